@@ -5,6 +5,18 @@
   #include <stdio.h>
 
   #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+
+  #ifdef ASYNC_ANALYSIS
+    #include <atomic>
+    #include <thread>
+
+// The thread that computes the statistics of the last analysis snapshot, and
+// whether it is done. Only one analysis is in flight at a time since the next
+// one reuses the buffers of the module
+static std::thread analysis_thread;
+static std::atomic<bool> analysis_done(false);
+  #endif  // ASYNC_ANALYSIS
 
 AnalysisModule::AnalysisModule(void) {}
 
@@ -26,14 +38,20 @@ void Grid3D::Compute_Lya_Statistics()
     if (axis == 1) chprintf(" Computing Along Y axis: ");
     if (axis == 2) chprintf(" Computing Along Z axis: ");
 
-    Populate_Lya_Skewers_Local(axis);
     Analysis.Initialize_Lya_Statistics_Measurements(axis);
     Analysis.Transfer_Skewers_Data(axis);
 
+    #ifdef LYA_STATISTICS_GPU
+    Compute_Transmitted_Flux_GPU(axis);
+    for (int skewer_id = 0; skewer_id < n_skewers; skewer_id++) {
+      Analysis.Compute_Lya_Mean_Flux_Skewer(skewer_id, axis);
+    }
+    #else
     for (int skewer_id = 0; skewer_id < n_skewers; skewer_id++) {
       Compute_Transmitted_Flux_Skewer(skewer_id, axis);
       Analysis.Compute_Lya_Mean_Flux_Skewer(skewer_id, axis);
     }
+    #endif  // LYA_STATISTICS_GPU
     Analysis.Reduce_Lya_Mean_Flux_Axis(axis);
 
     #ifdef OUTPUT_SKEWERS
@@ -56,9 +74,13 @@ void Grid3D::Compute_Lya_Statistics()
 
     Initialize_Power_Spectrum_Measurements(axis);
 
+    #ifdef LYA_STATISTICS_GPU
+    Compute_Flux_Power_Spectrum_GPU(axis);
+    #else
     for (int skewer_id = 0; skewer_id < n_skewers; skewer_id++) {
       Compute_Flux_Power_Spectrum_Skewer(skewer_id, axis);
     }
+    #endif  // LYA_STATISTICS_GPU
 
     Analysis.Reduce_Power_Spectrum_Axis(axis);
   }
@@ -78,25 +100,94 @@ void Grid3D::Compute_Lya_Statistics()
 
 void Grid3D::Compute_and_Output_Analysis(struct Parameters *P)
 {
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+
+  #ifdef ASYNC_ANALYSIS
+  // The buffers of the module are reused, so the previous analysis is written
+  // first
+  Finish_Analysis(P);
+  #endif  // ASYNC_ANALYSIS
+
   #ifdef COSMOLOGY
   chprintf("\nComputing Analysis  current_z: %f\n", Analysis.current_z);
+  Analysis.output_a = Cosmo.current_a;
+  Analysis.output_z = Cosmo.current_z;
   #else
   chprintf("\nComputing Analysis \n");
   #endif
+  Analysis.output_n_file = Analysis.n_file;
 
-  cudaMemcpy(C.density, C.device, H.n_fields * H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost);
+  // The phase diagram of the chemistry fields and the streamed skewers are
+  // computed on the device
+  bool copy_to_host = false;
+  #if defined(PHASE_DIAGRAM) && !defined(CHEMISTRY_GPU)
+  copy_to_host = true;
+  #endif
+  #ifdef LYA_STATISTICS
+  copy_to_host = copy_to_host || !Analysis.stream_skewers;
+  #endif
+  if (copy_to_host) {
+    cudaMemcpy(C.density, C.device, H.n_fields * H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost);
+  }
 
+  // Take everything the statistics need from the grid, they only use the
+  // buffers of the module after this
   #ifdef PHASE_DIAGRAM
+  Compute_Phase_Diagram();
+  #endif
+
+  #ifdef LYA_STATISTICS
+  if (Analysis.stream_skewers) {
+    Output_Lya_Skewers_GPU(P);
+  } else {
     #ifdef CHEMISTRY_GPU
-  Compute_Gas_Temperature(Chem.Fields.temperature_h, true);
+    // The skewers are taken from the host temperature, derived on the device
+    GPU_Error_Check(cudaMemcpy(Chem.Fields.temperature_h, Derived.Get(*this, "temperature"),
+                               H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost));
     #endif
-  Compute_Phase_Diagram();
+    for (int axis = 0; axis < 3; axis++) {
+      Populate_Lya_Skewers_Local(axis);
+    }
+  }
+  #endif
+
+  #ifdef ASYNC_ANALYSIS
+  // The statistics are computed while the simulation advances, and written by
+  // Poll_Analysis once they are done
+  analysis_done   = false;
+  analysis_thread = std::thread([this] {
+    Compute_Analysis_Statistics();
+    analysis_done = true;
+  });
+  #else
+  Compute_Analysis_Statistics();
+  Write_Analysis(P);
+  #endif  // ASYNC_ANALYSIS
+
+  #ifdef COSMOLOGY
+  Analysis.Set_Next_Scale_Output();
+  #endif
+
+  Analysis.Output_Now = false;
+
+  // exit(0);
+}
+
+void Grid3D::Compute_Analysis_Statistics()
+{
+  #ifdef PHASE_DIAGRAM
+  Analysis.Reduce_Phase_Diagram();
   #endif
 
   #ifdef LYA_STATISTICS
-  Compute_Lya_Statistics();
+  if (!Analysis.stream_skewers) {
+    Compute_Lya_Statistics();
+  }
   #endif
+}
 
+void Grid3D::Write_Analysis(struct Parameters *P)
+{
   // Write to HDF5 file
   #if defined(COSMOLOGY) || defined(PHASE_DIAGRAM) || defined(LYA_STATISTICS)
     #ifdef MPI_CHOLLA
@@ -109,15 +200,26 @@ void Grid3D::Compute_and_Output_Analysis(struct Parameters *P)
   #ifdef LYA_STATISTICS
   if (Analysis.Computed_Flux_Power_Spectrum == 1) Analysis.Clear_Power_Spectrum_Measurements();
   #endif
+}
 
-  #ifdef COSMOLOGY
-  Analysis.Set_Next_Scale_Output();
-  #endif
-
-  Analysis.Output_Now = false;
+  #ifdef ASYNC_ANALYSIS
+void Grid3D::Poll_Analysis(struct Parameters *P)
+{
+  if (analysis_thread.joinable() && analysis_done) {
+    Finish_Analysis(P);
+  }
+}
 
-  // exit(0);
+void Grid3D::Finish_Analysis(struct Parameters *P)
+{
+  if (!analysis_thread.joinable()) {
+    return;
+  }
+  analysis_thread.join();
+  // HDF5 is only called from the main thread
+  Write_Analysis(P);
 }
+  #endif  // ASYNC_ANALYSIS
 
 void Grid3D::Initialize_AnalysisModule(struct Parameters *P)
 {
@@ -228,9 +330,6 @@ void AnalysisModule::Reset()
     free(root_procs_y);
     free(root_procs_z);
       #ifdef OUTPUT_SKEWERS
-    free(transfer_buffer_root_x);
-    free(transfer_buffer_root_y);
-    free(transfer_buffer_root_z);
     free(skewers_transmitted_flux_HI_x_global);
     free(skewers_transmitted_flux_HI_y_global);
     free(skewers_transmitted_flux_HI_z_global);
@@ -313,6 +412,13 @@ void AnalysisModule::Reset()
       #endif
   }
 
+  MPI_Comm_free(&comm_skewers_x);
+  MPI_Comm_free(&comm_skewers_y);
+  MPI_Comm_free(&comm_skewers_z);
+  if (comm_skewers_roots_x != MPI_COMM_NULL) MPI_Comm_free(&comm_skewers_roots_x);
+  if (comm_skewers_roots_y != MPI_COMM_NULL) MPI_Comm_free(&comm_skewers_roots_y);
+  if (comm_skewers_roots_z != MPI_COMM_NULL) MPI_Comm_free(&comm_skewers_roots_z);
+
     #endif
   #endif
 }
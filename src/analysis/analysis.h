@@ -11,6 +11,10 @@
       #include <fftw3.h>
     #endif
 
+    #if defined(LYA_STATISTICS) && defined(MPI_CHOLLA)
+      #include <mpi.h>
+    #endif
+
 class AnalysisModule
 {
  public:
@@ -45,9 +49,15 @@ class AnalysisModule
   Real next_output;
   bool Output_Now;
   int n_file;
+  // The number of the output being computed, the statistics may still be
+  // computed when the simulation has moved on with ASYNC_ANALYSIS
+  int output_n_file;
 
     #ifdef COSMOLOGY
   Real current_z;
+  // The scale factor and the redshift of the output being computed
+  Real output_a;
+  Real output_z;
     #endif
 
     #ifdef PHASE_DIAGRAM
@@ -65,6 +75,8 @@ class AnalysisModule
 
     #ifdef LYA_STATISTICS
   int Computed_Flux_Power_Spectrum;
+  // Write the raw skewers from the device instead of computing the statistics
+  bool stream_skewers;
   int n_stride;
   int n_skewers_local_x;
   int n_skewers_local_y;
@@ -193,10 +205,6 @@ class AnalysisModule
   Real *skewers_transmitted_flux_HeII_x_global;
   Real *skewers_transmitted_flux_HeII_y_global;
   Real *skewers_transmitted_flux_HeII_z_global;
-
-  Real *transfer_buffer_root_x;
-  Real *transfer_buffer_root_y;
-  Real *transfer_buffer_root_z;
       #endif
 
   Real Flux_mean_root_HI_x;
@@ -286,6 +294,17 @@ class AnalysisModule
   vector<int> mpi_indices_x;
   vector<int> mpi_indices_y;
   vector<int> mpi_indices_z;
+
+  // The processes along the skewers of each axis in the order of mpi_indices,
+  // so the root is rank 0
+  MPI_Comm comm_skewers_x;
+  MPI_Comm comm_skewers_y;
+  MPI_Comm comm_skewers_z;
+  // The roots of each axis in the order of procID, MPI_COMM_NULL on the other
+  // processes
+  MPI_Comm comm_skewers_roots_x;
+  MPI_Comm comm_skewers_roots_y;
+  MPI_Comm comm_skewers_roots_z;
       #endif
 
     #endif
@@ -301,6 +320,7 @@ class AnalysisModule
 
     #ifdef PHASE_DIAGRAM
   void Initialize_Phase_Diagram(struct Parameters *P);
+  void Reduce_Phase_Diagram();
     #endif
 
     #ifdef LYA_STATISTICS
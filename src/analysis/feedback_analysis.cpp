@@ -6,6 +6,9 @@
 #ifdef MPI_CHOLLA
   #include "../mpi/mpi_routines.h"
 #endif
+#ifdef PARTICLES_GPU
+  #include "../utils/device_memory_pool.h"
+#endif
 
 #define VRMS_CUTOFF_DENSITY (0.01 * 0.6 * MP / DENSITY_UNIT)
 
@@ -16,8 +19,11 @@ FeedbackAnalysis::FeedbackAnalysis(Grid3D& G)
   h_circ_vel_y = (Real*)malloc(G.H.n_cells * sizeof(Real));
 
 #ifdef PARTICLES_GPU
-  GPU_Error_Check(cudaMalloc((void**)&d_circ_vel_x, G.H.n_cells * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void**)&d_circ_vel_y, G.H.n_cells * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  cuda_utilities::Pool_Malloc(&d_circ_vel_x, G.H.n_cells * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_circ_vel_y, G.H.n_cells * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_ring, 2 * n_ring * sizeof(Real));
+  GPU_Error_Check(cudaMemset(d_ring, 0, 2 * n_ring * sizeof(Real)));
 #endif
 
   // setup the (constant) circular speed arrays
@@ -50,8 +56,9 @@ FeedbackAnalysis::~FeedbackAnalysis()
   free(h_circ_vel_x);
   free(h_circ_vel_y);
 #ifdef PARTICLES_GPU
-  GPU_Error_Check(cudaFree(d_circ_vel_x));
-  GPU_Error_Check(cudaFree(d_circ_vel_y));
+  cuda_utilities::Pool_Free(d_circ_vel_x);
+  cuda_utilities::Pool_Free(d_circ_vel_y);
+  cuda_utilities::Pool_Free(d_ring);
 #endif
 }
 
@@ -141,3 +148,8 @@ void FeedbackAnalysis::Compute_Gas_Velocity_Dispersion(Grid3D& G)
   G.Timer.FeedbackAnalysis.End();
 #endif
 }
+
+#ifndef PARTICLES_GPU
+// The CPU version prints the dispersion of every step right away
+void FeedbackAnalysis::Output_Gas_Velocity_Dispersion() {}
+#endif  // PARTICLES_GPU
@@ -11,6 +11,13 @@ class FeedbackAnalysis
 
 #ifdef PARTICLES_GPU
   Real *d_circ_vel_x, *d_circ_vel_y;
+  // The gas mass and the mass weighted velocity variance of each step are
+  // summed into two slots of a device ring buffer and only read back at
+  // output cadence, or when the ring is full
+  static constexpr int n_ring = 64;
+  Real* d_ring;
+  Real h_ring_time[n_ring], h_ring_dt[n_ring];
+  int n_ring_steps{0};
   void Compute_Gas_Velocity_Dispersion_GPU(Grid3D& G);
 #endif
 
@@ -26,5 +33,8 @@ class FeedbackAnalysis
   ~FeedbackAnalysis();
 
   void Compute_Gas_Velocity_Dispersion(Grid3D& G);
+  /* Read back and print the velocity dispersions of the steps since the last
+   * call. Has to be called on all the ranks */
+  void Output_Gas_Velocity_Dispersion();
   void Reset();
 };
\ No newline at end of file
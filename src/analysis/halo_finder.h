@@ -0,0 +1,115 @@
+/*! \file halo_finder.h
+ *  \brief Declarations of the in-situ friends-of-friends halo finder of the
+ *  GPU particles. The groups are linked on the device with a union-find over
+ *  the particles sorted by cell, and stitched across the ranks through a halo
+ *  of the particles within a linking length of the faces of the local domain,
+ *  so only the catalogs are written instead of all the particles. */
+
+#pragma once
+
+#ifdef HALO_FINDER
+
+  #ifndef PARTICLES_GPU
+    #error "HALO_FINDER needs PARTICLES_GPU"
+  #endif
+
+  #include <vector>
+
+  #include "../global/global.h"
+
+class Particles3D;
+
+/*! \class HaloFinder
+ *  \brief The friends-of-friends groups of the particles of a Particles3D. The
+ *  linking length is fof_linking_length times the mean interparticle
+ *  separation, and the catalogs keep the groups of at least fof_min_members
+ *  particles */
+class HaloFinder
+{
+ public:
+  /*! \brief A group of the catalog. The id is the smallest global index of its
+   * particles, the index of a particle over the particles of all the ranks in
+   * the order of the ranks */
+  struct Halo {
+    long long id;
+    long long n_particles;
+    double mass;
+    double pos[3];
+    double vel[3];
+  };
+
+  /*! \brief A particle of a group of the catalog, for the member outputs */
+  struct Member {
+    long long halo_id;
+    long long particle_id;
+    double pos[3];
+  };
+
+  HaloFinder(struct Parameters const &P);
+  ~HaloFinder();
+  HaloFinder(HaloFinder const &)            = delete;
+  HaloFinder &operator=(HaloFinder const &) = delete;
+
+  /*! \fn void Find(Particles3D &Particles, bool find_members)
+   *  \brief Link the particles into groups. Every process must call it. The
+   * root gets the catalog in Halos(), sorted by id, and with find_members
+   * every process gets its particles of those groups in Members() */
+  void Find(Particles3D &Particles, bool find_members);
+
+  /*! \fn std::vector<Halo> const &Halos() const
+   *  \brief The catalog of the last Find, only on the root */
+  std::vector<Halo> const &Halos() const { return halos_; }
+
+  /*! \fn std::vector<Member> const &Members() const
+   *  \brief The local particles of the groups of the catalog of the last Find */
+  std::vector<Member> const &Members() const { return members_; }
+
+  /*! \fn Real Linking_Length() const
+   *  \brief The linking length of the last Find, in code units */
+  Real Linking_Length() const { return linking_length_; }
+
+ private:
+  /*! \brief Send the sources within the linking length of a face to the
+   * neighbor across it and append the ones of the neighbor across the opposite
+   * face, like the halo of the P3M forces */
+  void Exchange_Halo(Particles3D &Particles, int direction, int side);
+
+  /*! \brief Send the labels of the sources of every face again, in the order
+   * of Exchange_Halo, so the halo sources get the labels of their owners */
+  void Exchange_Labels();
+
+  /*! \brief Grow the source arrays to hold at least n_sources */
+  void Reserve_Sources(int n_sources);
+
+  /*! \brief Move n values of a device array to the rank across a face and the
+   * values of the rank across the opposite one into recv_dev */
+  template <typename T>
+  void Sendrecv(T const *send_dev, int n_send, T *recv_dev, int n_recv, int face, int opposite);
+
+  Real fof_linking_length_;
+  int min_members_;
+  Real linking_length_;
+  // The rank across each face whose sources are linked, -1 if none
+  int neighbors_[6];
+
+  // The positions (x, y, z) and the labels of the local particles then of the
+  // halo, in the order they were received
+  int n_sources_;
+  int sources_size_;
+  Real *pos_dev_;
+  long long *label_dev_;
+  // The sources sent across each face and the start and number of the ones
+  // received across the opposite face
+  int *send_dev_[6];
+  int n_send_[6];
+  int recv_start_[6];
+  int n_recv_[6];
+  int *n_selected_dev_;
+  void *temp_dev_;
+  size_t temp_bytes_;
+
+  std::vector<Halo> halos_;
+  std::vector<Member> members_;
+};
+
+#endif  // HALO_FINDER
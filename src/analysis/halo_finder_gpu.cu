@@ -0,0 +1,818 @@
+/*! \file halo_finder_gpu.cu
+ *  \brief Definitions of the in-situ friends-of-friends halo finder of the
+ *  GPU particles. */
+
+#ifdef HALO_FINDER
+
+  #include <algorithm>
+  #include <climits>
+  #include <cmath>
+
+  #ifdef O_HIP
+    #include <hipcub/hipcub.hpp>
+namespace cub = hipcub;
+  #else
+    #include <cub/cub.cuh>
+  #endif  // O_HIP
+
+  #include "../analysis/halo_finder.h"
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../particles/particles_3D.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/gpu_arrays_functions.h"
+
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif
+
+  // The sums of a group of Sum_FoF_Groups_Kernel: the mass, the mass weighted
+  // offsets from the root and the momentum
+  #define FOF_N_SUMS 7
+
+namespace
+{
+int FoF_Grid(int n) { return (n - 1) / TPB_PARTICLES + 1; }
+
+/*! \brief Grow the temporary storage of the cub calls to at least bytes */
+void Reserve_FoF_Temp(void **temp_dev, size_t *temp_bytes, size_t bytes)
+{
+  if (bytes > *temp_bytes) {
+    cuda_utilities::Pool_Free(*temp_dev);
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+    cuda_utilities::Pool_Malloc(temp_dev, bytes);
+    *temp_bytes = bytes;
+  }
+}
+}  // namespace
+
+/*! \brief Load the positions of the local particles at the start of pos_dev,
+ * with their global index as their label */
+__global__ void Load_FoF_Local_Sources_Kernel(int n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                              Real_Part *pos_z_dev, Real origin_x, Real origin_y, Real origin_z,
+                                              long long label_offset, Real *pos_dev, long long *label_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+  pos_dev[3 * tid + 0] = pos_x_dev[tid] + origin_x;
+  pos_dev[3 * tid + 1] = pos_y_dev[tid] + origin_y;
+  pos_dev[3 * tid + 2] = pos_z_dev[tid] + origin_z;
+  label_dev[tid]       = label_offset + tid;
+}
+
+/*! \brief Flag the sources inside the local domain along the direction and
+ * within width of the lower (side 0) or upper (side 1) face */
+__global__ void Get_FoF_Halo_Flags_Kernel(int n_sources, int direction, int side, Real d_min, Real d_max, Real width,
+                                          Real *pos_dev, bool *flags_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  Real const pos = pos_dev[3 * tid + direction];
+  if (side == 0) {
+    flags_dev[tid] = pos >= d_min && pos < d_min + width;
+  } else {
+    flags_dev[tid] = pos < d_max && pos >= d_max - width;
+  }
+}
+
+/*! \brief Copy the n_data values of the entries at indices_dev into dst_dev */
+template <typename T>
+__global__ void Gather_FoF_Kernel(int n_gather, int n_data, int *indices_dev, T *src_dev, T *dst_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_gather) {
+    return;
+  }
+  int const id = indices_dev[tid];
+  for (int i = 0; i < n_data; i++) {
+    dst_dev[n_data * tid + i] = src_dev[n_data * id + i];
+  }
+}
+
+/*! \brief Move the received halo sources across the periodic boundary when
+ * they come from the other end of the global domain */
+__global__ void Wrap_FoF_Halo_Sources_Kernel(int n_recv, int direction, int side, Real d_min, Real d_max,
+                                             Real length, Real *recv_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_recv) {
+    return;
+  }
+  Real &pos = recv_dev[3 * tid + direction];
+  if (side == 0 && pos < d_max) {
+    pos += length;
+  }
+  if (side == 1 && pos >= d_min) {
+    pos -= length;
+  }
+}
+
+/*! \brief Compute the linear index of the cell of each source in the local
+ * grid extended by ng_x, ng_y and ng_z cells on each side */
+__global__ void Get_FoF_Cell_Keys_Kernel(int n_sources, Real *pos_dev, Real xMin, Real yMin, Real zMin, Real dx,
+                                         Real dy, Real dz, int ng_x, int ng_y, int ng_z, int nx_ext, int ny_ext,
+                                         int nz_ext, int *keys_dev, int *indices_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const i = min(max(int(floor((pos_dev[3 * tid + 0] - xMin) / dx)) + ng_x, 0), nx_ext - 1);
+  int const j = min(max(int(floor((pos_dev[3 * tid + 1] - yMin) / dy)) + ng_y, 0), ny_ext - 1);
+  int const k = min(max(int(floor((pos_dev[3 * tid + 2] - zMin) / dz)) + ng_z, 0), nz_ext - 1);
+
+  keys_dev[tid]    = i + nx_ext * (j + ny_ext * k);
+  indices_dev[tid] = tid;
+}
+
+/*! \brief Set the range of the sorted sources of each occupied cell */
+__global__ void Get_FoF_Cell_Ranges_Kernel(int n_sources, int *keys_dev, int *cell_start_dev, int *cell_end_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const key = keys_dev[tid];
+  if (tid == 0 || keys_dev[tid - 1] != key) {
+    cell_start_dev[key] = tid;
+  }
+  if (tid == n_sources - 1 || keys_dev[tid + 1] != key) {
+    cell_end_dev[key] = tid + 1;
+  }
+}
+
+/*! \brief The root of the tree of i, halving the path to it on the way. Other
+ * threads only ever move an entry closer to its root, so the races are
+ * benign */
+__device__ int FoF_Find(int *parent_dev, int i)
+{
+  int next = parent_dev[i];
+  while (next != i) {
+    int const grandparent = parent_dev[next];
+    parent_dev[i]         = grandparent;
+    i                     = grandparent;
+    next                  = parent_dev[i];
+  }
+  return i;
+}
+
+/*! \brief Join the trees of a and b, the root with the larger index under the
+ * other one, retrying when another thread moved a root first */
+__device__ void FoF_Union(int *parent_dev, int a, int b)
+{
+  while (true) {
+    a = FoF_Find(parent_dev, a);
+    b = FoF_Find(parent_dev, b);
+    if (a == b) {
+      return;
+    }
+    if (a < b) {
+      int const swap = a;
+      a              = b;
+      b              = swap;
+    }
+    if (atomicCAS(parent_dev + a, a, b) == a) {
+      return;
+    }
+  }
+}
+
+/*! \brief Link every sorted source to the later sources within the linking
+ * length. The threads follow the sorted sources, so the threads of a block
+ * search the same cells */
+__global__ void Link_FoF_Kernel(int n_sources, Real *sorted_dev, int *keys_dev, int *cell_start_dev, int *cell_end_dev,
+                                int nx_ext, int ny_ext, int nz_ext, int ng_x, int ng_y, int ng_z, Real b2,
+                                int *parent_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  Real const x = sorted_dev[3 * tid + 0];
+  Real const y = sorted_dev[3 * tid + 1];
+  Real const z = sorted_dev[3 * tid + 2];
+
+  int const key = keys_dev[tid];
+  int const ci  = key % nx_ext;
+  int const cj  = (key / nx_ext) % ny_ext;
+  int const ck  = key / (nx_ext * ny_ext);
+
+  for (int k = max(ck - ng_z, 0); k <= min(ck + ng_z, nz_ext - 1); k++) {
+    for (int j = max(cj - ng_y, 0); j <= min(cj + ng_y, ny_ext - 1); j++) {
+      for (int i = max(ci - ng_x, 0); i <= min(ci + ng_x, nx_ext - 1); i++) {
+        int const cell = i + nx_ext * (j + ny_ext * k);
+        for (int s = max(cell_start_dev[cell], tid + 1); s < cell_end_dev[cell]; s++) {
+          Real const rx = sorted_dev[3 * s + 0] - x;
+          Real const ry = sorted_dev[3 * s + 1] - y;
+          Real const rz = sorted_dev[3 * s + 2] - z;
+          if (rx * rx + ry * ry + rz * rz <= b2) {
+            FoF_Union(parent_dev, tid, s);
+          }
+        }
+      }
+    }
+  }
+}
+
+/*! \brief Point every sorted source straight at its root */
+__global__ void Flatten_FoF_Kernel(int n_sources, int *parent_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  parent_dev[tid] = FoF_Find(parent_dev, tid);
+}
+
+/*! \brief Set the label of every root to the smallest label of its group */
+__global__ void Min_FoF_Labels_Kernel(int n_sources, int *parent_dev, int *indices_dev, long long *label_dev,
+                                      long long *root_label_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  atomicMin(root_label_dev + parent_dev[tid], label_dev[indices_dev[tid]]);
+}
+
+/*! \brief Give every source the label of its root, flagging the changes */
+__global__ void Set_FoF_Labels_Kernel(int n_sources, int *parent_dev, int *indices_dev, long long *label_dev,
+                                      long long *root_label_dev, int *changed_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const id          = indices_dev[tid];
+  long long const label = root_label_dev[parent_dev[tid]];
+  if (label_dev[id] != label) {
+    label_dev[id] = label;
+    *changed_dev  = 1;
+  }
+}
+
+/*! \brief Add the local particles of every group to the sums of its root, with
+ * the positions relative to the root since the groups can cross the periodic
+ * boundaries, and flag the groups with halo sources */
+__global__ void Sum_FoF_Groups_Kernel(int n_sources, int n_local, int *parent_dev, int *indices_dev,
+                                      Real *sorted_dev, Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                      Real_Part *vel_z_dev, Real *mass_dev, Real particle_mass, int *count_dev,
+                                      int *has_halo_dev, double *sums_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const root = parent_dev[tid];
+  int const id   = indices_dev[tid];
+  if (id >= n_local) {
+    has_halo_dev[root] = 1;
+    return;
+  }
+  double const m = (mass_dev == NULL) ? particle_mass : mass_dev[id];
+  double *sums   = sums_dev + FOF_N_SUMS * root;
+  atomicAdd(count_dev + root, 1);
+  atomicAdd(sums + 0, m);
+  atomicAdd(sums + 1, m * (sorted_dev[3 * tid + 0] - sorted_dev[3 * root + 0]));
+  atomicAdd(sums + 2, m * (sorted_dev[3 * tid + 1] - sorted_dev[3 * root + 1]));
+  atomicAdd(sums + 3, m * (sorted_dev[3 * tid + 2] - sorted_dev[3 * root + 2]));
+  atomicAdd(sums + 4, m * vel_x_dev[id]);
+  atomicAdd(sums + 5, m * vel_y_dev[id]);
+  atomicAdd(sums + 6, m * vel_z_dev[id]);
+}
+
+/*! \brief Flag the roots whose local particles the root process needs: the
+ * groups that continue on other ranks and the local groups that are large
+ * enough for the catalog */
+__global__ void Flag_FoF_Groups_Kernel(int n_sources, int min_members, int *parent_dev, int *count_dev,
+                                       int *has_halo_dev, bool *flags_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  flags_dev[tid] = parent_dev[tid] == tid && count_dev[tid] > 0 && (has_halo_dev[tid] || count_dev[tid] >= min_members);
+}
+
+/*! \brief Pack the local part of each flagged group. Its position is the
+ * center of mass of the local particles and its velocity their momentum, which
+ * the root combines with the other parts */
+__global__ void Pack_FoF_Groups_Kernel(int n_groups, int *roots_dev, int *indices_dev, long long *label_dev,
+                                       Real *sorted_dev, int *count_dev, double *sums_dev, HaloFinder::Halo *groups_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_groups) {
+    return;
+  }
+  int const root          = roots_dev[tid];
+  double const *sums      = sums_dev + FOF_N_SUMS * root;
+  HaloFinder::Halo &group = groups_dev[tid];
+  group.id                = label_dev[indices_dev[root]];
+  group.n_particles       = count_dev[root];
+  group.mass              = sums[0];
+  for (int d = 0; d < 3; d++) {
+    group.pos[d] = sorted_dev[3 * root + d] + sums[1 + d] / sums[0];
+    group.vel[d] = sums[4 + d];
+  }
+}
+
+/*! \brief Flag the local particles whose label is one of the sorted ids of the
+ * catalog */
+__global__ void Flag_FoF_Members_Kernel(int n_sources, int n_local, int *indices_dev, long long *label_dev,
+                                        long long *ids_dev, int n_ids, bool *flags_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const id   = indices_dev[tid];
+  flags_dev[tid] = false;
+  if (id >= n_local) {
+    return;
+  }
+  long long const label = label_dev[id];
+  int lo = 0, hi = n_ids;
+  while (lo < hi) {
+    int const mid = (lo + hi) / 2;
+    if (ids_dev[mid] < label) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  flags_dev[tid] = lo < n_ids && ids_dev[lo] == label;
+}
+
+/*! \brief Pack the flagged members. Without PARTICLE_IDS the particle id is
+ * the global index of the particle */
+__global__ void Pack_FoF_Members_Kernel(int n_members, int *selected_dev, int *indices_dev, long long *label_dev,
+                                        Real *sorted_dev, part_int_t *ids_dev, long long label_offset,
+                                        HaloFinder::Member *members_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_members) {
+    return;
+  }
+  int const s                = selected_dev[tid];
+  int const id               = indices_dev[s];
+  HaloFinder::Member &member = members_dev[tid];
+  member.halo_id             = label_dev[id];
+  member.particle_id         = (ids_dev == NULL) ? label_offset + id : ids_dev[id];
+  for (int d = 0; d < 3; d++) {
+    member.pos[d] = sorted_dev[3 * s + d];
+  }
+}
+
+HaloFinder::HaloFinder(struct Parameters const &P)
+    : fof_linking_length_(P.fof_linking_length),
+      min_members_(P.fof_min_members),
+      linking_length_(0),
+      n_sources_(0),
+      sources_size_(0),
+      pos_dev_(nullptr),
+      label_dev_(nullptr),
+      send_dev_{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr},
+      n_send_{0, 0, 0, 0, 0, 0},
+      recv_start_{0, 0, 0, 0, 0, 0},
+      n_recv_{0, 0, 0, 0, 0, 0},
+      n_selected_dev_(nullptr),
+      temp_dev_(nullptr),
+      temp_bytes_(0)
+{
+  CHOLLA_ASSERT(fof_linking_length_ > 0, "fof_linking_length must be positive");
+
+  // The halo comes from the neighbors across the MPI boundaries, and from this
+  // rank across the periodic boundaries when it's alone in that direction
+  int const flags[6] = {P.xl_bcnd, P.xu_bcnd, P.yl_bcnd, P.yu_bcnd, P.zl_bcnd, P.zu_bcnd};
+  for (int face = 0; face < 6; face++) {
+    neighbors_[face] = -1;
+  #ifdef MPI_CHOLLA
+    if (flags[face] == 5 || flags[face] == 1) {
+      neighbors_[face] = dest[face];
+    }
+  #else
+    if (flags[face] == 1) {
+      neighbors_[face] = 0;
+    }
+  #endif  // MPI_CHOLLA
+  }
+
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  cuda_utilities::Pool_Malloc(&n_selected_dev_, sizeof(int));
+}
+
+HaloFinder::~HaloFinder()
+{
+  cuda_utilities::Pool_Free(pos_dev_);
+  cuda_utilities::Pool_Free(label_dev_);
+  for (int face = 0; face < 6; face++) {
+    cuda_utilities::Pool_Free(send_dev_[face]);
+  }
+  cuda_utilities::Pool_Free(n_selected_dev_);
+  cuda_utilities::Pool_Free(temp_dev_);
+}
+
+void HaloFinder::Reserve_Sources(int n_sources)
+{
+  if (n_sources <= sources_size_) {
+    return;
+  }
+  int const new_size = std::max(n_sources, 2 * sources_size_);
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  if (sources_size_ == 0) {
+    cuda_utilities::Pool_Malloc(&pos_dev_, 3 * size_t(new_size) * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&label_dev_, size_t(new_size) * sizeof(long long));
+  } else {
+    Resize_GPU_Array(&pos_dev_, 3 * sources_size_, 3 * new_size);
+    Resize_GPU_Array(&label_dev_, sources_size_, new_size);
+  }
+  sources_size_ = new_size;
+}
+
+template <typename T>
+void HaloFinder::Sendrecv(T const *send_dev, int n_send, T *recv_dev, int n_recv, int face, int opposite)
+{
+  #ifdef MPI_CHOLLA
+  int const dest_rank   = (neighbors_[face] >= 0) ? neighbors_[face] : MPI_PROC_NULL;
+  int const source_rank = (neighbors_[opposite] >= 0) ? neighbors_[opposite] : MPI_PROC_NULL;
+    #ifdef MPI_GPU
+  MPI_Sendrecv(send_dev, n_send * sizeof(T), MPI_BYTE, dest_rank, face, recv_dev, n_recv * sizeof(T), MPI_BYTE,
+               source_rank, face, world, MPI_STATUS_IGNORE);
+    #else
+  std::vector<T> send_host(n_send), recv_host(n_recv);
+  if (n_send > 0) {
+    GPU_Error_Check(cudaMemcpy(send_host.data(), send_dev, n_send * sizeof(T), cudaMemcpyDeviceToHost));
+  }
+  MPI_Sendrecv(send_host.data(), n_send * sizeof(T), MPI_BYTE, dest_rank, face, recv_host.data(), n_recv * sizeof(T),
+               MPI_BYTE, source_rank, face, world, MPI_STATUS_IGNORE);
+  if (n_recv > 0) {
+    GPU_Error_Check(cudaMemcpy(recv_dev, recv_host.data(), n_recv * sizeof(T), cudaMemcpyHostToDevice));
+  }
+    #endif  // MPI_GPU
+  #else
+  // Without MPI the only neighbor is this process across a periodic boundary
+  if (n_recv > 0) {
+    GPU_Error_Check(cudaMemcpy(recv_dev, send_dev, n_recv * sizeof(T), cudaMemcpyDeviceToDevice));
+  }
+  #endif  // MPI_CHOLLA
+}
+
+void HaloFinder::Exchange_Halo(Particles3D &Particles, int direction, int side)
+{
+  int const face     = 2 * direction + side;
+  int const opposite = 2 * direction + 1 - side;
+
+  Real d_min, d_max, length;
+  if (direction == 0) {
+    d_min  = Particles.G.xMin;
+    d_max  = Particles.G.xMax;
+    length = Particles.G.domainMax_x - Particles.G.domainMin_x;
+  }
+  if (direction == 1) {
+    d_min  = Particles.G.yMin;
+    d_max  = Particles.G.yMax;
+    length = Particles.G.domainMax_y - Particles.G.domainMin_y;
+  }
+  if (direction == 2) {
+    d_min  = Particles.G.zMin;
+    d_max  = Particles.G.zMax;
+    length = Particles.G.domainMax_z - Particles.G.domainMin_z;
+  }
+
+  // Select the sources next to the face, which also include the halo sources
+  // of the earlier directions, so the edges and corners of the halo are filled
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  int n_send = 0;
+  cuda_utilities::Pool_Free(send_dev_[face]);
+  send_dev_[face] = nullptr;
+  if (neighbors_[face] >= 0 && n_sources_ > 0) {
+    cuda_utilities::DeviceVector<bool> flags(n_sources_);
+    hipLaunchKernelGGL(Get_FoF_Halo_Flags_Kernel, FoF_Grid(n_sources_), TPB_PARTICLES, 0, 0, n_sources_, direction,
+                       side, d_min, d_max, linking_length_, pos_dev_, flags.data());
+    GPU_Error_Check();
+
+    cuda_utilities::Pool_Malloc(&send_dev_[face], size_t(n_sources_) * sizeof(int));
+    cub::CountingInputIterator<int> source_ids(0);
+    size_t temp_bytes = 0;
+    GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, temp_bytes, source_ids, flags.data(), send_dev_[face],
+                                                  n_selected_dev_, n_sources_));
+    Reserve_FoF_Temp(&temp_dev_, &temp_bytes_, temp_bytes);
+    GPU_Error_Check(cub::DevicePartition::Flagged(temp_dev_, temp_bytes, source_ids, flags.data(), send_dev_[face],
+                                                  n_selected_dev_, n_sources_));
+    GPU_Error_Check(cudaMemcpy(&n_send, n_selected_dev_, sizeof(int), cudaMemcpyDeviceToHost));
+  }
+
+  int n_recv = 0;
+  #ifdef MPI_CHOLLA
+  int const dest_rank   = (neighbors_[face] >= 0) ? neighbors_[face] : MPI_PROC_NULL;
+  int const source_rank = (neighbors_[opposite] >= 0) ? neighbors_[opposite] : MPI_PROC_NULL;
+  MPI_Sendrecv(&n_send, 1, MPI_INT, dest_rank, face, &n_recv, 1, MPI_INT, source_rank, face, world, MPI_STATUS_IGNORE);
+  #else
+  if (neighbors_[opposite] >= 0) {
+    n_recv = n_send;
+  }
+  #endif  // MPI_CHOLLA
+
+  // Pack the sources before the arrays grow
+  cuda_utilities::DeviceVector<Real> send_pos(3 * std::max(n_send, 1));
+  cuda_utilities::DeviceVector<long long> send_label(std::max(n_send, 1));
+  if (n_send > 0) {
+    hipLaunchKernelGGL(Gather_FoF_Kernel<Real>, FoF_Grid(n_send), TPB_PARTICLES, 0, 0, n_send, 3, send_dev_[face],
+                       pos_dev_, send_pos.data());
+    hipLaunchKernelGGL(Gather_FoF_Kernel<long long>, FoF_Grid(n_send), TPB_PARTICLES, 0, 0, n_send, 1,
+                       send_dev_[face], label_dev_, send_label.data());
+    GPU_Error_Check();
+  }
+  Reserve_Sources(n_sources_ + n_recv);
+  Sendrecv(send_pos.data(), 3 * n_send, pos_dev_ + 3 * size_t(n_sources_), 3 * n_recv, face, opposite);
+  Sendrecv(send_label.data(), n_send, label_dev_ + n_sources_, n_recv, face, opposite);
+
+  if (n_recv > 0) {
+    hipLaunchKernelGGL(Wrap_FoF_Halo_Sources_Kernel, FoF_Grid(n_recv), TPB_PARTICLES, 0, 0, n_recv, direction, side,
+                       d_min, d_max, length, pos_dev_ + 3 * size_t(n_sources_));
+    GPU_Error_Check();
+  }
+  n_send_[face]     = n_send;
+  recv_start_[face] = n_sources_;
+  n_recv_[face]     = n_recv;
+  n_sources_ += n_recv;
+}
+
+void HaloFinder::Exchange_Labels()
+{
+  for (int direction = 0; direction < 3; direction++) {
+    for (int side = 0; side < 2; side++) {
+      int const face     = 2 * direction + side;
+      int const opposite = 2 * direction + 1 - side;
+      int const n_send   = n_send_[face];
+      cuda_utilities::DeviceVector<long long> send_label(std::max(n_send, 1));
+      if (n_send > 0) {
+        hipLaunchKernelGGL(Gather_FoF_Kernel<long long>, FoF_Grid(n_send), TPB_PARTICLES, 0, 0, n_send, 1,
+                           send_dev_[face], label_dev_, send_label.data());
+        GPU_Error_Check();
+      }
+      Sendrecv(send_label.data(), n_send, label_dev_ + recv_start_[face], n_recv_[face], face, opposite);
+    }
+  }
+}
+
+void HaloFinder::Find(Particles3D &Particles, bool const find_members)
+{
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  if (Particles.n_local > INT_MAX) {
+    CHOLLA_ERROR("Can't find the halos of more than %d particles per process, n_local is %ld", INT_MAX,
+                 long(Particles.n_local));
+  }
+  int const n_local = Particles.n_local;
+  auto const &G     = Particles.G;
+
+  // The global index of the first local particle and the linking length in
+  // units of the mean interparticle separation
+  long long n_total = n_local, label_offset = 0;
+  #ifdef MPI_CHOLLA
+  MPI_Exscan(&n_total, &label_offset, 1, MPI_LONG_LONG, MPI_SUM, world);
+  if (procID == 0) {
+    label_offset = 0;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &n_total, 1, MPI_LONG_LONG, MPI_SUM, world);
+  #endif  // MPI_CHOLLA
+  Real const length[3] = {G.domainMax_x - G.domainMin_x, G.domainMax_y - G.domainMin_y, G.domainMax_z - G.domainMin_z};
+  linking_length_      = fof_linking_length_ * cbrt(length[0] * length[1] * length[2] / std::max(n_total, 1LL));
+  if (linking_length_ > G.xMax - G.xMin || linking_length_ > G.yMax - G.yMin || linking_length_ > G.zMax - G.zMin) {
+    CHOLLA_ERROR("The FoF linking length %e is larger than the local domain", linking_length_);
+  }
+
+  // Load the local particles and the halo within the linking length of the
+  // local domain. Every rank takes part in the exchanges, even without local
+  // particles
+  Reserve_Sources(std::max(n_local, 1));
+  n_sources_ = n_local;
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Load_FoF_Local_Sources_Kernel, FoF_Grid(n_local), TPB_PARTICLES, 0, 0, n_local,
+                       Particles.pos_x_dev, Particles.pos_y_dev, Particles.pos_z_dev, G.pos_origin_x, G.pos_origin_y,
+                       G.pos_origin_z, label_offset, pos_dev_, label_dev_);
+    GPU_Error_Check();
+  }
+  for (int direction = 0; direction < 3; direction++) {
+    Exchange_Halo(Particles, direction, 0);
+    Exchange_Halo(Particles, direction, 1);
+  }
+  int const n_sources = n_sources_;
+  int const n_work    = std::max(n_sources, 1);
+
+  // Sort the sources by cell and build the linked list of the cells
+  int const ng_x    = ceil(linking_length_ / G.dx);
+  int const ng_y    = ceil(linking_length_ / G.dy);
+  int const ng_z    = ceil(linking_length_ / G.dz);
+  int const nx_ext  = G.nx_local + 2 * ng_x;
+  int const ny_ext  = G.ny_local + 2 * ng_y;
+  int const nz_ext  = G.nz_local + 2 * ng_z;
+  int const n_cells = nx_ext * ny_ext * nz_ext;
+  cuda_utilities::DeviceVector<int> keys(n_work), sorted_keys(n_work), unsorted(n_work), indices(n_work);
+  cuda_utilities::DeviceVector<Real> sorted(3 * n_work);
+  cuda_utilities::DeviceVector<int> cell_start(n_cells), cell_end(n_cells), parent(n_work);
+  if (n_sources > 0) {
+    hipLaunchKernelGGL(Get_FoF_Cell_Keys_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, pos_dev_,
+                       G.xMin, G.yMin, G.zMin, G.dx, G.dy, G.dz, ng_x, ng_y, ng_z, nx_ext, ny_ext, nz_ext,
+                       keys.data(), unsorted.data());
+    GPU_Error_Check();
+    int end_bit = 1;
+    while (end_bit < 31 && (1 << end_bit) < n_cells) {
+      end_bit++;
+    }
+    size_t temp_bytes = 0;
+    GPU_Error_Check(cub::DeviceRadixSort::SortPairs(nullptr, temp_bytes, keys.data(), sorted_keys.data(),
+                                                    unsorted.data(), indices.data(), n_sources, 0, end_bit));
+    Reserve_FoF_Temp(&temp_dev_, &temp_bytes_, temp_bytes);
+    GPU_Error_Check(cub::DeviceRadixSort::SortPairs(temp_dev_, temp_bytes, keys.data(), sorted_keys.data(),
+                                                    unsorted.data(), indices.data(), n_sources, 0, end_bit));
+    hipLaunchKernelGGL(Gather_FoF_Kernel<Real>, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, 3,
+                       indices.data(), pos_dev_, sorted.data());
+    GPU_Error_Check(cudaMemset(cell_start.data(), 0, n_cells * sizeof(int)));
+    GPU_Error_Check(cudaMemset(cell_end.data(), 0, n_cells * sizeof(int)));
+    hipLaunchKernelGGL(Get_FoF_Cell_Ranges_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources,
+                       sorted_keys.data(), cell_start.data(), cell_end.data());
+    GPU_Error_Check();
+
+    // Link the local groups with a union-find over the sorted sources
+    int *const parent_dev = parent.data();
+    gpuFor(
+        n_sources, GPU_LAMBDA(const int i) { parent_dev[i] = i; });
+    hipLaunchKernelGGL(Link_FoF_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, sorted.data(),
+                       sorted_keys.data(), cell_start.data(), cell_end.data(), nx_ext, ny_ext, nz_ext, ng_x, ng_y,
+                       ng_z, linking_length_ * linking_length_, parent_dev);
+    hipLaunchKernelGGL(Flatten_FoF_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, parent_dev);
+    GPU_Error_Check();
+  }
+
+  // Stitch the groups across the ranks. Every group takes the smallest label
+  // of its sources, and the halo sources take the labels of their owners,
+  // until the labels stop changing on all the ranks. A group spanning n ranks
+  // along a direction takes about n rounds
+  cuda_utilities::DeviceVector<long long> root_label(n_work);
+  cuda_utilities::DeviceVector<int> changed(1);
+  int rounds = 0;
+  while (true) {
+    int changed_host = 0;
+    if (n_sources > 0) {
+      GPU_Error_Check(cudaMemset(changed.data(), 0, sizeof(int)));
+      hipLaunchKernelGGL(Gather_FoF_Kernel<long long>, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, 1,
+                         indices.data(), label_dev_, root_label.data());
+      hipLaunchKernelGGL(Min_FoF_Labels_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, parent.data(),
+                         indices.data(), label_dev_, root_label.data());
+      hipLaunchKernelGGL(Set_FoF_Labels_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, parent.data(),
+                         indices.data(), label_dev_, root_label.data(), changed.data());
+      GPU_Error_Check();
+      GPU_Error_Check(cudaMemcpy(&changed_host, changed.data(), sizeof(int), cudaMemcpyDeviceToHost));
+    }
+    rounds++;
+  #ifdef MPI_CHOLLA
+    MPI_Allreduce(MPI_IN_PLACE, &changed_host, 1, MPI_INT, MPI_LOR, world);
+  #endif  // MPI_CHOLLA
+    if (!changed_host) {
+      break;
+    }
+    Exchange_Labels();
+  }
+
+  // Sum the local particles of every group, and pack the parts of the groups
+  // the root needs
+  cuda_utilities::DeviceVector<int> count(n_work, true), has_halo(n_work, true), roots(n_work);
+  cuda_utilities::DeviceVector<double> sums(FOF_N_SUMS * n_work, true);
+  cuda_utilities::DeviceVector<bool> flags(n_work);
+  int n_groups = 0;
+  if (n_sources > 0) {
+    hipLaunchKernelGGL(Sum_FoF_Groups_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, n_local,
+                       parent.data(), indices.data(), sorted.data(), Particles.vel_x_dev, Particles.vel_y_dev,
+                       Particles.vel_z_dev, Particles.mass_dev, Particles.particle_mass, count.data(),
+                       has_halo.data(), sums.data());
+    hipLaunchKernelGGL(Flag_FoF_Groups_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, min_members_,
+                       parent.data(), count.data(), has_halo.data(), flags.data());
+    GPU_Error_Check();
+    cub::CountingInputIterator<int> source_ids(0);
+    size_t temp_bytes = 0;
+    GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, temp_bytes, source_ids, flags.data(), roots.data(),
+                                                  n_selected_dev_, n_sources));
+    Reserve_FoF_Temp(&temp_dev_, &temp_bytes_, temp_bytes);
+    GPU_Error_Check(cub::DevicePartition::Flagged(temp_dev_, temp_bytes, source_ids, flags.data(), roots.data(),
+                                                  n_selected_dev_, n_sources));
+    GPU_Error_Check(cudaMemcpy(&n_groups, n_selected_dev_, sizeof(int), cudaMemcpyDeviceToHost));
+  }
+  std::vector<Halo> groups(n_groups);
+  if (n_groups > 0) {
+    cuda_utilities::DeviceVector<Halo> groups_dev(n_groups);
+    hipLaunchKernelGGL(Pack_FoF_Groups_Kernel, FoF_Grid(n_groups), TPB_PARTICLES, 0, 0, n_groups, roots.data(),
+                       indices.data(), label_dev_, sorted.data(), count.data(), sums.data(), groups_dev.data());
+    GPU_Error_Check();
+    groups_dev.cpyDeviceToHost(groups);
+  }
+
+  // Gather the parts on the root
+  #ifdef MPI_CHOLLA
+  int const n_bytes = n_groups * sizeof(Halo);
+  std::vector<int> counts(nproc), displs(nproc, 0);
+  MPI_Gather(&n_bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, root, world);
+  for (int rank = 1; rank < nproc; rank++) {
+    displs[rank] = displs[rank - 1] + counts[rank - 1];
+  }
+  std::vector<Halo> parts((procID == root) ? (displs[nproc - 1] + counts[nproc - 1]) / sizeof(Halo) : 0);
+  MPI_Gatherv(groups.data(), n_bytes, MPI_BYTE, parts.data(), counts.data(), displs.data(), MPI_BYTE, root, world);
+  #else
+  std::vector<Halo> parts = groups;
+  #endif  // MPI_CHOLLA
+
+  // Combine the parts of every group on the root, moving them next to the
+  // first one across the periodic boundaries, and keep the large groups
+  halos_.clear();
+  if (procID == root) {
+    Real const domain_min[3] = {G.domainMin_x, G.domainMin_y, G.domainMin_z};
+    std::sort(parts.begin(), parts.end(), [](Halo const &a, Halo const &b) { return a.id < b.id; });
+    for (size_t first = 0; first < parts.size();) {
+      size_t last = first;
+      Halo halo   = {parts[first].id, 0, 0, {0, 0, 0}, {0, 0, 0}};
+      for (; last < parts.size() && parts[last].id == halo.id; last++) {
+        Halo const &part = parts[last];
+        halo.n_particles += part.n_particles;
+        halo.mass += part.mass;
+        for (int d = 0; d < 3; d++) {
+          double offset = part.pos[d] - parts[first].pos[d];
+          offset -= length[d] * round(offset / length[d]);
+          halo.pos[d] += part.mass * (parts[first].pos[d] + offset);
+          halo.vel[d] += part.vel[d];
+        }
+      }
+      first = last;
+      if (halo.n_particles < min_members_) {
+        continue;
+      }
+      for (int d = 0; d < 3; d++) {
+        halo.pos[d] /= halo.mass;
+        halo.pos[d] -= length[d] * floor((halo.pos[d] - domain_min[d]) / length[d]);
+        halo.vel[d] /= halo.mass;
+      }
+      halos_.push_back(halo);
+    }
+    chprintf(" FoF: %zu halos of at least %d particles, linking length %g, %d rounds\n", halos_.size(), min_members_,
+             linking_length_, rounds);
+  }
+
+  // Select the local particles of the halos of the catalog
+  members_.clear();
+  if (find_members) {
+    std::vector<long long> ids(halos_.size());
+    for (size_t i = 0; i < halos_.size(); i++) {
+      ids[i] = halos_[i].id;
+    }
+    int n_ids = ids.size();
+  #ifdef MPI_CHOLLA
+    MPI_Bcast(&n_ids, 1, MPI_INT, root, world);
+    ids.resize(n_ids);
+    MPI_Bcast(ids.data(), n_ids, MPI_LONG_LONG, root, world);
+  #endif  // MPI_CHOLLA
+    int n_members = 0;
+    if (n_sources > 0 && n_ids > 0) {
+      cuda_utilities::DeviceVector<long long> ids_dev(n_ids);
+      ids_dev.cpyHostToDevice(ids);
+      hipLaunchKernelGGL(Flag_FoF_Members_Kernel, FoF_Grid(n_sources), TPB_PARTICLES, 0, 0, n_sources, n_local,
+                         indices.data(), label_dev_, ids_dev.data(), n_ids, flags.data());
+      GPU_Error_Check();
+      cub::CountingInputIterator<int> source_ids(0);
+      size_t temp_bytes = 0;
+      GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, temp_bytes, source_ids, flags.data(), roots.data(),
+                                                    n_selected_dev_, n_sources));
+      Reserve_FoF_Temp(&temp_dev_, &temp_bytes_, temp_bytes);
+      GPU_Error_Check(cub::DevicePartition::Flagged(temp_dev_, temp_bytes, source_ids, flags.data(), roots.data(),
+                                                    n_selected_dev_, n_sources));
+      GPU_Error_Check(cudaMemcpy(&n_members, n_selected_dev_, sizeof(int), cudaMemcpyDeviceToHost));
+    }
+    if (n_members > 0) {
+  #ifdef PARTICLE_IDS
+      part_int_t *const particle_ids = Particles.partIDs_dev;
+  #else
+      part_int_t *const particle_ids = NULL;
+  #endif  // PARTICLE_IDS
+      cuda_utilities::DeviceVector<Member> members_dev(n_members);
+      hipLaunchKernelGGL(Pack_FoF_Members_Kernel, FoF_Grid(n_members), TPB_PARTICLES, 0, 0, n_members, roots.data(),
+                         indices.data(), label_dev_, sorted.data(), particle_ids, label_offset, members_dev.data());
+      GPU_Error_Check();
+      members_.resize(n_members);
+      members_dev.cpyDeviceToHost(members_);
+    }
+  }
+
+  // The send lists are only valid for this set of sources
+  for (int face = 0; face < 6; face++) {
+    cuda_utilities::Pool_Free(send_dev_[face]);
+    send_dev_[face] = nullptr;
+  }
+}
+
+#endif  // HALO_FINDER
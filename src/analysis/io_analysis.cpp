@@ -18,14 +18,14 @@ void Grid3D::Output_Skewers_File(struct Parameters *P)
 
   // create the filename
   strcpy(filename, P->skewersdir);
-  sprintf(timestep, "%d", Analysis.n_file);
+  sprintf(timestep, "%d", Analysis.output_n_file);
   strcat(filename, timestep);
   // a binary file is created for each process
   // only one HDF5 file is created
   strcat(filename, "_skewers");
   strcat(filename, ".h5");
 
-  chprintf("Writing Skewers File:  %d   ", Analysis.n_file);
+  chprintf("Writing Skewers File:  %d   ", Analysis.output_n_file);
 
   hid_t file_id;
   herr_t status;
@@ -57,10 +57,10 @@ void Grid3D::Write_Skewers_Header_HDF5(hid_t file_id)
   dataspace_id = H5Screate_simple(1, &attr_dims, NULL);
     #ifdef COSMOLOGY
   attribute_id = H5Acreate(file_id, "current_a", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Particles.current_a);
+  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.output_a);
   status       = H5Aclose(attribute_id);
   attribute_id = H5Acreate(file_id, "current_z", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Particles.current_z);
+  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.output_z);
   status       = H5Aclose(attribute_id);
   attribute_id = H5Acreate(file_id, "H0", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
   status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &H0);
@@ -461,7 +461,9 @@ void Grid3D::Write_Skewers_Data_HDF5(hid_t file_id)
 void Grid3D::Output_Analysis(struct Parameters *P)
 {
   #ifdef OUTPUT_SKEWERS
-  Output_Skewers_File(P);
+  if (!Analysis.stream_skewers) {
+    Output_Skewers_File(P);
+  }
   #endif
 
   FILE *out;
@@ -470,14 +472,14 @@ void Grid3D::Output_Analysis(struct Parameters *P)
 
   // create the filename
   strcpy(filename, P->analysisdir);
-  sprintf(timestep, "%d", Analysis.n_file);
+  sprintf(timestep, "%d", Analysis.output_n_file);
   strcat(filename, timestep);
   // a binary file is created for each process
   // only one HDF5 file is created
   strcat(filename, "_analysis");
   strcat(filename, ".h5");
 
-  chprintf("Writing Analysis File: %d   ", Analysis.n_file);
+  chprintf("Writing Analysis File: %d   ", Analysis.output_n_file);
 
   hid_t file_id;
   herr_t status;
@@ -508,10 +510,10 @@ void Grid3D::Write_Analysis_Header_HDF5(hid_t file_id)
   #ifdef COSMOLOGY
   Real H0      = Cosmo.cosmo_h * 100;
   attribute_id = H5Acreate(file_id, "current_a", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Particles.current_a);
+  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.output_a);
   status       = H5Aclose(attribute_id);
   attribute_id = H5Acreate(file_id, "current_z", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Particles.current_z);
+  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.output_z);
   status       = H5Aclose(attribute_id);
   attribute_id = H5Acreate(file_id, "H0", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
   status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &H0);
@@ -603,51 +605,55 @@ void Grid3D::Write_Analysis_Data_HDF5(hid_t file_id)
 
   #ifdef LYA_STATISTICS
 
-  group_id = H5Gcreate(file_id, "/lya_statistics", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-
-  attribute_id = H5Acreate(group_id, "n_skewers", H5T_STD_I32BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_INT, &Analysis.n_skewers_processed);
-  status       = H5Aclose(attribute_id);
-
-  attribute_id = H5Acreate(group_id, "Flux_mean_HI", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.Flux_mean_HI);
-  status       = H5Aclose(attribute_id);
-
-  attribute_id = H5Acreate(group_id, "Flux_mean_HeII", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.Flux_mean_HeII);
-  status       = H5Aclose(attribute_id);
-
-  if (Analysis.Computed_Flux_Power_Spectrum == 1) {
-    hid_t ps_group, dataspace_id_ps;
-    hsize_t dims1d_ps[1];
-    int n_bins      = Analysis.n_hist_edges_x - 1;
-    dims1d_ps[0]    = n_bins;
-    dataspace_id_ps = H5Screate_simple(1, dims1d_ps, NULL);
-
-    ps_group = H5Gcreate(group_id, "power_spectrum", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-
-    Real *buffer_ps = (Real *)malloc(n_bins * sizeof(Real));
-
-    for (int bin_id = 0; bin_id < n_bins; bin_id++) {
-      buffer_ps[bin_id] = Analysis.k_centers[bin_id];
+  // The streamed skewers have no flux statistics
+  if (!Analysis.stream_skewers) {
+    group_id = H5Gcreate(file_id, "/lya_statistics", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+    attribute_id = H5Acreate(group_id, "n_skewers", H5T_STD_I32BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+    status       = H5Awrite(attribute_id, H5T_NATIVE_INT, &Analysis.n_skewers_processed);
+    status       = H5Aclose(attribute_id);
+
+    attribute_id = H5Acreate(group_id, "Flux_mean_HI", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+    status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.Flux_mean_HI);
+    status       = H5Aclose(attribute_id);
+
+    attribute_id = H5Acreate(group_id, "Flux_mean_HeII", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+    status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Analysis.Flux_mean_HeII);
+    status       = H5Aclose(attribute_id);
+
+    if (Analysis.Computed_Flux_Power_Spectrum == 1) {
+      hid_t ps_group, dataspace_id_ps;
+      hsize_t dims1d_ps[1];
+      int n_bins      = Analysis.n_hist_edges_x - 1;
+      dims1d_ps[0]    = n_bins;
+      dataspace_id_ps = H5Screate_simple(1, dims1d_ps, NULL);
+
+      ps_group = H5Gcreate(group_id, "power_spectrum", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+      Real *buffer_ps = (Real *)malloc(n_bins * sizeof(Real));
+
+      for (int bin_id = 0; bin_id < n_bins; bin_id++) {
+        buffer_ps[bin_id] = Analysis.k_centers[bin_id];
+      }
+      dataset_id =
+          H5Dcreate(ps_group, "k_vals", H5T_IEEE_F64BE, dataspace_id_ps, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+      status     = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer_ps);
+      status     = H5Dclose(dataset_id);
+
+      for (int bin_id = 0; bin_id < n_bins; bin_id++) {
+        buffer_ps[bin_id] = Analysis.ps_mean[bin_id];
+      }
+      dataset_id = H5Dcreate(ps_group, "p(k)", H5T_IEEE_F64BE, dataspace_id_ps, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+      status     = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer_ps);
+      status     = H5Dclose(dataset_id);
+
+      free(buffer_ps);
+      status = H5Gclose(ps_group);
     }
-    dataset_id = H5Dcreate(ps_group, "k_vals", H5T_IEEE_F64BE, dataspace_id_ps, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    status     = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer_ps);
-    status     = H5Dclose(dataset_id);
 
-    for (int bin_id = 0; bin_id < n_bins; bin_id++) {
-      buffer_ps[bin_id] = Analysis.ps_mean[bin_id];
-    }
-    dataset_id = H5Dcreate(ps_group, "p(k)", H5T_IEEE_F64BE, dataspace_id_ps, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    status     = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer_ps);
-    status     = H5Dclose(dataset_id);
-
-    free(buffer_ps);
-    status = H5Gclose(ps_group);
+    status = H5Gclose(group_id);
   }
 
-  status = H5Gclose(group_id);
-
   #endif
 }
 
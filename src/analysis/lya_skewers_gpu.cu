@@ -0,0 +1,181 @@
+#if defined(ANALYSIS) && defined(LYA_STATISTICS)
+
+  #include <string>
+  #include <vector>
+
+  #include "../analysis/analysis.h"
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+  #include "../grid/grid_enum.h"
+  #include "../io/io.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/hydro_utilities.h"
+
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
+
+// The fields of the streamed skewers, in the order of their blocks
+  #define N_SKEWER_FIELDS 5
+
+  #ifdef CHEMISTRY_GPU
+// Conversions of the code units to the physical units of
+// Populate_Lya_Skewers_Local
+struct Skewer_Units {
+  Real density;
+  Real velocity;
+  Real energy;
+};
+
+/*! \brief Copy the cells of the local skewers along axis, one every stride cells
+ * in the other two directions, to N_SKEWER_FIELDS blocks of n_skewers * n_los
+ * floats with the line of sight as the fastest index. The skewers are in the
+ * order of Populate_Lya_Skewers_Local */
+__global__ void Extract_Lya_Skewers_Kernel(Real const *dev_conserved, int nx, int ny, int n_cells, int n_ghost,
+                                           int axis, int n_los, int n_skewers_j, int n_skewers, int stride, Real gamma,
+                                           Skewer_Units units, float *skewers)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_skewers * n_los) {
+    return;
+  }
+  int const id_los    = tid % n_los;
+  int const skewer_id = tid / n_los;
+  int const id_i      = (skewer_id / n_skewers_j) * stride;
+  int const id_j      = (skewer_id % n_skewers_j) * stride;
+
+  int const xid = (axis == 0 ? id_los : id_i) + n_ghost;
+  int const yid = (axis == 0 ? id_i : (axis == 1 ? id_los : id_j)) + n_ghost;
+  int const zid = (axis == 2 ? id_los : id_j) + n_ghost;
+  int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+
+  Real const d = dev_conserved[grid_enum::density * n_cells + id];
+    #ifdef DE
+  Real const GE = dev_conserved[grid_enum::GasEnergy * n_cells + id];
+    #else
+  Real const GE = dev_conserved[grid_enum::Energy * n_cells + id] -
+                  hydro_utilities::Calc_Kinetic_Energy_From_Momentum(
+                      d, dev_conserved[grid_enum::momentum_x * n_cells + id],
+                      dev_conserved[grid_enum::momentum_y * n_cells + id],
+                      dev_conserved[grid_enum::momentum_z * n_cells + id]);
+    #endif  // DE
+
+  // The temperature of Compute_Gas_Temperature
+  Real const dens_HI    = dev_conserved[grid_enum::HI_density * n_cells + id];
+  Real const dens_HII   = dev_conserved[grid_enum::HII_density * n_cells + id];
+  Real const dens_HeI   = dev_conserved[grid_enum::HeI_density * n_cells + id];
+  Real const dens_HeII  = dev_conserved[grid_enum::HeII_density * n_cells + id];
+  Real const dens_HeIII = dev_conserved[grid_enum::HeIII_density * n_cells + id];
+  Real const dens_e     = dev_conserved[grid_enum::e_density * n_cells + id];
+  Real const mu         = (dens_HI + dens_HII + dens_HeI + dens_HeII + dens_HeIII) /
+                          (dens_HI + dens_HII + (dens_HeI + dens_HeII + dens_HeIII) / 4 + dens_e);
+  Real const temperature = GE * units.energy * MP * mu / d / KB * (gamma - 1.0);
+
+  Real const momentum_los = dev_conserved[(grid_enum::momentum_x + axis) * n_cells + id];
+
+  int const n_skewer_cells          = n_skewers * n_los;
+  skewers[tid]                      = float(d * units.density);
+  skewers[n_skewer_cells + tid]     = float(temperature);
+  skewers[2 * n_skewer_cells + tid] = float(dens_HI * units.density);
+  skewers[3 * n_skewer_cells + tid] = float(dens_HeII * units.density);
+  skewers[4 * n_skewer_cells + tid] = float(momentum_los / d * units.velocity);
+}
+  #endif  // CHEMISTRY_GPU
+
+void Grid3D::Output_Lya_Skewers_GPU(struct Parameters *P)
+{
+  #ifndef CHEMISTRY_GPU
+  CHOLLA_ERROR("lya_skewers_stream needs the chemistry fields on the device, build with CHEMISTRY_GPU");
+  #else
+  Skewer_Units units;
+  units.density  = Cosmo.rho_0_gas;
+  units.velocity = Cosmo.v_0_gas / Cosmo.current_a;
+  units.energy   = Chem.H.energy_conversion / (Cosmo.current_a * Cosmo.current_a);
+
+  int const stride             = Analysis.n_stride;
+  int const n_local[3]         = {Analysis.nx_local, Analysis.ny_local, Analysis.nz_local};
+  int const n_skewers_local[3] = {Analysis.n_skewers_local_x, Analysis.n_skewers_local_y, Analysis.n_skewers_local_z};
+  size_t n_cells_total         = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    n_cells_total += size_t(n_skewers_local[axis]) * n_local[axis];
+  }
+
+  // create the filename, every process writes the pieces of the skewers that
+  // cross its subvolume
+  std::string filename = std::string(P->analysisdir) + std::to_string(Analysis.n_file) + "_skewers_stream.h5";
+    #ifdef MPI_CHOLLA
+  filename += "." + std::to_string(procID);
+    #endif  // MPI_CHOLLA
+
+  hid_t file_id = Create_Output_File_HDF5(filename, N_SKEWER_FIELDS * n_cells_total * sizeof(float));
+  herr_t status;
+
+  // The attributes that place the pieces of the skewers in the whole box
+  hsize_t attr_dims  = 1;
+  hid_t dataspace_id = H5Screate_simple(1, &attr_dims, NULL);
+  double current_a   = Cosmo.current_a;
+  double current_z   = Cosmo.current_z;
+  int stride_data    = stride;
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &current_a, "current_a");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &current_z, "current_z");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &stride_data, "stride");
+  status             = H5Sclose(dataspace_id);
+
+  attr_dims       = 3;
+  dataspace_id    = H5Screate_simple(1, &attr_dims, NULL);
+  double Lbox[3]  = {Analysis.Lbox_x, Analysis.Lbox_y, Analysis.Lbox_z};
+  int dims[3]     = {Analysis.nx_total, Analysis.ny_total, Analysis.nz_total};
+  int dims_loc[3] = {n_local[0], n_local[1], n_local[2]};
+  int offset[3]   = {0, 0, 0};
+    #ifdef MPI_CHOLLA
+  offset[0] = nx_local_start;
+  offset[1] = ny_local_start;
+  offset[2] = nz_local_start;
+    #endif  // MPI_CHOLLA
+  status = Write_HDF5_Attribute(file_id, dataspace_id, Lbox, "Lbox");
+  status = Write_HDF5_Attribute(file_id, dataspace_id, dims, "dims");
+  status = Write_HDF5_Attribute(file_id, dataspace_id, dims_loc, "dims_local");
+  status = Write_HDF5_Attribute(file_id, dataspace_id, offset, "offset");
+  status = H5Sclose(dataspace_id);
+
+  const char *group_names[3]              = {"/skewers_x", "/skewers_y", "/skewers_z"};
+  const char *field_names[N_SKEWER_FIELDS] = {"density", "temperature", "HI_density", "HeII_density", "velocity"};
+  for (int axis = 0; axis < 3; axis++) {
+    int const n_los             = n_local[axis];
+    int const n_skewers         = n_skewers_local[axis];
+    int const n_skewers_j       = n_local[axis == 2 ? 1 : 2] / stride;
+    size_t const n_skewer_cells = size_t(n_skewers) * n_los;
+    std::vector<float> skewers(N_SKEWER_FIELDS * n_skewer_cells);
+
+    if (n_skewer_cells > 0) {
+      cuda_utilities::DeviceVector<float> device_skewers{N_SKEWER_FIELDS * n_skewer_cells};
+      dim3 dim1dGrid((n_skewer_cells + TPB - 1) / TPB, 1, 1);
+      dim3 dim1dBlock(TPB, 1, 1);
+      hipLaunchKernelGGL(Extract_Lya_Skewers_Kernel, dim1dGrid, dim1dBlock, 0, 0, C.device, H.nx, H.ny, H.n_cells,
+                         H.n_ghost, axis, n_los, n_skewers_j, n_skewers, stride, gama, units, device_skewers.data());
+      GPU_Error_Check();
+      device_skewers.cpyDeviceToHost(skewers.data(), N_SKEWER_FIELDS * n_skewer_cells);
+    }
+
+    hid_t group_id          = H5Gcreate(file_id, group_names[axis], H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    hsize_t skewer_dims[2]  = {hsize_t(n_skewers), hsize_t(n_los)};
+    hid_t dataspace_skewers = H5Screate_simple(2, skewer_dims, NULL);
+    for (int field = 0; field < N_SKEWER_FIELDS; field++) {
+      status = Write_HDF5_Dataset(group_id, dataspace_skewers, skewers.data() + field * n_skewer_cells,
+                                  field_names[field]);
+    }
+    status = H5Sclose(dataspace_skewers);
+    status = H5Gclose(group_id);
+  }
+
+  status = Close_Output_File_HDF5(file_id, filename, Analysis.n_file);
+  if (status < 0) {
+    CHOLLA_ERROR("Writing the skewers file %s failed", filename.c_str());
+  }
+  #endif  // CHEMISTRY_GPU
+}
+
+#endif  // ANALYSIS && LYA_STATISTICS
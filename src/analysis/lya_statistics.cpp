@@ -4,6 +4,8 @@
     #include <complex.h>
     #include <unistd.h>
 
+    #include <algorithm>
+
     #include "../analysis/analysis.h"
     #include "../io/io.h"
 
@@ -17,7 +19,6 @@ void AnalysisModule::Transfer_Skewers_Global_Axis(int axis)
 {
   bool am_I_root;
   int n_skewers_root, n_los;
-  bool *root_procs;
   Real *skewers_density_root;
   Real *skewers_density_global;
   Real *skewers_HI_density_root;
@@ -32,14 +33,13 @@ void AnalysisModule::Transfer_Skewers_Global_Axis(int axis)
   Real *skewers_F_HI_root;
   Real *skewers_F_HeII_global;
   Real *skewers_F_HeII_root;
-  Real *transfer_buffer;
+  MPI_Comm comm_roots;
 
   // chprintf( "  Transfering Skewers \n" );
 
   if (axis == 0) {
     am_I_root                   = am_I_root_x;
     n_los                       = nx_total;
-    root_procs                  = root_procs_x;
     n_skewers_root              = n_skewers_local_x;
     skewers_density_root        = skewers_density_root_x;
     skewers_density_global      = skewers_density_x_global;
@@ -55,12 +55,11 @@ void AnalysisModule::Transfer_Skewers_Global_Axis(int axis)
     skewers_F_HeII_global       = skewers_transmitted_flux_HeII_x_global;
     skewers_F_HI_root           = skewers_transmitted_flux_HI_x;
     skewers_F_HeII_root         = skewers_transmitted_flux_HeII_x;
-    transfer_buffer             = transfer_buffer_root_x;
+    comm_roots                  = comm_skewers_roots_x;
   }
   if (axis == 1) {
     am_I_root                   = am_I_root_y;
     n_los                       = ny_total;
-    root_procs                  = root_procs_y;
     n_skewers_root              = n_skewers_local_y;
     skewers_density_root        = skewers_density_root_y;
     skewers_density_global      = skewers_density_y_global;
@@ -76,12 +75,11 @@ void AnalysisModule::Transfer_Skewers_Global_Axis(int axis)
     skewers_F_HeII_global       = skewers_transmitted_flux_HeII_y_global;
     skewers_F_HI_root           = skewers_transmitted_flux_HI_y;
     skewers_F_HeII_root         = skewers_transmitted_flux_HeII_y;
-    transfer_buffer             = transfer_buffer_root_y;
+    comm_roots                  = comm_skewers_roots_y;
   }
   if (axis == 2) {
     am_I_root                   = am_I_root_z;
     n_los                       = nz_total;
-    root_procs                  = root_procs_z;
     n_skewers_root              = n_skewers_local_z;
     skewers_density_root        = skewers_density_root_z;
     skewers_density_global      = skewers_density_z_global;
@@ -97,191 +95,22 @@ void AnalysisModule::Transfer_Skewers_Global_Axis(int axis)
     skewers_F_HeII_global       = skewers_transmitted_flux_HeII_z_global;
     skewers_F_HI_root           = skewers_transmitted_flux_HI_z;
     skewers_F_HeII_root         = skewers_transmitted_flux_HeII_z;
-    transfer_buffer             = transfer_buffer_root_z;
+    comm_roots                  = comm_skewers_roots_z;
   }
 
   if (!am_I_root) return;
 
-  MPI_Status mpi_status;
-  int n_added, offset;
-
-    #ifdef OUTPUT_SKEWERS
-  // Set the density array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_density_global[skewer_id * n_los + los_id] = skewers_density_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_density_global[offset + skewer_id * n_los + los_id] = transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_density_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-    #endif
-
-  // Set the HI density array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_HI_density_global[skewer_id * n_los + los_id] = skewers_HI_density_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_HI_density_global[offset + skewer_id * n_los + los_id] = transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_HI_density_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-
-  // Set the HeII density array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_HeII_density_global[skewer_id * n_los + los_id] = skewers_HeII_density_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_HeII_density_global[offset + skewer_id * n_los + los_id] =
-              transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_HeII_density_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-
-  // Set the temeprature array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_temperature_global[skewer_id * n_los + los_id] = skewers_temperature_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_temperature_global[offset + skewer_id * n_los + los_id] = transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_temperature_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-
-  // Set the los_velocity array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_los_velocity_global[skewer_id * n_los + los_id] = skewers_los_velocity_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_los_velocity_global[offset + skewer_id * n_los + los_id] =
-              transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_los_velocity_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-
-  // Set the HI Flux array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_F_HI_global[skewer_id * n_los + los_id] = skewers_F_HI_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_F_HI_global[offset + skewer_id * n_los + los_id] = transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_F_HI_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
-  }
-
-  // Set the HeII Flux array
-  if (procID == 0) {
-    // Write the local data into the global array
-    for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-      for (int los_id = 0; los_id < n_los; los_id++) {
-        skewers_F_HeII_global[skewer_id * n_los + los_id] = skewers_F_HeII_root[skewer_id * n_los + los_id];
-      }
-    }
-    // Write the remote data into the global array
-    n_added = 1;
-    for (int p_id = 1; p_id < nproc; p_id++) {
-      if (!root_procs[p_id]) continue;
-      MPI_Recv(transfer_buffer, n_skewers_root * n_los, MPI_CHREAL, p_id, 0, world, &mpi_status);
-      offset = n_added * n_skewers_root * n_los;
-      for (int skewer_id = 0; skewer_id < n_skewers_root; skewer_id++) {
-        for (int los_id = 0; los_id < n_los; los_id++) {
-          skewers_F_HeII_global[offset + skewer_id * n_los + los_id] = transfer_buffer[skewer_id * n_los + los_id];
-        }
-      }
-      n_added += 1;
-    }
-  } else {
-    MPI_Send(skewers_F_HeII_root, n_skewers_root * n_los, MPI_CHREAL, 0, 0, world);
+  // The roots hold the same number of skewers and go to the global arrays in
+  // the order of their procID, so every field is a single gather on the roots
+  int const n_root              = n_skewers_root * n_los;
+  Real *const skewers_root[7]   = {skewers_density_root,     skewers_HI_density_root,   skewers_HeII_density_root,
+                                   skewers_temperature_root, skewers_los_velocity_root, skewers_F_HI_root,
+                                   skewers_F_HeII_root};
+  Real *const skewers_global[7] = {skewers_density_global,     skewers_HI_density_global,   skewers_HeII_density_global,
+                                   skewers_temperature_global, skewers_los_velocity_global, skewers_F_HI_global,
+                                   skewers_F_HeII_global};
+  for (int field = 0; field < 7; field++) {
+    MPI_Gather(skewers_root[field], n_root, MPI_CHREAL, skewers_global[field], n_root, MPI_CHREAL, 0, comm_roots);
   }
 }
 
@@ -314,7 +143,7 @@ int Locate_Index(Real val, Real *values, int N)
 
 void AnalysisModule::Clear_Power_Spectrum_Measurements(void)
 {
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
 
   // chprintf( "Cleared Power Spectrum cache \n ");
   free(hist_k_edges_x);
@@ -374,7 +203,7 @@ void Grid3D::Initialize_Power_Spectrum_Measurements(int axis)
 
   // Get Cosmological variables
   Real H, current_a, L_proper, dx_proper, dv_Hubble;
-  current_a = Cosmo.current_a;
+  current_a = Analysis.output_a;
   L_proper  = Lbox * current_a / Cosmo.cosmo_h;
   dx_proper = delta_x * current_a / Cosmo.cosmo_h;
   H         = Cosmo.Get_Hubble_Parameter(current_a);
@@ -573,7 +402,7 @@ void Grid3D::Compute_Flux_Power_Spectrum_Skewer(int skewer_id, int axis)
 
   // Get Cosmological variables
   Real H, current_a, L_proper, dx_proper, dv_Hubble;
-  current_a = Cosmo.current_a;
+  current_a = Analysis.output_a;
   L_proper  = Lbox * current_a / Cosmo.cosmo_h;
   dx_proper = delta_x * current_a / Cosmo.cosmo_h;
   H         = Cosmo.Get_Hubble_Parameter(current_a);
@@ -658,8 +487,8 @@ void AnalysisModule::Reduce_Power_Spectrum_Axis(int axis)
     n_axis    = &n_PS_axis_z;
   }
 
-  MPI_Allreduce(ps_root, ps_global, n_bins, MPI_CHREAL, MPI_SUM, world);
-  MPI_Allreduce(&n_root, n_axis, 1, MPI_INT, MPI_SUM, world);
+  MPI_Allreduce(ps_root, ps_global, n_bins, MPI_CHREAL, MPI_SUM, world_analysis);
+  MPI_Allreduce(&n_root, n_axis, 1, MPI_INT, MPI_SUM, world_analysis);
   // chprintf( "  N_Skewers_Processed: %d \n", *n_axis );
 }
 
@@ -743,14 +572,14 @@ void AnalysisModule::Reduce_Lya_Mean_Flux_Axis(int axis)
     if (procID == i)
       printf("   procID:%d   Flux_HI_Sum: %e     N_Skewers_Processed: %d \n", procID, (*Flux_mean_root_HI),
              *n_skewers_processed_root);
-    MPI_Barrier(world);
+    MPI_Barrier(world_analysis);
     sleep(1);
   }
       #endif
 
-  MPI_Allreduce(Flux_mean_root_HI, Flux_mean_HI, 1, MPI_CHREAL, MPI_SUM, world);
-  MPI_Allreduce(Flux_mean_root_HeII, Flux_mean_HeII, 1, MPI_CHREAL, MPI_SUM, world);
-  MPI_Allreduce(n_skewers_processed_root, n_skewers_processed, 1, MPI_INT, MPI_SUM, world);
+  MPI_Allreduce(Flux_mean_root_HI, Flux_mean_HI, 1, MPI_CHREAL, MPI_SUM, world_analysis);
+  MPI_Allreduce(Flux_mean_root_HeII, Flux_mean_HeII, 1, MPI_CHREAL, MPI_SUM, world_analysis);
+  MPI_Allreduce(n_skewers_processed_root, n_skewers_processed, 1, MPI_INT, MPI_SUM, world_analysis);
 
     #else
 
@@ -969,7 +798,7 @@ void Grid3D::Compute_Transmitted_Flux_Skewer(int skewer_id, int axis)
   }
 
   Real dens_factor, dens_factor_HI, dens_factor_HeII, vel_factor;
-  dens_factor      = 1. / (Cosmo.current_a * Cosmo.current_a * Cosmo.current_a) * Cosmo.cosmo_h * Cosmo.cosmo_h;
+  dens_factor      = 1. / (Analysis.output_a * Analysis.output_a * Analysis.output_a) * Cosmo.cosmo_h * Cosmo.cosmo_h;
   dens_factor_HI   = dens_factor * Msun / (kpc3) / Mp;
   dens_factor_HeII = dens_factor * Msun / (kpc3) / (4 * Mp);
   vel_factor       = 1e5;  // cm/s
@@ -978,7 +807,7 @@ void Grid3D::Compute_Transmitted_Flux_Skewer(int skewer_id, int axis)
   Real H, current_a, L_proper, dx_proper, dv_Hubble;
   Real H_cgs, Lya_lambda_HI, f_12, Lya_sigma_HI;
   Real Lya_lambda_HeII, Lya_sigma_HeII;
-  current_a = Cosmo.current_a;
+  current_a = Analysis.output_a;
   L_proper  = Lbox * current_a / Cosmo.cosmo_h;
   dx_proper = delta_x * current_a / Cosmo.cosmo_h;
   H         = Cosmo.Get_Hubble_Parameter(current_a);
@@ -1052,9 +881,7 @@ void AnalysisModule::Transfer_Skewers_Data(int axis)
     #endif
 
     #ifdef MPI_CHOLLA
-  vector<int> mpi_indices;
-  MPI_Status mpi_status;
-
+  MPI_Comm comm_skewers;
     #endif
 
   if (axis == 0) {
@@ -1072,7 +899,7 @@ void AnalysisModule::Transfer_Skewers_Data(int axis)
     skewers_velocity_root      = skewers_velocity_root_x;
     skewers_temperature_root   = skewers_temperature_root_x;
     #ifdef MPI_CHOLLA
-    mpi_indices = mpi_indices_x;
+    comm_skewers = comm_skewers_x;
     #endif
     #ifdef OUTPUT_SKEWERS
     skewers_density_root  = skewers_density_root_x;
@@ -1095,7 +922,7 @@ void AnalysisModule::Transfer_Skewers_Data(int axis)
     skewers_velocity_root      = skewers_velocity_root_y;
     skewers_temperature_root   = skewers_temperature_root_y;
     #ifdef MPI_CHOLLA
-    mpi_indices = mpi_indices_y;
+    comm_skewers = comm_skewers_y;
     #endif
     #ifdef OUTPUT_SKEWERS
     skewers_density_root  = skewers_density_root_y;
@@ -1118,7 +945,7 @@ void AnalysisModule::Transfer_Skewers_Data(int axis)
     skewers_velocity_root      = skewers_velocity_root_z;
     skewers_temperature_root   = skewers_temperature_root_z;
     #ifdef MPI_CHOLLA
-    mpi_indices = mpi_indices_z;
+    comm_skewers = comm_skewers_z;
     #endif
     #ifdef OUTPUT_SKEWERS
     skewers_density_root  = skewers_density_root_z;
@@ -1126,95 +953,36 @@ void AnalysisModule::Transfer_Skewers_Data(int axis)
     #endif
   }
 
-  // Copy Skewers Local Data to Root data
-
-  Real HI_density, HeII_density, velocity, temperature;
-  Real density;
-
     #ifdef MPI_CHOLLA
-  if (am_I_root) {
-    if (root_id != procID) {
-      printf("ERROR: Root ID doesn't match procID\n");
-      exit(-1);
-    }
-
-    for (int skewer_id = 0; skewer_id < n_skewers; skewer_id++) {
-      for (int los_id = 0; los_id < n_los_local; los_id++) {
-        HI_density   = skewers_HI_density_local[skewer_id * n_los_local + los_id];
-        HeII_density = skewers_HeII_density_local[skewer_id * n_los_local + los_id];
-        velocity     = skewers_velocity_local[skewer_id * n_los_local + los_id];
-        temperature  = skewers_temperature_local[skewer_id * n_los_local + los_id];
-        skewers_HI_density_root[skewer_id * n_los_total + los_id]   = HI_density;
-        skewers_HeII_density_root[skewer_id * n_los_total + los_id] = HeII_density;
-        skewers_velocity_root[skewer_id * n_los_total + los_id]     = velocity;
-        skewers_temperature_root[skewer_id * n_los_total + los_id]  = temperature;
-      #ifdef OUTPUT_SKEWERS
-        density = skewers_density_local[skewer_id * n_los_local + los_id];
-        skewers_density_root[skewer_id * n_los_total + los_id] = density;
-      #endif
-      }
-    }
-
-    int n_indices = mpi_indices.size();
-
-      #ifdef PRINT_ANALYSIS_LOG
-    printf("  N MPI indices: %d \n", n_indices);
-      #endif
-
-    int mpi_id;
-    for (int indx = 0; indx < n_indices; indx++) {
-      mpi_id = mpi_indices[indx];
-      if (indx == 0) {
-        if (mpi_id != procID) {
-          printf("ERROR: Fist MPI indx doesn't match root indx \n");
-          exit(-1);
-        }
-        continue;
-      }
-
-      #ifdef PRINT_ANALYSIS_LOG
-      printf("  Receiving Skewers From pID: %d\n", mpi_id);
-      #endif
-
-      MPI_Recv(skewers_HI_density_local, n_skewers * n_los_local, MPI_CHREAL, mpi_id, 0, world, &mpi_status);
-      MPI_Recv(skewers_velocity_local, n_skewers * n_los_local, MPI_CHREAL, mpi_id, 1, world, &mpi_status);
-      MPI_Recv(skewers_temperature_local, n_skewers * n_los_local, MPI_CHREAL, mpi_id, 2, world, &mpi_status);
-      MPI_Recv(skewers_HeII_density_local, n_skewers * n_los_local, MPI_CHREAL, mpi_id, 3, world, &mpi_status);
-
-      #ifdef OUTPUT_SKEWERS
-      MPI_Recv(skewers_density_local, n_skewers * n_los_local, MPI_CHREAL, mpi_id, 4, world, &mpi_status);
-      #endif
-
-      for (int skewer_id = 0; skewer_id < n_skewers; skewer_id++) {
-        for (int los_id = 0; los_id < n_los_local; los_id++) {
-          skewers_HI_density_root[skewer_id * n_los_total + indx * n_los_local + los_id] =
-              skewers_HI_density_local[skewer_id * n_los_local + los_id];
-          skewers_HeII_density_root[skewer_id * n_los_total + indx * n_los_local + los_id] =
-              skewers_HeII_density_local[skewer_id * n_los_local + los_id];
-          skewers_velocity_root[skewer_id * n_los_total + indx * n_los_local + los_id] =
-              skewers_velocity_local[skewer_id * n_los_local + los_id];
-          skewers_temperature_root[skewer_id * n_los_total + indx * n_los_local + los_id] =
-              skewers_temperature_local[skewer_id * n_los_local + los_id];
-      #ifdef OUTPUT_SKEWERS
-          skewers_density_root[skewer_id * n_los_total + indx * n_los_local + los_id] =
-              skewers_density_local[skewer_id * n_los_local + los_id];
-      #endif
-        }
-      }
-    }
+  if (am_I_root && root_id != procID) {
+    printf("ERROR: Root ID doesn't match procID\n");
+    exit(-1);
   }
 
-  else {
-    MPI_Send(skewers_HI_density_local, n_skewers * n_los_local, MPI_CHREAL, root_id, 0, world);
-    MPI_Send(skewers_velocity_local, n_skewers * n_los_local, MPI_CHREAL, root_id, 1, world);
-    MPI_Send(skewers_temperature_local, n_skewers * n_los_local, MPI_CHREAL, root_id, 2, world);
-    MPI_Send(skewers_HeII_density_local, n_skewers * n_los_local, MPI_CHREAL, root_id, 3, world);
+  // The piece of the skewers of the rank i along the axis goes to n_skewers
+  // blocks of n_los_local cells, n_los_total apart, starting at cell
+  // i * n_los_local of the root arrays. Resizing the type to n_los_local cells
+  // lets a single gather on the line of processes place every piece, the
+  // root's own included
+  MPI_Datatype piece_type, root_piece_type;
+  MPI_Type_vector(n_skewers, n_los_local, n_los_total, MPI_CHREAL, &piece_type);
+  MPI_Type_create_resized(piece_type, 0, n_los_local * sizeof(Real), &root_piece_type);
+  MPI_Type_commit(&root_piece_type);
+  MPI_Type_free(&piece_type);
+
+  int const n_local = n_skewers * n_los_local;
+  MPI_Gather(skewers_HI_density_local, n_local, MPI_CHREAL, skewers_HI_density_root, 1, root_piece_type, 0,
+             comm_skewers);
+  MPI_Gather(skewers_HeII_density_local, n_local, MPI_CHREAL, skewers_HeII_density_root, 1, root_piece_type, 0,
+             comm_skewers);
+  MPI_Gather(skewers_velocity_local, n_local, MPI_CHREAL, skewers_velocity_root, 1, root_piece_type, 0, comm_skewers);
+  MPI_Gather(skewers_temperature_local, n_local, MPI_CHREAL, skewers_temperature_root, 1, root_piece_type, 0,
+             comm_skewers);
       #ifdef OUTPUT_SKEWERS
-    MPI_Send(skewers_density_local, n_skewers * n_los_local, MPI_CHREAL, root_id, 4, world);
+  MPI_Gather(skewers_density_local, n_local, MPI_CHREAL, skewers_density_root, 1, root_piece_type, 0, comm_skewers);
       #endif
-  }
 
-  MPI_Barrier(world);
+  MPI_Type_free(&root_piece_type);
     #endif
 
     #ifdef PRINT_ANALYSIS_LOG
@@ -1357,6 +1125,12 @@ void AnalysisModule::Initialize_Lya_Statistics(struct Parameters *P)
   n_stride = P->lya_skewers_stride;
   chprintf("  Lya Skewers Stride: %d\n", n_stride);
 
+  stream_skewers               = P->lya_skewers_stream;
+  Computed_Flux_Power_Spectrum = 0;
+  if (stream_skewers) {
+    chprintf("  Streaming the Lya skewers, the flux statistics aren't computed\n");
+  }
+
   d_log_k = P->lya_Pk_d_log_k;
   chprintf("  Power Spectrum d_log_k: %f\n", d_log_k);
 
@@ -1410,9 +1184,9 @@ void AnalysisModule::Initialize_Lya_Statistics(struct Parameters *P)
   mpi_domain_boundary_y = (Real *)malloc(nproc * sizeof(Real));
   mpi_domain_boundary_z = (Real *)malloc(nproc * sizeof(Real));
 
-  MPI_Allgather(&xMin, 1, MPI_CHREAL, mpi_domain_boundary_x, 1, MPI_CHREAL, world);
-  MPI_Allgather(&yMin, 1, MPI_CHREAL, mpi_domain_boundary_y, 1, MPI_CHREAL, world);
-  MPI_Allgather(&zMin, 1, MPI_CHREAL, mpi_domain_boundary_z, 1, MPI_CHREAL, world);
+  MPI_Allgather(&xMin, 1, MPI_CHREAL, mpi_domain_boundary_x, 1, MPI_CHREAL, world_analysis);
+  MPI_Allgather(&yMin, 1, MPI_CHREAL, mpi_domain_boundary_y, 1, MPI_CHREAL, world_analysis);
+  MPI_Allgather(&zMin, 1, MPI_CHREAL, mpi_domain_boundary_z, 1, MPI_CHREAL, world_analysis);
 
   root_id_x = -1;
   root_id_y = -1;
@@ -1540,6 +1314,18 @@ void AnalysisModule::Initialize_Lya_Statistics(struct Parameters *P)
   else
     am_I_root_z = false;
 
+  // The processes along the skewers of each axis share their root, and are
+  // ranked by their position in mpi_indices
+  int const position_x = std::find(mpi_indices_x.begin(), mpi_indices_x.end(), procID) - mpi_indices_x.begin();
+  int const position_y = std::find(mpi_indices_y.begin(), mpi_indices_y.end(), procID) - mpi_indices_y.begin();
+  int const position_z = std::find(mpi_indices_z.begin(), mpi_indices_z.end(), procID) - mpi_indices_z.begin();
+  MPI_Comm_split(world_analysis, root_id_x, position_x, &comm_skewers_x);
+  MPI_Comm_split(world_analysis, root_id_y, position_y, &comm_skewers_y);
+  MPI_Comm_split(world_analysis, root_id_z, position_z, &comm_skewers_z);
+  MPI_Comm_split(world_analysis, am_I_root_x ? 0 : MPI_UNDEFINED, procID, &comm_skewers_roots_x);
+  MPI_Comm_split(world_analysis, am_I_root_y ? 0 : MPI_UNDEFINED, procID, &comm_skewers_roots_y);
+  MPI_Comm_split(world_analysis, am_I_root_z ? 0 : MPI_UNDEFINED, procID, &comm_skewers_roots_z);
+
   if (procID == 0) {
     root_procs_x = (bool *)malloc(nproc * sizeof(bool));
     root_procs_y = (bool *)malloc(nproc * sizeof(bool));
@@ -1547,9 +1333,9 @@ void AnalysisModule::Initialize_Lya_Statistics(struct Parameters *P)
   }
 
   // Gather the root processes
-  MPI_Gather(&am_I_root_x, 1, MPI_C_BOOL, root_procs_x, 1, MPI_C_BOOL, 0, world);
-  MPI_Gather(&am_I_root_y, 1, MPI_C_BOOL, root_procs_y, 1, MPI_C_BOOL, 0, world);
-  MPI_Gather(&am_I_root_z, 1, MPI_C_BOOL, root_procs_z, 1, MPI_C_BOOL, 0, world);
+  MPI_Gather(&am_I_root_x, 1, MPI_C_BOOL, root_procs_x, 1, MPI_C_BOOL, 0, world_analysis);
+  MPI_Gather(&am_I_root_y, 1, MPI_C_BOOL, root_procs_y, 1, MPI_C_BOOL, 0, world_analysis);
+  MPI_Gather(&am_I_root_z, 1, MPI_C_BOOL, root_procs_z, 1, MPI_C_BOOL, 0, world_analysis);
 
   int n_skewers_global_x, n_skewers_global_y, n_skewers_global_z;
   if (procID == 0) {
@@ -1595,38 +1381,35 @@ void AnalysisModule::Initialize_Lya_Statistics(struct Parameters *P)
     skewers_los_velocity_y_global = (Real *)malloc(n_skewers_global_y * ny_total * sizeof(Real));
     skewers_los_velocity_z_global = (Real *)malloc(n_skewers_global_z * nz_total * sizeof(Real));
 
-    transfer_buffer_root_x = (Real *)malloc(n_skewers_local_x * nx_total * sizeof(Real));
-    transfer_buffer_root_y = (Real *)malloc(n_skewers_local_y * ny_total * sizeof(Real));
-    transfer_buffer_root_z = (Real *)malloc(n_skewers_local_z * nz_total * sizeof(Real));
   }
       #endif
 
       #ifdef PRINT_ANALYSIS_LOG
   chprintf(" Root Ids X:  \n");
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
   if (am_I_root_x) {
     printf("  pID: %d  \n", procID);
   }
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
 
   chprintf(" Root Ids Y:  \n");
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
   if (am_I_root_y) {
     printf("  pID: %d  \n", procID);
   }
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
 
   chprintf(" Root Ids Z:  \n");
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
   if (am_I_root_z) {
     printf("  pID: %d  \n", procID);
   }
-  MPI_Barrier(world);
+  MPI_Barrier(world_analysis);
   sleep(1);
 
   if (procID == 0) {
@@ -0,0 +1,337 @@
+#if defined(ANALYSIS) && defined(LYA_STATISTICS) && defined(LYA_STATISTICS_GPU)
+
+  #include <cmath>
+  #include <vector>
+
+  #include "../analysis/analysis.h"
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+  #include "../io/io.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+
+  #if PRECISION == 1
+typedef cufftComplex Lya_Complex;
+  #else
+typedef cufftDoubleComplex Lya_Complex;
+  #endif  // PRECISION
+
+int Locate_Index(Real val, Real *values, int N);
+
+// Conversions of the skewer fields to the optical depth integral of
+// Compute_Transmitted_Flux_Skewer
+struct Lya_Factors {
+  Real density_HI;
+  Real density_HeII;
+  Real velocity;
+  // 2 Kb / m of the absorbers, the thermal width is sqrt(factor * T)
+  Real thermal_HI;
+  Real thermal_HeII;
+  Real sigma_HI;
+  Real sigma_HeII;
+};
+
+/*! \brief Compute the HI and HeII transmitted flux of every cell of n_skewers
+ * periodic skewers of n_los cells, one thread per cell. The n_ghost cells on
+ * each side of Compute_Transmitted_Flux_Skewer are folded into the loop over
+ * the absorbers by wrapping the index */
+__global__ void Compute_Transmitted_Flux_Kernel(Real const *density_HI, Real const *density_HeII,
+                                                Real const *velocity, Real const *temperature, int n_skewers,
+                                                int n_los, int n_ghost, Real dv_Hubble, Lya_Factors factors,
+                                                Real *flux_HI, Real *flux_HeII)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_skewers * n_los) {
+    return;
+  }
+  int const skewer_start = (tid / n_los) * n_los;
+  Real const vel_i       = (tid % n_los + 0.5) * dv_Hubble;
+
+  Real tau_HI   = 0;
+  Real tau_HeII = 0;
+  for (int j = -n_ghost; j < n_los + n_ghost; j++) {
+    int const id_j     = skewer_start + (j % n_los + n_los) % n_los;
+    Real const vel_j   = (j + 0.5) * dv_Hubble + velocity[id_j] * factors.velocity;
+    Real const b_HI    = sqrt(factors.thermal_HI * temperature[id_j]);
+    Real const b_HeII  = sqrt(factors.thermal_HeII * temperature[id_j]);
+    Real const y_left  = vel_i - 0.5 * dv_Hubble - vel_j;
+    Real const y_right = vel_i + 0.5 * dv_Hubble - vel_j;
+    tau_HI += density_HI[id_j] * (erf(y_right / b_HI) - erf(y_left / b_HI)) / 2;
+    tau_HeII += density_HeII[id_j] * (erf(y_right / b_HeII) - erf(y_left / b_HeII)) / 2;
+  }
+  flux_HI[tid]   = exp(-tau_HI * factors.density_HI * factors.sigma_HI);
+  flux_HeII[tid] = exp(-tau_HeII * factors.density_HeII * factors.sigma_HeII);
+}
+
+/*! \brief Divide the flux of every cell by the mean flux */
+__global__ void Compute_Delta_Flux_Kernel(Real const *flux, int n_cells, Real flux_mean, Real *delta_F)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_cells) {
+    return;
+  }
+  delta_F[tid] = flux[tid] / flux_mean;
+}
+
+/*! \brief Add the amplitude of the FFT of every skewer to the k-bins of
+ * bin_ids, where the k values outside of the histogram have a negative bin */
+__global__ void Bin_Flux_Power_Spectrum_Kernel(Lya_Complex const *fft_delta_F, int n_skewers, int n_fft, int n_los,
+                                               int const *bin_ids, Real *hist_PS)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_skewers * n_fft) {
+    return;
+  }
+  int const bin_id = bin_ids[tid % n_fft];
+  if (bin_id < 0) {
+    return;
+  }
+  Lya_Complex const value = fft_delta_F[tid];
+  atomicAdd(&hist_PS[bin_id], (value.x * value.x + value.y * value.y) / n_los / n_los);
+}
+
+void Grid3D::Compute_Transmitted_Flux_GPU(int axis)
+{
+  int n_skewers, n_los;
+  bool am_I_root;
+  Real Lbox, delta_x;
+  Real *skewers_HI_density_root;
+  Real *skewers_HeII_density_root;
+  Real *skewers_velocity_root;
+  Real *skewers_temperature_root;
+  Real *skewers_transmitted_flux_HI;
+  Real *skewers_transmitted_flux_HeII;
+
+  if (axis == 0) {
+    n_skewers                     = Analysis.n_skewers_local_x;
+    n_los                         = Analysis.nx_total;
+    am_I_root                     = Analysis.am_I_root_x;
+    Lbox                          = Analysis.Lbox_x;
+    delta_x                       = Analysis.dx;
+    skewers_HI_density_root       = Analysis.skewers_HI_density_root_x;
+    skewers_HeII_density_root     = Analysis.skewers_HeII_density_root_x;
+    skewers_velocity_root         = Analysis.skewers_velocity_root_x;
+    skewers_temperature_root      = Analysis.skewers_temperature_root_x;
+    skewers_transmitted_flux_HI   = Analysis.skewers_transmitted_flux_HI_x;
+    skewers_transmitted_flux_HeII = Analysis.skewers_transmitted_flux_HeII_x;
+  }
+
+  if (axis == 1) {
+    n_skewers                     = Analysis.n_skewers_local_y;
+    n_los                         = Analysis.ny_total;
+    am_I_root                     = Analysis.am_I_root_y;
+    Lbox                          = Analysis.Lbox_y;
+    delta_x                       = Analysis.dy;
+    skewers_HI_density_root       = Analysis.skewers_HI_density_root_y;
+    skewers_HeII_density_root     = Analysis.skewers_HeII_density_root_y;
+    skewers_velocity_root         = Analysis.skewers_velocity_root_y;
+    skewers_temperature_root      = Analysis.skewers_temperature_root_y;
+    skewers_transmitted_flux_HI   = Analysis.skewers_transmitted_flux_HI_y;
+    skewers_transmitted_flux_HeII = Analysis.skewers_transmitted_flux_HeII_y;
+  }
+
+  if (axis == 2) {
+    n_skewers                     = Analysis.n_skewers_local_z;
+    n_los                         = Analysis.nz_total;
+    am_I_root                     = Analysis.am_I_root_z;
+    Lbox                          = Analysis.Lbox_z;
+    delta_x                       = Analysis.dz;
+    skewers_HI_density_root       = Analysis.skewers_HI_density_root_z;
+    skewers_HeII_density_root     = Analysis.skewers_HeII_density_root_z;
+    skewers_velocity_root         = Analysis.skewers_velocity_root_z;
+    skewers_temperature_root      = Analysis.skewers_temperature_root_z;
+    skewers_transmitted_flux_HI   = Analysis.skewers_transmitted_flux_HI_z;
+    skewers_transmitted_flux_HeII = Analysis.skewers_transmitted_flux_HeII_z;
+  }
+
+  size_t const n_cells = size_t(n_skewers) * n_los;
+  if (!am_I_root || n_cells == 0) {
+    return;
+  }
+
+  // Constants in CGS
+  Real const Kb       = 1.38064852e-16;  // g (cm/s)^2 K-1
+  Real const Msun     = 1.98847e33;      // g
+  Real const Mp       = 1.6726219e-24;   // g
+  Real const Me       = 9.10938356e-28;  // g
+  Real const c        = 2.99792458e10;   // cm/s
+  Real const kpc      = 3.0857e21;       // cm
+  Real const e_charge = 4.8032e-10;      // cm^3/2 g^1/2 s^-1
+
+  Real const current_a   = Analysis.output_a;
+  Real const dens_factor = 1. / (current_a * current_a * current_a) * Cosmo.cosmo_h * Cosmo.cosmo_h;
+  Real const dx_proper   = delta_x * current_a / Cosmo.cosmo_h;
+  Real const H           = Cosmo.Get_Hubble_Parameter(current_a);
+  Real const H_cgs       = H * 1e5 / kpc;
+
+  Real const Lya_lambda_HI   = 1.21567e-5;  // cm  Rest wave length of the Lyman Alpha Transition Hydrogen
+  Real const Lya_lambda_HeII = Lya_lambda_HI / 4;
+  Real const f_12            = 0.416;  // Lya transition Oscillator strength
+
+  Lya_Factors factors;
+  factors.density_HI   = dens_factor * Msun / (kpc * kpc * kpc) / Mp;
+  factors.density_HeII = dens_factor * Msun / (kpc * kpc * kpc) / (4 * Mp);
+  factors.velocity     = 1e5;  // cm/s
+  factors.thermal_HI   = 2 * Kb / Mp;
+  factors.thermal_HeII = 2 * Kb / (4 * Mp);
+  factors.sigma_HI     = M_PI * e_charge * e_charge / Me / c * Lya_lambda_HI * f_12 / H_cgs;
+  factors.sigma_HeII   = M_PI * e_charge * e_charge / Me / c * Lya_lambda_HeII * f_12 / H_cgs;
+  Real const dv_Hubble = H * dx_proper * factors.velocity;  // cm/s
+
+  cuda_utilities::DeviceVector<Real> density_HI{n_cells};
+  cuda_utilities::DeviceVector<Real> density_HeII{n_cells};
+  cuda_utilities::DeviceVector<Real> velocity{n_cells};
+  cuda_utilities::DeviceVector<Real> temperature{n_cells};
+  cuda_utilities::DeviceVector<Real> flux_HI{n_cells};
+  cuda_utilities::DeviceVector<Real> flux_HeII{n_cells};
+  density_HI.cpyHostToDevice(skewers_HI_density_root, n_cells);
+  density_HeII.cpyHostToDevice(skewers_HeII_density_root, n_cells);
+  velocity.cpyHostToDevice(skewers_velocity_root, n_cells);
+  temperature.cpyHostToDevice(skewers_temperature_root, n_cells);
+
+  dim3 dim1dGrid((n_cells + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Compute_Transmitted_Flux_Kernel, dim1dGrid, dim1dBlock, 0, 0, density_HI.data(),
+                     density_HeII.data(), velocity.data(), temperature.data(), n_skewers, n_los,
+                     Analysis.n_ghost_skewer, dv_Hubble, factors, flux_HI.data(), flux_HeII.data());
+  GPU_Error_Check();
+
+  flux_HI.cpyDeviceToHost(skewers_transmitted_flux_HI, n_cells);
+  flux_HeII.cpyDeviceToHost(skewers_transmitted_flux_HeII, n_cells);
+}
+
+void Grid3D::Compute_Flux_Power_Spectrum_GPU(int axis)
+{
+  bool am_I_root;
+  int n_skewers, n_los, n_fft, n_hist_edges;
+  Real Lbox;
+  Real *k_vals;
+  Real *hist_k_edges;
+  Real *hist_PS;
+  Real *hist_n;
+  Real *ps_root;
+  Real *skewers_transmitted_flux;
+  int *n_PS_processed;
+
+  if (axis == 0) {
+    am_I_root                = Analysis.am_I_root_x;
+    n_skewers                = Analysis.n_skewers_local_x;
+    n_los                    = Analysis.nx_total;
+    n_fft                    = Analysis.n_fft_x;
+    n_hist_edges             = Analysis.n_hist_edges_x;
+    Lbox                     = Analysis.Lbox_x;
+    k_vals                   = Analysis.k_vals_x;
+    hist_k_edges             = Analysis.hist_k_edges_x;
+    hist_PS                  = Analysis.hist_PS_x;
+    hist_n                   = Analysis.hist_n_x;
+    ps_root                  = Analysis.ps_root_x;
+    skewers_transmitted_flux = Analysis.skewers_transmitted_flux_HI_x;
+    n_PS_processed           = &Analysis.n_PS_processed_x;
+  }
+
+  if (axis == 1) {
+    am_I_root                = Analysis.am_I_root_y;
+    n_skewers                = Analysis.n_skewers_local_y;
+    n_los                    = Analysis.ny_total;
+    n_fft                    = Analysis.n_fft_y;
+    n_hist_edges             = Analysis.n_hist_edges_y;
+    Lbox                     = Analysis.Lbox_y;
+    k_vals                   = Analysis.k_vals_y;
+    hist_k_edges             = Analysis.hist_k_edges_y;
+    hist_PS                  = Analysis.hist_PS_y;
+    hist_n                   = Analysis.hist_n_y;
+    ps_root                  = Analysis.ps_root_y;
+    skewers_transmitted_flux = Analysis.skewers_transmitted_flux_HI_y;
+    n_PS_processed           = &Analysis.n_PS_processed_y;
+  }
+
+  if (axis == 2) {
+    am_I_root                = Analysis.am_I_root_z;
+    n_skewers                = Analysis.n_skewers_local_z;
+    n_los                    = Analysis.nz_total;
+    n_fft                    = Analysis.n_fft_z;
+    n_hist_edges             = Analysis.n_hist_edges_z;
+    Lbox                     = Analysis.Lbox_z;
+    k_vals                   = Analysis.k_vals_z;
+    hist_k_edges             = Analysis.hist_k_edges_z;
+    hist_PS                  = Analysis.hist_PS_z;
+    hist_n                   = Analysis.hist_n_z;
+    ps_root                  = Analysis.ps_root_z;
+    skewers_transmitted_flux = Analysis.skewers_transmitted_flux_HI_z;
+    n_PS_processed           = &Analysis.n_PS_processed_z;
+  }
+
+  int const n_bins = n_hist_edges - 1;
+  for (int i = 0; i < n_bins; i++) {
+    ps_root[i] = 0;
+  }
+  if (!am_I_root || n_skewers == 0) {
+    return;
+  }
+
+  // The k values are the same for every skewer, so the bin of each k and the
+  // number of k values in each bin are found once
+  std::vector<int> bin_ids(n_fft, -1);
+  int hist_sum = 0;
+  for (int i = 0; i < n_bins; i++) {
+    hist_n[i] = 0;
+  }
+  for (int i = 0; i < n_fft; i++) {
+    if (k_vals[i] == 0) continue;
+    int const bin_id = Locate_Index(k_vals[i], hist_k_edges, n_hist_edges);
+    if (bin_id < 0 || bin_id >= n_bins) continue;
+    bin_ids[i] = bin_id;
+    hist_n[bin_id] += 1;
+    hist_sum += 1;
+  }
+  if (hist_sum != n_fft - 1) {
+    CHOLLA_ERROR("Histogram sum doesn't match n_pfft:  sum=%d    n_fft=%d", hist_sum, n_fft - 1);
+  }
+
+  size_t const n_cells = size_t(n_skewers) * n_los;
+  cuda_utilities::DeviceVector<Real> flux{n_cells};
+  cuda_utilities::DeviceVector<Real> delta_F{n_cells};
+  cuda_utilities::DeviceVector<Lya_Complex> fft_delta_F{size_t(n_skewers) * n_fft};
+  cuda_utilities::DeviceVector<int> device_bin_ids{size_t(n_fft)};
+  cuda_utilities::DeviceVector<Real> device_hist_PS{size_t(n_bins), true};
+  flux.cpyHostToDevice(skewers_transmitted_flux, n_cells);
+  device_bin_ids.cpyHostToDevice(bin_ids);
+
+  dim3 dim1dGrid((n_cells + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Compute_Delta_Flux_Kernel, dim1dGrid, dim1dBlock, 0, 0, flux.data(), int(n_cells),
+                     Analysis.Flux_mean_HI, delta_F.data());
+  GPU_Error_Check();
+
+  // One r2c transform per skewer, all the skewers in a single batch
+  cufftHandle plan;
+    #if PRECISION == 1
+  GPU_Error_Check(cufftPlanMany(&plan, 1, &n_los, NULL, 1, n_los, NULL, 1, n_fft, CUFFT_R2C, n_skewers));
+  GPU_Error_Check(cufftExecR2C(plan, delta_F.data(), fft_delta_F.data()));
+    #else
+  GPU_Error_Check(cufftPlanMany(&plan, 1, &n_los, NULL, 1, n_los, NULL, 1, n_fft, CUFFT_D2Z, n_skewers));
+  GPU_Error_Check(cufftExecD2Z(plan, delta_F.data(), fft_delta_F.data()));
+    #endif  // PRECISION
+  GPU_Error_Check(cufftDestroy(plan));
+
+  dim3 dim1dGrid_fft((size_t(n_skewers) * n_fft + TPB - 1) / TPB, 1, 1);
+  hipLaunchKernelGGL(Bin_Flux_Power_Spectrum_Kernel, dim1dGrid_fft, dim1dBlock, 0, 0, fft_delta_F.data(), n_skewers,
+                     n_fft, n_los, device_bin_ids.data(), device_hist_PS.data());
+  GPU_Error_Check();
+  device_hist_PS.cpyDeviceToHost(hist_PS, n_bins);
+
+  // Every skewer has the same number of k values in a bin, so the sum over the
+  // skewers of the bin means is the binned sum over hist_n
+  Real const current_a = Analysis.output_a;
+  Real const L_proper  = Lbox * current_a / Cosmo.cosmo_h;
+  Real const H         = Cosmo.Get_Hubble_Parameter(current_a);
+  for (int i = 0; i < n_bins; i++) {
+    if (hist_n[i] > 0) {
+      ps_root[i] = hist_PS[i] / hist_n[i] * (H * L_proper);
+    }
+  }
+  *n_PS_processed += n_skewers;
+}
+
+#endif  // ANALYSIS && LYA_STATISTICS && LYA_STATISTICS_GPU
@@ -46,6 +46,10 @@ void Grid3D::Compute_Phase_Diagram()
   int k, j, i, id_grid;
   int indx_dens, indx_temp, indx_phase;
 
+  #ifdef CHEMISTRY_GPU
+  // The temperature is computed from the fields on the device
+  Compute_Phase_Diagram_GPU();
+  #else
   // Clear Phase Dikagram
   for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++) Analysis.phase_diagram[indx_phase] = 0;
 
@@ -54,17 +58,15 @@ void Grid3D::Compute_Phase_Diagram()
       for (i = 0; i < nx_local; i++) {
         id_grid = (i + n_ghost) + (j + n_ghost) * nx_grid + (k + n_ghost) * nx_grid * ny_grid;
         dens    = C.density[id_grid] * Cosmo.rho_0_gas / Cosmo.rho_mean_baryon;  // Baryonic overdensity
-  // chprintf( "%f %f \n", dens, temp);
-  #ifdef COOLING_GRACKLE
+    // chprintf( "%f %f \n", dens, temp);
+    #ifdef COOLING_GRACKLE
         temp = Cool.temperature[id_grid];
-  #elif defined CHEMISTRY_GPU
-        temp = Chem.Fields.temperature_h[id_grid];
-  #else
+    #else
         chprintf(
             "ERROR: Temperature Field is only supported for Grackle Cooling or "
             "CHEMISTRY_GPU\n");
         exit(-1);
-  #endif
+    #endif
 
         if (dens < dens_min || dens > dens_max || temp < temp_min || temp > temp_max) {
           // printf("Outside Phase Diagram:  dens:%e   temp:%e \n", dens, temp
@@ -88,26 +90,34 @@ void Grid3D::Compute_Phase_Diagram()
       }
     }
   }
+  #endif  // CHEMISTRY_GPU
 
   // Real phase_sum_local = 0;
   // for (indx_phase=0; indx_phase<n_temp*n_dens; indx_phase++) phase_sum_local
   // += Analysis.phase_diagram[indx_phase]; printf(" Phase Diagram Sum Local:
   // %f\n", phase_sum_local );
+}
+
+// Add the local phase diagrams of all the processes and normalize the result.
+// Only uses the buffers of the module, so it can run on the analysis thread
+void AnalysisModule::Reduce_Phase_Diagram()
+{
+  int indx_phase;
 
   #ifdef MPI_CHOLLA
-  MPI_Reduce(Analysis.phase_diagram, Analysis.phase_diagram_global, n_temp * n_dens, MPI_FLOAT, MPI_SUM, 0, world);
+  MPI_Reduce(phase_diagram, phase_diagram_global, n_temp * n_dens, MPI_FLOAT, MPI_SUM, 0, world_analysis);
   if (procID == 0)
     for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++)
-      Analysis.phase_diagram[indx_phase] = Analysis.phase_diagram_global[indx_phase];
+      phase_diagram[indx_phase] = phase_diagram_global[indx_phase];
   #endif
 
   // Compute the sum for normalization
   Real phase_sum = 0;
-  for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++) phase_sum += Analysis.phase_diagram[indx_phase];
+  for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++) phase_sum += phase_diagram[indx_phase];
   chprintf(" Phase Diagram Sum Global: %f\n", phase_sum);
 
   // Normalize the Phase Diagram
-  for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++) Analysis.phase_diagram[indx_phase] /= phase_sum;
+  for (indx_phase = 0; indx_phase < n_temp * n_dens; indx_phase++) phase_diagram[indx_phase] /= phase_sum;
 }
 
 void AnalysisModule::Initialize_Phase_Diagram(struct Parameters *P)
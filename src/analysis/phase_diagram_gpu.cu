@@ -0,0 +1,61 @@
+#if defined(ANALYSIS) && defined(PHASE_DIAGRAM) && defined(CHEMISTRY_GPU)
+
+  #include "../analysis/analysis.h"
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+  #include "../io/io.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/histogram_utilities.h"
+
+/*! \brief The baryonic overdensity and the derived temperature of each real
+ * cell */
+struct Phase_Diagram_Sampler {
+  Real const *dev_density;
+  Real const *dev_temperature;
+  int nx, ny, n_ghost;
+  int nx_real, ny_real;
+  Real dens_factor;
+
+  __device__ bool operator()(size_t cell_id, Real &dens, Real &temp, Real &weight) const
+  {
+    int const i  = cell_id % nx_real + n_ghost;
+    int const j  = (cell_id / nx_real) % ny_real + n_ghost;
+    int const k  = cell_id / (size_t(nx_real) * ny_real) + n_ghost;
+    int const id = cuda_utilities::compute1DIndex(i, j, k, nx, ny);
+
+    dens = dev_density[id] * dens_factor;
+    temp = dev_temperature[id];
+    return true;
+  }
+};
+
+void Grid3D::Compute_Phase_Diagram_GPU()
+{
+  int const n_dens = Analysis.n_dens;
+  int const n_temp = Analysis.n_temp;
+
+  // The temperature of Compute_Gas_Temperature, shared with the outputs of the
+  // step
+  Phase_Diagram_Sampler sampler;
+  sampler.dev_density     = C.d_density;
+  sampler.dev_temperature = Derived.Get(*this, "temperature");
+  sampler.nx              = H.nx;
+  sampler.ny              = H.ny;
+  sampler.n_ghost         = H.n_ghost;
+  sampler.nx_real         = H.nx_real;
+  sampler.ny_real         = H.ny_real;
+  sampler.dens_factor     = Cosmo.rho_0_gas / Cosmo.rho_mean_baryon;  // Baryonic overdensity
+
+  // The temperature is the fastest index of the diagram
+  histogram_utilities::BinAxis const dens_axis = {n_dens, Analysis.dens_min, Analysis.dens_max, true};
+  histogram_utilities::BinAxis const temp_axis = {n_temp, Analysis.temp_min, Analysis.temp_max, true};
+
+  cuda_utilities::DeviceVector<float> dev_phase_diagram{size_t(n_dens) * n_temp, true};
+  histogram_utilities::Histogram2D(sampler, size_t(H.nx_real) * H.ny_real * H.nz_real, dens_axis, temp_axis,
+                                   dev_phase_diagram.data());
+  dev_phase_diagram.cpyDeviceToHost(Analysis.phase_diagram, size_t(n_dens) * n_temp);
+}
+
+#endif  // ANALYSIS && PHASE_DIAGRAM && CHEMISTRY_GPU
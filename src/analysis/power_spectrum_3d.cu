@@ -0,0 +1,133 @@
+/*! \file power_spectrum_3d.cu
+ *  \brief Definitions of the in-situ 3D power spectrum of a density field. */
+
+#ifdef POWER_SPECTRUM
+
+  #include <mpi.h>
+
+  #include <algorithm>
+  #include <cmath>
+
+  #include "../analysis/power_spectrum_3d.h"
+  #include "../global/global_cuda.h"
+  #include "../gravity/paris/HenryPeriodic.hpp"
+  #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+
+PowerSpectrum3D::PowerSpectrum3D(Real const lx, Real const ly, Real const lz, Real const xMin, Real const yMin,
+                                 Real const zMin, int const nx, int const ny, int const nz, int const nxReal,
+                                 int const nyReal, int const nzReal, Real const dx, Real const dy, Real const dz)
+    : henry_(nullptr),
+      n_local_{nxReal, nyReal, nzReal},
+      n_global_{nx, ny, nz},
+      k_min_{2 * M_PI / lx, 2 * M_PI / ly, 2 * M_PI / lz},
+      dk_(2 * M_PI / std::max({lx, ly, lz})),
+      volume_(double(lx) * ly * lz),
+      n_bins_(0),
+      bins_dev_(nullptr)
+{
+  // The decomposition of the Paris solvers, z first
+  double const myLo[3] = {zMin, yMin, xMin};
+  double lo[3];
+  MPI_Allreduce(myLo, lo, 3, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  double const hi[3] = {lo[0] + lz - dz, lo[1] + ly - dy, lo[2] + lx - dx};
+  int const n[3]     = {nz, ny, nx};
+  int const m[3]     = {nz / nzReal, ny / nyReal, nx / nxReal};
+  int const id[3]    = {int(round((zMin - lo[0]) / (nzReal * dz))), int(round((yMin - lo[1]) / (nyReal * dy))),
+                        int(round((xMin - lo[2]) / (nxReal * dx)))};
+  CHOLLA_ASSERT(n[0] == m[0] * nzReal && n[1] == m[1] * nyReal && n[2] == m[2] * nxReal,
+                "POWER_SPECTRUM needs the same number of cells on every process");
+  henry_ = new HenryPeriodic<double>(n, lo, hi, m, id, MPI_COMM_WORLD);
+
+  // The shell b is centered on (b + 1) dk, up to the smallest Nyquist
+  // frequency
+  double const k_nyquist = std::min({M_PI * nx / lx, M_PI * ny / ly, M_PI * nz / lz});
+  n_bins_                = int(k_nyquist / dk_);
+  CHOLLA_ASSERT(n_bins_ > 0, "POWER_SPECTRUM needs at least 2 cells along every direction");
+
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::analysis);
+  cuda_utilities::Pool_Malloc(&bins_dev_, (3 * n_bins_ + 1) * sizeof(double));
+  chprintf(" Power spectrum: %d shells of width %g\n", n_bins_, dk_);
+}
+
+PowerSpectrum3D::~PowerSpectrum3D()
+{
+  delete henry_;
+  cuda_utilities::Pool_Free(bins_dev_);
+}
+
+void PowerSpectrum3D::Compute(Real const *const density, int const n_ghost, std::vector<double> &k,
+                              std::vector<double> &power, std::vector<double> &n_modes)
+{
+  // Work arrays from the scratch pool shared with the Paris solvers
+  int const ni       = n_local_[0];
+  int const nj       = n_local_[1];
+  int const nk       = n_local_[2];
+  size_t const bytes = std::max(henry_->bytes(), sizeof(double) * size_t(ni) * nj * nk);
+  double *const da   = FFTCache::device(0, bytes);
+  double *const db   = FFTCache::device(1, bytes);
+
+  // Pack the real cells
+  int const ngi = ni + n_ghost + n_ghost;
+  int const ngj = nj + n_ghost + n_ghost;
+  gpuFor(
+      nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
+        da[i + ni * (j + nj * k)] = density[i + n_ghost + ngi * (j + n_ghost + ngj * (k + n_ghost))];
+      });
+
+  // Bin the modes of the transform, where i is the z index, j the y index and
+  // k the x index of the half of the modes that the R2C transform keeps. The
+  // other half are the conjugates of the modes with k > 0, except the Nyquist
+  // ones, so those count twice
+  double *const bins = bins_dev_;
+  int const n_bins   = n_bins_;
+  int const nx       = n_global_[0];
+  int const ny       = n_global_[1];
+  int const nz       = n_global_[2];
+  double const k_x   = k_min_[0];
+  double const k_y   = k_min_[1];
+  double const k_z   = k_min_[2];
+  double const dk    = dk_;
+  GPU_Error_Check(cudaMemset(bins, 0, (3 * n_bins + 1) * sizeof(double)));
+  henry_->spectrum(
+      bytes, da, db, GPU_LAMBDA(const int i, const int j, const int k, const cufftDoubleComplex value) {
+        double const p = value.x * value.x + value.y * value.y;
+        if (i == 0 && j == 0 && k == 0) {
+          bins[3 * n_bins] = p;
+          return;
+        }
+        double const kx    = k_x * k;
+        double const ky    = k_y * ((j > ny / 2) ? j - ny : j);
+        double const kz    = k_z * ((i > nz / 2) ? i - nz : i);
+        double const k_mag = sqrt(kx * kx + ky * ky + kz * kz);
+        int const bin      = int(k_mag / dk + 0.5) - 1;
+        if (bin < 0 || bin >= n_bins) {
+          return;
+        }
+        double const weight = (k == 0 || k + k == nx) ? 1 : 2;
+        atomicAdd(bins + bin, weight * k_mag);
+        atomicAdd(bins + n_bins + bin, weight * p);
+        atomicAdd(bins + 2 * n_bins + bin, weight);
+      });
+
+  std::vector<double> sums(3 * n_bins + 1);
+  GPU_Error_Check(cudaMemcpy(sums.data(), bins, sums.size() * sizeof(double), cudaMemcpyDeviceToHost));
+  MPI_Allreduce(MPI_IN_PLACE, sums.data(), sums.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  // rho(0) is the sum of the density, so V |rho(k)|^2 / |rho(0)|^2 is the
+  // power of the density contrast
+  double const p_0 = sums[3 * n_bins];
+  CHOLLA_ASSERT(p_0 > 0, "The power spectrum needs a density field with a nonzero mean");
+  k.assign(n_bins, 0);
+  power.assign(n_bins, 0);
+  n_modes.assign(n_bins, 0);
+  for (int b = 0; b < n_bins; b++) {
+    n_modes[b] = sums[2 * n_bins + b];
+    k[b]       = (n_modes[b] > 0) ? sums[b] / n_modes[b] : (b + 1) * dk;
+    power[b]   = (n_modes[b] > 0) ? volume_ * sums[n_bins + b] / (n_modes[b] * p_0) : 0;
+  }
+}
+
+#endif  // POWER_SPECTRUM
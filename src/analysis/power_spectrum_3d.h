@@ -0,0 +1,71 @@
+/*! \file power_spectrum_3d.h
+ *  \brief Declarations of the in-situ 3D power spectrum of a density field.
+ *  The density is transformed with the distributed FFTs of the Paris Poisson
+ *  solver, HenryPeriodic, with the plans and the work arrays it shares through
+ *  FFTCache, and |delta(k)|^2 is binned into shells of |k| on the device. */
+
+#pragma once
+
+#ifdef POWER_SPECTRUM
+
+  #if !defined(PARIS) || !defined(MPI_CHOLLA)
+    #error "POWER_SPECTRUM needs the Paris FFTs, build it with PARIS and MPI_CHOLLA"
+  #endif
+
+  #include <vector>
+
+  #include "../global/global.h"
+
+template <typename T>
+class HenryPeriodic;
+
+/*! \class PowerSpectrum3D
+ *  \brief The power spectrum of the density contrast of the global periodic
+ *  grid. The shells are centered on the multiples of the fundamental mode of
+ *  the longest side of the box, up to the smallest Nyquist frequency. */
+class PowerSpectrum3D
+{
+ public:
+  /*! \fn PowerSpectrum3D(Real lx, Real ly, Real lz, Real xMin, Real yMin, Real zMin, int nx, int ny, int nz, int
+   * nxReal, int nyReal, int nzReal, Real dx, Real dy, Real dz)
+   *  \brief Set up the FFTs of the global grid of nx x ny x nz cells and size lx
+   * x ly x lz, of which this process has the nxReal x nyReal x nzReal cells
+   * that start at (xMin, yMin, zMin). Every process must call it, like the
+   * Paris solvers */
+  PowerSpectrum3D(Real lx, Real ly, Real lz, Real xMin, Real yMin, Real zMin, int nx, int ny, int nz, int nxReal,
+                  int nyReal, int nzReal, Real dx, Real dy, Real dz);
+  ~PowerSpectrum3D();
+  PowerSpectrum3D(PowerSpectrum3D const &)            = delete;
+  PowerSpectrum3D &operator=(PowerSpectrum3D const &) = delete;
+
+  /*! \fn int N_Bins() const
+   *  \brief The number of shells */
+  int N_Bins() const { return n_bins_; }
+
+  /*! \fn void Compute(Real const *density, int n_ghost, std::vector<double> &k, std::vector<double> &power,
+   * std::vector<double> &n_modes)
+   *  \brief Compute the power spectrum of a device density field with n_ghost
+   * ghost cells on every side. Every process gets the mean wavenumber, the
+   * power and the number of modes of every shell. The power is in the units of
+   * the volume, V |rho(k)|^2 / |rho(0)|^2, without the shot noise subtracted or
+   * the CIC window deconvolved. Every process must call it */
+  void Compute(Real const *density, int n_ghost, std::vector<double> &k, std::vector<double> &power,
+               std::vector<double> &n_modes);
+
+ private:
+  HenryPeriodic<double> *henry_;
+  // The local real cells in each direction, x first
+  int n_local_[3];
+  // The global cells and the fundamental frequencies in each direction, x first
+  int n_global_[3];
+  double k_min_[3];
+  // The width of the shells and the volume of the box
+  double dk_;
+  double volume_;
+  int n_bins_;
+  // The sums of the wavenumbers, the powers and the numbers of modes of the
+  // shells, then |rho(0)|^2, on the device
+  double *bins_dev_;
+};
+
+#endif  // POWER_SPECTRUM
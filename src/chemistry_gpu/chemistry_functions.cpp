@@ -1,9 +1,13 @@
 #ifdef CHEMISTRY_GPU
 
+  #include <algorithm>
+  #include <cmath>
+
   #include "../grid/grid3D.h"
   #include "../io/io.h"
   #include "../utils/hydro_utilities.h"
   #include "../utils/mhd_utilities.h"
+  #include "../utils/profiling_ranges.h"
   #include "chemistry_gpu.h"
   #include "rates.cuh"
 
@@ -59,7 +63,7 @@ void Grid3D::Initialize_Chemistry(struct Parameters *P)
   Chem.H.density_units    = Chem.H.density_units / Chem.H.a_value / Chem.H.a_value / Chem.H.a_value;
   Chem.H.length_units     = Chem.H.length_units / Cosmo.cosmo_h * Chem.H.a_value;
   Chem.H.time_units       = Chem.H.time_units / Cosmo.cosmo_h;
-  Chem.H.dens_number_conv = Chem.H.density_number_conv * pow(Chem.H.a_value, 3);
+  Chem.H.dens_number_conv = Chem.H.dens_number_conv * pow(Chem.H.a_value, 3);
   #endif  // COSMOLOGY
   Chem.H.velocity_units = Chem.H.length_units / Chem.H.time_units;
 
@@ -139,6 +143,10 @@ void Chem_GPU::Initialize(struct Parameters *P)
   Initialize_Reaction_Rates();
 
   Initialize_UVB_Ionization_and_Heating_Rates(P);
+
+  #ifdef GRACKLE_METALS
+  Initialize_Metal_Cooling_Rates(P);
+  #endif
 }
 
 void Chem_GPU::Initialize_Cooling_Rates()
@@ -223,17 +231,102 @@ void Chem_GPU::Copy_UVB_Rates_to_GPU()
   Copy_Float_Array_to_Device(n_uvb_rates_samples, Ion_rates_HeII_h, Ion_rates_HeII_d);
 }
 
+  #ifdef GRACKLE_METALS
+void Chem_GPU::Initialize_Metal_Cooling_Rates(struct Parameters *P)
+{
+  chprintf(" Initializing Metal Cooling Rates... \n");
+  Load_Metal_Cooling_Rates(P);
+
+  metal_rates_h.resize(2 * metal_n_dens * metal_n_temp);
+  Allocate_Array_GPU_Real(&metal_rates_d, metal_rates_h.size());
+  H.metal_n_dens = metal_n_dens;
+  H.metal_n_temp = metal_n_temp;
+  H.metal_cool_d = metal_rates_d;
+  H.metal_heat_d = metal_rates_d + metal_n_dens * metal_n_temp;
+
+  // Force the copy of the first update
+  metal_z_loaded = -1;
+}
+
+void Chem_GPU::Update_Metal_Cooling_Rates(Real current_z)
+{
+  if (current_z == metal_z_loaded) {
+    return;
+  }
+  metal_z_loaded = current_z;
+
+  // Linear interpolation of the log of the rates in redshift, clamped to the
+  // redshift range of the table like in Grackle
+  int indx_l   = 0;
+  Real delta_z = 0;
+  if (metal_n_z > 1) {
+    int const indx_r = int(std::upper_bound(metal_z_h.begin(), metal_z_h.end(), current_z) - metal_z_h.begin());
+    indx_l           = std::min(std::max(indx_r - 1, 0), metal_n_z - 2);
+    delta_z          = (current_z - metal_z_h[indx_l]) / (metal_z_h[indx_l + 1] - metal_z_h[indx_l]);
+    delta_z          = std::min(std::max(delta_z, Real(0)), Real(1));
+  }
+
+  // The rates are converted to cooling units, which are shifts of the log
+  Real const log_units = log10(H.cooling_units);
+  Real *const cool     = metal_rates_h.data();
+  Real *const heat     = cool + metal_n_dens * metal_n_temp;
+  for (int i = 0; i < metal_n_dens; i++) {
+    for (int j = 0; j < metal_n_temp; j++) {
+      int const id_l = (i * metal_n_z + indx_l) * metal_n_temp + j;
+      int const id_r = metal_n_z > 1 ? id_l + metal_n_temp : id_l;
+      int const id   = i * metal_n_temp + j;
+
+      cool[id] = metal_cool_h[id_l] + delta_z * (metal_cool_h[id_r] - metal_cool_h[id_l]) - log_units;
+      heat[id] = metal_heat_h[id_l] + delta_z * (metal_heat_h[id_r] - metal_heat_h[id_l]) - log_units;
+    }
+  }
+  Copy_Real_Array_to_Device(metal_rates_h.size(), metal_rates_h.data(), metal_rates_d);
+}
+  #endif  // GRACKLE_METALS
+
 void Grid3D::Update_Chemistry()
 {
+  profiling::ScopedRange const range("Update_Chemistry");
+
   #ifdef COSMOLOGY
   Chem.H.current_z = Cosmo.current_z;
   #else
   Chem.H.current_z = 0;
   #endif
 
+  Chem.Update_UVB_Rates(Chem.H.current_z);
+  #ifdef GRACKLE_METALS
+  Chem.Update_Metal_Cooling_Rates(Chem.H.current_z);
+  #endif
   Do_Chemistry_Update(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dt, Chem.H);
 }
 
+void Chem_GPU::Update_UVB_Rates(Real current_z)
+{
+  int const n = n_uvb_rates_samples;
+  if (current_z > rates_z_h[n - 1]) {
+    H.photo_h_HI   = 0;
+    H.photo_h_HeI  = 0;
+    H.photo_h_HeII = 0;
+    H.photo_i_HI   = 0;
+    H.photo_i_HeI  = 0;
+    H.photo_i_HeII = 0;
+    return;
+  }
+  // Find closest value of z in rates_z such that z<=current_z
+  int const indx_r   = int(std::upper_bound(rates_z_h, rates_z_h + n, current_z) - rates_z_h);
+  int const indx_l   = std::min(std::max(indx_r - 1, 0), n - 2);
+  Real const delta_x = (current_z - rates_z_h[indx_l]) / (rates_z_h[indx_l + 1] - rates_z_h[indx_l]);
+  auto interpolate   = [&](float *rates) { return delta_x * (rates[indx_l + 1] - rates[indx_l]) + rates[indx_l]; };
+
+  H.photo_i_HI   = interpolate(Ion_rates_HI_h);
+  H.photo_i_HeI  = interpolate(Ion_rates_HeI_h);
+  H.photo_i_HeII = interpolate(Ion_rates_HeII_h);
+  H.photo_h_HI   = interpolate(Heat_rates_HI_h);
+  H.photo_h_HeI  = interpolate(Heat_rates_HeI_h);
+  H.photo_h_HeII = interpolate(Heat_rates_HeII_h);
+}
+
 void Grid3D::Compute_Gas_Temperature(Real *temperature, bool convert_cosmo_units)
 {
   int k, j, i, id;
@@ -312,6 +405,10 @@ void Chem_GPU::Reset()
   Free_Array_GPU_float(Ion_rates_HeI_d);
   Free_Array_GPU_float(Ion_rates_HeII_d);
 
+  #ifdef GRACKLE_METALS
+  Free_Array_GPU_Real(metal_rates_d);
+  #endif
+
   free(Fields.temperature_h);
 }
 
@@ -8,6 +8,14 @@
   #include "rates.cuh"
   #include "rates_Katz95.cuh"
 
+  #ifdef GRACKLE_METALS
+    #include "../cooling/texture_utilities.h"
+
+    // The solar metal mass fraction the Cloudy metal rates are normalized to,
+    // the same as in Grackle
+    #define CHEM_Z_SOLAR 0.01295
+  #endif
+
   #define eV_to_K 1.160451812e4
   #define K_to_eV 8.617333263e-5
   #define n_min   1e-20
@@ -15,6 +23,23 @@
 
   #define TPB_CHEM 256
 
+  // The reaction rate tables are staged in shared memory when they fit in
+  // CHEM_SHARED_RATES_MAX bytes
+  #define N_REACTION_RATES      8
+  #define CHEM_SHARED_RATES_MAX 49152
+
+  #ifdef CHEMISTRY_GPU_QUEUE
+    #include <algorithm>
+
+    #include "../utils/DeviceVector.h"
+
+    // The number of substeps of each cell in a round of the work queue
+    #define CHEM_ROUND_STEPS 16
+    // The queue holds up to 1/CHEM_QUEUE_FRACTION of the cells, the cells that
+    // don't fit finish their integration in the round that started it
+    #define CHEM_QUEUE_FRACTION 8
+  #endif  // CHEMISTRY_GPU_QUEUE
+
 void Chem_GPU::Allocate_Array_GPU_float(float **array_dev, int size)
 {
   GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(float)));
@@ -57,6 +82,10 @@ class Thermal_State
   Real d_HeII;
   Real d_HeIII;
   Real d_e;
+  #ifdef GRACKLE_METALS
+  // Metal mass fraction
+  Real metallicity = 0;
+  #endif
 
   // Constructor
   __host__ __device__ Thermal_State(Real U_0 = 1, Real d_0 = 1, Real d_HI_0 = 1, Real d_HII_0 = 0, Real d_HeI_0 = 1,
@@ -118,6 +147,17 @@ __device__ Real interpolate_rate(Real *rate_table, int indx, Real delta)
   return rate_val;
 }
 
+  #ifdef GRACKLE_METALS
+/*! \brief Interpolate one of the Cloudy metal rate tables of the header at
+ * log10(n_H) and log10(T), clamped to the edges of the table */
+__device__ Real Interpolate_Metal_Rate(const Real *log_rates, Chemistry_Header &Chem_H, Real log_n_H, Real log_T)
+{
+  Real const x = (log_T - Chem_H.metal_log_temp_start) / Chem_H.metal_d_log_temp;
+  Real const y = (log_n_H - Chem_H.metal_log_dens_start) / Chem_H.metal_d_log_dens;
+  return pow(10.0, Bilinear_Table(log_rates, Chem_H.metal_n_temp, Chem_H.metal_n_dens, x, y));
+}
+  #endif  // GRACKLE_METALS
+
 __device__ Real Get_Cooling_Rates(Thermal_State &TS, Chemistry_Header &Chem_H, Real dens_number_conv, Real current_z,
                                   Real temp_prev, float photo_h_HI, float photo_h_HeI, float photo_h_HeII, bool print)
 {
@@ -165,6 +205,22 @@ __device__ Real Get_Cooling_Rates(Thermal_State &TS, Chemistry_Header &Chem_H, R
   cool_compton = Chem_H.cool_compton * pow(1.0 + current_z, 4) * (temp - temp_cmb) * TS.d_e / dens_number_conv;
   U_dot -= cool_compton;
 
+  #ifdef GRACKLE_METALS
+  // Cloudy metal cooling and heating scaled by the metallicity, like Grackle
+  // does with metal_cooling. The cooling at the CMB temperature is removed so
+  // the metals don't cool the gas below it
+  Real cool_metal, heat_metal, d_H, log_n_H, metal_scale;
+  d_H         = TS.d_HI + TS.d_HII;
+  log_n_H     = log10(d_H * dens_number_conv);
+  metal_scale = TS.metallicity / CHEM_Z_SOLAR * d_H * d_H;
+  cool_metal  = Interpolate_Metal_Rate(Chem_H.metal_cool_d, Chem_H, log_n_H, log10(temp));
+  cool_metal -= Interpolate_Metal_Rate(Chem_H.metal_cool_d, Chem_H, log_n_H, log10(temp_cmb));
+  heat_metal = Interpolate_Metal_Rate(Chem_H.metal_heat_d, Chem_H, log_n_H, log10(temp));
+  cool_metal *= metal_scale;
+  heat_metal *= metal_scale;
+  U_dot -= cool_metal - heat_metal;
+  #endif  // GRACKLE_METALS
+
   // Phothoheating
   Real photo_heat;
   photo_heat = (photo_h_HI * TS.d_HI + 0.25 * (photo_h_HeI * TS.d_HeI + photo_h_HeII * TS.d_HeII)) / dens_number_conv;
@@ -196,6 +252,9 @@ __device__ Real Get_Cooling_Rates(Thermal_State &TS, Chemistry_Header &Chem_H, R
   if (print) printf("Cooling piHeII: %e rate: %e \n", photo_h_HeII, photo_h_HeII * TS.d_HeII / dens_number_conv * 0.25);
   if (print) printf("Cooling DOM: %e  \n", dens_number_conv);
   if (print) printf("Cooling compton: %e  \n", cool_compton);
+  #ifdef GRACKLE_METALS
+  if (print) printf("Cooling metal: %e  heat metal: %e  \n", cool_metal, heat_metal);
+  #endif
   if (print) printf("Cooling U_dot: %e  \n", U_dot);
 
   return U_dot;
@@ -232,61 +291,6 @@ __device__ void Get_Reaction_Rates(Thermal_State &TS, Chemistry_Header &Chem_H,
   if (print) printf("k_recomb_HeIII: %e \n", k_recomb_HeIII);
 }
 
-__device__ int Binary_Search(int N, Real val, float *data, int indx_l, int indx_r)
-{
-  int n, indx;
-  n    = indx_r - indx_l;
-  indx = indx_l + n / 2;
-  if (val >= data[N - 1]) return indx_r;
-  if (val <= data[0]) return indx_l;
-  if (indx_r == indx_l + 1) return indx_l;
-  if (data[indx] <= val)
-    indx_l = indx;
-  else
-    indx_r = indx;
-  return Binary_Search(N, val, data, indx_l, indx_r);
-}
-
-__device__ Real linear_interpolation(Real delta_x, int indx_l, int indx_r, float *array)
-{
-  float v_l, v_r;
-  Real v;
-  v_l = array[indx_l];
-  v_r = array[indx_r];
-  v   = delta_x * (v_r - v_l) + v_l;
-  return v;
-}
-
-__device__ void Get_Current_UVB_Rates(Real current_z, Chemistry_Header &Chem_H, float &photo_i_HI, float &photo_i_HeI,
-                                      float &photo_i_HeII, float &photo_h_HI, float &photo_h_HeI, float &photo_h_HeII,
-                                      bool print)
-{
-  if (current_z > Chem_H.uvb_rates_redshift_d[Chem_H.n_uvb_rates_samples - 1]) {
-    photo_h_HI   = 0;
-    photo_h_HeI  = 0;
-    photo_h_HeII = 0;
-    photo_i_HI   = 0;
-    photo_i_HeI  = 0;
-    photo_i_HeII = 0;
-    return;
-  }
-  // Find closest value of z in rates_z such that z<=current_z
-  int indx_l;
-  Real z_l, z_r, delta_x;
-  indx_l  = Binary_Search(Chem_H.n_uvb_rates_samples, current_z, Chem_H.uvb_rates_redshift_d, 0,
-                          Chem_H.n_uvb_rates_samples - 1);
-  z_l     = Chem_H.uvb_rates_redshift_d[indx_l];
-  z_r     = Chem_H.uvb_rates_redshift_d[indx_l + 1];
-  delta_x = (current_z - z_l) / (z_r - z_l);
-
-  photo_i_HI   = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_ion_HI_rate_d);
-  photo_i_HeI  = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_ion_HeI_rate_d);
-  photo_i_HeII = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_ion_HeII_rate_d);
-  photo_h_HI   = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_heat_HI_rate_d);
-  photo_h_HeI  = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_heat_HeI_rate_d);
-  photo_h_HeII = linear_interpolation(delta_x, indx_l, indx_l + 1, Chem_H.photo_heat_HeII_rate_d);
-}
-
 __device__ Real Get_Chemistry_dt(Thermal_State &TS, Chemistry_Header &Chem_H, Real &HI_dot, Real &e_dot, Real U_dot,
                                  Real k_coll_i_HI, Real k_coll_i_HeI, Real k_coll_i_HeII, Real k_coll_i_HI_HI,
                                  Real k_coll_i_HI_HeI, Real k_recomb_HII, Real k_recomb_HeII, Real k_recomb_HeIII,
@@ -332,8 +336,14 @@ __device__ Real Get_Chemistry_dt(Thermal_State &TS, Chemistry_Header &Chem_H, Re
   #endif
 
   energy = fmax(TS.U * TS.d, tiny);
-  dt     = fmin(fabs(0.1 * TS.d_HI / HI_dot), fabs(0.1 * TS.d_e / e_dot));
-  dt     = fmin(fabs(0.1 * energy / U_dot), dt);
+  #ifdef CHEMISTRY_IMPLICIT
+  // The species are integrated implicitly, only the explicit update of the
+  // energy limits the substeps
+  dt = fabs(0.1 * energy / U_dot);
+  #else
+  dt = fmin(fabs(0.1 * TS.d_HI / HI_dot), fabs(0.1 * TS.d_e / e_dot));
+  dt = fmin(fabs(0.1 * energy / U_dot), dt);
+  #endif  // CHEMISTRY_IMPLICIT
   dt     = fmin(0.5 * dt_hydro, dt);
   dt     = fmin(dt_hydro - t_chem, dt);
 
@@ -426,27 +436,385 @@ __device__ void Update_Step(Thermal_State &TS, Chemistry_Header &Chem_H, Real dt
   if (print) printf("Updated U: %e \n", TS.U);
 }
 
-__global__ void Update_Chemistry_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields,
-                                        Real dt_hydro, Chemistry_Header Chem_H)
+  #ifdef CHEMISTRY_IMPLICIT
+/*! \brief Solve the n by n system A x = b in place with Gaussian elimination
+ * and partial pivoting, the solution is returned in b. Returns false if A is
+ * singular */
+template <int n>
+__device__ bool Solve_Dense_System(Real (&A)[n][n], Real (&b)[n])
+{
+  for (int k = 0; k < n; k++) {
+    int pivot = k;
+    for (int i = k + 1; i < n; i++) {
+      if (fabs(A[i][k]) > fabs(A[pivot][k])) pivot = i;
+    }
+    if (A[pivot][k] == 0) return false;
+    if (pivot != k) {
+      for (int j = 0; j < n; j++) {
+        Real const temp = A[k][j];
+        A[k][j]         = A[pivot][j];
+        A[pivot][j]     = temp;
+      }
+      Real const temp = b[k];
+      b[k]            = b[pivot];
+      b[pivot]        = temp;
+    }
+    for (int i = k + 1; i < n; i++) {
+      Real const factor = A[i][k] / A[k][k];
+      for (int j = k; j < n; j++) A[i][j] -= factor * A[k][j];
+      b[i] -= factor * b[k];
+    }
+  }
+  for (int k = n - 1; k >= 0; k--) {
+    for (int j = k + 1; j < n; j++) b[k] -= A[k][j] * b[j];
+    b[k] /= A[k][k];
+  }
+  return true;
+}
+
+/*! \brief Backward Euler step of the species over dt, solved with Newton
+ * iterations on the HI, HII, HeI, HeII and HeIII densities. The electron
+ * density follows from charge conservation and the rates are the ones at the
+ * start of the step, like in Update_Step. If Newton doesn't converge dt is
+ * halved until it does, so dt returns the step that was taken. The energy is
+ * updated explicitly like in Update_Step */
+__device__ void Update_Step_Implicit(Thermal_State &TS, Chemistry_Header &Chem_H, Real &dt, Real U_dot,
+                                     Real k_coll_i_HI, Real k_coll_i_HeI, Real k_coll_i_HeII, Real k_coll_i_HI_HI,
+                                     Real k_coll_i_HI_HeI, Real k_recomb_HII, Real k_recomb_HeII, Real k_recomb_HeIII,
+                                     float photo_i_HI, float photo_i_HeI, float photo_i_HeII, Real &HI_dot_prev,
+                                     Real &e_dot_prev, Real &temp_prev, bool print)
 {
-  int id, xid, yid, zid, n_cells, n_iter;
-  Real d, d_inv, vx, vy, vz;
-  Real GE, E_kin, dt_chem, t_chem;
-  Real current_a, a3, a2;
+  int const max_newton  = 20;
+  int const max_halving = 30;
+  Real const y_0[5]     = {TS.d_HI, TS.d_HII, TS.d_HeI, TS.d_HeII, TS.d_HeIII};
+  // Charge conservation: d_e = d_HII + d_HeII / 4 + d_HeIII / 2
+  Real const de_dy[5] = {0, 1, 0, 0.25, 0.5};
+  Real y[5];
+  bool converged = false;
+
+  // A step that fails after max_halving halvings is kept as it is
+  for (int n_halving = 0; !converged && n_halving <= max_halving; n_halving++) {
+    for (int i = 0; i < 5; i++) y[i] = y_0[i];
+
+    for (int iter = 0; iter < max_newton && !converged; iter++) {
+      Real const HI = y[0], HII = y[1], HeI = y[2], HeII = y[3], HeIII = y[4];
+      Real const e = HII + 0.25 * HeII + 0.5 * HeIII;
+
+      // Rates of change of the species, the same network as Update_Step
+      Real f[5];
+      f[0] = k_recomb_HII * HII * e - k_coll_i_HI * HI * e - k_coll_i_HI_HI * HI * HI -
+             k_coll_i_HI_HeI * HI * HeI / 4.0 - photo_i_HI * HI;
+      f[1] = -f[0];
+      f[2] = k_recomb_HeII * HeII * e - (k_coll_i_HeI * e + photo_i_HeI) * HeI;
+      f[3] = k_coll_i_HeI * HeI * e + k_recomb_HeIII * HeIII * e + photo_i_HeI * HeI -
+             (k_recomb_HeII * e + k_coll_i_HeII * e + photo_i_HeII) * HeII;
+      f[4] = (k_coll_i_HeII * e + photo_i_HeII) * HeII - k_recomb_HeIII * e * HeIII;
+
+      // Their derivatives, with the electron density held fixed
+      Real J[5][5] = {};
+      J[0][0]      = -k_coll_i_HI * e - 2 * k_coll_i_HI_HI * HI - k_coll_i_HI_HeI * HeI / 4.0 - photo_i_HI;
+      J[0][1]      = k_recomb_HII * e;
+      J[0][2]      = -k_coll_i_HI_HeI * HI / 4.0;
+      J[2][2]      = -(k_coll_i_HeI * e + photo_i_HeI);
+      J[2][3]      = k_recomb_HeII * e;
+      J[3][2]      = k_coll_i_HeI * e + photo_i_HeI;
+      J[3][3]      = -(k_recomb_HeII * e + k_coll_i_HeII * e + photo_i_HeII);
+      J[3][4]      = k_recomb_HeIII * e;
+      J[4][3]      = k_coll_i_HeII * e + photo_i_HeII;
+      J[4][4]      = -k_recomb_HeIII * e;
+      // and their derivatives with respect to the electron density
+      Real df_de[5];
+      df_de[0] = k_recomb_HII * HII - k_coll_i_HI * HI;
+      df_de[1] = -df_de[0];
+      df_de[2] = k_recomb_HeII * HeII - k_coll_i_HeI * HeI;
+      df_de[3] = k_coll_i_HeI * HeI + k_recomb_HeIII * HeIII - (k_recomb_HeII + k_coll_i_HeII) * HeII;
+      df_de[4] = k_coll_i_HeII * HeII - k_recomb_HeIII * HeIII;
+      for (int j = 0; j < 5; j++) J[1][j] = -J[0][j];
+
+      // Newton update of y - y_0 - dt f(y) = 0
+      Real A[5][5], b[5];
+      for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) A[i][j] = (i == j) - dt * (J[i][j] + df_de[i] * de_dy[j]);
+        b[i] = -(y[i] - y_0[i] - dt * f[i]);
+      }
+      if (!Solve_Dense_System(A, b)) break;
+
+      Real max_change = 0;
+      for (int i = 0; i < 5; i++) {
+        Real const y_new = fmax(y[i] + b[i], i == 4 ? 1e-5 * tiny : tiny);
+        max_change       = fmax(max_change, fabs(y_new - y[i]) / fmax(y_new, tiny));
+        y[i]             = y_new;
+      }
+      converged = max_change < 1e-6;
+    }
+    if (!converged && n_halving < max_halving) {
+      dt *= 0.5;
+      if (print) printf("Implicit chemistry: Newton didn't converge, dt -> %e \n", dt);
+    }
+  }
 
-  Real current_z, density_conv, energy_conv;
-  current_z    = Chem_H.current_z;
-  density_conv = Chem_H.density_conversion;
-  energy_conv  = Chem_H.energy_conversion;
+  // Record the temperature for the next step
+  temp_prev = TS.get_temperature(Chem_H.gamma);
 
-  Real U_dot, HI_dot, e_dot, HI_dot_prev, e_dot_prev, temp_prev;
-  Real k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI;
-  Real k_recomb_HII, k_recomb_HeII, k_recomb_HeIII;
+  HI_dot_prev = fabs(TS.d_HI - y[0]) / fmax(dt, tiny);
+  TS.d_HI     = y[0];
+  TS.d_HII    = y[1];
+  TS.d_HeI    = y[2];
+  TS.d_HeII   = y[3];
+  TS.d_HeIII  = y[4];
+
+  // Use charge conservation to determine electron fraction
+  e_dot_prev = TS.d_e;
+  TS.d_e     = TS.d_HII + TS.d_HeII / 4.0 + TS.d_HeIII / 2.0;
+  e_dot_prev = fabs(TS.d_e - e_dot_prev) / fmax(dt, tiny);
+
+  // Update internal energy
+  TS.U += U_dot / TS.d * dt;
+    #ifdef TEMPERATURE_FLOOR
+  if (TS.get_temperature(Chem_H.gamma) < TEMP_FLOOR) TS.U = TS.compute_U(TEMP_FLOOR, Chem_H.gamma);
+    #endif
+  if (print) printf("Updated U: %e \n", TS.U);
+}
+  #endif  // CHEMISTRY_IMPLICIT
+
+/*! \brief The dynamic shared memory of the reaction rate tables staged by
+ * Stage_Reaction_Rates, 0 if they don't fit */
+__host__ __device__ size_t Reaction_Rates_Shared_Bytes(int N_Temp_bins)
+{
+  size_t const bytes = N_REACTION_RATES * N_Temp_bins * sizeof(Real);
+  return bytes <= CHEM_SHARED_RATES_MAX ? bytes : 0;
+}
+
+/*! \brief Copy the reaction rate tables of Chem_H into the shared memory of
+ * the block and point Chem_H to them, since every substep of every cell
+ * interpolates all of them. The cooling tables don't fit as well and stay in
+ * global memory. Has to be called by all the threads of the block */
+__device__ void Stage_Reaction_Rates(Chemistry_Header &Chem_H)
+{
+  extern __shared__ Real s_reaction_rates[];
+  int const N = Chem_H.N_Temp_bins;
+  if (Reaction_Rates_Shared_Bytes(N) == 0) {
+    return;
+  }
+
+  Real **const tables[N_REACTION_RATES] = {&Chem_H.k_coll_i_HI_d,    &Chem_H.k_coll_i_HeI_d,  &Chem_H.k_coll_i_HeII_d,
+                                           &Chem_H.k_coll_i_HI_HI_d, &Chem_H.k_coll_i_HI_HeI_d, &Chem_H.k_recomb_HII_d,
+                                           &Chem_H.k_recomb_HeII_d,  &Chem_H.k_recomb_HeIII_d};
+  for (int t = 0; t < N_REACTION_RATES; t++) {
+    for (int i = threadIdx.x; i < N; i += blockDim.x) {
+      s_reaction_rates[t * N + i] = (*tables[t])[i];
+    }
+  }
+  __syncthreads();
+  for (int t = 0; t < N_REACTION_RATES; t++) {
+    *tables[t] = s_reaction_rates + t * N;
+  }
+}
+
+/*! \brief The quantities of a chemistry update that are the same in all the
+ * cells */
+struct Chemistry_Step {
+  Real dt_hydro;
+  Real a2, a3;
   float photo_i_HI, photo_i_HeI, photo_i_HeII;
   float photo_h_HI, photo_h_HeI, photo_h_HeII;
+};
+
+/*! \brief The integration state of a cell, kept between the rounds of
+ * substeps of the work queue */
+struct Chemistry_Cell_State {
+  Thermal_State TS;
+  Real HI_dot_prev;
+  Real e_dot_prev;
+  Real temp_prev;
+  Real t_chem;
+  int n_iter;
+};
+
+__device__ Chemistry_Step Get_Chemistry_Step(Chemistry_Header &Chem_H, Real dt_hydro, bool print)
+{
+  Chemistry_Step step;
+  Real current_a = 1 / (Chem_H.current_z + 1);
+  step.a2        = current_a * current_a;
+  step.a3        = step.a2 * current_a;
+
+  // Convert to cgs units
+  step.dt_hydro = dt_hydro / Chem_H.time_units;
+  #ifdef COSMOLOGY
+  step.dt_hydro *= current_a * current_a / Chem_H.H0 * 1000 * KPC;
+  #endif  // COSMOLOGY
+  // dt_hydro = dt_hydro * current_a * current_a / Chem_H.H0 *
+  // 1000 * KPC / Chem_H.time_units;
+  //  delta_a = Chem_H.H0 * sqrt( Chem_H.Omega_M/current_a +
+  //  Chem_H.Omega_L*pow(current_a, 2) ) / ( 1000 * KPC ) *
+  //  dt_hydro * Chem_H.time_units;
+
+  // The photoheating and photoionization rates at z=current_z, evaluated on
+  // the host by Chem_GPU::Update_UVB_Rates
+  step.photo_i_HI   = Chem_H.photo_i_HI;
+  step.photo_i_HeI  = Chem_H.photo_i_HeI;
+  step.photo_i_HeII = Chem_H.photo_i_HeII;
+  step.photo_h_HI   = Chem_H.photo_h_HI;
+  step.photo_h_HeI  = Chem_H.photo_h_HeI;
+  step.photo_h_HeII = Chem_H.photo_h_HeII;
+  return step;
+}
+
+/*! \brief Initialize the integration state of the cell id from the conserved
+ * fields */
+__device__ void Load_Chemistry_State(Real *dev_conserved, int id, int n_cells, int n_fields, Chemistry_Header &Chem_H,
+                                     Chemistry_Step const &step, Chemistry_Cell_State &S)
+{
+  Real d, d_inv, vx, vy, vz, E_kin, GE;
+  d     = dev_conserved[id];
+  d_inv = 1.0 / d;
+  vx    = dev_conserved[1 * n_cells + id] * d_inv;
+  vy    = dev_conserved[2 * n_cells + id] * d_inv;
+  vz    = dev_conserved[3 * n_cells + id] * d_inv;
+  E_kin = 0.5 * d * (vx * vx + vy * vy + vz * vz);
+  #ifdef DE
+  GE = dev_conserved[(n_fields - 1) * n_cells + id];
+  #else
+  GE = dev_conserved[4 * n_cells + id] - E_kin;
+  #endif
+  GE *= Chem_H.energy_conversion / step.a2;
+
+  // Initialize the thermal state
+  Thermal_State &TS = S.TS;
+  TS.d              = dev_conserved[id] / step.a3;
+  TS.d_HI           = dev_conserved[id + n_cells * grid_enum::HI_density] / step.a3;
+  TS.d_HII          = dev_conserved[id + n_cells * grid_enum::HII_density] / step.a3;
+  TS.d_HeI          = dev_conserved[id + n_cells * grid_enum::HeI_density] / step.a3;
+  TS.d_HeII         = dev_conserved[id + n_cells * grid_enum::HeII_density] / step.a3;
+  TS.d_HeIII        = dev_conserved[id + n_cells * grid_enum::HeIII_density] / step.a3;
+  TS.d_e            = dev_conserved[id + n_cells * grid_enum::e_density] / step.a3;
+  TS.U              = GE * d_inv * 1e-10;
+  #ifdef GRACKLE_METALS
+  TS.metallicity = dev_conserved[id + n_cells * grid_enum::metal_density] * d_inv;
+  #endif
+
+  // Ceiling species
+  TS.d_HI    = fmax(TS.d_HI, tiny);
+  TS.d_HII   = fmax(TS.d_HII, tiny);
+  TS.d_HeI   = fmax(TS.d_HeI, tiny);
+  TS.d_HeII  = fmax(TS.d_HeII, tiny);
+  TS.d_HeIII = fmax(TS.d_HeIII, 1e-5 * tiny);
+  TS.d_e     = fmax(TS.d_e, tiny);
+
+  // Compute temperature at first iteration
+  S.temp_prev = TS.get_temperature(Chem_H.gamma);
+
+  S.HI_dot_prev = 0;
+  S.e_dot_prev  = 0;
+  S.n_iter      = 0;
+  S.t_chem      = 0;
+}
+
+/*! \brief Integrate the chemistry of a cell until it reaches dt_hydro or
+ * Chem_H.max_iter substeps. With a positive max_steps at most max_steps more
+ * substeps are done. Returns whether the cell is done */
+__device__ bool Integrate_Chemistry_State(Chemistry_Cell_State &S, Chemistry_Header &Chem_H,
+                                          Chemistry_Step const &step, int max_steps, bool print)
+{
+  Real U_dot, HI_dot, e_dot, dt_chem;
+  Real k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI;
+  Real k_recomb_HII, k_recomb_HeII, k_recomb_HeIII;
+  Thermal_State &TS = S.TS;
+
+  for (int n_steps = 0; S.t_chem < step.dt_hydro; n_steps++) {
+    if (n_steps == max_steps) {
+      return false;
+    }
+    if (print) printf("########################################## Iter %d \n", S.n_iter);
+
+    U_dot = Get_Cooling_Rates(TS, Chem_H, Chem_H.dens_number_conv, Chem_H.current_z, S.temp_prev, step.photo_h_HI,
+                              step.photo_h_HeI, step.photo_h_HeII, print);
+
+    Get_Reaction_Rates(TS, Chem_H, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI,
+                       k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, print);
+
+    dt_chem = Get_Chemistry_dt(TS, Chem_H, HI_dot, e_dot, U_dot, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII,
+                               k_coll_i_HI_HI, k_coll_i_HI_HeI, k_recomb_HII, k_recomb_HeII, k_recomb_HeIII,
+                               step.photo_i_HI, step.photo_i_HeI, step.photo_i_HeII, S.n_iter, S.HI_dot_prev,
+                               S.e_dot_prev, S.t_chem, step.dt_hydro, print);
+
+  #ifdef CHEMISTRY_IMPLICIT
+    Update_Step_Implicit(TS, Chem_H, dt_chem, U_dot, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI,
+                         k_coll_i_HI_HeI, k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, step.photo_i_HI,
+                         step.photo_i_HeI, step.photo_i_HeII, S.HI_dot_prev, S.e_dot_prev, S.temp_prev, print);
+  #else
+    Update_Step(TS, Chem_H, dt_chem, U_dot, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI,
+                k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, step.photo_i_HI, step.photo_i_HeI, step.photo_i_HeII,
+                S.HI_dot_prev, S.e_dot_prev, S.temp_prev, print);
+  #endif  // CHEMISTRY_IMPLICIT
+
+    S.t_chem += dt_chem;
+    S.n_iter += 1;
+    if (S.n_iter == Chem_H.max_iter) break;
+  }
+  if (print) printf("Chem_GPU: N Iter:  %d\n", S.n_iter);
+  return true;
+}
+
+/*! \brief Write the integrated thermal state of the cell id back to the
+ * conserved fields */
+__device__ void Store_Chemistry_State(Real *dev_conserved, int id, int n_cells, int n_fields, Chemistry_Header &Chem_H,
+                                      Chemistry_Step const &step, Chemistry_Cell_State &S, bool print)
+{
+  Real d, d_inv, vx, vy, vz, E_kin, GE;
   Real correct_H, correct_He;
+  Thermal_State &TS = S.TS;
+
+  // The hydro fields are not changed by the integration
+  d     = dev_conserved[id];
+  d_inv = 1.0 / d;
+  vx    = dev_conserved[1 * n_cells + id] * d_inv;
+  vy    = dev_conserved[2 * n_cells + id] * d_inv;
+  vz    = dev_conserved[3 * n_cells + id] * d_inv;
+  E_kin = 0.5 * d * (vx * vx + vy * vy + vz * vz);
+
+  // Make consistent abundances with the H and He density
+  correct_H  = Chem_H.H_fraction * TS.d / (TS.d_HI + TS.d_HII);
+  correct_He = (1.0 - Chem_H.H_fraction) * TS.d / (TS.d_HeI + TS.d_HeII + TS.d_HeIII);
+  TS.d_HI *= correct_H;
+  TS.d_HII *= correct_H;
+  TS.d_HeI *= correct_He;
+  TS.d_HeII *= correct_He;
+  TS.d_HeIII *= correct_He;
+
+  // Use charge conservation to determine electron fractioan
+  TS.d_e = TS.d_HII + TS.d_HeII / 4.0 + TS.d_HeIII / 2.0;
+
+  // Write the Updated Thermal State
+  dev_conserved[id + n_cells * grid_enum::HI_density]    = TS.d_HI * step.a3;
+  dev_conserved[id + n_cells * grid_enum::HII_density]   = TS.d_HII * step.a3;
+  dev_conserved[id + n_cells * grid_enum::HeI_density]   = TS.d_HeI * step.a3;
+  dev_conserved[id + n_cells * grid_enum::HeII_density]  = TS.d_HeII * step.a3;
+  dev_conserved[id + n_cells * grid_enum::HeIII_density] = TS.d_HeIII * step.a3;
+  dev_conserved[id + n_cells * grid_enum::e_density]     = TS.d_e * step.a3;
+  GE                                                     = TS.U / d_inv / Chem_H.energy_conversion * step.a2 / 1e-10;
+  dev_conserved[4 * n_cells + id]                        = GE + E_kin;
+  #ifdef DE
+  dev_conserved[(n_fields - 1) * n_cells + id] = GE;
+  #endif
 
+  if (print) printf("###########################################\n");
+  if (print) printf("Updated HI:  %e\n", TS.d_HI * step.a3);
+  if (print) printf("Updated HII:  %e\n", TS.d_HII * step.a3);
+  if (print) printf("Updated HeI:  %e\n", TS.d_HeI * step.a3);
+  if (print) printf("Updated HeII:  %e\n", TS.d_HeII * step.a3);
+  if (print) printf("Updated HeIII:  %e\n", TS.d_HeIII * step.a3);
+  if (print) printf("Updated e:  %e\n", TS.d_e * step.a3);
+  if (print) printf("Updated GE:  %e\n", dev_conserved[(n_fields - 1) * n_cells + id]);
+  if (print) printf("Updated E:   %e\n", dev_conserved[4 * n_cells + id]);
+}
+
+__global__ void Update_Chemistry_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields,
+                                        Real dt_hydro, Chemistry_Header Chem_H)
+{
+  int id, xid, yid, zid, n_cells;
   n_cells = nx * ny * nz;
+  Stage_Reaction_Rates(Chem_H);
 
   // get a global thread ID
   id  = threadIdx.x + blockIdx.x * blockDim.x;
@@ -458,150 +826,134 @@ __global__ void Update_Chemistry_kernel(Real *dev_conserved, int nx, int ny, int
   // threads corresponding to real cells do the calculation
   if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
       zid < nz - n_ghost) {
-    d     = dev_conserved[id];
-    d_inv = 1.0 / d;
-    vx    = dev_conserved[1 * n_cells + id] * d_inv;
-    vy    = dev_conserved[2 * n_cells + id] * d_inv;
-    vz    = dev_conserved[3 * n_cells + id] * d_inv;
-    E_kin = 0.5 * d * (vx * vx + vy * vy + vz * vz);
-  #ifdef DE
-    GE = dev_conserved[(n_fields - 1) * n_cells + id];
-  #else
-    GE = dev_conserved[4 * n_cells + id] - E_kin;
-  #endif
-
     print = false;
     // if ( xid == n_ghost && yid == n_ghost && zid == n_ghost ) print = true;
 
-    // Convert to cgs units
-    current_a = 1 / (current_z + 1);
-    a2        = current_a * current_a;
-    a3        = a2 * current_a;
-    d *= density_conv / a3;
-    GE *= energy_conv / a2;
-    dt_hydro = dt_hydro / Chem_H.time_units;
+    Chemistry_Step const step = Get_Chemistry_Step(Chem_H, dt_hydro, print);
+    Chemistry_Cell_State S;
+    Load_Chemistry_State(dev_conserved, id, n_cells, n_fields, Chem_H, step, S);
+    Integrate_Chemistry_State(S, Chem_H, step, -1, print);
+    Store_Chemistry_State(dev_conserved, id, n_cells, n_fields, Chem_H, step, S, print);
+  }
+}
 
-  #ifdef COSMOLOGY
-    dt_hydro *= current_a * current_a / Chem_H.H0 * 1000 *
-                KPC
-  #endif  // COSMOLOGY
-          // dt_hydro = dt_hydro * current_a * current_a / Chem_H.H0 *
-          // 1000 * KPC / Chem_H.time_units;
-          //  delta_a = Chem_H.H0 * sqrt( Chem_H.Omega_M/current_a +
-          //  Chem_H.Omega_L*pow(current_a, 2) ) / ( 1000 * KPC ) *
-          //  dt_hydro * Chem_H.time_units;
-
-                    // Initialize the thermal state
-                    Thermal_State TS;
-    TS.d       = dev_conserved[id] / a3;
-    TS.d_HI    = dev_conserved[id + n_cells * grid_enum::HI_density] / a3;
-    TS.d_HII   = dev_conserved[id + n_cells * grid_enum::HII_density] / a3;
-    TS.d_HeI   = dev_conserved[id + n_cells * grid_enum::HeI_density] / a3;
-    TS.d_HeII  = dev_conserved[id + n_cells * grid_enum::HeII_density] / a3;
-    TS.d_HeIII = dev_conserved[id + n_cells * grid_enum::HeIII_density] / a3;
-    TS.d_e     = dev_conserved[id + n_cells * grid_enum::e_density] / a3;
-    TS.U       = GE * d_inv * 1e-10;
-
-    // Ceiling species
-    TS.d_HI    = fmax(TS.d_HI, tiny);
-    TS.d_HII   = fmax(TS.d_HII, tiny);
-    TS.d_HeI   = fmax(TS.d_HeI, tiny);
-    TS.d_HeII  = fmax(TS.d_HeII, tiny);
-    TS.d_HeIII = fmax(TS.d_HeIII, 1e-5 * tiny);
-    TS.d_e     = fmax(TS.d_e, tiny);
-
-    // Compute temperature at first iteration
-    temp_prev = TS.get_temperature(Chem_H.gamma);
-
-    // if (print){
-    //   printf("current_z: %f\n", current_z );
-    //   printf("density_units: %e\n", Chem_H.density_units );
-    //   printf("lenght_units: %e\n", Chem_H.length_units );
-    //   printf("velocity_units: %e\n", Chem_H.velocity_units );
-    //   printf("time_units: %e\n", Chem_H.time_units );
-    //   printf("dom: %e \n", dens_number_conv );
-    //   printf("density: %e \n",         TS.d );
-    //   printf("HI_density: %e \n",      TS.d_HI );
-    //   printf("HII_density: %e \n",     TS.d_HII );
-    //   printf("HeI_density: %e \n",     TS.d_HeI );
-    //   printf("HeII_density: %e \n",    TS.d_HeII );
-    //   printf("HeIII_density: %e \n",   TS.d_HeIII );
-    //   printf("e_density: %e \n",       TS.d_e );
-    //   printf("internal_energy: %e \n", TS.U );
-    //   printf("energy: %e \n", TS.U*TS.d );
-    //   printf("dt_hydro: %e \n", dt_hydro / Chem_H.time_units );
-    // }
-
-    // Get the photoheating and photoionization rates at z=current_z
-    Get_Current_UVB_Rates(current_z, Chem_H, photo_i_HI, photo_i_HeI, photo_i_HeII, photo_h_HI, photo_h_HeI,
-                          photo_h_HeII, print);
-
-    HI_dot_prev = 0;
-    e_dot_prev  = 0;
-    n_iter      = 0;
-    t_chem      = 0;
-    while (t_chem < dt_hydro) {
-      if (print) printf("########################################## Iter %d \n", n_iter);
-
-      U_dot = Get_Cooling_Rates(TS, Chem_H, Chem_H.dens_number_conv, current_z, temp_prev, photo_h_HI, photo_h_HeI,
-                                photo_h_HeII, print);
-
-      Get_Reaction_Rates(TS, Chem_H, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI,
-                         k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, print);
-
-      dt_chem =
-          Get_Chemistry_dt(TS, Chem_H, HI_dot, e_dot, U_dot, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI,
-                           k_coll_i_HI_HeI, k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, photo_i_HI, photo_i_HeI,
-                           photo_i_HeII, n_iter, HI_dot_prev, e_dot_prev, t_chem, dt_hydro, print);
-
-      Update_Step(TS, Chem_H, dt_chem, U_dot, k_coll_i_HI, k_coll_i_HeI, k_coll_i_HeII, k_coll_i_HI_HI, k_coll_i_HI_HeI,
-                  k_recomb_HII, k_recomb_HeII, k_recomb_HeIII, photo_i_HI, photo_i_HeI, photo_i_HeII, HI_dot_prev,
-                  e_dot_prev, temp_prev, print);
-
-      t_chem += dt_chem;
-      n_iter += 1;
-      if (n_iter == Chem_H.max_iter) break;
-    }
-    if (print) printf("Chem_GPU: N Iter:  %d\n", n_iter);
-
-    // Make consistent abundances with the H and He density
-    correct_H  = Chem_H.H_fraction * TS.d / (TS.d_HI + TS.d_HII);
-    correct_He = (1.0 - Chem_H.H_fraction) * TS.d / (TS.d_HeI + TS.d_HeII + TS.d_HeIII);
-    TS.d_HI *= correct_H;
-    TS.d_HII *= correct_H;
-    TS.d_HeI *= correct_He;
-    TS.d_HeII *= correct_He;
-    TS.d_HeIII *= correct_He;
-
-    // Use charge conservation to determine electron fractioan
-    TS.d_e = TS.d_HII + TS.d_HeII / 4.0 + TS.d_HeIII / 2.0;
-
-    // Write the Updated Thermal State
-    dev_conserved[id + n_cells * grid_enum::HI_density]    = TS.d_HI * a3;
-    dev_conserved[id + n_cells * grid_enum::HII_density]   = TS.d_HII * a3;
-    dev_conserved[id + n_cells * grid_enum::HeI_density]   = TS.d_HeI * a3;
-    dev_conserved[id + n_cells * grid_enum::HeII_density]  = TS.d_HeII * a3;
-    dev_conserved[id + n_cells * grid_enum::HeIII_density] = TS.d_HeIII * a3;
-    dev_conserved[id + n_cells * grid_enum::e_density]     = TS.d_e * a3;
-    d                                                      = d / density_conv * a3;
-    GE                                                     = TS.U / d_inv / energy_conv * a2 / 1e-10;
-    dev_conserved[4 * n_cells + id]                        = GE + E_kin;
-  #ifdef DE
-    dev_conserved[(n_fields - 1) * n_cells + id] = GE;
-  #endif
+  #ifdef CHEMISTRY_GPU_QUEUE
+/*! \brief Append the state of the unfinished cells of the block to the queue
+ * with a single global atomic per block. Returns whether the cell was queued,
+ * the cells that don't fit in the capacity of the queue are not. Has to be
+ * called by all the threads of the block */
+__device__ bool Push_Chemistry_Queue(bool push, int id, Chemistry_Cell_State const &S, int *queue,
+                                     Chemistry_Cell_State *states, int capacity, int *n_queue)
+{
+  __shared__ int block_count;
+  __shared__ int block_offset;
+  if (threadIdx.x == 0) {
+    block_count = 0;
+  }
+  __syncthreads();
+  int slot = 0;
+  if (push) {
+    slot = atomicAdd(&block_count, 1);
+  }
+  __syncthreads();
+  if (threadIdx.x == 0 && block_count > 0) {
+    block_offset = atomicAdd(n_queue, block_count);
+  }
+  __syncthreads();
+  if (push && block_offset + slot < capacity) {
+    queue[block_offset + slot]  = id;
+    states[block_offset + slot] = S;
+    return true;
+  }
+  return false;
+}
 
-    if (print) printf("###########################################\n");
-    if (print) printf("Updated HI:  %e\n", TS.d_HI * a3);
-    if (print) printf("Updated HII:  %e\n", TS.d_HII * a3);
-    if (print) printf("Updated HeI:  %e\n", TS.d_HeI * a3);
-    if (print) printf("Updated HeII:  %e\n", TS.d_HeII * a3);
-    if (print) printf("Updated HeIII:  %e\n", TS.d_HeIII * a3);
-    if (print) printf("Updated e:  %e\n", TS.d_e * a3);
-    if (print) printf("Updated GE:  %e\n", dev_conserved[(n_fields - 1) * n_cells + id]);
-    if (print) printf("Updated E:   %e\n", dev_conserved[4 * n_cells + id]);
+/*! \brief Add the substeps of the cells finished by the block to substeps[0]
+ * and their maximum to substeps[1]. Has to be called by all the threads of the
+ * block */
+__device__ void Count_Chemistry_Substeps(bool finished, int n_iter, unsigned long long *substeps)
+{
+  __shared__ unsigned long long block_sum;
+  __shared__ unsigned long long block_max;
+  if (threadIdx.x == 0) {
+    block_sum = 0;
+    block_max = 0;
+  }
+  __syncthreads();
+  if (finished) {
+    atomicAdd(&block_sum, (unsigned long long)n_iter);
+    atomicMax(&block_max, (unsigned long long)n_iter);
+  }
+  __syncthreads();
+  if (threadIdx.x == 0 && block_sum > 0) {
+    atomicAdd(&substeps[0], block_sum);
+    atomicMax(&substeps[1], block_max);
   }
 }
 
+/*! \brief First round of the work queue: every real cell does up to
+ * CHEM_ROUND_STEPS substeps, the unfinished cells are queued for the next
+ * round */
+__global__ void Start_Chemistry_Queue_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields,
+                                             Real dt_hydro, Chemistry_Header Chem_H, int *queue,
+                                             Chemistry_Cell_State *states, int capacity, int *n_queue,
+                                             unsigned long long *substeps)
+{
+  Stage_Reaction_Rates(Chem_H);
+  int const n_cells = nx * ny * nz;
+  int const id      = threadIdx.x + blockIdx.x * blockDim.x;
+  int const zid     = id / (nx * ny);
+  int const yid     = (id - zid * nx * ny) / nx;
+  int const xid     = id - zid * nx * ny - yid * nx;
+  bool const real   = xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost &&
+                    zid > n_ghost - 1 && zid < nz - n_ghost;
+
+  Chemistry_Step const step = Get_Chemistry_Step(Chem_H, dt_hydro, false);
+  Chemistry_Cell_State S;
+  bool done = true;
+  if (real) {
+    Load_Chemistry_State(dev_conserved, id, n_cells, n_fields, Chem_H, step, S);
+    done = Integrate_Chemistry_State(S, Chem_H, step, CHEM_ROUND_STEPS, false);
+  }
+  bool const queued = Push_Chemistry_Queue(real && !done, id, S, queue, states, capacity, n_queue);
+  // The cells that didn't fit in the queue are finished here
+  if (real && !queued) {
+    Integrate_Chemistry_State(S, Chem_H, step, -1, false);
+    Store_Chemistry_State(dev_conserved, id, n_cells, n_fields, Chem_H, step, S, false);
+  }
+  Count_Chemistry_Substeps(real && !queued, S.n_iter, substeps);
+}
+
+/*! \brief Next round of the work queue: the n_in queued cells do up to
+ * CHEM_ROUND_STEPS more substeps, the unfinished ones are queued again */
+__global__ void Continue_Chemistry_Queue_kernel(Real *dev_conserved, int n_cells, int n_fields, Real dt_hydro,
+                                                Chemistry_Header Chem_H, int n_in, int *queue_in,
+                                                Chemistry_Cell_State *states_in, int *queue_out,
+                                                Chemistry_Cell_State *states_out, int capacity, int *n_out,
+                                                unsigned long long *substeps)
+{
+  Stage_Reaction_Rates(Chem_H);
+  int const i       = threadIdx.x + blockIdx.x * blockDim.x;
+  bool const active = i < n_in;
+
+  Chemistry_Step const step = Get_Chemistry_Step(Chem_H, dt_hydro, false);
+  Chemistry_Cell_State S;
+  int id    = 0;
+  bool done = true;
+  if (active) {
+    id   = queue_in[i];
+    S    = states_in[i];
+    done = Integrate_Chemistry_State(S, Chem_H, step, CHEM_ROUND_STEPS, false);
+  }
+  bool const queued = Push_Chemistry_Queue(active && !done, id, S, queue_out, states_out, capacity, n_out);
+  if (active && !queued) {
+    Integrate_Chemistry_State(S, Chem_H, step, -1, false);
+    Store_Chemistry_State(dev_conserved, id, n_cells, n_fields, Chem_H, step, S, false);
+  }
+  Count_Chemistry_Substeps(active && !queued, S.n_iter, substeps);
+}
+  #endif  // CHEMISTRY_GPU_QUEUE
+
 void Do_Chemistry_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
                          Chemistry_Header &Chem_H)
 {
@@ -614,8 +966,51 @@ void Do_Chemistry_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghos
   int ngrid = (nx * ny * nz - 1) / TPB_CHEM + 1;
   dim3 dim1dGrid(ngrid, 1, 1);
   dim3 dim1dBlock(TPB_CHEM, 1, 1);
-  hipLaunchKernelGGL(Update_Chemistry_kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields,
-                     dt, Chem_H);
+  size_t const shared_bytes = Reaction_Rates_Shared_Bytes(Chem_H.N_Temp_bins);
+  #ifdef CHEMISTRY_GPU_QUEUE
+  // The cells are integrated in rounds of CHEM_ROUND_STEPS substeps and only
+  // the unfinished cells are compacted into the queue of the next round, so
+  // the warps aren't left waiting for a few stiff cells
+  cuda_utilities::DeviceVector<int> static queue[2] = {cuda_utilities::DeviceVector<int>(1),
+                                                       cuda_utilities::DeviceVector<int>(1)};
+  cuda_utilities::DeviceVector<Chemistry_Cell_State> static states[2] = {
+      cuda_utilities::DeviceVector<Chemistry_Cell_State>(1), cuda_utilities::DeviceVector<Chemistry_Cell_State>(1)};
+  cuda_utilities::DeviceVector<int> static n_queue(1);
+  cuda_utilities::DeviceVector<unsigned long long> static substeps(2);
+
+  int const capacity = std::max(nx * ny * nz / CHEM_QUEUE_FRACTION, 1);
+  if (queue[0].size() != size_t(capacity)) {
+    for (int k = 0; k < 2; k++) {
+      queue[k].reset(capacity);
+      states[k].reset(capacity);
+    }
+  }
+  n_queue.assign(0);
+  substeps.assign(0, 0);
+  substeps.assign(0, 1);
+  hipLaunchKernelGGL(Start_Chemistry_Queue_kernel, dim1dGrid, dim1dBlock, shared_bytes, 0, dev_conserved, nx, ny, nz,
+                     n_ghost, n_fields, dt, Chem_H, queue[0].data(), states[0].data(), capacity, n_queue.data(),
+                     substeps.data());
+  GPU_Error_Check();
+
+  int n_rounds = 1;
+  for (int n_in = std::min(n_queue[0], capacity); n_in > 0; n_in = std::min(n_queue[0], capacity)) {
+    int const in = (n_rounds - 1) % 2;
+    n_queue.assign(0);
+    hipLaunchKernelGGL(Continue_Chemistry_Queue_kernel, (n_in - 1) / TPB_CHEM + 1, TPB_CHEM, shared_bytes, 0,
+                       dev_conserved, nx * ny * nz, n_fields, dt, Chem_H, n_in, queue[in].data(), states[in].data(),
+                       queue[1 - in].data(), states[1 - in].data(), capacity, n_queue.data(), substeps.data());
+    GPU_Error_Check();
+    n_rounds++;
+  }
+
+  int const n_real = (nx - 2 * n_ghost) * (ny - 2 * n_ghost) * (nz - 2 * n_ghost);
+  chprintf(" Chemistry: %d rounds, substeps per cell: mean %.1f  max %llu \n", n_rounds,
+           Real(substeps[0]) / n_real, substeps[1]);
+  #else
+  hipLaunchKernelGGL(Update_Chemistry_kernel, dim1dGrid, dim1dBlock, shared_bytes, 0, dev_conserved, nx, ny, nz,
+                     n_ghost, n_fields, dt, Chem_H);
+  #endif  // CHEMISTRY_GPU_QUEUE
 
   GPU_Error_Check();
   cudaEventRecord(stop, 0);
@@ -1,10 +1,16 @@
 #ifndef CHEMISTRY_GPU_H
 #define CHEMISTRY_GPU_H
 
+#include <vector>
+
 #include "../global/global.h"
 
 #define CHEM_TINY 1e-20
 
+#if defined(CHEMISTRY_GPU) && defined(COOLING_GRACKLE)
+  #error "CHEMISTRY_GPU replaces COOLING_GRACKLE, only one of them can be defined"
+#endif
+
 // Define the type of a generic rate function.
 typedef Real (*Rate_Function_T)(Real, Real);
 
@@ -76,6 +82,20 @@ struct ChemistryHeader {
   float *photo_heat_HI_rate_d;
   float *photo_heat_HeI_rate_d;
   float *photo_heat_HeII_rate_d;
+
+  // The UVB rates at current_z, set by Chem_GPU::Update_UVB_Rates
+  float photo_i_HI, photo_i_HeI, photo_i_HeII;
+  float photo_h_HI, photo_h_HeI, photo_h_HeII;
+
+  // The Cloudy metal cooling and heating at current_z, as log10 of the rates
+  // in cooling units on a uniform grid of log10(n_H) and log10(T) with the
+  // temperature the fastest index. Set by Chem_GPU::Update_Metal_Cooling_Rates
+  int metal_n_dens;
+  int metal_n_temp;
+  Real metal_log_dens_start, metal_d_log_dens;
+  Real metal_log_temp_start, metal_d_log_temp;
+  Real *metal_cool_d;
+  Real *metal_heat_d;
 };
 
 #ifdef CHEMISTRY_GPU
@@ -111,6 +131,24 @@ class Chem_GPU
   float *Ion_rates_HeI_d;
   float *Ion_rates_HeII_d;
 
+  #ifdef GRACKLE_METALS
+  // The Cloudy metal cooling and heating of the Grackle data file, as log10 of
+  // the rates in erg cm^3 / s with the temperature the fastest index, then the
+  // redshift and log10(n_H). Tables without a redshift dimension have
+  // metal_n_z = 1
+  int metal_n_dens;
+  int metal_n_z;
+  int metal_n_temp;
+  std::vector<Real> metal_z_h;
+  std::vector<Real> metal_cool_h;
+  std::vector<Real> metal_heat_h;
+
+  // The cooling and heating at metal_z_loaded, the heating after the cooling
+  std::vector<Real> metal_rates_h;
+  Real *metal_rates_d;
+  Real metal_z_loaded;
+  #endif  // GRACKLE_METALS
+
   struct Chemistry_Header H;
 
   struct Fields {
@@ -138,6 +176,20 @@ class Chem_GPU
 
   void Copy_UVB_Rates_to_GPU();
 
+  /*! \brief Interpolate the UVB rates at current_z into the header. They are
+   * the same for all the cells, so they are evaluated once per step */
+  void Update_UVB_Rates(Real current_z);
+
+  #ifdef GRACKLE_METALS
+  void Initialize_Metal_Cooling_Rates(struct Parameters *P);
+
+  void Load_Metal_Cooling_Rates(struct Parameters *P);
+
+  /*! \brief Interpolate the metal cooling and heating tables at current_z and
+   * copy them to the device when the redshift changed */
+  void Update_Metal_Cooling_Rates(Real current_z);
+  #endif  // GRACKLE_METALS
+
   void Reset();
 
   #ifdef TEXTURES_UVB_INTERPOLATION
@@ -8,8 +8,19 @@
   #include <vector>
 
   #include "../io/io.h"
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
   #include "chemistry_gpu.h"
 
+  #ifdef GRACKLE_METALS
+    #include <hdf5.h>
+
+    #include <algorithm>
+    #include <cmath>
+    #include <limits>
+  #endif
+
 void Chem_GPU::Load_UVB_Ionization_and_Heating_Rates(struct Parameters *P)
 {
   char uvb_filename[100];
@@ -17,31 +28,39 @@ void Chem_GPU::Load_UVB_Ionization_and_Heating_Rates(struct Parameters *P)
   strcpy(uvb_filename, P->UVB_rates_file);
   chprintf(" Loading UVB rates: %s\n", uvb_filename);
 
-  std::fstream in(uvb_filename);
-  std::string line;
-  std::vector<std::vector<float>> v;
-  int i = 0;
-  if (in.is_open()) {
-    while (std::getline(in, line)) {
-      if (line.find("#") == 0) continue;
-
-      float value;
-      std::stringstream ss(line);
-      // chprintf( "%s \n", line.c_str() );
-      v.push_back(std::vector<float>());
-
-      while (ss >> value) {
-        v[i].push_back(value);
+  // The redshift and the six rates of each line. With MPI only rank 0 parses
+  // the text file, the other ranks get the values in binary
+  int const n_columns = 7;
+  std::vector<float> v;
+  #ifdef MPI_CHOLLA
+  if (procID == 0) {
+  #endif  // MPI_CHOLLA
+    std::fstream in(uvb_filename);
+    std::string line;
+    if (in.is_open()) {
+      while (std::getline(in, line)) {
+        if (line.empty() or line.find("#") == 0) continue;
+
+        float value;
+        std::stringstream ss(line);
+        // chprintf( "%s \n", line.c_str() );
+        for (int column = 0; column < n_columns; column++) {
+          ss >> value;
+          v.push_back(value);
+        }
       }
-      i += 1;
+      in.close();
+    } else {
+      chprintf(" Error: Unable to open UVB rates file: %s\n", uvb_filename);
+      exit(1);
     }
-    in.close();
-  } else {
-    chprintf(" Error: Unable to open UVB rates file: %s\n", uvb_filename);
-    exit(1);
+  #ifdef MPI_CHOLLA
   }
+  Broadcast_Vector(v);
+  #endif  // MPI_CHOLLA
 
-  int n_lines = i;
+  int n_lines = v.size() / n_columns;
+  int i;
 
   chprintf(" Loaded %d lines in file\n", n_lines);
 
@@ -59,13 +78,14 @@ void Chem_GPU::Load_UVB_Ionization_and_Heating_Rates(struct Parameters *P)
   ion_units  = H.time_units;
 
   for (i = 0; i < n_lines; i++) {
-    rates_z_h[i]         = v[i][0];
-    Ion_rates_HI_h[i]    = v[i][1] * ion_units;
-    Heat_rates_HI_h[i]   = v[i][2] * heat_units;
-    Ion_rates_HeI_h[i]   = v[i][3] * ion_units;
-    Heat_rates_HeI_h[i]  = v[i][4] * heat_units;
-    Ion_rates_HeII_h[i]  = v[i][5] * ion_units;
-    Heat_rates_HeII_h[i] = v[i][6] * heat_units;
+    float const *rates   = &v[i * n_columns];
+    rates_z_h[i]         = rates[0];
+    Ion_rates_HI_h[i]    = rates[1] * ion_units;
+    Heat_rates_HI_h[i]   = rates[2] * heat_units;
+    Ion_rates_HeI_h[i]   = rates[3] * ion_units;
+    Heat_rates_HeI_h[i]  = rates[4] * heat_units;
+    Ion_rates_HeII_h[i]  = rates[5] * ion_units;
+    Heat_rates_HeII_h[i] = rates[6] * heat_units;
     // chprintf( " %f  %e  %e  %e   \n", rates_z_h[i], Heat_rates_HI_h[i],
     // Heat_rates_HeI_h[i],  Heat_rates_HeII_h[i]); chprintf( " %f  %f  \n",
     // rates_z_h[i], Heat_rates_HI_h[i] );
@@ -89,4 +109,119 @@ void Chem_GPU::Load_UVB_Ionization_and_Heating_Rates(struct Parameters *P)
   chprintf("  UVB on:  a=%f \n", scale_factor_UVB_on);
 }
 
+  #ifdef GRACKLE_METALS
+/*! \brief Read the attribute name of a Cloudy rate dataset, exits if it
+ * can't be read */
+static void Read_Metal_Cooling_Attribute(hid_t dataset_id, const char *name, hid_t type, void *buffer)
+{
+  herr_t status      = -1;
+  hid_t attribute_id = H5Aopen(dataset_id, name, H5P_DEFAULT);
+  if (attribute_id >= 0) {
+    status = H5Aread(attribute_id, type, buffer);
+    H5Aclose(attribute_id);
+  }
+  if (status < 0) {
+    chprintf(" Error: Unable to read the %s attribute of the metal cooling rates\n", name);
+    exit(1);
+  }
+}
+
+/*! \brief Read the Cloudy rate dataset name into rates as log10 of the rates,
+ * like Grackle does */
+static void Read_Metal_Cooling_Dataset(hid_t file_id, const char *name, std::vector<Real> &rates)
+{
+  std::vector<double> buffer(rates.size());
+  herr_t status    = -1;
+  hid_t dataset_id = H5Dopen(file_id, name, H5P_DEFAULT);
+  if (dataset_id >= 0) {
+    status = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+    H5Dclose(dataset_id);
+  }
+  if (status < 0) {
+    chprintf(" Error: Unable to read the metal cooling rates %s\n", name);
+    exit(1);
+  }
+  // Some rates of the tables are zero, keep their log finite
+  for (size_t i = 0; i < rates.size(); i++) {
+    rates[i] = log10(std::max(buffer[i], std::numeric_limits<double>::min()));
+  }
+}
+
+/*! \brief Check that the grid values are uniformly spaced, as the device
+ * lookup of the rates assumes */
+static void Check_Uniform_Metal_Cooling_Grid(std::vector<double> const &grid, const char *name)
+{
+  double const delta = (grid.back() - grid.front()) / (grid.size() - 1);
+  for (size_t i = 1; i < grid.size(); i++) {
+    if (fabs(grid[i] - grid[i - 1] - delta) > 1e-3 * fabs(delta)) {
+      chprintf(" Error: The %s grid of the metal cooling rates is not uniform\n", name);
+      exit(1);
+    }
+  }
+}
+
+void Chem_GPU::Load_Metal_Cooling_Rates(struct Parameters *P)
+{
+  chprintf(" Loading metal cooling rates: %s\n", P->metal_cooling_file);
+
+  hid_t file_id = H5Fopen(P->metal_cooling_file, H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file_id < 0) {
+    chprintf(" Error: Unable to open metal cooling file: %s\n", P->metal_cooling_file);
+    exit(1);
+  }
+
+  // The grid of the rates is stored in the attributes of the datasets. The
+  // rank 3 tables of Grackle are indexed by log10(n_H), the redshift and the
+  // temperature, the rank 2 ones don't depend on redshift
+  hid_t dataset_id = H5Dopen(file_id, "/CoolingRates/Metals/Cooling", H5P_DEFAULT);
+  if (dataset_id < 0) {
+    chprintf(" Error: No /CoolingRates/Metals/Cooling dataset in %s\n", P->metal_cooling_file);
+    exit(1);
+  }
+  long long rank;
+  Read_Metal_Cooling_Attribute(dataset_id, "Rank", H5T_NATIVE_LLONG, &rank);
+  if (rank != 2 && rank != 3) {
+    chprintf(" Error: Metal cooling rates of rank %lld are not supported\n", rank);
+    exit(1);
+  }
+  std::vector<long long> dimension(rank);
+  Read_Metal_Cooling_Attribute(dataset_id, "Dimension", H5T_NATIVE_LLONG, dimension.data());
+  metal_n_dens = dimension[0];
+  metal_n_z    = rank == 3 ? dimension[1] : 1;
+  metal_n_temp = dimension[rank - 1];
+
+  std::vector<double> log_dens(metal_n_dens), redshift(metal_n_z), temp(metal_n_temp);
+  Read_Metal_Cooling_Attribute(dataset_id, "Parameter1", H5T_NATIVE_DOUBLE, log_dens.data());
+  if (rank == 3) {
+    Read_Metal_Cooling_Attribute(dataset_id, "Parameter2", H5T_NATIVE_DOUBLE, redshift.data());
+  }
+  Read_Metal_Cooling_Attribute(dataset_id, "Temperature", H5T_NATIVE_DOUBLE, temp.data());
+  H5Dclose(dataset_id);
+
+  std::vector<double> log_temp(metal_n_temp);
+  for (int i = 0; i < metal_n_temp; i++) {
+    log_temp[i] = log10(temp[i]);
+  }
+  Check_Uniform_Metal_Cooling_Grid(log_dens, "density");
+  Check_Uniform_Metal_Cooling_Grid(log_temp, "temperature");
+  H.metal_log_dens_start = log_dens.front();
+  H.metal_d_log_dens     = (log_dens.back() - log_dens.front()) / (metal_n_dens - 1);
+  H.metal_log_temp_start = log_temp.front();
+  H.metal_d_log_temp     = (log_temp.back() - log_temp.front()) / (metal_n_temp - 1);
+  metal_z_h.assign(redshift.begin(), redshift.end());
+
+  metal_cool_h.resize(metal_n_dens * metal_n_z * metal_n_temp);
+  metal_heat_h.resize(metal_cool_h.size());
+  Read_Metal_Cooling_Dataset(file_id, "/CoolingRates/Metals/Cooling", metal_cool_h);
+  Read_Metal_Cooling_Dataset(file_id, "/CoolingRates/Metals/Heating", metal_heat_h);
+  H5Fclose(file_id);
+
+  chprintf(" Loaded metal cooling rates: \n");
+  chprintf("  N density values: %d  N redshift values: %d  N temperature values: %d \n", metal_n_dens, metal_n_z,
+           metal_n_temp);
+  chprintf("  log10(n_H) = [%f, %f]    log10(T) = [%f, %f] \n", log_dens.front(), log_dens.back(), log_temp.front(),
+           log_temp.back());
+}
+  #endif  // GRACKLE_METALS
+
 #endif
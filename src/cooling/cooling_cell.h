@@ -0,0 +1,211 @@
+/*! \file cooling_cell.h
+ *  \brief Definitions of the cooling of a single cell, shared by the cooling
+ *  kernels and the source term kernel. */
+
+// WARNING: like texture_utilities.h, do not include this header file in any
+// .cpp file or any .h file that would be included into a .cpp file.
+
+#pragma once
+
+#ifdef COOLING_GPU
+
+  #include <math.h>
+
+  #include "../cooling/cooling_cuda.h"
+  #include "../global/global.h"
+  #include "../utils/gpu.hpp"
+
+  #ifdef CLOUDY_COOL
+    #include "../cooling/texture_utilities.h"
+  #endif
+
+/* \fn __device__ Real CIE_cool(Real n, Real T)
+ * \brief Analytic fit to a solar metallicity CIE cooling curve
+          calculated using Cloudy. */
+inline __device__ Real CIE_cool(Real n, Real T)
+{
+  Real lambda = 0.0;  // cooling rate, erg s^-1 cm^3
+  Real cool   = 0.0;  // cooling per unit volume, erg /s / cm^3
+
+  // fit to CIE cooling function
+  if (log10(T) < 4.0) {
+    lambda = 0.0;
+  } else if (log10(T) >= 4.0 && log10(T) < 5.9) {
+    lambda = pow(10.0, (-1.3 * (log10(T) - 5.25) * (log10(T) - 5.25) - 21.25));
+  } else if (log10(T) >= 5.9 && log10(T) < 7.4) {
+    lambda = pow(10.0, (0.7 * (log10(T) - 7.1) * (log10(T) - 7.1) - 22.8));
+  } else {
+    lambda = pow(10.0, (0.45 * log10(T) - 26.065));
+  }
+
+  // cooling rate per unit volume
+  cool = n * n * lambda;
+
+  return cool;
+}
+
+  #ifdef CLOUDY_COOL
+/* \fn __device__ Real Cloudy_cool(Real n, Real T, CloudyTable coolTexObj,
+ CloudyTable heatTexObj)
+ * \brief Uses texture mapping to interpolate Cloudy cooling/heating
+          tables at z = 0 with solar metallicity and an HM05 UV background. */
+inline __device__ Real Cloudy_cool(Real n, Real T, CloudyTable coolTexObj, CloudyTable heatTexObj)
+{
+    #ifdef CLOUDY_COOL_TABLE
+  // Same lookup as the texture version below, in Real precision. The tables
+  // are uniform in log n and log T, so the remapped coordinates give the
+  // table indices directly
+  Real lambda      = 0.0;  // cooling rate, erg s^-1 cm^3
+  Real const log_T = (log10(T) - 1.0) * 10;
+  Real const log_n = (log10(n) + 6.0) * 10;
+
+  // don't cool below 10 K
+  if (log_T > 0.0) {
+    lambda = Bilinear_Table(coolTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, log_T, log_n);
+  }
+  Real const H = Bilinear_Table(heatTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, log_T, log_n);
+
+  // cooling rate per unit volume
+  return n * n * (pow(10.0, lambda) - pow(10.0, H));
+    #else
+
+  Real lambda = 0.0;  // cooling rate, erg s^-1 cm^3
+  Real H      = 0.0;  // heating rate, erg s^-1 cm^3
+  Real cool   = 0.0;  // cooling per unit volume, erg /s / cm^3
+  float log_n, log_T;
+  log_n = log10(n);
+  log_T = log10(T);
+
+  // remap coordinates for texture
+  // remapped = (input - TABLE_MIN_VALUE)*(1/TABLE_SPACING)
+  // remapped = (input - TABLE_MIN_VALUE)*(NUM_CELLS_PER_DECADE)
+  log_T = (log_T - 1.0) * 10;
+  log_n = (log_n + 6.0) * 10;
+
+  // Note: although the cloudy table columns are n,T,L,H , T is the fastest
+  // variable so it is treated as "x" This is why the Texture calls are T first,
+  // then n: Bilinear_Texture(tex, log_T, log_n)
+
+  // don't cool below 10 K
+  if (log10(T) > 1.0) {
+    lambda = Bilinear_Texture(coolTexObj, log_T, log_n);
+  } else
+    lambda = 0.0;
+  H = Bilinear_Texture(heatTexObj, log_T, log_n);
+
+  // cooling rate per unit volume
+  cool = n * n * (powf(10, lambda) - powf(10, H));
+  // printf("DEBUG Cloudy L350: %.17e\n",cool);
+  return cool;
+    #endif  // CLOUDY_COOL_TABLE
+}
+  #endif  // CLOUDY_COOL
+
+/*! \fn bool Cool_Cell(Real *dev_conserved, int id, int n_cells, int n_fields,
+ Real dt, Real gamma, int max_substeps, CloudyTable coolTexObj, CloudyTable
+ heatTexObj)
+ *  \brief Adjust the total energy of the cell id according to the specified
+ cooling function over dt, in substeps that limit the change in temperature to
+ 1%. If the cell needs more than max_substeps substeps it is left untouched and
+ false is returned, a negative max_substeps doesn't limit them. */
+inline __device__ bool Cool_Cell(Real *dev_conserved, int id, int n_cells, int n_fields, Real dt, Real gamma,
+                          int max_substeps, CloudyTable coolTexObj, CloudyTable heatTexObj)
+{
+  Real d, E;
+  Real n, T, T_init;
+  Real del_T, dt_sub;
+  Real mu;    // mean molecular weight
+  Real cool;  // cooling rate per volume, erg/s/cm^3
+  // #ifndef DE
+  Real vx, vy, vz, p;
+  // #endif
+  #ifdef DE
+  Real ge;
+  #endif
+
+  mu = 0.6;
+  // mu = 1.27;
+
+  // load values of density and pressure
+  d = dev_conserved[id];
+  E = dev_conserved[4 * n_cells + id];
+  // don't apply cooling if this thread crashed
+  if (E < 0.0 || E != E) {
+    return true;
+  }
+  // #ifndef DE
+  vx = dev_conserved[1 * n_cells + id] / d;
+  vy = dev_conserved[2 * n_cells + id] / d;
+  vz = dev_conserved[3 * n_cells + id] / d;
+  p  = (E - 0.5 * d * (vx * vx + vy * vy + vz * vz)) * (gamma - 1.0);
+  p  = fmax(p, (Real)TINY_NUMBER);
+  // #endif
+  #ifdef DE
+  ge = dev_conserved[(n_fields - 1) * n_cells + id] / d;
+  ge = fmax(ge, (Real)TINY_NUMBER);
+  #endif
+
+  // calculate the number density of the gas (in cgs)
+  n = d * DENSITY_UNIT / (mu * MP);
+
+  // calculate the temperature of the gas
+  T_init = p * PRESSURE_UNIT / (n * KB);
+  #ifdef DE
+  T_init = d * ge * (gamma - 1.0) * PRESSURE_UNIT / (n * KB);
+  #endif
+
+  // calculate cooling rate per volume
+  T = T_init;
+  // call the cooling function
+  #ifdef CLOUDY_COOL
+  cool = Cloudy_cool(n, T, coolTexObj, heatTexObj);
+  #else
+  cool = CIE_cool(n, T);
+  #endif
+
+  // calculate change in temperature given dt
+  del_T = cool * dt * TIME_UNIT * (gamma - 1.0) / (n * KB);
+
+  // limit change in temperature to 1%
+  int n_substeps = 0;
+  while (del_T / T > 0.01) {
+    // the cell is left to the caller, nothing was written yet
+    if (n_substeps == max_substeps) {
+      return false;
+    }
+    n_substeps++;
+    // what dt gives del_T = 0.01*T?
+    dt_sub = 0.01 * T * n * KB / (cool * TIME_UNIT * (gamma - 1.0));
+    // apply that dt
+    T -= cool * dt_sub * TIME_UNIT * (gamma - 1.0) / (n * KB);
+    // how much time is left from the original timestep?
+    dt -= dt_sub;
+  // calculate cooling again
+  #ifdef CLOUDY_COOL
+    cool = Cloudy_cool(n, T, coolTexObj, heatTexObj);
+  #else
+    cool = CIE_cool(n, T);
+  #endif
+    // calculate new change in temperature
+    del_T = cool * dt * TIME_UNIT * (gamma - 1.0) / (n * KB);
+  }
+
+  // calculate final temperature
+  T -= del_T;
+
+  // adjust value of energy based on total change in temperature
+  del_T = T_init - T;  // total change in T
+  E -= n * KB * del_T / ((gamma - 1.0) * ENERGY_UNIT);
+  #ifdef DE
+  ge -= KB * del_T / (mu * MP * (gamma - 1.0) * SP_ENERGY_UNIT);
+  #endif
+
+  // and send back from kernel
+  dev_conserved[4 * n_cells + id] = E;
+  #ifdef DE
+  dev_conserved[(n_fields - 1) * n_cells + id] = d * ge;
+  #endif
+  return true;
+}
+
+#endif  // COOLING_GPU
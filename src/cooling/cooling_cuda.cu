@@ -5,39 +5,76 @@
 
   #include <math.h>
 
+  #include "../cooling/cooling_cell.h"
   #include "../cooling/cooling_cuda.h"
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../utils/gpu.hpp"
+  #include "../utils/profiling_ranges.h"
 
-  #ifdef CLOUDY_COOL
-    #include "../cooling/texture_utilities.h"
+  #ifdef COOLING_SUBCYCLE_QUEUE
+    #include "../utils/DeviceVector.h"
+    #include "../utils/cuda_utilities.h"
   #endif
 
-cudaTextureObject_t coolTexObj = 0;
-cudaTextureObject_t heatTexObj = 0;
+CloudyTable coolTexObj = 0;
+CloudyTable heatTexObj = 0;
+
+  #ifdef COOLING_SUBCYCLE_QUEUE
+/*! \fn void Cooling_Defer_kernel(Real *dev_conserved, int nx, int ny, int nz,
+ int n_ghost, int n_fields, Real dt, Real gamma, CloudyTable coolTexObj,
+ CloudyTable heatTexObj, int *queue, int *n_queue)
+ *  \brief Like cooling_kernel for the cells that cool in a single step. The
+ cells that need substeps are appended to queue instead, for
+ Cooling_Queue_kernel */
+__global__ void Cooling_Defer_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
+                                     Real gamma, CloudyTable coolTexObj, CloudyTable heatTexObj, int *queue,
+                                     int *n_queue);
+
+/*! \fn void Cooling_Queue_kernel(Real *dev_conserved, int nx, int ny, int nz,
+ int n_fields, Real dt, Real gamma, CloudyTable coolTexObj, CloudyTable
+ heatTexObj, int *queue, int *n_queue)
+ *  \brief Subcycle the cooling of the *n_queue cells of queue */
+__global__ void Cooling_Queue_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_fields, Real dt, Real gamma,
+                                     CloudyTable coolTexObj, CloudyTable heatTexObj, int *queue, int *n_queue);
+  #endif  // COOLING_SUBCYCLE_QUEUE
 
 void Cooling_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt, Real gamma)
 {
+  profiling::ScopedRange const range("Cooling_Update");
+
   int n_cells = nx * ny * nz;
   int ngrid   = (n_cells + TPB - 1) / TPB;
   dim3 dim1dGrid(ngrid, 1, 1);
   dim3 dim1dBlock(TPB, 1, 1);
+  #ifdef COOLING_SUBCYCLE_QUEUE
+  // The few cells that need many substeps would otherwise keep the rest of
+  // their warp idle, so they are gathered and subcycled in a second kernel
+  // where the warps only hold such cells
+  cuda_utilities::DeviceVector<int> static queue(1);
+  cuda_utilities::DeviceVector<int> static n_queue(1);
+  cuda_utilities::AutomaticLaunchParams static const queueParams(Cooling_Queue_kernel);
+  if (queue.size() < size_t(n_cells)) {
+    queue.resize(n_cells);
+  }
+  n_queue.assign(0);
+  hipLaunchKernelGGL(Cooling_Defer_kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields,
+                     dt, gama, coolTexObj, heatTexObj, queue.data(), n_queue.data());
+  GPU_Error_Check();
+  hipLaunchKernelGGL(Cooling_Queue_kernel, queueParams.numBlocks, queueParams.threadsPerBlock, 0, 0, dev_conserved, nx,
+                     ny, nz, n_fields, dt, gama, coolTexObj, heatTexObj, queue.data(), n_queue.data());
+  #else
   hipLaunchKernelGGL(cooling_kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields, dt,
                      gama, coolTexObj, heatTexObj);
+  #endif  // COOLING_SUBCYCLE_QUEUE
   GPU_Error_Check();
 }
 
-/*! \fn void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int
- n_ghost, int n_fields, Real dt, Real gamma, cudaTextureObject_t coolTexObj,
- cudaTextureObject_t heatTexObj)
- *  \brief When passed an array of conserved variables and a timestep, adjust
- the value of the total energy for each cell according to the specified cooling
- function. */
-__global__ void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
-                               Real gamma, cudaTextureObject_t coolTexObj, cudaTextureObject_t heatTexObj)
+/*! \fn bool Is_Real_Cooling_Cell(int id, int nx, int ny, int nz, int n_ghost)
+ *  \brief Whether the cell id is a real cell, in the directions that have
+ ghost cells */
+__device__ bool Is_Real_Cooling_Cell(int id, int nx, int ny, int nz, int n_ghost)
 {
-  int n_cells = nx * ny * nz;
   int is, ie, js, je, ks, ke;
   is = n_ghost;
   ie = nx - n_ghost;
@@ -56,113 +93,76 @@ __global__ void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int
     ke = nz - n_ghost;
   }
 
-  Real d, E;
-  Real n, T, T_init;
-  Real del_T, dt_sub;
-  Real mu;    // mean molecular weight
-  Real cool;  // cooling rate per volume, erg/s/cm^3
-  // #ifndef DE
-  Real vx, vy, vz, p;
-  // #endif
-  #ifdef DE
-  Real ge;
-  #endif
-
-  mu = 0.6;
-  // mu = 1.27;
+  int zid = id / (nx * ny);
+  int yid = (id - zid * nx * ny) / nx;
+  int xid = id - zid * nx * ny - yid * nx;
+  return xid >= is && xid < ie && yid >= js && yid < je && zid >= ks && zid < ke;
+}
 
+/*! \fn void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int
+ n_ghost, int n_fields, Real dt, Real gamma, CloudyTable coolTexObj, CloudyTable
+ heatTexObj)
+ *  \brief When passed an array of conserved variables and a timestep, adjust
+ the value of the total energy for each cell according to the specified cooling
+ function. */
+__global__ void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
+                               Real gamma, CloudyTable coolTexObj, CloudyTable heatTexObj)
+{
   // get a global thread ID
   int blockId = blockIdx.x + blockIdx.y * gridDim.x;
   int id      = threadIdx.x + blockId * blockDim.x;
-  int zid     = id / (nx * ny);
-  int yid     = (id - zid * nx * ny) / nx;
-  int xid     = id - zid * nx * ny - yid * nx;
 
   // only threads corresponding to real cells do the calculation
-  if (xid >= is && xid < ie && yid >= js && yid < je && zid >= ks && zid < ke) {
-    // load values of density and pressure
-    d = dev_conserved[id];
-    E = dev_conserved[4 * n_cells + id];
-    // don't apply cooling if this thread crashed
-    if (E < 0.0 || E != E) {
-      return;
-    }
-    // #ifndef DE
-    vx = dev_conserved[1 * n_cells + id] / d;
-    vy = dev_conserved[2 * n_cells + id] / d;
-    vz = dev_conserved[3 * n_cells + id] / d;
-    p  = (E - 0.5 * d * (vx * vx + vy * vy + vz * vz)) * (gamma - 1.0);
-    p  = fmax(p, (Real)TINY_NUMBER);
-  // #endif
-  #ifdef DE
-    ge = dev_conserved[(n_fields - 1) * n_cells + id] / d;
-    ge = fmax(ge, (Real)TINY_NUMBER);
-  #endif
-
-    // calculate the number density of the gas (in cgs)
-    n = d * DENSITY_UNIT / (mu * MP);
-
-    // calculate the temperature of the gas
-    T_init = p * PRESSURE_UNIT / (n * KB);
-  #ifdef DE
-    T_init = d * ge * (gamma - 1.0) * PRESSURE_UNIT / (n * KB);
-  #endif
-
-    // calculate cooling rate per volume
-    T = T_init;
-  // call the cooling function
-  #ifdef CLOUDY_COOL
-    cool = Cloudy_cool(n, T, coolTexObj, heatTexObj);
-  #else
-    cool = CIE_cool(n, T);
-  #endif
+  if (Is_Real_Cooling_Cell(id, nx, ny, nz, n_ghost)) {
+    Cool_Cell(dev_conserved, id, nx * ny * nz, n_fields, dt, gamma, -1, coolTexObj, heatTexObj);
+  }
+}
 
-    // calculate change in temperature given dt
-    del_T = cool * dt * TIME_UNIT * (gamma - 1.0) / (n * KB);
-
-    // limit change in temperature to 1%
-    while (del_T / T > 0.01) {
-      // what dt gives del_T = 0.01*T?
-      dt_sub = 0.01 * T * n * KB / (cool * TIME_UNIT * (gamma - 1.0));
-      // apply that dt
-      T -= cool * dt_sub * TIME_UNIT * (gamma - 1.0) / (n * KB);
-      // how much time is left from the original timestep?
-      dt -= dt_sub;
-  // calculate cooling again
-  #ifdef CLOUDY_COOL
-      cool = Cloudy_cool(n, T, coolTexObj, heatTexObj);
-  #else
-      cool = CIE_cool(n, T);
-  #endif
-      // calculate new change in temperature
-      del_T = cool * dt * TIME_UNIT * (gamma - 1.0) / (n * KB);
-    }
+  #ifdef COOLING_SUBCYCLE_QUEUE
+__global__ void Cooling_Defer_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
+                                     Real gamma, CloudyTable coolTexObj, CloudyTable heatTexObj, int *queue,
+                                     int *n_queue)
+{
+  __shared__ int block_count;
+  __shared__ int block_offset;
 
-    // calculate final temperature
-    T -= del_T;
+  // get a global thread ID
+  int blockId = blockIdx.x + blockIdx.y * gridDim.x;
+  int id      = threadIdx.x + blockId * blockDim.x;
 
-    // adjust value of energy based on total change in temperature
-    del_T = T_init - T;  // total change in T
-    E -= n * KB * del_T / ((gamma - 1.0) * ENERGY_UNIT);
-  #ifdef DE
-    ge -= KB * del_T / (mu * MP * (gamma - 1.0) * SP_ENERGY_UNIT);
-  #endif
+  bool deferred = false;
+  if (Is_Real_Cooling_Cell(id, nx, ny, nz, n_ghost)) {
+    deferred = !Cool_Cell(dev_conserved, id, nx * ny * nz, n_fields, dt, gamma, 0, coolTexObj, heatTexObj);
+  }
 
-  // calculate cooling rate for new T
-  #ifdef CLOUDY_COOL
-    cool = Cloudy_cool(n, T, coolTexObj, heatTexObj);
-  #else
-    cool = CIE_cool(n, T);
-  // printf("%d %d %d %e %e %e\n", xid, yid, zid, n, T, cool);
-  #endif
+  // Reserve the slots of the whole block with a single global atomic
+  if (threadIdx.x == 0) {
+    block_count = 0;
+  }
+  __syncthreads();
+  int slot = 0;
+  if (deferred) {
+    slot = atomicAdd(&block_count, 1);
+  }
+  __syncthreads();
+  if (threadIdx.x == 0 && block_count > 0) {
+    block_offset = atomicAdd(n_queue, block_count);
+  }
+  __syncthreads();
+  if (deferred) {
+    queue[block_offset + slot] = id;
+  }
+}
 
-    // and send back from kernel
-    dev_conserved[4 * n_cells + id] = E;
-  #ifdef DE
-    dev_conserved[(n_fields - 1) * n_cells + id] = d * ge;
-  #endif
+__global__ void Cooling_Queue_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_fields, Real dt, Real gamma,
+                                     CloudyTable coolTexObj, CloudyTable heatTexObj, int *queue, int *n_queue)
+{
+  int const n = *n_queue;
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < n; i += blockDim.x * gridDim.x) {
+    Cool_Cell(dev_conserved, queue[i], nx * ny * nz, n_fields, dt, gamma, -1, coolTexObj, heatTexObj);
   }
 }
+  #endif  // COOLING_SUBCYCLE_QUEUE
 
 /* \fn __device__ Real test_cool(Real n, Real T)
  * \brief Cooling function from Creasey 2011. */
@@ -291,67 +291,4 @@ __device__ Real primordial_cool(Real n, Real T)
   return cool;
 }
 
-/* \fn __device__ Real CIE_cool(Real n, Real T)
- * \brief Analytic fit to a solar metallicity CIE cooling curve
-          calculated using Cloudy. */
-__device__ Real CIE_cool(Real n, Real T)
-{
-  Real lambda = 0.0;  // cooling rate, erg s^-1 cm^3
-  Real cool   = 0.0;  // cooling per unit volume, erg /s / cm^3
-
-  // fit to CIE cooling function
-  if (log10(T) < 4.0) {
-    lambda = 0.0;
-  } else if (log10(T) >= 4.0 && log10(T) < 5.9) {
-    lambda = pow(10.0, (-1.3 * (log10(T) - 5.25) * (log10(T) - 5.25) - 21.25));
-  } else if (log10(T) >= 5.9 && log10(T) < 7.4) {
-    lambda = pow(10.0, (0.7 * (log10(T) - 7.1) * (log10(T) - 7.1) - 22.8));
-  } else {
-    lambda = pow(10.0, (0.45 * log10(T) - 26.065));
-  }
-
-  // cooling rate per unit volume
-  cool = n * n * lambda;
-
-  return cool;
-}
-
-  #ifdef CLOUDY_COOL
-/* \fn __device__ Real Cloudy_cool(Real n, Real T, cudaTextureObject_t
- coolTexObj, cudaTextureObject_t heatTexObj)
- * \brief Uses texture mapping to interpolate Cloudy cooling/heating
-          tables at z = 0 with solar metallicity and an HM05 UV background. */
-__device__ Real Cloudy_cool(Real n, Real T, cudaTextureObject_t coolTexObj, cudaTextureObject_t heatTexObj)
-{
-  Real lambda = 0.0;  // cooling rate, erg s^-1 cm^3
-  Real H      = 0.0;  // heating rate, erg s^-1 cm^3
-  Real cool   = 0.0;  // cooling per unit volume, erg /s / cm^3
-  float log_n, log_T;
-  log_n = log10(n);
-  log_T = log10(T);
-
-  // remap coordinates for texture
-  // remapped = (input - TABLE_MIN_VALUE)*(1/TABLE_SPACING)
-  // remapped = (input - TABLE_MIN_VALUE)*(NUM_CELLS_PER_DECADE)
-  log_T = (log_T - 1.0) * 10;
-  log_n = (log_n + 6.0) * 10;
-
-  // Note: although the cloudy table columns are n,T,L,H , T is the fastest
-  // variable so it is treated as "x" This is why the Texture calls are T first,
-  // then n: Bilinear_Texture(tex, log_T, log_n)
-
-  // don't cool below 10 K
-  if (log10(T) > 1.0) {
-    lambda = Bilinear_Texture(coolTexObj, log_T, log_n);
-  } else
-    lambda = 0.0;
-  H = Bilinear_Texture(heatTexObj, log_T, log_n);
-
-  // cooling rate per unit volume
-  cool = n * n * (powf(10, lambda) - powf(10, H));
-  // printf("DEBUG Cloudy L350: %.17e\n",cool);
-  return cool;
-}
-  #endif  // CLOUDY_COOL
-
 #endif  // COOLING_GPU
@@ -9,8 +9,21 @@
   #include "../global/global.h"
   #include "../utils/gpu.hpp"
 
-extern cudaTextureObject_t coolTexObj;
-extern cudaTextureObject_t heatTexObj;
+  #ifdef CLOUDY_COOL_TABLE
+// With CLOUDY_COOL_TABLE the Cloudy tables are plain device arrays in Real
+// precision, interpolated with Bilinear_Table instead of float textures
+typedef const Real *CloudyTable;
+  #else
+typedef cudaTextureObject_t CloudyTable;
+  #endif  // CLOUDY_COOL_TABLE
+
+// Sizes of the Cloudy tables, log T is the fastest index. Both axes have 10
+// points per decade, starting from log T = 1 and log n = -6
+  #define CLOUDY_TABLE_NT 81
+  #define CLOUDY_TABLE_NN 121
+
+extern CloudyTable coolTexObj;
+extern CloudyTable heatTexObj;
 
 /*! \fn void Cooling_Update(Real *dev_conserved, int nx, int ny, int nz, int
  n_ghost, int n_fields, Real dt, Real gamma)
@@ -25,7 +38,7 @@ void Cooling_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, in
  the value of the total energy for each cell according to the specified cooling
  function. */
 __global__ void cooling_kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
-                               Real gamma, cudaTextureObject_t coolTexObj, cudaTextureObject_t heatTexObj);
+                               Real gamma, CloudyTable coolTexObj, CloudyTable heatTexObj);
 
 /* \fn __device__ Real test_cool(Real n, Real T)
  * \brief Cooling function from Creasey 2011. */
@@ -36,15 +49,6 @@ __device__ Real test_cool(int tid, Real n, Real T);
           derived according to Katz et al. 1996. */
 __device__ Real primordial_cool(Real n, Real T);
 
-/* \fn __device__ Real CIE_cool(Real n, Real T)
- * \brief Analytic fit to a solar metallicity CIE cooling curve
-          calculated using Cloudy. */
-__device__ Real CIE_cool(Real n, Real T);
-
-/* \fn __device__ Real Cloudy_cool(Real n, Real T, cudaTextureObject_t
- coolTexObj, cudaTextureObject_t heatTexObj)
- * \brief Uses texture mapping to interpolate Cloudy cooling/heating
-          tables at z = 0 with solar metallicity and an HM05 UV background. */
-__device__ Real Cloudy_cool(Real n, Real T, cudaTextureObject_t coolTexObj, cudaTextureObject_t heatTexObj);
+// CIE_cool, Cloudy_cool and Cool_Cell are defined in cooling_cell.h
 
 #endif  // COOLING_GPU
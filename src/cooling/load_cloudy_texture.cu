@@ -5,6 +5,7 @@
 
   #include <stdio.h>
   #include <stdlib.h>
+  #include <string.h>
 
   #include "../cooling/cooling_cuda.h"
   #include "../cooling/load_cloudy_texture.h"
@@ -12,16 +13,25 @@
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../io/io.h"  // provides chprintf
-
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
+
+    #ifdef CLOUDY_COOL_TABLE
+Real *dev_cool_table;
+Real *dev_heat_table;
+    #else
 cudaArray *cuCoolArray;
 cudaArray *cuHeatArray;
+    #endif  // CLOUDY_COOL_TABLE
 
 void Test_Cloudy_Textures();
 void Test_Cloudy_Speed();
 
-/* \fn void Host_Read_Cooling_Tables(float* cooling_table, float* heating_table)
- * \brief Load the Cloudy cooling tables into host (CPU) memory. */
-void Host_Read_Cooling_Tables(float *cooling_table, float *heating_table)
+/* \fn void Host_Parse_Cooling_Tables(T* cooling_table, T* heating_table)
+ * \brief Parse the Cloudy cooling text file into host (CPU) memory. */
+template <typename T>
+void Host_Parse_Cooling_Tables(T *cooling_table, T *heating_table)
 {
   double *n_arr;
   double *T_arr;
@@ -87,8 +97,8 @@ void Host_Read_Cooling_Tables(float *cooling_table, float *heating_table)
 
   // copy data from cooling array into the table
   for (i = 0; i < nx * ny; i++) {
-    cooling_table[i] = float(L_arr[i]);
-    heating_table[i] = float(H_arr[i]);
+    cooling_table[i] = T(L_arr[i]);
+    heating_table[i] = T(H_arr[i]);
   }
 
   // Free arrays used to read in table data
@@ -98,10 +108,48 @@ void Host_Read_Cooling_Tables(float *cooling_table, float *heating_table)
   free(H_arr);
 }
 
+/* \fn void Host_Read_Cooling_Tables(T* cooling_table, T* heating_table)
+ * \brief Load the Cloudy cooling tables into host (CPU) memory. With MPI only
+ * rank 0 parses the text file and broadcasts the binary tables. */
+template <typename T>
+void Host_Read_Cooling_Tables(T *cooling_table, T *heating_table)
+{
+    #ifdef MPI_CHOLLA
+  if (procID == 0) {
+    Host_Parse_Cooling_Tables(cooling_table, heating_table);
+  }
+  size_t const n_bytes = CLOUDY_TABLE_NT * CLOUDY_TABLE_NN * sizeof(T);
+  Broadcast_Bytes(cooling_table, n_bytes);
+  Broadcast_Bytes(heating_table, n_bytes);
+    #else
+  Host_Parse_Cooling_Tables(cooling_table, heating_table);
+    #endif  // MPI_CHOLLA
+}
+
 /* \fn void Load_Cuda_Textures()
  * \brief Load the Cloudy cooling tables into texture memory on the GPU. */
 void Load_Cuda_Textures()
 {
+    #ifdef CLOUDY_COOL_TABLE
+  Real *cooling_table;
+  Real *heating_table;
+  size_t const n_table = CLOUDY_TABLE_NT * CLOUDY_TABLE_NN;
+  GPU_Error_Check(cudaHostAlloc(&cooling_table, n_table * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&heating_table, n_table * sizeof(Real), cudaHostAllocDefault));
+  Host_Read_Cooling_Tables(cooling_table, heating_table);
+
+  // The tables are read through the regular cache hierarchy, they are too large
+  // for constant memory
+  GPU_Error_Check(cudaMalloc(&dev_cool_table, n_table * sizeof(Real)));
+  GPU_Error_Check(cudaMalloc(&dev_heat_table, n_table * sizeof(Real)));
+  GPU_Error_Check(cudaMemcpy(dev_cool_table, cooling_table, n_table * sizeof(Real), cudaMemcpyHostToDevice));
+  GPU_Error_Check(cudaMemcpy(dev_heat_table, heating_table, n_table * sizeof(Real), cudaMemcpyHostToDevice));
+  coolTexObj = dev_cool_table;
+  heatTexObj = dev_heat_table;
+
+  GPU_Error_Check(cudaFreeHost(cooling_table));
+  GPU_Error_Check(cudaFreeHost(heating_table));
+    #else
   float *cooling_table;
   float *heating_table;
   const int nx = 81;
@@ -165,6 +213,7 @@ void Load_Cuda_Textures()
   // Free the memory associated with the cooling tables on the host
   GPU_Error_Check(cudaFreeHost(cooling_table));
   GPU_Error_Check(cudaFreeHost(heating_table));
+    #endif  // CLOUDY_COOL_TABLE
 
   // Run Test
   // Test_Cloudy_Textures();
@@ -173,6 +222,12 @@ void Load_Cuda_Textures()
 
 void Free_Cuda_Textures()
 {
+    #ifdef CLOUDY_COOL_TABLE
+  GPU_Error_Check(cudaFree(dev_cool_table));
+  GPU_Error_Check(cudaFree(dev_heat_table));
+  coolTexObj = nullptr;
+  heatTexObj = nullptr;
+    #else
   // unbind the cuda textures
   cudaDestroyTextureObject(coolTexObj);
   cudaDestroyTextureObject(heatTexObj);
@@ -180,12 +235,12 @@ void Free_Cuda_Textures()
   // Free the device memory associated with the cuda arrays
   cudaFreeArray(cuCoolArray);
   cudaFreeArray(cuHeatArray);
+    #endif  // CLOUDY_COOL_TABLE
 }
 
 /* Consider this function only to be used at the end of Load_Cuda_Textures when
  * testing Evaluate texture on grid of size num_n num_T for variables n,T */
-__global__ void Test_Cloudy_Textures_Kernel(int num_n, int num_T, cudaTextureObject_t coolTexObj,
-                                            cudaTextureObject_t heatTexObj)
+__global__ void Test_Cloudy_Textures_Kernel(int num_n, int num_T, CloudyTable coolTexObj, CloudyTable heatTexObj)
 {
   int id, id_n, id_T;
   id = threadIdx.x + blockIdx.x * blockDim.x;
@@ -208,8 +263,13 @@ __global__ void Test_Cloudy_Textures_Kernel(int num_n, int num_T, cudaTextureObj
   float rlog_n = (log_n + 6.0) * 10;
 
   // Evaluate
+    #ifdef CLOUDY_COOL_TABLE
+  Real lambda = Bilinear_Table(coolTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, rlog_T, rlog_n);
+  Real heat   = Bilinear_Table(heatTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, rlog_T, rlog_n);
+    #else
   float lambda = Bilinear_Texture(coolTexObj, rlog_T, rlog_n);  // tex2D<float>(coolTexObj, rlog_T, rlog_n);
   float heat   = Bilinear_Texture(heatTexObj, rlog_T, rlog_n);  // tex2D<float>(heatTexObj, rlog_T, rlog_n);
+    #endif  // CLOUDY_COOL_TABLE
 
   // Hackfully print it out for processing for correctness
   printf("TEST_Cloudy: %.17e %.17e %.17e %.17e \n", log_T, log_n, lambda, heat);
@@ -217,8 +277,7 @@ __global__ void Test_Cloudy_Textures_Kernel(int num_n, int num_T, cudaTextureObj
 
 /* Consider this function only to be used at the end of Load_Cuda_Textures when
  * testing Evaluate texture on grid of size num_n num_T for variables n,T */
-__global__ void Test_Cloudy_Speed_Kernel(int num_n, int num_T, cudaTextureObject_t coolTexObj,
-                                         cudaTextureObject_t heatTexObj)
+__global__ void Test_Cloudy_Speed_Kernel(int num_n, int num_T, CloudyTable coolTexObj, CloudyTable heatTexObj)
 {
   int id, id_n, id_T;
   id = threadIdx.x + blockIdx.x * blockDim.x;
@@ -243,8 +302,13 @@ __global__ void Test_Cloudy_Speed_Kernel(int num_n, int num_T, cudaTextureObject
   float rlog_n = (id_n - 1) * 0.0125;
 
   // Evaluate
+    #ifdef CLOUDY_COOL_TABLE
+  Real lambda = Bilinear_Table(coolTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, rlog_T, rlog_n);
+  Real heat   = Bilinear_Table(heatTexObj, CLOUDY_TABLE_NT, CLOUDY_TABLE_NN, rlog_T, rlog_n);
+    #else
   float lambda = Bilinear_Texture(coolTexObj, rlog_T, rlog_n);  // tex2D<float>(coolTexObj, rlog_T, rlog_n);
   float heat   = Bilinear_Texture(heatTexObj, rlog_T, rlog_n);  // tex2D<float>(heatTexObj, rlog_T, rlog_n);
+    #endif  // CLOUDY_COOL_TABLE
 
   // Hackfully print it out for processing for correctness
   // printf("TEST_Cloudy: %.17e %.17e %.17e %.17e \n",log_T, log_n, lambda,
@@ -278,7 +342,11 @@ void Test_Cloudy_Speed()
   }
   GPU_Error_Check(cudaDeviceSynchronize());
   Real time_end = Get_Time();
-  printf(" Cloudy Test Time %9.4f micro-s \n", (time_end - time_start));
+    #ifdef CLOUDY_COOL_TABLE
+  printf(" Cloudy Test Time (tables) %9.4f micro-s \n", (time_end - time_start));
+    #else
+  printf(" Cloudy Test Time (textures) %9.4f micro-s \n", (time_end - time_start));
+    #endif  // CLOUDY_COOL_TABLE
   printf("Exiting due to Test_Cloudy_Speed() being called \n");
   exit(0);
 }
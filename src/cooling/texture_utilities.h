@@ -39,3 +39,31 @@ inline __device__ float Bilinear_Texture(cudaTextureObject_t tex, float x, float
   // The outer lerp interpolates along y
   return lerp(lerp(t00, t10, fx), lerp(t01, t11, fx), fy);
 }
+
+/* \fn Real Bilinear_Table(const Real *table, int nx, int ny, Real x, Real y)
+   \brief Access the values of the nx by ny table, with x the fastest index, at
+   coordinates (x,y) using bilinear interpolation. Out of bounds coordinates are
+   clamped to the edges like the texture fetches of Bilinear_Texture
+*/
+inline __device__ Real Bilinear_Table(const Real *__restrict__ table, int nx, int ny, Real x, Real y)
+{
+  // Split coordinates into integer px/py and fractional fx/fy parts
+  Real const px = floor(x);
+  Real const py = floor(y);
+  Real const fx = x - px;
+  Real const fy = y - py;
+
+  int const i0 = min(max(int(px), 0), nx - 1);
+  int const i1 = min(max(int(px) + 1, 0), nx - 1);
+  int const j0 = min(max(int(py), 0), ny - 1) * nx;
+  int const j1 = min(max(int(py) + 1, 0), ny - 1) * nx;
+
+  Real const t00 = table[i0 + j0];
+  Real const t01 = table[i0 + j1];
+  Real const t10 = table[i1 + j0];
+  Real const t11 = table[i1 + j1];
+  // Interpolate along x, then along y
+  Real const t0 = t00 + fx * (t10 - t00);
+  Real const t1 = t01 + fx * (t11 - t01);
+  return t0 + fy * (t1 - t0);
+}
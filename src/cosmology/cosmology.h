@@ -27,6 +27,13 @@ class Cosmology
   Real max_delta_a;
   Real delta_a;
 
+  // The factors of the particles KDK step from current_a to current_a +
+  // delta_a, the kicks of the two half steps and the drift of the whole step.
+  // They are set once per step by Set_Particles_Step_Factors
+  Real kick_factor_1;
+  Real kick_factor_2;
+  Real drift_factor;
+
   Real r_0_dm;
   Real t_0_dm;
   Real v_0_dm;
@@ -66,6 +73,10 @@ class Cosmology
 
   Real Get_da_from_dt(Real dt);
   Real Get_dt_from_da(Real da);
+
+  Real Get_Time_Interval(Real a_start, Real a_end);
+  void Get_Particles_Step_Factors(Real a_start, Real a_end, Real &kick_1, Real &kick_2, Real &drift);
+  void Set_Particles_Step_Factors();
 };
 
   #endif
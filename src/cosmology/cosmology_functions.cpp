@@ -42,6 +42,51 @@ Real Cosmology::Get_Hubble_Parameter(Real a)
   return H0 * sqrt(factor);
 }
 
+// Integrate f(a) from a_start to a_end with the 5 point Gauss-Legendre rule.
+// The integrands of the expansion are smooth over a step, where the rule is
+// exact to round-off
+template <typename Integrand>
+static Real Integrate_Scale_Factor(Integrand f, Real a_start, Real a_end)
+{
+  Real const nodes[5]   = {0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640};
+  Real const weights[5] = {0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891,
+                           0.2369268850561891};
+  Real const center     = (a_start + a_end) / 2;
+  Real const half_width = (a_end - a_start) / 2;
+  Real sum              = 0;
+  for (int i = 0; i < 5; i++) {
+    sum += weights[i] * f(center + half_width * nodes[i]);
+  }
+  return sum * half_width;
+}
+
+// The time elapsed while the scale factor grows from a_start to a_end, the
+// exact version of Get_dt_from_da
+Real Cosmology::Get_Time_Interval(Real a_start, Real a_end)
+{
+  return Integrate_Scale_Factor([this](Real a) { return 1 / (a * Get_Hubble_Parameter(a)); }, a_start, a_end);
+}
+
+// Integrate the kicks and the drift of the particles over a step from a_start
+// to a_end. The comoving momentum a * v is kicked by the time integral of the
+// gravity, and the positions drift by the integral of a * v / a^2 over time
+void Cosmology::Get_Particles_Step_Factors(Real a_start, Real a_end, Real &kick_1, Real &kick_2, Real &drift)
+{
+  Real const a_half = (a_start + a_end) / 2;
+
+  kick_1 = Get_Time_Interval(a_start, a_half) * cosmo_h;
+  kick_2 = Get_Time_Interval(a_half, a_end) * cosmo_h;
+  drift  = Integrate_Scale_Factor([this](Real a) { return 1 / (a * a * a * Get_Hubble_Parameter(a)); },
+                                  a_start, a_end) *
+          cosmo_h * a_half;
+}
+
+// The factors of the whole step delta_a
+void Cosmology::Set_Particles_Step_Factors()
+{
+  Get_Particles_Step_Factors(current_a, current_a + delta_a, kick_factor_1, kick_factor_2, drift_factor);
+}
+
 void Grid3D::Change_Cosmological_Frame_Sytem(bool forward)
 {
   if (forward) {
@@ -124,6 +169,9 @@ void Grid3D::Change_GAS_Frame_System(bool forward)
         C.HeII_density[id] *= dens_factor;
         C.HeIII_density[id] *= dens_factor;
         C.e_density[id] *= dens_factor;
+    #ifdef GRACKLE_METALS
+        C.metal_density[id] *= dens_factor;
+    #endif
   #endif
       }
     }
@@ -55,11 +55,14 @@ void Cosmology::Set_Scale_Outputs(struct Parameters *P)
   if (P->scale_outputs_file[0] == '\0') {
     chprintf(" Output every %d timesteps.\n", P->n_steps_output);
     Real scale_end = 1 / (P->End_redshift + 1);
-    scale_outputs.push_back(current_a);
+    // The benchmarks don't write the initial conditions
+    if (P->benchmark_steps == 0) {
+      scale_outputs.push_back(current_a);
+    }
     scale_outputs.push_back(scale_end);
     n_outputs        = scale_outputs.size();
     next_output_indx = 0;
-    next_output      = current_a;
+    next_output      = scale_outputs[0];
     chprintf("  Next output index: %d  \n", next_output_indx);
     chprintf("  Next output z value: %f  \n", 1. / next_output - 1);
   } else {
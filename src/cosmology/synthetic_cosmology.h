@@ -0,0 +1,108 @@
+/*! \file synthetic_cosmology.h
+ *  \brief A synthetic cosmological initial condition that is evaluated on the
+ *  device, for the benchmarks of any size without initial condition files. The
+ *  displacement field is a sum of a few sine modes along each axis, and the
+ *  dark matter particles and the gas follow it in the Zeldovich approximation.
+ *  The fields are in the units of the Read_Grid files: kpc/h, km/s and
+ *  h^2 Msun/kpc^3. */
+
+#pragma once
+
+#ifdef COSMOLOGY
+
+  #include <math.h>
+
+  #include "../global/global.h"
+  #include "../utils/gpu.hpp"
+
+namespace synthetic_cosmology
+{
+// The fundamental mode of the box and its first 2 octaves along each axis
+constexpr int n_modes = 9;
+
+// The linear overdensity of every mode at the initial redshift
+constexpr Real mode_delta = 0.02;
+
+// The temperature of the gas, in K
+constexpr Real gas_temperature = 100;
+
+/*!
+ * \brief The displacement field of the initial conditions and the peculiar
+ * velocity of a displacement
+ */
+struct Field {
+  // The lower bounds and the sizes of the periodic box
+  Real xbound, ybound, zbound;
+  Real xlen, ylen, zlen;
+  // The peculiar velocity of a unit displacement, a H(a) f(a) / h
+  Real vel_factor;
+
+  /*! \brief The wavenumber of a mode, along the axis mode % 3 */
+  __host__ __device__ Real Mode_Wavenumber(int mode) const
+  {
+    Real const length = (mode % 3 == 0) ? xlen : (mode % 3 == 1) ? ylen : zlen;
+    return 2 * M_PI * (1 << (mode / 3)) / length;
+  }
+
+  /*! \brief The displacement of the particle that starts at (x, y, z) */
+  __host__ __device__ void Displacement(Real x, Real y, Real z, Real &psi_x, Real &psi_y, Real &psi_z) const
+  {
+    Real psi[3]     = {0, 0, 0};
+    Real const q[3] = {x - xbound, y - ybound, z - zbound};
+    for (int mode = 0; mode < n_modes; mode++) {
+      Real const k = Mode_Wavenumber(mode);
+      psi[mode % 3] += mode_delta / k * sin(k * q[mode % 3] + 0.5 * mode);
+    }
+    psi_x = psi[0];
+    psi_y = psi[1];
+    psi_z = psi[2];
+  }
+
+  /*! \brief The linear overdensity at (x, y, z), minus the divergence of the
+   * displacement */
+  __host__ __device__ Real Overdensity(Real x, Real y, Real z) const
+  {
+    Real const q[3] = {x - xbound, y - ybound, z - zbound};
+    Real delta      = 0;
+    for (int mode = 0; mode < n_modes; mode++) {
+      delta -= mode_delta * cos(Mode_Wavenumber(mode) * q[mode % 3] + 0.5 * mode);
+    }
+    return delta;
+  }
+};
+
+/*!
+ * \brief The largest displacement along an axis of the given length, the sum
+ * of the amplitudes of its 3 modes
+ */
+inline Real Max_Displacement(Real length) { return mode_delta * length / (2 * M_PI) * (1 + 0.5 + 0.25); }
+
+/*!
+ * \brief The displacement field of the box and the cosmology of the
+ * parameters at Init_redshift. The growth rate is f = Omega_M(a)^0.55
+ */
+inline Field Make_Field(Parameters const &P)
+{
+  Real const a       = 1 / (P.Init_redshift + 1);
+  Real const cosmo_h = P.H0 / 100;
+  Real const Omega_K = 1 - (P.Omega_M + P.Omega_L);
+  Real const E2      = P.Omega_M / (a * a * a) + Omega_K / (a * a) + P.Omega_L;
+  Real const H       = P.H0 / 1000 * sqrt(E2);  // km/s / kpc
+  Real const f       = pow(P.Omega_M / (a * a * a) / E2, 0.55);
+  return Field{P.xmin, P.ymin, P.zmin, P.xlen, P.ylen, P.zlen, a * H * f / cosmo_h};
+}
+
+/*!
+ * \brief The mean comoving density of a component with the density parameter
+ * Omega, in h^2 Msun/kpc^3 like Cosmology::rho_0_gas
+ */
+inline Real Mean_Density(Parameters const &P, Real Omega)
+{
+  Real const H0      = P.H0 / 1000;
+  Real const cosmo_h = P.H0 / 100;
+  Real const G       = G_COSMO;
+  return 3 * H0 * H0 / (8 * M_PI * G) * Omega / cosmo_h / cosmo_h;
+}
+}  // namespace synthetic_cosmology
+
+#endif  // COSMOLOGY
@@ -51,86 +51,9 @@ __global__ void Dust_Kernel(Real *dev_conserved, int nx, int ny, int nz, int n_g
   int id_y    = (id - id_z * nx * ny) / nx;
   int id_x    = id - id_z * nx * ny - id_y * nx;
 
-  // define physics variables
-  Real density_gas, density_dust;  // fluid mass densities
-  Real number_density;             // gas number density
-  Real mu = 0.6;                   // mean molecular weight
-
-  // define integration variables
-  Real dd_dt;          // instantaneous rate of change in dust density
-  Real dd;             // change in dust density at current timestep
-  Real dd_max = 0.01;  // allowable percentage of dust density increase
-  Real dt_sub;         // refined timestep
-
   if (id_x >= is && id_x < ie && id_y >= js && id_y < je && id_z >= ks && id_z < ke) {
-    // get conserved quanitites
-    density_gas  = dev_conserved[id + n_cells * grid_enum::density];
-    density_dust = dev_conserved[id + n_cells * grid_enum::dust_density];
-
-    // convert mass density to number density
-    number_density = density_gas * DENSITY_UNIT / (mu * MP);
-
-    // Compute the temperature
-  #ifdef DE
-    Real const gas_energy  = dev_conserved[id + n_cells * grid_enum::GasEnergy];
-    Real const temperature = hydro_utilities::Calc_Temp_DE(gas_energy, gamma, number_density);
-  #else  // DE is not enabled
-    Real const energy     = dev_conserved[id + n_cells * grid_enum::Energy];
-    Real const momentum_x = dev_conserved[id + n_cells * grid_enum::momentum_x];
-    Real const momentum_y = dev_conserved[id + n_cells * grid_enum::momentum_y];
-    Real const momentum_z = dev_conserved[id + n_cells * grid_enum::momentum_z];
-
-    #ifdef MHD
-    auto const [magnetic_x, magnetic_y, magnetic_z] =
-        mhd::utils::cellCenteredMagneticFields(C.host, id, xid, yid, zid, H.n_cells, H.nx, H.ny);
-    Real const temperature =
-        hydro_utilities::Calc_Temp_Conserved(energy, density_gas, momentum_x, momentum_y, momentum_z, gamma,
-                                             number_density, magnetic_x, magnetic_y, magnetic_z);
-    #else   // MHD is not defined
-    Real const temperature = hydro_utilities::Calc_Temp_Conserved(energy, density_gas, momentum_x, momentum_y,
-                                                                  momentum_z, gamma, number_density);
-    #endif  // MHD
-  #endif    // DE
-
-    Real tau_sp = Calc_Sputtering_Timescale(number_density, temperature, grain_radius) /
-                  TIME_UNIT;  // sputtering timescale, kyr (sim units)
-
-    dd_dt = Calc_dd_dt(density_dust, tau_sp);  // rate of change in dust density at current timestep
-    dd    = dd_dt * dt;                        // change in dust density at current timestep
-
-    // ensure that dust density is not changing too rapidly
-    while (dd / density_dust > dd_max) {
-      dt_sub = dd_max * density_dust / dd_dt;
-      density_dust += dt_sub * dd_dt;
-      dt -= dt_sub;
-      dd_dt = Calc_dd_dt(density_dust, tau_sp);
-      dd    = dt * dd_dt;
-    }
-
-    // update dust density
-    density_dust += dd;
-
-    dev_conserved[id + n_cells * grid_enum::dust_density] = density_dust;
+    Dust_Cell(dev_conserved, id, id_x, id_y, id_z, nx, ny, n_cells, dt, gamma, grain_radius);
   }
 }
 
-// McKinnon et al. (2017) sputtering timescale
-__device__ __host__ Real Calc_Sputtering_Timescale(Real number_density, Real temperature, Real grain_radius)
-{
-  Real a             = grain_radius;  // dust grain size in units of 0.1 micrometers
-  Real temperature_0 = 2e6;           // temp above which the sputtering rate is ~constant in K
-  Real omega         = 2.5;           // controls the low-temperature scaling of the sputtering rate
-  Real A             = 5.3618e15;     // 0.17 Gyr in s
-
-  number_density /= (6e-4);  // gas number density in units of 10^-27 g/cm^3
-
-  // sputtering timescale, s
-  Real tau_sp = A * (a / number_density) * (pow(temperature_0 / temperature, omega) + 1);
-
-  return tau_sp;
-}
-
-// McKinnon et al. (2017) sputtering model
-__device__ __host__ Real Calc_dd_dt(Real density_dust, Real tau_sp) { return -density_dust / (tau_sp / 3); }
-
 #endif  // DUST
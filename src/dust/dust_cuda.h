@@ -13,7 +13,12 @@
     #include <math.h>
 
     #include "../global/global.h"
+    #include "../grid/grid_enum.h"
     #include "../utils/gpu.hpp"
+    #include "../utils/hydro_utilities.h"
+    #ifdef MHD
+      #include "../utils/mhd_utilities.h"
+    #endif  // MHD
 
 /*!
  * \brief Launch the dust kernel.
@@ -54,7 +59,20 @@ __global__ void Dust_Kernel(Real *dev_conserved, int nx, int ny, int nz, int n_g
  *
  * \return Real Sputtering timescale in seconds (McKinnon et al. 2017)
  */
-__device__ __host__ Real Calc_Sputtering_Timescale(Real number_density, Real temperature, Real grain_radius);
+inline __device__ __host__ Real Calc_Sputtering_Timescale(Real number_density, Real temperature, Real grain_radius)
+{
+  Real a             = grain_radius;  // dust grain size in units of 0.1 micrometers
+  Real temperature_0 = 2e6;           // temp above which the sputtering rate is ~constant in K
+  Real omega         = 2.5;           // controls the low-temperature scaling of the sputtering rate
+  Real A             = 5.3618e15;     // 0.17 Gyr in s
+
+  number_density /= (6e-4);  // gas number density in units of 10^-27 g/cm^3
+
+  // sputtering timescale, s
+  Real tau_sp = A * (a / number_density) * (pow(temperature_0 / temperature, omega) + 1);
+
+  return tau_sp;
+}
 
 /*!
  * \brief Compute the rate of change in dust density based on the current dust density and sputtering timescale.
@@ -64,7 +82,87 @@ __device__ __host__ Real Calc_Sputtering_Timescale(Real number_density, Real tem
  *
  * \return Real Dust density rate of change (McKinnon et al. 2017)
  */
-__device__ __host__ Real Calc_dd_dt(Real density_dust, Real tau_sp);
+inline __device__ __host__ Real Calc_dd_dt(Real density_dust, Real tau_sp) { return -density_dust / (tau_sp / 3); }
+
+/*!
+ * \brief Compute the change in dust density of the real cell id over dt and update its value in dev_conserved. This is
+ * the work of Dust_Kernel for a single cell, so the source term kernel can apply it after the cooling of the cell.
+ *
+ * \param[in,out] dev_conserved The device conserved variable array. The dust field is updated in this function.
+ * \param[in] id The 1D index of the cell
+ * \param[in] xid The x index of the cell
+ * \param[in] yid The y index of the cell
+ * \param[in] zid The z index of the cell
+ * \param[in] nx Number of cells in the x-direction
+ * \param[in] ny Number of cells in the y-direction
+ * \param[in] n_cells Total number of cells
+ * \param[in] dt Simulation timestep
+ * \param[in] gamma Specific heat ratio
+ * \param[in] grain_radius Dust grain radius in units of 0.1 micrometers
+ */
+inline __device__ void Dust_Cell(Real *dev_conserved, int id, int xid, int yid, int zid, int nx, int ny, int n_cells,
+                                 Real dt, Real gamma, Real grain_radius)
+{
+  // define physics variables
+  Real density_gas, density_dust;  // fluid mass densities
+  Real number_density;             // gas number density
+  Real mu = 0.6;                   // mean molecular weight
+
+  // define integration variables
+  Real dd_dt;          // instantaneous rate of change in dust density
+  Real dd;             // change in dust density at current timestep
+  Real dd_max = 0.01;  // allowable percentage of dust density increase
+  Real dt_sub;         // refined timestep
+
+  // get conserved quanitites
+  density_gas  = dev_conserved[id + n_cells * grid_enum::density];
+  density_dust = dev_conserved[id + n_cells * grid_enum::dust_density];
+
+  // convert mass density to number density
+  number_density = density_gas * DENSITY_UNIT / (mu * MP);
+
+  // Compute the temperature
+    #ifdef DE
+  Real const gas_energy  = dev_conserved[id + n_cells * grid_enum::GasEnergy];
+  Real const temperature = hydro_utilities::Calc_Temp_DE(gas_energy, gamma, number_density);
+    #else  // DE is not enabled
+  Real const energy     = dev_conserved[id + n_cells * grid_enum::Energy];
+  Real const momentum_x = dev_conserved[id + n_cells * grid_enum::momentum_x];
+  Real const momentum_y = dev_conserved[id + n_cells * grid_enum::momentum_y];
+  Real const momentum_z = dev_conserved[id + n_cells * grid_enum::momentum_z];
+
+      #ifdef MHD
+  auto const [magnetic_x, magnetic_y, magnetic_z] =
+      mhd::utils::cellCenteredMagneticFields(dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+  Real const temperature =
+      hydro_utilities::Calc_Temp_Conserved(energy, density_gas, momentum_x, momentum_y, momentum_z, gamma,
+                                           number_density, magnetic_x, magnetic_y, magnetic_z);
+      #else   // MHD is not defined
+  Real const temperature = hydro_utilities::Calc_Temp_Conserved(energy, density_gas, momentum_x, momentum_y,
+                                                                momentum_z, gamma, number_density);
+      #endif  // MHD
+    #endif    // DE
+
+  Real tau_sp = Calc_Sputtering_Timescale(number_density, temperature, grain_radius) /
+                TIME_UNIT;  // sputtering timescale, kyr (sim units)
+
+  dd_dt = Calc_dd_dt(density_dust, tau_sp);  // rate of change in dust density at current timestep
+  dd    = dd_dt * dt;                        // change in dust density at current timestep
+
+  // ensure that dust density is not changing too rapidly
+  while (dd / density_dust > dd_max) {
+    dt_sub = dd_max * density_dust / dd_dt;
+    density_dust += dt_sub * dd_dt;
+    dt -= dt_sub;
+    dd_dt = Calc_dd_dt(density_dust, tau_sp);
+    dd    = dt * dd_dt;
+  }
+
+  // update dust density
+  density_dust += dd;
+
+  dev_conserved[id + n_cells * grid_enum::dust_density] = density_dust;
+}
 
   #endif  // DUST_CUDA_H
 #endif    // DUST
\ No newline at end of file
@@ -121,6 +121,7 @@ int Is_Param_Valid(const char *param_name)
 }
 
 void Parse_Param(char *name, char *value, struct Parameters *parms);
+void Parse_Command_Line_Params(struct Parameters *parms, int argc, char **argv);
 
 /*! \fn void Parse_Params(char *param_file, struct Parameters * parms);
  *  \brief Reads the parameters in the given file into a structure. */
@@ -167,7 +168,15 @@ void Parse_Params(char *param_file, struct Parameters *parms, int argc, char **a
   /* Close file */
   fclose(fp);
 
-  // Parse overriding args from command line
+  Parse_Command_Line_Params(parms, argc, argv);
+}
+
+/*! \fn void Parse_Command_Line_Params(struct Parameters *parms, int argc, char **argv);
+ *  \brief Parses the name=value arguments on the command line, overriding the
+ * values already in the structure. Other arguments are ignored. */
+void Parse_Command_Line_Params(struct Parameters *parms, int argc, char **argv)
+{
+  char *s;
   for (int i = 0; i < argc; ++i) {
     char name[MAXLEN], value[MAXLEN];
     s = strtok(argv[i], "=");
@@ -187,6 +196,74 @@ void Parse_Params(char *param_file, struct Parameters *parms, int argc, char **a
   }
 }
 
+void Set_Benchmark_Params(struct Parameters *parms, int argc, char **argv)
+{
+  // Every cell does the same work, so the throughput doesn't depend on the
+  // decomposition or on how long the benchmark runs
+  parms->nx      = 128;
+  parms->ny      = 128;
+  parms->nz      = 128;
+  parms->tout    = 1e30;
+  parms->outstep = 1e30;
+  parms->gamma   = 5.0 / 3.0;
+  strncpy(parms->init, "Constant", MAXLEN);
+  parms->xmin    = 0;
+  parms->ymin    = 0;
+  parms->zmin    = 0;
+  parms->xlen    = 1;
+  parms->ylen    = 1;
+  parms->zlen    = 1;
+  parms->xl_bcnd = 1;
+  parms->xu_bcnd = 1;
+  parms->yl_bcnd = 1;
+  parms->yu_bcnd = 1;
+  parms->zl_bcnd = 1;
+  parms->zu_bcnd = 1;
+
+  parms->custom_bcnd[0] = '\0';
+  parms->indir[0]       = '\0';
+  strncpy(parms->outdir, "./", MAXLEN);
+  parms->rho = 1;
+  parms->vx  = 1;
+  parms->vy  = 1;
+  parms->vz  = 1;
+  parms->P   = 1;
+
+#ifdef COSMOLOGY
+  // The cosmological builds evolve the synthetic cosmology instead, with
+  // outputs only at the end of the run
+  strncpy(parms->init, "Synthetic_Cosmology", MAXLEN);
+  parms->xlen                  = 0;
+  parms->ylen                  = 0;
+  parms->zlen                  = 0;
+  parms->H0                    = 67.74;
+  parms->Omega_M               = 0.3089;
+  parms->Omega_L               = 0.6911;
+  parms->Omega_b               = 0.0486;
+  parms->Init_redshift         = 20;
+  parms->End_redshift          = 0;
+  parms->scale_outputs_file[0] = '\0';
+#endif  // COSMOLOGY
+
+  parms->benchmark_steps = 20;
+  if (argc > 2 and isdigit(argv[2][0])) {
+    parms->benchmark_steps = atoi(argv[2]);
+  }
+
+  Parse_Command_Line_Params(parms, argc, argv);
+#ifdef COSMOLOGY
+  // Unless they are given, the sizes of the box keep the resolution of the
+  // 25 Mpc/h, 128^3 FOM initial conditions for any number of cells, so the
+  // weak scaling runs evolve the same structures per cell
+  Real const cell_length = 25000.0 / 128;
+  parms->xlen            = (parms->xlen > 0) ? parms->xlen : parms->nx * cell_length;
+  parms->ylen            = (parms->ylen > 0) ? parms->ylen : parms->ny * cell_length;
+  parms->zlen            = (parms->zlen > 0) ? parms->zlen : parms->nz * cell_length;
+#endif  // COSMOLOGY
+  CHOLLA_ASSERT(parms->benchmark_steps > 0, "The number of benchmark steps must be positive, got %d",
+                parms->benchmark_steps);
+}
+
 /*! \fn void Parse_Param(char *name,char *value, struct Parameters *parms);
  *  \brief Parses and sets a single param based on name and value. */
 void Parse_Param(char *name, char *value, struct Parameters *parms)
@@ -201,6 +278,10 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
 #ifdef STATIC_GRAV
   } else if (strcmp(name, "custom_grav") == 0) {
     parms->custom_grav = atoi(value);
+#endif
+#ifdef DISK_ICS
+  } else if (strcmp(name, "disk_columns_nr") == 0) {
+    parms->disk_columns_nr = atoi(value);
 #endif
   } else if (strcmp(name, "tout") == 0) {
     parms->tout = atof(value);
@@ -224,6 +305,10 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
     parms->n_rotated_projection = atoi(value);
   } else if (strcmp(name, "n_slice") == 0) {
     parms->n_slice = atoi(value);
+  } else if (strcmp(name, "n_power_spectrum") == 0) {
+    parms->n_power_spectrum = atoi(value);
+  } else if (strcmp(name, "n_halo_catalog") == 0) {
+    parms->n_halo_catalog = atoi(value);
   } else if (strcmp(name, "n_out_float32") == 0) {
     parms->n_out_float32 = atoi(value);
   } else if (strcmp(name, "out_float32_density") == 0) {
@@ -260,6 +345,38 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
     int tmp = atoi(value);
     CHOLLA_ASSERT((tmp == 0) or (tmp == 1), "legacy_flat_outdir must be 1 or 0.");
     parms->legacy_flat_outdir = tmp;
+  } else if (strcmp(name, "output_cat") == 0) {
+    int tmp = atoi(value);
+    CHOLLA_ASSERT((tmp == 0) or (tmp == 1), "output_cat must be 1 or 0.");
+    parms->output_cat = tmp;
+  } else if (strcmp(name, "output_cat_aggregators") == 0) {
+    parms->output_cat_aggregators = atoi(value);
+  } else if (strcmp(name, "output_cat_chunk") == 0) {
+    parms->output_cat_chunk = atoi(value);
+  } else if (strcmp(name, "output_cat_particles_float32") == 0) {
+    int tmp = atoi(value);
+    CHOLLA_ASSERT((tmp == 0) or (tmp == 1), "output_cat_particles_float32 must be 1 or 0.");
+    parms->output_cat_particles_float32 = tmp;
+  } else if (strcmp(name, "read_particles_cat") == 0) {
+    int tmp = atoi(value);
+    CHOLLA_ASSERT((tmp == 0) or (tmp == 1), "read_particles_cat must be 1 or 0.");
+    parms->read_particles_cat = tmp;
+  } else if (strcmp(name, "read_particles_cat_chunk") == 0) {
+    parms->read_particles_cat_chunk = atoi(value);
+    CHOLLA_ASSERT(parms->read_particles_cat_chunk > 0, "read_particles_cat_chunk must be positive.");
+  } else if (strcmp(name, "checkpoint_dir") == 0) {
+    strncpy(parms->checkpoint_dir, value, MAXLEN);
+  } else if (strcmp(name, "output_compression") == 0) {
+    strncpy(parms->output_compression, value, MAXLEN);
+  } else if (strcmp(name, "out_float32_compression") == 0) {
+    strncpy(parms->out_float32_compression, value, MAXLEN);
+  } else if (strcmp(name, "output_derived") == 0) {
+    strncpy(parms->output_derived, value, MAXLEN);
+  } else if (strcmp(name, "n_out_coarse") == 0) {
+    parms->n_out_coarse = atoi(value);
+  } else if (strcmp(name, "out_coarse_factor") == 0) {
+    parms->out_coarse_factor = atoi(value);
+    CHOLLA_ASSERT(parms->out_coarse_factor >= 2, "out_coarse_factor must be at least 2.");
   } else if (strcmp(name, "xmin") == 0) {
     parms->xmin = atof(value);
   } else if (strcmp(name, "ymin") == 0) {
@@ -373,7 +490,37 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
 #ifdef PARTICLES
   } else if (strcmp(name, "prng_seed") == 0) {
     parms->prng_seed = atoi(value);
-#endif  // PARTICLES
+  } else if (strcmp(name, "n_out_particles_subset") == 0) {
+    parms->n_out_particles_subset = atoi(value);
+  } else if (strcmp(name, "particles_subset_fraction") == 0) {
+    parms->particles_subset_fraction = atof(value);
+    CHOLLA_ASSERT(parms->particles_subset_fraction >= 0 && parms->particles_subset_fraction <= 1,
+                  "particles_subset_fraction must be between 0 and 1.");
+  } else if (strcmp(name, "particles_subset_boxes") == 0) {
+    strncpy(parms->particles_subset_boxes, value, MAXLEN);
+  #ifdef PARTICLES_GPU
+  } else if (strcmp(name, "particle_sort_interval") == 0) {
+    parms->particle_sort_interval = atoi(value);
+  #endif  // PARTICLES_GPU
+  #ifdef PARTICLES_P3M
+  } else if (strcmp(name, "p3m_cutoff") == 0) {
+    parms->p3m_cutoff = atof(value);
+  } else if (strcmp(name, "p3m_softening") == 0) {
+    parms->p3m_softening = atof(value);
+  #endif  // PARTICLES_P3M
+  #ifdef PARTICLES_BLOCK_TIMESTEPS
+  } else if (strcmp(name, "particle_time_bins") == 0) {
+    parms->particle_time_bins = atoi(value);
+  #endif  // PARTICLES_BLOCK_TIMESTEPS
+  #ifdef HALO_FINDER
+  } else if (strcmp(name, "fof_linking_length") == 0) {
+    parms->fof_linking_length = atof(value);
+  } else if (strcmp(name, "fof_min_members") == 0) {
+    parms->fof_min_members = atoi(value);
+  } else if (strcmp(name, "fof_output_members") == 0) {
+    parms->fof_output_members = atoi(value);
+  #endif  // HALO_FINDER
+#endif    // PARTICLES
 #ifdef SUPERNOVA
   } else if (strcmp(name, "snr_filename") == 0) {
     strncpy(parms->snr_filename, value, MAXLEN);
@@ -399,6 +546,8 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
     parms->ddelta_dt = atof(value);
   } else if (strcmp(name, "flag_delta") == 0) {
     parms->flag_delta = atoi(value);
+  } else if (strcmp(name, "composite_rot_proj") == 0) {
+    parms->composite_rot_proj = atoi(value);
 #endif /*ROTATED_PROJECTION*/
 #ifdef COSMOLOGY
   } else if (strcmp(name, "scale_outputs_file") == 0) {
@@ -432,9 +581,25 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
 #endif
   } else if (strcmp(name, "bc_potential_type") == 0) {
     parms->bc_potential_type = atoi(value);
+  } else if (strcmp(name, "gravity_subcycle_steps") == 0) {
+    parms->gravity_subcycle_steps = atoi(value);
+  } else if (strcmp(name, "gravity_subcycle_tolerance") == 0) {
+    parms->gravity_subcycle_tolerance = atof(value);
+#ifdef PARIS
+  } else if (strcmp(name, "paris_gather_cells") == 0) {
+    parms->paris_gather_cells = atoi(value);
+#endif
+#if defined(PARIS) || defined(PARIS_GALACTIC)
+  } else if (strcmp(name, "paris_mpi_gpu") == 0) {
+    parms->paris_mpi_gpu = atoi(value);
+#endif
 #ifdef CHEMISTRY_GPU
   } else if (strcmp(name, "UVB_rates_file") == 0) {
     strncpy(parms->UVB_rates_file, value, MAXLEN);
+  #ifdef GRACKLE_METALS
+  } else if (strcmp(name, "metal_cooling_file") == 0) {
+    strncpy(parms->metal_cooling_file, value, MAXLEN);
+  #endif
 #endif
 #ifdef COOLING_GRACKLE
   } else if (strcmp(name, "UVB_rates_file") == 0) {
@@ -458,6 +623,66 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
           "parameter file.\n");
     }
 #endif
+#ifdef VL
+  } else if (strcmp(name, "n_vl_slabs") == 0) {
+    parms->n_vl_slabs = atoi(value);
+#endif  // VL
+#ifdef STATIC_REFINEMENT
+  } else if (strcmp(name, "refine_x_start") == 0) {
+    parms->refine_x_start = atoi(value);
+  } else if (strcmp(name, "refine_y_start") == 0) {
+    parms->refine_y_start = atoi(value);
+  } else if (strcmp(name, "refine_z_start") == 0) {
+    parms->refine_z_start = atoi(value);
+  } else if (strcmp(name, "refine_nx") == 0) {
+    parms->refine_nx = atoi(value);
+  } else if (strcmp(name, "refine_ny") == 0) {
+    parms->refine_ny = atoi(value);
+  } else if (strcmp(name, "refine_nz") == 0) {
+    parms->refine_nz = atoi(value);
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+  } else if (strcmp(name, "local_time_levels") == 0) {
+    parms->local_time_levels = atoi(value);
+#endif  // LOCAL_TIMESTEPS
+#ifdef MPI_CHOLLA
+  } else if (strcmp(name, "mpi_global_barrier") == 0) {
+    parms->mpi_global_barrier = atoi(value);
+  } else if (strcmp(name, "mpi_26_neighbors") == 0) {
+    parms->mpi_26_neighbors = atoi(value);
+  } else if (strcmp(name, "mpi_node_blocks") == 0) {
+    parms->mpi_node_blocks = atoi(value);
+  } else if (strcmp(name, "mpi_cart_reorder") == 0) {
+    parms->mpi_cart_reorder = atoi(value);
+  } else if (strcmp(name, "load_balance_file") == 0) {
+    strncpy(parms->load_balance_file, value, MAXLEN);
+  } else if (strcmp(name, "mpi_float_halos") == 0) {
+    parms->mpi_float_halos = atoi(value);
+  } else if (strcmp(name, "mpi_float_scalar_halos") == 0) {
+    parms->mpi_float_scalar_halos = atoi(value);
+  } else if (strcmp(name, "buddy_checkpoint_steps") == 0) {
+    parms->buddy_checkpoint_steps = atoi(value);
+#endif  // MPI_CHOLLA
+#ifdef CPU_TIME
+  } else if (strcmp(name, "perf_log") == 0) {
+    strncpy(parms->perf_log, value, MAXLEN);
+  } else if (strcmp(name, "flight_recorder_steps") == 0) {
+    parms->flight_recorder_steps = atoi(value);
+#endif  // CPU_TIME
+#ifdef LAUNCH_AUTOTUNE
+  } else if (strcmp(name, "launch_cache") == 0) {
+    strncpy(parms->launch_cache, value, MAXLEN);
+#endif  // LAUNCH_AUTOTUNE
+#ifdef RUNTIME_KERNELS
+  } else if (strcmp(name, "reconstruction") == 0) {
+    strncpy(parms->reconstruction, value, MAXLEN);
+  } else if (strcmp(name, "riemann_solver") == 0) {
+    strncpy(parms->riemann_solver, value, MAXLEN);
+#endif  // RUNTIME_KERNELS
+#ifdef LAGGED_DT
+  } else if (strcmp(name, "lagged_dt_safety") == 0) {
+    parms->lagged_dt_safety = atof(value);
+#endif  // LAGGED_DT
 #ifdef SCALAR_FLOOR
   } else if (strcmp(name, "scalar_floor") == 0) {
     parms->scalar_floor = atof(value);
@@ -476,6 +701,8 @@ void Parse_Param(char *name, char *value, struct Parameters *parms)
     parms->lya_skewers_stride = atoi(value);
   } else if (strcmp(name, "lya_Pk_d_log_k") == 0) {
     parms->lya_Pk_d_log_k = atof(value);
+  } else if (strcmp(name, "lya_skewers_stream") == 0) {
+    parms->lya_skewers_stream = atoi(value);
   #ifdef OUTPUT_SKEWERS
   } else if (strcmp(name, "skewersdir") == 0) {
     strncpy(parms->skewersdir, value, MAXLEN);
@@ -21,6 +21,33 @@ typedef double Real;
   #endif
 #endif
 
+// The type that the Riemann solvers compute in. With MIXED_PRECISION the
+// solvers run in float while the conserved variables and their update stay in
+// Real, which has to be double
+#ifdef MIXED_PRECISION
+  #if PRECISION != 2
+    #error "MIXED_PRECISION requires PRECISION=2"
+  #endif  // PRECISION != 2
+  #ifndef HLLC
+    #error "MIXED_PRECISION is only implemented for the HLLC Riemann solver"
+  #endif  // not HLLC
+typedef float Real_Solver;
+#else
+typedef Real Real_Solver;
+#endif  // MIXED_PRECISION
+
+// The type that the static analytic potential of GRAVITY_ANALYTIC_COMP is
+// stored in. With GRAVITY_ANALYTIC_FLOAT it is kept in float, halving its
+// memory and the bandwidth of adding it every step; the sum stays in Real
+#ifdef GRAVITY_ANALYTIC_FLOAT
+  #ifndef GRAVITY_ANALYTIC_COMP
+    #error "GRAVITY_ANALYTIC_FLOAT requires GRAVITY_ANALYTIC_COMP"
+  #endif  // not GRAVITY_ANALYTIC_COMP
+typedef float Real_Analytic;
+#else
+typedef Real Real_Analytic;
+#endif  // GRAVITY_ANALYTIC_FLOAT
+
 #define MAXLEN      2048
 #define TINY_NUMBER 1.0e-20
 #define MP          1.672622e-24  // mass of proton, grams
@@ -125,6 +152,32 @@ typedef long int part_int_t;
 typedef int part_int_t;
   #endif  // PARTICLES_LONG_INTS
 
+// The type of the positions and velocities of the GPU particles. With
+// PARTICLES_COMPACT they are stored in float and the positions are relative to
+// the lower bound of the local domain (Particles3D::G.pos_origin_x/y/z), which
+// keeps a float resolution of a small fraction of a cell. They are converted
+// back to Real for the output and the MPI transfers
+  #ifdef PARTICLES_COMPACT
+    #ifndef PARTICLES_GPU
+      #error "PARTICLES_COMPACT requires PARTICLES_GPU"
+    #endif  // not PARTICLES_GPU
+typedef float Real_Part;
+  #else
+typedef Real Real_Part;
+  #endif  // PARTICLES_COMPACT
+
+  #ifdef PARTICLES_P3M
+    #if !defined(PARTICLES_GPU) || defined(PARTICLES_KDK_FUSED) || defined(COSMOLOGY)
+      #error "PARTICLES_P3M requires PARTICLES_GPU and does not support PARTICLES_KDK_FUSED or COSMOLOGY"
+    #endif
+  #endif  // PARTICLES_P3M
+
+  #ifdef PARTICLES_BLOCK_TIMESTEPS
+    #if !defined(PARTICLES_GPU) || defined(PARTICLES_P3M)
+      #error "PARTICLES_BLOCK_TIMESTEPS requires PARTICLES_GPU and does not support PARTICLES_P3M"
+    #endif
+  #endif  // PARTICLES_BLOCK_TIMESTEPS
+
   #include <vector>
 typedef std::vector<Real> real_vector_t;
 typedef std::vector<part_int_t> int_vector_t;
@@ -195,6 +248,8 @@ struct Parameters {
   int n_projection           = 1;
   int n_rotated_projection   = 1;
   int n_slice                = 1;
+  int n_power_spectrum       = 1;
+  int n_halo_catalog         = 1;
   int n_out_float32          = 0;
   int out_float32_density    = 0;
   int out_float32_momentum_x = 0;
@@ -206,9 +261,52 @@ struct Parameters {
 #endif
   bool output_always      = false;
   bool legacy_flat_outdir = false;
+  // Write the hydro snapshots to a single file with collective parallel HDF5,
+  // in the layout of the concatenation scripts (MPI_CHOLLA only)
+  bool output_cat = false;
+  // Number of MPI-IO aggregators (cb_nodes hint) of the single file output, 0
+  // keeps the default of the MPI library
+  int output_cat_aggregators = 0;
+  // Side of the cubic chunks of the single file datasets, 0 for contiguous
+  // datasets
+  int output_cat_chunk = 0;
+  // Write the particle positions of the single file output as float32
+  bool output_cat_particles_float32 = false;
+  // Load the particles of init=Read_Grid from the single file
+  // <indir><nfile>_particles.h5 of all the particles, as with Read_Grid_Cat
+  bool read_particles_cat = false;
+  // Number of particles each rank reads per round when the particles of a
+  // single file are routed to the ranks of another decomposition
+  int read_particles_cat_chunk = 1048576;
+  // Node-local directory (NVMe or burst buffer) the restart snapshots are
+  // written to first. A background thread drains them to outdir while the run
+  // continues, and init=Read_Grid restarts from the local copy when every rank
+  // still has it. Only the latest checkpoint is kept on the local tier
+  char checkpoint_dir[MAXLEN] = "";
+  // Compression of the HDF5 datasets as comma separated field:codec[:value]
+  // entries, where codec is none, deflate, zstd or zfp, value is the level of
+  // deflate and zstd or the error bound of zfp, and the field * sets the
+  // default. The float32 files have their own list
+  char output_compression[MAXLEN]      = "";
+  char out_float32_compression[MAXLEN] = "";
+  // Derived fields computed on the device and added to the snapshots, as a
+  // comma separated list of temperature, pressure, magnetic_magnitude (MHD)
+  // and mach
+  char output_derived[MAXLEN] = "";
+  // Output the fields averaged over cubes of out_coarse_factor^3 cells every
+  // n_out_coarse outputs, 0 turns these outputs off
+  int n_out_coarse      = 0;
+  int out_coarse_factor = 2;
+  // The number of steps of a --benchmark run, 0 for a normal run
+  int benchmark_steps = 0;
 #ifdef STATIC_GRAV
   int custom_grav = 0;  // flag to set specific static gravity field
 #endif
+#ifdef DISK_ICS
+  // Solve the hydrostatic disk columns at this many radii and interpolate them
+  // for every cell, 0 solves the column of every (i,j)
+  int disk_columns_nr = 0;
+#endif
 #ifdef MHD
   int out_float32_magnetic_x = 0;
   int out_float32_magnetic_y = 0;
@@ -281,7 +379,46 @@ struct Parameters {
   // The random seed for particle simulations. With the default of 0 then a
   // machine dependent seed will be generated.
   std::uint_fast64_t prng_seed = 0;
-#endif  // PARTICLES
+  // Write the particles picked by a hash of their ID with probability
+  // particles_subset_fraction, and the ones inside the boxes of
+  // particles_subset_boxes, every n_out_particles_subset outputs, 0 turns these
+  // outputs off. The boxes are semicolon separated xmin,ymin,zmin,xmax,ymax,zmax
+  // lists in code units
+  int n_out_particles_subset          = 0;
+  Real particles_subset_fraction      = 0;
+  char particles_subset_boxes[MAXLEN] = "";
+  #ifdef PARTICLES_GPU
+  // Sort the particles by cell on the GPU every particle_sort_interval steps
+  // to make the CIC deposition and interpolation accesses coherent. The
+  // default of 0 never sorts, which keeps the order of the particles in the
+  // outputs unchanged
+  int particle_sort_interval = 0;
+  #endif  // PARTICLES_GPU
+  #ifdef PARTICLES_P3M
+  // Range of the particle-particle forces in units of the largest cell width.
+  // The mesh force is taken to be the force between two S2 spheres of this
+  // diameter, which is then replaced by the direct force below this distance
+  Real p3m_cutoff = 3;
+  // Plummer softening length of the direct particle-particle force in units of
+  // the largest cell width
+  Real p3m_softening = 0.1;
+  #endif  // PARTICLES_P3M
+  #ifdef PARTICLES_BLOCK_TIMESTEPS
+  // Number of power-of-two timestep bins of the particles. The particles of
+  // bin k take 2^k substeps per step, so the step can be up to
+  // 2^(particle_time_bins - 1) times the timestep of the fastest particle
+  int particle_time_bins = 1;
+  #endif  // PARTICLES_BLOCK_TIMESTEPS
+  #ifdef HALO_FINDER
+  // Linking length of the friends-of-friends halos in units of the mean
+  // interparticle separation
+  Real fof_linking_length = 0.2;
+  // Smallest number of particles of a halo of the catalogs
+  int fof_min_members = 20;
+  // Also write the particles of the halos of the catalogs, one file per process
+  int fof_output_members = 0;
+  #endif  // HALO_FINDER
+#endif    // PARTICLES
 #ifdef SUPERNOVA
   char snr_filename[MAXLEN];
 #endif
@@ -297,6 +434,8 @@ struct Parameters {
   int n_delta    = 0;
   Real ddelta_dt = 0;
   int flag_delta = 0;
+  // Composite the projections of all the processes into one image on the root
+  int composite_rot_proj = 0;
 #endif /*ROTATED_PROJECTION*/
 #ifdef COSMOLOGY
   Real H0;
@@ -318,14 +457,123 @@ struct Parameters {
   int n_proc_y;
   int n_proc_z;
 #endif
+  // Isolated gravity boundary potential: 0 uniform sphere, 1 Milky Way disk,
+  // 2 multipole expansion of the density (requires GRAVITY_GPU)
   int bc_potential_type;
+  // Maximum number of hydro steps between the Poisson solves of gravity, the
+  // potential is extrapolated in between (requires GRAVITY_GPU)
+  int gravity_subcycle_steps = 1;
+  // Relative L1 change of the gas density since the last Poisson solve that
+  // forces a new solve before gravity_subcycle_steps is reached
+  Real gravity_subcycle_tolerance = 0.01;
+#ifdef PARIS
+  // Minimum number of cells in each dimension of the blocks the periodic Paris
+  // FFTs run on, neighboring ranks are gathered onto one FFT rank until their
+  // combined block reaches it. 0 runs the FFTs on every rank
+  int paris_gather_cells = 0;
+#endif
+#if defined(PARIS) || defined(PARIS_GALACTIC)
+  // How the Paris transposes move their messages: 1 sends the device arrays
+  // directly (requires MPI_GPU), 0 stages them through pinned host memory, and
+  // -1 follows the faster path of the boundary transfer probe
+  int paris_mpi_gpu = -1;
+#endif
 #if defined(COOLING_GRACKLE) || defined(CHEMISTRY_GPU)
   char UVB_rates_file[MAXLEN];  // File for the UVB photoheating and
                                 // photoionization rates of HI, HeI and HeII
+#endif
+#if defined(CHEMISTRY_GPU) && defined(GRACKLE_METALS)
+  char metal_cooling_file[MAXLEN];  // Grackle Cloudy data file (HDF5) with the
+                                    // metal cooling and heating rates
 #endif
   Real temperature_floor = 0;
   Real density_floor     = 0;
   Real scalar_floor      = 0;
+#ifdef VL
+  // Number of z-slabs the 3D VL integrator splits the local grid into. Values
+  // larger than 1 shrink the integrator buffers to a single slab
+  int n_vl_slabs = 1;
+#endif  // VL
+#ifdef STATIC_REFINEMENT
+  // The box of the grid refined to twice the resolution: its first real cell
+  // and its number of cells along each axis, in cells of the grid. refine_nx =
+  // 0 disables the refinement
+  int refine_x_start = 0;
+  int refine_y_start = 0;
+  int refine_z_start = 0;
+  int refine_nx      = 0;
+  int refine_ny      = 0;
+  int refine_nz      = 0;
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+  // The number of timestep levels of the ranks. A rank on level l takes 2^l
+  // substeps per step, so the step can be up to 2^(local_time_levels - 1)
+  // times the shortest timestep of a rank
+  int local_time_levels = 1;
+#endif  // LOCAL_TIMESTEPS
+#ifdef MPI_CHOLLA
+  // Put a global MPI_Barrier between the x, y and z boundary exchanges instead
+  // of only completing the transfers with the neighboring ranks
+  int mpi_global_barrier = 0;
+  // Exchange the hydro boundaries with all 26 neighbors in a single phase
+  // instead of one phase per direction
+  int mpi_26_neighbors = 0;
+  // Give the ranks of each node a compact brick of blocks instead of numbering
+  // the blocks along x first, which keeps most of the halos on the node. Several
+  // ranks per device over-decompose the domain onto it
+  int mpi_node_blocks = 0;
+  // Create a Cartesian communicator that lets MPI reorder the ranks to fit the
+  // blocks to the topology of the machine. Replaces mpi_node_blocks
+  int mpi_cart_reorder = 0;
+  // File of the slab widths along each axis. If it exists the domain is split
+  // into these slabs instead of evenly, and with CPU_TIME the end of the run
+  // writes the widths that balance the measured cost of the ranks to it
+  char load_balance_file[MAXLEN] = "";
+  // Send the hydro boundaries in single precision. The ghost cells then differ
+  // slightly from the real cells of the neighbors, so conservation across the
+  // rank boundaries is only approximate
+  int mpi_float_halos = 0;
+  // Send only the passive scalars, dust and chemistry species of the hydro
+  // boundaries in single precision while the hydro fields keep full
+  // precision. With CHEMISTRY_GPU the six species then take half of their
+  // bytes. Ignored with mpi_float_halos, which already sends every field in
+  // single precision
+  int mpi_float_scalar_halos = 0;
+  // Number of steps between the in-memory checkpoints that every rank keeps of
+  // its own state and of the state of its buddy rank in host memory. 0
+  // disables them
+  int buddy_checkpoint_steps = 0;
+#endif  // MPI_CHOLLA
+#ifdef CPU_TIME
+  // File to append a machine readable record of the timers to every step. A
+  // .json or .jsonl extension writes JSON lines, anything else writes CSV.
+  // Empty disables the log
+  char perf_log[MAXLEN] = "";
+  // Number of steps of local timings every rank keeps in memory and writes to
+  // flight_recorder.<rank>.csv on SIGTERM, SIGUSR1 or chexit. 0 disables it
+  int flight_recorder_steps = 100;
+#endif  // CPU_TIME
+#ifdef LAUNCH_AUTOTUNE
+  // File of the tuned block sizes of the integrator kernels. The kernels that
+  // aren't in it for this GPU model and problem size are tuned on their first
+  // launch and added at the end of the run. Empty tunes them every run
+  char launch_cache[MAXLEN] = "";
+#endif  // LAUNCH_AUTOTUNE
+#ifdef RUNTIME_KERNELS
+  // Comma separated names of the reconstructions (pcm, plmp, plmc, ppmp, ppmc)
+  // and Riemann solvers (exact, roe, hllc, hll) the VL integrator may use, or
+  // auto for all of them. The reconstruction can't be wider than the ghost
+  // cells of the build, so build with PPMC to allow all of them. With more
+  // than one combination the fastest on the initial conditions is used. Empty
+  // keeps the ones of the build
+  char reconstruction[MAXLEN] = "";
+  char riemann_solver[MAXLEN] = "";
+#endif  // RUNTIME_KERNELS
+#ifdef LAGGED_DT
+  // The factor the lagged timestep is shortened by, so that it rarely breaks
+  // the CFL condition of the state it is taken from
+  Real lagged_dt_safety = 0.9;
+#endif  // LAGGED_DT
 #ifdef ANALYSIS
   char analysis_scale_outputs_file[MAXLEN];  // File for the scale_factor output
                                              // values for cosmological
@@ -333,6 +581,9 @@ struct Parameters {
   char analysisdir[MAXLEN];
   int lya_skewers_stride;
   Real lya_Pk_d_log_k;
+  // Write the raw skewers extracted on the device instead of computing the
+  // flux statistics on the host
+  int lya_skewers_stream = 0;
   #ifdef OUTPUT_SKEWERS
   char skewersdir[MAXLEN];
   #endif
@@ -348,6 +599,13 @@ struct Parameters {
  *  \brief Reads the parameters in the given file into a structure. */
 extern void Parse_Params(char *param_file, struct Parameters *parms, int argc, char **argv);
 
+/*! \fn void Set_Benchmark_Params(struct Parameters *parms, int argc, char **argv);
+ *  \brief Sets the parameters of the synthetic uniform problem run by
+ * `cholla --benchmark [n_steps] [name=value ...]`, a 128^3 periodic box of
+ * uniformly moving gas, or of the Synthetic_Cosmology initial conditions in
+ * the COSMOLOGY builds. The command line names override the defaults. */
+extern void Set_Benchmark_Params(struct Parameters *parms, int argc, char **argv);
+
 /*! \fn int is_param_valid(char *name);
  * \brief Verifies that a param is valid (even if not needed).  Avoids
  * "warnings" in output. */
@@ -9,6 +9,11 @@
 
   #include "../global/global.h"
   #include "../io/io.h"
+  #include "../utils/error_handling.h"
+  #if defined(PARIS) || defined(PARIS_GALACTIC)
+    #include "../gravity/paris/FFTCache.hpp"
+    #include "../mpi/mpi_routines.h"
+  #endif
 
   #ifdef PARALLEL_OMP
     #include "../utils/parallel_omp.h"
@@ -84,6 +89,29 @@ void Grav3D::Initialize(Real x_min, Real y_min, Real z_min, Real x_max, Real y_m
   // Flag to set the gravity boundary flags
   BC_FLAGS_SET = false;
 
+  // Subcycling of the Poisson solves, the first call always solves
+  subcycle_steps     = P->gravity_subcycle_steps;
+  subcycle_tolerance = P->gravity_subcycle_tolerance;
+  steps_since_solve  = subcycle_steps;
+  time_since_solve   = 0;
+  solve_interval     = 0;
+  POTENTIAL_SOLVED   = false;
+  if (subcycle_steps < 1) {
+    CHOLLA_ERROR("gravity_subcycle_steps must be at least 1, got %d", subcycle_steps);
+  }
+  #ifndef GRAVITY_GPU
+  if (subcycle_steps > 1) {
+    CHOLLA_ERROR("gravity_subcycle_steps > 1 requires GRAVITY_GPU");
+  }
+  #endif
+
+  #if defined(POISSON_FUSED_IO) && defined(GRAVITY_ANALYTIC_COMP)
+  // Add the analytic potential in the Poisson solver unless a boundary is
+  // periodic, decided from the global boundaries so all the ranks agree
+  ANALYTIC_POTENTIAL_FUSED = P->xl_bcnd != 1 && P->xu_bcnd != 1 && P->yl_bcnd != 1 && P->yu_bcnd != 1 &&
+                             P->zl_bcnd != 1 && P->zu_bcnd != 1;
+  #endif
+
   AllocateMemory_CPU();
 
   #ifdef GRAVITY_GPU
@@ -108,8 +136,19 @@ void Grav3D::Initialize(Real x_min, Real y_min, Real z_min, Real x_max, Real y_m
   chprintf("  N OMP Threads per MPI process: %d\n", N_OMP_THREADS);
   #endif
 
+  #if defined(PARIS) || defined(PARIS_GALACTIC)
+  // Choose how the transposes move their messages before the solvers reserve
+  // their host buffers
+  FFTCache::setDirect(P->paris_mpi_gpu < 0 ? mpi_gpu_direct : P->paris_mpi_gpu > 0);
+  chprintf(" Paris transposes send the %s buffers\n", FFTCache::direct() ? "device" : "staged host");
+  #endif
+  #ifdef PARIS
+  Poisson_solver.Initialize(Lbox_x, Lbox_y, Lbox_z, xMin, yMin, zMin, nx_total, ny_total, nz_total, nx_local, ny_local,
+                            nz_local, dx, dy, dz, P->paris_gather_cells);
+  #else
   Poisson_solver.Initialize(Lbox_x, Lbox_y, Lbox_z, xMin, yMin, zMin, nx_total, ny_total, nz_total, nx_local, ny_local,
                             nz_local, dx, dy, dz);
+  #endif
   #if defined(PARIS_TEST) || defined(PARIS_GALACTIC_TEST)
   Poisson_solver_test.Initialize(Lbox_x, Lbox_y, Lbox_z, xMin, yMin, zMin, nx_total, ny_total, nz_total, nx_local,
                                  ny_local, nz_local, dx, dy, dz);
@@ -149,7 +188,7 @@ void Grav3D::AllocateMemory_CPU(void)
   #endif
 
   #ifdef GRAVITY_ANALYTIC_COMP
-  F.analytic_potential_h = (Real *)malloc(n_cells_potential * sizeof(Real));
+  F.analytic_potential_h = (Real_Analytic *)malloc(n_cells_potential * sizeof(Real_Analytic));
   #endif
 }
 
@@ -197,6 +236,10 @@ void Grav3D::FreeMemory_CPU(void)
   #if defined(PARIS_TEST) || defined(PARIS_GALACTIC_TEST)
   Poisson_solver_test.Reset();
   #endif
+  #if defined(PARIS) || defined(PARIS_GALACTIC)
+  // Free the FFT plans and work arrays shared by the Paris solvers
+  FFTCache::release();
+  #endif
 
   #ifdef GRAVITY_ANALYTIC_COMP
   free(F.analytic_potential_h);
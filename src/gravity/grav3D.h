@@ -5,10 +5,16 @@
 
 #include "../global/global.h"
 
+#include "../gravity/potential_fused_io.h"
+
 #ifdef SOR
   #include "../gravity/potential_SOR_3D.h"
 #endif
 
+#if defined(MULTIGRID) && !defined(SOR)
+  #error "MULTIGRID is a mode of the SOR solver, build with POISSON_SOLVER=\"-DSOR -DMULTIGRID\""
+#endif
+
 #ifdef PARIS
   #include "../gravity/potential_paris_3D.h"
 #endif
@@ -30,6 +36,10 @@
 #define TPBY_GRAV 8
 #define TPBZ_GRAV 8
 
+// The number of density moments summed for the multipole expansion of the
+// isolated boundary potential: the mass, 3 first and 6 second moments
+#define N_DENSITY_MOMENTS 10
+
 /*! \class Grid3D
  *  \brief Class to create a the gravity object. */
 class Grav3D
@@ -96,6 +106,55 @@ class Grav3D
   bool BC_FLAGS_SET;
   int *boundary_flags;
 
+  /*! \var subcycle_steps
+   *  \brief Maximum number of hydro steps between two Poisson solves. In
+   * between the potential of the last two solves is extrapolated. 1 solves
+   * every step */
+  int subcycle_steps;
+  /*! \var subcycle_tolerance
+   *  \brief Relative L1 change of the gas density since the last solve above
+   * which the potential is solved again before subcycle_steps is reached */
+  Real subcycle_tolerance;
+  /*! \var steps_since_solve
+   *  \brief Number of steps that reused the last solution, subcycle_steps
+   * before the first solve */
+  int steps_since_solve;
+  /*! \var time_since_solve
+   *  \brief Time since the last solve */
+  Real time_since_solve;
+  /*! \var solve_interval
+   *  \brief Time between the last two solves, 0 before the second solve */
+  Real solve_interval;
+  /*! \var POTENTIAL_SOLVED
+   *  \brief The last call to Compute_Gravitational_Potential solved the
+   * Poisson equation. Otherwise the potential, including its boundaries and
+   * analytic component, is the one of the previous step */
+  bool POTENTIAL_SOLVED;
+
+#if defined(POISSON_FUSED_IO) && defined(GRAVITY_ANALYTIC_COMP)
+  /*! \var ANALYTIC_POTENTIAL_FUSED
+   *  \brief The Poisson solver adds the analytic potential to the real cells,
+   * so Add_Analytic_Potential_GPU only has to fill the non MPI ghost cells.
+   * Not used with periodic boundaries, whose ghost cells would get it twice */
+  bool ANALYTIC_POTENTIAL_FUSED;
+#endif
+
+#ifdef GRAVITY_GPU
+  /*! \struct Multipole_Moments
+   *  \brief Monopole and quadrupole of the mass distribution used to compute
+   *  the isolated boundary potential on the GPU. For bc_potential_type = 0 it
+   *  holds the uniform sphere and for bc_potential_type = 2 the moments of
+   *  the density of the whole domain */
+  struct Multipole_Moments {
+    Real mass;
+    /// The expansion center, the center of mass for bc_potential_type = 2
+    Real center[3];
+    /// The traceless quadrupole about the center in the order xx, yy, zz,
+    /// xy, xz, yz
+    Real quadrupole[6];
+  } multipole;
+#endif  // GRAVITY_GPU
+
 #ifdef SOR
   Potential_SOR_3D Poisson_solver;
 #endif
@@ -129,7 +188,7 @@ class Grav3D
     Real *potential_1_h;
 
 #ifdef GRAVITY_ANALYTIC_COMP
-    Real *analytic_potential_h;
+    Real_Analytic *analytic_potential_h;
 #endif
 
 #ifdef GRAVITY_GPU
@@ -149,9 +208,24 @@ class Grav3D
     Real *potential_1_d;
 
   #ifdef GRAVITY_ANALYTIC_COMP
-    Real *analytic_potential_d;
+    Real_Analytic *analytic_potential_d;
   #endif
 
+    /*! \var density_moments_d
+     *  \brief Device array of the N_DENSITY_MOMENTS sums of the density
+     * reduction for the multipole isolated boundaries */
+    Real *density_moments_d;
+
+    /*! \var density_solve_d
+     *  \brief Device array of the gas density of the real cells at the last
+     * solve, only allocated when subcycle_steps > 1 */
+    Real *density_solve_d;
+
+    /*! \var density_change_d
+     *  \brief Device array of the 2 sums of the relative density change
+     * reduction, only allocated when subcycle_steps > 1 */
+    Real *density_change_d;
+
 #endif  // GRAVITY_GPU
 
 // Arrays for computing the potential values in isolated boundaries
@@ -6,6 +6,7 @@
   #include "../grid/grid3D.h"
   #include "../io/io.h"
   #include "../model/disk_galaxy.h"
+  #include "../utils/error_handling.h"
 
   #if defined(GRAV_ISOLATED_BOUNDARY_X) || defined(GRAV_ISOLATED_BOUNDARY_Y) || defined(GRAV_ISOLATED_BOUNDARY_Z)
 
@@ -14,6 +15,10 @@ void Grid3D::Compute_Potential_Boundaries_Isolated(int dir, struct Parameters *P
   // Set Isolated Boundaries for the ghost cells.
   int bc_potential_type = P->bc_potential_type;
   // bc_potential_type = 0 -> Point mass potential GM/r
+    #ifdef GRAVITY_GPU
+  // The boundary is evaluated directly into the device buffers
+  Compute_Potential_Isolated_Boundary_GPU(dir / 2, dir % 2, bc_potential_type);
+    #else
   if (dir == 0) {
     Compute_Potential_Isolated_Boundary(0, 0, bc_potential_type);
   }
@@ -32,6 +37,7 @@ void Grid3D::Compute_Potential_Boundaries_Isolated(int dir, struct Parameters *P
   if (dir == 5) {
     Compute_Potential_Isolated_Boundary(2, 1, bc_potential_type);
   }
+    #endif  // GRAVITY_GPU
 }
 
 void Grid3D::Set_Potential_Boundaries_Isolated(int direction, int side, int *flags)
@@ -184,6 +190,10 @@ void Grid3D::Compute_Potential_Isolated_Boundary(int direction, int side, int bc
     cm_pos_z      = H.sphere_center_z;
   }
 
+  if (bc_potential_type == 2) {
+    CHOLLA_ERROR("The multipole boundary potential (bc_potential_type = 2) requires GRAVITY_GPU");
+  }
+
   // for bc_pontential_type = 1 the mod_frac is the fraction
   // of the disk mass contributed by the simulated particles
   Real mod_frac = SIMULATED_FRACTION;
@@ -5,9 +5,248 @@
   #include "../gravity/grav3D.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #include "../model/disk_galaxy.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/reduction_utilities.h"
 
   #if defined(GRAV_ISOLATED_BOUNDARY_X) || defined(GRAV_ISOLATED_BOUNDARY_Y) || defined(GRAV_ISOLATED_BOUNDARY_Z)
 
+/*! \brief Sum the mass and the first and second moments of the density over
+ * the local grid. The positions are relative to `origin` so the second
+ * moments don't lose precision to a domain far from the coordinate origin.
+ * `moments_d` must be zeroed before the launch. */
+__global__ void Compute_Density_Moments_kernel(Real *density_d, int nx, int ny, int nz, Real x_min, Real y_min,
+                                               Real z_min, Real dx, Real dy, Real dz, Real origin_x, Real origin_y,
+                                               Real origin_z, Real *moments_d)
+{
+  Real moments[N_DENSITY_MOMENTS] = {0};
+  int const n_cells               = nx * ny * nz;
+  Real const dV                   = dx * dy * dz;
+
+  // Grid stride loop so the kernel can be launched with the occupancy based
+  // launch parameters of the grid reduction
+  for (int id = threadIdx.x + blockIdx.x * blockDim.x; id < n_cells; id += blockDim.x * gridDim.x) {
+    int xid, yid, zid;
+    cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+    Real const mass  = density_d[id] * dV;
+    Real const pos_x = x_min + (xid + 0.5) * dx - origin_x;
+    Real const pos_y = y_min + (yid + 0.5) * dy - origin_y;
+    Real const pos_z = z_min + (zid + 0.5) * dz - origin_z;
+    moments[0] += mass;
+    moments[1] += mass * pos_x;
+    moments[2] += mass * pos_y;
+    moments[3] += mass * pos_z;
+    moments[4] += mass * pos_x * pos_x;
+    moments[5] += mass * pos_y * pos_y;
+    moments[6] += mass * pos_z * pos_z;
+    moments[7] += mass * pos_x * pos_y;
+    moments[8] += mass * pos_x * pos_z;
+    moments[9] += mass * pos_y * pos_z;
+  }
+
+  // The block reduction reuses its shared memory, sync between the moments
+  for (int n = 0; n < N_DENSITY_MOMENTS; n++) {
+    reduction_utilities::gridReduceSum(moments[n], &moments_d[n]);
+    __syncthreads();
+  }
+}
+
+void Grid3D::Compute_Density_Multipole_GPU()
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(Compute_Density_Moments_kernel);
+
+  // Expand about the center of the global domain to keep the sums well
+  // conditioned, the moments are shifted to the center of mass below
+  Real const origin_x = H.xbound + 0.5 * H.xdglobal;
+  Real const origin_y = H.ybound + 0.5 * H.ydglobal;
+  Real const origin_z = H.zbound + 0.5 * H.zdglobal;
+
+  GPU_Error_Check(cudaMemset(Grav.F.density_moments_d, 0, N_DENSITY_MOMENTS * sizeof(Real)));
+  hipLaunchKernelGGL(Compute_Density_Moments_kernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     Grav.F.density_d, Grav.nx_local, Grav.ny_local, Grav.nz_local, Grav.xMin, Grav.yMin, Grav.zMin,
+                     Grav.dx, Grav.dy, Grav.dz, origin_x, origin_y, origin_z, Grav.F.density_moments_d);
+  GPU_Error_Check();
+
+  Real moments[N_DENSITY_MOMENTS];
+  GPU_Error_Check(
+      cudaMemcpy(moments, Grav.F.density_moments_d, N_DENSITY_MOMENTS * sizeof(Real), cudaMemcpyDeviceToHost));
+    #ifdef MPI_CHOLLA
+  MPI_Allreduce(MPI_IN_PLACE, moments, N_DENSITY_MOMENTS, MPI_CHREAL, MPI_SUM, world);
+    #endif
+
+  Grav3D::Multipole_Moments &multipole = Grav.multipole;
+  Real const mass                      = moments[0];
+  multipole.mass                       = mass;
+  for (Real &quadrupole : multipole.quadrupole) {
+    quadrupole = 0.0;
+  }
+  if (mass <= 0.0) {
+    multipole.center[0] = origin_x;
+    multipole.center[1] = origin_y;
+    multipole.center[2] = origin_z;
+    return;
+  }
+
+  // Center of mass relative to the origin of the sums
+  Real const cm_x = moments[1] / mass;
+  Real const cm_y = moments[2] / mass;
+  Real const cm_z = moments[3] / mass;
+
+  multipole.center[0] = origin_x + cm_x;
+  multipole.center[1] = origin_y + cm_y;
+  multipole.center[2] = origin_z + cm_z;
+
+  // Second moments about the center of mass and the traceless quadrupole
+  // Q_ab = 3 I_ab - delta_ab tr(I)
+  Real const I_xx  = moments[4] - mass * cm_x * cm_x;
+  Real const I_yy  = moments[5] - mass * cm_y * cm_y;
+  Real const I_zz  = moments[6] - mass * cm_z * cm_z;
+  Real const trace = I_xx + I_yy + I_zz;
+
+  multipole.quadrupole[0] = 3 * I_xx - trace;
+  multipole.quadrupole[1] = 3 * I_yy - trace;
+  multipole.quadrupole[2] = 3 * I_zz - trace;
+  multipole.quadrupole[3] = 3 * (moments[7] - mass * cm_x * cm_y);
+  multipole.quadrupole[4] = 3 * (moments[8] - mass * cm_x * cm_z);
+  multipole.quadrupole[5] = 3 * (moments[9] - mass * cm_y * cm_z);
+}
+
+/*! \brief Evaluate the potential in the ghost cells of one isolated boundary
+ * directly into its device buffer, with the same buffer layout and cell
+ * positions as Grid3D::Compute_Potential_Isolated_Boundary. Types 0 and 2 use
+ * the multipole expansion about `multipole.center` and type 1 the
+ * Miyamoto-Nagai disk. */
+__global__ void Compute_Potential_Isolated_Boundary_kernel(int direction, int side, int n_i, int n_j, int n_ghost,
+                                                           Real x_min, Real y_min, Real z_min, Real dx, Real dy,
+                                                           Real dz, Real L_local, int bc_potential_type, Real Gconst,
+                                                           Grav3D::Multipole_Moments multipole, Real disk_M,
+                                                           Real disk_R, Real disk_Z, Real *pot_boundary_d)
+{
+  // get a global thread ID
+  int tid, tid_i, tid_j, tid_k;
+  tid   = threadIdx.x + blockIdx.x * blockDim.x;
+  tid_k = tid / (n_i * n_j);
+  tid_j = (tid - tid_k * n_i * n_j) / n_i;
+  tid_i = tid - tid_k * n_i * n_j - tid_j * n_i;
+
+  if (tid_i < 0 || tid_i >= n_i || tid_j < 0 || tid_j >= n_j || tid_k < 0 || tid_k >= n_ghost) {
+    return;
+  }
+
+  Real pos_x, pos_y, pos_z;
+  if (direction == 0) {
+    pos_x = x_min + (tid_k + 0.5 - n_ghost) * dx;
+    if (side == 1) {
+      pos_x += L_local + n_ghost * dx;
+    }
+    pos_y = y_min + (tid_i + 0.5) * dy;
+    pos_z = z_min + (tid_j + 0.5) * dz;
+  }
+  if (direction == 1) {
+    pos_y = y_min + (tid_k + 0.5 - n_ghost) * dy;
+    if (side == 1) {
+      pos_y += L_local + n_ghost * dy;
+    }
+    pos_x = x_min + (tid_i + 0.5) * dx;
+    pos_z = z_min + (tid_j + 0.5) * dz;
+  }
+  if (direction == 2) {
+    pos_z = z_min + (tid_k + 0.5 - n_ghost) * dz;
+    if (side == 1) {
+      pos_z += L_local + n_ghost * dz;
+    }
+    pos_x = x_min + (tid_i + 0.5) * dx;
+    pos_y = y_min + (tid_j + 0.5) * dy;
+  }
+
+  Real pot_val;
+  if (bc_potential_type == 1) {
+    // M-W disk potential, the same as DiskGalaxy::phi_disk_D3D scaled by
+    // the fraction of the disk mass in the simulated particles
+    Real const R = sqrt(pos_x * pos_x + pos_y * pos_y);
+    Real const A = sqrt(pos_z * pos_z + disk_Z * disk_Z);
+    Real const B = disk_R + A;
+    Real const C = sqrt(R * R + B * B);
+    pot_val      = -SIMULATED_FRACTION * GN * disk_M / C;
+  } else {
+    // Monopole plus quadrupole: -G ( M / r + Q_ab x_a x_b / ( 2 r^5 ) )
+    Real const delta_x = pos_x - multipole.center[0];
+    Real const delta_y = pos_y - multipole.center[1];
+    Real const delta_z = pos_z - multipole.center[2];
+    Real const r2      = delta_x * delta_x + delta_y * delta_y + delta_z * delta_z;
+    Real const r       = sqrt(r2);
+    Real const *Q      = multipole.quadrupole;
+    Real const Q_rr    = Q[0] * delta_x * delta_x + Q[1] * delta_y * delta_y + Q[2] * delta_z * delta_z +
+                      2 * (Q[3] * delta_x * delta_y + Q[4] * delta_x * delta_z + Q[5] * delta_y * delta_z);
+    pot_val = -Gconst * (multipole.mass / r + 0.5 * Q_rr / (r2 * r2 * r));
+  }
+
+  pot_boundary_d[tid_i + tid_j * n_i + tid_k * n_i * n_j] = pot_val;
+}
+
+void Grid3D::Compute_Potential_Isolated_Boundary_GPU(int direction, int side, int bc_potential_type)
+{
+  Real L_local, *pot_boundary_d;
+  int n_i, n_j, n_ghost;
+  n_ghost = N_GHOST_POTENTIAL;
+
+    #ifdef GRAV_ISOLATED_BOUNDARY_X
+  if (direction == 0) {
+    L_local        = Grav.nx_local * Grav.dx;
+    n_i            = Grav.ny_local;
+    n_j            = Grav.nz_local;
+    pot_boundary_d = (side == 0) ? Grav.F.pot_boundary_x0_d : Grav.F.pot_boundary_x1_d;
+  }
+    #endif
+    #ifdef GRAV_ISOLATED_BOUNDARY_Y
+  if (direction == 1) {
+    L_local        = Grav.ny_local * Grav.dy;
+    n_i            = Grav.nx_local;
+    n_j            = Grav.nz_local;
+    pot_boundary_d = (side == 0) ? Grav.F.pot_boundary_y0_d : Grav.F.pot_boundary_y1_d;
+  }
+    #endif
+    #ifdef GRAV_ISOLATED_BOUNDARY_Z
+  if (direction == 2) {
+    L_local        = Grav.nz_local * Grav.dz;
+    n_i            = Grav.nx_local;
+    n_j            = Grav.ny_local;
+    pot_boundary_d = (side == 0) ? Grav.F.pot_boundary_z0_d : Grav.F.pot_boundary_z1_d;
+  }
+    #endif
+
+  if (bc_potential_type == 0) {
+    // Point mass potential GM/r of the uniform sphere
+    const Real r0            = H.sphere_radius;
+    Grav.multipole.mass      = (H.sphere_density - H.sphere_background_density) * 4.0 * M_PI * r0 * r0 * r0 / 3.0;
+    Grav.multipole.center[0] = H.sphere_center_x;
+    Grav.multipole.center[1] = H.sphere_center_y;
+    Grav.multipole.center[2] = H.sphere_center_z;
+    for (Real &quadrupole : Grav.multipole.quadrupole) {
+      quadrupole = 0.0;
+    }
+  } else if (bc_potential_type != 1 && bc_potential_type != 2) {
+    CHOLLA_ERROR("Boundary Potential not set, need to set appropriate bc_potential_type (0, 1 or 2), got %d",
+                 bc_potential_type);
+  }
+
+  int size_buffer = n_ghost * n_i * n_j;
+
+  // set values for GPU kernels
+  int ngrid = (size_buffer - 1) / TPB_GRAV + 1;
+  // number of blocks per 1D grid
+  dim3 dim1dGrid(ngrid, 1, 1);
+  //  number of threads per 1D block
+  dim3 dim1dBlock(TPB_GRAV, 1, 1);
+
+  hipLaunchKernelGGL(Compute_Potential_Isolated_Boundary_kernel, dim1dGrid, dim1dBlock, 0, 0, direction, side, n_i, n_j,
+                     n_ghost, Grav.xMin, Grav.yMin, Grav.zMin, Grav.dx, Grav.dy, Grav.dz, L_local, bc_potential_type,
+                     Grav.Gconst, Grav.multipole, galaxies::MW.getM_d(), galaxies::MW.getR_d(), galaxies::MW.getZ_d(),
+                     pot_boundary_d);
+  GPU_Error_Check();
+}
+
 void __global__ Set_Potential_Boundaries_Isolated_kernel(int direction, int side, int size_buffer, int n_i, int n_j,
                                                          int nx, int ny, int nz, int n_ghost, Real *potential_d,
                                                          Real *pot_boundary_d)
@@ -62,17 +301,11 @@ void Grid3D::Set_Potential_Boundaries_Isolated_GPU(int direction, int side, int
   ny_g    = Grav.ny_local + 2 * n_ghost;
   nz_g    = Grav.nz_local + 2 * n_ghost;
 
-  Real *pot_boundary_h, *pot_boundary_d;
+  Real *pot_boundary_d;
     #ifdef GRAV_ISOLATED_BOUNDARY_X
   if (direction == 0) {
     n_i = Grav.ny_local;
     n_j = Grav.nz_local;
-    if (side == 0) {
-      pot_boundary_h = Grav.F.pot_boundary_x0;
-    }
-    if (side == 1) {
-      pot_boundary_h = Grav.F.pot_boundary_x1;
-    }
     if (side == 0) {
       pot_boundary_d = Grav.F.pot_boundary_x0_d;
     }
@@ -85,12 +318,6 @@ void Grid3D::Set_Potential_Boundaries_Isolated_GPU(int direction, int side, int
   if (direction == 1) {
     n_i = Grav.nx_local;
     n_j = Grav.nz_local;
-    if (side == 0) {
-      pot_boundary_h = Grav.F.pot_boundary_y0;
-    }
-    if (side == 1) {
-      pot_boundary_h = Grav.F.pot_boundary_y1;
-    }
     if (side == 0) {
       pot_boundary_d = Grav.F.pot_boundary_y0_d;
     }
@@ -103,12 +330,6 @@ void Grid3D::Set_Potential_Boundaries_Isolated_GPU(int direction, int side, int
   if (direction == 2) {
     n_i = Grav.nx_local;
     n_j = Grav.ny_local;
-    if (side == 0) {
-      pot_boundary_h = Grav.F.pot_boundary_z0;
-    }
-    if (side == 1) {
-      pot_boundary_h = Grav.F.pot_boundary_z1;
-    }
     if (side == 0) {
       pot_boundary_d = Grav.F.pot_boundary_z0_d;
     }
@@ -127,11 +348,8 @@ void Grid3D::Set_Potential_Boundaries_Isolated_GPU(int direction, int side, int
   //  number of threads per 1D block
   dim3 dim1dBlock(TPB_GRAV, 1, 1);
 
-  // Copy the boundary array from host to device
-  cudaMemcpy(pot_boundary_d, pot_boundary_h, size_buffer * sizeof(Real), cudaMemcpyHostToDevice);
-  cudaDeviceSynchronize();
-
-  // Copy the potential boundary from buffer to potential array
+  // The boundary buffer was filled on the device by
+  // Compute_Potential_Isolated_Boundary_GPU, copy it to the potential array
   hipLaunchKernelGGL(Set_Potential_Boundaries_Isolated_kernel, dim1dGrid, dim1dBlock, 0, 0, direction, side,
                      size_buffer, n_i, n_j, nx_g, ny_g, nz_g, n_ghost, Grav.F.potential_d, pot_boundary_d);
 }
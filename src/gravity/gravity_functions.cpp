@@ -4,9 +4,11 @@
 
   #include "../global/global.h"
   #include "../grid/grid3D.h"
+  #include "../integrators/VL_3D_cuda.h"
   #include "../io/io.h"
   #include "../mpi/cuda_mpi_routines.h"
   #include "../utils/error_handling.h"
+  #include "../utils/profiling_ranges.h"
 
   #ifdef PARALLEL_OMP
     #include "../utils/parallel_omp.h"
@@ -104,8 +106,9 @@ void Grid3D::set_dt_Gravity()
     exit(-1);
   }
 
-  // Set delta_a after it has been computed
+  // Set delta_a after it has been computed, and the particles step over it
   Cosmo.delta_a = da_min;
+  Cosmo.Set_Particles_Step_Factors();
   // Convert delta_a back to delta_t
   dt_min = Cosmo.Get_dt_from_da(Cosmo.delta_a) * Cosmo.H0 / (Cosmo.current_a * Cosmo.current_a);
   // Set the new delta_t for the hydro step
@@ -121,7 +124,7 @@ void Grid3D::set_dt_Gravity()
       #endif
 
   // Compute the physical time
-  dt_physical   = Cosmo.Get_dt_from_da(Cosmo.delta_a);
+  dt_physical   = Cosmo.Get_Time_Interval(Cosmo.current_a, Cosmo.current_a + Cosmo.delta_a);
   Cosmo.dt_secs = dt_physical * Cosmo.time_conversion;
   Cosmo.t_secs += Cosmo.dt_secs;
   chprintf(" t_physical: %f Myr   dt_physical: %f Myr\n", Cosmo.t_secs / MYR, Cosmo.dt_secs / MYR);
@@ -450,18 +453,56 @@ void Grid3D::Initialize_Gravity(struct Parameters *P)
 // Compute the Gravitational Potential by solving Poisson Equation
 void Grid3D::Compute_Gravitational_Potential(struct Parameters *P)
 {
+  profiling::ScopedRange const range("Compute_Gravitational_Potential");
+
   #ifdef CPU_TIME
   Timer.Grav_Potential.Start();
   #endif
 
+  #ifdef GRAVITY_GPU
+  if (Grav.subcycle_steps > 1) {
+    // Before the first solve there is nothing to reuse
+    if (Grav.steps_since_solve < Grav.subcycle_steps) {
+      Grav.time_since_solve += H.dt;
+      // Keep the last solution while the step limit isn't reached and the gas
+      // density is close to the one it was computed from
+      if (Grav.steps_since_solve + 1 < Grav.subcycle_steps &&
+          Get_Grav_Density_Change_GPU() <= Grav.subcycle_tolerance) {
+        Grav.steps_since_solve++;
+        Grav.POTENTIAL_SOLVED = false;
+    #ifdef CPU_TIME
+        Timer.Grav_Potential.End();
+    #endif
+        return;
+      }
+      // The last two solutions are extrapolated until the next solve
+      GPU_Error_Check(cudaMemcpy(Grav.F.potential_1_d, Grav.F.potential_d, Grav.n_cells_potential * sizeof(Real),
+                                 cudaMemcpyDeviceToDevice));
+      Grav.solve_interval = Grav.time_since_solve;
+    }
+    Grav.steps_since_solve = 0;
+    Grav.time_since_solve  = 0;
+    Store_Grav_Density_GPU();
+  }
+  #endif  // GRAVITY_GPU
+  Grav.POTENTIAL_SOLVED = true;
+
   #ifdef PARTICLES
   // Copy the particles density to the grav_density array
   Copy_Particles_Density_to_Gravity(*P);
   #endif
 
   #ifndef ONLY_PARTICLES
+    #ifdef POISSON_FUSED_IO
+  // The Paris solver reads the hydro density straight from the conserved
+  // array, unless the multipole boundaries need the total density first
+  if (P->bc_potential_type == 2) {
+    Copy_Hydro_Density_to_Gravity();
+  }
+    #else
   // Copy the hydro density to the grav_density array
   Copy_Hydro_Density_to_Gravity();
+    #endif  // POISSON_FUSED_IO
   #endif
 
   #ifdef COSMOLOGY
@@ -491,6 +532,14 @@ void Grid3D::Compute_Gravitational_Potential(struct Parameters *P)
     Grav.BC_FLAGS_SET = true;
   }
 
+  #ifdef GRAVITY_GPU
+  // The moments of the density are reduced over all the ranks, so every rank
+  // computes them even if it doesn't have an isolated boundary
+  if (P->bc_potential_type == 2) {
+    Compute_Density_Multipole_GPU();
+  }
+  #endif
+
   #ifdef GRAV_ISOLATED_BOUNDARY_X
   if (Grav.boundary_flags[0] == 3) {
     Compute_Potential_Boundaries_Isolated(0, P);
@@ -526,6 +575,14 @@ void Grid3D::Compute_Gravitational_Potential(struct Parameters *P)
   #ifdef GRAVITY_GPU
   input_density    = Grav.F.density_d;
   output_potential = Grav.F.potential_d;
+    #ifdef POISSON_FUSED_IO
+  const PotentialFusedIO fused = Get_Poisson_Fused_IO(P);
+  // The hydro and particle densities are the whole input density, the gravity
+  // density array only holds them for the multipole boundaries
+  if (P->bc_potential_type != 2) {
+    input_density = nullptr;
+  }
+    #endif  // POISSON_FUSED_IO
   #else
   input_density    = Grav.F.density_h;
   output_potential = Grav.F.potential_h;
@@ -546,6 +603,12 @@ void Grid3D::Compute_Gravitational_Potential(struct Parameters *P)
   Get_Potential_SOR(Grav_Constant, dens_avrg, current_a, P);
     #endif
 
+  #elif defined POISSON_FUSED_IO
+    #ifdef PARIS_GALACTIC
+  Grav.Poisson_solver.Get_Potential(input_density, output_potential, Grav_Constant, galaxies::MW, fused);
+    #else
+  Grav.Poisson_solver.Get_Potential(input_density, output_potential, Grav_Constant, dens_avrg, current_a, fused);
+    #endif
   #elif defined PARIS_GALACTIC
   Grav.Poisson_solver.Get_Potential(input_density, output_potential, Grav_Constant, galaxies::MW);
   #else
@@ -578,12 +641,17 @@ void Grid3D::Setup_Analytic_Potential(struct Parameters *P)
 
     #ifdef GRAVITY_GPU
   GPU_Error_Check(cudaMemcpy(Grav.F.analytic_potential_d, Grav.F.analytic_potential_h,
-                             Grav.n_cells_potential * sizeof(Real), cudaMemcpyHostToDevice));
+                             Grav.n_cells_potential * sizeof(Real_Analytic), cudaMemcpyHostToDevice));
     #endif
 }
 
 void Grid3D::Add_Analytic_Potential()
 {
+  // A potential kept from the previous step already includes it
+  if (!Grav.POTENTIAL_SOLVED) {
+    return;
+  }
+
     #ifdef GRAVITY_GPU
   Add_Analytic_Potential_GPU();
     #else
@@ -777,6 +845,11 @@ void Grid3D::Extrapolate_Grav_Potential()
   Extrapolate_Grav_Potential_GPU();
   #else
 
+    #ifdef GRAV_POTENTIAL_UPLOAD
+  // The last upload still reads the host potential
+  grav_potential_uploaded.Synchronize();
+    #endif  // GRAV_POTENTIAL_UPLOAD
+
     #ifndef PARALLEL_OMP
   Extrapolate_Grav_Potential_Function(0, Grav.nz_local + 2 * N_GHOST_POTENTIAL);
     #else
@@ -794,6 +867,10 @@ void Grid3D::Extrapolate_Grav_Potential()
   }
     #endif  // PARALLEL_OMP
 
+    #ifdef GRAV_POTENTIAL_UPLOAD
+  Upload_Grav_Potential();
+    #endif  // GRAV_POTENTIAL_UPLOAD
+
   #endif  // GRAVITY_GPU
 
   // After the first timestep the INITIAL flag is set to false, that way the
@@ -801,4 +878,20 @@ void Grid3D::Extrapolate_Grav_Potential()
   Grav.INITIAL = false;
 }
 
+  #ifdef GRAV_POTENTIAL_UPLOAD
+void Grid3D::Upload_Grav_Potential()
+{
+  // Switch to the buffer of the step before last, once the integrator of that
+  // step is done with it, so the upload doesn't wait for the last step
+  grav_potential_buffer = 1 - grav_potential_buffer;
+  C.d_Grav_potential    = d_grav_potential_buffers[grav_potential_buffer];
+  grav_potential_read[grav_potential_buffer].Wait(streams.uploads);
+  GPU_Error_Check(cudaMemcpyAsync(C.d_Grav_potential, C.Grav_potential, H.n_cells * sizeof(Real),
+                                  cudaMemcpyHostToDevice, streams.uploads));
+  grav_potential_uploaded.Record(streams.uploads);
+  // The integrator only waits for it before the full update
+  VL_Set_Potential_Ready(grav_potential_uploaded.get());
+}
+  #endif  // GRAV_POTENTIAL_UPLOAD
+
 #endif  // GRAVITY
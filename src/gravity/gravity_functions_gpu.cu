@@ -5,31 +5,44 @@
   #include "../global/global.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/error_handling.h"
+  #include "../utils/reduction_utilities.h"
 
 void Grav3D::AllocateMemory_GPU()
 {
-  GPU_Error_Check(cudaMalloc((void **)&F.density_d, n_cells * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void **)&F.potential_d, n_cells_potential * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void **)&F.potential_1_d, n_cells_potential * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+  cuda_utilities::Pool_Malloc(&F.density_d, n_cells * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&F.potential_d, n_cells_potential * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&F.potential_1_d, n_cells_potential * sizeof(Real));
 
   #ifdef GRAVITY_GPU
 
     #ifdef GRAVITY_ANALYTIC_COMP
-  GPU_Error_Check(cudaMalloc((void **)&F.analytic_potential_d, n_cells_potential * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&F.analytic_potential_d, n_cells_potential * sizeof(Real_Analytic));
     #endif
 
+  cuda_utilities::Pool_Malloc(&F.density_moments_d, N_DENSITY_MOMENTS * sizeof(Real));
+
+  F.density_solve_d  = nullptr;
+  F.density_change_d = nullptr;
+  if (subcycle_steps > 1) {
+    cuda_utilities::Pool_Malloc(&F.density_solve_d, n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&F.density_change_d, 2 * sizeof(Real));
+  }
+
     #ifdef GRAV_ISOLATED_BOUNDARY_X
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_x0_d, N_GHOST_POTENTIAL * ny_local * nz_local * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_x1_d, N_GHOST_POTENTIAL * ny_local * nz_local * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_x0_d, N_GHOST_POTENTIAL * ny_local * nz_local * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_x1_d, N_GHOST_POTENTIAL * ny_local * nz_local * sizeof(Real));
     #endif
     #ifdef GRAV_ISOLATED_BOUNDARY_Y
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_y0_d, N_GHOST_POTENTIAL * nx_local * nz_local * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_y1_d, N_GHOST_POTENTIAL * nx_local * nz_local * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_y0_d, N_GHOST_POTENTIAL * nx_local * nz_local * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_y1_d, N_GHOST_POTENTIAL * nx_local * nz_local * sizeof(Real));
     #endif
     #ifdef GRAV_ISOLATED_BOUNDARY_Z
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_z0_d, N_GHOST_POTENTIAL * nx_local * ny_local * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc((void **)&F.pot_boundary_z1_d, N_GHOST_POTENTIAL * nx_local * ny_local * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_z0_d, N_GHOST_POTENTIAL * nx_local * ny_local * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&F.pot_boundary_z1_d, N_GHOST_POTENTIAL * nx_local * ny_local * sizeof(Real));
     #endif
 
   #endif  // GRAVITY_GPU
@@ -39,27 +52,31 @@ void Grav3D::AllocateMemory_GPU()
 
 void Grav3D::FreeMemory_GPU(void)
 {
-  cudaFree(F.density_d);
-  cudaFree(F.potential_d);
-  cudaFree(F.potential_1_d);
+  cuda_utilities::Pool_Free(F.density_d);
+  cuda_utilities::Pool_Free(F.potential_d);
+  cuda_utilities::Pool_Free(F.potential_1_d);
 
   #ifdef GRAVITY_GPU
 
     #ifdef GRAVITY_ANALYTIC_COMP
-  cudaFree(F.analytic_potential_d);
+  cuda_utilities::Pool_Free(F.analytic_potential_d);
     #endif
 
+  cuda_utilities::Pool_Free(F.density_moments_d);
+  cuda_utilities::Pool_Free(F.density_solve_d);
+  cuda_utilities::Pool_Free(F.density_change_d);
+
     #ifdef GRAV_ISOLATED_BOUNDARY_X
-  cudaFree(F.pot_boundary_x0_d);
-  cudaFree(F.pot_boundary_x1_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_x0_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_x1_d);
     #endif
     #ifdef GRAV_ISOLATED_BOUNDARY_Y
-  cudaFree(F.pot_boundary_y0_d);
-  cudaFree(F.pot_boundary_y1_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_y0_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_y1_d);
     #endif
     #ifdef GRAV_ISOLATED_BOUNDARY_Z
-  cudaFree(F.pot_boundary_z0_d);
-  cudaFree(F.pot_boundary_z1_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_z0_d);
+  cuda_utilities::Pool_Free(F.pot_boundary_z1_d);
     #endif
 
   #endif  // GRAVITY_GPU
@@ -135,8 +152,122 @@ void Grid3D::Copy_Hydro_Density_to_Gravity_GPU()
                      nx_local, ny_local, nz_local, n_ghost, cosmo_rho_0_gas);
 }
 
+/*! \brief Sum the absolute change of the gas density of the real cells since
+ * the last Poisson solve into sums_d[0] and the density at the last solve into
+ * sums_d[1] */
+__global__ void Grav_Density_Change_Kernel(Real *density_d, Real *density_solve_d, int nx_local, int ny_local,
+                                           int nz_local, int n_ghost, Real *sums_d)
+{
+  Real change = 0, total = 0;
+  int const n_cells = nx_local * ny_local * nz_local;
+  int const nx_grid = nx_local + 2 * n_ghost;
+  int const ny_grid = ny_local + 2 * n_ghost;
+
+  // Grid stride loop so the kernel can be launched with the occupancy based
+  // launch parameters of the grid reduction
+  for (int id = threadIdx.x + blockIdx.x * blockDim.x; id < n_cells; id += blockDim.x * gridDim.x) {
+    int xid, yid, zid;
+    cuda_utilities::compute3DIndices(id, nx_local, ny_local, xid, yid, zid);
+    int const id_grid = cuda_utilities::compute1DIndex(xid + n_ghost, yid + n_ghost, zid + n_ghost, nx_grid, ny_grid);
+    change += fabs(density_d[id_grid] - density_solve_d[id]);
+    total += density_solve_d[id];
+  }
+
+  // The block reduction reuses its shared memory, sync between the sums
+  reduction_utilities::gridReduceSum(change, &sums_d[0]);
+  __syncthreads();
+  reduction_utilities::gridReduceSum(total, &sums_d[1]);
+}
+
+/*! \brief Copy the gas density of the real cells into density_solve_d */
+__global__ void Store_Grav_Density_Kernel(Real *density_d, Real *density_solve_d, int nx_local, int ny_local,
+                                          int nz_local, int n_ghost)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, nx_local, ny_local, xid, yid, zid);
+  if (zid >= nz_local) {
+    return;
+  }
+  int const nx_grid = nx_local + 2 * n_ghost;
+  int const ny_grid = ny_local + 2 * n_ghost;
+  density_solve_d[id] =
+      density_d[cuda_utilities::compute1DIndex(xid + n_ghost, yid + n_ghost, zid + n_ghost, nx_grid, ny_grid)];
+}
+
+Real Grid3D::Get_Grav_Density_Change_GPU()
+{
+    #ifdef ONLY_PARTICLES
+  // Only the number of steps limits the subcycle of particle only runs
+  return 0;
+    #else
+  cuda_utilities::AutomaticLaunchParams static const launchParams(Grav_Density_Change_Kernel);
+
+  GPU_Error_Check(cudaMemset(Grav.F.density_change_d, 0, 2 * sizeof(Real)));
+  hipLaunchKernelGGL(Grav_Density_Change_Kernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     C.d_density, Grav.F.density_solve_d, Grav.nx_local, Grav.ny_local, Grav.nz_local, H.n_ghost,
+                     Grav.F.density_change_d);
+  GPU_Error_Check();
+
+  Real sums[2];
+  GPU_Error_Check(cudaMemcpy(sums, Grav.F.density_change_d, 2 * sizeof(Real), cudaMemcpyDeviceToHost));
+      #ifdef MPI_CHOLLA
+  MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPI_CHREAL, MPI_SUM, world);
+      #endif
+
+  // Without gas any change forces a solve
+  return (sums[1] > 0) ? sums[0] / sums[1] : sums[0];
+    #endif  // ONLY_PARTICLES
+}
+
+void Grid3D::Store_Grav_Density_GPU()
+{
+    #ifndef ONLY_PARTICLES
+  int const n_cells = Grav.nx_local * Grav.ny_local * Grav.nz_local;
+  hipLaunchKernelGGL(Store_Grav_Density_Kernel, (n_cells - 1) / TPB_GRAV + 1, TPB_GRAV, 0, 0, C.d_density,
+                     Grav.F.density_solve_d, Grav.nx_local, Grav.ny_local, Grav.nz_local, H.n_ghost);
+    #endif  // ONLY_PARTICLES
+}
+
+  #ifdef POISSON_FUSED_IO
+PotentialFusedIO Grid3D::Get_Poisson_Fused_IO(struct Parameters *P)
+{
+  PotentialFusedIO fused;
+
+    #ifndef ONLY_PARTICLES
+  // The multipole boundaries copy the density to the gravity array before the
+  // solve, see Compute_Gravitational_Potential
+  if (P->bc_potential_type != 2) {
+    fused.hydro_density = C.d_density;
+    fused.hydro_n_ghost = H.n_ghost;
+      #ifdef COSMOLOGY
+    fused.hydro_scale = Cosmo.rho_0_gas;
+      #endif
+  }
+    #endif  // ONLY_PARTICLES
+
+    #ifdef PARTICLES
+  // Copy_Particles_Density_to_Gravity leaves the CIC density in the particle
+  // grid for the same boundaries
+  if (P->bc_potential_type != 2) {
+    fused.particle_density = Particles.G.density_dev;
+    fused.particle_n_ghost = Particles.G.n_ghost_particles_grid;
+  }
+    #endif  // PARTICLES
+
+    #ifdef GRAVITY_ANALYTIC_COMP
+  if (Grav.ANALYTIC_POTENTIAL_FUSED) {
+    fused.analytic_potential = Grav.F.analytic_potential_d;
+  }
+    #endif
+
+  return fused;
+}
+  #endif  // POISSON_FUSED_IO
+
   #if defined(GRAVITY_ANALYTIC_COMP)
-void __global__ Add_Analytic_Potential_Kernel(Real *analytic_d, Real *potential_d, int nx_pot, int ny_pot, int nz_pot)
+void __global__ Add_Analytic_Potential_Kernel(Real_Analytic *analytic_d, Real *potential_d, int nx_pot, int ny_pot,
+                                              int nz_pot)
 {
   int tid_x, tid_y, tid_z, tid;
   tid_x = blockIdx.x * blockDim.x + threadIdx.x;
@@ -159,6 +290,34 @@ void __global__ Add_Analytic_Potential_Kernel(Real *analytic_d, Real *potential_
   */
 }
 
+    #ifdef POISSON_FUSED_IO
+/*! \brief Add the analytic potential to the ghost cells of the faces selected
+ * by the bits of `faces`, ordered x0, x1, y0, y1, z0, z1. Cells in more than
+ * one selected face get it once. */
+void __global__ Add_Analytic_Potential_Ghost_Kernel(Real_Analytic *analytic_d, Real *potential_d, int nx_pot,
+                                                    int ny_pot, int nz_pot, int n_ghost, int faces)
+{
+  int tid_x, tid_y, tid_z, tid;
+  tid_x = blockIdx.x * blockDim.x + threadIdx.x;
+  tid_y = blockIdx.y * blockDim.y + threadIdx.y;
+  tid_z = blockIdx.z * blockDim.z + threadIdx.z;
+
+  if (tid_x >= nx_pot || tid_y >= ny_pot || tid_z >= nz_pot) {
+    return;
+  }
+
+  int const cell_faces = (tid_x < n_ghost) | (tid_x >= nx_pot - n_ghost) << 1 | (tid_y < n_ghost) << 2 |
+                         (tid_y >= ny_pot - n_ghost) << 3 | (tid_z < n_ghost) << 4 | (tid_z >= nz_pot - n_ghost) << 5;
+  if ((cell_faces & faces) == 0) {
+    return;
+  }
+
+  tid = tid_x + tid_y * nx_pot + tid_z * nx_pot * ny_pot;
+
+  potential_d[tid] += analytic_d[tid];
+}
+    #endif  // POISSON_FUSED_IO
+
 void Grid3D::Add_Analytic_Potential_GPU()
 {
   int nx_pot, ny_pot, nz_pot;
@@ -180,6 +339,24 @@ void Grid3D::Add_Analytic_Potential_GPU()
   //  number of threads per 1D block
   dim3 dim3dBlock(tpb_x, tpb_y, tpb_z);
 
+    #ifdef POISSON_FUSED_IO
+  if (Grav.ANALYTIC_POTENTIAL_FUSED) {
+    // The Poisson solver added the analytic potential to the real cells and
+    // the MPI ghost cells are copies of them, only the other ghost cells are
+    // left
+    int faces = 0;
+    for (int i = 0; i < 6; i++) {
+      if (Grav.boundary_flags[i] != 5) {
+        faces |= 1 << i;
+      }
+    }
+    hipLaunchKernelGGL(Add_Analytic_Potential_Ghost_Kernel, dim3dGrid, dim3dBlock, 0, 0, Grav.F.analytic_potential_d,
+                       Grav.F.potential_d, nx_pot, ny_pot, nz_pot, N_GHOST_POTENTIAL, faces);
+    cudaDeviceSynchronize();
+    return;
+  }
+    #endif  // POISSON_FUSED_IO
+
   // Copy the analytic potential from the device array to the device potential
   // array
   hipLaunchKernelGGL(Add_Analytic_Potential_Kernel, dim3dGrid, dim3dBlock, 0, 0, Grav.F.analytic_potential_d,
@@ -196,8 +373,8 @@ void Grid3D::Add_Analytic_Potential_GPU()
 
 void __global__ Extrapolate_Grav_Potential_Kernel(Real *dst_potential, Real *src_potential_0, Real *src_potential_1,
                                                   int nx_pot, int ny_pot, int nz_pot, int nx_grid, int ny_grid,
-                                                  int nz_grid, int n_offset, Real dt_now, Real dt_prev, bool INITIAL,
-                                                  Real cosmo_factor)
+                                                  int nz_grid, int n_offset, Real dt_extrp, Real dt_prev, bool INITIAL,
+                                                  bool update_prev, Real cosmo_factor)
 {
   int tid_x, tid_y, tid_z, tid_grid, tid_pot;
   tid_x = blockIdx.x * blockDim.x + threadIdx.x;
@@ -224,7 +401,7 @@ void __global__ Extrapolate_Grav_Potential_Kernel(Real *dst_potential, Real *src
     pot_prev = src_potential_1[tid_pot];  // Potential at the (n-1)-th timestep
                                           // ( previous step )
     // Compute the extrapolated potential from phi_n-1 and phi_n
-    pot_extrp = pot_now + 0.5 * dt_now * (pot_now - pot_prev) / dt_prev;
+    pot_extrp = pot_now + dt_extrp * (pot_now - pot_prev) / dt_prev;
   }
 
   #ifdef COSMOLOGY
@@ -236,7 +413,9 @@ void __global__ Extrapolate_Grav_Potential_Kernel(Real *dst_potential, Real *src
   // Save the extrapolated potential
   dst_potential[tid_grid] = pot_extrp;
   // Set phi_n-1 = phi_n, to use it during the next step
-  src_potential_1[tid_pot] = pot_now;
+  if (update_prev) {
+    src_potential_1[tid_pot] = pot_now;
+  }
 }
 
 void Grid3D::Extrapolate_Grav_Potential_GPU()
@@ -254,9 +433,25 @@ void Grid3D::Extrapolate_Grav_Potential_GPU()
 
   int n_offset = n_ghost_grid - N_GHOST_POTENTIAL;
 
-  Real dt_now, dt_prev, cosmo_factor;
-  dt_now  = Grav.dt_now;
-  dt_prev = Grav.dt_prev;
+  // Extrapolate from the last step to the middle of the next one
+  Real dt_extrp, dt_prev, cosmo_factor;
+  dt_extrp         = 0.5 * Grav.dt_now;
+  dt_prev          = Grav.dt_prev;
+  bool update_prev = true;
+
+  // When subcycling extrapolate from the last two solves instead, which
+  // Compute_Gravitational_Potential keeps in potential_d and potential_1_d
+  if (Grav.subcycle_steps > 1) {
+    update_prev = false;
+    if (Grav.solve_interval > 0) {
+      dt_extrp = Grav.time_since_solve + 0.5 * Grav.dt_now;
+      dt_prev  = Grav.solve_interval;
+    } else {
+      // There was a single solve, keep its potential
+      dt_extrp = 0;
+      dt_prev  = 1;
+    }
+  }
 
   #ifdef COSMOLOGY
   cosmo_factor = Cosmo.current_a * Cosmo.current_a / Cosmo.phi_0_gas;
@@ -278,7 +473,7 @@ void Grid3D::Extrapolate_Grav_Potential_GPU()
 
   hipLaunchKernelGGL(Extrapolate_Grav_Potential_Kernel, dim3dGrid, dim3dBlock, 0, 0, C.d_Grav_potential,
                      Grav.F.potential_d, Grav.F.potential_1_d, nx_pot, ny_pot, nz_pot, nx_grid, ny_grid, nz_grid,
-                     n_offset, dt_now, dt_prev, Grav.INITIAL, cosmo_factor);
+                     n_offset, dt_extrp, dt_prev, Grav.INITIAL, update_prev, cosmo_factor);
 }
 
   #ifdef PARTICLES_CPU
@@ -0,0 +1,106 @@
+#if defined(PARIS) || defined(PARIS_GALACTIC)
+
+  #include <array>
+  #include <cassert>
+  #include <map>
+  #include <vector>
+
+  #include "FFTCache.hpp"
+
+  #include "../../utils/device_memory_pool.h"
+  #include "../../utils/error_handling.h"
+
+namespace
+{
+//! Shape, strides, type, and batch count of a 1D batched plan
+using PlanKey = std::array<int, 9>;
+
+struct Buffer {
+  double *ptr  = nullptr;
+  size_t bytes = 0;
+};
+
+std::map<PlanKey, cufftHandle> plans;
+std::vector<Buffer> deviceBuffers;
+Buffer hostBuffer;
+bool directMPI = false;
+}  // namespace
+
+cufftHandle FFTCache::plan(int n, int inembed, int istride, int idist, int onembed, int ostride, int odist,
+                           const cufftType type, const int batch)
+{
+  const PlanKey key = {n, inembed, istride, idist, onembed, ostride, odist, int(type), batch};
+  const auto found  = plans.find(key);
+  if (found != plans.end()) {
+    return found->second;
+  }
+
+  cufftHandle handle;
+  GPU_Error_Check(cufftPlanMany(&handle, 1, &n, &inembed, istride, idist, &onembed, ostride, odist, type, batch));
+  plans[key] = handle;
+  return handle;
+}
+
+double *FFTCache::device(const int slot, const size_t bytes)
+{
+  assert(slot >= 0);
+  if (slot >= int(deviceBuffers.size())) {
+    deviceBuffers.resize(slot + 1);
+  }
+  Buffer &buffer = deviceBuffers[slot];
+  if (buffer.bytes < bytes) {
+    if (buffer.ptr) {
+      cuda_utilities::Pool_Free(buffer.ptr);
+    }
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+    cuda_utilities::Pool_Malloc(&buffer.ptr, bytes);
+    assert(buffer.ptr);
+    buffer.bytes = bytes;
+  }
+  return buffer.ptr;
+}
+
+double *FFTCache::host(const size_t bytes)
+{
+  if (hostBuffer.bytes < bytes) {
+    if (hostBuffer.ptr) {
+      GPU_Error_Check(cudaFreeHost(hostBuffer.ptr));
+    }
+    GPU_Error_Check(cudaHostAlloc(reinterpret_cast<void **>(&hostBuffer.ptr), bytes, cudaHostAllocDefault));
+    assert(hostBuffer.ptr);
+    hostBuffer.bytes = bytes;
+  }
+  return hostBuffer.ptr;
+}
+
+void FFTCache::setDirect(const bool direct)
+{
+  #ifndef MPI_GPU
+  CHOLLA_ASSERT(!direct, "Sending the Paris transposes from device memory needs a build with MPI_GPU");
+  #endif
+  directMPI = direct;
+}
+
+bool FFTCache::direct() { return directMPI; }
+
+void FFTCache::release()
+{
+  for (auto &entry : plans) {
+    GPU_Error_Check(cufftDestroy(entry.second));
+  }
+  plans.clear();
+
+  for (Buffer &buffer : deviceBuffers) {
+    if (buffer.ptr) {
+      cuda_utilities::Pool_Free(buffer.ptr);
+    }
+  }
+  deviceBuffers.clear();
+
+  if (hostBuffer.ptr) {
+    GPU_Error_Check(cudaFreeHost(hostBuffer.ptr));
+  }
+  hostBuffer = Buffer{};
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../../utils/gpu.hpp"
+
+/**
+ * @brief Process-wide cache of FFT plans and scratch memory shared by all the
+ * Paris Poisson solvers and Henry FFT filters in a run.
+ * @detail { Plans are keyed by their shape, strides, type, and batch count, so
+ * solvers with matching decompositions share a single plan. The device and
+ * pinned-host scratch buffers only grow, to the largest size any solver has
+ * requested, so all the solvers share one pool instead of each allocating its
+ * own. Since a buffer may be reallocated when a larger size is requested,
+ * callers should request their buffers at the start of each solve rather than
+ * keeping the pointers. All the solvers run on the default stream and never
+ * concurrently, so the shared buffers are never in use by two solvers at once. }
+ */
+class FFTCache
+{
+ public:
+  /**
+   * @return { A 1D batched FFT plan, as from `cufftPlanMany` with rank 1.
+   * Created on the first request and reused afterwards. The plan is owned by
+   * the cache and must not be destroyed by the caller. }
+   */
+  static cufftHandle plan(int n, int inembed, int istride, int idist, int onembed, int ostride, int odist,
+                          cufftType type, int batch);
+
+  /**
+   * @param[in] slot { Index of the device buffer. Callers that need more than
+   * one buffer at the same time use different slots. }
+   * @param[in] bytes { Minimum size of the buffer. }
+   * @return { Device buffer of at least @ref bytes bytes. }
+   */
+  static double *device(int slot, size_t bytes);
+
+  /**
+   * @param[in] bytes { Minimum size of the buffer. }
+   * @return { Pinned host buffer of at least @ref bytes bytes, used to stage
+   * MPI messages when they are not sent from device memory. }
+   */
+  static double *host(size_t bytes);
+
+  /**
+   * @brief Choose whether the redistributions of all the solvers send their
+   * device work arrays directly through GPU-aware MPI or stage them through
+   * @ref host. Set before the solvers are created, since they only reserve
+   * the host buffers when staging. Direct sends need a build with `MPI_GPU`.
+   */
+  static void setDirect(bool direct);
+
+  /**
+   * @return { Whether the MPI messages are sent from device memory. }
+   */
+  static bool direct();
+
+  /**
+   * @brief Destroy all the plans and free all the buffers. Called once the
+   * solvers using them have been reset.
+   */
+  static void release();
+};
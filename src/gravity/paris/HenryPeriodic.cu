@@ -7,7 +7,9 @@
 
   #include "HenryPeriodic.hpp"
 
-HenryPeriodic::HenryPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3])
+template <typename T>
+HenryPeriodic<T>::HenryPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3],
+                                const int id[3], const MPI_Comm comm)
     : idi_(id[0]),
       idj_(id[1]),
       idk_(id[2]),
@@ -35,17 +37,17 @@ HenryPeriodic::HenryPeriodic(const int n[3], const double lo[3], const double hi
   {
     const int color = idi_ * mj_ + idj_;
     const int key   = idk_;
-    MPI_Comm_split(MPI_COMM_WORLD, color, key, &commK_);
+    MPI_Comm_split(comm, color, key, &commK_);
   }
   {
     const int color = idi_ * mp_ + idp_;
     const int key   = idj_ * mq_ + idq_;
-    MPI_Comm_split(MPI_COMM_WORLD, color, key, &commJ_);
+    MPI_Comm_split(comm, color, key, &commJ_);
   }
   {
     const int color = idj_ * mq_ + idq_;
     const int key   = idi_ * mp_ + idp_;
-    MPI_Comm_split(MPI_COMM_WORLD, color, key, &commI_);
+    MPI_Comm_split(comm, color, key, &commI_);
   }
 
   // Maximum numbers of elements for various decompositions and dimensions
@@ -72,35 +74,120 @@ HenryPeriodic::HenryPeriodic(const int n[3], const double lo[3], const double hi
                 long(2) * long(dip_) * long(dhq_) * long(mip) * long(djp_),
                 long(2) * djp_ * long(dhq_) * long(mip) * long(dip_)});
   assert(nMax <= INT_MAX);
+  // Sized in doubles even for float transforms, since the input and output
+  // fields are always double
   bytes_ = nMax * sizeof(double);
 
-  // FFT objects
-  GPU_Error_Check(cufftPlanMany(&c2ci_, 1, &ni_, &ni_, 1, ni_, &ni_, 1, ni_, CUFFT_Z2Z, djp_ * dhq_));
-  GPU_Error_Check(cufftPlanMany(&c2cj_, 1, &nj_, &nj_, 1, nj_, &nj_, 1, nj_, CUFFT_Z2Z, dip_ * dhq_));
-  GPU_Error_Check(cufftPlanMany(&c2rk_, 1, &nk_, &nh_, 1, nh_, &nk_, 1, nk_, CUFFT_Z2D, dip_ * djq_));
-  GPU_Error_Check(cufftPlanMany(&r2ck_, 1, &nk_, &nk_, 1, nk_, &nh_, 1, nh_, CUFFT_D2Z, dip_ * djq_));
-
-  #ifndef MPI_GPU
-  // Host arrays for MPI communication
-  GPU_Error_Check(cudaHostAlloc(&ha_, bytes_ + bytes_, cudaHostAllocDefault));
-  assert(ha_);
-  hb_ = ha_ + nMax;
-  #endif
+  // FFT objects, shared with any other solver using the same shapes. The
+  // filter looks up the plans for each chunk of the redistributions, which are
+  // these full-size plans unless PARIS_PIPELINE is set
+  c2ci_ = FFTCache::plan(ni_, ni_, 1, ni_, ni_, 1, ni_, HenryFFT<T>::c2c, djp_ * dhq_);
+  FFTCache::plan(nj_, nj_, 1, nj_, nj_, 1, nj_, HenryFFT<T>::c2c, dip_ * dhq_);
+  FFTCache::plan(nk_, nh_, 1, nh_, nk_, 1, nk_, HenryFFT<T>::c2r, dip_ * djq_);
+  FFTCache::plan(nk_, nk_, 1, nk_, nh_, 1, nh_, HenryFFT<T>::r2c, dip_ * djq_);
+
+  if (!FFTCache::direct()) {
+    // Reserve the shared host arrays for MPI communication
+    FFTCache::host(bytes_ + bytes_);
+  }
 }
 
-HenryPeriodic::~HenryPeriodic()
+template <typename T>
+HenryPeriodic<T>::~HenryPeriodic()
 {
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaFreeHost(ha_));
-  ha_ = hb_ = nullptr;
-  #endif
-  GPU_Error_Check(cufftDestroy(r2ck_));
-  GPU_Error_Check(cufftDestroy(c2rk_));
-  GPU_Error_Check(cufftDestroy(c2cj_));
-  GPU_Error_Check(cufftDestroy(c2ci_));
+  // The FFT plans and host arrays belong to the FFTCache
   MPI_Comm_free(&commI_);
   MPI_Comm_free(&commJ_);
   MPI_Comm_free(&commK_);
 }
 
+template <typename T>
+HenryTranspose<T>::HenryTranspose(const size_t bytes, const T *const a, T *const b, const int count, const int outer,
+                                  const MPI_Comm comm)
+    : b_(b), count_(count), outer_(outer), chunks_(1), tasks_(0)
+{
+  assert(count % outer == 0);
+  MPI_Comm_size(comm, &tasks_);
+  const size_t messageBytes = sizeof(T) * size_t(count) * size_t(tasks_);
+  assert(messageBytes <= bytes);
+
+  #ifndef PARIS_PIPELINE
+  if (!FFTCache::direct()) {
+    double *const host = FFTCache::host(bytes + bytes);
+    T *const ha        = reinterpret_cast<T *>(host);
+    T *const hb        = reinterpret_cast<T *>(host + bytes / sizeof(double));
+    GPU_Error_Check(cudaMemcpy(ha, a, messageBytes, cudaMemcpyDeviceToHost));
+    MPI_Alltoall(ha, count, HenryFFT<T>::mpiType(), hb, count, HenryFFT<T>::mpiType(), comm);
+    GPU_Error_Check(cudaMemcpy(b, hb, messageBytes, cudaMemcpyHostToDevice));
+  } else {
+    GPU_Error_Check(cudaDeviceSynchronize());
+    MPI_Alltoall(a, count, HenryFFT<T>::mpiType(), b, count, HenryFFT<T>::mpiType(), comm);
+  }
+  #else
+  chunks_ = std::max(1, std::min(PARIS_PIPELINE_CHUNKS, outer));
+  recv_   = reinterpret_cast<T *>(FFTCache::device(recvSlot_, bytes));
+
+  const T *sendBuffer = nullptr;
+  T *recvBuffer       = nullptr;
+  if (!FFTCache::direct()) {
+    double *const host = FFTCache::host(bytes + bytes);
+    T *const ha        = reinterpret_cast<T *>(host);
+    hb_                = reinterpret_cast<T *>(host + bytes / sizeof(double));
+    GPU_Error_Check(cudaMemcpy(ha, a, messageBytes, cudaMemcpyDeviceToHost));
+    sendBuffer = ha;
+    recvBuffer = hb_;
+  } else {
+    // Send from a copy, since the caller unpacks into `a` while chunks are in flight
+    T *const send = reinterpret_cast<T *>(FFTCache::device(sendSlot_, bytes));
+    GPU_Error_Check(cudaMemcpy(send, a, messageBytes, cudaMemcpyDeviceToDevice));
+    GPU_Error_Check(cudaDeviceSynchronize());
+    hb_        = nullptr;
+    sendBuffer = send;
+    recvBuffer = recv_;
+  }
+
+  // Start every chunk up front so that later chunks progress while earlier ones are transformed
+  const int stride = count / outer;
+  counts_.resize(size_t(chunks_) * tasks_);
+  displs_.resize(size_t(chunks_) * tasks_);
+  requests_.resize(chunks_);
+  for (int c = 0; c < chunks_; c++) {
+    int *const counts = counts_.data() + size_t(c) * tasks_;
+    int *const displs = displs_.data() + size_t(c) * tasks_;
+    for (int task = 0; task < tasks_; task++) {
+      counts[task] = (hi(c) - lo(c)) * stride;
+      displs[task] = task * count + lo(c) * stride;
+    }
+    MPI_Ialltoallv(sendBuffer, counts, displs, HenryFFT<T>::mpiType(), recvBuffer, counts, displs,
+                   HenryFFT<T>::mpiType(), comm, &requests_[c]);
+  }
+  #endif  // PARIS_PIPELINE
+}
+
+template <typename T>
+const T *HenryTranspose<T>::wait(const int c)
+{
+  assert(c >= 0 && c < chunks_);
+  #ifndef PARIS_PIPELINE
+  return b_;
+  #else
+  MPI_Wait(&requests_[c], MPI_STATUS_IGNORE);
+  if (hb_) {
+    // Copy this chunk of every task's message to the device without waiting on the transforms of earlier chunks
+    const int stride    = count_ / outer_;
+    const size_t pitch  = sizeof(T) * count_;
+    const size_t offset = size_t(lo(c)) * stride;
+    const size_t width  = sizeof(T) * size_t(hi(c) - lo(c)) * stride;
+    GPU_Error_Check(cudaMemcpy2DAsync(recv_ + offset, pitch, hb_ + offset, pitch, width, tasks_,
+                                      cudaMemcpyHostToDevice, 0));
+  }
+  return recv_;
+  #endif  // PARIS_PIPELINE
+}
+
+template class HenryTranspose<double>;
+template class HenryTranspose<float>;
+template class HenryPeriodic<double>;
+template class HenryPeriodic<float>;
+
 #endif
@@ -3,12 +3,115 @@
 #include <mpi.h>
 
 #include <algorithm>
+#include <vector>
 
 #include "../../utils/gpu.hpp"
+#include "FFTCache.hpp"
+
+#ifndef PARIS_PIPELINE_CHUNKS
+  #define PARIS_PIPELINE_CHUNKS 4
+#endif
+
+/**
+ * @brief Types and FFT functions for the precision of the transforms in @ref
+ * HenryPeriodic, which is `double` or `float`.
+ */
+template <typename T>
+struct HenryFFT;
+
+template <>
+struct HenryFFT<double> {
+  using Complex                  = cufftDoubleComplex;
+  static constexpr cufftType r2c = CUFFT_D2Z;
+  static constexpr cufftType c2r = CUFFT_Z2D;
+  static constexpr cufftType c2c = CUFFT_Z2Z;
+  static MPI_Datatype mpiType() { return MPI_DOUBLE; }
+  static cufftResult_t execR2C(cufftHandle plan, double *in, Complex *out) { return cufftExecD2Z(plan, in, out); }
+  static cufftResult_t execC2R(cufftHandle plan, Complex *in, double *out) { return cufftExecZ2D(plan, in, out); }
+  static cufftResult_t execC2C(cufftHandle plan, Complex *in, Complex *out, int direction)
+  {
+    return cufftExecZ2Z(plan, in, out, direction);
+  }
+};
+
+template <>
+struct HenryFFT<float> {
+  using Complex                  = cufftComplex;
+  static constexpr cufftType r2c = CUFFT_R2C;
+  static constexpr cufftType c2r = CUFFT_C2R;
+  static constexpr cufftType c2c = CUFFT_C2C;
+  static MPI_Datatype mpiType() { return MPI_FLOAT; }
+  static cufftResult_t execR2C(cufftHandle plan, float *in, Complex *out) { return cufftExecR2C(plan, in, out); }
+  static cufftResult_t execC2R(cufftHandle plan, Complex *in, float *out) { return cufftExecC2R(plan, in, out); }
+  static cufftResult_t execC2C(cufftHandle plan, Complex *in, Complex *out, int direction)
+  {
+    return cufftExecC2C(plan, in, out, direction);
+  }
+};
+
+/**
+ * @brief All-to-all redistribution used between the FFT stages of @ref
+ * HenryPeriodic.
+ * @detail { The message to each task is split into chunks along its outermost
+ * dimension. Without `PARIS_PIPELINE` there is a single chunk, sent with a
+ * blocking `MPI_Alltoall` into the destination array. With `PARIS_PIPELINE`
+ * every chunk is started with its own `MPI_Ialltoallv` into a work array, so
+ * the caller can unpack and transform chunk `c` while the later chunks are
+ * still in flight. }
+ * @tparam T { Element type of the messages, `double` or `float`. }
+ */
+template <typename T>
+class HenryTranspose
+{
+ public:
+  /**
+   * @param[in] bytes { Size of the work arrays, from @ref HenryPeriodic::bytes.
+   * }
+   * @param[in] a { Packed message to every task in `comm`, `count` elements
+   * each, ordered by task. }
+   * @param[out] b { Destination of the blocking redistribution. }
+   * @param[in] count { Number of elements sent to each task. }
+   * @param[in] outer { Size of the outermost dimension of each message, which
+   * is the dimension that is chunked. Must divide `count`. }
+   * @param[in] comm { Communicator of the redistribution. }
+   */
+  HenryTranspose(size_t bytes, const T *a, T *b, int count, int outer, MPI_Comm comm);
+
+  //! Number of chunks
+  int chunks() const { return chunks_; }
+
+  //! First index of the outer dimension in chunk `c`
+  int lo(const int c) const { return (c * outer_) / chunks_; }
+
+  //! One past the last index of the outer dimension in chunk `c`
+  int hi(const int c) const { return ((c + 1) * outer_) / chunks_; }
+
+  /**
+   * @brief Wait for chunk `c` to arrive. Chunks must be waited for in order.
+   * @return { Array holding the received messages, ordered by task like `a`.
+   * Only the parts in chunks up to `c` are valid. }
+   */
+  const T *wait(int c);
+
+ private:
+  static constexpr int recvSlot_ = 2;  //!< FFTCache device slot for received chunks
+  static constexpr int sendSlot_ = 3;  //!< FFTCache device slot for sent chunks with FFTCache::direct()
+  T *b_;
+  int count_, outer_, chunks_, tasks_;
+#ifdef PARIS_PIPELINE
+  T *recv_;
+  T *hb_;
+  std::vector<int> counts_, displs_;
+  std::vector<MPI_Request> requests_;
+#endif
+};
 
 /**
  * @brief Generic distributed-memory 3D FFT filter.
+ * @tparam T { Precision of the FFTs and the redistributions, `double` or
+ * `float`. The input and output fields are `double` either way. }
  */
+template <typename T = double>
 class HenryPeriodic
 {
  public:
@@ -23,8 +126,10 @@ class HenryPeriodic
    * computation of these arguments. }
    * @param[in] m[3] { Number of MPI tasks in each dimension. }
    * @param[in] id[3] { Coordinates of this MPI task, starting at `{0,0,0}`. }
+   * @param[in] comm { Communicator of the `m[0]*m[1]*m[2]` tasks of the FFT. }
    */
-  HenryPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3]);
+  HenryPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3],
+                MPI_Comm comm = MPI_COMM_WORLD);
 
   ~HenryPeriodic();
 
@@ -49,7 +154,8 @@ class HenryPeriodic
    *                     Must be at least @ref bytes() bytes, likely larger than
    * the actual output field. }
    * @param[in] f { Functor or lambda function to be used as a filter.
-   *                The operator should have the following prototype.
+   *                The operator should have the following prototype, where
+   *                `complex` is `HenryFFT<T>::Complex`.
    *                \code
    *                complex f(int i, int j, int k, complex before)
    *                \endcode
@@ -60,7 +166,40 @@ class HenryPeriodic
   template <typename F>
   void filter(const size_t bytes, double *const before, double *const after, const F f) const;
 
+  /**
+   * @detail { Performs the forward 3D FFT of the real input field and passes
+   *           every local frequency-space value to the provided functor,
+   *           without the inverse FFT. The values are not normalized.
+   *           Expects fields in 3D block distribution with no ghost cells. }
+   * @tparam F { Type of functor that will be called in frequency space. }
+   * @param[in] bytes { Number of bytes allocated for arguments @ref before and
+   * @ref after, like for @ref filter. }
+   * @param[in,out] before { Input field. Modified as a work array. }
+   * @param[out] after { Modified as a work array. }
+   * @param[in] f { Functor or lambda function with the prototype
+   *                \code
+   *                void f(int i, int j, int k, complex value)
+   *                \endcode
+   *                with the frequency-space coordinates of @ref filter. Only
+   *                the non-negative frequencies of the last dimension are
+   *                stored, `k < n[2] / 2 + 1`. }
+   */
+  template <typename F>
+  void spectrum(const size_t bytes, double *const before, double *const after, const F f) const;
+
  private:
+  /**
+   * @brief The forward FFT of @ref filter, which leaves the frequency-space
+   * values distributed in X pencils in `before`.
+   */
+  void forward(size_t bytes, double *before, double *after) const;
+
+  /**
+   * @brief The backward FFT of @ref filter, from the filtered X pencils in
+   * `after` to the output field in `after`.
+   */
+  void backward(size_t bytes, double *before, double *after) const;
+
   int idi_, idj_, idk_;  //!< MPI coordinates of 3D block
   int mi_, mj_, mk_;     //!< Number of MPI tasks in each dimension of 3D domain
   int nh_;               //!< Global number of complex values in Z dimension, after R2C
@@ -74,25 +213,27 @@ class HenryPeriodic
   int dhq_, dip_, djp_,
       djq_;       //!< Max number of local points in dimensions of 2D decompositions
   size_t bytes_;  //!< Max bytes needed for argument arrays
-  cufftHandle c2ci_, c2cj_, c2rk_,
-      r2ck_;  //!< Objects for forward and inverse FFTs
-#ifndef MPI_GPU
-  double *ha_, *hb_;  //!< Host copies for MPI messages
-#endif
+  cufftHandle c2ci_;  //!< Backward FFT in X, owned by FFTCache. The other
+                      //!< FFTs use plans from FFTCache sized for each chunk
 };
 
 #if defined(__HIP__) || defined(__CUDACC__)
 
-template <typename F>
-void HenryPeriodic::filter(const size_t bytes, double *const before, double *const after, const F f) const
+template <typename T>
+void HenryPeriodic<T>::forward(const size_t bytes, double *const before, double *const after) const
 {
   // Make sure arguments have enough space
   assert(bytes >= bytes_);
 
-  double *const a              = after;
-  double *const b              = before;
-  cufftDoubleComplex *const ac = reinterpret_cast<cufftDoubleComplex *>(a);
-  cufftDoubleComplex *const bc = reinterpret_cast<cufftDoubleComplex *>(b);
+  using Fft     = HenryFFT<T>;
+  using Complex = typename Fft::Complex;
+
+  // Work arrays in the precision of the transforms, sharing the memory of the
+  // arguments
+  T *const a        = reinterpret_cast<T *>(after);
+  T *const b        = reinterpret_cast<T *>(before);
+  Complex *const ac = reinterpret_cast<Complex *>(a);
+  Complex *const bc = reinterpret_cast<Complex *>(b);
 
   // Local copies of member variables for lambda capture
 
@@ -111,6 +252,10 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
   const int mip  = mi * mp;
   const int mjq  = mj * mq;
 
+  const int countK = dip * djq * dk;
+  const int countJ = 2 * dip * djq * dhq;
+  const int countI = 2 * dip * djp * dhq;
+
   // Reorder 3D block into sub-pencils
 
   gpuFor(
@@ -119,41 +264,38 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
         const int jj = q * djq + j;
         const int ia = k + dk * (j + djq * (i + dip * (q + mq * p)));
         const int ib = k + dk * (jj + dj * ii);
-        a[ia]        = b[ib];
+        a[ia]        = T(before[ib]);
       });
 
-  // Redistribute into Z pencils
+  // Redistribute into Z pencils, make them contiguous in Z, and apply the
+  // real-to-complex FFT in Z, one chunk of X indices at a time
 
-  const int countK = dip * djq * dk;
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countK, MPI_DOUBLE, hb_, countK, MPI_DOUBLE, commK_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countK, MPI_DOUBLE, b, countK, MPI_DOUBLE, commK_);
-  #endif
-
-  // Make Z pencils contiguous in Z
   {
     const int iLo = idi * di + idp * dip;
     const int iHi = std::min({iLo + dip, (idi + 1) * di, ni});
     const int jLo = idj * dj + idq * djq;
     const int jHi = std::min({jLo + djq, (idj + 1) * dj, nj});
-    gpuFor(
-        iHi - iLo, jHi - jLo, mk, dk, GPU_LAMBDA(const int i, const int j, const int pq, const int k) {
-          const int kk = pq * dk + k;
-          if (kk < nk) {
-            const int ia = kk + nk * (j + djq * i);
-            const int ib = k + dk * (j + djq * (i + dip * pq));
-            a[ia]        = b[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countK, dip, commK_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const T *const src = transpose.wait(c);
+      const int i0            = transpose.lo(c);
+      const int ni0           = transpose.hi(c) - i0;
+      gpuFor(
+          std::min(ni0, iHi - iLo - i0), jHi - jLo, mk, dk,
+          GPU_LAMBDA(const int i1, const int j, const int pq, const int k) {
+            const int i  = i0 + i1;
+            const int kk = pq * dk + k;
+            if (kk < nk) {
+              const int ia = kk + nk * (j + djq * i);
+              const int ib = k + dk * (j + djq * (i + dip * pq));
+              a[ia]        = src[ib];
+            }
+          });
+      const cufftHandle r2ck = FFTCache::plan(nk, nk, 1, nk, nh, 1, nh, Fft::r2c, ni0 * djq);
+      GPU_Error_Check(Fft::execR2C(r2ck, a + long(i0) * djq * nk, bc + long(i0) * djq * nh));
+    }
   }
 
-  // Real-to-complex FFT in Z
-  GPU_Error_Check(cufftExecD2Z(r2ck_, a, bc));
-
   // Rearrange for Y redistribution
   {
     const int iLo = idi * di + idp * dip;
@@ -171,38 +313,36 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
         });
   }
 
-  // Redistribute for Y pencils
-  const int countJ = 2 * dip * djq * dhq;
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countJ, MPI_DOUBLE, hb_, countJ, MPI_DOUBLE, commJ_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countJ, MPI_DOUBLE, b, countJ, MPI_DOUBLE, commJ_);
-  #endif
-
-  // Make Y pencils contiguous in Y
+  // Redistribute for Y pencils, make them contiguous in Y, and apply the
+  // forward FFT in Y, one chunk of X indices at a time
   {
     const int iLo = idi * di + idp * dip;
     const int iHi = std::min({iLo + dip, (idi + 1) * di, ni});
     const int kLo = idjq * dhq;
     const int kHi = std::min(kLo + dhq, nh);
-    gpuFor(
-        kHi - kLo, iHi - iLo, mj, mq, djq, GPU_LAMBDA(const int k, const int i, const int r, const int q, const int j) {
-          const int rdj = r * dj;
-          const int jj  = rdj + q * djq + j;
-          if ((jj < nj) && (jj < rdj + dj)) {
-            const int ia = jj + nj * (i + dip * k);
-            const int ib = k + dhq * (j + djq * (i + dip * (q + mq * r)));
-            ac[ia]       = bc[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countJ, dip, commJ_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const Complex *const src = reinterpret_cast<const Complex *>(transpose.wait(c));
+      const int i0                        = transpose.lo(c);
+      const int ni0                       = transpose.hi(c) - i0;
+      gpuFor(
+          std::min(ni0, iHi - iLo - i0), kHi - kLo, mj, mq, djq,
+          GPU_LAMBDA(const int i1, const int k, const int r, const int q, const int j) {
+            const int i   = i0 + i1;
+            const int rdj = r * dj;
+            const int jj  = rdj + q * djq + j;
+            if ((jj < nj) && (jj < rdj + dj)) {
+              const int ia = jj + nj * (k + dhq * i);
+              const int ib = k + dhq * (j + djq * (i + dip * (q + mq * r)));
+              ac[ia]       = src[ib];
+            }
+          });
+      const cufftHandle c2cj = FFTCache::plan(nj, nj, 1, nj, nj, 1, nj, Fft::c2c, ni0 * dhq);
+      const long offset      = long(i0) * dhq * nj;
+      GPU_Error_Check(Fft::execC2C(c2cj, ac + offset, bc + offset, CUFFT_FORWARD));
+    }
   }
 
-  // Forward FFT in Y
-  GPU_Error_Check(cufftExecZ2Z(c2cj_, ac, bc, CUFFT_FORWARD));
-
   // Rearrange for X redistribution
   {
     const int iLo = idi * di + idp * dip;
@@ -214,61 +354,82 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
           const int jj = p * djp + j;
           if (jj < nj) {
             const int ia = j + djp * (i + dip * (k + dhq * p));
-            const int ib = jj + nj * (i + dip * k);
+            const int ib = jj + nj * (k + dhq * i);
             ac[ia]       = bc[ib];
           }
         });
   }
 
-  // Redistribute for X pencils
-  const int countI = 2 * dip * djp * dhq;
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countI, MPI_DOUBLE, hb_, countI, MPI_DOUBLE, commI_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countI, MPI_DOUBLE, b, countI, MPI_DOUBLE, commI_);
-  #endif
-
-  // Make X pencils contiguous in X
+  // Redistribute for X pencils, make them contiguous in X, and apply the
+  // forward FFT in X, one chunk of Z indices at a time
   {
     const int jLo = idip * djp;
     const int jHi = std::min(jLo + djp, nj);
     const int kLo = idjq * dhq;
     const int kHi = std::min(kLo + dhq, nh);
-    gpuFor(
-        jHi - jLo, kHi - kLo, mi, mp, dip, GPU_LAMBDA(const int j, const int k, const int r, const int p, const int i) {
-          const int rdi = r * di;
-          const int ii  = rdi + p * dip + i;
-          if ((ii < ni) && (ii < rdi + di)) {
-            const int ia = ii + ni * (k + dhq * j);
-            const int ib = j + djp * (i + dip * (k + dhq * (p + mp * r)));
-            ac[ia]       = bc[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countI, dhq, commI_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const Complex *const src = reinterpret_cast<const Complex *>(transpose.wait(c));
+      const int k0                        = transpose.lo(c);
+      const int nk0                       = transpose.hi(c) - k0;
+      gpuFor(
+          std::min(nk0, kHi - kLo - k0), jHi - jLo, mi, mp, dip,
+          GPU_LAMBDA(const int k1, const int j, const int r, const int p, const int i) {
+            const int k   = k0 + k1;
+            const int rdi = r * di;
+            const int ii  = rdi + p * dip + i;
+            if ((ii < ni) && (ii < rdi + di)) {
+              const int ia = ii + ni * (j + djp * k);
+              const int ib = j + djp * (i + dip * (k + dhq * (p + mp * r)));
+              ac[ia]       = src[ib];
+            }
+          });
+      const cufftHandle c2ci = FFTCache::plan(ni, ni, 1, ni, ni, 1, ni, Fft::c2c, nk0 * djp);
+      const long offset      = long(k0) * djp * ni;
+      GPU_Error_Check(Fft::execC2C(c2ci, ac + offset, bc + offset, CUFFT_FORWARD));
+    }
   }
+}
 
-  // Forward FFT in X
-  GPU_Error_Check(cufftExecZ2Z(c2ci_, ac, bc, CUFFT_FORWARD));
+template <typename T>
+void HenryPeriodic<T>::backward(const size_t bytes, double *const before, double *const after) const
+{
+  // Make sure arguments have enough space
+  assert(bytes >= bytes_);
 
-  // Apply filter in frequency space distributed in X pencils
+  using Fft     = HenryFFT<T>;
+  using Complex = typename Fft::Complex;
 
-  const int jLo = idip * djp;
-  const int jHi = std::min(jLo + djp, nj);
-  const int kLo = idjq * dhq;
-  const int kHi = std::min(kLo + dhq, nh);
+  // Work arrays in the precision of the transforms, sharing the memory of the
+  // arguments
+  T *const a        = reinterpret_cast<T *>(after);
+  T *const b        = reinterpret_cast<T *>(before);
+  Complex *const ac = reinterpret_cast<Complex *>(a);
+  Complex *const bc = reinterpret_cast<Complex *>(b);
 
-  gpuFor(
-      jHi - jLo, kHi - kLo, ni, GPU_LAMBDA(const int j0, const int k0, const int i) {
-        const int j   = jLo + j0;
-        const int k   = kLo + k0;
-        const int iab = i + ni * (k0 + dhq * j0);
-        ac[iab]       = f(i, j, k, bc[iab]);
-      });
+  // Local copies of member variables for lambda capture
+
+  const int di = di_, dj = dj_, dk = dk_;
+  const int dhq = dhq_, dip = dip_, djp = djp_, djq = djq_;
+  const int idi = idi_, idj = idj_, idk = idk_;
+  const int idp = idp_, idq = idq_;
+  const int mi = mi_, mj = mj_, mk = mk_;
+  const int mp = mp_, mq = mq_;
+  const int nh = nh_, ni = ni_, nj = nj_, nk = nk_;
+
+  // Indices and sizes for pencil redistributions
+
+  const int idip = idi * mp + idp;
+  const int idjq = idj * mq + idq;
+  const int mip  = mi * mp;
+  const int mjq  = mj * mq;
+
+  const int countK = dip * djq * dk;
+  const int countJ = 2 * dip * djq * dhq;
+  const int countI = 2 * dip * djp * dhq;
 
   // Backward FFT in X
-  GPU_Error_Check(cufftExecZ2Z(c2ci_, ac, bc, CUFFT_INVERSE));
+  GPU_Error_Check(Fft::execC2C(c2ci_, ac, bc, CUFFT_INVERSE));
 
   // Rearrange for Y redistribution
   {
@@ -281,43 +442,42 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
           const int rdi = r * di;
           const int ii  = rdi + p * dip + i;
           if ((ii < ni) && (ii < rdi + di)) {
-            const int ia = i + dip * (k + dhq * (j + djp * (p + mp * r)));
-            const int ib = ii + ni * (k + dhq * j);
+            const int ia = i + dip * (j + djp * (k + dhq * (p + mp * r)));
+            const int ib = ii + ni * (j + djp * k);
             ac[ia]       = bc[ib];
           }
         });
   }
 
-  // Redistribute for Y pencils
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countI, MPI_DOUBLE, hb_, countI, MPI_DOUBLE, commI_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countI, MPI_DOUBLE, b, countI, MPI_DOUBLE, commI_);
-  #endif
-
-  // Make Y pencils contiguous in Y
+  // Redistribute for Y pencils, make them contiguous in Y, and apply the
+  // backward FFT in Y, one chunk of Z indices at a time
   {
     const int iLo = idi * di + idp * dip;
     const int iHi = std::min({iLo + dip, (idi + 1) * di, ni});
     const int kLo = idjq * dhq;
     const int kHi = std::min(kLo + dhq, nh);
-    gpuFor(
-        kHi - kLo, iHi - iLo, mip, djp, GPU_LAMBDA(const int k, const int i, const int p, const int j) {
-          const int jj = p * djp + j;
-          if (jj < nj) {
-            const int ia = jj + nj * (i + dip * k);
-            const int ib = i + dip * (k + dhq * (j + djp * p));
-            ac[ia]       = bc[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countI, dhq, commI_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const Complex *const src = reinterpret_cast<const Complex *>(transpose.wait(c));
+      const int k0                        = transpose.lo(c);
+      const int nk0                       = transpose.hi(c) - k0;
+      gpuFor(
+          std::min(nk0, kHi - kLo - k0), iHi - iLo, mip, djp,
+          GPU_LAMBDA(const int k1, const int i, const int p, const int j) {
+            const int k  = k0 + k1;
+            const int jj = p * djp + j;
+            if (jj < nj) {
+              const int ia = jj + nj * (i + dip * k);
+              const int ib = i + dip * (j + djp * (k + dhq * p));
+              ac[ia]       = src[ib];
+            }
+          });
+      const cufftHandle c2cj = FFTCache::plan(nj, nj, 1, nj, nj, 1, nj, Fft::c2c, nk0 * dip);
+      const long offset      = long(k0) * dip * nj;
+      GPU_Error_Check(Fft::execC2C(c2cj, ac + offset, bc + offset, CUFFT_INVERSE));
+    }
   }
 
-  // Backward FFT in Y
-  GPU_Error_Check(cufftExecZ2Z(c2cj_, ac, bc, CUFFT_INVERSE));
-
   // Rearrange for Z redistribution
   {
     const int iLo = idi * di + idp * dip;
@@ -329,43 +489,41 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
           const int rdj = r * dj;
           const int jj  = rdj + q * djq + j;
           if ((jj < nj) && (jj < rdj + dj)) {
-            const int ia = j + djq * (i + dip * (k + dhq * (q + mq * r)));
+            const int ia = k + dhq * (j + djq * (i + dip * (q + mq * r)));
             const int ib = jj + nj * (i + dip * k);
             ac[ia]       = bc[ib];
           }
         });
   }
 
-  // Redistribute in Z pencils
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countJ, MPI_DOUBLE, hb_, countJ, MPI_DOUBLE, commJ_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countJ, MPI_DOUBLE, b, countJ, MPI_DOUBLE, commJ_);
-  #endif
-
-  // Make Z pencils contiguous in Z
+  // Redistribute in Z pencils, make them contiguous in Z, and apply the
+  // complex-to-real FFT in Z, one chunk of X indices at a time
   {
     const int iLo = idi * di + idp * dip;
     const int iHi = std::min({iLo + dip, (idi + 1) * di, ni});
     const int jLo = idj * dj + idq * djq;
     const int jHi = std::min({jLo + djq, (idj + 1) * dj, nj});
-    gpuFor(
-        iHi - iLo, jHi - jLo, mjq, dhq, GPU_LAMBDA(const int i, const int j, const int q, const int k) {
-          const int kk = q * dhq + k;
-          if (kk < nh) {
-            const int ia = kk + nh * (j + djq * i);
-            const int ib = j + djq * (i + dip * (k + dhq * q));
-            ac[ia]       = bc[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countJ, dip, commJ_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const Complex *const src = reinterpret_cast<const Complex *>(transpose.wait(c));
+      const int i0                        = transpose.lo(c);
+      const int ni0                       = transpose.hi(c) - i0;
+      gpuFor(
+          std::min(ni0, iHi - iLo - i0), jHi - jLo, mjq, dhq,
+          GPU_LAMBDA(const int i1, const int j, const int q, const int k) {
+            const int i  = i0 + i1;
+            const int kk = q * dhq + k;
+            if (kk < nh) {
+              const int ia = kk + nh * (j + djq * i);
+              const int ib = k + dhq * (j + djq * (i + dip * q));
+              ac[ia]       = src[ib];
+            }
+          });
+      const cufftHandle c2rk = FFTCache::plan(nk, nh, 1, nh, nk, 1, nk, Fft::c2r, ni0 * djq);
+      GPU_Error_Check(Fft::execC2R(c2rk, ac + long(i0) * djq * nh, b + long(i0) * djq * nk));
+    }
   }
 
-  // Complex-to-real FFT in Z
-  GPU_Error_Check(cufftExecZ2D(c2rk_, ac, b));
-
   // Rearrange for 3D-block redistribution
   {
     const int iLo = idi * di + idp * dip;
@@ -383,32 +541,87 @@ void HenryPeriodic::filter(const size_t bytes, double *const before, double *con
         });
   }
 
-  // Redistribute for 3D blocks
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, a, bytes, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, countK, MPI_DOUBLE, hb_, countK, MPI_DOUBLE, commK_);
-  GPU_Error_Check(cudaMemcpy(b, hb_, bytes, cudaMemcpyHostToDevice));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(a, countK, MPI_DOUBLE, b, countK, MPI_DOUBLE, commK_);
-  #endif
-
-  // Rearrange into 3D blocks and apply FFT normalization
+  // Redistribute for 3D blocks, then rearrange into 3D blocks and apply FFT
+  // normalization in double precision, one chunk of X indices at a time
   {
     const double divN = 1.0 / (double(ni) * double(nj) * double(nk));
     const int kLo     = idk * dk;
     const int kHi     = std::min(kLo + dk, nk);
-    gpuFor(
-        mp, dip, mq, djq, kHi - kLo, GPU_LAMBDA(const int p, const int i, const int q, const int j, const int k) {
-          const int ii = p * dip + i;
-          const int jj = q * djq + j;
-          if ((ii < di) && (jj < dj)) {
-            const int ia = k + dk * (jj + dj * ii);
-            const int ib = k + dk * (j + djq * (i + dip * (q + mq * p)));
-            a[ia]        = divN * b[ib];
-          }
-        });
+    HenryTranspose<T> transpose(bytes_, a, b, countK, dip, commK_);
+    for (int c = 0; c < transpose.chunks(); c++) {
+      const T *const src = transpose.wait(c);
+      const int i0            = transpose.lo(c);
+      gpuFor(
+          mp, transpose.hi(c) - i0, mq, djq, kHi - kLo,
+          GPU_LAMBDA(const int p, const int i1, const int q, const int j, const int k) {
+            const int i  = i0 + i1;
+            const int ii = p * dip + i;
+            const int jj = q * djq + j;
+            if ((ii < di) && (jj < dj)) {
+              const int ia = k + dk * (jj + dj * ii);
+              const int ib = k + dk * (j + djq * (i + dip * (q + mq * p)));
+              after[ia]    = divN * double(src[ib]);
+            }
+          });
+    }
   }
 }
 
+template <typename T>
+template <typename F>
+void HenryPeriodic<T>::filter(const size_t bytes, double *const before, double *const after, const F f) const
+{
+  using Complex = typename HenryFFT<T>::Complex;
+  forward(bytes, before, after);
+
+  // Apply filter in frequency space distributed in X pencils
+
+  Complex *const ac = reinterpret_cast<Complex *>(after);
+  Complex *const bc = reinterpret_cast<Complex *>(before);
+  const int ni = ni_, nj = nj_, nh = nh_, djp = djp_, dhq = dhq_;
+  const int idip = idi_ * mp_ + idp_;
+  const int idjq = idj_ * mq_ + idq_;
+  const int jLo  = idip * djp;
+  const int jHi  = std::min(jLo + djp, nj);
+  const int kLo  = idjq * dhq;
+  const int kHi  = std::min(kLo + dhq, nh);
+
+  gpuFor(
+      jHi - jLo, kHi - kLo, ni, GPU_LAMBDA(const int j0, const int k0, const int i) {
+        const int j   = jLo + j0;
+        const int k   = kLo + k0;
+        const int iab = i + ni * (j0 + djp * k0);
+        ac[iab]       = f(i, j, k, bc[iab]);
+      });
+
+  backward(bytes, before, after);
+}
+
+template <typename T>
+template <typename F>
+void HenryPeriodic<T>::spectrum(const size_t bytes, double *const before, double *const after, const F f) const
+{
+  using Complex = typename HenryFFT<T>::Complex;
+  forward(bytes, before, after);
+
+  // Pass the frequency-space values distributed in X pencils to the functor
+
+  const Complex *const bc = reinterpret_cast<const Complex *>(before);
+  const int ni = ni_, nj = nj_, nh = nh_, djp = djp_, dhq = dhq_;
+  const int idip = idi_ * mp_ + idp_;
+  const int idjq = idj_ * mq_ + idq_;
+  const int jLo  = idip * djp;
+  const int jHi  = std::min(jLo + djp, nj);
+  const int kLo  = idjq * dhq;
+  const int kHi  = std::min(kLo + dhq, nh);
+
+  gpuFor(
+      jHi - jLo, kHi - kLo, ni, GPU_LAMBDA(const int j0, const int k0, const int i) {
+        const int j   = jLo + j0;
+        const int k   = kLo + k0;
+        const int iab = i + ni * (j0 + djp * k0);
+        f(i, j, k, bc[iab]);
+      });
+}
+
 #endif
@@ -1,12 +1,33 @@
 #ifdef PARIS
 
+  #include <algorithm>
+  #include <cassert>
+  #include <climits>
   #include <cmath>
 
   #include "ParisPeriodic.hpp"
 
 __host__ __device__ static inline double Sqr(const double x) { return x * x; }
 
-ParisPeriodic::ParisPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3])
+/**
+ * @return { Number of tasks to gather in a dimension with `m` tasks of `d`
+ * elements each. The smallest divisor of `m` that gives blocks of at least
+ * `gatherCells` elements, so the FFT tasks still form a regular grid. }
+ */
+static int Gather_Factor(const int m, const int d, const int gatherCells)
+{
+  int g = 1;
+  while (g < m && long(g) * long(d) < long(gatherCells)) {
+    g++;
+    while (m % g) {
+      g++;
+    }
+  }
+  return g;
+}
+
+ParisPeriodic::ParisPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3],
+                             const int gatherCells)
     : ni_(n[0]),
       nj_(n[1]),
   #ifdef PARIS_3PT
@@ -24,11 +45,133 @@ ParisPeriodic::ParisPeriodic(const int n[3], const double lo[3], const double hi
       ddj_{2.0 * M_PI * double(n[1] - 1) / (double(n[1]) * (hi[1] - lo[1]))},
       ddk_{2.0 * M_PI * double(n[2] - 1) / (double(n[2]) * (hi[2] - lo[2]))},
   #endif
-      henry(n, lo, hi, m, id)
+      gather_{1, 1, 1},
+      dn_{n[0] / m[0], n[1] / m[1], n[2] / m[2]},
+      commGather_(MPI_COMM_NULL),
+      commHenry_(MPI_COMM_NULL),
+      bytes_(0),
+      henry_(nullptr)
+{
+  for (int d = 0; d < 3; d++) {
+    assert(dn_[d] * m[d] == n[d]);
+    gather_[d] = Gather_Factor(m[d], dn_[d], gatherCells);
+  }
+
+  if (gatherTasks() == 1) {
+    henry_ = new HenryPeriodic<ParisReal>(n, lo, hi, m, id);
+    bytes_ = henry_->bytes();
+    return;
+  }
+
+  // Group the tasks by the FFT block they fall in, with the task at the lower
+  // corner of each block first so it is rank 0 of the group
+  const int mg[3]  = {m[0] / gather_[0], m[1] / gather_[1], m[2] / gather_[2]};
+  const int idg[3] = {id[0] / gather_[0], id[1] / gather_[1], id[2] / gather_[2]};
+  const int color  = idg[2] + mg[2] * (idg[1] + mg[1] * idg[0]);
+  const int key    = id[2] % gather_[2] + gather_[2] * (id[1] % gather_[1] + gather_[1] * (id[0] % gather_[0]));
+  MPI_Comm_split(MPI_COMM_WORLD, color, key, &commGather_);
+  MPI_Comm_split(MPI_COMM_WORLD, key ? MPI_UNDEFINED : 0, color, &commHenry_);
+
+  const long local = long(dn_[0]) * long(dn_[1]) * long(dn_[2]);
+  if (key) {
+    bytes_ = local * sizeof(double);
+  } else {
+    henry_         = new HenryPeriodic<ParisReal>(n, lo, hi, mg, idg, commHenry_);
+    const long all = local * long(gatherTasks());
+    assert(all <= INT_MAX);
+    bytes_ = std::max(henry_->bytes(), all * sizeof(double));
+  }
+
+  if (!FFTCache::direct()) {
+    // Reserve the shared host arrays for the gather and scatter
+    FFTCache::host(bytes_ + bytes_);
+  }
+}
+
+ParisPeriodic::~ParisPeriodic()
 {
+  if (henry_) {
+    delete henry_;
+  }
+  if (commHenry_ != MPI_COMM_NULL) {
+    MPI_Comm_free(&commHenry_);
+  }
+  if (commGather_ != MPI_COMM_NULL) {
+    MPI_Comm_free(&commGather_);
+  }
 }
 
 void ParisPeriodic::solve(const size_t bytes, double *const density, double *const potential) const
+{
+  assert(bytes >= bytes_);
+  if (commGather_ == MPI_COMM_NULL) {
+    filter(bytes, density, potential);
+    return;
+  }
+
+  // Gather the density blocks of the group in group order into `potential` on
+  // the FFT task
+  const int count    = dn_[0] * dn_[1] * dn_[2];
+  const int tasks    = gatherTasks();
+  const bool direct  = FFTCache::direct();
+  double *const host = direct ? nullptr : FFTCache::host(bytes_ + bytes_);
+  double *const hb   = direct ? nullptr : host + bytes_ / sizeof(double);
+  if (direct) {
+    GPU_Error_Check(cudaDeviceSynchronize());
+    MPI_Gather(density, count, MPI_DOUBLE, potential, count, MPI_DOUBLE, 0, commGather_);
+  } else {
+    GPU_Error_Check(cudaMemcpy(host, density, sizeof(double) * count, cudaMemcpyDeviceToHost));
+    MPI_Gather(host, count, MPI_DOUBLE, hb, count, MPI_DOUBLE, 0, commGather_);
+    if (henry_) {
+      GPU_Error_Check(cudaMemcpy(potential, hb, sizeof(double) * count * tasks, cudaMemcpyHostToDevice));
+    }
+  }
+
+  if (henry_) {
+    // Local copies of members for lambda capture
+    const int di = dn_[0], dj = dn_[1], dk = dn_[2];
+    const int gj = gather_[1], gk = gather_[2];
+    const int ni = di * gather_[0], nj = dj * gj, nk = dk * gk;
+
+    // Combine the blocks of the group into the block of the FFT task
+    gpuFor(
+        ni, nj, nk, GPU_LAMBDA(const int i, const int j, const int k) {
+          const int p  = i / di;
+          const int q  = j / dj;
+          const int r  = k / dk;
+          const int ia = k - r * dk + dk * (j - q * dj + dj * (i - p * di + di * (r + gk * (q + gj * p))));
+          const int ib = k + nk * (j + nj * i);
+          density[ib]  = potential[ia];
+        });
+
+    filter(bytes, density, potential);
+
+    // Split the potential back into the blocks of the group, in group order
+    gpuFor(
+        ni, nj, nk, GPU_LAMBDA(const int i, const int j, const int k) {
+          const int p  = i / di;
+          const int q  = j / dj;
+          const int r  = k / dk;
+          const int ia = k - r * dk + dk * (j - q * dj + dj * (i - p * di + di * (r + gk * (q + gj * p))));
+          const int ib = k + nk * (j + nj * i);
+          density[ia]  = potential[ib];
+        });
+  }
+
+  // Scatter the potential blocks from `density` on the FFT task
+  if (direct) {
+    GPU_Error_Check(cudaDeviceSynchronize());
+    MPI_Scatter(density, count, MPI_DOUBLE, potential, count, MPI_DOUBLE, 0, commGather_);
+  } else {
+    if (henry_) {
+      GPU_Error_Check(cudaMemcpy(hb, density, sizeof(double) * count * tasks, cudaMemcpyDeviceToHost));
+    }
+    MPI_Scatter(hb, count, MPI_DOUBLE, host, count, MPI_DOUBLE, 0, commGather_);
+    GPU_Error_Check(cudaMemcpy(potential, host, sizeof(double) * count, cudaMemcpyHostToDevice));
+  }
+}
+
+void ParisPeriodic::filter(const size_t bytes, double *const density, double *const potential) const
 {
   // Local copies of members for lambda capture
   const int ni = ni_, nj = nj_;
@@ -47,9 +190,11 @@ void ParisPeriodic::solve(const size_t bytes, double *const density, double *con
   const double sk = 2.0 * M_PI / double(nk);
   #endif
 
-  // Provide FFT filter with a lambda that does Poisson solve in frequency space
-  henry.filter(bytes, density, potential,
-               [=] __device__(const int i, const int j, const int k, const cufftDoubleComplex b) {
+  // Provide FFT filter with a lambda that does Poisson solve in frequency
+  // space. The Green's function is always evaluated in double precision
+  using Complex = HenryFFT<ParisReal>::Complex;
+  henry_->filter(bytes, density, potential,
+               [=] __device__(const int i, const int j, const int k, const Complex b) {
                  if (i || j || k) {
   #ifdef PARIS_3PT
                    const double i2 = Sqr(sin(double(min(i, ni - i)) * si) * ddi);
@@ -68,9 +213,9 @@ void ParisPeriodic::solve(const size_t bytes, double *const density, double *con
           const double k2 = Sqr(double(k) * ddk);
   #endif
                    const double d = -1.0 / (i2 + j2 + k2);
-                   return cufftDoubleComplex{d * b.x, d * b.y};
+                   return Complex{ParisReal(d * b.x), ParisReal(d * b.y)};
                  } else {
-                   return cufftDoubleComplex{0.0, 0.0};
+                   return Complex{0, 0};
                  }
                });
 }
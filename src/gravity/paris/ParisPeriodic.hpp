@@ -2,6 +2,13 @@
 
 #include "HenryPeriodic.hpp"
 
+#ifdef PARIS_FLOAT
+//! Precision of the FFTs in the periodic Poisson solve
+using ParisReal = float;
+#else
+using ParisReal = double;
+#endif
+
 /**
  * @brief Periodic Poisson solver using @ref Henry FFT filter.
  */
@@ -19,18 +26,37 @@ class ParisPeriodic
    * computation of these arguments. }
    * @param[in] m[3] { Number of MPI tasks in each dimension. }
    * @param[in] id[3] { Coordinates of this MPI task, starting at `{0,0,0}`. }
+   * @param[in] gatherCells { Minimum number of cells in each dimension of the
+   * blocks the FFTs run on. Neighboring tasks are gathered onto one FFT task
+   * until its block reaches this size or spans the dimension, and the other
+   * tasks only send their density and receive their potential. 0 never
+   * gathers. }
    */
-  ParisPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3]);
+  ParisPeriodic(const int n[3], const double lo[3], const double hi[3], const int m[3], const int id[3],
+                int gatherCells = 0);
+
+  ~ParisPeriodic();
 
   /**
    * @return { Number of bytes needed for array arguments for @ref solve. }
    */
-  size_t bytes() const { return henry.bytes(); }
+  size_t bytes() const { return bytes_; }
+
+  /**
+   * @return { Number of tasks gathered onto each FFT task, 1 without
+   * gathering. }
+   */
+  int gatherTasks() const { return gather_[0] * gather_[1] * gather_[2]; }
 
   /**
    * @detail { Solves the Poisson equation for the potential derived from the
    * provided density. Assumes periodic boundary conditions. Assumes fields have
-   * no ghost cells. Uses a 3D FFT provided by the @ref Henry class. }
+   * no ghost cells. Uses a 3D FFT provided by the @ref Henry class. With
+   * `PARIS_FLOAT` the FFTs and redistributions are single precision, while the
+   * arguments, the Green's function, and the normalization stay double. When
+   * tasks are gathered, each FFT task gathers the density blocks of its
+   * group, runs the FFTs on the combined block, and scatters the potential
+   * back. }
    * @param[in] bytes { Number of bytes allocated for arguments @ref density and
    * @ref potential. Used to ensure that the arrays have enough extra work
    * space. }
@@ -44,10 +70,20 @@ class ParisPeriodic
   void solve(size_t bytes, double *density, double *potential) const;
 
  private:
+  /**
+   * @brief Solve on the FFT tasks, with the fields in the blocks of @ref henry_.
+   */
+  void filter(size_t bytes, double *density, double *potential) const;
+
   int ni_, nj_;  //!< Number of elements in X and Y dimensions
 #if defined(PARIS_3PT) || defined(PARIS_5PT)
   int nk_;  //!< Number of elements in Z dimension
 #endif
-  double ddi_, ddj_, ddk_;  //!< Frequency-independent terms in Poisson solve
-  HenryPeriodic henry;      //!< FFT filter object
+  double ddi_, ddj_, ddk_;           //!< Frequency-independent terms in Poisson solve
+  int gather_[3];                    //!< Number of tasks gathered in each dimension
+  int dn_[3];                        //!< Number of local elements of each task in each dimension
+  MPI_Comm commGather_;              //!< Tasks gathered onto the same FFT task, `MPI_COMM_NULL` without gathering
+  MPI_Comm commHenry_;               //!< FFT tasks, `MPI_COMM_NULL` on the other tasks
+  size_t bytes_;                     //!< Max bytes needed for argument arrays
+  HenryPeriodic<ParisReal> *henry_;  //!< FFT filter object, null on the tasks that are not FFT tasks
 };
@@ -5,13 +5,39 @@
   #include <cmath>
   #include <cstdio>
   #include <cstdlib>
+  #include <vector>
 
+  #include "FFTCache.hpp"
   #include "PoissonZero3DBlockedGPU.hpp"
 
+  #include "../../utils/device_memory_pool.h"
+
 static constexpr double sqrt2 = 0.4142135623730950488016887242096980785696718753769480731766797379;
 
 static inline __host__ __device__ double Sqr(const double x) { return x * x; }
 
+// Eigenvalue of the discrete Laplacian for the sine mode x of n points
+static double Eigenvalue(const int x, const int n, const double dd)
+{
+  #ifdef PARIS_GALACTIC_3PT
+  return Sqr(sin(M_PI * double(x) / double(n + n)) * dd);
+  #elif defined PARIS_GALACTIC_5PT
+  const double c = cos(M_PI * double(x) / double(n));
+  return dd * (2.0 * c * c - 16.0 * c + 14.0);
+  #else
+  return Sqr(double(x) * dd);
+  #endif
+}
+
+// Twiddles cos and sin of pi x / 2n for the sine modes x of n points
+static void Twiddles(const int n, double *const w)
+{
+  for (int x = 0; x <= n / 2; x++) {
+    w[x + x]     = cos(M_PI * double(x) / double(n + n));
+    w[x + x + 1] = sin(M_PI * double(x) / double(n + n));
+  }
+}
+
 PoissonZero3DBlockedGPU::PoissonZero3DBlockedGPU(const int n[3], const double lo[3], const double hi[3], const int m[3],
                                                  const int id[3])
     :
@@ -36,7 +62,8 @@ PoissonZero3DBlockedGPU::PoissonZero3DBlockedGPU(const int n[3], const double lo
       mk_(m[2]),
       ni_(n[0]),
       nj_(n[1]),
-      nk_(n[2])
+      nk_(n[2]),
+      tables_(nullptr)
 {
   mq_ = int(round(Sqr(mk_)));
   while (mk_ % mq_) {
@@ -83,31 +110,63 @@ PoissonZero3DBlockedGPU::PoissonZero3DBlockedGPU(const int n[3], const double lo
                               dip_ * dkq_ * mip * djp_, dkq_ * djp_ * mip * dip_, dkq_ * djp_ * ni2_});
   bytes_          = nMax * sizeof(double);
 
-  int nkh = nk_ / 2 + 1;
-  GPU_Error_Check(cufftPlanMany(&d2zk_, 1, &nk_, &nk_, 1, nk_, &nkh, 1, nkh, CUFFT_D2Z, dip_ * djq_));
-  int njh = nj_ / 2 + 1;
-  GPU_Error_Check(cufftPlanMany(&d2zj_, 1, &nj_, &nj_, 1, nj_, &njh, 1, njh, CUFFT_D2Z, dip_ * dkq_));
-  int nih = ni_ / 2 + 1;
-  GPU_Error_Check(cufftPlanMany(&d2zi_, 1, &ni_, &ni_, 1, ni_, &nih, 1, nih, CUFFT_D2Z, dkq_ * djp_));
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaHostAlloc(&ha_, bytes_ + bytes_, cudaHostAllocDefault));
-  assert(ha_);
-  hb_ = ha_ + nMax;
-  #endif
+  // FFT objects, shared with any other solver using the same shapes
+  const int nkh = nk_ / 2 + 1;
+  d2zk_         = FFTCache::plan(nk_, nk_, 1, nk_, nkh, 1, nkh, CUFFT_D2Z, dip_ * djq_);
+  const int njh = nj_ / 2 + 1;
+  d2zj_         = FFTCache::plan(nj_, nj_, 1, nj_, njh, 1, njh, CUFFT_D2Z, dip_ * dkq_);
+  const int nih = ni_ / 2 + 1;
+  d2zi_         = FFTCache::plan(ni_, ni_, 1, ni_, nih, 1, nih, CUFFT_D2Z, dkq_ * djp_);
+  if (!FFTCache::direct()) {
+    // Reserve the shared host arrays for MPI communication
+    FFTCache::host(bytes_ + bytes_);
+  }
+
+  // Tables of the twiddles of the sine transforms and of the eigenvalues of
+  // the Laplacian, so the kernels load them instead of evaluating sines and
+  // cosines at every element of every solve
+  const int nei = ni_ + 1;
+  const int nej = mip * djp_ + 1;
+  const int nek = mjq * dkq_ + 1;
+  std::vector<double> tables(ni2_ + nj2_ + nk2_ + nei + nej + nek);
+  double *const hwi = tables.data();
+  double *const hwj = hwi + ni2_;
+  double *const hwk = hwj + nj2_;
+  double *const hei = hwk + nk2_;
+  double *const hej = hei + nei;
+  double *const hek = hej + nej;
+  Twiddles(ni_, hwi);
+  Twiddles(nj_, hwj);
+  Twiddles(nk_, hwk);
+  for (int i = 0; i < nei; i++) {
+    hei[i] = Eigenvalue(i, ni_, ddi_);
+  }
+  for (int j = 0; j < nej; j++) {
+    hej[j] = Eigenvalue(j, nj_, ddj_);
+  }
+  for (int k = 0; k < nek; k++) {
+    hek[k] = Eigenvalue(k, nk_, ddk_);
+  }
+  {
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+    cuda_utilities::Pool_Malloc(&tables_, tables.size() * sizeof(double));
+  }
+  GPU_Error_Check(cudaMemcpy(tables_, tables.data(), tables.size() * sizeof(double), cudaMemcpyHostToDevice));
+  wi_ = tables_;
+  wj_ = wi_ + ni2_;
+  wk_ = wj_ + nj2_;
+  ei_ = wk_ + nk2_;
+  ej_ = ei_ + nei;
+  ek_ = ej_ + nej;
 }
 
 PoissonZero3DBlockedGPU::~PoissonZero3DBlockedGPU()
 {
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaFreeHost(ha_));
-  ha_ = hb_ = nullptr;
-  #endif
-  GPU_Error_Check(cufftDestroy(d2zi_));
-  GPU_Error_Check(cufftDestroy(d2zj_));
-  GPU_Error_Check(cufftDestroy(d2zk_));
+  // The FFT plans and host arrays belong to the FFTCache
   MPI_Comm_free(&commI_);
   MPI_Comm_free(&commJ_);
   MPI_Comm_free(&commK_);
+  cuda_utilities::Pool_Free(tables_);
 }
 
 void Print(const char *const title, const int ni, const int nj, const int nk, const double *const v)
@@ -125,6 +184,25 @@ void Print(const char *const title, const int ni, const int nj, const int nk, co
   printf("\n");
 }
 
+void PoissonZero3DBlockedGPU::transpose(const double *const a, double *const b, const int count, MPI_Comm comm) const
+{
+  // Move only the messages, not the whole work arrays
+  int tasks = 0;
+  MPI_Comm_size(comm, &tasks);
+  const size_t messageBytes = sizeof(double) * size_t(count) * size_t(tasks);
+  assert(messageBytes <= size_t(bytes_));
+  if (!FFTCache::direct()) {
+    double *const ha = FFTCache::host(bytes_ + bytes_);
+    double *const hb = ha + bytes_ / sizeof(double);
+    GPU_Error_Check(cudaMemcpy(ha, a, messageBytes, cudaMemcpyDeviceToHost));
+    MPI_Alltoall(ha, count, MPI_DOUBLE, hb, count, MPI_DOUBLE, comm);
+    GPU_Error_Check(cudaMemcpyAsync(b, hb, messageBytes, cudaMemcpyHostToDevice, 0));
+  } else {
+    GPU_Error_Check(cudaDeviceSynchronize());
+    MPI_Alltoall(a, count, MPI_DOUBLE, b, count, MPI_DOUBLE, comm);
+  }
+}
+
 void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, double *const potential) const
 {
   assert(bytes >= bytes_);
@@ -135,28 +213,31 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
   double *const ub = density;
   auto *const uc   = reinterpret_cast<cufftDoubleComplex *>(ub);
 
-  const double ddi = ddi_;
-  const double ddj = ddj_;
-  const double ddk = ddk_;
-  const int di     = di_;
-  const int dip    = dip_;
-  const int dj     = dj_;
-  const int djp    = djp_;
-  const int djq    = djq_;
-  const int dk     = dk_;
-  const int dkq    = dkq_;
-  const int idi    = idi_;
-  const int idj    = idj_;
-  const int idp    = idp_;
-  const int idq    = idq_;
-  const int mp     = mp_;
-  const int mq     = mq_;
-  const int ni     = ni_;
-  const int ni2    = ni2_;
-  const int nj     = nj_;
-  const int nj2    = nj2_;
-  const int nk     = nk_;
-  const int nk2    = nk2_;
+  const double *const wi = wi_;
+  const double *const wj = wj_;
+  const double *const wk = wk_;
+  const double *const ei = ei_;
+  const double *const ej = ej_;
+  const double *const ek = ek_;
+  const int di           = di_;
+  const int dip          = dip_;
+  const int dj           = dj_;
+  const int djp          = djp_;
+  const int djq          = djq_;
+  const int dk           = dk_;
+  const int dkq          = dkq_;
+  const int idi          = idi_;
+  const int idj          = idj_;
+  const int idp          = idp_;
+  const int idq          = idq_;
+  const int mp           = mp_;
+  const int mq           = mq_;
+  const int ni           = ni_;
+  const int ni2          = ni2_;
+  const int nj           = nj_;
+  const int nj2          = nj2_;
+  const int nk           = nk_;
+  const int nk2          = nk2_;
 
   gpuFor(
       mp, mq, dip, djq, dk, GPU_LAMBDA(const int p, const int q, const int i, const int j, const int k) {
@@ -166,14 +247,7 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           ua[(((p * mq + q) * dip + i) * djq + j) * dk + k] = ub[((i + iLo) * dj + j + jLo) * dk + k];
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dip * djq * dk, MPI_DOUBLE, hb_, dip * djq * dk, MPI_DOUBLE, commK_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dip * djq * dk, MPI_DOUBLE, ub, dip * djq * dk, MPI_DOUBLE, commK_);
-  #endif
+  transpose(ua, ub, dip * djq * dk, commK_);
   gpuFor(
       dip, djq, nk / 2 + 1, GPU_LAMBDA(const int i, const int j, const int k) {
         const int ij = (i * djq + j) * nk;
@@ -205,26 +279,19 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           const int ka                              = (nk / 2 - 1) % dkq;
           ua[((qa * dip + i) * dkq + ka) * djq + j] = sqrt2 * ub[(i * djq + j) * nk2 + nk];
         } else {
-          const int qa    = (nk - k - 1) / dkq;
-          const int ka    = (nk - k - 1) % dkq;
-          const int qb    = (k - 1) / dkq;
-          const int kb    = (k - 1) % dkq;
-          const double ak = 2.0 * ub[(i * djq + j) * nk2 + 2 * k];
-          const double bk = 2.0 * ub[(i * djq + j) * nk2 + 2 * k + 1];
-          double wa, wb;
-          sincospi(double(k) / double(nk + nk), &wb, &wa);
+          const int qa                              = (nk - k - 1) / dkq;
+          const int ka                              = (nk - k - 1) % dkq;
+          const int qb                              = (k - 1) / dkq;
+          const int kb                              = (k - 1) % dkq;
+          const double ak                           = 2.0 * ub[(i * djq + j) * nk2 + 2 * k];
+          const double bk                           = 2.0 * ub[(i * djq + j) * nk2 + 2 * k + 1];
+          const double wa                           = wk[k + k];
+          const double wb                           = wk[k + k + 1];
           ua[((qa * dip + i) * dkq + ka) * djq + j] = wa * ak + wb * bk;
           ua[((qb * dip + i) * dkq + kb) * djq + j] = wb * ak - wa * bk;
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dip * dkq * djq, MPI_DOUBLE, hb_, dip * dkq * djq, MPI_DOUBLE, commJ_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dip * dkq * djq, MPI_DOUBLE, ub, dip * dkq * djq, MPI_DOUBLE, commJ_);
-  #endif
+  transpose(ua, ub, dip * dkq * djq, commJ_);
   gpuFor(
       dip, dkq, nj / 2 + 1, GPU_LAMBDA(const int i, const int k, const int j) {
         const int ik = (i * dkq + k) * nj;
@@ -255,10 +322,10 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           const int ja                              = (nj / 2 - 1) % djp;
           ua[((pa * dkq + k) * djp + ja) * dip + i] = sqrt2 * ub[(i * dkq + k) * nj2 + nj];
         } else {
-          const double aj = 2.0 * ub[(i * dkq + k) * nj2 + 2 * j];
-          const double bj = 2.0 * ub[(i * dkq + k) * nj2 + 2 * j + 1];
-          double wa, wb;
-          sincospi(double(j) / double(nj + nj), &wb, &wa);
+          const double aj                           = 2.0 * ub[(i * dkq + k) * nj2 + 2 * j];
+          const double bj                           = 2.0 * ub[(i * dkq + k) * nj2 + 2 * j + 1];
+          const double wa                           = wj[j + j];
+          const double wb                           = wj[j + j + 1];
           const int pa                              = (nj - j - 1) / djp;
           const int ja                              = (nj - j - 1) % djp;
           const int pb                              = (j - 1) / djp;
@@ -267,14 +334,7 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           ua[((pb * dkq + k) * djp + jb) * dip + i] = wb * aj - wa * bj;
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dkq * djp * dip, MPI_DOUBLE, hb_, dkq * djp * dip, MPI_DOUBLE, commI_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dkq * djp * dip, MPI_DOUBLE, ub, dkq * djp * dip, MPI_DOUBLE, commI_);
-  #endif
+  transpose(ua, ub, dkq * djp * dip, commI_);
   gpuFor(
       dkq, djp, ni / 2 + 1, GPU_LAMBDA(const int k, const int j, const int i) {
         const int kj = (k * djp + j) * ni;
@@ -298,64 +358,25 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
       });
   GPU_Error_Check(cufftExecD2Z(d2zi_, ua, uc));
   {
-  #ifdef PARIS_GALACTIC_3PT
-    const double si  = M_PI / double(ni + ni);
-    const double sj  = M_PI / double(nj + nj);
-    const double sk  = M_PI / double(nk + nk);
-    const double iin = Sqr(sin(double(ni) * si) * ddi);
-  #elif defined PARIS_GALACTIC_5PT
-    const double si  = M_PI / double(ni);
-    const double sj  = M_PI / double(nj);
-    const double sk  = M_PI / double(nk);
-    const double cin = cos(double(ni) * si);
-    const double iin = ddi * (2.0 * cin * cin - 16.0 * cin + 14.0);
-  #else
-    const double iin = Sqr(double(ni) * ddi);
-  #endif
     const int jLo = (idi * mp + idp) * djp;
     const int kLo = (idj * mq + idq) * dkq;
     gpuFor(
         dkq, djp, ni / 2 + 1, GPU_LAMBDA(const int k, const int j, const int i) {
-          const int kj  = (k * djp + j) * ni;
-          const int kj2 = (k * djp + j) * ni2;
-  #ifdef PARIS_GALACTIC_3PT
-          const double jjkk = Sqr(sin(double(jLo + j + 1) * sj) * ddj) + Sqr(sin(double(kLo + k + 1) * sk) * ddk);
-  #elif defined PARIS_GALACTIC_5PT
-          const double cj   = cos(double(jLo + j + 1) * sj);
-          const double jj   = ddj * (2.0 * cj * cj - 16.0 * cj + 14.0);
-          const double ck   = cos(double(kLo + k + 1) * sk);
-          const double kk   = ddk * (2.0 * ck * ck - 16.0 * ck + 14.0);
-          const double jjkk = jj + kk;
-  #else
-          const double jjkk =
-              Sqr(double(jLo + j + 1) * ddj) + Sqr(double(kLo + k + 1) * ddk);
-  #endif
+          const int kj      = (k * djp + j) * ni;
+          const int kj2     = (k * djp + j) * ni2;
+          const double jjkk = ej[jLo + j + 1] + ek[kLo + k + 1];
           if (i == 0) {
-            ua[kj] = -2.0 * ub[kj2] / (iin + jjkk);
+            ua[kj] = -2.0 * ub[kj2] / (ei[ni] + jjkk);
           } else {
-  #ifdef PARIS_GALACTIC_3PT
-            const double ii = Sqr(sin(double(i) * si) * ddi);
-  #elif defined PARIS_GALACTIC_5PT
-            const double ci = cos(double(i) * si);
-            const double ii = ddi * (2.0 * ci * ci - 16.0 * ci + 14.0);
-  #else
-            const double ii = Sqr(double(i) * ddi);
-  #endif
+            const double ii = ei[i];
             if (i + i == ni) {
               ua[kj + ni / 2] = -2.0 * ub[kj2 + ni] / (ii + jjkk);
             } else {
-              const double ai = 2.0 * ub[kj2 + 2 * i];
-              const double bi = 2.0 * ub[kj2 + 2 * i + 1];
-              double wa, wb;
-              sincospi(double(i) / double(ni + ni), &wb, &wa);
-  #ifdef PARIS_GALACTIC_3PT
-              const double nii = t(sin(double(ni - i) * si) * ddi);
-  #elif defined PARIS_GALACTIC_5PT
-              const double cni = cos(double(ni - i) * si);
-              const double nii = ddi * (2.0 * cni * cni - 16.0 * cni + 14.0);
-  #else
-              const double nii = Sqr(double(ni - i) * ddi);
-  #endif
+              const double ai  = 2.0 * ub[kj2 + 2 * i];
+              const double bi  = 2.0 * ub[kj2 + 2 * i + 1];
+              const double wa  = wi[i + i];
+              const double wb  = wi[i + i + 1];
+              const double nii = ei[ni - i];
               const double aai = -(wa * ai + wb * bi) / (nii + jjkk);
               const double bbi = (wa * bi - wb * ai) / (ii + jjkk);
               const double apb = aai + bbi;
@@ -389,14 +410,7 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           ua[(((idb * mp + pb) * dkq + k) * dip + ib) * djp + j] = ai + bi;
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dkq * djp * dip, MPI_DOUBLE, hb_, dkq * djp * dip, MPI_DOUBLE, commI_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dkq * djp * dip, MPI_DOUBLE, ub, dkq * djp * dip, MPI_DOUBLE, commI_);
-  #endif
+  transpose(ua, ub, dkq * djp * dip, commI_);
   gpuFor(
       dkq, dip, nj / 2 + 1, GPU_LAMBDA(const int k, const int i, const int j) {
         const long ki = (k * dip + i) * nj;
@@ -417,10 +431,10 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           const double bj  = ub[((pb * dkq + k) * dip + i) * djp + jb];
           const double apb = aj + bj;
           const double amb = aj - bj;
-          double wa, wb;
-          sincospi(double(j) / double(nj + nj), &wb, &wa);
-          ua[ki + j]      = wa * amb + wb * apb;
-          ua[ki + nj - j] = wa * apb - wb * amb;
+          const double wa  = wj[j + j];
+          const double wb  = wj[j + j + 1];
+          ua[ki + j]       = wa * amb + wb * apb;
+          ua[ki + nj - j]  = wa * apb - wb * amb;
         }
       });
   GPU_Error_Check(cufftExecD2Z(d2zj_, ua, uc));
@@ -447,14 +461,7 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           ua[(((idb * mq + qb) * dip + i) * djq + jb) * dkq + k] = aj + bj;
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dip * djq * dkq, MPI_DOUBLE, hb_, dip * djq * dkq, MPI_DOUBLE, commJ_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dip * djq * dkq, MPI_DOUBLE, ub, dip * djq * dkq, MPI_DOUBLE, commJ_);
-  #endif
+  transpose(ua, ub, dip * djq * dkq, commJ_);
   gpuFor(
       dip, djq, nk / 2 + 1, GPU_LAMBDA(const int i, const int j, const int k) {
         const long ij = (i * djq + j) * nk;
@@ -475,10 +482,10 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           const double bk  = ub[((qb * dip + i) * djq + j) * dkq + kb];
           const double apb = ak + bk;
           const double amb = ak - bk;
-          double wa, wb;
-          sincospi(double(k) / double(nk + nk), &wb, &wa);
-          ua[ij + k]      = wa * amb + wb * apb;
-          ua[ij + nk - k] = wa * apb - wb * amb;
+          const double wa  = wk[k + k];
+          const double wb  = wk[k + k + 1];
+          ua[ij + k]       = wa * amb + wb * apb;
+          ua[ij + nk - k]  = wa * apb - wb * amb;
         }
       });
   GPU_Error_Check(cufftExecD2Z(d2zk_, ua, uc));
@@ -503,14 +510,7 @@ void PoissonZero3DBlockedGPU::solve(const long bytes, double *const density, dou
           ua[((pqb * dip + i) * djq + j) * dk + kb] = divN * (ak + bk);
         }
       });
-  #ifndef MPI_GPU
-  GPU_Error_Check(cudaMemcpy(ha_, ua, bytes_, cudaMemcpyDeviceToHost));
-  MPI_Alltoall(ha_, dip * djq * dk, MPI_DOUBLE, hb_, dip * djq * dk, MPI_DOUBLE, commK_);
-  GPU_Error_Check(cudaMemcpyAsync(ub, hb_, bytes_, cudaMemcpyHostToDevice, 0));
-  #else
-  GPU_Error_Check(cudaDeviceSynchronize());
-  MPI_Alltoall(ua, dip * djq * dk, MPI_DOUBLE, ub, dip * djq * dk, MPI_DOUBLE, commK_);
-  #endif
+  transpose(ua, ub, dip * djq * dk, commK_);
   gpuFor(
       mp, dip, mq, djq, dk, GPU_LAMBDA(const int p, const int i, const int q, const int j, const int k) {
         const int iLo = p * dip;
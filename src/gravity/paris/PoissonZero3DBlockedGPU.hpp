@@ -13,6 +13,9 @@ class PoissonZero3DBlockedGPU
   void solve(long bytes, double *density, double *potential) const;
 
  private:
+  // All-to-all of count doubles per task of comm, from a to b on the device
+  void transpose(const double *a, double *b, int count, MPI_Comm comm) const;
+
   double ddi_, ddj_, ddk_;
   int idi_, idj_, idk_;
   int mi_, mj_, mk_;
@@ -24,8 +27,10 @@ class PoissonZero3DBlockedGPU
   int dip_, djp_, djq_, dkq_;
   int ni2_, nj2_, nk2_;
   long bytes_;
-  cufftHandle d2zi_, d2zj_, d2zk_;
-#ifndef MPI_GPU
-  double *ha_, *hb_;
-#endif
+  cufftHandle d2zi_, d2zj_, d2zk_;  // Owned by FFTCache
+  // Device twiddles of the sine transforms, cos and sin of pi x / 2n, and
+  // eigenvalues of the Laplacian for every sine mode x, all in tables_
+  double *tables_;
+  const double *wi_, *wj_, *wk_;
+  const double *ei_, *ej_, *ek_;
 };
@@ -2,6 +2,7 @@
 
   #include "../gravity/potential_SOR_3D.h"
 
+  #include <algorithm>
   #include <cmath>
   #include <iostream>
 
@@ -43,7 +44,14 @@ void Potential_SOR_3D::Initialize(Real Lx, Real Ly, Real Lz, Real x_min, Real y_
   n_cells_potential = nx_pot * ny_pot * nz_pot;
   n_cells_total     = nx_total * ny_total * nz_total;
 
-  n_ghost_transfer = 1;
+  // SOR transfers n_halo ghost cells at a time and updates them redundantly in
+  // between, only transferring the boundaries every n_halo half iterations
+  #if defined(MULTIGRID) || defined(HALF_SIZE_BOUNDARIES)
+  n_halo = 1;
+  #else
+  n_halo = n_ghost;
+  #endif
+  n_ghost_transfer = n_halo;
 
   size_buffer_x = n_ghost_transfer * ny_pot * nz_pot;
   size_buffer_y = n_ghost_transfer * nx_pot * nz_pot;
@@ -76,15 +84,25 @@ void Potential_SOR_3D::Initialize(Real Lx, Real Ly, Real Lz, Real x_min, Real y_
   // Flag to transfer Poisson Boundaries when calling Set_Boundaries
   TRANSFER_POISSON_BOUNDARIES = false;
 
+  #ifdef MULTIGRID
+  chprintf(" Using Poisson Solver: SOR Multigrid\n");
+  #else
   chprintf(" Using Poisson Solver: SOR\n");
+  #endif
   chprintf("  SOR: L[ %f %f %f ] N[ %d %d %d ] dx[ %f %f %f ]\n", Lbox_x, Lbox_y, Lbox_z, nx_local, ny_local, nz_local,
            dx, dy, dz);
 
   chprintf("  SOR: Allocating memory...\n");
   AllocateMemory_CPU();
   AllocateMemory_GPU();
+  #ifdef MULTIGRID
+  Multigrid_Initialize();
+  #endif
+  Set_Transfer_Level(0);
 
-  potential_initialized = false;
+  potential_initialized      = false;
+  potential_prev_initialized = false;
+  n_iter_previous            = 0;
 }
 
 void Potential_SOR_3D::AllocateMemory_CPU(void)
@@ -98,6 +116,10 @@ void Potential_SOR_3D::AllocateMemory_GPU(void)
   Allocate_Array_GPU_Real(&F.input_d, n_cells_local);
   Allocate_Array_GPU_Real(&F.density_d, n_cells_local);
   Allocate_Array_GPU_Real(&F.potential_d, n_cells_potential);
+  Allocate_Array_GPU_Real(&F.density_halo_d, n_cells_potential);
+  Allocate_Array_GPU_Real(&F.potential_prev_d, n_cells_potential);
+  // The ghost cells of the density at the isolated boundaries are never used
+  GPU_Error_Check(cudaMemset(F.density_halo_d, 0, n_cells_potential * sizeof(Real)));
   Allocate_Array_GPU_bool(&F.converged_d, 1);
   Allocate_Array_GPU_Real(&F.boundaries_buffer_x0_d, size_buffer_x);
   Allocate_Array_GPU_Real(&F.boundaries_buffer_x1_d, size_buffer_x);
@@ -129,8 +151,79 @@ void Potential_SOR_3D::AllocateMemory_GPU(void)
   #endif
 }
 
+void Potential_SOR_3D::Set_Transfer_Array(Real *array_d, int nx, int ny, int nz, int n_ghost_array, int n_layers)
+{
+  transfer_potential_d = array_d;
+  transfer_nx          = nx;
+  transfer_ny          = ny;
+  transfer_nz          = nz;
+  transfer_n_ghost     = n_ghost_array;
+  n_ghost_transfer     = n_layers;
+
+  #ifndef HALF_SIZE_BOUNDARIES
+  // The transfer buffers are allocated for n_halo layers of the potential,
+  // smaller transfers only use the beginning of them
+  size_buffer_x = n_ghost_transfer * (ny + 2 * n_ghost_array) * (nz + 2 * n_ghost_array);
+  size_buffer_y = n_ghost_transfer * (nx + 2 * n_ghost_array) * (nz + 2 * n_ghost_array);
+  size_buffer_z = n_ghost_transfer * (nx + 2 * n_ghost_array) * (ny + 2 * n_ghost_array);
+  #endif
+}
+
+void Potential_SOR_3D::Set_Transfer_Level(int level)
+{
+  #ifdef MULTIGRID
+  MG_Level const &mg = mg_levels[level];
+  Set_Transfer_Array(mg.phi_d, mg.nx, mg.ny, mg.nz, mg.n_ghost, 1);
+  #else
+  Set_Transfer_Array(F.potential_d, nx_local, ny_local, nz_local, n_ghost, n_halo);
+  #endif
+}
+
+  #ifdef MULTIGRID
+void Potential_SOR_3D::Multigrid_Initialize(void)
+{
+  // Level 0 is the SOR grid itself
+  mg_levels.clear();
+  mg_levels.push_back({nx_local, ny_local, nz_local, n_ghost, dx, F.potential_d, F.density_d});
+
+  // Halve the local grid while every direction stays even and at least 2 cells
+  // wide. With MPI the coarsening stops at the local grid of each process
+  while (true) {
+    MG_Level const &fine = mg_levels.back();
+    if (fine.nx % 2 != 0 || fine.ny % 2 != 0 || fine.nz % 2 != 0) break;
+    if (fine.nx < 4 || fine.ny < 4 || fine.nz < 4) break;
+
+    MG_Level coarse;
+    coarse.nx      = fine.nx / 2;
+    coarse.ny      = fine.ny / 2;
+    coarse.nz      = fine.nz / 2;
+    coarse.n_ghost = 1;
+    coarse.dx      = 2 * fine.dx;
+    Allocate_Array_GPU_Real(&coarse.phi_d, (coarse.nx + 2) * (coarse.ny + 2) * (coarse.nz + 2));
+    Allocate_Array_GPU_Real(&coarse.rhs_d, coarse.nx * coarse.ny * coarse.nz);
+    mg_levels.push_back(coarse);
+  }
+  Allocate_Array_GPU_Real(&mg_norms_d, 2);
+
+  chprintf("  Multigrid: %d levels, coarsest N[ %d %d %d ]\n", (int)mg_levels.size(), mg_levels.back().nx,
+           mg_levels.back().ny, mg_levels.back().nz);
+}
+
+void Potential_SOR_3D::Multigrid_Free(void)
+{
+  // Level 0 uses the SOR arrays, freed in FreeMemory_GPU
+  for (size_t level = 1; level < mg_levels.size(); level++) {
+    Free_Array_GPU_Real(mg_levels[level].phi_d);
+    Free_Array_GPU_Real(mg_levels[level].rhs_d);
+  }
+  mg_levels.clear();
+  Free_Array_GPU_Real(mg_norms_d);
+}
+  #endif  // MULTIGRID
+
 void Potential_SOR_3D::Copy_Input_And_Initialize(Real *input_density, const Real *const input_potential,
-                                                 Real Grav_Constant, Real dens_avrg, Real current_a)
+                                                 Real Grav_Constant, Real dens_avrg, Real current_a, Real dt_now,
+                                                 Real dt_prev)
 {
   Copy_Input(n_cells_local, F.input_d, input_density, Grav_Constant, dens_avrg, current_a);
 
@@ -141,6 +234,9 @@ void Potential_SOR_3D::Copy_Input_And_Initialize(Real *input_density, const Real
     // Initialize_Potential( nx_local, ny_local, nz_local, n_ghost,
     // F.potential_d, F.density_d );
     potential_initialized = true;
+  } else {
+    // Start from the previous solutions extrapolated to the current time
+    Warm_Start_Potential(dt_now, dt_prev);
   }
 }
 
@@ -162,71 +258,88 @@ void Grid3D::Get_Potential_SOR(Real Grav_Constant, Real dens_avrg, Real current_
   #endif
 
   Grav.Poisson_solver.Copy_Input_And_Initialize(Grav.F.density_h, Grav.F.potential_h, Grav_Constant, dens_avrg,
-                                                current_a);
+                                                current_a, Grav.dt_now, Grav.dt_prev);
 
   // Set Isolated Boundary Conditions
   Grav.Copy_Isolated_Boundaries_To_GPU(P);
   Grav.Poisson_solver.Set_Isolated_Boundary_Conditions(Grav.boundary_flags, P);
 
+  #ifdef MULTIGRID
+  Multigrid_Solve(P);
+  #else
+  Potential_SOR_3D &solver = Grav.Poisson_solver;
+
   Real epsilon = 1e-4;
   int max_iter = 10000000;
   int n_iter   = 0;
 
-  Grav.Poisson_solver.F.converged_h[0] = 0;
-
   // For Diriclet Boundaries
-  Real omega = 2. / (1 + M_PI / Grav.Poisson_solver.nx_total);
+  Real omega = 2. / (1 + M_PI / solver.nx_total);
 
   // For Periodic Boundaries
   // Real omega = 2. / ( 1 + 2*M_PI / nx_total  );
   // chprintf("Omega: %f \n", omega);
 
-  bool set_boundaries;
+  // The ghost cells of the potential are updated redundantly between the
+  // boundary transfers, which needs the density in the ghost cells
+  solver.Copy_Density_To_Halo();
+  if (solver.n_halo > 1) {
+    solver.Set_Transfer_Array(solver.F.density_halo_d, solver.nx_local, solver.ny_local, solver.nz_local,
+                              solver.n_ghost, solver.n_halo);
+    solver.TRANSFER_POISSON_BOUNDARIES = true;
+    Set_Boundary_Conditions(*P);
+    solver.TRANSFER_POISSON_BOUNDARIES = false;
+    solver.Set_Transfer_Level(0);
+  }
 
-  // Number of iterations in between boundary transfers
-  int n_iter_per_boundaries_transfer = 1;
+  // Each convergence check costs a device to host copy and a global
+  // reduction. Start checking a little before the previous solve converged and
+  // then check more and more rarely
+  int next_check     = 3 * solver.n_iter_previous / 4;
+  int check_interval = 1;
+  bool converged     = false;
+  int n_half_iter    = 0;
 
   // Iterate to solve Poisson equation
-  while (Grav.Poisson_solver.F.converged_h[0] == 0) {
-    set_boundaries = false;
-    if (n_iter % n_iter_per_boundaries_transfer == 0) set_boundaries = true;
-
-    // First Partial Iteration
-    Grav.Poisson_solver.iteration_parity = 0;
-    if (set_boundaries) {
-      Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = true;
-      Set_Boundary_Conditions(*P);
-      Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = false;
+  while (!converged) {
+    bool const check = n_iter >= next_check;
+
+    for (int parity = 0; parity < 2; parity++) {
+      // Transfer n_halo ghost cells, the following half iterations update a
+      // region that shrinks by one cell each time
+      int const stage = n_half_iter % solver.n_halo;
+      if (stage == 0) {
+        solver.TRANSFER_POISSON_BOUNDARIES = true;
+        Set_Boundary_Conditions(*P);
+        solver.TRANSFER_POISSON_BOUNDARIES = false;
+      }
+      solver.iteration_parity = parity;
+      solver.Poisson_Halo_Iteration(parity, solver.n_halo - 1 - stage, omega, epsilon, check && parity == 0,
+                                    Grav.boundary_flags);
+      n_half_iter += 1;
     }
-    Grav.Poisson_solver.Poisson_Partial_Iteration(Grav.Poisson_solver.iteration_parity, omega, epsilon);
-
-    // Second Partial Iteration
-    Grav.Poisson_solver.iteration_parity = 1;
-    if (set_boundaries) {
-      Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = true;
-      Set_Boundary_Conditions(*P);
-      Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = false;
-    }
-    Grav.Poisson_solver.Poisson_Partial_Iteration(Grav.Poisson_solver.iteration_parity, omega, epsilon);
-
-  // Get convergence state
-  #ifdef MPI_CHOLLA
-    Grav.Poisson_solver.F.converged_h[0] =
-        Grav.Poisson_solver.Get_Global_Converged(Grav.Poisson_solver.F.converged_h[0]);
-  #endif
+    n_iter += 1;
 
-    // Only aloow to connverge after the boundaries have been transfere to avoid
-    // false convergence in the boundaries.
-    if (set_boundaries == false) Grav.Poisson_solver.F.converged_h[0] = 0;
+    if (check) {
+      converged = solver.Get_Local_Converged();
+    #ifdef MPI_CHOLLA
+      converged = solver.Get_Global_Converged(converged);
+    #endif
+      if (!converged) {
+        check_interval = std::min(2 * check_interval, SOR_MAX_CHECK_INTERVAL);
+        next_check     = n_iter + check_interval;
+      }
+    }
 
-    n_iter += 1;
     if (n_iter == max_iter) break;
   }
+  solver.n_iter_previous = n_iter;
 
   if (n_iter == max_iter)
     chprintf(" SOR: No convergence in %d iterations \n", n_iter);
   else
     chprintf(" SOR: Converged in %d iterations \n", n_iter);
+  #endif  // MULTIGRID
 
   Grav.Poisson_solver.Copy_Output(Grav.F.potential_h);
 
@@ -240,29 +353,105 @@ void Grid3D::Get_Potential_SOR(Real Grav_Constant, Real dens_avrg, Real current_
   #endif
 }
 
+  #ifdef MULTIGRID
+void Grid3D::Multigrid_Exchange_Boundaries(int level, struct Parameters *P)
+{
+  Grav.Poisson_solver.Set_Transfer_Level(level);
+  Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = true;
+  Set_Boundary_Conditions(*P);
+  Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES = false;
+  Grav.Poisson_solver.Set_Transfer_Level(0);
+}
+
+void Grid3D::Multigrid_Smooth_Level(int level, int n_sweeps, struct Parameters *P)
+{
+  // Red-black Gauss-Seidel, each half sweep needs the updated boundaries of the
+  // other color
+  for (int sweep = 0; sweep < n_sweeps; sweep++) {
+    for (int parity = 0; parity < 2; parity++) {
+      Multigrid_Exchange_Boundaries(level, P);
+      Grav.Poisson_solver.Multigrid_Smooth(level, parity);
+    }
+  }
+}
+
+void Grid3D::Multigrid_V_Cycle(int level, struct Parameters *P)
+{
+  int const coarsest = Grav.Poisson_solver.mg_levels.size() - 1;
+  if (level == coarsest) {
+    Multigrid_Smooth_Level(level, MULTIGRID_COARSE_SWEEPS, P);
+    return;
+  }
+
+  Multigrid_Smooth_Level(level, MULTIGRID_SMOOTH_SWEEPS, P);
+
+  // Solve for the correction on the coarser level
+  Multigrid_Exchange_Boundaries(level, P);
+  Grav.Poisson_solver.Multigrid_Restrict_Residual(level);
+  Multigrid_V_Cycle(level + 1, P);
+
+  // Interpolate the correction and remove the high frequency error it adds
+  Multigrid_Exchange_Boundaries(level + 1, P);
+  Grav.Poisson_solver.Multigrid_Prolongate_Correction(level);
+  Multigrid_Smooth_Level(level, MULTIGRID_SMOOTH_SWEEPS, P);
+}
+
+void Grid3D::Multigrid_Solve(struct Parameters *P)
+{
+  Real residual_max, rhs_max;
+  int n_cycles = 0;
+  while (true) {
+    Multigrid_Exchange_Boundaries(0, P);
+    Grav.Poisson_solver.Multigrid_Norms(residual_max, rhs_max);
+    #ifdef MPI_CHOLLA
+    residual_max = ReduceRealMax(residual_max);
+    rhs_max      = ReduceRealMax(rhs_max);
+    #endif
+    if (residual_max <= MULTIGRID_EPSILON * rhs_max || n_cycles == MULTIGRID_MAX_CYCLES) break;
+
+    Multigrid_V_Cycle(0, P);
+    n_cycles += 1;
+  }
+
+  if (residual_max > MULTIGRID_EPSILON * rhs_max)
+    chprintf(" Multigrid: No convergence in %d V-cycles, residual %e \n", n_cycles, residual_max / rhs_max);
+  else
+    chprintf(" Multigrid: Converged in %d V-cycles \n", n_cycles);
+}
+  #endif  // MULTIGRID
+
 void Grav3D::Copy_Isolated_Boundaries_To_GPU(struct Parameters *P)
 {
   if (P->xl_bcnd != 3 && P->xu_bcnd != 3 && P->yl_bcnd != 3 && P->yu_bcnd != 3 && P->zl_bcnd != 3 && P->zu_bcnd != 3)
     return;
 
+  #ifdef GRAVITY_GPU
+  // The isolated boundaries are computed on the device
+  Real *pot_boundary[6] = {F.pot_boundary_x0_d, F.pot_boundary_x1_d, F.pot_boundary_y0_d,
+                           F.pot_boundary_y1_d, F.pot_boundary_z0_d, F.pot_boundary_z1_d};
+  #else
+  Real *pot_boundary[6] = {F.pot_boundary_x0, F.pot_boundary_x1, F.pot_boundary_y0,
+                           F.pot_boundary_y1, F.pot_boundary_z0, F.pot_boundary_z1};
+  #endif
+
   // chprintf( " Copying Isolated Boundaries \n");
   if (boundary_flags[0] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_x0, Poisson_solver.F.boundary_isolated_x0_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[0], Poisson_solver.F.boundary_isolated_x0_d,
                                          Poisson_solver.n_ghost * ny_local * nz_local);
   if (boundary_flags[1] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_x1, Poisson_solver.F.boundary_isolated_x1_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[1], Poisson_solver.F.boundary_isolated_x1_d,
                                          Poisson_solver.n_ghost * ny_local * nz_local);
   if (boundary_flags[2] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_y0, Poisson_solver.F.boundary_isolated_y0_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[2], Poisson_solver.F.boundary_isolated_y0_d,
                                          Poisson_solver.n_ghost * nx_local * nz_local);
   if (boundary_flags[3] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_y1, Poisson_solver.F.boundary_isolated_y1_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[3], Poisson_solver.F.boundary_isolated_y1_d,
                                          Poisson_solver.n_ghost * nx_local * nz_local);
   if (boundary_flags[4] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_z0, Poisson_solver.F.boundary_isolated_z0_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[4], Poisson_solver.F.boundary_isolated_z0_d,
                                          Poisson_solver.n_ghost * nx_local * ny_local);
   if (boundary_flags[5] == 3)
-    Copy_Isolated_Boundary_To_GPU_buffer(F.pot_boundary_z1, Poisson_solver.F.boundary_isolated_z1_d,
+    Copy_Isolated_Boundary_To_GPU_buffer(pot_boundary[5], Poisson_solver.F.boundary_isolated_z1_d,
                                          Poisson_solver.n_ghost * nx_local * ny_local);
 }
 
@@ -301,10 +490,10 @@ void Potential_SOR_3D::Copy_Poisson_Boundary_Periodic(int direction, int side)
   side_load   = side;
   side_unload = (side_load + 1) % 2;
 
-  Load_Transfer_Buffer_GPU(direction, side_load, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           boundaries_buffer);
-  Unload_Transfer_Buffer_GPU(direction, side_unload, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost,
-                             F.potential_d, boundaries_buffer);
+  Load_Transfer_Buffer_GPU(direction, side_load, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer,
+                           transfer_n_ghost, transfer_potential_d, boundaries_buffer);
+  Unload_Transfer_Buffer_GPU(direction, side_unload, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer,
+                             transfer_n_ghost, transfer_potential_d, boundaries_buffer);
 }
 
 void Potential_SOR_3D::FreeMemory_GPU(void)
@@ -312,6 +501,8 @@ void Potential_SOR_3D::FreeMemory_GPU(void)
   Free_Array_GPU_Real(F.input_d);
   Free_Array_GPU_Real(F.density_d);
   Free_Array_GPU_Real(F.potential_d);
+  Free_Array_GPU_Real(F.density_halo_d);
+  Free_Array_GPU_Real(F.potential_prev_d);
   Free_Array_GPU_Real(F.boundaries_buffer_x0_d);
   Free_Array_GPU_Real(F.boundaries_buffer_x1_d);
   Free_Array_GPU_Real(F.boundaries_buffer_y0_d);
@@ -345,6 +536,9 @@ void Potential_SOR_3D::FreeMemory_GPU(void)
 void Potential_SOR_3D::Reset(void)
 {
   free(F.output_h);
+  #ifdef MULTIGRID
+  Multigrid_Free();
+  #endif
   FreeMemory_GPU();
 }
 
@@ -435,132 +629,132 @@ void Grid3D::Unload_Poisson_Boundary_From_Buffer(int direction, int side, Real *
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_x0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(0, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_x0_d);
+  Load_Transfer_Buffer_Half_GPU(0, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_x0_d);
     #else
-  Load_Transfer_Buffer_GPU(0, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_x0_d);
+  Load_Transfer_Buffer_GPU(0, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_x0_d);
     #endif
 }
 
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_x1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(0, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_x1_d);
+  Load_Transfer_Buffer_Half_GPU(0, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_x1_d);
     #else
-  Load_Transfer_Buffer_GPU(0, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_x1_d);
+  Load_Transfer_Buffer_GPU(0, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_x1_d);
     #endif
 }
 
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_y0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(1, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_y0_d);
+  Load_Transfer_Buffer_Half_GPU(1, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_y0_d);
     #else
-  Load_Transfer_Buffer_GPU(1, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_y0_d);
+  Load_Transfer_Buffer_GPU(1, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_y0_d);
     #endif
 }
 
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_y1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(1, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_y1_d);
+  Load_Transfer_Buffer_Half_GPU(1, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_y1_d);
     #else
-  Load_Transfer_Buffer_GPU(1, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_y1_d);
+  Load_Transfer_Buffer_GPU(1, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_y1_d);
     #endif
 }
 
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_z0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(2, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_z0_d);
+  Load_Transfer_Buffer_Half_GPU(2, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_z0_d);
     #else
-  Load_Transfer_Buffer_GPU(2, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_z0_d);
+  Load_Transfer_Buffer_GPU(2, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_z0_d);
     #endif
 }
 
 void Potential_SOR_3D::Load_Transfer_Buffer_GPU_z1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Load_Transfer_Buffer_Half_GPU(2, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                F.boundaries_buffer_z1_d);
+  Load_Transfer_Buffer_Half_GPU(2, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                transfer_potential_d, F.boundaries_buffer_z1_d);
     #else
-  Load_Transfer_Buffer_GPU(2, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                           F.boundaries_buffer_z1_d);
+  Load_Transfer_Buffer_GPU(2, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                           transfer_potential_d, F.boundaries_buffer_z1_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_x0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(0, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_x0_d);
+  Unload_Transfer_Buffer_Half_GPU(0, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_x0_d);
     #else
-  Unload_Transfer_Buffer_GPU(0, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_x0_d);
+  Unload_Transfer_Buffer_GPU(0, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_x0_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_x1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(0, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_x1_d);
+  Unload_Transfer_Buffer_Half_GPU(0, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_x1_d);
     #else
-  Unload_Transfer_Buffer_GPU(0, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_x1_d);
+  Unload_Transfer_Buffer_GPU(0, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_x1_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_y0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(1, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_y0_d);
+  Unload_Transfer_Buffer_Half_GPU(1, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_y0_d);
     #else
-  Unload_Transfer_Buffer_GPU(1, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_y0_d);
+  Unload_Transfer_Buffer_GPU(1, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_y0_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_y1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(1, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_y1_d);
+  Unload_Transfer_Buffer_Half_GPU(1, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_y1_d);
     #else
-  Unload_Transfer_Buffer_GPU(1, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_y1_d);
+  Unload_Transfer_Buffer_GPU(1, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_y1_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_z0()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(2, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_z0_d);
+  Unload_Transfer_Buffer_Half_GPU(2, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_z0_d);
     #else
-  Unload_Transfer_Buffer_GPU(2, 0, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_z0_d);
+  Unload_Transfer_Buffer_GPU(2, 0, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_z0_d);
     #endif
 }
 
 void Potential_SOR_3D::Unload_Transfer_Buffer_GPU_z1()
 {
     #ifdef HALF_SIZE_BOUNDARIES
-  Unload_Transfer_Buffer_Half_GPU(2, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                                  F.recv_boundaries_buffer_z1_d);
+  Unload_Transfer_Buffer_Half_GPU(2, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                                  transfer_potential_d, F.recv_boundaries_buffer_z1_d);
     #else
-  Unload_Transfer_Buffer_GPU(2, 1, nx_local, ny_local, nz_local, n_ghost_transfer, n_ghost, F.potential_d,
-                             F.recv_boundaries_buffer_z1_d);
+  Unload_Transfer_Buffer_GPU(2, 1, transfer_nx, transfer_ny, transfer_nz, n_ghost_transfer, transfer_n_ghost,
+                             transfer_potential_d, F.recv_boundaries_buffer_z1_d);
     #endif
 }
 
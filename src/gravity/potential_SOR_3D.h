@@ -5,11 +5,32 @@
 
     #include <stdlib.h>
 
+    #ifdef MULTIGRID
+      #include <vector>
+    #endif
+
     #include "../global/global.h"
 
 // #define TIME_SOR
 // #define HALF_SIZE_BOUNDARIES
 
+// Maximum number of iterations between two convergence checks
+    #define SOR_MAX_CHECK_INTERVAL 32
+
+    #ifdef MULTIGRID
+      #ifdef HALF_SIZE_BOUNDARIES
+        #error "MULTIGRID does not support HALF_SIZE_BOUNDARIES"
+      #endif
+      // Red-black Gauss-Seidel sweeps before and after each coarse grid correction
+      #define MULTIGRID_SMOOTH_SWEEPS 2
+      // Red-black Gauss-Seidel sweeps on the coarsest level
+      #define MULTIGRID_COARSE_SWEEPS 32
+      // Maximum number of V-cycles per solve
+      #define MULTIGRID_MAX_CYCLES 100
+      // Convergence criteria: max|residual| <= MULTIGRID_EPSILON * max|4 pi G rho|
+      #define MULTIGRID_EPSILON 1e-6
+    #endif
+
 class Potential_SOR_3D
 {
  public:
@@ -40,15 +61,31 @@ class Potential_SOR_3D
   grav_int_t n_cells_total;
 
   int n_ghost_transfer;
+  // Number of half iterations between boundary transfers, n_halo ghost cells
+  // are transferred and updated redundantly in between
+  int n_halo;
   int size_buffer_x;
   int size_buffer_y;
   int size_buffer_z;
 
   bool TRANSFER_POISSON_BOUNDARIES;
 
+  // The array and its real size whose boundaries are transferred when
+  // TRANSFER_POISSON_BOUNDARIES is set. This is F.potential_d except while
+  // multigrid is exchanging the boundaries of a coarse level
+  Real *transfer_potential_d;
+  int transfer_nx;
+  int transfer_ny;
+  int transfer_nz;
+  int transfer_n_ghost;
+
   int iteration_parity;
 
   bool potential_initialized;
+  bool potential_prev_initialized;
+
+  // Iterations used by the previous solve, to schedule the convergence checks
+  int n_iter_previous;
 
   struct Fields {
     Real *output_h;
@@ -57,6 +94,11 @@ class Potential_SOR_3D
     // Real *output_d;
     Real *density_d;
     Real *potential_d;
+    // Density with n_ghost ghost cells for the redundant updates of the ghost
+    // cells of the potential
+    Real *density_halo_d;
+    // Solution of the previous solve, for the warm start extrapolation
+    Real *potential_prev_d;
 
     bool *converged_d;
 
@@ -87,6 +129,24 @@ class Potential_SOR_3D
 
   } F;
 
+    #ifdef MULTIGRID
+  /*! \brief One level of the multigrid hierarchy. Level 0 is the SOR grid
+   *  itself and each coarser level has half the cells in each direction */
+  struct MG_Level {
+    int nx, ny, nz;
+    int n_ghost;
+    Real dx;
+    // Potential on level 0 and the correction to the finer level on the
+    // coarser levels, with n_ghost ghost cells
+    Real *phi_d;
+    // Right hand side, without ghost cells
+    Real *rhs_d;
+  };
+  std::vector<MG_Level> mg_levels;
+  // Device scratch for the residual and right hand side norms
+  Real *mg_norms_d;
+    #endif
+
   Potential_SOR_3D(void);
 
   void Initialize(Real Lx, Real Ly, Real Lz, Real x_min, Real y_min, Real z_min, int nx, int ny, int nz, int nx_real,
@@ -114,7 +174,9 @@ class Potential_SOR_3D
 
   void Initialize_Potential(int nx, int ny, int nz, int n_ghost_potential, Real *potential_d, Real *density_d);
   void Copy_Input_And_Initialize(Real *input_density, const Real *input_potential, Real Grav_Constant, Real dens_avrg,
-                                 Real current_a);
+                                 Real current_a, Real dt_now, Real dt_prev);
+  void Warm_Start_Potential(Real dt_now, Real dt_prev);
+  void Copy_Density_To_Halo(void);
 
   void Poisson_iteration(int n_cells, int nx, int ny, int nz, int n_ghost_potential, Real dx, Real dy, Real dz,
                          Real omega, Real epsilon, Real *density_d, Real *potential_d, bool *converged_h,
@@ -126,6 +188,9 @@ class Potential_SOR_3D
                                   Real omega, Real epsilon, Real *density_d, Real *potential_d, bool *converged_h,
                                   bool *converged_d);
   void Poisson_Partial_Iteration(int n_step, Real omega, Real epsilon);
+  void Poisson_Halo_Iteration(int parity, int extension, Real omega, Real epsilon, bool reset_converged,
+                              int *boundary_flags);
+  bool Get_Local_Converged(void);
 
   void Load_Transfer_Buffer_GPU(int direction, int side, int nx, int ny, int nz, int n_ghost_transfer,
                                 int n_ghost_potential, Real *potential_d, Real *transfer_buffer_d);
@@ -164,6 +229,18 @@ class Potential_SOR_3D
     #ifdef MPI_CHOLLA
   bool Get_Global_Converged(bool converged_local);
     #endif
+
+  void Set_Transfer_Array(Real *array_d, int nx, int ny, int nz, int n_ghost_array, int n_layers);
+  void Set_Transfer_Level(int level);
+
+    #ifdef MULTIGRID
+  void Multigrid_Initialize(void);
+  void Multigrid_Free(void);
+  void Multigrid_Smooth(int level, int parity);
+  void Multigrid_Restrict_Residual(int level);
+  void Multigrid_Prolongate_Correction(int level);
+  void Multigrid_Norms(Real &residual_max, Real &rhs_max);
+    #endif
 };
 
   #endif  // POTENTIAL_SOR_H
@@ -1,24 +1,32 @@
-#if defined(CUDA) && defined(GRAVITY) && defined(SOR)
+#if defined(GRAVITY) && defined(SOR)
 
   #include "../global/global_cuda.h"
   #include "../gravity/potential_SOR_3D.h"
   #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+
+  #ifdef MULTIGRID
+    #include "../utils/cuda_utilities.h"
+    #include "../utils/reduction_utilities.h"
+  #endif
 
   #define TPB_SOR 1024
 
 void Potential_SOR_3D::Allocate_Array_GPU_Real(Real **array_dev, grav_int_t size)
 {
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(Real));
 }
 
 void Potential_SOR_3D::Allocate_Array_GPU_bool(bool **array_dev, grav_int_t size)
 {
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(bool)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(bool));
 }
 
-void Potential_SOR_3D::Free_Array_GPU_Real(Real *array_dev) { GPU_Error_Check(cudaFree(array_dev)); }
+void Potential_SOR_3D::Free_Array_GPU_Real(Real *array_dev) { cuda_utilities::Pool_Free(array_dev); }
 
-void Potential_SOR_3D::Free_Array_GPU_bool(bool *array_dev) { GPU_Error_Check(cudaFree(array_dev)); }
+void Potential_SOR_3D::Free_Array_GPU_bool(bool *array_dev) { cuda_utilities::Pool_Free(array_dev); }
 
 __global__ void Copy_Input_Kernel(int n_cells, Real *input_d, Real *density_d, Real Grav_Constant, Real dens_avrg,
                                   Real current_a)
@@ -55,7 +63,13 @@ void Potential_SOR_3D::Copy_Input(int n_cells, Real *input_d, Real *input_densit
 void Grav3D::Copy_Isolated_Boundary_To_GPU_buffer(Real *isolated_boundary_h, Real *isolated_boundary_d,
                                                   int boundary_size)
 {
+  #ifdef GRAVITY_GPU
+  // The boundary was computed on the device, isolated_boundary_h is a device
+  // array as well
+  cudaMemcpy(isolated_boundary_d, isolated_boundary_h, boundary_size * sizeof(Real), cudaMemcpyDeviceToDevice);
+  #else
   cudaMemcpy(isolated_boundary_d, isolated_boundary_h, boundary_size * sizeof(Real), cudaMemcpyHostToDevice);
+  #endif
 }
 
 __global__ void Initialize_Potential_Kernel(Real init_val, Real *potential_d, Real *density_d, int nx, int ny, int nz,
@@ -277,6 +291,123 @@ void Potential_SOR_3D::Poisson_iteration_Patial_2(int n_cells, int nx, int ny, i
   cudaMemcpy(converged_h, converged_d, sizeof(bool), cudaMemcpyDeviceToHost);
 }
 
+/*! \brief Red-black SOR half iteration over the real cells and the first
+ *  ext_* ghost cells of each side. The ghost cells are updated redundantly so
+ *  the boundaries only have to be transferred every few half iterations.
+ *  density_d has the same ghost cells as potential_d. Only the real cells are
+ *  checked for convergence */
+__global__ void Iteration_Step_SOR_Halo(Real const *density_d, Real *potential_d, int nx, int ny, int nz, int n_ghost,
+                                        int ext_x0, int ext_x1, int ext_y0, int ext_y1, int ext_z0, int ext_z1,
+                                        Real dx, Real omega, int parity, Real epsilon, bool *converged_d)
+{
+  // Indices relative to the first real cell
+  int const j = blockIdx.y * blockDim.y + threadIdx.y - ext_y0;
+  int const k = blockIdx.z * blockDim.z + threadIdx.z - ext_z0;
+  if (j >= ny + ext_y1 || k >= nz + ext_z1) return;
+
+  // Same checkerboard as Iteration_Step_SOR: update the cells with
+  // (i + j + k + 1) % 2 == parity
+  int const shift = (parity + 1 + j + k + 6 * n_ghost) % 2;
+  int const i     = -ext_x0 + 2 * (blockIdx.x * blockDim.x + threadIdx.x) + (ext_x0 + shift) % 2;
+  if (i >= nx + ext_x1) return;
+
+  int const nx_pot = nx + 2 * n_ghost;
+  int const ny_pot = ny + 2 * n_ghost;
+  int const id_pot = (i + n_ghost) + (j + n_ghost) * nx_pot + (k + n_ghost) * nx_pot * ny_pot;
+
+  Real const phi_c   = potential_d[id_pot];
+  Real const phi_sum = potential_d[id_pot - 1] + potential_d[id_pot + 1] + potential_d[id_pot - nx_pot] +
+                       potential_d[id_pot + nx_pot] + potential_d[id_pot - nx_pot * ny_pot] +
+                       potential_d[id_pot + nx_pot * ny_pot];
+  Real const phi_new  = (1 - omega) * phi_c + omega / 6 * (phi_sum - dx * dx * density_d[id_pot]);
+  potential_d[id_pot] = phi_new;
+
+  // Check the residual for the convergence criteria
+  bool const real = i >= 0 && i < nx && j >= 0 && j < ny && k >= 0 && k < nz;
+  if (real && (fabs((phi_new - phi_c) / phi_c) > epsilon)) converged_d[0] = 0;
+}
+
+void Potential_SOR_3D::Poisson_Halo_Iteration(int parity, int extension, Real omega, Real epsilon,
+                                              bool reset_converged, int *boundary_flags)
+{
+  // Only the transferred boundaries, periodic (1) and MPI (5), have ghost cells
+  // that can be updated
+  int ext[6];
+  for (int i = 0; i < 6; i++) ext[i] = (boundary_flags[i] == 1 || boundary_flags[i] == 5) ? extension : 0;
+  int const nx = nx_local + ext[0] + ext[1];
+  int const ny = ny_local + ext[2] + ext[3];
+  int const nz = nz_local + ext[4] + ext[5];
+
+  // set values for GPU kernels
+  int tpb_x        = 16;
+  int tpb_y        = 8;
+  int tpb_z        = 8;
+  int ngrid_y      = (ny + tpb_y - 1) / tpb_y;
+  int ngrid_z      = (nz + tpb_z - 1) / tpb_z;
+  int ngrid_x_half = ((nx + 1) / 2 + tpb_x - 1) / tpb_x;
+  dim3 dim3dGrid_half(ngrid_x_half, ngrid_y, ngrid_z);
+  dim3 dim3dBlock(tpb_x, tpb_y, tpb_z);
+
+  if (reset_converged) GPU_Error_Check(cudaMemset(F.converged_d, 1, sizeof(bool)));
+
+  hipLaunchKernelGGL(Iteration_Step_SOR_Halo, dim3dGrid_half, dim3dBlock, 0, 0, F.density_halo_d, F.potential_d,
+                     nx_local, ny_local, nz_local, n_ghost, ext[0], ext[1], ext[2], ext[3], ext[4], ext[5], dx, omega,
+                     parity, epsilon, F.converged_d);
+}
+
+bool Potential_SOR_3D::Get_Local_Converged(void)
+{
+  GPU_Error_Check(cudaMemcpy(F.converged_h, F.converged_d, sizeof(bool), cudaMemcpyDeviceToHost));
+  return F.converged_h[0];
+}
+
+__global__ void Copy_Density_To_Halo_Kernel(Real const *density_d, Real *density_halo_d, int nx, int ny, int nz,
+                                            int n_ghost)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= nx * ny * nz) return;
+
+  int const k      = tid / (nx * ny);
+  int const j      = (tid - k * nx * ny) / nx;
+  int const i      = tid - k * nx * ny - j * nx;
+  int const nx_pot = nx + 2 * n_ghost;
+  int const ny_pot = ny + 2 * n_ghost;
+  density_halo_d[(i + n_ghost) + (j + n_ghost) * nx_pot + (k + n_ghost) * nx_pot * ny_pot] = density_d[tid];
+}
+
+void Potential_SOR_3D::Copy_Density_To_Halo(void)
+{
+  int ngrid = (n_cells_local + TPB_SOR - 1) / TPB_SOR;
+  hipLaunchKernelGGL(Copy_Density_To_Halo_Kernel, ngrid, TPB_SOR, 0, 0, F.density_d, F.density_halo_d, nx_local,
+                     ny_local, nz_local, n_ghost);
+}
+
+__global__ void Warm_Start_Potential_Kernel(Real *potential_d, Real *potential_prev_d, int n_cells, Real factor)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_cells) return;
+
+  Real const phi_now    = potential_d[tid];
+  potential_d[tid]      = phi_now + factor * (phi_now - potential_prev_d[tid]);
+  potential_prev_d[tid] = phi_now;
+}
+
+void Potential_SOR_3D::Warm_Start_Potential(Real dt_now, Real dt_prev)
+{
+  // Linear extrapolation of the last two solutions over the time step, as in
+  // Extrapolate_Grav_Potential. The first solve only stores its solution
+  if (!potential_prev_initialized || dt_prev <= 0) {
+    GPU_Error_Check(
+        cudaMemcpy(F.potential_prev_d, F.potential_d, n_cells_potential * sizeof(Real), cudaMemcpyDeviceToDevice));
+    potential_prev_initialized = true;
+    return;
+  }
+
+  int ngrid = (n_cells_potential + TPB_SOR - 1) / TPB_SOR;
+  hipLaunchKernelGGL(Warm_Start_Potential_Kernel, ngrid, TPB_SOR, 0, 0, F.potential_d, F.potential_prev_d,
+                     (int)n_cells_potential, dt_now / dt_prev);
+}
+
 __global__ void Set_Isolated_Boundary_GPU_kernel(int direction, int side, int size_buffer, int n_i, int n_j,
                                                  int n_ghost, int nx_pot, int ny_pot, int nz_pot, Real *potential_d,
                                                  Real *boundary_d)
@@ -684,4 +815,173 @@ void Potential_SOR_3D::Copy_Transfer_Buffer_To_Device(int size_buffer, Real *tra
   GPU_Error_Check(cudaMemcpy(transfer_buffer_d, transfer_buffer_h, size_buffer * sizeof(Real), cudaMemcpyHostToDevice));
 }
 
+
+  #ifdef MULTIGRID
+void Potential_SOR_3D::Multigrid_Smooth(int level, int parity)
+{
+  MG_Level const &mg = mg_levels[level];
+
+  // set values for GPU kernels
+  int tpb_x        = 16;
+  int tpb_y        = 8;
+  int tpb_z        = 8;
+  int ngrid_y      = (mg.ny + tpb_y - 1) / tpb_y;
+  int ngrid_z      = (mg.nz + tpb_z - 1) / tpb_z;
+  int ngrid_x_half = ((mg.nx + 1) / 2 + tpb_x - 1) / tpb_x;
+  dim3 dim3dGrid_half(ngrid_x_half, ngrid_y, ngrid_z);
+  dim3 dim3dBlock(tpb_x, tpb_y, tpb_z);
+
+  // Gauss-Seidel is SOR with omega = 1, the convergence flag is not used
+  hipLaunchKernelGGL(Iteration_Step_SOR, dim3dGrid_half, dim3dBlock, 0, 0, mg.nx * mg.ny * mg.nz, mg.rhs_d, mg.phi_d,
+                     mg.nx, mg.ny, mg.nz, mg.n_ghost, mg.dx, mg.dx, mg.dx, 1.0, parity, 0.0, F.converged_d);
+}
+
+/*! \brief Residual rhs - laplacian( phi ) of the real cell (i, j, k) of a
+ *  multigrid level. The ghost cells of phi must be up to date */
+__device__ Real Multigrid_Residual(Real const *phi_d, Real const *rhs_d, int i, int j, int k, int nx, int ny,
+                                   int n_ghost, Real dx)
+{
+  int const nx_pot = nx + 2 * n_ghost;
+  int const ny_pot = ny + 2 * n_ghost;
+  int const id_pot = (i + n_ghost) + (j + n_ghost) * nx_pot + (k + n_ghost) * nx_pot * ny_pot;
+
+  Real const laplacian = (phi_d[id_pot - 1] + phi_d[id_pot + 1] + phi_d[id_pot - nx_pot] + phi_d[id_pot + nx_pot] +
+                          phi_d[id_pot - nx_pot * ny_pot] + phi_d[id_pot + nx_pot * ny_pot] - 6 * phi_d[id_pot]) /
+                         (dx * dx);
+  return rhs_d[i + j * nx + k * nx * ny] - laplacian;
+}
+
+/*! \brief Restrict the residual of a level to the right hand side of the next
+ *  coarser level by averaging the 8 fine cells of each coarse cell. One thread
+ *  per coarse cell */
+__global__ void Multigrid_Restrict_Residual_Kernel(Real const *phi_d, Real const *rhs_d, int nx, int ny, int nz,
+                                                   int n_ghost, Real dx, Real *coarse_rhs_d)
+{
+  int const nx_c = nx / 2;
+  int const ny_c = ny / 2;
+  int const nz_c = nz / 2;
+  int const tid  = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= nx_c * ny_c * nz_c) return;
+
+  int const k_c = tid / (nx_c * ny_c);
+  int const j_c = (tid - k_c * nx_c * ny_c) / nx_c;
+  int const i_c = tid - k_c * nx_c * ny_c - j_c * nx_c;
+
+  Real residual = 0;
+  for (int dk = 0; dk < 2; dk++) {
+    for (int dj = 0; dj < 2; dj++) {
+      for (int di = 0; di < 2; di++) {
+        residual += Multigrid_Residual(phi_d, rhs_d, 2 * i_c + di, 2 * j_c + dj, 2 * k_c + dk, nx, ny, n_ghost, dx);
+      }
+    }
+  }
+  coarse_rhs_d[tid] = residual / 8;
+}
+
+void Potential_SOR_3D::Multigrid_Restrict_Residual(int level)
+{
+  MG_Level const &fine   = mg_levels[level];
+  MG_Level const &coarse = mg_levels[level + 1];
+
+  // The coarse level solves for the correction starting from zero. This also
+  // zeroes its ghost cells, the homogeneous Dirichlet condition of the
+  // correction at the isolated boundaries
+  GPU_Error_Check(cudaMemset(coarse.phi_d, 0,
+                             (coarse.nx + 2 * coarse.n_ghost) * (coarse.ny + 2 * coarse.n_ghost) *
+                                 (coarse.nz + 2 * coarse.n_ghost) * sizeof(Real)));
+
+  int ngrid = (coarse.nx * coarse.ny * coarse.nz + TPB_SOR - 1) / TPB_SOR;
+  hipLaunchKernelGGL(Multigrid_Restrict_Residual_Kernel, ngrid, TPB_SOR, 0, 0, fine.phi_d, fine.rhs_d, fine.nx, fine.ny,
+                     fine.nz, fine.n_ghost, fine.dx, coarse.rhs_d);
+}
+
+/*! \brief Add the trilinear interpolation of the correction on the coarser
+ *  level to the real cells of a level. One thread per fine cell. The coarse
+ *  level has 1 ghost cell, which must be up to date */
+__global__ void Multigrid_Prolongate_Correction_Kernel(Real const *coarse_phi_d, int nx, int ny, int nz, int n_ghost,
+                                                       Real *phi_d)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= nx * ny * nz) return;
+
+  int const k = tid / (nx * ny);
+  int const j = (tid - k * nx * ny) / nx;
+  int const i = tid - k * nx * ny - j * nx;
+
+  // The coarse cell containing this cell and the direction of the nearest
+  // coarse neighbors, weighted 3/4 and 1/4 in each direction
+  int const nx_c = nx / 2 + 2;
+  int const ny_c = ny / 2 + 2;
+  int const i_c  = i / 2 + 1;
+  int const j_c  = j / 2 + 1;
+  int const k_c  = k / 2 + 1;
+  int const s_i  = (i % 2 == 0) ? -1 : 1;
+  int const s_j  = (j % 2 == 0) ? -1 : 1;
+  int const s_k  = (k % 2 == 0) ? -1 : 1;
+
+  Real correction = 0;
+  for (int dk = 0; dk < 2; dk++) {
+    Real const w_k = (dk == 0) ? 0.75 : 0.25;
+    for (int dj = 0; dj < 2; dj++) {
+      Real const w_j = (dj == 0) ? 0.75 : 0.25;
+      for (int di = 0; di < 2; di++) {
+        Real const w_i = (di == 0) ? 0.75 : 0.25;
+        correction += w_i * w_j * w_k *
+                      coarse_phi_d[(i_c + di * s_i) + (j_c + dj * s_j) * nx_c + (k_c + dk * s_k) * nx_c * ny_c];
+      }
+    }
+  }
+
+  int const nx_pot = nx + 2 * n_ghost;
+  int const ny_pot = ny + 2 * n_ghost;
+  phi_d[(i + n_ghost) + (j + n_ghost) * nx_pot + (k + n_ghost) * nx_pot * ny_pot] += correction;
+}
+
+void Potential_SOR_3D::Multigrid_Prolongate_Correction(int level)
+{
+  MG_Level const &fine   = mg_levels[level];
+  MG_Level const &coarse = mg_levels[level + 1];
+
+  int ngrid = (fine.nx * fine.ny * fine.nz + TPB_SOR - 1) / TPB_SOR;
+  hipLaunchKernelGGL(Multigrid_Prolongate_Correction_Kernel, ngrid, TPB_SOR, 0, 0, coarse.phi_d, fine.nx, fine.ny,
+                     fine.nz, fine.n_ghost, fine.phi_d);
+}
+
+/*! \brief Compute max|residual| and max|rhs| of a level with a grid-stride
+ *  loop. norms_d must be zeroed before the launch */
+__global__ void Multigrid_Norms_Kernel(Real const *phi_d, Real const *rhs_d, int nx, int ny, int nz, int n_ghost,
+                                       Real dx, Real *norms_d)
+{
+  Real residual_max = 0;
+  Real rhs_max      = 0;
+  for (int id = threadIdx.x + blockIdx.x * blockDim.x; id < nx * ny * nz; id += blockDim.x * gridDim.x) {
+    int const k  = id / (nx * ny);
+    int const j  = (id - k * nx * ny) / nx;
+    int const i  = id - k * nx * ny - j * nx;
+    residual_max = fmax(residual_max, fabs(Multigrid_Residual(phi_d, rhs_d, i, j, k, nx, ny, n_ghost, dx)));
+    rhs_max      = fmax(rhs_max, fabs(rhs_d[id]));
+  }
+
+  reduction_utilities::gridReduceMax(residual_max, &norms_d[0]);
+  // Both reductions use the same shared memory
+  __syncthreads();
+  reduction_utilities::gridReduceMax(rhs_max, &norms_d[1]);
+}
+
+void Potential_SOR_3D::Multigrid_Norms(Real &residual_max, Real &rhs_max)
+{
+  MG_Level const &mg = mg_levels[0];
+  cuda_utilities::AutomaticLaunchParams static const launchParams(Multigrid_Norms_Kernel);
+
+  Real norms[2] = {0, 0};
+  GPU_Error_Check(cudaMemcpy(mg_norms_d, norms, 2 * sizeof(Real), cudaMemcpyHostToDevice));
+  hipLaunchKernelGGL(Multigrid_Norms_Kernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, mg.phi_d,
+                     mg.rhs_d, mg.nx, mg.ny, mg.nz, mg.n_ghost, mg.dx, mg_norms_d);
+  GPU_Error_Check(cudaMemcpy(norms, mg_norms_d, 2 * sizeof(Real), cudaMemcpyDeviceToHost));
+
+  residual_max = norms[0];
+  rhs_max      = norms[1];
+}
+  #endif  // MULTIGRID
+
 #endif  // GRAVITY
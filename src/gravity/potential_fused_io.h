@@ -0,0 +1,37 @@
+/*! \file potential_fused_io.h
+ *  \brief Declaration of the device arrays that the Paris Poisson solvers read
+ *  in their input packing and add in their output unpacking when gravity runs
+ *  on the GPU. This avoids the full grid passes of copying the hydro and
+ *  particle densities into the gravity density and of adding the analytic
+ *  potential. */
+
+#pragma once
+
+#include "../global/global.h"
+
+// With GRAVITY_GPU the Paris solvers read the hydro density straight from the
+// conserved array and write the potential without intermediate copies
+#if defined(GRAVITY_GPU) && (defined(PARIS) || defined(PARIS_GALACTIC)) && !defined(SOR)
+  #define POISSON_FUSED_IO
+#endif
+
+/*! \struct PotentialFusedIO
+ *  \brief Optional inputs of the Paris solvers. The default leaves the density
+ *  and the potential untouched, so the solvers behave as if it wasn't there */
+struct PotentialFusedIO {
+  /// The hydro density of the conserved array on the device, with
+  /// hydro_n_ghost ghost cells. When set it is scaled by hydro_scale and added
+  /// to the input density, which may then be null if there are no particles
+  const Real *hydro_density = nullptr;
+  int hydro_n_ghost         = 0;
+  /// Cosmo.rho_0_gas for cosmological runs, 1 otherwise
+  Real hydro_scale = 1;
+  /// The CIC density of the particles on the device, with particle_n_ghost
+  /// ghost cells whose contributions the density boundary transfer already
+  /// added to the real cells. When set it is added to the input density
+  const Real *particle_density = nullptr;
+  int particle_n_ghost         = 0;
+  /// The analytic potential on the device, with N_GHOST_POTENTIAL ghost cells.
+  /// When set it is added to the real cells of the solution
+  const Real_Analytic *analytic_potential = nullptr;
+};
@@ -7,6 +7,7 @@
   #include "../gravity/potential_paris_3D.h"
   #include "../io/io.h"
   #include "../utils/gpu.hpp"
+  #include "paris/FFTCache.hpp"
 
 static void __attribute__((unused)) Print_Diff(const Real *p, const Real *q, const int ng, const int nx, const int ny,
                                                const int nz, const bool plot = false)
@@ -65,61 +66,91 @@ PotentialParis3D::PotentialParis3D()
       pp_(nullptr),
       minBytes_(0),
       densityBytes_(0),
-      potentialBytes_(0),
-      da_(nullptr),
-      db_(nullptr)
+      potentialBytes_(0)
 {
 }
 
 PotentialParis3D::~PotentialParis3D() { Reset(); }
 
 void PotentialParis3D::Get_Potential(const Real *const density, Real *const potential, const Real g, const Real offset,
-                                     const Real a)
+                                     const Real a, const PotentialFusedIO &fused)
 {
   #ifdef COSMOLOGY
   const Real scale = Real(4) * M_PI * g / a;
   #else
   const Real scale = Real(4) * M_PI * g;
   #endif
-  assert(da_);
-  Real *const da = da_;
-  Real *const db = db_;
-  assert(density);
+  assert(pp_);
+  // Work arrays from the scratch pool shared by all the Paris solvers
+  Real *const da = FFTCache::device(0, std::max(minBytes_, densityBytes_));
+  Real *const db = FFTCache::device(1, std::max(minBytes_, potentialBytes_));
+  assert(density || fused.hydro_density || fused.particle_density);
 
   const int ni = dn_[2];
   const int nj = dn_[1];
   const int nk = dn_[0];
 
-  const int n = ni * nj * nk;
-  #ifdef GRAVITY_GPU
-  GPU_Error_Check(cudaMemcpy(db, density, densityBytes_, cudaMemcpyDeviceToDevice));
-  #else
-  GPU_Error_Check(cudaMemcpy(db, density, densityBytes_, cudaMemcpyHostToDevice));
-  #endif
   const int ngi = ni + N_GHOST_POTENTIAL + N_GHOST_POTENTIAL;
   const int ngj = nj + N_GHOST_POTENTIAL + N_GHOST_POTENTIAL;
 
+  #ifdef GRAVITY_GPU
+  // Pack the scaled density straight from the gravity, hydro and particle
+  // density arrays, without copying any of them first
+  const Real *const hydro    = fused.hydro_density;
+  const Real hydro_scale     = fused.hydro_scale;
+  const int nhg              = fused.hydro_n_ghost;
+  const int nhi              = ni + nhg + nhg;
+  const int nhj              = nj + nhg + nhg;
+  const Real *const particle = fused.particle_density;
+  const int npg              = fused.particle_n_ghost;
+  const int npi              = ni + npg + npg;
+  const int npj              = nj + npg + npg;
+  gpuFor(
+      nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
+        const int ia = i + ni * (j + nj * k);
+        Real rho     = density ? density[ia] : 0;
+        if (hydro) {
+          rho += hydro_scale * hydro[i + nhg + nhi * (j + nhg + nhj * (k + nhg))];
+        }
+        if (particle) {
+          rho += particle[i + npg + npi * (j + npg + npj * (k + npg))];
+        }
+        db[ia] = scale * (rho - offset);
+      });
+  #else
+  const int n = ni * nj * nk;
+  GPU_Error_Check(cudaMemcpy(db, density, densityBytes_, cudaMemcpyHostToDevice));
   gpuFor(
       n, GPU_LAMBDA(const int i) { db[i] = scale * (db[i] - offset); });
+  #endif
   pp_->solve(minBytes_, db, da);
+
+  assert(potential);
+  #ifdef GRAVITY_GPU
+  // Unpack the solution straight into the potential, adding the analytic
+  // potential in the same pass
+  const Real_Analytic *const analytic = fused.analytic_potential;
+  gpuFor(
+      nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
+        const int ia  = i + ni * (j + nj * k);
+        const int ib  = i + N_GHOST_POTENTIAL + ngi * (j + N_GHOST_POTENTIAL + ngj * (k + N_GHOST_POTENTIAL));
+        potential[ib] = analytic ? da[ia] + analytic[ib] : da[ia];
+      });
+  #else
   gpuFor(
       nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
         const int ia = i + ni * (j + nj * k);
         const int ib = i + N_GHOST_POTENTIAL + ngi * (j + N_GHOST_POTENTIAL + ngj * (k + N_GHOST_POTENTIAL));
         db[ib]       = da[ia];
       });
-
-  assert(potential);
-  #ifdef GRAVITY_GPU
-  GPU_Error_Check(cudaMemcpy(potential, db, potentialBytes_, cudaMemcpyDeviceToDevice));
-  #else
   GPU_Error_Check(cudaMemcpy(potential, db, potentialBytes_, cudaMemcpyDeviceToHost));
   #endif
 }
 
 void PotentialParis3D::Initialize(const Real lx, const Real ly, const Real lz, const Real xMin, const Real yMin,
                                   const Real zMin, const int nx, const int ny, const int nz, const int nxReal,
-                                  const int nyReal, const int nzReal, const Real dx, const Real dy, const Real dz)
+                                  const int nyReal, const int nzReal, const Real dx, const Real dy, const Real dz,
+                                  const int gatherCells)
 {
   chprintf(" Using Poisson Solver: Paris Periodic");
   #ifdef PARIS_5PT
@@ -164,32 +195,23 @@ void PotentialParis3D::Initialize(const Real lx, const Real ly, const Real lz, c
   assert(dn_[1] == n[1] / m[1]);
   assert(dn_[2] == n[2] / m[2]);
 
-  pp_ = new ParisPeriodic(n, lo_, hi, m, id);
+  pp_ = new ParisPeriodic(n, lo_, hi, m, id, gatherCells);
   assert(pp_);
+  if (pp_->gatherTasks() > 1) {
+    chprintf("  Paris: FFTs gathered from %d tasks onto each FFT task\n", pp_->gatherTasks());
+  }
   minBytes_       = pp_->bytes();
   densityBytes_   = long(sizeof(Real)) * dn_[0] * dn_[1] * dn_[2];
   const long gg   = N_GHOST_POTENTIAL + N_GHOST_POTENTIAL;
   potentialBytes_ = long(sizeof(Real)) * (dn_[0] + gg) * (dn_[1] + gg) * (dn_[2] + gg);
 
-  GPU_Error_Check(cudaMalloc(reinterpret_cast<void **>(&da_), std::max(minBytes_, densityBytes_)));
-  assert(da_);
-
-  GPU_Error_Check(cudaMalloc(reinterpret_cast<void **>(&db_), std::max(minBytes_, potentialBytes_)));
-  assert(db_);
+  // Reserve the work arrays up front so the pool does not grow during a solve
+  FFTCache::device(0, std::max(minBytes_, densityBytes_));
+  FFTCache::device(1, std::max(minBytes_, potentialBytes_));
 }
 
 void PotentialParis3D::Reset()
 {
-  if (db_) {
-    GPU_Error_Check(cudaFree(db_));
-  }
-  db_ = nullptr;
-
-  if (da_) {
-    GPU_Error_Check(cudaFree(da_));
-  }
-  da_ = nullptr;
-
   potentialBytes_ = densityBytes_ = minBytes_ = 0;
 
   if (pp_) {
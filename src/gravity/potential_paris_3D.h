@@ -3,6 +3,7 @@
 #if defined(GRAVITY) && defined(PARIS)
 
   #include "../global/global.h"
+  #include "../gravity/potential_fused_io.h"
   #include "paris/ParisPeriodic.hpp"
 
 class PotentialParis3D
@@ -10,9 +11,10 @@ class PotentialParis3D
  public:
   PotentialParis3D();
   ~PotentialParis3D();
-  void Get_Potential(const Real *density, Real *potential, Real g, Real massInfo, Real a);
+  void Get_Potential(const Real *density, Real *potential, Real g, Real massInfo, Real a,
+                     const PotentialFusedIO &fused = PotentialFusedIO());
   void Initialize(Real lx, Real ly, Real lz, Real xMin, Real yMin, Real zMin, int nx, int ny, int nz, int nxReal,
-                  int nyReal, int nzReal, Real dx, Real dy, Real dz);
+                  int nyReal, int nzReal, Real dx, Real dy, Real dz, int gatherCells = 0);
   void Reset();
 
  protected:
@@ -22,8 +24,6 @@ class PotentialParis3D
   long minBytes_;
   long densityBytes_;
   long potentialBytes_;
-  Real *da_;
-  Real *db_;
 };
 
 #endif
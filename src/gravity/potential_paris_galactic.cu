@@ -4,7 +4,9 @@
 
   #include "../gravity/potential_paris_galactic.h"
   #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/gpu.hpp"
+  #include "paris/FFTCache.hpp"
 
 PotentialParisGalactic::PotentialParisGalactic()
     : dn_{0, 0, 0},
@@ -14,9 +16,7 @@ PotentialParisGalactic::PotentialParisGalactic()
       myLo_{0, 0, 0},
       pp_(nullptr),
       densityBytes_(0),
-      minBytes_(0),
-      da_(nullptr),
-      db_(nullptr)
+      minBytes_(0)
   #ifndef GRAVITY_GPU
       ,
       potentialBytes_(0),
@@ -28,14 +28,15 @@ PotentialParisGalactic::PotentialParisGalactic()
 PotentialParisGalactic::~PotentialParisGalactic() { Reset(); }
 
 void PotentialParisGalactic::Get_Potential(const Real *const density, Real *const potential, const Real g,
-                                           const DiskGalaxy &galaxy)
+                                           const DiskGalaxy &galaxy, const PotentialFusedIO &fused)
 {
   const Real scale = Real(4) * M_PI * g;
 
-  assert(da_);
-  Real *const da = da_;
-  Real *const db = db_;
-  assert(density);
+  assert(pp_);
+  // Work arrays from the scratch pool shared by all the Paris solvers
+  Real *const da = FFTCache::device(0, std::max(minBytes_, densityBytes_));
+  Real *const db = FFTCache::device(1, std::max(minBytes_, densityBytes_));
+  assert(density || fused.hydro_density || fused.particle_density);
 
   const int ni = dn_[2];
   const int nj = dn_[1];
@@ -66,6 +67,18 @@ void PotentialParisGalactic::Get_Potential(const Real *const density, Real *cons
   const Real rd = galaxy.getR_d();
   const Real zd = galaxy.getZ_d();
 
+  // The hydro and particle densities are only set with GRAVITY_GPU, when they
+  // are read straight from the conserved and CIC arrays
+  const Real *const hydro    = fused.hydro_density;
+  const Real hydro_scale     = fused.hydro_scale;
+  const int nhg              = fused.hydro_n_ghost;
+  const int nhi              = ni + nhg + nhg;
+  const int nhj              = nj + nhg + nhg;
+  const Real *const particle = fused.particle_density;
+  const int npg              = fused.particle_n_ghost;
+  const int npi              = ni + npg + npg;
+  const int npj              = nj + npg + npg;
+
   const Real rho0 = md * zd * zd / (4.0 * M_PI);
   gpuFor(
       nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
@@ -81,12 +94,21 @@ void PotentialParisGalactic::Get_Potential(const Real *const density, Real *cons
         const Real c    = r * r + b * b;
         const Real dRho = rho0 * (rd * c + 3.0 * a * b * b) / (a * a * a * pow(c, 2.5));
 
-        da[ia] = scale * (rho[ia] - dRho);
+        Real dens = rho ? rho[ia] : 0;
+        if (hydro) {
+          dens += hydro_scale * hydro[i + nhg + nhi * (j + nhg + nhj * (k + nhg))];
+        }
+        if (particle) {
+          dens += particle[i + npg + npi * (j + npg + npj * (k + npg))];
+        }
+        da[ia] = scale * (dens - dRho);
       });
 
   pp_->solve(minBytes_, da, db);
 
-  const Real phi0 = -g * md;
+  // Like the hydro density the analytic potential is only set with GRAVITY_GPU
+  const Real_Analytic *const analytic = fused.analytic_potential;
+  const Real phi0                     = -g * md;
   gpuFor(
       nk, nj, ni, GPU_LAMBDA(const int k, const int j, const int i) {
         const int ia = i + ni * (j + nj * k);
@@ -102,7 +124,7 @@ void PotentialParisGalactic::Get_Potential(const Real *const density, Real *cons
         const Real c    = sqrt(r * r + b * b);
         const Real dPhi = phi0 / c;
 
-        phi[ib] = db[ia] + dPhi;
+        phi[ib] = analytic ? db[ia] + dPhi + analytic[ib] : db[ia] + dPhi;
       });
 
   #ifndef GRAVITY_GPU
@@ -154,13 +176,15 @@ void PotentialParisGalactic::Initialize(const Real lx, const Real ly, const Real
   minBytes_     = pp_->bytes();
   densityBytes_ = long(sizeof(Real)) * dn_[0] * dn_[1] * dn_[2];
 
-  GPU_Error_Check(cudaMalloc(reinterpret_cast<void **>(&da_), std::max(minBytes_, densityBytes_)));
-  GPU_Error_Check(cudaMalloc(reinterpret_cast<void **>(&db_), std::max(minBytes_, densityBytes_)));
+  // Reserve the work arrays up front so the pool does not grow during a solve
+  FFTCache::device(0, std::max(minBytes_, densityBytes_));
+  FFTCache::device(1, std::max(minBytes_, densityBytes_));
 
   #ifndef GRAVITY_GPU
   const long gg   = N_GHOST_POTENTIAL + N_GHOST_POTENTIAL;
   potentialBytes_ = long(sizeof(Real)) * (dn_[0] + gg) * (dn_[1] + gg) * (dn_[2] + gg);
-  GPU_Error_Check(cudaMalloc(reinterpret_cast<void **>(&dc_), potentialBytes_));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::gravity);
+  cuda_utilities::Pool_Malloc(&dc_, potentialBytes_);
   #endif
 }
 
@@ -168,22 +192,12 @@ void PotentialParisGalactic::Reset()
 {
   #ifndef GRAVITY_GPU
   if (dc_) {
-    GPU_Error_Check(cudaFree(dc_));
+    cuda_utilities::Pool_Free(dc_);
   }
   dc_             = nullptr;
   potentialBytes_ = 0;
   #endif
 
-  if (db_) {
-    GPU_Error_Check(cudaFree(db_));
-  }
-  db_ = nullptr;
-
-  if (da_) {
-    GPU_Error_Check(cudaFree(da_));
-  }
-  da_ = nullptr;
-
   densityBytes_ = minBytes_ = 0;
 
   if (pp_) {
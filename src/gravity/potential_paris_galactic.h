@@ -3,6 +3,7 @@
 #ifdef PARIS_GALACTIC
 
   #include "../global/global.h"
+  #include "../gravity/potential_fused_io.h"
   #include "../model/disk_galaxy.h"
   #include "paris/PoissonZero3DBlockedGPU.hpp"
 
@@ -11,7 +12,8 @@ class PotentialParisGalactic
  public:
   PotentialParisGalactic();
   ~PotentialParisGalactic();
-  void Get_Potential(const Real *density, Real *potential, Real g, const DiskGalaxy &galaxy);
+  void Get_Potential(const Real *density, Real *potential, Real g, const DiskGalaxy &galaxy,
+                     const PotentialFusedIO &fused = PotentialFusedIO());
   void Initialize(Real lx, Real ly, Real lz, Real xMin, Real yMin, Real zMin, int nx, int ny, int nz, int nxReal,
                   int nyReal, int nzReal, Real dx, Real dy, Real dz);
   void Reset();
@@ -22,8 +24,6 @@ class PotentialParisGalactic
   PoissonZero3DBlockedGPU *pp_;
   long densityBytes_;
   long minBytes_;
-  Real *da_;
-  Real *db_;
   #ifndef GRAVITY_GPU
   long potentialBytes_;
   Real *dc_;
@@ -13,39 +13,101 @@
 #include "../mpi/mpi_routines.h"
 #include "../utils/error_handling.h"
 
+#if defined(MPI_COALESCE_BOUNDARIES) && !(defined(MPI_CHOLLA) && defined(GRAVITY_GPU))
+  #error "MPI_COALESCE_BOUNDARIES requires MPI_CHOLLA and GRAVITY_GPU"
+#endif  // MPI_COALESCE_BOUNDARIES
+
 /*! \fn void Set_Boundary_Conditions_Grid(Parameters P )
  *  \brief Set the boundary conditions for all components based on info in the
  * parameters structure. */
 void Grid3D::Set_Boundary_Conditions_Grid(Parameters P)
 {
+#ifdef GRAVITY
+  bool potential_transferred = false;
+#endif  // GRAVITY
+
 #ifndef ONLY_PARTICLES
   // Dont transfer Hydro boundaries when only doing particles
+  #ifdef VL_OVERLAP
+  // or when the hydro integrator transfers them at the start of the next step
+  if (!H.OVERLAP_HYDRO_BOUNDARIES) {
+  #endif  // VL_OVERLAP
 
   // Transfer Hydro Conserved boundaries
   #ifdef CPU_TIME
   Timer.Boundaries.Start();
   #endif  // CPU_TIME
   H.TRANSFER_HYDRO_BOUNDARIES = true;
+  #ifdef MPI_COALESCE_BOUNDARIES
+  // Send the potential in the same messages as the hydro boundaries, unless
+  // the hydro boundaries go through the 26 neighbor exchange
+  potential_transferred              = Grav.POTENTIAL_SOLVED && !P.mpi_26_neighbors;
+  Grav.TRANSFER_POTENTIAL_BOUNDARIES = potential_transferred;
+  #endif  // MPI_COALESCE_BOUNDARIES
   Set_Boundary_Conditions(P);
   H.TRANSFER_HYDRO_BOUNDARIES = false;
+  #ifdef MPI_COALESCE_BOUNDARIES
+  Grav.TRANSFER_POTENTIAL_BOUNDARIES = false;
+  #endif  // MPI_COALESCE_BOUNDARIES
   #ifdef CPU_TIME
   Timer.Boundaries.End();
   #endif  // CPU_TIME
+  #ifdef VL_OVERLAP
+  }
+  #endif  // VL_OVERLAP
 #endif    // ONLY_PARTICLES
 
 // If the Gravity coupling is on the CPU, the potential is not in the Conserved
-// arrays, and its boundaries need to be transferred separately
+// arrays, and its boundaries need to be transferred separately. A potential
+// kept from the previous step when subcycling already has its boundaries
 #ifdef GRAVITY
+  if (Grav.POTENTIAL_SOLVED && !potential_transferred) {
   #ifdef CPU_TIME
-  Timer.Pot_Boundaries.Start();
+    Timer.Pot_Boundaries.Start();
   #endif  // CPU_TIME
-  Grav.TRANSFER_POTENTIAL_BOUNDARIES = true;
-  Set_Boundary_Conditions(P);
-  Grav.TRANSFER_POTENTIAL_BOUNDARIES = false;
+    Grav.TRANSFER_POTENTIAL_BOUNDARIES = true;
+    Set_Boundary_Conditions(P);
+    Grav.TRANSFER_POTENTIAL_BOUNDARIES = false;
   #ifdef CPU_TIME
-  Timer.Pot_Boundaries.End();
+    Timer.Pot_Boundaries.End();
   #endif  // CPU_TIME
-#endif    // GRAVITY
+  }
+#endif  // GRAVITY
+}
+
+/*! \fn void Set_Hydro_Boundary_Conditions_Fields(Parameters P, std::vector<int> const &fields, int n_ghost)
+ *  \brief Transfer the Conserved boundaries of only some of the fields and
+ * only the n_ghost cells closest to the interior. */
+void Grid3D::Set_Hydro_Boundary_Conditions_Fields(Parameters P, std::vector<int> const &fields, int n_ghost)
+{
+  if (fields.size() > static_cast<size_t>(FieldList::max_fields)) {
+    CHOLLA_ERROR("Can't select more than %d fields for a boundary transfer", FieldList::max_fields);
+  }
+  if (n_ghost < 1 or n_ghost > H.n_ghost) {
+    CHOLLA_ERROR("The ghost depth of a boundary transfer must be between 1 and %d", H.n_ghost);
+  }
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (fields[i] < 0 or fields[i] >= H.n_fields) {
+      CHOLLA_ERROR("Field %d selected for a boundary transfer does not exist", fields[i]);
+    }
+    H.transfer_hydro_fields.field[i] = fields[i];
+  }
+  H.transfer_hydro_fields.n_fields = fields.size();
+  H.transfer_hydro_n_ghost         = n_ghost;
+
+#ifdef CPU_TIME
+  Timer.Boundaries.Start();
+#endif  // CPU_TIME
+  H.TRANSFER_HYDRO_BOUNDARIES = true;
+  Set_Boundary_Conditions(P);
+  H.TRANSFER_HYDRO_BOUNDARIES = false;
+#ifdef CPU_TIME
+  Timer.Boundaries.End();
+#endif  // CPU_TIME
+
+  // Go back to transferring all fields and ghost cells
+  H.transfer_hydro_fields.n_fields = 0;
+  H.transfer_hydro_n_ghost         = H.n_ghost;
 }
 
 /*! \fn void Set_Boundary_Conditions(Parameters P )
@@ -66,6 +128,12 @@ void Grid3D::Set_Boundary_Conditions(Parameters P)
   n_bounds += (int)Particles.TRANSFER_PARTICLES_BOUNDARIES;
   n_bounds += (int)Particles.TRANSFER_DENSITY_BOUNDARIES;
 #endif  // PARTICLES
+#ifdef MPI_COALESCE_BOUNDARIES
+  // The hydro and potential boundaries can share the messages
+  if (H.TRANSFER_HYDRO_BOUNDARIES && Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
+    n_bounds--;
+  }
+#endif  // MPI_COALESCE_BOUNDARIES
 
   if (n_bounds > 1) {
     printf(
@@ -101,18 +169,22 @@ void Grid3D::Set_Boundary_Conditions(Parameters P)
     Custom_Boundary(P.custom_bcnd);
   }
 
-  // set regular boundaries
-  if (H.nx > 1) {
-    Set_Boundaries(0, flags);
-    Set_Boundaries(1, flags);
-  }
-  if (H.ny > 1) {
-    Set_Boundaries(2, flags);
-    Set_Boundaries(3, flags);
-  }
-  if (H.nz > 1) {
-    Set_Boundaries(4, flags);
-    Set_Boundaries(5, flags);
+  // set regular boundaries, the hydro ones all at once
+  if (H.TRANSFER_HYDRO_BOUNDARIES) {
+    Set_Hydro_Boundaries_Single_Launch(flags);
+  } else {
+    if (H.nx > 1) {
+      Set_Boundaries(0, flags);
+      Set_Boundaries(1, flags);
+    }
+    if (H.ny > 1) {
+      Set_Boundaries(2, flags);
+      Set_Boundaries(3, flags);
+    }
+    if (H.nz > 1) {
+      Set_Boundaries(4, flags);
+      Set_Boundaries(5, flags);
+    }
   }
 
   #ifdef GRAVITY
@@ -271,7 +343,10 @@ void Grid3D::Set_Boundaries(int dir, int flags[])
       }
   #endif  // GRAVITY_GPU
     }
-    return;
+    // The hydro boundaries may be set together with the potential
+    if (!H.TRANSFER_HYDRO_BOUNDARIES) {
+      return;
+    }
   }
   #ifdef SOR
   if (Grav.Poisson_solver.TRANSFER_POISSON_BOUNDARIES) {
@@ -414,6 +489,29 @@ void Grid3D::Set_Boundaries(int dir, int flags[])
                 imax[1] - imin[1], imax[2] - imin[2], imin[0], imin[1], imin[2], dir);
 }
 
+/*! \fn void Set_Hydro_Boundaries_Single_Launch(int flags[])
+ *  \brief Set the hydro ghost cells of all the regular faces in one launch. */
+void Grid3D::Set_Hydro_Boundaries_Single_Launch(int flags[])
+{
+  if (!ghost_cell_map.Matches(flags)) {
+    // the regions of the faces are disjoint and every ghost cell copies a
+    // real cell, so the order of the faces doesn't matter
+    ghost_cell_map.Clear(flags);
+    int const n_dims[3] = {H.nx, H.ny, H.nz};
+    for (int dir = 0; dir < 6; dir++) {
+      if (n_dims[dir / 2] > 1) {
+        int imin[3] = {0, 0, 0};
+        int imax[3] = {H.nx, H.ny, H.nz};
+        Set_Boundary_Extents(dir, &imin[0], &imax[0]);
+        ghost_cell_map.Add_Region(H.nx, H.ny, H.nz, H.n_ghost, imax[0] - imin[0], imax[1] - imin[1], imax[2] - imin[2],
+                                  imin[0], imin[1], imin[2], dir);
+      }
+    }
+    ghost_cell_map.Upload();
+  }
+  ghost_cell_map.Apply(C.device, H.n_fields, H.n_cells);
+}
+
 /*! \fn Set_Boundary_Extents(int dir, int *imin, int *imax)
  *  \brief Set the extents of the ghost region we are initializing. */
 void Grid3D::Set_Boundary_Extents(int dir, int *imin, int *imax)
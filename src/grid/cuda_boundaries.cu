@@ -1,164 +1,420 @@
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include "../global/global.h"
 #include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
 #include "../utils/cuda_utilities.h"
 #include "../utils/gpu.hpp"
 #include "cuda_boundaries.h"
 
-__device__ int FindIndex(int ig, int nx, int flag, int face, int n_ghost, Real *a);
+__host__ __device__ int FindIndex(int ig, int nx, int flag, int face, int n_ghost, Real *a);
+
+__host__ __device__ int SetBoundaryMapping(int ig, int jg, int kg, Real *a, int flags[], int nx, int ny, int nz,
+                                           int n_ghost);
 
-__device__ int SetBoundaryMapping(int ig, int jg, int kg, Real *a, int flags[], int nx, int ny, int nz, int n_ghost);
+// A cell of a buffer of PackBoxes3D and UnpackBoxes3D: its index in the grid,
+// the index of its first field in the buffer and the stride of the fields
+struct BoxCell {
+  int cell, buffer, stride;
+};
 
-__global__ void PackBuffers3DKernel(Real *buffer, Real *c_head, int isize, int jsize, int ksize, int nx, int ny,
-                                    int idxoffset, int buffer_ncells, int n_fields, int n_cells)
+// Find the box that cell tid of a packed buffer belongs to, and the index of
+// the cell in the grid and in the buffer
+void FindBufferBox(int tid, BufferBoxes const &boxes, int nx, int ny, int n_fields, int &idx, int &buffer_idx,
+                   int &box_ncells)
 {
-  int id, i, j, k, idx, ii;
-  id = threadIdx.x + blockIdx.x * blockDim.x;
-  if (id >= buffer_ncells) {
-    return;
+  int b = 0;
+  while (b + 1 < boxes.n_boxes && tid >= boxes.box[b + 1].cell_start) {
+    b++;
   }
-  k   = id / (isize * jsize);
-  j   = (id - k * isize * jsize) / isize;
-  i   = id - k * isize * jsize - j * isize;
-  idx = i + (j + k * ny) * nx + idxoffset;
+  BufferBox const &box = boxes.box[b];
+
+  int i, j, k;
+  int const id = tid - box.cell_start;
+  cuda_utilities::compute3DIndices(id, box.isize, box.jsize, i, j, k);
+  idx        = i + (j + k * ny) * nx + box.idxoffset;
+  buffer_idx = n_fields * box.cell_start + id;
+  box_ncells = box.isize * box.jsize * box.ksize;
+}
+
+namespace
+{
+// The device index lists of the buffers and the ghost regions, built the first
+// time a region is packed, unpacked or set. The boundary geometry doesn't
+// change after Grid3D::Initialize so there are only a few of them
+std::map<std::vector<int>, int *> buffer_cell_lists;
+std::map<std::vector<int>, BoxCell *> box_cell_lists;
+std::map<std::vector<int>, GhostCellMap> ghost_region_maps;
+
+template <typename T>
+T *Copy_List_To_Device(std::vector<T> const &list)
+{
+  T *dev_list;
+  GPU_Error_Check(cudaMalloc((void **)&dev_list, list.size() * sizeof(T)));
+  GPU_Error_Check(cudaMemcpy(dev_list, list.data(), list.size() * sizeof(T), cudaMemcpyHostToDevice));
+  return dev_list;
+}
+
+// The grid index of each cell of a box of isize*jsize*ksize cells starting at
+// cell idxoffset, in the order of the buffer
+int const *Buffer_Cell_List(int nx, int ny, int idxoffset, int isize, int jsize, int ksize)
+{
+  std::vector<int> const key = {nx, ny, idxoffset, isize, jsize, ksize};
+  auto const found           = buffer_cell_lists.find(key);
+  if (found != buffer_cell_lists.end()) {
+    return found->second;
+  }
+
   // idxoffset contains offset terms from
   // idx = (i+ioffset) + (j+joffset)*H.nx + (k+koffset)*H.nx*H.ny;
-  for (ii = 0; ii < n_fields; ii++) {
-    *(buffer + id + ii * buffer_ncells) = c_head[idx + ii * n_cells];
+  std::vector<int> cells;
+  cells.reserve(isize * jsize * ksize);
+  for (int k = 0; k < ksize; k++) {
+    for (int j = 0; j < jsize; j++) {
+      for (int i = 0; i < isize; i++) {
+        cells.push_back(i + (j + k * ny) * nx + idxoffset);
+      }
+    }
+  }
+  return buffer_cell_lists[key] = Copy_List_To_Device(cells);
+}
+
+// The cells of FindBufferBox of every cell of the boxes
+BoxCell const *Box_Cell_List(BufferBoxes const &boxes, int nx, int ny, int n_fields)
+{
+  std::vector<int> key = {nx, ny, n_fields, boxes.n_boxes, boxes.buffer_ncells};
+  for (int b = 0; b < boxes.n_boxes; b++) {
+    BufferBox const &box = boxes.box[b];
+    key.insert(key.end(), {box.idxoffset, box.isize, box.jsize, box.ksize, box.cell_start});
+  }
+  auto const found = box_cell_lists.find(key);
+  if (found != box_cell_lists.end()) {
+    return found->second;
+  }
+
+  std::vector<BoxCell> cells(boxes.buffer_ncells);
+  for (int tid = 0; tid < boxes.buffer_ncells; tid++) {
+    FindBufferBox(tid, boxes, nx, ny, n_fields, cells[tid].cell, cells[tid].buffer, cells[tid].stride);
+  }
+  return box_cell_lists[key] = Copy_List_To_Device(cells);
+}
+}  // namespace
+
+void Free_Boundary_Index_Lists()
+{
+  for (auto &list : buffer_cell_lists) {
+    GPU_Error_Check(cudaFree(list.second));
+  }
+  for (auto &list : box_cell_lists) {
+    GPU_Error_Check(cudaFree(list.second));
+  }
+  for (auto &map : ghost_region_maps) {
+    map.second.Free();
+  }
+  buffer_cell_lists.clear();
+  box_cell_lists.clear();
+  ghost_region_maps.clear();
+}
+
+namespace
+{
+// The range of field indices that are packed as floats with precision
+void Halo_Float_Range(HaloPrecision precision, int n_fields, int &float_begin, int &float_end)
+{
+  switch (precision) {
+    case HaloPrecision::single:
+      float_begin = 0;
+      float_end   = n_fields;
+      break;
+    case HaloPrecision::scalars:
+      float_begin = grid_enum::scalar;
+      float_end   = grid_enum::finalscalar_plus_1;
+      break;
+    default:
+      float_begin = float_end = 0;
+      break;
+  }
+}
+}  // namespace
+
+int Halo_Float_Fields(int n_fields, FieldList const &fields, HaloPrecision precision)
+{
+  int float_begin, float_end;
+  Halo_Float_Range(precision, n_fields, float_begin, float_end);
+  if (fields.n_fields == 0) {
+    return std::max(0, std::min(float_end, n_fields) - float_begin);
+  }
+  int n_float = 0;
+  for (int ii = 0; ii < fields.n_fields; ii++) {
+    n_float += int(fields.field[ii] >= float_begin and fields.field[ii] < float_end);
+  }
+  return n_float;
+}
+
+// The fields in [float_begin, float_end) are stored as floats after the
+// n_full fields that keep the precision of Real
+__global__ void PackBuffers3DKernel(Real *buffer, Real *c_head, int const *cells, int buffer_ncells, int n_fields,
+                                    int n_cells, FieldList fields, int n_full, int float_begin, int float_end)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id >= buffer_ncells) {
+    return;
+  }
+  int const idx             = cells[id];
+  float *const float_buffer = reinterpret_cast<float *>(buffer + n_full * buffer_ncells);
+  // The next slot of each precision
+  int i_full = 0, i_float = 0;
+  for (int ii = 0; ii < n_fields; ii++) {
+    int const field  = (fields.n_fields > 0) ? fields.field[ii] : ii;
+    Real const value = c_head[idx + field * n_cells];
+    if (field >= float_begin and field < float_end) {
+      float_buffer[id + (i_float++) * buffer_ncells] = float(value);
+    } else {
+      buffer[id + (i_full++) * buffer_ncells] = value;
+    }
   }
 }
 
 void PackBuffers3D(Real *buffer, Real *c_head, int nx, int ny, int n_fields, int n_cells, int idxoffset, int isize,
-                   int jsize, int ksize)
+                   int jsize, int ksize, cudaStream_t stream, FieldList const &fields, HaloPrecision precision)
 {
-  int buffer_ncells = isize * jsize * ksize;
+  int buffer_ncells     = isize * jsize * ksize;
+  int const *const cells = Buffer_Cell_List(nx, ny, idxoffset, isize, jsize, ksize);
   dim3 dim1dGrid((buffer_ncells + TPB - 1) / TPB, 1, 1);
   dim3 dim1dBlock(TPB, 1, 1);
-  hipLaunchKernelGGL(PackBuffers3DKernel, dim1dGrid, dim1dBlock, 0, 0, buffer, c_head, isize, jsize, ksize, nx, ny,
-                     idxoffset, buffer_ncells, n_fields, n_cells);
-  GPU_Error_Check(cudaDeviceSynchronize());
+  int float_begin, float_end;
+  Halo_Float_Range(precision, n_fields, float_begin, float_end);
+  int const n_float = Halo_Float_Fields(n_fields, fields, precision);
+  if (fields.n_fields > 0) {
+    n_fields = fields.n_fields;
+  }
+  hipLaunchKernelGGL(PackBuffers3DKernel, dim1dGrid, dim1dBlock, 0, stream, buffer, c_head, cells, buffer_ncells,
+                     n_fields, n_cells, fields, n_fields - n_float, float_begin, float_end);
+  // The buffer is handed to MPI next so it has to be complete
+  GPU_Error_Check(cudaStreamSynchronize(stream));
 }
 
-__global__ void UnpackBuffers3DKernel(Real *buffer, Real *c_head, int isize, int jsize, int ksize, int nx, int ny,
-                                      int idxoffset, int buffer_ncells, int n_fields, int n_cells)
+__global__ void UnpackBuffers3DKernel(Real *buffer, Real *c_head, int const *cells, int buffer_ncells, int n_fields,
+                                      int n_cells, FieldList fields, int n_full, int float_begin, int float_end)
 {
-  int id, i, j, k, idx, ii;
-  id = threadIdx.x + blockIdx.x * blockDim.x;
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
   if (id >= buffer_ncells) {
     return;
   }
-  k   = id / (isize * jsize);
-  j   = (id - k * isize * jsize) / isize;
-  i   = id - k * isize * jsize - j * isize;
-  idx = i + (j + k * ny) * nx + idxoffset;
-  for (ii = 0; ii < n_fields; ii++) {
-    c_head[idx + ii * n_cells] = *(buffer + id + ii * buffer_ncells);
+  int const idx                   = cells[id];
+  float const *const float_buffer = reinterpret_cast<float const *>(buffer + n_full * buffer_ncells);
+  // The next slot of each precision
+  int i_full = 0, i_float = 0;
+  for (int ii = 0; ii < n_fields; ii++) {
+    int const field = (fields.n_fields > 0) ? fields.field[ii] : ii;
+    if (field >= float_begin and field < float_end) {
+      c_head[idx + field * n_cells] = float_buffer[id + (i_float++) * buffer_ncells];
+    } else {
+      c_head[idx + field * n_cells] = buffer[id + (i_full++) * buffer_ncells];
+    }
   }
 }
 
 void UnpackBuffers3D(Real *buffer, Real *c_head, int nx, int ny, int n_fields, int n_cells, int idxoffset, int isize,
-                     int jsize, int ksize)
+                     int jsize, int ksize, cudaStream_t stream, FieldList const &fields, HaloPrecision precision)
 {
   // void UnpackBuffers3D(Real * buffer, Real * c_head, int isize, int jsize,
   // int ksize, int nx, int ny, int idxoffset, int offset, int n_fields, int
   // n_cells){
-  int buffer_ncells = isize * jsize * ksize;
+  int buffer_ncells     = isize * jsize * ksize;
+  int const *const cells = Buffer_Cell_List(nx, ny, idxoffset, isize, jsize, ksize);
   dim3 dim1dGrid((buffer_ncells + TPB - 1) / TPB, 1, 1);
   dim3 dim1dBlock(TPB, 1, 1);
-  hipLaunchKernelGGL(UnpackBuffers3DKernel, dim1dGrid, dim1dBlock, 0, 0, buffer, c_head, isize, jsize, ksize, nx, ny,
-                     idxoffset, buffer_ncells, n_fields, n_cells);
+  int float_begin, float_end;
+  Halo_Float_Range(precision, n_fields, float_begin, float_end);
+  int const n_float = Halo_Float_Fields(n_fields, fields, precision);
+  if (fields.n_fields > 0) {
+    n_fields = fields.n_fields;
+  }
+  hipLaunchKernelGGL(UnpackBuffers3DKernel, dim1dGrid, dim1dBlock, 0, stream, buffer, c_head, cells, buffer_ncells,
+                     n_fields, n_cells, fields, n_fields - n_float, float_begin, float_end);
 }
 
-__global__ void SetGhostCellsKernel(Real *c_head, int nx, int ny, int nz, int n_fields, int n_cells, int n_ghost,
-                                    int f0, int f1, int f2, int f3, int f4, int f5, int isize, int jsize, int ksize,
-                                    int imin, int jmin, int kmin, int dir)
+__global__ void PackBoxes3DKernel(Real *buffer, Real *c_head, BoxCell const *cells, int buffer_ncells, int n_fields,
+                                  int n_cells)
 {
-  int id, i, j, k, gidx, idx, ii;
-  Real a[3]    = {1., 1., 1.};
-  int flags[6] = {f0, f1, f2, f3, f4, f5};
+  for (int tid = threadIdx.x + blockIdx.x * blockDim.x; tid < buffer_ncells; tid += blockDim.x * gridDim.x) {
+    BoxCell const cell = cells[tid];
+    for (int ii = 0; ii < n_fields; ii++) {
+      buffer[cell.buffer + ii * cell.stride] = c_head[cell.cell + ii * n_cells];
+    }
+  }
+}
 
-  // using thread ID calculate which ghost cell this is
-  // calculate which real cell using SetBoundaryMapping
-  // and FindIndex
-  // set variables, flipping momentum sign when needed
-  // if flags[dir] == 3 correct the energy
+__global__ void UnpackBoxes3DKernel(Real *buffer, Real *c_head, BoxCell const *cells, int buffer_ncells, int n_fields,
+                                    int n_cells)
+{
+  for (int tid = threadIdx.x + blockIdx.x * blockDim.x; tid < buffer_ncells; tid += blockDim.x * gridDim.x) {
+    BoxCell const cell = cells[tid];
+    for (int ii = 0; ii < n_fields; ii++) {
+      c_head[cell.cell + ii * n_cells] = buffer[cell.buffer + ii * cell.stride];
+    }
+  }
+}
 
-  // calculate ghost cell ID and i,j,k
-  id = threadIdx.x + blockIdx.x * blockDim.x;
+void PackBoxes3D(Real *buffer, Real *c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const &boxes,
+                 cudaStream_t stream)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(PackBoxes3DKernel);
+  hipLaunchKernelGGL(PackBoxes3DKernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, stream, buffer,
+                     c_head, Box_Cell_List(boxes, nx, ny, n_fields), boxes.buffer_ncells, n_fields, n_cells);
+  // The buffer is handed to MPI next so it has to be complete
+  GPU_Error_Check(cudaStreamSynchronize(stream));
+}
 
-  // not true i,j,k but relative i,j,k
-  k = id / (isize * jsize);
-  j = (id - k * isize * jsize) / isize;
-  i = id - k * isize * jsize - j * isize;
-  if (id >= isize * jsize * ksize) {
-    return;
+void UnpackBoxes3D(Real *buffer, Real *c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const &boxes,
+                   cudaStream_t stream)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(UnpackBoxes3DKernel);
+  hipLaunchKernelGGL(UnpackBoxes3DKernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, stream, buffer,
+                     c_head, Box_Cell_List(boxes, nx, ny, n_fields), boxes.buffer_ncells, n_fields, n_cells);
+  GPU_Error_Check();
+}
+
+void SetGhostCells(Real *c_head, int nx, int ny, int nz, int n_fields, int n_cells, int n_ghost, int flags[], int isize,
+                   int jsize, int ksize, int imin, int jmin, int kmin, int dir)
+{
+  // the map of the region is built the first time it is set
+  std::vector<int> key = {nx, ny, nz, n_ghost, isize, jsize, ksize, imin, jmin, kmin, dir};
+  key.insert(key.end(), flags, flags + 6);
+  GhostCellMap &map = ghost_region_maps[key];
+  if (!map.Matches(flags)) {
+    map.Clear(flags);
+    map.Add_Region(nx, ny, nz, n_ghost, isize, jsize, ksize, imin, jmin, kmin, dir);
+    map.Upload();
   }
-  // true i,j,k conversion
-  i += imin;
-  j += jmin;
-  k += kmin;
-  gidx = i + j * nx + k * nx * ny;
+  map.Apply(c_head, n_fields, n_cells);
+}
 
-  // calculate idx (index of real cell) and a[:] for reflection
-  idx = SetBoundaryMapping(i, j, k, &a[0], flags, nx, ny, nz, n_ghost);
+// Set the ghost cells of a GhostCellMap: copy the real cell of each ghost
+// cell, flip the momenta of the reflections and stop the inflow through the
+// diodes of the transmissive faces
+__global__ void SetGhostCellMapKernel(Real *c_head, GhostCell const *cells, int n_ghost_cells, int n_fields,
+                                      int n_cells)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id >= n_ghost_cells) {
+    return;
+  }
+  GhostCell const cell = cells[id];
+  int const gidx       = cell.ghost;
 
-  if (idx >= 0) {
-    for (ii = 0; ii < n_fields; ii++) {
-      c_head[gidx + ii * n_cells] = c_head[idx + ii * n_cells];
-    }
-    // momentum correction for reflection
-    // these are set to -1 whenever ghost cells in a direction are in a
-    // reflective boundary condition
-    if (flags[0] == 2 || flags[1] == 2) {
-      c_head[gidx + n_cells] *= a[0];
+  for (int ii = 0; ii < n_fields; ii++) {
+    c_head[gidx + ii * n_cells] = c_head[cell.source + ii * n_cells];
+  }
+  // momentum correction for reflection
+  for (int axis = 0; axis < 3; axis++) {
+    if (cell.info & (1 << axis)) {
+      c_head[gidx + (axis + 1) * n_cells] *= -1.0;
     }
-    if (flags[2] == 2 || flags[3] == 2) {
-      c_head[gidx + 2 * n_cells] *= a[1];
+  }
+
+#ifndef MHD
+  // energy and momentum correction for transmission
+  // Diode: only allow outflow
+  if (cell.info & (1 << 3)) {
+    int const dir    = cell.info >> 4;
+    int const momdex = gidx + (dir / 2 + 1) * n_cells;
+    // Direction 0,2,4 are left-side, don't allow inflow with positive
+    // momentum. Direction 1,3,5 are right-side, don't allow inflow with
+    // negative momentum
+    if ((dir % 2 == 0) ? c_head[momdex] > 0.0 : c_head[momdex] < 0.0) {
+      c_head[gidx + 4 * n_cells] -= 0.5 * (c_head[momdex] * c_head[momdex]) / c_head[gidx];
+      c_head[momdex] = 0.0;
     }
-    if (flags[4] == 2 || flags[5] == 2) {
-      c_head[gidx + 3 * n_cells] *= a[2];
+  }
+#endif  // not MHD
+}
+
+bool GhostCellMap::Matches(int const flags[6]) const
+{
+  for (int i = 0; i < 6; i++) {
+    if (flags[i] != _flags[i]) {
+      return false;
     }
+  }
+  return true;
+}
 
-#ifndef MHD
-    // energy and momentum correction for transmission
-    // Diode: only allow outflow
-    if (flags[dir] == 3) {
-      //
-      int momdex = gidx + (dir / 2 + 1) * n_cells;
-      // (X) Dir 0,1 -> Mom 1 -> c_head[gidx+1*n_cells]
-      // (Y) Dir 2,3 -> Mom 2 -> c_head[gidx+2*n_cells]
-      // (Z) Dir 4,5 -> Mom 3 -> c_head[gidx+3*n_cells]
-      // If a momentum is set to 0, subtract its kinetic energy [gidx+4*n_cells]
-      if (dir % 2 == 0) {
-        // Direction 0,2,4 are left-side, don't allow inflow with positive
-        // momentum
-        if (c_head[momdex] > 0.0) {
-          c_head[gidx + 4 * n_cells] -= 0.5 * (c_head[momdex] * c_head[momdex]) / c_head[gidx];
-          c_head[momdex] = 0.0;
+void GhostCellMap::Clear(int const flags[6])
+{
+  for (int i = 0; i < 6; i++) {
+    _flags[i] = flags[i];
+  }
+  _host_cells.clear();
+}
+
+void GhostCellMap::Add_Region(int nx, int ny, int nz, int n_ghost, int isize, int jsize, int ksize, int imin, int jmin,
+                              int kmin, int dir)
+{
+  // the custom faces are set by their own kernels
+  if (_flags[dir] == 4) {
+    return;
+  }
+  for (int k = kmin; k < kmin + ksize; k++) {
+    for (int j = jmin; j < jmin + jsize; j++) {
+      for (int i = imin; i < imin + isize; i++) {
+        Real a[3]     = {1., 1., 1.};
+        int const idx = SetBoundaryMapping(i, j, k, &a[0], _flags, nx, ny, nz, n_ghost);
+        if (idx < 0) {
+          continue;
+        }
+        int info = (a[0] < 0) | ((a[1] < 0) << 1) | ((a[2] < 0) << 2) | (dir << 4);
+        if (_flags[dir] == 3) {
+          info |= 1 << 3;
         }
-      } else {
-        // Direction 1,3,5 are right-side, don't allow inflow with negative
-        // momentum
-        if (c_head[momdex] < 0.0) {
-          c_head[gidx + 4 * n_cells] -= 0.5 * (c_head[momdex] * c_head[momdex]) / c_head[gidx];
-          c_head[momdex] = 0.0;
+        // the ghost cells of the MPI faces map to themselves and are skipped
+        // unless they are corrected
+        int const gidx = i + j * nx + k * nx * ny;
+        if (idx == gidx && (info & 0xF) == 0) {
+          continue;
         }
+        _host_cells.push_back({gidx, idx, info});
       }
-    }   // end energy correction for transmissive boundaries
-#endif  // not MHD
-  }     // end idx>=0
-}  // end function
+    }
+  }
+}
 
-void SetGhostCells(Real *c_head, int nx, int ny, int nz, int n_fields, int n_cells, int n_ghost, int flags[], int isize,
-                   int jsize, int ksize, int imin, int jmin, int kmin, int dir)
+void GhostCellMap::Upload()
 {
-  dim3 dim1dGrid((isize * jsize * ksize + TPB - 1) / TPB, 1, 1);
+  Free();
+  _n_cells = _host_cells.size();
+  if (_n_cells > 0) {
+    GPU_Error_Check(cudaMalloc((void **)&_dev_cells, _n_cells * sizeof(GhostCell)));
+    GPU_Error_Check(cudaMemcpy(_dev_cells, _host_cells.data(), _n_cells * sizeof(GhostCell), cudaMemcpyHostToDevice));
+  }
+  _host_cells.clear();
+}
+
+void GhostCellMap::Apply(Real *c_head, int n_fields, int n_cells, cudaStream_t stream) const
+{
+  if (_n_cells == 0) {
+    return;
+  }
+  dim3 dim1dGrid((_n_cells + TPB - 1) / TPB, 1, 1);
   dim3 dim1dBlock(TPB, 1, 1);
-  hipLaunchKernelGGL(SetGhostCellsKernel, dim1dGrid, dim1dBlock, 0, 0, c_head, nx, ny, nz, n_fields, n_cells, n_ghost,
-                     flags[0], flags[1], flags[2], flags[3], flags[4], flags[5], isize, jsize, ksize, imin, jmin, kmin,
-                     dir);
+  hipLaunchKernelGGL(SetGhostCellMapKernel, dim1dGrid, dim1dBlock, 0, stream, c_head, _dev_cells, _n_cells, n_fields,
+                     n_cells);
+}
+
+void GhostCellMap::Free()
+{
+  if (_dev_cells != nullptr) {
+    GPU_Error_Check(cudaFree(_dev_cells));
+  }
+  _dev_cells = nullptr;
+  _n_cells   = 0;
 }
 
-__device__ int SetBoundaryMapping(int ig, int jg, int kg, Real *a, int flags[], int nx, int ny, int nz, int n_ghost)
+__host__ __device__ int SetBoundaryMapping(int ig, int jg, int kg, Real *a, int flags[], int nx, int ny, int nz,
+                                           int n_ghost)
 {
   // nx, ny, nz, n_ghost
   /* 1D */
@@ -237,7 +493,7 @@ __device__ int SetBoundaryMapping(int ig, int jg, int kg, Real *a, int flags[],
   return idx;
 }
 
-__device__ int FindIndex(int ig, int nx, int flag, int face, int n_ghost, Real *a)
+__host__ __device__ int FindIndex(int ig, int nx, int flag, int face, int n_ghost, Real *a)
 {
   int id;
 
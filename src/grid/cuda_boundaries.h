@@ -1,20 +1,119 @@
+#pragma once
+
+#include <vector>
+
 #include "../global/global.h"
 #include "../global/global_cuda.h"
 #include "../utils/gpu.hpp"
 
+/*! \brief A subset of the fields of the grid to pack into or unpack from a
+ * communication buffer, small enough to pass to a kernel by value. An empty
+ * list selects all the fields */
+struct FieldList {
+  static int constexpr max_fields = 32;
+  int n_fields = 0;
+  int field[max_fields];
+};
+
+/*! \brief The precision the fields of a communication buffer are packed in.
+ * With scalars the passive scalars, dust and chemistry species are packed as
+ * floats after the other fields, which keep the precision of Real */
+enum class HaloPrecision { full, single, scalars };
+
+/*! \brief The number of the n_fields fields, or of the selected fields, that
+ * are packed as floats with precision */
+int Halo_Float_Fields(int n_fields, FieldList const& fields, HaloPrecision precision);
+
 // void PackBuffers3D(Real * buffer, Real * c_head, int isize, int jsize, int
 // ksize, int nx, int ny, int idxoffset, int offset, int n_fields, int n_cells);
+// The fields that precision selects are packed as floats instead of Reals. The
+// cells are gathered from a device list of their grid indices that is built
+// the first time the box is packed or unpacked
 void PackBuffers3D(Real* buffer, Real* c_head, int nx, int ny, int n_fields, int n_cells, int idxoffset, int isize,
-                   int jsize, int ksize);
+                   int jsize, int ksize, cudaStream_t stream = 0, FieldList const& fields = FieldList(),
+                   HaloPrecision precision = HaloPrecision::full);
 
 void UnpackBuffers3D(Real* buffer, Real* c_head, int nx, int ny, int n_fields, int n_cells, int idxoffset, int isize,
-                     int jsize, int ksize);
+                     int jsize, int ksize, cudaStream_t stream = 0, FieldList const& fields = FieldList(),
+                     HaloPrecision precision = HaloPrecision::full);
 // void UnpackBuffers3D(Real * buffer, Real * c_head, int isize, int jsize, int
 // ksize, int nx, int ny, int idxoffset, int offset, int n_fields, int n_cells);
 
+/*! \brief A box of isize*jsize*ksize cells starting at cell idxoffset of the
+ * grid that is stored in a communication buffer. All the fields of the box are
+ * stored one after the other, starting at n_fields*cell_start */
+struct BufferBox {
+  int idxoffset, isize, jsize, ksize, cell_start;
+};
+
+/*! \brief A set of boxes packed into a single buffer, small enough to pass to
+ * a kernel by value. The boxes have to be sorted by cell_start */
+struct BufferBoxes {
+  static int constexpr max_boxes = 26;
+  BufferBox box[max_boxes];
+  int n_boxes;
+  int buffer_ncells;
+};
+
+// Pack or unpack all the boxes of a buffer in a single kernel launch. Like
+// PackBuffers3D and UnpackBuffers3D they gather the cells from a device list of
+// their grid indices that is built the first time the boxes are used
+void PackBoxes3D(Real* buffer, Real* c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const& boxes,
+                 cudaStream_t stream = 0);
+
+void UnpackBoxes3D(Real* buffer, Real* c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const& boxes,
+                   cudaStream_t stream = 0);
+
+// Free the device index lists of the buffers and the ghost regions
+void Free_Boundary_Index_Lists();
+
+// Set the ghost cells of the region of face dir with a GhostCellMap that is
+// built the first time the region is set
 void SetGhostCells(Real* c_head, int nx, int ny, int nz, int n_fields, int n_cells, int n_ghost, int flags[], int isize,
                    int jsize, int ksize, int imin, int jmin, int kmin, int dir);
 
+/*! \brief The real cell that a ghost cell copies, and how the kernel of
+ * GhostCellMap corrects the copy. The first three bits of info flip the x, y and z momenta
+ * of a reflection, the fourth bit is set for the diode of a transmissive face
+ * and the face dir of the ghost cell starts at the fifth bit */
+struct GhostCell {
+  int ghost, source, info;
+};
+
+/*! \brief The precomputed map of the ghost cells of all the regular faces,
+ * edges and corners of the grid to their real cells, so they are all set in a
+ * single launch instead of one SetGhostCells launch per face. The map is
+ * built on the host once per set of boundary flags and kept on the device */
+class GhostCellMap
+{
+ public:
+  /*! \brief Whether the map was built for these boundary flags */
+  bool Matches(int const flags[6]) const;
+
+  /*! \brief Start a new map for these boundary flags */
+  void Clear(int const flags[6]);
+
+  /*! \brief Add the ghost cells of the region of face dir that SetGhostCells
+   * would set */
+  void Add_Region(int nx, int ny, int nz, int n_ghost, int isize, int jsize, int ksize, int imin, int jmin, int kmin,
+                  int dir);
+
+  /*! \brief Copy the map to the device */
+  void Upload();
+
+  /*! \brief Set all the ghost cells of the map in a single launch */
+  void Apply(Real* c_head, int n_fields, int n_cells, cudaStream_t stream = 0) const;
+
+  /*! \brief Free the device copy of the map */
+  void Free();
+
+ private:
+  int _flags[6]         = {-1, -1, -1, -1, -1, -1};
+  int _n_cells          = 0;
+  GhostCell* _dev_cells = nullptr;
+  std::vector<GhostCell> _host_cells;
+};
+
 void Wind_Boundary_CUDA(Real* c_device, int nx, int ny, int nz, int n_cells, int n_ghost, int x_off, int y_off,
                         int z_off, Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound, Real gamma,
                         Real t);
@@ -0,0 +1,255 @@
+/*!
+ * \file cuda_boundaries_tests.cu
+ * \brief Tests for the contents of cuda_boundaries.h
+ *
+ */
+
+// STL Includes
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../grid/cuda_boundaries.h"
+#include "../grid/grid_enum.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/testing_utilities.h"
+
+namespace
+{
+// The ghost region of face dir, like Grid3D::Set_Boundary_Extents
+void Face_Extents(int dir, int nx, int ny, int nz, int n_ghost, int imin[3], int imax[3])
+{
+  int const n[3] = {nx, ny, nz};
+  int const axis = dir / 2;
+  for (int i = 0; i < 3; i++) {
+    // the faces of the lower axes are already set, the higher ones are not
+    bool const interior = i > axis && n[i] > 1;
+    imin[i]             = interior ? n_ghost : 0;
+    imax[i]             = interior ? n[i] - n_ghost : n[i];
+  }
+  imin[axis] = (dir % 2 == 0) ? 0 : n[axis] - n_ghost;
+  imax[axis] = (dir % 2 == 0) ? n_ghost : n[axis];
+}
+
+// The real cell index that ghost index g of an axis of n cells copies, and
+// the sign of the momentum of a reflection, or -1 for the custom faces
+int Host_Source_Index(int g, int n, int n_ghost, int const flags[2], Real &sign)
+{
+  bool const lower = g < n_ghost;
+  if (!lower && g < n - n_ghost) {
+    return g;
+  }
+  switch (flags[lower ? 0 : 1]) {
+    case 1:
+      return lower ? g + n - 2 * n_ghost : g - n + 2 * n_ghost;
+    case 2:
+      sign = -1;
+      return lower ? 2 * n_ghost - g - 1 : 2 * (n - n_ghost) - g - 1;
+    case 3:
+      return lower ? n_ghost : n - n_ghost - 1;
+    default:
+      return -1;
+  }
+}
+
+// Set the ghost cells on the host, each from the face of its last axis that
+// is a ghost axis
+void Host_Set_Ghost_Cells(std::vector<Real> &grid, int const flags[6], int nx, int ny, int nz, int n_ghost,
+                          int n_fields)
+{
+  int const n[3]    = {nx, ny, nz};
+  int const n_cells = nx * ny * nz;
+  for (int k = 0; k < nz; k++) {
+    for (int j = 0; j < ny; j++) {
+      for (int i = 0; i < nx; i++) {
+        int const g[3] = {i, j, k};
+        int source[3];
+        Real sign[3] = {1, 1, 1};
+        int dir      = -1;
+        bool skip    = false;
+        for (int axis = 0; axis < 3; axis++) {
+          source[axis] = Host_Source_Index(g[axis], n[axis], n_ghost, &flags[2 * axis], sign[axis]);
+          skip         = skip || source[axis] < 0;
+          if (g[axis] < n_ghost || g[axis] >= n[axis] - n_ghost) {
+            dir = 2 * axis + (g[axis] < n_ghost ? 0 : 1);
+          }
+        }
+        if (dir < 0 || skip) {
+          continue;
+        }
+
+        int const gidx = i + (j + k * ny) * nx;
+        int const idx  = source[0] + (source[1] + source[2] * ny) * nx;
+        for (int field = 0; field < n_fields; field++) {
+          grid[gidx + field * n_cells] = grid[idx + field * n_cells];
+        }
+        for (int axis = 0; axis < 3; axis++) {
+          grid[gidx + (axis + 1) * n_cells] *= sign[axis];
+        }
+#ifndef MHD
+        // the diode of a transmissive face only lets the gas out
+        Real &momentum = grid[gidx + (dir / 2 + 1) * n_cells];
+        if (flags[dir] == 3 && ((dir % 2 == 0) ? momentum > 0 : momentum < 0)) {
+          grid[gidx + 4 * n_cells] -= 0.5 * momentum * momentum / grid[gidx];
+          momentum = 0;
+        }
+#endif  // not MHD
+      }
+    }
+  }
+}
+
+void Check_Ghost_Cell_Map(int flags[6])
+{
+  int const nx = 9, ny = 8, nz = 7, n_ghost = 2, n_fields = 5;
+  int const n_cells = nx * ny * nz;
+
+  // Random states with positive densities
+  std::vector<Real> host_grid(n_fields * n_cells);
+  std::mt19937 prng(1);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  for (size_t i = 0; i < host_grid.size(); i++) {
+    host_grid[i] = distribution(prng);
+  }
+  for (int i = 0; i < n_cells; i++) {
+    host_grid[i] = std::abs(host_grid[i]) + 0.5;
+  }
+
+  // Set the ghost cells on the host, face by face with SetGhostCells and with
+  // a single map
+  std::vector<Real> fiducial = host_grid;
+  Host_Set_Ghost_Cells(fiducial, flags, nx, ny, nz, n_ghost, n_fields);
+  cuda_utilities::DeviceVector<Real> face_grid(host_grid.size()), test_grid(host_grid.size());
+  face_grid.cpyHostToDevice(host_grid);
+  test_grid.cpyHostToDevice(host_grid);
+
+  GhostCellMap map;
+  map.Clear(flags);
+  for (int dir = 0; dir < 6; dir++) {
+    int imin[3], imax[3];
+    Face_Extents(dir, nx, ny, nz, n_ghost, imin, imax);
+    if (flags[dir] != 4) {
+      SetGhostCells(face_grid.data(), nx, ny, nz, n_fields, n_cells, n_ghost, flags, imax[0] - imin[0],
+                    imax[1] - imin[1], imax[2] - imin[2], imin[0], imin[1], imin[2], dir);
+    }
+    map.Add_Region(nx, ny, nz, n_ghost, imax[0] - imin[0], imax[1] - imin[1], imax[2] - imin[2], imin[0], imin[1],
+                   imin[2], dir);
+  }
+  map.Upload();
+  EXPECT_TRUE(map.Matches(flags));
+  map.Apply(test_grid.data(), n_fields, n_cells);
+  map.Free();
+
+  Free_Boundary_Index_Lists();
+
+  std::vector<Real> face(host_grid.size()), test(host_grid.size());
+  face_grid.cpyDeviceToHost(face);
+  test_grid.cpyDeviceToHost(test);
+  for (size_t i = 0; i < fiducial.size(); i++) {
+    testing_utilities::Check_Results(fiducial[i], face[i], "face by face value " + std::to_string(i));
+    testing_utilities::Check_Results(fiducial[i], test[i], "single map value " + std::to_string(i));
+  }
+}
+
+}  // namespace
+
+TEST(tALLGhostCellMap, PeriodicBoundariesExpectCorrectGhostCells)
+{
+  int flags[6] = {1, 1, 1, 1, 1, 1};
+  Check_Ghost_Cell_Map(flags);
+}
+
+TEST(tALLGhostCellMap, MixedBoundariesExpectCorrectGhostCells)
+{
+  int flags[6] = {2, 3, 1, 1, 3, 2};
+  Check_Ghost_Cell_Map(flags);
+}
+
+TEST(tALLGhostCellMap, CustomBoundaryExpectCorrectGhostCells)
+{
+  int flags[6] = {4, 3, 2, 2, 1, 1};
+  Check_Ghost_Cell_Map(flags);
+}
+
+TEST(tALLPackBuffers3D, PackAndUnpackExpectSameCells)
+{
+  int const nx = 9, ny = 8, nz = 7, n_fields = 3;
+  int const n_cells = nx * ny * nz;
+  std::vector<Real> host_grid(n_fields * n_cells);
+  for (size_t i = 0; i < host_grid.size(); i++) {
+    host_grid[i] = i;
+  }
+  cuda_utilities::DeviceVector<Real> grid(host_grid.size()), copy(host_grid.size(), true);
+  grid.cpyHostToDevice(host_grid);
+
+  // A box of 2x3x4 cells starting at cell (1, 2, 3)
+  int const isize = 2, jsize = 3, ksize = 4, idxoffset = 1 + (2 + 3 * ny) * nx;
+  cuda_utilities::DeviceVector<Real> buffer(n_fields * isize * jsize * ksize);
+  PackBuffers3D(buffer.data(), grid.data(), nx, ny, n_fields, n_cells, idxoffset, isize, jsize, ksize);
+  UnpackBuffers3D(buffer.data(), copy.data(), nx, ny, n_fields, n_cells, idxoffset, isize, jsize, ksize);
+  GPU_Error_Check(cudaDeviceSynchronize());
+  Free_Boundary_Index_Lists();
+
+  std::vector<Real> host_buffer(buffer.size()), host_copy(host_grid.size());
+  buffer.cpyDeviceToHost(host_buffer);
+  copy.cpyDeviceToHost(host_copy);
+  int id = 0;
+  for (int k = 0; k < ksize; k++) {
+    for (int j = 0; j < jsize; j++) {
+      for (int i = 0; i < isize; i++, id++) {
+        int const idx = i + (j + k * ny) * nx + idxoffset;
+        for (int field = 0; field < n_fields; field++) {
+          EXPECT_EQ(host_buffer[id + field * isize * jsize * ksize], host_grid[idx + field * n_cells]);
+          EXPECT_EQ(host_copy[idx + field * n_cells], host_grid[idx + field * n_cells]);
+        }
+      }
+    }
+  }
+}
+
+TEST(tALLPackBuffers3D, ScalarPrecisionExpectFloatScalarsAndExactHydro)
+{
+  int const nx = 9, ny = 8, nz = 7, n_fields = grid_enum::num_fields;
+  int const n_cells = nx * ny * nz;
+  std::vector<Real> host_grid(n_fields * n_cells);
+  for (size_t i = 0; i < host_grid.size(); i++) {
+    host_grid[i] = i + 0.1;
+  }
+  cuda_utilities::DeviceVector<Real> grid(host_grid.size()), copy(host_grid.size(), true);
+  grid.cpyHostToDevice(host_grid);
+
+  int const n_float = Halo_Float_Fields(n_fields, FieldList(), HaloPrecision::scalars);
+  EXPECT_EQ(grid_enum::nscalars, n_float);
+
+  // A box of 2x3x4 cells starting at cell (1, 2, 3)
+  int const isize = 2, jsize = 3, ksize = 4, idxoffset = 1 + (2 + 3 * ny) * nx;
+  cuda_utilities::DeviceVector<Real> buffer(n_fields * isize * jsize * ksize, true);
+  PackBuffers3D(buffer.data(), grid.data(), nx, ny, n_fields, n_cells, idxoffset, isize, jsize, ksize, 0, FieldList(),
+                HaloPrecision::scalars);
+  UnpackBuffers3D(buffer.data(), copy.data(), nx, ny, n_fields, n_cells, idxoffset, isize, jsize, ksize, 0,
+                  FieldList(), HaloPrecision::scalars);
+  GPU_Error_Check(cudaDeviceSynchronize());
+  Free_Boundary_Index_Lists();
+
+  std::vector<Real> host_copy(host_grid.size());
+  copy.cpyDeviceToHost(host_copy);
+  for (int k = 0; k < ksize; k++) {
+    for (int j = 0; j < jsize; j++) {
+      for (int i = 0; i < isize; i++) {
+        int const idx = i + (j + k * ny) * nx + idxoffset;
+        for (int field = 0; field < n_fields; field++) {
+          Real const value     = host_grid[idx + field * n_cells];
+          bool const is_scalar = field >= grid_enum::scalar and field < grid_enum::finalscalar_plus_1;
+          Real const fiducial  = is_scalar ? Real(float(value)) : value;
+          EXPECT_EQ(fiducial, host_copy[idx + field * n_cells]) << "field " << field << " cell " << idx;
+        }
+      }
+    }
+  }
+}
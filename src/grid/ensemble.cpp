@@ -0,0 +1,170 @@
+/*! \file ensemble.cpp
+ *  \brief Definitions of the ensemble driver. */
+
+#include "../grid/ensemble.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include "../global/global.h"
+#include "../grid/grid3D.h"
+#include "../io/io.h"
+#include "../utils/error_handling.h"
+#ifdef MHD
+  #include "../mhd/magnetic_divergence.h"
+#endif  // MHD
+
+#if defined(GRAVITY) || defined(PARTICLES) || defined(COSMOLOGY) || defined(ANALYSIS) || defined(COOLING_GRACKLE) || \
+    defined(CHEMISTRY_GPU) || defined(VL_OVERLAP)
+  // These keep global state that is set up for a single grid
+  #define ENSEMBLE_UNSUPPORTED
+#endif
+
+namespace
+{
+// One simulation of the ensemble
+struct Member {
+  Parameters P;
+  Grid3D G;
+  int nfile    = 0;  // number of output files
+  Real outtime = 0;  // next output time
+  bool running = true;
+};
+
+// Initialize the grid and initial conditions of a member and write its first
+// output
+void Initialize_Member(Member &m)
+{
+  bool const is_restart = strcmp(m.P.init, "Read_Grid") == 0 or strcmp(m.P.init, "Read_Grid_Cat") == 0;
+
+  m.G.Initialize(&m.P);
+  m.G.Set_Initial_Conditions(m.P);
+  if (is_restart) {
+    m.outtime += m.G.H.t;
+    m.nfile = m.P.nfile;
+  }
+#ifdef CPU_TIME
+  m.G.Timer.Initialize(m.P);
+#endif  // CPU_TIME
+  m.G.Set_Boundary_Conditions_Grid(m.P);
+  m.G.Calc_Inverse_Timestep();
+
+#ifdef OUTPUT
+  if (!is_restart || m.G.H.Output_Now) {
+    Write_Data(m.G, m.P, m.nfile);
+  }
+  m.nfile++;
+#endif  // OUTPUT
+#ifdef MHD
+  mhd::checkMagneticDivergence(m.G);
+#endif  // MHD
+  m.outtime += m.P.outstep;
+}
+
+// Advance a member by one time step, like the loop of main
+void Step_Member(Member &m)
+{
+  // The integrators read gamma from its global
+  Set_Gammas(m.P.gamma);
+
+  m.G.set_dt();
+  const Real next_scheduled_time = fmin(m.outtime, m.P.tout);
+  if (m.G.H.t + m.G.H.dt > next_scheduled_time) {
+    m.G.H.dt = next_scheduled_time - m.G.H.t;
+  }
+
+  m.G.Update_Hydro_Grid(&m.P);
+#ifdef LAGGED_DT
+  if (m.G.Retake_Lagged_Step()) {
+    m.G.Update_Hydro_Grid(&m.P);
+  }
+#endif  // LAGGED_DT
+  m.G.Update_Time();
+  m.G.H.n_step++;
+  m.G.Set_Boundary_Conditions_Grid(m.P);
+
+  if (m.P.output_always) m.G.H.Output_Now = true;
+  if (m.G.H.t == m.outtime || m.G.H.Output_Now) {
+#ifdef OUTPUT
+    Write_Data(m.G, m.P, m.nfile);
+    m.nfile++;
+#endif  // OUTPUT
+    if (m.G.H.t == m.outtime) {
+      m.outtime += m.P.outstep;
+    }
+  }
+
+  m.running = m.G.H.t < m.P.tout;
+#ifdef N_STEPS_LIMIT
+  m.running = m.running and m.G.H.n_step < N_STEPS_LIMIT;
+#endif  // N_STEPS_LIMIT
+}
+}  // namespace
+
+void Run_Ensemble(int n_members, char **param_files)
+{
+#ifdef ENSEMBLE_UNSUPPORTED
+  CHOLLA_ERROR("The ensemble mode only supports hydro and MHD builds without VL_OVERLAP");
+#else   // not ENSEMBLE_UNSUPPORTED
+  CHOLLA_ASSERT(n_members > 0, "usage: cholla --ensemble <parameter_file> [<parameter_file> ...]");
+  double const start_total = Get_Time();
+
+  // Grid3D isn't movable, so the members stay where they are allocated
+  std::vector<std::unique_ptr<Member>> members;
+  for (int i = 0; i < n_members; i++) {
+    members.push_back(std::make_unique<Member>());
+    Member &m = *members.back();
+    Parse_Params(param_files[i], &m.P, 0, nullptr);
+    Check_Configuration(m.P);
+    Parameters const &first = members.front()->P;
+    CHOLLA_ASSERT(m.P.nx == first.nx and m.P.ny == first.ny and m.P.nz == first.nz,
+                  "Ensemble member %s has %d x %d x %d cells, but the members share the integrator buffers and must "
+                  "all have the %d x %d x %d cells of the first one",
+                  param_files[i], m.P.nx, m.P.ny, m.P.nz, first.nx, first.ny, first.nz);
+    chprintf("Ensemble member %d: %s, init = %s, tout = %f, output directory %s\n", i, param_files[i], m.P.init,
+             m.P.tout, m.P.outdir);
+  }
+  #ifdef HDF5
+  Init_Output_Compression(members.front()->P);
+  #endif  // HDF5
+  Create_Log_File(members.front()->P);
+
+  for (auto &member : members) {
+    Initialize_Member(*member);
+  }
+  chprintf("Initialized %d ensemble members of %d x %d x %d cells in %9.4f s\n", n_members, members.front()->P.nx,
+           members.front()->P.ny, members.front()->P.nz, Get_Time() - start_total);
+
+  // Each round advances every running member by one of its own time steps
+  int n_rounds = 0;
+  for (int n_running = n_members; n_running > 0;) {
+    double const start_round = Get_Time();
+    n_running                = 0;
+    for (auto &member : members) {
+      if (member->running) {
+        Step_Member(*member);
+        n_running += member->running;
+      }
+    }
+    n_rounds++;
+    chprintf("ensemble round: %d   members running: %d of %d   round time = %9.3f ms   total time = %9.4f s\n",
+             n_rounds, n_running, n_members, (Get_Time() - start_round) * 1000, Get_Time() - start_total);
+  }
+
+  for (int i = 0; i < n_members; i++) {
+    chprintf("Ensemble member %d: %d steps, sim time %10.7f\n", i, members[i]->G.H.n_step, members[i]->G.H.t);
+  }
+  Write_Message_To_Log_File("Ensemble completed successfully.");
+
+  #ifdef ASYNC_OUTPUT
+  // The last snapshot may still be written by the I/O thread
+  Wait_Async_Output();
+  #endif  // ASYNC_OUTPUT
+
+  // The members aren't Reset, the first would free the integrator buffers that
+  // all of them share. Their device memory is released with the process.
+#endif  // ENSEMBLE_UNSUPPORTED
+}
@@ -0,0 +1,20 @@
+/*! \file ensemble.h
+ *  \brief Declarations of the ensemble driver, which runs several independent
+ *  simulations in one process. Parameter sweeps of small grids then pay the
+ *  startup of the process and the device once, and the members take turns on
+ *  the same device instead of each leaving most of it idle. */
+
+#pragma once
+
+/*!
+ * \brief Run the simulations of the parameter files param_files until each
+ * reaches its tout, stepping the members in turn. Each member has its own
+ * time step and outputs, so the outdir of the files should differ. The
+ * members share the scratch buffers of the integrator and so need the same
+ * grid size. Only builds without gravity, particles, cosmology, analysis or
+ * the chemistry solvers are supported.
+ *
+ * \param[in] n_members The number of parameter files
+ * \param[in] param_files The parameter files of the members
+ */
+void Run_Ensemble(int n_members, char **param_files);
@@ -0,0 +1,135 @@
+/*!
+ * \file field_layout.h
+ * \brief Contains the index views for the flat field-major layout of the
+ * conserved variables and for a block-tiled (brick) layout, along with the
+ * kernels that convert between them. Since the views and kernels are templated
+ * the implementation is in the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/gpu.hpp"
+
+namespace field_layout
+{
+/*!
+ * \brief The layout used by C.device, all cells of field 0 followed by all
+ * cells of field 1 and so on, i.e. [field][k][j][i]
+ */
+struct Flat {
+  int nx, ny, nz;
+
+  /// The total number of elements of one field
+  __host__ __device__ size_t Cells() const { return static_cast<size_t>(nx) * ny * nz; }
+
+  /// The total number of elements for n_fields fields
+  __host__ __device__ size_t Size(int const n_fields) const { return n_fields * Cells(); }
+
+  /// The index of a field in the cell (xid, yid, zid)
+  __host__ __device__ size_t Index(int const field, int const xid, int const yid, int const zid) const
+  {
+    return field * Cells() + cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+  }
+};
+
+/*!
+ * \brief A block-tiled layout. The grid is split into cubic bricks of
+ * brick_size^3 cells, padded up to a whole number of bricks in each direction.
+ * Each brick stores all of its fields contiguously, field-major within the
+ * brick, i.e. [brick][field][brick k][brick j][brick i], so all the fields of
+ * a cell and its stencil neighbors are close together in memory.
+ *
+ * \tparam brick_size The edge length of a brick in cells. A power of two so
+ * the divisions compile to shifts
+ */
+template <int brick_size>
+struct Brick {
+  static_assert(brick_size > 0 and (brick_size & (brick_size - 1)) == 0, "brick_size must be a power of two");
+
+  /// The number of cells in one brick
+  static int constexpr brick_cells = brick_size * brick_size * brick_size;
+
+  int nx, ny, nz, n_fields;
+
+  /// The number of bricks in each direction
+  __host__ __device__ int Bricks_X() const { return (nx + brick_size - 1) / brick_size; }
+  __host__ __device__ int Bricks_Y() const { return (ny + brick_size - 1) / brick_size; }
+  __host__ __device__ int Bricks_Z() const { return (nz + brick_size - 1) / brick_size; }
+
+  /// The total number of elements including the padding of the last bricks
+  __host__ __device__ size_t Size() const
+  {
+    return static_cast<size_t>(Bricks_X()) * Bricks_Y() * Bricks_Z() * n_fields * brick_cells;
+  }
+
+  /// The index of a field in the cell (xid, yid, zid)
+  __host__ __device__ size_t Index(int const field, int const xid, int const yid, int const zid) const
+  {
+    size_t const brick = (xid / brick_size) + Bricks_X() * ((yid / brick_size) + Bricks_Y() * (zid / brick_size));
+    int const cell = (xid % brick_size) + brick_size * ((yid % brick_size) + brick_size * (zid % brick_size));
+    return (brick * n_fields + field) * brick_cells + cell;
+  }
+};
+
+/*!
+ * \brief Copy an array in the flat layout into another layout. One thread per
+ * cell.
+ *
+ * \tparam Layout The destination layout
+ * \param[in] flat_array The source array
+ * \param[out] layout_array The destination array
+ * \param[in] flat The view of the source array
+ * \param[in] layout The view of the destination array
+ * \param[in] n_fields The number of fields to copy
+ */
+template <typename Layout>
+__global__ void Flat_To_Layout(Real const *flat_array, Real *layout_array, Flat const flat, Layout const layout,
+                               int const n_fields)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, flat.nx, flat.ny, xid, yid, zid);
+  if (zid >= flat.nz) {
+    return;
+  }
+
+  for (int field = 0; field < n_fields; field++) {
+    layout_array[layout.Index(field, xid, yid, zid)] = flat_array[flat.Index(field, xid, yid, zid)];
+  }
+}
+
+/*!
+ * \brief Copy an array in another layout back into the flat layout. One thread
+ * per cell.
+ *
+ * \tparam Layout The source layout
+ * \param[in] layout_array The source array
+ * \param[out] flat_array The destination array
+ * \param[in] layout The view of the source array
+ * \param[in] flat The view of the destination array
+ * \param[in] n_fields The number of fields to copy
+ */
+template <typename Layout>
+__global__ void Layout_To_Flat(Real const *layout_array, Real *flat_array, Layout const layout, Flat const flat,
+                               int const n_fields)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, flat.nx, flat.ny, xid, yid, zid);
+  if (zid >= flat.nz) {
+    return;
+  }
+
+  for (int field = 0; field < n_fields; field++) {
+    flat_array[flat.Index(field, xid, yid, zid)] = layout_array[layout.Index(field, xid, yid, zid)];
+  }
+}
+}  // namespace field_layout
@@ -0,0 +1,160 @@
+/*!
+ * \file field_layout_tests.cu
+ * \brief Tests for the contents of field_layout.h
+ *
+ */
+
+// STL Includes
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../grid/field_layout.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/gpu_streams.h"
+#include "../utils/testing_utilities.h"
+
+namespace
+{
+/*!
+ * \brief Read a 5 cell stencil in each direction of every field of a cell and
+ * write the sum, the access pattern of PPMC_VL over all three directions
+ */
+template <typename Layout>
+__global__ void Stencil_Benchmark(Real const *in, Real *out, Layout const layout, int const nx, int const ny,
+                                  int const nz, int const n_fields)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+  if (xid < 2 or xid >= nx - 2 or yid < 2 or yid >= ny - 2 or zid < 2 or zid >= nz - 2) {
+    return;
+  }
+
+  for (int field = 0; field < n_fields; field++) {
+    Real sum = 0;
+    for (int offset = -2; offset <= 2; offset++) {
+      sum += in[layout.Index(field, xid + offset, yid, zid)] + in[layout.Index(field, xid, yid + offset, zid)] +
+             in[layout.Index(field, xid, yid, zid + offset)];
+    }
+    out[layout.Index(field, xid, yid, zid)] = sum;
+  }
+}
+
+/*!
+ * \brief Time the stencil benchmark in a layout and return the time per sweep
+ * in milliseconds
+ */
+template <typename Layout>
+float Time_Stencil_Benchmark(Layout const &layout, size_t const size, int const nx, int const ny, int const nz,
+                             int const n_fields, int const n_sweeps)
+{
+  cuda_utilities::DeviceVector<Real> in(size, true), out(size, true);
+  int const n_blocks = (nx * ny * nz + TPB - 1) / TPB;
+  auto *const kernel = Stencil_Benchmark<Layout>;
+
+  // Warm up
+  hipLaunchKernelGGL(kernel, n_blocks, TPB, 0, 0, in.data(), out.data(), layout, nx, ny, nz, n_fields);
+  GPU_Error_Check();
+
+  cuda_utilities::Event start(true), stop(true);
+  start.Record(0);
+  for (int i = 0; i < n_sweeps; i++) {
+    hipLaunchKernelGGL(kernel, n_blocks, TPB, 0, 0, in.data(), out.data(), layout, nx, ny, nz, n_fields);
+  }
+  stop.Record(0);
+  stop.Synchronize();
+  GPU_Error_Check();
+
+  return stop.ElapsedTime(start) / n_sweeps;
+}
+}  // namespace
+
+TEST(tALLFieldLayoutBrick, IndicesExpectUniqueAndInBounds)
+{
+  // Deliberately not a multiple of the brick size so the padding is exercised
+  int const nx = 11, ny = 9, nz = 6, n_fields = 3;
+  field_layout::Brick<4> const brick{nx, ny, nz, n_fields};
+
+  std::vector<int> hits(brick.Size(), 0);
+  for (int field = 0; field < n_fields; field++) {
+    for (int zid = 0; zid < nz; zid++) {
+      for (int yid = 0; yid < ny; yid++) {
+        for (int xid = 0; xid < nx; xid++) {
+          size_t const index = brick.Index(field, xid, yid, zid);
+          ASSERT_LT(index, brick.Size());
+          hits.at(index)++;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < hits.size(); i++) {
+    EXPECT_LE(hits[i], 1) << "index " << i << " is used by more than one element";
+  }
+}
+
+TEST(tALLFieldLayoutBrick, RoundTripExpectIdenticalData)
+{
+  // Set up PRNG to use
+  std::mt19937_64 prng(42);
+  std::uniform_real_distribution<double> doubleRand(-5, 5);
+
+  int const nx = 13, ny = 10, nz = 9, n_fields = 5;
+  field_layout::Flat const flat{nx, ny, nz};
+  field_layout::Brick<8> const brick{nx, ny, nz, n_fields};
+
+  std::vector<Real> host_grid(flat.Size(n_fields));
+  for (Real &val : host_grid) {
+    val = doubleRand(prng);
+  }
+
+  cuda_utilities::DeviceVector<Real> dev_flat(host_grid.size()), dev_brick(brick.Size(), true);
+  cuda_utilities::DeviceVector<Real> dev_result(host_grid.size(), true);
+  dev_flat.cpyHostToDevice(host_grid);
+
+  int const n_blocks = (flat.Cells() + TPB - 1) / TPB;
+  auto *const to_brick   = field_layout::Flat_To_Layout<field_layout::Brick<8>>;
+  auto *const from_brick = field_layout::Layout_To_Flat<field_layout::Brick<8>>;
+  hipLaunchKernelGGL(to_brick, n_blocks, TPB, 0, 0, dev_flat.data(), dev_brick.data(), flat, brick, n_fields);
+  hipLaunchKernelGGL(from_brick, n_blocks, TPB, 0, 0, dev_brick.data(), dev_result.data(), brick, flat, n_fields);
+  GPU_Error_Check();
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  std::vector<Real> host_result(host_grid.size());
+  dev_result.cpyDeviceToHost(host_result);
+  for (size_t i = 0; i < host_grid.size(); i++) {
+    testing_utilities::Check_Results(host_grid[i], host_result[i], "element " + std::to_string(i));
+  }
+
+  // Spot check that the data really was rearranged
+  EXPECT_EQ(host_grid[flat.Index(2, 9, 3, 8)], dev_brick.at(brick.Index(2, 9, 3, 8)));
+}
+
+/*!
+ * \brief Compare the time of a PPMC-like stencil sweep in the flat and the
+ * brick layouts. Disabled by default, run it with
+ * `--gtest_also_run_disabled_tests --gtest_filter=*FieldLayoutBenchmark*`. The
+ * L2 hit rate of the two kernels can be collected by running the same command
+ * under `ncu --metrics lts__t_sector_hit_rate.pct` or
+ * `rocprof --pmc TCC_HIT_sum TCC_MISS_sum`.
+ */
+TEST(tALLFieldLayoutBenchmark, DISABLED_StencilSweepFlatVsBrick)
+{
+  int const nx = 256, ny = 256, nz = 128, n_fields = 5, n_sweeps = 20;
+  field_layout::Flat const flat{nx, ny, nz};
+  field_layout::Brick<8> const brick{nx, ny, nz, n_fields};
+
+  float const flat_time  = Time_Stencil_Benchmark(flat, flat.Size(n_fields), nx, ny, nz, n_fields, n_sweeps);
+  float const brick_time = Time_Stencil_Benchmark(brick, brick.Size(), nx, ny, nz, n_fields, n_sweeps);
+
+  std::cout << "Stencil sweep of " << nx << "x" << ny << "x" << nz << " cells with " << n_fields
+            << " fields: flat " << flat_time << " ms, 8^3 bricks " << brick_time << " ms, speedup "
+            << flat_time / brick_time << std::endl;
+}
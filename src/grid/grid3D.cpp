@@ -9,7 +9,8 @@
 #include "../global/global.h"
 #include "../grid/grid3D.h"
 #include "../grid/grid_enum.h"    // provides grid_enum
-#include "../hydro/hydro_cuda.h"  // provides Calc_dt_GPU
+#include "../hydro/hydro_cuda.h"  // provides Reduce_dti_GPU
+#include "../hydro/source_terms_cuda.h"
 #include "../integrators/VL_1D_cuda.h"
 #include "../integrators/VL_2D_cuda.h"
 #include "../integrators/VL_3D_cuda.h"
@@ -17,7 +18,27 @@
 #include "../integrators/simple_2D_cuda.h"
 #include "../integrators/simple_3D_cuda.h"
 #include "../io/io.h"
+#ifdef MHD
+  #include "../mhd/magnetic_divergence.h"
+#endif  // MHD
+#include "../utils/device_memory_pool.h"
 #include "../utils/error_handling.h"
+#include "../utils/timestep_constraints.h"
+#ifdef STATIC_REFINEMENT
+  #include "../grid/static_refinement.h"
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+  #include "../grid/local_timesteps.h"
+#endif  // LOCAL_TIMESTEPS
+#ifdef POWER_SPECTRUM
+  #include "../analysis/power_spectrum_3d.h"
+#endif  // POWER_SPECTRUM
+#ifdef HALO_FINDER
+  #include "../analysis/halo_finder.h"
+#endif  // HALO_FINDER
+#ifdef GPU_GRAPHS
+  #include "../utils/gpu_graph.h"
+#endif  // GPU_GRAPHS
 #ifdef MPI_CHOLLA
   #include <mpi.h>
   #ifdef HDF5
@@ -74,6 +95,19 @@ Grid3D::Grid3D(void)
   // Set the number of ghost cells high enough for MHD. MHD needs one extra for the left most face
   H.n_ghost++;
 #endif  // MHD
+
+#ifdef STATIC_REFINEMENT
+  refined_patch = nullptr;
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+  local_timesteps = nullptr;
+#endif  // LOCAL_TIMESTEPS
+#ifdef POWER_SPECTRUM
+  power_spectrum = nullptr;
+#endif  // POWER_SPECTRUM
+#ifdef HALO_FINDER
+  halo_finder = nullptr;
+#endif  // HALO_FINDER
 }
 
 /*! \fn void Get_Position(long i, long j, long k, Real *xpos, Real *ypos, Real
@@ -112,11 +146,35 @@ void Grid3D::Get_Position(long i, long j, long k, Real *x_pos, Real *y_pos, Real
 #endif /*MPI_CHOLLA*/
 }
 
-Real Grid3D::Calc_Inverse_Timestep()
+void Grid3D::Calc_Inverse_Timestep()
 {
-  // ==Calculate the next inverse time step using Calc_dt_GPU from
-  // hydro/hydro_cuda.h==
-  return Calc_dt_GPU(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_cells, H.dx, H.dy, H.dz, gama);
+  // ==Calculate the next inverse time step using Reduce_dti_GPU from
+  // hydro/hydro_cuda.h==. It stays on the device until set_dt
+#ifdef MHD
+  // The maximum magnetic divergence is reduced in the same kernel, from the
+  // faces it reads for the cell centered field. With MHD_CENTERED_B_CACHE the
+  // cell centered field is also cached for the outputs until the next update
+  Reduce_dti_GPU(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_cells, H.dx, H.dy, H.dz, gama,
+                 timestep_constraints::Device_Slot(H.dti_constraint),
+                 timestep_constraints::Device_Slot(timestep_constraints::magnetic_divergence), C.d_magnetic_centered);
+#elif defined(AVERAGE_SLOW_CELLS)
+  // The cells slower than min_dt_slow are averaged now, while they are found
+  // by the reduction, and their averaged state is reduced too
+  Reduce_dti_Average_Slow_Cells(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dx, H.dy, H.dz, gama,
+                                1 / H.min_dt_slow, timestep_constraints::Device_Slot(H.dti_constraint));
+#else   // not MHD
+  Reduce_dti_GPU(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_cells, H.dx, H.dy, H.dz, gama,
+                 timestep_constraints::Device_Slot(H.dti_constraint));
+#endif  // MHD
+
+#ifndef PARTICLES_GPU
+  // Nothing else reduces into the slots before set_dt, so the inverse
+  // timestep comes back to the host while the boundaries are exchanged and
+  // set_dt only waits for the copy. A refined patch is read back with its grid
+  if (H.dti_constraint == timestep_constraints::hydro) {
+    timestep_constraints::Start_Readback();
+  }
+#endif  // not PARTICLES_GPU
 }
 
 /*! \fn void Initialize(int nx_in, int ny_in, int nz_in)
@@ -215,9 +273,34 @@ void Grid3D::Initialize(struct Parameters *P)
   // Set Transfer flag to false, only set to true before Conserved boundaries
   // are transferred
   H.TRANSFER_HYDRO_BOUNDARIES = false;
+  // By default the transfers fill all fields and all ghost cells
+  H.transfer_hydro_fields.n_fields = 0;
+  H.transfer_hydro_n_ghost         = H.n_ghost;
+#ifdef MPI_CHOLLA
+  if (P->mpi_float_halos) {
+    H.transfer_hydro_precision = HaloPrecision::single;
+  } else if (P->mpi_float_scalar_halos) {
+    H.transfer_hydro_precision = HaloPrecision::scalars;
+  } else {
+    H.transfer_hydro_precision = HaloPrecision::full;
+  }
+#else
+  H.transfer_hydro_precision = HaloPrecision::full;
+#endif  // MPI_CHOLLA
+#ifdef VL_OVERLAP
+  // Set to true once the initial boundaries have been set
+  H.OVERLAP_HYDRO_BOUNDARIES = false;
+#endif  // VL_OVERLAP
+#ifdef LAGGED_DT
+  H.lagged_dt_safety   = P->lagged_dt_safety;
+  H.lagged_max_dti     = 0;
+  H.lagged_dti_pending = false;
+#endif  // LAGGED_DT
+  H.dti_constraint = timestep_constraints::hydro;
 
   // Set output to true when data has to be written to file;
   H.Output_Now = false;
+  Derived.Set_Outputs(P->output_derived);
 
   // allocate memory
   AllocateMemory();
@@ -255,6 +338,8 @@ void Grid3D::Initialize(struct Parameters *P)
   // are we outputting multiple rotations(1)? or rotating during a
   // simulation(2)?
   R.flag_delta = P->flag_delta;
+  // are we compositing the pieces of the projection into one image?
+  R.composite = P->composite_rot_proj;
 #endif /*ROTATED_PROJECTION*/
 
 // Values for lower limit for density and temperature
@@ -270,6 +355,10 @@ void Grid3D::Initialize(struct Parameters *P)
   H.scalar_floor = P->scalar_floor;
 #endif
 
+#ifdef VL
+  H.n_vl_slabs = P->n_vl_slabs;
+#endif  // VL
+
 #ifdef COSMOLOGY
   H.OUTPUT_SCALE_FACOR = not(P->scale_outputs_file[0] == '\0');
 #endif
@@ -316,7 +405,8 @@ void Grid3D::AllocateMemory(void)
 #endif  // DE
 
   // allocate memory for the conserved variable arrays on the device
-  GPU_Error_Check(cudaMalloc((void **)&C.device, H.n_fields * H.n_cells * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::hydro);
+  cuda_utilities::Pool_Malloc(&C.device, H.n_fields * H.n_cells * sizeof(Real));
   cuda_utilities::initGpuMemory(C.device, H.n_fields * H.n_cells * sizeof(Real));
   C.d_density    = C.device;
   C.d_momentum_x = &(C.device[H.n_cells]);
@@ -343,12 +433,34 @@ void Grid3D::AllocateMemory(void)
 
 #if defined(GRAVITY)
   GPU_Error_Check(cudaHostAlloc(&C.Grav_potential, H.n_cells * sizeof(Real), cudaHostAllocDefault));
-  GPU_Error_Check(cudaMalloc((void **)&C.d_Grav_potential, H.n_cells * sizeof(Real)));
+  // Managed with MANAGED_MEMORY, the integrator prefetches it every step
+  #ifdef GRAV_POTENTIAL_UPLOAD
+  cuda_utilities::Pool_Malloc_Managed(&d_grav_potential_buffers[0], H.n_cells * sizeof(Real));
+  cuda_utilities::Pool_Malloc_Managed(&d_grav_potential_buffers[1], H.n_cells * sizeof(Real));
+  C.d_Grav_potential = d_grav_potential_buffers[grav_potential_buffer];
+  #else   // not GRAV_POTENTIAL_UPLOAD
+  cuda_utilities::Pool_Malloc_Managed(&C.d_Grav_potential, H.n_cells * sizeof(Real));
+  #endif  // GRAV_POTENTIAL_UPLOAD
 #else
   C.Grav_potential   = NULL;
   C.d_Grav_potential = NULL;
 #endif
 
+#ifdef MHD_CENTERED_B_CACHE
+  #ifndef MHD
+    #error "MHD_CENTERED_B_CACHE requires MHD"
+  #endif  // MHD
+  cuda_utilities::Pool_Malloc(&C.d_magnetic_centered, 3 * H.n_cells * sizeof(Real));
+#else
+  C.d_magnetic_centered = NULL;
+#endif  // MHD_CENTERED_B_CACHE
+
+#ifdef LAGGED_DT
+  cuda_utilities::Pool_Malloc(&C.d_lagged_backup, H.n_fields * H.n_cells * sizeof(Real));
+#else
+  C.d_lagged_backup = NULL;
+#endif  // LAGGED_DT
+
 #ifdef CHEMISTRY_GPU
   C.HI_density    = &C.host[H.n_cells * grid_enum::HI_density];
   C.HII_density   = &C.host[H.n_cells * grid_enum::HII_density];
@@ -356,6 +468,9 @@ void Grid3D::AllocateMemory(void)
   C.HeII_density  = &C.host[H.n_cells * grid_enum::HeII_density];
   C.HeIII_density = &C.host[H.n_cells * grid_enum::HeIII_density];
   C.e_density     = &C.host[H.n_cells * grid_enum::e_density];
+  #ifdef GRACKLE_METALS
+  C.metal_density = &C.host[H.n_cells * grid_enum::metal_density];
+  #endif
 #endif
 
   // initialize host array
@@ -368,9 +483,9 @@ void Grid3D::AllocateMemory(void)
 #endif  // CLOUDY_COOL
 }
 
-/*! \fn void set_dt(Real dti)
+/*! \fn void set_dt()
  *  \brief Set the timestep. */
-void Grid3D::set_dt(Real dti)
+void Grid3D::set_dt()
 {
   Real max_dti;
 
@@ -378,6 +493,52 @@ void Grid3D::set_dt(Real dti)
   Timer.Calc_dt.Start();
 #endif
 
+#ifdef PARTICLES_GPU
+  // The particles reduce their maximum inverse timestep into their slot of the
+  // registry, next to the hydro one
+  Calc_Particles_dti_GPU();
+#endif  // PARTICLES_GPU
+
+#ifdef LAGGED_DT
+  #if defined(GRAVITY) || defined(PARTICLES) || defined(ONLY_PARTICLES)
+    #error "LAGGED_DT can only take the hydro step again, it doesn't support gravity or particles"
+  #endif  // GRAVITY || PARTICLES || ONLY_PARTICLES
+  if (H.lagged_max_dti > 0) {
+    // Take the step with the inverse timestep of the state the last step
+    // started from. The one of this state is reduced over the ranks while it
+    // is updated and checked by Retake_Lagged_Step
+    timestep_constraints::Start_Reduce();
+    H.lagged_dti_pending = true;
+    H.dt                 = H.lagged_dt_safety * C_cfl / H.lagged_max_dti;
+    GPU_Error_Check(cudaMemcpyAsync(C.d_lagged_backup, C.device, H.n_fields * H.n_cells * sizeof(Real),
+                                    cudaMemcpyDeviceToDevice, 0));
+  #ifdef CPU_TIME
+    Timer.Calc_dt.End();
+  #endif  // CPU_TIME
+    return;
+  }
+#endif  // LAGGED_DT
+
+  // The inverse timestep of the hydro is calculated before the first loop and
+  // at the end of Update_Grid. All the constraints come back from the device
+  // with one copy, and this is the MPI_Allreduce for every iteration of the
+  // loop, not just the first one
+  Real max_dtis[timestep_constraints::n_constraints];
+#ifdef LOCAL_TIMESTEPS
+  // The level of the rank comes from its own inverse timestep
+  Real local_max_dtis[timestep_constraints::n_constraints];
+  timestep_constraints::Reduce(max_dtis, local_max_dtis);
+#else   // not LOCAL_TIMESTEPS
+  timestep_constraints::Reduce(max_dtis);
+#endif  // LOCAL_TIMESTEPS
+#ifdef PARTICLES_GPU
+  Particles.max_dti = max_dtis[timestep_constraints::particles];
+#endif  // PARTICLES_GPU
+#ifdef MHD
+  // Check that the magnetic field of the last update has zero divergence
+  mhd::checkMagneticDivergenceLimit(max_dtis[timestep_constraints::magnetic_divergence]);
+#endif  // MHD
+
 #ifdef ONLY_PARTICLES
   // If only solving particles the time for hydro is set to a  large value,
   // that way the minimum dt is the one corresponding to particles
@@ -385,16 +546,19 @@ void Grid3D::set_dt(Real dti)
 
 #else  // NOT ONLY_PARTICLES
 
-  // dti is calculated before first loop and at the end of Update_Grid
-  max_dti = dti;
-
-  #ifdef MPI_CHOLLA
-  // Note that this is the MPI_Allreduce for every iteration of the loop, not
-  // just the first one
-  max_dti = ReduceRealMax(max_dti);
-  #endif /*MPI_CHOLLA*/
-
+  max_dti = max_dtis[timestep_constraints::hydro];
+  #ifdef STATIC_REFINEMENT
+  // The refined patch takes ratio steps per step of the grid
+  max_dti = fmax(max_dti, max_dtis[timestep_constraints::refinement] / static_refinement::ratio);
+  #endif  // STATIC_REFINEMENT
   H.dt = C_cfl / max_dti;
+  #ifdef LOCAL_TIMESTEPS
+  // The ranks with faster cells take substeps of the longer step
+  H.dt = local_timesteps->Step(max_dtis, local_max_dtis);
+  #endif  // LOCAL_TIMESTEPS
+  #ifdef LAGGED_DT
+  H.lagged_max_dti = max_dti;
+  #endif  // LAGGED_DT
 
 #endif  // ONLY_PARTICLES
 
@@ -408,9 +572,38 @@ void Grid3D::set_dt(Real dti)
 #endif
 }
 
-/*! \fn void Execute_Hydro_Integratore_Grid(void)
+#ifdef LAGGED_DT
+bool Grid3D::Retake_Lagged_Step()
+{
+  if (not H.lagged_dti_pending) {
+    return false;
+  }
+  H.lagged_dti_pending = false;
+
+  Real max_dtis[timestep_constraints::n_constraints];
+  timestep_constraints::Finish_Reduce(max_dtis);
+  #ifdef MHD
+  // Check that the magnetic field the step started from has zero divergence
+  mhd::checkMagneticDivergenceLimit(max_dtis[timestep_constraints::magnetic_divergence]);
+  #endif  // MHD
+  H.lagged_max_dti = max_dtis[timestep_constraints::hydro];
+
+  // Every rank has the same reduced values, so they all agree on the retake
+  Real const dt = C_cfl / H.lagged_max_dti;
+  if (H.dt <= dt) {
+    return false;
+  }
+  chprintf("Lagged timestep %e is too long for the CFL condition, taking the step again with dt = %e\n", H.dt, dt);
+  GPU_Error_Check(cudaMemcpyAsync(C.device, C.d_lagged_backup, H.n_fields * H.n_cells * sizeof(Real),
+                                  cudaMemcpyDeviceToDevice, 0));
+  H.dt = dt;
+  return true;
+}
+#endif  // LAGGED_DT
+
+/*! \fn void Execute_Hydro_Integratore_Grid(struct Parameters *P)
  *  \brief Updates cells by executing the hydro integrator. */
-void Grid3D::Execute_Hydro_Integrator(void)
+void Grid3D::Execute_Hydro_Integrator(struct Parameters *P)
 {
   Real max_dti = 0;
   int x_off, y_off, z_off;
@@ -424,6 +617,47 @@ void Grid3D::Execute_Hydro_Integrator(void)
   z_off = nz_local_start;
 #endif
 
+#ifdef STATIC_GRAV_CACHE
+  // The static gravity only depends on the position, so it is evaluated once
+  // for the grid instead of in every update. This happens outside of the
+  // captured graph since the table is usually built on the first step only
+  Update_Static_Gravity_Table(H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.custom_grav, H.dx, H.dy, H.dz,
+                              H.xbound, H.ybound, H.zbound);
+#endif  // STATIC_GRAV_CACHE
+
+  // The 3D VL integrator applies the floors in its last kernel. The disabled
+  // ones are zero so they don't make the captured graph stale
+#ifdef TEMPERATURE_FLOOR
+  Real const U_floor = Internal_Energy_Floor();
+#else   // not TEMPERATURE_FLOOR
+  Real const U_floor = 0;
+#endif  // TEMPERATURE_FLOOR
+#ifdef SCALAR_FLOOR
+  Real const scalar_floor = H.scalar_floor;
+#else   // not SCALAR_FLOOR
+  Real const scalar_floor = 0;
+#endif  // SCALAR_FLOOR
+
+#ifdef VL_OVERLAP
+  #ifndef VL
+    #error "VL_OVERLAP requires the VL integrator"
+  #endif  // VL
+  // The 3D integrator exchanges the boundaries itself while it updates the
+  // interior, every other case transfers them before integrating
+  bool const overlap_boundaries = H.OVERLAP_HYDRO_BOUNDARIES && H.nz > 1 && H.n_vl_slabs == 1;
+  if (H.OVERLAP_HYDRO_BOUNDARIES && !overlap_boundaries) {
+  #ifdef CPU_TIME
+    Timer.Boundaries.Start();
+  #endif  // CPU_TIME
+    H.TRANSFER_HYDRO_BOUNDARIES = true;
+    Set_Boundary_Conditions(*P);
+    H.TRANSFER_HYDRO_BOUNDARIES = false;
+  #ifdef CPU_TIME
+    Timer.Boundaries.End();
+  #endif  // CPU_TIME
+  }
+#endif  // VL_OVERLAP
+
 #ifdef CPU_TIME
   Timer.Hydro_Integrator.Start();
 #endif  // CPU_TIME
@@ -450,9 +684,52 @@ void Grid3D::Execute_Hydro_Integrator(void)
   } else if (H.nx > 1 && H.ny > 1 && H.nz > 1)  // 3D
   {
 #ifdef VL
-    VL_Algorithm_3D_CUDA(C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx, H.dy,
-                         H.dz, H.xbound, H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav, H.density_floor,
-                         C.Grav_potential);
+    if (H.n_vl_slabs > 1) {
+      VL_Algorithm_3D_Slabs_CUDA(C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx,
+                                 H.dy, H.dz, H.xbound, H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav,
+                                 H.density_floor, U_floor, scalar_floor, C.Grav_potential, H.n_vl_slabs);
+    }
+  #ifdef VL_OVERLAP
+    else if (overlap_boundaries) {
+      // Only the part of the exchange that isn't hidden behind the interior
+      // update is recorded, the timer itself would synchronize the device
+      Real const exposed_time = VL_Algorithm_3D_Overlap_CUDA(
+          C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx, H.dy, H.dz, H.xbound,
+          H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav, H.density_floor, U_floor, scalar_floor,
+          [&]() {
+            H.TRANSFER_HYDRO_BOUNDARIES = true;
+            Set_Boundary_Conditions(*P);
+            H.TRANSFER_HYDRO_BOUNDARIES = false;
+          },
+          streams.hydro, streams.boundaries);
+    #ifdef CPU_TIME
+      Timer.Boundaries.RecordTime(exposed_time);
+    #endif  // CPU_TIME
+    }
+  #endif  // VL_OVERLAP
+    else {
+  #ifdef GPU_GRAPHS
+      // Replay the captured integrator launches, recapturing whenever any of
+      // the arguments change
+      static cuda_utilities::GpuGraph hydro_graph;
+      hydro_graph.Launch(
+          [&](cudaStream_t stream) {
+            VL_Algorithm_3D_CUDA(C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx,
+                                 H.dy, H.dz, H.xbound, H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav,
+                                 H.density_floor, U_floor, scalar_floor, C.Grav_potential, stream);
+          },
+          C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx, H.dy, H.dz, H.xbound,
+          H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav, H.density_floor, U_floor, scalar_floor);
+  #else   // not GPU_GRAPHS
+      VL_Algorithm_3D_CUDA(C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx,
+                           H.dy, H.dz, H.xbound, H.ybound, H.zbound, H.dt, H.n_fields, H.custom_grav, H.density_floor,
+                           U_floor, scalar_floor, C.Grav_potential, streams.hydro);
+  #endif  // GPU_GRAPHS
+    }
+  #ifdef GRAV_POTENTIAL_UPLOAD
+    // The buffer can take the upload of the step after next once this is done
+    grav_potential_read[grav_potential_buffer].Record(streams.hydro);
+  #endif  // GRAV_POTENTIAL_UPLOAD
 #endif  // VL
 #ifdef SIMPLE
     Simple_Algorithm_3D_CUDA(C.device, C.d_Grav_potential, H.nx, H.ny, H.nz, x_off, y_off, z_off, H.n_ghost, H.dx, H.dy,
@@ -469,13 +746,38 @@ void Grid3D::Execute_Hydro_Integrator(void)
 #endif  // CPU_TIME
 }
 
-/*! \fn void Update_Hydro_Grid(void)
+/*! \fn Real Internal_Energy_Floor()
+ *  \brief The specific internal energy of the temperature floor. */
+Real Grid3D::Internal_Energy_Floor()
+{
+  // Minimum of internal energy from minumum of temperature
+  Real U_floor = H.temperature_floor * KB / (gama - 1) / MP / SP_ENERGY_UNIT;
+#ifdef COSMOLOGY
+  U_floor = H.temperature_floor / (gama - 1) / MP * KB * 1e-10;  // ( km/s )^2
+  U_floor /= Cosmo.v_0_gas * Cosmo.v_0_gas / Cosmo.current_a / Cosmo.current_a;
+#endif
+  return U_floor;
+}
+
+#ifdef RUNTIME_KERNELS
+/*! \fn void Select_Hydro_Kernels(struct Parameters const &P)
+ *  \brief Choose the reconstruction and Riemann solver of the VL integrator
+ *  from the parameters, timing the candidates on the current state. */
+void Grid3D::Select_Hydro_Kernels(struct Parameters const &P)
+{
+  CHOLLA_ASSERT(H.nx > 1 && H.ny > 1 && H.nz > 1, "RUNTIME_KERNELS only selects the kernels of the 3D integrator");
+  VL_Select_Kernels(P.reconstruction, P.riemann_solver, C.device, H.nx, H.ny, H.nz, H.n_ghost, H.dx, H.dy, H.dz, H.dt,
+                    H.n_fields);
+}
+#endif  // RUNTIME_KERNELS
+
+/*! \fn void Update_Hydro_Grid(struct Parameters *P)
  *  \brief Do all steps to update the hydro. */
-Real Grid3D::Update_Hydro_Grid()
+void Grid3D::Update_Hydro_Grid(struct Parameters *P)
 {
 #ifdef ONLY_PARTICLES
   // Don't integrate the Hydro when only solving for particles
-  return 1e-10;
+  return;
 #endif  // ONLY_PARTICLES
 
 #ifdef CPU_TIME
@@ -488,43 +790,78 @@ Real Grid3D::Update_Hydro_Grid()
   Extrapolate_Grav_Potential();
 #endif  // GRAVITY
 
-  Execute_Hydro_Integrator();
+#ifdef STATIC_REFINEMENT
+  // The ghost cells of the refined patch are interpolated between the state of
+  // the grid at the start and at the end of the step
+  if (refined_patch != nullptr) {
+    refined_patch->Save_Grid_State();
+  }
+#endif  // STATIC_REFINEMENT
 
-#ifdef TEMPERATURE_FLOOR
-  // Set the lower limit temperature (Internal Energy)
-  Real U_floor;
-  // Minimum of internal energy from minumum of temperature
-  U_floor = H.temperature_floor * KB / (gama - 1) / MP / SP_ENERGY_UNIT;
-  #ifdef COSMOLOGY
-  U_floor = H.temperature_floor / (gama - 1) / MP * KB * 1e-10;  // ( km/s )^2
-  U_floor /= Cosmo.v_0_gas * Cosmo.v_0_gas / Cosmo.current_a / Cosmo.current_a;
-  #endif
-  Apply_Temperature_Floor(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, U_floor);
-#endif  // TEMPERATURE_FLOOR
+  Execute_Hydro_Integrator(P);
 
-#ifdef SCALAR_FLOOR
+  // The 3D VL integrator has already applied the floors
+#ifdef VL
+  bool const floors_applied = H.nx > 1 && H.ny > 1 && H.nz > 1;
+#else   // not VL
+  bool const floors_applied = false;
+#endif  // VL
+
+#ifdef SOURCE_TERM_KERNEL
+  // The floors, the cooling and the dust are applied in a single pass over the
+  // grid, which the Cooling_GPU timer times
+  #if defined(CPU_TIME) && defined(COOLING_GPU)
+  Timer.Cooling_GPU.Start();
+  #endif
+  #ifdef TEMPERATURE_FLOOR
+  Real const U_floor = Internal_Energy_Floor();
+  #else   // not TEMPERATURE_FLOOR
+  Real const U_floor = 0;
+  #endif  // TEMPERATURE_FLOOR
   #ifdef DUST
-  Apply_Scalar_Floor(C.device, H.nx, H.ny, H.nz, H.n_ghost, grid_enum::dust_density, H.scalar_floor);
+  Real const grain_radius = H.grain_radius;
+  #else   // not DUST
+  Real const grain_radius = 0;
+  #endif  // DUST
+  Source_Terms_Update(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dt, gama, !floors_applied, U_floor,
+                      H.scalar_floor, grain_radius);
+  #if defined(CPU_TIME) && defined(COOLING_GPU)
+  Timer.Cooling_GPU.End();
   #endif
-#endif  // SCALAR_FLOOR
+#else  // not SOURCE_TERM_KERNEL
+  #ifdef TEMPERATURE_FLOOR
+  // Set the lower limit temperature (Internal Energy)
+  if (!floors_applied) {
+    Apply_Temperature_Floor(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, Internal_Energy_Floor());
+  }
+  #endif  // TEMPERATURE_FLOOR
+
+  #ifdef SCALAR_FLOOR
+    #ifdef DUST
+  if (!floors_applied) {
+    Apply_Scalar_Floor(C.device, H.nx, H.ny, H.nz, H.n_ghost, grid_enum::dust_density, H.scalar_floor);
+  }
+    #endif
+  #endif  // SCALAR_FLOOR
 
 // == Perform chemistry/cooling (there are a few different cases) ==
-#ifdef COOLING_GPU
-  #ifdef CPU_TIME
+  #ifdef COOLING_GPU
+    #ifdef CPU_TIME
   Timer.Cooling_GPU.Start();
-  #endif
+    #endif
   // ==Apply Cooling from cooling/cooling_cuda.h==
   Cooling_Update(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dt, gama);
-  #ifdef CPU_TIME
+    #ifdef CPU_TIME
   Timer.Cooling_GPU.End();
-  #endif
+    #endif
 
-#endif  // COOLING_GPU
+  #endif  // COOLING_GPU
 
-#ifdef DUST
+  #ifdef DUST
   // ==Apply dust from dust/dust_cuda.h==
   Dust_Update(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dt, gama, H.grain_radius);
-#endif  // DUST
+  #endif  // DUST
+#endif  // SOURCE_TERM_KERNEL
 
 #ifdef CHEMISTRY_GPU
   // Update the H and He ionization fractions and apply cooling and photoheating
@@ -539,6 +876,9 @@ Real Grid3D::Update_Hydro_Grid()
   C.HeII_density  = &C.host[H.n_cells * grid_enum::HeII_density];
   C.HeIII_density = &C.host[H.n_cells * grid_enum::HeIII_density];
   C.e_density     = &C.host[H.n_cells * grid_enum::e_density];
+  #ifdef GRACKLE_METALS
+  C.metal_density = &C.host[H.n_cells * grid_enum::metal_density];
+  #endif
 #endif
 
 #ifdef COOLING_GRACKLE
@@ -565,23 +905,22 @@ Real Grid3D::Update_Hydro_Grid()
   #endif  // CPU_TIME
 #endif    // COOLING_GRACKLE
 
-  // == average slow cells and compute the new timestep ==
-#ifdef AVERAGE_SLOW_CELLS
-  // Set the min_delta_t for averaging a slow cell
-  Real max_dti_slow;
-  max_dti_slow = 1 / H.min_dt_slow;
-  Average_Slow_Cells(C.device, H.nx, H.ny, H.nz, H.n_ghost, H.n_fields, H.dx, H.dy, H.dz, gama, max_dti_slow);
-#endif  // AVERAGE_SLOW_CELLS
+#ifdef STATIC_REFINEMENT
+  // Bring the refined patch to the end of the step, before the inverse
+  // timestep of the cells it covers is reduced
+  if (refined_patch != nullptr) {
+    refined_patch->Advance();
+  }
+#endif  // STATIC_REFINEMENT
 
-  // ==Calculate the next time step using Calc_dt_GPU from hydro/hydro_cuda.h==
-  Real dti = Calc_Inverse_Timestep();
+  // == average slow cells and compute the new timestep ==
+  // ==Calculate the next time step using Reduce_dti_GPU from hydro/hydro_cuda.h==
+  Calc_Inverse_Timestep();
 
 #ifdef CPU_TIME
   Timer.Hydro.Subtract(non_hydro_elapsed_time);
   Timer.Hydro.End();
 #endif  // CPU_TIME
-
-  return dti;
 }
 
 void Grid3D::Update_Time()
@@ -621,14 +960,49 @@ void Grid3D::Reset(void)
  *  \brief Free the memory allocated by the Grid3D class. */
 void Grid3D::FreeMemory(void)
 {
+#ifdef STATIC_REFINEMENT
+  delete refined_patch;
+  refined_patch = nullptr;
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+  delete local_timesteps;
+  local_timesteps = nullptr;
+#endif  // LOCAL_TIMESTEPS
+#ifdef POWER_SPECTRUM
+  delete power_spectrum;
+  power_spectrum = nullptr;
+#endif  // POWER_SPECTRUM
+#ifdef HALO_FINDER
+  delete halo_finder;
+  halo_finder = nullptr;
+#endif  // HALO_FINDER
+
+  Derived.Free();
+
   // free the conserved variable arrays
   GPU_Error_Check(cudaFreeHost(C.host));
 
 #ifdef GRAVITY
   GPU_Error_Check(cudaFreeHost(C.Grav_potential));
-  GPU_Error_Check(cudaFree(C.d_Grav_potential));
+  #ifdef GRAV_POTENTIAL_UPLOAD
+  cuda_utilities::Pool_Free(d_grav_potential_buffers[0]);
+  cuda_utilities::Pool_Free(d_grav_potential_buffers[1]);
+  #else   // not GRAV_POTENTIAL_UPLOAD
+  cuda_utilities::Pool_Free(C.d_Grav_potential);
+  #endif  // GRAV_POTENTIAL_UPLOAD
 #endif
 
+#ifdef MHD_CENTERED_B_CACHE
+  cuda_utilities::Pool_Free(C.d_magnetic_centered);
+#endif  // MHD_CENTERED_B_CACHE
+
+#ifdef LAGGED_DT
+  cuda_utilities::Pool_Free(C.d_lagged_backup);
+#endif  // LAGGED_DT
+
+  ghost_cell_map.Free();
+  Free_Boundary_Index_Lists();
+
 // If memory is single allocated, free the memory at the end of the simulation.
 #ifdef VL
   if (H.nx > 1 && H.ny == 1 && H.nz == 1) {
@@ -639,6 +1013,12 @@ void Grid3D::FreeMemory(void)
   }
   if (H.nx > 1 && H.ny > 1 && H.nz > 1) {
     Free_Memory_VL_3D();
+    if (H.n_vl_slabs > 1) {
+      Free_Memory_VL_3D_Slabs(C.device);
+    }
+  #ifdef VL_OVERLAP
+    Free_Memory_VL_3D_Overlap();
+  #endif  // VL_OVERLAP
   }
 #endif  // VL
 #ifdef SIMPLE
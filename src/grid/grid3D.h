@@ -9,9 +9,14 @@
 #endif /*MPI_CHOLLA*/
 
 #include <stdio.h>
+#include <vector>
 
 #include "../global/global.h"
 #include "../global/global_cuda.h"
+#include "../grid/cuda_boundaries.h"
+#include "../io/derived_fields.h"
+#include "../utils/gpu_streams.h"
+#include "../utils/timestep_constraints.h"
 
 #ifdef HDF5
   #include <hdf5.h>
@@ -21,6 +26,12 @@
   #include "../gravity/grav3D.h"
 #endif
 
+// The potential of CPU gravity is uploaded on its own stream while the VL
+// integrator runs. A graph would capture the change of buffer every step
+#if defined(VL) && defined(GRAVITY) && !defined(GRAVITY_GPU) && !defined(GPU_GRAPHS)
+  #define GRAV_POTENTIAL_UPLOAD
+#endif  // VL and GRAVITY and not GRAVITY_GPU and not GPU_GRAPHS
+
 #ifdef PARTICLES
   #include "../particles/particles_3D.h"
 #endif
@@ -107,6 +118,11 @@ struct Rotation {
   /*! \var flag_delta
    *  \brief output mode for box rotation*/
   int flag_delta;
+
+  /*! \var composite
+   *  \brief sum the projections of all the processes into one image written
+   * by the root process*/
+  int composite;
 };
 
 struct Header {
@@ -235,11 +251,43 @@ struct Header {
   Real density_floor;
   Real scalar_floor;
 
+#ifdef VL
+  /*! \var n_vl_slabs
+   *  \brief Number of z-slabs the 3D VL integrator processes the grid in */
+  int n_vl_slabs;
+#endif  // VL
+
   Real Ekin_avrg;
 
   // Flag to indicate when to transfer the Conserved boundaries
   bool TRANSFER_HYDRO_BOUNDARIES;
 
+  // The fields and the number of ghost cells per face that the MPI transfer of
+  // the Conserved boundaries fills. An empty field list selects all fields
+  FieldList transfer_hydro_fields;
+  int transfer_hydro_n_ghost;
+  // The precision the transferred Conserved boundaries are packed in
+  HaloPrecision transfer_hydro_precision;
+
+#ifdef VL_OVERLAP
+  // Flag to indicate that the Conserved boundaries are transferred by the
+  // hydro integrator, overlapped with the update of the interior cells
+  bool OVERLAP_HYDRO_BOUNDARIES;
+#endif  // VL_OVERLAP
+
+#ifdef LAGGED_DT
+  // The safety factor of the lagged timestep, the reduced inverse timestep of
+  // the state the last step started from (0 before the first step) and whether
+  // the one of the current step is still being reduced
+  Real lagged_dt_safety;
+  Real lagged_max_dti;
+  bool lagged_dti_pending;
+#endif  // LAGGED_DT
+
+  // The slot of timestep_constraints the inverse timestep of the hydro is
+  // reduced into. A refined patch has its own slot, read back by the grid
+  timestep_constraints::Constraint dti_constraint;
+
   // Parameters For Spherical Colapse Problem
   Real sphere_density;
   Real sphere_radius;
@@ -276,6 +324,19 @@ struct Header {
 #endif
 };
 
+#ifdef STATIC_REFINEMENT
+class RefinedPatch;
+#endif  // STATIC_REFINEMENT
+#ifdef LOCAL_TIMESTEPS
+class LocalTimesteps;
+#endif  // LOCAL_TIMESTEPS
+#ifdef POWER_SPECTRUM
+class PowerSpectrum3D;
+#endif  // POWER_SPECTRUM
+#ifdef HALO_FINDER
+class HaloFinder;
+#endif  // HALO_FINDER
+
 /*! \class Grid3D
  *  \brief Class to create a 3D grid of cells. */
 class Grid3D
@@ -293,6 +354,26 @@ class Grid3D
    *  \brief Rotation struct for data projections */
   struct Rotation R;
 
+  /*! \var streams
+   *  \brief GPU streams for the hydro, boundary and particle work */
+  cuda_utilities::GridStreams streams;
+
+#ifdef GRAV_POTENTIAL_UPLOAD
+  /*! \var d_grav_potential_buffers
+   *  \brief The two device copies of the potential, C.d_Grav_potential is the
+   *  one of the current step and the other may still be read by the last */
+  Real *d_grav_potential_buffers[2];
+  int grav_potential_buffer = 0;
+
+  /*! \var grav_potential_read
+   *  \brief Recorded after the integrator that reads each buffer */
+  cuda_utilities::Event grav_potential_read[2];
+
+  /*! \var grav_potential_uploaded
+   *  \brief Recorded once the potential of the step is on the device */
+  cuda_utilities::Event grav_potential_uploaded;
+#endif  // GRAV_POTENTIAL_UPLOAD
+
 #ifdef GRAVITY
   // Object that contains data for gravity
   Grav3D Grav;
@@ -326,6 +407,31 @@ class Grid3D
   AnalysisModule Analysis;
 #endif
 
+  // The fields derived from the conserved variables on the device, shared by
+  // the outputs and the analysis of a step
+  DerivedFields Derived;
+
+#ifdef STATIC_REFINEMENT
+  // The refined patch of the grid, null if it has none. The patch is itself a
+  // Grid3D without one
+  RefinedPatch *refined_patch;
+#endif  // STATIC_REFINEMENT
+
+#ifdef LOCAL_TIMESTEPS
+  // The substeps of the ranks within the global step
+  LocalTimesteps *local_timesteps;
+#endif  // LOCAL_TIMESTEPS
+
+#ifdef POWER_SPECTRUM
+  // The FFTs of the power spectra of the outputs, set up at the first one
+  PowerSpectrum3D *power_spectrum;
+#endif  // POWER_SPECTRUM
+
+#ifdef HALO_FINDER
+  // The friends-of-friends halos of the outputs, set up at the first one
+  HaloFinder *halo_finder;
+#endif  // HALO_FINDER
+
 #ifdef SUPERNOVA  // TODO refactor this into Analysis module
   Real countSN;
   Real countResolved;
@@ -418,6 +524,9 @@ class Grid3D
     Real *HeII_density;
     Real *HeIII_density;
     Real *e_density;
+  #ifdef GRACKLE_METALS
+    Real *metal_density;
+  #endif
 #endif
 
     /*! pointer to conserved variable on device */
@@ -427,8 +536,20 @@ class Grid3D
 
     /*! pointer to gravitational potential on device */
     Real *d_Grav_potential;
+
+    /*! pointer to the cell centered magnetic fields of the last update on
+     * device, null unless MHD_CENTERED_B_CACHE is on */
+    Real *d_magnetic_centered;
+
+    /*! pointer to the copy of the grid at the start of the step on device,
+     * null unless LAGGED_DT is on */
+    Real *d_lagged_backup;
   } C;
 
+  /*! The map of the regular hydro ghost cells to their real cells, built by
+   * Set_Hydro_Boundaries_Single_Launch */
+  GhostCellMap ghost_cell_map;
+
   /*! \fn Grid3D(void)
    *  \brief Constructor for the grid */
   Grid3D(void);
@@ -450,15 +571,26 @@ class Grid3D
    * *zpos) \brief Get the cell-centered position based on cell index */
   void Get_Position(long i, long j, long k, Real *xpos, Real *ypos, Real *zpos);
 
-  Real Calc_Inverse_Timestep();
+  /*! \fn void Calc_Inverse_Timestep()
+   *  \brief Reduce the inverse timestep of the hydro into its slot of
+   *  timestep_constraints, set_dt brings it back to the host */
+  void Calc_Inverse_Timestep();
 
   /*! \fn void Set_Domain_Properties(struct Parameters P)
    *  \brief Set local domain properties */
   void Set_Domain_Properties(struct Parameters P);
 
-  /*! \fn void set_dt(Real dti)
-   *  \brief Calculate the timestep. */
-  void set_dt(Real dti);
+  /*! \fn void set_dt()
+   *  \brief Calculate the timestep from all the timestep_constraints. */
+  void set_dt();
+
+#ifdef LAGGED_DT
+  /*! \fn bool Retake_Lagged_Step()
+   *  \brief Wait for the reduced inverse timestep of the state the step
+   *  started from. If the lagged timestep was too long for it, restore that
+   *  state and set the exact timestep; the step has to be taken again */
+  bool Retake_Lagged_Step();
+#endif  // LAGGED_DT
 
 #ifdef GRAVITY
   /*! \fn void set_dt(Real dti)
@@ -466,13 +598,24 @@ class Grid3D
   void set_dt_Gravity();
 #endif
 
-  /*! \fn void Execute_Hydro_Integratore_Grid(void)
+  /*! \fn void Execute_Hydro_Integratore_Grid(struct Parameters *P)
    *  \brief Updates cells by executing the hydro integrator. */
-  void Execute_Hydro_Integrator(void);
+  void Execute_Hydro_Integrator(struct Parameters *P);
+
+  /*! \fn Real Internal_Energy_Floor()
+   *  \brief The specific internal energy of the temperature floor. */
+  Real Internal_Energy_Floor();
 
-  /*! \fn void Update_Hydro_Grid(void)
+  /*! \fn void Update_Hydro_Grid(struct Parameters *P)
    *  \brief Do all steps to update the hydro. */
-  Real Update_Hydro_Grid(void);
+  void Update_Hydro_Grid(struct Parameters *P);
+
+#ifdef RUNTIME_KERNELS
+  /*! \fn void Select_Hydro_Kernels(struct Parameters const &P)
+   *  \brief Choose the reconstruction and Riemann solver of the VL integrator
+   *  from the parameters, timing the candidates on the current state. */
+  void Select_Hydro_Kernels(struct Parameters const &P);
+#endif  // RUNTIME_KERNELS
 
   void Update_Time();
   /*! \fn void Write_Header_Text(FILE *fp)
@@ -509,6 +652,11 @@ class Grid3D
    * projection. */
   void Write_Header_Rotated_HDF5(hid_t file_id);
 
+  /*! \fn void Set_Rotated_Projection_Bounds()
+   *  \brief Set the piece of the rotated projection that this subvolume
+   * covers. */
+  void Set_Rotated_Projection_Bounds();
+
   /*! \fn void Write_Rotated_Projection_HDF5(hid_t file_id)
    *  \brief Write rotated projected data to a file, at the current simulation
    * time. */
@@ -646,6 +794,12 @@ class Grid3D
    * parameters structure. */
   void Set_Boundary_Conditions_Grid(Parameters P);
 
+  /*! \fn void Set_Hydro_Boundary_Conditions_Fields(Parameters P, std::vector<int> const &fields, int n_ghost)
+   *  \brief Transfer the Conserved boundaries of only some of the fields and
+   * only the n_ghost cells closest to the interior. The MPI messages shrink
+   * accordingly; faces that are not MPI faces are filled as usual. */
+  void Set_Hydro_Boundary_Conditions_Fields(Parameters P, std::vector<int> const &fields, int n_ghost);
+
   /*! \fn int Check_Custom_Boundary(int *flags, struct Parameters P)
    *  \brief Check for custom boundary conditions */
   int Check_Custom_Boundary(int *flags, struct Parameters P);
@@ -654,6 +808,12 @@ class Grid3D
    *  \brief Apply boundary conditions to the grid. */
   void Set_Boundaries(int dir, int flags[]);
 
+  /*! \fn void Set_Hydro_Boundaries_Single_Launch(int flags[])
+   *  \brief Set the hydro ghost cells of all the regular faces, edges and
+   * corners like the Set_Boundaries calls of each face, in a single launch of
+   * ghost_cell_map. The map is rebuilt when the flags change. */
+  void Set_Hydro_Boundaries_Single_Launch(int flags[]);
+
   /*! \fn Set_Boundary_Extents(int dir, int *imin, int *imax)
    *  \brief Set the extents of the ghost region we are initializing. */
   void Set_Boundary_Extents(int dir, int *imin, int *imax);
@@ -726,6 +886,21 @@ class Grid3D
 #ifdef MPI_CHOLLA
   void Set_Boundaries_MPI(struct Parameters P);
   void Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P);
+  /*! \fn void Start_Boundaries_MPI_BLOCK(int *flags)
+   *  \brief Post the x sends of Set_Boundaries_MPI_BLOCK, selecting the
+   * particles to transfer first when transferring particles */
+  void Start_Boundaries_MPI_BLOCK(int *flags);
+  /*! \fn void Finish_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
+   *  \brief Complete the exchange started by Start_Boundaries_MPI_BLOCK */
+  void Finish_Boundaries_MPI_BLOCK(int *flags, struct Parameters P);
+  /*! \fn bool Check_MPI_26_Neighbors(int *flags)
+   *  \brief Check if the hydro ghost cells can be filled by a single exchange
+   * with all 26 neighbors for the given boundary flags */
+  bool Check_MPI_26_Neighbors(int *flags);
+  /*! \fn void Set_Hydro_Boundaries_MPI_26()
+   *  \brief Fill all the hydro ghost cells, including edges and corners, in a
+   * single exchange with the 26 neighboring ranks */
+  void Set_Hydro_Boundaries_MPI_26();
   void Load_and_Send_MPI_Comm_Buffers(int dir, int *flags);
   void Wait_and_Unload_MPI_Comm_Buffers(int dir, int *flags);
   void Unload_MPI_Comm_Buffers(int index);
@@ -743,6 +918,14 @@ class Grid3D
   void Unload_Hydro_DeviceBuffer_Y1(Real *buffer);
   void Unload_Hydro_DeviceBuffer_Z0(Real *buffer);
   void Unload_Hydro_DeviceBuffer_Z1(Real *buffer);
+  /*! \fn int Hydro_Transfer_Length(int buffer_length)
+   *  \brief The number of values in a hydro MPI message given the length of
+   * the full buffer, accounting for the selected fields and ghost depth */
+  int Hydro_Transfer_Length(int buffer_length);
+  /*! \fn int Potential_Buffer_Offset(int direction)
+   *  \brief The offset of the potential boundaries in the MPI messages of a
+   * direction, past the hydro boundaries when both are transferred together */
+  int Potential_Buffer_Offset(int direction);
 #endif /*MPI_CHOLLA*/
 
 #ifdef GRAVITY
@@ -752,6 +935,12 @@ class Grid3D
   void Copy_Hydro_Density_to_Gravity();
   void Extrapolate_Grav_Potential_Function(int g_start, int g_end);
   void Extrapolate_Grav_Potential();
+  #ifdef GRAV_POTENTIAL_UPLOAD
+  /*! \fn void Upload_Grav_Potential()
+   *  \brief Start the upload of the extrapolated potential into the device
+   *  buffer the last integrator step didn't read, for the next one to wait on */
+  void Upload_Grav_Potential();
+  #endif  // GRAV_POTENTIAL_UPLOAD
   void Set_Potential_Boundaries_Periodic(int direction, int side, int *flags);
   int Load_Gravity_Potential_To_Buffer(int direction, int side, Real *buffer, int buffer_start);
   void Unload_Gravity_Potential_from_Buffer(int direction, int side, Real *buffer, int buffer_start);
@@ -762,14 +951,27 @@ class Grid3D
   void Get_Potential_SOR(Real Grav_Constant, Real dens_avrg, Real current_a, struct Parameters *P);
   int Load_Poisson_Boundary_To_Buffer(int direction, int side, Real *buffer);
   void Unload_Poisson_Boundary_From_Buffer(int direction, int side, Real *buffer_host);
+    #ifdef MULTIGRID
+  void Multigrid_Exchange_Boundaries(int level, struct Parameters *P);
+  void Multigrid_Smooth_Level(int level, int n_sweeps, struct Parameters *P);
+  void Multigrid_V_Cycle(int level, struct Parameters *P);
+  void Multigrid_Solve(struct Parameters *P);
+    #endif
   #endif
   #ifdef GRAVITY_GPU
   void Copy_Hydro_Density_to_Gravity_GPU();
+  Real Get_Grav_Density_Change_GPU();
+  void Store_Grav_Density_GPU();
+    #ifdef POISSON_FUSED_IO
+  PotentialFusedIO Get_Poisson_Fused_IO(struct Parameters *P);
+    #endif
   void Extrapolate_Grav_Potential_GPU();
   int Load_Gravity_Potential_To_Buffer_GPU(int direction, int side, Real *buffer, int buffer_start);
   void Unload_Gravity_Potential_from_Buffer_GPU(int direction, int side, Real *buffer, int buffer_start);
   void Set_Potential_Boundaries_Isolated_GPU(int direction, int side, int *flags);
   void Set_Potential_Boundaries_Periodic_GPU(int direction, int side, int *flags);
+  void Compute_Potential_Isolated_Boundary_GPU(int direction, int side, int bc_potential_type);
+  void Compute_Density_Multipole_GPU();
   #endif
 
 #endif  // GRAVITY
@@ -792,6 +994,13 @@ class Grid3D
   void Copy_Particles_Density_to_Gravity(struct Parameters P);
   void Set_Particles_Density_Boundaries_Periodic(int direction, int side);
   void Transfer_Particles_Boundaries(struct Parameters P);
+  /*! \fn void Start_Transfer_Particles_Boundaries(struct Parameters P)
+   *  \brief Start the transfer of the particles that moved outside the local
+   * domain. With MPI the particles of the x faces are in flight when it
+   * returns, Finish_Transfer_Particles_Boundaries must be called before the
+   * particles are used again */
+  void Start_Transfer_Particles_Boundaries(struct Parameters P);
+  void Finish_Transfer_Particles_Boundaries(struct Parameters P);
   Real Update_Grid_and_Particles_KDK(struct Parameters P);
   void Set_Particles_Boundary(int dir, int side);
   #ifdef PARTICLES_CPU
@@ -827,7 +1036,14 @@ class Grid3D
   #ifdef HDF5
   void Write_Particles_Header_HDF5(hid_t file_id);
   void Write_Particles_Data_HDF5(hid_t file_id);
+  void Write_Particles_Grid_HDF5(hid_t file_id);
   void Load_Particles_Data_HDF5(hid_t file_id, int nfile);
+  // Write the particles of the selection of particles_subset_fraction and
+  // particles_subset_boxes
+  void Output_Particles_Subset(struct Parameters P, int nfile);
+    #ifdef MPI_CHOLLA
+  void Output_Particles_Data_Cat(struct Parameters P, int nfile);
+    #endif  // MPI_CHOLLA
   #endif  // HDF5
   void Get_Gravity_Field_Particles_function(int g_start, int g_end);
   void Get_Gravity_Field_Particles();
@@ -842,9 +1058,15 @@ class Grid3D
   Real Calc_Particles_dt_function(part_int_t p_start, part_int_t p_end);
   Real Calc_Particles_dt();
   #ifdef PARTICLES_GPU
+  void Calc_Particles_dti_GPU();
   Real Calc_Particles_dt_GPU();
   void Advance_Particles_KDK_Step1_GPU();
   void Advance_Particles_KDK_Step2_GPU();
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  BlockStepFactors Get_Block_Step_Factors(int tick, Real step_start, Real step_length);
+  void Advance_Particles_Block_Steps_GPU();
+  void Close_Particles_Block_Steps_GPU();
+    #endif  // PARTICLES_BLOCK_TIMESTEPS
   void Set_Particles_Boundary_GPU(int dir, int side);
   void Set_Particles_Density_Boundaries_Periodic_GPU(int direction, int side);
   #endif  // PARTICLES_GPU
@@ -857,6 +1079,20 @@ class Grid3D
   #endif  // GRAVITY_GPU
 #endif    // PARTICLES
 
+#ifdef STATIC_REFINEMENT
+  /*! \fn void Initialize_Refinement(struct Parameters *P)
+   *  \brief Create the refined patch of the refine_* parameters, if any, with
+   * its initial conditions at its own resolution and average it onto the grid
+   * cells it covers */
+  void Initialize_Refinement(struct Parameters *P);
+#endif  // STATIC_REFINEMENT
+
+#ifdef LOCAL_TIMESTEPS
+  /*! \fn void Initialize_Local_Timesteps(struct Parameters *P)
+   *  \brief Set up the local timesteps of the local_time_levels parameter */
+  void Initialize_Local_Timesteps(struct Parameters *P);
+#endif  // LOCAL_TIMESTEPS
+
 #ifdef COSMOLOGY
   void Initialize_Cosmology(struct Parameters *P);
   void Change_DM_Frame_System(bool forward);
@@ -893,12 +1129,34 @@ class Grid3D
 #ifdef ANALYSIS
   void Initialize_AnalysisModule(struct Parameters *P);
   void Compute_and_Output_Analysis(struct Parameters *P);
+  /*! \fn void Compute_Analysis_Statistics()
+   *  \brief Reduce the measurements that Compute_and_Output_Analysis took from
+   * the grid into the statistics of the output, without touching the grid. */
+  void Compute_Analysis_Statistics();
+  void Write_Analysis(struct Parameters *P);
+  #ifdef ASYNC_ANALYSIS
+  /*! \fn void Poll_Analysis(struct Parameters *P)
+   *  \brief Write the analysis computed on the background thread if it is
+   * done. */
+  void Poll_Analysis(struct Parameters *P);
+  /*! \fn void Finish_Analysis(struct Parameters *P)
+   *  \brief Wait for the analysis computed on the background thread and write
+   * it. */
+  void Finish_Analysis(struct Parameters *P);
+  #endif  // ASYNC_ANALYSIS
   void Output_Analysis(struct Parameters *P);
   void Write_Analysis_Header_HDF5(hid_t file_id);
   void Write_Analysis_Data_HDF5(hid_t file_id);
 
   #ifdef PHASE_DIAGRAM
   void Compute_Phase_Diagram();
+    #ifdef CHEMISTRY_GPU
+  /*! \fn void Compute_Phase_Diagram_GPU()
+   *  \brief Bin the density and temperature of the local cells into
+   * Analysis.phase_diagram on the device, without copying the fields to the
+   * host. */
+  void Compute_Phase_Diagram_GPU();
+    #endif  // CHEMISTRY_GPU
   #endif
 
   #ifdef LYA_STATISTICS
@@ -907,6 +1165,21 @@ class Grid3D
   void Compute_Lya_Statistics();
   void Compute_Flux_Power_Spectrum_Skewer(int skewer_id, int axis);
   void Initialize_Power_Spectrum_Measurements(int axis);
+  /*! \fn void Output_Lya_Skewers_GPU(struct Parameters *P)
+   *  \brief Extract the density, temperature, HI and HeII densities and
+   * velocity of the local skewers on the device and write them to a file per
+   * process, instead of computing the flux statistics on the host. */
+  void Output_Lya_Skewers_GPU(struct Parameters *P);
+    #ifdef LYA_STATISTICS_GPU
+  /*! \fn void Compute_Transmitted_Flux_GPU(int axis)
+   *  \brief Compute the transmitted flux of all the skewers along axis of the
+   * root process at once on the device. */
+  void Compute_Transmitted_Flux_GPU(int axis);
+  /*! \fn void Compute_Flux_Power_Spectrum_GPU(int axis)
+   *  \brief Compute the flux power spectrum of all the skewers along axis of
+   * the root process with a batched FFT on the device. */
+  void Compute_Flux_Power_Spectrum_GPU(int axis);
+    #endif  // LYA_STATISTICS_GPU
     #ifdef OUTPUT_SKEWERS
   void Output_Skewers_File(struct Parameters *P);
   void Write_Skewers_Header_HDF5(hid_t file_id);
@@ -16,6 +16,7 @@
 
 #include "../global/global.h"
 #include "../grid/grid3D.h"
+#include "../grid/initial_conditions_gpu.h"
 #include "../io/io.h"
 #include "../mpi/mpi_routines.h"
 #include "../utils/error_handling.h"
@@ -31,6 +32,24 @@ void Grid3D::Set_Initial_Conditions(Parameters P)
   Set_Domain_Properties(P);
   Set_Gammas(P.gamma);
 
+#ifdef DEVICE_INITIAL_CONDITIONS
+  // The setups with a device version are evaluated straight into C.device,
+  // which is still zero, and the host grid is copied from it for the code that
+  // reads it before the first step
+  if (C.device != NULL and initial_conditions::Has_Device_Initial_Conditions(P.init)) {
+    initial_conditions::GridGeometry grid{H.nx, H.ny, H.nz, H.n_ghost, H.n_cells, 0, 0, 0, H.xbound, H.ybound,
+                                          H.zbound, H.xdglobal, H.ydglobal, H.zdglobal, H.dx, H.dy, H.dz};
+  #ifdef MPI_CHOLLA
+    grid.x_offset = nx_local_start;
+    grid.y_offset = ny_local_start;
+    grid.z_offset = nz_local_start;
+  #endif  // MPI_CHOLLA
+    initial_conditions::Set_Initial_Conditions_GPU(grid, P, gama, C.device);
+    GPU_Error_Check(cudaMemcpy(C.density, C.device, H.n_fields * H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost));
+    return;
+  }
+#endif  // DEVICE_INITIAL_CONDITIONS
+
   if (strcmp(P.init, "Constant") == 0) {
     Constant(P);
   } else if (strcmp(P.init, "Sound_Wave") == 0) {
@@ -1653,6 +1672,9 @@ void Grid3D::Chemistry_Test(struct Parameters P)
         C.HeII_density[id]  = rho_gas_mean * HeII_frac;
         C.HeIII_density[id] = rho_gas_mean * HeIII_frac;
         C.e_density[id]     = rho_gas_mean * e_frac;
+    #ifdef GRACKLE_METALS
+        C.metal_density[id] = rho_gas_mean * metal_frac;
+    #endif
   #endif
 
   #ifdef COOLING_GRACKLE
@@ -0,0 +1,352 @@
+/*! \file initial_conditions_gpu.cu
+ *  \brief Definitions of the initial conditions that are evaluated on the
+ *  device. Each functor mirrors the host version of the same name in
+ *  initial_conditions.cpp. */
+
+#ifdef DEVICE_INITIAL_CONDITIONS
+
+  #include <math.h>
+  #include <stdio.h>
+  #include <string.h>
+
+  #include "../cosmology/synthetic_cosmology.h"
+  #include "../global/global_cuda.h"
+  #include "../grid/grid_enum.h"
+  #include "../grid/initial_conditions_gpu.h"
+  #include "../io/io.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/hydro_utilities.h"
+
+namespace
+{
+// Evaluate the functor at every real cell, and with MHD also at the ghost
+// cells just left of them for the magnetic fields
+template <typename Functor>
+__global__ void Set_Conserved_Kernel(Functor const functor, initial_conditions::GridGeometry const grid,
+                                     Real *dev_conserved)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id >= grid.n_cells) {
+    return;
+  }
+  int i, j, k;
+  cuda_utilities::compute3DIndices(id, grid.nx, grid.ny, i, j, k);
+
+  // The axes without ghost cells are all real cells
+  int const jstart = (grid.ny > 1) ? grid.n_ghost : 0;
+  int const kstart = (grid.nz > 1) ? grid.n_ghost : 0;
+  bool const real  = i >= grid.n_ghost and i < grid.nx - grid.n_ghost and j >= jstart and j < grid.ny - jstart and
+                    k >= kstart and k < grid.nz - kstart;
+  #ifdef MHD
+  bool const left_face = i >= grid.n_ghost - 1 and i < grid.nx - grid.n_ghost and j >= jstart - (grid.ny > 1) and
+                         j < grid.ny - jstart and k >= kstart - (grid.nz > 1) and k < grid.nz - kstart;
+  if (not left_face) {
+    return;
+  }
+  #else   // not MHD
+  if (not real) {
+    return;
+  }
+  #endif  // MHD
+
+  Real x, y, z;
+  grid.Position(i, j, k, x, y, z);
+  initial_conditions::ConservedCell const cell = functor(x, y, z);
+
+  #ifdef MHD
+  dev_conserved[id + grid_enum::magnetic_x * grid.n_cells] = cell.magnetic_x;
+  dev_conserved[id + grid_enum::magnetic_y * grid.n_cells] = cell.magnetic_y;
+  dev_conserved[id + grid_enum::magnetic_z * grid.n_cells] = cell.magnetic_z;
+  if (not real) {
+    return;
+  }
+  #endif  // MHD
+  dev_conserved[id + grid_enum::density * grid.n_cells]    = cell.density;
+  dev_conserved[id + grid_enum::momentum_x * grid.n_cells] = cell.momentum_x;
+  dev_conserved[id + grid_enum::momentum_y * grid.n_cells] = cell.momentum_y;
+  dev_conserved[id + grid_enum::momentum_z * grid.n_cells] = cell.momentum_z;
+  dev_conserved[id + grid_enum::Energy * grid.n_cells]     = cell.energy;
+  #ifdef DE
+  dev_conserved[id + grid_enum::GasEnergy * grid.n_cells] = cell.gas_energy;
+  #endif  // DE
+  #ifdef SCALAR
+    #ifdef BASIC_SCALAR
+  dev_conserved[id + grid_enum::basic_scalar * grid.n_cells] = cell.basic_scalar;
+    #endif  // BASIC_SCALAR
+    #ifdef DUST
+  dev_conserved[id + grid_enum::dust_density * grid.n_cells] = cell.dust_density;
+    #endif  // DUST
+  #endif    // SCALAR
+}
+
+template <typename Functor>
+void Set_Conserved_GPU(Functor const &functor, initial_conditions::GridGeometry const &grid, Real *dev_conserved)
+{
+  int const n_blocks = (grid.n_cells + TPB - 1) / TPB;
+  hipLaunchKernelGGL(Set_Conserved_Kernel<Functor>, n_blocks, TPB, 0, 0, functor, grid, dev_conserved);
+  GPU_Error_Check(cudaDeviceSynchronize());
+}
+
+// A uniform state
+struct ConstantState {
+  Real rho, vx, vy, vz, P, gamma;
+  Real Bx, By, Bz;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    initial_conditions::ConservedCell cell;
+    cell.density    = rho;
+    cell.momentum_x = rho * vx;
+    cell.momentum_y = rho * vy;
+    cell.momentum_z = rho * vz;
+    cell.energy     = P / (gamma - 1.0) + 0.5 * rho * (vx * vx + vy * vy + vz * vz);
+  #ifdef DE
+    cell.gas_energy = P / (gamma - 1.0);
+  #endif  // DE
+  #ifdef MHD
+    cell.magnetic_x = Bx;
+    cell.magnetic_y = By;
+    cell.magnetic_z = Bz;
+  #endif  // MHD
+    return cell;
+  }
+};
+
+// A small amplitude sine perturbation of a uniform state along x
+struct SoundWave {
+  Real rho, vx, vy, vz, P, A, gamma;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    Real const perturbation = A * sin(2.0 * M_PI * x);
+    initial_conditions::ConservedCell cell;
+    cell.density    = rho + perturbation;
+    cell.momentum_x = rho * vx + perturbation;
+    cell.momentum_y = rho * vy + perturbation;
+    cell.momentum_z = rho * vz + perturbation;
+    cell.energy     = P / (gamma - 1.0) + 0.5 * rho * (vx * vx + vy * vy + vz * vz) + A * (1.5) * sin(2 * M_PI * x);
+  #ifdef DE
+    cell.gas_energy = P / (gamma - 1.0);
+  #endif  // DE
+    return cell;
+  }
+};
+
+// Two uniform states separated at x = diaph
+struct RiemannProblem {
+  Real rho_l, vx_l, vy_l, vz_l, P_l, Bx_l, By_l, Bz_l;
+  Real rho_r, vx_r, vy_r, vz_r, P_r, Bx_r, By_r, Bz_r;
+  Real diaph, gamma;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    bool const left = x < diaph;
+    Real const rho  = left ? rho_l : rho_r;
+    Real const vx   = left ? vx_l : vx_r;
+    Real const vy   = left ? vy_l : vy_r;
+    Real const vz   = left ? vz_l : vz_r;
+    Real const P    = left ? P_l : P_r;
+    Real const Bx   = left ? Bx_l : Bx_r;
+    Real const By   = left ? By_l : By_r;
+    Real const Bz   = left ? Bz_l : Bz_r;
+
+    initial_conditions::ConservedCell cell;
+    cell.density    = rho;
+    cell.momentum_x = rho * vx;
+    cell.momentum_y = rho * vy;
+    cell.momentum_z = rho * vz;
+    cell.energy     = hydro_utilities::Calc_Energy_Primitive(P, rho, vx, vy, vz, gamma, Bx, By, Bz);
+  #ifdef DE
+    cell.gas_energy = P / (gamma - 1.0);
+  #endif  // DE
+  #ifdef SCALAR
+    #ifdef BASIC_SCALAR
+    cell.basic_scalar = left ? 1.0 * rho_l : 0.0 * rho_r;
+    #endif  // BASIC_SCALAR
+  #endif    // SCALAR
+  #ifdef MHD
+    cell.magnetic_x = Bx;
+    cell.magnetic_y = By;
+    cell.magnetic_z = Bz;
+  #endif  // MHD
+    return cell;
+  }
+};
+
+// A Kelvin-Helmholtz unstable shear layer with a sinusoidal perturbation
+struct KelvinHelmholtz {
+  Real ydglobal, gamma;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    Real const d1 = 2.0, d2 = 1.0, v1 = 0.5, v2 = -0.5, P = 2.5, A = 0.1;
+
+    // outer quarters of the slab, inner half of the slab
+    bool const outer = (y <= 1.0 * ydglobal / 4.0) or (y >= 3.0 * ydglobal / 4.0);
+    initial_conditions::ConservedCell cell;
+    cell.density    = outer ? d2 : d1;
+    cell.momentum_x = (outer ? v2 : v1) * cell.density;
+    cell.momentum_y = cell.density * A * sin(4 * M_PI * x);
+    cell.momentum_z = 0.0;
+    cell.energy     = P / (gamma - 1.0) +
+                  0.5 * (cell.momentum_x * cell.momentum_x + cell.momentum_y * cell.momentum_y) / cell.density;
+  #ifdef DE
+    cell.gas_energy = P / (gamma - 1.0);
+  #endif  // DE
+  #ifdef SCALAR
+    #ifdef BASIC_SCALAR
+    cell.basic_scalar = outer ? 0.0 : 1.0 * d1;
+    #endif  // BASIC_SCALAR
+  #endif    // SCALAR
+    return cell;
+  }
+};
+
+// A dense, overpressured sphere in the center of the unit box
+struct SphericalOverpressure {
+  Real gamma;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    Real const center = 0.5, overDensity = 1, overPressure = 10;
+    Real density = 0.1, pressure = 1;
+    Real const r = sqrt((x - center) * (x - center) + (y - center) * (y - center) + (z - center) * (z - center));
+    if (r < 0.2) {
+      density = overDensity;
+      pressure += overPressure;
+    }
+
+    initial_conditions::ConservedCell cell;
+    cell.density = density;
+    cell.energy  = pressure / (gamma - 1);
+  #ifdef DE
+    cell.gas_energy = pressure / (gamma - 1);
+  #endif  // DE
+    return cell;
+  }
+};
+
+// A cold cloud in pressure equilibrium with a hot background
+struct Cloud {
+  Real cl_x, cl_y, cl_z, R_cl;
+  Real rho_bg, rho_cl, p_bg, p_cl, gamma;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    Real const r      = sqrt((x - cl_x) * (x - cl_x) + (y - cl_y) * (y - cl_y) + (z - cl_z) * (z - cl_z));
+    bool const inside = r < R_cl;
+    Real const rho    = inside ? rho_cl : rho_bg;
+    Real const p      = inside ? p_cl : p_bg;
+
+    // Both states are at rest
+    initial_conditions::ConservedCell cell;
+    cell.density = rho;
+    cell.energy  = p / (gamma - 1.0);
+  #ifdef DE
+    cell.gas_energy = p / (gamma - 1.0);
+  #endif  // DE
+  #ifdef SCALAR
+    #ifdef DUST
+    cell.dust_density = inside ? rho_cl * 1e-2 : 0.0;
+    #endif  // DUST
+  #endif    // SCALAR
+    return cell;
+  }
+};
+
+  #ifdef COSMOLOGY
+// The gas of the synthetic cosmological initial conditions: the mean baryon
+// density perturbed by the linear overdensity, moving with the dark matter
+struct SyntheticCosmology {
+  synthetic_cosmology::Field field;
+  Real rho_mean, u;
+
+  __device__ initial_conditions::ConservedCell operator()(Real x, Real y, Real z) const
+  {
+    Real psi_x, psi_y, psi_z;
+    field.Displacement(x, y, z, psi_x, psi_y, psi_z);
+    Real const rho = rho_mean * (1 + field.Overdensity(x, y, z));
+    Real const vx  = field.vel_factor * psi_x;
+    Real const vy  = field.vel_factor * psi_y;
+    Real const vz  = field.vel_factor * psi_z;
+
+    initial_conditions::ConservedCell cell;
+    cell.density    = rho;
+    cell.momentum_x = rho * vx;
+    cell.momentum_y = rho * vy;
+    cell.momentum_z = rho * vz;
+    cell.energy     = rho * u + 0.5 * rho * (vx * vx + vy * vy + vz * vz);
+    #ifdef DE
+    cell.gas_energy = rho * u;
+    #endif  // DE
+    return cell;
+  }
+};
+  #endif  // COSMOLOGY
+}  // namespace
+
+namespace initial_conditions
+{
+bool Has_Device_Initial_Conditions(char const *init)
+{
+  #ifdef COSMOLOGY
+  // The synthetic cosmology only has a device version
+  if (strcmp(init, "Synthetic_Cosmology") == 0) {
+    return true;
+  }
+  #endif  // COSMOLOGY
+  char const *const device_setups[] = {"Constant", "Sound_Wave", "Riemann", "KH", "Spherical_Overpressure_3D",
+                                       "Clouds"};
+  for (char const *setup : device_setups) {
+    if (strcmp(init, setup) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Set_Initial_Conditions_GPU(GridGeometry const &grid, Parameters const &P, Real gamma, Real *dev_conserved)
+{
+  if (strcmp(P.init, "Constant") == 0) {
+    Set_Conserved_GPU(ConstantState{P.rho, P.vx, P.vy, P.vz, P.P, gamma, P.Bx, P.By, P.Bz}, grid, dev_conserved);
+    Real const mu = 0.6;
+    Real const n  = P.rho * DENSITY_UNIT / (mu * MP);
+    Real const T  = P.P * PRESSURE_UNIT / (n * KB);
+    printf("Initial n = %e, T = %e\n", n, T);
+  } else if (strcmp(P.init, "Sound_Wave") == 0) {
+    Set_Conserved_GPU(SoundWave{P.rho, P.vx, P.vy, P.vz, P.P, P.A, gamma}, grid, dev_conserved);
+  } else if (strcmp(P.init, "Riemann") == 0) {
+    Set_Conserved_GPU(RiemannProblem{P.rho_l, P.vx_l, P.vy_l, P.vz_l, P.P_l, P.Bx_l, P.By_l, P.Bz_l, P.rho_r, P.vx_r,
+                                     P.vy_r, P.vz_r, P.P_r, P.Bx_r, P.By_r, P.Bz_r, P.diaph, gamma},
+                      grid, dev_conserved);
+  } else if (strcmp(P.init, "KH") == 0) {
+    Set_Conserved_GPU(KelvinHelmholtz{grid.ydglobal, gamma}, grid, dev_conserved);
+  } else if (strcmp(P.init, "Spherical_Overpressure_3D") == 0) {
+    Set_Conserved_GPU(SphericalOverpressure{gamma}, grid, dev_conserved);
+  } else if (strcmp(P.init, "Clouds") == 0) {
+    // A single centered cloud, see Grid3D::Clouds
+    Real const mu   = 0.6;
+    Real const n_bg = 1.68e-4, n_cl = 5.4e-2, T_bg = 3e6;
+    Real const p_bg = n_bg * KB * T_bg / PRESSURE_UNIT;
+    Cloud const cloud{0.5 * grid.xdglobal, 0.5 * grid.ydglobal, 0.5 * grid.zdglobal, 2.5,
+                      n_bg * mu * MP / DENSITY_UNIT, n_cl * mu * MP / DENSITY_UNIT, p_bg, p_bg, gamma};
+    printf("Cloud positions: %f %f %f\n", cloud.cl_x, cloud.cl_y, cloud.cl_z);
+    Set_Conserved_GPU(cloud, grid, dev_conserved);
+  #ifdef COSMOLOGY
+  } else if (strcmp(P.init, "Synthetic_Cosmology") == 0) {
+    // The specific internal energy of the gas at gas_temperature, in (km/s)^2
+    CHOLLA_ASSERT(P.Omega_b > 0 and P.Omega_b < P.Omega_M, "Synthetic_Cosmology needs 0 < Omega_b < Omega_M");
+    Real const mu = 1.22;
+    Real const u  = KB * synthetic_cosmology::gas_temperature / ((gamma - 1) * mu * MP) * 1e-10;
+    SyntheticCosmology const gas{synthetic_cosmology::Make_Field(P), synthetic_cosmology::Mean_Density(P, P.Omega_b),
+                                 u};
+    Set_Conserved_GPU(gas, grid, dev_conserved);
+  #endif  // COSMOLOGY
+  } else {
+    CHOLLA_ERROR("%s has no device initial conditions", P.init);
+  }
+}
+}  // namespace initial_conditions
+
+#endif  // DEVICE_INITIAL_CONDITIONS
@@ -0,0 +1,80 @@
+/*! \file initial_conditions_gpu.h
+ *  \brief Declarations of the initial conditions that are evaluated on the
+ *  device. Each setup is a functor that gives the conserved state of a cell
+ *  from its position, and one kernel evaluates it for every cell straight into
+ *  the device grid, so large grids don't wait on serial host loops. */
+
+#pragma once
+
+#ifdef DEVICE_INITIAL_CONDITIONS
+
+  #include "../global/global.h"
+  #include "../utils/gpu.hpp"
+
+namespace initial_conditions
+{
+/*!
+ * \brief The local grid the initial conditions are evaluated on. The cell
+ * centers are computed like Grid3D::Get_Position
+ */
+struct GridGeometry {
+  int nx, ny, nz, n_ghost, n_cells;
+  // The global index of the first real cell of the local grid along each axis
+  int x_offset, y_offset, z_offset;
+  // The lower bounds of the global domain
+  Real xbound, ybound, zbound;
+  // The sizes of the global domain
+  Real xdglobal, ydglobal, zdglobal;
+  Real dx, dy, dz;
+
+  __host__ __device__ void Position(int i, int j, int k, Real &x, Real &y, Real &z) const
+  {
+    x = xbound + (x_offset + i - n_ghost) * dx + 0.5 * dx;
+    y = ybound + (y_offset + j - n_ghost) * dy + 0.5 * dy;
+    z = zbound + (z_offset + k - n_ghost) * dz + 0.5 * dz;
+  }
+};
+
+/*!
+ * \brief The conserved state of a cell that an initial condition functor
+ * returns. The fields it leaves alone stay zero. The magnetic fields are also
+ * set in the ghost cells just left of the real cells, which hold the left faces
+ * of the first real cells
+ */
+struct ConservedCell {
+  Real density    = 0;
+  Real momentum_x = 0;
+  Real momentum_y = 0;
+  Real momentum_z = 0;
+  Real energy     = 0;
+  #ifdef DE
+  Real gas_energy = 0;
+  #endif  // DE
+  #ifdef SCALAR
+    #ifdef BASIC_SCALAR
+  Real basic_scalar = 0;
+    #endif  // BASIC_SCALAR
+    #ifdef DUST
+  Real dust_density = 0;
+    #endif  // DUST
+  #endif    // SCALAR
+  #ifdef MHD
+  Real magnetic_x = 0;
+  Real magnetic_y = 0;
+  Real magnetic_z = 0;
+  #endif  // MHD
+};
+
+/*! \fn bool Has_Device_Initial_Conditions(char const *init)
+ *  \brief Whether the initial conditions named init have a device version */
+bool Has_Device_Initial_Conditions(char const *init);
+
+/*! \fn void Set_Initial_Conditions_GPU(GridGeometry const &grid, Parameters const &P, Real gamma, Real
+ * *dev_conserved)
+ *  \brief Evaluate the initial conditions P.init on the device into
+ *  dev_conserved, which has to be zero. Only the setups of
+ *  Has_Device_Initial_Conditions are supported */
+void Set_Initial_Conditions_GPU(GridGeometry const &grid, Parameters const &P, Real gamma, Real *dev_conserved);
+}  // namespace initial_conditions
+
+#endif  // DEVICE_INITIAL_CONDITIONS
@@ -0,0 +1,111 @@
+/*!
+ * \file initial_conditions_gpu_tests.cu
+ * \brief Tests for the contents of initial_conditions_gpu.h
+ *
+ */
+
+// STL Includes
+#include <cstring>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../grid/grid_enum.h"
+#include "../grid/initial_conditions_gpu.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/hydro_utilities.h"
+#include "../utils/testing_utilities.h"
+
+#ifdef DEVICE_INITIAL_CONDITIONS
+namespace
+{
+// A unit cube of 8^3 real cells with two ghost cells on each side
+initial_conditions::GridGeometry Test_Grid()
+{
+  int const n_ghost = 2, n_real = 8;
+  int const n       = n_real + 2 * n_ghost;
+  Real const d      = 1.0 / n_real;
+  return initial_conditions::GridGeometry{n, n, n, n_ghost, n * n * n, 0, 0, 0, 0, 0, 0, 1, 1, 1, d, d, d};
+}
+
+std::vector<Real> Run_Initial_Conditions(initial_conditions::GridGeometry const &grid, Parameters const &P,
+                                         Real const gamma)
+{
+  size_t const n_values = static_cast<size_t>(grid_enum::num_fields) * grid.n_cells;
+  cuda_utilities::DeviceVector<Real> dev_conserved(n_values);
+  dev_conserved.cpyHostToDevice(std::vector<Real>(n_values, 0));
+  initial_conditions::Set_Initial_Conditions_GPU(grid, P, gamma, dev_conserved.data());
+  std::vector<Real> conserved(n_values);
+  dev_conserved.cpyDeviceToHost(conserved);
+  return conserved;
+}
+}  // namespace
+
+TEST(tALLDeviceInitialConditions, SetupNamesExpectOnlyPortedSetups)
+{
+  EXPECT_TRUE(initial_conditions::Has_Device_Initial_Conditions("Riemann"));
+  EXPECT_TRUE(initial_conditions::Has_Device_Initial_Conditions("Clouds"));
+  EXPECT_FALSE(initial_conditions::Has_Device_Initial_Conditions("Disk_3D"));
+  EXPECT_FALSE(initial_conditions::Has_Device_Initial_Conditions("Read_Grid"));
+}
+
+TEST(tALLDeviceInitialConditions, RiemannExpectCorrectStates)
+{
+  Parameters P;
+  strncpy(P.init, "Riemann", MAXLEN);
+  P.rho_l = 1.0, P.vx_l = 0.5, P.P_l = 1.0;
+  P.rho_r = 0.125, P.vx_r = 0.0, P.P_r = 0.1;
+  P.diaph          = 0.5;
+  Real const gamma = 1.4;
+
+  initial_conditions::GridGeometry const grid = Test_Grid();
+  std::vector<Real> const conserved           = Run_Initial_Conditions(grid, P, gamma);
+
+  for (int k = 0; k < grid.nz; k++) {
+    for (int j = 0; j < grid.ny; j++) {
+      for (int i = 0; i < grid.nx; i++) {
+        int const id    = i + (j + k * grid.ny) * grid.nx;
+        bool const real = i >= grid.n_ghost and i < grid.nx - grid.n_ghost and j >= grid.n_ghost and
+                          j < grid.ny - grid.n_ghost and k >= grid.n_ghost and k < grid.nz - grid.n_ghost;
+        Real x, y, z;
+        grid.Position(i, j, k, x, y, z);
+        bool const left = x < P.diaph;
+
+        Real const density  = real ? (left ? P.rho_l : P.rho_r) : 0;
+        Real const momentum = real ? (left ? P.rho_l * P.vx_l : 0) : 0;
+        Real const energy   =
+            real ? (left ? hydro_utilities::Calc_Energy_Primitive(P.P_l, P.rho_l, P.vx_l, 0, 0, gamma)
+                         : hydro_utilities::Calc_Energy_Primitive(P.P_r, P.rho_r, 0, 0, 0, gamma))
+                 : 0;
+        testing_utilities::Check_Results(density, conserved[id + grid_enum::density * grid.n_cells], "density");
+        testing_utilities::Check_Results(momentum, conserved[id + grid_enum::momentum_x * grid.n_cells],
+                                         "momentum_x");
+        testing_utilities::Check_Results(energy, conserved[id + grid_enum::Energy * grid.n_cells], "energy");
+      }
+    }
+  }
+}
+
+TEST(tALLDeviceInitialConditions, KHExpectShearLayers)
+{
+  Parameters P;
+  strncpy(P.init, "KH", MAXLEN);
+  initial_conditions::GridGeometry const grid = Test_Grid();
+  std::vector<Real> const conserved           = Run_Initial_Conditions(grid, P, 1.4);
+
+  int const i = grid.n_ghost, k = grid.n_ghost;
+  for (int j = grid.n_ghost; j < grid.ny - grid.n_ghost; j++) {
+    int const id = i + (j + k * grid.ny) * grid.nx;
+    Real x, y, z;
+    grid.Position(i, j, k, x, y, z);
+    Real const fiducial_density  = (y <= 0.25 or y >= 0.75) ? 1.0 : 2.0;
+    Real const fiducial_momentum = (y <= 0.25 or y >= 0.75) ? -0.5 : 1.0;
+    testing_utilities::Check_Results(fiducial_density, conserved[id + grid_enum::density * grid.n_cells], "density");
+    testing_utilities::Check_Results(fiducial_momentum, conserved[id + grid_enum::momentum_x * grid.n_cells],
+                                     "momentum_x");
+  }
+}
+#endif  // DEVICE_INITIAL_CONDITIONS
@@ -0,0 +1,421 @@
+/*! \file local_timesteps.cu
+ *  \brief Definitions of the local timesteps. */
+
+#ifdef LOCAL_TIMESTEPS
+
+  #include <math.h>
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../grid/grid3D.h"
+  #include "../grid/local_timesteps.h"
+  #include "../io/io.h"
+  #include "../mpi/mpi_routines.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/timestep_constraints.h"
+
+namespace local_timesteps
+{
+namespace
+{
+// The boxes of Copy_Boxes and Interpolate_Boxes, passed to the kernels by
+// value
+struct Box_List {
+  Box boxes[6];
+  int n_boxes;
+  int size;
+};
+
+Box_List Make_Box_List(Box const *boxes, int n_boxes)
+{
+  CHOLLA_ASSERT(n_boxes <= 6, "At most 6 boxes can be copied at once, not %d", n_boxes);
+  Box_List list;
+  list.n_boxes = n_boxes;
+  list.size    = 0;
+  for (int b = 0; b < n_boxes; b++) {
+    list.boxes[b] = boxes[b];
+    list.size += boxes[b].Size();
+  }
+  return list;
+}
+
+// The index in the grid of element tid of the boxes of a list
+__device__ int Box_Cell(Box_List const &list, int tid, int nx, int ny)
+{
+  int b = 0;
+  while (tid >= list.boxes[b].Size()) {
+    tid -= list.boxes[b].Size();
+    b++;
+  }
+  Box const &box = list.boxes[b];
+  int i, j, k;
+  cuda_utilities::compute3DIndices(tid, box.nx, box.ny, i, j, k);
+  return cuda_utilities::compute1DIndex(box.x + i, box.y + j, box.z + k, nx, ny);
+}
+
+__global__ void Copy_Boxes_Kernel(Real *grid, int nx, int ny, int n_cells, int n_fields, Box_List list, Real *box_data,
+                                  bool to_grid)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= list.size) {
+    return;
+  }
+
+  int const id = Box_Cell(list, tid, nx, ny);
+  for (int field = 0; field < n_fields; field++) {
+    if (to_grid) {
+      grid[field * n_cells + id] = box_data[field * list.size + tid];
+    } else {
+      box_data[field * list.size + tid] = grid[field * n_cells + id];
+    }
+  }
+}
+
+__global__ void Interpolate_Boxes_Kernel(Real const *box_old, Real const *box_new, Real weight, Real *grid, int nx,
+                                         int ny, int n_cells, int n_fields, Box_List list)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= list.size) {
+    return;
+  }
+
+  int const id = Box_Cell(list, tid, nx, ny);
+  for (int field = 0; field < n_fields; field++) {
+    int const b                = field * list.size + tid;
+    grid[field * n_cells + id] = (1 - weight) * box_old[b] + weight * box_new[b];
+  }
+}
+
+// A face of the register: the axis it is normal to, whether it is the high
+// face, the index of its first value and its number of values per field
+struct Face {
+  int index;
+  int axis;
+  bool high;
+  int first, size;
+  int n_a;  // the number of values along the first transverse axis
+};
+
+// Find the face of element tid of the faces of a register, and the index of
+// the element in the face
+__device__ Face Find_Face(int tid, Box real, int n_fields, int &element)
+{
+  int const sizes[3] = {real.ny * real.nz, real.nx * real.nz, real.nx * real.ny};
+  int const n_a[3]   = {real.ny, real.nx, real.nx};
+  int first          = 0;
+  for (int face = 0; face < 6; face++) {
+    int const size = sizes[face / 2];
+    if (tid < size) {
+      element = tid;
+      return Face{face, face / 2, face % 2 == 1, first, size, n_a[face / 2]};
+    }
+    tid -= size;
+    first += n_fields * size;
+  }
+  element = -1;
+  return Face{};
+}
+
+// The index of the real cell along a face of the register, or of the cell
+// before it with outside
+__device__ int Face_Cell(Face const &face, int element, Box real, int nx, int ny, bool outside)
+{
+  int const a         = element % face.n_a;
+  int const b         = element / face.n_a;
+  int const starts[3] = {real.x, real.y, real.z};
+  int const sizes[3]  = {real.nx, real.ny, real.nz};
+  int normal          = face.high ? starts[face.axis] + sizes[face.axis] - 1 : starts[face.axis];
+  if (outside and not face.high) {
+    normal--;
+  }
+  if (face.axis == 0) {
+    return cuda_utilities::compute1DIndex(normal, real.y + a, real.z + b, nx, ny);
+  } else if (face.axis == 1) {
+    return cuda_utilities::compute1DIndex(real.x + a, normal, real.z + b, nx, ny);
+  }
+  return cuda_utilities::compute1DIndex(real.x + a, real.y + b, normal, nx, ny);
+}
+
+__global__ void Add_Face_Fluxes_Kernel(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells,
+                                       int n_fields, Box real, Real scale, Real *flux_register)
+{
+  int const n_elements = 2 * (real.ny * real.nz + real.nx * real.nz + real.nx * real.ny);
+  int const tid        = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_elements) {
+    return;
+  }
+
+  int element;
+  Face const face = Find_Face(tid, real, n_fields, element);
+  // The fluxes of a cell are the ones of its right face, so the low faces are
+  // the ones of the ghost cells before the real cells
+  int const id  = Face_Cell(face, element, real, nx, ny, true);
+  Real const *F = (face.axis == 0) ? F_x : ((face.axis == 1) ? F_y : F_z);
+
+  for (int field = 0; field < n_fields; field++) {
+    flux_register[face.first + field * face.size + element] += scale * F[field * n_cells + id];
+  }
+}
+
+__global__ void Reflux_Kernel(Real const *flux_register, Real const *neighbor_register, int correct, Real *grid, int nx,
+                              int ny, int n_cells, int n_fields, Box real, Real dx, Real dy, Real dz)
+{
+  int const n_elements = 2 * (real.ny * real.nz + real.nx * real.nz + real.nx * real.ny);
+  int const tid        = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_elements) {
+    return;
+  }
+
+  int element;
+  Face const face = Find_Face(tid, real, n_fields, element);
+  if (((correct >> face.index) & 1) == 0) {
+    return;
+  }
+
+  // The flux through a low face was added to the cell after it and the flux
+  // through a high face subtracted from the cell before it
+  Real const widths[3] = {dx, dy, dz};
+  Real const sign      = face.high ? -1 : 1;
+  int const id         = Face_Cell(face, element, real, nx, ny, false);
+  for (int field = 0; field < n_fields; field++) {
+    int const r = face.first + field * face.size + element;
+    grid[field * n_cells + id] += sign * (neighbor_register[r] - flux_register[r]) / widths[face.axis];
+  }
+}
+}  // namespace
+
+int Level(Real dt, Real max_dti, int n_levels)
+{
+  int level = 0;
+  while (level < n_levels - 1 and dt * max_dti > C_cfl * (1 << level)) {
+    level++;
+  }
+  return level;
+}
+
+void Copy_Boxes(Real *grid, int nx, int ny, int n_cells, int n_fields, Box const *boxes, int n_boxes, Real *box_data,
+                bool to_grid)
+{
+  Box_List const list = Make_Box_List(boxes, n_boxes);
+  dim3 dim1dGrid((list.size + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Copy_Boxes_Kernel, dim1dGrid, dim1dBlock, 0, 0, grid, nx, ny, n_cells, n_fields, list, box_data,
+                     to_grid);
+  GPU_Error_Check();
+}
+
+void Interpolate_Boxes(Real const *box_old, Real const *box_new, Real weight, Real *grid, int nx, int ny, int n_cells,
+                       int n_fields, Box const *boxes, int n_boxes)
+{
+  Box_List const list = Make_Box_List(boxes, n_boxes);
+  dim3 dim1dGrid((list.size + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Interpolate_Boxes_Kernel, dim1dGrid, dim1dBlock, 0, 0, box_old, box_new, weight, grid, nx, ny,
+                     n_cells, n_fields, list);
+  GPU_Error_Check();
+}
+
+int Flux_Register_Size(Box real, int n_fields)
+{
+  return 2 * n_fields * (real.ny * real.nz + real.nx * real.nz + real.nx * real.ny);
+}
+
+void Add_Face_Fluxes(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells, int n_fields,
+                     Box real, Real scale, Real *flux_register)
+{
+  int const n_threads = Flux_Register_Size(real, n_fields) / n_fields;
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Add_Face_Fluxes_Kernel, dim1dGrid, dim1dBlock, 0, 0, F_x, F_y, F_z, nx, ny, n_cells, n_fields,
+                     real, scale, flux_register);
+  GPU_Error_Check();
+}
+
+void Reflux(Real const *flux_register, Real const *neighbor_register, int correct, Real *grid, int nx, int ny,
+            int n_cells, int n_fields, Box real, Real dx, Real dy, Real dz)
+{
+  int const n_threads = Flux_Register_Size(real, n_fields) / n_fields;
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Reflux_Kernel, dim1dGrid, dim1dBlock, 0, 0, flux_register, neighbor_register, correct, grid, nx,
+                     ny, n_cells, n_fields, real, dx, dy, dz);
+  GPU_Error_Check();
+}
+}  // namespace local_timesteps
+
+LocalTimesteps::LocalTimesteps(Grid3D &grid, struct Parameters const &P) : grid(grid)
+{
+  n_levels = P.local_time_levels;
+  CHOLLA_ASSERT(n_levels >= 1 and n_levels <= LOCAL_TIMESTEPS_MAX_LEVELS,
+                "local_time_levels has to be between 1 and %d, it is %d", LOCAL_TIMESTEPS_MAX_LEVELS, n_levels);
+  CHOLLA_ASSERT(grid.H.nx > 1 and grid.H.ny > 1 and grid.H.nz > 1, "The local timesteps need a 3D grid");
+  CHOLLA_ASSERT(P.n_vl_slabs == 1, "The local timesteps need the fluxes of the whole grid, n_vl_slabs must be 1");
+
+  max_dti       = 0;
+  local_max_dti = 0;
+  level         = 0;
+  finest_level  = 0;
+
+  // Only the neighbors across the MPI boundaries can be on another level
+  int const flags[6] = {P.xl_bcnd, P.xu_bcnd, P.yl_bcnd, P.yu_bcnd, P.zl_bcnd, P.zu_bcnd};
+  for (int face = 0; face < 6; face++) {
+    neighbors[face]       = (flags[face] == 5) ? dest[face] : -1;
+    neighbor_levels[face] = 0;
+  }
+
+  int const n_ghost = grid.H.n_ghost;
+  int const nx      = grid.H.nx_real;
+  int const ny      = grid.H.ny_real;
+  int const nz      = grid.H.nz_real;
+  real              = {n_ghost, n_ghost, n_ghost, nx, ny, nz};
+  // The last n_ghost real cells along an axis of n real cells start at n
+  slabs[0] = {n_ghost, n_ghost, n_ghost, n_ghost, ny, nz};
+  slabs[1] = {nx, n_ghost, n_ghost, n_ghost, ny, nz};
+  slabs[2] = {n_ghost, n_ghost, n_ghost, nx, n_ghost, nz};
+  slabs[3] = {n_ghost, ny, n_ghost, nx, n_ghost, nz};
+  slabs[4] = {n_ghost, n_ghost, n_ghost, nx, ny, n_ghost};
+  slabs[5] = {n_ghost, n_ghost, nz, nx, ny, n_ghost};
+
+  int slabs_size = 0;
+  for (int face = 0; face < 6; face++) {
+    slabs_size += slabs[face].Size();
+  }
+  register_size = local_timesteps::Flux_Register_Size(real, grid.H.n_fields);
+  {
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::hydro);
+    cuda_utilities::Pool_Malloc(&slabs_old, grid.H.n_fields * slabs_size * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&slabs_new, grid.H.n_fields * slabs_size * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&flux_register, register_size * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&neighbor_register, register_size * sizeof(Real));
+  }
+  GPU_Error_Check(cudaMallocHost(&host_register, register_size * sizeof(Real)));
+  GPU_Error_Check(cudaMallocHost(&host_neighbor_register, register_size * sizeof(Real)));
+
+  chprintf("Local timesteps: %d levels ( up to %d substeps per step )\n", n_levels, 1 << (n_levels - 1));
+}
+
+LocalTimesteps::~LocalTimesteps()
+{
+  cuda_utilities::Pool_Free(slabs_old);
+  cuda_utilities::Pool_Free(slabs_new);
+  cuda_utilities::Pool_Free(flux_register);
+  cuda_utilities::Pool_Free(neighbor_register);
+  GPU_Error_Check(cudaFreeHost(host_register));
+  GPU_Error_Check(cudaFreeHost(host_neighbor_register));
+}
+
+Real LocalTimesteps::Step(Real const *max_dtis, Real const *local_max_dtis)
+{
+  max_dti       = max_dtis[timestep_constraints::hydro];
+  local_max_dti = local_max_dtis[timestep_constraints::hydro];
+  return fmin(C_cfl * max_dtis[timestep_constraints::hydro_rank_dt], (1 << (n_levels - 1)) * C_cfl / max_dti);
+}
+
+void LocalTimesteps::Advance(struct Parameters &P)
+{
+  int const n_fields = grid.H.n_fields;
+  Real const t_start = grid.H.t;
+  Real const dt      = grid.H.dt;
+
+  // The step may have been shortened to reach an output, which can only lower
+  // the levels. The finest level is the same on every rank
+  level        = local_timesteps::Level(dt, local_max_dti, n_levels);
+  finest_level = local_timesteps::Level(dt, max_dti, n_levels);
+  if (finest_level == 0) {
+    grid.Update_Hydro_Grid(&P);
+    return;
+  }
+
+  int const n_ticks     = 1 << finest_level;
+  int const substep     = 1 << (finest_level - level);
+  Real const substep_dt = dt * substep / n_ticks;
+  GPU_Error_Check(cudaMemset(flux_register, 0, register_size * sizeof(Real)));
+
+  for (int tick = 0; tick < n_ticks; tick++) {
+    int const phase = tick % substep;
+
+    // The boundaries at the start of the step were exchanged at the end of the
+    // last one. Between two of its substeps a rank sends the interpolation of
+    // the state at their ends, and gets its own state back after the exchange
+    if (tick > 0) {
+      grid.H.t = t_start + dt * tick / n_ticks;
+      if (phase > 0) {
+        local_timesteps::Interpolate_Boxes(slabs_old, slabs_new, Real(phase) / substep, grid.C.device, grid.H.nx,
+                                           grid.H.ny, grid.H.n_cells, n_fields, slabs, 6);
+      }
+      grid.Set_Boundary_Conditions_Grid(P);
+      if (phase > 0) {
+        local_timesteps::Copy_Boxes(grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, slabs, 6, slabs_new,
+                                    true);
+      }
+    }
+    if (phase > 0) {
+      continue;
+    }
+
+    if (substep > 1) {
+      local_timesteps::Copy_Boxes(grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, slabs, 6, slabs_old,
+                                  false);
+    }
+    grid.H.t  = t_start + dt * tick / n_ticks;
+    grid.H.dt = substep_dt;
+    grid.Update_Hydro_Grid(&P);
+    local_timesteps::Add_Face_Fluxes(F_x, F_y, F_z, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, real, substep_dt,
+                                     flux_register);
+    if (substep > 1) {
+      local_timesteps::Copy_Boxes(grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, slabs, 6, slabs_new,
+                                  false);
+    }
+  }
+  grid.H.t  = t_start;
+  grid.H.dt = dt;
+
+  // The faces with a finer neighbor get its fluxes, and the inverse timestep
+  // is reduced again from the corrected cells
+  Exchange_Fluxes();
+  int correct = 0;
+  for (int face = 0; face < 6; face++) {
+    if (neighbors[face] >= 0 and neighbor_levels[face] > level) {
+      correct |= 1 << face;
+    }
+  }
+  if (correct != 0) {
+    local_timesteps::Reflux(flux_register, neighbor_register, correct, grid.C.device, grid.H.nx, grid.H.ny,
+                            grid.H.n_cells, n_fields, real, grid.H.dx, grid.H.dy, grid.H.dz);
+    grid.Calc_Inverse_Timestep();
+  }
+}
+
+void LocalTimesteps::Exchange_Fluxes()
+{
+  GPU_Error_Check(cudaMemcpy(host_register, flux_register, register_size * sizeof(Real), cudaMemcpyDeviceToHost));
+
+  // Each face is contiguous in the register, and the neighbor across face f
+  // sends its opposite face f ^ 1 with the tag of that face
+  int const face_sizes[3] = {real.ny * real.nz, real.nx * real.nz, real.nx * real.ny};
+  MPI_Request requests[24];
+  int n_requests = 0;
+  int first      = 0;
+  for (int face = 0; face < 6; face++) {
+    int const count = grid.H.n_fields * face_sizes[face / 2];
+    if (neighbors[face] >= 0) {
+      MPI_Irecv(host_neighbor_register + first, count, MPI_CHREAL, neighbors[face], face ^ 1, world,
+                &requests[n_requests++]);
+      MPI_Irecv(&neighbor_levels[face], 1, MPI_INT, neighbors[face], 6 + (face ^ 1), world, &requests[n_requests++]);
+      MPI_Isend(host_register + first, count, MPI_CHREAL, neighbors[face], face, world, &requests[n_requests++]);
+      MPI_Isend(&level, 1, MPI_INT, neighbors[face], 6 + face, world, &requests[n_requests++]);
+    }
+    first += count;
+  }
+  MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+
+  GPU_Error_Check(cudaMemcpy(neighbor_register, host_neighbor_register, register_size * sizeof(Real),
+                             cudaMemcpyHostToDevice));
+}
+
+void Grid3D::Initialize_Local_Timesteps(struct Parameters *P) { local_timesteps = new LocalTimesteps(*this, *P); }
+
+#endif  // LOCAL_TIMESTEPS
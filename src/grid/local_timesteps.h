@@ -0,0 +1,202 @@
+/*! \file local_timesteps.h
+ *  \brief Declarations of the local timesteps. Every rank takes the substeps
+ *  of its own level within the global step, 2^level substeps of dt / 2^level,
+ *  so the subdomains with a long allowed timestep take fewer steps than the
+ *  few with fast cells. The boundaries are exchanged at every substep of the
+ *  finest level, with the ranks between two of their own substeps sending the
+ *  state interpolated in time. At the end of the step the fluxes through the
+ *  faces of the subdomains are exchanged, and the coarser side of every face
+ *  is corrected with the fluxes of the finer one (Berger & Colella 1989). */
+
+#pragma once
+
+#ifdef LOCAL_TIMESTEPS
+
+  #if !defined(MPI_CHOLLA) || !defined(VL) || defined(MHD) || defined(GRAVITY) || defined(PARTICLES) || \
+      defined(STATIC_REFINEMENT) || defined(LAGGED_DT) || defined(VL_OVERLAP)
+    #error \
+        "LOCAL_TIMESTEPS only supports VL hydro with MPI_CHOLLA, without MHD, gravity, particles, STATIC_REFINEMENT, LAGGED_DT or VL_OVERLAP"
+  #endif  // not MPI_CHOLLA || not VL || MHD || GRAVITY || PARTICLES || STATIC_REFINEMENT || LAGGED_DT || VL_OVERLAP
+
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+
+/// The largest number of levels, up to 2^(LOCAL_TIMESTEPS_MAX_LEVELS - 1)
+/// substeps per step
+  #define LOCAL_TIMESTEPS_MAX_LEVELS 8
+
+namespace local_timesteps
+{
+/*!
+ * \brief A box of cells of a grid: the index of its first cell, ghost cells
+ * included, and its number of cells along each axis
+ */
+struct Box {
+  int x, y, z;
+  int nx, ny, nz;
+
+  __host__ __device__ int Size() const { return nx * ny * nz; }
+};
+
+/*!
+ * \brief The level of a timestep: the smallest level whose substeps, of
+ * dt / 2^level, are not longer than C_cfl / max_dti
+ *
+ * \param[in] dt The step
+ * \param[in] max_dti The maximum inverse timestep
+ * \param[in] n_levels The number of levels
+ * \return int The level, at most n_levels - 1
+ */
+int Level(Real dt, Real max_dti, int n_levels);
+
+/*!
+ * \brief Copy the fields of a list of boxes of a grid to a contiguous array,
+ * or back from it to the grid. The boxes follow each other in the array
+ *
+ * \param[in,out] grid The conserved variables of the grid
+ * \param[in] nx The number of cells of the grid in the X-direction
+ * \param[in] ny The number of cells of the grid in the Y-direction
+ * \param[in] n_cells The number of cells of the grid
+ * \param[in] n_fields The number of fields
+ * \param[in] boxes The boxes
+ * \param[in] n_boxes The number of boxes, at most 6
+ * \param[in,out] box_data The n_fields values of every cell of the boxes
+ * \param[in] to_grid Copy box_data to the grid instead
+ */
+void Copy_Boxes(Real *grid, int nx, int ny, int n_cells, int n_fields, Box const *boxes, int n_boxes, Real *box_data,
+                bool to_grid);
+
+/*!
+ * \brief Set the cells of a list of boxes of a grid to the interpolation in
+ * time between two copies of them from Copy_Boxes
+ *
+ * \param[in] box_old The boxes at the start of the substep
+ * \param[in] box_new The boxes at the end of the substep
+ * \param[in] weight The weight of box_new, between 0 and 1
+ * \param[out] grid The conserved variables of the grid
+ * \param[in] nx The number of cells of the grid in the X-direction
+ * \param[in] ny The number of cells of the grid in the Y-direction
+ * \param[in] n_cells The number of cells of the grid
+ * \param[in] n_fields The number of fields
+ * \param[in] boxes The boxes
+ * \param[in] n_boxes The number of boxes, at most 6
+ */
+void Interpolate_Boxes(Real const *box_old, Real const *box_new, Real weight, Real *grid, int nx, int ny, int n_cells,
+                       int n_fields, Box const *boxes, int n_boxes);
+
+/*!
+ * \brief The number of values of a flux register of the 6 faces of the real
+ * cells of a grid, the first n_fields * ny * nz for the low X face
+ */
+int Flux_Register_Size(Box real, int n_fields);
+
+/*!
+ * \brief Add scale times the fluxes of the integrator through the faces of
+ * the real cells of a grid to a flux register. The fluxes are the ones of the
+ * right face of every cell, like the integrator stores them
+ *
+ * \param[in] F_x The X-fluxes
+ * \param[in] F_y The Y-fluxes
+ * \param[in] F_z The Z-fluxes
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] n_cells The number of cells
+ * \param[in] n_fields The number of fields
+ * \param[in] real The box of the real cells
+ * \param[in] scale The factor of the fluxes
+ * \param[in,out] flux_register The register of the faces
+ */
+void Add_Face_Fluxes(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells, int n_fields,
+                     Box real, Real scale, Real *flux_register);
+
+/*!
+ * \brief Correct the real cells along the faces of a grid whose neighbor is
+ * finer, so the time integral of the fluxes through those faces is the one of
+ * the neighbor
+ *
+ * \param[in] flux_register The register of Add_Face_Fluxes of the grid
+ * \param[in] neighbor_register The register of the neighbors, each face the
+ * one of the neighbor across it
+ * \param[in] correct The faces to correct, a bit per face in the order of the
+ * register
+ * \param[in,out] grid The conserved variables of the grid
+ * \param[in] nx The number of cells of the grid in the X-direction
+ * \param[in] ny The number of cells of the grid in the Y-direction
+ * \param[in] n_cells The number of cells of the grid
+ * \param[in] n_fields The number of fields
+ * \param[in] real The box of the real cells
+ * \param[in] dx The cell size of the grid in the X-direction
+ * \param[in] dy The cell size of the grid in the Y-direction
+ * \param[in] dz The cell size of the grid in the Z-direction
+ */
+void Reflux(Real const *flux_register, Real const *neighbor_register, int correct, Real *grid, int nx, int ny,
+            int n_cells, int n_fields, Box real, Real dx, Real dy, Real dz);
+}  // namespace local_timesteps
+
+/*! \class LocalTimesteps
+ *  \brief The local timesteps of a grid, owned by Grid3D::local_timesteps.
+ *  The level of the rank is set from the inverse timesteps of set_dt, and
+ *  Advance takes the substeps of the step in place of Update_Hydro_Grid. */
+class LocalTimesteps
+{
+ public:
+  /*! \fn LocalTimesteps(Grid3D &grid, struct Parameters const &P)
+   *  \brief Set up the local timesteps of the local_time_levels parameter */
+  LocalTimesteps(Grid3D &grid, struct Parameters const &P);
+
+  /*! \fn ~LocalTimesteps()
+   *  \brief Free the buffers of the local timesteps */
+  ~LocalTimesteps();
+
+  /*! \fn Real Step(Real const *max_dtis, Real const *local_max_dtis)
+   *  \brief The global step for the reduced and the local inverse timesteps
+   * of timestep_constraints::Reduce: the longest timestep of a rank, but at
+   * most 2^(levels - 1) times the shortest one */
+  Real Step(Real const *max_dtis, Real const *local_max_dtis);
+
+  /*! \fn void Advance(struct Parameters &P)
+   *  \brief Take the substeps of the rank for the step grid.H.dt, with the
+   * boundaries exchanged between the substeps of the finest level, and
+   * correct the faces with the finer neighbors */
+  void Advance(struct Parameters &P);
+
+ private:
+  /*! \fn void Exchange_Fluxes()
+   *  \brief Send the flux register and the level to the neighbors across
+   * the MPI boundaries, and receive theirs */
+  void Exchange_Fluxes();
+
+  Grid3D &grid;
+  int n_levels;
+
+  // The inverse timesteps of the last set_dt, over all the ranks and local
+  Real max_dti, local_max_dti;
+
+  // The level of the rank and of the finest rank in the last step
+  int level, finest_level;
+
+  // The neighbor across every face, -1 across the physical and the periodic
+  // boundaries that stay on this rank
+  int neighbors[6];
+
+  // The real cells, and the n_ghost thick boxes inside each of their faces
+  // that the neighbors receive
+  local_timesteps::Box real;
+  local_timesteps::Box slabs[6];
+
+  // The slabs at the start and at the end of the substep of the rank, and the
+  // flux registers of the rank and of its neighbors, on the device
+  Real *slabs_old;
+  Real *slabs_new;
+  Real *flux_register;
+  Real *neighbor_register;
+  int register_size;
+
+  // The registers in host memory for the MPI exchange, and the levels of the
+  // neighbors in the last step
+  Real *host_register;
+  Real *host_neighbor_register;
+  int neighbor_levels[6];
+};
+
+#endif  // LOCAL_TIMESTEPS
@@ -4,8 +4,11 @@
 #include "../grid/cuda_boundaries.h"  // provides PackBuffers3D and UnpackBuffers3D
 #include "../io/io.h"
 #include "../mpi/mpi_routines.h"
+#include "../mpi/nvshmem_boundaries.h"
+#include "../utils/device_memory_pool.h"
 #include "../utils/error_handling.h"
 #include "../utils/gpu.hpp"
+#include "../utils/profiling_ranges.h"
 #include "grid3D.h"
 
 #ifdef MPI_CHOLLA
@@ -19,7 +22,11 @@ void Grid3D::Set_Boundaries_MPI(struct Parameters P)
     Custom_Boundary(P.custom_bcnd);
   }
 
-  Set_Boundaries_MPI_BLOCK(flags, P);
+  if (H.TRANSFER_HYDRO_BOUNDARIES && P.mpi_26_neighbors && Check_MPI_26_Neighbors(flags)) {
+    Set_Hydro_Boundaries_MPI_26();
+  } else {
+    Set_Boundaries_MPI_BLOCK(flags, P);
+  }
 
   #ifdef GRAVITY
   Grav.Set_Boundary_Flags(flags);
@@ -27,6 +34,14 @@ void Grid3D::Set_Boundaries_MPI(struct Parameters P)
 }
 
 void Grid3D::Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
+{
+  profiling::ScopedRange const range("Set_Boundaries_MPI_BLOCK");
+
+  Start_Boundaries_MPI_BLOCK(flags);
+  Finish_Boundaries_MPI_BLOCK(flags, P);
+}
+
+void Grid3D::Start_Boundaries_MPI_BLOCK(int *flags)
 {
   #ifdef PARTICLES
   // Clear the vectors that contain the particles IDs to be transfred
@@ -41,7 +56,24 @@ void Grid3D::Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
     if (flags[0] == 5 || flags[1] == 5) {
       Load_and_Send_MPI_Comm_Buffers(0, flags);
     }
+  }
+}
+
+void Grid3D::Finish_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
+{
+  // Each direction completes its sends and receives before the next one
+  // starts, so the ranks only have to synchronize with their neighbors. The
+  // particle sends are freed instead of completed, so their buffers are only
+  // safe to reuse after a global barrier
+  bool global_barrier = P.mpi_global_barrier;
+
+  #ifdef PARTICLES
+  if (Particles.TRANSFER_PARTICLES_BOUNDARIES) {
+    global_barrier = true;
+  }
+  #endif
 
+  if (H.nx > 1) {
     /* Step 2 - Set non-MPI x-boundaries */
     Set_Boundaries(0, flags);
     Set_Boundaries(1, flags);
@@ -58,7 +90,9 @@ void Grid3D::Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
   #endif
     }
   }
-  MPI_Barrier(world);
+  if (global_barrier) {
+    MPI_Barrier(world);
+  }
   if (H.ny > 1) {
     /* Step 4 - Send MPI y-boundaries */
     if (flags[2] == 5 || flags[3] == 5) {
@@ -80,7 +114,9 @@ void Grid3D::Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
   #endif
     }
   }
-  MPI_Barrier(world);
+  if (global_barrier) {
+    MPI_Barrier(world);
+  }
   if (H.nz > 1) {
     /* Step 7 - Send MPI z-boundaries */
     if (flags[4] == 5 || flags[5] == 5) {
@@ -110,191 +146,382 @@ void Grid3D::Set_Boundaries_MPI_BLOCK(int *flags, struct Parameters P)
   #endif
 }
 
+bool Grid3D::Check_MPI_26_Neighbors(int *flags)
+{
+  // Every ghost cell has to be a copy of a real cell of some rank, which holds
+  // when each face is either an MPI boundary or periodic with a single rank
+  // in that direction, in which case this rank is its own neighbor
+  int const nproc[3] = {nproc_x, nproc_y, nproc_z};
+  if (H.ny == 1 || H.nz == 1) {
+    return false;
+  }
+  for (int face = 0; face < 6; face++) {
+    if (flags[face] != 5 && !(flags[face] == 1 && nproc[face / 2] == 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Grid3D::Set_Hydro_Boundaries_MPI_26()
+{
+  profiling::ScopedRange const range("Set_Hydro_Boundaries_MPI_26");
+
+  int const ng = H.n_ghost;
+  int const n_buffer_cells = H.n_cells - (H.nx - 2 * ng) * (H.ny - 2 * ng) * (H.nz - 2 * ng);
+  size_t const buffer_size = size_t(H.n_fields) * n_buffer_cells * sizeof(Real);
+
+  // Along each direction a box either spans the real cells (offset 0) or is
+  // n_ghost cells wide. The box sent towards offset -1 holds the first real
+  // cells and the box received from it is the lower ghost cells
+  int const n[3] = {H.nx, H.ny, H.nz};
+  auto start = [&](int dim, int offset, bool send) {
+    if (offset == 0) {
+      return ng;
+    }
+    if (send) {
+      return offset < 0 ? ng : n[dim] - 2 * ng;
+    }
+    return offset < 0 ? 0 : n[dim] - ng;
+  };
+  auto size = [&](int dim, int offset) { return offset == 0 ? n[dim] - 2 * ng : ng; };
+
+  BufferBoxes send_boxes, recv_boxes;
+  int neighbor[BufferBoxes::max_boxes], message_size[BufferBoxes::max_boxes], direction[BufferBoxes::max_boxes];
+  int n_boxes = 0, cell_start = 0;
+  for (int dk = -1; dk <= 1; dk++) {
+    for (int dj = -1; dj <= 1; dj++) {
+      for (int di = -1; di <= 1; di++) {
+        int const offset = (di + 1) + 3 * (dj + 1) + 9 * (dk + 1);
+        if (offset == 13) {
+          continue;
+        }
+        BufferBox &send = send_boxes.box[n_boxes];
+        BufferBox &recv = recv_boxes.box[n_boxes];
+
+        send.isize      = recv.isize = size(0, di);
+        send.jsize      = recv.jsize = size(1, dj);
+        send.ksize      = recv.ksize = size(2, dk);
+        send.cell_start = recv.cell_start = cell_start;
+        send.idxoffset  = start(0, di, true) + (start(1, dj, true) + start(2, dk, true) * H.ny) * H.nx;
+        recv.idxoffset  = start(0, di, false) + (start(1, dj, false) + start(2, dk, false) * H.ny) * H.nx;
+
+        neighbor[n_boxes]     = neighbor_rank[offset];
+        message_size[n_boxes] = H.n_fields * send.isize * send.jsize * send.ksize;
+        direction[n_boxes]    = offset;
+        cell_start += send.isize * send.jsize * send.ksize;
+        n_boxes++;
+      }
+    }
+  }
+  send_boxes.n_boxes = recv_boxes.n_boxes = n_boxes;
+  send_boxes.buffer_ncells = recv_boxes.buffer_ncells = cell_start;
+
+  #ifdef NVSHMEM_BOUNDARIES
+  // The pack kernel writes the boxes straight into the receive buffers of the
+  // neighbors, which flip the offsets so box b arrives from box n_boxes - 1 - b
+  Exchange_Boxes_NVSHMEM(C.device, H.nx, H.ny, H.n_fields, H.n_cells, send_boxes, recv_boxes, neighbor,
+                         streams.boundaries);
+  mpi_bytes_sent += buffer_size;
+  return;
+  #endif  // NVSHMEM_BOUNDARIES
+
+  if (d_send_buffer_26 == NULL) {
+    chprintf("Allocating buffers for the 26 neighbor boundary exchange.\n");
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::boundaries);
+    cuda_utilities::Pool_Malloc(&d_send_buffer_26, buffer_size);
+    cuda_utilities::Pool_Malloc(&d_recv_buffer_26, buffer_size);
+    GPU_Error_Check(cudaHostAlloc(&h_send_buffer_26, buffer_size, cudaHostAllocDefault));
+    GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_26, buffer_size, cudaHostAllocDefault));
+  }
+
+  Real *send_buffer = d_send_buffer_26, *recv_buffer = d_recv_buffer_26;
+  PackBoxes3D(d_send_buffer_26, C.device, H.nx, H.ny, H.n_fields, H.n_cells, send_boxes, streams.boundaries);
+  if (not mpi_gpu_direct) {
+    GPU_Error_Check(cudaMemcpy(h_send_buffer_26, d_send_buffer_26, buffer_size, cudaMemcpyDeviceToHost));
+    send_buffer = h_send_buffer_26;
+    recv_buffer = h_recv_buffer_26;
+  }
+
+  // Messages are tagged with the direction they travel in, so the ghost cells
+  // at offset d receive the message sent towards -d. The tags start after the
+  // ones used by Set_Boundaries_MPI_BLOCK
+  int const tag_start = 6;
+  MPI_Request requests[2 * BufferBoxes::max_boxes];
+  for (int b = 0; b < n_boxes; b++) {
+    Real *recv_box = recv_buffer + H.n_fields * recv_boxes.box[b].cell_start;
+    MPI_Irecv(recv_box, message_size[b], MPI_CHREAL, neighbor[b], tag_start + 26 - direction[b], world, &requests[b]);
+  }
+  for (int b = 0; b < n_boxes; b++) {
+    Real *send_box = send_buffer + H.n_fields * send_boxes.box[b].cell_start;
+    MPI_Isend(send_box, message_size[b], MPI_CHREAL, neighbor[b], tag_start + direction[b], world,
+              &requests[n_boxes + b]);
+    mpi_bytes_sent += message_size[b] * sizeof(Real);
+  }
+  double const wait_start = Get_Time();
+  MPI_Waitall(2 * n_boxes, requests, MPI_STATUSES_IGNORE);
+  mpi_wait_time += Get_Time() - wait_start;
+
+  if (not mpi_gpu_direct) {
+    GPU_Error_Check(cudaMemcpy(d_recv_buffer_26, h_recv_buffer_26, buffer_size, cudaMemcpyHostToDevice));
+  }
+  UnpackBoxes3D(d_recv_buffer_26, C.device, H.nx, H.ny, H.n_fields, H.n_cells, recv_boxes, streams.boundaries);
+}
+
+int Grid3D::Hydro_Transfer_Length(int buffer_length)
+{
+  // The full buffers hold H.n_fields fields and H.n_ghost cells per face
+  int const n_fields = (H.transfer_hydro_fields.n_fields > 0) ? H.transfer_hydro_fields.n_fields : H.n_fields;
+  int const n_float  = Halo_Float_Fields(H.n_fields, H.transfer_hydro_fields, H.transfer_hydro_precision);
+  int const n_cells  = buffer_length / (H.n_fields * H.n_ghost) * H.transfer_hydro_n_ghost;
+  if (n_float > 0) {
+    // The packed floats are sent as raw bytes, rounded up to a whole Real
+    size_t const bytes = size_t(n_cells) * ((n_fields - n_float) * sizeof(Real) + n_float * sizeof(float));
+    return (bytes + sizeof(Real) - 1) / sizeof(Real);
+  }
+  return n_cells * n_fields;
+}
+
+int Grid3D::Potential_Buffer_Offset(int direction)
+{
+  // The potential follows the hydro boundaries when they share the message
+  if (!H.TRANSFER_HYDRO_BOUNDARIES) {
+    return 0;
+  }
+  int const length[3] = {x_buffer_length, y_buffer_length, z_buffer_length};
+  return Hydro_Transfer_Length(length[direction]);
+}
+
 int Grid3D::Load_Hydro_DeviceBuffer_X0(Real *send_buffer_x0)
 {
+  // only the ng cells closest to the interior are sent
+  int const ng = H.transfer_hydro_n_ghost;
   // 1D
   if (H.ny == 1 && H.nz == 1) {
     int idxoffset = H.n_ghost;
-    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost, 1, 1);
+    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, 1, 1, streams.boundaries,
+                  H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 2D
   if (H.ny > 1 && H.nz == 1) {
     int idxoffset = H.n_ghost + H.n_ghost * H.nx;
-    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                  H.ny - 2 * H.n_ghost, 1);
+    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost, 1,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.ny > 1 && H.nz > 1) {
     int idxoffset = H.n_ghost + H.n_ghost * H.nx + H.n_ghost * H.nx * H.ny;
-    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                  H.ny - 2 * H.n_ghost, H.nz - 2 * H.n_ghost);
+    PackBuffers3D(send_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                  H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 
-  return x_buffer_length;
+  return Hydro_Transfer_Length(x_buffer_length);
 }
 
 // load right x communication buffer
 int Grid3D::Load_Hydro_DeviceBuffer_X1(Real *send_buffer_x1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 1D
   if (H.ny == 1 && H.nz == 1) {
-    int idxoffset = H.nx - 2 * H.n_ghost;
-    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost, 1, 1);
+    int idxoffset = H.nx - H.n_ghost - ng;
+    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, 1, 1, streams.boundaries,
+                  H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 2D
   if (H.ny > 1 && H.nz == 1) {
-    int idxoffset = H.nx - 2 * H.n_ghost + H.n_ghost * H.nx;
-    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                  H.ny - 2 * H.n_ghost, 1);
+    int idxoffset = H.nx - H.n_ghost - ng + H.n_ghost * H.nx;
+    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost, 1,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.ny > 1 && H.nz > 1) {
-    int idxoffset = H.nx - 2 * H.n_ghost + H.n_ghost * H.nx + H.n_ghost * H.nx * H.ny;
-    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                  H.ny - 2 * H.n_ghost, H.nz - 2 * H.n_ghost);
+    int idxoffset = H.nx - H.n_ghost - ng + H.n_ghost * H.nx + H.n_ghost * H.nx * H.ny;
+    PackBuffers3D(send_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                  H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 
-  return x_buffer_length;
+  return Hydro_Transfer_Length(x_buffer_length);
 }
 
 // load left y communication buffer
 int Grid3D::Load_Hydro_DeviceBuffer_Y0(Real *send_buffer_y0)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 2D
   if (H.nz == 1) {
     int idxoffset = H.n_ghost * H.nx;
-    PackBuffers3D(send_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost, 1);
+    PackBuffers3D(send_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng, 1,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
     int idxoffset = H.n_ghost * H.nx + H.n_ghost * H.nx * H.ny;
-    PackBuffers3D(send_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost,
-                  H.nz - 2 * H.n_ghost);
+    PackBuffers3D(send_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng,
+                  H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 
-  return y_buffer_length;
+  return Hydro_Transfer_Length(y_buffer_length);
 }
 
 int Grid3D::Load_Hydro_DeviceBuffer_Y1(Real *send_buffer_y1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 2D
   if (H.nz == 1) {
-    int idxoffset = (H.ny - 2 * H.n_ghost) * H.nx;
-    PackBuffers3D(send_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost, 1);
+    int idxoffset = (H.ny - H.n_ghost - ng) * H.nx;
+    PackBuffers3D(send_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng, 1,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
-    int idxoffset = (H.ny - 2 * H.n_ghost) * H.nx + H.n_ghost * H.nx * H.ny;
-    PackBuffers3D(send_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost,
-                  H.nz - 2 * H.n_ghost);
+    int idxoffset = (H.ny - H.n_ghost - ng) * H.nx + H.n_ghost * H.nx * H.ny;
+    PackBuffers3D(send_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng,
+                  H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 
-  return y_buffer_length;
+  return Hydro_Transfer_Length(y_buffer_length);
 }
 
 // load left z communication buffer
 int Grid3D::Load_Hydro_DeviceBuffer_Z0(Real *send_buffer_z0)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 3D
   int idxoffset = H.n_ghost * H.nx * H.ny;
-  PackBuffers3D(send_buffer_z0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, H.n_ghost);
+  PackBuffers3D(send_buffer_z0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, ng,
+                streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
 
-  return z_buffer_length;
+  return Hydro_Transfer_Length(z_buffer_length);
 }
 
 int Grid3D::Load_Hydro_DeviceBuffer_Z1(Real *send_buffer_z1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 3D
-  int idxoffset = (H.nz - 2 * H.n_ghost) * H.nx * H.ny;
-  PackBuffers3D(send_buffer_z1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, H.n_ghost);
+  int idxoffset = (H.nz - H.n_ghost - ng) * H.nx * H.ny;
+  PackBuffers3D(send_buffer_z1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, ng,
+                streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
 
-  return z_buffer_length;
+  return Hydro_Transfer_Length(z_buffer_length);
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_X0(Real *recv_buffer_x0)
 {
+  // only the ng ghost cells closest to the interior are received
+  int const ng = H.transfer_hydro_n_ghost;
   // 1D
   if (H.ny == 1 && H.nz == 1) {
-    int idxoffset = 0;
-    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost, 1, 1);
+    int idxoffset = H.n_ghost - ng;
+    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, 1, 1,
+                    streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 2D
   if (H.ny > 1 && H.nz == 1) {
-    int idxoffset = H.n_ghost * H.nx;
-    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                    H.ny - 2 * H.n_ghost, 1);
+    int idxoffset = H.n_ghost - ng + H.n_ghost * H.nx;
+    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                    1, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
-    int idxoffset = H.n_ghost * (H.nx + H.nx * H.ny);
-    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                    H.ny - 2 * H.n_ghost, H.nz - 2 * H.n_ghost);
+    int idxoffset = H.n_ghost - ng + H.n_ghost * (H.nx + H.nx * H.ny);
+    UnpackBuffers3D(recv_buffer_x0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                    H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_X1(Real *recv_buffer_x1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 1D
   if (H.ny == 1 && H.nz == 1) {
     int idxoffset = H.nx - H.n_ghost;
-    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost, 1, 1);
+    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, 1, 1,
+                    streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 2D
   if (H.ny > 1 && H.nz == 1) {
     int idxoffset = H.nx - H.n_ghost + H.n_ghost * H.nx;
-    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                    H.ny - 2 * H.n_ghost, 1);
+    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                    1, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
     int idxoffset = H.nx - H.n_ghost + H.n_ghost * (H.nx + H.nx * H.ny);
-    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.n_ghost,
-                    H.ny - 2 * H.n_ghost, H.nz - 2 * H.n_ghost);
+    UnpackBuffers3D(recv_buffer_x1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, ng, H.ny - 2 * H.n_ghost,
+                    H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_Y0(Real *recv_buffer_y0)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 2D
   if (H.nz == 1) {
-    int idxoffset = 0;
-    UnpackBuffers3D(recv_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost, 1);
+    int idxoffset = (H.n_ghost - ng) * H.nx;
+    UnpackBuffers3D(recv_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng, 1,
+                    streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
-    int idxoffset = H.n_ghost * H.nx * H.ny;
-    UnpackBuffers3D(recv_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost,
-                    H.nz - 2 * H.n_ghost);
+    int idxoffset = (H.n_ghost - ng) * H.nx + H.n_ghost * H.nx * H.ny;
+    UnpackBuffers3D(recv_buffer_y0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng,
+                    H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_Y1(Real *recv_buffer_y1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 2D
   if (H.nz == 1) {
     int idxoffset = (H.ny - H.n_ghost) * H.nx;
-    UnpackBuffers3D(recv_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost, 1);
+    UnpackBuffers3D(recv_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng, 1,
+                    streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
   // 3D
   if (H.nz > 1) {
     int idxoffset = (H.ny - H.n_ghost) * H.nx + H.n_ghost * H.nx * H.ny;
-    UnpackBuffers3D(recv_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.n_ghost,
-                    H.nz - 2 * H.n_ghost);
+    UnpackBuffers3D(recv_buffer_y1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, ng,
+                    H.nz - 2 * H.n_ghost, streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
   }
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_Z0(Real *recv_buffer_z0)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 3D
-  int idxoffset = 0;
-  UnpackBuffers3D(recv_buffer_z0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, H.n_ghost);
+  int idxoffset = (H.n_ghost - ng) * H.nx * H.ny;
+  UnpackBuffers3D(recv_buffer_z0, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, ng,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
 }
 
 void Grid3D::Unload_Hydro_DeviceBuffer_Z1(Real *recv_buffer_z1)
 {
+  int const ng = H.transfer_hydro_n_ghost;
   // 3D
   int idxoffset = (H.nz - H.n_ghost) * H.nx * H.ny;
-  UnpackBuffers3D(recv_buffer_z1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, H.n_ghost);
+  UnpackBuffers3D(recv_buffer_z1, C.device, H.nx, H.ny, H.n_fields, H.n_cells, idxoffset, H.nx, H.ny, ng,
+                  streams.boundaries, H.transfer_hydro_fields, H.transfer_hydro_precision);
+}
+
+// Select the buffers a message is sent from and received into. With GPU-aware
+// MPI the device buffers can be sent directly, otherwise the message is staged
+// through the pinned host buffers
+static void Select_MPI_Comm_Buffers(Real *d_send, Real *d_recv, Real *h_send, Real *h_recv, int length, Real *&send,
+                                    Real *&recv)
+{
+  #ifdef MPI_GPU
+  if (mpi_gpu_direct) {
+    send = d_send;
+    recv = d_recv;
+    return;
+  }
+  // With MPI_GPU every buffer is loaded on the device, so copy it to the host
+  GPU_Error_Check(cudaMemcpy(h_send, d_send, length * sizeof(Real), cudaMemcpyDeviceToHost));
+  #endif  // MPI_GPU
+  send = h_send;
+  recv = h_recv;
 }
 
 void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
@@ -313,9 +540,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   int ireq;
   ireq = 0;
 
-  int xbsize = x_buffer_length, ybsize = y_buffer_length, zbsize = z_buffer_length;
+  // Faces without communication leave their send request empty
+  send_request[0] = MPI_REQUEST_NULL;
+  send_request[1] = MPI_REQUEST_NULL;
 
   int buffer_length;
+  Real *send_buffer, *recv_buffer;
 
   // Flag to omit the transfer of the main buffer when tranferring the particles
   // buffer
@@ -328,16 +558,19 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_X0(d_send_buffer_x0);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x0, d_send_buffer_x0, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x0, d_send_buffer_x0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
       }
 
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(0, 0, d_send_buffer_x0, 0);
+        int const potential_offset = Potential_Buffer_Offset(0);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(0, 0, d_send_buffer_x0 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x0, d_send_buffer_x0, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x0 + potential_offset, d_send_buffer_x0 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(0, 0, h_send_buffer_x0, 0);
@@ -354,7 +587,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(0, 0, d_send_buffer_x0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x0, d_send_buffer_x0, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x0, d_send_buffer_x0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -373,19 +606,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
-        // post non-blocking receive left x communication buffer
-        MPI_Irecv(d_recv_buffer_x0, buffer_length, MPI_CHREAL, source[0], 0, world, &recv_request[ireq]);
-
-        // non-blocking send left x communication buffer
-        MPI_Isend(d_send_buffer_x0, buffer_length, MPI_CHREAL, dest[0], 1, world, &send_request[0]);
-  #else
+        Select_MPI_Comm_Buffers(d_send_buffer_x0, d_recv_buffer_x0, h_send_buffer_x0, h_recv_buffer_x0, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive left x communication buffer
-        MPI_Irecv(h_recv_buffer_x0, buffer_length, MPI_CHREAL, source[0], 0, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[0], 0, world, &recv_request[ireq]);
 
         // non-blocking send left x communication buffer
-        MPI_Isend(h_send_buffer_x0, buffer_length, MPI_CHREAL, dest[0], 1, world, &send_request[0]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[0], 1, world, &send_request[0]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
         MPI_Request_free(send_request);
 
         // keep track of how many sends and receives are expected
@@ -398,7 +626,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_X1(d_send_buffer_x1);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x1, d_send_buffer_x1, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x1, d_send_buffer_x1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
         // printf("X1 len: %d\n", buffer_length);
       }
@@ -406,9 +634,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(0, 1, d_send_buffer_x1, 0);
+        int const potential_offset = Potential_Buffer_Offset(0);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(0, 1, d_send_buffer_x1 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x1, d_send_buffer_x1, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x1 + potential_offset, d_send_buffer_x1 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(0, 1, h_send_buffer_x1, 0);
@@ -425,7 +656,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(0, 1, d_send_buffer_x1);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_x1, d_send_buffer_x1, xbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_x1, d_send_buffer_x1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -444,19 +675,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
-        // post non-blocking receive right x communication buffer
-        MPI_Irecv(d_recv_buffer_x1, buffer_length, MPI_CHREAL, source[1], 1, world, &recv_request[ireq]);
-
-        // non-blocking send right x communication buffer
-        MPI_Isend(d_send_buffer_x1, buffer_length, MPI_CHREAL, dest[1], 0, world, &send_request[1]);
-  #else
+        Select_MPI_Comm_Buffers(d_send_buffer_x1, d_recv_buffer_x1, h_send_buffer_x1, h_recv_buffer_x1, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive right x communication buffer
-        MPI_Irecv(h_recv_buffer_x1, buffer_length, MPI_CHREAL, source[1], 1, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[1], 1, world, &recv_request[ireq]);
 
         // non-blocking send right x communication buffer
-        MPI_Isend(h_send_buffer_x1, buffer_length, MPI_CHREAL, dest[1], 0, world, &send_request[1]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[1], 0, world, &send_request[1]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
 
         MPI_Request_free(send_request + 1);
 
@@ -479,7 +705,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_Y0(d_send_buffer_y0);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y0, d_send_buffer_y0, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y0, d_send_buffer_y0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
         // printf("Y0 len: %d\n", buffer_length);
       }
@@ -487,9 +713,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(1, 0, d_send_buffer_y0, 0);
+        int const potential_offset = Potential_Buffer_Offset(1);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(1, 0, d_send_buffer_y0 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y0, d_send_buffer_y0, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y0 + potential_offset, d_send_buffer_y0 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(1, 0, h_send_buffer_y0, 0);
@@ -506,7 +735,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(1, 0, d_send_buffer_y0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y0, d_send_buffer_y0, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y0, d_send_buffer_y0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -525,19 +754,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
+        Select_MPI_Comm_Buffers(d_send_buffer_y0, d_recv_buffer_y0, h_send_buffer_y0, h_recv_buffer_y0, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive left y communication buffer
-        MPI_Irecv(d_recv_buffer_y0, buffer_length, MPI_CHREAL, source[2], 2, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[2], 2, world, &recv_request[ireq]);
 
         // non-blocking send left y communication buffer
-        MPI_Isend(d_send_buffer_y0, buffer_length, MPI_CHREAL, dest[2], 3, world, &send_request[0]);
-  #else
-        // post non-blocking receive left y communication buffer
-        MPI_Irecv(h_recv_buffer_y0, buffer_length, MPI_CHREAL, source[2], 2, world, &recv_request[ireq]);
-
-        // non-blocking send left y communication buffer
-        MPI_Isend(h_send_buffer_y0, buffer_length, MPI_CHREAL, dest[2], 3, world, &send_request[0]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[2], 3, world, &send_request[0]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
 
         MPI_Request_free(send_request);
 
@@ -551,7 +775,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_Y1(d_send_buffer_y1);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y1, d_send_buffer_y1, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y1, d_send_buffer_y1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
         // printf("Y1 len: %d\n", buffer_length);
       }
@@ -559,9 +783,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(1, 1, d_send_buffer_y1, 0);
+        int const potential_offset = Potential_Buffer_Offset(1);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(1, 1, d_send_buffer_y1 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y1, d_send_buffer_y1, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y1 + potential_offset, d_send_buffer_y1 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(1, 1, h_send_buffer_y1, 0);
@@ -578,7 +805,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(1, 1, d_send_buffer_y1);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_y1, d_send_buffer_y1, ybsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_y1, d_send_buffer_y1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -597,19 +824,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
-        // post non-blocking receive right y communication buffer
-        MPI_Irecv(d_recv_buffer_y1, buffer_length, MPI_CHREAL, source[3], 3, world, &recv_request[ireq]);
-
-        // non-blocking send right y communication buffer
-        MPI_Isend(d_send_buffer_y1, buffer_length, MPI_CHREAL, dest[3], 2, world, &send_request[1]);
-  #else
+        Select_MPI_Comm_Buffers(d_send_buffer_y1, d_recv_buffer_y1, h_send_buffer_y1, h_recv_buffer_y1, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive right y communication buffer
-        MPI_Irecv(h_recv_buffer_y1, buffer_length, MPI_CHREAL, source[3], 3, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[3], 3, world, &recv_request[ireq]);
 
         // non-blocking send right y communication buffer
-        MPI_Isend(h_send_buffer_y1, buffer_length, MPI_CHREAL, dest[3], 2, world, &send_request[1]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[3], 2, world, &send_request[1]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
         MPI_Request_free(send_request + 1);
 
         // keep track of how many sends and receives are expected
@@ -631,7 +853,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_Z0(d_send_buffer_z0);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z0, d_send_buffer_z0, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z0, d_send_buffer_z0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
         // printf("Z0 len: %d\n", buffer_length);
       }
@@ -639,9 +861,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(2, 0, d_send_buffer_z0, 0);
+        int const potential_offset = Potential_Buffer_Offset(2);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(2, 0, d_send_buffer_z0 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z0, d_send_buffer_z0, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z0 + potential_offset, d_send_buffer_z0 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(2, 0, h_send_buffer_z0, 0);
@@ -658,7 +883,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(2, 0, d_send_buffer_z0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z0, d_send_buffer_z0, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z0, d_send_buffer_z0, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -677,18 +902,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
+        Select_MPI_Comm_Buffers(d_send_buffer_z0, d_recv_buffer_z0, h_send_buffer_z0, h_recv_buffer_z0, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive left z communication buffer
-        MPI_Irecv(d_recv_buffer_z0, buffer_length, MPI_CHREAL, source[4], 4, world, &recv_request[ireq]);
-        // non-blocking send left z communication buffer
-        MPI_Isend(d_send_buffer_z0, buffer_length, MPI_CHREAL, dest[4], 5, world, &send_request[0]);
-  #else
-        // post non-blocking receive left z communication buffer
-        MPI_Irecv(h_recv_buffer_z0, buffer_length, MPI_CHREAL, source[4], 4, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[4], 4, world, &recv_request[ireq]);
 
         // non-blocking send left z communication buffer
-        MPI_Isend(h_send_buffer_z0, buffer_length, MPI_CHREAL, dest[4], 5, world, &send_request[0]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[4], 5, world, &send_request[0]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
 
         MPI_Request_free(send_request);
 
@@ -702,7 +923,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
       if (H.TRANSFER_HYDRO_BOUNDARIES) {
         buffer_length = Load_Hydro_DeviceBuffer_Z1(d_send_buffer_z1);
   #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z1, d_send_buffer_z1, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z1, d_send_buffer_z1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
   #endif
         // printf("Z1 len: %d\n", buffer_length);
       }
@@ -710,9 +931,12 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #ifdef GRAVITY
       if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
-        buffer_length = Load_Gravity_Potential_To_Buffer_GPU(2, 1, d_send_buffer_z1, 0);
+        int const potential_offset = Potential_Buffer_Offset(2);
+        buffer_length              =
+            potential_offset + Load_Gravity_Potential_To_Buffer_GPU(2, 1, d_send_buffer_z1 + potential_offset, 0);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z1, d_send_buffer_z1, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z1 + potential_offset, d_send_buffer_z1 + potential_offset,
+                   (buffer_length - potential_offset) * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
         buffer_length = Load_Gravity_Potential_To_Buffer(2, 1, h_send_buffer_z1, 0);
@@ -729,7 +953,7 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
     #ifdef PARTICLES_GPU
         buffer_length = Load_Particles_Density_Boundary_to_Buffer_GPU(2, 1, d_send_buffer_z1);
       #ifndef MPI_GPU
-        cudaMemcpy(h_send_buffer_z1, d_send_buffer_z1, zbsize * sizeof(Real), cudaMemcpyDeviceToHost);
+        cudaMemcpy(h_send_buffer_z1, d_send_buffer_z1, buffer_length * sizeof(Real), cudaMemcpyDeviceToHost);
       #endif
     #else
       #ifndef MPI_GPU
@@ -748,19 +972,14 @@ void Grid3D::Load_and_Send_MPI_Comm_Buffers(int dir, int *flags)
   #endif
 
       if (transfer_main_buffer) {
-  #if defined(MPI_GPU)
+        Select_MPI_Comm_Buffers(d_send_buffer_z1, d_recv_buffer_z1, h_send_buffer_z1, h_recv_buffer_z1, buffer_length,
+                                send_buffer, recv_buffer);
         // post non-blocking receive right x communication buffer
-        MPI_Irecv(d_recv_buffer_z1, buffer_length, MPI_CHREAL, source[5], 5, world, &recv_request[ireq]);
+        MPI_Irecv(recv_buffer, buffer_length, MPI_CHREAL, source[5], 5, world, &recv_request[ireq]);
 
         // non-blocking send right x communication buffer
-        MPI_Isend(d_send_buffer_z1, buffer_length, MPI_CHREAL, dest[5], 4, world, &send_request[1]);
-  #else
-        // post non-blocking receive right x communication buffer
-        MPI_Irecv(h_recv_buffer_z1, buffer_length, MPI_CHREAL, source[5], 5, world, &recv_request[ireq]);
-
-        // non-blocking send right x communication buffer
-        MPI_Isend(h_send_buffer_z1, buffer_length, MPI_CHREAL, dest[5], 4, world, &send_request[1]);
-  #endif
+        MPI_Isend(send_buffer, buffer_length, MPI_CHREAL, dest[5], 4, world, &send_request[1]);
+        mpi_bytes_sent += buffer_length * sizeof(Real);
         MPI_Request_free(send_request + 1);
 
         // keep track of how many sends and receives are expected
@@ -820,13 +1039,20 @@ void Grid3D::Wait_and_Unload_MPI_Comm_Buffers(int dir, int *flags)
   // wait for any receives to complete
   for (iwait = 0; iwait < wait_max; iwait++) {
     // wait for recv completion
+    double const wait_start = Get_Time();
     MPI_Waitany(wait_max, recv_request, &index, &status);
+    mpi_wait_time += Get_Time() - wait_start;
     // if (procID==1) MPI_Get_count(&status, MPI_CHREAL, &count);
     // if (procID==1) printf("Process 1 unloading direction %d, source %d, index
     // %d, length %d.\n", status.MPI_TAG, status.MPI_SOURCE, index, count);
     // depending on which face arrived, load the buffer into the ghost grid
     Unload_MPI_Comm_Buffers(status.MPI_TAG);
   }
+
+  // Complete the sends so the send buffers can be reused by the next transfer
+  double const wait_start = Get_Time();
+  MPI_Waitall(2, send_request, MPI_STATUSES_IGNORE);
+  mpi_wait_time += Get_Time() - wait_start;
 }
 
 void Grid3D::Unload_MPI_Comm_Buffers(int index)
@@ -840,6 +1066,14 @@ void Grid3D::Unload_MPI_Comm_Buffers(int index)
   Grid3D_PMF_UnloadGravityPotential Fptr_Unload_Gravity_Potential;
   Grid3D_PMF_UnloadParticleDensity Fptr_Unload_Particle_Density;
 
+  #ifdef MPI_GPU
+  // A staged message arrived in the host buffer, everything below expects it
+  // on the device
+  if (not mpi_gpu_direct) {
+    copyHostToDeviceReceiveBuffer(index);
+  }
+  #endif  // MPI_GPU
+
   if (H.TRANSFER_HYDRO_BOUNDARIES) {
   #ifndef MPI_GPU
     copyHostToDeviceReceiveBuffer(index);
@@ -884,15 +1118,18 @@ void Grid3D::Unload_MPI_Comm_Buffers(int index)
   if (Grav.TRANSFER_POTENTIAL_BOUNDARIES) {
     #ifdef GRAVITY_GPU
       #ifndef MPI_GPU
-    copyHostToDeviceReceiveBuffer(index);
+    // A message shared with the hydro boundaries is already on the device
+    if (!H.TRANSFER_HYDRO_BOUNDARIES) {
+      copyHostToDeviceReceiveBuffer(index);
+    }
       #endif  // MPI_GPU
 
-    l_recv_buffer_x0 = d_recv_buffer_x0;
-    l_recv_buffer_x1 = d_recv_buffer_x1;
-    l_recv_buffer_y0 = d_recv_buffer_y0;
-    l_recv_buffer_y1 = d_recv_buffer_y1;
-    l_recv_buffer_z0 = d_recv_buffer_z0;
-    l_recv_buffer_z1 = d_recv_buffer_z1;
+    l_recv_buffer_x0 = d_recv_buffer_x0 + Potential_Buffer_Offset(0);
+    l_recv_buffer_x1 = d_recv_buffer_x1 + Potential_Buffer_Offset(0);
+    l_recv_buffer_y0 = d_recv_buffer_y0 + Potential_Buffer_Offset(1);
+    l_recv_buffer_y1 = d_recv_buffer_y1 + Potential_Buffer_Offset(1);
+    l_recv_buffer_z0 = d_recv_buffer_z0 + Potential_Buffer_Offset(2);
+    l_recv_buffer_z1 = d_recv_buffer_z1 + Potential_Buffer_Offset(2);
 
     Fptr_Unload_Gravity_Potential = &Grid3D::Unload_Gravity_Potential_from_Buffer_GPU;
 
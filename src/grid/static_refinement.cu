@@ -0,0 +1,424 @@
+/*! \file static_refinement.cu
+ *  \brief Definitions of the static refinement. */
+
+#ifdef STATIC_REFINEMENT
+
+  #include <math.h>
+  #include <string.h>
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../grid/grid3D.h"
+  #include "../grid/static_refinement.h"
+  #include "../io/io.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+
+namespace static_refinement
+{
+namespace
+{
+__global__ void Copy_Box_Kernel(Real const *grid, int nx, int ny, int n_cells, int n_fields, Box box, Real *box_data)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= box.Size()) {
+    return;
+  }
+
+  int i, j, k;
+  cuda_utilities::compute3DIndices(tid, box.nx, box.ny, i, j, k);
+  int const id = cuda_utilities::compute1DIndex(box.x + i, box.y + j, box.z + k, nx, ny);
+  for (int field = 0; field < n_fields; field++) {
+    box_data[field * box.Size() + tid] = grid[field * n_cells + id];
+  }
+}
+
+__device__ Real Minmod(Real const left, Real const right)
+{
+  if (left * right <= 0) {
+    return 0;
+  }
+  return (fabs(left) < fabs(right)) ? left : right;
+}
+
+// The index of the grid cell that a patch cell, counted from the first real
+// cell of the patch, is in, and the offset of its center from the center of
+// the grid cell in grid cells
+__device__ void Parent(int const r, int &parent, Real &offset)
+{
+  parent = (r >= 0) ? r / ratio : -((-r + ratio - 1) / ratio);
+  offset = (r - ratio * parent + Real(0.5)) / ratio - Real(0.5);
+}
+
+__global__ void Prolong_Kernel(Real const *box_old, Real const *box_new, Real weight, Box box, int margin, Real *patch,
+                               int nx, int ny, int nz, int n_ghost, int n_fields, bool ghost_only)
+{
+  int const n_cells = nx * ny * nz;
+  int const tid     = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_cells) {
+    return;
+  }
+
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(tid, nx, ny, xid, yid, zid);
+  bool const is_real = xid >= n_ghost and xid < nx - n_ghost and yid >= n_ghost and yid < ny - n_ghost and
+                       zid >= n_ghost and zid < nz - n_ghost;
+  if (ghost_only and is_real) {
+    return;
+  }
+
+  int pi, pj, pk;
+  Real ox, oy, oz;
+  Parent(xid - n_ghost, pi, ox);
+  Parent(yid - n_ghost, pj, oy);
+  Parent(zid - n_ghost, pk, oz);
+  int const b      = cuda_utilities::compute1DIndex(pi + margin, pj + margin, pk + margin, box.nx, box.ny);
+  int const stride = box.Size();
+  int const sx = 1, sy = box.nx, sz = box.nx * box.ny;
+
+  for (int field = 0; field < n_fields; field++) {
+    Real const *old_field = box_old + field * stride;
+    Real const *new_field = box_new + field * stride;
+    auto value            = [&](int const offset) {
+      return (1 - weight) * old_field[b + offset] + weight * new_field[b + offset];
+    };
+    Real const center  = value(0);
+    Real const slope_x = Minmod(center - value(-sx), value(sx) - center);
+    Real const slope_y = Minmod(center - value(-sy), value(sy) - center);
+    Real const slope_z = Minmod(center - value(-sz), value(sz) - center);
+    patch[field * n_cells + tid] = center + ox * slope_x + oy * slope_y + oz * slope_z;
+  }
+}
+
+__global__ void Restrict_Kernel(Real const *patch, int nx, int ny, int nz, int n_ghost, int n_fields, Real *grid,
+                                int grid_nx, int grid_ny, int grid_n_cells, Box covered)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= covered.Size()) {
+    return;
+  }
+
+  int i, j, k;
+  cuda_utilities::compute3DIndices(tid, covered.nx, covered.ny, i, j, k);
+  int const id      = cuda_utilities::compute1DIndex(covered.x + i, covered.y + j, covered.z + k, grid_nx, grid_ny);
+  int const n_cells = nx * ny * nz;
+  int const first =
+      cuda_utilities::compute1DIndex(n_ghost + ratio * i, n_ghost + ratio * j, n_ghost + ratio * k, nx, ny);
+
+  for (int field = 0; field < n_fields; field++) {
+    Real sum = 0;
+    for (int dk = 0; dk < ratio; dk++) {
+      for (int dj = 0; dj < ratio; dj++) {
+        for (int di = 0; di < ratio; di++) {
+          sum += patch[field * n_cells + first + cuda_utilities::compute1DIndex(di, dj, dk, nx, ny)];
+        }
+      }
+    }
+    grid[field * grid_n_cells + id] = sum / (ratio * ratio * ratio);
+  }
+}
+
+// A face of the register: the axis it is normal to, whether it is the high
+// face, the index of its first value and its number of values per field
+struct Face {
+  int axis;
+  bool high;
+  int first, size;
+  int n_a;  // the number of values along the first transverse axis
+};
+
+// Find the face of element tid of the faces of a register, and the index of
+// the element in the face
+__device__ Face Find_Face(int tid, Box covered, int n_fields, int &element)
+{
+  int const sizes[3] = {covered.ny * covered.nz, covered.nx * covered.nz, covered.nx * covered.ny};
+  int const n_a[3]   = {covered.ny, covered.nx, covered.nx};
+  int first          = 0;
+  for (int face = 0; face < 6; face++) {
+    int const size = sizes[face / 2];
+    if (tid < size) {
+      element = tid;
+      return Face{face / 2, face % 2 == 1, first, size, n_a[face / 2]};
+    }
+    tid -= size;
+    first += n_fields * size;
+  }
+  element = -1;
+  return Face{};
+}
+
+__global__ void Add_Face_Fluxes_Kernel(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells,
+                                       int n_fields, Box box, int factor, Real scale, Real *flux_register, Box covered)
+{
+  int const n_elements = 2 * (covered.ny * covered.nz + covered.nx * covered.nz + covered.nx * covered.ny);
+  int const tid        = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_elements) {
+    return;
+  }
+
+  int element;
+  Face const face = Find_Face(tid, covered, n_fields, element);
+  int const a     = element % face.n_a;
+  int const b     = element / face.n_a;
+
+  // The fluxes of a cell are the ones of its right face
+  int const starts[3] = {box.x, box.y, box.z};
+  int const sizes[3]  = {box.nx, box.ny, box.nz};
+  int const normal    = face.high ? starts[face.axis] + sizes[face.axis] - 1 : starts[face.axis] - 1;
+  Real const *F       = (face.axis == 0) ? F_x : ((face.axis == 1) ? F_y : F_z);
+
+  for (int field = 0; field < n_fields; field++) {
+    Real sum = 0;
+    for (int db = 0; db < factor; db++) {
+      for (int da = 0; da < factor; da++) {
+        int const ta = factor * a + da, tb = factor * b + db;
+        int id;
+        if (face.axis == 0) {
+          id = cuda_utilities::compute1DIndex(normal, box.y + ta, box.z + tb, nx, ny);
+        } else if (face.axis == 1) {
+          id = cuda_utilities::compute1DIndex(box.x + ta, normal, box.z + tb, nx, ny);
+        } else {
+          id = cuda_utilities::compute1DIndex(box.x + ta, box.y + tb, normal, nx, ny);
+        }
+        sum += F[field * n_cells + id];
+      }
+    }
+    flux_register[face.first + field * face.size + element] += scale * sum;
+  }
+}
+
+__global__ void Reflux_Kernel(Real const *flux_register, Real *grid, int nx, int ny, int n_cells, int n_fields,
+                              Box covered, Real dx, Real dy, Real dz)
+{
+  int const n_elements = 2 * (covered.ny * covered.nz + covered.nx * covered.nz + covered.nx * covered.ny);
+  int const tid        = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_elements) {
+    return;
+  }
+
+  int element;
+  Face const face = Find_Face(tid, covered, n_fields, element);
+  int const a     = element % face.n_a;
+  int const b     = element / face.n_a;
+
+  // The register is added to the cell below the low faces and subtracted from
+  // the cell above the high faces
+  int const starts[3]  = {covered.x, covered.y, covered.z};
+  int const sizes[3]   = {covered.nx, covered.ny, covered.nz};
+  Real const widths[3] = {dx, dy, dz};
+  int const normal     = face.high ? starts[face.axis] + sizes[face.axis] : starts[face.axis] - 1;
+  Real const sign      = face.high ? -1 : 1;
+  int id;
+  if (face.axis == 0) {
+    id = cuda_utilities::compute1DIndex(normal, covered.y + a, covered.z + b, nx, ny);
+  } else if (face.axis == 1) {
+    id = cuda_utilities::compute1DIndex(covered.x + a, normal, covered.z + b, nx, ny);
+  } else {
+    id = cuda_utilities::compute1DIndex(covered.x + a, covered.y + b, normal, nx, ny);
+  }
+
+  for (int field = 0; field < n_fields; field++) {
+    grid[field * n_cells + id] += sign * flux_register[face.first + field * face.size + element] / widths[face.axis];
+  }
+}
+}  // namespace
+
+void Copy_Box(Real const *grid, int nx, int ny, int n_cells, int n_fields, Box box, Real *box_data)
+{
+  int const n_threads = box.Size();
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Copy_Box_Kernel, dim1dGrid, dim1dBlock, 0, 0, grid, nx, ny, n_cells, n_fields, box, box_data);
+  GPU_Error_Check();
+}
+
+void Prolong(Real const *box_old, Real const *box_new, Real weight, Box box, int margin, Real *patch, int nx, int ny,
+             int nz, int n_ghost, int n_fields, bool ghost_only)
+{
+  int const n_threads = nx * ny * nz;
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Prolong_Kernel, dim1dGrid, dim1dBlock, 0, 0, box_old, box_new, weight, box, margin, patch, nx, ny,
+                     nz, n_ghost, n_fields, ghost_only);
+  GPU_Error_Check();
+}
+
+void Restrict(Real const *patch, int nx, int ny, int nz, int n_ghost, int n_fields, Real *grid, int grid_nx,
+              int grid_ny, int grid_n_cells, Box covered)
+{
+  int const n_threads = covered.Size();
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Restrict_Kernel, dim1dGrid, dim1dBlock, 0, 0, patch, nx, ny, nz, n_ghost, n_fields, grid, grid_nx,
+                     grid_ny, grid_n_cells, covered);
+  GPU_Error_Check();
+}
+
+int Flux_Register_Size(Box covered, int n_fields)
+{
+  return 2 * n_fields * (covered.ny * covered.nz + covered.nx * covered.nz + covered.nx * covered.ny);
+}
+
+void Add_Face_Fluxes(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells, int n_fields,
+                     Box box, int factor, Real scale, Real *flux_register, Box covered)
+{
+  int const n_threads = Flux_Register_Size(covered, n_fields) / n_fields;
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Add_Face_Fluxes_Kernel, dim1dGrid, dim1dBlock, 0, 0, F_x, F_y, F_z, nx, ny, n_cells, n_fields,
+                     box, factor, scale, flux_register, covered);
+  GPU_Error_Check();
+}
+
+void Reflux(Real const *flux_register, Real *grid, int nx, int ny, int n_cells, int n_fields, Box covered, Real dx,
+            Real dy, Real dz)
+{
+  int const n_threads = Flux_Register_Size(covered, n_fields) / n_fields;
+  dim3 dim1dGrid((n_threads + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Reflux_Kernel, dim1dGrid, dim1dBlock, 0, 0, flux_register, grid, nx, ny, n_cells, n_fields,
+                     covered, dx, dy, dz);
+  GPU_Error_Check();
+}
+}  // namespace static_refinement
+
+RefinedPatch::RefinedPatch(Grid3D &grid, struct Parameters const &P) : grid(grid), P_patch(P)
+{
+  using static_refinement::ratio;
+  int const n_ghost = grid.H.n_ghost;
+
+  covered = {n_ghost + P.refine_x_start, n_ghost + P.refine_y_start, n_ghost + P.refine_z_start,
+             P.refine_nx,                P.refine_ny,                P.refine_nz};
+  // The patch ghost cells need the grid cell they are in and its neighbors
+  margin = (n_ghost + ratio - 1) / ratio + 1;
+  box    = {covered.x - margin,      covered.y - margin,      covered.z - margin,
+            covered.nx + 2 * margin, covered.ny + 2 * margin, covered.nz + 2 * margin};
+
+  CHOLLA_ASSERT(grid.H.nx > 1 and grid.H.ny > 1 and grid.H.nz > 1, "The static refinement needs a 3D grid");
+  CHOLLA_ASSERT(P.refine_ny > 0 and P.refine_nz > 0, "refine_ny and refine_nz must be positive");
+  CHOLLA_ASSERT(box.x >= n_ghost and box.y >= n_ghost and box.z >= n_ghost and
+                    box.x + box.nx <= grid.H.nx - n_ghost and box.y + box.ny <= grid.H.ny - n_ghost and
+                    box.z + box.nz <= grid.H.nz - n_ghost,
+                "The refined patch must be at least %d cells inside the real cells of the grid", margin);
+  CHOLLA_ASSERT(P.n_vl_slabs == 1, "The static refinement needs the fluxes of the whole grid, n_vl_slabs must be 1");
+
+  // The patch covers the same region at ratio times the resolution
+  P_patch.nx = ratio * P.refine_nx;
+  P_patch.ny = ratio * P.refine_ny;
+  P_patch.nz = ratio * P.refine_nz;
+  P_patch.xmin += P.refine_x_start * grid.H.dx;
+  P_patch.ymin += P.refine_y_start * grid.H.dy;
+  P_patch.zmin += P.refine_z_start * grid.H.dz;
+  P_patch.xlen      = P.refine_nx * grid.H.dx;
+  P_patch.ylen      = P.refine_ny * grid.H.dy;
+  P_patch.zlen      = P.refine_nz * grid.H.dz;
+  P_patch.refine_nx = 0;
+  P_patch.refine_ny = 0;
+  P_patch.refine_nz = 0;
+  snprintf(P_patch.outdir, MAXLEN, "%srefined_", P.outdir);
+  #ifdef CPU_TIME
+  P_patch.perf_log[0] = '\0';
+  #endif  // CPU_TIME
+
+  patch.Initialize(&P_patch);
+  CHOLLA_ASSERT(patch.H.n_cells <= grid.H.n_cells,
+                "The refined patch has %d cells with its ghost cells, more than the %d of the grid whose integrator "
+                "buffers it shares",
+                patch.H.n_cells, grid.H.n_cells);
+  patch.H.dti_constraint = timestep_constraints::refinement;
+  #ifdef CPU_TIME
+  patch.Timer.Initialize(P_patch);
+  #endif  // CPU_TIME
+
+  {
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::hydro);
+    cuda_utilities::Pool_Malloc(&box_old, grid.H.n_fields * box.Size() * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&box_new, grid.H.n_fields * box.Size() * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&flux_register,
+                                static_refinement::Flux_Register_Size(covered, grid.H.n_fields) * sizeof(Real));
+  }
+  Save_Grid_State();
+
+  // A restart only has the grid, the patch is interpolated from it. Otherwise
+  // the patch gets the initial conditions at its own resolution
+  bool const is_restart = strcmp(P.init, "Read_Grid") == 0 or strcmp(P.init, "Read_Grid_Cat") == 0;
+  if (is_restart) {
+    patch.Set_Domain_Properties(P_patch);
+  } else {
+    patch.Set_Initial_Conditions(P_patch);
+  }
+  static_refinement::Prolong(box_old, box_old, 0, box, margin, patch.C.device, patch.H.nx, patch.H.ny, patch.H.nz,
+                             n_ghost, patch.H.n_fields, not is_restart);
+  static_refinement::Restrict(patch.C.device, patch.H.nx, patch.H.ny, patch.H.nz, n_ghost, patch.H.n_fields,
+                              grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, covered);
+  patch.H.t = grid.H.t;
+  patch.Calc_Inverse_Timestep();
+
+  chprintf("Refined patch: %d x %d x %d cells starting at grid cell (%d, %d, %d)\n", P_patch.nx, P_patch.ny,
+           P_patch.nz, P.refine_x_start, P.refine_y_start, P.refine_z_start);
+}
+
+RefinedPatch::~RefinedPatch()
+{
+  // The patch shares the integrator buffers of the grid, which frees them
+  cuda_utilities::Pool_Free(box_old);
+  cuda_utilities::Pool_Free(box_new);
+  cuda_utilities::Pool_Free(flux_register);
+}
+
+void RefinedPatch::Save_Grid_State()
+{
+  static_refinement::Copy_Box(grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, grid.H.n_fields, box, box_old);
+}
+
+void RefinedPatch::Advance()
+{
+  using static_refinement::ratio;
+  int const n_ghost  = patch.H.n_ghost;
+  int const n_fields = grid.H.n_fields;
+
+  // The register starts with the fluxes the grid used around the patch
+  GPU_Error_Check(
+      cudaMemset(flux_register, 0, static_refinement::Flux_Register_Size(covered, n_fields) * sizeof(Real)));
+  static_refinement::Add_Face_Fluxes(F_x, F_y, F_z, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, covered, 1,
+                                     grid.H.dt, flux_register, covered);
+  static_refinement::Copy_Box(grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, box, box_new);
+
+  // The patch fluxes are averaged over the ratio * ratio patch faces of every
+  // grid face
+  static_refinement::Box const patch_box{n_ghost, n_ghost, n_ghost, P_patch.nx, P_patch.ny, P_patch.nz};
+  patch.H.dt = grid.H.dt / ratio;
+  for (int step = 0; step < ratio; step++) {
+    patch.H.t = grid.H.t + step * patch.H.dt;
+    static_refinement::Prolong(box_old, box_new, Real(step) / ratio, box, margin, patch.C.device, patch.H.nx,
+                               patch.H.ny, patch.H.nz, n_ghost, n_fields, true);
+    patch.Update_Hydro_Grid(&P_patch);
+    static_refinement::Add_Face_Fluxes(F_x, F_y, F_z, patch.H.nx, patch.H.ny, patch.H.n_cells, n_fields, patch_box,
+                                       ratio, -patch.H.dt / (ratio * ratio), flux_register, covered);
+  }
+  patch.H.t = grid.H.t + grid.H.dt;
+
+  static_refinement::Reflux(flux_register, grid.C.device, grid.H.nx, grid.H.ny, grid.H.n_cells, n_fields, covered,
+                            grid.H.dx, grid.H.dy, grid.H.dz);
+  static_refinement::Restrict(patch.C.device, patch.H.nx, patch.H.ny, patch.H.nz, n_ghost, n_fields, grid.C.device,
+                              grid.H.nx, grid.H.ny, grid.H.n_cells, covered);
+}
+
+void RefinedPatch::Write(int nfile)
+{
+  patch.H.t      = grid.H.t;
+  patch.H.n_step = grid.H.n_step;
+  patch.H.dt     = grid.H.dt;
+  Write_Data(patch, P_patch, nfile);
+}
+
+void Grid3D::Initialize_Refinement(struct Parameters *P)
+{
+  if (P->refine_nx > 0) {
+    refined_patch = new RefinedPatch(*this, *P);
+  }
+}
+
+#endif  // STATIC_REFINEMENT
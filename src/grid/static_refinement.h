@@ -0,0 +1,194 @@
+/*! \file static_refinement.h
+ *  \brief Declarations of the static refinement. A fixed box of the grid is
+ *  covered by a patch at twice the resolution, which is a Grid3D of its own
+ *  and is updated by the same integrator. Every step of the grid the patch
+ *  takes two steps of half the timestep, its ghost cells interpolated from the
+ *  grid in space and time. The fluxes through its faces then replace the ones
+ *  of the grid in the grid cells around it (Berger & Colella 1989), and the
+ *  patch is averaged onto the grid cells it covers. */
+
+#pragma once
+
+#ifdef STATIC_REFINEMENT
+
+  #if defined(MPI_CHOLLA) || defined(MHD) || defined(GRAVITY) || defined(PARTICLES) || !defined(VL)
+    #error "STATIC_REFINEMENT only supports VL hydro without MPI_CHOLLA, MHD, gravity or particles"
+  #endif  // MPI_CHOLLA || MHD || GRAVITY || PARTICLES || not VL
+
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+
+namespace static_refinement
+{
+/// The ratio of the cell sizes of the grid and the patch, and the number of
+/// steps the patch takes per step of the grid
+int constexpr ratio = 2;
+
+/*!
+ * \brief A box of cells of a grid: the index of its first cell, ghost cells
+ * included, and its number of cells along each axis
+ */
+struct Box {
+  int x, y, z;
+  int nx, ny, nz;
+
+  __host__ __device__ int Size() const { return nx * ny * nz; }
+};
+
+/*!
+ * \brief Copy the fields of a box of a grid to a contiguous array, ordered
+ * like a grid of the size of the box
+ *
+ * \param[in] grid The conserved variables of the grid
+ * \param[in] nx The number of cells of the grid in the X-direction
+ * \param[in] ny The number of cells of the grid in the Y-direction
+ * \param[in] n_cells The number of cells of the grid
+ * \param[in] n_fields The number of fields
+ * \param[in] box The box to copy
+ * \param[out] box_data The n_fields * box.Size() values of the box
+ */
+void Copy_Box(Real const *grid, int nx, int ny, int n_cells, int n_fields, Box box, Real *box_data);
+
+/*!
+ * \brief Set the cells of a patch from a box of the grid around it, with the
+ * slopes of the grid cells limited by minmod, so the average of the patch
+ * cells in a grid cell is the value of the grid cell. The values of the grid
+ * are interpolated in time between two copies of the box
+ *
+ * \param[in] box_old The box at the start of the step, from Copy_Box
+ * \param[in] box_new The box at the end of the step
+ * \param[in] weight The weight of box_new, between 0 and 1
+ * \param[in] box The box of the grid, which extends margin cells past the patch
+ * on every side
+ * \param[in] margin The number of grid cells between the box and the patch
+ * \param[out] patch The conserved variables of the patch
+ * \param[in] nx The number of cells of the patch in the X-direction
+ * \param[in] ny The number of cells of the patch in the Y-direction
+ * \param[in] nz The number of cells of the patch in the Z-direction
+ * \param[in] n_ghost The number of ghost cells of the patch
+ * \param[in] n_fields The number of fields
+ * \param[in] ghost_only Only set the ghost cells of the patch
+ */
+void Prolong(Real const *box_old, Real const *box_new, Real weight, Box box, int margin, Real *patch, int nx, int ny,
+             int nz, int n_ghost, int n_fields, bool ghost_only);
+
+/*!
+ * \brief Set the cells of the grid covered by a patch to the average of the
+ * patch cells in them
+ *
+ * \param[in] patch The conserved variables of the patch
+ * \param[in] nx The number of cells of the patch in the X-direction
+ * \param[in] ny The number of cells of the patch in the Y-direction
+ * \param[in] nz The number of cells of the patch in the Z-direction
+ * \param[in] n_ghost The number of ghost cells of the patch
+ * \param[in] n_fields The number of fields
+ * \param[out] grid The conserved variables of the grid
+ * \param[in] grid_nx The number of cells of the grid in the X-direction
+ * \param[in] grid_ny The number of cells of the grid in the Y-direction
+ * \param[in] grid_n_cells The number of cells of the grid
+ * \param[in] covered The box of the grid the patch covers
+ */
+void Restrict(Real const *patch, int nx, int ny, int nz, int n_ghost, int n_fields, Real *grid, int grid_nx,
+              int grid_ny, int grid_n_cells, Box covered);
+
+/*!
+ * \brief The number of values of a flux register of the 6 faces of a box of
+ * the grid, the first n_fields * ny * nz for the low X face
+ */
+int Flux_Register_Size(Box covered, int n_fields);
+
+/*!
+ * \brief Add scale times the fluxes of the integrator through the faces of a
+ * box to a flux register. The fluxes are the ones of the right face of every
+ * cell, like the integrator stores them. For the patch each face of the
+ * register is the sum over the ratio * ratio patch faces it covers
+ *
+ * \param[in] F_x The X-fluxes
+ * \param[in] F_y The Y-fluxes
+ * \param[in] F_z The Z-fluxes
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] n_cells The number of cells
+ * \param[in] n_fields The number of fields
+ * \param[in] box The box, in the cells of the fluxes
+ * \param[in] factor The number of cells of the box per cell of the register, 1
+ * for the grid and ratio for the patch
+ * \param[in] scale The factor of the fluxes
+ * \param[in,out] flux_register The register of the faces of the box
+ * \param[in] covered The box of the grid the register is for
+ */
+void Add_Face_Fluxes(Real const *F_x, Real const *F_y, Real const *F_z, int nx, int ny, int n_cells, int n_fields,
+                     Box box, int factor, Real scale, Real *flux_register, Box covered);
+
+/*!
+ * \brief Correct the grid cells just outside a box with a flux register that
+ * holds the time integral of the difference between the fluxes of the grid
+ * and of the patch through the faces of the box
+ *
+ * \param[in] flux_register The register of Add_Face_Fluxes
+ * \param[in,out] grid The conserved variables of the grid
+ * \param[in] nx The number of cells of the grid in the X-direction
+ * \param[in] ny The number of cells of the grid in the Y-direction
+ * \param[in] n_cells The number of cells of the grid
+ * \param[in] n_fields The number of fields
+ * \param[in] covered The box of the grid covered by the patch
+ * \param[in] dx The cell size of the grid in the X-direction
+ * \param[in] dy The cell size of the grid in the Y-direction
+ * \param[in] dz The cell size of the grid in the Z-direction
+ */
+void Reflux(Real const *flux_register, Real *grid, int nx, int ny, int n_cells, int n_fields, Box covered, Real dx,
+            Real dy, Real dz);
+}  // namespace static_refinement
+
+/*! \class RefinedPatch
+ *  \brief The refined patch of a grid, owned by Grid3D::refined_patch. The
+ *  patch has the same integrator and source terms as the grid it refines, and
+ *  the two share the scratch buffers of the integrator, so the patch can't
+ *  have more cells than the grid. */
+class RefinedPatch
+{
+ public:
+  /*! \fn RefinedPatch(Grid3D &grid, struct Parameters const &P)
+   *  \brief Create the patch of the refine_* parameters with the initial
+   * conditions of P at its resolution. For restarts the patch is interpolated
+   * from the grid instead */
+  RefinedPatch(Grid3D &grid, struct Parameters const &P);
+
+  /*! \fn ~RefinedPatch()
+   *  \brief Free the buffers of the patch */
+  ~RefinedPatch();
+
+  /*! \fn void Save_Grid_State()
+   *  \brief Copy the grid cells around the patch at the start of the step of
+   * the grid */
+  void Save_Grid_State();
+
+  /*! \fn void Advance()
+   *  \brief Take the steps of the patch for the step of the grid that was just
+   * taken, correct the grid cells around it with its fluxes and average it
+   * onto the grid cells it covers */
+  void Advance();
+
+  /*! \fn void Write(int nfile)
+   *  \brief Write the patch with the outputs of nfile, to the files of the
+   * outdir of the grid prefixed with "refined_" */
+  void Write(int nfile);
+
+ private:
+  Grid3D &grid;
+  Parameters P_patch;
+  Grid3D patch;
+
+  // The cells of the grid the patch covers and the box of the grid its ghost
+  // cells are interpolated from, margin cells larger on every side
+  static_refinement::Box covered, box;
+  int margin;
+
+  // The box at the start and at the end of the step of the grid and the flux
+  // register of the faces of the covered cells, on the device
+  Real *box_old;
+  Real *box_new;
+  Real *flux_register;
+};
+
+#endif  // STATIC_REFINEMENT
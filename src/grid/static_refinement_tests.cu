@@ -0,0 +1,102 @@
+/*!
+ * \file static_refinement_tests.cu
+ * \brief Tests for the contents of static_refinement.h
+ *
+ */
+
+#ifdef STATIC_REFINEMENT
+
+  // STL Includes
+  #include <random>
+  #include <string>
+  #include <vector>
+
+  // External Includes
+  #include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+  // Local Includes
+  #include "../global/global.h"
+  #include "../grid/static_refinement.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/testing_utilities.h"
+
+TEST(tHYDROStaticRefinement, ProlongThenRestrictExpectGridValues)
+{
+  std::mt19937_64 prng(42);
+  std::uniform_real_distribution<double> doubleRand(0.1, 5);
+
+  int const n_ghost = 3, n_fields = 2, margin = 3;
+  int const nx = 10, ny = 9, nz = 8;
+  int const n_cells = nx * ny * nz;
+  static_refinement::Box const covered{3, 3, 3, 2, 2, 2};
+  static_refinement::Box const box{covered.x - margin,      covered.y - margin,      covered.z - margin,
+                                   covered.nx + 2 * margin, covered.ny + 2 * margin, covered.nz + 2 * margin};
+
+  std::vector<double> host_grid(n_fields * n_cells);
+  for (double &val : host_grid) {
+    val = doubleRand(prng);
+  }
+  cuda_utilities::DeviceVector<double> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+
+  // Interpolate a patch from the grid and average it back onto the grid
+  int const patch_nx = static_refinement::ratio * covered.nx + 2 * n_ghost;
+  int const patch_ny = static_refinement::ratio * covered.ny + 2 * n_ghost;
+  int const patch_nz = static_refinement::ratio * covered.nz + 2 * n_ghost;
+  cuda_utilities::DeviceVector<double> dev_box(n_fields * box.Size());
+  cuda_utilities::DeviceVector<double> dev_patch(n_fields * patch_nx * patch_ny * patch_nz, true);
+  static_refinement::Copy_Box(dev_grid.data(), nx, ny, n_cells, n_fields, box, dev_box.data());
+  static_refinement::Prolong(dev_box.data(), dev_box.data(), 0, box, margin, dev_patch.data(), patch_nx, patch_ny,
+                             patch_nz, n_ghost, n_fields, false);
+  static_refinement::Restrict(dev_patch.data(), patch_nx, patch_ny, patch_nz, n_ghost, n_fields, dev_grid.data(), nx,
+                              ny, n_cells, covered);
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  for (size_t i = 0; i < host_grid.size(); i++) {
+    testing_utilities::Check_Results(host_grid[i], dev_grid.at(i), "element " + std::to_string(i), 1.0E-14);
+  }
+}
+
+TEST(tHYDROStaticRefinement, MatchingFluxesExpectEmptyRegister)
+{
+  int const n_fields = 2, ratio = static_refinement::ratio;
+  static_refinement::Box const covered{2, 2, 2, 3, 2, 2};
+
+  // Fluxes that are the same everywhere on both grids, so the patch fluxes
+  // integrated over the substeps are the grid fluxes
+  auto const set_fluxes = [&](cuda_utilities::DeviceVector<double> &dev_fluxes, int const n_cells) {
+    std::vector<double> host_fluxes(n_fields * n_cells);
+    for (int field = 0; field < n_fields; field++) {
+      for (int id = 0; id < n_cells; id++) {
+        host_fluxes[field * n_cells + id] = field + 1.5;
+      }
+    }
+    dev_fluxes.cpyHostToDevice(host_fluxes);
+  };
+  int const nx = 7, ny = 6, nz = 6;
+  int const patch_nx = ratio * covered.nx + 4, patch_ny = ratio * covered.ny + 4, patch_nz = ratio * covered.nz + 4;
+  cuda_utilities::DeviceVector<double> grid_fluxes(n_fields * nx * ny * nz);
+  cuda_utilities::DeviceVector<double> patch_fluxes(n_fields * patch_nx * patch_ny * patch_nz);
+  set_fluxes(grid_fluxes, nx * ny * nz);
+  set_fluxes(patch_fluxes, patch_nx * patch_ny * patch_nz);
+
+  int const size = static_refinement::Flux_Register_Size(covered, n_fields);
+  cuda_utilities::DeviceVector<double> dev_register(size, true);
+  double const dt = 0.3;
+  static_refinement::Add_Face_Fluxes(grid_fluxes.data(), grid_fluxes.data(), grid_fluxes.data(), nx, ny, nx * ny * nz,
+                                     n_fields, covered, 1, dt, dev_register.data(), covered);
+  static_refinement::Box const patch_box{2, 2, 2, ratio * covered.nx, ratio * covered.ny, ratio * covered.nz};
+  for (int step = 0; step < ratio; step++) {
+    static_refinement::Add_Face_Fluxes(patch_fluxes.data(), patch_fluxes.data(), patch_fluxes.data(), patch_nx,
+                                       patch_ny, patch_nx * patch_ny * patch_nz, n_fields, patch_box, ratio,
+                                       -dt / (ratio * ratio * ratio), dev_register.data(), covered);
+  }
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  EXPECT_EQ(size, 2 * n_fields * (2 * 2 + 3 * 2 + 3 * 2));
+  for (int i = 0; i < size; i++) {
+    testing_utilities::Check_Results(0, dev_register.at(i), "element " + std::to_string(i), 1.0E-14);
+  }
+}
+
+#endif  // STATIC_REFINEMENT
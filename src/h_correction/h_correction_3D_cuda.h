@@ -8,52 +8,45 @@
 #include "../global/global.h"
 #include "../utils/gpu.hpp"
 
-/*! \fn void calc_eta_x(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_x, int
- nx, int ny, int nz, int n_ghost, Real gamma)
- *  \brief When passed the left and right boundary values at an interface,
- calculates the eta value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_eta_x_3D(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_x, int nx, int ny, int nz, int n_ghost,
-                              Real gamma);
-
-/*! \fn void calc_eta_y(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_y, int
- nx, int ny, int nz, int n_ghost, Real gamma)
- *  \brief When passed the left and right boundary values at an interface,
- calculates the eta value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_eta_y_3D(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_y, int nx, int ny, int nz, int n_ghost,
-                              Real gamma);
-
-/*! \fn void calc_eta_z(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_z, int
- nx, int ny, int nz, int n_ghost, Real gamma)
- *  \brief When passed the left and right boundary values at an interface,
- calculates the eta value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_eta_z_3D(Real *dev_bounds_L, Real *dev_bounds_R, Real *eta_z, int nx, int ny, int nz, int n_ghost,
-                              Real gamma);
-
-/*! \fn void calc_etah_x_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_x,
- int nx, int ny, int nz, int n_ghost)
- *  \brief When passed the eta values at every interface, calculates
-           the eta_h value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_etah_x_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_x, int nx, int ny, int nz,
-                               int n_ghost);
-
-/*! \fn void calc_etah_y_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_y,
- int nx, int ny, int nz, int n_ghost)
- *  \brief When passed the eta values at every interface, calculates
-           the eta_h value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_etah_y_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_y, int nx, int ny, int nz,
-                               int n_ghost);
-
-/*! \fn void calc_etah_z_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_z,
- int nx, int ny, int nz, int n_ghost)
- *  \brief When passed the eta values at every interface, calculates
-           the eta_h value for the interface according to the forumulation in
- Sanders et al, 1998. */
-__global__ void calc_etah_z_3D(Real *eta_x, Real *eta_y, Real *eta_z, Real *etah_z, int nx, int ny, int nz,
-                               int n_ghost);
+/*! \fn Real Calc_Eta_3D(Real const *dev_bounds_L, Real const *dev_bounds_R, int id, int n_cells, int dir, Real gamma)
+ *  \brief When passed the left and right boundary values at the interface id
+ normal to dir (0, 1 or 2 for x, y or z), calculates the eta value for the
+ interface according to the forumulation in Sanders et al, 1998. */
+inline __device__ Real Calc_Eta_3D(Real const *dev_bounds_L, Real const *dev_bounds_R, int id, int n_cells, int dir,
+                                   Real gamma)
+{
+  Real const dl  = dev_bounds_L[id];
+  Real const mxl = dev_bounds_L[n_cells + id];
+  Real const myl = dev_bounds_L[2 * n_cells + id];
+  Real const mzl = dev_bounds_L[3 * n_cells + id];
+  Real const dr  = dev_bounds_R[id];
+  Real const mxr = dev_bounds_R[n_cells + id];
+  Real const myr = dev_bounds_R[2 * n_cells + id];
+  Real const mzr = dev_bounds_R[3 * n_cells + id];
+
+  Real pl = (dev_bounds_L[4 * n_cells + id] - 0.5 * (mxl * mxl + myl * myl + mzl * mzl) / dl) * (gamma - 1.0);
+  pl      = fmax(pl, (Real)1.0e-20);
+  Real pr = (dev_bounds_R[4 * n_cells + id] - 0.5 * (mxr * mxr + myr * myr + mzr * mzr) / dr) * (gamma - 1.0);
+  pr      = fmax(pr, (Real)1.0e-20);
+
+  Real const al = sqrt(gamma * pl / dl);
+  Real const ar = sqrt(gamma * pr / dr);
+
+  // the momentum normal to the interface
+  Real const mnl = dev_bounds_L[(1 + dir) * n_cells + id];
+  Real const mnr = dev_bounds_R[(1 + dir) * n_cells + id];
+
+  return 0.5 * fabs((mnr / dr + ar) - (mnl / dl - al));
+}
+
+/*! \fn void Calc_Etah_3D(Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry, Real *Q_Lz, Real *Q_Rz, Real *etah_x,
+ Real *etah_y, Real *etah_z, int nx, int ny, int nz, int n_ghost, Real gamma)
+ *  \brief When passed the boundary values at every interface, calculates the
+ eta_h value of the x, y and z interfaces according to the forumulation in
+ Sanders et al, 1998. The eta values of the neighbouring interfaces are
+ computed from the boundary values where they are needed, so the H
+ correction needs no eta arrays and a single kernel. */
+__global__ void Calc_Etah_3D(Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry, Real *Q_Lz, Real *Q_Rz, Real *etah_x,
+                             Real *etah_y, Real *etah_z, int nx, int ny, int nz, int n_ghost, Real gamma);
 
 #endif  // H_CORRECTION_3D_H
@@ -6,6 +6,7 @@
 #include <stdio.h>
 
 #include <limits>
+#include <tuple>
 
 #include "../global/global.h"
 #include "../global/global_cuda.h"
@@ -16,189 +17,59 @@
 #include "../utils/gpu.hpp"
 #include "../utils/hydro_utilities.h"
 #include "../utils/reduction_utilities.h"
+#include "../utils/timing_functions.h"
 
-__global__ void Update_Conserved_Variables_1D(Real *dev_conserved, Real *dev_F, int n_cells, int x_off, int n_ghost,
-                                              Real dx, Real xbound, Real dt, Real gamma, int n_fields, int custom_grav)
+namespace
 {
-  int id;
-#ifdef STATIC_GRAV
-  Real d, d_inv, vx;
-  Real gx, d_n, d_inv_n, vx_n;
-  gx = 0.0;
-#endif
-
-  Real dtodx = dt / dx;
-
-  // get a global thread ID
-  id = threadIdx.x + blockIdx.x * blockDim.x;
-
-  // threads corresponding to real cells do the calculation
-  if (id > n_ghost - 1 && id < n_cells - n_ghost) {
-#ifdef STATIC_GRAV
-    d     = dev_conserved[id];
-    d_inv = 1.0 / d;
-    vx    = dev_conserved[1 * n_cells + id] * d_inv;
-#endif
-
-    // update the conserved variable array
-    dev_conserved[id] += dtodx * (dev_F[id - 1] - dev_F[id]);
-    dev_conserved[n_cells + id] += dtodx * (dev_F[n_cells + id - 1] - dev_F[n_cells + id]);
-    dev_conserved[2 * n_cells + id] += dtodx * (dev_F[2 * n_cells + id - 1] - dev_F[2 * n_cells + id]);
-    dev_conserved[3 * n_cells + id] += dtodx * (dev_F[3 * n_cells + id - 1] - dev_F[3 * n_cells + id]);
-    dev_conserved[4 * n_cells + id] += dtodx * (dev_F[4 * n_cells + id - 1] - dev_F[4 * n_cells + id]);
-#ifdef SCALAR
-    for (int i = 0; i < NSCALARS; i++) {
-      dev_conserved[(5 + i) * n_cells + id] +=
-          dtodx * (dev_F[(5 + i) * n_cells + id - 1] - dev_F[(5 + i) * n_cells + id]);
-    }
-#endif
-#ifdef DE
-    dev_conserved[(n_fields - 1) * n_cells + id] +=
-        dtodx * (dev_F[(n_fields - 1) * n_cells + id - 1] - dev_F[(n_fields - 1) * n_cells + id]);
-#endif
-#ifdef STATIC_GRAV  // add gravitational source terms, time averaged from n to
-                    // n+1
-    calc_g_1D(id, x_off, n_ghost, custom_grav, dx, xbound, &gx);
-    d_n     = dev_conserved[id];
-    d_inv_n = 1.0 / d_n;
-    vx_n    = dev_conserved[1 * n_cells + id] * d_inv_n;
-    dev_conserved[n_cells + id] += 0.5 * dt * gx * (d + d_n);
-    dev_conserved[4 * n_cells + id] += 0.25 * dt * gx * (d + d_n) * (vx + vx_n);
-#endif
-    if (dev_conserved[id] != dev_conserved[id]) {
-      printf("%3d Thread crashed in final update. %f\n", id, dev_conserved[id]);
-    }
-    /*
-    d  =  dev_conserved[            id];
-    d_inv = 1.0 / d;
-    vx =  dev_conserved[1*n_cells + id] * d_inv;
-    vy =  dev_conserved[2*n_cells + id] * d_inv;
-    vz =  dev_conserved[3*n_cells + id] * d_inv;
-    P  = (dev_conserved[4*n_cells + id] - 0.5*d*(vx*vx + vy*vy + vz*vz)) *
-    (gamma - 1.0); if (P < 0.0) printf("%d Negative pressure after final
-    update.\n", id);
-    */
+/*! \brief The change of a field over dt from the differences of the fluxes
+ *  through the faces of the cell along each of the dim dimensions */
+template <int dim>
+__device__ __forceinline__ Real Flux_Difference(Real const *dev_F_x, Real const *dev_F_y, Real const *dev_F_z,
+                                                int offset, int id, int imo, int jmo, int kmo, Real dtodx, Real dtody,
+                                                Real dtodz)
+{
+  Real change = dtodx * (dev_F_x[offset + imo] - dev_F_x[offset + id]);
+  if constexpr (dim > 1) {
+    change += dtody * (dev_F_y[offset + jmo] - dev_F_y[offset + id]);
+  }
+  if constexpr (dim > 2) {
+    change += dtodz * (dev_F_z[offset + kmo] - dev_F_z[offset + id]);
   }
+  return change;
 }
-
-__global__ void Update_Conserved_Variables_2D(Real *dev_conserved, Real *dev_F_x, Real *dev_F_y, int nx, int ny,
-                                              int x_off, int y_off, int n_ghost, Real dx, Real dy, Real xbound,
-                                              Real ybound, Real dt, Real gamma, int n_fields, int custom_grav)
+}  // namespace
+
+template <int dim, int n_fields_static>
+__global__ void Update_Conserved_Variables(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
+                                           Real *Q_Lz, Real *Q_Rz, Real *dev_F_x, Real *dev_F_y, Real *dev_F_z, int nx,
+                                           int ny, int nz, int x_off, int y_off, int z_off, int n_ghost, Real dx,
+                                           Real dy, Real dz, Real xbound, Real ybound, Real zbound, Real dt,
+                                           Real gamma, int n_fields, int custom_grav, Real density_floor,
+                                           Real *dev_potential, StaticGravityTable static_grav)
 {
-  int id, xid, yid, n_cells;
-  int imo, jmo;
-
-#ifdef STATIC_GRAV
-  Real d, d_inv, vx, vy;
-  Real gx, gy, d_n, d_inv_n, vx_n, vy_n;
-  gx = 0.0;
-  gy = 0.0;
-#endif
-
-  Real dtodx = dt / dx;
-  Real dtody = dt / dy;
-
-  n_cells = nx * ny;
-
-  // get a global thread ID
-  int blockId = blockIdx.x + blockIdx.y * gridDim.x;
-  id          = threadIdx.x + blockId * blockDim.x;
-  yid         = id / nx;
-  xid         = id - yid * nx;
-  imo         = xid - 1 + yid * nx;
-  jmo         = xid + (yid - 1) * nx;
-
-  // threads corresponding to real cells do the calculation
-  if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost) {
-#ifdef STATIC_GRAV
-    d     = dev_conserved[id];
-    d_inv = 1.0 / d;
-    vx    = dev_conserved[1 * n_cells + id] * d_inv;
-    vy    = dev_conserved[2 * n_cells + id] * d_inv;
-#endif
-    // update the conserved variable array
-    dev_conserved[id] += dtodx * (dev_F_x[imo] - dev_F_x[id]) + dtody * (dev_F_y[jmo] - dev_F_y[id]);
-    dev_conserved[n_cells + id] += dtodx * (dev_F_x[n_cells + imo] - dev_F_x[n_cells + id]) +
-                                   dtody * (dev_F_y[n_cells + jmo] - dev_F_y[n_cells + id]);
-    dev_conserved[2 * n_cells + id] += dtodx * (dev_F_x[2 * n_cells + imo] - dev_F_x[2 * n_cells + id]) +
-                                       dtody * (dev_F_y[2 * n_cells + jmo] - dev_F_y[2 * n_cells + id]);
-    dev_conserved[3 * n_cells + id] += dtodx * (dev_F_x[3 * n_cells + imo] - dev_F_x[3 * n_cells + id]) +
-                                       dtody * (dev_F_y[3 * n_cells + jmo] - dev_F_y[3 * n_cells + id]);
-    dev_conserved[4 * n_cells + id] += dtodx * (dev_F_x[4 * n_cells + imo] - dev_F_x[4 * n_cells + id]) +
-                                       dtody * (dev_F_y[4 * n_cells + jmo] - dev_F_y[4 * n_cells + id]);
-#ifdef SCALAR
-    for (int i = 0; i < NSCALARS; i++) {
-      dev_conserved[(5 + i) * n_cells + id] +=
-          dtodx * (dev_F_x[(5 + i) * n_cells + imo] - dev_F_x[(5 + i) * n_cells + id]) +
-          dtody * (dev_F_y[(5 + i) * n_cells + jmo] - dev_F_y[(5 + i) * n_cells + id]);
-    }
-#endif
-#ifdef DE
-    dev_conserved[(n_fields - 1) * n_cells + id] +=
-        dtodx * (dev_F_x[(n_fields - 1) * n_cells + imo] - dev_F_x[(n_fields - 1) * n_cells + id]) +
-        dtody * (dev_F_y[(n_fields - 1) * n_cells + jmo] - dev_F_y[(n_fields - 1) * n_cells + id]);
-#endif
-#ifdef STATIC_GRAV
-    // calculate the gravitational acceleration as a function of x & y position
-    calc_g_2D(xid, yid, x_off, y_off, n_ghost, custom_grav, dx, dy, xbound, ybound, &gx, &gy);
-    // add gravitational source terms, time averaged from n to n+1
-    d_n     = dev_conserved[id];
-    d_inv_n = 1.0 / d_n;
-    vx_n    = dev_conserved[1 * n_cells + id] * d_inv_n;
-    vy_n    = dev_conserved[2 * n_cells + id] * d_inv_n;
-    dev_conserved[n_cells + id] += 0.5 * dt * gx * (d + d_n);
-    dev_conserved[2 * n_cells + id] += 0.5 * dt * gy * (d + d_n);
-    dev_conserved[4 * n_cells + id] +=
-        0.25 * dt * gx * (d + d_n) * (vx + vx_n) + 0.25 * dt * gy * (d + d_n) * (vy + vy_n);
-#endif
-    if (dev_conserved[id] < 0.0 || dev_conserved[id] != dev_conserved[id]) {
-      printf("%3d %3d Thread crashed in final update. %f %f %f\n", xid, yid, dtodx * (dev_F_x[imo] - dev_F_x[id]),
-             dtody * (dev_F_y[jmo] - dev_F_y[id]), dev_conserved[id]);
-    }
-    /*
-    d  =  dev_conserved[            id];
-    d_inv = 1.0 / d;
-    vx =  dev_conserved[1*n_cells + id] * d_inv;
-    vy =  dev_conserved[2*n_cells + id] * d_inv;
-    vz =  dev_conserved[3*n_cells + id] * d_inv;
-    P  = (dev_conserved[4*n_cells + id] - 0.5*d*(vx*vx + vy*vy + vz*vz)) *
-    (gamma - 1.0); if (P < 0.0) printf("%3d %3d Negative pressure after final
-    update. %f %f %f %f\n", xid, yid, dev_conserved[4*n_cells + id],
-    0.5*d*vx*vx, 0.5*d*vy*vy, P);
-    */
+  static_assert(dim >= 1 and dim <= 3, "Update_Conserved_Variables supports 1, 2 and 3 dimensions");
+  if constexpr (n_fields_static > 0) {
+    n_fields = n_fields_static;
   }
-}
 
-__global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
-                                              Real *Q_Lz, Real *Q_Rz, Real *dev_F_x, Real *dev_F_y, Real *dev_F_z,
-                                              int nx, int ny, int nz, int x_off, int y_off, int z_off, int n_ghost,
-                                              Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound, Real dt,
-                                              Real gamma, int n_fields, int custom_grav, Real density_floor,
-                                              Real *dev_potential)
-{
   int id, xid, yid, zid, n_cells;
   int imo, jmo, kmo;
 
-#ifdef STATIC_GRAV
+#if defined(STATIC_GRAV) || defined(GRAVITY)
   Real d, d_inv, vx, vy, vz;
   Real gx, gy, gz, d_n, d_inv_n, vx_n, vy_n, vz_n;
   gx = 0.0;
   gy = 0.0;
   gz = 0.0;
-#endif
+#endif  // STATIC_GRAV or GRAVITY
 
 #ifdef DENSITY_FLOOR
   Real dens_0;
 #endif
 
 #ifdef GRAVITY
-  Real d, d_inv, vx, vy, vz;
-  Real gx, gy, gz, d_n, d_inv_n, vx_n, vy_n, vz_n;
   Real pot_l, pot_r;
   int id_l, id_r;
-  gx = 0.0;
-  gy = 0.0;
-  gz = 0.0;
 
   #ifdef GRAVITY_5_POINTS_GRADIENT
   int id_ll, id_rr;
@@ -212,7 +83,8 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
   Real dtodz = dt / dz;
   n_cells    = nx * ny * nz;
 
-  // get a global thread ID
+  // get a global thread ID. The lower dimensional grids have ny = nz = 1 or
+  // nz = 1, so the neighbors along their missing dimensions are never read
   id  = threadIdx.x + blockIdx.x * blockDim.x;
   zid = id / (nx * ny);
   yid = (id - zid * nx * ny) / nx;
@@ -222,8 +94,14 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
   kmo = xid + yid * nx + (zid - 1) * nx * ny;
 
   // threads corresponding to real cells do the calculation
-  if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
-      zid < nz - n_ghost) {
+  bool real_cell = id < n_cells && xid > n_ghost - 1 && xid < nx - n_ghost;
+  if constexpr (dim > 1) {
+    real_cell = real_cell && yid > n_ghost - 1 && yid < ny - n_ghost;
+  }
+  if constexpr (dim > 2) {
+    real_cell = real_cell && zid > n_ghost - 1 && zid < nz - n_ghost;
+  }
+  if (real_cell) {
 #if defined(STATIC_GRAV) || defined(GRAVITY)
     d     = dev_conserved[id];
     d_inv = 1.0 / d;
@@ -233,43 +111,27 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
 #endif
 
     // update the conserved variable array
-    dev_conserved[id] += dtodx * (dev_F_x[imo] - dev_F_x[id]) + dtody * (dev_F_y[jmo] - dev_F_y[id]) +
-                         dtodz * (dev_F_z[kmo] - dev_F_z[id]);
-    dev_conserved[n_cells + id] += dtodx * (dev_F_x[n_cells + imo] - dev_F_x[n_cells + id]) +
-                                   dtody * (dev_F_y[n_cells + jmo] - dev_F_y[n_cells + id]) +
-                                   dtodz * (dev_F_z[n_cells + kmo] - dev_F_z[n_cells + id]);
-    dev_conserved[2 * n_cells + id] += dtodx * (dev_F_x[2 * n_cells + imo] - dev_F_x[2 * n_cells + id]) +
-                                       dtody * (dev_F_y[2 * n_cells + jmo] - dev_F_y[2 * n_cells + id]) +
-                                       dtodz * (dev_F_z[2 * n_cells + kmo] - dev_F_z[2 * n_cells + id]);
-    dev_conserved[3 * n_cells + id] += dtodx * (dev_F_x[3 * n_cells + imo] - dev_F_x[3 * n_cells + id]) +
-                                       dtody * (dev_F_y[3 * n_cells + jmo] - dev_F_y[3 * n_cells + id]) +
-                                       dtodz * (dev_F_z[3 * n_cells + kmo] - dev_F_z[3 * n_cells + id]);
-    dev_conserved[4 * n_cells + id] += dtodx * (dev_F_x[4 * n_cells + imo] - dev_F_x[4 * n_cells + id]) +
-                                       dtody * (dev_F_y[4 * n_cells + jmo] - dev_F_y[4 * n_cells + id]) +
-                                       dtodz * (dev_F_z[4 * n_cells + kmo] - dev_F_z[4 * n_cells + id]);
+    for (int field = 0; field < 5; field++) {
+      dev_conserved[field * n_cells + id] += Flux_Difference<dim>(dev_F_x, dev_F_y, dev_F_z, field * n_cells, id, imo,
+                                                                  jmo, kmo, dtodx, dtody, dtodz);
+    }
 #ifdef SCALAR
     for (int i = 0; i < NSCALARS; i++) {
-      dev_conserved[(5 + i) * n_cells + id] +=
-          dtodx * (dev_F_x[(5 + i) * n_cells + imo] - dev_F_x[(5 + i) * n_cells + id]) +
-          dtody * (dev_F_y[(5 + i) * n_cells + jmo] - dev_F_y[(5 + i) * n_cells + id]) +
-          dtodz * (dev_F_z[(5 + i) * n_cells + kmo] - dev_F_z[(5 + i) * n_cells + id]);
+      Real const change = Flux_Difference<dim>(dev_F_x, dev_F_y, dev_F_z, (5 + i) * n_cells, id, imo, jmo, kmo, dtodx,
+                                               dtody, dtodz);
+      dev_conserved[(5 + i) * n_cells + id] += change;
   #ifdef COOLING_GRACKLE
       // If the updated value is negative, then revert to the value before the
       // update
       if (dev_conserved[(5 + i) * n_cells + id] < 0) {
-        dev_conserved[(5 + i) * n_cells + id] -=
-            dtodx * (dev_F_x[(5 + i) * n_cells + imo] - dev_F_x[(5 + i) * n_cells + id]) +
-            dtody * (dev_F_y[(5 + i) * n_cells + jmo] - dev_F_y[(5 + i) * n_cells + id]) +
-            dtodz * (dev_F_z[(5 + i) * n_cells + kmo] - dev_F_z[(5 + i) * n_cells + id]);
+        dev_conserved[(5 + i) * n_cells + id] -= change;
       }
   #endif
     }
 #endif
 #ifdef DE
-    dev_conserved[(n_fields - 1) * n_cells + id] +=
-        dtodx * (dev_F_x[(n_fields - 1) * n_cells + imo] - dev_F_x[(n_fields - 1) * n_cells + id]) +
-        dtody * (dev_F_y[(n_fields - 1) * n_cells + jmo] - dev_F_y[(n_fields - 1) * n_cells + id]) +
-        dtodz * (dev_F_z[(n_fields - 1) * n_cells + kmo] - dev_F_z[(n_fields - 1) * n_cells + id]);
+    dev_conserved[(n_fields - 1) * n_cells + id] += Flux_Difference<dim>(
+        dev_F_x, dev_F_y, dev_F_z, (n_fields - 1) * n_cells, id, imo, jmo, kmo, dtodx, dtody, dtodz);
     // +  0.5*P*(dtodx*(vx_imo-vx_ipo) + dtody*(vy_jmo-vy_jpo) +
     // dtodz*(vz_kmo-vz_kpo));
     // Note: this term is added in a separate kernel to avoid synchronization
@@ -290,7 +152,7 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
   #ifdef DE
         dev_conserved[(n_fields - 1) * n_cells + id] *= (density_floor / dens_0);
   #endif
-      } else {
+      } else if constexpr (dim == 3) {
         // If the density is negative: average the density on that cell
         dens_0 = dev_conserved[id];
         Average_Cell_Single_Field(0, xid, yid, zid, nx, ny, nz, n_cells, dev_conserved);
@@ -299,8 +161,23 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
 #endif  // DENSITY_FLOOR
 
 #ifdef STATIC_GRAV
-    calc_g_3D(xid, yid, zid, x_off, y_off, z_off, n_ghost, custom_grav, dx, dy, dz, xbound, ybound, zbound, &gx, &gy,
-              &gz);
+    // calculate the gravitational acceleration as a function of position
+  #ifdef STATIC_GRAV_CACHE
+    bool const cached = static_grav.Load(x_off + xid, y_off + yid, z_off + zid, gx, gy, gz);
+  #else   // not STATIC_GRAV_CACHE
+    bool const cached = false;
+  #endif  // STATIC_GRAV_CACHE
+    if (!cached) {
+      if constexpr (dim == 1) {
+        calc_g_1D(xid, x_off, n_ghost, custom_grav, dx, xbound, &gx);
+      } else if constexpr (dim == 2) {
+        calc_g_2D(xid, yid, x_off, y_off, n_ghost, custom_grav, dx, dy, xbound, ybound, &gx, &gy);
+      } else {
+        calc_g_3D(xid, yid, zid, x_off, y_off, z_off, n_ghost, custom_grav, dx, dy, dz, xbound, ybound, zbound, &gx,
+                  &gy, &gz);
+      }
+    }
+    // add gravitational source terms, time averaged from n to n+1
     d_n     = dev_conserved[id];
     d_inv_n = 1.0 / d_n;
     vx_n    = dev_conserved[1 * n_cells + id] * d_inv_n;
@@ -315,92 +192,226 @@ __global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, R
 #endif
 
 #ifdef GRAVITY
-    d_n     = dev_conserved[id];
-    d_inv_n = 1.0 / d_n;
-    vx_n    = dev_conserved[1 * n_cells + id] * d_inv_n;
-    vy_n    = dev_conserved[2 * n_cells + id] * d_inv_n;
-    vz_n    = dev_conserved[3 * n_cells + id] * d_inv_n;
-
-    // Calculate the -gradient of potential
-    // Get X componet of gravity field
-    id_l  = (xid - 1) + (yid)*nx + (zid)*nx * ny;
-    id_r  = (xid + 1) + (yid)*nx + (zid)*nx * ny;
-    pot_l = dev_potential[id_l];
-    pot_r = dev_potential[id_r];
+    // The potential is only solved for 3D grids
+    if constexpr (dim == 3) {
+      d_n     = dev_conserved[id];
+      d_inv_n = 1.0 / d_n;
+      vx_n    = dev_conserved[1 * n_cells + id] * d_inv_n;
+      vy_n    = dev_conserved[2 * n_cells + id] * d_inv_n;
+      vz_n    = dev_conserved[3 * n_cells + id] * d_inv_n;
+
+      // Calculate the -gradient of potential
+      // Get X componet of gravity field
+      id_l  = (xid - 1) + (yid)*nx + (zid)*nx * ny;
+      id_r  = (xid + 1) + (yid)*nx + (zid)*nx * ny;
+      pot_l = dev_potential[id_l];
+      pot_r = dev_potential[id_r];
   #ifdef GRAVITY_5_POINTS_GRADIENT
-    id_ll  = (xid - 2) + (yid)*nx + (zid)*nx * ny;
-    id_rr  = (xid + 2) + (yid)*nx + (zid)*nx * ny;
-    pot_ll = dev_potential[id_ll];
-    pot_rr = dev_potential[id_rr];
-    gx     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
+      id_ll  = (xid - 2) + (yid)*nx + (zid)*nx * ny;
+      id_rr  = (xid + 2) + (yid)*nx + (zid)*nx * ny;
+      pot_ll = dev_potential[id_ll];
+      pot_rr = dev_potential[id_rr];
+      gx     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
   #else
-    gx = -0.5 * (pot_r - pot_l) / dx;
+      gx = -0.5 * (pot_r - pot_l) / dx;
   #endif
 
-    // Get Y componet of gravity field
-    id_l  = (xid) + (yid - 1) * nx + (zid)*nx * ny;
-    id_r  = (xid) + (yid + 1) * nx + (zid)*nx * ny;
-    pot_l = dev_potential[id_l];
-    pot_r = dev_potential[id_r];
+      // Get Y componet of gravity field
+      id_l  = (xid) + (yid - 1) * nx + (zid)*nx * ny;
+      id_r  = (xid) + (yid + 1) * nx + (zid)*nx * ny;
+      pot_l = dev_potential[id_l];
+      pot_r = dev_potential[id_r];
   #ifdef GRAVITY_5_POINTS_GRADIENT
-    id_ll  = (xid) + (yid - 2) * nx + (zid)*nx * ny;
-    id_rr  = (xid) + (yid + 2) * nx + (zid)*nx * ny;
-    pot_ll = dev_potential[id_ll];
-    pot_rr = dev_potential[id_rr];
-    gy     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
+      id_ll  = (xid) + (yid - 2) * nx + (zid)*nx * ny;
+      id_rr  = (xid) + (yid + 2) * nx + (zid)*nx * ny;
+      pot_ll = dev_potential[id_ll];
+      pot_rr = dev_potential[id_rr];
+      gy     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
   #else
-    gy = -0.5 * (pot_r - pot_l) / dy;
+      gy = -0.5 * (pot_r - pot_l) / dy;
   #endif
-    // Get Z componet of gravity field
-    id_l  = (xid) + (yid)*nx + (zid - 1) * nx * ny;
-    id_r  = (xid) + (yid)*nx + (zid + 1) * nx * ny;
-    pot_l = dev_potential[id_l];
-    pot_r = dev_potential[id_r];
+      // Get Z componet of gravity field
+      id_l  = (xid) + (yid)*nx + (zid - 1) * nx * ny;
+      id_r  = (xid) + (yid)*nx + (zid + 1) * nx * ny;
+      pot_l = dev_potential[id_l];
+      pot_r = dev_potential[id_r];
   #ifdef GRAVITY_5_POINTS_GRADIENT
-    id_ll  = (xid) + (yid)*nx + (zid - 2) * nx * ny;
-    id_rr  = (xid) + (yid)*nx + (zid + 2) * nx * ny;
-    pot_ll = dev_potential[id_ll];
-    pot_rr = dev_potential[id_rr];
-    gz     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
+      id_ll  = (xid) + (yid)*nx + (zid - 2) * nx * ny;
+      id_rr  = (xid) + (yid)*nx + (zid + 2) * nx * ny;
+      pot_ll = dev_potential[id_ll];
+      pot_rr = dev_potential[id_rr];
+      gz     = -1 * (-pot_rr + 8 * pot_r - 8 * pot_l + pot_ll) / (12 * dx);
   #else
-    gz = -0.5 * (pot_r - pot_l) / dz;
+      gz = -0.5 * (pot_r - pot_l) / dz;
   #endif
 
-    // Add gravity term to Momentum
-    dev_conserved[n_cells + id] += 0.5 * dt * gx * (d + d_n);
-    dev_conserved[2 * n_cells + id] += 0.5 * dt * gy * (d + d_n);
-    dev_conserved[3 * n_cells + id] += 0.5 * dt * gz * (d + d_n);
-
-    // Add gravity term to Total Energy
-    // Add the work done by the gravitational force
-    dev_conserved[4 * n_cells + id] +=
-        0.5 * dt * (gx * (d * vx + d_n * vx_n) + gy * (d * vy + d_n * vy_n) + gz * (d * vz + d_n * vz_n));
+      // Add gravity term to Momentum
+      dev_conserved[n_cells + id] += 0.5 * dt * gx * (d + d_n);
+      dev_conserved[2 * n_cells + id] += 0.5 * dt * gy * (d + d_n);
+      dev_conserved[3 * n_cells + id] += 0.5 * dt * gz * (d + d_n);
 
+      // Add gravity term to Total Energy
+      // Add the work done by the gravitational force
+      dev_conserved[4 * n_cells + id] +=
+          0.5 * dt * (gx * (d * vx + d_n * vx_n) + gy * (d * vy + d_n * vy_n) + gz * (d * vz + d_n * vz_n));
+    }
 #endif  // GRAVITY
 
 #if !(defined(DENSITY_FLOOR) && defined(TEMPERATURE_FLOOR))
     if (dev_conserved[id] < 0.0 || dev_conserved[id] != dev_conserved[id] || dev_conserved[4 * n_cells + id] < 0.0 ||
         dev_conserved[4 * n_cells + id] != dev_conserved[4 * n_cells + id]) {
-      printf("%3d %3d %3d Thread crashed in final update. %e %e %e %e %e\n", xid + x_off, yid + y_off, zid + z_off,
-             dev_conserved[id], dtodx * (dev_F_x[imo] - dev_F_x[id]), dtody * (dev_F_y[jmo] - dev_F_y[id]),
-             dtodz * (dev_F_z[kmo] - dev_F_z[id]), dev_conserved[4 * n_cells + id]);
-      Average_Cell_All_Fields(xid, yid, zid, nx, ny, nz, n_cells, n_fields, gamma, dev_conserved);
+      printf("%3d %3d %3d Thread crashed in final update. %e %e %e\n", xid + x_off, yid + y_off, zid + z_off,
+             dev_conserved[id],
+             Flux_Difference<dim>(dev_F_x, dev_F_y, dev_F_z, 0, id, imo, jmo, kmo, dtodx, dtody, dtodz),
+             dev_conserved[4 * n_cells + id]);
+      // Averaging the crashed cell reads its neighbors along all three axes
+      if constexpr (dim == 3) {
+        Average_Cell_All_Fields(xid, yid, zid, nx, ny, nz, n_cells, n_fields, gamma, dev_conserved);
+      }
     }
 #endif  // DENSITY_FLOOR
-    /*
-    d  =  dev_conserved[            id];
-    d_inv = 1.0 / d;
-    vx =  dev_conserved[1*n_cells + id] * d_inv;
-    vy =  dev_conserved[2*n_cells + id] * d_inv;
-    vz =  dev_conserved[3*n_cells + id] * d_inv;
-    P  = (dev_conserved[4*n_cells + id] - 0.5*d*(vx*vx + vy*vy + vz*vz)) *
-    (gamma - 1.0); if (P < 0.0) printf("%3d %3d %3d Negative pressure after
-    final update. %f %f %f %f %f\n", xid, yid, zid, dev_conserved[4*n_cells +
-    id], 0.5*d*vx*vx, 0.5*d*vy*vy, 0.5*d*vz*vz, P);
-    */
   }
 }
 
+// The generic kernels and the ones specialized for the field count of this
+// build
+template __global__ void Update_Conserved_Variables<1, 0>(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly,
+                                                          Real *Q_Ry, Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                          Real *dev_F_y, Real *dev_F_z, int nx, int ny, int nz,
+                                                          int x_off, int y_off, int z_off, int n_ghost, Real dx,
+                                                          Real dy, Real dz, Real xbound, Real ybound, Real zbound,
+                                                          Real dt, Real gamma, int n_fields, int custom_grav,
+                                                          Real density_floor, Real *dev_potential,
+                                                          StaticGravityTable static_grav);
+template __global__ void Update_Conserved_Variables<1, grid_enum::num_fields>(Real *dev_conserved, Real *Q_Lx,
+                                                                              Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
+                                                                              Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                                              Real *dev_F_y, Real *dev_F_z, int nx,
+                                                                              int ny, int nz, int x_off, int y_off,
+                                                                              int z_off, int n_ghost, Real dx, Real dy,
+                                                                              Real dz, Real xbound, Real ybound,
+                                                                              Real zbound, Real dt, Real gamma,
+                                                                              int n_fields, int custom_grav,
+                                                                              Real density_floor, Real *dev_potential,
+                                                                              StaticGravityTable static_grav);
+template __global__ void Update_Conserved_Variables<2, 0>(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly,
+                                                          Real *Q_Ry, Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                          Real *dev_F_y, Real *dev_F_z, int nx, int ny, int nz,
+                                                          int x_off, int y_off, int z_off, int n_ghost, Real dx,
+                                                          Real dy, Real dz, Real xbound, Real ybound, Real zbound,
+                                                          Real dt, Real gamma, int n_fields, int custom_grav,
+                                                          Real density_floor, Real *dev_potential,
+                                                          StaticGravityTable static_grav);
+template __global__ void Update_Conserved_Variables<2, grid_enum::num_fields>(Real *dev_conserved, Real *Q_Lx,
+                                                                              Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
+                                                                              Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                                              Real *dev_F_y, Real *dev_F_z, int nx,
+                                                                              int ny, int nz, int x_off, int y_off,
+                                                                              int z_off, int n_ghost, Real dx, Real dy,
+                                                                              Real dz, Real xbound, Real ybound,
+                                                                              Real zbound, Real dt, Real gamma,
+                                                                              int n_fields, int custom_grav,
+                                                                              Real density_floor, Real *dev_potential,
+                                                                              StaticGravityTable static_grav);
+template __global__ void Update_Conserved_Variables<3, 0>(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly,
+                                                          Real *Q_Ry, Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                          Real *dev_F_y, Real *dev_F_z, int nx, int ny, int nz,
+                                                          int x_off, int y_off, int z_off, int n_ghost, Real dx,
+                                                          Real dy, Real dz, Real xbound, Real ybound, Real zbound,
+                                                          Real dt, Real gamma, int n_fields, int custom_grav,
+                                                          Real density_floor, Real *dev_potential,
+                                                          StaticGravityTable static_grav);
+template __global__ void Update_Conserved_Variables<3, grid_enum::num_fields>(Real *dev_conserved, Real *Q_Lx,
+                                                                              Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
+                                                                              Real *Q_Lz, Real *Q_Rz, Real *dev_F_x,
+                                                                              Real *dev_F_y, Real *dev_F_z, int nx,
+                                                                              int ny, int nz, int x_off, int y_off,
+                                                                              int z_off, int n_ghost, Real dx, Real dy,
+                                                                              Real dz, Real xbound, Real ybound,
+                                                                              Real zbound, Real dt, Real gamma,
+                                                                              int n_fields, int custom_grav,
+                                                                              Real density_floor, Real *dev_potential,
+                                                                              StaticGravityTable static_grav);
+
+template <int dim>
+decltype(&Update_Conserved_Variables<dim, 0>) Select_Update_Conserved_Variables(int n_fields)
+{
+  if (n_fields == grid_enum::num_fields) {
+    return Update_Conserved_Variables<dim, grid_enum::num_fields>;
+  }
+  return Update_Conserved_Variables<dim, 0>;
+}
+template decltype(&Update_Conserved_Variables<1, 0>) Select_Update_Conserved_Variables<1>(int n_fields);
+template decltype(&Update_Conserved_Variables<2, 0>) Select_Update_Conserved_Variables<2>(int n_fields);
+template decltype(&Update_Conserved_Variables<3, 0>) Select_Update_Conserved_Variables<3>(int n_fields);
+
+StaticGravityTable static_grav_table;
+
+#ifdef STATIC_GRAV_CACHE
+  #ifndef STATIC_GRAV
+    #error "STATIC_GRAV_CACHE requires STATIC_GRAV"
+  #endif  // STATIC_GRAV
+namespace
+{
+__global__ void Compute_Static_Gravity_Table(Static_Grav_Real *dev_g, int nx, int ny, int nz, int x_off, int y_off,
+                                             int z_off, int n_ghost, int custom_grav, Real dx, Real dy, Real dz,
+                                             Real xbound, Real ybound, Real zbound)
+{
+  int const n_cells = nx * ny * nz;
+  int const id      = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id >= n_cells) {
+    return;
+  }
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+
+  // The same calls as Update_Conserved_Variables makes for the dimensions of
+  // the grid
+  Real gx = 0.0, gy = 0.0, gz = 0.0;
+  if (ny == 1 && nz == 1) {
+    calc_g_1D(xid, x_off, n_ghost, custom_grav, dx, xbound, &gx);
+  } else if (nz == 1) {
+    calc_g_2D(xid, yid, x_off, y_off, n_ghost, custom_grav, dx, dy, xbound, ybound, &gx, &gy);
+  } else {
+    calc_g_3D(xid, yid, zid, x_off, y_off, z_off, n_ghost, custom_grav, dx, dy, dz, xbound, ybound, zbound, &gx, &gy,
+              &gz);
+  }
+  dev_g[id]               = gx;
+  dev_g[n_cells + id]     = gy;
+  dev_g[2 * n_cells + id] = gz;
+}
+}  // namespace
+#endif  // STATIC_GRAV_CACHE
+
+void Update_Static_Gravity_Table(int nx, int ny, int nz, int x_off, int y_off, int z_off, int n_ghost, int custom_grav,
+                                 Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound)
+{
+#ifdef STATIC_GRAV_CACHE
+  // The arguments of the table currently in dev_g
+  using Arguments = std::tuple<int, int, int, int, int, int, int, int, Real, Real, Real, Real, Real, Real>;
+  static Arguments built;
+  static bool is_built = false;
+  cuda_utilities::DeviceVector<Static_Grav_Real> static dev_g(1);
+
+  Arguments const requested(nx, ny, nz, x_off, y_off, z_off, n_ghost, custom_grav, dx, dy, dz, xbound, ybound, zbound);
+  if (is_built && built == requested) {
+    return;
+  }
+
+  int const n_cells = nx * ny * nz;
+  if (dev_g.size() != size_t(3 * n_cells)) {
+    dev_g.reset(3 * n_cells);
+  }
+  hipLaunchKernelGGL(Compute_Static_Gravity_Table, (n_cells + TPB - 1) / TPB, TPB, 0, 0, dev_g.data(), nx, ny, nz,
+                     x_off, y_off, z_off, n_ghost, custom_grav, dx, dy, dz, xbound, ybound, zbound);
+  GPU_Error_Check();
+
+  static_grav_table = {dev_g.data(), nx, ny, nz, x_off, y_off, z_off};
+  built             = requested;
+  is_built          = true;
+#endif  // STATIC_GRAV_CACHE
+}
+
 __device__ __host__ Real hydroInverseCrossingTime(Real const &E, Real const &d, Real const &d_inv, Real const &vx,
                                                   Real const &vy, Real const &vz, Real const &dx, Real const &dy,
                                                   Real const &dz, Real const &gamma)
@@ -512,9 +523,11 @@ __global__ void Calc_dt_2D(Real *dev_conserved, Real *dev_dti, Real gamma, int n
 }
 
 __global__ void Calc_dt_3D(Real *dev_conserved, Real *dev_dti, Real gamma, int n_ghost, int n_fields, int nx, int ny,
-                           int nz, Real dx, Real dy, Real dz)
+                           int nz, Real dx, Real dy, Real dz, Real *dev_max_divergence, Real *dev_magnetic_centered,
+                           Real max_dti_slow, int *dev_slow_cells, int *dev_n_slow)
 {
-  Real max_dti = -DBL_MAX;
+  Real max_dti        = -DBL_MAX;
+  Real max_divergence = 0.0;
 
   Real d, d_inv, vx, vy, vz, E;
   int xid, yid, zid, n_cells;
@@ -530,6 +543,18 @@ __global__ void Calc_dt_3D(Real *dev_conserved, Real *dev_dti, Real gamma, int n
     // get a global thread ID
     cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
 
+#ifdef MHD
+    // Cache the cell centered magnetic field of every cell, ghost cells
+    // included, for the output after the update
+    if (dev_magnetic_centered != nullptr) {
+      auto const [cachedBx, cachedBy, cachedBz] =
+          mhd::utils::cellCenteredMagneticFields(dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+      dev_magnetic_centered[id]               = cachedBx;
+      dev_magnetic_centered[n_cells + id]     = cachedBy;
+      dev_magnetic_centered[2 * n_cells + id] = cachedBz;
+    }
+#endif  // MHD
+
     // threads corresponding to real cells do the calculation
     if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
         zid < nz - n_ghost) {
@@ -549,47 +574,79 @@ __global__ void Calc_dt_3D(Real *dev_conserved, Real *dev_dti, Real gamma, int n
       auto const [avgBx, avgBy, avgBz] =
           mhd::utils::cellCenteredMagneticFields(dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
       max_dti = fmax(max_dti, mhdInverseCrossingTime(E, d, d_inv, vx, vy, vz, avgBx, avgBy, avgBz, dx, dy, dz, gamma));
+
+      // The faces of the divergence are already loaded for the cell centered
+      // field
+      max_divergence = fmax(max_divergence, fabs(mhd::utils::computeMagneticDivergence(
+                                                dev_conserved, id, xid, yid, zid, n_cells, nx, ny, dx, dy, dz)));
 #else   // not MHD
-      max_dti = fmax(max_dti, hydroInverseCrossingTime(E, d, d_inv, vx, vy, vz, dx, dy, dz, gamma));
+      Real const cell_dti = hydroInverseCrossingTime(E, d, d_inv, vx, vy, vz, dx, dy, dz, gamma);
+      if (dev_n_slow != nullptr && cell_dti > max_dti_slow) {
+        // The slow cell is averaged by Average_Slow_Cells_3D, which reduces
+        // its new inverse crossing time instead
+        dev_slow_cells[atomicAdd(dev_n_slow, 1)] = id;
+      } else {
+        max_dti = fmax(max_dti, cell_dti);
+      }
 #endif  // MHD
     }
   }
 
   // do the grid wide reduction (find the max inverse timestep in the grid)
   reduction_utilities::gridReduceMax(max_dti, dev_dti);
+  if (dev_max_divergence != nullptr) {
+    reduction_utilities::gridReduceMax(max_divergence, dev_max_divergence);
+  }
 }
 
-Real Calc_dt_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy, Real dz,
-                 Real gamma)
+namespace
 {
-  // Allocate the device memory
-  cuda_utilities::DeviceVector<Real> static dev_dti(1);
-
-  // Set the device side inverse time step to the smallest possible double so
-  // that the reduction isn't using the maximum value of the previous iteration
-  dev_dti.assign(std::numeric_limits<double>::lowest());
+// Event based timer of the time step reduction kernels, printed at the end of
+// the run when CPU_TIME is on
+GpuTimer calc_dt_timer("Calc_dt");
+}  // namespace
 
-  // compute dt and store in dev_dti
+void Reduce_dti_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy, Real dz,
+                    Real gamma, Real *dev_dti, Real *dev_max_divergence, Real *dev_magnetic_centered)
+{
+  // compute dt and reduce it into dev_dti
+  calc_dt_timer.Start();
   if (nx > 1 && ny == 1 && nz == 1)  // 1D
   {
     // set launch parameters for GPU kernels.
     cuda_utilities::AutomaticLaunchParams static const launchParams(Calc_dt_1D);
-    hipLaunchKernelGGL(Calc_dt_1D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved,
-                       dev_dti.data(), gamma, n_ghost, nx, dx);
+    hipLaunchKernelGGL(Calc_dt_1D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved, dev_dti,
+                       gamma, n_ghost, nx, dx);
   } else if (nx > 1 && ny > 1 && nz == 1)  // 2D
   {
     // set launch parameters for GPU kernels.
     cuda_utilities::AutomaticLaunchParams static const launchParams(Calc_dt_2D);
-    hipLaunchKernelGGL(Calc_dt_2D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved,
-                       dev_dti.data(), gamma, n_ghost, nx, ny, dx, dy);
+    hipLaunchKernelGGL(Calc_dt_2D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved, dev_dti,
+                       gamma, n_ghost, nx, ny, dx, dy);
   } else if (nx > 1 && ny > 1 && nz > 1)  // 3D
   {
     // set launch parameters for GPU kernels.
     cuda_utilities::AutomaticLaunchParams static const launchParams(Calc_dt_3D);
-    hipLaunchKernelGGL(Calc_dt_3D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved,
-                       dev_dti.data(), gamma, n_ghost, n_fields, nx, ny, nz, dx, dy, dz);
+    hipLaunchKernelGGL(Calc_dt_3D, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0, dev_conserved, dev_dti,
+                       gamma, n_ghost, n_fields, nx, ny, nz, dx, dy, dz, dev_max_divergence, dev_magnetic_centered, 0,
+                       nullptr, nullptr);
   }
+  calc_dt_timer.Stop();
   GPU_Error_Check();
+}
+
+Real Calc_dt_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy, Real dz,
+                 Real gamma)
+{
+  // Allocate the device memory
+  cuda_utilities::DeviceVector<Real> static dev_dti(1);
+
+  // Set the device side inverse time step to the smallest possible double so
+  // that the reduction isn't using the maximum value of the previous iteration
+  dev_dti.assign(std::numeric_limits<double>::lowest());
+
+  // compute dt and store in dev_dti
+  Reduce_dti_GPU(dev_conserved, nx, ny, nz, n_ghost, n_fields, dx, dy, dz, gamma, dev_dti.data());
 
   // Note: dev_dti[0] is DeviceVector syntactic sugar for returning a value via
   // cudaMemcpy
@@ -598,39 +655,51 @@ Real Calc_dt_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n
 
 #ifdef AVERAGE_SLOW_CELLS
 
-void Average_Slow_Cells(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy,
-                        Real dz, Real gamma, Real max_dti_slow)
+void Reduce_dti_Average_Slow_Cells(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx,
+                                   Real dy, Real dz, Real gamma, Real max_dti_slow, Real *dev_dti)
 {
-  // set values for GPU kernels
-  int n_cells = nx * ny * nz;
-  int ngrid   = (n_cells + TPB - 1) / TPB;
-  // number of blocks per 1D grid
-  dim3 dim1dGrid(ngrid, 1, 1);
-  //  number of threads per 1D block
-  dim3 dim1dBlock(TPB, 1, 1);
+  if (nx == 1 || ny == 1 || nz == 1) {
+    // Only 3D grids average the slow cells
+    Reduce_dti_GPU(dev_conserved, nx, ny, nz, n_ghost, n_fields, dx, dy, dz, gamma, dev_dti);
+    return;
+  }
 
-  if (nx > 1 && ny > 1 && nz > 1) {  // 3D
-    hipLaunchKernelGGL(Average_Slow_Cells_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields,
-                       dx, dy, dz, gamma, max_dti_slow);
+  // The slow cells are rare, so Calc_dt_3D lists them and only the listed
+  // cells are averaged, instead of checking every cell in another pass
+  int const n_cells = nx * ny * nz;
+  cuda_utilities::DeviceVector<int> static slow_cells(1);
+  cuda_utilities::DeviceVector<int> static n_slow(1);
+  cuda_utilities::AutomaticLaunchParams static const dtParams(Calc_dt_3D);
+  cuda_utilities::AutomaticLaunchParams static const averageParams(Average_Slow_Cells_3D);
+  if (slow_cells.size() < size_t(n_cells)) {
+    slow_cells.resize(n_cells);
   }
+  n_slow.assign(0);
+
+  calc_dt_timer.Start();
+  hipLaunchKernelGGL(Calc_dt_3D, dtParams.numBlocks, dtParams.threadsPerBlock, 0, 0, dev_conserved, dev_dti, gamma,
+                     n_ghost, n_fields, nx, ny, nz, dx, dy, dz, nullptr, nullptr, max_dti_slow, slow_cells.data(),
+                     n_slow.data());
+  hipLaunchKernelGGL(Average_Slow_Cells_3D, averageParams.numBlocks, averageParams.threadsPerBlock, 0, 0, dev_conserved,
+                     nx, ny, nz, n_fields, dx, dy, dz, gamma, max_dti_slow, slow_cells.data(), n_slow.data(), dev_dti);
+  calc_dt_timer.Stop();
+  GPU_Error_Check();
 }
 
-__global__ void Average_Slow_Cells_3D(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx,
-                                      Real dy, Real dz, Real gamma, Real max_dti_slow)
+__global__ void Average_Slow_Cells_3D(Real *dev_conserved, int nx, int ny, int nz, int n_fields, Real dx, Real dy,
+                                      Real dz, Real gamma, Real max_dti_slow, int const *dev_slow_cells,
+                                      int const *dev_n_slow, Real *dev_dti)
 {
-  int id, xid, yid, zid, n_cells;
+  int xid, yid, zid;
   Real d, d_inv, vx, vy, vz, E, max_dti;
   Real speed, temp, P, cs;
 
-  // get a global thread ID
-  id      = threadIdx.x + blockIdx.x * blockDim.x;
-  n_cells = nx * ny * nz;
-
-  cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+  int const n_cells = nx * ny * nz;
+  int const n_slow  = *dev_n_slow;
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < n_slow; i += blockDim.x * gridDim.x) {
+    int const id = dev_slow_cells[i];
+    cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
 
-  // threads corresponding to real cells do the calculation
-  if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
-      zid < nz - n_ghost) {
     d     = dev_conserved[id];
     d_inv = 1.0 / d;
     vx    = dev_conserved[1 * n_cells + id] * d_inv;
@@ -638,23 +707,31 @@ __global__ void Average_Slow_Cells_3D(Real *dev_conserved, int nx, int ny, int n
     vz    = dev_conserved[3 * n_cells + id] * d_inv;
     E     = dev_conserved[4 * n_cells + id];
 
-    // Compute the maximum inverse crossing time in the cell
+    // Calc_dt_3D only lists the cells whose inverse crossing time is above
+    // max_dti_slow
     max_dti = hydroInverseCrossingTime(E, d, d_inv, vx, vy, vz, dx, dy, dz, gamma);
 
-    if (max_dti > max_dti_slow) {
-      speed = sqrt(vx * vx + vy * vy + vz * vz);
-      temp  = (gamma - 1) * (E - 0.5 * (speed * speed) * d) * ENERGY_UNIT / (d * DENSITY_UNIT / 0.6 / MP) / KB;
-      P     = (E - 0.5 * d * (vx * vx + vy * vy + vz * vz)) * (gamma - 1.0);
-      cs    = sqrt(d_inv * gamma * P) * VELOCITY_UNIT * 1e-5;
-      // Average this cell
-      kernel_printf(
-          " Average Slow Cell [ %d %d %d ] -> dt_cell=%f    dt_min=%f, n=%.3e, "
-          "T=%.3e, v=%.3e (%.3e, %.3e, %.3e), cs=%.3e\n",
-          xid, yid, zid, 1. / max_dti, 1. / max_dti_slow, dev_conserved[id] * DENSITY_UNIT / 0.6 / MP, temp,
-          speed * VELOCITY_UNIT * 1e-5, vx * VELOCITY_UNIT * 1e-5, vy * VELOCITY_UNIT * 1e-5, vz * VELOCITY_UNIT * 1e-5,
-          cs);
-      Average_Cell_All_Fields(xid, yid, zid, nx, ny, nz, n_cells, n_fields, gamma, dev_conserved);
-    }
+    speed = sqrt(vx * vx + vy * vy + vz * vz);
+    temp  = (gamma - 1) * (E - 0.5 * (speed * speed) * d) * ENERGY_UNIT / (d * DENSITY_UNIT / 0.6 / MP) / KB;
+    P     = (E - 0.5 * d * (vx * vx + vy * vy + vz * vz)) * (gamma - 1.0);
+    cs    = sqrt(d_inv * gamma * P) * VELOCITY_UNIT * 1e-5;
+    // Average this cell
+    kernel_printf(
+        " Average Slow Cell [ %d %d %d ] -> dt_cell=%f    dt_min=%f, n=%.3e, "
+        "T=%.3e, v=%.3e (%.3e, %.3e, %.3e), cs=%.3e\n",
+        xid, yid, zid, 1. / max_dti, 1. / max_dti_slow, dev_conserved[id] * DENSITY_UNIT / 0.6 / MP, temp,
+        speed * VELOCITY_UNIT * 1e-5, vx * VELOCITY_UNIT * 1e-5, vy * VELOCITY_UNIT * 1e-5, vz * VELOCITY_UNIT * 1e-5,
+        cs);
+    Average_Cell_All_Fields(xid, yid, zid, nx, ny, nz, n_cells, n_fields, gamma, dev_conserved);
+
+    // The timestep has to hold for the averaged state
+    d     = dev_conserved[id];
+    d_inv = 1.0 / d;
+    vx    = dev_conserved[1 * n_cells + id] * d_inv;
+    vy    = dev_conserved[2 * n_cells + id] * d_inv;
+    vz    = dev_conserved[3 * n_cells + id] * d_inv;
+    E     = dev_conserved[4 * n_cells + id];
+    reduction_utilities::atomicMaxBits(dev_dti, hydroInverseCrossingTime(E, d, d_inv, vx, vy, vz, dx, dy, dz, gamma));
   }
 }
 #endif  // AVERAGE_SLOW_CELLS
@@ -1118,7 +1195,6 @@ __global__ void Temperature_Floor_Kernel(Real *dev_conserved, int nx, int ny, in
                                          Real U_floor)
 {
   int id, xid, yid, zid, n_cells;
-  Real d, d_inv, vx, vy, vz, E, Ekin, U;
   n_cells = nx * ny * nz;
 
   // get a global thread ID
@@ -1130,25 +1206,7 @@ __global__ void Temperature_Floor_Kernel(Real *dev_conserved, int nx, int ny, in
   // threads corresponding to real cells do the calculation
   if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
       zid < nz - n_ghost) {
-    d     = dev_conserved[id];
-    d_inv = 1.0 / d;
-    vx    = dev_conserved[1 * n_cells + id] * d_inv;
-    vy    = dev_conserved[2 * n_cells + id] * d_inv;
-    vz    = dev_conserved[3 * n_cells + id] * d_inv;
-    E     = dev_conserved[4 * n_cells + id];
-    Ekin  = 0.5 * d * (vx * vx + vy * vy + vz * vz);
-
-    U = (E - Ekin) / d;
-    if (U < U_floor) {
-      dev_conserved[4 * n_cells + id] = Ekin + d * U_floor;
-    }
-
-#ifdef DE
-    U = dev_conserved[(n_fields - 1) * n_cells + id] / d;
-    if (U < U_floor) {
-      dev_conserved[(n_fields - 1) * n_cells + id] = d * U_floor;
-    }
-#endif
+    Temperature_Floor_Cell(dev_conserved, id, n_cells, n_fields, U_floor);
   }
 }
 
@@ -1305,3 +1363,43 @@ __global__ void Scalar_Floor_Kernel(Real *dev_conserved, int nx, int ny, int nz,
     }
   }
 }
+
+#ifdef POST_UPDATE_KERNEL
+__global__ void Sync_Energies_And_Apply_Floors_3D(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, Real gamma,
+                                                  int n_fields, Real U_floor, Real scalar_floor)
+{
+  int const n_cells = nx * ny * nz;
+
+  // get a global thread ID
+  int const id  = threadIdx.x + blockIdx.x * blockDim.x;
+  int const zid = id / (nx * ny);
+  int const yid = (id - zid * nx * ny) / nx;
+  int const xid = id - zid * nx * ny - yid * nx;
+
+  // threads corresponding to real cells do the calculation
+  if (xid > n_ghost - 1 && xid < nx - n_ghost && yid > n_ghost - 1 && yid < ny - n_ghost && zid > n_ghost - 1 &&
+      zid < nz - n_ghost) {
+  #ifdef DE
+    // Use the internal energy picked by Select_Internal_Energy_3D to update the
+    // total energy, like Sync_Energies_3D
+    Real const d     = dev_conserved[id];
+    Real const d_inv = 1.0 / d;
+    Real const vx    = dev_conserved[1 * n_cells + id] * d_inv;
+    Real const vy    = dev_conserved[2 * n_cells + id] * d_inv;
+    Real const vz    = dev_conserved[3 * n_cells + id] * d_inv;
+    Real const U     = dev_conserved[(n_fields - 1) * n_cells + id];
+    dev_conserved[4 * n_cells + id] = 0.5 * d * (vx * vx + vy * vy + vz * vz) + U;
+  #endif  // DE
+
+  #ifdef TEMPERATURE_FLOOR
+    Temperature_Floor_Cell(dev_conserved, id, n_cells, n_fields, U_floor);
+  #endif  // TEMPERATURE_FLOOR
+
+  #if defined(SCALAR_FLOOR) && defined(DUST)
+    if (dev_conserved[id + n_cells * grid_enum::dust_density] < scalar_floor) {
+      dev_conserved[id + n_cells * grid_enum::dust_density] = scalar_floor;
+    }
+  #endif  // SCALAR_FLOOR and DUST
+  }
+}
+#endif  // POST_UPDATE_KERNEL
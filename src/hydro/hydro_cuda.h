@@ -5,21 +5,80 @@
 #define HYDRO_CUDA_H
 
 #include "../global/global.h"
+#include "../grid/grid_enum.h"
 #include "../utils/mhd_utilities.h"
 
-__global__ void Update_Conserved_Variables_1D(Real *dev_conserved, Real *dev_F, int n_cells, int x_off, int n_ghost,
-                                              Real dx, Real xbound, Real dt, Real gamma, int n_fields, int custom_grav);
-
-__global__ void Update_Conserved_Variables_2D(Real *dev_conserved, Real *dev_F_x, Real *dev_F_y, int nx, int ny,
-                                              int x_off, int y_off, int n_ghost, Real dx, Real dy, Real xbound,
-                                              Real ybound, Real dt, Real gamma, int n_fields, int custom_grav);
-
-__global__ void Update_Conserved_Variables_3D(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
-                                              Real *Q_Lz, Real *Q_Rz, Real *dev_F_x, Real *dev_F_y, Real *dev_F_z,
-                                              int nx, int ny, int nz, int x_off, int y_off, int z_off, int n_ghost,
-                                              Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound, Real dt,
-                                              Real gamma, int n_fields, int custom_grav, Real density_floor,
-                                              Real *dev_potential);
+#ifdef STATIC_GRAV_CACHE_FLOAT
+typedef float Static_Grav_Real;
+#else   // not STATIC_GRAV_CACHE_FLOAT
+typedef Real Static_Grav_Real;
+#endif  // STATIC_GRAV_CACHE_FLOAT
+
+/*! \brief The static gravitational acceleration of every cell of the local
+ *  grid, precomputed by Update_Static_Gravity_Table. The table is indexed with
+ *  the global cell indices so the integrators that update sub-grids with
+ *  shifted offsets read the same values as the full grid. The default table is
+ *  empty and every lookup misses. */
+struct StaticGravityTable {
+  Static_Grav_Real const *g = nullptr;  // gx, gy and gz in blocks of nx * ny * nz
+  int nx = 0, ny = 0, nz = 0;           // the size of the local grid
+  int x_off = 0, y_off = 0, z_off = 0;  // the offsets of the local grid
+
+  /*! \brief Load the acceleration of the cell with the global indices i, j, k.
+   *  Returns false without touching gx, gy and gz if it isn't in the table */
+  __device__ bool Load(int i, int j, int k, Real &gx, Real &gy, Real &gz) const
+  {
+    i -= x_off;
+    j -= y_off;
+    k -= z_off;
+    if (i < 0 || i >= nx || j < 0 || j >= ny || k < 0 || k >= nz) {
+      return false;
+    }
+    int const n_cells = nx * ny * nz;
+    int const id      = i + (j + k * ny) * nx;
+    gx                = g[id];
+    gy                = g[n_cells + id];
+    gz                = g[2 * n_cells + id];
+    return true;
+  }
+};
+
+/*! \brief The table of the last Update_Static_Gravity_Table call, passed to
+ *  Update_Conserved_Variables by every integrator */
+extern StaticGravityTable static_grav_table;
+
+/*! \fn Update_Static_Gravity_Table
+ *  \brief Evaluate calc_g_1D, calc_g_2D or calc_g_3D, depending on the
+ *  dimensions of the grid, once for every cell and store the result in
+ *  static_grav_table. The field only depends on the arguments, so the table is
+ *  only rebuilt when they change and the call is cheap every other step. Does
+ *  nothing without STATIC_GRAV_CACHE. */
+void Update_Static_Gravity_Table(int nx, int ny, int nz, int x_off, int y_off, int z_off, int n_ghost, int custom_grav,
+                                 Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound);
+
+/*! \fn Update_Conserved_Variables
+ *  \brief Update the conserved variables with the fluxes along the first dim
+ *  dimensions. Every integrator launches this kernel: the 1D and 2D grids pass
+ *  ny = nz = 1 or nz = 1 and nullptr for the fluxes, interface states and
+ *  potential they don't have. The density floor averaging, the self gravity
+ *  and the averaging of crashed cells only apply in 3D. If n_fields_static is
+ *  nonzero it replaces the n_fields argument so the field count is a compile
+ *  time constant. With STATIC_GRAV_CACHE the static gravity is read from
+ *  static_grav, falling back to the analytic field for cells it misses. */
+template <int dim, int n_fields_static>
+__global__ void Update_Conserved_Variables(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, Real *Q_Ly, Real *Q_Ry,
+                                           Real *Q_Lz, Real *Q_Rz, Real *dev_F_x, Real *dev_F_y, Real *dev_F_z, int nx,
+                                           int ny, int nz, int x_off, int y_off, int z_off, int n_ghost, Real dx,
+                                           Real dy, Real dz, Real xbound, Real ybound, Real zbound, Real dt,
+                                           Real gamma, int n_fields, int custom_grav, Real density_floor,
+                                           Real *dev_potential, StaticGravityTable static_grav);
+
+/*! \fn Select_Update_Conserved_Variables(int n_fields)
+ *  \brief Select the instantiation of Update_Conserved_Variables to launch for
+ *  a dim dimensional grid. This is the one specialized for the field count of
+ *  this build when n_fields matches it and the generic one otherwise. */
+template <int dim>
+decltype(&Update_Conserved_Variables<dim, 0>) Select_Update_Conserved_Variables(int n_fields);
 
 /*!
  * \brief Determine the maximum inverse crossing time in a specific cell
@@ -63,12 +122,30 @@ __device__ __host__ Real mhdInverseCrossingTime(Real const &E, Real const &d, Re
                                                 Real const &avgBz, Real const &dx, Real const &dy, Real const &dz,
                                                 Real const &gamma);
 
+/*! \brief Reduce the maximum inverse timestep of the real cells into dev_dti.
+ * With MHD the maximum magnetic divergence of the real cells is reduced into
+ * dev_max_divergence in the same pass, unless it is null. The cell centered
+ * magnetic fields of every cell are written to the three blocks of n_cells of
+ * dev_magnetic_centered when it isn't null. Without MHD, when dev_n_slow isn't
+ * null the cells with an inverse crossing time above max_dti_slow are appended
+ * to dev_slow_cells, counted by *dev_n_slow, instead of being reduced */
 __global__ void Calc_dt_3D(Real *dev_conserved, Real *dev_dti, Real gamma, int n_ghost, int n_fields, int nx, int ny,
-                           int nz, Real dx, Real dy, Real dz);
+                           int nz, Real dx, Real dy, Real dz, Real *dev_max_divergence, Real *dev_magnetic_centered,
+                           Real max_dti_slow, int *dev_slow_cells, int *dev_n_slow);
 
 Real Calc_dt_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy, Real dz,
                  Real gamma);
 
+/*! \brief Launch the kernels of Calc_dt_GPU and reduce the maximum inverse
+ * timestep of the cells into dev_dti without copying it back to the host.
+ * dev_dti has to be set before the launch, e.g. to a slot of
+ * timestep_constraints. In 3D the maximum magnetic divergence goes to
+ * dev_max_divergence and the cell centered magnetic fields to
+ * dev_magnetic_centered when they are given */
+void Reduce_dti_GPU(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy, Real dz,
+                    Real gamma, Real *dev_dti, Real *dev_max_divergence = nullptr,
+                    Real *dev_magnetic_centered = nullptr);
+
 __global__ void Sync_Energies_1D(Real *dev_conserved, int nx, int n_ghost, Real gamma, int n_fields);
 
 __global__ void Sync_Energies_2D(Real *dev_conserved, int nx, int ny, int n_ghost, Real gamma, int n_fields);
@@ -77,12 +154,45 @@ __global__ void Sync_Energies_3D(Real *dev_conserved, int nx, int ny, int nz, in
 
 #ifdef AVERAGE_SLOW_CELLS
 
-void Average_Slow_Cells(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx, Real dy,
-                        Real dz, Real gamma, Real max_dti_slow);
+/*! \brief Like Reduce_dti_GPU, but in 3D the real cells with an inverse
+ * crossing time above max_dti_slow are averaged with their neighbours, and
+ * their inverse crossing time after the averaging is reduced into dev_dti.
+ * The slow cells are found by the reduction, so only they are averaged */
+void Reduce_dti_Average_Slow_Cells(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx,
+                                   Real dy, Real dz, Real gamma, Real max_dti_slow, Real *dev_dti);
+
+/*! \brief Average the *dev_n_slow cells of dev_slow_cells that Calc_dt_3D
+ * listed and reduce their new inverse crossing time into dev_dti */
+__global__ void Average_Slow_Cells_3D(Real *dev_conserved, int nx, int ny, int nz, int n_fields, Real dx, Real dy,
+                                      Real dz, Real gamma, Real max_dti_slow, int const *dev_slow_cells,
+                                      int const *dev_n_slow, Real *dev_dti);
+#endif
 
-__global__ void Average_Slow_Cells_3D(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dx,
-                                      Real dy, Real dz, Real gamma, Real max_dti_slow);
+/*! \fn void Temperature_Floor_Cell(Real *dev_conserved, int id, int n_cells, int n_fields, Real U_floor)
+ *  \brief Raise the specific internal energy of cell id, and with DE the
+ *  advected one, to U_floor */
+inline __device__ void Temperature_Floor_Cell(Real *dev_conserved, int id, int n_cells, int n_fields, Real U_floor)
+{
+  Real const d     = dev_conserved[id];
+  Real const d_inv = 1.0 / d;
+  Real const vx    = dev_conserved[1 * n_cells + id] * d_inv;
+  Real const vy    = dev_conserved[2 * n_cells + id] * d_inv;
+  Real const vz    = dev_conserved[3 * n_cells + id] * d_inv;
+  Real const E     = dev_conserved[4 * n_cells + id];
+  Real const Ekin  = 0.5 * d * (vx * vx + vy * vy + vz * vz);
+
+  Real U = (E - Ekin) / d;
+  if (U < U_floor) {
+    dev_conserved[4 * n_cells + id] = Ekin + d * U_floor;
+  }
+
+#ifdef DE
+  U = dev_conserved[(n_fields - 1) * n_cells + id] / d;
+  if (U < U_floor) {
+    dev_conserved[(n_fields - 1) * n_cells + id] = d * U_floor;
+  }
 #endif
+}
 
 void Apply_Temperature_Floor(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real U_floor);
 
@@ -94,6 +204,20 @@ void Apply_Scalar_Floor(Real *dev_conserved, int nx, int ny, int nz, int n_ghost
 __global__ void Scalar_Floor_Kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int field_num,
                                     Real scalar_floor);
 
+#if defined(DE) || defined(TEMPERATURE_FLOOR) || (defined(SCALAR_FLOOR) && defined(DUST))
+  // Whether there is anything for Sync_Energies_And_Apply_Floors_3D to do
+  #define POST_UPDATE_KERNEL
+
+/*! \fn Sync_Energies_And_Apply_Floors_3D
+ *  \brief The passes after Select_Internal_Energy_3D in one kernel: the total
+ *  energy is synchronized with the selected internal energy with DE, then the
+ *  temperature floor and the dust scalar floor are applied when they are
+ *  enabled. It replaces Sync_Energies_3D, Apply_Temperature_Floor and
+ *  Apply_Scalar_Floor, each of which reads and writes the whole grid. */
+__global__ void Sync_Energies_And_Apply_Floors_3D(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, Real gamma,
+                                                  int n_fields, Real U_floor, Real scalar_floor);
+#endif  // DE or TEMPERATURE_FLOOR or SCALAR_FLOOR and DUST
+
 __global__ void Partial_Update_Advected_Internal_Energy_1D(Real *dev_conserved, Real *Q_Lx, Real *Q_Rx, int nx,
                                                            int n_ghost, Real dx, Real dt, Real gamma, int n_fields);
 
@@ -56,11 +56,12 @@ TEST(tHYDROCalcDt3D, CorrectInputExpectCorrectOutput)
   dev_conserved.cpyHostToDevice(host_conserved);
   //__global__ void Calc_dt_3D(Real *dev_conserved, Real *dev_dti, Real gamma,
   // int n_ghost, int n_fields, int nx, int ny, int nz, Real dx, Real dy, Real
-  // dz)
+  // dz, Real *dev_max_divergence, Real *dev_magnetic_centered, Real
+  // max_dti_slow, int *dev_slow_cells, int *dev_n_slow)
 
   // Run the kernel
   hipLaunchKernelGGL(Calc_dt_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved.data(), dev_dti.data(), gamma, n_ghost,
-                     n_fields, nx, ny, nz, dx, dy, dz);
+                     n_fields, nx, ny, nz, dx, dy, dz, nullptr, nullptr, 0, nullptr, nullptr);
   GPU_Error_Check();
 
   // Compare results
@@ -189,4 +190,61 @@ TEST(tHYDROScalarFloor, CorrectInputExpectCorrectOutput)
   hipLaunchKernelGGL(Scalar_Floor_Kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved.data(), nx, ny, nz, n_ghost,
                      field_num, scalar_floor);
   testing_utilities::Check_Results(host_conserved.at(field_num), dev_conserved.at(field_num), "at floor");
-}
\ No newline at end of file
+}
+#ifdef POST_UPDATE_KERNEL
+TEST(tHYDROSyncEnergiesAndApplyFloors3D, RandomStatesExpectSameAsSeparatePasses)
+{
+  int const nx = 6, ny = 5, nz = 4, n_ghost = 1;
+  int const n_cells       = nx * ny * nz;
+  int const n_fields      = grid_enum::num_fields;
+  Real const gamma        = 5.0 / 3.0;
+  Real const U_floor      = 0.5;
+  Real const scalar_floor = 0.25;
+
+  // Cold and hot cells, so only some of them are floored
+  std::vector<Real> host_conserved(n_fields * n_cells);
+  for (int id = 0; id < n_cells; id++) {
+    Real const d                     = 1.0 + 0.1 * (id % 7);
+    host_conserved[id]               = d;
+    host_conserved[n_cells + id]     = 0.3 * d * ((id % 3) - 1);
+    host_conserved[2 * n_cells + id] = 0.2 * d * ((id % 5) - 2);
+    host_conserved[3 * n_cells + id] = 0.1 * d;
+    host_conserved[4 * n_cells + id] = 0.1 + 0.05 * (id % 11);
+  #ifdef DUST
+    host_conserved[grid_enum::dust_density * n_cells + id] = 0.1 * (id % 5);
+  #endif  // DUST
+  #ifdef DE
+    host_conserved[(n_fields - 1) * n_cells + id] = d * 0.2 * (id % 9);
+  #endif  // DE
+  }
+
+  dim3 const dim1dGrid((n_cells + TPB - 1) / TPB, 1, 1);
+  dim3 const dim1dBlock(TPB, 1, 1);
+  cuda_utilities::DeviceVector<Real> separate(n_fields * n_cells), fused(n_fields * n_cells);
+  separate.cpyHostToDevice(host_conserved);
+  fused.cpyHostToDevice(host_conserved);
+
+  #ifdef DE
+  hipLaunchKernelGGL(Sync_Energies_3D, dim1dGrid, dim1dBlock, 0, 0, separate.data(), nx, ny, nz, n_ghost, gamma,
+                     n_fields);
+  #endif  // DE
+  #ifdef TEMPERATURE_FLOOR
+  hipLaunchKernelGGL(Temperature_Floor_Kernel, dim1dGrid, dim1dBlock, 0, 0, separate.data(), nx, ny, nz, n_ghost,
+                     n_fields, U_floor);
+  #endif  // TEMPERATURE_FLOOR
+  #if defined(SCALAR_FLOOR) && defined(DUST)
+  hipLaunchKernelGGL(Scalar_Floor_Kernel, dim1dGrid, dim1dBlock, 0, 0, separate.data(), nx, ny, nz, n_ghost,
+                     grid_enum::dust_density, scalar_floor);
+  #endif  // SCALAR_FLOOR and DUST
+  hipLaunchKernelGGL(Sync_Energies_And_Apply_Floors_3D, dim1dGrid, dim1dBlock, 0, 0, fused.data(), nx, ny, nz, n_ghost,
+                     gamma, n_fields, U_floor, scalar_floor);
+  GPU_Error_Check();
+
+  std::vector<Real> fiducial(n_fields * n_cells), result(n_fields * n_cells);
+  separate.cpyDeviceToHost(fiducial);
+  fused.cpyDeviceToHost(result);
+  for (size_t i = 0; i < result.size(); i++) {
+    testing_utilities::Check_Results(fiducial[i], result[i], "value " + std::to_string(i));
+  }
+}
+#endif  // POST_UPDATE_KERNEL
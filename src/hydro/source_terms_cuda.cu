@@ -0,0 +1,111 @@
+/*! \file source_terms_cuda.cu
+ *  \brief Definitions of the source term kernel. */
+
+#include "../hydro/source_terms_cuda.h"
+
+#ifdef SOURCE_TERM_KERNEL
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../grid/grid_enum.h"
+  #include "../hydro/hydro_cuda.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/profiling_ranges.h"
+  #ifdef COOLING_GPU
+    #include "../cooling/cooling_cell.h"
+    #include "../cooling/cooling_cuda.h"
+  #endif  // COOLING_GPU
+  #ifdef DUST
+    #include "../dust/dust_cuda.h"
+  #endif  // DUST
+
+namespace
+{
+// The parameters of the enabled source terms
+struct SourceTerms {
+  Real dt;
+  Real gamma;
+  Real U_floor;
+  Real scalar_floor;
+  #ifdef COOLING_GPU
+  CloudyTable coolTexObj;
+  CloudyTable heatTexObj;
+  #endif  // COOLING_GPU
+  #ifdef DUST
+  Real grain_radius;
+  #endif  // DUST
+};
+
+template <bool apply_floors>
+__global__ void Source_Terms_Kernel(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields,
+                                    SourceTerms const terms)
+{
+  int const n_cells = nx * ny * nz;
+
+  // get a global thread ID
+  int const id  = threadIdx.x + blockIdx.x * blockDim.x;
+  int const zid = id / (nx * ny);
+  int const yid = (id - zid * nx * ny) / nx;
+  int const xid = id - zid * nx * ny - yid * nx;
+
+  // only threads corresponding to real cells do the calculation
+  int is, ie, js, je, ks, ke;
+  cuda_utilities::Get_Real_Indices(n_ghost, nx, ny, nz, is, ie, js, je, ks, ke);
+  if (xid < is || xid >= ie || yid < js || yid >= je || zid < ks || zid >= ke) {
+    return;
+  }
+
+  #if defined(TEMPERATURE_FLOOR) || (defined(SCALAR_FLOOR) && defined(DUST))
+  // Like Apply_Temperature_Floor and Apply_Scalar_Floor, the floors skip the
+  // ghost cells along every axis
+  if (apply_floors && yid >= n_ghost && yid < ny - n_ghost && zid >= n_ghost && zid < nz - n_ghost) {
+    #ifdef TEMPERATURE_FLOOR
+    Temperature_Floor_Cell(dev_conserved, id, n_cells, n_fields, terms.U_floor);
+    #endif  // TEMPERATURE_FLOOR
+    #if defined(SCALAR_FLOOR) && defined(DUST)
+    if (dev_conserved[id + n_cells * grid_enum::dust_density] < terms.scalar_floor) {
+      dev_conserved[id + n_cells * grid_enum::dust_density] = terms.scalar_floor;
+    }
+    #endif  // SCALAR_FLOOR and DUST
+  }
+  #endif  // TEMPERATURE_FLOOR or SCALAR_FLOOR and DUST
+
+  #ifdef COOLING_GPU
+  Cool_Cell(dev_conserved, id, n_cells, n_fields, terms.dt, terms.gamma, -1, terms.coolTexObj, terms.heatTexObj);
+  #endif  // COOLING_GPU
+
+  #ifdef DUST
+  Dust_Cell(dev_conserved, id, xid, yid, zid, nx, ny, n_cells, terms.dt, terms.gamma, terms.grain_radius);
+  #endif  // DUST
+}
+}  // namespace
+
+void Source_Terms_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt, Real gamma,
+                         bool apply_floors, Real U_floor, Real scalar_floor, Real grain_radius)
+{
+  profiling::ScopedRange const range("Source_Terms_Update");
+
+  SourceTerms terms;
+  terms.dt           = dt;
+  terms.gamma        = gamma;
+  terms.U_floor      = U_floor;
+  terms.scalar_floor = scalar_floor;
+  #ifdef COOLING_GPU
+  terms.coolTexObj = coolTexObj;
+  terms.heatTexObj = heatTexObj;
+  #endif  // COOLING_GPU
+  #ifdef DUST
+  terms.grain_radius = grain_radius;
+  #endif  // DUST
+
+  int n_cells = nx * ny * nz;
+  int ngrid   = (n_cells + TPB - 1) / TPB;
+  dim3 dim1dGrid(ngrid, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  auto *const kernel = apply_floors ? Source_Terms_Kernel<true> : Source_Terms_Kernel<false>;
+  hipLaunchKernelGGL(kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields, terms);
+  GPU_Error_Check();
+}
+
+#endif  // SOURCE_TERM_KERNEL
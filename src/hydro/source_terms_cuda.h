@@ -0,0 +1,27 @@
+/*! \file source_terms_cuda.h
+ *  \brief Declarations of the source term kernel, which applies the operator
+ *  split source terms that only depend on the state of a cell in one pass. */
+
+#pragma once
+
+#include "../global/global.h"
+
+// The cooling cells that are deferred to the subcycle queue have to cool before
+// their dust is updated, so that build keeps the separate kernels
+#if (defined(COOLING_GPU) || defined(DUST)) && !defined(COOLING_SUBCYCLE_QUEUE)
+  // Whether Update_Hydro_Grid applies the cell source terms with
+  // Source_Terms_Update
+  #define SOURCE_TERM_KERNEL
+
+/*! \fn void Source_Terms_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt,
+ * Real gamma, bool apply_floors, Real U_floor, Real scalar_floor, Real grain_radius)
+ *  \brief Apply the source terms of the enabled modules to every real cell in
+ *  a single kernel, in the order Update_Hydro_Grid launched them in: with
+ *  apply_floors the temperature floor and the dust scalar floor, then the
+ *  cooling of COOLING_GPU and the sputtering of DUST. Each module provides the
+ *  device function for a single cell, so the conserved variables make one
+ *  round trip per step instead of one per module. The floors and grain_radius
+ *  are ignored when their modules are disabled. */
+void Source_Terms_Update(Real *dev_conserved, int nx, int ny, int nz, int n_ghost, int n_fields, Real dt, Real gamma,
+                         bool apply_floors, Real U_floor, Real scalar_floor, Real grain_radius);
+#endif  // COOLING_GPU or DUST, and not COOLING_SUBCYCLE_QUEUE
@@ -0,0 +1,83 @@
+/*!
+ * \file source_terms_cuda_tests.cu
+ * \brief Tests for the contents of source_terms_cuda.h
+ *
+ */
+
+// STL Includes
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../grid/grid_enum.h"
+#include "../hydro/hydro_cuda.h"
+#include "../hydro/source_terms_cuda.h"  // Include code to test
+#include "../utils/DeviceVector.h"
+#include "../utils/testing_utilities.h"
+#ifdef COOLING_GPU
+  #include "../cooling/cooling_cuda.h"
+#endif  // COOLING_GPU
+#ifdef DUST
+  #include "../dust/dust_cuda.h"
+#endif  // DUST
+
+#ifdef SOURCE_TERM_KERNEL
+TEST(tALLSourceTermsUpdate, RandomStatesExpectSameAsSeparatePasses)
+{
+  int const nx = 6, ny = 5, nz = 4, n_ghost = 1;
+  int const n_cells       = nx * ny * nz;
+  int const n_fields      = grid_enum::num_fields;
+  Real const dt           = 1.0;
+  Real const U_floor      = 0.5;
+  Real const scalar_floor = 0.25;
+  Real const grain_radius = 1.0;
+  // Cooling_Update uses the global gamma
+  gama = 5.0 / 3.0;
+
+  // Cold and hot cells, so only some of them are floored
+  std::vector<Real> host_conserved(n_fields * n_cells);
+  for (int id = 0; id < n_cells; id++) {
+    Real const d                     = 1.0e3 * (1.0 + 0.1 * (id % 7));
+    host_conserved[id]               = d;
+    host_conserved[n_cells + id]     = 0.3 * d * ((id % 3) - 1);
+    host_conserved[2 * n_cells + id] = 0.2 * d * ((id % 5) - 2);
+    host_conserved[3 * n_cells + id] = 0.1 * d;
+    host_conserved[4 * n_cells + id] = d * (0.1 + 0.5 * (id % 11));
+  #ifdef DUST
+    host_conserved[grid_enum::dust_density * n_cells + id] = 0.1 * (1 + id % 5);
+  #endif  // DUST
+  #ifdef DE
+    host_conserved[(n_fields - 1) * n_cells + id] = d * 0.2 * (id % 9);
+  #endif  // DE
+  }
+
+  cuda_utilities::DeviceVector<Real> separate(n_fields * n_cells), fused(n_fields * n_cells);
+  separate.cpyHostToDevice(host_conserved);
+  fused.cpyHostToDevice(host_conserved);
+
+  #ifdef TEMPERATURE_FLOOR
+  Apply_Temperature_Floor(separate.data(), nx, ny, nz, n_ghost, n_fields, U_floor);
+  #endif  // TEMPERATURE_FLOOR
+  #if defined(SCALAR_FLOOR) && defined(DUST)
+  Apply_Scalar_Floor(separate.data(), nx, ny, nz, n_ghost, grid_enum::dust_density, scalar_floor);
+  #endif  // SCALAR_FLOOR and DUST
+  #ifdef COOLING_GPU
+  Cooling_Update(separate.data(), nx, ny, nz, n_ghost, n_fields, dt, gama);
+  #endif  // COOLING_GPU
+  #ifdef DUST
+  Dust_Update(separate.data(), nx, ny, nz, n_ghost, n_fields, dt, gama, grain_radius);
+  #endif  // DUST
+  Source_Terms_Update(fused.data(), nx, ny, nz, n_ghost, n_fields, dt, gama, true, U_floor, scalar_floor, grain_radius);
+
+  std::vector<Real> fiducial(n_fields * n_cells), result(n_fields * n_cells);
+  separate.cpyDeviceToHost(fiducial);
+  fused.cpyDeviceToHost(result);
+  for (size_t i = 0; i < result.size(); i++) {
+    testing_utilities::Check_Results(fiducial[i], result[i], "value " + std::to_string(i));
+  }
+}
+#endif  // SOURCE_TERM_KERNEL
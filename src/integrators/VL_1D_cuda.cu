@@ -20,6 +20,8 @@
   #include "../riemann_solvers/exact_cuda.h"
   #include "../riemann_solvers/hllc_cuda.h"
   #include "../riemann_solvers/roe_cuda.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/error_handling.h"
   #include "../utils/gpu.hpp"
 
@@ -42,15 +44,18 @@ void VL_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost, Rea
   dim3 dimGrid(ngrid, 1, 1);
   dim3 dimBlock(TPB, 1, 1);
 
+  // The grid can change between calls, the scratch buffers are reused
+  dev_conserved = d_conserved;
+
   if (!memory_allocated) {
     // allocate memory on the GPU
-    dev_conserved = d_conserved;
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
     // GPU_Error_Check( cudaMalloc((void**)&dev_conserved,
     // n_fields*n_cells*sizeof(Real)) );
-    GPU_Error_Check(cudaMalloc((void **)&dev_conserved_half, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Lx, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Rx, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&F_x, n_fields * n_cells * sizeof(Real)));
+    cuda_utilities::Pool_Malloc(&dev_conserved_half, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Lx, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Rx, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&F_x, n_fields * n_cells * sizeof(Real));
 
     // If memory is single allocated: memory_allocated becomes true and
     // successive timesteps won't allocate memory. If the memory is not single
@@ -75,8 +80,8 @@ void VL_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost, Rea
                      n_fields);
   #endif
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0,
-                     n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
   #endif
   GPU_Error_Check();
 
@@ -118,8 +123,7 @@ void VL_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost, Rea
                      n_fields);
   #endif
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0,
-                     n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
   #endif
   GPU_Error_Check();
 
@@ -132,8 +136,12 @@ void VL_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost, Rea
   #endif
 
   // Step 6: Update the conserved variable array
-  hipLaunchKernelGGL(Update_Conserved_Variables_1D, dimGrid, dimBlock, 0, 0, dev_conserved, F_x, n_cells, x_off,
-                     n_ghost, dx, xbound, dt, gama, n_fields, custom_grav);
+  auto *const update_kernel = Select_Update_Conserved_Variables<1>(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const update_launch_params(update_kernel, n_cells);
+  hipLaunchKernelGGL(update_kernel, update_launch_params.numBlocks, update_launch_params.threadsPerBlock, 0, 0,
+                     dev_conserved, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, F_x, nullptr, nullptr, nx, 1,
+                     1, x_off, 0, 0, n_ghost, dx, dx, dx, xbound, 0, 0, dt, gama, n_fields, custom_grav, 0, nullptr,
+                     static_grav_table);
   GPU_Error_Check();
 
   #ifdef DE
@@ -149,10 +157,10 @@ void Free_Memory_VL_1D()
 {
   // free the GPU memory
   cudaFree(dev_conserved);
-  cudaFree(dev_conserved_half);
-  cudaFree(Q_Lx);
-  cudaFree(Q_Rx);
-  cudaFree(F_x);
+  cuda_utilities::Pool_Free(dev_conserved_half);
+  cuda_utilities::Pool_Free(Q_Lx);
+  cuda_utilities::Pool_Free(Q_Rx);
+  cuda_utilities::Pool_Free(F_x);
 }
 
 __global__ void Update_Conserved_Variables_1D_half(Real *dev_conserved, Real *dev_conserved_half, Real *dev_F,
@@ -18,6 +18,8 @@
   #include "../riemann_solvers/exact_cuda.h"
   #include "../riemann_solvers/hllc_cuda.h"
   #include "../riemann_solvers/roe_cuda.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/gpu.hpp"
 
 __global__ void Update_Conserved_Variables_2D_half(Real *dev_conserved, Real *dev_conserved_half, Real *dev_F_x,
@@ -41,18 +43,21 @@ void VL_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int y_of
   // number of threads per 1D block
   dim3 dim1dBlock(TPB, 1, 1);
 
+  // The grid can change between calls, the scratch buffers are reused
+  dev_conserved = d_conserved;
+
   if (!memory_allocated) {
     // allocate GPU arrays
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
     // GPU_Error_Check( cudaMalloc((void**)&dev_conserved,
     // n_fields*n_cells*sizeof(Real)) );
-    dev_conserved = d_conserved;
-    GPU_Error_Check(cudaMalloc((void **)&dev_conserved_half, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Lx, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Rx, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Ly, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Ry, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&F_x, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&F_y, n_fields * n_cells * sizeof(Real)));
+    cuda_utilities::Pool_Malloc(&dev_conserved_half, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Lx, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Rx, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Ly, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&Q_Ry, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&F_x, n_fields * n_cells * sizeof(Real));
+    cuda_utilities::Pool_Malloc(&F_y, n_fields * n_cells * sizeof(Real));
 
     // If memory is single allocated: memory_allocated becomes true and
     // successive timesteps won't allocate memory. If the memory is not single
@@ -81,10 +86,9 @@ void VL_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int y_of
                      1, n_fields);
   #endif
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost,
-                     gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost,
-                     gama, 1, n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
   #endif
   GPU_Error_Check();
 
@@ -133,10 +137,8 @@ void VL_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int y_of
                      1, n_fields);
   #endif
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost,
-                     gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost,
-                     gama, 1, n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
   #endif
   GPU_Error_Check();
 
@@ -149,8 +151,12 @@ void VL_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int y_of
   #endif
 
   // Step 6: Update the conserved variable array
-  hipLaunchKernelGGL(Update_Conserved_Variables_2D, dim2dGrid, dim1dBlock, 0, 0, dev_conserved, F_x, F_y, nx, ny, x_off,
-                     y_off, n_ghost, dx, dy, xbound, ybound, dt, gama, n_fields, custom_grav);
+  auto *const update_kernel = Select_Update_Conserved_Variables<2>(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const update_launch_params(update_kernel, n_cells);
+  hipLaunchKernelGGL(update_kernel, update_launch_params.numBlocks, update_launch_params.threadsPerBlock, 0, 0,
+                     dev_conserved, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, F_x, F_y, nullptr, nx, ny, 1,
+                     x_off, y_off, 0, n_ghost, dx, dy, dx, xbound, ybound, 0, dt, gama, n_fields, custom_grav, 0,
+                     nullptr, static_grav_table);
   GPU_Error_Check();
 
   #ifdef DE
@@ -166,13 +172,13 @@ void Free_Memory_VL_2D()
 {
   // free the GPU memory
   cudaFree(dev_conserved);
-  cudaFree(dev_conserved_half);
-  cudaFree(Q_Lx);
-  cudaFree(Q_Rx);
-  cudaFree(Q_Ly);
-  cudaFree(Q_Ry);
-  cudaFree(F_x);
-  cudaFree(F_y);
+  cuda_utilities::Pool_Free(dev_conserved_half);
+  cuda_utilities::Pool_Free(Q_Lx);
+  cuda_utilities::Pool_Free(Q_Rx);
+  cuda_utilities::Pool_Free(Q_Ly);
+  cuda_utilities::Pool_Free(Q_Ry);
+  cuda_utilities::Pool_Free(F_x);
+  cuda_utilities::Pool_Free(F_y);
 }
 
 __global__ void Update_Conserved_Variables_2D_half(Real *dev_conserved, Real *dev_conserved_half, Real *dev_F_x,
@@ -10,11 +10,22 @@
   #include <stdio.h>
   #include <stdlib.h>
 
+  #include <algorithm>
+  #include <cstring>
+  #include <functional>
+  #include <limits>
+  #include <string>
+  #include <vector>
+
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../hydro/hydro_cuda.h"
   #include "../integrators/VL_3D_cuda.h"
   #include "../io/io.h"
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
+  #include "../utils/error_handling.h"
   #include "../mhd/ct_electric_fields.h"
   #include "../mhd/magnetic_update.h"
   #include "../reconstruction/pcm_cuda.h"
@@ -22,22 +33,335 @@
   #include "../reconstruction/plmp_cuda.h"
   #include "../reconstruction/ppmc_cuda.h"
   #include "../reconstruction/ppmp_cuda.h"
+  #include "../reconstruction/primitive_cache_cuda.h"
+  #include "../reconstruction/tiled_reconstruction_cuda.h"
   #include "../riemann_solvers/exact_cuda.h"
+  #include "../riemann_solvers/fused_flux_cuda.h"
   #include "../riemann_solvers/hll_cuda.h"
   #include "../riemann_solvers/hllc_cuda.h"
   #include "../riemann_solvers/hlld_cuda.h"
   #include "../riemann_solvers/roe_cuda.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/gpu.hpp"
+  #include "../utils/gpu_streams.h"
   #include "../utils/hydro_utilities.h"
+  #include "../utils/launch_autotuner.h"
+  #include "../utils/timing_functions.h"
 
 __global__ void Update_Conserved_Variables_3D_half(Real *dev_conserved, Real *dev_conserved_half, Real *dev_F_x,
                                                    Real *dev_F_y, Real *dev_F_z, int nx, int ny, int nz, int n_ghost,
                                                    Real dx, Real dy, Real dz, Real dt, Real gamma, int n_fields,
                                                    Real density_floor);
 
+  #ifdef VL_FUSED
+    #if !defined(HLLC) || defined(MHD)
+      #error "VL_FUSED requires the HLLC Riemann solver and does not support MHD"
+    #endif  // !HLLC or MHD
+__global__ void Update_Conserved_Variables_3D_half_Fused(Real *dev_conserved, Real *dev_conserved_half, int nx, int ny,
+                                                         int nz, int n_ghost, Real dx, Real dy, Real dz, Real dt,
+                                                         Real gamma, int n_fields, Real density_floor);
+  #endif  // VL_FUSED
+
+  #ifdef VL_FUSED_CORRECTOR
+    #if !defined(HLLC) || !(defined(PLMC) || defined(PPMC)) || defined(MHD) || defined(DE)
+      #error "VL_FUSED_CORRECTOR requires the HLLC Riemann solver and PLMC or PPMC, and does not support MHD or DE"
+    #endif  // !HLLC or !(PLMC or PPMC) or MHD or DE
+    #ifdef PLMC
+using CorrectorReconstruction = reconstruction::PlmcPolicy;
+    #else   // PPMC
+using CorrectorReconstruction = reconstruction::PpmcPolicy;
+    #endif  // PLMC
+  #endif    // VL_FUSED_CORRECTOR
+
+  #ifdef VL_FUSED_CT
+    #ifndef MHD
+      #error "VL_FUSED_CT requires MHD"
+    #endif  // not MHD
+  #endif    // VL_FUSED_CT
+
+  #ifdef MHD_LOW_STORAGE
+    #if !defined(MHD) || !defined(HLLD)
+      #error "MHD_LOW_STORAGE requires MHD and the HLLD Riemann solver"
+    #endif  // not MHD or not HLLD
+  #endif    // MHD_LOW_STORAGE
+
+  #ifdef VL_TILED_RECONSTRUCTION
+    #if !(defined(PLMC) || defined(PPMC)) || defined(MHD) || defined(VL_FUSED_CORRECTOR)
+      #error "VL_TILED_RECONSTRUCTION requires PLMC or PPMC and does not support MHD or VL_FUSED_CORRECTOR"
+    #endif  // !(PLMC or PPMC) or MHD or VL_FUSED_CORRECTOR
+  #endif    // VL_TILED_RECONSTRUCTION
+
+  #ifdef VL_PRIMITIVE_CACHE
+    #if !(defined(PLMC) || defined(PPMC)) || defined(VL_TILED_RECONSTRUCTION) || defined(VL_FUSED_CORRECTOR)
+      #error "VL_PRIMITIVE_CACHE requires PLMC or PPMC and not VL_TILED_RECONSTRUCTION or VL_FUSED_CORRECTOR"
+    #endif  // !(PLMC or PPMC) or VL_TILED_RECONSTRUCTION or VL_FUSED_CORRECTOR
+    #ifdef PLMC
+using CachedReconstruction = reconstruction::PlmcPolicy;
+    #else   // PPMC
+using CachedReconstruction = reconstruction::PpmcPolicy;
+    #endif  // PLMC
+  #endif    // VL_PRIMITIVE_CACHE
+
+  #ifdef RUNTIME_KERNELS
+    #if defined(MHD) || defined(VL_FUSED) || defined(VL_FUSED_CORRECTOR)
+      #error "RUNTIME_KERNELS does not support MHD, VL_FUSED or VL_FUSED_CORRECTOR"
+    #endif  // MHD or VL_FUSED or VL_FUSED_CORRECTOR
+    #if defined(VL_TILED_RECONSTRUCTION) || defined(VL_PRIMITIVE_CACHE)
+      #error "RUNTIME_KERNELS does not support VL_TILED_RECONSTRUCTION or VL_PRIMITIVE_CACHE"
+    #endif  // VL_TILED_RECONSTRUCTION or VL_PRIMITIVE_CACHE
+  #endif    // RUNTIME_KERNELS
+
+  #if defined(MANAGED_MEMORY) && defined(GPU_GRAPHS)
+    #error "MANAGED_MEMORY does not support GPU_GRAPHS"
+  #endif  // MANAGED_MEMORY and GPU_GRAPHS
+
+namespace
+{
+// Event based timers of every stage of VL_Algorithm_3D_CUDA, printed at the
+// end of the run when CPU_TIME is on. The fused corrector is timed as the
+// reconstruction
+GpuTimer predictor_fused_timer("VL_Predictor_Fused");
+GpuTimer pcm_timer("VL_PCM");
+GpuTimer riemann_predictor_timers[3] = {GpuTimer("VL_Riemann_Predictor_X"), GpuTimer("VL_Riemann_Predictor_Y"),
+                                        GpuTimer("VL_Riemann_Predictor_Z")};
+GpuTimer ct_predictor_timer("VL_CT_Predictor");
+GpuTimer update_half_timer("VL_Update_Half");
+GpuTimer magnetic_half_timer("VL_Magnetic_Half");
+GpuTimer reconstruction_timers[3] = {GpuTimer("VL_Reconstruct_X"), GpuTimer("VL_Reconstruct_Y"),
+                                     GpuTimer("VL_Reconstruct_Z")};
+GpuTimer riemann_corrector_timers[3] = {GpuTimer("VL_Riemann_Corrector_X"), GpuTimer("VL_Riemann_Corrector_Y"),
+                                        GpuTimer("VL_Riemann_Corrector_Z")};
+GpuTimer de_advect_timer("VL_DE_Advect");
+GpuTimer ct_corrector_timer("VL_CT_Corrector");
+GpuTimer update_full_timer("VL_Update_Full");
+GpuTimer magnetic_full_timer("VL_Magnetic_Full");
+GpuTimer post_update_timer("VL_Post_Update");
+GpuTimer primitive_cache_timer("VL_Primitive_Cache");
+
+  #ifdef VL_PRIMITIVE_CACHE
+// The primitive variables of the half step state, read by all three corrector
+// reconstructions
+Real *dev_primitive;
+  #endif  // VL_PRIMITIVE_CACHE
+
+  #ifdef MANAGED_MEMORY
+// The flux arrays are moved to the device on their own stream while the
+// predictor reconstruction runs
+cuda_utilities::Stream prefetch_stream(false);
+cuda_utilities::Event prefetch_start, fluxes_prefetched;
+  #endif  // MANAGED_MEMORY
+
+  #if defined(GRAVITY) && !defined(GRAVITY_GPU)
+// Set by VL_Set_Potential_Ready when the caller uploads the potential itself
+cudaEvent_t potential_ready = nullptr;
+  #endif  // GRAVITY and not GRAVITY_GPU
+
+  #ifdef RUNTIME_KERNELS
+enum class Reconstruction { pcm, plmp, plmc, ppmp, ppmc };
+enum class RiemannSolver { exact, roe, hllc, hll };
+
+struct ReconstructionKernel {
+  char const *name;
+  Reconstruction kernel;
+  // The ghost cells its stencil needs
+  int n_ghost;
+};
+ReconstructionKernel const reconstruction_kernels[] = {
+    {"pcm", Reconstruction::pcm, 2},
+    {"plmp", Reconstruction::plmp, 3},
+    {"plmc", Reconstruction::plmc, 3},
+    #ifdef PPMP
+    {"ppmp", Reconstruction::ppmp, 4},
+    #endif  // PPMP
+    {"ppmc", Reconstruction::ppmc, 4},
+};
+
+struct RiemannSolverKernel {
+  char const *name;
+  RiemannSolver kernel;
+};
+RiemannSolverKernel const riemann_solver_kernels[] = {
+    {"exact", RiemannSolver::exact},
+    {"roe", RiemannSolver::roe},
+    {"hllc", RiemannSolver::hllc},
+    {"hll", RiemannSolver::hll},
+};
+
+    // The kernels of the build, used until VL_Select_Kernels picks others
+    #if defined(PCM)
+char const *const build_reconstruction = "pcm";
+    #elif defined(PLMP)
+char const *const build_reconstruction = "plmp";
+    #elif defined(PLMC)
+char const *const build_reconstruction = "plmc";
+    #elif defined(PPMP)
+char const *const build_reconstruction = "ppmp";
+    #else   // PPMC
+char const *const build_reconstruction = "ppmc";
+    #endif  // PCM
+    #if defined(EXACT)
+char const *const build_riemann_solver = "exact";
+    #elif defined(ROE)
+char const *const build_riemann_solver = "roe";
+    #elif defined(HLL)
+char const *const build_riemann_solver = "hll";
+    #else   // HLLC
+char const *const build_riemann_solver = "hllc";
+    #endif  // EXACT
+
+    #if defined(PCM)
+Reconstruction selected_reconstruction = Reconstruction::pcm;
+    #elif defined(PLMP)
+Reconstruction selected_reconstruction = Reconstruction::plmp;
+    #elif defined(PLMC)
+Reconstruction selected_reconstruction = Reconstruction::plmc;
+    #elif defined(PPMP)
+Reconstruction selected_reconstruction = Reconstruction::ppmp;
+    #else   // PPMC
+Reconstruction selected_reconstruction = Reconstruction::ppmc;
+    #endif  // PCM
+    #if defined(EXACT)
+RiemannSolver selected_riemann_solver = RiemannSolver::exact;
+    #elif defined(ROE)
+RiemannSolver selected_riemann_solver = RiemannSolver::roe;
+    #elif defined(HLL)
+RiemannSolver selected_riemann_solver = RiemannSolver::hll;
+    #else   // HLLC
+RiemannSolver selected_riemann_solver = RiemannSolver::hllc;
+    #endif  // EXACT
+
+/*! \brief The entries of kernels named in the comma separated list, or fallback
+ *  if it is empty. auto stands for every entry that allowed accepts, and naming
+ *  an entry it rejects is an error */
+template <typename Kernel, size_t N, typename Allowed>
+std::vector<Kernel const *> Parse_Kernel_List(char const *list, char const *fallback, Kernel const (&kernels)[N],
+                                              char const *kind, Allowed allowed)
+{
+  std::string const names = (list[0] == '\0') ? fallback : list;
+  std::vector<Kernel const *> selected;
+  size_t begin = 0;
+  while (begin <= names.size()) {
+    size_t end = names.find(',', begin);
+    if (end == std::string::npos) {
+      end = names.size();
+    }
+    std::string const name = names.substr(begin, end - begin);
+    begin                  = end + 1;
+    if (name.empty()) {
+      continue;
+    }
+    bool found = false;
+    for (Kernel const &kernel : kernels) {
+      if (name == "auto" && allowed(kernel)) {
+        selected.push_back(&kernel);
+        found = true;
+      } else if (name == kernel.name) {
+        CHOLLA_ASSERT(allowed(kernel), "The %s %s needs more ghost cells than this build has", kind, kernel.name);
+        selected.push_back(&kernel);
+        found = true;
+      }
+    }
+    CHOLLA_ASSERT(found, "Unknown %s \"%s\" in \"%s\"", kind, name.c_str(), names.c_str());
+  }
+  CHOLLA_ASSERT(!selected.empty(), "No %s given in \"%s\"", kind, names.c_str());
+  return selected;
+}
+
+/*! \brief Reconstruct the interface states of all three directions from
+ *  dev_conserved with the given kernel. PCM does all three in one launch,
+ *  timed as the X direction. timers may be null */
+void Reconstruct(Reconstruction const kernel, Real *dev_conserved, Real *const bounds_L[3], Real *const bounds_R[3],
+                 int const nx, int const ny, int const nz, int const n_ghost, Real const cell_sizes[3], Real const dt,
+                 int const n_fields, GpuTimer *timers, cudaStream_t stream)
+{
+  dim3 const dim1dGrid((nx * ny * nz + TPB - 1) / TPB, 1, 1);
+  dim3 const dim1dBlock(TPB, 1, 1);
+  int const n_launches = (kernel == Reconstruction::pcm) ? 1 : 3;
+  for (int dir = 0; dir < n_launches; dir++) {
+    if (timers != nullptr) {
+      timers[dir].Start(stream);
+    }
+    switch (kernel) {
+      case Reconstruction::pcm:
+        hipLaunchKernelGGL(PCM_Reconstruction_3D, dim1dGrid, dim1dBlock, 0, stream, dev_conserved, bounds_L[0],
+                           bounds_R[0], bounds_L[1], bounds_R[1], bounds_L[2], bounds_R[2], nx, ny, nz, n_ghost, gama,
+                           n_fields);
+        break;
+      case Reconstruction::plmp:
+        hipLaunchKernelGGL(PLMP_cuda, dim1dGrid, dim1dBlock, 0, stream, dev_conserved, bounds_L[dir], bounds_R[dir], nx,
+                           ny, nz, n_ghost, cell_sizes[dir], dt, gama, dir, n_fields);
+        break;
+      case Reconstruction::plmc:
+        hipLaunchKernelGGL(PLMC_cuda, dim1dGrid, dim1dBlock, 0, stream, dev_conserved, bounds_L[dir], bounds_R[dir], nx,
+                           ny, nz, cell_sizes[dir], dt, gama, dir, n_fields);
+        break;
+      case Reconstruction::ppmp:
+    #ifdef PPMP
+        hipLaunchKernelGGL(PPMP_cuda, dim1dGrid, dim1dBlock, 0, stream, dev_conserved, bounds_L[dir], bounds_R[dir], nx,
+                           ny, nz, n_ghost, cell_sizes[dir], dt, gama, dir, n_fields);
+    #endif  // PPMP
+        break;
+      case Reconstruction::ppmc:
+        hipLaunchKernelGGL(PPMC_VL, dim1dGrid, dim1dBlock, 0, stream, dev_conserved, bounds_L[dir], bounds_R[dir], nx,
+                           ny, nz, gama, dir);
+        break;
+    }
+    if (timers != nullptr) {
+      timers[dir].Stop(stream);
+    }
+  }
+}
+
+/*! \brief Solve the Riemann problems of all three directions with the given
+ *  kernel. timers may be null */
+void Solve_Riemann(RiemannSolver const kernel, Real *const bounds_L[3], Real *const bounds_R[3], Real *const fluxes[3],
+                   int const nx, int const ny, int const nz, int const n_ghost, int const n_fields, GpuTimer *timers,
+                   cudaStream_t stream)
+{
+  dim3 const dim1dGrid((nx * ny * nz + TPB - 1) / TPB, 1, 1);
+  dim3 const dim1dBlock(TPB, 1, 1);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  for (int dir = 0; dir < 3; dir++) {
+    if (timers != nullptr) {
+      timers[dir].Start(stream);
+    }
+    switch (kernel) {
+      case RiemannSolver::exact:
+        hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, stream, bounds_L[dir], bounds_R[dir],
+                           fluxes[dir], nx, ny, nz, n_ghost, gama, dir, n_fields);
+        break;
+      case RiemannSolver::roe:
+        hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, stream, bounds_L[dir], bounds_R[dir],
+                           fluxes[dir], nx, ny, nz, n_ghost, gama, dir, n_fields);
+        break;
+      case RiemannSolver::hllc:
+        hipLaunchKernelGGL(hllc_kernel, dim1dGrid, dim1dBlock, 0, stream, bounds_L[dir], bounds_R[dir], fluxes[dir], nx,
+                           ny, nz, n_ghost, gama, dir, n_fields);
+        break;
+      case RiemannSolver::hll:
+        hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, stream, bounds_L[dir], bounds_R[dir],
+                           fluxes[dir], nx, ny, nz, n_ghost, gama, dir, n_fields);
+        break;
+    }
+    if (timers != nullptr) {
+      timers[dir].Stop(stream);
+    }
+  }
+}
+  #endif  // RUNTIME_KERNELS
+}  // namespace
+
+void Report_VL_Memory_Traffic(int n_fields);
+
+void Report_VL_Memory_Footprint(int n_fields);
+
+void Report_VL_Kernel_Resource_Usage();
+
 void VL_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off, int y_off,
                           int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound,
-                          Real dt, int n_fields, int custom_grav, Real density_floor, Real *host_grav_potential)
+                          Real dt, int n_fields, int custom_grav, Real density_floor, Real U_floor, Real scalar_floor,
+                          Real *host_grav_potential, cudaStream_t stream)
 {
   // Here, *dev_conserved contains the entire
   // set of conserved variables on the grid
@@ -57,8 +381,7 @@ void VL_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int
 
   if (!memory_allocated) {
     // allocate memory on the GPU
-    dev_conserved = d_conserved;
-
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
   // Set the size of the interface and flux arrays
   #ifdef MHD
     // In MHD/Constrained Transport the interface arrays have one fewer fields
@@ -89,20 +412,35 @@ void VL_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int
     //  -(-cross(V,B))z = -EMF_Y F_z[(grid_enum::fluxZ_magnetic_x)*n_cells] =
     //  VxBz - BxVz =  (-cross(V,B))y =  EMF_X
     size_t const arraySize   = (n_fields - 1) * n_cells * sizeof(Real);
+    #if !defined(VL_FUSED_CT) && !defined(MHD_LOW_STORAGE)
     size_t const ctArraySize = 3 * n_cells * sizeof(Real);
+    #endif  // not VL_FUSED_CT and not MHD_LOW_STORAGE
   #else   // not MHD
     size_t const arraySize = n_fields * n_cells * sizeof(Real);
   #endif  // MHD
-    GPU_Error_Check(cudaMalloc((void **)&dev_conserved_half, n_fields * n_cells * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Lx, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Rx, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Ly, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Ry, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Lz, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&Q_Rz, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&F_x, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&F_y, arraySize));
-    GPU_Error_Check(cudaMalloc((void **)&F_z, arraySize));
+    cuda_utilities::Pool_Malloc(&dev_conserved_half, n_fields * n_cells * sizeof(Real));
+  #ifdef VL_PRIMITIVE_CACHE
+    cuda_utilities::Pool_Malloc(&dev_primitive, n_fields * n_cells * sizeof(Real));
+  #endif  // VL_PRIMITIVE_CACHE
+    cuda_utilities::Pool_Malloc_Managed(&Q_Lx, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&Q_Rx, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&Q_Ly, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&Q_Ry, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&Q_Lz, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&Q_Rz, arraySize);
+  #ifdef MHD_LOW_STORAGE
+    // The fluxes take the place of the left interface states. Every thread of
+    // the HLLD solver loads both of its states before it writes the flux of
+    // the same interface, and nothing reads the interface states after the
+    // Riemann solves
+    F_x = Q_Lx;
+    F_y = Q_Ly;
+    F_z = Q_Lz;
+  #else   // not MHD_LOW_STORAGE
+    cuda_utilities::Pool_Malloc_Managed(&F_x, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&F_y, arraySize);
+    cuda_utilities::Pool_Malloc_Managed(&F_z, arraySize);
+  #endif  // MHD_LOW_STORAGE
 
     cuda_utilities::initGpuMemory(dev_conserved_half, n_fields * n_cells * sizeof(Real));
     cuda_utilities::initGpuMemory(Q_Lx, arraySize);
@@ -111,269 +449,874 @@ void VL_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int
     cuda_utilities::initGpuMemory(Q_Ry, arraySize);
     cuda_utilities::initGpuMemory(Q_Lz, arraySize);
     cuda_utilities::initGpuMemory(Q_Rz, arraySize);
+  #ifndef MHD_LOW_STORAGE
     cuda_utilities::initGpuMemory(F_x, arraySize);
     cuda_utilities::initGpuMemory(F_y, arraySize);
     cuda_utilities::initGpuMemory(F_z, arraySize);
+  #endif  // not MHD_LOW_STORAGE
 
-  #ifdef MHD
-    GPU_Error_Check(cudaMalloc((void **)&ctElectricFields, ctArraySize));
-  #endif  // MHD
-
-  #if defined(GRAVITY)
-    dev_grav_potential = d_grav_potential;
-  #else   // not GRAVITY
-    dev_grav_potential = NULL;
-  #endif  // GRAVITY
+  #if defined(MHD) && !defined(VL_FUSED_CT)
+    #ifdef MHD_LOW_STORAGE
+    // The x-direction right interface states are not needed after the x
+    // Riemann solve, which comes before the CT electric fields. They are
+    // overwritten by the next reconstruction, after the magnetic update
+    ctElectricFields = Q_Rx;
+    #else   // not MHD_LOW_STORAGE
+    cuda_utilities::Pool_Malloc(&ctElectricFields, ctArraySize);
+    #endif  // MHD_LOW_STORAGE
+  #endif    // MHD and not VL_FUSED_CT
 
     // If memory is single allocated: memory_allocated becomes true and
     // successive timesteps won't allocate memory. If the memory is not single
     // allocated: memory_allocated remains Null and memory is allocated every
     // timestep.
     memory_allocated = true;
+
+    Report_VL_Memory_Traffic(n_fields);
+    Report_VL_Memory_Footprint(n_fields);
+    Report_VL_Kernel_Resource_Usage();
   }
 
+  // Set every step since the slab and overlap modes pass a different section
+  // of the grid and potential each call
+  dev_conserved = d_conserved;
+  #if defined(GRAVITY)
+  dev_grav_potential = d_grav_potential;
+  #else   // not GRAVITY
+  dev_grav_potential = NULL;
+  #endif  // GRAVITY
+
+  #ifdef MANAGED_MEMORY
+  // The interface arrays and the potential are used right away, the fluxes
+  // only from the first Riemann solve on
+  prefetch_start.Record(stream);
+  prefetch_start.Wait(prefetch_stream);
+  for (Real *const array : {F_x, F_y, F_z}) {
+    cuda_utilities::Pool_Prefetch(array, prefetch_stream);
+  }
+  fluxes_prefetched.Record(prefetch_stream);
+  for (Real *const array : {Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz, dev_grav_potential}) {
+    cuda_utilities::Pool_Prefetch(array, stream);
+  }
+  #endif  // MANAGED_MEMORY
+
   #if defined(GRAVITY) && !defined(GRAVITY_GPU)
-  GPU_Error_Check(cudaMemcpy(dev_grav_potential, temp_potential, n_cells * sizeof(Real), cudaMemcpyHostToDevice));
+  if (potential_ready == nullptr) {
+    GPU_Error_Check(cudaMemcpyAsync(dev_grav_potential, temp_potential, n_cells * sizeof(Real),
+                                    cudaMemcpyHostToDevice, stream));
+  }
   #endif  // GRAVITY and GRAVITY_GPU
 
+  #ifdef VL_FUSED
+  // Steps 1-3: Fused PCM reconstruction, first-order HLLC fluxes and half
+  // timestep update. The interface and flux arrays are not touched.
+  cuda_utilities::TunedLaunchParams static const fused_half_launch_params(
+      "Update_Conserved_Variables_3D_half_Fused", Update_Conserved_Variables_3D_half_Fused, n_cells, stream,
+      dev_conserved, dev_conserved_half, nx, ny, nz, n_ghost, dx, dy, dz, 0.5 * dt, gama, n_fields, density_floor);
+  predictor_fused_timer.Start(stream);
+  hipLaunchKernelGGL(Update_Conserved_Variables_3D_half_Fused, fused_half_launch_params.numBlocks,
+                     fused_half_launch_params.threadsPerBlock, 0, stream, dev_conserved, dev_conserved_half, nx, ny, nz,
+                     n_ghost, dx, dy, dz, 0.5 * dt, gama, n_fields, density_floor);
+  predictor_fused_timer.Stop(stream);
+  GPU_Error_Check();
+    #ifdef MANAGED_MEMORY
+  fluxes_prefetched.Wait(stream);
+    #endif  // MANAGED_MEMORY
+
+  // The corrector step still needs the HLLC launch parameters
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const hllc_launch_params(hllc_kernel, n_cells);
+  #else   // not VL_FUSED
   // Step 1: Use PCM reconstruction to put primitive variables into interface
   // arrays
-  cuda_utilities::AutomaticLaunchParams static const pcm_launch_params(PCM_Reconstruction_3D, n_cells);
-  hipLaunchKernelGGL(PCM_Reconstruction_3D, pcm_launch_params.numBlocks, pcm_launch_params.threadsPerBlock, 0, 0,
+  cuda_utilities::TunedLaunchParams static const pcm_launch_params("PCM_Reconstruction_3D", PCM_Reconstruction_3D,
+                                                                  n_cells, stream, dev_conserved, Q_Lx, Q_Rx, Q_Ly,
+                                                                  Q_Ry, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, gama,
+                                                                  n_fields);
+  pcm_timer.Start(stream);
+  hipLaunchKernelGGL(PCM_Reconstruction_3D, pcm_launch_params.numBlocks, pcm_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, gama, n_fields);
+  pcm_timer.Stop(stream);
   GPU_Error_Check();
 
   // Step 2: Calculate first-order upwind fluxes
+  #ifdef MANAGED_MEMORY
+  fluxes_prefetched.Wait(stream);
+  #endif  // MANAGED_MEMORY
+  #ifdef RUNTIME_KERNELS
+  // The arrays of each direction, for the kernels chosen by VL_Select_Kernels
+  Real *const Q_L[3]       = {Q_Lx, Q_Ly, Q_Lz};
+  Real *const Q_R[3]       = {Q_Rx, Q_Ry, Q_Rz};
+  Real *const F[3]         = {F_x, F_y, F_z};
+  Real const cell_sizes[3] = {dx, dy, dz};
+  Solve_Riemann(selected_riemann_solver, Q_L, Q_R, F, nx, ny, nz, n_ghost, n_fields, riemann_predictor_timers, stream);
+  #else   // not RUNTIME_KERNELS
   #ifdef EXACT
-  cuda_utilities::AutomaticLaunchParams static const exact_launch_params(Calculate_Exact_Fluxes_CUDA,
-                                                                         n_cellsCalculate_Exact_Fluxes_CUDA);
+  cuda_utilities::TunedLaunchParams static const exact_launch_params("Calculate_Exact_Fluxes_CUDA",
+                                                                    Calculate_Exact_Fluxes_CUDA, n_cells, stream, Q_Lx,
+                                                                    Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Stop(stream);
+  riemann_predictor_timers[1].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_predictor_timers[1].Stop(stream);
+  riemann_predictor_timers[2].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_predictor_timers[2].Stop(stream);
   #endif  // EXACT
   #ifdef ROE
-  cuda_utilities::AutomaticLaunchParams static const roe_launch_params(Calculate_Roe_Fluxes_CUDA, n_cells);
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  cuda_utilities::TunedLaunchParams static const roe_launch_params("Calculate_Roe_Fluxes_CUDA",
+                                                                  Calculate_Roe_Fluxes_CUDA, n_cells, stream, Q_Lx,
+                                                                  Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Stop(stream);
+  riemann_predictor_timers[1].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_predictor_timers[1].Stop(stream);
+  riemann_predictor_timers[2].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_predictor_timers[2].Stop(stream);
   #endif  // ROE
   #ifdef HLLC
-  cuda_utilities::AutomaticLaunchParams static const hllc_launch_params(Calculate_HLLC_Fluxes_CUDA, n_cells);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  cuda_utilities::TunedLaunchParams static const hllc_launch_params(
+      "Calculate_HLLC_Fluxes_CUDA", hllc_kernel, n_cells, stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0,
+      n_fields);
+  riemann_predictor_timers[0].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Lx,
+                     Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Stop(stream);
+  riemann_predictor_timers[1].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Ly,
+                     Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_predictor_timers[1].Stop(stream);
+  riemann_predictor_timers[2].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Lz,
+                     Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_predictor_timers[2].Stop(stream);
   #endif  // HLLC
   #ifdef HLL
-  cuda_utilities::AutomaticLaunchParams static const hll_launch_params(Calculate_HLL_Fluxes_CUDA, n_cells);
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  cuda_utilities::TunedLaunchParams static const hll_launch_params("Calculate_HLL_Fluxes_CUDA",
+                                                                  Calculate_HLL_Fluxes_CUDA, n_cells, stream, Q_Lx,
+                                                                  Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_predictor_timers[0].Stop(stream);
+  riemann_predictor_timers[1].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_predictor_timers[1].Stop(stream);
+  riemann_predictor_timers[2].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_predictor_timers[2].Stop(stream);
   #endif  // HLL
   #ifdef HLLD
-  cuda_utilities::AutomaticLaunchParams static const hlld_launch_params(mhd::Calculate_HLLD_Fluxes_CUDA, n_cells);
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Lx, Q_Rx, &(dev_conserved[(grid_enum::magnetic_x)*n_cells]), F_x, n_cells, gama, 0,
-                     n_fields);
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Ly, Q_Ry, &(dev_conserved[(grid_enum::magnetic_y)*n_cells]), F_y, n_cells, gama, 1,
-                     n_fields);
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Lz, Q_Rz, &(dev_conserved[(grid_enum::magnetic_z)*n_cells]), F_z, n_cells, gama, 2,
-                     n_fields);
+  auto *const hlld_kernel = mhd::Select_Calculate_HLLD_Fluxes_CUDA();
+  cuda_utilities::TunedLaunchParams static const hlld_launch_params(
+      "Calculate_HLLD_Fluxes_CUDA", hlld_kernel, n_cells, stream, Q_Lx, Q_Rx,
+      &(dev_conserved[(grid_enum::magnetic_x)*n_cells]), F_x, n_cells, gama, 0, n_fields);
+  riemann_predictor_timers[0].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Lx,
+                     Q_Rx, &(dev_conserved[(grid_enum::magnetic_x)*n_cells]), F_x, n_cells, gama, 0, n_fields);
+  riemann_predictor_timers[0].Stop(stream);
+  riemann_predictor_timers[1].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Ly,
+                     Q_Ry, &(dev_conserved[(grid_enum::magnetic_y)*n_cells]), F_y, n_cells, gama, 1, n_fields);
+  riemann_predictor_timers[1].Stop(stream);
+  riemann_predictor_timers[2].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Lz,
+                     Q_Rz, &(dev_conserved[(grid_enum::magnetic_z)*n_cells]), F_z, n_cells, gama, 2, n_fields);
+  riemann_predictor_timers[2].Stop(stream);
   #endif  // HLLD
+  #endif  // RUNTIME_KERNELS
   GPU_Error_Check();
 
-  #ifdef MHD
+  #if defined(MHD) && !defined(VL_FUSED_CT)
   // Step 2.5: Compute the Constrained transport electric fields
-  cuda_utilities::AutomaticLaunchParams static const ct_launch_params(mhd::Calculate_CT_Electric_Fields, n_cells);
+  cuda_utilities::TunedLaunchParams static const ct_launch_params("Calculate_CT_Electric_Fields",
+                                                                 mhd::Calculate_CT_Electric_Fields, n_cells, stream,
+                                                                 F_x, F_y, F_z, dev_conserved, ctElectricFields, nx,
+                                                                 ny, nz, n_cells);
+  ct_predictor_timer.Start(stream);
   hipLaunchKernelGGL(mhd::Calculate_CT_Electric_Fields, ct_launch_params.numBlocks, ct_launch_params.threadsPerBlock, 0,
-                     0, F_x, F_y, F_z, dev_conserved, ctElectricFields, nx, ny, nz, n_cells);
+                     stream, F_x, F_y, F_z, dev_conserved, ctElectricFields, nx, ny, nz, n_cells);
+  ct_predictor_timer.Stop(stream);
   GPU_Error_Check();
-  #endif  // MHD
+  #endif  // MHD and not VL_FUSED_CT
 
   // Step 3: Update the conserved variables half a timestep
-  cuda_utilities::AutomaticLaunchParams static const update_half_launch_params(Update_Conserved_Variables_3D_half,
-                                                                               n_cells);
+  cuda_utilities::TunedLaunchParams static const update_half_launch_params(
+      "Update_Conserved_Variables_3D_half", Update_Conserved_Variables_3D_half, n_cells, stream, dev_conserved,
+      dev_conserved_half, F_x, F_y, F_z, nx, ny, nz, n_ghost, dx, dy, dz, 0.5 * dt, gama, n_fields, density_floor);
+  update_half_timer.Start(stream);
   hipLaunchKernelGGL(Update_Conserved_Variables_3D_half, update_half_launch_params.numBlocks,
-                     update_half_launch_params.threadsPerBlock, 0, 0, dev_conserved, dev_conserved_half, F_x, F_y, F_z,
-                     nx, ny, nz, n_ghost, dx, dy, dz, 0.5 * dt, gama, n_fields, density_floor);
+                     update_half_launch_params.threadsPerBlock, 0, stream, dev_conserved, dev_conserved_half, F_x, F_y,
+                     F_z, nx, ny, nz, n_ghost, dx, dy, dz, 0.5 * dt, gama, n_fields, density_floor);
+  update_half_timer.Stop(stream);
   GPU_Error_Check();
+  #endif  // VL_FUSED
 
   #ifdef MHD
+    #ifdef VL_FUSED_CT
+  // Compute the CT electric fields of the predictor fluxes and update the
+  // magnetic fields with them in one kernel, timed as the magnetic update
+  magnetic_half_timer.Start(stream);
+  hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D_Fused, mhd::fusedMagneticUpdateBlocks(nx, ny, nz), TPB, 0, stream,
+                     F_x, F_y, F_z, dev_conserved, dev_conserved, dev_conserved_half, nx, ny, nz, n_cells, 0.5 * dt, dx,
+                     dy, dz);
+  magnetic_half_timer.Stop(stream);
+    #else   // not VL_FUSED_CT
   // Update the magnetic fields
-  cuda_utilities::AutomaticLaunchParams static const update_magnetic_launch_params(mhd::Update_Magnetic_Field_3D,
-                                                                                   n_cells);
+  cuda_utilities::TunedLaunchParams static const update_magnetic_launch_params(
+      "Update_Magnetic_Field_3D", mhd::Update_Magnetic_Field_3D, n_cells, stream, dev_conserved, dev_conserved_half,
+      ctElectricFields, nx, ny, nz, n_cells, 0.5 * dt, dx, dy, dz);
+  magnetic_half_timer.Start(stream);
   hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D, update_magnetic_launch_params.numBlocks,
-                     update_magnetic_launch_params.threadsPerBlock, 0, 0, dev_conserved, dev_conserved_half,
+                     update_magnetic_launch_params.threadsPerBlock, 0, stream, dev_conserved, dev_conserved_half,
                      ctElectricFields, nx, ny, nz, n_cells, 0.5 * dt, dx, dy, dz);
+  magnetic_half_timer.Stop(stream);
+    #endif  // VL_FUSED_CT
   GPU_Error_Check();
   #endif  // MHD
 
+  #ifdef VL_FUSED_CORRECTOR
+  // Steps 4 and 5: Reconstruct the interfaces from the half step state and
+  // calculate the fluxes in a single kernel per direction
+  auto *const fused_flux_kernel = Calculate_Fluxes_Fused_3D<CorrectorReconstruction, riemann_solvers::HllcPolicy>;
+  cuda_utilities::TunedLaunchParams static const fused_flux_launch_params(
+      "Calculate_Fluxes_Fused_3D", fused_flux_kernel, n_cells, stream, dev_conserved_half, F_x, nx, ny, nz, dx, dt,
+      gama, 0, n_fields);
+  reconstruction_timers[0].Start(stream);
+  hipLaunchKernelGGL(fused_flux_kernel, fused_flux_launch_params.numBlocks, fused_flux_launch_params.threadsPerBlock, 0,
+                     stream, dev_conserved_half, F_x, nx, ny, nz, dx, dt, gama, 0, n_fields);
+  reconstruction_timers[0].Stop(stream);
+  reconstruction_timers[1].Start(stream);
+  hipLaunchKernelGGL(fused_flux_kernel, fused_flux_launch_params.numBlocks, fused_flux_launch_params.threadsPerBlock, 0,
+                     stream, dev_conserved_half, F_y, nx, ny, nz, dy, dt, gama, 1, n_fields);
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  hipLaunchKernelGGL(fused_flux_kernel, fused_flux_launch_params.numBlocks, fused_flux_launch_params.threadsPerBlock, 0,
+                     stream, dev_conserved_half, F_z, nx, ny, nz, dz, dt, gama, 2, n_fields);
+  reconstruction_timers[2].Stop(stream);
+  GPU_Error_Check();
+  #else   // not VL_FUSED_CORRECTOR
   // Step 4: Construct left and right interface values using updated conserved
   // variables
+  #ifdef RUNTIME_KERNELS
+  Reconstruct(selected_reconstruction, dev_conserved_half, Q_L, Q_R, nx, ny, nz, n_ghost, cell_sizes, dt, n_fields,
+              reconstruction_timers, stream);
+  #else   // not RUNTIME_KERNELS
   #ifdef PCM
-  hipLaunchKernelGGL(PCM_Reconstruction_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved_half, Q_Lx, Q_Rx, Q_Ly, Q_Ry,
-                     Q_Lz, Q_Rz, nx, ny, nz, n_ghost, gama, n_fields);
+  pcm_timer.Start(stream);
+  hipLaunchKernelGGL(PCM_Reconstruction_3D, dim1dGrid, dim1dBlock, 0, stream, dev_conserved_half, Q_Lx, Q_Rx, Q_Ly,
+                     Q_Ry, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, gama, n_fields);
+  pcm_timer.Stop(stream);
   #endif  // PCM
   #ifdef PLMP
-  cuda_utilities::AutomaticLaunchParams static const plmp_launch_params(PLMP_cuda, n_cells);
-  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, 0,
+  cuda_utilities::TunedLaunchParams static const plmp_launch_params("PLMP_cuda", PLMP_cuda, n_cells, stream,
+                                                                   dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, n_ghost,
+                                                                   dx, dt, gama, 0, n_fields);
+  reconstruction_timers[0].Start(stream);
+  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, n_ghost, dx, dt, gama, 0, n_fields);
-  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[0].Stop(stream);
+  reconstruction_timers[1].Start(stream);
+  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, n_ghost, dy, dt, gama, 1, n_fields);
-  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  hipLaunchKernelGGL(PLMP_cuda, plmp_launch_params.numBlocks, plmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, dz, dt, gama, 2, n_fields);
+  reconstruction_timers[2].Stop(stream);
   #endif  // PLMP
-  #ifdef PLMC
-  cuda_utilities::AutomaticLaunchParams static const plmc_vl_launch_params(PLMC_cuda, n_cells);
-  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, 0,
+  #if defined(PLMC) && !defined(VL_PRIMITIVE_CACHE)
+  cuda_utilities::TunedLaunchParams static const plmc_vl_launch_params("PLMC_cuda", PLMC_cuda, n_cells, stream,
+                                                                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, dx,
+                                                                      dt, gama, 0, n_fields);
+  reconstruction_timers[0].Start(stream);
+  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, dx, dt, gama, 0, n_fields);
-  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[0].Stop(stream);
+    #ifdef VL_TILED_RECONSTRUCTION
+  reconstruction_timers[1].Start(stream);
+  reconstruction::Reconstruct_Tiled<reconstruction::PlmcPolicy>(dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, dy, dt,
+                                                                gama, 1, n_fields, stream);
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  reconstruction::Reconstruct_Tiled<reconstruction::PlmcPolicy>(dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, dz, dt,
+                                                                gama, 2, n_fields, stream);
+  reconstruction_timers[2].Stop(stream);
+    #else   // not VL_TILED_RECONSTRUCTION
+  reconstruction_timers[1].Start(stream);
+  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, dy, dt, gama, 1, n_fields);
-  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  hipLaunchKernelGGL(PLMC_cuda, plmc_vl_launch_params.numBlocks, plmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, dz, dt, gama, 2, n_fields);
-  #endif  // PLMC
+  reconstruction_timers[2].Stop(stream);
+    #endif  // VL_TILED_RECONSTRUCTION
+  #endif    // PLMC and not VL_PRIMITIVE_CACHE
   #ifdef PPMP
-  cuda_utilities::AutomaticLaunchParams static const ppmp_launch_params(PPMP_cuda, n_cells);
-  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, 0,
+  cuda_utilities::TunedLaunchParams static const ppmp_launch_params("PPMP_cuda", PPMP_cuda, n_cells, stream,
+                                                                   dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, n_ghost,
+                                                                   dx, dt, gama, 0, n_fields);
+  reconstruction_timers[0].Start(stream);
+  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, n_ghost, dx, dt, gama, 0, n_fields);
-  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[0].Stop(stream);
+  reconstruction_timers[1].Start(stream);
+  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, n_ghost, dy, dt, gama, 1, n_fields);
-  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  hipLaunchKernelGGL(PPMP_cuda, ppmp_launch_params.numBlocks, ppmp_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, dz, dt, gama, 2, n_fields);
+  reconstruction_timers[2].Stop(stream);
   #endif  // PPMP
-  #ifdef PPMC
-  cuda_utilities::AutomaticLaunchParams static const ppmc_vl_launch_params(PPMC_VL, n_cells);
-  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, 0,
+  #if defined(PPMC) && !defined(VL_PRIMITIVE_CACHE)
+  cuda_utilities::TunedLaunchParams static const ppmc_vl_launch_params("PPMC_VL", PPMC_VL, n_cells, stream,
+                                                                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, gama,
+                                                                      0);
+  reconstruction_timers[0].Start(stream);
+  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lx, Q_Rx, nx, ny, nz, gama, 0);
-  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[0].Stop(stream);
+    #ifdef VL_TILED_RECONSTRUCTION
+  reconstruction_timers[1].Start(stream);
+  reconstruction::Reconstruct_Tiled<reconstruction::PpmcPolicy>(dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, 0, 0, gama,
+                                                                1, n_fields, stream);
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  reconstruction::Reconstruct_Tiled<reconstruction::PpmcPolicy>(dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, 0, 0, gama,
+                                                                2, n_fields, stream);
+  reconstruction_timers[2].Stop(stream);
+    #else   // not VL_TILED_RECONSTRUCTION
+  reconstruction_timers[1].Start(stream);
+  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Ly, Q_Ry, nx, ny, nz, gama, 1);
-  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, 0,
+  reconstruction_timers[1].Stop(stream);
+  reconstruction_timers[2].Start(stream);
+  hipLaunchKernelGGL(PPMC_VL, ppmc_vl_launch_params.numBlocks, ppmc_vl_launch_params.threadsPerBlock, 0, stream,
                      dev_conserved_half, Q_Lz, Q_Rz, nx, ny, nz, gama, 2);
-  #endif  // PPMC
+  reconstruction_timers[2].Stop(stream);
+    #endif  // VL_TILED_RECONSTRUCTION
+  #endif    // PPMC and not VL_PRIMITIVE_CACHE
+  #ifdef VL_PRIMITIVE_CACHE
+  // Convert the half step state to primitives once for all three sweeps
+  primitive_cache_timer.Start(stream);
+  reconstruction::Compute_Primitive_Cache(dev_conserved_half, dev_primitive, nx, ny, nz, gama, stream);
+  primitive_cache_timer.Stop(stream);
+  Real const cell_sizes[3] = {dx, dy, dz};
+  Real *const bounds_L[3]  = {Q_Lx, Q_Ly, Q_Lz};
+  Real *const bounds_R[3]  = {Q_Rx, Q_Ry, Q_Rz};
+  for (int dir = 0; dir < 3; dir++) {
+    reconstruction_timers[dir].Start(stream);
+    reconstruction::Reconstruct_Cached<CachedReconstruction>(dev_primitive, dev_conserved_half, bounds_L[dir],
+                                                             bounds_R[dir], nx, ny, nz, cell_sizes[dir], dt, gama, dir,
+                                                             stream);
+    reconstruction_timers[dir].Stop(stream);
+  }
+  #endif  // VL_PRIMITIVE_CACHE
+  #endif  // RUNTIME_KERNELS
   GPU_Error_Check();
 
   // Step 5: Calculate the fluxes again
+  #ifdef RUNTIME_KERNELS
+  Solve_Riemann(selected_riemann_solver, Q_L, Q_R, F, nx, ny, nz, n_ghost, n_fields, riemann_corrector_timers, stream);
+  #else   // not RUNTIME_KERNELS
   #ifdef EXACT
+  riemann_corrector_timers[0].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_corrector_timers[0].Stop(stream);
+  riemann_corrector_timers[1].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_corrector_timers[1].Stop(stream);
+  riemann_corrector_timers[2].Start(stream);
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, exact_launch_params.numBlocks, exact_launch_params.threadsPerBlock, 0,
-                     0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[2].Stop(stream);
   #endif  // EXACT
   #ifdef ROE
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[0].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_corrector_timers[0].Stop(stream);
+  riemann_corrector_timers[1].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_corrector_timers[1].Stop(stream);
+  riemann_corrector_timers[2].Start(stream);
+  hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, roe_launch_params.numBlocks, roe_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[2].Stop(stream);
   #endif  // ROE
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[0].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Lx,
+                     Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_corrector_timers[0].Stop(stream);
+  riemann_corrector_timers[1].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Ly,
+                     Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_corrector_timers[1].Stop(stream);
+  riemann_corrector_timers[2].Start(stream);
+  hipLaunchKernelGGL(hllc_kernel, hllc_launch_params.numBlocks, hllc_launch_params.threadsPerBlock, 0, stream, Q_Lz,
+                     Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[2].Stop(stream);
   #endif  // HLLC
   #ifdef HLL
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0, 0,
-                     Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[0].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_corrector_timers[0].Stop(stream);
+  riemann_corrector_timers[1].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_corrector_timers[1].Stop(stream);
+  riemann_corrector_timers[2].Start(stream);
+  hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, hll_launch_params.numBlocks, hll_launch_params.threadsPerBlock, 0,
+                     stream, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_corrector_timers[2].Stop(stream);
   #endif  // HLLC
   #ifdef HLLD
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Lx, Q_Rx, &(dev_conserved_half[(grid_enum::magnetic_x)*n_cells]), F_x, n_cells, gama, 0,
-                     n_fields);
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Ly, Q_Ry, &(dev_conserved_half[(grid_enum::magnetic_y)*n_cells]), F_y, n_cells, gama, 1,
-                     n_fields);
-  hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock,
-                     0, 0, Q_Lz, Q_Rz, &(dev_conserved_half[(grid_enum::magnetic_z)*n_cells]), F_z, n_cells, gama, 2,
-                     n_fields);
+  riemann_corrector_timers[0].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Lx,
+                     Q_Rx, &(dev_conserved_half[(grid_enum::magnetic_x)*n_cells]), F_x, n_cells, gama, 0, n_fields);
+  riemann_corrector_timers[0].Stop(stream);
+  riemann_corrector_timers[1].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Ly,
+                     Q_Ry, &(dev_conserved_half[(grid_enum::magnetic_y)*n_cells]), F_y, n_cells, gama, 1, n_fields);
+  riemann_corrector_timers[1].Stop(stream);
+  riemann_corrector_timers[2].Start(stream);
+  hipLaunchKernelGGL(hlld_kernel, hlld_launch_params.numBlocks, hlld_launch_params.threadsPerBlock, 0, stream, Q_Lz,
+                     Q_Rz, &(dev_conserved_half[(grid_enum::magnetic_z)*n_cells]), F_z, n_cells, gama, 2, n_fields);
+  riemann_corrector_timers[2].Stop(stream);
   #endif  // HLLD
+  #endif  // RUNTIME_KERNELS
   GPU_Error_Check();
+  #endif  // VL_FUSED_CORRECTOR
 
   #ifdef DE
   // Compute the divergence of Vel before updating the conserved array, this
   // solves synchronization issues when adding this term on
-  // Update_Conserved_Variables_3D
+  // Update_Conserved_Variables
   cuda_utilities::AutomaticLaunchParams static const de_advect_launch_params(Partial_Update_Advected_Internal_Energy_3D,
                                                                              n_cells);
+  de_advect_timer.Start(stream);
   hipLaunchKernelGGL(Partial_Update_Advected_Internal_Energy_3D, de_advect_launch_params.numBlocks,
-                     de_advect_launch_params.threadsPerBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz,
-                     nx, ny, nz, n_ghost, dx, dy, dz, dt, gama, n_fields);
+                     de_advect_launch_params.threadsPerBlock, 0, stream, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz,
+                     Q_Rz, nx, ny, nz, n_ghost, dx, dy, dz, dt, gama, n_fields);
+  de_advect_timer.Stop(stream);
   GPU_Error_Check();
   #endif  // DE
 
-  #ifdef MHD
+  #if defined(MHD) && !defined(VL_FUSED_CT)
   // Step 5.5: Compute the Constrained transport electric fields
+  ct_corrector_timer.Start(stream);
   hipLaunchKernelGGL(mhd::Calculate_CT_Electric_Fields, ct_launch_params.numBlocks, ct_launch_params.threadsPerBlock, 0,
-                     0, F_x, F_y, F_z, dev_conserved_half, ctElectricFields, nx, ny, nz, n_cells);
+                     stream, F_x, F_y, F_z, dev_conserved_half, ctElectricFields, nx, ny, nz, n_cells);
+  ct_corrector_timer.Stop(stream);
   GPU_Error_Check();
-  #endif  // MHD
+  #endif  // MHD and not VL_FUSED_CT
 
   // Step 6: Update the conserved variable array
-  cuda_utilities::AutomaticLaunchParams static const update_full_launch_params(Update_Conserved_Variables_3D, n_cells);
-  hipLaunchKernelGGL(Update_Conserved_Variables_3D, update_full_launch_params.numBlocks,
-                     update_full_launch_params.threadsPerBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz,
-                     F_x, F_y, F_z, nx, ny, nz, x_off, y_off, z_off, n_ghost, dx, dy, dz, xbound, ybound, zbound, dt,
-                     gama, n_fields, custom_grav, density_floor, dev_grav_potential);
+  #if defined(GRAVITY) && !defined(GRAVITY_GPU)
+  // The only stage that reads the potential, the upload had until here
+  if (potential_ready != nullptr) {
+    GPU_Error_Check(cudaStreamWaitEvent(stream, potential_ready, 0));
+  }
+  #endif  // GRAVITY and not GRAVITY_GPU
+  auto *const update_full_kernel = Select_Update_Conserved_Variables<3>(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const update_full_launch_params(update_full_kernel, n_cells);
+  update_full_timer.Start(stream);
+  hipLaunchKernelGGL(update_full_kernel, update_full_launch_params.numBlocks, update_full_launch_params.threadsPerBlock,
+                     0, stream, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz, F_x, F_y, F_z, nx, ny, nz, x_off,
+                     y_off, z_off, n_ghost, dx, dy, dz, xbound, ybound, zbound, dt, gama, n_fields, custom_grav,
+                     density_floor, dev_grav_potential, static_grav_table);
+  update_full_timer.Stop(stream);
   GPU_Error_Check();
 
   #ifdef MHD
+    #ifdef VL_FUSED_CT
+  // The corrector electric fields come from the half step state, so the
+  // magnetic field can be updated in place after Update_Conserved_Variables
+  magnetic_full_timer.Start(stream);
+  hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D_Fused, mhd::fusedMagneticUpdateBlocks(nx, ny, nz), TPB, 0, stream,
+                     F_x, F_y, F_z, dev_conserved_half, dev_conserved, dev_conserved, nx, ny, nz, n_cells, dt, dx, dy,
+                     dz);
+  magnetic_full_timer.Stop(stream);
+    #else   // not VL_FUSED_CT
   // Update the magnetic fields
+  magnetic_full_timer.Start(stream);
   hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D, update_magnetic_launch_params.numBlocks,
-                     update_magnetic_launch_params.threadsPerBlock, 0, 0, dev_conserved, dev_conserved,
+                     update_magnetic_launch_params.threadsPerBlock, 0, stream, dev_conserved, dev_conserved,
                      ctElectricFields, nx, ny, nz, n_cells, dt, dx, dy, dz);
+  magnetic_full_timer.Stop(stream);
+    #endif  // VL_FUSED_CT
   GPU_Error_Check();
   #endif  // MHD
 
-  #ifdef DE
+  #ifdef POST_UPDATE_KERNEL
+  post_update_timer.Start(stream);
+    #ifdef DE
+  // The selection reads the total energy of the neighbors, so it can't share a
+  // kernel with the synchronization that writes it
   cuda_utilities::AutomaticLaunchParams static const de_select_launch_params(Select_Internal_Energy_3D, n_cells);
   hipLaunchKernelGGL(Select_Internal_Energy_3D, de_select_launch_params.numBlocks,
-                     de_select_launch_params.threadsPerBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, n_fields);
-  cuda_utilities::AutomaticLaunchParams static const de_sync_launch_params(Sync_Energies_3D, n_cells);
-  hipLaunchKernelGGL(Sync_Energies_3D, de_sync_launch_params.numBlocks, de_sync_launch_params.threadsPerBlock, 0, 0,
-                     dev_conserved, nx, ny, nz, n_ghost, gama, n_fields);
+                     de_select_launch_params.threadsPerBlock, 0, stream, dev_conserved, nx, ny, nz, n_ghost, n_fields);
+    #endif  // DE
+  // The synchronization and the floors only touch their own cell
+  cuda_utilities::AutomaticLaunchParams static const post_update_launch_params(Sync_Energies_And_Apply_Floors_3D,
+                                                                              n_cells);
+  hipLaunchKernelGGL(Sync_Energies_And_Apply_Floors_3D, post_update_launch_params.numBlocks,
+                     post_update_launch_params.threadsPerBlock, 0, stream, dev_conserved, nx, ny, nz, n_ghost, gama,
+                     n_fields, U_floor, scalar_floor);
+  post_update_timer.Stop(stream);
   GPU_Error_Check();
-  #endif  // DE
+  #endif  // POST_UPDATE_KERNEL
 
   return;
 }
 
+// Staging buffers for VL_Algorithm_3D_Slabs_CUDA. slab_conserved is always
+// the array handed to VL_Algorithm_3D_CUDA, slab_next holds the following slab
+Real *slab_conserved = NULL, *slab_next = NULL;
+
+void VL_Algorithm_3D_Slabs_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off, int y_off,
+                                int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound, Real ybound,
+                                Real zbound, Real dt, int n_fields, int custom_grav, Real density_floor, Real U_floor,
+                                Real scalar_floor, Real *host_grav_potential, int n_slabs)
+{
+  int const nz_real    = nz - 2 * n_ghost;
+  int const slab_width = (nz_real + n_slabs - 1) / n_slabs;
+  size_t const n_plane = nx * ny;
+
+  // The halo of each slab has to lie within its neighbors since the slabs are
+  // written back one at a time
+  if (slab_width < n_ghost) {
+    chprintf("Error: n_vl_slabs = %d gives slabs of %d cells, fewer than n_ghost = %d\n", n_slabs, slab_width, n_ghost);
+    chexit(-1);
+  }
+
+  if (slab_conserved == NULL) {
+    size_t const slab_size = n_fields * n_plane * (slab_width + 2 * n_ghost) * sizeof(Real);
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
+    cuda_utilities::Pool_Malloc(&slab_conserved, slab_size);
+    cuda_utilities::Pool_Malloc(&slab_next, slab_size);
+    chprintf(" VL slab mode: %d slabs of %d cells in z\n", n_slabs, slab_width);
+  }
+
+  // Copy n_planes z-planes of every field between two arrays with nz_src and
+  // nz_dst planes per field
+  auto copy_planes = [&](Real *dst, int nz_dst, int z_dst, Real *src, int nz_src, int z_src, int n_planes) {
+    GPU_Error_Check(cudaMemcpy2D(dst + z_dst * n_plane, nz_dst * n_plane * sizeof(Real), src + z_src * n_plane,
+                                 nz_src * n_plane * sizeof(Real), n_planes * n_plane * sizeof(Real), n_fields,
+                                 cudaMemcpyDeviceToDevice));
+  };
+
+  // Slab k updates the real planes [z_lo, z_hi) using [z_lo - n_ghost, z_hi + n_ghost)
+  auto z_lo = [&](int k) { return n_ghost + k * slab_width; };
+  auto z_hi = [&](int k) { return std::min(n_ghost + (k + 1) * slab_width, nz - n_ghost); };
+
+  copy_planes(slab_next, z_hi(0) - z_lo(0) + 2 * n_ghost, 0, d_conserved, nz, 0, z_hi(0) - z_lo(0) + 2 * n_ghost);
+
+  for (int k = 0; k < n_slabs && z_lo(k) < z_hi(k); k++) {
+    int const nz_slab = z_hi(k) - z_lo(k) + 2 * n_ghost;
+    int const z_start = z_lo(k) - n_ghost;
+    GPU_Error_Check(
+        cudaMemcpy(slab_conserved, slab_next, n_fields * n_plane * nz_slab * sizeof(Real), cudaMemcpyDeviceToDevice));
+
+    // Stage the next slab before this one is written back, every plane it
+    // needs still holds the values from the start of the step
+    if (k + 1 < n_slabs && z_lo(k + 1) < z_hi(k + 1)) {
+      int const nz_next = z_hi(k + 1) - z_lo(k + 1) + 2 * n_ghost;
+      copy_planes(slab_next, nz_next, 0, d_conserved, nz, z_lo(k + 1) - n_ghost, nz_next);
+    }
+
+    Real *slab_potential      = (d_grav_potential == NULL) ? NULL : d_grav_potential + z_start * n_plane;
+    Real *slab_host_potential = (host_grav_potential == NULL) ? NULL : host_grav_potential + z_start * n_plane;
+    VL_Algorithm_3D_CUDA(slab_conserved, slab_potential, nx, ny, nz_slab, x_off, y_off, z_off + z_start, n_ghost, dx,
+                         dy, dz, xbound, ybound, zbound, dt, n_fields, custom_grav, density_floor, U_floor,
+                         scalar_floor, slab_host_potential);
+
+    copy_planes(d_conserved, nz, z_lo(k), slab_conserved, nz_slab, n_ghost, z_hi(k) - z_lo(k));
+  }
+}
+
+void Free_Memory_VL_3D_Slabs(Real *d_conserved)
+{
+  cuda_utilities::Pool_Free(slab_next);
+  cuda_utilities::Pool_Free(d_conserved);
+}
+
+  #ifdef VL_OVERLAP
+    #if defined(GRAVITY) && !defined(GRAVITY_GPU)
+      #error "VL_OVERLAP requires GRAVITY_GPU when gravity is enabled"
+    #endif  // GRAVITY and not GRAVITY_GPU
+
+// Staging buffers for VL_Algorithm_3D_Overlap_CUDA. The interior box comes
+// first, followed by the six boxes of the boundary shell
+Real *overlap_conserved = NULL, *overlap_potential = NULL;
+
+/*! \fn void Copy_Box_3D(...)
+ *  \brief Copy a box of bx*by*bz cells of every field from src, starting at
+ *  cell (si, sj, sk), to dst, starting at cell (di, dj, dk) */
+__global__ void Copy_Box_3D(Real *dst, int dst_nx, int dst_ny, int dst_n_cells, int di, int dj, int dk,
+                            Real const *src, int src_nx, int src_ny, int src_n_cells, int si, int sj, int sk, int bx,
+                            int by, int bz, int n_fields)
+{
+  int const n_box = bx * by * bz;
+  for (int tid = threadIdx.x + blockIdx.x * blockDim.x; tid < n_box; tid += blockDim.x * gridDim.x) {
+    int i, j, k;
+    cuda_utilities::compute3DIndices(tid, bx, by, i, j, k);
+    int const src_id = (si + i) + (sj + j) * src_nx + (sk + k) * src_nx * src_ny;
+    int const dst_id = (di + i) + (dj + j) * dst_nx + (dk + k) * dst_nx * dst_ny;
+    for (int field = 0; field < n_fields; field++) {
+      dst[dst_id + field * dst_n_cells] = src[src_id + field * src_n_cells];
+    }
+  }
+}
+
+Real VL_Algorithm_3D_Overlap_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off,
+                                  int y_off, int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound,
+                                  Real ybound, Real zbound, Real dt, int n_fields, int custom_grav, Real density_floor,
+                                  Real U_floor, Real scalar_floor, std::function<void()> const &exchange_boundaries,
+                                  cudaStream_t stream, cudaStream_t boundary_stream)
+{
+  int const ng = n_ghost;
+
+  // A box that updates the cells [i, i + ni) x [j, j + nj) x [k, k + nk) of
+  // the grid. It is staged with n_ghost halo cells on each side, giving
+  // nx * ny * nz cells starting at offset in the staging buffer
+  struct Box {
+    int i, j, k, ni, nj, nk, nx, ny, nz;
+    size_t n_cells, offset;
+  };
+  size_t n_staged = 0;
+  auto make_box   = [&](int i, int j, int k, int ni, int nj, int nk) {
+    Box const box = {i, j, k, ni, nj, nk, ni + 2 * ng, nj + 2 * ng, nk + 2 * ng,
+                     size_t(ni + 2 * ng) * (nj + 2 * ng) * (nk + 2 * ng), n_staged};
+    n_staged += box.n_cells;
+    return box;
+  };
+
+  // The interior only depends on real cells. The shell is split into its z,
+  // y and x faces, each shorter than the previous so they don't overlap
+  std::vector<Box> const boxes = {make_box(2 * ng, 2 * ng, 2 * ng, nx - 4 * ng, ny - 4 * ng, nz - 4 * ng),
+                                  make_box(ng, ng, ng, nx - 2 * ng, ny - 2 * ng, ng),
+                                  make_box(ng, ng, nz - 2 * ng, nx - 2 * ng, ny - 2 * ng, ng),
+                                  make_box(ng, ng, 2 * ng, nx - 2 * ng, ng, nz - 4 * ng),
+                                  make_box(ng, ny - 2 * ng, 2 * ng, nx - 2 * ng, ng, nz - 4 * ng),
+                                  make_box(ng, 2 * ng, 2 * ng, ng, ny - 4 * ng, nz - 4 * ng),
+                                  make_box(nx - 2 * ng, 2 * ng, 2 * ng, ng, ny - 4 * ng, nz - 4 * ng)};
+
+  if (overlap_conserved == NULL) {
+    // The interface and flux buffers and the launch parameters are sized by
+    // the first call to VL_Algorithm_3D_CUDA, which is the interior box
+    if (std::min({nx, ny, nz}) <= 4 * ng) {
+      chprintf("Error: VL_OVERLAP needs more than %d real cells in each direction\n", 2 * ng);
+      chexit(-1);
+    }
+    for (Box const &box : boxes) {
+      if (box.n_cells > boxes[0].n_cells) {
+        chprintf("Error: VL_OVERLAP needs the interior of the grid to be larger than each face of the shell\n");
+        chexit(-1);
+      }
+    }
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
+    cuda_utilities::Pool_Malloc(&overlap_conserved, n_fields * n_staged * sizeof(Real), stream);
+    if (d_grav_potential != NULL) {
+      cuda_utilities::Pool_Malloc(&overlap_potential, n_staged * sizeof(Real), stream);
+    }
+    chprintf(" VL overlap mode: staging %.1f%% of the grid\n", 100.0 * n_staged / (nx * ny * nz));
+  }
+
+  cuda_utilities::AutomaticLaunchParams static const copy_launch_params(Copy_Box_3D);
+  auto stage = [&](Box const &box) {
+    hipLaunchKernelGGL(Copy_Box_3D, copy_launch_params.numBlocks, copy_launch_params.threadsPerBlock, 0, stream,
+                       overlap_conserved + n_fields * box.offset, box.nx, box.ny, box.n_cells, 0, 0, 0,
+                       d_conserved, nx, ny, nx * ny * nz, box.i - ng, box.j - ng, box.k - ng, box.nx, box.ny,
+                       box.nz, n_fields);
+    if (d_grav_potential != NULL) {
+      hipLaunchKernelGGL(Copy_Box_3D, copy_launch_params.numBlocks, copy_launch_params.threadsPerBlock, 0, stream,
+                         overlap_potential + box.offset, box.nx, box.ny, box.n_cells, 0, 0, 0, d_grav_potential,
+                         nx, ny, nx * ny * nz, box.i - ng, box.j - ng, box.k - ng, box.nx, box.ny, box.nz, 1);
+    }
+    GPU_Error_Check();
+  };
+  auto update = [&](Box const &box) {
+    Real *box_potential = (d_grav_potential == NULL) ? NULL : overlap_potential + box.offset;
+    VL_Algorithm_3D_CUDA(overlap_conserved + n_fields * box.offset, box_potential, box.nx, box.ny, box.nz,
+                         x_off + box.i - ng, y_off + box.j - ng, z_off + box.k - ng, n_ghost, dx, dy, dz, xbound,
+                         ybound, zbound, dt, n_fields, custom_grav, density_floor, U_floor, scalar_floor, NULL,
+                         stream);
+  };
+  auto write_back = [&](Box const &box) {
+    hipLaunchKernelGGL(Copy_Box_3D, copy_launch_params.numBlocks, copy_launch_params.threadsPerBlock, 0, stream,
+                       d_conserved, nx, ny, nx * ny * nz, box.i, box.j, box.k,
+                       overlap_conserved + n_fields * box.offset, box.nx, box.ny, box.n_cells, ng, ng, ng, box.ni,
+                       box.nj, box.nk, n_fields);
+    GPU_Error_Check();
+  };
+
+  cuda_utilities::Event static interior_start(true), interior_done(true), exchange_done;
+
+  // Update the interior while the halos are exchanged. Neither touches the
+  // cells the other writes
+  stage(boxes[0]);
+  interior_start.Record(stream);
+  update(boxes[0]);
+  interior_done.Record(stream);
+
+  Real const exchange_start = Get_Time();
+  exchange_boundaries();
+  Real const exchange_time = Get_Time() - exchange_start;
+  exchange_done.Record(boundary_stream);
+  exchange_done.Wait(stream);
+
+  // The shell boxes overlap each other and the interior, so every box has to
+  // be staged before any result is written back
+  for (size_t b = 1; b < boxes.size(); b++) {
+    stage(boxes[b]);
+  }
+  for (size_t b = 1; b < boxes.size(); b++) {
+    update(boxes[b]);
+  }
+  for (Box const &box : boxes) {
+    write_back(box);
+  }
+
+  // Free_Memory_VL_3D frees dev_conserved
+  dev_conserved = d_conserved;
+
+  // Only the part of the exchange that outlasted the interior update is
+  // exposed
+  interior_done.Synchronize();
+  Real const interior_time = 1e-3 * interior_done.ElapsedTime(interior_start);
+  return fmax(exchange_time - interior_time, 0.0);
+}
+
+void Free_Memory_VL_3D_Overlap()
+{
+  cuda_utilities::Pool_Free(overlap_conserved);
+  cuda_utilities::Pool_Free(overlap_potential);
+}
+  #endif  // VL_OVERLAP
+
+  #if defined(GRAVITY) && !defined(GRAVITY_GPU)
+void VL_Set_Potential_Ready(cudaEvent_t ready) { potential_ready = ready; }
+  #endif  // GRAVITY and not GRAVITY_GPU
+
+  #ifdef RUNTIME_KERNELS
+void VL_Select_Kernels(char const *reconstructions, char const *riemann_solvers, Real *d_conserved, int nx, int ny,
+                       int nz, int n_ghost, Real dx, Real dy, Real dz, Real dt, int n_fields)
+{
+  std::vector<ReconstructionKernel const *> const reconstruction_candidates = Parse_Kernel_List(
+      reconstructions, build_reconstruction, reconstruction_kernels, "reconstruction",
+      [n_ghost](ReconstructionKernel const &kernel) { return kernel.n_ghost <= n_ghost; });
+  std::vector<RiemannSolverKernel const *> const riemann_solver_candidates =
+      Parse_Kernel_List(riemann_solvers, build_riemann_solver, riemann_solver_kernels, "Riemann solver",
+                        [](RiemannSolverKernel const &) { return true; });
+
+  ReconstructionKernel const *best_reconstruction = reconstruction_candidates.front();
+  RiemannSolverKernel const *best_riemann_solver  = riemann_solver_candidates.front();
+  if (reconstruction_candidates.size() * riemann_solver_candidates.size() > 1) {
+    // Time the corrector of every combination on the initial conditions, in
+    // scratch arrays so the grid is untouched
+    int const n_cells       = nx * ny * nz;
+    size_t const array_size = n_fields * n_cells * sizeof(Real);
+    Real *bounds_L, *bounds_R, *fluxes;
+    {
+      cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::integrator);
+      cuda_utilities::Pool_Malloc(&bounds_L, array_size);
+      cuda_utilities::Pool_Malloc(&bounds_R, array_size);
+      cuda_utilities::Pool_Malloc(&fluxes, array_size);
+    }
+    // The three directions share the scratch arrays, only the time matters
+    Real *const bounds_Ls[3] = {bounds_L, bounds_L, bounds_L};
+    Real *const bounds_Rs[3] = {bounds_R, bounds_R, bounds_R};
+    Real *const fluxes_3[3]  = {fluxes, fluxes, fluxes};
+    Real const cell_sizes[3] = {dx, dy, dz};
+    int const n_repeats      = 5;
+    cuda_utilities::Event start(true), stop(true);
+
+    chprintf("Timing the VL corrector kernels on the local grid:\n");
+    double best_time = std::numeric_limits<double>::max();
+    for (ReconstructionKernel const *reconstruction : reconstruction_candidates) {
+      for (RiemannSolverKernel const *riemann_solver : riemann_solver_candidates) {
+        // One untimed pass so first launch costs aren't counted
+        for (int repeat = 0; repeat <= n_repeats; repeat++) {
+          if (repeat == 1) {
+            start.Record(0);
+          }
+          Reconstruct(reconstruction->kernel, d_conserved, bounds_Ls, bounds_Rs, nx, ny, nz, n_ghost, cell_sizes, dt,
+                      n_fields, nullptr, 0);
+          Solve_Riemann(riemann_solver->kernel, bounds_Ls, bounds_Rs, fluxes_3, nx, ny, nz, n_ghost, n_fields, nullptr,
+                        0);
+        }
+        stop.Record(0);
+        stop.Synchronize();
+        GPU_Error_Check();
+        double time = stop.ElapsedTime(start) / n_repeats;
+    #ifdef MPI_CHOLLA
+        time = ReduceRealMax(time);
+    #endif  // MPI_CHOLLA
+        chprintf("  %-5s %-6s %9.3f ms\n", reconstruction->name, riemann_solver->name, time);
+        if (time < best_time) {
+          best_time           = time;
+          best_reconstruction = reconstruction;
+          best_riemann_solver = riemann_solver;
+        }
+      }
+    }
+
+    cuda_utilities::Pool_Free(bounds_L);
+    cuda_utilities::Pool_Free(bounds_R);
+    cuda_utilities::Pool_Free(fluxes);
+  }
+
+  selected_reconstruction = best_reconstruction->kernel;
+  selected_riemann_solver = best_riemann_solver->kernel;
+  chprintf("VL integrator uses the %s reconstruction and the %s Riemann solver\n", best_reconstruction->name,
+           best_riemann_solver->name);
+}
+  #endif  // RUNTIME_KERNELS
+
 void Free_Memory_VL_3D()
 {
   // free the GPU memory
-  cudaFree(dev_conserved);
-  cudaFree(dev_conserved_half);
-  cudaFree(Q_Lx);
-  cudaFree(Q_Rx);
-  cudaFree(Q_Ly);
-  cudaFree(Q_Ry);
-  cudaFree(Q_Lz);
-  cudaFree(Q_Rz);
-  cudaFree(F_x);
-  cudaFree(F_y);
-  cudaFree(F_z);
-  cudaFree(ctElectricFields);
+  cuda_utilities::Pool_Free(dev_conserved);
+  cuda_utilities::Pool_Free(dev_conserved_half);
+  #ifdef VL_PRIMITIVE_CACHE
+  cuda_utilities::Pool_Free(dev_primitive);
+  #endif  // VL_PRIMITIVE_CACHE
+  cuda_utilities::Pool_Free(Q_Lx);
+  cuda_utilities::Pool_Free(Q_Rx);
+  cuda_utilities::Pool_Free(Q_Ly);
+  cuda_utilities::Pool_Free(Q_Ry);
+  cuda_utilities::Pool_Free(Q_Lz);
+  cuda_utilities::Pool_Free(Q_Rz);
+  #ifndef MHD_LOW_STORAGE
+  cuda_utilities::Pool_Free(F_x);
+  cuda_utilities::Pool_Free(F_y);
+  cuda_utilities::Pool_Free(F_z);
+  #endif  // not MHD_LOW_STORAGE
+  #if defined(MHD) && !defined(VL_FUSED_CT) && !defined(MHD_LOW_STORAGE)
+  cuda_utilities::Pool_Free(ctElectricFields);
+  #endif  // MHD and not VL_FUSED_CT and not MHD_LOW_STORAGE
 }
 
 __global__ void Update_Conserved_Variables_3D_half(Real *dev_conserved, Real *dev_conserved_half, Real *dev_F_x,
@@ -494,4 +1437,257 @@ __global__ void Update_Conserved_Variables_3D_half(Real *dev_conserved, Real *de
   }
 }
 
+void Report_VL_Memory_Traffic(int n_fields)
+{
+  // Estimated device memory traffic per cell update, counting each field of
+  // each full-grid array once per read or write and assuming the neighbor
+  // reads are served from cache
+  // Predictor: PCM reads 1 and writes 6 arrays, the three Riemann solves read
+  // 6 and write 3, and the half step reads the state and 3 fluxes then writes
+  // the half step state
+  int const unfused_predictor = (1 + 6) + (6 + 3) + (1 + 3 + 1);
+  // The fused predictor only reads the state and writes the half step state
+  int const fused_predictor = 1 + 1;
+  // Corrector: reconstruction reads 3 and writes 6 arrays, the Riemann solves
+  // read 6 and write 3, and the update reads the state and 3 fluxes then
+  // writes the state
+  int const unfused_corrector = (3 + 6) + (6 + 3) + (1 + 3 + 1);
+  // The fused corrector reads the half step state and writes 3 fluxes in the
+  // three directions before the same update
+  int const fused_corrector = (3 + 3) + (1 + 3 + 1);
+
+  size_t const bytes_per_field = n_fields * sizeof(Real);
+  #ifdef VL_FUSED
+  int const predictor = fused_predictor;
+  #else   // not VL_FUSED
+  int const predictor = unfused_predictor;
+  #endif  // VL_FUSED
+  #ifdef VL_FUSED_CORRECTOR
+  int const corrector = fused_corrector;
+  #else   // not VL_FUSED_CORRECTOR
+  int const corrector = unfused_corrector;
+  #endif  // VL_FUSED_CORRECTOR
+  chprintf(" VL memory traffic per cell update: predictor %zu B (unfused %zu B, fused %zu B), total %zu B\n",
+           predictor * bytes_per_field, unfused_predictor * bytes_per_field, fused_predictor * bytes_per_field,
+           (predictor + corrector) * bytes_per_field);
+  chprintf(" VL memory traffic per cell update: corrector %zu B (unfused %zu B, fused %zu B)\n",
+           corrector * bytes_per_field, unfused_corrector * bytes_per_field, fused_corrector * bytes_per_field);
+}
+
+void Report_VL_Memory_Footprint(int n_fields)
+{
+  // The device memory of the integrator per cell, on top of the n_fields of
+  // the grid itself: the half step state, 6 interface and 3 flux arrays and
+  // with MHD the 3 CT electric fields. The MHD interface and flux arrays have
+  // one field less
+  #ifdef MHD
+  int const n_interface_fields = n_fields - 1;
+    #ifdef VL_FUSED_CT
+  int const n_ct_fields = 0;
+    #else   // not VL_FUSED_CT
+  int const n_ct_fields = 3;
+    #endif  // VL_FUSED_CT
+  #else     // not MHD
+  int const n_interface_fields = n_fields;
+  int const n_ct_fields        = 0;
+  #endif    // MHD
+  size_t const default_bytes = (n_fields + 9 * n_interface_fields + n_ct_fields) * sizeof(Real);
+  // The low storage mode keeps the fluxes and electric fields in the interface
+  // arrays
+  size_t const low_storage_bytes = (n_fields + 6 * n_interface_fields) * sizeof(Real);
+  // The primitive cache is one more array of all the fields
+  #ifdef VL_PRIMITIVE_CACHE
+  size_t const primitive_cache_bytes = n_fields * sizeof(Real);
+  #else   // not VL_PRIMITIVE_CACHE
+  size_t const primitive_cache_bytes = 0;
+  #endif  // VL_PRIMITIVE_CACHE
+
+  #ifdef MHD_LOW_STORAGE
+  size_t const bytes = low_storage_bytes + primitive_cache_bytes;
+  #else   // not MHD_LOW_STORAGE
+  size_t const bytes = default_bytes + primitive_cache_bytes;
+  #endif  // MHD_LOW_STORAGE
+  chprintf(
+      " VL device memory per cell: integrator %zu B (default %zu B, MHD low storage %zu B, primitive cache %zu B), "
+      "peak %zu B\n", bytes, default_bytes, low_storage_bytes, primitive_cache_bytes, bytes + n_fields * sizeof(Real));
+}
+
+void Report_VL_Kernel_Resource_Usage()
+{
+  // The register use and occupancy of the generic kernels and of the ones
+  // specialized for the field count of this build
+  std::string const n_fields_static = "<" + std::to_string(grid_enum::num_fields) + ">";
+  cuda_utilities::Print_Kernel_Resource_Usage("Update_Conserved_Variables<3, 0>", Update_Conserved_Variables<3, 0>);
+  cuda_utilities::Print_Kernel_Resource_Usage(
+      "Update_Conserved_Variables<3, " + std::to_string(grid_enum::num_fields) + ">",
+      Update_Conserved_Variables<3, grid_enum::num_fields>);
+  #ifdef HLLC
+  cuda_utilities::Print_Kernel_Resource_Usage("Calculate_HLLC_Fluxes_CUDA<0>", Calculate_HLLC_Fluxes_CUDA<0>);
+  cuda_utilities::Print_Kernel_Resource_Usage("Calculate_HLLC_Fluxes_CUDA" + n_fields_static,
+                                              Calculate_HLLC_Fluxes_CUDA<grid_enum::num_fields>);
+  #endif  // HLLC
+  #ifdef VL_FUSED_CT
+  cuda_utilities::Print_Kernel_Resource_Usage("Update_Magnetic_Field_3D_Fused", mhd::Update_Magnetic_Field_3D_Fused);
+  #endif  // VL_FUSED_CT
+}
+
+  #ifdef VL_FUSED
+/*! \fn void Load_Rotated_State(Real *dev_conserved, int id, int n_cells, int
+ *  n_fields, int dir, Real_Solver state[])
+ *  \brief Load the conserved state of cell id into the rotated ordering
+ *  expected by hllc::Calculate_Flux */
+__device__ void Load_Rotated_State(Real *dev_conserved, int id, int n_cells, int n_fields, int dir,
+                                   Real_Solver state[hllc::n_state_vars])
+{
+  int const o1 = grid_enum::momentum_x + dir;
+  int const o2 = grid_enum::momentum_x + (dir + 1) % 3;
+  int const o3 = grid_enum::momentum_x + (dir + 2) % 3;
+
+  state[0] = dev_conserved[id];
+  state[1] = dev_conserved[o1 * n_cells + id];
+  state[2] = dev_conserved[o2 * n_cells + id];
+  state[3] = dev_conserved[o3 * n_cells + id];
+  state[4] = dev_conserved[4 * n_cells + id];
+    #ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    state[5 + i] = dev_conserved[(5 + i) * n_cells + id];
+  }
+    #endif  // SCALAR
+    #ifdef DE
+  state[hllc::gas_energy_id] = dev_conserved[(n_fields - 1) * n_cells + id];
+    #endif  // DE
+}
+
+/*! \fn void Calculate_Face_Flux(Real *dev_conserved, int id_L, int id_R, int
+ *  n_cells, int n_fields, int dir, Real gamma, Real flux[])
+ *  \brief Compute the first order HLLC flux between cells id_L and id_R and
+ *  return it in the unrotated field ordering */
+__device__ void Calculate_Face_Flux(Real *dev_conserved, int id_L, int id_R, int n_cells, int n_fields, int dir,
+                                    Real gamma, Real flux[hllc::n_state_vars])
+{
+  Real_Solver stateL[hllc::n_state_vars], stateR[hllc::n_state_vars], rotated_flux[hllc::n_state_vars];
+  Load_Rotated_State(dev_conserved, id_L, n_cells, n_fields, dir, stateL);
+  Load_Rotated_State(dev_conserved, id_R, n_cells, n_fields, dir, stateR);
+
+  hllc::Calculate_Flux<Real_Solver>(stateL, stateR, rotated_flux, gamma);
+
+  for (int i = 0; i < hllc::n_state_vars; i++) {
+    flux[i] = rotated_flux[i];
+  }
+  flux[grid_enum::momentum_x + dir]           = rotated_flux[1];
+  flux[grid_enum::momentum_x + (dir + 1) % 3] = rotated_flux[2];
+  flux[grid_enum::momentum_x + (dir + 2) % 3] = rotated_flux[3];
+}
+
+/*! \fn void Update_Conserved_Variables_3D_half_Fused(Real *dev_conserved, Real
+ *  *dev_conserved_half, int nx, int ny, int nz, int n_ghost, Real dx, Real dy,
+ *  Real dz, Real dt, Real gamma, int n_fields, Real density_floor)
+ *  \brief Fused version of PCM_Reconstruction_3D, Calculate_HLLC_Fluxes_CUDA
+ *  and Update_Conserved_Variables_3D_half. Each thread computes the six first
+ *  order fluxes through the faces of its cell directly from the conserved
+ *  state and applies them, so nothing goes through the interface and flux
+ *  arrays. Every face flux is computed twice, once by each neighbor, trading
+ *  arithmetic for memory traffic. The update is applied in the same order as
+ *  the unfused kernels. */
+__global__ void Update_Conserved_Variables_3D_half_Fused(Real *dev_conserved, Real *dev_conserved_half, int nx, int ny,
+                                                         int nz, int n_ghost, Real dx, Real dy, Real dz, Real dt,
+                                                         Real gamma, int n_fields, Real density_floor)
+{
+  Real dtodx  = dt / dx;
+  Real dtody  = dt / dy;
+  Real dtodz  = dt / dz;
+  int n_cells = nx * ny * nz;
+
+  // get a global thread ID
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  int zid = tid / (nx * ny);
+  int yid = (tid - zid * nx * ny) / nx;
+  int xid = tid - zid * nx * ny - yid * nx;
+  int id  = xid + yid * nx + zid * nx * ny;
+
+  int imo = xid - 1 + yid * nx + zid * nx * ny;
+  int jmo = xid + (yid - 1) * nx + zid * nx * ny;
+  int kmo = xid + yid * nx + (zid - 1) * nx * ny;
+  int ipo = xid + 1 + yid * nx + zid * nx * ny;
+  int jpo = xid + (yid + 1) * nx + zid * nx * ny;
+  int kpo = xid + yid * nx + (zid + 1) * nx * ny;
+
+  // Map the local flux index to the field in the conserved array
+  auto field_index = [n_fields](int i) { return (i == hllc::gas_energy_id) ? n_fields - 1 : i; };
+
+  // threads corresponding to all cells except outer ring of ghost cells do the
+  // calculation
+  if (xid > 0 && xid < nx - 1 && yid > 0 && yid < ny - 1 && zid > 0 && zid < nz - 1) {
+    Real update[hllc::n_state_vars], flux_m[hllc::n_state_vars], flux_p[hllc::n_state_vars];
+    for (int i = 0; i < hllc::n_state_vars; i++) {
+      update[i] = dev_conserved[field_index(i) * n_cells + id];
+    }
+
+    // x fluxes through the i-1/2 and i+1/2 faces
+    Calculate_Face_Flux(dev_conserved, imo, id, n_cells, n_fields, 0, gamma, flux_m);
+    Calculate_Face_Flux(dev_conserved, id, ipo, n_cells, n_fields, 0, gamma, flux_p);
+    for (int i = 0; i < hllc::n_state_vars; i++) {
+      update[i] += dtodx * (flux_m[i] - flux_p[i]);
+    }
+
+    // y fluxes
+    Calculate_Face_Flux(dev_conserved, jmo, id, n_cells, n_fields, 1, gamma, flux_m);
+    Calculate_Face_Flux(dev_conserved, id, jpo, n_cells, n_fields, 1, gamma, flux_p);
+    for (int i = 0; i < hllc::n_state_vars; i++) {
+      update[i] += dtody * (flux_m[i] - flux_p[i]);
+    }
+
+    // z fluxes
+    Calculate_Face_Flux(dev_conserved, kmo, id, n_cells, n_fields, 2, gamma, flux_m);
+    Calculate_Face_Flux(dev_conserved, id, kpo, n_cells, n_fields, 2, gamma, flux_p);
+    for (int i = 0; i < hllc::n_state_vars; i++) {
+      update[i] += dtodz * (flux_m[i] - flux_p[i]);
+    }
+
+    #ifdef DE
+    // Add the pressure work term to the advected internal energy
+    Real const d     = dev_conserved[id];
+    Real const d_inv = 1.0 / d;
+    Real const vx    = dev_conserved[1 * n_cells + id] * d_inv;
+    Real const vy    = dev_conserved[2 * n_cells + id] * d_inv;
+    Real const vz    = dev_conserved[3 * n_cells + id] * d_inv;
+    Real const E     = dev_conserved[4 * n_cells + id];
+    Real const GE    = dev_conserved[(n_fields - 1) * n_cells + id];
+    Real const E_kin = hydro_utilities::Calc_Kinetic_Energy_From_Velocity(d, vx, vy, vz);
+    Real P           = hydro_utilities::Get_Pressure_From_DE(E, E - E_kin, GE, gamma);
+    P                = fmax(P, (Real)TINY_NUMBER);
+
+    Real const vx_imo = dev_conserved[1 * n_cells + imo] / dev_conserved[imo];
+    Real const vx_ipo = dev_conserved[1 * n_cells + ipo] / dev_conserved[ipo];
+    Real const vy_jmo = dev_conserved[2 * n_cells + jmo] / dev_conserved[jmo];
+    Real const vy_jpo = dev_conserved[2 * n_cells + jpo] / dev_conserved[jpo];
+    Real const vz_kmo = dev_conserved[3 * n_cells + kmo] / dev_conserved[kmo];
+    Real const vz_kpo = dev_conserved[3 * n_cells + kpo] / dev_conserved[kpo];
+    update[hllc::gas_energy_id] +=
+        0.5 * P * (dtodx * (vx_imo - vx_ipo) + dtody * (vy_jmo - vy_jpo) + dtodz * (vz_kmo - vz_kpo));
+    #endif  // DE
+
+    #ifdef DENSITY_FLOOR
+    if (update[0] < density_floor) {
+      Real dens_0 = update[0];
+      printf("###Thread density change  %f -> %f \n", dens_0, density_floor);
+      update[0] = density_floor;
+      // Scale the conserved values to the new density
+      update[1] *= (density_floor / dens_0);
+      update[2] *= (density_floor / dens_0);
+      update[3] *= (density_floor / dens_0);
+      update[4] *= (density_floor / dens_0);
+      #ifdef DE
+      update[hllc::gas_energy_id] *= (density_floor / dens_0);
+      #endif  // DE
+    }
+    #endif  // DENSITY_FLOOR
+
+    for (int i = 0; i < hllc::n_state_vars; i++) {
+      dev_conserved_half[field_index(i) * n_cells + id] = update[i];
+    }
+  }
+}
+  #endif  // VL_FUSED
+
 #endif  // VL
@@ -4,12 +4,76 @@
 #ifndef VL_3D_CUDA_H
 #define VL_3D_CUDA_H
 
+#include <functional>
+
 #include "../global/global.h"
+#include "../utils/gpu.hpp"
 
 void VL_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off, int y_off,
                           int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound,
-                          Real dt, int n_fields, int custom_grav, Real density_floor, Real *host_grav_potential);
+                          Real dt, int n_fields, int custom_grav, Real density_floor, Real U_floor, Real scalar_floor,
+                          Real *host_grav_potential, cudaStream_t stream = 0);
+
+/*! \fn void VL_Algorithm_3D_Slabs_CUDA(...)
+ *  \brief Low memory version of VL_Algorithm_3D_CUDA. The grid is split into
+ *  n_slabs slabs along z and VL_Algorithm_3D_CUDA is run on each slab plus
+ *  n_ghost halo planes, so the interface and flux buffers only need to hold a
+ *  single slab. */
+void VL_Algorithm_3D_Slabs_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off, int y_off,
+                                int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound, Real ybound,
+                                Real zbound, Real dt, int n_fields, int custom_grav, Real density_floor, Real U_floor,
+                                Real scalar_floor, Real *host_grav_potential, int n_slabs);
 
 void Free_Memory_VL_3D();
 
+/*! \fn void Free_Memory_VL_3D_Slabs(Real *d_conserved)
+ *  \brief Free the slab staging buffers and the full grid conserved array,
+ *  which Free_Memory_VL_3D does not own in slab mode */
+void Free_Memory_VL_3D_Slabs(Real *d_conserved);
+
+#ifdef VL_OVERLAP
+/*! \fn Real VL_Algorithm_3D_Overlap_CUDA(...)
+ *  \brief Version of VL_Algorithm_3D_CUDA that hides the hydro boundary
+ *  exchange. The cells more than n_ghost from the faces of the real domain
+ *  are updated on stream while exchange_boundaries runs on the host, then the
+ *  boundary shell is updated once the exchange (issued on boundary_stream)
+ *  has finished. Returns the time in seconds that the exchange outlasted the
+ *  interior update. */
+Real VL_Algorithm_3D_Overlap_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off,
+                                  int y_off, int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound,
+                                  Real ybound, Real zbound, Real dt, int n_fields, int custom_grav, Real density_floor,
+                                  Real U_floor, Real scalar_floor, std::function<void()> const &exchange_boundaries,
+                                  cudaStream_t stream, cudaStream_t boundary_stream);
+
+/*! \fn void Free_Memory_VL_3D_Overlap()
+ *  \brief Free the staging buffers of VL_Algorithm_3D_Overlap_CUDA */
+void Free_Memory_VL_3D_Overlap();
+#endif  // VL_OVERLAP
+
+#if defined(GRAVITY) && !defined(GRAVITY_GPU)
+/*! \fn void VL_Set_Potential_Ready(cudaEvent_t ready)
+ *  \brief Have VL_Algorithm_3D_CUDA read a d_grav_potential that the caller
+ *  uploads itself instead of copying host_grav_potential. The integrator
+ *  waits for ready, recorded once the upload is done, only before the full
+ *  update so the transfer overlaps the stages before it. nullptr goes back to
+ *  the copy */
+void VL_Set_Potential_Ready(cudaEvent_t ready);
+#endif  // GRAVITY and not GRAVITY_GPU
+
+#ifdef RUNTIME_KERNELS
+  #ifndef VL
+    #error "RUNTIME_KERNELS requires the VL integrator"
+  #endif  // not VL
+/*! \fn void VL_Select_Kernels(char const *reconstructions, char const *riemann_solvers, Real *d_conserved, int nx,
+ *  int ny, int nz, int n_ghost, Real dx, Real dy, Real dz, Real dt, int n_fields)
+ *  \brief Choose the corrector reconstruction and the Riemann solver of
+ *  VL_Algorithm_3D_CUDA from comma separated lists of names, or auto for all
+ *  of them that fit in n_ghost. An empty list keeps the kernel of the build.
+ *  With more than one combination the corrector of each is timed on
+ *  d_conserved and the fastest on the slowest rank is kept, so every rank has
+ *  to call it before the first step. */
+void VL_Select_Kernels(char const *reconstructions, char const *riemann_solvers, Real *d_conserved, int nx, int ny,
+                       int nz, int n_ghost, Real dx, Real dy, Real dz, Real dt, int n_fields);
+#endif  // RUNTIME_KERNELS
+
 #endif  // VL_3D_CUDA_H
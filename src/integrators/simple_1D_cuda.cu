@@ -18,6 +18,7 @@
 #include "../riemann_solvers/exact_cuda.h"
 #include "../riemann_solvers/hllc_cuda.h"
 #include "../riemann_solvers/roe_cuda.h"
+#include "../utils/cuda_utilities.h"
 #include "../utils/error_handling.h"
 #include "../utils/gpu.hpp"
 
@@ -36,9 +37,11 @@ void Simple_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost,
   dim3 dimGrid(ngrid, 1, 1);
   dim3 dimBlock(TPB, 1, 1);
 
+  // The grid can change between calls, the scratch buffers are reused
+  dev_conserved = d_conserved;
+
   if (!memory_allocated) {
     // allocate memory on the GPU
-    dev_conserved = d_conserved;
     // GPU_Error_Check( cudaMalloc((void**)&dev_conserved,
     // n_fields*n_cells*sizeof(Real)) );
     GPU_Error_Check(cudaMalloc((void **)&Q_Lx, n_fields * n_cells * sizeof(Real)));
@@ -88,8 +91,8 @@ void Simple_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost,
                      n_fields);
 #endif
 #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0,
-                     n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dimGrid, dimBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
 #endif
   GPU_Error_Check();
 
@@ -102,8 +105,12 @@ void Simple_Algorithm_1D_CUDA(Real *d_conserved, int nx, int x_off, int n_ghost,
 #endif
 
   // Step 3: Update the conserved variable array
-  hipLaunchKernelGGL(Update_Conserved_Variables_1D, dimGrid, dimBlock, 0, 0, dev_conserved, F_x, n_cells, x_off,
-                     n_ghost, dx, xbound, dt, gama, n_fields, custom_grav);
+  auto *const update_kernel = Select_Update_Conserved_Variables<1>(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const update_launch_params(update_kernel, n_cells);
+  hipLaunchKernelGGL(update_kernel, update_launch_params.numBlocks, update_launch_params.threadsPerBlock, 0, 0,
+                     dev_conserved, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, F_x, nullptr, nullptr, nx, 1,
+                     1, x_off, 0, 0, n_ghost, dx, dx, dx, xbound, 0, 0, dt, gama, n_fields, custom_grav, 0, nullptr,
+                     static_grav_table);
   GPU_Error_Check();
 
 // Synchronize the total and internal energy, if using dual-energy formalism
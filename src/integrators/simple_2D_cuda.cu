@@ -16,6 +16,7 @@
 #include "../riemann_solvers/exact_cuda.h"
 #include "../riemann_solvers/hllc_cuda.h"
 #include "../riemann_solvers/roe_cuda.h"
+#include "../utils/cuda_utilities.h"
 #include "../utils/gpu.hpp"
 
 void Simple_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int y_off, int n_ghost, Real dx, Real dy,
@@ -34,9 +35,11 @@ void Simple_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int
   // number of threads per 1D block
   dim3 dim1dBlock(TPB, 1, 1);
 
+  // The grid can change between calls, the scratch buffers are reused
+  dev_conserved = d_conserved;
+
   if (!memory_allocated) {
     // allocate memory on the GPU
-    dev_conserved = d_conserved;
     // GPU_Error_Check( cudaMalloc((void**)&dev_conserved,
     // n_fields*n_cells*sizeof(Real)) );
     GPU_Error_Check(cudaMalloc((void **)&Q_Lx, n_fields * n_cells * sizeof(Real)));
@@ -96,10 +99,9 @@ void Simple_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int
                      1, n_fields);
 #endif
 #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost,
-                     gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost,
-                     gama, 1, n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  hipLaunchKernelGGL(hllc_kernel, dim2dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
 #endif
   GPU_Error_Check();
 
@@ -112,8 +114,12 @@ void Simple_Algorithm_2D_CUDA(Real *d_conserved, int nx, int ny, int x_off, int
 #endif
 
   // Step 3: Update the conserved variable array
-  hipLaunchKernelGGL(Update_Conserved_Variables_2D, dim2dGrid, dim1dBlock, 0, 0, dev_conserved, F_x, F_y, nx, ny, x_off,
-                     y_off, n_ghost, dx, dy, xbound, ybound, dt, gama, n_fields, custom_grav);
+  auto *const update_kernel = Select_Update_Conserved_Variables<2>(n_fields);
+  cuda_utilities::AutomaticLaunchParams static const update_launch_params(update_kernel, n_cells);
+  hipLaunchKernelGGL(update_kernel, update_launch_params.numBlocks, update_launch_params.threadsPerBlock, 0, 0,
+                     dev_conserved, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, F_x, F_y, nullptr, nx, ny, 1,
+                     x_off, y_off, 0, n_ghost, dx, dy, dx, xbound, ybound, 0, dt, gama, n_fields, custom_grav, 0,
+                     nullptr, static_grav_table);
   GPU_Error_Check();
 
 // Synchronize the total and internal energy
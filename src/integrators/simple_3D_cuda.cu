@@ -22,6 +22,20 @@
   #include "../riemann_solvers/hllc_cuda.h"
   #include "../riemann_solvers/roe_cuda.h"
   #include "../utils/gpu.hpp"
+  #include "../utils/timing_functions.h"
+
+namespace
+{
+// Event based timers of every stage of Simple_Algorithm_3D_CUDA, printed at
+// the end of the run when CPU_TIME is on
+GpuTimer pcm_timer("Simple_PCM");
+GpuTimer reconstruction_timers[3] = {GpuTimer("Simple_Reconstruct_X"), GpuTimer("Simple_Reconstruct_Y"),
+                                     GpuTimer("Simple_Reconstruct_Z")};
+GpuTimer riemann_timers[3] = {GpuTimer("Simple_Riemann_X"), GpuTimer("Simple_Riemann_Y"), GpuTimer("Simple_Riemann_Z")};
+GpuTimer de_advect_timer("Simple_DE_Advect");
+GpuTimer update_timer("Simple_Update");
+GpuTimer de_sync_timer("Simple_DE_Select_Sync");
+}  // namespace
 
 void Simple_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx, int ny, int nz, int x_off, int y_off,
                               int z_off, int n_ghost, Real dx, Real dy, Real dz, Real xbound, Real ybound, Real zbound,
@@ -42,6 +56,9 @@ void Simple_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx,
   // host_grav_potential is NULL if not using GRAVITY
   temp_potential = host_grav_potential;
 
+  // The grid can change between calls, the scratch buffers are reused
+  dev_conserved = d_conserved;
+
   if (!memory_allocated) {
     size_t global_free, global_total;
     GPU_Error_Check(cudaMemGetInfo(&global_free, &global_total));
@@ -53,7 +70,6 @@ void Simple_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx,
         n_fields, n_cells, nx, ny, nz);
     chprintf(" Memory needed: %f GB    Free: %f GB    Total:  %f GB  \n", n_fields * n_cells * sizeof(Real) / 1e9,
              global_free / 1e9, global_total / 1e9);
-    dev_conserved = d_conserved;
     GPU_Error_Check(cudaMalloc((void **)&Q_Lx, n_fields * n_cells * sizeof(Real)));
     GPU_Error_Check(cudaMalloc((void **)&Q_Rx, n_fields * n_cells * sizeof(Real)));
     GPU_Error_Check(cudaMalloc((void **)&Q_Ly, n_fields * n_cells * sizeof(Real)));
@@ -87,94 +103,149 @@ void Simple_Algorithm_3D_CUDA(Real *d_conserved, Real *d_grav_potential, int nx,
   // Step 1: Construct left and right interface values using updated conserved
   // variables
   #ifdef PCM
+  pcm_timer.Start();
   hipLaunchKernelGGL(PCM_Reconstruction_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz,
                      Q_Rz, nx, ny, nz, n_ghost, gama, n_fields);
+  pcm_timer.Stop();
   #endif
   #ifdef PLMP
+  reconstruction_timers[0].Start();
   hipLaunchKernelGGL(PLMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, nx, ny, nz, n_ghost, dx, dt,
                      gama, 0, n_fields);
+  reconstruction_timers[0].Stop();
+  reconstruction_timers[1].Start();
   hipLaunchKernelGGL(PLMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Ly, Q_Ry, nx, ny, nz, n_ghost, dy, dt,
                      gama, 1, n_fields);
+  reconstruction_timers[1].Stop();
+  reconstruction_timers[2].Start();
   hipLaunchKernelGGL(PLMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, dz, dt,
                      gama, 2, n_fields);
+  reconstruction_timers[2].Stop();
   #endif  // PLMP
   #ifdef PLMC
+  reconstruction_timers[0].Start();
   hipLaunchKernelGGL(PLMC_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, nx, ny, nz, dx, dt, gama, 0,
                      n_fields);
+  reconstruction_timers[0].Stop();
+  reconstruction_timers[1].Start();
   hipLaunchKernelGGL(PLMC_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Ly, Q_Ry, nx, ny, nz, dy, dt, gama, 1,
                      n_fields);
+  reconstruction_timers[1].Stop();
+  reconstruction_timers[2].Start();
   hipLaunchKernelGGL(PLMC_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lz, Q_Rz, nx, ny, nz, dz, dt, gama, 2,
                      n_fields);
+  reconstruction_timers[2].Stop();
   #endif
   #ifdef PPMP
+  reconstruction_timers[0].Start();
   hipLaunchKernelGGL(PPMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, nx, ny, nz, n_ghost, dx, dt,
                      gama, 0, n_fields);
+  reconstruction_timers[0].Stop();
+  reconstruction_timers[1].Start();
   hipLaunchKernelGGL(PPMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Ly, Q_Ry, nx, ny, nz, n_ghost, dy, dt,
                      gama, 1, n_fields);
+  reconstruction_timers[1].Stop();
+  reconstruction_timers[2].Start();
   hipLaunchKernelGGL(PPMP_cuda, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, dz, dt,
                      gama, 2, n_fields);
+  reconstruction_timers[2].Stop();
   #endif  // PPMP
   #ifdef PPMC
+  reconstruction_timers[0].Start();
   hipLaunchKernelGGL(PPMC_CTU, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, nx, ny, nz, dx, dt, gama, 0);
+  reconstruction_timers[0].Stop();
+  reconstruction_timers[1].Start();
   hipLaunchKernelGGL(PPMC_CTU, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Ly, Q_Ry, nx, ny, nz, dy, dt, gama, 1);
+  reconstruction_timers[1].Stop();
+  reconstruction_timers[2].Start();
   hipLaunchKernelGGL(PPMC_CTU, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lz, Q_Rz, nx, ny, nz, dz, dt, gama, 2);
+  reconstruction_timers[2].Stop();
   GPU_Error_Check();
   #endif  // PPMC
 
   // Step 2: Calculate the fluxes
   #ifdef EXACT
+  riemann_timers[0].Start();
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost,
                      gama, 0, n_fields);
+  riemann_timers[0].Stop();
+  riemann_timers[1].Start();
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost,
                      gama, 1, n_fields);
+  riemann_timers[1].Stop();
+  riemann_timers[2].Start();
   hipLaunchKernelGGL(Calculate_Exact_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost,
                      gama, 2, n_fields);
+  riemann_timers[2].Stop();
   #endif  // EXACT
   #ifdef ROE
+  riemann_timers[0].Start();
   hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama,
                      0, n_fields);
+  riemann_timers[0].Stop();
+  riemann_timers[1].Start();
   hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama,
                      1, n_fields);
+  riemann_timers[1].Stop();
+  riemann_timers[2].Start();
   hipLaunchKernelGGL(Calculate_Roe_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama,
                      2, n_fields);
+  riemann_timers[2].Stop();
   #endif  // ROE
   #ifdef HLLC
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost,
-                     gama, 0, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost,
-                     gama, 1, n_fields);
-  hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost,
-                     gama, 2, n_fields);
+  auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  riemann_timers[0].Start();
+  hipLaunchKernelGGL(hllc_kernel, dim1dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama, 0, n_fields);
+  riemann_timers[0].Stop();
+  riemann_timers[1].Start();
+  hipLaunchKernelGGL(hllc_kernel, dim1dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama, 1, n_fields);
+  riemann_timers[1].Stop();
+  riemann_timers[2].Start();
+  hipLaunchKernelGGL(hllc_kernel, dim1dGrid, dim1dBlock, 0, 0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama, 2, n_fields);
+  riemann_timers[2].Stop();
   #endif  // HLLC
   #ifdef HLL
+  riemann_timers[0].Start();
   hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lx, Q_Rx, F_x, nx, ny, nz, n_ghost, gama,
                      0, n_fields);
+  riemann_timers[0].Stop();
+  riemann_timers[1].Start();
   hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Ly, Q_Ry, F_y, nx, ny, nz, n_ghost, gama,
                      1, n_fields);
+  riemann_timers[1].Stop();
+  riemann_timers[2].Start();
   hipLaunchKernelGGL(Calculate_HLL_Fluxes_CUDA, dim1dGrid, dim1dBlock, 0, 0, Q_Lz, Q_Rz, F_z, nx, ny, nz, n_ghost, gama,
                      2, n_fields);
+  riemann_timers[2].Stop();
   #endif  // HLL
   GPU_Error_Check();
 
   #ifdef DE
   // Compute the divergence of Vel before updating the conserved array, this
   // solves synchronization issues when adding this term on
-  // Update_Conserved_Variables_3D
+  // Update_Conserved_Variables
+  de_advect_timer.Start();
   hipLaunchKernelGGL(Partial_Update_Advected_Internal_Energy_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx,
                      Q_Ly, Q_Ry, Q_Lz, Q_Rz, nx, ny, nz, n_ghost, dx, dy, dz, dt, gama, n_fields);
+  de_advect_timer.Stop();
   GPU_Error_Check();
   #endif
 
   // Step 3: Update the conserved variable array
-  hipLaunchKernelGGL(Update_Conserved_Variables_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry,
-                     Q_Lz, Q_Rz, F_x, F_y, F_z, nx, ny, nz, x_off, y_off, z_off, n_ghost, dx, dy, dz, xbound, ybound,
-                     zbound, dt, gama, n_fields, custom_grav, density_floor, dev_grav_potential);
+  auto *const update_kernel = Select_Update_Conserved_Variables<3>(n_fields);
+  update_timer.Start();
+  hipLaunchKernelGGL(update_kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, Q_Lx, Q_Rx, Q_Ly, Q_Ry, Q_Lz, Q_Rz, F_x,
+                     F_y, F_z, nx, ny, nz, x_off, y_off, z_off, n_ghost, dx, dy, dz, xbound, ybound, zbound, dt, gama,
+                     n_fields, custom_grav, density_floor, dev_grav_potential, static_grav_table);
+  update_timer.Stop();
   GPU_Error_Check();
 
   #ifdef DE
+  de_sync_timer.Start();
   hipLaunchKernelGGL(Select_Internal_Energy_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost,
                      n_fields);
   hipLaunchKernelGGL(Sync_Energies_3D, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, nx, ny, nz, n_ghost, gama, n_fields);
+  de_sync_timer.Stop();
   GPU_Error_Check();
   #endif
 
@@ -0,0 +1,233 @@
+/*! \file derived_fields.cu
+ *  \brief Definitions of the derived fields of the outputs and the analysis,
+ *  computed on the device from the conserved variables. */
+
+#include <math.h>
+
+#include <sstream>
+
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid3D.h"
+#include "../grid/grid_enum.h"
+#include "../io/derived_fields.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/device_memory_pool.h"
+#include "../utils/error_handling.h"
+#include "../utils/gpu.hpp"
+#include "../utils/hydro_utilities.h"
+#include "../utils/math_utilities.h"
+#include "../utils/mhd_utilities.h"
+
+namespace
+{
+enum class DerivedField { temperature, pressure, magnetic_magnitude, mach };
+
+struct DerivedFieldName {
+  char const *name;
+  DerivedField field;
+};
+
+// The registry of the derived fields
+DerivedFieldName const derived_field_names[] = {
+    {"temperature", DerivedField::temperature},
+    {"pressure", DerivedField::pressure},
+#ifdef MHD
+    {"magnetic_magnitude", DerivedField::magnetic_magnitude},
+#endif  // MHD
+    {"mach", DerivedField::mach},
+};
+
+/*! \brief The constants that convert the internal energy of a cell to its
+ * temperature */
+struct TemperatureParameters {
+  Real gamma;
+  // The factor of the specific internal energy to (cm/s)^2 of the chemistry
+  // temperature
+  Real energy_factor;
+};
+
+/*! \brief The internal energy density and the cell centered magnetic field of
+ * a cell. The internal energy is the one of the dual energy formalism with DE
+ * and the total energy minus the kinetic and the magnetic ones without it */
+__device__ Real Internal_Energy(Real const *dev_conserved, Real const *dev_magnetic_centered, int id, int xid, int yid,
+                                int zid, int nx, int ny, int n_cells, Real &magnetic_x, Real &magnetic_y,
+                                Real &magnetic_z)
+{
+  magnetic_x = magnetic_y = magnetic_z = 0;
+#ifdef MHD
+  auto const [b_x, b_y, b_z] =
+      mhd::utils::cellCenteredMagneticFields(dev_magnetic_centered, dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+  magnetic_x = b_x;
+  magnetic_y = b_y;
+  magnetic_z = b_z;
+#endif  // MHD
+#ifdef DE
+  return dev_conserved[grid_enum::GasEnergy * n_cells + id];
+#else   // DE is not defined
+  Real GE = dev_conserved[grid_enum::Energy * n_cells + id] -
+            hydro_utilities::Calc_Kinetic_Energy_From_Momentum(dev_conserved[grid_enum::density * n_cells + id],
+                                                               dev_conserved[grid_enum::momentum_x * n_cells + id],
+                                                               dev_conserved[grid_enum::momentum_y * n_cells + id],
+                                                               dev_conserved[grid_enum::momentum_z * n_cells + id]);
+  #ifdef MHD
+  GE -= mhd::utils::computeMagneticEnergy(magnetic_x, magnetic_y, magnetic_z);
+  #endif  // MHD
+  return GE;
+#endif  // DE
+}
+
+/*! \brief The temperature of a cell in K. With CHEMISTRY_GPU it is the one of
+ * Compute_Gas_Temperature, with the mean molecular weight of the species, and
+ * otherwise the one of the projections, with a mean molecular weight of 0.6 */
+__device__ Real Temperature(Real const *dev_conserved, int id, int n_cells, Real d, Real GE,
+                            TemperatureParameters const &params)
+{
+#ifdef CHEMISTRY_GPU
+  Real const dens_HI    = dev_conserved[grid_enum::HI_density * n_cells + id];
+  Real const dens_HII   = dev_conserved[grid_enum::HII_density * n_cells + id];
+  Real const dens_HeI   = dev_conserved[grid_enum::HeI_density * n_cells + id];
+  Real const dens_HeII  = dev_conserved[grid_enum::HeII_density * n_cells + id];
+  Real const dens_HeIII = dev_conserved[grid_enum::HeIII_density * n_cells + id];
+  Real const dens_e     = dev_conserved[grid_enum::e_density * n_cells + id];
+  Real const mu         = (dens_HI + dens_HII + dens_HeI + dens_HeII + dens_HeIII) /
+                          (dens_HI + dens_HII + (dens_HeI + dens_HeII + dens_HeIII) / 4 + dens_e);
+  return GE * params.energy_factor * MP * mu / d / KB * (params.gamma - 1.0);
+#else   // CHEMISTRY_GPU is not defined
+  Real const mu = 0.6;
+  Real const n  = d * DENSITY_UNIT / (mu * MP);
+  return GE * (params.gamma - 1.0) * PRESSURE_UNIT / (n * KB);
+#endif  // CHEMISTRY_GPU
+}
+
+/*! \brief Compute a derived field in every cell of the grid, ghost cells
+ * included */
+__global__ void Derived_Field_Kernel(Real const *dev_conserved, Real const *dev_magnetic_centered, int nx, int ny,
+                                     int nz, DerivedField field, TemperatureParameters params, Real *derived)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+  if (zid >= nz) {
+    return;
+  }
+  int const n_cells = nx * ny * nz;
+
+  Real magnetic_x, magnetic_y, magnetic_z;
+  Real const d  = dev_conserved[grid_enum::density * n_cells + id];
+  Real const GE = Internal_Energy(dev_conserved, dev_magnetic_centered, id, xid, yid, zid, nx, ny, n_cells, magnetic_x,
+                                  magnetic_y, magnetic_z);
+  Real const P  = (params.gamma - 1.0) * GE;
+
+  Real value = 0;
+  switch (field) {
+    case DerivedField::temperature:
+      value = Temperature(dev_conserved, id, n_cells, d, GE, params);
+      break;
+    case DerivedField::pressure:
+      value = P;
+      break;
+    case DerivedField::magnetic_magnitude:
+      value = sqrt(math_utils::SquareMagnitude(magnetic_x, magnetic_y, magnetic_z));
+      break;
+    case DerivedField::mach: {
+      Real const speed = sqrt(math_utils::SquareMagnitude(dev_conserved[grid_enum::momentum_x * n_cells + id],
+                                                          dev_conserved[grid_enum::momentum_y * n_cells + id],
+                                                          dev_conserved[grid_enum::momentum_z * n_cells + id])) /
+                         d;
+      value = speed / hydro_utilities::Calc_Sound_Speed(P, d, params.gamma);
+      break;
+    }
+  }
+  derived[id] = value;
+}
+
+DerivedFieldName const *Find_Derived_Field(std::string const &name)
+{
+  for (DerivedFieldName const &entry : derived_field_names) {
+    if (name == entry.name) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+bool DerivedFields::Exists(std::string const &name) { return Find_Derived_Field(name) != nullptr; }
+
+std::vector<std::string> DerivedFields::Names()
+{
+  std::vector<std::string> names;
+  for (DerivedFieldName const &entry : derived_field_names) {
+    names.emplace_back(entry.name);
+  }
+  return names;
+}
+
+void DerivedFields::Set_Outputs(char const *list)
+{
+  outputs.clear();
+  std::stringstream entries(list);
+  std::string name;
+  while (std::getline(entries, name, ',')) {
+    if (name.empty()) {
+      continue;
+    }
+    if (not Exists(name)) {
+      std::string known;
+      for (std::string const &entry : Names()) {
+        known += " " + entry;
+      }
+      CHOLLA_ERROR("output_derived: unknown derived field \"%s\", this build has:%s", name.c_str(), known.c_str());
+    }
+    outputs.push_back(name);
+  }
+}
+
+Real *DerivedFields::Get(Grid3D &G, std::string const &name)
+{
+  DerivedFieldName const *entry = Find_Derived_Field(name);
+  if (entry == nullptr) {
+    CHOLLA_ERROR("Unknown derived field \"%s\"", name.c_str());
+  }
+
+  Field &field = fields[name];
+  if (field.data != nullptr && field.n_step == G.H.n_step && field.t == G.H.t) {
+    return field.data;
+  }
+  if (field.data == nullptr) {
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::io);
+    cuda_utilities::Pool_Malloc(&field.data, G.H.n_cells * sizeof(Real));
+  }
+
+  TemperatureParameters params;
+  params.gamma         = gama;
+  params.energy_factor = 1;
+#if defined(CHEMISTRY_GPU) && defined(COSMOLOGY)
+  params.energy_factor = G.Chem.H.energy_conversion / (G.Cosmo.current_a * G.Cosmo.current_a);
+#endif  // CHEMISTRY_GPU and COSMOLOGY
+
+  dim3 dim1dGrid((G.H.n_cells + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Derived_Field_Kernel, dim1dGrid, dim1dBlock, 0, 0, G.C.device, G.C.d_magnetic_centered, G.H.nx,
+                     G.H.ny, G.H.nz, entry->field, params, field.data);
+  GPU_Error_Check();
+  field.n_step = G.H.n_step;
+  field.t      = G.H.t;
+  return field.data;
+}
+
+Real DerivedFields::Output_Scale(std::string const &name, Real energy_unit)
+{
+  // The pressure is an energy density, the other fields are in K, in the
+  // units of the magnetic fields of the snapshots or dimensionless
+  return name == "pressure" ? energy_unit : 1;
+}
+
+void DerivedFields::Free()
+{
+  for (auto &[name, field] : fields) {
+    cuda_utilities::Pool_Free(field.data);
+  }
+  fields.clear();
+}
@@ -0,0 +1,76 @@
+/*! \file derived_fields.h
+ *  \brief Declarations of the fields derived from the conserved variables on
+ *  the device: the temperature, the thermal pressure, the magnitude of the
+ *  magnetic field and the Mach number. The outputs and the analysis request
+ *  them by name, and each one is computed at most once per step, so a snapshot
+ *  and the analysis of the same step share it. */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../global/global.h"
+
+class Grid3D;
+
+/*! \class DerivedFields
+ *  \brief The derived fields of a grid, owned by Grid3D::Derived. Every field
+ *  is a device array with the layout of the conserved fields, ghost cells
+ *  included, that stays valid until the grid advances. */
+class DerivedFields
+{
+ public:
+  DerivedFields()                                 = default;
+  DerivedFields(DerivedFields const &)            = delete;
+  DerivedFields &operator=(DerivedFields const &) = delete;
+
+  /*! \fn ~DerivedFields()
+   *  \brief Free the device arrays of the fields */
+  ~DerivedFields() { Free(); }
+
+  /*! \fn static bool Exists(std::string const &name)
+   *  \brief Whether name is a derived field of this build. magnetic_magnitude
+   * needs MHD */
+  static bool Exists(std::string const &name);
+
+  /*! \fn static std::vector<std::string> Names()
+   *  \brief The names of the derived fields of this build */
+  static std::vector<std::string> Names();
+
+  /*! \fn void Set_Outputs(char const *list)
+   *  \brief Set the fields that Write_Grid_HDF5 adds to the snapshots from a
+   * comma separated list of names, the output_derived parameter */
+  void Set_Outputs(char const *list);
+
+  /*! \fn std::vector<std::string> const &Outputs() const
+   *  \brief The fields of Set_Outputs */
+  std::vector<std::string> const &Outputs() const { return outputs; }
+
+  /*! \fn Real *Get(Grid3D &G, std::string const &name)
+   *  \brief The device array of a derived field of the current state of G,
+   * computed with one kernel launch unless it was already computed at this
+   * step */
+  Real *Get(Grid3D &G, std::string const &name);
+
+  /*! \fn Real Output_Scale(std::string const &name, Real energy_unit)
+   *  \brief The factor that converts a derived field to the units of the
+   * outputs, where energy_unit is the factor of the energy density */
+  static Real Output_Scale(std::string const &name, Real energy_unit);
+
+  /*! \fn void Free()
+   *  \brief Free the device arrays of the fields */
+  void Free();
+
+ private:
+  struct Field {
+    Real *data = nullptr;
+    // The step and the time the field was computed at
+    int n_step = -1;
+    Real t     = -1;
+  };
+
+  std::map<std::string, Field> fields;
+  std::vector<std::string> outputs;
+};
@@ -5,19 +5,40 @@
 #include <string.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #ifdef HDF5
   #include <hdf5.h>
 #endif  // HDF5
+#ifdef ASYNC_OUTPUT
+  #include <deque>
+#endif  // ASYNC_OUTPUT
 #include "../grid/grid3D.h"
+#ifdef STATIC_REFINEMENT
+  #include "../grid/static_refinement.h"
+#endif  // STATIC_REFINEMENT
+#ifdef POWER_SPECTRUM
+  #include "../analysis/power_spectrum_3d.h"
+#endif  // POWER_SPECTRUM
+#ifdef HALO_FINDER
+  #include "../analysis/halo_finder.h"
+#endif  // HALO_FINDER
 #include "../io/io.h"
 #include "../utils/cuda_utilities.h"
+#include "../utils/device_memory_pool.h"
 #include "../utils/hydro_utilities.h"
 #include "../utils/mhd_utilities.h"
+#include "../utils/profiling_ranges.h"
 #include "../utils/timing_functions.h"  // provides ScopedTimer
 #ifdef MPI_CHOLLA
   #include "../mpi/mpi_routines.h"
@@ -47,6 +68,40 @@ static inline bool Is_Root_Proc()
 #endif
 }
 
+/* The factors that convert the conserved fields of the grid to the units of
+ * the outputs. The comoving cosmological fields are written in physical units,
+ * the factors are applied while the fields are packed for the output so the
+ * grid itself is never converted */
+struct Output_Units {
+  Real density  = 1;
+  Real momentum = 1;
+  Real energy   = 1;
+};
+
+static Output_Units Get_Output_Units(Grid3D const &G)
+{
+  Output_Units units;
+#ifdef COSMOLOGY
+  units.density  = G.Cosmo.rho_0_gas;
+  units.momentum = G.Cosmo.rho_0_gas * G.Cosmo.v_0_gas / G.Cosmo.current_a;
+  units.energy   = G.Cosmo.rho_0_gas * G.Cosmo.v_0_gas * G.Cosmo.v_0_gas / G.Cosmo.current_a / G.Cosmo.current_a;
+#endif  // COSMOLOGY
+  return units;
+}
+
+/* Multiply the maps of n_map pixels of a projection or slice by the scale of
+ * each map */
+static void Scale_Output_Maps(Real *maps, size_t n_map, std::vector<Real> const &scales)
+{
+  for (size_t map = 0; map < scales.size(); map++) {
+    if (scales[map] != 1) {
+      for (size_t i = 0; i < n_map; i++) {
+        maps[map * n_map + i] *= scales[map];
+      }
+    }
+  }
+}
+
 void Create_Log_File(struct Parameters P)
 {
   if (not Is_Root_Proc()) {
@@ -88,10 +143,352 @@ void Write_Message_To_Log_File(const char *message)
   out_file.close();
 }
 
+#ifdef ASYNC_OUTPUT
+/*!
+ * \brief Writes the images of the HDF5 output files to disk on a background
+ * thread, so that the simulation continues while the file system drains them.
+ * The files of a snapshot are only queued once the files of the previous
+ * snapshot are written, so at most two snapshots are held in memory
+ */
+class SnapshotWriter
+{
+ public:
+  SnapshotWriter()
+  {
+    writer = std::thread([this] { Write_Files(); });
+  }
+
+  ~SnapshotWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    ready.notify_one();
+    writer.join();
+  }
+
+  void Push(int nfile, std::string filename, std::vector<char> image)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      written.wait(lock, [&] { return (files.empty() and not writing) or nfile == queued_nfile; });
+      queued_nfile = nfile;
+      files.push_back({std::move(filename), std::move(image)});
+    }
+    ready.notify_one();
+  }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this] { return files.empty() and not writing; });
+  }
+
+ private:
+  struct File {
+    std::string name;
+    std::vector<char> image;
+  };
+
+  // Write whatever has been queued until the writer is destroyed and the queue
+  // is empty
+  void Write_Files()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [this] { return done or not files.empty(); });
+      if (files.empty()) {
+        return;
+      }
+      File file = std::move(files.front());
+      files.pop_front();
+      writing = true;
+      lock.unlock();
+
+      FILE *out = fopen(file.name.c_str(), "wb");
+      if (out == NULL or fwrite(file.image.data(), 1, file.image.size(), out) != file.image.size()) {
+        CHOLLA_ERROR("Writing the output file %s failed", file.name.c_str());
+      }
+      fclose(out);
+      // Release the image before the next snapshot is allowed in
+      file.image = std::vector<char>();
+
+      lock.lock();
+      writing = false;
+      written.notify_all();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable written;
+  std::deque<File> files;
+  int queued_nfile = -1;
+  bool writing     = false;
+  bool done        = false;
+  std::thread writer;
+};
+
+static SnapshotWriter &Get_Snapshot_Writer()
+{
+  static SnapshotWriter snapshot_writer;
+  return snapshot_writer;
+}
+
+void Wait_Async_Output() { Get_Snapshot_Writer().Wait(); }
+#endif  // ASYNC_OUTPUT
+
+/*!
+ * \brief Copies the restart files of the node-local checkpoint tier to the
+ * output directory on a background thread. A checkpoint is only queued once
+ * the previous one is drained, and the local tier only keeps the latest
+ * drained checkpoint: the files of the previous one are removed once the
+ * files of the next one are on the output directory
+ */
+class CheckpointDrainer
+{
+ public:
+  CheckpointDrainer()
+  {
+    drainer = std::thread([this] { Drain_Files(); });
+  }
+
+  ~CheckpointDrainer()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    ready.notify_one();
+    drainer.join();
+  }
+
+  /* Queue the files of a checkpoint to copy into shared_dir. The marker of
+   * the checkpoint is removed from the local tier with its files */
+  void Push(std::vector<std::filesystem::path> files, std::filesystem::path shared_dir, std::filesystem::path marker)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      drained.wait(lock, [this] { return not pending and not draining; });
+      next    = Checkpoint{std::move(files), std::move(shared_dir), std::move(marker)};
+      pending = true;
+    }
+    ready.notify_one();
+  }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return not pending and not draining; });
+  }
+
+ private:
+  struct Checkpoint {
+    std::vector<std::filesystem::path> files;
+    std::filesystem::path shared_dir;
+    std::filesystem::path marker;
+  };
+
+  void Drain_Files()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [this] { return done or pending; });
+      if (not pending) {
+        return;
+      }
+      Checkpoint checkpoint = std::move(next);
+      pending               = false;
+      draining              = true;
+      lock.unlock();
+
+      // Copy to a temporary name first, so a file on the output directory is
+      // always complete
+      for (std::filesystem::path const &file : checkpoint.files) {
+        std::filesystem::path const target = checkpoint.shared_dir / file.filename();
+        std::filesystem::path const part   = target.string() + ".part";
+        std::error_code err_code;
+        std::filesystem::copy_file(file, part, std::filesystem::copy_options::overwrite_existing, err_code);
+        if (not err_code) {
+          std::filesystem::rename(part, target, err_code);
+        }
+        if (err_code) {
+          CHOLLA_ERROR("Draining the checkpoint file %s to %s failed: %s", file.c_str(), target.c_str(),
+                       err_code.message().c_str());
+        }
+      }
+
+      // The previous checkpoint is superseded now. Its directory is only
+      // removed when it isn't shared with the new one, and only if the other
+      // ranks of the node left it empty
+      std::error_code err_code;
+      for (std::filesystem::path const &file : previous.files) {
+        std::filesystem::remove(file, err_code);
+      }
+      if (not previous.marker.empty()) {
+        std::filesystem::remove(previous.marker, err_code);
+        if (previous.marker.parent_path() != checkpoint.marker.parent_path()) {
+          std::filesystem::remove(previous.marker.parent_path(), err_code);
+        }
+      }
+      previous = std::move(checkpoint);
+
+      lock.lock();
+      draining = false;
+      drained.notify_all();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable drained;
+  Checkpoint next, previous;
+  bool pending  = false;
+  bool draining = false;
+  bool done     = false;
+  std::thread drainer;
+};
+
+static CheckpointDrainer &Get_Checkpoint_Drainer()
+{
+  static CheckpointDrainer checkpoint_drainer;
+  return checkpoint_drainer;
+}
+
+void Wait_Checkpoint_Drain() { Get_Checkpoint_Drainer().Wait(); }
+
+/* The parameters with the output directory moved to the node-local checkpoint
+ * tier, keeping the file prefix of outdir */
+static Parameters Local_Checkpoint_Parameters(Parameters const &P)
+{
+  Parameters P_local = P;
+  std::string const local_outdir =
+      std::string(P.checkpoint_dir) + "/" + std::filesystem::path(P.outdir).filename().string();
+  strncpy(P_local.outdir, local_outdir.c_str(), MAXLEN - 1);
+  P_local.outdir[MAXLEN - 1] = '\0';
+  return P_local;
+}
+
+/* The marker of a complete checkpoint of this rank on the local tier */
+static std::string Local_Checkpoint_Marker(Parameters const &P_local, int nfile)
+{
+  return FnameTemplate(P_local).format_fname(nfile, "") + ".complete";
+}
+
+/* Queue the files this rank wrote to the local tier for checkpoint nfile to be
+ * drained to the output directory of P, once they are all written */
+static void Drain_Checkpoint(Parameters const &P, Parameters const &P_local, int nfile)
+{
+#ifdef ASYNC_OUTPUT
+  Wait_Async_Output();
+#endif  // ASYNC_OUTPUT
+#ifdef MPI_CHOLLA
+  int const file_proc_id = procID;
+#else
+  int const file_proc_id = 0;
+#endif  // MPI_CHOLLA
+
+  // The files of this rank are <prefix><nfile>[_suffix].<extension>.<procID>,
+  // the other ranks of the node write to the same directory
+  FnameTemplate const local_names(P_local);
+  std::string const leading =
+      (local_names.separate_cycle_dirs() ? std::string() : std::filesystem::path(P_local.outdir).filename().string()) +
+      std::to_string(nfile);
+  std::string const proc_part = "." + std::to_string(file_proc_id);
+  std::vector<std::filesystem::path> files;
+  for (auto const &entry : std::filesystem::directory_iterator(local_names.effective_output_dir_path(nfile))) {
+    std::string const name = entry.path().filename().string();
+    if (not entry.is_regular_file() or name.size() <= leading.size() + proc_part.size()) {
+      continue;
+    }
+    char const separator = name[leading.size()];
+    if (name.compare(0, leading.size(), leading) == 0 and (separator == '.' or separator == '_') and
+        name.compare(name.size() - proc_part.size(), proc_part.size(), proc_part) == 0) {
+      files.push_back(entry.path());
+    }
+  }
+
+  std::string const marker = Local_Checkpoint_Marker(P_local, nfile);
+  std::ofstream(marker) << nfile << std::endl;
+  Get_Checkpoint_Drainer().Push(std::move(files), FnameTemplate(P).effective_output_dir_path(nfile), marker);
+}
+
+void Use_Local_Checkpoint(Parameters *P)
+{
+  if (P->checkpoint_dir[0] == '\0' or strcmp(P->init, "Read_Grid") != 0) {
+    return;
+  }
+  Parameters const P_local = Local_Checkpoint_Parameters(*P);
+  FnameTemplate const local_names(P_local);
+
+  // Only restart from the local tier if every rank still has its checkpoint
+  int present = std::filesystem::exists(Local_Checkpoint_Marker(P_local, P->nfile)) ? 1 : 0;
+#ifdef MPI_CHOLLA
+  MPI_Allreduce(MPI_IN_PLACE, &present, 1, MPI_INT, MPI_MIN, world);
+#endif  // MPI_CHOLLA
+  if (not present) {
+    chprintf("No complete local checkpoint %d in %s, restarting from %s\n", P->nfile, P->checkpoint_dir, P->indir);
+    return;
+  }
+  std::string const indir = local_names.separate_cycle_dirs() ? local_names.effective_output_dir_path(P->nfile)
+                                                              : std::string(P_local.outdir);
+  strncpy(P->indir, indir.c_str(), MAXLEN - 1);
+  P->indir[MAXLEN - 1] = '\0';
+}
+
+#ifdef HDF5
+hid_t Create_Output_File_HDF5(std::string const &filename, size_t size_hint)
+{
+  #ifdef ASYNC_OUTPUT
+  // Build the file in memory without a backing store, the whole file is
+  // reserved at once so the image is not reallocated while it grows
+  hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_fapl_core(fapl_id, std::max(size_hint, size_t(1) << 20), false);
+  hid_t file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+  H5Pclose(fapl_id);
+  return file_id;
+  #else
+  return H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  #endif  // ASYNC_OUTPUT
+}
+
+herr_t Close_Output_File_HDF5(hid_t file_id, std::string const &filename, int nfile)
+{
+  #ifdef ASYNC_OUTPUT
+  // Copy the image out of the file, only the main thread calls HDF5 since the
+  // library is not thread safe in general
+  H5Fflush(file_id, H5F_SCOPE_GLOBAL);
+  ssize_t const size = H5Fget_file_image(file_id, NULL, 0);
+  if (size < 0) {
+    H5Fclose(file_id);
+    return -1;
+  }
+  std::vector<char> image(size);
+  if (H5Fget_file_image(file_id, image.data(), size) != size) {
+    H5Fclose(file_id);
+    return -1;
+  }
+  herr_t const status = H5Fclose(file_id);
+  Get_Snapshot_Writer().Push(nfile, filename, std::move(image));
+  return status;
+  #else
+  return H5Fclose(file_id);
+  #endif  // ASYNC_OUTPUT
+}
+#endif  // HDF5
+
 /* Write Cholla Output Data */
 void Write_Data(Grid3D &G, struct Parameters P, int nfile)
 {
-  cudaMemcpy(G.C.density, G.C.device, G.H.n_fields * G.H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost);
+  profiling::ScopedRange const range("Write_Data");
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::io);
+
+  // The projections and slices are computed on the device, only the hydro
+  // snapshots need the host copy of the grid
+  if (nfile % P.n_hydro == 0) {
+    cudaMemcpy(G.C.density, G.C.device, G.H.n_fields * G.H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost);
+  }
 
   chprintf("\nSaving Snapshot: %d \n", nfile);
 
@@ -119,14 +516,29 @@ void Write_Data(Grid3D &G, struct Parameters P, int nfile)
   G.H.Output_Complete_Data = true;
 #endif
 
-#ifdef COSMOLOGY
+  // The restart files go to the node-local checkpoint tier first, and are
+  // drained to the output directory while the simulation continues
+  bool const local_checkpoint = G.H.Output_Complete_Data and P.checkpoint_dir[0] != '\0';
+  Parameters const P_restart  = local_checkpoint ? Local_Checkpoint_Parameters(P) : P;
+  if (local_checkpoint) {
+    // Every node has its own tier, so every rank makes sure the directory exists
+    std::error_code err_code;
+    std::filesystem::create_directories(FnameTemplate(P_restart).effective_output_dir_path(nfile), err_code);
+    if (err_code) {
+      CHOLLA_ERROR("Creating the checkpoint directory in %s failed: %s", P.checkpoint_dir, err_code.message().c_str());
+    }
+  }
+
+// The HDF5 outputs convert the comoving fields as they are packed, only the
+// text and binary outputs need the grid in physical units
+#if defined(COSMOLOGY) && !defined(HDF5)
   G.Change_Cosmological_Frame_Sytem(false);
 #endif
 
 #ifndef ONLY_PARTICLES
   /*call the data output routine for Hydro data*/
   if (nfile % P.n_hydro == 0) {
-    Output_Data(G, P, nfile);
+    Output_Data(G, P_restart, nfile);
   }
 #endif
 
@@ -135,6 +547,9 @@ void Write_Data(Grid3D &G, struct Parameters P, int nfile)
   if (P.n_out_float32 && nfile % P.n_out_float32 == 0) {
     Output_Float32(G, P, nfile);
   }
+  if (P.n_out_coarse && nfile % P.n_out_coarse == 0) {
+    Output_Coarse(G, P, nfile);
+  }
 #endif
 
 #ifdef PROJECTION
@@ -155,10 +570,27 @@ void Write_Data(Grid3D &G, struct Parameters P, int nfile)
   }
 #endif /*SLICES*/
 
+#ifdef POWER_SPECTRUM
+  if (nfile % P.n_power_spectrum == 0) {
+    Output_Power_Spectrum(G, P, nfile);
+  }
+#endif  // POWER_SPECTRUM
+
+#ifdef HALO_FINDER
+  if (nfile % P.n_halo_catalog == 0) {
+    Output_Halo_Catalog(G, P, nfile);
+  }
+#endif  // HALO_FINDER
+
 #ifdef PARTICLES
   if (nfile % P.n_particle == 0) {
-    G.WriteData_Particles(P, nfile);
+    G.WriteData_Particles(P_restart, nfile);
+  }
+  #ifdef HDF5
+  if (P.n_out_particles_subset && nfile % P.n_out_particles_subset == 0) {
+    G.Output_Particles_Subset(P, nfile);
   }
+  #endif  // HDF5
 #endif
 
 #ifdef COSMOLOGY
@@ -175,7 +607,9 @@ void Write_Data(Grid3D &G, struct Parameters P, int nfile)
   } else {
     chprintf(" Saved Snapshot: %d     z:%f\n", nfile, G.Cosmo.current_z);
   }
+  #ifndef HDF5
   G.Change_Cosmological_Frame_Sytem(true);
+  #endif  // HDF5
   chprintf("\n");
   G.H.Output_Now = false;
 #endif
@@ -186,9 +620,21 @@ void Write_Data(Grid3D &G, struct Parameters P, int nfile)
 #endif
 
 #if defined(GRAVITY) && defined(HDF5)
-  G.Grav.Write_Restart_HDF5(&P, nfile);
+  Parameters P_gravity = P_restart;
+  G.Grav.Write_Restart_HDF5(&P_gravity, nfile);
 #endif
 
+  if (local_checkpoint) {
+    Drain_Checkpoint(P, P_restart, nfile);
+  }
+
+#ifdef STATIC_REFINEMENT
+  // The refined patch is written to files of its own
+  if (G.refined_patch != nullptr) {
+    G.refined_patch->Write(nfile);
+  }
+#endif  // STATIC_REFINEMENT
+
 #ifdef MPI_CHOLLA
   MPI_Barrier(world);
 #endif
@@ -224,11 +670,19 @@ void Output_Data(Grid3D &G, struct Parameters P, int nfile)
 
 // create the file for hdf5 writes
 #elif defined HDF5
+  #ifdef MPI_CHOLLA
+  // All the ranks write a single file
+  if (P.output_cat) {
+    Output_Data_Cat(G, P, nfile);
+    return;
+  }
+  #endif  // MPI_CHOLLA
   hid_t file_id; /* file identifier */
   herr_t status;
 
   // Create a new file using default properties.
-  file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  size_t const size_hint = size_t(G.H.n_fields) * G.H.nx_real * G.H.ny_real * G.H.nz_real * sizeof(Real);
+  file_id                = Create_Output_File_HDF5(filename, size_hint);
 
   // Write the header (file attributes)
   G.Write_Header_HDF5(file_id);
@@ -237,7 +691,7 @@ void Output_Data(Grid3D &G, struct Parameters P, int nfile)
   G.Write_Grid_HDF5(file_id);
 
   // close the file
-  status = H5Fclose(file_id);
+  status = Close_Output_File_HDF5(file_id, filename, nfile);
 
   if (status < 0) {
     printf("File write failed.\n");
@@ -288,10 +742,12 @@ void Output_Float32(Grid3D &G, struct Parameters P, int nfile)
   herr_t status;
 
   // Create a new file using default properties.
-  file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  size_t const size_hint = size_t(H.n_fields) * H.nx_real * H.ny_real * H.nz_real * sizeof(float);
+  file_id                = Create_Output_File_HDF5(filename, size_hint);
 
   // Write the header (file attributes)
   G.Write_Header_HDF5(file_id);
+  Use_Output_Compression(true);
 
   // write the conserved variables to the output file
 
@@ -300,46 +756,29 @@ void Output_Float32(Grid3D &G, struct Parameters P, int nfile)
     int nx_dset = H.nx_real;
     int ny_dset = H.ny_real;
     int nz_dset = H.nz_real;
-    size_t buffer_size;
-    // Need a larger device buffer for MHD. In the future, if other fields need
-    // a larger device buffer, choose the maximum of the sizes. If the buffer is
-    // too large, it does not cause bugs (Oct 6 2022)
-  #ifdef MHD
-    buffer_size = (nx_dset + 1) * (ny_dset + 1) * (nz_dset + 1);
-  #else
-    buffer_size = nx_dset * ny_dset * nz_dset;
-  #endif  // MHD
-
-    // Using static DeviceVector here automatically allocates the buffer the
-    // first time it is needed It persists until program exit, and then calls
-    // Free upon destruction
-    cuda_utilities::DeviceVector<float> static device_dataset_vector{buffer_size};
-    auto *dataset_buffer = (float *)malloc(buffer_size * sizeof(float));
 
+    // All the selected fields are packed and converted to float with one
+    // kernel launch
+    Output_Units const units = Get_Output_Units(G);
+    HDF5_Field_Pack pack;
     if (P.out_float32_density > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_density, "/density");
+      pack.Add(G.C.d_density, "/density", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.density);
     }
     if (P.out_float32_momentum_x > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_momentum_x, "/momentum_x");
+      pack.Add(G.C.d_momentum_x, "/momentum_x", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.momentum);
     }
     if (P.out_float32_momentum_y > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_momentum_y, "/momentum_y");
+      pack.Add(G.C.d_momentum_y, "/momentum_y", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.momentum);
     }
     if (P.out_float32_momentum_z > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_momentum_z, "/momentum_z");
+      pack.Add(G.C.d_momentum_z, "/momentum_z", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.momentum);
     }
     if (P.out_float32_Energy > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_Energy, "/Energy");
+      pack.Add(G.C.d_Energy, "/Energy", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.energy);
     }
   #ifdef DE
     if (P.out_float32_GasEnergy > 0) {
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_GasEnergy, "/GasEnergy");
+      pack.Add(G.C.d_GasEnergy, "/GasEnergy", H.nx, H.ny, nx_dset, ny_dset, nz_dset, H.n_ghost, -1, units.energy);
     }
   #endif  // DE
   #ifdef MHD
@@ -347,23 +786,20 @@ void Output_Float32(Grid3D &G, struct Parameters P, int nfile)
     // TODO (by Alwin, for anyone) : Repair output format if needed and remove these chprintfs when appropriate
     if (P.out_float32_magnetic_x > 0) {
       chprintf("WARNING: MHD float-32 output has a different output format than float-64\n");
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_magnetic_x, "/magnetic_x");
+      pack.Add(G.C.d_magnetic_x, "/magnetic_x", H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1);
     }
     if (P.out_float32_magnetic_y > 0) {
       chprintf("WARNING: MHD float-32 output has a different output format than float-64\n");
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_magnetic_y, "/magnetic_y");
+      pack.Add(G.C.d_magnetic_y, "/magnetic_y", H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1);
     }
     if (P.out_float32_magnetic_z > 0) {
       chprintf("WARNING: MHD float-32 output has a different output format than float-64\n");
-      Write_HDF5_Field_3D(H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1, file_id, dataset_buffer,
-                          device_dataset_vector.data(), G.C.d_magnetic_z, "/magnetic_z");
+      pack.Add(G.C.d_magnetic_z, "/magnetic_z", H.nx, H.ny, nx_dset + 1, ny_dset + 1, nz_dset + 1, H.n_ghost - 1);
     }
 
   #endif  // MHD
 
-    free(dataset_buffer);
+    status = Write_HDF5_Fields_3D<float>(file_id, pack);
 
     if (status < 0) {
       printf("File write failed.\n");
@@ -371,8 +807,201 @@ void Output_Float32(Grid3D &G, struct Parameters P, int nfile)
     }
   }  // 3-D case
 
+  Use_Output_Compression(false);
+
   // close the file
-  status = H5Fclose(file_id);
+  status = Close_Output_File_HDF5(file_id, filename, nfile);
+#endif  // HDF5
+}
+
+#if defined(HDF5) && defined(MPI_CHOLLA)
+/* Copy the layer of index layer in direction dir of the n_fields blocks of the
+ * coarse cells of sums to buffer, or add buffer to it. buffer has the size of
+ * the layers */
+static void Copy_Coarse_Layer(std::vector<Real> &sums, int n_fields, int const n_coarse[3], int dir, int layer,
+                              std::vector<Real> &buffer, bool add)
+{
+  size_t const n_cells = size_t(n_coarse[0]) * n_coarse[1] * n_coarse[2];
+  int start[3]         = {0, 0, 0};
+  int end[3]           = {n_coarse[0], n_coarse[1], n_coarse[2]};
+  start[dir]           = layer;
+  end[dir]             = layer + 1;
+
+  size_t id_buffer = 0;
+  for (int field = 0; field < n_fields; field++) {
+    for (int i = start[0]; i < end[0]; i++) {
+      for (int j = start[1]; j < end[1]; j++) {
+        for (int k = start[2]; k < end[2]; k++) {
+          Real &cell = sums[field * n_cells + k + n_coarse[2] * (j + n_coarse[1] * size_t(i))];
+          if (add) {
+            cell += buffer[id_buffer++];
+          } else {
+            buffer[id_buffer++] = cell;
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Complete the coarse cells that straddle the boundaries of the processes. The
+ * process that has the first fine cell of a coarse cell owns it, so each
+ * process sends its partial first layer to its lower neighbor and adds the one
+ * of its upper neighbor to its last layer. Going through the directions one
+ * after the other completes the edges and corners too. */
+static void Add_Coarse_Boundaries(std::vector<Real> &sums, int n_fields, int const n_coarse[3], int const offset[3],
+                                  long const end[3], long const n_global[3], int factor)
+{
+  size_t const n_cells = size_t(n_coarse[0]) * n_coarse[1] * n_coarse[2];
+  for (int dir = 0; dir < 3; dir++) {
+    bool const send_lower = offset[dir] > 0;
+    bool const recv_upper = end[dir] % factor != 0 && end[dir] < n_global[dir];
+
+    // The neighbors in direction dir have the same coarse cells in the other
+    // directions
+    std::vector<Real> send_buffer(n_fields * n_cells / n_coarse[dir]);
+    std::vector<Real> recv_buffer(send_buffer.size());
+
+    MPI_Request send_request_coarse;
+    if (send_lower) {
+      Copy_Coarse_Layer(sums, n_fields, n_coarse, dir, 0, send_buffer, false);
+      MPI_Isend(send_buffer.data(), int(send_buffer.size()), MPI_CHREAL, dest[2 * dir], dir, world,
+                &send_request_coarse);
+    }
+    if (recv_upper) {
+      MPI_Recv(recv_buffer.data(), int(recv_buffer.size()), MPI_CHREAL, dest[2 * dir + 1], dir, world,
+               MPI_STATUS_IGNORE);
+      Copy_Coarse_Layer(sums, n_fields, n_coarse, dir, n_coarse[dir] - 1, recv_buffer, true);
+    }
+    if (send_lower) {
+      MPI_Wait(&send_request_coarse, MPI_STATUS_IGNORE);
+    }
+  }
+}
+#endif  // HDF5 && MPI_CHOLLA
+
+/* Output the grid data averaged over cubes of out_coarse_factor^3 cells. */
+void Output_Coarse(Grid3D &G, struct Parameters P, int nfile)
+{
+#ifdef HDF5
+  Header const &H = G.H;
+  // Do nothing in 1-D and 2-D case
+  if (H.ny_real == 1 || H.nz_real == 1) {
+    return;
+  }
+  int const factor = P.out_coarse_factor;
+
+  // The global index of the first real cell and the number of real cells of
+  // this process, and the number of cells of the whole grid
+  int const n_real[3] = {H.nx_real, H.ny_real, H.nz_real};
+  #ifdef MPI_CHOLLA
+  long const start[3]    = {nx_local_start, ny_local_start, nz_local_start};
+  long const n_global[3] = {nx_global, ny_global, nz_global};
+  #else
+  long const start[3]    = {0, 0, 0};
+  long const n_global[3] = {H.nx_real, H.ny_real, H.nz_real};
+  #endif  // MPI_CHOLLA
+
+  // Coarse cell c has the cells [c * factor, (c + 1) * factor) of the whole
+  // grid, the last ones are smaller if factor doesn't divide the grid. The
+  // real cells touch n_coarse coarse cells, and this process owns all but a
+  // first one that starts on its lower neighbor
+  int offset[3], n_coarse[3], n_owned[3], owned_start[3], n_coarse_global[3];
+  long end[3];
+  for (int dir = 0; dir < 3; dir++) {
+    if (n_real[dir] < factor) {
+      CHOLLA_ERROR("out_coarse_factor=%d is larger than the %d local cells of direction %d", factor, n_real[dir],
+                   dir);
+    }
+    end[dir]             = start[dir] + n_real[dir];
+    offset[dir]          = start[dir] % factor;
+    n_coarse[dir]        = (end[dir] - 1) / factor - start[dir] / factor + 1;
+    owned_start[dir]     = (start[dir] + factor - 1) / factor;
+    n_owned[dir]         = n_coarse[dir] - int(offset[dir] > 0);
+    n_coarse_global[dir] = (n_global[dir] + factor - 1) / factor;
+  }
+
+  // The conserved fields are averaged over the volume, so the velocities,
+  // specific energies and scalar fractions derived from them are mass
+  // weighted averages
+  Output_Units const units = Get_Output_Units(G);
+  HDF5_Field_Pack pack;
+  pack.Add(G.C.d_density, "/density", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.density);
+  pack.Add(G.C.d_momentum_x, "/momentum_x", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.momentum);
+  pack.Add(G.C.d_momentum_y, "/momentum_y", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.momentum);
+  pack.Add(G.C.d_momentum_z, "/momentum_z", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.momentum);
+  pack.Add(G.C.d_Energy, "/Energy", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.energy);
+  #ifdef DE
+  pack.Add(G.C.d_GasEnergy, "/GasEnergy", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, units.energy);
+  #endif  // DE
+  #ifdef BASIC_SCALAR
+  pack.Add(G.C.d_basic_scalar, "/scalar0", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost);
+  #endif  // BASIC_SCALAR
+  #ifdef DUST
+  pack.Add(G.C.d_dust_density, "/dust_density", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost);
+  #endif  // DUST
+
+  size_t const n_cells = size_t(n_coarse[0]) * n_coarse[1] * n_coarse[2];
+  std::vector<Real> sums(pack.n_fields * n_cells);
+  Coarsen_Grid_GPU(pack, factor, offset, n_coarse, sums.data());
+  #ifdef MPI_CHOLLA
+  Add_Coarse_Boundaries(sums, pack.n_fields, n_coarse, offset, end, n_global, factor);
+  #endif  // MPI_CHOLLA
+
+  // Divide the owned coarse cells by their number of cells
+  size_t const n_owned_cells = size_t(n_owned[0]) * n_owned[1] * n_owned[2];
+  std::vector<Real> coarse(pack.n_fields * n_owned_cells);
+  int const skip[3] = {n_coarse[0] - n_owned[0], n_coarse[1] - n_owned[1], n_coarse[2] - n_owned[2]};
+  auto n_fine       = [&](int dir, long c) { return std::min((c + 1) * factor, n_global[dir]) - c * factor; };
+  for (int field = 0; field < pack.n_fields; field++) {
+    size_t id = field * n_owned_cells;
+    for (int i = 0; i < n_owned[0]; i++) {
+      for (int j = 0; j < n_owned[1]; j++) {
+        for (int k = 0; k < n_owned[2]; k++) {
+          size_t const id_sums = (k + skip[2]) + n_coarse[2] * ((j + skip[1]) + n_coarse[1] * size_t(i + skip[0]));
+          long const volume    = n_fine(0, owned_start[0] + i) * n_fine(1, owned_start[1] + j) *
+                                 n_fine(2, owned_start[2] + k);
+          coarse[id++]         = sums[field * n_cells + id_sums] / Real(volume);
+        }
+      }
+    }
+  }
+
+  // create the filename
+  std::string filename = FnameTemplate(P).format_fname(nfile, "_coarse");
+
+  // Create a new file using default properties.
+  hid_t file_id = Create_Output_File_HDF5(filename, coarse.size() * sizeof(Real));
+  herr_t status;
+
+  // Write the header of the grid, and the global and local sizes of the coarse
+  // grid
+  G.Write_Header_HDF5(file_id);
+  hsize_t attr_dims  = 1;
+  hid_t dataspace_id = H5Screate_simple(1, &attr_dims, NULL);
+  int factor_data    = factor;
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &factor_data, "coarse_factor");
+  status             = H5Sclose(dataspace_id);
+  attr_dims          = 3;
+  dataspace_id       = H5Screate_simple(1, &attr_dims, NULL);
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, n_coarse_global, "dims_coarse");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, n_owned, "dims_local_coarse");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, owned_start, "offset_coarse");
+  status             = H5Sclose(dataspace_id);
+
+  hsize_t dims[3] = {hsize_t(n_owned[0]), hsize_t(n_owned[1]), hsize_t(n_owned[2])};
+  dataspace_id    = H5Screate_simple(3, dims, NULL);
+  for (int field = 0; field < pack.n_fields; field++) {
+    status = Write_HDF5_Dataset(file_id, dataspace_id, coarse.data() + field * n_owned_cells, pack.name[field]);
+    if (status < 0) {
+      printf("File write failed.\n");
+      exit(-1);
+    }
+  }
+  status = H5Sclose(dataspace_id);
+
+  // close the file
+  status = Close_Output_File_HDF5(file_id, filename, nfile);
 #endif  // HDF5
 }
 
@@ -415,40 +1044,58 @@ void Output_Projected_Data(Grid3D &G, struct Parameters P, int nfile)
 #endif  // HDF5
 }
 
+#ifdef HDF5
+/* Write the rotated projection at the current rotation to filename. Unless the
+ * pieces of the projection are composited into one image that the root
+ * writes, every process writes its own piece to its own file. */
+static herr_t Write_Rotated_Projection_File(Grid3D &G, std::string const &filename)
+{
+  bool const write_file = !G.R.composite || Is_Root_Proc();
+  hid_t file_id         = -1;
+
+  // Create a new file
+  if (write_file) {
+    file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  }
+
+  // Write the density and temperature projections to the output file, this
+  // sets the bounds of the piece of the image that the header records
+  G.Write_Rotated_Projection_HDF5(file_id);
+  if (!write_file) {
+    return 0;
+  }
+
+  // Write header (file attributes)
+  G.Write_Header_Rotated_HDF5(file_id);
+
+  // Close the file
+  return H5Fclose(file_id);
+}
+#endif  // HDF5
+
 /* Output a rotated projection of the grid data to file. */
 void Output_Rotated_Projected_Data(Grid3D &G, struct Parameters P, int nfile)
 {
 #ifdef HDF5
-  hid_t file_id;
   herr_t status;
 
   // create the filename
-  std::string filename = FnameTemplate(P).format_fname(nfile, "_rot_proj");
+  std::string filename = G.R.composite ? FnameTemplate(P).format_cat_fname(nfile, "_rot_proj")
+                                       : FnameTemplate(P).format_fname(nfile, "_rot_proj");
 
   if (G.R.flag_delta == 1) {
     // if flag_delta==1, then we are just outputting a
     // bunch of rotations of the same snapshot
     int i_delta;
-    char fname[200];
 
     for (i_delta = 0; i_delta < G.R.n_delta; i_delta++) {
-      filename += "." + std::to_string(G.R.i_delta);
-      chprintf("Outputting rotated projection %s.\n", fname);
+      std::string const fname = filename + "." + std::to_string(G.R.i_delta);
+      chprintf("Outputting rotated projection %s.\n", fname.c_str());
 
       // determine delta about z by output index
       G.R.delta = 2.0 * M_PI * ((double)i_delta) / ((double)G.R.n_delta);
 
-      // Create a new file
-      file_id = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-
-      // Write header (file attributes)
-      G.Write_Header_Rotated_HDF5(file_id);
-
-      // Write the density and temperature projections to the output file
-      G.Write_Rotated_Projection_HDF5(file_id);
-
-      // Close the file
-      status = H5Fclose(file_id);
+      status = Write_Rotated_Projection_File(G, fname);
   #ifdef MPI_CHOLLA
       if (status < 0) {
         printf("Output_Rotated_Projected_Data: File write failed. ProcID: %d\n", procID);
@@ -470,31 +1117,10 @@ void Output_Rotated_Projected_Data(Grid3D &G, struct Parameters P, int nfile)
     // rotation rate given in the parameter file
     G.R.delta = fmod(nfile * G.R.ddelta_dt * 2.0 * M_PI, (2.0 * M_PI));
 
-    // Create a new file
-    file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-
-    // Write header (file attributes)
-    G.Write_Header_Rotated_HDF5(file_id);
-
-    // Write the density and temperature projections to the output file
-    G.Write_Rotated_Projection_HDF5(file_id);
-
-    // Close the file
-    status = H5Fclose(file_id);
+    status = Write_Rotated_Projection_File(G, filename);
   } else {
     // case 0 -- just output at the delta given in the parameter file
-
-    // Create a new file
-    file_id = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-
-    // Write header (file attributes)
-    G.Write_Header_Rotated_HDF5(file_id);
-
-    // Write the density and temperature projections to the output file
-    G.Write_Rotated_Projection_HDF5(file_id);
-
-    // Close the file
-    status = H5Fclose(file_id);
+    status = Write_Rotated_Projection_File(G, filename);
   }
 
   #ifdef MPI_CHOLLA
@@ -552,6 +1178,169 @@ void Output_Slices(Grid3D &G, struct Parameters P, int nfile)
 #endif    // HDF5
 }
 
+#ifdef POWER_SPECTRUM
+/* Output the power spectra of the gas and the dark matter densities. The CIC
+ * density of the particles is deposited again, since the particles have moved
+ * since the last potential solve. */
+void Output_Power_Spectrum(Grid3D &G, struct Parameters P, int nfile)
+{
+  Header const &H = G.H;
+  if (G.power_spectrum == nullptr) {
+    G.power_spectrum = new PowerSpectrum3D(H.xdglobal, H.ydglobal, H.zdglobal, H.xblocal, H.yblocal, H.zblocal,
+                                           nx_global, ny_global, nz_global, H.nx_real, H.ny_real, H.nz_real, H.dx,
+                                           H.dy, H.dz);
+  }
+
+  std::vector<double> k, power_gas, n_modes;
+  G.power_spectrum->Compute(G.C.d_density, H.n_ghost, k, power_gas, n_modes);
+
+  #ifdef PARTICLES
+  std::vector<double> power_dm;
+  G.Particles.Clear_Density();
+  G.Particles.Get_Density_CIC();
+  G.Transfer_Particles_Density_Boundaries(P);
+  int const n_ghost_particles = G.Particles.G.n_ghost_particles_grid;
+    #ifdef PARTICLES_GPU
+  G.power_spectrum->Compute(G.Particles.G.density_dev, n_ghost_particles, k, power_dm, n_modes);
+    #else   // PARTICLES_CPU
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::io);
+  cuda_utilities::DeviceVector<Real> density_dm(G.Particles.G.n_cells);
+  density_dm.cpyHostToDevice(G.Particles.G.density, G.Particles.G.n_cells);
+  G.power_spectrum->Compute(density_dm.data(), n_ghost_particles, k, power_dm, n_modes);
+    #endif  // PARTICLES_GPU
+  #endif    // PARTICLES
+
+  if (procID != root) {
+    return;
+  }
+  #ifdef HDF5
+  std::string filename = FnameTemplate(P).format_cat_fname(nfile, "_power_spectrum");
+  hid_t file_id        = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  herr_t status;
+
+  hsize_t attr_dims  = 1;
+  hid_t dataspace_id = H5Screate_simple(1, &attr_dims, NULL);
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &G.H.t, "t");
+    #ifdef COSMOLOGY
+  status = Write_HDF5_Attribute(file_id, dataspace_id, &G.Cosmo.current_z, "Current_z");
+    #endif  // COSMOLOGY
+  status = H5Sclose(dataspace_id);
+
+  hsize_t dims = k.size();
+  dataspace_id = H5Screate_simple(1, &dims, NULL);
+  status       = Write_HDF5_Dataset(file_id, dataspace_id, k.data(), "/k");
+  status       = Write_HDF5_Dataset(file_id, dataspace_id, n_modes.data(), "/n_modes");
+  status       = Write_HDF5_Dataset(file_id, dataspace_id, power_gas.data(), "/P_gas");
+    #ifdef PARTICLES
+  status = Write_HDF5_Dataset(file_id, dataspace_id, power_dm.data(), "/P_dm");
+    #endif  // PARTICLES
+  status = H5Sclose(dataspace_id);
+
+  status = H5Fclose(file_id);
+  if (status < 0) {
+    printf("Output_Power_Spectrum: File write failed.\n");
+    chexit(-1);
+  }
+  #else   // HDF5 is not defined
+  printf("Output_Power_Spectrum only defined for hdf5 writes.\n");
+  #endif  // HDF5
+}
+#endif  // POWER_SPECTRUM
+
+#ifdef HALO_FINDER
+  #ifdef HDF5
+/* Write one column of the records of a halo catalog or of its members */
+template <typename Record, typename Get>
+static herr_t Write_Halo_Column(hid_t file_id, std::vector<Record> const &records, const char *name, Get get)
+{
+  using T = decltype(get(records[0]));
+  std::vector<T> column(records.size());
+  std::transform(records.begin(), records.end(), column.begin(), get);
+  hsize_t dims       = column.size();
+  hid_t dataspace_id = H5Screate_simple(1, &dims, NULL);
+  hid_t file_type    = std::is_integral<T>::value ? H5T_STD_I64LE : H5T_IEEE_F64BE;
+  hid_t mem_type     = std::is_integral<T>::value ? H5T_NATIVE_LLONG : H5T_NATIVE_DOUBLE;
+  hid_t dataset_id   = H5Dcreate(file_id, name, file_type, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  herr_t status      = H5Dwrite(dataset_id, mem_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, column.data());
+  H5Dclose(dataset_id);
+  H5Sclose(dataspace_id);
+  return status;
+}
+  #endif  // HDF5
+
+/* Output the friends-of-friends halos of the particles. The root writes the
+ * catalog, and with fof_output_members every process writes its particles of
+ * the halos of the catalog. */
+void Output_Halo_Catalog(Grid3D &G, struct Parameters P, int nfile)
+{
+  if (G.halo_finder == nullptr) {
+    G.halo_finder = new HaloFinder(P);
+  }
+  HaloFinder &finder = *G.halo_finder;
+  finder.Find(G.Particles, P.fof_output_members);
+
+  #ifdef HDF5
+  using Halo   = HaloFinder::Halo;
+  using Member = HaloFinder::Member;
+  herr_t status;
+  if (procID == root) {
+    std::vector<Halo> const &halos = finder.Halos();
+    std::string filename           = FnameTemplate(P).format_cat_fname(nfile, "_halos");
+    hid_t file_id                  = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+    hsize_t attr_dims   = 1;
+    hid_t dataspace_id  = H5Screate_simple(1, &attr_dims, NULL);
+    Real linking_length = finder.Linking_Length();
+    int n_halos         = halos.size();
+    status              = Write_HDF5_Attribute(file_id, dataspace_id, &G.H.t, "t");
+    #ifdef COSMOLOGY
+    status = Write_HDF5_Attribute(file_id, dataspace_id, &G.Cosmo.current_z, "Current_z");
+    #endif  // COSMOLOGY
+    status = Write_HDF5_Attribute(file_id, dataspace_id, &linking_length, "linking_length");
+    status = Write_HDF5_Attribute(file_id, dataspace_id, &P.fof_min_members, "min_members");
+    status = Write_HDF5_Attribute(file_id, dataspace_id, &n_halos, "n_halos");
+    status = H5Sclose(dataspace_id);
+
+    status = Write_Halo_Column(file_id, halos, "/id", [](Halo const &h) { return h.id; });
+    status = Write_Halo_Column(file_id, halos, "/n_particles", [](Halo const &h) { return h.n_particles; });
+    status = Write_Halo_Column(file_id, halos, "/mass", [](Halo const &h) { return h.mass; });
+    status = Write_Halo_Column(file_id, halos, "/pos_x", [](Halo const &h) { return h.pos[0]; });
+    status = Write_Halo_Column(file_id, halos, "/pos_y", [](Halo const &h) { return h.pos[1]; });
+    status = Write_Halo_Column(file_id, halos, "/pos_z", [](Halo const &h) { return h.pos[2]; });
+    status = Write_Halo_Column(file_id, halos, "/vel_x", [](Halo const &h) { return h.vel[0]; });
+    status = Write_Halo_Column(file_id, halos, "/vel_y", [](Halo const &h) { return h.vel[1]; });
+    status = Write_Halo_Column(file_id, halos, "/vel_z", [](Halo const &h) { return h.vel[2]; });
+
+    status = H5Fclose(file_id);
+    if (status < 0) {
+      printf("Output_Halo_Catalog: File write failed.\n");
+      chexit(-1);
+    }
+  }
+
+  if (P.fof_output_members) {
+    std::vector<Member> const &members = finder.Members();
+    std::string filename               = FnameTemplate(P).format_fname(nfile, "_halo_members");
+    hid_t file_id                      = H5Fcreate(filename.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+    status = Write_Halo_Column(file_id, members, "/halo_id", [](Member const &m) { return m.halo_id; });
+    status = Write_Halo_Column(file_id, members, "/particle_IDs", [](Member const &m) { return m.particle_id; });
+    status = Write_Halo_Column(file_id, members, "/pos_x", [](Member const &m) { return m.pos[0]; });
+    status = Write_Halo_Column(file_id, members, "/pos_y", [](Member const &m) { return m.pos[1]; });
+    status = Write_Halo_Column(file_id, members, "/pos_z", [](Member const &m) { return m.pos[2]; });
+
+    status = H5Fclose(file_id);
+    if (status < 0) {
+      printf("Output_Halo_Catalog: File write failed. ProcID: %d\n", procID);
+      chexit(-1);
+    }
+  }
+  #else   // HDF5 is not defined
+  printf("Output_Halo_Catalog only defined for hdf5 writes.\n");
+  #endif  // HDF5
+}
+#endif  // HALO_FINDER
+
 /*! \fn void Write_Header_Text(FILE *fp)
  *  \brief Write some relevant header info to a text output file. */
 void Grid3D::Write_Header_Text(FILE *fp)
@@ -694,17 +1483,21 @@ void Grid3D::Write_Header_HDF5(hid_t file_id)
   status = Write_HDF5_Attribute(file_id, dataspace_id, int_data, "dims");
 
   #ifdef MPI_CHOLLA
-  int_data[0] = H.nx_real;
-  int_data[1] = H.ny_real;
-  int_data[2] = H.nz_real;
+  // A single file of all the processes has no local attributes, like the
+  // concatenated files
+  if (not Output_Cat_Active()) {
+    int_data[0] = H.nx_real;
+    int_data[1] = H.ny_real;
+    int_data[2] = H.nz_real;
 
-  status = Write_HDF5_Attribute(file_id, dataspace_id, int_data, "dims_local");
+    status = Write_HDF5_Attribute(file_id, dataspace_id, int_data, "dims_local");
 
-  int_data[0] = nx_local_start;
-  int_data[1] = ny_local_start;
-  int_data[2] = nz_local_start;
+    int_data[0] = nx_local_start;
+    int_data[1] = ny_local_start;
+    int_data[2] = nz_local_start;
 
-  status = Write_HDF5_Attribute(file_id, dataspace_id, int_data, "offset");
+    status = Write_HDF5_Attribute(file_id, dataspace_id, int_data, "offset");
+  }
 
   int_data[0] = nproc_x;
   int_data[1] = nproc_y;
@@ -735,18 +1528,11 @@ void Grid3D::Write_Header_HDF5(hid_t file_id)
   status = H5Sclose(dataspace_id);
 }
 
-/*! \fn void Write_Header_Rotated_HDF5(hid_t file_id)
- *  \brief Write the relevant header info to the HDF5 file for rotated
- * projection. */
-void Grid3D::Write_Header_Rotated_HDF5(hid_t file_id)
+/*! \fn void Set_Rotated_Projection_Bounds()
+ *  \brief Set the piece of the rotated projection that this subvolume
+ * covers. */
+void Grid3D::Set_Rotated_Projection_Bounds()
 {
-  hid_t attribute_id, dataspace_id;
-  herr_t status;
-  hsize_t attr_dims;
-  int int_data[3];
-  Real Real_data[3];
-  Real delta, theta, phi;
-
   #ifdef MPI_CHOLLA
   // determine the size of the projection to output for this subvolume
   Real x, y, z, xp, yp, zp;
@@ -783,7 +1569,23 @@ void Grid3D::Write_Header_Rotated_HDF5(hid_t file_id)
   R.nx_max = std::min(R.nx_max, R.nx);
   R.nz_min = std::max(R.nz_min, 0);
   R.nz_max = std::min(R.nz_max, R.nz);
-  #endif
+  // a subvolume that projects outside of the image has an empty piece
+  R.nx_max = std::max(R.nx_max, R.nx_min);
+  R.nz_max = std::max(R.nz_max, R.nz_min);
+  #endif  // MPI_CHOLLA
+}
+
+/*! \fn void Write_Header_Rotated_HDF5(hid_t file_id)
+ *  \brief Write the relevant header info to the HDF5 file for rotated
+ * projection. */
+void Grid3D::Write_Header_Rotated_HDF5(hid_t file_id)
+{
+  hid_t attribute_id, dataspace_id;
+  herr_t status;
+  hsize_t attr_dims;
+  int int_data[3];
+  Real Real_data[3];
+  Real delta, theta, phi;
 
   // Single attributes first
   attr_dims = 1;
@@ -1153,23 +1955,45 @@ herr_t Read_HDF5_Dataset(hid_t file_id, float *dataset_buffer, const char *name)
 // dataset_buffer to avoid writing garbage
 herr_t Write_HDF5_Dataset(hid_t file_id, hid_t dataspace_id, double *dataset_buffer, const char *name)
 {
+  #ifdef MPI_CHOLLA
+  if (Output_Cat_Active()) {
+    return Write_HDF5_Dataset_Cat(file_id, dataspace_id, dataset_buffer, H5T_IEEE_F64BE, H5T_NATIVE_DOUBLE, name);
+  }
+  #endif  // MPI_CHOLLA
+  // Chunk and compress the dataset if its field is compressed
+  hsize_t dims[3];
+  int const rank = H5Sget_simple_extent_dims(dataspace_id, dims, NULL);
+  hid_t dcpl_id  = H5Pcreate(H5P_DATASET_CREATE);
+  Set_Output_Compression_HDF5(dcpl_id, name, H5T_IEEE_F64BE, rank, dims);
   // Create the dataset id
-  hid_t dataset_id = H5Dcreate(file_id, name, H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t dataset_id = H5Dcreate(file_id, name, H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
   // Write the array to file
   herr_t status = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer);
   // Free the dataset id
   status = H5Dclose(dataset_id);
+  H5Pclose(dcpl_id);
   return status;
 }
 
 herr_t Write_HDF5_Dataset(hid_t file_id, hid_t dataspace_id, float *dataset_buffer, const char *name)
 {
+  #ifdef MPI_CHOLLA
+  if (Output_Cat_Active()) {
+    return Write_HDF5_Dataset_Cat(file_id, dataspace_id, dataset_buffer, H5T_IEEE_F32BE, H5T_NATIVE_FLOAT, name);
+  }
+  #endif  // MPI_CHOLLA
+  // Chunk and compress the dataset if its field is compressed
+  hsize_t dims[3];
+  int const rank = H5Sget_simple_extent_dims(dataspace_id, dims, NULL);
+  hid_t dcpl_id  = H5Pcreate(H5P_DATASET_CREATE);
+  Set_Output_Compression_HDF5(dcpl_id, name, H5T_IEEE_F32BE, rank, dims);
   // Create the dataset id
-  hid_t dataset_id = H5Dcreate(file_id, name, H5T_IEEE_F32BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t dataset_id = H5Dcreate(file_id, name, H5T_IEEE_F32BE, dataspace_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
   // Write the array to file
   herr_t status = H5Dwrite(dataset_id, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer);
   // Free the dataset id
   status = H5Dclose(dataset_id);
+  H5Pclose(dcpl_id);
   return status;
 }
 
@@ -1230,7 +2054,7 @@ void Write_HDF5_Field_2D_CPU(Header H, hid_t file_id, hid_t dataspace_id, float
 
 /* \brief Before HDF5 reads data into a buffer, remap and write grid to HDF5 buffer. */
 void Fill_HDF5_Buffer_From_Grid_CPU(int nx, int ny, int nz, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                    Real *hdf5_buffer, Real *grid_buffer)
+                                    Real *hdf5_buffer, Real *grid_buffer, Real scale = 1)
 {
   int i, j, k, id, buf_id;
   // 3D case
@@ -1240,7 +2064,7 @@ void Fill_HDF5_Buffer_From_Grid_CPU(int nx, int ny, int nz, int nx_real, int ny_
         for (i = 0; i < nx_real; i++) {
           id                  = (i + n_ghost) + (j + n_ghost) * nx + (k + n_ghost) * nx * ny;
           buf_id              = k + j * nz_real + i * nz_real * ny_real;
-          hdf5_buffer[buf_id] = grid_buffer[id];
+          hdf5_buffer[buf_id] = scale * grid_buffer[id];
         }
       }
     }
@@ -1253,7 +2077,7 @@ void Fill_HDF5_Buffer_From_Grid_CPU(int nx, int ny, int nz, int nx_real, int ny_
       for (i = 0; i < nx_real; i++) {
         id                  = (i + n_ghost) + (j + n_ghost) * nx;
         buf_id              = j + i * ny_real;
-        hdf5_buffer[buf_id] = grid_buffer[id];
+        hdf5_buffer[buf_id] = scale * grid_buffer[id];
       }
     }
     return;
@@ -1261,15 +2085,17 @@ void Fill_HDF5_Buffer_From_Grid_CPU(int nx, int ny, int nz, int nx_real, int ny_
 
   // 1D case
   if (nx > 1 && ny == 1 && nz == 1) {
-    id = n_ghost;
-    memcpy(&hdf5_buffer[0], &grid_buffer[id], nx_real * sizeof(Real));
+    for (i = 0; i < nx_real; i++) {
+      hdf5_buffer[i] = scale * grid_buffer[i + n_ghost];
+    }
     return;
   }
 }
 
 /* \brief Before HDF5 reads data into a buffer, remap and write grid to HDF5 buffer. */
 void Fill_HDF5_Buffer_From_Grid_GPU(int nx, int ny, int nz, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                    Real *hdf5_buffer, Real *device_hdf5_buffer, Real *device_grid_buffer);
+                                    Real *hdf5_buffer, Real *device_hdf5_buffer, Real *device_grid_buffer,
+                                    Real scale = 1);
 // From src/io/io_gpu
 
 // Set up dataspace for grid formatted data and write dataset
@@ -1312,20 +2138,22 @@ void Write_HDF5_Dataset_Grid(int nx, int ny, int nz, int nx_real, int ny_real, i
   herr_t status = H5Sclose(dataspace_id);
 }
 
-// Data moves from host grid_buffer to dataset_buffer to hdf5 file
-void Write_Grid_HDF5_Field_CPU(Header H, hid_t file_id, Real *dataset_buffer, Real *grid_buffer, const char *name)
+// Data moves from host grid_buffer to dataset_buffer to hdf5 file, multiplied
+// by scale
+void Write_Grid_HDF5_Field_CPU(Header H, hid_t file_id, Real *dataset_buffer, Real *grid_buffer, const char *name,
+                               Real scale = 1)
 {
   Fill_HDF5_Buffer_From_Grid_CPU(H.nx, H.ny, H.nz, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, dataset_buffer,
-                                 grid_buffer);
+                                 grid_buffer, scale);
   Write_HDF5_Dataset_Grid(H.nx, H.ny, H.nz, H.nx_real, H.ny_real, H.nz_real, file_id, dataset_buffer, name);
 }
 
-// Data moves from device_grid_buffer to device_hdf5_buffer to dataset_buffer to hdf5 file
+// Data moves from device_grid_buffer to device_hdf5_buffer to dataset_buffer to hdf5 file, multiplied by scale
 void Write_Grid_HDF5_Field_GPU(Header H, hid_t file_id, Real *dataset_buffer, Real *device_hdf5_buffer,
-                               Real *device_grid_buffer, const char *name)
+                               Real *device_grid_buffer, const char *name, Real scale = 1)
 {
   Fill_HDF5_Buffer_From_Grid_GPU(H.nx, H.ny, H.nz, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, dataset_buffer,
-                                 device_hdf5_buffer, device_grid_buffer);
+                                 device_hdf5_buffer, device_grid_buffer, scale);
   Write_HDF5_Dataset_Grid(H.nx, H.ny, H.nz, H.nx_real, H.ny_real, H.nz_real, file_id, dataset_buffer, name);
 }
 
@@ -1404,47 +2232,50 @@ void Grid3D::Write_Grid_HDF5(hid_t file_id)
 
   // Start writing fields
 
-  Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_density, "/density");
+  // The device fields are gathered first, so in 3D they are all packed with
+  // one kernel launch, each with the factor to its output units
+  Output_Units const units = Get_Output_Units(*this);
+  std::vector<std::tuple<Real *, const char *, Real>> gpu_fields;
+  gpu_fields.emplace_back(C.d_density, "/density", units.density);
   if (output_momentum || H.Output_Complete_Data) {
-    Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_momentum_x, "/momentum_x");
-    Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_momentum_y, "/momentum_y");
-    Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_momentum_z, "/momentum_z");
+    gpu_fields.emplace_back(C.d_momentum_x, "/momentum_x", units.momentum);
+    gpu_fields.emplace_back(C.d_momentum_y, "/momentum_y", units.momentum);
+    gpu_fields.emplace_back(C.d_momentum_z, "/momentum_z", units.momentum);
   }
   if (output_energy || H.Output_Complete_Data) {
-    Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_Energy, "/Energy");
+    gpu_fields.emplace_back(C.d_Energy, "/Energy", units.energy);
   #ifdef DE
-    Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_GasEnergy, "/GasEnergy");
+    gpu_fields.emplace_back(C.d_GasEnergy, "/GasEnergy", units.energy);
   #endif
   }
 
   #ifdef SCALAR
 
     #ifdef BASIC_SCALAR
-  Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_basic_scalar, "/scalar0");
+  gpu_fields.emplace_back(C.d_basic_scalar, "/scalar0", 1);
     #endif  // BASIC_SCALAR
 
     #ifdef DUST
-  Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), C.d_dust_density,
-                            "/dust_density");
+  gpu_fields.emplace_back(C.d_dust_density, "/dust_density", 1);
     #endif  // DUST
 
     #ifdef OUTPUT_CHEMISTRY
       #ifdef CHEMISTRY_GPU
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HI_density, "/HI_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HII_density, "/HII_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeI_density, "/HeI_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeII_density, "/HeII_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeIII_density, "/HeIII_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.e_density, "/e_density");
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HI_density, "/HI_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HII_density, "/HII_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeI_density, "/HeI_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeII_density, "/HeII_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.HeIII_density, "/HeIII_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.e_density, "/e_density", units.density);
       #elif defined(COOLING_GRACKLE)
   // Cool fields are CPU (host) only
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HI_density, "/HI_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HII_density, "/HII_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeI_density, "/HeI_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeII_density, "/HeII_density");
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeIII_density, "/HeIII_density");
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HI_density, "/HI_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HII_density, "/HII_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeI_density, "/HeI_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeII_density, "/HeII_density", units.density);
+  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.HeIII_density, "/HeIII_density", units.density);
   if (output_electrons || H.Output_Complete_Data) {
-    Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.e_density, "/e_density");
+    Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.e_density, "/e_density", units.density);
   }
       #endif
     #endif  // OUTPUT_CHEMISTRY
@@ -1453,14 +2284,17 @@ void Grid3D::Write_Grid_HDF5(hid_t file_id)
 
       #ifdef GRACKLE_METALS
   if (output_metals || H.Output_Complete_Data) {
-    Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.metal_density, "/metal_density");
+        #ifdef CHEMISTRY_GPU
+    Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, C.metal_density, "/metal_density", units.density);
+        #else
+    Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.fields.metal_density, "/metal_density", units.density);
+        #endif
   }
       #endif  // GRACKLE_METALS
 
       #ifdef OUTPUT_TEMPERATURE
         #ifdef CHEMISTRY_GPU
-  Compute_Gas_Temperature(Chem.Fields.temperature_h, false);
-  Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Chem.Fields.temperature_h, "/temperature");
+  gpu_fields.emplace_back(Derived.Get(*this, "temperature"), "/temperature", 1);
         #elif defined(COOLING_GRACKLE)
   Write_Grid_HDF5_Field_CPU(H, file_id, dataset_buffer, Cool.temperature, "/temperature");
         #endif
@@ -1470,25 +2304,43 @@ void Grid3D::Write_Grid_HDF5(hid_t file_id)
 
   #endif  // SCALAR
 
+  // The derived fields of output_derived, unless they are already written
+  std::vector<std::string> derived_names;
+  derived_names.reserve(Derived.Outputs().size());
+  for (std::string const &name : Derived.Outputs()) {
+    derived_names.push_back("/" + name);
+    bool const written = std::any_of(gpu_fields.begin(), gpu_fields.end(), [&](auto const &field) {
+      return derived_names.back() == std::get<1>(field);
+    });
+    if (not written) {
+      gpu_fields.emplace_back(Derived.Get(*this, name), derived_names.back().c_str(),
+                              DerivedFields::Output_Scale(name, units.energy));
+    }
+  }
+
   // 3D case
   if (H.nx > 1 && H.ny > 1 && H.nz > 1) {
+    HDF5_Field_Pack pack;
+    for (auto const &[device_field, name, scale] : gpu_fields) {
+      pack.Add(device_field, name, H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, -1, scale);
+    }
   #if defined(GRAVITY) && defined(OUTPUT_POTENTIAL)
-    Write_Generic_HDF5_Field_GPU(Grav.nx_local + 2 * N_GHOST_POTENTIAL, Grav.ny_local + 2 * N_GHOST_POTENTIAL,
-                                 Grav.nz_local + 2 * N_GHOST_POTENTIAL, Grav.nx_local, Grav.ny_local, Grav.nz_local,
-                                 N_GHOST_POTENTIAL, file_id, dataset_buffer, device_dataset_vector.data(),
-                                 Grav.F.potential_d, "/grav_potential");
+    pack.Add(Grav.F.potential_d, "/grav_potential", Grav.nx_local + 2 * N_GHOST_POTENTIAL,
+             Grav.ny_local + 2 * N_GHOST_POTENTIAL, Grav.nx_local, Grav.ny_local, Grav.nz_local, N_GHOST_POTENTIAL);
   #endif  // GRAVITY and OUTPUT_POTENTIAL
 
   #ifdef MHD
     if (H.Output_Complete_Data) {
-      Write_HDF5_Field_3D(H.nx, H.ny, H.nx_real + 1, H.ny_real, H.nz_real, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), C.d_magnetic_x, "/magnetic_x", 0);
-      Write_HDF5_Field_3D(H.nx, H.ny, H.nx_real, H.ny_real + 1, H.nz_real, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), C.d_magnetic_y, "/magnetic_y", 1);
-      Write_HDF5_Field_3D(H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real + 1, H.n_ghost, file_id, dataset_buffer,
-                          device_dataset_vector.data(), C.d_magnetic_z, "/magnetic_z", 2);
+      pack.Add(C.d_magnetic_x, "/magnetic_x", H.nx, H.ny, H.nx_real + 1, H.ny_real, H.nz_real, H.n_ghost, 0);
+      pack.Add(C.d_magnetic_y, "/magnetic_y", H.nx, H.ny, H.nx_real, H.ny_real + 1, H.nz_real, H.n_ghost, 1);
+      pack.Add(C.d_magnetic_z, "/magnetic_z", H.nx, H.ny, H.nx_real, H.ny_real, H.nz_real + 1, H.n_ghost, 2);
     }
   #endif  // MHD
+    Write_HDF5_Fields_3D<Real>(file_id, pack);
+  } else {
+    for (auto const &[device_field, name, scale] : gpu_fields) {
+      Write_Grid_HDF5_Field_GPU(H, file_id, dataset_buffer, device_dataset_vector.data(), device_field, name, scale);
+    }
   }
 
   free(dataset_buffer);
@@ -1501,17 +2353,8 @@ void Grid3D::Write_Grid_HDF5(hid_t file_id)
  * current simulation time. */
 void Grid3D::Write_Projection_HDF5(hid_t file_id)
 {
-  hid_t dataset_id, dataspace_xy_id, dataspace_xz_id;
-  Real *dataset_buffer_dxy, *dataset_buffer_dxz;
-  Real *dataset_buffer_Txy, *dataset_buffer_Txz;
+  hid_t dataspace_xy_id, dataspace_xz_id;
   herr_t status;
-  Real dxy, dxz, Txy, Txz;
-  #ifdef DUST
-  Real dust_xy, dust_xz;
-  Real *dataset_buffer_dust_xy, *dataset_buffer_dust_xz;
-  #endif
-
-  Real mu = 0.6;
 
   // 3D
   if (H.nx > 1 && H.ny > 1 && H.nz > 1) {
@@ -1519,14 +2362,20 @@ void Grid3D::Write_Projection_HDF5(hid_t file_id)
     int ny_dset = H.ny_real;
     int nz_dset = H.nz_real;
     hsize_t dims[2];
-    dataset_buffer_dxy = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_dxz = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-    dataset_buffer_Txy = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_Txz = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-  #ifdef DUST
-    dataset_buffer_dust_xy = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_dust_xz = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-  #endif
+
+    // The columns are summed on the device, only the density, temperature and
+    // dust maps are copied back
+    size_t const n_xy = size_t(nx_dset) * ny_dset;
+    size_t const n_xz = size_t(nx_dset) * nz_dset;
+    std::vector<Real> projection_xy(3 * n_xy);
+    std::vector<Real> projection_xz(3 * n_xz);
+    Project_Grid_GPU(H, C.device, gama, 2, projection_xy.data(), C.d_magnetic_centered);
+    Project_Grid_GPU(H, C.device, gama, 1, projection_xz.data(), C.d_magnetic_centered);
+    // The density weighted temperature scales like the energy
+    Output_Units const units       = Get_Output_Units(*this);
+    std::vector<Real> const scales = {units.density, units.energy, 1};
+    Scale_Output_Maps(projection_xy.data(), n_xy, scales);
+    Scale_Output_Maps(projection_xz.data(), n_xz, scales);
 
     // Create the data space for the datasets
     dims[0]         = nx_dset;
@@ -1535,118 +2384,14 @@ void Grid3D::Write_Projection_HDF5(hid_t file_id)
     dims[1]         = nz_dset;
     dataspace_xz_id = H5Screate_simple(2, dims, NULL);
 
-    // Copy the xy density and temperature projections to the memory buffer
-    for (int j = 0; j < H.ny_real; j++) {
-      for (int i = 0; i < H.nx_real; i++) {
-        dxy = 0;
-        Txy = 0;
-  #ifdef DUST
-        dust_xy = 0;
-  #endif
-        // for each xy element, sum over the z column
-        for (int k = 0; k < H.nz_real; k++) {
-          int const xid = i + H.n_ghost;
-          int const yid = j + H.n_ghost;
-          int const zid = k + H.n_ghost;
-          int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, H.nx, H.ny);
-
-          // sum density
-          Real const d = C.density[id];
-          dxy += d * H.dz;
-  #ifdef DUST
-          dust_xy += C.dust_density[id] * H.dz;
-  #endif
-          // calculate number density
-          Real const n = d * DENSITY_UNIT / (mu * MP);
-
-  // calculate temperature
-  #ifdef DE
-          Real const T = hydro_utilities::Calc_Temp_DE(C.GasEnergy[id], gama, n);
-  #else  // DE is not defined
-          Real const mx = C.momentum_x[id];
-          Real const my = C.momentum_y[id];
-          Real const mz = C.momentum_z[id];
-          Real const E  = C.Energy[id];
-
-    #ifdef MHD
-          auto const [magnetic_x, magnetic_y, magnetic_z] =
-              mhd::utils::cellCenteredMagneticFields(C.host, id, xid, yid, zid, H.n_cells, H.nx, H.ny);
-          Real const T =
-              hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n, magnetic_x, magnetic_y, magnetic_z);
-    #else   // MHD is not defined
-          Real const T = hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n);
-    #endif  // MHD
-  #endif    // DE
-
-          Txy += T * d * H.dz;
-        }
-        int const buf_id           = j + i * H.ny_real;
-        dataset_buffer_dxy[buf_id] = dxy;
-        dataset_buffer_Txy[buf_id] = Txy;
-  #ifdef DUST
-        dataset_buffer_dust_xy[buf_id] = dust_xy;
-  #endif
-      }
-    }
-
-    // Copy the xz density and temperature projections to the memory buffer
-    for (int k = 0; k < H.nz_real; k++) {
-      for (int i = 0; i < H.nx_real; i++) {
-        dxz = 0;
-        Txz = 0;
-  #ifdef DUST
-        dust_xz = 0;
-  #endif
-        // for each xz element, sum over the y column
-        for (int j = 0; j < H.ny_real; j++) {
-          int const xid = i + H.n_ghost;
-          int const yid = j + H.n_ghost;
-          int const zid = k + H.n_ghost;
-          int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, H.nx, H.ny);
-          // sum density
-          Real const d = C.density[id];
-          dxz += d * H.dy;
-  #ifdef DUST
-          dust_xz += C.dust_density[id] * H.dy;
-  #endif
-          // calculate number density
-          Real const n = d * DENSITY_UNIT / (mu * MP);
-  #ifdef DE
-          Real const T = hydro_utilities::Calc_Temp_DE(C.GasEnergy[id], gama, n);
-  #else  // DE is not defined
-          Real const mx = C.momentum_x[id];
-          Real const my = C.momentum_y[id];
-          Real const mz = C.momentum_z[id];
-          Real const E  = C.Energy[id];
-
-    #ifdef MHD
-          auto const [magnetic_x, magnetic_y, magnetic_z] =
-              mhd::utils::cellCenteredMagneticFields(C.host, id, xid, yid, zid, H.n_cells, H.nx, H.ny);
-          Real const T =
-              hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n, magnetic_x, magnetic_y, magnetic_z);
-    #else   // MHD is not defined
-          Real const T = hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n);
-    #endif  // MHD
-  #endif    // DE
-          Txz += T * d * H.dy;
-        }
-        int const buf_id           = k + i * H.nz_real;
-        dataset_buffer_dxz[buf_id] = dxz;
-        dataset_buffer_Txz[buf_id] = Txz;
-  #ifdef DUST
-        dataset_buffer_dust_xz[buf_id] = dust_xz;
-  #endif
-      }
-    }
-
     // Write the projected density and temperature arrays to file
-    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, dataset_buffer_dxy, "/d_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, dataset_buffer_dxz, "/d_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, dataset_buffer_Txy, "/T_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, dataset_buffer_Txz, "/T_xz");
+    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, projection_xy.data(), "/d_xy");
+    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, projection_xz.data(), "/d_xz");
+    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, projection_xy.data() + n_xy, "/T_xy");
+    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, projection_xz.data() + n_xz, "/T_xz");
   #ifdef DUST
-    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, dataset_buffer_dust_xy, "/d_dust_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, dataset_buffer_dust_xz, "/d_dust_xz");
+    status = Write_HDF5_Dataset(file_id, dataspace_xy_id, projection_xy.data() + 2 * n_xy, "/d_dust_xy");
+    status = Write_HDF5_Dataset(file_id, dataspace_xz_id, projection_xz.data() + 2 * n_xz, "/d_dust_xz");
   #endif
 
     // Free the dataspace ids
@@ -1655,49 +2400,110 @@ void Grid3D::Write_Projection_HDF5(hid_t file_id)
   } else {
     printf("Projection write only works for 3D data.\n");
   }
-
-  free(dataset_buffer_dxy);
-  free(dataset_buffer_dxz);
-  free(dataset_buffer_Txy);
-  free(dataset_buffer_Txz);
-  #ifdef DUST
-  free(dataset_buffer_dust_xy);
-  free(dataset_buffer_dust_xz);
-  #endif  // DUST
 }
 #endif  // HDF5
 
+#if defined(HDF5) && defined(MPI_CHOLLA)
+/* The number of pixels of a piece [box[0], box[1]) x [box[2], box[3]) of the
+ * rotated projection */
+static size_t Rotated_Projection_Box_Size(int const box[4])
+{
+  return size_t(box[1] - box[0]) * (box[3] - box[2]);
+}
+
+/* Add the n_maps maps of src, that cover the piece src_box of the rotated
+ * projection, to the maps of dst that cover dst_box, which contains src_box */
+static void Add_Rotated_Projection_Box(int const src_box[4], Real const *src, int const dst_box[4], Real *dst,
+                                       int n_maps)
+{
+  size_t const n_src = Rotated_Projection_Box_Size(src_box);
+  size_t const n_dst = Rotated_Projection_Box_Size(dst_box);
+  int const nz_src   = src_box[3] - src_box[2];
+  int const nz_dst   = dst_box[3] - dst_box[2];
+  for (int m = 0; m < n_maps; m++) {
+    for (int ix = src_box[0]; ix < src_box[1]; ix++) {
+      Real const *src_row = src + m * n_src + size_t(ix - src_box[0]) * nz_src;
+      Real *dst_row       = dst + m * n_dst + size_t(ix - dst_box[0]) * nz_dst + (src_box[2] - dst_box[2]);
+      for (int iz = 0; iz < nz_src; iz++) {
+        dst_row[iz] += src_row[iz];
+      }
+    }
+  }
+}
+
+/* Grow the piece box of the n_maps maps of projection to also cover other */
+static void Grow_Rotated_Projection_Box(int box[4], std::vector<Real> &projection, int const other[4], int n_maps)
+{
+  if (Rotated_Projection_Box_Size(other) == 0) {
+    return;
+  }
+  int grown[4] = {other[0], other[1], other[2], other[3]};
+  if (Rotated_Projection_Box_Size(box) > 0) {
+    grown[0] = std::min(box[0], other[0]);
+    grown[1] = std::max(box[1], other[1]);
+    grown[2] = std::min(box[2], other[2]);
+    grown[3] = std::max(box[3], other[3]);
+  }
+  if (std::equal(grown, grown + 4, box)) {
+    return;
+  }
+  std::vector<Real> grown_projection(n_maps * Rotated_Projection_Box_Size(grown), 0.0);
+  Add_Rotated_Projection_Box(box, projection.data(), grown, grown_projection.data(), n_maps);
+  projection.swap(grown_projection);
+  std::copy(grown, grown + 4, box);
+}
+
+/* Sum the pieces of the n_maps maps of the rotated projection of every process
+ * on the root with a binary tree. Each process adds the pieces of its children
+ * to its own and sends the bounding box of the sum to its parent, so no
+ * process receives more than log2(nproc) pieces and the pieces stay small
+ * until the last levels. On the root projection becomes the whole R.nx*R.nz
+ * image. */
+static void Reduce_Rotated_Projection(Rotation &R, std::vector<Real> &projection, int n_maps)
+{
+  int box[4]     = {R.nx_min, R.nx_max, R.nz_min, R.nz_max};
+  int const rank = (procID - root + nproc) % nproc;
+
+  for (int step = 1; step < nproc; step *= 2) {
+    if (rank % (2 * step) != 0) {
+      int const parent = (rank - step + root) % nproc;
+      MPI_Send(box, 4, MPI_INT, parent, 0, world);
+      MPI_Send(projection.data(), int(projection.size()), MPI_CHREAL, parent, 1, world);
+      return;
+    }
+    if (rank + step >= nproc) {
+      continue;
+    }
+    int const child = (rank + step + root) % nproc;
+    int child_box[4];
+    MPI_Recv(child_box, 4, MPI_INT, child, 0, world, MPI_STATUS_IGNORE);
+    std::vector<Real> child_projection(n_maps * Rotated_Projection_Box_Size(child_box));
+    MPI_Recv(child_projection.data(), int(child_projection.size()), MPI_CHREAL, child, 1, world, MPI_STATUS_IGNORE);
+    Grow_Rotated_Projection_Box(box, projection, child_box, n_maps);
+    Add_Rotated_Projection_Box(child_box, child_projection.data(), box, projection.data(), n_maps);
+  }
+
+  // The root writes the whole image, even where no cell was projected
+  int const image_box[4] = {0, R.nx, 0, R.nz};
+  Grow_Rotated_Projection_Box(box, projection, image_box, n_maps);
+  R.nx_min = 0;
+  R.nx_max = R.nx;
+  R.nz_min = 0;
+  R.nz_max = R.nz;
+}
+#endif  // HDF5 && MPI_CHOLLA
+
 #ifdef HDF5
 /*! \fn void Write_Rotated_Projection_HDF5(hid_t file_id)
  *  \brief Write rotated projected data to a file, at the current simulation
  * time. */
 void Grid3D::Write_Rotated_Projection_HDF5(hid_t file_id)
 {
-  hid_t dataset_id, dataspace_xzr_id;
-  Real *dataset_buffer_dxzr;
-  Real *dataset_buffer_Txzr;
-  Real *dataset_buffer_vxxzr;
-  Real *dataset_buffer_vyxzr;
-  Real *dataset_buffer_vzxzr;
-
+  hid_t dataspace_xzr_id;
   herr_t status;
-  Real dxy, dxz, Txy, Txz;
-  Real d, vx, vy, vz;
-
-  Real x, y, z;      // cell positions
-  Real xp, yp, zp;   // rotated positions
-  Real alpha, beta;  // projected positions
-  int ix, iz;        // projected index positions
-
-  Real mu = 0.6;
-
-  srand(137);      // initialize a random number
-  Real eps = 0.1;  // randomize cell centers slightly to combat aliasing
 
   // 3D
   if (H.nx > 1 && H.ny > 1 && H.nz > 1) {
-    Real Lx     = R.Lx;  // projected box size in x dir
-    Real Lz     = R.Lz;  // projected box size in z dir
     int nx_dset = R.nx;
     int nz_dset = R.nz;
 
@@ -1710,118 +2516,50 @@ void Grid3D::Write_Rotated_Projection_HDF5(hid_t file_id)
 
     // set the projected dataset size for this process to capture
     // this piece of the simulation volume
-    // min and max values were set in the header write
-    int nx_min, nx_max, nz_min, nz_max;
-    nx_min  = R.nx_min;
-    nx_max  = R.nx_max;
-    nz_min  = R.nz_min;
-    nz_max  = R.nz_max;
-    nx_dset = nx_max - nx_min;
-    nz_dset = nz_max - nz_min;
+    Set_Rotated_Projection_Bounds();
+    nx_dset = R.nx_max - R.nx_min;
+    nz_dset = R.nz_max - R.nz_min;
 
     hsize_t dims[2];
 
-    // allocate the buffers for the projected dataset
-    // and initialize to zero
-    dataset_buffer_dxzr  = (Real *)calloc(nx_dset * nz_dset, sizeof(Real));
-    dataset_buffer_Txzr  = (Real *)calloc(nx_dset * nz_dset, sizeof(Real));
-    dataset_buffer_vxxzr = (Real *)calloc(nx_dset * nz_dset, sizeof(Real));
-    dataset_buffer_vyxzr = (Real *)calloc(nx_dset * nz_dset, sizeof(Real));
-    dataset_buffer_vzxzr = (Real *)calloc(nx_dset * nz_dset, sizeof(Real));
+    // The cells are projected on the device with slightly jittered centers to
+    // combat aliasing, only the d, T, vx, vy and vz maps are copied back
+    size_t n_xzr = size_t(nx_dset) * nz_dset;
+    std::vector<Real> projection_xzr(5 * n_xzr);
+    Project_Rotated_Grid_GPU(H, R, C.device, gama, nx_dset, nz_dset, projection_xzr.data(), C.d_magnetic_centered);
+    Output_Units const units = Get_Output_Units(*this);
+    Scale_Output_Maps(projection_xzr.data(), n_xzr,
+                      {units.density, units.energy, units.momentum, units.momentum, units.momentum});
+
+  #ifdef MPI_CHOLLA
+    // Sum the pieces into the whole image on the root, which is the only
+    // process that writes it
+    if (R.composite) {
+      Reduce_Rotated_Projection(R, projection_xzr, 5);
+      if (procID != root) {
+        return;
+      }
+      nx_dset = R.nx;
+      nz_dset = R.nz;
+      n_xzr   = size_t(nx_dset) * nz_dset;
+    }
+  #endif  // MPI_CHOLLA
 
     // Create the data space for the datasets
     dims[0]          = nx_dset;
     dims[1]          = nz_dset;
     dataspace_xzr_id = H5Screate_simple(2, dims, NULL);
 
-    // Copy the xz rotated projection to the memory buffer
-    for (int k = 0; k < H.nz_real; k++) {
-      for (int i = 0; i < H.nx_real; i++) {
-        for (int j = 0; j < H.ny_real; j++) {
-          // get cell index
-          int const xid = i + H.n_ghost;
-          int const yid = j + H.n_ghost;
-          int const zid = k + H.n_ghost;
-          int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, H.nx, H.ny);
-
-          // get cell positions
-          Get_Position(i + H.n_ghost, j + H.n_ghost, k + H.n_ghost, &x, &y, &z);
-
-          // add very slight noise to locations
-          x += eps * H.dx * (drand48() - 0.5);
-          y += eps * H.dy * (drand48() - 0.5);
-          z += eps * H.dz * (drand48() - 0.5);
-
-          // rotate cell positions
-          Rotate_Point(x, y, z, R.delta, R.phi, R.theta, &xp, &yp, &zp);
-
-          // find projected locations
-          // assumes box centered at [0,0,0]
-          alpha = (R.nx * (xp + 0.5 * R.Lx) / R.Lx);
-          beta  = (R.nz * (zp + 0.5 * R.Lz) / R.Lz);
-          ix    = (int)round(alpha);
-          iz    = (int)round(beta);
-  #ifdef MPI_CHOLLA
-          ix = ix - nx_min;
-          iz = iz - nz_min;
-  #endif
-
-          if ((ix >= 0) && (ix < nx_dset) && (iz >= 0) && (iz < nz_dset)) {
-            int const buf_id = iz + ix * nz_dset;
-            d                = C.density[id];
-            // project density
-            dataset_buffer_dxzr[buf_id] += d * H.dy;
-            // calculate number density
-            Real const n = d * DENSITY_UNIT / (mu * MP);
-
-  // calculate temperature
-  #ifdef DE
-            Real const T = hydro_utilities::Calc_Temp_DE(C.GasEnergy[id], gama, n);
-  #else  // DE is not defined
-            Real const mx = C.momentum_x[id];
-            Real const my = C.momentum_y[id];
-            Real const mz = C.momentum_z[id];
-            Real const E  = C.Energy[id];
-
-    #ifdef MHD
-            auto const [magnetic_x, magnetic_y, magnetic_z] =
-                mhd::utils::cellCenteredMagneticFields(C.host, id, xid, yid, zid, H.n_cells, H.nx, H.ny);
-            Real const T =
-                hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n, magnetic_x, magnetic_y, magnetic_z);
-    #else   // MHD is not defined
-            Real const T = hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gama, n);
-    #endif  // MHD
-  #endif    // DE
-
-            Txz = T * d * H.dy;
-            dataset_buffer_Txzr[buf_id] += Txz;
-
-            // compute velocities
-            dataset_buffer_vxxzr[buf_id] += C.momentum_x[id] * H.dy;
-            dataset_buffer_vyxzr[buf_id] += C.momentum_y[id] * H.dy;
-            dataset_buffer_vzxzr[buf_id] += C.momentum_z[id] * H.dy;
-          }
-        }
-      }
-    }
-
     // Write projected d,T,vx,vy,vz
-    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, dataset_buffer_dxzr, "/d_xzr");
-    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, dataset_buffer_Txzr, "/T_xzr");
-    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, dataset_buffer_vxxzr, "/vx_xzr");
-    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, dataset_buffer_vyxzr, "/vy_xzr");
-    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, dataset_buffer_vzxzr, "/vz_xzr");
+    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, projection_xzr.data(), "/d_xzr");
+    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, projection_xzr.data() + n_xzr, "/T_xzr");
+    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, projection_xzr.data() + 2 * n_xzr, "/vx_xzr");
+    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, projection_xzr.data() + 3 * n_xzr, "/vy_xzr");
+    status = Write_HDF5_Dataset(file_id, dataspace_xzr_id, projection_xzr.data() + 4 * n_xzr, "/vz_xzr");
 
     // Free the dataspace id
     status = H5Sclose(dataspace_xzr_id);
 
-    // free the data
-    free(dataset_buffer_dxzr);
-    free(dataset_buffer_Txzr);
-    free(dataset_buffer_vxxzr);
-    free(dataset_buffer_vyxzr);
-    free(dataset_buffer_vzxzr);
-
   } else {
     chprintf("Rotated projection write only implemented for 3D data.\n");
   }
@@ -1834,19 +2572,7 @@ void Grid3D::Write_Rotated_Projection_HDF5(hid_t file_id)
      at the current simulation time. */
 void Grid3D::Write_Slices_HDF5(hid_t file_id)
 {
-  int i, j, k, id, buf_id;
-  hid_t dataset_id, dataspace_id;
-  Real *dataset_buffer_d;
-  Real *dataset_buffer_mx;
-  Real *dataset_buffer_my;
-  Real *dataset_buffer_mz;
-  Real *dataset_buffer_E;
-  #ifdef DE
-  Real *dataset_buffer_GE;
-  #endif
-  #ifdef SCALAR
-  Real *dataset_buffer_scalar;
-  #endif
+  hid_t dataspace_id;
   herr_t status;
   int xslice, yslice, zslice;
   xslice = H.nx / 2;
@@ -1860,390 +2586,72 @@ void Grid3D::Write_Slices_HDF5(hid_t file_id)
 
   // 3D
   if (H.nx > 1 && H.ny > 1 && H.nz > 1) {
-    int nx_dset = H.nx_real;
-    int ny_dset = H.ny_real;
-    int nz_dset = H.nz_real;
-    hsize_t dims[2];
-
-    // Create the xy data space for the datasets
-    dims[0]      = nx_dset;
-    dims[1]      = ny_dset;
-    dataspace_id = H5Screate_simple(2, dims, NULL);
-
-    // Allocate memory for the xy slices
-    dataset_buffer_d  = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_mx = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_my = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_mz = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
-    dataset_buffer_E  = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
+    // The names of the Slice_Grid_GPU fields, followed by the plane, and the
+    // factors to their output units
+    Output_Units const units       = Get_Output_Units(*this);
+    std::vector<std::string> names = {"/d", "/mx", "/my", "/mz", "/E"};
+    std::vector<Real> scales       = {units.density, units.momentum, units.momentum, units.momentum, units.energy};
   #ifdef MHD
-    std::vector<Real> dataset_buffer_magnetic_x(H.nx_real * H.ny_real);
-    std::vector<Real> dataset_buffer_magnetic_y(H.nx_real * H.ny_real);
-    std::vector<Real> dataset_buffer_magnetic_z(H.nx_real * H.ny_real);
+    names.insert(names.end(), {"/magnetic_x", "/magnetic_y", "/magnetic_z"});
+    scales.insert(scales.end(), {1, 1, 1});
   #endif  // MHD
   #ifdef DE
-    dataset_buffer_GE = (Real *)malloc(H.nx_real * H.ny_real * sizeof(Real));
+    names.push_back("/GE");
+    scales.push_back(units.energy);
   #endif
   #ifdef SCALAR
-    dataset_buffer_scalar = (Real *)malloc(NSCALARS * H.nx_real * H.ny_real * sizeof(Real));
+    // Only the first scalar is written
+    names.push_back("/scalar");
+    scales.push_back(1);
   #endif
 
-    // Copy the xy slices to the memory buffers
-    for (j = 0; j < H.ny_real; j++) {
-      for (i = 0; i < H.nx_real; i++) {
-        id     = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost, zslice, H.nx, H.ny);
-        buf_id = j + i * H.ny_real;
-  #ifdef MHD
-        int id_xm1 = cuda_utilities::compute1DIndex(i + H.n_ghost - 1, j + H.n_ghost, zslice, H.nx, H.ny);
-        int id_ym1 = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost - 1, zslice, H.nx, H.ny);
-        int id_zm1 = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost, zslice - 1, H.nx, H.ny);
-  #endif  // MHD
-  #ifdef MPI_CHOLLA
-        // When there are multiple processes, check whether this slice is in
-        // your domain
-        if (zslice >= nz_local_start && zslice < nz_local_start + nz_local) {
-          id = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost, zslice - nz_local_start + H.n_ghost, H.nx,
-                                              H.ny);
-    #ifdef MHD
-          int id_xm1 = cuda_utilities::compute1DIndex(i + H.n_ghost - 1, j + H.n_ghost,
-                                                      zslice - nz_local_start + H.n_ghost, H.nx, H.ny);
-          int id_ym1 = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost - 1,
-                                                      zslice - nz_local_start + H.n_ghost, H.nx, H.ny);
-          int id_zm1 = cuda_utilities::compute1DIndex(i + H.n_ghost, j + H.n_ghost,
-                                                      zslice - nz_local_start + H.n_ghost - 1, H.nx, H.ny);
-    #endif  // MHD
-  #endif    // MPI_CHOLLA
-          dataset_buffer_d[buf_id]  = C.density[id];
-          dataset_buffer_mx[buf_id] = C.momentum_x[id];
-          dataset_buffer_my[buf_id] = C.momentum_y[id];
-          dataset_buffer_mz[buf_id] = C.momentum_z[id];
-          dataset_buffer_E[buf_id]  = C.Energy[id];
-  #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0.5 * (C.magnetic_x[id] + C.magnetic_x[id_xm1]);
-          dataset_buffer_magnetic_y[buf_id] = 0.5 * (C.magnetic_y[id] + C.magnetic_y[id_ym1]);
-          dataset_buffer_magnetic_z[buf_id] = 0.5 * (C.magnetic_z[id] + C.magnetic_z[id_zm1]);
-  #endif  // MHD
-  #ifdef DE
-          dataset_buffer_GE[buf_id] = C.GasEnergy[id];
-  #endif
-  #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.nx * H.ny] = C.scalar[id + ii * H.n_cells];
-          }
-  #endif
+    struct Plane {
+      int axis;
+      int global_slice;
+      long local_start;
+      int n_local;
+      hsize_t dims[2];
+      const char *suffix;
+    };
+    Plane planes[3] = {
+        {2, zslice, 0, H.nz, {hsize_t(H.nx_real), hsize_t(H.ny_real)}, "_xy"},
+        {1, yslice, 0, H.ny, {hsize_t(H.nx_real), hsize_t(H.nz_real)}, "_xz"},
+        {0, xslice, 0, H.nx, {hsize_t(H.ny_real), hsize_t(H.nz_real)}, "_yz"},
+    };
   #ifdef MPI_CHOLLA
-        }
-        // if the slice isn't in your domain, just write out zeros
-        else {
-          dataset_buffer_d[buf_id]  = 0;
-          dataset_buffer_mx[buf_id] = 0;
-          dataset_buffer_my[buf_id] = 0;
-          dataset_buffer_mz[buf_id] = 0;
-          dataset_buffer_E[buf_id]  = 0;
-    #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0;
-          dataset_buffer_magnetic_y[buf_id] = 0;
-          dataset_buffer_magnetic_z[buf_id] = 0;
-    #endif  // MHD
-    #ifdef DE
-          dataset_buffer_GE[buf_id] = 0;
-    #endif
-    #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.nx * H.ny] = 0;
-          }
-    #endif
-        }
+    planes[0].local_start = nz_local_start;
+    planes[0].n_local     = nz_local;
+    planes[1].local_start = ny_local_start;
+    planes[1].n_local     = ny_local;
+    planes[2].local_start = nx_local_start;
+    planes[2].n_local     = nx_local;
   #endif  // MPI_CHOLLA
-      }
-    }
-
-    // Write out the xy datasets for each variable
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_d, "/d_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mx, "/mx_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_my, "/my_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mz, "/mz_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_E, "/E_xy");
-  #ifdef MHD
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_x.data(), "/magnetic_x_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_y.data(), "/magnetic_y_xy");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_z.data(), "/magnetic_z_xy");
-  #endif  // MHD
-  #ifdef DE
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_GE, "/GE_xy");
-  #endif
-  #ifdef SCALAR
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_scalar, "/scalar_xy");
-  #endif
-    // Free the dataspace id
-    status = H5Sclose(dataspace_id);
-
-    // free the dataset buffers
-    free(dataset_buffer_d);
-    free(dataset_buffer_mx);
-    free(dataset_buffer_my);
-    free(dataset_buffer_mz);
-    free(dataset_buffer_E);
-  #ifdef DE
-    free(dataset_buffer_GE);
-  #endif
-  #ifdef SCALAR
-    free(dataset_buffer_scalar);
-  #endif
-
-    // Create the xz data space for the datasets
-    dims[0]      = nx_dset;
-    dims[1]      = nz_dset;
-    dataspace_id = H5Screate_simple(2, dims, NULL);
-
-    // allocate the memory for the xz slices
-    dataset_buffer_d  = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-    dataset_buffer_mx = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-    dataset_buffer_my = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-    dataset_buffer_mz = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-    dataset_buffer_E  = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-  #ifdef MHD
-    dataset_buffer_magnetic_x.resize(H.nx_real * H.nz_real);
-    dataset_buffer_magnetic_y.resize(H.nx_real * H.nz_real);
-    dataset_buffer_magnetic_z.resize(H.nx_real * H.nz_real);
-  #endif  // MHD
-  #ifdef DE
-    dataset_buffer_GE = (Real *)malloc(H.nx_real * H.nz_real * sizeof(Real));
-  #endif
-  #ifdef SCALAR
-    dataset_buffer_scalar = (Real *)malloc(NSCALARS * H.nx_real * H.nz_real * sizeof(Real));
-  #endif
 
-    // Copy the xz slices to the memory buffers
-    for (k = 0; k < H.nz_real; k++) {
-      for (i = 0; i < H.nx_real; i++) {
-        id     = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice, k + H.n_ghost, H.nx, H.ny);
-        buf_id = k + i * H.nz_real;
-  #ifdef MHD
-        int id_xm1 = cuda_utilities::compute1DIndex(i + H.n_ghost - 1, yslice, k + H.n_ghost, H.nx, H.ny);
-        int id_ym1 = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice - 1, k + H.n_ghost, H.nx, H.ny);
-        int id_zm1 = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice, k + H.n_ghost - 1, H.nx, H.ny);
-  #endif  // MHD
-  #ifdef MPI_CHOLLA
-        // When there are multiple processes, check whether this slice is in
-        // your domain
-        if (yslice >= ny_local_start && yslice < ny_local_start + ny_local) {
-          id = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice - ny_local_start + H.n_ghost, k + H.n_ghost, H.nx,
-                                              H.ny);
-    #ifdef MHD
-          int id_xm1 = cuda_utilities::compute1DIndex(i + H.n_ghost - 1, yslice - ny_local_start + H.n_ghost,
-                                                      k + H.n_ghost, H.nx, H.ny);
-          int id_ym1 = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice - ny_local_start + H.n_ghost - 1,
-                                                      k + H.n_ghost, H.nx, H.ny);
-          int id_zm1 = cuda_utilities::compute1DIndex(i + H.n_ghost, yslice - ny_local_start + H.n_ghost,
-                                                      k + H.n_ghost - 1, H.nx, H.ny);
-    #endif  // MHD
-  #endif    // MPI_CHOLLA
-          dataset_buffer_d[buf_id]  = C.density[id];
-          dataset_buffer_mx[buf_id] = C.momentum_x[id];
-          dataset_buffer_my[buf_id] = C.momentum_y[id];
-          dataset_buffer_mz[buf_id] = C.momentum_z[id];
-          dataset_buffer_E[buf_id]  = C.Energy[id];
-  #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0.5 * (C.magnetic_x[id] + C.magnetic_x[id_xm1]);
-          dataset_buffer_magnetic_y[buf_id] = 0.5 * (C.magnetic_y[id] + C.magnetic_y[id_ym1]);
-          dataset_buffer_magnetic_z[buf_id] = 0.5 * (C.magnetic_z[id] + C.magnetic_z[id_zm1]);
-  #endif  // MHD
-  #ifdef DE
-          dataset_buffer_GE[buf_id] = C.GasEnergy[id];
-  #endif
-  #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.nx * H.nz] = C.scalar[id + ii * H.n_cells];
-          }
-  #endif
+    for (Plane const &plane : planes) {
+      size_t const n_slice = plane.dims[0] * plane.dims[1];
+      // if the slice isn't in your domain, just write out zeros
+      std::vector<Real> slices(Slice_N_Fields() * n_slice, 0);
   #ifdef MPI_CHOLLA
-        }
-        // if the slice isn't in your domain, just write out zeros
-        else {
-          dataset_buffer_d[buf_id]  = 0;
-          dataset_buffer_mx[buf_id] = 0;
-          dataset_buffer_my[buf_id] = 0;
-          dataset_buffer_mz[buf_id] = 0;
-          dataset_buffer_E[buf_id]  = 0;
-    #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0;
-          dataset_buffer_magnetic_y[buf_id] = 0;
-          dataset_buffer_magnetic_z[buf_id] = 0;
-    #endif  // MHD
-    #ifdef DE
-          dataset_buffer_GE[buf_id] = 0;
-    #endif
-    #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.nx * H.nz] = 0;
-          }
-    #endif
-        }
-  #endif  // MPI_CHOLLA
+      // When there are multiple processes, check whether this slice is in
+      // your domain
+      int const slice = plane.global_slice - plane.local_start + H.n_ghost;
+      if (plane.global_slice >= plane.local_start && plane.global_slice < plane.local_start + plane.n_local) {
+        Slice_Grid_GPU(H, C.device, plane.axis, slice, slices.data(), C.d_magnetic_centered);
       }
-    }
-
-    // Write out the xz datasets for each variable
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_d, "/d_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mx, "/mx_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_my, "/my_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mz, "/mz_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_E, "/E_xz");
-  #ifdef MHD
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_x.data(), "/magnetic_x_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_y.data(), "/magnetic_y_xz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_z.data(), "/magnetic_z_xz");
-  #endif  // MHD
-  #ifdef DE
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_GE, "/GE_xz");
-  #endif
-  #ifdef SCALAR
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_scalar, "/scalar_xz");
-  #endif
-
-    // Free the dataspace id
-    status = H5Sclose(dataspace_id);
-
-    // free the dataset buffers
-    free(dataset_buffer_d);
-    free(dataset_buffer_mx);
-    free(dataset_buffer_my);
-    free(dataset_buffer_mz);
-    free(dataset_buffer_E);
-  #ifdef DE
-    free(dataset_buffer_GE);
-  #endif
-  #ifdef SCALAR
-    free(dataset_buffer_scalar);
-  #endif
-
-    // Create the yz data space for the datasets
-    dims[0]      = ny_dset;
-    dims[1]      = nz_dset;
-    dataspace_id = H5Screate_simple(2, dims, NULL);
-
-    // allocate the memory for the yz slices
-    dataset_buffer_d  = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-    dataset_buffer_mx = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-    dataset_buffer_my = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-    dataset_buffer_mz = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-    dataset_buffer_E  = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-  #ifdef MHD
-    dataset_buffer_magnetic_x.resize(H.ny_real * H.nz_real);
-    dataset_buffer_magnetic_y.resize(H.ny_real * H.nz_real);
-    dataset_buffer_magnetic_z.resize(H.ny_real * H.nz_real);
-  #endif  // MHD
-  #ifdef DE
-    dataset_buffer_GE = (Real *)malloc(H.ny_real * H.nz_real * sizeof(Real));
-  #endif
-  #ifdef SCALAR
-    dataset_buffer_scalar = (Real *)malloc(NSCALARS * H.ny_real * H.nz_real * sizeof(Real));
-  #endif
-
-    // Copy the yz slices to the memory buffers
-    for (k = 0; k < H.nz_real; k++) {
-      for (j = 0; j < H.ny_real; j++) {
-        id     = cuda_utilities::compute1DIndex(xslice, j + H.n_ghost, k + H.n_ghost, H.nx, H.ny);
-        buf_id = k + j * H.nz_real;
-  #ifdef MHD
-        int id_xm1 = cuda_utilities::compute1DIndex(xslice - 1, j + H.n_ghost, k + H.n_ghost, H.nx, H.ny);
-        int id_ym1 = cuda_utilities::compute1DIndex(xslice, j + H.n_ghost - 1, k + H.n_ghost, H.nx, H.ny);
-        int id_zm1 = cuda_utilities::compute1DIndex(xslice, j + H.n_ghost, k + H.n_ghost - 1, H.nx, H.ny);
-  #endif  // MHD
-  #ifdef MPI_CHOLLA
-        // When there are multiple processes, check whether this slice is in
-        // your domain
-        if (xslice >= nx_local_start && xslice < nx_local_start + nx_local) {
-          id = cuda_utilities::compute1DIndex(xslice - nx_local_start, j + H.n_ghost, k + H.n_ghost, H.nx, H.ny);
-    #ifdef MHD
-          int id_xm1 =
-              cuda_utilities::compute1DIndex(xslice - nx_local_start - 1, j + H.n_ghost, k + H.n_ghost, H.nx, H.ny);
-          int id_ym1 =
-              cuda_utilities::compute1DIndex(xslice - nx_local_start, j + H.n_ghost - 1, k + H.n_ghost, H.nx, H.ny);
-          int id_zm1 =
-              cuda_utilities::compute1DIndex(xslice - nx_local_start, j + H.n_ghost, k + H.n_ghost - 1, H.nx, H.ny);
-    #endif  // MHD
-  #endif    // MPI_CHOLLA
-          dataset_buffer_d[buf_id]  = C.density[id];
-          dataset_buffer_mx[buf_id] = C.momentum_x[id];
-          dataset_buffer_my[buf_id] = C.momentum_y[id];
-          dataset_buffer_mz[buf_id] = C.momentum_z[id];
-          dataset_buffer_E[buf_id]  = C.Energy[id];
-  #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0.5 * (C.magnetic_x[id] + C.magnetic_x[id_xm1]);
-          dataset_buffer_magnetic_y[buf_id] = 0.5 * (C.magnetic_y[id] + C.magnetic_y[id_ym1]);
-          dataset_buffer_magnetic_z[buf_id] = 0.5 * (C.magnetic_z[id] + C.magnetic_z[id_zm1]);
-  #endif  // MHD
-  #ifdef DE
-          dataset_buffer_GE[buf_id] = C.GasEnergy[id];
-  #endif
-  #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.ny * H.nz] = C.scalar[id + ii * H.n_cells];
-          }
-  #endif
-  #ifdef MPI_CHOLLA
-        }
-        // if the slice isn't in your domain, just write out zeros
-        else {
-          dataset_buffer_d[buf_id]  = 0;
-          dataset_buffer_mx[buf_id] = 0;
-          dataset_buffer_my[buf_id] = 0;
-          dataset_buffer_mz[buf_id] = 0;
-          dataset_buffer_E[buf_id]  = 0;
-    #ifdef MHD
-          dataset_buffer_magnetic_x[buf_id] = 0;
-          dataset_buffer_magnetic_y[buf_id] = 0;
-          dataset_buffer_magnetic_z[buf_id] = 0;
-    #endif  // MHD
-    #ifdef DE
-          dataset_buffer_GE[buf_id] = 0;
-    #endif
-    #ifdef SCALAR
-          for (int ii = 0; ii < NSCALARS; ii++) {
-            dataset_buffer_scalar[buf_id + ii * H.ny * H.nz] = 0;
-          }
-    #endif
-        }
+  #else
+      Slice_Grid_GPU(H, C.device, plane.axis, plane.global_slice, slices.data(), C.d_magnetic_centered);
   #endif  // MPI_CHOLLA
+      Scale_Output_Maps(slices.data(), n_slice, scales);
+
+      // Write out the datasets for each variable
+      dataspace_id = H5Screate_simple(2, plane.dims, NULL);
+      for (size_t field = 0; field < names.size(); field++) {
+        std::string const name = names[field] + plane.suffix;
+        status = Write_HDF5_Dataset(file_id, dataspace_id, slices.data() + field * n_slice, name.c_str());
       }
+      // Free the dataspace id
+      status = H5Sclose(dataspace_id);
     }
-
-    // Write out the yz datasets for each variable
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_d, "/d_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mx, "/mx_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_my, "/my_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_mz, "/mz_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_E, "/E_yz");
-  #ifdef MHD
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_x.data(), "/magnetic_x_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_y.data(), "/magnetic_y_yz");
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_magnetic_z.data(), "/magnetic_z_yz");
-  #endif  // MHD
-  #ifdef DE
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_GE, "/GE_yz");
-  #endif
-  #ifdef SCALAR
-    status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer_scalar, "/scalar_yz");
-  #endif
-
-    // Free the dataspace id
-    status = H5Sclose(dataspace_id);
-
-    // free the dataset buffers
-    free(dataset_buffer_d);
-    free(dataset_buffer_mx);
-    free(dataset_buffer_my);
-    free(dataset_buffer_mz);
-    free(dataset_buffer_E);
-  #ifdef DE
-    free(dataset_buffer_GE);
-  #endif
-  #ifdef SCALAR
-    free(dataset_buffer_scalar);
-  #endif
-
   } else {
     printf("Slice write only works for 3D data.\n");
   }
@@ -2827,6 +3235,13 @@ std::string FnameTemplate::format_fname(int nfile, int file_proc_id,
   return path_prefix + std::to_string(nfile) + pre_extension_suffix + extension + procID_part;
 }
 
+std::string FnameTemplate::format_cat_fname(int nfile, const std::string &pre_extension_suffix) const noexcept
+{
+  // the same path without the process id part
+  const std::string fname = format_fname(nfile, 0, pre_extension_suffix);
+  return fname.substr(0, fname.rfind('.'));
+}
+
 void Ensure_Dir_Exists(std::string dir_path)
 {
   if (Is_Root_Proc()) {
@@ -16,6 +16,9 @@ void Output_Data(Grid3D& G, struct Parameters P, int nfile);
 /* Output the grid data to file as 32-bit floats. */
 void Output_Float32(Grid3D& G, struct Parameters P, int nfile);
 
+/* Output the grid data averaged over cubes of out_coarse_factor^3 cells. */
+void Output_Coarse(Grid3D& G, struct Parameters P, int nfile);
+
 /* Output a projection of the grid data to file. */
 void Output_Projected_Data(Grid3D& G, struct Parameters P, int nfile);
 
@@ -25,6 +28,87 @@ void Output_Rotated_Projected_Data(Grid3D& G, struct Parameters P, int nfile);
 /* Output xy, xz, and yz slices of the grid data to file. */
 void Output_Slices(Grid3D& G, struct Parameters P, int nfile);
 
+#ifdef POWER_SPECTRUM
+/* Output the power spectra of the gas density and of the CIC density of the
+ * dark matter to a single file. */
+void Output_Power_Spectrum(Grid3D& G, struct Parameters P, int nfile);
+#endif  // POWER_SPECTRUM
+
+#ifdef HALO_FINDER
+/* Output the catalog of the friends-of-friends halos of the particles to a
+ * single file, and with fof_output_members their particles to a file per
+ * process. */
+void Output_Halo_Catalog(Grid3D& G, struct Parameters P, int nfile);
+#endif  // HALO_FINDER
+
+#ifdef HDF5
+/* Create the HDF5 output file of snapshot nfile. With ASYNC_OUTPUT the file is
+ * built in memory, with size_hint bytes reserved for it. */
+hid_t Create_Output_File_HDF5(std::string const& filename, size_t size_hint);
+
+/* Close a file of Create_Output_File_HDF5. With ASYNC_OUTPUT the image of the
+ * file is queued for the I/O thread, which writes it while the simulation
+ * continues. */
+herr_t Close_Output_File_HDF5(hid_t file_id, std::string const& filename, int nfile);
+#endif  // HDF5
+
+#ifdef HDF5
+// From io/io_compression.cpp
+
+/* Parse the per field compression of the output_compression and
+ * out_float32_compression parameters. */
+void Init_Output_Compression(struct Parameters const& P);
+
+/* Select the compression of the float32 files or of the other outputs for the
+ * datasets written next. */
+void Use_Output_Compression(bool float32);
+
+/* Add the filter of the field name to the dataset creation property list
+ * dcpl_id, and chunk the dataset of dims if dcpl_id isn't chunked yet. Returns
+ * false if the field isn't compressed. */
+bool Set_Output_Compression_HDF5(hid_t dcpl_id, const char* name, hid_t file_type, int rank, hsize_t const* dims);
+#endif  // HDF5
+
+#if defined(HDF5) && defined(MPI_CHOLLA)
+// From io/io_parallel.cpp
+
+/* Output the grid data of all the ranks to a single file with collective
+ * parallel HDF5. */
+void Output_Data_Cat(Grid3D& G, struct Parameters P, int nfile);
+
+/* Create the single file filename with collective parallel HDF5 and direct the
+ * datasets of Write_HDF5_Dataset to the blocks of the ranks until
+ * Close_Output_File_Cat. */
+hid_t Open_Output_File_Cat(Grid3D& G, struct Parameters P, std::string const& filename);
+
+/* Close the single file of Open_Output_File_Cat. */
+void Close_Output_File_Cat(hid_t file_id, std::string const& filename);
+
+/* Whether a single file of Open_Output_File_Cat is open, the datasets are then
+ * written by Write_HDF5_Dataset_Cat. */
+bool Output_Cat_Active();
+
+/* Write the local block of a dataset of the file of Open_Output_File_Cat. */
+herr_t Write_HDF5_Dataset_Cat(hid_t file_id, hid_t dataspace_id, const void* dataset_buffer, hid_t file_type,
+                              hid_t mem_type, const char* name);
+#endif  // HDF5 and MPI_CHOLLA
+
+#ifdef ASYNC_OUTPUT
+  #ifndef HDF5
+    #error "ASYNC_OUTPUT requires HDF5 outputs"
+  #endif
+/* Block until the output files queued by Close_Output_File_HDF5 are written. */
+void Wait_Async_Output();
+#endif  // ASYNC_OUTPUT
+
+/* Block until the restart files of the checkpoint_dir tier are drained to the
+ * output directory. */
+void Wait_Checkpoint_Drain();
+
+/* Point the indir of an init=Read_Grid restart to the checkpoint_dir tier if
+ * every rank still has a complete local copy of checkpoint nfile there. */
+void Use_Local_Checkpoint(Parameters* P);
+
 /* MPI-safe printf routine */
 int chprintf(const char* __restrict sdata, ...);
 
@@ -101,6 +185,9 @@ class FnameTemplate
 
   std::string format_fname(int nfile, int file_proc_id, const std::string& pre_extension_suffix) const noexcept;
 
+  /* format the path of the single file that all the processes write together */
+  std::string format_cat_fname(int nfile, const std::string& pre_extension_suffix) const noexcept;
+
  private:
   bool separate_cycle_dirs_;
   std::string outdir_;
@@ -129,10 +216,93 @@ void Fill_Grid_From_HDF5_Buffer(int nx, int ny, int nz, int nx_real, int ny_real
                                 Real* hdf5_buffer, Real* grid_buffer);
 
 // From io/io_gpu.cu
-// Use GPU to pack source -> device_buffer, then copy device_buffer -> buffer,
-// then write HDF5 field
-void Write_HDF5_Field_3D(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost, hid_t file_id,
-                         float* buffer, float* device_buffer, Real* source, const char* name, int mhd_direction = -1);
-void Write_HDF5_Field_3D(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost, hid_t file_id,
-                         double* buffer, double* device_buffer, Real* source, const char* name, int mhd_direction = -1);
+
+/*! \struct HDF5_Field_Pack
+ *  \brief The 3D device fields of an output, which Write_HDF5_Fields_3D packs
+ *  into one host buffer with a single kernel launch. Each field has its own
+ *  dataset dims and ghost cells, so the magnetic fields can be packed with the
+ *  cell centered fields. */
+struct HDF5_Field_Pack {
+  static constexpr int max_fields = 16;
+
+  int n_fields = 0;
+  Real* source[max_fields];
+  const char* name[max_fields];
+  int nx[max_fields];
+  int ny[max_fields];
+  int nx_real[max_fields];
+  int ny_real[max_fields];
+  int nz_real[max_fields];
+  int n_ghost[max_fields];
+  int mhd_direction[max_fields];
+  /// The factor each field is multiplied by as it is packed
+  Real scale[max_fields];
+  /// Where each field starts in the packed buffer
+  size_t offset[max_fields];
+  /// The total size of the packed buffer
+  size_t n_cells = 0;
+
+  /* Add the nx_dset*ny_dset*nz_dset real cells of a device field with x and y
+   * dims nx_source and ny_source to the pack. mhd_dir shifts the copy by one
+   * cell for the face centered magnetic fields, and field_scale converts the
+   * field to the units of the output */
+  void Add(Real* device_source, const char* dataset_name, int nx_source, int ny_source, int nx_dset, int ny_dset,
+           int nz_dset, int n_ghost_dset, int mhd_dir = -1, Real field_scale = 1);
+};
+
+/* Strip the ghost cells of every field of pack and convert them to T in one
+ * kernel launch that writes into a pinned host buffer, then write each field
+ * to its dataset of file_id. */
+template <typename T>
+herr_t Write_HDF5_Fields_3D(hid_t file_id, HDF5_Field_Pack const& pack);
+
+/* Sum the real cells of every field of pack, which all have the geometry of
+ * the grid, over the coarse cells of factor^3 cells that they fall in. offset
+ * is the position of the first real cell in its coarse cell in each direction
+ * and n_coarse the number of coarse cells that the real cells touch. sums gets
+ * an HDF5 ordered block of coarse cells per field. */
+void Coarsen_Grid_GPU(HDF5_Field_Pack const& pack, int factor, int const offset[3], int const n_coarse[3], Real* sums);
+
+/* Project the density, the density weighted temperature and the dust density
+ * of the real cells along z (axis 2) or y (axis 1) on the device. projections
+ * gets the three HDF5 ordered xy or xz maps one after the other. With MHD the
+ * cell centered fields are read from dev_magnetic_centered unless it is null. */
+void Project_Grid_GPU(Header const& H, Real const* dev_conserved, Real gamma, int axis, Real* projections,
+                      Real const* dev_magnetic_centered = nullptr);
+
+/* Compute the rotated projection of R on the device like
+ * Write_Rotated_Projection_HDF5. projections gets the density, temperature
+ * and x, y and z momentum maps of nx_dset*nz_dset pixels one after the other. */
+void Project_Rotated_Grid_GPU(Header const& H, Rotation const& R, Real const* dev_conserved, Real gamma, int nx_dset,
+                              int nz_dset, Real* projections, Real const* dev_magnetic_centered = nullptr);
+
+/* The fields of a plane of Slice_Grid_GPU: density, momentum, Energy, the
+ * cell centered magnetic fields, GasEnergy and the scalars. */
+constexpr int Slice_N_Fields()
+{
+  int n_fields = 5;
+  #ifdef MHD
+  n_fields += 3;
+  #endif  // MHD
+  #ifdef DE
+  n_fields += 1;
+  #endif  // DE
+  #ifdef SCALAR
+  n_fields += NSCALARS;
+  #endif  // SCALAR
+  return n_fields;
+}
+
+/* Copy the plane normal to axis (0 for yz, 1 for xz, 2 for xy) at the local
+ * index slice, ghost cells included, of the Slice_N_Fields() fields into
+ * consecutive HDF5 ordered blocks of slices. Only the plane is copied to the
+ * host. The cell centered magnetic fields are read from dev_magnetic_centered
+ * unless it is null. */
+void Slice_Grid_GPU(Header const& H, Real const* dev_conserved, int axis, int slice, Real* slices,
+                    Real const* dev_magnetic_centered = nullptr);
+
+/* Unpack the 3D HDF5 ordered device buffer of nx_real*ny_real*nz_real cells
+ * into the real cells of a device grid field. */
+void Fill_Grid_From_HDF5_Buffer_GPU(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
+                                    Real* device_hdf5_buffer, Real* device_grid_buffer, int mhd_direction = -1);
 #endif
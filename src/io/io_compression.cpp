@@ -0,0 +1,171 @@
+// Chunking and compression filters of the HDF5 output datasets, chosen per
+// field with the output_compression and out_float32_compression parameters
+#include "../global/global.h"
+#include "../io/io.h"
+#include "../utils/error_handling.h"
+
+#ifdef HDF5
+  #include <hdf5.h>
+
+  #include <algorithm>
+  #include <cstdlib>
+  #include <cstring>
+  #include <map>
+  #include <sstream>
+  #include <string>
+
+// Filter ids registered with the HDF Group for the zstd and ZFP plugins, which
+// HDF5 loads from HDF5_PLUGIN_PATH
+  #define H5Z_FILTER_ZSTD_ID 32015
+  #define H5Z_FILTER_ZFP_ID  32013
+// Fixed accuracy mode of H5Z-ZFP
+  #define H5Z_ZFP_MODE_ACCURACY 3
+
+// The largest chunk of a compressed dataset, in bytes
+  #define COMPRESSION_CHUNK_BYTES (size_t(1) << 22)
+
+enum class Codec { none, deflate, zstd, zfp };
+
+struct FieldCompression {
+  Codec codec = Codec::none;
+  // Compression level of deflate and zstd
+  int level = 0;
+  // Absolute error bound of zfp
+  double accuracy = 0;
+};
+
+// The compression of each field of the snapshots and of the float32 files, the
+// "*" entry applies to the fields that aren't listed
+static std::map<std::string, FieldCompression> compression_specs[2];
+static int active_spec = 0;
+
+static void Check_Filter_Available(H5Z_filter_t filter, const char *codec)
+{
+  if (H5Zfilter_avail(filter) <= 0) {
+    CHOLLA_ERROR("The %s HDF5 filter is not available, check HDF5_PLUGIN_PATH", codec);
+  }
+}
+
+// Parse a list of field:codec[:value] entries separated by commas, where value
+// is the level of deflate and zstd and the absolute error bound of zfp
+static std::map<std::string, FieldCompression> Parse_Compression(const char *parameter, const char *spec)
+{
+  std::map<std::string, FieldCompression> fields;
+  std::stringstream entries(spec);
+  std::string entry;
+  while (std::getline(entries, entry, ',')) {
+    if (entry.empty()) {
+      continue;
+    }
+    std::stringstream tokens(entry);
+    std::string field, codec, value;
+    std::getline(tokens, field, ':');
+    std::getline(tokens, codec, ':');
+    std::getline(tokens, value, ':');
+
+    FieldCompression compression;
+    if (codec == "none") {
+      compression.codec = Codec::none;
+    } else if (codec == "deflate") {
+      compression.codec = Codec::deflate;
+      compression.level = value.empty() ? 4 : std::atoi(value.c_str());
+      Check_Filter_Available(H5Z_FILTER_DEFLATE, "deflate");
+    } else if (codec == "zstd") {
+      compression.codec = Codec::zstd;
+      compression.level = value.empty() ? 3 : std::atoi(value.c_str());
+      Check_Filter_Available(H5Z_FILTER_ZSTD_ID, "zstd");
+    } else if (codec == "zfp") {
+      compression.codec    = Codec::zfp;
+      compression.accuracy = std::atof(value.c_str());
+      if (compression.accuracy <= 0) {
+        CHOLLA_ERROR("%s: the zfp compression of %s needs a positive error bound, e.g. %s:zfp:1e-6", parameter,
+                     field.c_str(), field.c_str());
+      }
+      Check_Filter_Available(H5Z_FILTER_ZFP_ID, "zfp");
+    } else {
+      CHOLLA_ERROR("%s: unknown codec \"%s\" for %s, use none, deflate, zstd or zfp", parameter, codec.c_str(),
+                   field.c_str());
+    }
+    int const max_level = compression.codec == Codec::deflate ? 9 : 22;
+    if (compression.codec != Codec::zfp && (compression.level < 0 || compression.level > max_level)) {
+      CHOLLA_ERROR("%s: invalid compression level %s for %s", parameter, value.c_str(), field.c_str());
+    }
+    fields[field] = compression;
+  }
+  return fields;
+}
+
+void Init_Output_Compression(struct Parameters const &P)
+{
+  compression_specs[0] = Parse_Compression("output_compression", P.output_compression);
+  compression_specs[1] = Parse_Compression("out_float32_compression", P.out_float32_compression);
+}
+
+void Use_Output_Compression(bool float32) { active_spec = float32 ? 1 : 0; }
+
+bool Set_Output_Compression_HDF5(hid_t dcpl_id, const char *name, hid_t file_type, int rank, hsize_t const *dims)
+{
+  std::map<std::string, FieldCompression> const &fields = compression_specs[active_spec];
+  if (fields.empty()) {
+    return false;
+  }
+
+  // Dataset names are absolute paths
+  std::string field(name);
+  if (!field.empty() && field[0] == '/') {
+    field.erase(0, 1);
+  }
+  auto spec = fields.find(field);
+  if (spec == fields.end()) {
+    spec = fields.find("*");
+  }
+  if (spec == fields.end() || spec->second.codec == Codec::none) {
+    return false;
+  }
+  FieldCompression const &compression = spec->second;
+
+  // Filters need a chunked layout. Unless the caller chose the chunks, split
+  // the dataset along its slowest dimensions until a chunk is small enough
+  if (H5Pget_layout(dcpl_id) != H5D_CHUNKED) {
+    hsize_t chunk[3];
+    size_t chunk_bytes = H5Tget_size(file_type);
+    for (int d = 0; d < rank; d++) {
+      chunk[d] = std::max(dims[d], hsize_t(1));
+      chunk_bytes *= chunk[d];
+    }
+    for (int d = 0; d < rank && chunk_bytes > COMPRESSION_CHUNK_BYTES; d++) {
+      while (chunk[d] > 1 && chunk_bytes > COMPRESSION_CHUNK_BYTES) {
+        chunk_bytes /= chunk[d];
+        chunk[d] = (chunk[d] + 1) / 2;
+        chunk_bytes *= chunk[d];
+      }
+    }
+    H5Pset_chunk(dcpl_id, rank, chunk);
+  }
+
+  switch (compression.codec) {
+    case Codec::deflate:
+      H5Pset_shuffle(dcpl_id);
+      H5Pset_deflate(dcpl_id, compression.level);
+      break;
+    case Codec::zstd: {
+      unsigned int const cd_values[1] = {unsigned(compression.level)};
+      H5Pset_shuffle(dcpl_id);
+      H5Pset_filter(dcpl_id, H5Z_FILTER_ZSTD_ID, H5Z_FLAG_MANDATORY, 1, cd_values);
+      break;
+    }
+    case Codec::zfp: {
+      // H5Z-ZFP takes the mode and the error bound as a double in the last two
+      // values
+      unsigned int cd_values[4] = {H5Z_ZFP_MODE_ACCURACY, 0, 0, 0};
+      std::memcpy(&cd_values[2], &compression.accuracy, sizeof(double));
+      H5Pset_filter(dcpl_id, H5Z_FILTER_ZFP_ID, H5Z_FLAG_MANDATORY, 4, cd_values);
+      break;
+    }
+    case Codec::none:
+      break;
+  }
+  return true;
+}
+
+#endif  // HDF5
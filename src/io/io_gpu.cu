@@ -3,9 +3,20 @@
 
   #include <hdf5.h>
 
+  #include <algorithm>
+
   #include "../grid/grid3D.h"
+  #include "../grid/grid_enum.h"
   #include "../io/io.h"
+  #include "../utils/DeviceVector.h"
   #include "../utils/cuda_utilities.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/hydro_utilities.h"
+  #include "../utils/mhd_utilities.h"
+
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
 
 // Note that the HDF5 file and buffer will have size nx_real * ny_real * nz_real
 // whereas the conserved variables have size nx,ny,nz.
@@ -20,7 +31,7 @@
 // 2D version of CopyReal3D_GPU_Kernel. Note that magnetic fields and float32 output are not enabled in 2-D so this is a
 // simpler kernel
 __global__ void CopyReal2D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                      Real* destination, Real* source)
+                                      Real* destination, Real* source, Real scale)
 {
   int const id = threadIdx.x + blockIdx.x * blockDim.x;
 
@@ -37,13 +48,13 @@ __global__ void CopyReal2D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real,
   int const dest_id   = j + i * ny_real;
   int const source_id = (i + n_ghost) + (j + n_ghost) * nx;
 
-  destination[dest_id] = source[source_id];
+  destination[dest_id] = scale * source[source_id];
 }
 
 // Copy Real (non-ghost) cells from source to a double destination (for writing
 // HDF5 in double precision)
 __global__ void CopyReal3D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                      double* destination, Real* source, int mhd_direction)
+                                      double* destination, Real* source, int mhd_direction, Real scale)
 {
   int const id = threadIdx.x + blockIdx.x * blockDim.x;
 
@@ -59,13 +70,13 @@ __global__ void CopyReal3D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real,
   int const source_id = (i + n_ghost - int(mhd_direction == 0)) + (j + n_ghost - int(mhd_direction == 1)) * nx +
                         (k + n_ghost - int(mhd_direction == 2)) * nx * ny;
 
-  destination[dest_id] = (double)source[source_id];
+  destination[dest_id] = (double)(scale * source[source_id]);
 }
 
 // Copy Real (non-ghost) cells from source to a float destination (for writing
 // HDF5 in float precision)
 __global__ void CopyReal3D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                      float* destination, Real* source, int mhd_direction)
+                                      float* destination, Real* source, int mhd_direction, Real scale)
 {
   int const id = threadIdx.x + blockIdx.x * blockDim.x;
 
@@ -83,69 +94,176 @@ __global__ void CopyReal3D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real,
   int const source_id = (i + n_ghost - int(mhd_direction == 0)) + (j + n_ghost - int(mhd_direction == 1)) * nx +
                         (k + n_ghost - int(mhd_direction == 2)) * nx * ny;
 
-  destination[dest_id] = (float)source[source_id];
+  destination[dest_id] = (float)(scale * source[source_id]);
 }
 
-// When buffer is double, automatically use the double version of everything
-// using function overloading
-void Write_HDF5_Field_3D(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost, hid_t file_id,
-                         double* buffer, double* device_buffer, Real* device_source, const char* name,
-                         int mhd_direction)
+// Copy the real cells of every field of pack into its block of destination,
+// converting them to T. blockIdx.y is the field, so a single launch packs all
+// the fields of an output
+template <typename T>
+__global__ void PackReal3D_GPU_Kernel(HDF5_Field_Pack pack, T* destination)
 {
-  herr_t status;
-  hsize_t dims[3];
-  dims[0]            = nx_real;
-  dims[1]            = ny_real;
-  dims[2]            = nz_real;
-  hid_t dataspace_id = H5Screate_simple(3, dims, NULL);
+  int const field   = blockIdx.y;
+  int const nx      = pack.nx[field];
+  int const ny      = pack.ny[field];
+  int const nx_real = pack.nx_real[field];
+  int const ny_real = pack.ny_real[field];
+  int const nz_real = pack.nz_real[field];
+  int const n_ghost = pack.n_ghost[field];
 
-  // Copy non-ghost parts of source to buffer
-  dim3 dim1dGrid((nx_real * ny_real * nz_real + TPB - 1) / TPB, 1, 1);
-  dim3 dim1dBlock(TPB, 1, 1);
-  hipLaunchKernelGGL(CopyReal3D_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, nx, ny, nx_real, ny_real, nz_real, n_ghost,
-                     device_buffer, device_source, mhd_direction);
-  GPU_Error_Check(
-      cudaMemcpy(buffer, device_buffer, nx_real * ny_real * nz_real * sizeof(double), cudaMemcpyDeviceToHost));
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
 
-  // Write Buffer to HDF5
-  status = Write_HDF5_Dataset(file_id, dataspace_id, buffer, name);
+  int i, j, k;
+  cuda_utilities::compute3DIndices(id, nx_real, ny_real, i, j, k);
 
-  status = H5Sclose(dataspace_id);
-  if (status < 0) {
-    printf("File write failed.\n");
+  if (k >= nz_real) {
+    return;
   }
+
+  // This converts into HDF5 indexing that plays well with Python.
+  // The `int(mhd_direction == NUM)` sections provide appropriate shifts for writing out the magnetic fields since they
+  // need an extra cell in the same direction as the field
+  int const mhd_direction = pack.mhd_direction[field];
+  int const dest_id       = k + j * nz_real + i * ny_real * nz_real;
+  int const source_id     = (i + n_ghost - int(mhd_direction == 0)) + (j + n_ghost - int(mhd_direction == 1)) * nx +
+                            (k + n_ghost - int(mhd_direction == 2)) * nx * ny;
+
+  destination[pack.offset[field] + dest_id] = (T)(pack.scale[field] * pack.source[field][source_id]);
 }
 
-// When buffer is float, automatically use the float version of everything using
-// function overloading
-void Write_HDF5_Field_3D(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost, hid_t file_id,
-                         float* buffer, float* device_buffer, Real* device_source, const char* name, int mhd_direction)
+void HDF5_Field_Pack::Add(Real* device_source, const char* dataset_name, int nx_source, int ny_source, int nx_dset,
+                          int ny_dset, int nz_dset, int n_ghost_dset, int mhd_dir, Real field_scale)
 {
-  herr_t status;
-  hsize_t dims[3];
-  dims[0]            = nx_real;
-  dims[1]            = ny_real;
-  dims[2]            = nz_real;
-  hid_t dataspace_id = H5Screate_simple(3, dims, NULL);
+  if (n_fields == max_fields) {
+    CHOLLA_ERROR("Can't pack more than %d fields for the output, %s doesn't fit", max_fields, dataset_name);
+  }
+  source[n_fields]        = device_source;
+  name[n_fields]          = dataset_name;
+  nx[n_fields]            = nx_source;
+  ny[n_fields]            = ny_source;
+  nx_real[n_fields]       = nx_dset;
+  ny_real[n_fields]       = ny_dset;
+  nz_real[n_fields]       = nz_dset;
+  n_ghost[n_fields]       = n_ghost_dset;
+  mhd_direction[n_fields] = mhd_dir;
+  scale[n_fields]         = field_scale;
+  offset[n_fields]        = n_cells;
+  n_cells += size_t(nx_dset) * ny_dset * nz_dset;
+  n_fields++;
+}
 
-  // Copy non-ghost parts of source to buffer
-  dim3 dim1dGrid((nx_real * ny_real * nz_real + TPB - 1) / TPB, 1, 1);
+// Mapped pinned host memory that the packing kernel writes into directly, so
+// the fields reach the host without a device buffer of the size of the pack
+// and without a separate copy. It grows to the largest pack and is reused by
+// every output
+template <typename T>
+class Mapped_Host_Buffer
+{
+ public:
+  ~Mapped_Host_Buffer()
+  {
+    if (host_ != nullptr) {
+      cudaFreeHost(host_);
+    }
+  }
+
+  void Reserve(size_t size)
+  {
+    if (size <= size_) {
+      return;
+    }
+    if (host_ != nullptr) {
+      GPU_Error_Check(cudaFreeHost(host_));
+    }
+    GPU_Error_Check(cudaHostAlloc((void**)&host_, size * sizeof(T), cudaHostAllocMapped));
+    GPU_Error_Check(cudaHostGetDevicePointer((void**)&device_, host_, 0));
+    size_ = size;
+  }
+
+  T* host() { return host_; }
+  T* device() { return device_; }
+
+ private:
+  T* host_     = nullptr;
+  T* device_   = nullptr;
+  size_t size_ = 0;
+};
+
+template <typename T>
+herr_t Write_HDF5_Fields_3D(hid_t file_id, HDF5_Field_Pack const& pack)
+{
+  herr_t status = 0;
+  if (pack.n_fields == 0) {
+    return status;
+  }
+
+  Mapped_Host_Buffer<T> static buffer;
+  buffer.Reserve(pack.n_cells);
+
+  // Strip the ghost cells of all the fields with one launch, sized for the
+  // largest field
+  int max_cells = 0;
+  for (int field = 0; field < pack.n_fields; field++) {
+    max_cells = std::max(max_cells, pack.nx_real[field] * pack.ny_real[field] * pack.nz_real[field]);
+  }
+  dim3 dim2dGrid((max_cells + TPB - 1) / TPB, pack.n_fields, 1);
   dim3 dim1dBlock(TPB, 1, 1);
-  hipLaunchKernelGGL(CopyReal3D_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, nx, ny, nx_real, ny_real, nz_real, n_ghost,
-                     device_buffer, device_source, mhd_direction);
-  GPU_Error_Check(
-      cudaMemcpy(buffer, device_buffer, nx_real * ny_real * nz_real * sizeof(float), cudaMemcpyDeviceToHost));
+  hipLaunchKernelGGL(PackReal3D_GPU_Kernel<T>, dim2dGrid, dim1dBlock, 0, 0, pack, buffer.device());
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  // Write each field from its block of the buffer
+  for (int field = 0; field < pack.n_fields; field++) {
+    hsize_t dims[3];
+    dims[0]            = pack.nx_real[field];
+    dims[1]            = pack.ny_real[field];
+    dims[2]            = pack.nz_real[field];
+    hid_t dataspace_id = H5Screate_simple(3, dims, NULL);
 
-  // Write Buffer to HDF5
-  status = Write_HDF5_Dataset(file_id, dataspace_id, buffer, name);
+    status = Write_HDF5_Dataset(file_id, dataspace_id, buffer.host() + pack.offset[field], pack.name[field]);
 
-  status = H5Sclose(dataspace_id);
-  if (status < 0) {
-    printf("File write failed.\n");
+    if (H5Sclose(dataspace_id) < 0 || status < 0) {
+      printf("File write failed.\n");
+      status = -1;
+    }
   }
+  return status;
 }
+template herr_t Write_HDF5_Fields_3D<double>(hid_t file_id, HDF5_Field_Pack const& pack);
+template herr_t Write_HDF5_Fields_3D<float>(hid_t file_id, HDF5_Field_Pack const& pack);
+
+// Copy an HDF5 ordered block into the real cells of a grid field, the inverse
+// of CopyReal3D_GPU_Kernel
+__global__ void FillReal3D_GPU_Kernel(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
+                                      Real* destination, Real* source, int mhd_direction)
+{
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+
+  int i, j, k;
+  cuda_utilities::compute3DIndices(id, nx_real, ny_real, i, j, k);
+
+  if (k >= nz_real) {
+    return;
+  }
+
+  int const source_id = k + j * nz_real + i * ny_real * nz_real;
+  int const dest_id   = (i + n_ghost - int(mhd_direction == 0)) + (j + n_ghost - int(mhd_direction == 1)) * nx +
+                        (k + n_ghost - int(mhd_direction == 2)) * nx * ny;
+
+  destination[dest_id] = source[source_id];
+}
+
+void Fill_Grid_From_HDF5_Buffer_GPU(int nx, int ny, int nx_real, int ny_real, int nz_real, int n_ghost,
+                                    Real* device_hdf5_buffer, Real* device_grid_buffer, int mhd_direction)
+{
+  dim3 dim1dGrid((nx_real * ny_real * nz_real + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(FillReal3D_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, nx, ny, nx_real, ny_real, nz_real, n_ghost,
+                     device_grid_buffer, device_hdf5_buffer, mhd_direction);
+  GPU_Error_Check();
+}
+
 void Fill_HDF5_Buffer_From_Grid_GPU(int nx, int ny, int nz, int nx_real, int ny_real, int nz_real, int n_ghost,
-                                    Real* hdf5_buffer, Real* device_hdf5_buffer, Real* device_grid_buffer)
+                                    Real* hdf5_buffer, Real* device_hdf5_buffer, Real* device_grid_buffer, Real scale)
 {
   int mhd_direction = -1;
 
@@ -154,7 +272,7 @@ void Fill_HDF5_Buffer_From_Grid_GPU(int nx, int ny, int nz, int nx_real, int ny_
     dim3 dim1dGrid((nx_real * ny_real * nz_real + TPB - 1) / TPB, 1, 1);
     dim3 dim1dBlock(TPB, 1, 1);
     hipLaunchKernelGGL(CopyReal3D_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, nx, ny, nx_real, ny_real, nz_real, n_ghost,
-                       device_hdf5_buffer, device_grid_buffer, mhd_direction);
+                       device_hdf5_buffer, device_grid_buffer, mhd_direction, scale);
     GPU_Error_Check(cudaMemcpy(hdf5_buffer, device_hdf5_buffer, nx_real * ny_real * nz_real * sizeof(Real),
                                cudaMemcpyDeviceToHost));
     return;
@@ -165,7 +283,7 @@ void Fill_HDF5_Buffer_From_Grid_GPU(int nx, int ny, int nz, int nx_real, int ny_
     dim3 dim1dGrid((nx_real * ny_real + TPB - 1) / TPB, 1, 1);
     dim3 dim1dBlock(TPB, 1, 1);
     hipLaunchKernelGGL(CopyReal2D_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, nx, ny, nx_real, ny_real, nz_real, n_ghost,
-                       device_hdf5_buffer, device_grid_buffer);
+                       device_hdf5_buffer, device_grid_buffer, scale);
     GPU_Error_Check(
         cudaMemcpy(hdf5_buffer, device_hdf5_buffer, nx_real * ny_real * sizeof(Real), cudaMemcpyDeviceToHost));
     return;
@@ -175,8 +293,319 @@ void Fill_HDF5_Buffer_From_Grid_GPU(int nx, int ny, int nz, int nx_real, int ny_
   if (nx > 1 && ny == 1 && nz == 1) {
     GPU_Error_Check(
         cudaMemcpy(hdf5_buffer, device_grid_buffer + n_ghost, nx_real * sizeof(Real), cudaMemcpyDeviceToHost));
+    for (int i = 0; i < nx_real; i++) {
+      hdf5_buffer[i] *= scale;
+    }
+    return;
+  }
+}
+
+// Sum the real cells of every field of pack over its coarse cells of
+// factor^3 cells. blockIdx.y is the field, and the coarse cells at the edges of
+// the local grid only get the real cells that fall in them
+__global__ void Coarsen_GPU_Kernel(HDF5_Field_Pack pack, int factor, int offset_x, int offset_y, int offset_z,
+                                   int ncx, int ncy, int ncz, Real* sums)
+{
+  int const field   = blockIdx.y;
+  int const nx      = pack.nx[field];
+  int const ny      = pack.ny[field];
+  int const nx_real = pack.nx_real[field];
+  int const ny_real = pack.ny_real[field];
+  int const nz_real = pack.nz_real[field];
+  int const n_ghost = pack.n_ghost[field];
+
+  int const id = threadIdx.x + blockIdx.x * blockDim.x;
+
+  int ci, cj, ck;
+  cuda_utilities::compute3DIndices(id, ncx, ncy, ci, cj, ck);
+  if (ck >= ncz) {
+    return;
+  }
+
+  int const i_start = max(ci * factor - offset_x, 0);
+  int const j_start = max(cj * factor - offset_y, 0);
+  int const k_start = max(ck * factor - offset_z, 0);
+  int const i_end   = min((ci + 1) * factor - offset_x, nx_real);
+  int const j_end   = min((cj + 1) * factor - offset_y, ny_real);
+  int const k_end   = min((ck + 1) * factor - offset_z, nz_real);
+
+  Real const* source = pack.source[field];
+  Real sum           = 0;
+  for (int k = k_start; k < k_end; k++) {
+    for (int j = j_start; j < j_end; j++) {
+      for (int i = i_start; i < i_end; i++) {
+        sum += source[cuda_utilities::compute1DIndex(i + n_ghost, j + n_ghost, k + n_ghost, nx, ny)];
+      }
+    }
+  }
+
+  // HDF5 ordering, like the other outputs
+  size_t const n_coarse = size_t(ncx) * ncy * ncz;
+  sums[field * n_coarse + ck + ncz * (cj + ncy * ci)] = pack.scale[field] * sum;
+}
+
+void Coarsen_Grid_GPU(HDF5_Field_Pack const& pack, int factor, int const offset[3], int const n_coarse[3], Real* sums)
+{
+  size_t const n_cells = size_t(n_coarse[0]) * n_coarse[1] * n_coarse[2];
+  cuda_utilities::DeviceVector<Real> device_sums{pack.n_fields * n_cells};
+
+  dim3 dim1dGrid((n_cells + TPB - 1) / TPB, pack.n_fields, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Coarsen_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, pack, factor, offset[0], offset[1], offset[2],
+                     n_coarse[0], n_coarse[1], n_coarse[2], device_sums.data());
+  GPU_Error_Check();
+  device_sums.cpyDeviceToHost(sums, pack.n_fields * n_cells);
+}
+
+// Temperature of a cell of the projections. As in the host projections the
+// gas has a mean molecular weight of 0.6
+__device__ Real Projection_Temperature(Real const* dev_conserved, Real const* dev_magnetic_centered, int id, int xid,
+                                       int yid, int zid, int nx, int ny, int n_cells, Real gamma)
+{
+  Real const mu = 0.6;
+  Real const d  = dev_conserved[grid_enum::density * n_cells + id];
+  Real const n  = d * DENSITY_UNIT / (mu * MP);
+  #ifdef DE
+  return hydro_utilities::Calc_Temp_DE(dev_conserved[grid_enum::GasEnergy * n_cells + id], gamma, n);
+  #else  // DE is not defined
+  Real const mx = dev_conserved[grid_enum::momentum_x * n_cells + id];
+  Real const my = dev_conserved[grid_enum::momentum_y * n_cells + id];
+  Real const mz = dev_conserved[grid_enum::momentum_z * n_cells + id];
+  Real const E  = dev_conserved[grid_enum::Energy * n_cells + id];
+    #ifdef MHD
+  auto const [magnetic_x, magnetic_y, magnetic_z] =
+      mhd::utils::cellCenteredMagneticFields(dev_magnetic_centered, dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+  return hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gamma, n, magnetic_x, magnetic_y, magnetic_z);
+    #else   // MHD is not defined
+  return hydro_utilities::Calc_Temp_Conserved(E, d, mx, my, mz, gamma, n);
+    #endif  // MHD
+  #endif    // DE
+}
+
+// Sum the density, the density weighted temperature and the dust density of
+// the real cells of each column along z (axis 2) or y (axis 1). A thread sums
+// a column, with consecutive threads at consecutive x so the reads coalesce
+__global__ void Project_GPU_Kernel(Real const* dev_conserved, Real const* dev_magnetic_centered, int nx, int ny,
+                                   int n_cells, int n_ghost, int nx_real, int ny_real, int nz_real, int axis, Real dl,
+                                   Real gamma, Real* projections)
+{
+  int const n_b     = axis == 2 ? ny_real : nz_real;
+  int const n_c     = axis == 2 ? nz_real : ny_real;
+  int const n_proj  = nx_real * n_b;
+  int const id_proj = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id_proj >= n_proj) {
+    return;
+  }
+  int const i = id_proj % nx_real;
+  int const b = id_proj / nx_real;
+
+  Real d_sum = 0, T_sum = 0, dust_sum = 0;
+  for (int c = 0; c < n_c; c++) {
+    int const xid = i + n_ghost;
+    int const yid = (axis == 2 ? b : c) + n_ghost;
+    int const zid = (axis == 2 ? c : b) + n_ghost;
+    int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+
+    Real const d = dev_conserved[grid_enum::density * n_cells + id];
+    d_sum += d * dl;
+    T_sum += Projection_Temperature(dev_conserved, dev_magnetic_centered, id, xid, yid, zid, nx, ny, n_cells,
+                                    gamma) * d * dl;
+  #ifdef DUST
+    dust_sum += dev_conserved[grid_enum::dust_density * n_cells + id] * dl;
+  #endif  // DUST
+  }
+
+  // HDF5 order, with x the slowest index
+  int const buf_id                 = b + i * n_b;
+  projections[buf_id]              = d_sum;
+  projections[n_proj + buf_id]     = T_sum;
+  projections[2 * n_proj + buf_id] = dust_sum;
+}
+
+void Project_Grid_GPU(Header const& H, Real const* dev_conserved, Real gamma, int axis, Real* projections,
+                      Real const* dev_magnetic_centered)
+{
+  int const n_proj = H.nx_real * (axis == 2 ? H.ny_real : H.nz_real);
+  Real const dl    = axis == 2 ? H.dz : H.dy;
+  cuda_utilities::DeviceVector<Real> device_projections{3 * size_t(n_proj)};
+
+  dim3 dim1dGrid((n_proj + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Project_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, dev_magnetic_centered, H.nx, H.ny,
+                     H.n_cells, H.n_ghost, H.nx_real, H.ny_real, H.nz_real, axis, dl, gamma, device_projections.data());
+  GPU_Error_Check();
+  device_projections.cpyDeviceToHost(projections, 3 * size_t(n_proj));
+}
+
+// A uniform number in [0, 1) from a hash of a global cell and a seed, so the
+// jitter of a cell center doesn't depend on the order of the threads
+__device__ Real Cell_Jitter(unsigned long long cell, unsigned long long seed)
+{
+  unsigned long long h = cell * 0x9E3779B97F4A7C15ull + seed * 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBull;
+  h ^= h >> 31;
+  return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// The rotation of Rotate_Point, with the trigonometric functions evaluated once
+struct RotationMatrix {
+  Real a[3][3];
+};
+
+// Add the density, density weighted temperature and momenta of each real cell
+// to the pixel of the rotated projection that its jittered center falls in
+__global__ void Rotated_Project_GPU_Kernel(Real const* dev_conserved, Real const* dev_magnetic_centered, int nx, int ny,
+                                           int n_cells, int n_ghost, int nx_real, int ny_real, int nz_real,
+                                           Real x_start, Real y_start, Real z_start, Real dx, Real dy, Real dz,
+                                           long i_start, long j_start, long k_start, RotationMatrix rotation, int nx_r,
+                                           int nz_r, Real Lx, Real Lz, int ix_offset, int iz_offset, int nx_dset,
+                                           int nz_dset, Real gamma, Real* projections)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  int i, j, k;
+  cuda_utilities::compute3DIndices(tid, nx_real, ny_real, i, j, k);
+  if (k >= nz_real) {
+    return;
+  }
+  int const xid = i + n_ghost;
+  int const yid = j + n_ghost;
+  int const zid = k + n_ghost;
+  int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+
+  // add very slight noise to the cell center to combat aliasing
+  Real const eps                = 0.1;
+  unsigned long long const cell = (i_start + i) + ((j_start + j) << 21) + ((k_start + k) << 42);
+  Real const x                  = x_start + (i + 0.5) * dx + eps * dx * (Cell_Jitter(cell, 0) - 0.5);
+  Real const y                  = y_start + (j + 0.5) * dy + eps * dy * (Cell_Jitter(cell, 1) - 0.5);
+  Real const z                  = z_start + (k + 0.5) * dz + eps * dz * (Cell_Jitter(cell, 2) - 0.5);
+
+  Real const xp = rotation.a[0][0] * x + rotation.a[0][1] * y + rotation.a[0][2] * z;
+  Real const zp = rotation.a[2][0] * x + rotation.a[2][1] * y + rotation.a[2][2] * z;
+
+  // find projected locations, assumes box centered at [0,0,0]
+  int const ix = (int)round(nx_r * (xp + 0.5 * Lx) / Lx) - ix_offset;
+  int const iz = (int)round(nz_r * (zp + 0.5 * Lz) / Lz) - iz_offset;
+  if (ix < 0 || ix >= nx_dset || iz < 0 || iz >= nz_dset) {
     return;
   }
+
+  int const n_proj = nx_dset * nz_dset;
+  int const buf_id = iz + ix * nz_dset;
+  Real const d     = dev_conserved[grid_enum::density * n_cells + id];
+  Real const T     = Projection_Temperature(dev_conserved, dev_magnetic_centered, id, xid, yid, zid, nx, ny, n_cells,
+                                            gamma);
+  atomicAdd(&projections[buf_id], d * dy);
+  atomicAdd(&projections[n_proj + buf_id], T * d * dy);
+  atomicAdd(&projections[2 * n_proj + buf_id], dev_conserved[grid_enum::momentum_x * n_cells + id] * dy);
+  atomicAdd(&projections[3 * n_proj + buf_id], dev_conserved[grid_enum::momentum_y * n_cells + id] * dy);
+  atomicAdd(&projections[4 * n_proj + buf_id], dev_conserved[grid_enum::momentum_z * n_cells + id] * dy);
+}
+
+void Project_Rotated_Grid_GPU(Header const& H, Rotation const& R, Real const* dev_conserved, Real gamma, int nx_dset,
+                              int nz_dset, Real* projections, Real const* dev_magnetic_centered)
+{
+  Real const cd = cos(R.delta), sd = sin(R.delta);
+  Real const cp = cos(R.phi), sp = sin(R.phi);
+  Real const ct = cos(R.theta), st = sin(R.theta);
+  RotationMatrix rotation;
+  rotation.a[0][0] = cp * cd - sp * ct * sd;
+  rotation.a[0][1] = -1.0 * (cp * sd + sp * ct * cd);
+  rotation.a[0][2] = sp * st;
+  rotation.a[1][0] = sp * cd + cp * ct * sd;
+  rotation.a[1][1] = cp * ct * cd - st * sd;
+  rotation.a[1][2] = cp * st;
+  rotation.a[2][0] = st * sd;
+  rotation.a[2][1] = st * cd;
+  rotation.a[2][2] = ct;
+
+  // The same global positions as Get_Position
+  long i_start = 0, j_start = 0, k_start = 0;
+  int ix_offset = 0, iz_offset = 0;
+  #ifdef MPI_CHOLLA
+  i_start   = nx_local_start;
+  j_start   = ny_local_start;
+  k_start   = nz_local_start;
+  ix_offset = R.nx_min;
+  iz_offset = R.nz_min;
+  #endif  // MPI_CHOLLA
+
+  size_t const n_proj = size_t(nx_dset) * nz_dset;
+  cuda_utilities::DeviceVector<Real> device_projections{5 * n_proj, true};
+
+  dim3 dim1dGrid((H.nx_real * H.ny_real * H.nz_real + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Rotated_Project_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, dev_magnetic_centered,
+                     H.nx, H.ny, H.n_cells, H.n_ghost, H.nx_real, H.ny_real, H.nz_real, H.xbound + i_start * H.dx,
+                     H.ybound + j_start * H.dy, H.zbound + k_start * H.dz, H.dx, H.dy, H.dz, i_start, j_start, k_start,
+                     rotation, R.nx, R.nz, R.Lx, R.Lz, ix_offset, iz_offset, nx_dset, nz_dset, gamma,
+                     device_projections.data());
+  GPU_Error_Check();
+  device_projections.cpyDeviceToHost(projections, 5 * n_proj);
+}
+
+// Copy the plane normal to axis at the local index slice, ghost cells
+// included, of the conserved fields into consecutive HDF5 ordered blocks. The
+// magnetic fields are averaged to the cell centers, unless they are read from
+// the cache dev_magnetic_centered
+__global__ void Slice_GPU_Kernel(Real const* dev_conserved, Real const* dev_magnetic_centered, int nx, int ny,
+                                 int n_cells, int n_ghost, int n_a, int n_b, int axis, int slice, Real* slices)
+{
+  int const n_slice  = n_a * n_b;
+  int const id_slice = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id_slice >= n_slice) {
+    return;
+  }
+  // a is the faster of the two axes of the plane in the grid
+  int const a   = id_slice % n_a;
+  int const b   = id_slice / n_a;
+  int const xid = axis == 0 ? slice : a + n_ghost;
+  int const yid = axis == 1 ? slice : (axis == 0 ? a : b) + n_ghost;
+  int const zid = axis == 2 ? slice : b + n_ghost;
+  int const id  = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+
+  Real* slice_field = slices + b + a * n_b;
+  for (int field : {grid_enum::density, grid_enum::momentum_x, grid_enum::momentum_y, grid_enum::momentum_z,
+                    grid_enum::Energy}) {
+    *slice_field = dev_conserved[field * n_cells + id];
+    slice_field += n_slice;
+  }
+  #ifdef MHD
+  auto const [magnetic_x, magnetic_y, magnetic_z] =
+      mhd::utils::cellCenteredMagneticFields(dev_magnetic_centered, dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+  for (Real const magnetic : {magnetic_x, magnetic_y, magnetic_z}) {
+    *slice_field = magnetic;
+    slice_field += n_slice;
+  }
+  #endif  // MHD
+  #ifdef DE
+  *slice_field = dev_conserved[grid_enum::GasEnergy * n_cells + id];
+  slice_field += n_slice;
+  #endif  // DE
+  #ifdef SCALAR
+  for (int field = grid_enum::scalar; field < grid_enum::scalar + NSCALARS; field++) {
+    *slice_field = dev_conserved[field * n_cells + id];
+    slice_field += n_slice;
+  }
+  #endif  // SCALAR
+}
+
+void Slice_Grid_GPU(Header const& H, Real const* dev_conserved, int axis, int slice, Real* slices,
+                    Real const* dev_magnetic_centered)
+{
+  int const n_a        = axis == 0 ? H.ny_real : H.nx_real;
+  int const n_b        = axis == 2 ? H.ny_real : H.nz_real;
+  size_t const n_slice = size_t(n_a) * n_b;
+  cuda_utilities::DeviceVector<Real> device_slices{Slice_N_Fields() * n_slice};
+
+  dim3 dim1dGrid((n_slice + TPB - 1) / TPB, 1, 1);
+  dim3 dim1dBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(Slice_GPU_Kernel, dim1dGrid, dim1dBlock, 0, 0, dev_conserved, dev_magnetic_centered, H.nx, H.ny,
+                     H.n_cells, H.n_ghost, n_a, n_b, axis, slice, device_slices.data());
+  GPU_Error_Check();
+  device_slices.cpyDeviceToHost(slices, Slice_N_Fields() * n_slice);
 }
 
 #endif  // HDF5
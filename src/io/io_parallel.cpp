@@ -6,14 +6,156 @@
 #if defined(HDF5) && defined(MPI_CHOLLA)
   #include <hdf5.h>
 
+  #include <algorithm>
+  #include <string>
+
   #include "../mpi/mpi_routines.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/gpu.hpp"
   #include "../utils/timing_functions.h"  // provides ScopedTimer
 
+// The single file of Open_Output_File_Cat. While it is open the datasets of
+// Write_HDF5_Dataset are written collectively into the block of the local grid
+struct CatOutputFile {
+  bool active = false;
+  int chunk   = 0;
+  hsize_t local_real[3];
+  hsize_t global_real[3];
+  hsize_t offset[3];
+};
+static CatOutputFile cat_file;
+
+bool Output_Cat_Active() { return cat_file.active; }
+
+herr_t Write_HDF5_Dataset_Cat(hid_t file_id, hid_t dataspace_id, const void *dataset_buffer, hid_t file_type,
+                              hid_t mem_type, const char *name)
+{
+  // The local dataspace has the real cells of this rank, the face centered
+  // fields have one more cell in their direction
+  hsize_t dims[3];
+  int const rank = H5Sget_simple_extent_ndims(dataspace_id);
+  if (rank != 3) {
+    CHOLLA_ERROR("The single file output only supports 3D datasets, %s has rank %d", name, rank);
+  }
+  H5Sget_simple_extent_dims(dataspace_id, dims, NULL);
+
+  hsize_t global_dims[3], count[3], chunk[3];
+  hsize_t const start[3] = {0, 0, 0};
+  for (int d = 0; d < 3; d++) {
+    global_dims[d] = cat_file.global_real[d] + dims[d] - cat_file.local_real[d];
+    // Neighboring ranks share their faces, only the last rank writes the
+    // upper one so the selections don't overlap
+    bool const last = cat_file.offset[d] + cat_file.local_real[d] == cat_file.global_real[d];
+    count[d]        = last ? dims[d] : cat_file.local_real[d];
+    chunk[d]        = std::min(hsize_t(cat_file.chunk), global_dims[d]);
+  }
+
+  hid_t file_space_id = H5Screate_simple(3, global_dims, NULL);
+  hid_t mem_space_id  = H5Scopy(dataspace_id);
+  hid_t dcpl_id       = H5Pcreate(H5P_DATASET_CREATE);
+  if (cat_file.chunk > 0) {
+    H5Pset_chunk(dcpl_id, 3, chunk);
+  }
+  // Compressed datasets are chunked by the local blocks unless the chunk size
+  // is set, so the chunks of a rank don't straddle its neighbors
+  Set_Output_Compression_HDF5(dcpl_id, name, file_type, 3, cat_file.local_real);
+  hid_t dataset_id = H5Dcreate(file_id, name, file_type, file_space_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+
+  // Select the block of this rank in the file and in the local buffer
+  herr_t status = H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, cat_file.offset, NULL, count, NULL);
+  status        = H5Sselect_hyperslab(mem_space_id, H5S_SELECT_SET, start, NULL, count, NULL);
+
+  hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+  #ifdef H5_HAVE_PARALLEL
+  H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+  #endif  // H5_HAVE_PARALLEL
+  status = H5Dwrite(dataset_id, mem_type, mem_space_id, file_space_id, dxpl_id, dataset_buffer);
+
+  H5Pclose(dxpl_id);
+  H5Dclose(dataset_id);
+  H5Pclose(dcpl_id);
+  H5Sclose(mem_space_id);
+  H5Sclose(file_space_id);
+  return status;
+}
+
+hid_t Open_Output_File_Cat(Grid3D &G, struct Parameters P, std::string const &filename)
+{
+  if (G.H.nx == 1 or G.H.ny == 1 or G.H.nz == 1) {
+    CHOLLA_ERROR("The single file output only supports 3D grids");
+  }
+
+  // Collective MPI-IO access, where the number of aggregators is a hint of the
+  // collective buffering
+  MPI_Info info;
+  MPI_Info_create(&info);
+  if (P.output_cat_aggregators > 0) {
+    std::string const aggregators = std::to_string(P.output_cat_aggregators);
+    MPI_Info_set(info, "cb_nodes", aggregators.c_str());
+    MPI_Info_set(info, "romio_cb_write", "enable");
+  }
+  hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+  #ifdef H5_HAVE_PARALLEL
+  H5Pset_fapl_mpio(fapl_id, world, info);
+  // The header is the same on all the ranks, so its metadata is written once
+  H5Pset_coll_metadata_write(fapl_id, true);
+  #endif  // H5_HAVE_PARALLEL
+  hid_t file_id = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+  H5Pclose(fapl_id);
+  MPI_Info_free(&info);
+  if (file_id < 0) {
+    CHOLLA_ERROR("Unable to create the output file %s", filename.c_str());
+  }
+
+  cat_file.active         = true;
+  cat_file.chunk          = P.output_cat_chunk;
+  cat_file.local_real[0]  = G.H.nx_real;
+  cat_file.local_real[1]  = G.H.ny_real;
+  cat_file.local_real[2]  = G.H.nz_real;
+  cat_file.global_real[0] = nx_global;
+  cat_file.global_real[1] = ny_global;
+  cat_file.global_real[2] = nz_global;
+  cat_file.offset[0]      = nx_local_start;
+  cat_file.offset[1]      = ny_local_start;
+  cat_file.offset[2]      = nz_local_start;
+  return file_id;
+}
+
+void Close_Output_File_Cat(hid_t file_id, std::string const &filename)
+{
+  cat_file.active = false;
+  if (H5Fclose(file_id) < 0) {
+    CHOLLA_ERROR("Writing the output file %s failed", filename.c_str());
+  }
+}
+
+/*! \brief Write the hydro snapshot nfile of all the ranks to a single file with
+ * collective parallel HDF5, in the layout read by Read_Grid_Cat */
+void Output_Data_Cat(Grid3D &G, struct Parameters P, int nfile)
+{
+  #ifdef H5_HAVE_PARALLEL
+  ScopedTimer timer("Output_Data_Cat");
+  std::string const filename = FnameTemplate(P).format_cat_fname(nfile, "");
+  hid_t file_id              = Open_Output_File_Cat(G, P, filename);
+
+  G.Write_Header_HDF5(file_id);
+  G.Write_Grid_HDF5(file_id);
+
+  Close_Output_File_Cat(file_id, filename);
+  #else
+  CHOLLA_ERROR("output_cat needs an HDF5 library built with parallel support");
+  #endif  // H5_HAVE_PARALLEL
+}
+
 // Warning: H5Sselect_hyperslab expects its pointer args to be arrays of same size as the rank of the dataspace
 // file_space_id
-void Read_HDF5_Selection_3D(hid_t file_id, hsize_t* offset, hsize_t* count, double* buffer, const char* name)
+void Read_HDF5_Selection_3D(hid_t file_id, hid_t dxpl_id, hsize_t* offset, hsize_t* count, double* buffer,
+                            const char* name)
 {
   hid_t dataset_id = H5Dopen(file_id, name, H5P_DEFAULT);
+  if (dataset_id < 0) {
+    CHOLLA_ERROR("Unable to open the dataset %s of the restart file", name);
+  }
   // Select the requested subset of data
   hid_t file_space_id = H5Dget_space(dataset_id);
   hid_t mem_space_id  = H5Screate_simple(3, count, NULL);
@@ -30,7 +172,10 @@ void Read_HDF5_Selection_3D(hid_t file_id, hsize_t* offset, hsize_t* count, doub
 
   herr_t status = H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, offset, NULL, count, NULL);
   // Read in the data subset
-  status = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id, H5P_DEFAULT, buffer);
+  status = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id, dxpl_id, buffer);
+  if (status < 0) {
+    CHOLLA_ERROR("Reading the dataset %s of the restart file failed", name);
+  }
 
   // Free the ids
   status = H5Sclose(mem_space_id);
@@ -39,23 +184,30 @@ void Read_HDF5_Selection_3D(hid_t file_id, hsize_t* offset, hsize_t* count, doub
 }
 
 // Alwin: I'm only writing a 3D version of this because that's what is practical.
-// Read from concatenated HDF5 file
-void Read_Grid_Cat_HDF5_Field(hid_t file_id, Real* dataset_buffer, Header H, hsize_t* offset, hsize_t* count,
-                              Real* grid_buffer, const char* name)
+// Read the block of a field of the concatenated HDF5 file at offset into the
+// pinned host_buffer, then unpack it into the device field and bring the field
+// back to the host. The face centered magnetic fields have one more cell in
+// their direction
+void Read_Grid_Cat_HDF5_Field(hid_t file_id, hid_t dxpl_id, Header H, hsize_t* offset, Real* host_buffer,
+                              Real* device_buffer, Real* device_field, Real* host_field, const char* name,
+                              int mhd_direction = -1)
 {
-  Read_HDF5_Selection_3D(file_id, offset, count, dataset_buffer, name);
-  Fill_Grid_From_HDF5_Buffer(H.nx, H.ny, H.nz, H.nx_real, H.ny_real, H.nz_real, H.n_ghost, dataset_buffer, grid_buffer);
-}
+  hsize_t count[3];
+  count[0] = H.nx_real + int(mhd_direction == 0);
+  count[1] = H.ny_real + int(mhd_direction == 1);
+  count[2] = H.nz_real + int(mhd_direction == 2);
+  Read_HDF5_Selection_3D(file_id, dxpl_id, offset, count, host_buffer, name);
 
-void Read_Grid_Cat_HDF5_Field_Magnetic(hid_t file_id, Real* dataset_buffer, Header H, hsize_t* offset, hsize_t* count,
-                                       Real* grid_buffer, const char* name)
-{
-  Read_HDF5_Selection_3D(file_id, offset, count, dataset_buffer, name);
-  Fill_Grid_From_HDF5_Buffer(H.nx, H.ny, H.nz, H.nx_real + 1, H.ny_real + 1, H.nz_real + 1, H.n_ghost - 1,
-                             dataset_buffer, grid_buffer);
+  GPU_Error_Check(
+      cudaMemcpy(device_buffer, host_buffer, count[0] * count[1] * count[2] * sizeof(Real), cudaMemcpyHostToDevice));
+  Fill_Grid_From_HDF5_Buffer_GPU(H.nx, H.ny, count[0], count[1], count[2], H.n_ghost, device_buffer, device_field,
+                                 mhd_direction);
+  GPU_Error_Check(cudaMemcpy(host_field, device_field, H.n_cells * sizeof(Real), cudaMemcpyDeviceToHost));
 }
 
-/*! \brief Read in grid data from a single concatenated output file. */
+/*! \brief Read in grid data from a single concatenated output file. Each rank
+ * reads the block of its subdomain, so the restart can use any number of ranks
+ * and any decomposition of the grid of the file. */
 void Grid3D::Read_Grid_Cat(struct Parameters P)
 {
   ScopedTimer timer("Read_Grid_Cat");
@@ -64,15 +216,24 @@ void Grid3D::Read_Grid_Cat(struct Parameters P)
 
   sprintf(filename, "%s%d.h5", P.indir, P.nfile);
 
-  hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+  // With parallel HDF5 the ranks open the file together and read the
+  // attributes and the datasets with collective MPI-IO calls. The metadata is
+  // then read once and broadcast instead of by every rank
+  hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+  hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+  #ifdef H5_HAVE_PARALLEL
+  H5Pset_fapl_mpio(fapl_id, world, MPI_INFO_NULL);
+  H5Pset_all_coll_metadata_ops(fapl_id, true);
+  H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+  #endif  // H5_HAVE_PARALLEL
+
+  hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id);
+  H5Pclose(fapl_id);
 
   if (file_id < 0) {
-    printf("Unable to open input file: %s\n", filename);
-    exit(0);
+    CHOLLA_ERROR("Unable to open input file: %s", filename);
   }
 
-  // TODO (written by Alwin, for anyone to do) :
-  // Consider using collective calls if this part is slow at scale
   hid_t attribute_id;
   attribute_id = H5Aopen(file_id, "t", H5P_DEFAULT);
   status       = H5Aread(attribute_id, H5T_NATIVE_DOUBLE, &H.t);
@@ -81,50 +242,70 @@ void Grid3D::Read_Grid_Cat(struct Parameters P)
   status       = H5Aread(attribute_id, H5T_NATIVE_INT, &H.n_step);
   status       = H5Aclose(attribute_id);
 
+  // The blocks are only remapped, so the global grid must be the one of the
+  // file
+  int dims[3];
+  attribute_id = H5Aopen(file_id, "dims", H5P_DEFAULT);
+  status       = H5Aread(attribute_id, H5T_NATIVE_INT, dims);
+  status       = H5Aclose(attribute_id);
+  if (dims[0] != P.nx || dims[1] != P.ny || dims[2] != P.nz) {
+    CHOLLA_ERROR("The grid of %s is %d x %d x %d, but the parameters have %d x %d x %d", filename, dims[0], dims[1],
+                 dims[2], P.nx, P.ny, P.nz);
+  }
+
   // Offsets are global variables from mpi_routines.h
   hsize_t offset[3];
   offset[0] = nx_local_start;
   offset[1] = ny_local_start;
   offset[2] = nz_local_start;
 
-  // This is really dims but I name it count because that's what HDF5 names it
-  hsize_t count[3];
-  count[0] = H.nx_real;
-  count[1] = H.ny_real;
-  count[2] = H.nz_real;
-
+  // The blocks are read into pinned memory and unpacked on the device
   #ifdef MHD
-  Real* dataset_buffer = (Real*)malloc((H.nz_real + 1) * (H.ny_real + 1) * (H.nx_real + 1) * sizeof(Real));
+  size_t const buffer_size = (H.nz_real + 1) * (H.ny_real + 1) * (H.nx_real + 1);
   #else
-  Real* dataset_buffer = (Real*)malloc((H.nz_real) * (H.ny_real) * (H.nx_real) * sizeof(Real));
+  size_t const buffer_size = (H.nz_real) * (H.ny_real) * (H.nx_real);
   #endif
+  Real* host_buffer;
+  GPU_Error_Check(cudaHostAlloc(&host_buffer, buffer_size * sizeof(Real), cudaHostAllocDefault));
+  cuda_utilities::DeviceVector<Real> device_buffer{buffer_size};
+  Real* const buffer = device_buffer.data();
 
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.density, "/density");
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.momentum_x, "/momentum_x");
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.momentum_y, "/momentum_y");
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.momentum_z, "/momentum_z");
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.Energy, "/Energy");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_density, C.density, "/density");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_momentum_x, C.momentum_x,
+                           "/momentum_x");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_momentum_y, C.momentum_y,
+                           "/momentum_y");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_momentum_z, C.momentum_z,
+                           "/momentum_z");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_Energy, C.Energy, "/Energy");
   #ifdef DE
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.GasEnergy, "/GasEnergy");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_GasEnergy, C.GasEnergy,
+                           "/GasEnergy");
   #endif  // DE
 
   #ifdef SCALAR
     #ifdef BASIC_SCALAR
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.basic_scalar, "/scalar0");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_basic_scalar, C.basic_scalar,
+                           "/scalar0");
     #endif
     #ifdef DUST
-  Read_Grid_Cat_HDF5_Field(file_id, dataset_buffer, H, offset, count, C.dust_density, "/dust_density");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_dust_density, C.dust_density,
+                           "/dust_density");
     #endif
   #endif
   // TODO (Alwin) : add scalar stuff
 
   #ifdef MHD
-  Read_Grid_Cat_HDF5_Field_Magnetic(file_id, dataset_buffer, H, offset, count, C.magnetic_x, "/magnetic_x");
-  Read_Grid_Cat_HDF5_Field_Magnetic(file_id, dataset_buffer, H, offset, count, C.magnetic_y, "/magnetic_y");
-  Read_Grid_Cat_HDF5_Field_Magnetic(file_id, dataset_buffer, H, offset, count, C.magnetic_z, "/magnetic_z");
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_magnetic_x, C.magnetic_x,
+                           "/magnetic_x", 0);
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_magnetic_y, C.magnetic_y,
+                           "/magnetic_y", 1);
+  Read_Grid_Cat_HDF5_Field(file_id, dxpl_id, H, offset, host_buffer, buffer, C.d_magnetic_z, C.magnetic_z,
+                           "/magnetic_z", 2);
   #endif
 
-  free(dataset_buffer);
+  GPU_Error_Check(cudaFreeHost(host_buffer));
+  H5Pclose(dxpl_id);
   status = H5Fclose(file_id);
 }
 
@@ -4,7 +4,9 @@
 #ifdef MPI_CHOLLA
   #include <mpi.h>
 
+  #include "mpi/buddy_checkpoint.h"
   #include "mpi/mpi_routines.h"
+  #include "mpi/nvshmem_boundaries.h"
 #endif
 #include <math.h>
 #include <stdio.h>
@@ -12,10 +14,15 @@
 #include <string.h>
 
 #include "global/global.h"
+#include "grid/ensemble.h"
 #include "grid/grid3D.h"
 #include "io/io.h"
 #include "utils/cuda_utilities.h"
+#include "utils/device_memory_pool.h"
 #include "utils/error_handling.h"
+#include "utils/launch_autotuner.h"
+#include "utils/roofline.h"
+#include "utils/timing_functions.h"
 
 #ifdef SUPERNOVA
   #include "particles/supernova.h"
@@ -36,6 +43,7 @@ int main(int argc, char *argv[])
 {
   // timing variables
   double start_total, stop_total, start_step, stop_step;
+  double benchmark_time = 0;
 #ifdef CPU_TIME
   double stop_init, init_min, init_max, init_avg;
   double start_bound, stop_bound, bound_min, bound_max, bound_avg;
@@ -46,6 +54,7 @@ int main(int argc, char *argv[])
 
   // start the total time
   start_total = Get_Time();
+  StartupTimer startup_timer(start_total);
 
 #ifdef MPI_CHOLLA
   /* Initialize MPI communication */
@@ -55,8 +64,6 @@ int main(int argc, char *argv[])
   Init_Global_Parallel_Vars_No_MPI();
 #endif /*MPI_CHOLLA*/
 
-  Real dti = 0;  // inverse time step, 1.0 / dt
-
   // input parameter variables
   char *param_file;
   struct Parameters P;
@@ -66,6 +73,8 @@ int main(int argc, char *argv[])
   // read in command line arguments
   if (argc < 2) {
     chprintf("usage: %s <parameter_file>\n", argv[0]);
+    chprintf("       %s --benchmark [n_steps] [name=value ...]\n", argv[0]);
+    chprintf("       %s --ensemble <parameter_file> [<parameter_file> ...]\n", argv[0]);
     chprintf("Git Commit Hash = %s\n", GIT_HASH);
     chprintf("Macro Flags     = %s\n", MACRO_FLAGS);
     chexit(-1);
@@ -73,11 +82,27 @@ int main(int argc, char *argv[])
     param_file = argv[1];
   }
 
+  // Run several independent simulations in this process instead of one
+  if (strcmp(param_file, "--ensemble") == 0) {
+    Run_Ensemble(argc - 2, argv + 2);
+#ifdef MPI_CHOLLA
+  #ifdef NVSHMEM_BOUNDARIES
+    Finalize_NVSHMEM();
+  #endif  // NVSHMEM_BOUNDARIES
+    MPI_Finalize();
+#endif  // MPI_CHOLLA
+    return 0;
+  }
+
   // create the grid
   Grid3D G;
 
-  // read in the parameters
-  Parse_Params(param_file, &P, argc, argv);
+  // read in the parameters, or set up the synthetic benchmark problem
+  if (strcmp(param_file, "--benchmark") == 0) {
+    Set_Benchmark_Params(&P, argc, argv);
+  } else {
+    Parse_Params(param_file, &P, argc, argv);
+  }
   // and output to screen
   chprintf("Git Commit Hash = %s\n", GIT_HASH);
   chprintf("Macro Flags     = %s\n", MACRO_FLAGS);
@@ -95,12 +120,16 @@ int main(int argc, char *argv[])
   }
 
   if (is_restart) {
+    Use_Local_Checkpoint(&P);
     chprintf("Input directory:  %s\n", P.indir);
   }
   chprintf("Output directory:  %s\n", P.outdir);
 
   // Check the configuration
   Check_Configuration(P);
+#ifdef HDF5
+  Init_Output_Compression(P);
+#endif  // HDF5
 
   // Create a Log file to output run-time messages and output the git hash and
   // macro flags used
@@ -110,9 +139,18 @@ int main(int argc, char *argv[])
   message = "Macro Flags     = " + std::string(MACRO_FLAGS);
   Write_Message_To_Log_File(message.c_str());
 
+  startup_timer.End_Phase("MPI and parameters");
+
+#ifdef LAUNCH_AUTOTUNE
+  if (P.launch_cache[0] != '\0') {
+    cuda_utilities::Load_Launch_Cache(P.launch_cache);
+  }
+#endif  // LAUNCH_AUTOTUNE
+
   // initialize the grid
   G.Initialize(&P);
   chprintf("Local number of grid cells: %d %d %d %d\n", G.H.nx_real, G.H.ny_real, G.H.nz_real, G.H.n_cells);
+  startup_timer.End_Phase("Grid");
 
   message = "Initializing Simulation";
   Write_Message_To_Log_File(message.c_str());
@@ -121,6 +159,7 @@ int main(int argc, char *argv[])
   chprintf("Setting initial conditions...\n");
   G.Set_Initial_Conditions(P);
   chprintf("Initial conditions set.\n");
+  startup_timer.End_Phase("Initial conditions");
   // set main variables for Read_Grid and Read_Grid_Cat initial conditions
   if (is_restart) {
     outtime += G.H.t;
@@ -134,7 +173,7 @@ int main(int argc, char *argv[])
 #endif
 
 #ifdef CPU_TIME
-  G.Timer.Initialize();
+  G.Timer.Initialize(P);
 #endif
 
 #ifdef GRAVITY
@@ -145,6 +184,14 @@ int main(int argc, char *argv[])
   G.Initialize_Particles(&P);
 #endif
 
+#ifdef STATIC_REFINEMENT
+  G.Initialize_Refinement(&P);
+#endif  // STATIC_REFINEMENT
+
+#ifdef LOCAL_TIMESTEPS
+  G.Initialize_Local_Timesteps(&P);
+#endif  // LOCAL_TIMESTEPS
+
 #ifdef COSMOLOGY
   G.Initialize_Cosmology(&P);
 #endif
@@ -166,16 +213,13 @@ int main(int argc, char *argv[])
 
 #if defined(SUPERNOVA) && defined(PARTICLE_AGE)
   FeedbackAnalysis sn_analysis(G);
-  #ifdef MPI_CHOLLA
-  supernova::initState(&P, G.Particles.n_total_initial);
-  #else
-  supernova::initState(&P, G.Particles.n_local);
-  #endif  // MPI_CHOLLA
+  supernova::initState(&P);
 #endif    // SUPERNOVA && PARTICLE_AGE
 
 #ifdef STAR_FORMATION
   star_formation::Initialize(G);
 #endif
+  startup_timer.End_Phase("Subsystems");
 
 #ifdef GRAVITY_ANALYTIC_COMP
   G.Setup_Analytic_Potential(&P);
@@ -191,6 +235,14 @@ int main(int argc, char *argv[])
   chprintf("Setting boundary conditions...\n");
   G.Set_Boundary_Conditions_Grid(P);
   chprintf("Boundary conditions set.\n");
+#ifdef RUNTIME_KERNELS
+  // Pick the hydro kernels now that the ghost cells hold the initial state
+  G.Select_Hydro_Kernels(P);
+#endif  // RUNTIME_KERNELS
+#ifdef VL_OVERLAP
+  // From here on the hydro boundaries are transferred by the integrator
+  G.H.OVERLAP_HYDRO_BOUNDARIES = true;
+#endif  // VL_OVERLAP
 
 #ifdef GRAVITY_ANALYTIC_COMP
   G.Add_Analytic_Potential();
@@ -201,12 +253,19 @@ int main(int argc, char *argv[])
   G.Get_Particles_Acceleration();
 #endif
 
+  startup_timer.End_Phase("Potential and boundaries");
+
   chprintf("Dimensions of each cell: dx = %f dy = %f dz = %f\n", G.H.dx, G.H.dy, G.H.dz);
   chprintf("Ratio of specific heats gamma = %f\n", gama);
   chprintf("Nstep = %d  Simulation time = %f\n", G.H.n_step, G.H.t);
+  roofline::Print_Integrator_Cost(G.H.n_fields);
+
+  // Compute inverse timestep for the first time, before the initial output
+  // reads the cell centered magnetic fields that it caches
+  G.Calc_Inverse_Timestep();
 
 #ifdef OUTPUT
-  if (!is_restart || G.H.Output_Now) {
+  if ((!is_restart || G.H.Output_Now) and P.benchmark_steps == 0) {
     // write the initial conditions to file
     chprintf("Writing initial conditions to file...\n");
     Write_Data(G, P, nfile);
@@ -222,6 +281,8 @@ int main(int argc, char *argv[])
 
   // increment the next output time
   outtime += P.outstep;
+  startup_timer.End_Phase("Initial output");
+  startup_timer.Print();
 
 #ifdef CPU_TIME
   stop_init = Get_Time();
@@ -241,9 +302,6 @@ int main(int argc, char *argv[])
   message = "Starting calculations.";
   Write_Message_To_Log_File(message.c_str());
 
-  // Compute inverse timestep for the first time
-  dti = G.Calc_Inverse_Timestep();
-
   while (G.H.t < P.tout) {
 // get the start time
 #ifdef CPU_TIME
@@ -252,7 +310,15 @@ int main(int argc, char *argv[])
     start_step = Get_Time();
 
     // calculate the timestep by calling MPI_Allreduce
-    G.set_dt(dti);
+    G.set_dt();
+#ifdef MPI_CHOLLA
+    // A state that went bad, e.g. from a transient memory error, continues
+    // from the last buddy checkpoint. The timestep is reduced, so every rank
+    // agrees on going back
+    if (not isfinite(G.H.dt) and buddy_checkpoint::Restore(G, -1, &outtime, &nfile)) {
+      G.set_dt();
+    }
+#endif  // MPI_CHOLLA
 
     // adjust timestep based on the next available scheduled time
     const Real next_scheduled_time = fmin(outtime, P.tout);
@@ -268,12 +334,30 @@ int main(int argc, char *argv[])
     // Advance the particles KDK( first step ): Velocities are updated by 0.5*dt
     // and positions are updated by dt
     G.Advance_Particles(1);
-    // Transfer the particles that moved outside the local domain
-    G.Transfer_Particles_Boundaries(P);
+    // Start the transfer of the particles that moved outside the local domain,
+    // it progresses while the hydro is updated
+    G.Start_Transfer_Particles_Boundaries(P);
 #endif
 
     // Advance the grid by one timestep
-    dti = G.Update_Hydro_Grid();
+#ifdef LOCAL_TIMESTEPS
+    // Every rank takes the substeps of its own level, with the boundaries
+    // exchanged between them
+    G.local_timesteps->Advance(P);
+#else   // not LOCAL_TIMESTEPS
+    G.Update_Hydro_Grid(&P);
+#endif  // LOCAL_TIMESTEPS
+#ifdef LAGGED_DT
+    // Take the step again if its lagged timestep was too long
+    if (G.Retake_Lagged_Step()) {
+      G.Update_Hydro_Grid(&P);
+    }
+#endif  // LAGGED_DT
+
+#ifdef PARTICLES
+    // The transferred particles are needed by the next density deposit
+    G.Finish_Transfer_Particles_Boundaries(P);
+#endif
 
     // update the simulation time ( t += dt )
     G.Update_Time();
@@ -304,12 +388,13 @@ int main(int argc, char *argv[])
 #endif
 
 #ifdef CPU_TIME
-    cuda_utilities::Print_GPU_Memory_Usage();
     G.Timer.Total.End();
 #endif  // CPU_TIME
 
 #ifdef CPU_TIME
+    G.Timer.Reduce_Step();
     G.Timer.Print_Times();
+    G.Timer.Write_Step_Record(G.H.n_step, G.H.t, G.H.dt);
 #endif
 
     // get the time to compute the total timestep
@@ -323,6 +408,7 @@ int main(int argc, char *argv[])
         "n_step: %d   sim time: %10.7f   sim timestep: %7.4e  timestep time = "
         "%9.3f ms   total time = %9.4f s\n\n",
         G.H.n_step, G.H.t, G.H.dt, (stop_step - start_step) * 1000, G.H.t_wall);
+    roofline::Print_Step_Throughput(Real(P.nx) * P.ny * P.nz, G.H.n_fields, stop_step - start_step);
 
     if (P.output_always) G.H.Output_Now = true;
 
@@ -330,6 +416,9 @@ int main(int argc, char *argv[])
     if (G.Analysis.Output_Now) {
       G.Compute_and_Output_Analysis(&P);
     }
+  #ifdef ASYNC_ANALYSIS
+    G.Poll_Analysis(&P);
+  #endif  // ASYNC_ANALYSIS
   #if defined(SUPERNOVA) && defined(PARTICLE_AGE)
     sn_analysis.Compute_Gas_Velocity_Dispersion(G);
   #endif
@@ -339,21 +428,42 @@ int main(int argc, char *argv[])
     // G.H.Output_Now = true;
 
     if (G.H.t == outtime || G.H.Output_Now) {
+#if defined(ANALYSIS) && defined(SUPERNOVA) && defined(PARTICLE_AGE)
+      sn_analysis.Output_Gas_Velocity_Dispersion();
+#endif
 #ifdef OUTPUT
       /*output the grid data*/
       Write_Data(G, P, nfile);
       // add one to the output file count
       nfile++;
 #endif  // OUTPUT
+      // The usage is tracked locally, the report is the only collective
+      cuda_utilities::Print_Pool_Usage();
       if (G.H.t == outtime) {
         outtime += P.outstep;  // update to the next output time
       }
     }
 
+#ifdef MPI_CHOLLA
+    if (P.buddy_checkpoint_steps > 0 and G.H.n_step % P.buddy_checkpoint_steps == 0) {
+      buddy_checkpoint::Save(G, outtime, nfile);
+    }
+#endif  // MPI_CHOLLA
+
 #ifdef CPU_TIME
     G.Timer.n_steps += 1;
 #endif
 
+    // The first step is excluded from the benchmark since it always takes longer
+    if (P.benchmark_steps > 0) {
+      if (G.H.n_step > 1) {
+        benchmark_time += stop_step - start_step;
+      }
+      if (G.H.n_step == P.benchmark_steps) {
+        break;
+      }
+    }
+
 #ifdef N_STEPS_LIMIT
     // Exit the loop when reached the limit number of steps (optional)
     if (G.H.n_step == N_STEPS_LIMIT) {
@@ -372,24 +482,71 @@ int main(int argc, char *argv[])
     }
 #endif
 
-#ifdef MHD
-    // Check that the magnetic field has zero divergence
-    mhd::checkMagneticDivergence(G);
-#endif  // MHD
-  }     /*end loop over timesteps*/
+    // With MHD the divergence of the magnetic field is checked by the next
+    // set_dt, from the reduction of the inverse timestep
+  } /*end loop over timesteps*/
+
+#if defined(ANALYSIS) && defined(ASYNC_ANALYSIS)
+  // The last analysis may still be computed by the analysis thread
+  G.Finish_Analysis(&P);
+#endif
+
+#if defined(ANALYSIS) && defined(SUPERNOVA) && defined(PARTICLE_AGE)
+  // Print the velocity dispersions of the steps since the last output
+  sn_analysis.Output_Gas_Velocity_Dispersion();
+#endif
+
+  if (P.benchmark_steps > 1) {
+#ifdef MPI_CHOLLA
+    benchmark_time = ReduceRealMax(benchmark_time);
+#endif
+    chprintf("\nBenchmark: %d steps of %d x %d x %d cells, average of the last %d steps\n", P.benchmark_steps, P.nx,
+             P.ny, P.nz, P.benchmark_steps - 1);
+    roofline::Print_Step_Throughput(Real(P.nx) * P.ny * P.nz, G.H.n_fields,
+                                    benchmark_time / (P.benchmark_steps - 1));
+#ifdef PARTICLES
+    if (benchmark_time > 0) {
+      chprintf("particle updates/s/GPU: %9.3e\n",
+               Real(G.Particles.n_total_initial) / nproc / (benchmark_time / (P.benchmark_steps - 1)));
+    }
+#endif  // PARTICLES
+  }
 
 #ifdef CPU_TIME
   // Print timing statistics
   G.Timer.Print_Average_Times(P);
+  #ifdef MPI_CHOLLA
+  if (P.load_balance_file[0] != '\0') {
+    Write_Load_Balanced_Slabs(P.load_balance_file, G.Timer.local_work, G.H.n_ghost);
+  }
+  #endif  // MPI_CHOLLA
 #endif
 
+  cuda_utilities::Print_Pool_Usage();
+  cuda_utilities::Print_GPU_Memory_Usage();
+#ifdef LAUNCH_AUTOTUNE
+  cuda_utilities::Save_Launch_Cache();
+#endif  // LAUNCH_AUTOTUNE
+
   message = "Simulation completed successfully.";
   Write_Message_To_Log_File(message.c_str());
 
+#ifdef ASYNC_OUTPUT
+  // The last snapshot may still be written by the I/O thread
+  Wait_Async_Output();
+#endif
+  if (P.checkpoint_dir[0] != '\0') {
+    // The last checkpoint may still be drained to the output directory
+    Wait_Checkpoint_Drain();
+  }
+
   // free the grid
   G.Reset();
 
 #ifdef MPI_CHOLLA
+  #ifdef NVSHMEM_BOUNDARIES
+  Finalize_NVSHMEM();
+  #endif  // NVSHMEM_BOUNDARIES
   MPI_Finalize();
 #endif /*MPI_CHOLLA*/
 
@@ -22,6 +22,8 @@ testing_utilities::GlobalString globalChollaRoot;
 testing_utilities::GlobalString globalChollaBuild;
 testing_utilities::GlobalString globalChollaMachine;
 testing_utilities::GlobalString globalMpiLauncher;
+testing_utilities::GlobalString globalPerformanceMode;
+double globalPerformanceThreshold;
 bool globalRunCholla;
 bool globalCompareSystemTestResults;
 
@@ -102,7 +104,11 @@ class InputParser
  * \param argv A list of the CLI arguments. Requires that `--cholla-root` be set
  * to the root directory of Cholla, `--build-type` be set to the make type used
  * to build cholla and the tests, and `--machine` be set to the name of the
- * machine being used, this must be the same name as in the `make.host` file
+ * machine being used, this must be the same name as in the `make.host` file.
+ * Optionally `--perf-mode record` or `--perf-mode compare` times the system
+ * tests against the baseline of the machine, see
+ * SystemTestRunner::launchCholla, with `--perf-threshold` the allowed
+ * slowdown as a fraction
  * \return int
  */
 int main(int argc, char **argv)
@@ -128,6 +134,16 @@ int main(int argc, char **argv)
     globalMpiLauncher.init("mpirun -np");
   }
 
+  // The performance mode of the system tests, `record` or `compare`, and the
+  // fraction by which a phase may be slower than its baseline
+  if (input.Cmd_Option_Exists("--perf-mode")) {
+    globalPerformanceMode.init(input.Get_Cmd_Option("--perf-mode"));
+  }
+  globalPerformanceThreshold = 0.15;
+  if (input.Cmd_Option_Exists("--perf-threshold")) {
+    globalPerformanceThreshold = std::stod(input.Get_Cmd_Option("--perf-threshold"));
+  }
+
   globalRunCholla                = not input.Cmd_Option_Exists("--runCholla=false");
   globalCompareSystemTestResults = not input.Cmd_Option_Exists("--compareSystemTestResults=false");
 
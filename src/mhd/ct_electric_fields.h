@@ -118,6 +118,286 @@ inline __host__ __device__ Real _ctSlope(Real const *flux, Real const *dev_conse
   return electric_face - electric_centered;
 }
 // =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Compute the three CT electric fields on the edges at the lower
+ * corner of cell (xid, yid, zid), i.e. the x field on the y-1/2, z-1/2 edge
+ * and cyclically for the other two. This function implements S&G 2009
+ * equations 22 and 23. The cell has to satisfy 0 < xid < nx, 0 < yid < ny
+ * and 0 < zid < nz
+ *
+ * \param[in] fluxX The flux on the x+1/2 face of each cell
+ * \param[in] fluxY The flux on the y+1/2 face of each cell
+ * \param[in] fluxZ The flux on the z+1/2 face of each cell
+ * \param[in] dev_conserved The conserved variable array
+ * \param[in] xid The x index
+ * \param[in] yid The y index
+ * \param[in] zid The z index
+ * \param[in] nx The number of cells in the x-direction
+ * \param[in] ny The number of cells in the y-direction
+ * \param[in] n_cells The total number of cells
+ * \return auto local struct with the X, Y, and Z electric fields. Intended
+ * to be called with structured binding like `auto [x, y, z] =
+ * mhd::internal::_ctElectricFields(*args*)`
+ */
+inline __host__ __device__ auto _ctElectricFields(Real const *fluxX, Real const *fluxY, Real const *fluxZ,
+                                                  Real const *dev_conserved, int const &xid, int const &yid,
+                                                  int const &zid, int const &nx, int const &ny, int const &n_cells)
+{
+  // According to Stone et al. 2008 section 5.3 and the source code of
+  // Athena, the following equation relate the magnetic flux to the
+  // face centered electric fields/EMF. -cross(V,B)x is the negative
+  // of the x-component of V cross B. Note that "X" is the direction
+  // the solver is running in this case, not necessarily the true "X".
+  //  F_x[(grid_enum::fluxX_magnetic_z)*n_cells] = VxBy - BxVy =
+  //  -(-cross(V,B))z = -EMF_Z F_x[(grid_enum::fluxX_magnetic_y)*n_cells] =
+  //  VxBz - BxVz =  (-cross(V,B))y =  EMF_Y
+  //  F_y[(grid_enum::fluxY_magnetic_x)*n_cells] = VxBy - BxVy =
+  //  -(-cross(V,B))z = -EMF_X F_y[(grid_enum::fluxY_magnetic_z)*n_cells] =
+  //  VxBz - BxVz =  (-cross(V,B))y =  EMF_Z
+  //  F_z[(grid_enum::fluxZ_magnetic_y)*n_cells] = VxBy - BxVy =
+  //  -(-cross(V,B))z = -EMF_Y F_z[(grid_enum::fluxZ_magnetic_x)*n_cells] =
+  //  VxBz - BxVz =  (-cross(V,B))y =  EMF_X
+
+  // Notes on Implementation Details
+  // - The density flux has the same sign as the velocity on the face
+  //   and we only care about the sign so we're using the density flux
+  //   to perform upwinding checks
+  // - All slopes are computed without the factor of two shown in
+  //   Stone & Gardiner 2008 eqn. 24. That factor of two is taken care
+  //   of in the final assembly of the electric field
+
+  // Variable to get the sign of the velocity at the interface.
+  Real signUpwind;
+
+  // Slope and face variables. Format is
+  // "<slope/face>_<direction>_<pos/neg>". Slope/Face indicates if the
+  // value is a slope or a face centered EMF, direction indicates the
+  // direction of the derivative/face and pos/neg indicates if it's
+  // the slope on the positive or negative side of the edge field
+  // being computed. Note that the direction for the face is parallel
+  // to the face and the other direction that is parallel to that face
+  // is the direction of the electric field being calculated
+  Real slope_x_pos, slope_x_neg, slope_y_pos, slope_y_neg, slope_z_pos, slope_z_neg, face_x_pos, face_x_neg,
+      face_y_pos, face_y_neg, face_z_pos, face_z_neg;
+  // ================
+  // X electric field
+  // ================
+
+  // Y-direction slope on the positive Y side. S&G 2009 equation 23
+  signUpwind = fluxZ[cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_y_pos = mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 2, -1, 1, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_y_pos = mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, -1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_y_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 2, -1, 1, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, -1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Y-direction slope on the negative Y side. S&G 2009 equation 23
+  signUpwind = fluxZ[cuda_utilities::compute1DIndex(xid, yid - 1, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_y_neg = mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 1, 2, 1, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_y_neg = mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_y_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 1, 2, 1, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxY, dev_conserved, -1, 0, 1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Z-direction slope on the positive Z side. S&G 2009 equation 23
+  signUpwind = fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_z_pos = mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 1, -1, 1, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_z_pos = mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, -1, -1, 2, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_z_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 1, -1, 1, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, -1, -1, 2, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Z-direction slope on the negative Z side. S&G 2009 equation 23
+  signUpwind = fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_z_neg = mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 1, 2, 1, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_z_neg = mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 2, -1, -1, 2, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_z_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 1, 2, 1, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxZ, dev_conserved, 1, 0, 2, -1, -1, 2, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Load the face centered electric fields  Note the negative signs to
+  // convert from magnetic flux to electric field
+
+  face_y_pos =
+      +fluxZ[cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny) + (grid_enum::fluxZ_magnetic_x)*n_cells];
+  face_y_neg =
+      +fluxZ[cuda_utilities::compute1DIndex(xid, yid - 1, zid - 1, nx, ny) + (grid_enum::fluxZ_magnetic_x)*n_cells];
+  face_z_pos =
+      -fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny) + (grid_enum::fluxY_magnetic_x)*n_cells];
+  face_z_neg =
+      -fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid - 1, nx, ny) + (grid_enum::fluxY_magnetic_x)*n_cells];
+
+  // sum and average face centered electric fields and slopes to get the
+  // edge averaged electric field.
+  // S&G 2009 equation 22
+  Real const electric_x =
+      0.25 *
+      (+face_y_pos + face_y_neg + face_z_pos + face_z_neg + slope_y_pos + slope_y_neg + slope_z_pos + slope_z_neg);
+
+  // ================
+  // Y electric field
+  // ================
+
+  // X-direction slope on the positive X side. S&G 2009 equation 23
+  signUpwind = fluxZ[cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_x_pos = mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 2, -1, 0, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_x_pos = mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, -1, -1, 0, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_x_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 2, -1, 0, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, -1, -1, 0, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // X-direction slope on the negative X side. S&G 2009 equation 23
+  signUpwind = fluxZ[cuda_utilities::compute1DIndex(xid - 1, yid, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_x_neg = mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 0, 2, 0, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_x_neg = mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 0, -1, 0, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_x_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 0, 2, 0, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxX, dev_conserved, 1, 1, 0, -1, 0, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Z-direction slope on the positive Z side. S&G 2009 equation 23
+  signUpwind = fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_z_pos = mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 0, -1, 0, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_z_pos = mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, -1, -1, 2, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_z_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 0, -1, 0, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, -1, -1, 2, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Z-direction slope on the negative Z side. S&G 2009 equation 23
+  signUpwind = fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid - 1, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_z_neg = mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 0, 2, 0, 2, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_z_neg = mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 2, -1, 2, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_z_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 0, 2, 0, 2, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxZ, dev_conserved, -1, 1, 2, -1, 2, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Load the face centered electric fields  Note the negative signs to
+  // convert from magnetic flux to electric field
+  face_x_pos =
+      -fluxZ[cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny) + (grid_enum::fluxZ_magnetic_y)*n_cells];
+  face_x_neg =
+      -fluxZ[cuda_utilities::compute1DIndex(xid - 1, yid, zid - 1, nx, ny) + (grid_enum::fluxZ_magnetic_y)*n_cells];
+  face_z_pos =
+      +fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny) + (grid_enum::fluxX_magnetic_y)*n_cells];
+  face_z_neg =
+      +fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid - 1, nx, ny) + (grid_enum::fluxX_magnetic_y)*n_cells];
+
+  // sum and average face centered electric fields and slopes to get the
+  // edge averaged electric field.
+  // S&G 2009 equation 22
+  Real const electric_y =
+      0.25 *
+      (+face_x_pos + face_x_neg + face_z_pos + face_z_neg + slope_x_pos + slope_x_neg + slope_z_pos + slope_z_neg);
+
+  // ================
+  // Z electric field
+  // ================
+
+  // Y-direction slope on the positive Y side. S&G 2009 equation 23
+  signUpwind = fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_y_pos = mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 0, -1, 0, 1, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_y_pos = mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, -1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_y_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 0, -1, 0, 1, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, -1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Y-direction slope on the negative Y side. S&G 2009 equation 23
+  signUpwind = fluxX[cuda_utilities::compute1DIndex(xid - 1, yid - 1, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_y_neg = mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 0, 1, 0, 1, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_y_neg = mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_y_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 0, 1, 0, 1, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxY, dev_conserved, 1, 2, 1, -1, 1, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // X-direction slope on the positive X side. S&G 2009 equation 23
+  signUpwind = fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_x_pos = mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 1, -1, 0, 1, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_x_pos = mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, -1, -1, 0, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_x_pos =
+        0.5 * (mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 1, -1, 0, 1, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, -1, -1, 0, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // X-direction slope on the negative X side. S&G 2009 equation 23
+  signUpwind = fluxY[cuda_utilities::compute1DIndex(xid - 1, yid - 1, zid, nx, ny) + grid_enum::density * n_cells];
+  if (signUpwind > 0.0) {
+    slope_x_neg = mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 0, 1, 0, 1, xid, yid, zid, nx, ny, n_cells);
+  } else if (signUpwind < 0.0) {
+    slope_x_neg = mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 0, -1, 0, -1, xid, yid, zid, nx, ny, n_cells);
+  } else {
+    slope_x_neg =
+        0.5 * (mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 0, 1, 0, 1, xid, yid, zid, nx, ny, n_cells) +
+               mhd::internal::_ctSlope(fluxX, dev_conserved, -1, 2, 0, -1, 0, -1, xid, yid, zid, nx, ny, n_cells));
+  }
+
+  // Load the face centered electric fields  Note the negative signs to
+  // convert from magnetic flux to electric field
+  face_x_pos =
+      +fluxY[cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny) + (grid_enum::fluxY_magnetic_z)*n_cells];
+  face_x_neg =
+      +fluxY[cuda_utilities::compute1DIndex(xid - 1, yid - 1, zid, nx, ny) + (grid_enum::fluxY_magnetic_z)*n_cells];
+  face_y_pos =
+      -fluxX[cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny) + (grid_enum::fluxX_magnetic_z)*n_cells];
+  face_y_neg =
+      -fluxX[cuda_utilities::compute1DIndex(xid - 1, yid - 1, zid, nx, ny) + (grid_enum::fluxX_magnetic_z)*n_cells];
+
+  // sum and average face centered electric fields and slopes to get the
+  // edge averaged electric field.
+  // S&G 2009 equation 22
+  Real const electric_z =
+      0.25 *
+      (+face_x_pos + face_x_neg + face_y_pos + face_y_neg + slope_x_pos + slope_x_neg + slope_y_pos + slope_y_neg);
+
+  struct ReturnStruct {
+    Real x, y, z;
+  };
+  return ReturnStruct{electric_x, electric_y, electric_z};
+}
+// =====================================================================
 }  // namespace internal
 
 // =========================================================================
@@ -24,6 +24,7 @@
 #include "../utils/DeviceVector.h"
 #include "../utils/cuda_utilities.h"
 #include "../utils/error_handling.h"
+#include "../utils/mhd_utilities.h"
 #include "../utils/reduction_utilities.h"
 #ifdef MHD
 
@@ -35,11 +36,10 @@ __global__ void calculateMagneticDivergence(Real const *dev_conserved, Real *dev
                                             int const n_cells)
 {
   // Variables to store the divergence
-  Real cellDivergence;
   Real maxDivergence = 0.0;
 
   // Index variables
-  int xid, yid, zid, id_xMin1, id_yMin1, id_zMin1;
+  int xid, yid, zid;
 
   // Grid stride loop to perform as much of the reduction as possible
   for (size_t id = threadIdx.x + blockIdx.x * blockDim.x; id < n_cells; id += blockDim.x * gridDim.x) {
@@ -49,23 +49,8 @@ __global__ void calculateMagneticDivergence(Real const *dev_conserved, Real *dev
     // Thread guard to avoid overrun and to skip ghost cells that cannot
     // have their divergences computed due to a missing face;
     if (xid > 1 and yid > 1 and zid > 1 and xid < nx and yid < ny and zid < nz) {
-      // Compute the various offset indices
-      id_xMin1 = cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny);
-      id_yMin1 = cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny);
-      id_zMin1 = cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny);
-
-      // Compute divergence
-      // Stone et al. 2008 equation 25
-      cellDivergence = ((dev_conserved[id + (grid_enum::magnetic_x)*n_cells] -
-                         dev_conserved[id_xMin1 + (grid_enum::magnetic_x)*n_cells]) /
-                        dx) +
-                       ((dev_conserved[id + (grid_enum::magnetic_y)*n_cells] -
-                         dev_conserved[id_yMin1 + (grid_enum::magnetic_y)*n_cells]) /
-                        dy) +
-                       ((dev_conserved[id + (grid_enum::magnetic_z)*n_cells] -
-                         dev_conserved[id_zMin1 + (grid_enum::magnetic_z)*n_cells]) /
-                        dz);
-
+      Real const cellDivergence =
+          mhd::utils::computeMagneticDivergence(dev_conserved, id, xid, yid, zid, n_cells, nx, ny, dx, dy, dz);
       maxDivergence = max(maxDivergence, fabs(cellDivergence));
     }
   }
@@ -98,6 +83,14 @@ Real checkMagneticDivergence(Grid3D const &G)
   max_magnetic_divergence = ReduceRealMax(max_magnetic_divergence);
   #endif  // MPI_CHOLLA
 
+  checkMagneticDivergenceLimit(max_magnetic_divergence);
+  return max_magnetic_divergence;
+}
+// =============================================================================
+
+// =============================================================================
+void checkMagneticDivergenceLimit(Real const max_magnetic_divergence)
+{
   // If the magnetic divergence is greater than the limit then raise a warning and exit.
   // This maximum value of divergence was chosen after a discussion with Chris White of the Flatiron institute and an
   // Athena dev. He said that in his experience issues start showing up at around 1E-8 divergence so this is set with an
@@ -118,8 +111,6 @@ Real checkMagneticDivergence(Grid3D const &G)
   {
     chprintf("Global maximum magnetic divergence = %7.4e\n", max_magnetic_divergence);
   }
-
-  return max_magnetic_divergence;
 }
 // =============================================================================
 }  // end namespace mhd
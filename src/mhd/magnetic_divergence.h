@@ -60,4 +60,17 @@ __global__ void calculateMagneticDivergence(Real const *dev_conserved, Real *max
  */
 Real checkMagneticDivergence(Grid3D const &G);
 // =========================================================================
+
+// =========================================================================
+/*!
+ * \brief Report an error and exit if the global maximum magnetic divergence
+ * exceeds the magnetic divergence limit or is negative, otherwise print it.
+ * The time step loop checks the divergence that Calc_dt_3D reduces with the
+ * inverse time step instead of launching calculateMagneticDivergence
+ *
+ * \param max_magnetic_divergence The maximum magnetic divergence over all the
+ * ranks
+ */
+void checkMagneticDivergenceLimit(Real const max_magnetic_divergence);
+// =========================================================================
 }  // end namespace mhd
\ No newline at end of file
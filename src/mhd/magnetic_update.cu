@@ -12,6 +12,7 @@
 // External Includes
 
 // Local Includes
+#include "../mhd/ct_electric_fields.h"
 #include "../mhd/magnetic_update.h"
 #include "../utils/cuda_utilities.h"
 #ifdef MHD
@@ -80,5 +81,112 @@ __global__ void Update_Magnetic_Field_3D(Real *sourceGrid, Real *destinationGrid
   }
 }
 // =========================================================================
+
+// =========================================================================
+__global__ void Update_Magnetic_Field_3D_Fused(Real const *fluxX, Real const *fluxY, Real const *fluxZ,
+                                               Real const *ctGrid, Real const *sourceGrid, Real *destinationGrid,
+                                               int const nx, int const ny, int const nz, int const n_cells,
+                                               Real const dt, Real const dx, Real const dy, Real const dz)
+{
+  // The edges at the lower corners of the cells of the tile and of the cells
+  // just past its high x and y sides
+  int constexpr edgesX = internal::fusedTileX + 1;
+  int constexpr nEdges = edgesX * (internal::fusedTileY + 1);
+
+  // The X, Y, and Z electric fields of two planes of edges, the one below the
+  // current layer of cells and the one above it. Which buffer a plane is in
+  // alternates with the parity of its z index
+  __shared__ Real electricFields[2][3][nEdges];
+
+  // Find the column of cells of this block
+  int const nTilesX = (nx + internal::fusedTileX - 1) / internal::fusedTileX;
+  int const nTilesY = (ny + internal::fusedTileY - 1) / internal::fusedTileY;
+  int const xStart  = (blockIdx.x % nTilesX) * internal::fusedTileX;
+  int const yStart  = ((blockIdx.x / nTilesX) % nTilesY) * internal::fusedTileY;
+  int const zBlock  = (blockIdx.x / (nTilesX * nTilesY)) * internal::fusedTileZ;
+
+  // Skip the first and last layers of cells like Update_Magnetic_Field_3D
+  int const zStart = max(zBlock, 1);
+  int const zEnd   = min(zBlock + internal::fusedTileZ, nz - 1);
+  if (zStart >= zEnd) {
+    return;
+  }
+
+  // Compute the electric fields of a plane of edges with the same thread
+  // guard as Calculate_CT_Electric_Fields, the edges outside of it are never
+  // used by the update
+  auto computePlane = [&](int const zid) {
+    int const buffer = zid % 2;
+    for (int edge = threadIdx.x; edge < nEdges; edge += blockDim.x) {
+      int const xid = xStart + edge % edgesX;
+      int const yid = yStart + edge / edgesX;
+      if (xid > 0 and yid > 0 and zid > 0 and xid < nx and yid < ny and zid < nz) {
+        auto const [electric_x, electric_y, electric_z] =
+            mhd::internal::_ctElectricFields(fluxX, fluxY, fluxZ, ctGrid, xid, yid, zid, nx, ny, n_cells);
+        electricFields[buffer][0][edge] = electric_x;
+        electricFields[buffer][1][edge] = electric_y;
+        electricFields[buffer][2][edge] = electric_z;
+      }
+    }
+  };
+
+  // Compute the three dt/dx quantities
+  Real const dtodx = dt / dx;
+  Real const dtody = dt / dy;
+  Real const dtodz = dt / dz;
+
+  // The cell of this thread in each layer and its lower corner edge
+  int const xid  = xStart + int(threadIdx.x) % internal::fusedTileX;
+  int const yid  = yStart + int(threadIdx.x) / internal::fusedTileX;
+  int const edge = int(threadIdx.x) % internal::fusedTileX + (int(threadIdx.x) / internal::fusedTileX) * edgesX;
+
+  computePlane(zStart);
+  for (int zid = zStart; zid < zEnd; zid++) {
+    computePlane(zid + 1);
+    __syncthreads();
+
+    // Thread guard to avoid overrun and to skip ghost cells that cannot be
+    // evolved due to missing electric fields that can't be reconstructed
+    if (threadIdx.x < internal::fusedTileX * internal::fusedTileY and xid > 0 and yid > 0 and xid < nx - 1 and
+        yid < ny - 1) {
+      int const id    = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+      Real const *low = &electricFields[zid % 2][0][0];
+      Real const *up  = &electricFields[(zid + 1) % 2][0][0];
+
+      // Load the same edge electric fields as Update_Magnetic_Field_3D
+      Real const electric_x_1 = low[grid_enum::ct_elec_x * nEdges + edge + edgesX];
+      Real const electric_x_2 = up[grid_enum::ct_elec_x * nEdges + edge];
+      Real const electric_x_3 = up[grid_enum::ct_elec_x * nEdges + edge + edgesX];
+      Real const electric_y_1 = low[grid_enum::ct_elec_y * nEdges + edge + 1];
+      Real const electric_y_2 = up[grid_enum::ct_elec_y * nEdges + edge];
+      Real const electric_y_3 = up[grid_enum::ct_elec_y * nEdges + edge + 1];
+      Real const electric_z_1 = low[grid_enum::ct_elec_z * nEdges + edge + 1];
+      Real const electric_z_2 = low[grid_enum::ct_elec_z * nEdges + edge + edgesX];
+      Real const electric_z_3 = low[grid_enum::ct_elec_z * nEdges + edge + edgesX + 1];
+
+      // X field update
+      // S&G 2009 equation 10
+      destinationGrid[id + grid_enum::magnetic_x * n_cells] = sourceGrid[id + grid_enum::magnetic_x * n_cells] +
+                                                              dtodz * (electric_y_3 - electric_y_1) +
+                                                              dtody * (electric_z_1 - electric_z_3);
+
+      // Y field update
+      // S&G 2009 equation 11
+      destinationGrid[id + grid_enum::magnetic_y * n_cells] = sourceGrid[id + grid_enum::magnetic_y * n_cells] +
+                                                              dtodx * (electric_z_3 - electric_z_2) +
+                                                              dtodz * (electric_x_1 - electric_x_3);
+
+      // Z field update
+      // S&G 2009 equation 12
+      destinationGrid[id + grid_enum::magnetic_z * n_cells] = sourceGrid[id + grid_enum::magnetic_z * n_cells] +
+                                                              dtody * (electric_x_3 - electric_x_2) +
+                                                              dtodx * (electric_y_2 - electric_y_3);
+    }
+
+    // The buffer of the lower plane is overwritten by the next iteration
+    __syncthreads();
+  }
+}
+// =========================================================================
 }  // end namespace mhd
 #endif  // MHD
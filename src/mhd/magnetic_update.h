@@ -48,4 +48,76 @@ __global__ void Update_Magnetic_Field_3D(Real *sourceGrid, Real *destinationGrid
                                          int const ny, int const nz, int const n_cells, Real const dt, Real const dx,
                                          Real const dy, Real const dz);
 // =========================================================================
+
+/*!
+ * \brief Namespace for functions required by functions within the mhd
+ * namespace. Everything in this name space should be regarded as private
+ * but is made accesible for testing
+ *
+ */
+namespace internal
+{
+/// The cells in the x and y directions of the tiles of
+/// Update_Magnetic_Field_3D_Fused, one thread per cell of the tile
+int constexpr fusedTileX = 32;
+int constexpr fusedTileY = TPB / fusedTileX;
+/// The cells in the z-direction that each block of
+/// Update_Magnetic_Field_3D_Fused marches through
+int constexpr fusedTileZ = 16;
+}  // namespace internal
+
+// =========================================================================
+/*!
+ * \brief Compute the CT electric fields and update the magnetic field in a
+ * single kernel, the fused version of Calculate_CT_Electric_Fields and
+ * Update_Magnetic_Field_3D. Each block marches through a column of
+ * fusedTileX * fusedTileY cells in the z-direction and keeps the electric
+ * fields of the two edge planes of the current layer in shared memory, so
+ * the electric fields never go through global memory. The edges on the high
+ * x and y sides of the tile are computed by both neighboring blocks. Launch
+ * it with TPB threads per block and fusedMagneticUpdateBlocks(nx, ny, nz)
+ * blocks
+ *
+ * \param[in] fluxX The flux on the x+1/2 face of each cell
+ * \param[in] fluxY The flux on the y+1/2 face of each cell
+ * \param[in] fluxZ The flux on the z+1/2 face of each cell
+ * \param[in] ctGrid The conserved variables that the electric fields are
+ * computed from, i.e. the dev_conserved argument of
+ * Calculate_CT_Electric_Fields
+ * \param[in] sourceGrid The array which holds the old values of the
+ * magnetic field
+ * \param[out] destinationGrid The array to hold the updated values of the
+ * magnetic field. It can be sourceGrid but not ctGrid
+ * \param[in] nx The number of cells in the x-direction
+ * \param[in] ny The number of cells in the y-direction
+ * \param[in] nz The number of cells in the z-direction
+ * \param[in] n_cells The total number of cells
+ * \param[in] dt The time step. If doing the half time step update make sure
+ * to divide it by two when passing the time step to this kernel
+ * \param[in] dx The size of each cell in the x-direction
+ * \param[in] dy The size of each cell in the y-direction
+ * \param[in] dz The size of each cell in the z-direction
+ */
+__global__ void Update_Magnetic_Field_3D_Fused(Real const *fluxX, Real const *fluxY, Real const *fluxZ,
+                                               Real const *ctGrid, Real const *sourceGrid, Real *destinationGrid,
+                                               int const nx, int const ny, int const nz, int const n_cells,
+                                               Real const dt, Real const dx, Real const dy, Real const dz);
+// =========================================================================
+
+// =========================================================================
+/*!
+ * \brief The number of blocks to launch Update_Magnetic_Field_3D_Fused with
+ *
+ * \param[in] nx The number of cells in the x-direction
+ * \param[in] ny The number of cells in the y-direction
+ * \param[in] nz The number of cells in the z-direction
+ * \return int The number of blocks, one per column of cells
+ */
+inline int fusedMagneticUpdateBlocks(int const nx, int const ny, int const nz)
+{
+  return ((nx + internal::fusedTileX - 1) / internal::fusedTileX) *
+         ((ny + internal::fusedTileY - 1) / internal::fusedTileY) *
+         ((nz + internal::fusedTileZ - 1) / internal::fusedTileZ);
+}
+// =========================================================================
 }  // end namespace mhd
\ No newline at end of file
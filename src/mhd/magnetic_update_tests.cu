@@ -8,6 +8,7 @@
 // STL Includes
 #include <iostream>
 #include <numeric>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -15,7 +16,9 @@
 #include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
 
 // Local Includes
+#include "../mhd/ct_electric_fields.h"
 #include "../mhd/magnetic_update.h"
+#include "../utils/DeviceVector.h"
 #include "../utils/cuda_utilities.h"
 #include "../utils/testing_utilities.h"
 
@@ -124,4 +127,54 @@ TEST_F(tMHDUpdateMagneticField3D, CorrectInputExpectCorrectOutput)
   Run_Test();
 }
 // =============================================================================
+
+// =============================================================================
+TEST(tMHDUpdateMagneticField3DFused, RandomInputExpectSameAsUnfusedKernels)
+{
+  // A grid that is cut by the edges of the tiles in every direction
+  int const nx = mhd::internal::fusedTileX + 5, ny = 2 * mhd::internal::fusedTileY + 3,
+            nz = mhd::internal::fusedTileZ + 4;
+  int const n_cells = nx * ny * nz;
+  Real const dt = 0.1, dx = 0.5, dy = 0.6, dz = 0.7;
+
+  // Positive values everywhere so that the density is never zero
+  std::mt19937 prng(1);
+  std::uniform_real_distribution<double> distribution(1, 2);
+  std::vector<Real> conserved(n_cells * grid_enum::num_fields), flux(n_cells * (grid_enum::num_fields - 1));
+  for (Real &value : conserved) {
+    value = distribution(prng);
+  }
+  cuda_utilities::DeviceVector<Real> dev_conserved(conserved.size()), dev_fluxX(flux.size()), dev_fluxY(flux.size()),
+      dev_fluxZ(flux.size());
+  dev_conserved.cpyHostToDevice(conserved);
+  for (auto *dev_flux : {&dev_fluxX, &dev_fluxY, &dev_fluxZ}) {
+    for (Real &value : flux) {
+      value = distribution(prng) - 1.5;
+    }
+    dev_flux->cpyHostToDevice(flux);
+  }
+
+  // The fiducial update of the unfused kernels
+  cuda_utilities::DeviceVector<Real> dev_ctElectricFields(3 * n_cells, true);
+  cuda_utilities::DeviceVector<Real> dev_fiducial(conserved.size()), dev_test(conserved.size());
+  dev_fiducial.cpyHostToDevice(conserved);
+  dev_test.cpyHostToDevice(conserved);
+  dim3 const dimGrid((n_cells + TPB - 1) / TPB, 1, 1), dimBlock(TPB, 1, 1);
+  hipLaunchKernelGGL(mhd::Calculate_CT_Electric_Fields, dimGrid, dimBlock, 0, 0, dev_fluxX.data(), dev_fluxY.data(),
+                     dev_fluxZ.data(), dev_conserved.data(), dev_ctElectricFields.data(), nx, ny, nz, n_cells);
+  hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D, dimGrid, dimBlock, 0, 0, dev_conserved.data(), dev_fiducial.data(),
+                     dev_ctElectricFields.data(), nx, ny, nz, n_cells, dt, dx, dy, dz);
+  hipLaunchKernelGGL(mhd::Update_Magnetic_Field_3D_Fused, mhd::fusedMagneticUpdateBlocks(nx, ny, nz), TPB, 0, 0,
+                     dev_fluxX.data(), dev_fluxY.data(), dev_fluxZ.data(), dev_conserved.data(), dev_conserved.data(),
+                     dev_test.data(), nx, ny, nz, n_cells, dt, dx, dy, dz);
+  GPU_Error_Check();
+
+  std::vector<Real> fiducialData(conserved.size()), testData(conserved.size());
+  dev_fiducial.cpyDeviceToHost(fiducialData);
+  dev_test.cpyDeviceToHost(testData);
+  for (size_t i = grid_enum::magnetic_x * n_cells; i < fiducialData.size(); i++) {
+    testing_utilities::Check_Results(fiducialData.at(i), testData.at(i), "value at i = " + std::to_string(i));
+  }
+}
+// =============================================================================
 #endif  // MHD
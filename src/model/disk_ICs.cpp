@@ -9,7 +9,9 @@
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "../global/global.h"
 #include "../grid/grid3D.h"
@@ -732,15 +734,70 @@ Real Halo_Density_D3D(Real r, Real *r_halo, Real *rho_halo, Real dr, int nr)
   return (rho_halo[i + 1] - rho_halo[i]) * (r - r_halo[i]) / (r_halo[i + 1] - r_halo[i]) + rho_halo[i];
 }
 
+/*! \fn std::vector<Real> Hydrostatic_Column_Table_D3D(Real *hdp, Real dR, int
+ nR, Real dz, int nz, int ng)
+ *  \brief Solve the hydrostatic disk column at the nR radii n*dR. The columns
+ are split between the ranks and threads, then the whole table is gathered on
+ every rank. Column n is stored at n*(nz + 2*ng). */
+std::vector<Real> Hydrostatic_Column_Table_D3D(Real *hdp, Real dR, int nR, Real dz, int nz, int ng)
+{
+  int const nzt = nz + 2 * ng;
+  std::vector<Real> table(static_cast<size_t>(nR) * nzt, 0);
+
+  // the contiguous block of radii this rank solves
+  int n_start = 0, n_end = nR;
+#ifdef MPI_CHOLLA
+  std::vector<int> counts(nproc), offsets(nproc);
+  for (int rank = 0; rank < nproc; rank++) {
+    int const first = (int)(((long)nR * rank) / nproc);
+    int const last  = (int)(((long)nR * (rank + 1)) / nproc);
+    offsets[rank]   = first * nzt;
+    counts[rank]    = (last - first) * nzt;
+  }
+  n_start = offsets[procID] / nzt;
+  n_end   = n_start + counts[procID] / nzt;
+#endif  // MPI_CHOLLA
+
+  // the columns near the center converge slowest, so balance them dynamically
+#ifdef PARALLEL_OMP
+  #pragma omp parallel for num_threads(N_OMP_THREADS) schedule(dynamic)
+#endif  // PARALLEL_OMP
+  for (int n = n_start; n < n_end; n++) {
+    Hydrostatic_Column_Isothermal_D3D(&table[static_cast<size_t>(n) * nzt], n * dR, hdp, dz, nz, ng);
+  }
+
+#ifdef MPI_CHOLLA
+  MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, table.data(), counts.data(), offsets.data(), MPI_CHREAL, world);
+#endif  // MPI_CHOLLA
+
+  return table;
+}
+
+/*! \fn void Interpolate_Column_D3D(Real *rho, Real R, std::vector<Real> const
+ &table, Real dR, int nzt)
+ *  \brief Linearly interpolate the column at cylindrical radius R from the
+ columns of Hydrostatic_Column_Table_D3D. */
+void Interpolate_Column_D3D(Real *rho, Real R, std::vector<Real> const &table, Real dR, int nzt)
+{
+  int const nR = table.size() / nzt;
+  Real const s = R / dR;
+  int const n  = std::min((int)s, nR - 2);
+  Real const w = s - n;
+
+  Real const *rho_l = &table[static_cast<size_t>(n) * nzt];
+  Real const *rho_r = rho_l + nzt;
+  for (int k = 0; k < nzt; k++) {
+    rho[k] = (1.0 - w) * rho_l[k] + w * rho_r[k];
+  }
+}
+
 /*! \fn void Disk_3D(Parameters P )
  *  \brief Initialize the grid with a 3D disk. */
 void Grid3D::Disk_3D(Parameters p)
 {
 #ifdef DISK_ICS
 
-  int i, j, k, id;
-  Real x_pos, y_pos, z_pos, r, phi;
-  Real d, a, a_d, a_h, v, vx, vy, vz, P, T_d, T_h, mu;
+  Real T_d, T_h, mu;
   Real M_vir, M_h, M_d, c_vir, R_vir, R_s, R_d, z_d;
   Real K_eos, rho_eos, cs, K_eos_h, rho_eos_h, cs_h;
   Real Sigma_0, R_g, H_g;
@@ -818,10 +875,9 @@ void Grid3D::Disk_3D(Parameters p)
   // Now we can start the density calculation
   // we will loop over each column and compute
   // the density distribution
-  int nz    = p.nz;
-  int nzt   = 2 * H.n_ghost + nz;
-  Real dz   = p.zlen / ((Real)nz);
-  Real *rho = (Real *)calloc(nzt, sizeof(Real));
+  int nz  = p.nz;
+  int nzt = 2 * H.n_ghost + nz;
+  Real dz = p.zlen / ((Real)nz);
 
   // create a look up table for the halo gas profile
   int nr         = 1000;
@@ -837,6 +893,19 @@ void Grid3D::Disk_3D(Parameters p)
   Hydrostatic_Ray_Analytical_D3D(rho_halo, r_halo, hdp, dr, nr);
   chprintf("Hot halo lookup table generated...\n");
 
+  // The disk is axisymmetric, so with disk_columns_nr the columns are only
+  // solved at that many radii out to the farthest column of the domain and
+  // interpolated in R for every (i,j)
+  std::vector<Real> column_table;
+  Real dR_columns = 0;
+  if (p.disk_columns_nr > 1) {
+    Real const x_max = fmax(fabs(p.xmin), fabs(p.xmin + p.xlen));
+    Real const y_max = fmax(fabs(p.ymin), fabs(p.ymin + p.ylen));
+    dR_columns       = sqrt(x_max * x_max + y_max * y_max) / (p.disk_columns_nr - 1);
+    column_table     = Hydrostatic_Column_Table_D3D(hdp, dR_columns, p.disk_columns_nr, dz, nz, H.n_ghost);
+    chprintf("Hydrostatic disk columns generated at %d radii...\n", p.disk_columns_nr);
+  }
+
   //////////////////////////////////////////////
   //////////////////////////////////////////////
   // Add a disk component
@@ -846,38 +915,45 @@ void Grid3D::Disk_3D(Parameters p)
   // hydrostatic column for the disk
   // and add the disk density and thermal energy
   // to the density and energy arrays
-  for (j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
-    // chprintf("j %d\n",j);
-    for (i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
+  #ifdef PARALLEL_OMP
+    #pragma omp parallel for num_threads(N_OMP_THREADS) schedule(dynamic)
+  #endif  // PARALLEL_OMP
+  for (int j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
+    std::vector<Real> rho(nzt);
+    for (int i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
       // get the centered x, y, and z positions
-      k = H.n_ghost + H.ny;
-      Get_Position(i, j, k, &x_pos, &y_pos, &z_pos);
+      Real x_pos, y_pos, z_pos;
+      Get_Position(i, j, H.n_ghost + H.ny, &x_pos, &y_pos, &z_pos);
 
       // cylindrical radius
-      r = sqrt(x_pos * x_pos + y_pos * y_pos);
+      Real const r = sqrt(x_pos * x_pos + y_pos * y_pos);
 
       // Compute the hydrostatic density profile in this z column
       // owing to the disk
       // hydrostatic_column_analytical_D3D(rho, r, hdp, dz, nz, H.n_ghost);
-      Hydrostatic_Column_Isothermal_D3D(rho, r, hdp, dz, nz,
-                                        H.n_ghost);  // CHANGED_FOR_ISOTHERMAL
+      if (column_table.empty()) {
+        Hydrostatic_Column_Isothermal_D3D(rho.data(), r, hdp, dz, nz,
+                                          H.n_ghost);  // CHANGED_FOR_ISOTHERMAL
+      } else {
+        Interpolate_Column_D3D(rho.data(), r, column_table, dR_columns, nzt);
+      }
 
       // store densities
-      for (k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
-        id = i + j * H.nx + k * H.nx * H.ny;
+      for (int k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
+        int const id = i + j * H.nx + k * H.nx * H.ny;
 
   // get density from hydrostatic column computation
   #ifdef MPI_CHOLLA
-        d = rho[nz_local_start + H.n_ghost + (k - H.n_ghost)];
+        Real const d = rho[nz_local_start + H.n_ghost + (k - H.n_ghost)];
   #else
-        d = rho[H.n_ghost + (k - H.n_ghost)];
+        Real const d = rho[H.n_ghost + (k - H.n_ghost)];
   #endif
         // if (d != d || d < 0) printf("Error calculating density. d: %e\n", d);
 
         // set pressure adiabatically
         // P = K_eos*pow(d,p.gamma);
         // set pressure isothermally
-        P = d * cs * cs;  // CHANGED FOR ISOTHERMAL
+        Real const P = d * cs * cs;  // CHANGED FOR ISOTHERMAL
 
         // store density in density
         C.density[id] = d;
@@ -888,40 +964,39 @@ void Grid3D::Disk_3D(Parameters p)
     }
   }
 
-  int idm, idp;
-  Real xpm, xpp;
-  Real ypm, ypp;
-  Real zpm, zpp;
-  Real Pm, Pp;
-
-  // pressure gradients for changing
-  // the rotational velocity
-  Real dPdx, dPdy, dPdr;
-
   // compute radial pressure gradients, adjust circular velocities
-  for (k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
-    for (j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
-      for (i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
-        id = i + j * H.nx + k * H.nx * H.ny;
+  #ifdef PARALLEL_OMP
+    #pragma omp parallel for num_threads(N_OMP_THREADS)
+  #endif  // PARALLEL_OMP
+  for (int k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
+    for (int j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
+      for (int i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
+        int const id = i + j * H.nx + k * H.nx * H.ny;
 
         // get density
-        d = C.density[id];
+        Real const d = C.density[id];
 
         // restrict to regions where the density
         // has been set
         if (d > 0.0) {
+          int idm, idp;
+          Real x_pos, y_pos, z_pos;
+          Real xpm, xpp;
+          Real ypm, ypp;
+          Real zpm, zpp;
+
           // get the centered x, y, and z positions
           Get_Position(i, j, k, &x_pos, &y_pos, &z_pos);
 
           // calculate radial position and phi (assumes disk is centered at 0,
           // 0)
-          r   = sqrt(x_pos * x_pos + y_pos * y_pos);
-          phi = atan2(y_pos, x_pos);  // azimuthal angle (in x-y plane)
+          Real const r   = sqrt(x_pos * x_pos + y_pos * y_pos);
+          Real const phi = atan2(y_pos, x_pos);  // azimuthal angle (in x-y plane)
 
           // radial acceleration from disk
-          a_d = fabs(Gr_Disk_D3D(r, z_pos, hdp));
+          Real const a_d = fabs(Gr_Disk_D3D(r, z_pos, hdp));
           // radial acceleration from halo
-          a_h = fabs(Gr_Halo_D3D(r, z_pos, hdp));
+          Real const a_h = fabs(Gr_Halo_D3D(r, z_pos, hdp));
 
           //  pressure gradient along x direction
           // gradient calc is first order at boundaries
@@ -937,9 +1012,9 @@ void Grid3D::Disk_3D(Parameters p)
           }
           Get_Position(i - 1, j, k, &xpm, &ypm, &zpm);
           Get_Position(i + 1, j, k, &xpp, &ypp, &zpp);
-          Pm   = C.Energy[idm] * (gama - 1.0);  // only internal energy stored in energy currently
-          Pp   = C.Energy[idp] * (gama - 1.0);  // only internal energy stored in energy currently
-          dPdx = (Pp - Pm) / (xpp - xpm);
+          Real Pm         = C.Energy[idm] * (gama - 1.0);  // only internal energy stored in energy currently
+          Real Pp         = C.Energy[idp] * (gama - 1.0);  // only internal energy stored in energy currently
+          Real const dPdx = (Pp - Pm) / (xpp - xpm);
 
           // pressure gradient along y direction
           if (j == H.n_ghost) {
@@ -954,15 +1029,15 @@ void Grid3D::Disk_3D(Parameters p)
           }
           Get_Position(i, j - 1, k, &xpm, &ypm, &zpm);
           Get_Position(i, j + 1, k, &xpp, &ypp, &zpm);
-          Pm   = C.Energy[idm] * (gama - 1.0);  // only internal energy stored in energy currently
-          Pp   = C.Energy[idp] * (gama - 1.0);  // only internal energy stored in energy currently
-          dPdy = (Pp - Pm) / (ypp - ypm);
+          Pm              = C.Energy[idm] * (gama - 1.0);  // only internal energy stored in energy currently
+          Pp              = C.Energy[idp] * (gama - 1.0);  // only internal energy stored in energy currently
+          Real const dPdy = (Pp - Pm) / (ypp - ypm);
 
           // radial pressure gradient
-          dPdr = x_pos * dPdx / r + y_pos * dPdy / r;
+          Real const dPdr = x_pos * dPdx / r + y_pos * dPdy / r;
 
           // radial acceleration
-          a = a_d + a_h + dPdr / d;
+          Real const a = a_d + a_h + dPdr / d;
 
           if (isnan(a) || (a != a) || (r * a < 0)) {
             // printf("i %d j %d k %d a %e a_d %e dPdr %e d
@@ -975,10 +1050,10 @@ void Grid3D::Disk_3D(Parameters p)
             // %e\n",C.Energy[idm],C.Energy[idp],C.density[idm],C.density[idp]);
           } else {
             // radial velocity
-            v  = sqrt(r * a);
-            vx = -sin(phi) * v;
-            vy = cos(phi) * v;
-            vz = 0;
+            Real const v  = sqrt(r * a);
+            Real const vx = -sin(phi) * v;
+            Real const vy = cos(phi) * v;
+            Real const vz = 0;
 
             // set the momenta
             C.momentum_x[id] = d * vx;
@@ -986,7 +1061,7 @@ void Grid3D::Disk_3D(Parameters p)
             C.momentum_z[id] = d * vz;
 
             // sheepishly check for NaN's!
-
+            Real const P = C.Energy[id] * (gama - 1.0);
             if ((d < 0) || (P < 0) || (isnan(d)) || (isnan(P)) || (d != d) || (P != P)) {
               printf("d %e P %e i %d j %d k %d id %d\n", d, P, i, j, k, id);
             }
@@ -1011,24 +1086,28 @@ void Grid3D::Disk_3D(Parameters p)
   // Add a hot, hydrostatic halo
   //////////////////////////////////////////////
   //////////////////////////////////////////////
-  for (k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
-    for (j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
-      for (i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
+  #ifdef PARALLEL_OMP
+    #pragma omp parallel for num_threads(N_OMP_THREADS)
+  #endif  // PARALLEL_OMP
+  for (int k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
+    for (int j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
+      for (int i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
         // get the cell index
-        id = i + j * H.nx + k * H.nx * H.ny;
+        int const id = i + j * H.nx + k * H.nx * H.ny;
 
         // get the centered x, y, and z positions
+        Real x_pos, y_pos, z_pos;
         Get_Position(i, j, k, &x_pos, &y_pos, &z_pos);
 
         // calculate 3D radial position and phi (assumes halo is centered at 0,
         // 0)
-        r = sqrt(x_pos * x_pos + y_pos * y_pos + z_pos * z_pos);
+        Real const r = sqrt(x_pos * x_pos + y_pos * y_pos + z_pos * z_pos);
 
         // interpolate the density at this position
-        d = Halo_Density_D3D(r, r_halo, rho_halo, dr, nr);
+        Real const d = Halo_Density_D3D(r, r_halo, rho_halo, dr, nr);
 
         // set pressure adiabatically
-        P = K_eos_h * pow(d, p.gamma);
+        Real const P = K_eos_h * pow(d, p.gamma);
 
         // store density in density
         C.density[id] += d;
@@ -1045,10 +1124,13 @@ void Grid3D::Disk_3D(Parameters p)
   //////////////////////////////////////////////
   //////////////////////////////////////////////
 
-  for (k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
-    for (j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
-      for (i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
-        id = i + j * H.nx + k * H.nx * H.ny;
+  #ifdef PARALLEL_OMP
+    #pragma omp parallel for num_threads(N_OMP_THREADS)
+  #endif  // PARALLEL_OMP
+  for (int k = H.n_ghost; k < H.nz - H.n_ghost; k++) {
+    for (int j = H.n_ghost; j < H.ny - H.n_ghost; j++) {
+      for (int i = H.n_ghost; i < H.nx - H.n_ghost; i++) {
+        int const id = i + j * H.nx + k * H.nx * H.ny;
 
   // set internal energy
   #ifdef DE
@@ -1064,8 +1146,7 @@ void Grid3D::Disk_3D(Parameters p)
     }
   }
 
-  // free density profile
-  free(rho);
+  // free the parameters
   free(hdp);
 
   // free the arrays
@@ -0,0 +1,322 @@
+/*! \file buddy_checkpoint.cpp
+ *  \brief Definitions of the in-memory buddy checkpoints. */
+
+#ifdef MPI_CHOLLA
+
+  #include "../mpi/buddy_checkpoint.h"
+
+  #include <mpi.h>
+
+  #include <algorithm>
+  #include <array>
+  #include <climits>
+  #include <vector>
+
+  #include "../global/global.h"
+  #include "../io/io.h"
+  #include "../mpi/mpi_routines.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/timing_functions.h"
+
+namespace
+{
+// The scalars of the state a checkpoint continues from
+enum Header {
+  time,
+  timestep,
+  step,
+  output_time,
+  output_file,
+  grav_dt_now,
+  grav_dt_prev,
+  scale_factor,
+  n_particles,
+  n_header
+};
+
+// The state of one rank at the end of a step
+struct Snapshot {
+  std::array<Real, n_header> header;
+  // The conserved variables, the potentials and the particle fields, in the
+  // order Pack appends them
+  std::vector<Real> data;
+  #ifdef PARTICLE_IDS
+  std::vector<part_int_t> ids;
+  #endif  // PARTICLE_IDS
+};
+
+// The copy of this rank and the one this rank keeps for the rank that sends
+// its copy here
+Snapshot own, kept;
+bool saved    = false;
+bool restored = false;
+
+// The rank a copy is sent to, half of the ranks away so that with the ranks
+// of a node placed next to each other it is on another node
+int Buddy_Of(int rank) { return (rank + std::max(nproc / 2, 1)) % nproc; }
+
+// The rank whose copy this rank keeps
+int Kept_For(int rank) { return (rank - std::max(nproc / 2, 1) + nproc) % nproc; }
+
+// Append n values of a device array to the data of a snapshot
+void Append_Device(std::vector<Real> &data, Real const *values_dev, size_t n)
+{
+  size_t const offset = data.size();
+  data.resize(offset + n);
+  GPU_Error_Check(cudaMemcpy(data.data() + offset, values_dev, n * sizeof(Real), cudaMemcpyDeviceToHost));
+}
+
+// Copy the next n values of the data of a snapshot to a device array
+void Extract_Device(Real const *&cursor, Real *values_dev, size_t n)
+{
+  GPU_Error_Check(cudaMemcpy(values_dev, cursor, n * sizeof(Real), cudaMemcpyHostToDevice));
+  cursor += n;
+}
+
+void Pack(Grid3D &G, Real outtime, int nfile, Snapshot &snapshot)
+{
+  snapshot.header.fill(0);
+  snapshot.header[time]        = G.H.t;
+  snapshot.header[timestep]    = G.H.dt;
+  snapshot.header[step]        = G.H.n_step;
+  snapshot.header[output_time] = outtime;
+  snapshot.header[output_file] = nfile;
+  snapshot.data.clear();
+
+  Append_Device(snapshot.data, G.C.device, size_t(G.H.n_fields) * G.H.n_cells);
+
+  #ifdef GRAVITY
+  snapshot.header[grav_dt_now]  = G.Grav.dt_now;
+  snapshot.header[grav_dt_prev] = G.Grav.dt_prev;
+    #ifdef GRAVITY_GPU
+  Append_Device(snapshot.data, G.Grav.F.potential_d, G.Grav.n_cells_potential);
+  Append_Device(snapshot.data, G.Grav.F.potential_1_d, G.Grav.n_cells_potential);
+    #else
+  snapshot.data.insert(snapshot.data.end(), G.Grav.F.potential_h, G.Grav.F.potential_h + G.Grav.n_cells_potential);
+  snapshot.data.insert(snapshot.data.end(), G.Grav.F.potential_1_h, G.Grav.F.potential_1_h + G.Grav.n_cells_potential);
+    #endif  // GRAVITY_GPU
+  #endif    // GRAVITY
+
+  #ifdef COSMOLOGY
+  snapshot.header[scale_factor] = G.Cosmo.current_a;
+  #endif  // COSMOLOGY
+
+  #ifdef PARTICLES
+  Particles3D &particles       = G.Particles;
+  part_int_t const n           = particles.n_local;
+  snapshot.header[n_particles] = n;
+    #ifdef PARTICLES_GPU
+  Real_Part *const part_dev[6] = {particles.pos_x_dev, particles.pos_y_dev, particles.pos_z_dev,
+                                  particles.vel_x_dev, particles.vel_y_dev, particles.vel_z_dev};
+  Real const origin[6]         = {particles.G.pos_origin_x, particles.G.pos_origin_y, particles.G.pos_origin_z, 0, 0,
+                                  0};
+  for (int field = 0; field < 6; field++) {
+    size_t const offset = snapshot.data.size();
+    snapshot.data.resize(offset + n);
+    particles.Copy_Particles_Array_Part_Device_to_Host(part_dev[field], snapshot.data.data() + offset, n,
+                                                       origin[field]);
+  }
+      #ifndef PARTICLES_KDK_FUSED
+  Append_Device(snapshot.data, particles.grav_x_dev, n);
+  Append_Device(snapshot.data, particles.grav_y_dev, n);
+  Append_Device(snapshot.data, particles.grav_z_dev, n);
+      #endif  // PARTICLES_KDK_FUSED
+      #ifndef SINGLE_PARTICLE_MASS
+  Append_Device(snapshot.data, particles.mass_dev, n);
+      #endif  // SINGLE_PARTICLE_MASS
+      #ifdef PARTICLE_AGE
+  Append_Device(snapshot.data, particles.age_dev, n);
+      #endif  // PARTICLE_AGE
+      #ifdef PARTICLE_IDS
+  snapshot.ids.resize(n);
+  particles.Copy_Particles_Array_Int_Device_to_Host(particles.partIDs_dev, snapshot.ids.data(), n);
+      #endif  // PARTICLE_IDS
+    #endif    // PARTICLES_GPU
+
+    #ifdef PARTICLES_CPU
+  for (real_vector_t const *field : {&particles.pos_x, &particles.pos_y, &particles.pos_z, &particles.vel_x,
+                                     &particles.vel_y, &particles.vel_z, &particles.grav_x, &particles.grav_y,
+                                     &particles.grav_z}) {
+    snapshot.data.insert(snapshot.data.end(), field->begin(), field->end());
+  }
+      #ifndef SINGLE_PARTICLE_MASS
+  snapshot.data.insert(snapshot.data.end(), particles.mass.begin(), particles.mass.end());
+      #endif  // SINGLE_PARTICLE_MASS
+      #ifdef PARTICLE_AGE
+  snapshot.data.insert(snapshot.data.end(), particles.age.begin(), particles.age.end());
+      #endif  // PARTICLE_AGE
+      #ifdef PARTICLE_IDS
+  snapshot.ids = particles.partIDs;
+      #endif  // PARTICLE_IDS
+    #endif    // PARTICLES_CPU
+  #endif      // PARTICLES
+}
+
+void Unpack(Snapshot const &snapshot, Grid3D &G, Real *outtime, int *nfile)
+{
+  G.H.t      = snapshot.header[time];
+  G.H.dt     = snapshot.header[timestep];
+  G.H.n_step = int(snapshot.header[step]);
+  *outtime   = snapshot.header[output_time];
+  *nfile     = int(snapshot.header[output_file]);
+
+  Real const *cursor = snapshot.data.data();
+  Extract_Device(cursor, G.C.device, size_t(G.H.n_fields) * G.H.n_cells);
+
+  #ifdef GRAVITY
+  G.Grav.dt_now  = snapshot.header[grav_dt_now];
+  G.Grav.dt_prev = snapshot.header[grav_dt_prev];
+    #ifdef GRAVITY_GPU
+  Extract_Device(cursor, G.Grav.F.potential_d, G.Grav.n_cells_potential);
+  Extract_Device(cursor, G.Grav.F.potential_1_d, G.Grav.n_cells_potential);
+    #else
+  std::copy(cursor, cursor + G.Grav.n_cells_potential, G.Grav.F.potential_h);
+  cursor += G.Grav.n_cells_potential;
+  std::copy(cursor, cursor + G.Grav.n_cells_potential, G.Grav.F.potential_1_h);
+  cursor += G.Grav.n_cells_potential;
+    #endif  // GRAVITY_GPU
+  #endif    // GRAVITY
+
+  #ifdef COSMOLOGY
+  // Same as Update_Time
+  G.Cosmo.current_a = snapshot.header[scale_factor];
+  G.Cosmo.current_z = 1. / G.Cosmo.current_a - 1;
+  G.Grav.current_a  = G.Cosmo.current_a;
+    #ifdef ANALYSIS
+  G.Analysis.current_z = G.Cosmo.current_z;
+    #endif  // ANALYSIS
+  #endif    // COSMOLOGY
+
+  #ifdef PARTICLES
+  Particles3D &particles = G.Particles;
+  part_int_t const n     = part_int_t(snapshot.header[n_particles]);
+  particles.t            = G.H.t;
+    #ifdef COSMOLOGY
+  particles.current_a = G.Cosmo.current_a;
+  particles.current_z = G.Cosmo.current_z;
+    #endif  // COSMOLOGY
+    #ifdef PARTICLES_GPU
+  if (n > particles.particles_array_size) {
+    particles.Resize_Particles_Arrays_GPU(particles.Compute_Particles_GPU_Array_Size(n));
+  }
+  Real_Part *const part_dev[6] = {particles.pos_x_dev, particles.pos_y_dev, particles.pos_z_dev,
+                                  particles.vel_x_dev, particles.vel_y_dev, particles.vel_z_dev};
+  Real const origin[6]         = {particles.G.pos_origin_x, particles.G.pos_origin_y, particles.G.pos_origin_z, 0, 0,
+                                  0};
+  for (int field = 0; field < 6; field++) {
+    particles.Copy_Particles_Array_Part_Host_to_Device(const_cast<Real *>(cursor), part_dev[field], n, origin[field]);
+    cursor += n;
+  }
+      #ifndef PARTICLES_KDK_FUSED
+  Extract_Device(cursor, particles.grav_x_dev, n);
+  Extract_Device(cursor, particles.grav_y_dev, n);
+  Extract_Device(cursor, particles.grav_z_dev, n);
+      #endif  // PARTICLES_KDK_FUSED
+      #ifndef SINGLE_PARTICLE_MASS
+  Extract_Device(cursor, particles.mass_dev, n);
+      #endif  // SINGLE_PARTICLE_MASS
+      #ifdef PARTICLE_AGE
+  Extract_Device(cursor, particles.age_dev, n);
+      #endif  // PARTICLE_AGE
+      #ifdef PARTICLE_IDS
+  particles.Copy_Particles_Array_Int_Host_to_Device(const_cast<part_int_t *>(snapshot.ids.data()),
+                                                    particles.partIDs_dev, n);
+      #endif  // PARTICLE_IDS
+    #endif    // PARTICLES_GPU
+
+    #ifdef PARTICLES_CPU
+  for (real_vector_t *field : {&particles.pos_x, &particles.pos_y, &particles.pos_z, &particles.vel_x,
+                               &particles.vel_y, &particles.vel_z, &particles.grav_x, &particles.grav_y,
+                               &particles.grav_z}) {
+    field->assign(cursor, cursor + n);
+    cursor += n;
+  }
+      #ifndef SINGLE_PARTICLE_MASS
+  particles.mass.assign(cursor, cursor + n);
+  cursor += n;
+      #endif  // SINGLE_PARTICLE_MASS
+      #ifdef PARTICLE_AGE
+  particles.age.assign(cursor, cursor + n);
+  cursor += n;
+      #endif  // PARTICLE_AGE
+      #ifdef PARTICLE_IDS
+  particles.partIDs = snapshot.ids;
+      #endif  // PARTICLE_IDS
+    #endif    // PARTICLES_CPU
+  particles.n_local = n;
+  #endif  // PARTICLES
+
+  #ifdef LAGGED_DT
+  // The inverse timestep of the state the last step started from is gone
+  G.H.lagged_max_dti = 0;
+  #endif  // LAGGED_DT
+  // set_dt reads the inverse timestep of the restored state
+  G.Calc_Inverse_Timestep();
+}
+
+// Send a snapshot to dest and receive one from source, either can be
+// MPI_PROC_NULL
+void Exchange(Snapshot const &send, int dest, Snapshot &recv, int source)
+{
+  CHOLLA_ASSERT(send.data.size() <= INT_MAX, "The buddy checkpoint of a rank has more than INT_MAX values");
+  MPI_Sendrecv(send.header.data(), n_header, MPI_CHREAL, dest, 0, recv.header.data(), n_header, MPI_CHREAL, source, 0,
+               world, MPI_STATUS_IGNORE);
+  long long const send_size = send.data.size();
+  long long recv_size;
+  MPI_Sendrecv(&send_size, 1, MPI_LONG_LONG, dest, 1, &recv_size, 1, MPI_LONG_LONG, source, 1, world,
+               MPI_STATUS_IGNORE);
+  if (source != MPI_PROC_NULL) {
+    recv.data.resize(recv_size);
+  #ifdef PARTICLE_IDS
+    recv.ids.resize(part_int_t(recv.header[n_particles]));
+  #endif  // PARTICLE_IDS
+  }
+  MPI_Sendrecv(send.data.data(), int(send.data.size()), MPI_CHREAL, dest, 2, recv.data.data(), int(recv.data.size()),
+               MPI_CHREAL, source, 2, world, MPI_STATUS_IGNORE);
+  #ifdef PARTICLE_IDS
+  MPI_Sendrecv(send.ids.data(), int(send.ids.size()), MPI_PART_INT, dest, 3, recv.ids.data(), int(recv.ids.size()),
+               MPI_PART_INT, source, 3, world, MPI_STATUS_IGNORE);
+  #endif  // PARTICLE_IDS
+}
+}  // namespace
+
+namespace buddy_checkpoint
+{
+void Save(Grid3D &G, Real outtime, int nfile)
+{
+  ScopedTimer timer("Save_Buddy_Checkpoint");
+  Pack(G, outtime, nfile, own);
+  Exchange(own, Buddy_Of(procID), kept, Kept_For(procID));
+  saved    = true;
+  restored = false;
+}
+
+bool Restore(Grid3D &G, int lost_rank, Real *outtime, int *nfile)
+{
+  // Every rank has to go back to the same checkpoint. The lost rank has no
+  // checkpoint of its own and doesn't take part in the decision
+  int usable = (saved and not restored) or procID == lost_rank;
+  MPI_Allreduce(MPI_IN_PLACE, &usable, 1, MPI_INT, MPI_MIN, world);
+  if (not usable) {
+    return false;
+  }
+
+  // A single rank is its own buddy and already has the copy
+  if (lost_rank >= 0 and Buddy_Of(lost_rank) != lost_rank) {
+    Snapshot const none{};
+    if (procID == Buddy_Of(lost_rank)) {
+      Exchange(kept, lost_rank, own, MPI_PROC_NULL);
+    } else if (procID == lost_rank) {
+      Exchange(none, MPI_PROC_NULL, own, Buddy_Of(lost_rank));
+    }
+  }
+  Unpack(own, G, outtime, nfile);
+  chprintf("Restored the buddy checkpoint of step %d, sim time: %10.7f\n", G.H.n_step, G.H.t);
+  saved    = true;
+  restored = true;
+  return true;
+}
+}  // namespace buddy_checkpoint
+
+#endif  // MPI_CHOLLA
@@ -0,0 +1,34 @@
+/*! \file buddy_checkpoint.h
+ *  \brief Declarations of the in-memory buddy checkpoints. Every
+ *  buddy_checkpoint_steps steps each rank copies its state to host memory and
+ *  sends the copy to its buddy rank, half of the ranks away and so on another
+ *  node, which keeps it next to its own. A rank that lost its state can then be
+ *  rebuilt from its buddy instead of reading the restart files. */
+
+#pragma once
+
+#ifdef MPI_CHOLLA
+
+  #include "../global/global.h"
+  #include "../grid/grid3D.h"
+
+namespace buddy_checkpoint
+{
+/*! \fn void Save(Grid3D &G, Real outtime, int nfile)
+ *  \brief Copy the conserved variables, the gravitational potentials and the
+ *  particles of this rank to host memory and exchange the copy with the buddy
+ *  ranks. Called by every rank at the end of a step, outtime and nfile are the
+ *  next output time and file number the step is continued with. */
+void Save(Grid3D &G, Real outtime, int nfile);
+
+/*! \fn bool Restore(Grid3D &G, int lost_rank, Real *outtime, int *nfile)
+ *  \brief Go back to the state of the last buddy checkpoint. Every rank
+ *  restores its own copy, except lost_rank, e.g. the replacement of a failed
+ *  rank, which gets its copy back from its buddy. A negative lost_rank restores
+ *  every rank from its own copy. Called by every rank; returns false if there
+ *  is no checkpoint or it was already restored, so a state that goes bad again
+ *  is not retried forever. */
+bool Restore(Grid3D &G, int lost_rank, Real *outtime, int *nfile);
+}  // namespace buddy_checkpoint
+
+#endif  // MPI_CHOLLA
@@ -4,12 +4,21 @@
   #include <math.h>
   #include <mpi.h>
 
+  #include <algorithm>
+  #include <fstream>
   #include <iostream>
+  #include <numeric>
+  #include <sstream>
+  #include <string>
   #include <tuple>
+  #include <vector>
 
   #include "../global/global.h"
   #include "../io/io.h"
   #include "../mpi/cuda_mpi_routines.h"
+  #include "../mpi/nvshmem_boundaries.h"
+  #include "../particles/particles_boundaries_gpu.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/error_handling.h"
 
 /*Global MPI Variables*/
@@ -19,6 +28,7 @@ int procID_node; /*process rank on node*/
 int nproc_node;  /*number of MPI processes on node*/
 
 MPI_Comm world; /*global communicator*/
+MPI_Comm world_analysis;
 
 MPI_Datatype MPI_CHREAL; /*set equal to MPI_FLOAT or MPI_DOUBLE*/
 
@@ -34,6 +44,26 @@ MPI_Request *recv_request;
 int dest[6];
 int source[6];
 
+// Ranks of all 26 neighbors (and this rank at the center). The neighbor at
+// offset (di, dj, dk) is at index (di + 1) + 3 * (dj + 1) + 9 * (dk + 1)
+int neighbor_rank[27];
+
+// Buffers for the single phase exchange with all 26 neighbors, allocated on
+// first use
+Real *d_send_buffer_26 = NULL;
+Real *d_recv_buffer_26 = NULL;
+Real *h_send_buffer_26 = NULL;
+Real *h_recv_buffer_26 = NULL;
+
+// Send the device buffers directly instead of staging them through the host
+// buffers. Only possible with GPU-aware MPI, set by Probe_MPI_GPU_Direct
+bool mpi_gpu_direct = false;
+
+// The time spent waiting for the hydro boundary transfers in seconds and the
+// bytes sent by them, accumulated since Time::Reduce_Step last reset them
+double mpi_wait_time  = 0;
+size_t mpi_bytes_sent = 0;
+
 // Communication buffers
 
 // For BLOCK
@@ -68,6 +98,9 @@ int recv_buffer_length;
 int x_buffer_length;
 int y_buffer_length;
 int z_buffer_length;
+int x_buffer_capacity;
+int y_buffer_capacity;
+int z_buffer_capacity;
 
   #ifdef PARTICLES
 // Buffers for particles transfers
@@ -137,6 +170,11 @@ int nproc_x;
 int nproc_y;
 int nproc_z;
 
+// The widths of the slabs of blocks along each axis and the slab of this rank
+// along each axis, for the load balancing of load_balance_file
+static std::vector<int> slab_widths[3];
+static int slab_index[3];
+
   #ifdef FFTW
 ptrdiff_t n_local_complex;
   #endif /*FFTW*/
@@ -146,7 +184,13 @@ ptrdiff_t n_local_complex;
 void InitializeChollaMPI(int *pargc, char **pargv[])
 {
   /*initialize MPI*/
+  #ifdef ASYNC_ANALYSIS
+  // The analysis thread communicates while the main thread advances the grid
+  int thread_level;
+  MPI_Init_thread(pargc, pargv, MPI_THREAD_MULTIPLE, &thread_level);
+  #else
   MPI_Init(pargc, pargv);
+  #endif  // ASYNC_ANALYSIS
 
   /*set process ids in comm world*/
   MPI_Comm_rank(MPI_COMM_WORLD, &procID);
@@ -163,6 +207,17 @@ void InitializeChollaMPI(int *pargc, char **pargv[])
   /* set the global communicator */
   world = MPI_COMM_WORLD;
 
+  /* the analysis thread has its own communicator, so its messages never match
+   * the ones of the main thread */
+  #ifdef ASYNC_ANALYSIS
+  if (thread_level < MPI_THREAD_MULTIPLE) {
+    CHOLLA_ERROR("ASYNC_ANALYSIS needs an MPI library with MPI_THREAD_MULTIPLE support");
+  }
+  MPI_Comm_dup(world, &world_analysis);
+  #else
+  world_analysis = world;
+  #endif  // ASYNC_ANALYSIS
+
   /* set the precision of MPI floating point numbers */
   #if PRECISION == 1
   MPI_CHREAL = MPI_FLOAT;
@@ -233,6 +288,11 @@ void InitializeChollaMPI(int *pargc, char **pargv[])
     chexit(-10);
   }
   // #endif//ONLY_PARTICLES
+
+  #ifdef NVSHMEM_BOUNDARIES
+  // NVSHMEM uses the device that was just selected
+  Initialize_NVSHMEM();
+  #endif  // NVSHMEM_BOUNDARIES
 }
 
 /* Perform domain decomposition */
@@ -264,6 +324,218 @@ void DomainDecomposition(struct Parameters *P, struct Header *H, int nx_gin, int
 
   // Allocate communication buffers
   Allocate_MPI_DeviceBuffers(H);
+
+  // and choose how they are sent
+  Probe_MPI_GPU_Direct(H);
+
+  #ifdef NVSHMEM_BOUNDARIES
+  // The symmetric buffers of the 26 neighbor exchange are allocated by all the
+  // ranks together, so they can't wait until the first exchange
+  if (H->ny > 1 && H->nz > 1) {
+    int const ng          = H->n_ghost;
+    int const n_box_cells = H->n_cells - (H->nx - 2 * ng) * (H->ny - 2 * ng) * (H->nz - 2 * ng);
+    Allocate_NVSHMEM_Buffers(H->n_fields * n_box_cells);
+  }
+  #endif  // NVSHMEM_BOUNDARIES
+}
+
+/* Print how many of the face neighbors of the ranks are on the same node,
+ * whose halos don't have to cross the network */
+static void Print_Node_Local_Faces()
+{
+  // A node is identified by its lowest rank
+  MPI_Comm node_comm;
+  MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED, procID, MPI_INFO_NULL, &node_comm);
+  int node_id = procID;
+  MPI_Allreduce(MPI_IN_PLACE, &node_id, 1, MPI_INT, MPI_MIN, node_comm);
+  MPI_Comm_free(&node_comm);
+  std::vector<int> node_ids(nproc);
+  MPI_Allgather(&node_id, 1, MPI_INT, node_ids.data(), 1, MPI_INT, world);
+
+  // The faces with another rank on the other side, and those on this node
+  int faces[2] = {0, 0};
+  for (int face = 0; face < 6; face++) {
+    if (dest[face] != procID) {
+      faces[0]++;
+      faces[1] += (node_ids[dest[face]] == node_id) ? 1 : 0;
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, faces, 2, MPI_INT, MPI_SUM, world);
+  if (faces[0] > 0) {
+    chprintf("%d of the %d face neighbors of the ranks are on the same node\n", faces[1], faces[0]);
+  }
+}
+
+/* The widths of the n_proc slabs of n_global cells along an axis. The cells
+ * are split evenly, with the remainder going to the first slabs */
+static std::vector<int> Uniform_Slab_Widths(int n_global, int n_proc)
+{
+  std::vector<int> widths(n_proc, n_global / n_proc);
+  for (int i = 0; i < n_global % n_proc; i++) {
+    widths[i]++;
+  }
+  return widths;
+}
+
+/* Read the slab widths along x, y and z from file_name, one line of widths
+ * per axis with # starting a comment. Returns false if the file doesn't exist,
+ * widths that don't fit the decomposition are an error */
+static bool Read_Slab_Widths(char const *file_name, int n_ghost, std::vector<int> widths[3])
+{
+  std::ifstream file(file_name);
+  if (!file) {
+    return false;
+  }
+
+  int const n_global[3] = {int(nx_global), int(ny_global), int(nz_global)};
+  int const n_proc[3]   = {nproc_x, nproc_y, nproc_z};
+  std::vector<int> read[3];
+  std::string line;
+  for (int axis = 0; axis < 3 && std::getline(file, line);) {
+    std::istringstream values(line.substr(0, line.find('#')));
+    for (int width; values >> width;) {
+      read[axis].push_back(width);
+    }
+    axis += read[axis].empty() ? 0 : 1;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    // A slab needs the cells of the halos its neighbors receive
+    int const min_width = (n_global[axis] > 1) ? n_ghost : 1;
+    int const total     = std::accumulate(read[axis].begin(), read[axis].end(), 0);
+    int const narrowest = read[axis].empty() ? 0 : *std::min_element(read[axis].begin(), read[axis].end());
+    if (int(read[axis].size()) != n_proc[axis] || total != n_global[axis] || narrowest < min_width) {
+      CHOLLA_ERROR("The slabs of axis %d in %s don't split %d cells into %d slabs of at least %d cells", axis,
+                   file_name, n_global[axis], n_proc[axis], min_width);
+    }
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    widths[axis] = read[axis];
+  }
+  return true;
+}
+
+/* The slab widths that give every slab the same share of the cost, with the
+ * cost of each slab spread evenly over its cells. Every slab keeps at least
+ * min_width cells */
+static std::vector<int> Balance_Slab_Widths(std::vector<int> const &widths, std::vector<double> const &cost,
+                                            int min_width)
+{
+  int const n_slabs  = widths.size();
+  int const n_cells  = std::accumulate(widths.begin(), widths.end(), 0);
+  double const total = std::accumulate(cost.begin(), cost.end(), 0.0);
+  if (n_slabs == 1 || total <= 0) {
+    return widths;
+  }
+
+  std::vector<int> balanced(n_slabs);
+  int slab = 0, slab_start = 0, previous = 0;
+  double cost_below = 0;
+  for (int m = 1; m < n_slabs; m++) {
+    // The new boundary m is where the cost below it reaches m / n_slabs of the
+    // total
+    double const target = total * m / n_slabs;
+    while (slab < n_slabs - 1 && cost_below + cost[slab] < target) {
+      cost_below += cost[slab];
+      slab_start += widths[slab];
+      slab++;
+    }
+    double const fraction = (cost[slab] > 0) ? (target - cost_below) / cost[slab] : 0;
+    int boundary          = slab_start + int(std::lround(fraction * widths[slab]));
+    boundary              = std::max(boundary, previous + min_width);
+    boundary              = std::min(boundary, n_cells - (n_slabs - m) * min_width);
+    balanced[m - 1]       = boundary - previous;
+    previous              = boundary;
+  }
+  balanced[n_slabs - 1] = n_cells - previous;
+  return balanced;
+}
+
+void Write_Load_Balanced_Slabs(char const *file_name, double cost, int n_ghost)
+{
+  int const n_global[3] = {int(nx_global), int(ny_global), int(nz_global)};
+  char const axes[3]    = {'x', 'y', 'z'};
+  std::vector<int> balanced[3];
+  for (int axis = 0; axis < 3; axis++) {
+    // The cost of a slab is the sum over the ranks in it
+    std::vector<double> slab_cost(slab_widths[axis].size(), 0);
+    slab_cost[slab_index[axis]] = cost;
+    MPI_Allreduce(MPI_IN_PLACE, slab_cost.data(), slab_cost.size(), MPI_DOUBLE, MPI_SUM, world);
+    balanced[axis] = Balance_Slab_Widths(slab_widths[axis], slab_cost, (n_global[axis] > 1) ? n_ghost : 1);
+
+    double const max_cost = *std::max_element(slab_cost.begin(), slab_cost.end());
+    double const sum_cost = std::accumulate(slab_cost.begin(), slab_cost.end(), 0.0);
+    if (sum_cost > 0) {
+      chprintf("Load balance along %c: the most expensive slab costs %.2f times the mean\n", axes[axis],
+               max_cost * slab_cost.size() / sum_cost);
+    }
+  }
+
+  if (procID != root) {
+    return;
+  }
+  std::ofstream file(file_name);
+  file << "# Slab widths along x, y and z that balance the measured cost of the last run\n";
+  for (int axis = 0; axis < 3; axis++) {
+    for (size_t i = 0; i < balanced[axis].size(); i++) {
+      file << ((i > 0) ? " " : "") << balanced[axis][i];
+    }
+    file << "\n";
+  }
+  if (!file) {
+    CHOLLA_ERROR("Unable to write the load balanced slabs to %s", file_name);
+  }
+  chprintf("Load balanced slabs written to %s, restart from a concatenated output to use them\n", file_name);
+}
+
+/* Find the brick of blocks that the ranks of each node are placed on with
+ * mpi_node_blocks. The ranks of a node have to be consecutive and every node
+ * needs the same number of them. Of the bricks that tile the blocks the one
+ * with the smallest surface is taken, so most of the halo exchanges stay on
+ * the node. Returns false if the ranks can't be placed */
+static bool Find_Node_Brick(int node_brick[3])
+{
+  int placeable = (procID_node == procID % nproc_node) ? 1 : 0;
+  int min_nproc_node, max_nproc_node;
+  MPI_Allreduce(MPI_IN_PLACE, &placeable, 1, MPI_INT, MPI_MIN, world);
+  MPI_Allreduce(&nproc_node, &min_nproc_node, 1, MPI_INT, MPI_MIN, world);
+  MPI_Allreduce(&nproc_node, &max_nproc_node, 1, MPI_INT, MPI_MAX, world);
+  if (!placeable || min_nproc_node != max_nproc_node) {
+    return false;
+  }
+
+  // The surface of a brick in cells, from the size of a block
+  Real const block_size[3] = {Real(nx_global) / nproc_x, Real(ny_global) / nproc_y, Real(nz_global) / nproc_z};
+  Real min_surface         = -1;
+  for (int bx = 1; bx <= nproc_node; bx++) {
+    for (int by = 1; bx * by <= nproc_node; by++) {
+      int const bz = nproc_node / (bx * by);
+      if (bx * by * bz != nproc_node || nproc_x % bx || nproc_y % by || nproc_z % bz) {
+        continue;
+      }
+      Real const lx      = bx * block_size[0], ly = by * block_size[1], lz = bz * block_size[2];
+      Real const surface = lx * ly + ly * lz + lz * lx;
+      if (min_surface < 0 || surface < min_surface) {
+        min_surface   = surface;
+        node_brick[0] = bx;
+        node_brick[1] = by;
+        node_brick[2] = bz;
+      }
+    }
+  }
+  return min_surface >= 0;
+}
+
+/* The rank of block (i, j, k). The ranks of each node hold a brick of
+ * node_brick blocks, with the blocks of a brick and the bricks both numbered
+ * along x first. With a brick of a single block this is the plain numbering of
+ * the blocks */
+static int Block_Rank(int i, int j, int k, int const node_brick[3])
+{
+  int const bx    = node_brick[0], by = node_brick[1], bz = node_brick[2];
+  int const node  = i / bx + (j / by + (k / bz) * (nproc_y / by)) * (nproc_x / bx);
+  int const local = i % bx + (j % by + (k % bz) * by) * bx;
+  return node * bx * by * bz + local;
 }
 
 /* Perform domain decomposition */
@@ -313,6 +585,42 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
   // P->n_proc_y, P->n_proc_z);
   #endif
 
+  // With mpi_cart_reorder MPI may renumber the ranks to fit the blocks to the
+  // topology of the machine. The Cartesian communicator is row major, so with x
+  // last its ranks number the blocks along x first like the default
+  if (P->mpi_cart_reorder) {
+  #ifdef NVSHMEM_BOUNDARIES
+    CHOLLA_ERROR("mpi_cart_reorder would break the NVSHMEM PE of each rank");
+  #endif  // NVSHMEM_BOUNDARIES
+    int dims[3]    = {nproc_z, nproc_y, nproc_x};
+    int periods[3] = {1, 1, 1};
+    MPI_Comm cart;
+    MPI_Cart_create(world, 3, dims, periods, 1, &cart);
+    world = cart;
+    MPI_Comm_rank(world, &procID);
+  #ifdef ASYNC_ANALYSIS
+    MPI_Comm_free(&world_analysis);
+    MPI_Comm_dup(world, &world_analysis);
+  #else
+    world_analysis = world;
+  #endif  // ASYNC_ANALYSIS
+  }
+
+  // The blocks are assigned to the ranks along x first, or by node with
+  // mpi_node_blocks, so the neighbors on a node exchange their halos through
+  // the node's devices instead of the network
+  int node_brick[3] = {1, 1, 1};
+  if (P->mpi_node_blocks && P->mpi_cart_reorder) {
+    chprintf("WARNING: mpi_node_blocks is ignored with mpi_cart_reorder\n");
+  } else if (P->mpi_node_blocks) {
+    if (Find_Node_Brick(node_brick)) {
+      chprintf("Placing the %d ranks of each node on bricks of %d x %d x %d blocks\n", nproc_node, node_brick[0],
+               node_brick[1], node_brick[2]);
+    } else {
+      chprintf("WARNING: mpi_node_blocks needs the same number of consecutive ranks on every node, ignoring it\n");
+    }
+  }
+
   // chprintf("Allocating tiling.\n");
   MPI_Barrier(world);
   int ***tiling = three_dimensional_int_array(nproc_x, nproc_y, nproc_z);
@@ -320,7 +628,6 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
   // find indices
   // chprintf("Setting indices.\n");
   MPI_Barrier(world);
-  n = 0;
   // Gravity: Change the order of MPI processes assignment to match the
   // assignment done by PFFT Original:
   //  for(i=0;i<nproc_x;i++)
@@ -331,6 +638,7 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
   for (k = 0; k < nproc_z; k++) {
     for (j = 0; j < nproc_y; j++) {
       for (i = 0; i < nproc_x; i++) {
+        n     = Block_Rank(i, j, k, node_brick);
         ix[n] = i;
         iy[n] = j;
         iz[n] = k;
@@ -365,7 +673,6 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
             dest[5] -= nproc_z;
           }
         }
-        n++;
       }
     }
   }
@@ -415,6 +722,34 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
     }
   }
 
+  // The slabs can also come from the measured cost of a previous run
+  int const n_global[3] = {int(nx_global), int(ny_global), int(nz_global)};
+  int const n_proc[3]   = {nproc_x, nproc_y, nproc_z};
+  slab_index[0]         = ix[procID];
+  slab_index[1]         = iy[procID];
+  slab_index[2]         = iz[procID];
+  for (int axis = 0; axis < 3; axis++) {
+    slab_widths[axis] = Uniform_Slab_Widths(n_global[axis], n_proc[axis]);
+  }
+  if (P->load_balance_file[0] != '\0' && Read_Slab_Widths(P->load_balance_file, H->n_ghost, slab_widths)) {
+  #ifdef GRAVITY
+    // The Poisson solvers need blocks of the same size
+    for (int axis = 0; axis < 3; axis++) {
+      if (slab_widths[axis] != Uniform_Slab_Widths(n_global[axis], n_proc[axis])) {
+        CHOLLA_ERROR("The load balanced slabs of %s don't work with GRAVITY", P->load_balance_file);
+      }
+    }
+  #endif  // GRAVITY
+    ptrdiff_t *const local[3] = {&nx_local, &ny_local, &nz_local};
+    ptrdiff_t *const start[3] = {&nx_local_start, &ny_local_start, &nz_local_start};
+    for (int axis = 0; axis < 3; axis++) {
+      std::vector<int> const &widths = slab_widths[axis];
+      *local[axis]                   = widths[slab_index[axis]];
+      *start[axis]                   = std::accumulate(widths.begin(), widths.begin() + slab_index[axis], 0);
+    }
+    chprintf("Using the load balanced slabs of %s\n", P->load_balance_file);
+  }
+
   // find MPI sources
   for (i = 0; i < 6; i++) {
     source[i] = dest[i];
@@ -435,7 +770,18 @@ void DomainDecompositionBLOCK(struct Parameters *P, struct Header *H, int nx_gin
   source[4] = tiling[ix[procID]][iy[procID]][source[4]];
   source[5] = tiling[ix[procID]][iy[procID]][source[5]];
 
+  for (int dk = -1; dk <= 1; dk++) {
+    for (int dj = -1; dj <= 1; dj++) {
+      for (int di = -1; di <= 1; di++) {
+        neighbor_rank[(di + 1) + 3 * (dj + 1) + 9 * (dk + 1)] =
+            tiling[(ix[procID] + di + nproc_x) % nproc_x][(iy[procID] + dj + nproc_y) % nproc_y]
+                  [(iz[procID] + dk + nproc_z) % nproc_z];
+      }
+    }
+  }
+
   chprintf("nproc_x %d nproc_y %d nproc_z %d\n", nproc_x, nproc_y, nproc_z);
+  Print_Node_Local_Faces();
 
   // free the tiling
   deallocate_three_dimensional_int_array(tiling, nproc_x, nproc_y, nproc_z);
@@ -561,6 +907,22 @@ void Allocate_MPI_DeviceBuffers(struct Header *H)
   y_buffer_length = ybsize;
   z_buffer_length = zbsize;
 
+  #if defined(MPI_COALESCE_BOUNDARIES) && defined(GRAVITY)
+  // The potential boundaries are appended to the hydro ones
+  if (H->nz > 1) {
+    int const n_ghost_pot = N_GHOST_POTENTIAL;
+    int const nx_pot      = H->nx - 2 * H->n_ghost + 2 * n_ghost_pot;
+    int const ny_pot      = H->ny - 2 * H->n_ghost + 2 * n_ghost_pot;
+    int const nz_pot      = H->nz - 2 * H->n_ghost + 2 * n_ghost_pot;
+    xbsize += n_ghost_pot * ny_pot * nz_pot;
+    ybsize += n_ghost_pot * nx_pot * nz_pot;
+    zbsize += n_ghost_pot * nx_pot * ny_pot;
+  }
+  #endif  // MPI_COALESCE_BOUNDARIES
+  x_buffer_capacity = xbsize;
+  y_buffer_capacity = ybsize;
+  z_buffer_capacity = zbsize;
+
   #ifdef PARTICLES
   // Set Initial sizes for particles buffers
   int n_max            = std::max(H->nx, H->ny);
@@ -569,16 +931,21 @@ void Allocate_MPI_DeviceBuffers(struct Header *H)
   N_PARTICLES_TRANSFER = n_max * n_max * factor;
 
   // Set the number of values that will be transferred for each particle
+    #ifdef PARTICLES_GPU
+  // the GPU particles are packed into records with each field in its own type
+  N_DATA_PER_PARTICLE_TRANSFER = sizeof(ParticleTransferRecord) / sizeof(Real);
+    #else
   N_DATA_PER_PARTICLE_TRANSFER = 6;  // 3 positions and 3 velocities
-    #ifndef SINGLE_PARTICLE_MASS
+      #ifndef SINGLE_PARTICLE_MASS
   N_DATA_PER_PARTICLE_TRANSFER += 1;  // one more for the particle mass
-    #endif
-    #ifdef PARTICLE_IDS
+      #endif
+      #ifdef PARTICLE_IDS
   N_DATA_PER_PARTICLE_TRANSFER += 1;  // one more for the particle ID
-    #endif
-    #ifdef PARTICLE_AGE
+      #endif
+      #ifdef PARTICLE_AGE
   N_DATA_PER_PARTICLE_TRANSFER += 1;  // one more for the particle age
-    #endif
+      #endif
+    #endif  // PARTICLES_GPU
 
   buffer_length_particles_x0_send = N_PARTICLES_TRANSFER * N_DATA_PER_PARTICLE_TRANSFER;
   buffer_length_particles_x0_recv = N_PARTICLES_TRANSFER * N_DATA_PER_PARTICLE_TRANSFER;
@@ -597,33 +964,34 @@ void Allocate_MPI_DeviceBuffers(struct Header *H)
   chprintf("Allocating MPI communication buffers on GPU ");
   chprintf("(nx = %ld, ny = %ld, nz = %ld).\n", xbsize, ybsize, zbsize);
 
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_x0, xbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_x1, xbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_x0, xbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_x1, xbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_y0, ybsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_y1, ybsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_y0, ybsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_y1, ybsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_z0, zbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_z1, zbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_z0, zbsize * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_z1, zbsize * sizeof(Real)));
-
-  #if !defined(MPI_GPU)
-  h_send_buffer_x0 = (Real *)malloc(xbsize * sizeof(Real));
-  h_send_buffer_x1 = (Real *)malloc(xbsize * sizeof(Real));
-  h_recv_buffer_x0 = (Real *)malloc(xbsize * sizeof(Real));
-  h_recv_buffer_x1 = (Real *)malloc(xbsize * sizeof(Real));
-  h_send_buffer_y0 = (Real *)malloc(ybsize * sizeof(Real));
-  h_send_buffer_y1 = (Real *)malloc(ybsize * sizeof(Real));
-  h_recv_buffer_y0 = (Real *)malloc(ybsize * sizeof(Real));
-  h_recv_buffer_y1 = (Real *)malloc(ybsize * sizeof(Real));
-  h_send_buffer_z0 = (Real *)malloc(zbsize * sizeof(Real));
-  h_send_buffer_z1 = (Real *)malloc(zbsize * sizeof(Real));
-  h_recv_buffer_z0 = (Real *)malloc(zbsize * sizeof(Real));
-  h_recv_buffer_z1 = (Real *)malloc(zbsize * sizeof(Real));
-  #endif
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::boundaries);
+  cuda_utilities::Pool_Malloc(&d_send_buffer_x0, xbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_x1, xbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_x0, xbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_x1, xbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_y0, ybsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_y1, ybsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_y0, ybsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_y1, ybsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_z0, zbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_z1, zbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_z0, zbsize * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_z1, zbsize * sizeof(Real));
+
+  // Pinned host buffers, used to stage the messages when MPI is not GPU-aware
+  // or when staging is faster than sending the device buffers
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_x0, xbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_x1, xbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_x0, xbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_x1, xbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_y0, ybsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_y1, ybsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_y0, ybsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_y1, ybsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_z0, zbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_send_buffer_z1, zbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_z0, zbsize * sizeof(Real), cudaHostAllocDefault));
+  GPU_Error_Check(cudaHostAlloc(&h_recv_buffer_z1, zbsize * sizeof(Real), cudaHostAllocDefault));
 
   // NOTE: When changing this ifdef check for compatibility with
   // Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer
@@ -637,18 +1005,18 @@ void Allocate_MPI_DeviceBuffers(struct Header *H)
       "Allocating MPI communication buffers on GPU for particle transfers ( "
       "N_Particles: %d ).\n",
       N_PARTICLES_TRANSFER);
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_x0_particles, buffer_length_particles_x0_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_x1_particles, buffer_length_particles_x1_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_y0_particles, buffer_length_particles_y0_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_y1_particles, buffer_length_particles_y1_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_z0_particles, buffer_length_particles_z0_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_send_buffer_z1_particles, buffer_length_particles_z1_send * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_x0_particles, buffer_length_particles_x0_recv * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_x1_particles, buffer_length_particles_x1_recv * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_y0_particles, buffer_length_particles_y0_recv * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_y1_particles, buffer_length_particles_y1_recv * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_z0_particles, buffer_length_particles_z0_recv * sizeof(Real)));
-  GPU_Error_Check(cudaMalloc(&d_recv_buffer_z1_particles, buffer_length_particles_z1_recv * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_x0_particles, buffer_length_particles_x0_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_x1_particles, buffer_length_particles_x1_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_y0_particles, buffer_length_particles_y0_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_y1_particles, buffer_length_particles_y1_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_z0_particles, buffer_length_particles_z0_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_send_buffer_z1_particles, buffer_length_particles_z1_send * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_x0_particles, buffer_length_particles_x0_recv * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_x1_particles, buffer_length_particles_x1_recv * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_y0_particles, buffer_length_particles_y0_recv * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_y1_particles, buffer_length_particles_y1_recv * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_z0_particles, buffer_length_particles_z0_recv * sizeof(Real));
+  cuda_utilities::Pool_Malloc(&d_recv_buffer_z1_particles, buffer_length_particles_z1_recv * sizeof(Real));
   #endif  // PARTICLES && PARTICLES_GPU
 
   // CPU relies on host buffers, GPU without MPI_GPU relies on host buffers
@@ -688,6 +1056,12 @@ Real ReduceRealMax(Real x)
   return y;
 }
 
+/* MPI reduction wrapper for the element-wise max of n Reals, in place*/
+void ReduceRealMax(Real *x, int n)
+{
+  MPI_Allreduce(MPI_IN_PLACE, x, n, MPI_CHREAL, MPI_MAX, world);
+}
+
 /* MPI reduction wrapper for min(Real)*/
 Real ReduceRealMin(Real x)
 {
@@ -735,6 +1109,16 @@ size_t Reduce_size_t_Max(size_t in)
   return out;
 }
 
+void Broadcast_Bytes(void *buffer, size_t n_bytes)
+{
+  // Split the broadcast so counts past INT_MAX still work
+  size_t constexpr max_chunk = 1 << 30;
+  for (size_t offset = 0; offset < n_bytes; offset += max_chunk) {
+    int const count = (int)std::min(max_chunk, n_bytes - offset);
+    MPI_Bcast((char *)buffer + offset, count, MPI_BYTE, 0, world);
+  }
+}
+
   #ifdef PARTICLES
 /* MPI reduction wrapper for sum(part_int)*/
 Real ReducePartIntSum(part_int_t x)
@@ -962,9 +1346,68 @@ void deallocate_three_dimensional_int_array(int ***x, int n, int l, int m)
   delete x;
 }
 
+/* Time one exchange of a buffer pair with the neighbors along a direction.
+ * When staged the buffers are copied through the host buffers */
+static double Time_MPI_Exchange(Real *d_send, Real *d_recv, Real *h_send, Real *h_recv, int length, int dir,
+                                bool staged)
+{
+  MPI_Request requests[2];
+  MPI_Barrier(world);
+  double const start = MPI_Wtime();
+  if (staged) {
+    GPU_Error_Check(cudaMemcpy(h_send, d_send, length * sizeof(Real), cudaMemcpyDeviceToHost));
+  }
+  MPI_Irecv(staged ? h_recv : d_recv, length, MPI_CHREAL, source[2 * dir], dir, world, &requests[0]);
+  MPI_Isend(staged ? h_send : d_send, length, MPI_CHREAL, dest[2 * dir], dir, world, &requests[1]);
+  MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+  if (staged) {
+    GPU_Error_Check(cudaMemcpy(d_recv, h_recv, length * sizeof(Real), cudaMemcpyHostToDevice));
+  }
+  return MPI_Wtime() - start;
+}
+
+void Probe_MPI_GPU_Direct(struct Header *H)
+{
+  #ifdef MPI_GPU
+  int const n_reps    = 5;
+  Real *d_send[3]     = {d_send_buffer_x0, d_send_buffer_y0, d_send_buffer_z0};
+  Real *d_recv[3]     = {d_recv_buffer_x0, d_recv_buffer_y0, d_recv_buffer_z0};
+  Real *h_send[3]     = {h_send_buffer_x0, h_send_buffer_y0, h_send_buffer_z0};
+  Real *h_recv[3]     = {h_recv_buffer_x0, h_recv_buffer_y0, h_recv_buffer_z0};
+  int const length[3] = {x_buffer_length, y_buffer_length, z_buffer_length};
+  int const n_dims    = (H->nz > 1) ? 3 : ((H->ny > 1) ? 2 : 1);
+  char const axis[3]  = {'x', 'y', 'z'};
+
+  double time_direct = 0, time_staged = 0;
+  for (int dir = 0; dir < n_dims; dir++) {
+    double time[2] = {0, 0};
+    for (int staged = 0; staged < 2; staged++) {
+      // the first exchange sets up the MPI internals and isn't timed
+      Time_MPI_Exchange(d_send[dir], d_recv[dir], h_send[dir], h_recv[dir], length[dir], dir, staged);
+      for (int rep = 0; rep < n_reps; rep++) {
+        time[staged] += Time_MPI_Exchange(d_send[dir], d_recv[dir], h_send[dir], h_recv[dir], length[dir], dir, staged);
+      }
+      // every rank has to make the same choice
+      time[staged] = ReduceRealMax(time[staged]);
+    }
+    Real const gigabytes = Real(n_reps) * length[dir] * sizeof(Real) / 1.0e9;
+    chprintf("MPI transfer probe along %c (%d values): direct %.2f GB/s, staged %.2f GB/s\n", axis[dir], length[dir],
+             gigabytes / time[0], gigabytes / time[1]);
+    time_direct += time[0];
+    time_staged += time[1];
+  }
+
+  mpi_gpu_direct = time_direct <= time_staged;
+  chprintf("MPI transfers use the %s buffers.\n", mpi_gpu_direct ? "device" : "staged host");
+  #else
+  // Without GPU-aware MPI the messages always go through the host
+  mpi_gpu_direct = false;
+  #endif  // MPI_GPU
+}
+
 void copyHostToDeviceReceiveBuffer(int direction)
 {
-  int xbsize = x_buffer_length, ybsize = y_buffer_length, zbsize = z_buffer_length;
+  int xbsize = x_buffer_capacity, ybsize = y_buffer_capacity, zbsize = z_buffer_capacity;
 
   switch (direction) {
     case (0):
@@ -0,0 +1,210 @@
+/*! \file nvshmem_boundaries.cu
+ *  \brief Definitions of the 26 neighbor hydro boundary exchange through
+ *  NVSHMEM. */
+
+#if defined(MPI_CHOLLA) && defined(NVSHMEM_BOUNDARIES)
+
+  #ifdef O_HIP
+    #error "NVSHMEM_BOUNDARIES requires CUDA"
+  #endif  // O_HIP
+
+  #include <nvshmem.h>
+  #include <nvshmemx.h>
+
+  #include <algorithm>
+  #include <cstdint>
+
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../mpi/mpi_routines.h"
+  #include "../mpi/nvshmem_boundaries.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/error_handling.h"
+
+namespace
+{
+// The largest number of blocks that pack or unpack a single box
+int constexpr max_blocks_per_box = 32;
+
+// The symmetric buffers of the exchange. The neighbors write into the receive
+// buffer, the send buffer only stages the boxes of the neighbors that can't be
+// written with stores
+Real *nvshmem_send_buffer = nullptr;
+Real *nvshmem_recv_buffer = nullptr;
+
+// signals[b] counts the blocks of the box that arrived in receive box b and
+// signals[max_boxes + b] the blocks of send box b that the neighbor unpacked.
+// They only grow, by one block per box and exchange
+uint64_t *nvshmem_signals = nullptr;
+
+// The number of exchanges so far
+uint64_t nvshmem_exchange = 0;
+
+// The PEs of the neighbors of the boxes, passed to the kernels by value
+struct BoxNeighbors {
+  int pe[BufferBoxes::max_boxes];
+};
+
+// The values of box that block blockIdx.x of gridDim.x blocks packs or unpacks.
+// The values of a box are contiguous in the buffer, field after field
+__device__ void Block_Values(BufferBox const &box, int n_fields, int &box_ncells, int &first, int &last)
+{
+  box_ncells         = box.isize * box.jsize * box.ksize;
+  int const n_values = n_fields * box_ncells;
+  int const chunk    = (n_values + gridDim.x - 1) / gridDim.x;
+  first              = min(blockIdx.x * chunk, n_values);
+  last               = min(first + chunk, n_values);
+}
+
+__device__ int Box_Grid_Index(BufferBox const &box, int value, int box_ncells, int nx, int ny, int n_cells)
+{
+  int i, j, k;
+  cuda_utilities::compute3DIndices(value % box_ncells, box.isize, box.jsize, i, j, k);
+  return (value / box_ncells) * n_cells + i + (j + k * ny) * nx + box.idxoffset;
+}
+
+// Block (blockIdx.x, b) packs its part of send box b. When the receive buffer
+// of the neighbor is reachable with stores the values are written into it
+// directly, otherwise they are staged in the send buffer and put. Either way
+// the block adds one to the arrival signal of the box at the neighbor
+__global__ void Pack_And_Put_Boxes_Kernel(Real *c_head, int nx, int ny, int n_fields, int n_cells,
+                                          BufferBoxes send_boxes, BufferBoxes recv_boxes, BoxNeighbors neighbors,
+                                          Real *send_buffer, Real *recv_buffer, uint64_t *signals, uint64_t exchange)
+{
+  int const b                = blockIdx.y;
+  int const pe               = neighbors.pe[b];
+  BufferBox const &send      = send_boxes.box[b];
+  BufferBox const &peer_recv = recv_boxes.box[send_boxes.n_boxes - 1 - b];
+  int box_ncells, first, last;
+  Block_Values(send, n_fields, box_ncells, first, last);
+
+  // The neighbor has to be done with the previous exchange before its receive
+  // buffer is overwritten
+  if (threadIdx.x == 0) {
+    nvshmem_signal_wait_until(&signals[BufferBoxes::max_boxes + b], NVSHMEM_CMP_GE, (exchange - 1) * gridDim.x);
+  }
+  __syncthreads();
+
+  Real *const remote = static_cast<Real *>(nvshmem_ptr(recv_buffer, pe));
+  Real *const values = (remote != nullptr) ? remote + n_fields * peer_recv.cell_start
+                                           : send_buffer + n_fields * send.cell_start;
+  for (int value = first + threadIdx.x; value < last; value += blockDim.x) {
+    values[value] = c_head[Box_Grid_Index(send, value, box_ncells, nx, ny, n_cells)];
+  }
+  if (remote != nullptr) {
+    __threadfence_system();
+  }
+  __syncthreads();
+
+  uint64_t *const arrived = &signals[send_boxes.n_boxes - 1 - b];
+  if (remote == nullptr && last > first) {
+    nvshmemx_putmem_signal_nbi_block(recv_buffer + n_fields * peer_recv.cell_start + first, values + first,
+                                     (last - first) * sizeof(Real), arrived, 1, NVSHMEM_SIGNAL_ADD, pe);
+  } else if (threadIdx.x == 0) {
+    nvshmemx_signal_op(arrived, 1, NVSHMEM_SIGNAL_ADD, pe);
+  }
+}
+
+// Block (blockIdx.x, b) waits for all of receive box b, unpacks its part and
+// tells the neighbor that sent it that its part of the buffer is free again
+__global__ void Wait_And_Unpack_Boxes_Kernel(Real *c_head, int nx, int ny, int n_fields, int n_cells,
+                                             BufferBoxes recv_boxes, BoxNeighbors neighbors, Real const *recv_buffer,
+                                             uint64_t *signals, uint64_t exchange)
+{
+  int const b           = blockIdx.y;
+  BufferBox const &recv = recv_boxes.box[b];
+  int box_ncells, first, last;
+  Block_Values(recv, n_fields, box_ncells, first, last);
+
+  if (threadIdx.x == 0) {
+    nvshmem_signal_wait_until(&signals[b], NVSHMEM_CMP_GE, exchange * gridDim.x);
+  }
+  __syncthreads();
+
+  Real const *const values = recv_buffer + n_fields * recv.cell_start;
+  for (int value = first + threadIdx.x; value < last; value += blockDim.x) {
+    c_head[Box_Grid_Index(recv, value, box_ncells, nx, ny, n_cells)] = values[value];
+  }
+  __syncthreads();
+
+  if (threadIdx.x == 0) {
+    nvshmemx_signal_op(&signals[BufferBoxes::max_boxes + recv_boxes.n_boxes - 1 - b], 1, NVSHMEM_SIGNAL_ADD,
+                       neighbors.pe[b]);
+  }
+}
+}  // namespace
+
+void Initialize_NVSHMEM()
+{
+  nvshmemx_init_attr_t attr;
+  attr.mpi_comm = &world;
+  nvshmemx_init_attr(NVSHMEMX_INIT_WITH_MPI_COMM, &attr);
+  if (nvshmem_my_pe() != procID) {
+    CHOLLA_ERROR("NVSHMEM PE %d doesn't match MPI rank %d", nvshmem_my_pe(), procID);
+  }
+}
+
+void Allocate_NVSHMEM_Buffers(int n_values)
+{
+  // The neighbors write a box at the offset it has in their own receive
+  // buffer, which only holds if every rank has the same boxes
+  int min_values, max_values;
+  MPI_Allreduce(&n_values, &min_values, 1, MPI_INT, MPI_MIN, world);
+  MPI_Allreduce(&n_values, &max_values, 1, MPI_INT, MPI_MAX, world);
+  if (min_values != max_values) {
+    CHOLLA_ERROR("NVSHMEM_BOUNDARIES requires the same local grid on every rank");
+  }
+
+  chprintf("Allocating NVSHMEM buffers for the 26 neighbor boundary exchange.\n");
+  nvshmem_send_buffer = static_cast<Real *>(nvshmem_malloc(n_values * sizeof(Real)));
+  nvshmem_recv_buffer = static_cast<Real *>(nvshmem_malloc(n_values * sizeof(Real)));
+  nvshmem_signals     = static_cast<uint64_t *>(nvshmem_calloc(2 * BufferBoxes::max_boxes, sizeof(uint64_t)));
+  if (nvshmem_send_buffer == nullptr || nvshmem_recv_buffer == nullptr || nvshmem_signals == nullptr) {
+    CHOLLA_ERROR("Failed to allocate %d values on the NVSHMEM symmetric heap", 2 * n_values);
+  }
+}
+
+void Exchange_Boxes_NVSHMEM(Real *c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const &send_boxes,
+                            BufferBoxes const &recv_boxes, int const neighbor[], cudaStream_t stream)
+{
+  if (nvshmem_recv_buffer == nullptr) {
+    CHOLLA_ERROR("The NVSHMEM buffers are only allocated for 3D grids");
+  }
+
+  BoxNeighbors neighbors;
+  int max_values = 0;
+  for (int b = 0; b < send_boxes.n_boxes; b++) {
+    BufferBox const &box = send_boxes.box[b];
+    neighbors.pe[b]      = neighbor[b];
+    max_values           = std::max(max_values, n_fields * box.isize * box.jsize * box.ksize);
+  }
+
+  // Enough blocks for the largest boxes, both kernels have to agree on the
+  // number since the signals count the blocks
+  int const blocks_per_box = std::min((max_values + TPB - 1) / TPB, max_blocks_per_box);
+  dim3 const grid(blocks_per_box, send_boxes.n_boxes, 1);
+  nvshmem_exchange++;
+
+  hipLaunchKernelGGL(Pack_And_Put_Boxes_Kernel, grid, dim3(TPB, 1, 1), 0, stream, c_head, nx, ny, n_fields, n_cells,
+                     send_boxes, recv_boxes, neighbors, nvshmem_send_buffer, nvshmem_recv_buffer, nvshmem_signals,
+                     nvshmem_exchange);
+  GPU_Error_Check();
+  hipLaunchKernelGGL(Wait_And_Unpack_Boxes_Kernel, grid, dim3(TPB, 1, 1), 0, stream, c_head, nx, ny, n_fields, n_cells,
+                     recv_boxes, neighbors, nvshmem_recv_buffer, nvshmem_signals, nvshmem_exchange);
+  GPU_Error_Check();
+}
+
+void Finalize_NVSHMEM()
+{
+  // The last exchange has to be unpacked everywhere before the buffers go
+  GPU_Error_Check(cudaDeviceSynchronize());
+  nvshmem_barrier_all();
+  if (nvshmem_recv_buffer != nullptr) {
+    nvshmem_free(nvshmem_send_buffer);
+    nvshmem_free(nvshmem_recv_buffer);
+    nvshmem_free(nvshmem_signals);
+  }
+  nvshmem_finalize();
+}
+
+#endif  // MPI_CHOLLA && NVSHMEM_BOUNDARIES
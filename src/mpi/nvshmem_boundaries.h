@@ -0,0 +1,39 @@
+/*! \file nvshmem_boundaries.h
+ *  \brief Declarations of the 26 neighbor hydro boundary exchange through
+ *  NVSHMEM. The pack kernel writes the boxes straight into the receive buffers
+ *  of the neighbors and signals their arrival, so the exchange never goes
+ *  through the host or MPI. */
+
+#pragma once
+
+#if defined(MPI_CHOLLA) && defined(NVSHMEM_BOUNDARIES)
+
+  #include "../global/global.h"
+  #include "../grid/cuda_boundaries.h"
+  #include "../utils/gpu.hpp"
+
+/*! \fn void Initialize_NVSHMEM()
+ *  \brief Initialize NVSHMEM on the world communicator, so the PE of each rank
+ *  is its rank. Called after the device of the rank is selected. */
+void Initialize_NVSHMEM();
+
+/*! \fn void Allocate_NVSHMEM_Buffers(int n_values)
+ *  \brief Allocate the symmetric send and receive buffers of n_values values
+ *  and the arrival signals. Every rank has to call it, with the same n_values */
+void Allocate_NVSHMEM_Buffers(int n_values);
+
+/*! \fn void Exchange_Boxes_NVSHMEM(Real *c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const
+ * &send_boxes, BufferBoxes const &recv_boxes, int const neighbor[], cudaStream_t stream)
+ *  \brief Send box b of send_boxes to rank neighbor[b] and set the ghost cells
+ *  of recv_boxes from the boxes the neighbors send. The boxes are ordered so
+ *  that box b is received from the neighbor that sends towards box
+ *  n_boxes - 1 - b, and every rank has the same boxes. */
+void Exchange_Boxes_NVSHMEM(Real *c_head, int nx, int ny, int n_fields, int n_cells, BufferBoxes const &send_boxes,
+                            BufferBoxes const &recv_boxes, int const neighbor[], cudaStream_t stream);
+
+/*! \fn void Finalize_NVSHMEM()
+ *  \brief Free the symmetric buffers and finalize NVSHMEM, before MPI is
+ *  finalized. */
+void Finalize_NVSHMEM();
+
+#endif  // MPI_CHOLLA && NVSHMEM_BOUNDARIES
@@ -3,6 +3,7 @@
   #include <stdio.h>
   #include <stdlib.h>
 
+  #include <algorithm>
   #include <iostream>
 
   #include "../global/global.h"
@@ -19,7 +20,9 @@
 void Particles3D::Get_Density_CIC()
 {
   #ifdef PARTICLES_CPU
-    #ifdef PARALLEL_OMP
+    #if defined(PARALLEL_OMP) && defined(PARTICLES_OMP_DYNAMIC)
+  Get_Density_CIC_OMP_Dynamic();
+    #elif defined(PARALLEL_OMP)
   Get_Density_CIC_OMP();
     #else
   Get_Density_CIC_Serial();
@@ -54,7 +57,19 @@ void Grid3D::Copy_Particles_Density_to_Gravity(struct Parameters P)
   Transfer_Particles_Density_Boundaries(P);
 
   // Step 3: Copy Particles density to Gravity array
+  #ifdef POISSON_FUSED_IO
+  // The Paris solver reads the CIC density straight from the particle grid,
+  // unless the multipole boundaries need the total density first
+  if (P.bc_potential_type == 2) {
+    Copy_Particles_Density();
+  } else {
+    #ifdef PARTICLES_CPU
+    Copy_Particles_Density_to_GPU();
+    #endif  // PARTICLES_CPU
+  }
+  #else   // not POISSON_FUSED_IO
   Copy_Particles_Density();
+  #endif  // POISSON_FUSED_IO
 
   #ifdef CPU_TIME
   Timer.Part_Dens_Transf.End();
@@ -136,9 +151,11 @@ void Particles3D::Clear_Density_GPU() { Clear_Density_GPU_function(G.density_dev
 
 void Particles3D::Get_Density_CIC_GPU()
 {
-  Get_Density_CIC_GPU_function(n_local, particle_mass, G.xMin, G.xMax, G.yMin, G.yMax, G.zMin, G.zMax, G.dx, G.dy, G.dz,
-                               G.nx_local, G.ny_local, G.nz_local, G.n_ghost_particles_grid, G.n_cells, G.density,
-                               G.density_dev, pos_x_dev, pos_y_dev, pos_z_dev, mass_dev);
+  Get_Density_CIC_GPU_function(n_local, particle_mass, G.xMin - G.pos_origin_x, G.xMax - G.pos_origin_x,
+                               G.yMin - G.pos_origin_y, G.yMax - G.pos_origin_y, G.zMin - G.pos_origin_z,
+                               G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                               G.n_ghost_particles_grid, G.n_cells, G.density, G.density_dev, pos_x_dev, pos_y_dev,
+                               pos_z_dev, mass_dev);
 }
 
   #endif  // PARTICLES_GPU
@@ -153,8 +170,8 @@ void Get_Indexes_CIC(Real xMin, Real yMin, Real zMin, Real dx, Real dy, Real dz,
   indx_z = (int)floor((pos_z - zMin - 0.5 * dz) / dz);
 }
 
-// Comute the CIC density (NO OpenMP)
-void Particles3D::Get_Density_CIC_Serial()
+// Add the CIC density of particle pIndx to density
+void Particles3D::Add_Particle_Density_CIC(part_int_t pIndx, Real *density)
 {
   int nGHST = G.n_ghost_particles_grid;
   int nx_g  = G.nx_local + 2 * nGHST;
@@ -169,101 +186,104 @@ void Particles3D::Get_Density_CIC_Serial()
   dy   = G.dy;
   dz   = G.dz;
 
-  part_int_t pIndx;
   int indx_x, indx_y, indx_z, indx;
   Real pMass, x_pos, y_pos, z_pos;
 
   Real cell_center_x, cell_center_y, cell_center_z;
   Real delta_x, delta_y, delta_z;
   Real dV_inv = 1. / (G.dx * G.dy * G.dz);
-  bool ignore, in_local;
-
-  for (pIndx = 0; pIndx < n_local; pIndx++) {
-    ignore   = false;
-    in_local = true;
+  bool ignore   = false;
+  bool in_local = true;
 
     #ifdef SINGLE_PARTICLE_MASS
-    pMass = particle_mass * dV_inv;
+  pMass = particle_mass * dV_inv;
     #else
-    pMass = mass[pIndx] * dV_inv;
+  pMass = mass[pIndx] * dV_inv;
     #endif
-    x_pos = pos_x[pIndx];
-    y_pos = pos_y[pIndx];
-    z_pos = pos_z[pIndx];
-    Get_Indexes_CIC(xMin, yMin, zMin, dx, dy, dz, x_pos, y_pos, z_pos, indx_x, indx_y, indx_z);
-    if (indx_x < -1) ignore = true;
-    if (indx_y < -1) ignore = true;
-    if (indx_z < -1) ignore = true;
-    if (indx_x > nx_g - 3) ignore = true;
-    if (indx_y > ny_g - 3) ignore = true;
-    if (indx_y > nz_g - 3) ignore = true;
-    if (x_pos < G.xMin || x_pos >= G.xMax) in_local = false;
-    if (y_pos < G.yMin || y_pos >= G.yMax) in_local = false;
-    if (z_pos < G.zMin || z_pos >= G.zMax) in_local = false;
-    if (!in_local) {
-      std::cout << " Density CIC Error:" << std::endl;
+  x_pos = pos_x[pIndx];
+  y_pos = pos_y[pIndx];
+  z_pos = pos_z[pIndx];
+  Get_Indexes_CIC(xMin, yMin, zMin, dx, dy, dz, x_pos, y_pos, z_pos, indx_x, indx_y, indx_z);
+  if (indx_x < -1) ignore = true;
+  if (indx_y < -1) ignore = true;
+  if (indx_z < -1) ignore = true;
+  if (indx_x > nx_g - 3) ignore = true;
+  if (indx_y > ny_g - 3) ignore = true;
+  if (indx_y > nz_g - 3) ignore = true;
+  if (x_pos < G.xMin || x_pos >= G.xMax) in_local = false;
+  if (y_pos < G.yMin || y_pos >= G.yMax) in_local = false;
+  if (z_pos < G.zMin || z_pos >= G.zMax) in_local = false;
+  if (!in_local) {
+    std::cout << " Density CIC Error:" << std::endl;
     #ifdef PARTICLE_IDS
-      std::cout << " Particle outside Local  domain    pID: " << partIDs[pIndx] << std::endl;
+    std::cout << " Particle outside Local  domain    pID: " << partIDs[pIndx] << std::endl;
     #else
-      std::cout << " Particle outside Local  domain " << std::endl;
+    std::cout << " Particle outside Local  domain " << std::endl;
     #endif
-      std::cout << "  Domain X: " << G.xMin << "  " << G.xMax << std::endl;
-      std::cout << "  Domain Y: " << G.yMin << "  " << G.yMax << std::endl;
-      std::cout << "  Domain Z: " << G.zMin << "  " << G.zMax << std::endl;
-      std::cout << "  Particle X: " << x_pos << std::endl;
-      std::cout << "  Particle Y: " << y_pos << std::endl;
-      std::cout << "  Particle Z: " << z_pos << std::endl;
-      continue;
-    }
-    if (ignore) {
+    std::cout << "  Domain X: " << G.xMin << "  " << G.xMax << std::endl;
+    std::cout << "  Domain Y: " << G.yMin << "  " << G.yMax << std::endl;
+    std::cout << "  Domain Z: " << G.zMin << "  " << G.zMax << std::endl;
+    std::cout << "  Particle X: " << x_pos << std::endl;
+    std::cout << "  Particle Y: " << y_pos << std::endl;
+    std::cout << "  Particle Z: " << z_pos << std::endl;
+    return;
+  }
+  if (ignore) {
     #ifdef PARTICLE_IDS
-      std::cout << "ERROR Density CIC Index    pID: " << partIDs[pIndx] << std::endl;
+    std::cout << "ERROR Density CIC Index    pID: " << partIDs[pIndx] << std::endl;
     #else
-      std::cout << "ERROR Density CIC Index " << std::endl;
+    std::cout << "ERROR Density CIC Index " << std::endl;
     #endif
-      std::cout << "Negative xIndx: " << x_pos << "  " << indx_x << std::endl;
-      std::cout << "Negative zIndx: " << z_pos << "  " << indx_z << std::endl;
-      std::cout << "Negative yIndx: " << y_pos << "  " << indx_y << std::endl;
-      std::cout << "Excess xIndx: " << x_pos << "  " << indx_x << std::endl;
-      std::cout << "Excess yIndx: " << y_pos << "  " << indx_y << std::endl;
-      std::cout << "Excess zIndx: " << z_pos << "  " << indx_z << std::endl;
-      std::cout << std::endl;
-      // exit(-1);
-      continue;
-    }
-    cell_center_x = xMin + indx_x * dx + 0.5 * dx;
-    cell_center_y = yMin + indx_y * dy + 0.5 * dy;
-    cell_center_z = zMin + indx_z * dz + 0.5 * dz;
-    delta_x       = 1 - (x_pos - cell_center_x) / dx;
-    delta_y       = 1 - (y_pos - cell_center_y) / dy;
-    delta_z       = 1 - (z_pos - cell_center_z) / dz;
-    indx_x += nGHST;
-    indx_y += nGHST;
-    indx_z += nGHST;
+    std::cout << "Negative xIndx: " << x_pos << "  " << indx_x << std::endl;
+    std::cout << "Negative zIndx: " << z_pos << "  " << indx_z << std::endl;
+    std::cout << "Negative yIndx: " << y_pos << "  " << indx_y << std::endl;
+    std::cout << "Excess xIndx: " << x_pos << "  " << indx_x << std::endl;
+    std::cout << "Excess yIndx: " << y_pos << "  " << indx_y << std::endl;
+    std::cout << "Excess zIndx: " << z_pos << "  " << indx_z << std::endl;
+    std::cout << std::endl;
+    // exit(-1);
+    return;
+  }
+  cell_center_x = xMin + indx_x * dx + 0.5 * dx;
+  cell_center_y = yMin + indx_y * dy + 0.5 * dy;
+  cell_center_z = zMin + indx_z * dz + 0.5 * dz;
+  delta_x       = 1 - (x_pos - cell_center_x) / dx;
+  delta_y       = 1 - (y_pos - cell_center_y) / dy;
+  delta_z       = 1 - (z_pos - cell_center_z) / dz;
+  indx_x += nGHST;
+  indx_y += nGHST;
+  indx_z += nGHST;
 
-    indx = indx_x + indx_y * nx_g + indx_z * nx_g * ny_g;
-    G.density[indx] += pMass * delta_x * delta_y * delta_z;
+  indx = indx_x + indx_y * nx_g + indx_z * nx_g * ny_g;
+  density[indx] += pMass * delta_x * delta_y * delta_z;
 
-    indx = (indx_x + 1) + indx_y * nx_g + indx_z * nx_g * ny_g;
-    G.density[indx] += pMass * (1 - delta_x) * delta_y * delta_z;
+  indx = (indx_x + 1) + indx_y * nx_g + indx_z * nx_g * ny_g;
+  density[indx] += pMass * (1 - delta_x) * delta_y * delta_z;
 
-    indx = indx_x + (indx_y + 1) * nx_g + indx_z * nx_g * ny_g;
-    G.density[indx] += pMass * delta_x * (1 - delta_y) * delta_z;
+  indx = indx_x + (indx_y + 1) * nx_g + indx_z * nx_g * ny_g;
+  density[indx] += pMass * delta_x * (1 - delta_y) * delta_z;
 
-    indx = indx_x + indx_y * nx_g + (indx_z + 1) * nx_g * ny_g;
-    G.density[indx] += pMass * delta_x * delta_y * (1 - delta_z);
+  indx = indx_x + indx_y * nx_g + (indx_z + 1) * nx_g * ny_g;
+  density[indx] += pMass * delta_x * delta_y * (1 - delta_z);
 
-    indx = (indx_x + 1) + (indx_y + 1) * nx_g + indx_z * nx_g * ny_g;
-    G.density[indx] += pMass * (1 - delta_x) * (1 - delta_y) * delta_z;
+  indx = (indx_x + 1) + (indx_y + 1) * nx_g + indx_z * nx_g * ny_g;
+  density[indx] += pMass * (1 - delta_x) * (1 - delta_y) * delta_z;
 
-    indx = (indx_x + 1) + indx_y * nx_g + (indx_z + 1) * nx_g * ny_g;
-    G.density[indx] += pMass * (1 - delta_x) * delta_y * (1 - delta_z);
+  indx = (indx_x + 1) + indx_y * nx_g + (indx_z + 1) * nx_g * ny_g;
+  density[indx] += pMass * (1 - delta_x) * delta_y * (1 - delta_z);
 
-    indx = indx_x + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
-    G.density[indx] += pMass * delta_x * (1 - delta_y) * (1 - delta_z);
+  indx = indx_x + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
+  density[indx] += pMass * delta_x * (1 - delta_y) * (1 - delta_z);
 
-    indx = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
-    G.density[indx] += pMass * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
+  indx = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
+  density[indx] += pMass * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
+}
+
+// Comute the CIC density (NO OpenMP)
+void Particles3D::Get_Density_CIC_Serial()
+{
+  for (part_int_t pIndx = 0; pIndx < n_local; pIndx++) {
+    Add_Particle_Density_CIC(pIndx, G.density);
   }
 }
 
@@ -413,7 +433,37 @@ void Particles3D::Get_Density_CIC_OMP()
     }
   }
 }
-    #endif  // PARALLEL_OMP
+
+      #ifdef PARTICLES_OMP_DYNAMIC
+// Compute the CIC density when PARALLEL_OMP, handing out chunks of particles
+// to the threads as they finish the previous ones. Each thread adds its
+// particles to a private density grid, so the work does not depend on where
+// the particles are, and the grids are summed at the end
+void Particles3D::Get_Density_CIC_OMP_Dynamic()
+{
+  G.density_threads.resize(size_t(N_OMP_THREADS) * G.n_cells);
+
+        #pragma omp parallel num_threads(N_OMP_THREADS)
+  {
+    int const n_omp_procs = omp_get_num_threads();
+    Real *density         = G.density_threads.data() + size_t(omp_get_thread_num()) * G.n_cells;
+    std::fill(density, density + G.n_cells, 0);
+
+        #pragma omp for schedule(dynamic, PARTICLES_OMP_CHUNK)
+    for (part_int_t pIndx = 0; pIndx < n_local; pIndx++) {
+      Add_Particle_Density_CIC(pIndx, density);
+    }
+
+        #pragma omp for schedule(static)
+    for (int id = 0; id < G.n_cells; id++) {
+      for (int thread = 0; thread < n_omp_procs; thread++) {
+        G.density[id] += G.density_threads[size_t(thread) * G.n_cells + id];
+      }
+    }
+  }
+}
+      #endif  // PARTICLES_OMP_DYNAMIC
+    #endif    // PARALLEL_OMP
 
   #endif  // PARTICLES_CPU
 
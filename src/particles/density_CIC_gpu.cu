@@ -47,8 +47,8 @@ __device__ void Get_Indexes_CIC(Real xMin, Real yMin, Real zMin, Real dx, Real d
 }
 
 // CUDA Kernel to compute the CIC density from the particles positions
-__global__ void Get_Density_CIC_Kernel(part_int_t n_local, Real particle_mass, Real *density_dev, Real *pos_x_dev,
-                                       Real *pos_y_dev, Real *pos_z_dev, Real *mass_dev, Real xMin, Real yMin,
+__global__ void Get_Density_CIC_Kernel(part_int_t n_local, Real particle_mass, Real *density_dev, Real_Part *pos_x_dev,
+                                       Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real *mass_dev, Real xMin, Real yMin,
                                        Real zMin, Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz, int nx,
                                        int ny, int nz, int n_ghost)
 {
@@ -141,6 +141,149 @@ __global__ void Get_Density_CIC_Kernel(part_int_t n_local, Real particle_mass, R
   atomicAdd(&density_dev[indx], pMass * (1 - delta_x) * (1 - delta_y) * (1 - delta_z));
 }
 
+    #ifdef PARTICLES_CIC_TILES
+// CUDA Kernel to get the deposit tile of each particle. The particles outside
+// the local domain get the key n_tiles, so they don't belong to any tile
+__global__ void Get_CIC_Tile_Keys_Kernel(part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                         Real_Part *pos_z_dev, Real xMin, Real yMin, Real zMin, Real xMax, Real yMax,
+                                         Real zMax, Real dx, Real dy, Real dz, int n_ghost, int n_tiles_x,
+                                         int n_tiles_y, int n_tiles, int *keys_dev, int *indices_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  Real pos_x = pos_x_dev[tid];
+  Real pos_y = pos_y_dev[tid];
+  Real pos_z = pos_z_dev[tid];
+
+  indices_dev[tid] = tid;
+  if (pos_x < xMin || pos_x >= xMax || pos_y < yMin || pos_y >= yMax || pos_z < zMin || pos_z >= zMax) {
+    printf(
+        " Density CIC Error: Particle outside local domain [%f  %f  %f]  [%f "
+        "%f] [%f %f] [%f %f]\n ",
+        pos_x, pos_y, pos_z, xMin, xMax, yMin, yMax, zMin, zMax);
+    keys_dev[tid] = n_tiles;
+    return;
+  }
+
+  int indx_x, indx_y, indx_z;
+  Get_Indexes_CIC(xMin, yMin, zMin, dx, dy, dz, pos_x, pos_y, pos_z, indx_x, indx_y, indx_z);
+  int const tile_x = (indx_x + n_ghost) / CIC_TILE_SIZE;
+  int const tile_y = (indx_y + n_ghost) / CIC_TILE_SIZE;
+  int const tile_z = (indx_z + n_ghost) / CIC_TILE_SIZE;
+  keys_dev[tid]    = tile_x + n_tiles_x * (tile_y + n_tiles_y * tile_z);
+}
+
+// CUDA Kernel to get the range of the sorted particles of each tile. Empty
+// tiles keep start = end = 0
+__global__ void Get_CIC_Tile_Ranges_Kernel(part_int_t n_local, int *keys_dev, int n_tiles, int *tile_start_dev,
+                                           int *tile_end_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  int const key = keys_dev[tid];
+  if (key >= n_tiles) {
+    return;
+  }
+  if (tid == 0 || keys_dev[tid - 1] != key) {
+    tile_start_dev[key] = tid;
+  }
+  if (tid == n_local - 1 || keys_dev[tid + 1] != key) {
+    tile_end_dev[key] = tid + 1;
+  }
+}
+
+// CUDA Kernel to compute the CIC density of the particles of one tile per
+// block. The tile and its upper neighbor cells are accumulated in shared memory
+// and then added to the global density once per cell
+__global__ __launch_bounds__(TPB_CIC_TILE) void Get_Density_CIC_Tiles_Kernel(
+    Real particle_mass, Real *density_dev, Real_Part *pos_x_dev, Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+    Real *mass_dev, int *indices_dev, int *tile_start_dev, int *tile_end_dev, Real xMin, Real yMin, Real zMin, Real dx,
+    Real dy, Real dz, int nx, int ny, int nz, int n_ghost, int n_tiles_x, int n_tiles_y)
+{
+  int constexpr tile_len   = CIC_TILE_SIZE + 1;
+  int constexpr tile_cells = tile_len * tile_len * tile_len;
+  __shared__ Real tile[tile_cells];
+
+  int const start = tile_start_dev[blockIdx.x];
+  int const end   = tile_end_dev[blockIdx.x];
+  if (start == end) {
+    return;
+  }
+
+  // First base cell of the tile, including the ghost cells
+  int const x0 = (blockIdx.x % n_tiles_x) * CIC_TILE_SIZE;
+  int const y0 = ((blockIdx.x / n_tiles_x) % n_tiles_y) * CIC_TILE_SIZE;
+  int const z0 = (blockIdx.x / (n_tiles_x * n_tiles_y)) * CIC_TILE_SIZE;
+
+  for (int i = threadIdx.x; i < tile_cells; i += blockDim.x) {
+    tile[i] = 0;
+  }
+  __syncthreads();
+
+  Real dV_inv = 1. / (dx * dy * dz);
+  for (int p = start + threadIdx.x; p < end; p += blockDim.x) {
+    int const id = indices_dev[p];
+    Real pos_x   = pos_x_dev[id];
+    Real pos_y   = pos_y_dev[id];
+    Real pos_z   = pos_z_dev[id];
+
+      #ifdef SINGLE_PARTICLE_MASS
+    Real pMass = particle_mass * dV_inv;
+      #else
+    Real pMass = mass_dev[id] * dV_inv;
+      #endif
+
+    int indx_x, indx_y, indx_z;
+    Get_Indexes_CIC(xMin, yMin, zMin, dx, dy, dz, pos_x, pos_y, pos_z, indx_x, indx_y, indx_z);
+
+    Real cell_center_x = xMin + indx_x * dx + 0.5 * dx;
+    Real cell_center_y = yMin + indx_y * dy + 0.5 * dy;
+    Real cell_center_z = zMin + indx_z * dz + 0.5 * dz;
+    Real delta_x       = 1 - (pos_x - cell_center_x) / dx;
+    Real delta_y       = 1 - (pos_y - cell_center_y) / dy;
+    Real delta_z       = 1 - (pos_z - cell_center_z) / dz;
+
+    // Index of the base cell in the tile
+    indx_x += n_ghost - x0;
+    indx_y += n_ghost - y0;
+    indx_z += n_ghost - z0;
+    int const indx = indx_x + indx_y * tile_len + indx_z * tile_len * tile_len;
+    int const di   = 1;
+    int const dj   = tile_len;
+    int const dk   = tile_len * tile_len;
+    atomicAdd(&tile[indx], pMass * delta_x * delta_y * delta_z);
+    atomicAdd(&tile[indx + di], pMass * (1 - delta_x) * delta_y * delta_z);
+    atomicAdd(&tile[indx + dj], pMass * delta_x * (1 - delta_y) * delta_z);
+    atomicAdd(&tile[indx + dk], pMass * delta_x * delta_y * (1 - delta_z));
+    atomicAdd(&tile[indx + di + dj], pMass * (1 - delta_x) * (1 - delta_y) * delta_z);
+    atomicAdd(&tile[indx + di + dk], pMass * (1 - delta_x) * delta_y * (1 - delta_z));
+    atomicAdd(&tile[indx + dj + dk], pMass * delta_x * (1 - delta_y) * (1 - delta_z));
+    atomicAdd(&tile[indx + di + dj + dk], pMass * (1 - delta_x) * (1 - delta_y) * (1 - delta_z));
+  }
+  __syncthreads();
+
+  // The upper cells of the tile are shared with the neighbor tiles, so the
+  // flush still adds atomically
+  int const nx_g = nx + 2 * n_ghost;
+  int const ny_g = ny + 2 * n_ghost;
+  int const nz_g = nz + 2 * n_ghost;
+  for (int i = threadIdx.x; i < tile_cells; i += blockDim.x) {
+    int const indx_x = x0 + i % tile_len;
+    int const indx_y = y0 + (i / tile_len) % tile_len;
+    int const indx_z = z0 + i / (tile_len * tile_len);
+    if (tile[i] != 0 && indx_x < nx_g && indx_y < ny_g && indx_z < nz_g) {
+      atomicAdd(&density_dev[indx_x + indx_y * nx_g + indx_z * nx_g * ny_g], tile[i]);
+    }
+  }
+}
+    #endif  // PARTICLES_CIC_TILES
+
 // Clear the density array: density=0
 void Particles3D::Clear_Density_GPU_function(Real *density_dev, int n_cells)
 {
@@ -151,8 +294,8 @@ void Particles3D::Clear_Density_GPU_function(Real *density_dev, int n_cells)
 void Particles3D::Get_Density_CIC_GPU_function(part_int_t n_local, Real particle_mass, Real xMin, Real xMax, Real yMin,
                                                Real yMax, Real zMin, Real zMax, Real dx, Real dy, Real dz, int nx_local,
                                                int ny_local, int nz_local, int n_ghost_particles_grid, int n_cells,
-                                               Real *density_h, Real *density_dev, Real *pos_x_dev, Real *pos_y_dev,
-                                               Real *pos_z_dev, Real *mass_dev)
+                                               Real *density_h, Real *density_dev, Real_Part *pos_x_dev,
+                                               Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real *mass_dev)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -163,9 +306,29 @@ void Particles3D::Get_Density_CIC_GPU_function(part_int_t n_local, Real particle
 
   // Only runs if there are local particles
   if (n_local > 0) {
+    #ifdef PARTICLES_CIC_TILES
+    // Bin the particles by tile and deposit each tile from shared memory
+    int const n_tiles = G.n_cic_tiles_x * G.n_cic_tiles_y * G.n_cic_tiles_z;
+    Reserve_Sort_Arrays_GPU();
+    hipLaunchKernelGGL(Get_CIC_Tile_Keys_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, pos_x_dev, pos_y_dev, pos_z_dev,
+                       xMin, yMin, zMin, xMax, yMax, zMax, dx, dy, dz, n_ghost_particles_grid, G.n_cic_tiles_x,
+                       G.n_cic_tiles_y, n_tiles, sort_keys_dev[0], sort_indices_dev[0]);
+    GPU_Error_Check();
+    Sort_Keys_GPU(n_tiles + 1);
+    GPU_Error_Check(cudaMemset(G.cic_tile_start_dev, 0, n_tiles * sizeof(int)));
+    GPU_Error_Check(cudaMemset(G.cic_tile_end_dev, 0, n_tiles * sizeof(int)));
+    hipLaunchKernelGGL(Get_CIC_Tile_Ranges_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, sort_keys_dev[1], n_tiles,
+                       G.cic_tile_start_dev, G.cic_tile_end_dev);
+    GPU_Error_Check();
+    hipLaunchKernelGGL(Get_Density_CIC_Tiles_Kernel, n_tiles, TPB_CIC_TILE, 0, 0, particle_mass, density_dev,
+                       pos_x_dev, pos_y_dev, pos_z_dev, mass_dev, sort_indices_dev[1], G.cic_tile_start_dev,
+                       G.cic_tile_end_dev, xMin, yMin, zMin, dx, dy, dz, nx_local, ny_local, nz_local,
+                       n_ghost_particles_grid, G.n_cic_tiles_x, G.n_cic_tiles_y);
+    #else
     hipLaunchKernelGGL(Get_Density_CIC_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, particle_mass, density_dev,
                        pos_x_dev, pos_y_dev, pos_z_dev, mass_dev, xMin, yMin, zMin, xMax, yMax, zMax, dx, dy, dz,
                        nx_local, ny_local, nz_local, n_ghost_particles_grid);
+    #endif  // PARTICLES_CIC_TILES
     GPU_Error_Check();
     cudaDeviceSynchronize();
   }
@@ -5,15 +5,31 @@
   #include <stdlib.h>
   #include <unistd.h>
 
+  #include <algorithm>
+  #include <cfloat>
   #include <cstring>
   #include <fstream>
   #include <sstream>
   #include <vector>
 
+  #ifdef O_HIP
+    #include <hipcub/hipcub.hpp>
+namespace cub = hipcub;
+  #else
+    #include <cub/cub.cuh>
+  #endif  // O_HIP
+
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif  // MPI_CHOLLA
+  #include "../utils/DeviceVector.h"
+  #include "../utils/cuda_utilities.h"
+  #include "../utils/reduction_utilities.h"
+  #include "../utils/timestep_constraints.h"
   #include "supernova.h"
 
   #define TPB_FEEDBACK   128
@@ -24,15 +40,27 @@
   #define I_MOMENTUM     4  // unused
   #define I_UNRES_ENERGY 5  // used
 
-typedef curandStateMRG32k3a_t FeedbackPrng;
-// typedef curandStatePhilox4_32_10_t FeedbackPrng;
+typedef curandStatePhilox4_32_10_t FeedbackPrng;
 
 namespace supernova
 {
-FeedbackPrng* randStates;
-part_int_t n_states;
-Real *dev_snr, snr_dt, time_sn_start, time_sn_end;
+unsigned long long prng_seed;
+// The cumulative number of supernovae per solar mass at the snr_n ages
+// time_sn_start + i * snr_dt of the S'99 table, null for the constant rate
+Real *dev_snr_cumulative, snr_dt, time_sn_start, time_sn_end;
 int snr_n;
+
+// Indices of the clusters inside their supernova window, the only ones
+// Cluster_Feedback_Kernel is launched over. The list is rebuilt when the GPU
+// particles change or when a cluster enters or leaves the window
+int *active_ids, n_active;
+bool* active_flags;
+void* active_temp;
+size_t active_temp_bytes;
+part_int_t active_size, active_n_local;
+unsigned int active_order_version;
+bool active_valid;
+Real active_time, next_activation, next_expiry;
 }  // namespace supernova
 
   #ifndef O_HIP
@@ -49,80 +77,209 @@ __device__ double atomicMax(double* address, double val)
 }
   #endif  // O_HIP
 
-__global__ void Init_State_Kernel(unsigned int seed, FeedbackPrng* states)
+/*! \brief The number of supernovae of the cluster particle_id in step
+ * n_step, drawn from a Poisson distribution with the mean average_num_sn. The
+ * Philox generator is counter based, so the draw is a pure function of the
+ * seed, the particle id and the step: no state is stored per particle and the
+ * feedback doesn't depend on which rank holds the particle */
+__device__ int Draw_Supernova_Count(unsigned long long seed, part_int_t particle_id, int n_step, Real average_num_sn)
+{
+  // Each particle has its own subsequence and every step starts 2^32 numbers
+  // further along it
+  FeedbackPrng state;
+  curand_init(seed, particle_id, (unsigned long long)n_step << 32, &state);
+  return (int)curand_poisson(&state, average_num_sn);
+}
+
+/*! \brief Flag the clusters that are inside the supernova window at time t,
+ * and find the earliest time at which one of the younger clusters enters the
+ * window and at which one of the flagged clusters leaves it */
+__global__ void Get_Active_Clusters_Kernel(part_int_t n_local, Real* age_dev, Real t, Real time_sn_start,
+                                           Real time_sn_end, bool* active_flags, Real* next_times)
 {
-  int id = blockIdx.x * blockDim.x + threadIdx.x;
-  curand_init(seed, id, 0, &states[id]);
+  Real next_activation = DBL_MAX;
+  Real next_expiry     = DBL_MAX;
+
+  // Grid stride loop so the reductions below see every thread of the blocks
+  for (part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x; tid < n_local; tid += blockDim.x * gridDim.x) {
+    Real const cluster_age = t - age_dev[tid];
+    bool const active      = cluster_age >= time_sn_start && cluster_age < time_sn_end;
+    active_flags[tid]      = active;
+    if (cluster_age < time_sn_start) {
+      next_activation = fmin(next_activation, age_dev[tid] + time_sn_start);
+    } else if (active) {
+      next_expiry = fmin(next_expiry, age_dev[tid] + time_sn_end);
+    }
+  }
+
+  reduction_utilities::gridReduceMin(next_activation, &next_times[0]);
+  // The two reductions share the same shared memory
+  __syncthreads();
+  reduction_utilities::gridReduceMin(next_expiry, &next_times[1]);
+}
+
+/*! \brief Compact the indices of the clusters that can explode at time t into
+ * supernova::active_ids. GetCumulativeSN is flat outside of the supernova
+ * window, so the other clusters can't change anything in
+ * Cluster_Feedback_Kernel. The
+ * list is kept between calls while the particles are in the same order and no
+ * cluster entered or left the window */
+static void Update_Active_Clusters(Particles3D& Particles, Real t)
+{
+  using namespace supernova;
+
+  bool const up_to_date = active_valid && active_order_version == Particles.order_version &&
+                          active_n_local == Particles.n_local && t >= active_time && t < next_activation &&
+                          t < next_expiry;
+  if (up_to_date) {
+    return;
+  }
+
+  active_valid         = true;
+  active_order_version = Particles.order_version;
+  active_n_local       = Particles.n_local;
+  active_time          = t;
+  next_activation      = DBL_MAX;
+  next_expiry          = DBL_MAX;
+  n_active             = 0;
+  if (Particles.n_local == 0) {
+    return;
+  }
+
+  if (Particles.n_local > active_size) {
+    part_int_t const new_size = std::max(Particles.n_local, 2 * active_size);
+    cudaFree(active_ids);
+    cudaFree(active_flags);
+    GPU_Error_Check(cudaMalloc((void**)&active_ids, new_size * sizeof(int)));
+    GPU_Error_Check(cudaMalloc((void**)&active_flags, new_size * sizeof(bool)));
+    active_size = new_size;
+  }
+
+  cuda_utilities::DeviceVector<Real> static next_times(2);
+  cuda_utilities::DeviceVector<int> static n_active_dev(1);
+  cuda_utilities::AutomaticLaunchParams static const launchParams(Get_Active_Clusters_Kernel);
+
+  next_times.assign(DBL_MAX, 0);
+  next_times.assign(DBL_MAX, 1);
+  hipLaunchKernelGGL(Get_Active_Clusters_Kernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     Particles.n_local, Particles.age_dev, t, time_sn_start, time_sn_end, active_flags,
+                     next_times.data());
+  GPU_Error_Check();
+
+  cub::CountingInputIterator<int> particle_ids(0);
+  size_t temp_bytes = 0;
+  GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, temp_bytes, particle_ids, active_flags, active_ids,
+                                                n_active_dev.data(), int(Particles.n_local)));
+  if (temp_bytes > active_temp_bytes) {
+    cudaFree(active_temp);
+    GPU_Error_Check(cudaMalloc(&active_temp, temp_bytes));
+    active_temp_bytes = temp_bytes;
+  }
+  GPU_Error_Check(cub::DevicePartition::Flagged(active_temp, temp_bytes, particle_ids, active_flags, active_ids,
+                                                n_active_dev.data(), int(Particles.n_local)));
+
+  n_active        = n_active_dev[0];
+  next_activation = next_times[0];
+  next_expiry     = next_times[1];
 }
 
 /**
  * @brief Does 2 things:
  * -# Read in SN rate data from Starburst 99. If no file exists, assume a
  * constant rate.
- * -# Initialize the cuRAND state, which is analogous to the concept of
- * generators in CPU code. The state object maintains configuration and status
- * the cuRAND context for each thread on the GPU. Initialize more than the
- * number of local particles since the latter will change through MPI transfers.
+ * -# Store the seed of the counter based generator the numbers of supernovae
+ * are drawn from. The draws are keyed by the particle id and the step, so there
+ * is no per particle state to set up or to keep in step with MPI transfers.
  *
  * @param P pointer to parameters struct. Passes in starburst 99 filename and
  * random number gen seed.
- * @param n_local  number of local particles on the GPU
- * @param allocation_factor
  */
-void supernova::initState(struct Parameters* P, part_int_t n_local, Real allocation_factor)
+void supernova::initState(struct Parameters* P)
 {
   chprintf("supernova::initState start\n");
   std::string snr_filename(P->snr_filename);
   if (not snr_filename.empty()) {
     chprintf("Specified a SNR filename %s.\n", snr_filename.data());
 
-    // read in array of supernova rate values.
-    std::ifstream snr_in(snr_filename);
-    if (!snr_in.is_open()) {
-      chprintf("ERROR: but couldn't read SNR file.\n");
-      exit(-1);
-    }
-
+    // read in array of supernova rate values. With MPI only rank 0 parses
+    // the S'99 file, the other ranks get the values in binary
     std::vector<Real> snr_time;
     std::vector<Real> snr;
+  #ifdef MPI_CHOLLA
+    if (procID == 0) {
+  #endif  // MPI_CHOLLA
+      std::ifstream snr_in(snr_filename);
+      if (!snr_in.is_open()) {
+        chprintf("ERROR: but couldn't read SNR file.\n");
+        exit(-1);
+      }
 
-    const int N_HEADER    = 7;    // S'99 has 7 rows of header information
-    const char* s99_delim = " ";  // S'99 data separator
-    std::string line;
-    int line_counter = 0;
-
-    while (snr_in.good()) {
-      std::getline(snr_in, line);
-      if (line_counter++ < N_HEADER) {
-        continue;
-      }  // skip header processing
-
-      int i      = 0;
-      char* data = strtok(line.data(), s99_delim);
-      while (data != nullptr) {
-        if (i == 0) {
-          // in the following divide by # years per kyr (1000)
-          snr_time.push_back(std::stof(std::string(data)) / 1000);
-        } else if (i == 1) {
-          snr.push_back(pow(10, std::stof(std::string(data))) / 1000);
-        }
-        if (i > 0) {
-          break;  // only care about the first 2 items.  Once i = 1 can break
-        }         // here.
+      const int N_HEADER    = 7;    // S'99 has 7 rows of header information
+      const char* s99_delim = " ";  // S'99 data separator
+      std::string line;
+      int line_counter = 0;
+
+      while (snr_in.good()) {
+        std::getline(snr_in, line);
+        if (line_counter++ < N_HEADER) {
+          continue;
+        }  // skip header processing
+
+        int i      = 0;
+        char* data = strtok(line.data(), s99_delim);
+        while (data != nullptr) {
+          if (i == 0) {
+            // in the following divide by # years per kyr (1000)
+            snr_time.push_back(std::stof(std::string(data)) / 1000);
+          } else if (i == 1) {
+            snr.push_back(pow(10, std::stof(std::string(data))) / 1000);
+          }
+          if (i > 0) {
+            break;  // only care about the first 2 items.  Once i = 1 can break
+          }         // here.
 
-        data = strtok(nullptr, s99_delim);
-        i++;
+          data = strtok(nullptr, s99_delim);
+          i++;
+        }
       }
+  #ifdef MPI_CHOLLA
     }
+    Broadcast_Vector(snr_time);
+    Broadcast_Vector(snr);
+  #endif  // MPI_CHOLLA
 
-    time_sn_end   = snr_time[snr_time.size() - 1];
-    time_sn_start = snr_time[0];
     // the following is the time interval between data points
     // (i.e. assumes regular temporal spacing)
-    snr_dt = (time_sn_end - time_sn_start) / (snr.size() - 1);
+    snr_dt = (snr_time[snr_time.size() - 1] - snr_time[0]) / (snr.size() - 1);
+
+    // S'99 writes a log rate of -30 for the ages without supernovae. Trim those
+    // at both ends, keeping one zero rate row on each side, so the clusters
+    // outside the remaining window aren't active
+    auto const has_sn = [](Real rate) { return rate > 1e-29; };
+    int first = 0, last = snr.size() - 1;
+    while (first + 1 < last && !has_sn(snr[first]) && !has_sn(snr[first + 1])) {
+      first++;
+    }
+    while (last - 1 > first && !has_sn(snr[last]) && !has_sn(snr[last - 1])) {
+      last--;
+    }
+    time_sn_start = snr_time[first];
+    time_sn_end   = snr_time[last];
+    snr_n         = last - first + 1;
+
+    // Integrate the piecewise linear rate, so the expected number of
+    // supernovae over a step is one difference of the interpolated cumulative
+    // count
+    std::vector<Real> snr_cumulative(snr_n, 0);
+    for (int i = 1; i < snr_n; i++) {
+      Real const rate_left  = has_sn(snr[first + i - 1]) ? snr[first + i - 1] : 0;
+      Real const rate_right = has_sn(snr[first + i]) ? snr[first + i] : 0;
+      snr_cumulative[i]     = snr_cumulative[i - 1] + 0.5 * (rate_left + rate_right) * snr_dt;
+    }
 
-    GPU_Error_Check(cudaMalloc((void**)&dev_snr, snr.size() * sizeof(Real)));
-    GPU_Error_Check(cudaMemcpy(dev_snr, snr.data(), snr.size() * sizeof(Real), cudaMemcpyHostToDevice));
+    GPU_Error_Check(cudaMalloc((void**)&dev_snr_cumulative, snr_n * sizeof(Real)));
+    GPU_Error_Check(
+        cudaMemcpy(dev_snr_cumulative, snr_cumulative.data(), snr_n * sizeof(Real), cudaMemcpyHostToDevice));
 
   } else {
     chprintf("No SN rate file specified.  Using constant rate\n");
@@ -130,30 +287,39 @@ void supernova::initState(struct Parameters* P, part_int_t n_local, Real allocat
     time_sn_end   = DEFAULT_SN_END;
   }
 
-  // Now initialize the poisson random number generator state.
-  n_states = n_local * allocation_factor;
-  GPU_Error_Check(cudaMalloc((void**)&randStates, n_states * sizeof(FeedbackPrng)));
-
-  int ngrid = (n_states - 1) / TPB_FEEDBACK + 1;
-  dim3 grid(ngrid);
-  dim3 block(TPB_FEEDBACK);
-
-  hipLaunchKernelGGL(Init_State_Kernel, grid, block, 0, 0, P->prng_seed, randStates);
-  GPU_Error_Check(cudaDeviceSynchronize());
-  chprintf("supernova::initState end: n_states=%ld, ngrid=%d, threads=%d\n", n_states, ngrid, TPB_FEEDBACK);
+  // The number of supernovae is drawn from a counter based generator keyed by
+  // this seed, the particle id and the step
+  prng_seed = P->prng_seed;
+  chprintf("supernova::initState end: prng_seed=%llu, threads=%d\n", prng_seed, TPB_FEEDBACK);
 }
 
-__device__ Real GetSNRate(Real t, Real* dev_snr, Real snr_dt, Real t_start, Real t_end)
+/*! \brief The cumulative number of supernovae per solar mass of a cluster of
+ * age t, linearly interpolated in the table of snr_n values. The constant rate
+ * is used when the table is null */
+__device__ Real GetCumulativeSN(Real t, Real const* __restrict__ dev_snr_cumulative, int snr_n, Real snr_dt,
+                                Real t_start, Real t_end)
 {
-  if (t < t_start || t >= t_end) {
+  if (t <= t_start) {
     return 0;
   }
-  if (dev_snr == nullptr) {
-    return supernova::DEFAULT_SNR;
+  t = fmin(t, t_end);
+  if (dev_snr_cumulative == nullptr) {
+    return supernova::DEFAULT_SNR * (t - t_start);
   }
 
-  int index = (int)((t - t_start) / snr_dt);
-  return dev_snr[index] + (t - index * snr_dt) * (dev_snr[index + 1] - dev_snr[index]) / snr_dt;
+  Real const position = (t - t_start) / snr_dt;
+  int const index     = min((int)position, snr_n - 2);
+  Real const lower    = dev_snr_cumulative[index];
+  return lower + (position - index) * (dev_snr_cumulative[index + 1] - lower);
+}
+
+/*! \brief The expected number of supernovae of a cluster of the given mass
+ * between the ages t and t + dt */
+__device__ Real GetAverageNumSN(Real t, Real dt, Real mass, Real const* __restrict__ dev_snr_cumulative, int snr_n,
+                                Real snr_dt, Real t_start, Real t_end)
+{
+  return mass * (GetCumulativeSN(t + dt, dev_snr_cumulative, snr_n, snr_dt, t_start, t_end) -
+                 GetCumulativeSN(t, dev_snr_cumulative, snr_n, snr_dt, t_start, t_end));
 }
 
 __device__ Real Calc_Timestep(Real gamma, Real* density, Real* momentum_x, Real* momentum_y, Real* momentum_z,
@@ -203,8 +369,8 @@ __device__ Real GetAverageNumberDensity_CGS(Real* density, int xi, int yi, int z
   return GetAverageDensity(density, xi, yi, zi, nx_grid, ny_grid, n_ghost) * DENSITY_UNIT / (supernova::MU * MP);
 }
 
-__device__ bool Particle_Is_Alone(Real* pos_x_dev, Real* pos_y_dev, Real* pos_z_dev, part_int_t n_local, int gtid,
-                                  Real dx)
+__device__ bool Particle_Is_Alone(Real_Part* pos_x_dev, Real_Part* pos_y_dev, Real_Part* pos_z_dev, part_int_t n_local,
+                                  int gtid, Real dx)
 {
   Real x0 = pos_x_dev[gtid];
   Real y0 = pos_y_dev[gtid];
@@ -229,19 +395,23 @@ __device__ bool Particle_Is_Alone(Real* pos_x_dev, Real* pos_y_dev, Real* pos_z_
   return true;
 }
 
-__global__ void Cluster_Feedback_Kernel(part_int_t n_local, part_int_t* id, Real* pos_x_dev, Real* pos_y_dev,
-                                        Real* pos_z_dev, Real* mass_dev, Real* age_dev, Real xMin, Real yMin, Real zMin,
-                                        Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz, int nx_g, int ny_g,
-                                        int nz_g, int n_ghost, Real t, Real dt, Real* dti, Real* info, Real* density,
-                                        Real* gasEnergy, Real* energy, Real* momentum_x, Real* momentum_y,
-                                        Real* momentum_z, Real gamma, FeedbackPrng* states, Real* prev_dens,
-                                        int* prev_N, short direction, Real* dev_snr, Real snr_dt, Real time_sn_start,
+__global__ void Cluster_Feedback_Kernel(int n_active, int* active_ids, part_int_t* id, Real_Part* pos_x_dev,
+                                        Real_Part* pos_y_dev, Real_Part* pos_z_dev, Real* mass_dev, Real* age_dev,
+                                        Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax, Real dx,
+                                        Real dy, Real dz, int nx_g, int ny_g, int nz_g, int n_ghost, Real t, Real dt,
+                                        Real* dti, Real* info, Real* density, Real* gasEnergy, Real* energy,
+                                        Real* momentum_x, Real* momentum_y, Real* momentum_z, Real gamma,
+                                        unsigned long long seed, Real* prev_dens, int* prev_N, short direction,
+                                        Real const* dev_snr_cumulative, int snr_n, Real snr_dt, Real time_sn_start,
                                         Real time_sn_end, int n_step, Real density_floor)
 {
   __shared__ Real s_info[FEED_INFO_N * TPB_FEEDBACK];  // for collecting SN feedback information, like #
                                                        // of SNe or # resolved.
-  int tid  = threadIdx.x;
-  int gtid = blockIdx.x * blockDim.x + tid;
+  int tid = threadIdx.x;
+  // The threads go over the active clusters, the prev_* arrays are indexed by
+  // the position in the list
+  int aid  = blockIdx.x * blockDim.x + tid;
+  int gtid = aid < n_active ? active_ids[aid] : 0;
 
   s_info[FEED_INFO_N * tid]     = 0;  // number of supernovae
   s_info[FEED_INFO_N * tid + 1] = 0;  // number of resolved events
@@ -250,7 +420,7 @@ __global__ void Cluster_Feedback_Kernel(part_int_t n_local, part_int_t* id, Real
   s_info[FEED_INFO_N * tid + 4] = 0;  // unresolved momentum
   s_info[FEED_INFO_N * tid + 5] = 0;  // unresolved KE added via momentum injection
 
-  if (gtid < n_local) {
+  if (aid < n_active) {
     Real pos_x, pos_y, pos_z;
     Real cell_center_x, cell_center_y, cell_center_z;
     Real delta_x, delta_y, delta_z;
@@ -302,35 +472,26 @@ __global__ void Cluster_Feedback_Kernel(part_int_t n_local, part_int_t* id, Real
       // only calculate this if there will be SN feedback
       if ((t - age_dev[gtid]) <= time_sn_end) {
         if (direction == -1) {
-          N = -prev_N[gtid];
+          N = -prev_N[aid];
         } else {
-          Real average_num_sn =
-              GetSNRate(t - age_dev[gtid], dev_snr, snr_dt, time_sn_start, time_sn_end) * mass_dev[gtid] * dt;
+          Real average_num_sn = GetAverageNumSN(t - age_dev[gtid], dt, mass_dev[gtid], dev_snr_cumulative, snr_n,
+                                                snr_dt, time_sn_start, time_sn_end);
 
           // N = (int) (average_num_sn + 0.5);
 
-          FeedbackPrng state;  // = states[0]; // load initial state
-
-          curand_init(42, 0, 0, &state);
-          unsigned long long skip = n_step * 10000 + id[gtid];
-          skipahead(skip, &state);  // provided by curand
-          // unsigned int debug_state = curand(&state);
-
-          N = (int)curand_poisson(&state, average_num_sn);
-
-          // states[gtid] = state; // don't write back to state, keep it
-          // pristine
-          prev_N[gtid] = N;
+          // Skip the draw where the cumulative count is flat
+          N = average_num_sn > 0 ? Draw_Supernova_Count(seed, id[gtid], n_step, average_num_sn) : 0;
+          prev_N[aid] = N;
         }
         if (N != 0) {
           mass_dev[gtid] -= N * supernova::MASS_PER_SN;
           feedback_energy  = N * supernova::ENERGY_PER_SN / dV;
           feedback_density = N * supernova::MASS_PER_SN / dV;
           if (direction == -1) {
-            n_0 = prev_dens[gtid];
+            n_0 = prev_dens[aid];
           } else {
             n_0             = GetAverageNumberDensity_CGS(density, indx_x, indx_y, indx_z, nx_g, ny_g, n_ghost);
-            prev_dens[gtid] = n_0;
+            prev_dens[aid] = n_0;
           }
           // int devcount;
           // cudaGetDeviceCount(&devcount);
@@ -634,16 +795,398 @@ __global__ void Cluster_Feedback_Kernel(part_int_t n_local, part_int_t* id, Real
     __syncthreads();
   }
 
+  // info was zeroed before the launch, and collects the sums of all the blocks
   if (tid == 0) {
-    info[FEED_INFO_N * blockIdx.x]     = s_info[0];
-    info[FEED_INFO_N * blockIdx.x + 1] = s_info[1];
-    info[FEED_INFO_N * blockIdx.x + 2] = s_info[2];
-    info[FEED_INFO_N * blockIdx.x + 3] = s_info[3];
-    info[FEED_INFO_N * blockIdx.x + 4] = s_info[4];
-    info[FEED_INFO_N * blockIdx.x + 5] = s_info[5];
+    for (int i = 0; i < FEED_INFO_N; i++) {
+      atomicAdd(&info[i], s_info[i]);
+    }
+  }
+}
+
+  #ifdef SUPERNOVA_DETERMINISTIC
+    // Number of cells a cluster can deposit into, the 3x3x3 stencil of the
+    // unresolved remnants. The resolved ones only use 2x2x2 of the slots
+    #define FEED_STENCIL 27
+
+/*! \struct FeedbackDeposit
+ *  \brief What a cluster adds to one cell. Only the unresolved remnants set
+ *  density_set, which replaces the density of the cell */
+struct FeedbackDeposit {
+  Real density;
+  Real density_set;
+  Real gas_energy;
+  Real momentum_x;
+  Real momentum_y;
+  Real momentum_z;
+};
+
+/*! \brief Compute the supernovae of each active cluster and write what it
+ * deposits in each cell of its stencil to FEED_STENCIL slots of deposits,
+ * without touching the grid. The slots that aren't used get the key n_cells so
+ * they are sorted after all the cells. The density is only read, so n_0 doesn't
+ * depend on the order of the clusters. The info of each cluster is written to
+ * FEED_INFO_N values of info and the mass before the supernovae to prev_mass */
+__global__ void Cluster_Feedback_Deposit_Kernel(int n_active, int* active_ids, part_int_t* id, Real_Part* pos_x_dev,
+                                                Real_Part* pos_y_dev, Real_Part* pos_z_dev, Real* mass_dev,
+                                                Real* age_dev, Real xMin, Real yMin, Real zMin, Real xMax, Real yMax,
+                                                Real zMax, Real dx, Real dy, Real dz, int nx_g, int ny_g, int nz_g,
+                                                int n_ghost, Real t, Real dt, Real* density,
+                                                Real const* dev_snr_cumulative, int snr_n, Real snr_dt,
+                                                Real time_sn_start, Real time_sn_end, int n_step,
+                                                unsigned long long seed, int* keys, int* entry_ids,
+                                                FeedbackDeposit* deposits, Real* info, Real* prev_mass)
+{
+  int aid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (aid >= n_active) {
+    return;
+  }
+  int const gtid    = active_ids[aid];
+  int const n_cells = nx_g * ny_g * nz_g;
+  int const first   = FEED_STENCIL * aid;
+
+  for (int s = 0; s < FEED_STENCIL; s++) {
+    keys[first + s]      = n_cells;
+    entry_ids[first + s] = first + s;
+  }
+  for (int i = 0; i < FEED_INFO_N; i++) {
+    info[FEED_INFO_N * aid + i] = 0;
+  }
+  prev_mass[aid] = mass_dev[gtid];
+
+  Real const pos_x = pos_x_dev[gtid];
+  Real const pos_y = pos_y_dev[gtid];
+  Real const pos_z = pos_z_dev[gtid];
+  bool const in_local =
+      (pos_x >= xMin && pos_x < xMax) && (pos_y >= yMin && pos_y < yMax) && (pos_z >= zMin && pos_z < zMax);
+  int indx_x = (int)floor((pos_x - xMin) / dx);
+  int indx_y = (int)floor((pos_y - yMin) / dy);
+  int indx_z = (int)floor((pos_z - zMin) / dz);
+  bool const ignore = indx_x < 0 || indx_y < 0 || indx_z < 0 || indx_x >= nx_g - 2 * n_ghost ||
+                      indx_y >= ny_g - 2 * n_ghost || indx_z >= nz_g - 2 * n_ghost;
+  if (!in_local || ignore) {
+    kernel_printf(" Feedback GPU: Particle outside local domain [%f  %f  %f]  [%d %d %d]\n ", pos_x, pos_y, pos_z,
+                  indx_x, indx_y, indx_z);
+    return;
+  }
+
+  // Same random numbers as Cluster_Feedback_Kernel
+  Real const average_num_sn = GetAverageNumSN(t - age_dev[gtid], dt, mass_dev[gtid], dev_snr_cumulative, snr_n,
+                                              snr_dt, time_sn_start, time_sn_end);
+  int const N = average_num_sn > 0 ? Draw_Supernova_Count(seed, id[gtid], n_step, average_num_sn) : 0;
+  if (N == 0) {
+    return;
+  }
+
+  Real const dV               = dx * dy * dz;
+  Real const feedback_energy  = N * supernova::ENERGY_PER_SN / dV;
+  Real const feedback_density = N * supernova::MASS_PER_SN / dV;
+  Real const n_0              = GetAverageNumberDensity_CGS(density, indx_x, indx_y, indx_z, nx_g, ny_g, n_ghost);
+  Real feedback_momentum      = supernova::FINAL_MOMENTUM * pow(n_0, -0.17) * pow(fabsf(N), 0.93) / dV;
+  Real const shell_radius     = supernova::R_SH * pow(n_0, -0.46) * pow(fabsf(N), 0.29);
+  bool const is_resolved      = 3 * max(dx, max(dy, dz)) <= shell_radius;
+  mass_dev[gtid] -= N * supernova::MASS_PER_SN;
+
+  info[FEED_INFO_N * aid] = 1. * N;
+  if (is_resolved) {
+    info[FEED_INFO_N * aid + 1] = 1;
+  } else {
+    info[FEED_INFO_N * aid + 2] = 1;
+  }
+
+  int s = first;
+  if (is_resolved) {
+    // Inject energy and density with CIC weights
+    info[FEED_INFO_N * aid + 3] = feedback_energy * dV;
+
+    indx_x = (int)floor((pos_x - xMin - 0.5 * dx) / dx);
+    indx_y = (int)floor((pos_y - yMin - 0.5 * dy) / dy);
+    indx_z = (int)floor((pos_z - zMin - 0.5 * dz) / dz);
+
+    Real const delta_x = 1 - (pos_x - (xMin + indx_x * dx + 0.5 * dx)) / dx;
+    Real const delta_y = 1 - (pos_y - (yMin + indx_y * dy + 0.5 * dy)) / dy;
+    Real const delta_z = 1 - (pos_z - (zMin + indx_z * dz + 0.5 * dz)) / dz;
+    indx_x += n_ghost;
+    indx_y += n_ghost;
+    indx_z += n_ghost;
+
+    for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < 2; j++) {
+        for (int k = 0; k < 2; k++) {
+          Real const x_frac = i * (1 - delta_x) + (1 - i) * delta_x;
+          Real const y_frac = j * (1 - delta_y) + (1 - j) * delta_y;
+          Real const z_frac = k * (1 - delta_z) + (1 - k) * delta_z;
+          Real const weight = x_frac * y_frac * z_frac;
+          keys[s]           = (indx_x + i) + (indx_y + j) * nx_g + (indx_z + k) * nx_g * ny_g;
+          deposits[s]       = {weight * feedback_density, 0, weight * feedback_energy, 0, 0, 0};
+          s++;
+        }
+      }
+    }
+  } else {
+    // Inject momentum and set the density
+    info[FEED_INFO_N * aid + 4] = feedback_momentum * dV;
+
+    Real const delta_x = (pos_x - xMin - indx_x * dx) / dx;
+    Real const delta_y = (pos_y - yMin - indx_y * dy) / dy;
+    Real const delta_z = (pos_z - zMin - indx_z * dz) / dz;
+    indx_x += n_ghost;
+    indx_y += n_ghost;
+    indx_z += n_ghost;
+    feedback_momentum /= sqrt(3.0);
+
+    for (int i = -1; i < 2; i++) {
+      for (int j = -1; j < 2; j++) {
+        for (int k = -1; k < 2; k++) {
+          Real const x_frac = D_Fr(i, delta_x) * Frac(j, delta_y) * Frac(k, delta_z);
+          Real const y_frac = Frac(i, delta_x) * D_Fr(j, delta_y) * Frac(k, delta_z);
+          Real const z_frac = Frac(i, delta_x) * Frac(j, delta_y) * D_Fr(k, delta_z);
+
+          Real const px = x_frac * feedback_momentum;
+          Real const py = y_frac * feedback_momentum;
+          Real const pz = z_frac * feedback_momentum;
+          Real const d  = (abs(x_frac) + abs(y_frac) + abs(z_frac)) / 6 * feedback_density +
+                         n_0 * supernova::MU * MP / DENSITY_UNIT;
+
+          keys[s]     = (indx_x + i) + (indx_y + j) * nx_g + (indx_z + k) * nx_g * ny_g;
+          deposits[s] = {0, d, 0, px, py, pz};
+          info[FEED_INFO_N * aid + I_UNRES_ENERGY] += (px * px + py * py + pz * pz) / 2 / d * dV;
+          s++;
+        }
+      }
+    }
   }
 }
 
+/*! \brief Flag the first deposit of each cell in the sorted keys */
+__global__ void Get_Deposit_Heads_Kernel(int n_entries, int* keys, bool* heads)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_entries) {
+    return;
+  }
+  heads[tid] = tid == 0 || keys[tid] != keys[tid - 1];
+}
+
+/*! \brief Add the deposits of each cell to the grid, one thread per cell. The
+ * deposits of a cell are summed in the order of the stable sort, so the result
+ * doesn't depend on the scheduling of the threads. The overlapping unresolved
+ * remnants set the largest of their densities. The previous values of the
+ * cells are saved in backup so that the step can be undone exactly. Also finds
+ * the largest inverse timestep of the updated cells */
+__global__ void Apply_Feedback_Deposits_Kernel(int n_entries, int n_runs, int* run_starts, int* keys, int* entry_ids,
+                                               FeedbackDeposit* deposits, int n_cells, Real* density,
+                                               Real* gasEnergy, Real* energy, Real* momentum_x, Real* momentum_y,
+                                               Real* momentum_z, Real* backup, Real gamma, Real dx, Real dy, Real dz,
+                                               Real density_floor, Real* dti)
+{
+  Real local_dti = 0;
+
+  // Grid stride loop so the reduction below sees every thread of the blocks
+  for (int r = blockIdx.x * blockDim.x + threadIdx.x; r < n_runs; r += blockDim.x * gridDim.x) {
+    int const start = run_starts[r];
+    int const end   = r + 1 < n_runs ? run_starts[r + 1] : n_entries;
+    int const indx  = keys[start];
+    if (indx == n_cells) {
+      continue;
+    }
+
+    FeedbackDeposit sum = {0, 0, 0, 0, 0, 0};
+    for (int e = start; e < end; e++) {
+      FeedbackDeposit const dep = deposits[entry_ids[e]];
+      sum.density += dep.density;
+      sum.density_set = fmax(sum.density_set, dep.density_set);
+      sum.gas_energy += dep.gas_energy;
+      sum.momentum_x += dep.momentum_x;
+      sum.momentum_y += dep.momentum_y;
+      sum.momentum_z += dep.momentum_z;
+    }
+
+    backup[6 * r]     = density[indx];
+    backup[6 * r + 1] = gasEnergy[indx];
+    backup[6 * r + 2] = energy[indx];
+    backup[6 * r + 3] = momentum_x[indx];
+    backup[6 * r + 4] = momentum_y[indx];
+    backup[6 * r + 5] = momentum_z[indx];
+
+    gasEnergy[indx] += sum.gas_energy;
+    if (sum.density_set > 0) {
+      Real const mx    = momentum_x[indx] + sum.momentum_x;
+      Real const my    = momentum_y[indx] + sum.momentum_y;
+      Real const mz    = momentum_z[indx] + sum.momentum_z;
+      Real const d     = sum.density_set + sum.density;
+      density[indx]    = d;
+      momentum_x[indx] = mx;
+      momentum_y[indx] = my;
+      momentum_z[indx] = mz;
+      energy[indx]     = (mx * mx + my * my + mz * mz) / 2 / d + gasEnergy[indx];
+    } else {
+      density[indx] += sum.density;
+      energy[indx] += sum.gas_energy;
+    }
+
+    local_dti = fmax(local_dti, Calc_Timestep(gamma, density, momentum_x, momentum_y, momentum_z, energy, indx, dx,
+                                              dy, dz, density_floor));
+  }
+
+  reduction_utilities::gridReduceMax(local_dti, dti);
+}
+
+/*! \brief Restore the cells changed by Apply_Feedback_Deposits_Kernel and the
+ * masses of the clusters */
+__global__ void Undo_Feedback_Deposits_Kernel(int n_runs, int* run_starts, int* keys, int n_cells, Real* backup,
+                                              Real* density, Real* gasEnergy, Real* energy, Real* momentum_x,
+                                              Real* momentum_y, Real* momentum_z, int n_active, int* active_ids,
+                                              Real* prev_mass, Real* mass_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid < n_active) {
+    mass_dev[active_ids[tid]] = prev_mass[tid];
+  }
+  if (tid >= n_runs) {
+    return;
+  }
+  int const indx = keys[run_starts[tid]];
+  if (indx == n_cells) {
+    return;
+  }
+  density[indx]    = backup[6 * tid];
+  gasEnergy[indx]  = backup[6 * tid + 1];
+  energy[indx]     = backup[6 * tid + 2];
+  momentum_x[indx] = backup[6 * tid + 3];
+  momentum_y[indx] = backup[6 * tid + 4];
+  momentum_z[indx] = backup[6 * tid + 5];
+}
+
+/*! \brief Make sure vec holds at least size elements, growing geometrically */
+template <typename T>
+static void Reserve_Feedback_Array(cuda_utilities::DeviceVector<T>& vec, size_t size)
+{
+  if (vec.size() < size) {
+    vec.reset(std::max(size, 2 * vec.size()));
+  }
+}
+
+/*! \brief Deposit the feedback of the active clusters in one pass that gives
+ * the same result in every run. The deposits are staged per cluster, sorted by
+ * cell with a stable radix sort and summed per cell in that order, so no
+ * atomics touch the grid. When the updated cells need a smaller timestep, the
+ * saved cells and masses are restored exactly and the feedback is redone with
+ * the new timestep, which changes the number of supernovae. Returns the
+ * largest inverse timestep of the updated cells over all the ranks and adds
+ * the info of the clusters to h_info */
+static Real Deposit_Feedback_Deterministic(Grid3D& G, Real xMin, Real yMin, Real zMin, Real xMax, Real yMax,
+                                           Real zMax, Real* h_info)
+{
+  using namespace supernova;
+
+  cuda_utilities::DeviceVector<int> static keys_in(1), keys_out(1);
+  cuda_utilities::DeviceVector<int> static ids_in(1), ids_out(1);
+  cuda_utilities::DeviceVector<FeedbackDeposit> static deposits(1);
+  cuda_utilities::DeviceVector<bool> static heads(1);
+  cuda_utilities::DeviceVector<int> static run_starts(1);
+  cuda_utilities::DeviceVector<int> static n_runs_dev(1);
+  cuda_utilities::DeviceVector<Real> static backup(1);
+  cuda_utilities::DeviceVector<Real> static cluster_info(1);
+  cuda_utilities::DeviceVector<Real> static prev_mass(1);
+  cuda_utilities::DeviceVector<char> static temp(1);
+  cuda_utilities::AutomaticLaunchParams static const applyParams(Apply_Feedback_Deposits_Kernel);
+
+  int const n_cells   = G.H.nx * G.H.ny * G.H.nz;
+  int const n_entries = FEED_STENCIL * n_active;
+  Real h_dti          = 0;
+  std::vector<Real> host_info;
+  if (n_active > 0) {
+    Reserve_Feedback_Array(keys_in, n_entries);
+    Reserve_Feedback_Array(keys_out, n_entries);
+    Reserve_Feedback_Array(ids_in, n_entries);
+    Reserve_Feedback_Array(ids_out, n_entries);
+    Reserve_Feedback_Array(deposits, n_entries);
+    Reserve_Feedback_Array(heads, n_entries);
+    Reserve_Feedback_Array(run_starts, n_entries);
+    Reserve_Feedback_Array(backup, 6 * (size_t)n_entries);
+    Reserve_Feedback_Array(cluster_info, FEED_INFO_N * (size_t)n_active);
+    Reserve_Feedback_Array(prev_mass, n_active);
+    host_info.resize(FEED_INFO_N * n_active);
+  }
+
+  // Only sort the bits that a key can have, the unused slots have the key
+  // n_cells
+  int end_bit = 1;
+  while (end_bit < 31 && (1 << end_bit) <= n_cells) {
+    end_bit++;
+  }
+
+  bool undo;
+  do {
+    int n_runs = 0;
+    if (n_active > 0) {
+      int ngrid = (n_active - 1) / TPB_FEEDBACK + 1;
+      hipLaunchKernelGGL(Cluster_Feedback_Deposit_Kernel, ngrid, TPB_FEEDBACK, 0, 0, n_active, active_ids,
+                         G.Particles.partIDs_dev, G.Particles.pos_x_dev, G.Particles.pos_y_dev, G.Particles.pos_z_dev,
+                         G.Particles.mass_dev, G.Particles.age_dev, xMin, yMin, zMin, xMax, yMax, zMax, G.H.dx, G.H.dy,
+                         G.H.dz, G.H.nx, G.H.ny, G.H.nz, G.H.n_ghost, G.H.t, G.H.dt, G.C.d_density, dev_snr_cumulative,
+                         snr_n, snr_dt, time_sn_start, time_sn_end, G.H.n_step, supernova::prng_seed, keys_in.data(),
+                         ids_in.data(), deposits.data(), cluster_info.data(), prev_mass.data());
+      GPU_Error_Check();
+
+      // The radix sort is stable, so the deposits of a cell stay in the order
+      // of the clusters
+      size_t sort_bytes = 0, partition_bytes = 0;
+      cub::CountingInputIterator<int> entry_index(0);
+      GPU_Error_Check(cub::DeviceRadixSort::SortPairs(nullptr, sort_bytes, keys_in.data(), keys_out.data(),
+                                                      ids_in.data(), ids_out.data(), n_entries, 0,
+                                                      end_bit));
+      GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, partition_bytes, entry_index, heads.data(),
+                                                    run_starts.data(), n_runs_dev.data(), n_entries));
+      Reserve_Feedback_Array(temp, std::max(sort_bytes, partition_bytes));
+      GPU_Error_Check(cub::DeviceRadixSort::SortPairs(temp.data(), sort_bytes, keys_in.data(), keys_out.data(),
+                                                      ids_in.data(), ids_out.data(), n_entries, 0,
+                                                      end_bit));
+
+      ngrid = (n_entries - 1) / TPB_FEEDBACK + 1;
+      hipLaunchKernelGGL(Get_Deposit_Heads_Kernel, ngrid, TPB_FEEDBACK, 0, 0, n_entries, keys_out.data(),
+                         heads.data());
+      GPU_Error_Check(cub::DevicePartition::Flagged(temp.data(), partition_bytes, entry_index, heads.data(),
+                                                    run_starts.data(), n_runs_dev.data(), n_entries));
+      n_runs = n_runs_dev[0];
+
+      hipLaunchKernelGGL(Apply_Feedback_Deposits_Kernel, applyParams.numBlocks, applyParams.threadsPerBlock, 0, 0,
+                         n_entries, n_runs, run_starts.data(), keys_out.data(), ids_out.data(), deposits.data(),
+                         n_cells, G.C.d_density, G.C.d_GasEnergy, G.C.d_Energy, G.C.d_momentum_x, G.C.d_momentum_y,
+                         G.C.d_momentum_z, backup.data(), gama, G.H.dx, G.H.dy, G.H.dz, G.H.density_floor,
+                         timestep_constraints::Device_Slot(timestep_constraints::feedback));
+      GPU_Error_Check();
+    }
+    h_dti = timestep_constraints::Reduce(timestep_constraints::feedback);
+
+    undo = h_dti != 0 && (C_cfl / h_dti < G.H.dt);
+    if (undo) {
+      if (n_active > 0) {
+        int ngrid = (std::max(n_runs, n_active) - 1) / TPB_FEEDBACK + 1;
+        hipLaunchKernelGGL(Undo_Feedback_Deposits_Kernel, ngrid, TPB_FEEDBACK, 0, 0, n_runs, run_starts.data(),
+                           keys_out.data(), n_cells, backup.data(), G.C.d_density, G.C.d_GasEnergy, G.C.d_Energy,
+                           G.C.d_momentum_x, G.C.d_momentum_y, G.C.d_momentum_z, n_active, active_ids,
+                           prev_mass.data(), G.Particles.mass_dev);
+        GPU_Error_Check();
+      }
+      G.H.dt = C_cfl / h_dti;
+    }
+  } while (undo);
+
+  // Sum the info of the clusters on the host in a fixed order
+  if (n_active > 0) {
+    GPU_Error_Check(cudaMemcpy(host_info.data(), cluster_info.data(), host_info.size() * sizeof(Real),
+                               cudaMemcpyDeviceToHost));
+    for (int aid = 0; aid < n_active; aid++) {
+      for (int i = 0; i < FEED_INFO_N; i++) {
+        h_info[i] += host_info[FEED_INFO_N * aid + i];
+      }
+    }
+  }
+  return h_dti;
+}
+  #endif  // SUPERNOVA_DETERMINISTIC
+
 Real supernova::Cluster_Feedback(Grid3D& G, FeedbackAnalysis& analysis)
 {
   #ifdef CPU_TIME
@@ -654,72 +1197,70 @@ Real supernova::Cluster_Feedback(Grid3D& G, FeedbackAnalysis& analysis)
     return 0.0;
   }
 
-  /*
-  if (G.Particles.n_local > supernova::n_states) {
-    printf("ERROR: not enough cuRAND states (%ld) for %ld local particles\n",
-           supernova::n_states, G.Particles.n_local);
-    exit(-1);
-  }
-  */
+  Update_Active_Clusters(G.Particles, G.H.t);
 
   Real h_dti = 0.0;
-  int direction, ngrid;
   Real h_info[6] = {0, 0, 0, 0, 0, 0};
   Real info[6];
-  Real *d_dti, *d_info;
+  // Bounds of the local domain in the coordinates of the stored particle
+  // positions
+  Real const xMin = G.H.xblocal - G.Particles.G.pos_origin_x;
+  Real const yMin = G.H.yblocal - G.Particles.G.pos_origin_y;
+  Real const zMin = G.H.zblocal - G.Particles.G.pos_origin_z;
+  Real const xMax = G.H.xblocal_max - G.Particles.G.pos_origin_x;
+  Real const yMax = G.H.yblocal_max - G.Particles.G.pos_origin_y;
+  Real const zMax = G.H.zblocal_max - G.Particles.G.pos_origin_z;
+
+  #ifdef SUPERNOVA_DETERMINISTIC
+  h_dti = Deposit_Feedback_Deterministic(G, xMin, yMin, zMin, xMax, yMax, zMax, h_info);
+  #else
+  int direction, ngrid;
+  Real* d_info;
+  // The feedback kernel reduces its inverse timestep into its slot of the
+  // registry
+  Real* d_dti = timestep_constraints::Device_Slot(timestep_constraints::feedback);
   // require d_prev_dens & d_prev_N in case we have to undo feedback if the time
   // step is too large.
   Real* d_prev_dens;
   int* d_prev_N;
-
-  if (G.Particles.n_local > 0) {
-    GPU_Error_Check(cudaMalloc(&d_dti, sizeof(Real)));
-    GPU_Error_Check(cudaMemcpy(d_dti, &h_dti, sizeof(Real), cudaMemcpyHostToDevice));
-    GPU_Error_Check(cudaMalloc(&d_prev_dens, G.Particles.n_local * sizeof(Real)));
-    GPU_Error_Check(cudaMalloc(&d_prev_N, G.Particles.n_local * sizeof(int)));
-    GPU_Error_Check(cudaMemset(d_prev_dens, 0, G.Particles.n_local * sizeof(Real)));
-    GPU_Error_Check(cudaMemset(d_prev_N, 0, G.Particles.n_local * sizeof(int)));
-
-    ngrid = std::ceil((1. * G.Particles.n_local) / TPB_FEEDBACK);
-    GPU_Error_Check(cudaMalloc((void**)&d_info, FEED_INFO_N * ngrid * sizeof(Real)));
+  int const n_active = supernova::n_active;
+  if (n_active > 0) {
+    GPU_Error_Check(cudaMalloc(&d_prev_dens, n_active * sizeof(Real)));
+    GPU_Error_Check(cudaMalloc(&d_prev_N, n_active * sizeof(int)));
+    GPU_Error_Check(cudaMemset(d_prev_dens, 0, n_active * sizeof(Real)));
+    GPU_Error_Check(cudaMemset(d_prev_N, 0, n_active * sizeof(int)));
+
+    ngrid = (n_active - 1) / TPB_FEEDBACK + 1;
+    GPU_Error_Check(cudaMalloc((void**)&d_info, FEED_INFO_N * sizeof(Real)));
   }
-  // TODO: info collection and max dti calculation
-  // assumes ngrid is 1.  The reason being that reduction of
-  // d_info is currently done on each block.  Only the first block reduction
-  // is used
 
   do {
     direction = 1;
-    if (G.Particles.n_local > 0) {
-      hipLaunchKernelGGL(Cluster_Feedback_Kernel, ngrid, TPB_FEEDBACK, 0, 0, G.Particles.n_local,
+    if (n_active > 0) {
+      // Only the info of the last forward pass is kept
+      GPU_Error_Check(cudaMemset(d_info, 0, FEED_INFO_N * sizeof(Real)));
+      hipLaunchKernelGGL(Cluster_Feedback_Kernel, ngrid, TPB_FEEDBACK, 0, 0, n_active, supernova::active_ids,
                          G.Particles.partIDs_dev, G.Particles.pos_x_dev, G.Particles.pos_y_dev, G.Particles.pos_z_dev,
-                         G.Particles.mass_dev, G.Particles.age_dev, G.H.xblocal, G.H.yblocal, G.H.zblocal,
-                         G.H.xblocal_max, G.H.yblocal_max, G.H.zblocal_max, G.H.dx, G.H.dy, G.H.dz, G.H.nx, G.H.ny,
-                         G.H.nz, G.H.n_ghost, G.H.t, G.H.dt, d_dti, d_info, G.C.d_density, G.C.d_GasEnergy,
-                         G.C.d_Energy, G.C.d_momentum_x, G.C.d_momentum_y, G.C.d_momentum_z, gama,
-                         supernova::randStates, d_prev_dens, d_prev_N, direction, dev_snr, snr_dt, time_sn_start,
-                         time_sn_end, G.H.n_step, G.H.density_floor);
-
-      GPU_Error_Check(cudaMemcpy(&h_dti, d_dti, sizeof(Real), cudaMemcpyDeviceToHost));
+                         G.Particles.mass_dev, G.Particles.age_dev, xMin, yMin, zMin, xMax, yMax, zMax, G.H.dx, G.H.dy,
+                         G.H.dz, G.H.nx, G.H.ny, G.H.nz, G.H.n_ghost, G.H.t, G.H.dt, d_dti, d_info, G.C.d_density,
+                         G.C.d_GasEnergy, G.C.d_Energy, G.C.d_momentum_x, G.C.d_momentum_y, G.C.d_momentum_z, gama,
+                         supernova::prng_seed, d_prev_dens, d_prev_N, direction, dev_snr_cumulative, snr_n, snr_dt,
+                         time_sn_start, time_sn_end, G.H.n_step, G.H.density_floor);
     }
-
-  #ifdef MPI_CHOLLA
-    h_dti = ReduceRealMax(h_dti);
-    MPI_Barrier(world);
-  #endif  // MPI_CHOLLA
+    h_dti = timestep_constraints::Reduce(timestep_constraints::feedback);
 
     if (h_dti != 0 && (C_cfl / h_dti < G.H.dt)) {
       // timestep too big: need to undo the last operation
       direction = -1;
-      if (G.Particles.n_local > 0) {
-        hipLaunchKernelGGL(Cluster_Feedback_Kernel, ngrid, TPB_FEEDBACK, 0, 0, G.Particles.n_local,
+      if (n_active > 0) {
+        hipLaunchKernelGGL(Cluster_Feedback_Kernel, ngrid, TPB_FEEDBACK, 0, 0, n_active, supernova::active_ids,
                            G.Particles.partIDs_dev, G.Particles.pos_x_dev, G.Particles.pos_y_dev, G.Particles.pos_z_dev,
-                           G.Particles.mass_dev, G.Particles.age_dev, G.H.xblocal, G.H.yblocal, G.H.zblocal,
-                           G.H.xblocal_max, G.H.yblocal_max, G.H.zblocal_max, G.H.dx, G.H.dy, G.H.dz, G.H.nx, G.H.ny,
-                           G.H.nz, G.H.n_ghost, G.H.t, G.H.dt, d_dti, d_info, G.C.d_density, G.C.d_GasEnergy,
-                           G.C.d_Energy, G.C.d_momentum_x, G.C.d_momentum_y, G.C.d_momentum_z, gama,
-                           supernova::randStates, d_prev_dens, d_prev_N, direction, dev_snr, snr_dt, time_sn_start,
-                           time_sn_end, G.H.n_step, G.H.density_floor);
+                           G.Particles.mass_dev, G.Particles.age_dev, xMin, yMin, zMin, xMax, yMax, zMax, G.H.dx,
+                           G.H.dy, G.H.dz, G.H.nx, G.H.ny, G.H.nz, G.H.n_ghost, G.H.t, G.H.dt, d_dti, d_info,
+                           G.C.d_density, G.C.d_GasEnergy, G.C.d_Energy, G.C.d_momentum_x, G.C.d_momentum_y,
+                           G.C.d_momentum_z, gama, supernova::prng_seed, d_prev_dens, d_prev_N, direction,
+                           dev_snr_cumulative, snr_n, snr_dt, time_sn_start, time_sn_end, G.H.n_step,
+                           G.H.density_floor);
 
         GPU_Error_Check(cudaDeviceSynchronize());
       }
@@ -728,13 +1269,13 @@ Real supernova::Cluster_Feedback(Grid3D& G, FeedbackAnalysis& analysis)
 
   } while (direction == -1);
 
-  if (G.Particles.n_local > 0) {
+  if (n_active > 0) {
     GPU_Error_Check(cudaMemcpy(&h_info, d_info, FEED_INFO_N * sizeof(Real), cudaMemcpyDeviceToHost));
-    GPU_Error_Check(cudaFree(d_dti));
     GPU_Error_Check(cudaFree(d_info));
     GPU_Error_Check(cudaFree(d_prev_dens));
     GPU_Error_Check(cudaFree(d_prev_N));
   }
+  #endif  // SUPERNOVA_DETERMINISTIC
 
   #ifdef MPI_CHOLLA
   MPI_Reduce(&h_info, &info, FEED_INFO_N, MPI_CHREAL, MPI_SUM, root, world);
@@ -3,6 +3,7 @@
   #include <stdio.h>
   #include <stdlib.h>
 
+  #include <algorithm>
   #include <iostream>
 
   #include "../global/global.h"
@@ -57,6 +58,14 @@ void Grid3D::Get_Gravity_CIC()
 
     #ifndef PARALLEL_OMP
   Get_Gravity_CIC_function(0, Particles.n_local);
+    #elif defined(PARTICLES_OMP_DYNAMIC)
+
+      // Hand out chunks of particles to the threads as they finish the previous
+      // ones, so threads slowed down by scattered memory accesses do less work
+      #pragma omp parallel for num_threads(N_OMP_THREADS) schedule(dynamic)
+  for (part_int_t p_start = 0; p_start < Particles.n_local; p_start += PARTICLES_OMP_CHUNK) {
+    Get_Gravity_CIC_function(p_start, std::min<part_int_t>(p_start + PARTICLES_OMP_CHUNK, Particles.n_local));
+  }
     #else
 
       #pragma omp parallel num_threads(N_OMP_THREADS)
@@ -74,8 +83,12 @@ void Grid3D::Get_Gravity_CIC()
     #endif  // PARALLEL_OMP
   #endif    // PARTICLES_CPU
 
-  #ifdef PARTICLES_GPU
+  #if defined(PARTICLES_GPU) && !defined(PARTICLES_KDK_FUSED)
   Particles.Get_Gravity_CIC_GPU();
+    #ifdef PARTICLES_P3M
+  // Add the particle-particle forces that the mesh doesn't resolve
+  Particles.Add_Short_Range_Forces_GPU(Grav.Gconst);
+    #endif
   #endif
 }
 
@@ -87,12 +100,16 @@ void Particles3D::Get_Gravity_Field_Particles_GPU(Real *potential_host)
                                            G.gravity_x_dev, G.gravity_y_dev, G.gravity_z_dev);
 }
 
+    #ifndef PARTICLES_KDK_FUSED
 void Particles3D::Get_Gravity_CIC_GPU()
 {
-  Get_Gravity_CIC_GPU_function(n_local, G.nx_local, G.ny_local, G.nz_local, G.n_ghost_particles_grid, G.xMin, G.xMax,
-                               G.yMin, G.yMax, G.zMin, G.zMax, G.dx, G.dy, G.dz, pos_x_dev, pos_y_dev, pos_z_dev,
-                               grav_x_dev, grav_y_dev, grav_z_dev, G.gravity_x_dev, G.gravity_y_dev, G.gravity_z_dev);
+  Get_Gravity_CIC_GPU_function(n_local, G.nx_local, G.ny_local, G.nz_local, G.n_ghost_particles_grid,
+                               G.xMin - G.pos_origin_x, G.xMax - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                               G.yMax - G.pos_origin_y, G.zMin - G.pos_origin_z, G.zMax - G.pos_origin_z, G.dx, G.dy,
+                               G.dz, pos_x_dev, pos_y_dev, pos_z_dev, grav_x_dev, grav_y_dev, grav_z_dev,
+                               G.gravity_x_dev, G.gravity_y_dev, G.gravity_z_dev);
 }
+    #endif  // PARTICLES_KDK_FUSED
 
   #endif  // PARTICLES_GPU
 
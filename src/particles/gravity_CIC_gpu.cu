@@ -8,6 +8,7 @@
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../utils/gpu.hpp"
+  #include "gravity_CIC_gpu.h"
   #include "particles_3D.h"
 
   #ifdef GRAVITY_GPU
@@ -135,22 +136,13 @@ void Particles3D::Get_Gravity_Field_Particles_GPU_function(int nx_local, int ny_
   GPU_Error_Check();
 }
 
-// Get CIC indexes from the particles positions
-__device__ void Get_Indexes_CIC_Gravity(Real xMin, Real yMin, Real zMin, Real dx, Real dy, Real dz, Real pos_x,
-                                        Real pos_y, Real pos_z, int &indx_x, int &indx_y, int &indx_z)
-{
-  indx_x = (int)floor((pos_x - xMin - 0.5 * dx) / dx);
-  indx_y = (int)floor((pos_y - yMin - 0.5 * dy) / dy);
-  indx_z = (int)floor((pos_z - zMin - 0.5 * dz) / dz);
-}
-
 // Kernel to compute the gravitational field at the particles positions via
 // Cloud-In-Cell
 __global__ void Get_Gravity_CIC_Kernel(part_int_t n_local, Real *gravity_x_dev, Real *gravity_y_dev,
-                                       Real *gravity_z_dev, Real *pos_x_dev, Real *pos_y_dev, Real *pos_z_dev,
-                                       Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev, Real xMin, Real yMin,
-                                       Real zMin, Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz, int nx,
-                                       int ny, int nz, int n_ghost)
+                                       Real *gravity_z_dev, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                       Real_Part *pos_z_dev, Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev,
+                                       Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax, Real dx,
+                                       Real dy, Real dz, int nx, int ny, int nz, int n_ghost)
 {
   part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
 
@@ -158,106 +150,13 @@ __global__ void Get_Gravity_CIC_Kernel(part_int_t n_local, Real *gravity_x_dev,
     return;
   }
 
-  int nx_g, ny_g;
-  nx_g = nx + 2 * n_ghost;
-  ny_g = ny + 2 * n_ghost;
-
-  Real pos_x, pos_y, pos_z;
-  Real cell_center_x, cell_center_y, cell_center_z;
-  Real delta_x, delta_y, delta_z;
-  Real g_x_bl, g_x_br, g_x_bu, g_x_bru, g_x_tl, g_x_tr, g_x_tu, g_x_tru;
-  Real g_y_bl, g_y_br, g_y_bu, g_y_bru, g_y_tl, g_y_tr, g_y_tu, g_y_tru;
-  Real g_z_bl, g_z_br, g_z_bu, g_z_bru, g_z_tl, g_z_tr, g_z_tu, g_z_tru;
   Real g_x, g_y, g_z;
-
-  pos_x = pos_x_dev[tid];
-  pos_y = pos_y_dev[tid];
-  pos_z = pos_z_dev[tid];
-
-  int indx_x, indx_y, indx_z, indx;
-  Get_Indexes_CIC_Gravity(xMin, yMin, zMin, dx, dy, dz, pos_x, pos_y, pos_z, indx_x, indx_y, indx_z);
-
-  bool in_local = true;
-
-  if (pos_x < xMin || pos_x >= xMax) {
-    in_local = false;
-  }
-  if (pos_y < yMin || pos_y >= yMax) {
-    in_local = false;
-  }
-  if (pos_z < zMin || pos_z >= zMax) {
-    in_local = false;
-  }
-  if (!in_local) {
-    printf(" Gravity CIC Error: Particle outside local domain");
+  if (!Interpolate_Gravity_CIC(pos_x_dev[tid], pos_y_dev[tid], pos_z_dev[tid], gravity_x_dev, gravity_y_dev,
+                               gravity_z_dev, xMin, yMin, zMin, xMax, yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x,
+                               g_y, g_z)) {
     return;
   }
 
-  cell_center_x = xMin + indx_x * dx + 0.5 * dx;
-  cell_center_y = yMin + indx_y * dy + 0.5 * dy;
-  cell_center_z = zMin + indx_z * dz + 0.5 * dz;
-  delta_x       = 1 - (pos_x - cell_center_x) / dx;
-  delta_y       = 1 - (pos_y - cell_center_y) / dy;
-  delta_z       = 1 - (pos_z - cell_center_z) / dz;
-  indx_x += n_ghost;
-  indx_y += n_ghost;
-  indx_z += n_ghost;
-
-  indx   = indx_x + indx_y * nx_g + indx_z * nx_g * ny_g;
-  g_x_bl = gravity_x_dev[indx];
-  g_y_bl = gravity_y_dev[indx];
-  g_z_bl = gravity_z_dev[indx];
-
-  indx   = (indx_x + 1) + (indx_y)*nx_g + (indx_z)*nx_g * ny_g;
-  g_x_br = gravity_x_dev[indx];
-  g_y_br = gravity_y_dev[indx];
-  g_z_br = gravity_z_dev[indx];
-
-  indx   = (indx_x) + (indx_y + 1) * nx_g + (indx_z)*nx_g * ny_g;
-  g_x_bu = gravity_x_dev[indx];
-  g_y_bu = gravity_y_dev[indx];
-  g_z_bu = gravity_z_dev[indx];
-
-  indx    = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z)*nx_g * ny_g;
-  g_x_bru = gravity_x_dev[indx];
-  g_y_bru = gravity_y_dev[indx];
-  g_z_bru = gravity_z_dev[indx];
-
-  indx   = (indx_x) + (indx_y)*nx_g + (indx_z + 1) * nx_g * ny_g;
-  g_x_tl = gravity_x_dev[indx];
-  g_y_tl = gravity_y_dev[indx];
-  g_z_tl = gravity_z_dev[indx];
-
-  indx   = (indx_x + 1) + (indx_y)*nx_g + (indx_z + 1) * nx_g * ny_g;
-  g_x_tr = gravity_x_dev[indx];
-  g_y_tr = gravity_y_dev[indx];
-  g_z_tr = gravity_z_dev[indx];
-
-  indx   = (indx_x) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
-  g_x_tu = gravity_x_dev[indx];
-  g_y_tu = gravity_y_dev[indx];
-  g_z_tu = gravity_z_dev[indx];
-
-  indx    = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
-  g_x_tru = gravity_x_dev[indx];
-  g_y_tru = gravity_y_dev[indx];
-  g_z_tru = gravity_z_dev[indx];
-
-  g_x = g_x_bl * (delta_x) * (delta_y) * (delta_z) + g_x_br * (1 - delta_x) * (delta_y) * (delta_z) +
-        g_x_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_x_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
-        g_x_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_x_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
-        g_x_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_x_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
-
-  g_y = g_y_bl * (delta_x) * (delta_y) * (delta_z) + g_y_br * (1 - delta_x) * (delta_y) * (delta_z) +
-        g_y_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_y_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
-        g_y_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_y_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
-        g_y_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_y_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
-
-  g_z = g_z_bl * (delta_x) * (delta_y) * (delta_z) + g_z_br * (1 - delta_x) * (delta_y) * (delta_z) +
-        g_z_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_z_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
-        g_z_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_z_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
-        g_z_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_z_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
-
   grav_x_dev[tid] = g_x;
   grav_y_dev[tid] = g_y;
   grav_z_dev[tid] = g_z;
@@ -267,10 +166,10 @@ __global__ void Get_Gravity_CIC_Kernel(part_int_t n_local, Real *gravity_x_dev,
 // ( CIC )
 void Particles3D::Get_Gravity_CIC_GPU_function(part_int_t n_local, int nx_local, int ny_local, int nz_local,
                                                int n_ghost_particles_grid, Real xMin, Real xMax, Real yMin, Real yMax,
-                                               Real zMin, Real zMax, Real dx, Real dy, Real dz, Real *pos_x_dev,
-                                               Real *pos_y_dev, Real *pos_z_dev, Real *grav_x_dev, Real *grav_y_dev,
-                                               Real *grav_z_dev, Real *gravity_x_dev, Real *gravity_y_dev,
-                                               Real *gravity_z_dev)
+                                               Real zMin, Real zMax, Real dx, Real dy, Real dz, Real_Part *pos_x_dev,
+                                               Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real *grav_x_dev,
+                                               Real *grav_y_dev, Real *grav_z_dev, Real *gravity_x_dev,
+                                               Real *gravity_y_dev, Real *gravity_z_dev)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -0,0 +1,126 @@
+#if defined(PARTICLES) && defined(PARTICLES_GPU)
+
+  #ifndef GRAVITY_CIC_GPU_H
+    #define GRAVITY_CIC_GPU_H
+
+    #include <stdio.h>
+
+    #include "../global/global.h"
+    #include "../utils/gpu.hpp"
+
+// Get CIC indexes from the particles positions
+__device__ inline void Get_Indexes_CIC_Gravity(Real xMin, Real yMin, Real zMin, Real dx, Real dy, Real dz, Real pos_x,
+                                               Real pos_y, Real pos_z, int &indx_x, int &indx_y, int &indx_z)
+{
+  indx_x = (int)floor((pos_x - xMin - 0.5 * dx) / dx);
+  indx_y = (int)floor((pos_y - yMin - 0.5 * dy) / dy);
+  indx_z = (int)floor((pos_z - zMin - 0.5 * dz) / dz);
+}
+
+// Interpolate the gravitational field from the centers of the cells to the
+// position of a particle via Cloud-In-Cell. Returns false without setting the
+// field if the particle is outside the local domain
+__device__ inline bool Interpolate_Gravity_CIC(Real pos_x, Real pos_y, Real pos_z, Real *gravity_x_dev,
+                                               Real *gravity_y_dev, Real *gravity_z_dev, Real xMin, Real yMin,
+                                               Real zMin, Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz,
+                                               int nx, int ny, int nz, int n_ghost, Real &g_x, Real &g_y, Real &g_z)
+{
+  int nx_g, ny_g;
+  nx_g = nx + 2 * n_ghost;
+  ny_g = ny + 2 * n_ghost;
+
+  Real cell_center_x, cell_center_y, cell_center_z;
+  Real delta_x, delta_y, delta_z;
+  Real g_x_bl, g_x_br, g_x_bu, g_x_bru, g_x_tl, g_x_tr, g_x_tu, g_x_tru;
+  Real g_y_bl, g_y_br, g_y_bu, g_y_bru, g_y_tl, g_y_tr, g_y_tu, g_y_tru;
+  Real g_z_bl, g_z_br, g_z_bu, g_z_bru, g_z_tl, g_z_tr, g_z_tu, g_z_tru;
+
+  int indx_x, indx_y, indx_z, indx;
+  Get_Indexes_CIC_Gravity(xMin, yMin, zMin, dx, dy, dz, pos_x, pos_y, pos_z, indx_x, indx_y, indx_z);
+
+  bool in_local = true;
+
+  if (pos_x < xMin || pos_x >= xMax) {
+    in_local = false;
+  }
+  if (pos_y < yMin || pos_y >= yMax) {
+    in_local = false;
+  }
+  if (pos_z < zMin || pos_z >= zMax) {
+    in_local = false;
+  }
+  if (!in_local) {
+    printf(" Gravity CIC Error: Particle outside local domain");
+    return false;
+  }
+
+  cell_center_x = xMin + indx_x * dx + 0.5 * dx;
+  cell_center_y = yMin + indx_y * dy + 0.5 * dy;
+  cell_center_z = zMin + indx_z * dz + 0.5 * dz;
+  delta_x       = 1 - (pos_x - cell_center_x) / dx;
+  delta_y       = 1 - (pos_y - cell_center_y) / dy;
+  delta_z       = 1 - (pos_z - cell_center_z) / dz;
+  indx_x += n_ghost;
+  indx_y += n_ghost;
+  indx_z += n_ghost;
+
+  indx   = indx_x + indx_y * nx_g + indx_z * nx_g * ny_g;
+  g_x_bl = gravity_x_dev[indx];
+  g_y_bl = gravity_y_dev[indx];
+  g_z_bl = gravity_z_dev[indx];
+
+  indx   = (indx_x + 1) + (indx_y)*nx_g + (indx_z)*nx_g * ny_g;
+  g_x_br = gravity_x_dev[indx];
+  g_y_br = gravity_y_dev[indx];
+  g_z_br = gravity_z_dev[indx];
+
+  indx   = (indx_x) + (indx_y + 1) * nx_g + (indx_z)*nx_g * ny_g;
+  g_x_bu = gravity_x_dev[indx];
+  g_y_bu = gravity_y_dev[indx];
+  g_z_bu = gravity_z_dev[indx];
+
+  indx    = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z)*nx_g * ny_g;
+  g_x_bru = gravity_x_dev[indx];
+  g_y_bru = gravity_y_dev[indx];
+  g_z_bru = gravity_z_dev[indx];
+
+  indx   = (indx_x) + (indx_y)*nx_g + (indx_z + 1) * nx_g * ny_g;
+  g_x_tl = gravity_x_dev[indx];
+  g_y_tl = gravity_y_dev[indx];
+  g_z_tl = gravity_z_dev[indx];
+
+  indx   = (indx_x + 1) + (indx_y)*nx_g + (indx_z + 1) * nx_g * ny_g;
+  g_x_tr = gravity_x_dev[indx];
+  g_y_tr = gravity_y_dev[indx];
+  g_z_tr = gravity_z_dev[indx];
+
+  indx   = (indx_x) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
+  g_x_tu = gravity_x_dev[indx];
+  g_y_tu = gravity_y_dev[indx];
+  g_z_tu = gravity_z_dev[indx];
+
+  indx    = (indx_x + 1) + (indx_y + 1) * nx_g + (indx_z + 1) * nx_g * ny_g;
+  g_x_tru = gravity_x_dev[indx];
+  g_y_tru = gravity_y_dev[indx];
+  g_z_tru = gravity_z_dev[indx];
+
+  g_x = g_x_bl * (delta_x) * (delta_y) * (delta_z) + g_x_br * (1 - delta_x) * (delta_y) * (delta_z) +
+        g_x_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_x_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
+        g_x_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_x_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
+        g_x_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_x_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
+
+  g_y = g_y_bl * (delta_x) * (delta_y) * (delta_z) + g_y_br * (1 - delta_x) * (delta_y) * (delta_z) +
+        g_y_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_y_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
+        g_y_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_y_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
+        g_y_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_y_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
+
+  g_z = g_z_bl * (delta_x) * (delta_y) * (delta_z) + g_z_br * (1 - delta_x) * (delta_y) * (delta_z) +
+        g_z_bu * (delta_x) * (1 - delta_y) * (delta_z) + g_z_bru * (1 - delta_x) * (1 - delta_y) * (delta_z) +
+        g_z_tl * (delta_x) * (delta_y) * (1 - delta_z) + g_z_tr * (1 - delta_x) * (delta_y) * (1 - delta_z) +
+        g_z_tu * (delta_x) * (1 - delta_y) * (1 - delta_z) + g_z_tru * (1 - delta_x) * (1 - delta_y) * (1 - delta_z);
+
+  return true;
+}
+
+  #endif  // GRAVITY_CIC_GPU_H
+#endif    // PARTICLES && PARTICLES_GPU
@@ -5,13 +5,19 @@
   #include <string.h>
   #include <unistd.h>
 
+  #include <algorithm>
   #include <iostream>
   #include <string>
+  #include <vector>
 
   #include "../global/global.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/timing_functions.h"
   #include "particles_3D.h"
+  #include "particles_subset.h"
 
   #ifdef HDF5
     #include <hdf5.h>
@@ -43,6 +49,13 @@ void Particles3D::Load_Particles_Data(struct Parameters *P)
 
   const std::string filename = std::string(P->indir) + base_fname;
 
+  #if defined(HDF5) && defined(MPI_CHOLLA) && !defined(TILED_INITIAL_CONDITIONS)
+  if (strcmp(P->init, "Read_Grid_Cat") == 0 || P->read_particles_cat) {
+    Load_Particles_Data_Cat(P);
+    return;
+  }
+  #endif
+
   chprintf(" Loading particles file: %s \n", filename.c_str());
 
   #ifdef HDF5
@@ -69,28 +82,343 @@ void Grid3D::WriteData_Particles(struct Parameters P, int nfile)
 
   #ifdef HDF5
 
-void Particles3D::Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Parameters *P)
+// Read the particles of this rank from a dataset. With a slab {offset, count}
+// the ranks read their particles of the single file collectively
+static herr_t Read_Particles_Dataset_HDF5(hid_t file_id, const char *name, hid_t mem_type, void *buffer,
+                                          hsize_t const *slab)
 {
-  int i, j, k, id, buf_id;
-  hid_t attribute_id, dataset_id;
-  Real *dataset_buffer_px;
-  Real *dataset_buffer_py;
-  Real *dataset_buffer_pz;
-  Real *dataset_buffer_vx;
-  Real *dataset_buffer_vy;
-  Real *dataset_buffer_vz;
-  Real *dataset_buffer_m;
-    #ifdef PARTICLE_AGE
-  Real *dataset_buffer_age;
-    #endif
+  hid_t dataset_id = H5Dopen(file_id, name, H5P_DEFAULT);
+  if (slab == nullptr) {
+    herr_t status = H5Dread(dataset_id, mem_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer);
+    H5Dclose(dataset_id);
+    return status;
+  }
+
+  hid_t file_space_id = H5Dget_space(dataset_id);
+  hid_t mem_space_id  = H5Screate_simple(1, &slab[1], NULL);
+  if (slab[1] > 0) {
+    H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &slab[0], NULL, &slab[1], NULL);
+  } else {
+    H5Sselect_none(file_space_id);
+  }
+  hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+    #ifdef H5_HAVE_PARALLEL
+  H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+    #endif  // H5_HAVE_PARALLEL
+  herr_t status = H5Dread(dataset_id, mem_type, mem_space_id, file_space_id, dxpl_id, buffer);
+  H5Pclose(dxpl_id);
+  H5Sclose(mem_space_id);
+  H5Sclose(file_space_id);
+  H5Dclose(dataset_id);
+  return status;
+}
+
+    #ifdef MPI_CHOLLA
+/*! \brief Load the particles of this rank from a single file of all the
+ * particles. The ranks of the decomposition of a file of
+ * Output_Particles_Data_Cat read their slabs, any other decomposition or file
+ * is loaded by Load_Particles_Data_Streamed */
+void Particles3D::Load_Particles_Data_Cat(struct Parameters *P)
+{
+  ScopedTimer timer("Load_Particles_Data_Cat");
+  std::string const filename = std::string(P->indir) + std::to_string(P->nfile) + "_particles.h5";
+  chprintf(" Loading particles file: %s \n", filename.c_str());
+
+  hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+      #ifdef H5_HAVE_PARALLEL
+  H5Pset_fapl_mpio(fapl_id, world, MPI_INFO_NULL);
+  H5Pset_all_coll_metadata_ops(fapl_id, true);
+      #endif  // H5_HAVE_PARALLEL
+  hid_t file_id = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, fapl_id);
+  H5Pclose(fapl_id);
+  if (file_id < 0) {
+    CHOLLA_ERROR("Unable to open input file: %s", filename.c_str());
+  }
+
   herr_t status;
+  bool same_decomposition = false;
+  if (H5Aexists(file_id, "nprocs") > 0 && H5Lexists(file_id, "n_particles_rank", H5P_DEFAULT) > 0) {
+    int nprocs[3];
+    hid_t attribute_id = H5Aopen(file_id, "nprocs", H5P_DEFAULT);
+    status             = H5Aread(attribute_id, H5T_NATIVE_INT, nprocs);
+    status             = H5Aclose(attribute_id);
+    same_decomposition = nprocs[0] == nproc_x && nprocs[1] == nproc_y && nprocs[2] == nproc_z;
+  }
 
-  part_int_t n_to_load, pIndx;
+  if (same_decomposition) {
+    // The slab of this rank follows the particles of the lower ranks
+    std::vector<part_int_t> n_particles_rank(nproc);
+    hid_t dataset_id = H5Dopen(file_id, "/n_particles_rank", H5P_DEFAULT);
+    status           = H5Dread(dataset_id, H5T_NATIVE_LONG, H5S_ALL, H5S_ALL, H5P_DEFAULT, n_particles_rank.data());
+    status           = H5Dclose(dataset_id);
+    hsize_t slab[2]  = {0, hsize_t(n_particles_rank[procID])};
+    for (int rank = 0; rank < procID; rank++) {
+      slab[0] += n_particles_rank[rank];
+    }
+    Load_Particles_Data_HDF5(file_id, P->nfile, P, slab);
+  } else {
+    Load_Particles_Data_Streamed(file_id, P);
+  }
+  H5Fclose(file_id);
+}
 
-  attribute_id = H5Aopen(file_id, "n_particles_local", H5P_DEFAULT);
-  status       = H5Aread(attribute_id, H5T_NATIVE_LONG, &n_to_load);
-  status       = H5Aclose(attribute_id);
+// A particle of Load_Particles_Data_Streamed, sent to the rank of its position
+struct ParticleLoadRecord {
+  Real pos[3];
+  Real vel[3];
+      #ifndef SINGLE_PARTICLE_MASS
+  Real mass;
+      #endif
+      #ifdef PARTICLE_AGE
+  Real age;
+      #endif
+      #ifdef PARTICLE_IDS
+  part_int_t id;
+      #endif
+};
+
+/*! \brief Load the particles of a single file on any decomposition, e.g. the
+ * initial conditions of all the particles. Every rank reads a contiguous block
+ * of the datasets collectively, in rounds of read_particles_cat_chunk
+ * particles, and each round is sent to the ranks of the positions with
+ * MPI_Alltoallv. The host memory is then bounded by the rounds instead of the
+ * file. On the GPU a first pass over the positions counts the particles of
+ * each rank to allocate the device arrays, which the particles are copied to
+ * as they arrive */
+void Particles3D::Load_Particles_Data_Streamed(hid_t file_id, struct Parameters *P)
+{
+  ScopedTimer timer("Load_Particles_Data_Streamed");
+  Load_Particles_Header_HDF5(file_id);
+
+  hsize_t n_total;
+  hid_t dataset_id = H5Dopen(file_id, "/pos_x", H5P_DEFAULT);
+  hid_t space_id   = H5Dget_space(dataset_id);
+  H5Sget_simple_extent_dims(space_id, &n_total, NULL);
+  H5Sclose(space_id);
+  H5Dclose(dataset_id);
+  chprintf(" Total Particles To Load: %llu\n", (unsigned long long)n_total);
+
+  // The rounds of every rank have the same number of collective reads, the
+  // ranks that reached the end of their block read nothing
+  hsize_t const chunk       = P->read_particles_cat_chunk;
+  hsize_t const block_start = n_total * procID / nproc;
+  hsize_t const block_end   = n_total * (procID + 1) / nproc;
+  hsize_t const n_rounds    = ((n_total + nproc - 1) / nproc + chunk - 1) / chunk;
+
+  // The {offset, count} of the particles of a round
+  auto round_slab = [&](hsize_t round, hsize_t *slab) {
+    slab[0] = std::min(block_start + round * chunk, block_end);
+    slab[1] = std::min(chunk, block_end - slab[0]);
+  };
+
+  // The lower bounds of the subdomains along each axis, and the rank of each
+  // block of the decomposition
+  std::vector<Real> lower(3 * nproc);
+  Real local_lower[3] = {G.xMin, G.yMin, G.zMin};
+  MPI_Allgather(local_lower, 3, MPI_CHREAL, lower.data(), 3, MPI_CHREAL, world);
+  std::vector<Real> starts[3];
+  for (int d = 0; d < 3; d++) {
+    for (int rank = 0; rank < nproc; rank++) {
+      starts[d].push_back(lower[3 * rank + d]);
+    }
+    std::sort(starts[d].begin(), starts[d].end());
+    starts[d].erase(std::unique(starts[d].begin(), starts[d].end()), starts[d].end());
+  }
+  if (starts[0].size() * starts[1].size() * starts[2].size() != size_t(nproc)) {
+    CHOLLA_ERROR("The streamed particle loader needs a block decomposition of the domain");
+  }
+  std::vector<int> block_rank(nproc);
+  for (int rank = 0; rank < nproc; rank++) {
+    int block[3];
+    for (int d = 0; d < 3; d++) {
+      block[d] = std::lower_bound(starts[d].begin(), starts[d].end(), lower[3 * rank + d]) - starts[d].begin();
+    }
+    block_rank[(block[0] * starts[1].size() + block[1]) * starts[2].size() + block[2]] = rank;
+  }
+  // The particles outside of the domain go to the ranks of the closest blocks
+  auto owner = [&](Real x, Real y, Real z) {
+    Real const pos[3] = {x, y, z};
+    int block[3];
+    for (int d = 0; d < 3; d++) {
+      int const i = std::upper_bound(starts[d].begin(), starts[d].end(), pos[d]) - starts[d].begin() - 1;
+      block[d]    = std::min(std::max(i, 0), int(starts[d].size()) - 1);
+    }
+    return block_rank[(block[0] * starts[1].size() + block[1]) * starts[2].size() + block[2]];
+  };
+
+  const char *position_names[3] = {"/pos_x", "/pos_y", "/pos_z"};
+  const char *velocity_names[3] = {"/vel_x", "/vel_y", "/vel_z"};
+  std::vector<Real> position[3], velocity[3], mass_read, age_read;
+  std::vector<part_int_t> ids_read;
+  for (int d = 0; d < 3; d++) {
+    position[d].resize(chunk);
+    velocity[d].resize(chunk);
+  }
+  hsize_t slab[2];
+  herr_t status;
+
+      #ifdef PARTICLES_GPU
+  // Count the particles of this rank to allocate the device arrays once
+  std::vector<part_int_t> n_send_total(nproc, 0);
+  for (hsize_t round = 0; round < n_rounds; round++) {
+    round_slab(round, slab);
+    for (int d = 0; d < 3; d++) {
+      status = Read_Particles_Dataset_HDF5(file_id, position_names[d], H5T_NATIVE_DOUBLE, position[d].data(), slab);
+    }
+    for (hsize_t i = 0; i < slab[1]; i++) {
+      n_send_total[owner(position[0][i], position[1][i], position[2][i])]++;
+    }
+  }
+  part_int_t n_receive_total;
+  MPI_Reduce_scatter_block(n_send_total.data(), &n_receive_total, 1, MPI_PART_INT, MPI_SUM, world);
+  Allocate_Particles_Arrays_GPU(n_receive_total);
+      #endif  // PARTICLES_GPU
 
+      #ifndef SINGLE_PARTICLE_MASS
+  mass_read.resize(chunk);
+      #endif
+      #ifdef PARTICLE_AGE
+  age_read.resize(chunk);
+      #endif
+      #ifdef PARTICLE_IDS
+  ids_read.resize(chunk);
+      #endif
+  MPI_Datatype record_type;
+  MPI_Type_contiguous(sizeof(ParticleLoadRecord), MPI_BYTE, &record_type);
+  MPI_Type_commit(&record_type);
+  std::vector<ParticleLoadRecord> send, receive;
+  std::vector<int> owners(chunk);
+  std::vector<int> send_counts(nproc), send_displs(nproc), recv_counts(nproc), recv_displs(nproc), cursor(nproc);
+  n_local = 0;
+
+  for (hsize_t round = 0; round < n_rounds; round++) {
+    round_slab(round, slab);
+    for (int d = 0; d < 3; d++) {
+      status = Read_Particles_Dataset_HDF5(file_id, position_names[d], H5T_NATIVE_DOUBLE, position[d].data(), slab);
+      status = Read_Particles_Dataset_HDF5(file_id, velocity_names[d], H5T_NATIVE_DOUBLE, velocity[d].data(), slab);
+    }
+      #ifndef SINGLE_PARTICLE_MASS
+    status = Read_Particles_Dataset_HDF5(file_id, "/mass", H5T_NATIVE_DOUBLE, mass_read.data(), slab);
+      #endif
+      #ifdef PARTICLE_AGE
+    status = Read_Particles_Dataset_HDF5(file_id, "/age", H5T_NATIVE_DOUBLE, age_read.data(), slab);
+      #endif
+      #ifdef PARTICLE_IDS
+    status = Read_Particles_Dataset_HDF5(file_id, "/particle_IDs", H5T_NATIVE_LONG, ids_read.data(), slab);
+      #endif
+
+    // Group the particles of the round by their ranks
+    std::fill(send_counts.begin(), send_counts.end(), 0);
+    for (hsize_t i = 0; i < slab[1]; i++) {
+      owners[i] = owner(position[0][i], position[1][i], position[2][i]);
+      send_counts[owners[i]]++;
+    }
+    for (int rank = 0, displ = 0; rank < nproc; rank++) {
+      send_displs[rank] = displ;
+      cursor[rank]      = displ;
+      displ += send_counts[rank];
+    }
+    send.resize(slab[1]);
+    for (hsize_t i = 0; i < slab[1]; i++) {
+      ParticleLoadRecord &record = send[cursor[owners[i]]++];
+      for (int d = 0; d < 3; d++) {
+        record.pos[d] = position[d][i];
+        record.vel[d] = velocity[d][i];
+      }
+      #ifndef SINGLE_PARTICLE_MASS
+      record.mass = mass_read[i];
+      #endif
+      #ifdef PARTICLE_AGE
+      record.age = age_read[i];
+      #endif
+      #ifdef PARTICLE_IDS
+      record.id = ids_read[i];
+      #endif
+    }
+
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, world);
+    int n_receive = 0;
+    for (int rank = 0; rank < nproc; rank++) {
+      recv_displs[rank] = n_receive;
+      n_receive += recv_counts[rank];
+    }
+    receive.resize(n_receive);
+    MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), record_type, receive.data(), recv_counts.data(),
+                  recv_displs.data(), record_type, world);
+    Append_Loaded_Particles(receive.data(), n_receive);
+  }
+  MPI_Type_free(&record_type);
+
+  part_int_t const n_total_loaded = ReducePartIntSum(n_local);
+  chprintf(" Total Particles Loaded: %ld\n", n_total_loaded);
+}
+
+// Add the particles received by Load_Particles_Data_Streamed to the local ones
+void Particles3D::Append_Loaded_Particles(ParticleLoadRecord const *records, int n_records)
+{
+      #ifdef PARTICLES_CPU
+  for (int i = 0; i < n_records; i++) {
+    pos_x.push_back(records[i].pos[0]);
+    pos_y.push_back(records[i].pos[1]);
+    pos_z.push_back(records[i].pos[2]);
+    vel_x.push_back(records[i].vel[0]);
+    vel_y.push_back(records[i].vel[1]);
+    vel_z.push_back(records[i].vel[2]);
+    grav_x.push_back(0.0);
+    grav_y.push_back(0.0);
+    grav_z.push_back(0.0);
+        #ifndef SINGLE_PARTICLE_MASS
+    mass.push_back(records[i].mass);
+        #endif
+        #ifdef PARTICLE_IDS
+    partIDs.push_back(records[i].id);
+        #endif
+        #ifdef PARTICLE_AGE
+    age.push_back(records[i].age);
+        #endif
+  }
+      #endif  // PARTICLES_CPU
+
+      #ifdef PARTICLES_GPU
+  // Copy the fields of the records to the end of the device arrays
+  std::vector<Real> buffer(n_records);
+  Real_Part *const part_dev[6] = {pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev};
+  Real const origin[6]         = {G.pos_origin_x, G.pos_origin_y, G.pos_origin_z, 0, 0, 0};
+  for (int field = 0; field < 6; field++) {
+    for (int i = 0; i < n_records; i++) {
+      buffer[i] = field < 3 ? records[i].pos[field] : records[i].vel[field - 3];
+    }
+    Copy_Particles_Array_Part_Host_to_Device(buffer.data(), part_dev[field] + n_local, n_records, origin[field]);
+  }
+        #ifndef SINGLE_PARTICLE_MASS
+  for (int i = 0; i < n_records; i++) {
+    buffer[i] = records[i].mass;
+  }
+  Copy_Particles_Array_Real_Host_to_Device(buffer.data(), mass_dev + n_local, n_records);
+        #endif
+        #ifdef PARTICLE_AGE
+  for (int i = 0; i < n_records; i++) {
+    buffer[i] = records[i].age;
+  }
+  Copy_Particles_Array_Real_Host_to_Device(buffer.data(), age_dev + n_local, n_records);
+        #endif
+        #ifdef PARTICLE_IDS
+  std::vector<part_int_t> ids(n_records);
+  for (int i = 0; i < n_records; i++) {
+    ids[i] = records[i].id;
+  }
+  Copy_Particles_Array_Int_Host_to_Device(ids.data(), partIDs_dev + n_local, n_records);
+        #endif
+      #endif  // PARTICLES_GPU
+  n_local += n_records;
+}
+    #endif  // MPI_CHOLLA
+
+// Read the attributes of a particles file
+void Particles3D::Load_Particles_Header_HDF5(hid_t file_id)
+{
+  hid_t attribute_id;
+  herr_t status;
     #ifdef COSMOLOGY
   attribute_id = H5Aopen(file_id, "current_z", H5P_DEFAULT);
   status       = H5Aread(attribute_id, H5T_NATIVE_DOUBLE, &current_z);
@@ -107,6 +435,35 @@ void Particles3D::Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Para
   status       = H5Aclose(attribute_id);
   chprintf(" Using Single mass for DM particles: %f  Msun/h\n", particle_mass);
     #endif
+}
+
+void Particles3D::Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Parameters *P, hsize_t const *slab)
+{
+  int i, j, k, id, buf_id;
+  hid_t attribute_id, dataset_id;
+  Real *dataset_buffer_px;
+  Real *dataset_buffer_py;
+  Real *dataset_buffer_pz;
+  Real *dataset_buffer_vx;
+  Real *dataset_buffer_vy;
+  Real *dataset_buffer_vz;
+  Real *dataset_buffer_m;
+    #ifdef PARTICLE_AGE
+  Real *dataset_buffer_age;
+    #endif
+  herr_t status;
+
+  part_int_t n_to_load, pIndx;
+
+  if (slab != nullptr) {
+    n_to_load = slab[1];
+  } else {
+    attribute_id = H5Aopen(file_id, "n_particles_local", H5P_DEFAULT);
+    status       = H5Aread(attribute_id, H5T_NATIVE_LONG, &n_to_load);
+    status       = H5Aclose(attribute_id);
+  }
+
+  Load_Particles_Header_HDF5(file_id);
 
     #ifndef MPI_CHOLLA
   chprintf(" Loading %ld particles\n", n_to_load);
@@ -123,55 +480,38 @@ void Particles3D::Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Para
     #endif
 
   dataset_buffer_px = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/pos_x", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_px);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/pos_x", H5T_NATIVE_DOUBLE, dataset_buffer_px, slab);
 
   dataset_buffer_py = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/pos_y", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_py);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/pos_y", H5T_NATIVE_DOUBLE, dataset_buffer_py, slab);
 
   dataset_buffer_pz = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/pos_z", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_pz);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/pos_z", H5T_NATIVE_DOUBLE, dataset_buffer_pz, slab);
 
   dataset_buffer_vx = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/vel_x", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_vx);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/vel_x", H5T_NATIVE_DOUBLE, dataset_buffer_vx, slab);
 
   dataset_buffer_vy = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/vel_y", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_vy);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/vel_y", H5T_NATIVE_DOUBLE, dataset_buffer_vy, slab);
 
   dataset_buffer_vz = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id        = H5Dopen(file_id, "/vel_z", H5P_DEFAULT);
-  status            = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_vz);
-  status            = H5Dclose(dataset_id);
+  status            = Read_Particles_Dataset_HDF5(file_id, "/vel_z", H5T_NATIVE_DOUBLE, dataset_buffer_vz, slab);
 
     #ifndef SINGLE_PARTICLE_MASS
   dataset_buffer_m = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id       = H5Dopen(file_id, "/mass", H5P_DEFAULT);
-  status           = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_m);
-  status           = H5Dclose(dataset_id);
+  status           = Read_Particles_Dataset_HDF5(file_id, "/mass", H5T_NATIVE_DOUBLE, dataset_buffer_m, slab);
     #endif
 
     #ifdef PARTICLE_IDS
   part_int_t *dataset_buffer_IDs;
   dataset_buffer_IDs = (part_int_t *)malloc(n_to_load * sizeof(part_int_t));
-  dataset_id         = H5Dopen(file_id, "/particle_IDs", H5P_DEFAULT);
-  status             = H5Dread(dataset_id, H5T_NATIVE_LONG, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_IDs);
-  status             = H5Dclose(dataset_id);
+  status =
+      Read_Particles_Dataset_HDF5(file_id, "/particle_IDs", H5T_NATIVE_LONG, dataset_buffer_IDs, slab);
     #endif
 
     #ifdef PARTICLE_AGE
   dataset_buffer_age = (Real *)malloc(n_to_load * sizeof(Real));
-  dataset_id         = H5Dopen(file_id, "/age", H5P_DEFAULT);
-  status             = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer_age);
-  status             = H5Dclose(dataset_id);
+  status             = Read_Particles_Dataset_HDF5(file_id, "/age", H5T_NATIVE_DOUBLE, dataset_buffer_age, slab);
     #endif
 
   // Initialize min and max values for position and velocity to print initial
@@ -367,41 +707,16 @@ void Particles3D::Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Para
   }
 
     #ifdef PARTICLES_GPU
-  // Alocate memory in GPU for particle data
-  // particles_array_size = (part_int_t) n_to_load;
-  particles_array_size = Compute_Particles_GPU_Array_Size(n_to_load);
-  chprintf(" Allocating GPU buffer size: %ld * %f = %ld \n", n_to_load, G.gpu_allocation_factor, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&pos_x_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&pos_y_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&pos_z_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_x_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_y_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_z_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&grav_x_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&grav_y_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&grav_z_dev, particles_array_size);
-      #ifndef SINGLE_PARTICLE_MASS
-  Allocate_Particles_GPU_Array_Real(&mass_dev, particles_array_size);
-      #endif
-      #ifdef PARTICLE_IDS
-  Allocate_Particles_GPU_Array_Part_Int(&partIDs_dev, particles_array_size);
-      #endif
-      #ifdef PARTICLE_AGE
-  Allocate_Particles_GPU_Array_Real(&age_dev, particles_array_size);
-      #endif
-
+  Allocate_Particles_Arrays_GPU(n_to_load);
   n_local = n_to_load;
 
-  chprintf(" Allocated GPU memory for particle data\n");
-  // printf( " Loaded %ld  particles ", n_to_load);
-
   // Copy the particle data to GPU memory
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_px, pos_x_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_py, pos_y_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_pz, pos_z_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_vx, vel_x_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_vy, vel_y_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_vz, vel_z_dev, n_local);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_px, pos_x_dev, n_local, G.pos_origin_x);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_py, pos_y_dev, n_local, G.pos_origin_y);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_pz, pos_z_dev, n_local, G.pos_origin_z);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_vx, vel_x_dev, n_local, 0);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_vy, vel_y_dev, n_local, 0);
+  Copy_Particles_Array_Part_Host_to_Device(dataset_buffer_vz, vel_z_dev, n_local, 0);
       #ifndef SINGLE_PARTICLE_MASS
   Copy_Particles_Array_Real_Host_to_Device(dataset_buffer_m, mass_dev, n_local);
       #endif
@@ -504,8 +819,19 @@ void Grid3D::Write_Particles_Header_HDF5(hid_t file_id)
   attribute_id = H5Acreate(file_id, "dt_particles", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
   status       = H5Awrite(attribute_id, H5T_NATIVE_DOUBLE, &Particles.dt);
   status       = H5Aclose(attribute_id);
-  attribute_id = H5Acreate(file_id, "n_particles_local", H5T_STD_I64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
-  status       = H5Awrite(attribute_id, H5T_NATIVE_LONG, &Particles.n_local);
+
+  // The attributes of the single file are the same on all the ranks, it has the
+  // total number of particles instead
+  part_int_t n_particles       = Particles.n_local;
+  const char *n_particles_name = "n_particles_local";
+    #ifdef MPI_CHOLLA
+  if (Output_Cat_Active()) {
+    n_particles      = ReducePartIntSum(Particles.n_local);
+    n_particles_name = "n_particles_total";
+  }
+    #endif  // MPI_CHOLLA
+  attribute_id = H5Acreate(file_id, n_particles_name, H5T_STD_I64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+  status       = H5Awrite(attribute_id, H5T_NATIVE_LONG, &n_particles);
   status       = H5Aclose(attribute_id);
 
     #ifdef SINGLE_PARTICLE_MASS
@@ -548,16 +874,6 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   output_particle_data = false;
     #endif
 
-    #ifdef PARTICLES_GPU
-  // Copy the device arrays from the device to the host
-  GPU_Error_Check(cudaMemcpy(Particles.G.density, Particles.G.density_dev, Particles.G.n_cells * sizeof(Real),
-                             cudaMemcpyDeviceToHost));
-    #endif  // PARTICLES_GPU
-    #if defined(OUTPUT_POTENTIAL) && defined(ONLY_PARTICLES) && defined(GRAVITY_GPU)
-  GPU_Error_Check(cudaMemcpy(Grav.F.potential_h, Grav.F.potential_d, Grav.n_cells_potential * sizeof(Real),
-                             cudaMemcpyDeviceToHost));
-    #endif  // OUTPUT_POTENTIAL
-
   // Count Current Total Particles
   part_int_t N_particles_total;
     #ifdef MPI_CHOLLA
@@ -587,7 +903,8 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.pos_x[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.pos_x_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.pos_x_dev, dataset_buffer, Particles.n_local,
+                                                     Particles.G.pos_origin_x);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/pos_x", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -600,7 +917,8 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.pos_y[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.pos_y_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.pos_y_dev, dataset_buffer, Particles.n_local,
+                                                     Particles.G.pos_origin_y);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/pos_y", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -613,7 +931,8 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.pos_z[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.pos_z_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.pos_z_dev, dataset_buffer, Particles.n_local,
+                                                     Particles.G.pos_origin_z);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/pos_z", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -626,7 +945,7 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.vel_x[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.vel_x_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.vel_x_dev, dataset_buffer, Particles.n_local, 0);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/vel_x", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -639,7 +958,7 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.vel_y[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.vel_y_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.vel_y_dev, dataset_buffer, Particles.n_local, 0);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/vel_y", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -652,7 +971,7 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   for (i = 0; i < n_local; i++) dataset_buffer[i] = Particles.vel_z[i];
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
-  Particles.Copy_Particles_Array_Real_Device_to_Host(Particles.vel_z_dev, dataset_buffer, Particles.n_local);
+  Particles.Copy_Particles_Array_Part_Device_to_Host(Particles.vel_z_dev, dataset_buffer, Particles.n_local, 0);
     #endif  // PARTICLES_GPU
   if (output_particle_data || H.Output_Complete_Data) {
     dataset_id = H5Dcreate(file_id, "/vel_z", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -699,14 +1018,36 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
   status     = H5Dclose(dataset_id);
     #endif
 
-  // Create a data set for the grid data ( density and potential )
+  H5Sclose(dataspace_id);
+  free(dataset_buffer);
+  Write_Particles_Grid_HDF5(file_id);
+}
+
+/*! \brief Write the grid data of the particles, the density and with
+ * OUTPUT_POTENTIAL and ONLY_PARTICLES the potential */
+void Grid3D::Write_Particles_Grid_HDF5(hid_t file_id)
+{
+  int i, j, k, id, buf_id;
+  hid_t dataspace_id;
+  herr_t status;
+
+    #ifdef PARTICLES_GPU
+  // Copy the device arrays from the device to the host
+  GPU_Error_Check(cudaMemcpy(Particles.G.density, Particles.G.density_dev, Particles.G.n_cells * sizeof(Real),
+                             cudaMemcpyDeviceToHost));
+    #endif  // PARTICLES_GPU
+    #if defined(OUTPUT_POTENTIAL) && defined(ONLY_PARTICLES) && defined(GRAVITY_GPU)
+  GPU_Error_Check(cudaMemcpy(Grav.F.potential_h, Grav.F.potential_d, Grav.n_cells_potential * sizeof(Real),
+                             cudaMemcpyDeviceToHost));
+    #endif  // OUTPUT_POTENTIAL
 
   // 3D case
   int nx_dset = Particles.G.nx_local;
   int ny_dset = Particles.G.ny_local;
   int nz_dset = Particles.G.nz_local;
   hsize_t dims3d[3];
-  dataset_buffer = (Real *)malloc(Particles.G.nz_local * Particles.G.ny_local * Particles.G.nx_local * sizeof(Real));
+  Real *dataset_buffer =
+      (Real *)malloc(Particles.G.nz_local * Particles.G.ny_local * Particles.G.nx_local * sizeof(Real));
 
   // Create the data space for the datasets
   dims3d[0]    = nx_dset;
@@ -727,9 +1068,7 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
     }
   }
 
-  dataset_id = H5Dcreate(file_id, "/density", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-  status     = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer);
-  status     = H5Dclose(dataset_id);
+  status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer, "/density");
 
     #if defined(OUTPUT_POTENTIAL) && defined(ONLY_PARTICLES)
   // Copy the potential array to the memory buffer
@@ -744,15 +1083,194 @@ void Grid3D::Write_Particles_Data_HDF5(hid_t file_id)
       }
     }
   }
-  dataset_id =
-      H5Dcreate(file_id, "/grav_potential", H5T_IEEE_F64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-  status = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset_buffer);
-  status = H5Dclose(dataset_id);
+  status = Write_HDF5_Dataset(file_id, dataspace_id, dataset_buffer, "/grav_potential");
     #endif  // OUTPUT_POTENTIAL
 
+  H5Sclose(dataspace_id);
   free(dataset_buffer);
 }
-  #endif  // HDF5
+
+    #ifdef MPI_CHOLLA
+// Write the particles of this rank to their slab of a dataset of the particles
+// of all the ranks
+static herr_t Write_Particles_Dataset_Cat(hid_t file_id, const char *name, hid_t file_type, hid_t mem_type,
+                                          const void *buffer, hsize_t n_total, hsize_t offset, hsize_t count)
+{
+  hid_t file_space_id = H5Screate_simple(1, &n_total, NULL);
+  hid_t mem_space_id  = H5Screate_simple(1, &count, NULL);
+  hid_t dcpl_id       = H5Pcreate(H5P_DATASET_CREATE);
+  // The filters need chunks, which an empty dataset can't have
+  if (n_total > 0) {
+    Set_Output_Compression_HDF5(dcpl_id, name, file_type, 1, &n_total);
+  }
+  hid_t dataset_id = H5Dcreate(file_id, name, file_type, file_space_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+
+  if (count > 0) {
+    H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &offset, NULL, &count, NULL);
+  } else {
+    H5Sselect_none(file_space_id);
+  }
+  hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+      #ifdef H5_HAVE_PARALLEL
+  H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+      #endif  // H5_HAVE_PARALLEL
+  herr_t status = H5Dwrite(dataset_id, mem_type, mem_space_id, file_space_id, dxpl_id, buffer);
+
+  H5Pclose(dxpl_id);
+  H5Dclose(dataset_id);
+  H5Pclose(dcpl_id);
+  H5Sclose(mem_space_id);
+  H5Sclose(file_space_id);
+  return status;
+}
+
+/*! \brief Write the particle snapshot nfile of all the ranks to a single file
+ * with collective parallel HDF5. The particles of each rank are a contiguous
+ * slab of the datasets after the particles of the lower ranks, and
+ * n_particles_rank has the number of particles of every rank for
+ * Load_Particles_Data_Cat */
+void Grid3D::Output_Particles_Data_Cat(struct Parameters P, int nfile)
+{
+      #ifdef H5_HAVE_PARALLEL
+  ScopedTimer timer("Output_Particles_Data_Cat");
+  std::string const filename = FnameTemplate(P).format_cat_fname(nfile, "_particles");
+  hid_t file_id              = Open_Output_File_Cat(*this, P, filename);
+
+  Write_Header_HDF5(file_id);
+  Write_Particles_Header_HDF5(file_id);
+
+  // Offsets of the slabs of the ranks
+  part_int_t const n_local = Particles.n_local;
+  part_int_t offset        = 0;
+  MPI_Exscan(&n_local, &offset, 1, MPI_PART_INT, MPI_SUM, world);
+  if (procID == 0) {
+    offset = 0;
+  }
+  part_int_t const n_total = ReducePartIntSum(n_local);
+  chprintf(" Total Particles: %ld\n", n_total);
+  if (n_total != Particles.n_total_initial) {
+    chprintf(" WARNING: Lost Particles: %d \n", Particles.n_total_initial - n_total);
+  }
+
+  herr_t status = Write_Particles_Dataset_Cat(file_id, "/n_particles_rank", H5T_STD_I64LE, H5T_NATIVE_LONG, &n_local,
+                                              nproc, procID, 1);
+
+  // Pointers to the fields of the local particles
+  Real_Part const *position[3], *velocity[3];
+  Real const *mass     = nullptr, *age = nullptr;
+  part_int_t const *ids = nullptr;
+  Real origin[3]        = {0, 0, 0};
+        #ifdef PARTICLES_CPU
+  position[0] = Particles.pos_x.data();
+  position[1] = Particles.pos_y.data();
+  position[2] = Particles.pos_z.data();
+  velocity[0] = Particles.vel_x.data();
+  velocity[1] = Particles.vel_y.data();
+  velocity[2] = Particles.vel_z.data();
+          #ifndef SINGLE_PARTICLE_MASS
+  mass = Particles.mass.data();
+          #endif
+          #ifdef PARTICLE_IDS
+  ids = Particles.partIDs.data();
+          #endif
+          #ifdef PARTICLE_AGE
+  age = Particles.age.data();
+          #endif
+        #endif  // PARTICLES_CPU
+
+        #ifdef PARTICLES_GPU
+  // Queue the copies of all the fields to pinned buffers and wait for them
+  // once, instead of a blocking copy per field
+  size_t const n_staged        = std::max(n_local, part_int_t(1));
+  Real_Part *part_staged       = nullptr;
+  Real *real_staged            = nullptr;
+  part_int_t *ids_staged       = nullptr;
+  Real_Part *const part_dev[6] = {Particles.pos_x_dev, Particles.pos_y_dev, Particles.pos_z_dev,
+                                  Particles.vel_x_dev, Particles.vel_y_dev, Particles.vel_z_dev};
+  GPU_Error_Check(cudaHostAlloc(&part_staged, 6 * n_staged * sizeof(Real_Part), cudaHostAllocDefault));
+  for (int field = 0; field < 6; field++) {
+    GPU_Error_Check(cudaMemcpyAsync(part_staged + field * n_local, part_dev[field], n_local * sizeof(Real_Part),
+                                    cudaMemcpyDeviceToHost, 0));
+  }
+  for (int dir = 0; dir < 3; dir++) {
+    position[dir] = part_staged + dir * n_local;
+    velocity[dir] = part_staged + (3 + dir) * n_local;
+  }
+  origin[0] = Particles.G.pos_origin_x;
+  origin[1] = Particles.G.pos_origin_y;
+  origin[2] = Particles.G.pos_origin_z;
+  GPU_Error_Check(cudaHostAlloc(&real_staged, 2 * n_staged * sizeof(Real), cudaHostAllocDefault));
+          #ifndef SINGLE_PARTICLE_MASS
+  GPU_Error_Check(
+      cudaMemcpyAsync(real_staged, Particles.mass_dev, n_local * sizeof(Real), cudaMemcpyDeviceToHost, 0));
+  mass = real_staged;
+          #endif
+          #ifdef PARTICLE_AGE
+  GPU_Error_Check(cudaMemcpyAsync(real_staged + n_local, Particles.age_dev, n_local * sizeof(Real),
+                                  cudaMemcpyDeviceToHost, 0));
+  age = real_staged + n_local;
+          #endif
+          #ifdef PARTICLE_IDS
+  GPU_Error_Check(cudaHostAlloc(&ids_staged, n_staged * sizeof(part_int_t), cudaHostAllocDefault));
+  GPU_Error_Check(cudaMemcpyAsync(ids_staged, Particles.partIDs_dev, n_local * sizeof(part_int_t),
+                                  cudaMemcpyDeviceToHost, 0));
+  ids = ids_staged;
+          #endif
+  GPU_Error_Check(cudaStreamSynchronize(0));
+        #endif  // PARTICLES_GPU
+
+        #ifdef OUTPUT_PARTICLES_DATA
+  bool const output_particle_data = true;
+        #else
+  bool const output_particle_data = H.Output_Complete_Data;
+        #endif
+  if (output_particle_data) {
+    // The positions are relative to the origin of the local domain with
+    // PARTICLES_COMPACT, the file has the global ones
+    hid_t const part_type         = sizeof(Real_Part) == sizeof(float) ? H5T_NATIVE_FLOAT : H5T_NATIVE_DOUBLE;
+    hid_t const position_type     = P.output_cat_particles_float32 ? H5T_IEEE_F32BE : H5T_IEEE_F64BE;
+    const char *position_names[3] = {"/pos_x", "/pos_y", "/pos_z"};
+    const char *velocity_names[3] = {"/vel_x", "/vel_y", "/vel_z"};
+    std::vector<Real> global_position(n_local);
+    for (int dir = 0; dir < 3; dir++) {
+      for (part_int_t i = 0; i < n_local; i++) {
+        global_position[i] = Real(position[dir][i]) + origin[dir];
+      }
+      status = Write_Particles_Dataset_Cat(file_id, position_names[dir], position_type, H5T_NATIVE_DOUBLE,
+                                           global_position.data(), n_total, offset, n_local);
+      status = Write_Particles_Dataset_Cat(file_id, velocity_names[dir], H5T_IEEE_F64BE, part_type, velocity[dir],
+                                           n_total, offset, n_local);
+    }
+  }
+        #ifndef SINGLE_PARTICLE_MASS
+  status =
+      Write_Particles_Dataset_Cat(file_id, "/mass", H5T_IEEE_F64BE, H5T_NATIVE_DOUBLE, mass, n_total, offset, n_local);
+        #endif
+        #ifdef PARTICLE_IDS
+  status = Write_Particles_Dataset_Cat(file_id, "/particle_IDs", H5T_STD_I64LE, H5T_NATIVE_LONG, ids, n_total, offset,
+                                       n_local);
+        #endif
+        #ifdef PARTICLE_AGE
+  status =
+      Write_Particles_Dataset_Cat(file_id, "/age", H5T_IEEE_F64BE, H5T_NATIVE_DOUBLE, age, n_total, offset, n_local);
+        #endif
+
+        #ifdef PARTICLES_GPU
+  GPU_Error_Check(cudaFreeHost(part_staged));
+  GPU_Error_Check(cudaFreeHost(real_staged));
+  if (ids_staged != nullptr) {
+    GPU_Error_Check(cudaFreeHost(ids_staged));
+  }
+        #endif  // PARTICLES_GPU
+
+  Write_Particles_Grid_HDF5(file_id);
+  Close_Output_File_Cat(file_id, filename);
+      #else
+  CHOLLA_ERROR("output_cat needs an HDF5 library built with parallel support");
+      #endif  // H5_HAVE_PARALLEL
+}
+    #endif  // MPI_CHOLLA
+  #endif    // HDF5
 
 void Grid3D::OutputData_Particles(struct Parameters P, int nfile)
 {
@@ -765,11 +1283,20 @@ void Grid3D::OutputData_Particles(struct Parameters P, int nfile)
   #endif
 
   #if defined HDF5
+    #ifdef MPI_CHOLLA
+  // All the ranks write a single file
+  if (P.output_cat) {
+    Output_Particles_Data_Cat(P, nfile);
+    return;
+  }
+    #endif  // MPI_CHOLLA
   hid_t file_id;
   herr_t status;
 
-  // Create a new file collectively
-  file_id = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  // Create a new file collectively, with room for the positions, velocities
+  // and a few more fields of the local particles
+  size_t const size_hint = size_t(Particles.n_local) * 8 * sizeof(Real);
+  file_id                = Create_Output_File_HDF5(filename, size_hint);
 
   // Write header (file attributes)
   Write_Header_HDF5(file_id);
@@ -777,8 +1304,82 @@ void Grid3D::OutputData_Particles(struct Parameters P, int nfile)
   Write_Particles_Data_HDF5(file_id);
 
   // Close the file
-  status = H5Fclose(file_id);
+  status = Close_Output_File_HDF5(file_id, filename, nfile);
   #endif
 }
 
+  #ifdef HDF5
+/*! \brief Write the particles of the subset of particles_subset_fraction and
+ * particles_subset_boxes to the file <nfile>_particles_subset.h5 of each
+ * process. With PARTICLES_GPU the selection runs on the device, so only the
+ * subset is copied to the host */
+void Grid3D::Output_Particles_Subset(struct Parameters P, int nfile)
+{
+  ParticleSubset const subset = Parse_Particle_Subset(P);
+  std::vector<Real> fields;
+  std::vector<part_int_t> ids;
+    #ifdef PARTICLES_GPU
+  part_int_t const n_selected = Select_Particle_Subset_GPU(Particles, subset, fields, ids);
+    #else
+  part_int_t const n_selected = Select_Particle_Subset_CPU(Particles, subset, fields, ids);
+    #endif  // PARTICLES_GPU
+  part_int_t n_subset_total = n_selected;
+    #ifdef MPI_CHOLLA
+  n_subset_total = ReducePartIntSum(n_selected);
+    #endif  // MPI_CHOLLA
+  chprintf(" Particles in the subset: %ld\n", n_subset_total);
+
+  std::string filename   = FnameTemplate(P).format_fname(nfile, "_particles_subset");
+  size_t const size_hint = fields.size() * sizeof(Real) + ids.size() * sizeof(part_int_t);
+  hid_t file_id          = Create_Output_File_HDF5(filename, size_hint);
+  herr_t status;
+
+  // The header of the grid, then the particle time, the selection and the
+  // number of particles in this file
+  Write_Header_HDF5(file_id);
+  hsize_t attr_dims  = 1;
+  hid_t dataspace_id = H5Screate_simple(1, &attr_dims, NULL);
+  double t_particles = Particles.t;
+  double fraction    = subset.fraction;
+  int n_boxes        = subset.n_boxes;
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &t_particles, "t_particles");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &fraction, "subset_fraction");
+  status             = Write_HDF5_Attribute(file_id, dataspace_id, &n_boxes, "subset_n_boxes");
+  hid_t attribute_id = H5Acreate(file_id, "n_particles_local", H5T_STD_I64BE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+  long n_particles   = n_selected;
+  status             = H5Awrite(attribute_id, H5T_NATIVE_LONG, &n_particles);
+  status             = H5Aclose(attribute_id);
+    #ifdef SINGLE_PARTICLE_MASS
+  double particle_mass = Particles.particle_mass;
+  status               = Write_HDF5_Attribute(file_id, dataspace_id, &particle_mass, "particle_mass");
+    #endif  // SINGLE_PARTICLE_MASS
+  status = H5Sclose(dataspace_id);
+
+  std::vector<char const *> field_names = {"pos_x", "pos_y", "pos_z", "vel_x", "vel_y", "vel_z"};
+    #ifndef SINGLE_PARTICLE_MASS
+  field_names.push_back("mass");
+    #endif  // SINGLE_PARTICLE_MASS
+    #ifdef PARTICLE_AGE
+  field_names.push_back("age");
+    #endif  // PARTICLE_AGE
+  hsize_t dims[1] = {hsize_t(n_selected)};
+  dataspace_id    = H5Screate_simple(1, dims, NULL);
+  for (int field = 0; field < N_PARTICLE_SUBSET_FIELDS; field++) {
+    status = Write_HDF5_Dataset(file_id, dataspace_id, fields.data() + field * n_selected, field_names[field]);
+  }
+    #ifdef PARTICLE_IDS
+  hid_t dataset_id = H5Dcreate(file_id, "/particle_IDs", H5T_STD_I64LE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT,
+                               H5P_DEFAULT);
+  status           = H5Dwrite(dataset_id, H5T_NATIVE_LONG, H5S_ALL, H5S_ALL, H5P_DEFAULT, ids.data());
+  status           = H5Dclose(dataset_id);
+    #endif  // PARTICLE_IDS
+  status = H5Sclose(dataspace_id);
+
+  status = Close_Output_File_HDF5(file_id, filename, nfile);
+  if (status < 0) {
+    CHOLLA_ERROR("Writing the particle subset file %s failed", filename.c_str());
+  }
+}
+  #endif  // HDF5
+
 #endif
@@ -64,6 +64,10 @@ void Particles3D::Initialize(struct Parameters *P, Grav3D &Grav, Real xbound, Re
 
   // Courant CFL condition factor for particles
   C_cfl = 0.3;
+  #ifdef PARTICLES_GPU
+  max_dti       = 0;
+  order_version = 0;
+  #endif
 
   #ifndef SINGLE_PARTICLE_MASS
   particle_mass = 0;  // The particle masses are stored in a separate array
@@ -168,14 +172,27 @@ void Particles3D::Initialize(struct Parameters *P, Grav3D &Grav, Real xbound, Re
   #ifdef PARTICLES_GPU
     // Factor to allocate the particles data arrays on the GPU.
     // When using MPI particles will be transferred to other GPU, for that
-    // reason we need extra memory allocated
+    // reason we need extra memory allocated. The arrays grow by at least
+    // gpu_growth_factor when they are full, so the headroom can stay small
     #ifdef MPI_CHOLLA
-  G.gpu_allocation_factor = 1.25;
+  G.gpu_allocation_factor = 1.1;
     #else
   G.gpu_allocation_factor = 1.0;
     #endif
+  G.gpu_growth_factor = 2.0;
+  n_local_peak        = 0;
+
+  // Origin of the positions stored on the device
+    #ifdef PARTICLES_COMPACT
+  G.pos_origin_x = G.xMin;
+  G.pos_origin_y = G.yMin;
+  G.pos_origin_z = G.zMin;
+    #else
+  G.pos_origin_x = 0;
+  G.pos_origin_y = 0;
+  G.pos_origin_z = 0;
+    #endif  // PARTICLES_COMPACT
 
-  G.size_blocks_array = 1024 * 128;
   G.n_cells_potential = (G.nx_local + 2 * N_GHOST_POTENTIAL) * (G.ny_local + 2 * N_GHOST_POTENTIAL) *
                         (G.nz_local + 2 * N_GHOST_POTENTIAL);
 
@@ -183,6 +200,28 @@ void Particles3D::Initialize(struct Parameters *P, Grav3D &Grav, Real xbound, Re
   mass_dev = NULL;  // This array won't be used
     #endif
 
+  // The sorting arrays are allocated the first time the particles are sorted
+  particle_sort_interval = P->particle_sort_interval;
+  sort_array_size        = 0;
+  sort_keys_dev[0] = sort_keys_dev[1] = NULL;
+  sort_indices_dev[0] = sort_indices_dev[1] = NULL;
+  sort_real_dev                             = NULL;
+    #ifdef PARTICLES_COMPACT
+  sort_part_dev = NULL;
+    #endif
+    #ifdef PARTICLE_IDS
+  sort_ids_dev = NULL;
+    #endif
+  sort_temp_dev   = NULL;
+  sort_temp_bytes = 0;
+
+    #ifdef PARTICLES_P3M
+  Initialize_P3M_GPU(P);
+    #endif
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  Initialize_Block_Timesteps_GPU(P);
+    #endif
+
   #endif  // PARTICLES_GPU
 
   // Flags for Initial and tranfer the particles and density
@@ -200,8 +239,12 @@ void Particles3D::Initialize(struct Parameters *P, Grav3D &Grav, Real xbound, Re
     Initialize_Sphere(P);
   } else if (strcmp(P->init, "Zeldovich_Pancake") == 0) {
     Initialize_Zeldovich_Pancake(P);
-  } else if (strcmp(P->init, "Read_Grid") == 0) {
+  } else if (strcmp(P->init, "Read_Grid") == 0 || strcmp(P->init, "Read_Grid_Cat") == 0) {
     Load_Particles_Data(P);
+  #if defined(PARTICLES_GPU) && defined(COSMOLOGY)
+  } else if (strcmp(P->init, "Synthetic_Cosmology") == 0) {
+    Initialize_Synthetic_Cosmology(P);
+  #endif
   #if defined(PARTICLE_AGE) && !defined(SINGLE_PARTICLE_MASS) && defined(PARTICLE_IDS)
   } else if (strcmp(P->init, "Disk_3D_particles") == 0) {
     Initialize_Disk_Stellar_Clusters(P);
@@ -287,7 +330,6 @@ void Particles3D::Allocate_Memory(void)
 
   #ifdef PARTICLES_GPU
   Allocate_Memory_GPU();
-  G.dti_array_host = (Real *)malloc(G.size_blocks_array * sizeof(Real));
   #endif
 }
 
@@ -300,10 +342,18 @@ void Particles3D::Allocate_Memory_GPU()
   Allocate_Particles_Grid_Field_Real(&G.gravity_x_dev, G.n_cells);
   Allocate_Particles_Grid_Field_Real(&G.gravity_y_dev, G.n_cells);
   Allocate_Particles_Grid_Field_Real(&G.gravity_z_dev, G.n_cells);
-  Allocate_Particles_Grid_Field_Real(&G.dti_array_dev, G.size_blocks_array);
     #ifndef GRAVITY_GPU
   Allocate_Particles_Grid_Field_Real(&G.potential_dev, G.n_cells_potential);
     #endif
+    #ifdef PARTICLES_CIC_TILES
+  // The CIC base cells go from 0 to nx_local including the ghost cell
+  G.n_cic_tiles_x   = (G.nx_local + CIC_TILE_SIZE) / CIC_TILE_SIZE;
+  G.n_cic_tiles_y   = (G.ny_local + CIC_TILE_SIZE) / CIC_TILE_SIZE;
+  G.n_cic_tiles_z   = (G.nz_local + CIC_TILE_SIZE) / CIC_TILE_SIZE;
+  int const n_tiles = G.n_cic_tiles_x * G.n_cic_tiles_y * G.n_cic_tiles_z;
+  Allocate_Particles_GPU_Array_int(&G.cic_tile_start_dev, n_tiles);
+  Allocate_Particles_GPU_Array_int(&G.cic_tile_end_dev, n_tiles);
+    #endif  // PARTICLES_CIC_TILES
   chprintf(" Allocated GPU memory.\n");
 }
 
@@ -313,6 +363,36 @@ part_int_t Particles3D::Compute_Particles_GPU_Array_Size(part_int_t n)
   return buffer_size;
 }
 
+// Allocate the device arrays of the particles with room for n_particles and
+// the growth of Compute_Particles_GPU_Array_Size
+void Particles3D::Allocate_Particles_Arrays_GPU(part_int_t n_particles)
+{
+  particles_array_size = Compute_Particles_GPU_Array_Size(n_particles);
+  chprintf(" Allocating GPU buffer size: %ld * %f = %ld \n", n_particles, G.gpu_allocation_factor,
+           particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_x_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_y_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_z_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_x_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_y_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_z_dev, particles_array_size);
+      #ifndef PARTICLES_KDK_FUSED
+  Allocate_Particles_GPU_Array_Real(&grav_x_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Real(&grav_y_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Real(&grav_z_dev, particles_array_size);
+      #endif
+      #ifndef SINGLE_PARTICLE_MASS
+  Allocate_Particles_GPU_Array_Real(&mass_dev, particles_array_size);
+      #endif
+      #ifdef PARTICLE_IDS
+  Allocate_Particles_GPU_Array_Part_Int(&partIDs_dev, particles_array_size);
+      #endif
+      #ifdef PARTICLE_AGE
+  Allocate_Particles_GPU_Array_Real(&age_dev, particles_array_size);
+      #endif
+  chprintf(" Allocated GPU memory for particle data\n");
+}
+
     #ifdef MPI_CHOLLA
 
 void Particles3D::ReAllocate_Memory_GPU_MPI()
@@ -321,36 +401,29 @@ void Particles3D::ReAllocate_Memory_GPU_MPI()
   Free_GPU_Array_bool(G.transfer_particles_flags_d);
   Free_GPU_Array_int(G.transfer_particles_indices_d);
   Free_GPU_Array_int(G.replace_particles_indices_d);
-  Free_GPU_Array_int(G.transfer_particles_prefix_sum_d);
-  Free_GPU_Array_int(G.transfer_particles_prefix_sum_blocks_d);
 
   // Allocate new resized arrays for the particles MPI transfers
-  part_int_t buffer_size, half_blocks_size;
-  buffer_size      = particles_array_size;
-  half_blocks_size = ((buffer_size - 1) / 2) / TPB_PARTICLES + 1;
+  part_int_t buffer_size = particles_array_size;
   Allocate_Particles_GPU_Array_bool(&G.transfer_particles_flags_d, buffer_size);
   Allocate_Particles_GPU_Array_int(&G.transfer_particles_indices_d, buffer_size);
   Allocate_Particles_GPU_Array_int(&G.replace_particles_indices_d, buffer_size);
-  Allocate_Particles_GPU_Array_int(&G.transfer_particles_prefix_sum_d, buffer_size);
-  Allocate_Particles_GPU_Array_int(&G.transfer_particles_prefix_sum_blocks_d, half_blocks_size);
   printf(" New allocation of arrays for particles transfers   new_size: %d \n", (int)buffer_size);
 }
 
 void Particles3D::Allocate_Memory_GPU_MPI()
 {
   // Allocate memory for the the particles MPI transfers
-  part_int_t buffer_size, half_blocks_size;
-
-  buffer_size      = Compute_Particles_GPU_Array_Size(n_local);
-  half_blocks_size = ((buffer_size - 1) / 2) / TPB_PARTICLES + 1;
+  part_int_t buffer_size = Compute_Particles_GPU_Array_Size(n_local);
 
   Allocate_Particles_GPU_Array_bool(&G.transfer_particles_flags_d, buffer_size);
   Allocate_Particles_GPU_Array_int(&G.transfer_particles_indices_d, buffer_size);
   Allocate_Particles_GPU_Array_int(&G.replace_particles_indices_d, buffer_size);
-  Allocate_Particles_GPU_Array_int(&G.transfer_particles_prefix_sum_d, buffer_size);
-  Allocate_Particles_GPU_Array_int(&G.transfer_particles_prefix_sum_blocks_d, half_blocks_size);
   Allocate_Particles_GPU_Array_int(&G.n_transfer_d, 1);
 
+  // The temporary storage of the partition is allocated on the first transfer
+  G.transfer_temp_d     = NULL;
+  G.transfer_temp_bytes = 0;
+
   G.n_transfer_h = (int *)malloc(sizeof(int));
 
   // Used the global particles send/recv buffers that already have been
@@ -391,21 +464,26 @@ void Particles3D::Free_Memory_GPU()
   Free_GPU_Array_Real(G.gravity_x_dev);
   Free_GPU_Array_Real(G.gravity_y_dev);
   Free_GPU_Array_Real(G.gravity_z_dev);
-  Free_GPU_Array_Real(G.dti_array_dev);
 
     #ifndef GRAVITY_GPU
   Free_GPU_Array_Real(G.potential_dev);
     #endif
+    #ifdef PARTICLES_CIC_TILES
+  Free_GPU_Array_int(G.cic_tile_start_dev);
+  Free_GPU_Array_int(G.cic_tile_end_dev);
+    #endif
 
-  Free_GPU_Array_Real(pos_x_dev);
-  Free_GPU_Array_Real(pos_y_dev);
-  Free_GPU_Array_Real(pos_z_dev);
-  Free_GPU_Array_Real(vel_x_dev);
-  Free_GPU_Array_Real(vel_y_dev);
-  Free_GPU_Array_Real(vel_z_dev);
+  Free_GPU_Array(pos_x_dev);
+  Free_GPU_Array(pos_y_dev);
+  Free_GPU_Array(pos_z_dev);
+  Free_GPU_Array(vel_x_dev);
+  Free_GPU_Array(vel_y_dev);
+  Free_GPU_Array(vel_z_dev);
+    #ifndef PARTICLES_KDK_FUSED
   Free_GPU_Array_Real(grav_x_dev);
   Free_GPU_Array_Real(grav_y_dev);
   Free_GPU_Array_Real(grav_z_dev);
+    #endif
     #ifdef PARTICLE_IDS
   Free_GPU_Array(partIDs_dev);
     #endif
@@ -415,14 +493,20 @@ void Particles3D::Free_Memory_GPU()
     #ifndef SINGLE_PARTICLE_MASS
   Free_GPU_Array_Real(mass_dev);
     #endif
+  Free_Sort_Arrays_GPU();
+    #ifdef PARTICLES_P3M
+  Free_P3M_GPU();
+    #endif
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  Free_Block_Timesteps_GPU();
+    #endif
 
     #ifdef MPI_CHOLLA
   Free_GPU_Array_bool(G.transfer_particles_flags_d);
-  Free_GPU_Array_int(G.transfer_particles_prefix_sum_d);
-  Free_GPU_Array_int(G.transfer_particles_prefix_sum_blocks_d);
   Free_GPU_Array_int(G.transfer_particles_indices_d);
   Free_GPU_Array_int(G.replace_particles_indices_d);
   Free_GPU_Array_int(G.n_transfer_d);
+  Free_GPU_Array(G.transfer_temp_d);
   free(G.n_transfer_h);
 
   Free_GPU_Array_Real(G.send_buffer_x0_d);
@@ -488,15 +572,17 @@ void Particles3D::Initialize_Sphere(struct Parameters *P)
   #ifdef PARTICLES_GPU
   // Alocate memory in GPU for particle data
   particles_array_size = Compute_Particles_GPU_Array_Size(n_particles_local);
-  Allocate_Particles_GPU_Array_Real(&pos_x_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&pos_y_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&pos_z_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_x_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_y_dev, particles_array_size);
-  Allocate_Particles_GPU_Array_Real(&vel_z_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_x_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_y_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&pos_z_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_x_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_y_dev, particles_array_size);
+  Allocate_Particles_GPU_Array_Part(&vel_z_dev, particles_array_size);
+    #ifndef PARTICLES_KDK_FUSED
   Allocate_Particles_GPU_Array_Real(&grav_x_dev, particles_array_size);
   Allocate_Particles_GPU_Array_Real(&grav_y_dev, particles_array_size);
   Allocate_Particles_GPU_Array_Real(&grav_z_dev, particles_array_size);
+    #endif
     #ifndef SINGLE_PARTICLE_MASS
   Allocate_Particles_GPU_Array_Real(&mass_dev, particles_array_size);
     #endif
@@ -603,12 +689,12 @@ void Particles3D::Initialize_Sphere(struct Parameters *P)
 
   #ifdef PARTICLES_GPU
   // Copyt the particle data from tepmpotal Host buffer to GPU memory
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_x, pos_x_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_y, pos_y_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_z, pos_z_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_x, vel_x_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_y, vel_y_dev, n_local);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_z, vel_z_dev, n_local);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_x, pos_x_dev, n_local, G.pos_origin_x);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_y, pos_y_dev, n_local, G.pos_origin_y);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_z, pos_z_dev, n_local, G.pos_origin_z);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_x, vel_x_dev, n_local, 0);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_y, vel_y_dev, n_local, 0);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_z, vel_z_dev, n_local, 0);
     #ifndef SINGLE_PARTICLE_MASS
   Copy_Particles_Array_Real_Host_to_Device(temp_mass, mass_dev, n_local);
     #endif
@@ -759,24 +845,26 @@ void Particles3D::Initialize_Disk_Stellar_Clusters(struct Parameters *P)
 
     #ifdef PARTICLES_GPU
   particles_array_size = Compute_Particles_GPU_Array_Size(n_local);
-  Allocate_Particles_GPU_Array_Real(&pos_x_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_x.data(), pos_x_dev, n_local);
-  Allocate_Particles_GPU_Array_Real(&pos_y_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_y.data(), pos_y_dev, n_local);
-  Allocate_Particles_GPU_Array_Real(&pos_z_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_pos_z.data(), pos_z_dev, n_local);
-  Allocate_Particles_GPU_Array_Real(&vel_x_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_x.data(), vel_x_dev, n_local);
-  Allocate_Particles_GPU_Array_Real(&vel_y_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_y.data(), vel_y_dev, n_local);
-  Allocate_Particles_GPU_Array_Real(&vel_z_dev, particles_array_size);
-  Copy_Particles_Array_Real_Host_to_Device(temp_vel_z.data(), vel_z_dev, n_local);
+  Allocate_Particles_GPU_Array_Part(&pos_x_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_x.data(), pos_x_dev, n_local, G.pos_origin_x);
+  Allocate_Particles_GPU_Array_Part(&pos_y_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_y.data(), pos_y_dev, n_local, G.pos_origin_y);
+  Allocate_Particles_GPU_Array_Part(&pos_z_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_pos_z.data(), pos_z_dev, n_local, G.pos_origin_z);
+  Allocate_Particles_GPU_Array_Part(&vel_x_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_x.data(), vel_x_dev, n_local, 0);
+  Allocate_Particles_GPU_Array_Part(&vel_y_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_y.data(), vel_y_dev, n_local, 0);
+  Allocate_Particles_GPU_Array_Part(&vel_z_dev, particles_array_size);
+  Copy_Particles_Array_Part_Host_to_Device(temp_vel_z.data(), vel_z_dev, n_local, 0);
+      #ifndef PARTICLES_KDK_FUSED
   Allocate_Particles_GPU_Array_Real(&grav_x_dev, particles_array_size);
   Copy_Particles_Array_Real_Host_to_Device(temp_grav_x.data(), grav_x_dev, n_local);
   Allocate_Particles_GPU_Array_Real(&grav_y_dev, particles_array_size);
   Copy_Particles_Array_Real_Host_to_Device(temp_grav_y.data(), grav_y_dev, n_local);
   Allocate_Particles_GPU_Array_Real(&grav_z_dev, particles_array_size);
   Copy_Particles_Array_Real_Host_to_Device(temp_grav_z.data(), grav_z_dev, n_local);
+      #endif
   Allocate_Particles_GPU_Array_Real(&mass_dev, particles_array_size);
   Copy_Particles_Array_Real_Host_to_Device(temp_mass.data(), mass_dev, n_local);
   Allocate_Particles_GPU_Array_Part_Int(&partIDs_dev, particles_array_size);
@@ -905,7 +993,6 @@ void Particles3D::Reset(void)
   Free_Memory();
 
   #ifdef PARTICLES_GPU
-  free(G.dti_array_host);
   Free_Memory_GPU();
   #endif
 }
@@ -12,12 +12,41 @@
 
     #include "../global/global.h"
     #include "../gravity/grav3D.h"
+    #include "../utils/device_memory_pool.h"
+    #include "../utils/gpu.hpp"
 
     #ifdef PARTICLES_GPU
       #define TPB_PARTICLES 1024
       // #define PRINT_GPU_MEMORY
       #define PRINT_MAX_MEMORY_USAGE
-    #endif
+      #ifdef PARTICLES_CIC_TILES
+        // Number of CIC base cells along each side of a deposit tile and the
+        // threads per block depositing one tile
+        #define CIC_TILE_SIZE 8
+        #define TPB_CIC_TILE  256
+      #endif  // PARTICLES_CIC_TILES
+    #endif    // PARTICLES_GPU
+
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+      // Largest number of timestep bins of the particles
+      #define PARTICLES_MAX_TIME_BINS 8
+
+// The kick and the drift of the particles of each time bin at a substep. The
+// velocities go from a_from to a_to as v = (a_from * v + kick * g) / a_to, the
+// comoving momentum of the cosmological KDK, which is v += kick * g with a = 1
+// without COSMOLOGY. The positions then move by drift * v
+struct BlockStepFactors {
+  Real a_from[PARTICLES_MAX_TIME_BINS];
+  Real a_to[PARTICLES_MAX_TIME_BINS];
+  Real kick[PARTICLES_MAX_TIME_BINS];
+  Real drift[PARTICLES_MAX_TIME_BINS];
+};
+    #endif  // PARTICLES_BLOCK_TIMESTEPS
+
+    #if defined(PARTICLES_OMP_DYNAMIC) && !defined(PARTICLES_OMP_CHUNK)
+      // Number of particles handed out to an OpenMP thread at a time
+      #define PARTICLES_OMP_CHUNK 4096
+    #endif  // PARTICLES_OMP_DYNAMIC
 
 /*! \class Part3D
  *  \brief Class to create a set of particles in 3D space. */
@@ -34,6 +63,14 @@ class Particles3D
   Real max_dt;
 
   Real C_cfl;
+    #ifdef PARTICLES_GPU
+  // Maximum inverse timestep of the particles over all the ranks, reduced
+  // together with the hydro one in Grid3D::set_dt
+  Real max_dti;
+  // Incremented every time particles are added, removed or reordered on the
+  // GPU, so that lists of particle indices know when they are out of date
+  unsigned int order_version;
+    #endif
 
   bool INITIAL;
 
@@ -67,6 +104,8 @@ class Particles3D
 
     #ifdef PARTICLES_GPU
   part_int_t particles_array_size;
+  // Largest number of local particles after a transfer
+  part_int_t n_local_peak;
       #ifdef PARTICLE_IDS
   part_int_t *partIDs_dev;
       #endif
@@ -74,15 +113,81 @@ class Particles3D
   Real *age_dev;
       #endif
   Real *mass_dev;
-  Real *pos_x_dev;
-  Real *pos_y_dev;
-  Real *pos_z_dev;
-  Real *vel_x_dev;
-  Real *vel_y_dev;
-  Real *vel_z_dev;
+  Real_Part *pos_x_dev;
+  Real_Part *pos_y_dev;
+  Real_Part *pos_z_dev;
+  Real_Part *vel_x_dev;
+  Real_Part *vel_y_dev;
+  Real_Part *vel_z_dev;
+      #ifndef PARTICLES_KDK_FUSED
+  // The fused kicks interpolate the acceleration instead of storing it
   Real *grav_x_dev;
   Real *grav_y_dev;
   Real *grav_z_dev;
+      #endif
+
+  // Sort the particles by cell every particle_sort_interval steps, 0 disables
+  // the sorting
+  int particle_sort_interval;
+  // Work arrays of the sorting, reallocated when particles_array_size changes
+  part_int_t sort_array_size;
+  int *sort_keys_dev[2];
+  int *sort_indices_dev[2];
+  Real *sort_real_dev;
+      #ifdef PARTICLES_COMPACT
+  Real_Part *sort_part_dev;
+      #endif
+      #ifdef PARTICLE_IDS
+  part_int_t *sort_ids_dev;
+      #endif
+  void *sort_temp_dev;
+  size_t sort_temp_bytes;
+
+      #ifdef PARTICLES_P3M
+  // Particle-particle correction of the PM forces. The local particles and the
+  // halo particles of the neighbors within the cutoff are packed in
+  // p3m_sources_dev as (x, y, z, mass) and sorted by cell into p3m_sorted_dev
+  Real p3m_cutoff;
+  Real p3m_softening;
+  // Rank across each face whose halo particles are needed, -1 if none
+  int p3m_neighbors[6];
+  int p3m_n_sources;
+  int p3m_sources_size;
+  Real *p3m_sources_dev;
+  Real *p3m_sorted_dev;
+  int *p3m_keys_dev[2];
+  int *p3m_indices_dev[2];
+  bool *p3m_flags_dev;
+  int *p3m_n_selected_dev;
+  int p3m_send_size;
+  Real *p3m_send_dev;
+  // Linked list of the cells of the local grid extended by the cutoff
+  int p3m_n_cells;
+  int *p3m_cell_start_dev;
+  int *p3m_cell_end_dev;
+  void *p3m_temp_dev;
+  size_t p3m_temp_bytes;
+        #if defined(MPI_CHOLLA) && !defined(MPI_GPU)
+  std::vector<Real> p3m_send_host;
+  std::vector<Real> p3m_recv_host;
+        #endif
+      #endif  // PARTICLES_P3M
+
+      #ifdef PARTICLES_BLOCK_TIMESTEPS
+  // Power-of-two block timesteps. A particle in time bin k takes 2^k substeps
+  // of the step, with the gravitational field of the start of the step
+  // between them. The bins are assigned at the start of every step and
+  // time_bin_dev moves with the particles until the closing kick
+  int n_time_bins;
+  int *time_bin_dev;
+  part_int_t time_bin_size;
+  // Number of local particles in each bin
+  int time_bin_counts[PARTICLES_MAX_TIME_BINS];
+  int *time_bin_counts_dev;
+  // With particles above bin 0, sort_indices_dev[1] lists the particles by
+  // decreasing bin, so the particles that start a substep are a prefix of it
+  bool time_bin_sorted;
+      #endif  // PARTICLES_BLOCK_TIMESTEPS
 
     #endif  // PARTICLES_GPU
 
@@ -125,6 +230,9 @@ class Particles3D
   int_vector_t out_indxs_vec_z1;
       #endif  // PARTICLES_CPU
 
+  // Boundary flags of the particles transfer in progress
+  int transfer_boundary_flags[6];
+
     #endif  // MPI_CHOLLA
 
   bool TRANSFER_DENSITY_BOUNDARIES;
@@ -137,6 +245,11 @@ class Particles3D
     Real xMin, yMin, zMin;
     Real xMax, yMax, zMax;
     Real dx, dy, dz;
+    #ifdef PARTICLES_GPU
+    // The origin of the positions stored on the device, the lower bound of the
+    // local domain with PARTICLES_COMPACT and zero otherwise
+    Real pos_origin_x, pos_origin_y, pos_origin_z;
+    #endif
 
     Real domainMin_x, domainMax_x;
     Real domainMin_y, domainMax_y;
@@ -150,7 +263,9 @@ class Particles3D
     int n_cells;
     #ifdef PARTICLES_GPU
     Real gpu_allocation_factor;
-    part_int_t size_blocks_array;
+    // Minimum factor by which the arrays and transfer buffers grow when they
+    // are full, so that the reallocations are amortized
+    Real gpu_growth_factor;
     int n_cells_potential;
     #endif
 
@@ -162,6 +277,10 @@ class Particles3D
       #ifdef GRAVITY_GPU
     Real *density_dev;
       #endif
+      #if defined(PARALLEL_OMP) && defined(PARTICLES_OMP_DYNAMIC)
+    // The private density grids of the OpenMP threads
+    std::vector<Real> density_threads;
+      #endif
     #endif
 
     #ifdef PARTICLES_GPU
@@ -170,15 +289,24 @@ class Particles3D
     Real *gravity_x_dev;
     Real *gravity_y_dev;
     Real *gravity_z_dev;
-    Real *dti_array_dev;
-    Real *dti_array_host;
+
+      #ifdef PARTICLES_CIC_TILES
+    // Number of CIC deposit tiles along each direction and the range of
+    // sorted particles of each tile
+    int n_cic_tiles_x;
+    int n_cic_tiles_y;
+    int n_cic_tiles_z;
+    int *cic_tile_start_dev;
+    int *cic_tile_end_dev;
+      #endif  // PARTICLES_CIC_TILES
 
       #ifdef MPI_CHOLLA
     bool *transfer_particles_flags_d;
     int *transfer_particles_indices_d;
     int *replace_particles_indices_d;
-    int *transfer_particles_prefix_sum_d;
-    int *transfer_particles_prefix_sum_blocks_d;
+    // Temporary storage of the partition of the transferred particles
+    void *transfer_temp_d;
+    size_t transfer_temp_bytes;
     int *n_transfer_d;
     int *n_transfer_h;
 
@@ -229,7 +357,7 @@ class Particles3D
   template <typename T>
   void Free_GPU_Array(T *array)
   {
-    cudaFree(array);
+    cuda_utilities::Pool_Free(array);
   }  // TODO remove the Free_GPU_Array_<type> functions
   void Allocate_Memory_GPU();
   void Allocate_Particles_GPU_Array_Real(Real **array_dev, part_int_t size);
@@ -240,6 +368,9 @@ class Particles3D
   void Copy_Particles_Array_Real_Device_to_Host(Real *array_dev, Real *array_host, part_int_t size);
   void Copy_Particles_Array_Int_Host_to_Device(part_int_t *array_host, part_int_t *array_dev, part_int_t size);
   void Copy_Particles_Array_Int_Device_to_Host(part_int_t *array_dev, part_int_t *array_host, part_int_t size);
+  void Allocate_Particles_GPU_Array_Part(Real_Part **array_dev, part_int_t size);
+  void Copy_Particles_Array_Part_Host_to_Device(Real *array_host, Real_Part *array_dev, part_int_t size, Real origin);
+  void Copy_Particles_Array_Part_Device_to_Host(Real_Part *array_dev, Real *array_host, part_int_t size, Real origin);
   void Set_Particles_Array_Real(Real value, Real *array_dev, part_int_t size);
   void Free_Memory_GPU();
   void Initialize_Grid_Values_GPU();
@@ -247,8 +378,8 @@ class Particles3D
   void Get_Density_CIC_GPU_function(part_int_t n_local, Real particle_mass, Real xMin, Real xMax, Real yMin, Real yMax,
                                     Real zMin, Real zMax, Real dx, Real dy, Real dz, int nx_local, int ny_local,
                                     int nz_local, int n_ghost_particles_grid, int n_cells, Real *density_h,
-                                    Real *density_dev, Real *pos_x_dev, Real *pos_y_dev, Real *pos_z_dev,
-                                    Real *mass_dev);
+                                    Real *density_dev, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                    Real_Part *pos_z_dev, Real *mass_dev);
   void Clear_Density_GPU();
   void Clear_Density_GPU_function(Real *density_dev, int n_cells);
   void Copy_Potential_To_GPU(Real *potential_host, Real *potential_dev, int n_cells_potential);
@@ -257,29 +388,43 @@ class Particles3D
                                                 int n_cells_potential, Real dx, Real dy, Real dz, Real *potential_host,
                                                 Real *potential_dev, Real *gravity_x_dev, Real *gravity_y_dev,
                                                 Real *gravity_z_dev);
+      #ifndef PARTICLES_KDK_FUSED
   void Get_Gravity_CIC_GPU();
+      #endif
   void Get_Gravity_CIC_GPU_function(part_int_t n_local, int nx_local, int ny_local, int nz_local,
                                     int n_ghost_particles_grid, Real xMin, Real xMax, Real yMin, Real yMax, Real zMin,
-                                    Real zMax, Real dx, Real dy, Real dz, Real *pos_x_dev, Real *pos_y_dev,
-                                    Real *pos_z_dev, Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev,
-                                    Real *gravity_x_dev, Real *gravity_y_dev, Real *gravity_z_dev);
-  Real Calc_Particles_dt_GPU_function(int ngrid, part_int_t n_local, Real dx, Real dy, Real dz, Real *vel_x_dev,
-                                      Real *vel_y_dev, Real *vel_z_dev, Real *dti_array_host, Real *dti_array_dev);
-  void Advance_Particles_KDK_Step1_GPU_function(part_int_t n_local, Real dt, Real *pos_x_dev, Real *pos_y_dev,
-                                                Real *pos_z_dev, Real *vel_x_dev, Real *vel_y_dev, Real *vel_z_dev,
-                                                Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev);
-  void Advance_Particles_KDK_Step1_Cosmo_GPU_function(part_int_t n_local, Real delta_a, Real *pos_x_dev,
-                                                      Real *pos_y_dev, Real *pos_z_dev, Real *vel_x_dev,
-                                                      Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
-                                                      Real *grav_y_dev, Real *grav_z_dev, Real current_a, Real H0,
-                                                      Real cosmo_h, Real Omega_M, Real Omega_L, Real Omega_K);
-  void Advance_Particles_KDK_Step2_GPU_function(part_int_t n_local, Real dt, Real *vel_x_dev, Real *vel_y_dev,
-                                                Real *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev);
-  void Advance_Particles_KDK_Step2_Cosmo_GPU_function(part_int_t n_local, Real delta_a, Real *vel_x_dev,
-                                                      Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
-                                                      Real *grav_y_dev, Real *grav_z_dev, Real current_a, Real H0,
-                                                      Real cosmo_h, Real Omega_M, Real Omega_L, Real Omega_K);
+                                    Real zMax, Real dx, Real dy, Real dz, Real_Part *pos_x_dev,
+                                    Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real *grav_x_dev, Real *grav_y_dev,
+                                    Real *grav_z_dev, Real *gravity_x_dev, Real *gravity_y_dev, Real *gravity_z_dev);
+  void Calc_Particles_dti_GPU_function(part_int_t n_local, Real dx, Real dy, Real dz, Real_Part *vel_x_dev,
+                                       Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *max_dti_dev);
+  void Advance_Particles_KDK_Step1_GPU_function(part_int_t n_local, Real dt, Real_Part *pos_x_dev,
+                                                Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+                                                Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                Real *grav_y_dev, Real *grav_z_dev, cudaStream_t stream = 0);
+  void Advance_Particles_KDK_Step1_Cosmo_GPU_function(part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                                      Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+                                                      Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                      Real *grav_y_dev, Real *grav_z_dev, Real current_a,
+                                                      Real a_half, Real kick, Real drift, cudaStream_t stream = 0);
+  void Advance_Particles_KDK_Step2_GPU_function(part_int_t n_local, Real dt, Real_Part *vel_x_dev,
+                                                Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                Real *grav_y_dev, Real *grav_z_dev, cudaStream_t stream = 0);
+  void Advance_Particles_KDK_Step2_Cosmo_GPU_function(part_int_t n_local, Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                                      Real_Part *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev,
+                                                      Real *grav_z_dev, Real a_half, Real current_a, Real kick,
+                                                      cudaStream_t stream = 0);
+      #ifdef PARTICLES_KDK_FUSED
+  void Advance_Particles_KDK_Step1_Fused_GPU(Real dt, cudaStream_t stream = 0);
+  void Advance_Particles_KDK_Step2_Fused_GPU(Real dt, cudaStream_t stream = 0);
+        #ifdef COSMOLOGY
+  void Advance_Particles_KDK_Step1_Cosmo_Fused_GPU(Real current_a, Real a_half, Real kick, Real drift,
+                                                   cudaStream_t stream = 0);
+  void Advance_Particles_KDK_Step2_Cosmo_Fused_GPU(Real a_half, Real current_a, Real kick, cudaStream_t stream = 0);
+        #endif  // COSMOLOGY
+      #endif    // PARTICLES_KDK_FUSED
   part_int_t Compute_Particles_GPU_Array_Size(part_int_t n);
+  void Allocate_Particles_Arrays_GPU(part_int_t n_particles);
   int Select_Particles_to_Transfer_GPU(int direction, int side);
   void Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int direction, int side, Real *send_buffer,
                                              int buffer_length);
@@ -287,6 +432,25 @@ class Particles3D
   void Unload_Particles_from_Buffer_GPU(int direction, int side, Real *recv_buffer_h, int n_recv);
   void Copy_Transfer_Particles_from_Buffer_GPU(int n_recv, Real *recv_buffer_d);
   void Set_Particles_Open_Boundary_GPU(int dir, int side);
+  void Reserve_Sort_Arrays_GPU();
+  void Sort_Keys_GPU(int n_keys);
+  void Sort_Particles_GPU();
+  void Free_Sort_Arrays_GPU();
+      #ifdef PARTICLES_P3M
+  void Initialize_P3M_GPU(struct Parameters *P);
+  void Free_P3M_GPU();
+  void Reserve_P3M_Sources_GPU(int n_sources);
+  void Exchange_P3M_Halo_GPU(int direction, int side, Real cutoff);
+  void Add_Short_Range_Forces_GPU(Real Gconst);
+      #endif  // PARTICLES_P3M
+      #ifdef PARTICLES_BLOCK_TIMESTEPS
+  void Initialize_Block_Timesteps_GPU(struct Parameters *P);
+  void Free_Block_Timesteps_GPU();
+  void Assign_Time_Bins_GPU(Real step_dti);
+  part_int_t Count_Active_Particles(int tick);
+  void Advance_Particles_Block_Step_GPU(part_int_t n_active, int *active_dev, BlockStepFactors const &factors,
+                                        cudaStream_t stream = 0);
+      #endif  // PARTICLES_BLOCK_TIMESTEPS
       #ifdef PRINT_MAX_MEMORY_USAGE
   void Print_Max_Memory_Usage();
       #endif
@@ -305,6 +469,10 @@ class Particles3D
 
   void Initialize_Zeldovich_Pancake(struct Parameters *P);
 
+    #if defined(PARTICLES_GPU) && defined(COSMOLOGY)
+  void Initialize_Synthetic_Cosmology(struct Parameters *P);
+    #endif
+
   void Load_Particles_Data(struct Parameters *P);
 
   void Free_Memory();
@@ -313,14 +481,25 @@ class Particles3D
 
   void Clear_Density();
 
+  void Add_Particle_Density_CIC(part_int_t pIndx, Real *density);
+
   void Get_Density_CIC_Serial();
 
     #ifdef HDF5
-  void Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Parameters *P);
+  void Load_Particles_Data_HDF5(hid_t file_id, int nfile, struct Parameters *P, hsize_t const *slab = nullptr);
+  void Load_Particles_Header_HDF5(hid_t file_id);
+      #ifdef MPI_CHOLLA
+  void Load_Particles_Data_Cat(struct Parameters *P);
+  void Load_Particles_Data_Streamed(hid_t file_id, struct Parameters *P);
+  void Append_Loaded_Particles(struct ParticleLoadRecord const *records, int n_records);
+      #endif  // MPI_CHOLLA
     #endif
 
     #ifdef PARALLEL_OMP
   void Get_Density_CIC_OMP();
+      #ifdef PARTICLES_OMP_DYNAMIC
+  void Get_Density_CIC_OMP_Dynamic();
+      #endif
     #endif
 
   void Get_Density_CIC();
@@ -347,6 +526,9 @@ class Particles3D
       #ifdef PARTICLES_GPU
   void Allocate_Memory_GPU_MPI();
   void ReAllocate_Memory_GPU_MPI();
+  void Resize_Particles_Arrays_GPU(part_int_t new_size);
+  void Shrink_Particles_Arrays_GPU();
+  void Grow_Transfer_Buffer_GPU(Real **buffer_d, int *buffer_size, int new_size);
   void Load_Particles_to_Buffer_GPU(int direction, int side, Real *send_buffer, int buffer_length);
       #endif  // PARTICLES_GPU
     #endif
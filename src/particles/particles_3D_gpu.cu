@@ -5,13 +5,16 @@
   #include <stdlib.h>
   #include <unistd.h>
 
+  #include <vector>
+
   #include "../global/global.h"
   #include "../global/global_cuda.h"
   #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
   #include "../utils/gpu.hpp"
   #include "particles_3D.h"
 
-void Particles3D::Free_GPU_Array_Real(Real *array) { cudaFree(array); }
+void Particles3D::Free_GPU_Array_Real(Real *array) { cuda_utilities::Pool_Free(array); }
 
 void Particles3D::Allocate_Particles_Grid_Field_Real(Real **array_dev, int size)
 {
@@ -26,7 +29,8 @@ void Particles3D::Allocate_Particles_Grid_Field_Real(Real **array_dev, int size)
     printf(" Requested Memory: %ld  MB \n", size * sizeof(Real) / 1000000);
     exit(-1);
   }
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(Real));
   cudaDeviceSynchronize();
 }
 
@@ -47,7 +51,7 @@ void Particles3D::Print_Max_Memory_Usage()
   n_local_max  = (part_int_t)ReduceRealMax((Real)n_local);
   n_total      = ReducePartIntSum(n_local);
   fraction_max = (Real)n_local_max / (Real)n_total;
-  mem_usage    = n_local_max * 9 * sizeof(Real);  // Usage for pos, vel ans accel.
+  mem_usage    = n_local_max * (6 * sizeof(Real_Part) + 3 * sizeof(Real));  // Usage for pos, vel ans accel.
 
   global_free_min = ReduceRealMin((Real)global_free);
 
@@ -55,12 +59,19 @@ void Particles3D::Print_Max_Memory_Usage()
       " Particles GPU Memory: N_local_max: %ld  (%.1f %)  mem_usage: %ld MB    "
       " global_free_min: %.1f MB  \n",
       n_local_max, fraction_max * 100, mem_usage / 1000000, global_free_min / 1000000);
+
+  // Peak occupancy of the particle arrays over the run, to size the headroom
+  // of gpu_allocation_factor
+  part_int_t n_local_peak_max = (part_int_t)ReduceRealMax((Real)n_local_peak);
+  part_int_t array_size_max   = (part_int_t)ReduceRealMax((Real)particles_array_size);
+  chprintf(" Particles GPU Arrays: N_local_peak_max: %ld  array_size_max: %ld  (%.1f %%) \n", n_local_peak_max,
+           array_size_max, 100.0 * n_local_peak_max / array_size_max);
 }
 
     #endif
 
-void Particles3D::Free_GPU_Array_int(int *array) { cudaFree(array); }
-void Particles3D::Free_GPU_Array_bool(bool *array) { cudaFree(array); }
+void Particles3D::Free_GPU_Array_int(int *array) { cuda_utilities::Pool_Free(array); }
+void Particles3D::Free_GPU_Array_bool(bool *array) { cuda_utilities::Pool_Free(array); }
 
 template <typename T>
 void __global__ Copy_Device_to_Device_Kernel(T *src_array_dev, T *dst_array_dev, part_int_t size)
@@ -94,7 +105,8 @@ void Particles3D::Allocate_Particles_GPU_Array_Real(Real **array_dev, part_int_t
     printf(" Requested Memory: %ld  MB \n", size * sizeof(Real) / 1000000);
     exit(-1);
   }
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(Real)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(Real));
   cudaDeviceSynchronize();
 }
 
@@ -111,7 +123,8 @@ void Particles3D::Allocate_Particles_GPU_Array_int(int **array_dev, part_int_t s
     printf(" Requested Memory: %ld  MB \n", size * sizeof(int) / 1000000);
     exit(-1);
   }
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(int)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(int));
   cudaDeviceSynchronize();
 }
 
@@ -128,7 +141,8 @@ void Particles3D::Allocate_Particles_GPU_Array_Part_Int(part_int_t **array_dev,
     printf(" Requested Memory: %ld  MB \n", size * sizeof(part_int_t) / 1000000);
     exit(-1);
   }
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(part_int_t)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(part_int_t));
   cudaDeviceSynchronize();
 }
 
@@ -145,7 +159,8 @@ void Particles3D::Allocate_Particles_GPU_Array_bool(bool **array_dev, part_int_t
     printf(" Requested Memory: %ld  MB \n", size * sizeof(bool) / 1000000);
     exit(-1);
   }
-  GPU_Error_Check(cudaMalloc((void **)array_dev, size * sizeof(bool)));
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(bool));
   cudaDeviceSynchronize();
 }
 
@@ -175,6 +190,59 @@ void Particles3D::Copy_Particles_Array_Int_Device_to_Host(part_int_t *array_dev,
   cudaDeviceSynchronize();
 }
 
+void Particles3D::Allocate_Particles_GPU_Array_Part(Real_Part **array_dev, part_int_t size)
+{
+  size_t global_free, global_total;
+  GPU_Error_Check(cudaMemGetInfo(&global_free, &global_total));
+    #ifdef PRINT_GPU_MEMORY
+  chprintf("Allocating GPU Memory:  %ld  MB free \n", global_free / 1000000);
+    #endif
+  if (global_free < size * sizeof(Real_Part)) {
+    printf("ERROR: Not enough global device memory \n");
+    printf(" Available Memory: %ld  MB \n", global_free / 1000000);
+    printf(" Requested Memory: %ld  MB \n", size * sizeof(Real_Part) / 1000000);
+    exit(-1);
+  }
+  cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+  cuda_utilities::Pool_Malloc(array_dev, size * sizeof(Real_Part));
+  cudaDeviceSynchronize();
+}
+
+/*! \brief Copy a position or velocity array to the device, subtracting the
+ * origin of the stored values. Without PARTICLES_COMPACT the origin is zero and
+ * the array is copied as is */
+void Particles3D::Copy_Particles_Array_Part_Host_to_Device(Real *array_host, Real_Part *array_dev, part_int_t size,
+                                                           Real origin)
+{
+    #ifdef PARTICLES_COMPACT
+  std::vector<Real_Part> array_part(size);
+  for (part_int_t i = 0; i < size; i++) {
+    array_part[i] = (Real_Part)(array_host[i] - origin);
+  }
+  GPU_Error_Check(cudaMemcpy(array_dev, array_part.data(), size * sizeof(Real_Part), cudaMemcpyHostToDevice));
+    #else
+  GPU_Error_Check(cudaMemcpy(array_dev, array_host, size * sizeof(Real), cudaMemcpyHostToDevice));
+    #endif  // PARTICLES_COMPACT
+  cudaDeviceSynchronize();
+}
+
+/*! \brief Copy a position or velocity array to the host as Real, adding back
+ * the origin of the stored values */
+void Particles3D::Copy_Particles_Array_Part_Device_to_Host(Real_Part *array_dev, Real *array_host, part_int_t size,
+                                                           Real origin)
+{
+    #ifdef PARTICLES_COMPACT
+  std::vector<Real_Part> array_part(size);
+  GPU_Error_Check(cudaMemcpy(array_part.data(), array_dev, size * sizeof(Real_Part), cudaMemcpyDeviceToHost));
+  for (part_int_t i = 0; i < size; i++) {
+    array_host[i] = (Real)array_part[i] + origin;
+  }
+    #else
+  GPU_Error_Check(cudaMemcpy(array_host, array_dev, size * sizeof(Real), cudaMemcpyDeviceToHost));
+    #endif  // PARTICLES_COMPACT
+  cudaDeviceSynchronize();
+}
+
 __global__ void Set_Particles_Array_Real_Kernel(Real value, Real *array_dev, part_int_t size)
 {
   int tid = blockIdx.x * blockDim.x + threadIdx.x;
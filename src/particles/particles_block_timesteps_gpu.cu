@@ -0,0 +1,210 @@
+#if defined(PARTICLES) && defined(PARTICLES_BLOCK_TIMESTEPS)
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "gravity_CIC_gpu.h"
+  #include "particles_3D.h"
+
+/*! \brief Put each particle in the first bin whose substep is not longer than
+ * its own timestep and count the particles of each bin. step_dti is the
+ * length of the step over the Courant number, so dti * step_dti is the number
+ * of particle timesteps that the step spans */
+__global__ void Assign_Time_Bins_Kernel(part_int_t n_local, Real dx, Real dy, Real dz, Real_Part *vel_x_dev,
+                                        Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real step_dti, int n_time_bins,
+                                        int *time_bin_dev, int *counts_dev)
+{
+  __shared__ int block_counts[PARTICLES_MAX_TIME_BINS];
+  if (threadIdx.x < PARTICLES_MAX_TIME_BINS) {
+    block_counts[threadIdx.x] = 0;
+  }
+  __syncthreads();
+
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid < n_local) {
+    Real dti = fabs(vel_x_dev[tid]) / dx;
+    dti      = fmax(dti, fabs(vel_y_dev[tid]) / dy);
+    dti      = fmax(dti, fabs(vel_z_dev[tid]) / dz);
+
+    Real const n_steps = dti * step_dti;
+    int bin            = 0;
+    while (bin < n_time_bins - 1 && n_steps > Real(1 << bin)) {
+      bin++;
+    }
+    time_bin_dev[tid] = bin;
+    atomicAdd(&block_counts[bin], 1);
+  }
+  __syncthreads();
+
+  // One atomic per bin and block
+  if (threadIdx.x < n_time_bins && block_counts[threadIdx.x] > 0) {
+    atomicAdd(&counts_dev[threadIdx.x], block_counts[threadIdx.x]);
+  }
+}
+
+/*! \brief Sort keys that put the particles of the last bin first */
+__global__ void Get_Time_Bin_Keys_Kernel(part_int_t n_local, int n_time_bins, int *time_bin_dev, int *keys_dev,
+                                         int *indices_dev)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+  keys_dev[tid]    = n_time_bins - 1 - time_bin_dev[tid];
+  indices_dev[tid] = tid;
+}
+
+/*! \brief Kick and drift the particles by the factors of their bin. With
+ * active_dev the first n_active particles it lists are advanced, otherwise
+ * the first n_active particles */
+__global__ void Advance_Particles_Block_Step_Kernel(part_int_t n_active, int *active_dev, int *time_bin_dev,
+                                                    Real_Part *pos_x_dev, Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+                                                    Real_Part *vel_x_dev, Real_Part *vel_y_dev, Real_Part *vel_z_dev,
+                                                    Real *gravity_x_dev, Real *gravity_y_dev, Real *gravity_z_dev,
+                                                    Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax,
+                                                    Real dx, Real dy, Real dz, int nx, int ny, int nz, int n_ghost,
+                                                    BlockStepFactors factors)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_active) {
+    return;
+  }
+  part_int_t const id = (active_dev == nullptr) ? tid : active_dev[tid];
+  int const bin       = time_bin_dev[id];
+
+  Real const pos_x = pos_x_dev[id];
+  Real const pos_y = pos_y_dev[id];
+  Real const pos_z = pos_z_dev[id];
+
+  // The particles that drifted out of the local domain during the substeps
+  // are not accelerated until they are transferred
+  Real g_x = 0, g_y = 0, g_z = 0;
+  if (pos_x >= xMin && pos_x < xMax && pos_y >= yMin && pos_y < yMax && pos_z >= zMin && pos_z < zMax) {
+    Interpolate_Gravity_CIC(pos_x, pos_y, pos_z, gravity_x_dev, gravity_y_dev, gravity_z_dev, xMin, yMin, zMin, xMax,
+                            yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x, g_y, g_z);
+  }
+
+  Real const a_from = factors.a_from[bin];
+  Real const a_to   = factors.a_to[bin];
+  Real const kick   = factors.kick[bin];
+  Real const vel_x  = (a_from * vel_x_dev[id] + kick * g_x) / a_to;
+  Real const vel_y  = (a_from * vel_y_dev[id] + kick * g_y) / a_to;
+  Real const vel_z  = (a_from * vel_z_dev[id] + kick * g_z) / a_to;
+  vel_x_dev[id]     = vel_x;
+  vel_y_dev[id]     = vel_y;
+  vel_z_dev[id]     = vel_z;
+
+  // The closing kicks don't drift
+  Real const drift = factors.drift[bin];
+  if (drift != 0) {
+    pos_x_dev[id] = pos_x + drift * vel_x;
+    pos_y_dev[id] = pos_y + drift * vel_y;
+    pos_z_dev[id] = pos_z + drift * vel_z;
+  }
+}
+
+void Particles3D::Initialize_Block_Timesteps_GPU(struct Parameters *P)
+{
+  n_time_bins = P->particle_time_bins;
+  if (n_time_bins < 1 || n_time_bins > PARTICLES_MAX_TIME_BINS) {
+    CHOLLA_ERROR("particle_time_bins has to be between 1 and %d, it is %d", PARTICLES_MAX_TIME_BINS, n_time_bins);
+  }
+  chprintf(" Particles time bins: %d ( up to %d substeps per step )\n", n_time_bins, 1 << (n_time_bins - 1));
+
+  // The bins are allocated the first time they are assigned
+  time_bin_dev  = NULL;
+  time_bin_size = 0;
+  for (int bin = 0; bin < PARTICLES_MAX_TIME_BINS; bin++) {
+    time_bin_counts[bin] = 0;
+  }
+  time_bin_sorted = false;
+  Allocate_Particles_GPU_Array_int(&time_bin_counts_dev, PARTICLES_MAX_TIME_BINS);
+}
+
+void Particles3D::Free_Block_Timesteps_GPU()
+{
+  cuda_utilities::Pool_Free(time_bin_dev);
+  cuda_utilities::Pool_Free(time_bin_counts_dev);
+  time_bin_dev        = nullptr;
+  time_bin_counts_dev = nullptr;
+  time_bin_size       = 0;
+}
+
+void Particles3D::Assign_Time_Bins_GPU(Real step_dti)
+{
+  // time_bin_dev is resized with the other particle arrays after this, see
+  // Resize_Particles_Arrays_GPU
+  if (time_bin_size != particles_array_size) {
+    cuda_utilities::Pool_Free(time_bin_dev);
+    Allocate_Particles_GPU_Array_int(&time_bin_dev, particles_array_size);
+    time_bin_size = particles_array_size;
+  }
+
+  GPU_Error_Check(cudaMemset(time_bin_counts_dev, 0, PARTICLES_MAX_TIME_BINS * sizeof(int)));
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Assign_Time_Bins_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_local, G.dx, G.dy, G.dz, vel_x_dev,
+                       vel_y_dev, vel_z_dev, step_dti, n_time_bins, time_bin_dev, time_bin_counts_dev);
+    GPU_Error_Check();
+  }
+  GPU_Error_Check(cudaMemcpy(time_bin_counts, time_bin_counts_dev, PARTICLES_MAX_TIME_BINS * sizeof(int),
+                             cudaMemcpyDeviceToHost));
+
+  // Most steps have all the particles in bin 0 and don't need the order
+  time_bin_sorted = false;
+  for (int bin = 1; bin < n_time_bins; bin++) {
+    time_bin_sorted = time_bin_sorted || time_bin_counts[bin] > 0;
+  }
+  if (time_bin_sorted) {
+    Reserve_Sort_Arrays_GPU();
+    hipLaunchKernelGGL(Get_Time_Bin_Keys_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_local, n_time_bins, time_bin_dev,
+                       sort_keys_dev[0], sort_indices_dev[0]);
+    GPU_Error_Check();
+    Sort_Keys_GPU(n_time_bins);
+  }
+}
+
+// Bin k starts a substep every 2^(n_time_bins - 1 - k) ticks of the last bin.
+// Tick 0 starts a substep of every bin
+part_int_t Particles3D::Count_Active_Particles(int tick)
+{
+  if (tick == 0) {
+    return n_local;
+  }
+  if (!time_bin_sorted) {
+    return 0;
+  }
+
+  int trailing_zeros = 0;
+  while (((tick >> trailing_zeros) & 1) == 0) {
+    trailing_zeros++;
+  }
+  part_int_t n_active = 0;
+  for (int bin = n_time_bins - 1 - trailing_zeros; bin < n_time_bins; bin++) {
+    n_active += time_bin_counts[bin];
+  }
+  return n_active;
+}
+
+void Particles3D::Advance_Particles_Block_Step_GPU(part_int_t n_active, int *active_dev,
+                                                   BlockStepFactors const &factors, cudaStream_t stream)
+{
+  // Only runs if there are active particles
+  if (n_active == 0) {
+    return;
+  }
+
+  int ngrid = (n_active - 1) / TPB_PARTICLES + 1;
+  hipLaunchKernelGGL(Advance_Particles_Block_Step_Kernel, ngrid, TPB_PARTICLES, 0, stream, n_active, active_dev,
+                     time_bin_dev, pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, G.gravity_x_dev,
+                     G.gravity_y_dev, G.gravity_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                     G.zMin - G.pos_origin_z, G.xMax - G.pos_origin_x, G.yMax - G.pos_origin_y,
+                     G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                     G.n_ghost_particles_grid, factors);
+  GPU_Error_Check();
+}
+
+#endif  // PARTICLES && PARTICLES_BLOCK_TIMESTEPS
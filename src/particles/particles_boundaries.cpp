@@ -19,6 +19,14 @@
 
 // Transfer the particles that moved outside the local domain
 void Grid3D::Transfer_Particles_Boundaries(struct Parameters P)
+{
+  Start_Transfer_Particles_Boundaries(P);
+  Finish_Transfer_Particles_Boundaries(P);
+}
+
+// With MPI only the sends of the x faces are posted here, so the hydro update
+// can run while those particles are in flight
+void Grid3D::Start_Transfer_Particles_Boundaries(struct Parameters P)
 {
   GPU_Error_Check();
   // Transfer Particles Boundaries
@@ -26,12 +34,53 @@ void Grid3D::Transfer_Particles_Boundaries(struct Parameters P)
   #ifdef CPU_TIME
   Timer.Part_Boundaries.Start();
   #endif
+  #ifdef MPI_CHOLLA
+  int *const flags = Particles.transfer_boundary_flags;
+  for (int i = 0; i < 6; i++) {
+    flags[i] = 0;
+  }
+  if (Check_Custom_Boundary(flags, P)) {
+    Custom_Boundary(P.custom_bcnd);
+  }
+  Start_Boundaries_MPI_BLOCK(flags);
+  #else
   Set_Boundary_Conditions(P);
+  #endif  // MPI_CHOLLA
   #ifdef CPU_TIME
   Timer.Part_Boundaries.End();
   #endif
+}
+
+// Complete the transfer, this has to happen before the particles are
+// used again by the density deposit
+void Grid3D::Finish_Transfer_Particles_Boundaries(struct Parameters P)
+{
+  #ifdef MPI_CHOLLA
+    #ifdef CPU_TIME
+  Timer.Part_Boundaries.Start();
+    #endif
+  Finish_Boundaries_MPI_BLOCK(Particles.transfer_boundary_flags, P);
+    #ifdef GRAVITY
+  Grav.Set_Boundary_Flags(Particles.transfer_boundary_flags);
+    #endif
+    #ifdef CPU_TIME
+  Timer.Part_Boundaries.End();
+    #endif
+  #endif  // MPI_CHOLLA
   Particles.TRANSFER_PARTICLES_BOUNDARIES = false;
   GPU_Error_Check();
+
+  #ifdef PARTICLES_GPU
+  Particles.n_local_peak = std::max(Particles.n_local_peak, Particles.n_local);
+    #ifdef MPI_CHOLLA
+  Particles.Shrink_Particles_Arrays_GPU();
+    #endif
+
+  // Sort once all the particles are in their local domain
+  if (Particles.particle_sort_interval > 0 && H.n_step % Particles.particle_sort_interval == 0) {
+    Particles.Sort_Particles_GPU();
+  }
+  #endif  // PARTICLES_GPU
 }
 
   #ifdef MPI_CHOLLA
@@ -179,12 +228,12 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
 
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-  Real *recv_buffer_x0_particles = d_recv_buffer_x0_particles;
-  Real *recv_buffer_x1_particles = d_recv_buffer_x1_particles;
-  Real *recv_buffer_y0_particles = d_recv_buffer_y0_particles;
-  Real *recv_buffer_y1_particles = d_recv_buffer_y1_particles;
-  Real *recv_buffer_z0_particles = d_recv_buffer_z0_particles;
-  Real *recv_buffer_z1_particles = d_recv_buffer_z1_particles;
+  Real *recv_buffer_x0_particles = Particles.G.recv_buffer_x0_d;
+  Real *recv_buffer_x1_particles = Particles.G.recv_buffer_x1_d;
+  Real *recv_buffer_y0_particles = Particles.G.recv_buffer_y0_d;
+  Real *recv_buffer_y1_particles = Particles.G.recv_buffer_y1_d;
+  Real *recv_buffer_z0_particles = Particles.G.recv_buffer_z0_d;
+  Real *recv_buffer_z1_particles = Particles.G.recv_buffer_z1_d;
       #else
   Real *recv_buffer_x0_particles = h_recv_buffer_x0_particles;
   Real *recv_buffer_x1_particles = h_recv_buffer_x1_particles;
@@ -208,18 +257,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_x0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_x0) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_x0_particles, Particles.G.recv_buffer_size_x0,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_x0 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_x0_d, &Particles.G.recv_buffer_size_x0, buffer_length);
+    recv_buffer_x0_particles = Particles.G.recv_buffer_x0_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_x0_particles, &buffer_length_particles_x0_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_x0_d, &Particles.G.recv_buffer_size_x0, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_x0_particles, &buffer_length_particles_x0_recv, buffer_length);
+    recv_buffer_x0_particles = h_recv_buffer_x0_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_x0_particles, &buffer_length_particles_x0_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_x0_particles, &buffer_length_particles_x0_recv, buffer_length);
+    recv_buffer_x0_particles = h_recv_buffer_x0_particles;
     #endif
     // if ( Particles.n_recv_x0 > 0 ) std::cout << " Recv X0: " <<
     // Particles.n_recv_x0 << std::endl;
@@ -230,18 +279,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_x1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_x1) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_x1_particles, Particles.G.recv_buffer_size_x1,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_x1 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_x1_d, &Particles.G.recv_buffer_size_x1, buffer_length);
+    recv_buffer_x1_particles = Particles.G.recv_buffer_x1_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_x1_particles, &buffer_length_particles_x1_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_x1_d, &Particles.G.recv_buffer_size_x1, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_x1_particles, &buffer_length_particles_x1_recv, buffer_length);
+    recv_buffer_x1_particles = h_recv_buffer_x1_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_x1_particles, &buffer_length_particles_x1_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_x1_particles, &buffer_length_particles_x1_recv, buffer_length);
+    recv_buffer_x1_particles = h_recv_buffer_x1_particles;
     #endif
     // if ( Particles.n_recv_x1 > 0 ) if ( Particles.n_recv_x1 > 0 ) std::cout
     // << " Recv X1:  " << Particles.n_recv_x1 <<  "  " << procID <<  "  from "
@@ -253,18 +302,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_y0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_y0) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_y0_particles, Particles.G.recv_buffer_size_y0,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_y0 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_y0_d, &Particles.G.recv_buffer_size_y0, buffer_length);
+    recv_buffer_y0_particles = Particles.G.recv_buffer_y0_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_y0_particles, &buffer_length_particles_y0_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_y0_d, &Particles.G.recv_buffer_size_y0, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_y0_particles, &buffer_length_particles_y0_recv, buffer_length);
+    recv_buffer_y0_particles = h_recv_buffer_y0_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_y0_particles, &buffer_length_particles_y0_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_y0_particles, &buffer_length_particles_y0_recv, buffer_length);
+    recv_buffer_y0_particles = h_recv_buffer_y0_particles;
     #endif
     // if ( Particles.n_recv_y0 > 0 ) std::cout << " Recv Y0: " <<
     // Particles.n_recv_y0 << std::endl;
@@ -275,18 +324,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_y1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_y1) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_y1_particles, Particles.G.recv_buffer_size_y1,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_y1 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_y1_d, &Particles.G.recv_buffer_size_y1, buffer_length);
+    recv_buffer_y1_particles = Particles.G.recv_buffer_y1_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_y1_particles, &buffer_length_particles_y1_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_y1_d, &Particles.G.recv_buffer_size_y1, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_y1_particles, &buffer_length_particles_y1_recv, buffer_length);
+    recv_buffer_y1_particles = h_recv_buffer_y1_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_y1_particles, &buffer_length_particles_y1_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_y1_particles, &buffer_length_particles_y1_recv, buffer_length);
+    recv_buffer_y1_particles = h_recv_buffer_y1_particles;
     #endif
     // if ( Particles.n_recv_y1 > 0 ) std::cout << " Recv Y1: " <<
     // Particles.n_recv_y1 << std::endl;
@@ -297,18 +346,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_z0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_z0) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_z0_particles, Particles.G.recv_buffer_size_z0,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_z0 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_z0_d, &Particles.G.recv_buffer_size_z0, buffer_length);
+    recv_buffer_z0_particles = Particles.G.recv_buffer_z0_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_z0_particles, &buffer_length_particles_z0_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_z0_d, &Particles.G.recv_buffer_size_z0, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_z0_particles, &buffer_length_particles_z0_recv, buffer_length);
+    recv_buffer_z0_particles = h_recv_buffer_z0_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_z0_particles, &buffer_length_particles_z0_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_z0_particles, &buffer_length_particles_z0_recv, buffer_length);
+    recv_buffer_z0_particles = h_recv_buffer_z0_particles;
     #endif
     // if ( Particles.n_recv_z0 > 0 ) std::cout << " Recv Z0: " <<
     // Particles.n_recv_z0 << std::endl;
@@ -319,18 +368,18 @@ void Grid3D::Load_NTtransfer_and_Request_Receive_Particles_Transfer(int index, i
     buffer_length = Particles.n_recv_z1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_GPU
       #ifdef MPI_GPU
-    if (buffer_length > Particles.G.recv_buffer_size_z1) {
-      printf("Extending Particles Transfer Buffer  ");
-      Extend_GPU_Array(&recv_buffer_z1_particles, Particles.G.recv_buffer_size_z1,
-                       Particles.G.gpu_allocation_factor * buffer_length, true);
-      Particles.G.recv_buffer_size_z1 = (part_int_t)Particles.G.gpu_allocation_factor * buffer_length;
-    }
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_z1_d, &Particles.G.recv_buffer_size_z1, buffer_length);
+    recv_buffer_z1_particles = Particles.G.recv_buffer_z1_d;
       #else
-    Check_and_Grow_Particles_Buffer(&recv_buffer_z1_particles, &buffer_length_particles_z1_recv, buffer_length);
+    // The received host buffer is copied into the device buffer
+    Particles.Grow_Transfer_Buffer_GPU(&Particles.G.recv_buffer_z1_d, &Particles.G.recv_buffer_size_z1, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_z1_particles, &buffer_length_particles_z1_recv, buffer_length);
+    recv_buffer_z1_particles = h_recv_buffer_z1_particles;
       #endif
     #endif
     #ifdef PARTICLES_CPU
-    Check_and_Grow_Particles_Buffer(&recv_buffer_z1_particles, &buffer_length_particles_z1_recv, buffer_length);
+    Check_and_Grow_Particles_Buffer(&h_recv_buffer_z1_particles, &buffer_length_particles_z1_recv, buffer_length);
+    recv_buffer_z1_particles = h_recv_buffer_z1_particles;
     #endif
     // if ( Particles.n_recv_z1 >0 ) std::cout << " Recv Z1: " <<
     // Particles.n_recv_z1 << std::endl;
@@ -349,8 +398,9 @@ void Grid3D::Load_and_Send_Particles_X0(int ireq_n_particles, int ireq_particles
   Real *send_buffer_x0_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_x0_particles = d_send_buffer_x0_particles;
-  Particles.Load_Particles_to_Buffer_GPU(0, 0, send_buffer_x0_particles, buffer_length_particles_x0_send);
+  Particles.Load_Particles_to_Buffer_GPU(0, 0, Particles.G.send_buffer_x0_d, buffer_length_particles_x0_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_x0_particles = Particles.G.send_buffer_x0_d;
     #endif  // PARTICLES_GPU
 
   MPI_Irecv(&Particles.n_recv_x0, 1, MPI_PART_INT, source[0], 0, world, &recv_request_n_particles[ireq_n_particles]);
@@ -361,13 +411,14 @@ void Grid3D::Load_and_Send_Particles_X0(int ireq_n_particles, int ireq_particles
   // dest[0] <<  std::endl;
   buffer_length = Particles.n_send_x0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_x0_particles, &buffer_length_particles_x0_send, buffer_length);
   send_buffer_x0_particles = h_send_buffer_x0_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_x0_particles, &buffer_length_particles_x0_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(0, 0, send_buffer_x0_particles, buffer_length_particles_x0_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_x0_particles, d_send_buffer_x0_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_x0_particles, &buffer_length_particles_x0_send, buffer_length);
+  cudaMemcpy(h_send_buffer_x0_particles, send_buffer_x0_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_x0_particles = h_send_buffer_x0_particles;
     #endif
@@ -383,8 +434,9 @@ void Grid3D::Load_and_Send_Particles_X1(int ireq_n_particles, int ireq_particles
   Real *send_buffer_x1_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_x1_particles = d_send_buffer_x1_particles;
-  Particles.Load_Particles_to_Buffer_GPU(0, 1, send_buffer_x1_particles, buffer_length_particles_x1_send);
+  Particles.Load_Particles_to_Buffer_GPU(0, 1, Particles.G.send_buffer_x1_d, buffer_length_particles_x1_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_x1_particles = Particles.G.send_buffer_x1_d;
     #endif  // PARTICLES_GPU
 
   MPI_Irecv(&Particles.n_recv_x1, 1, MPI_PART_INT, source[1], 1, world, &recv_request_n_particles[ireq_n_particles]);
@@ -394,13 +446,14 @@ void Grid3D::Load_and_Send_Particles_X1(int ireq_n_particles, int ireq_particles
   // Particles.n_send_x1 << std::endl;
   buffer_length = Particles.n_send_x1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_x1_particles, &buffer_length_particles_x1_send, buffer_length);
   send_buffer_x1_particles = h_send_buffer_x1_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_x1_particles, &buffer_length_particles_x1_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(0, 1, send_buffer_x1_particles, buffer_length_particles_x1_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_x1_particles, d_send_buffer_x1_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_x1_particles, &buffer_length_particles_x1_send, buffer_length);
+  cudaMemcpy(h_send_buffer_x1_particles, send_buffer_x1_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_x1_particles = h_send_buffer_x1_particles;
     #endif
@@ -416,8 +469,9 @@ void Grid3D::Load_and_Send_Particles_Y0(int ireq_n_particles, int ireq_particles
   Real *send_buffer_y0_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_y0_particles = d_send_buffer_y0_particles;
-  Particles.Load_Particles_to_Buffer_GPU(1, 0, send_buffer_y0_particles, buffer_length_particles_y0_send);
+  Particles.Load_Particles_to_Buffer_GPU(1, 0, Particles.G.send_buffer_y0_d, buffer_length_particles_y0_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_y0_particles = Particles.G.send_buffer_y0_d;
     #endif  // PARTICLES_GPU
 
   MPI_Isend(&Particles.n_send_y0, 1, MPI_PART_INT, dest[2], 3, world, &send_request_n_particles[0]);
@@ -427,13 +481,14 @@ void Grid3D::Load_and_Send_Particles_Y0(int ireq_n_particles, int ireq_particles
   // Particles.n_send_y0 << std::endl;
   buffer_length = Particles.n_send_y0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_y0_particles, &buffer_length_particles_y0_send, buffer_length);
   send_buffer_y0_particles = h_send_buffer_y0_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_y0_particles, &buffer_length_particles_y0_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(1, 0, send_buffer_y0_particles, buffer_length_particles_y0_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_y0_particles, d_send_buffer_y0_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_y0_particles, &buffer_length_particles_y0_send, buffer_length);
+  cudaMemcpy(h_send_buffer_y0_particles, send_buffer_y0_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_y0_particles = h_send_buffer_y0_particles;
     #endif
@@ -449,8 +504,9 @@ void Grid3D::Load_and_Send_Particles_Y1(int ireq_n_particles, int ireq_particles
   Real *send_buffer_y1_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_y1_particles = d_send_buffer_y1_particles;
-  Particles.Load_Particles_to_Buffer_GPU(1, 1, send_buffer_y1_particles, buffer_length_particles_y1_send);
+  Particles.Load_Particles_to_Buffer_GPU(1, 1, Particles.G.send_buffer_y1_d, buffer_length_particles_y1_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_y1_particles = Particles.G.send_buffer_y1_d;
     #endif  // PARTICLES_GPU
 
   MPI_Isend(&Particles.n_send_y1, 1, MPI_PART_INT, dest[3], 2, world, &send_request_n_particles[1]);
@@ -460,13 +516,14 @@ void Grid3D::Load_and_Send_Particles_Y1(int ireq_n_particles, int ireq_particles
   // Particles.n_send_y1 << std::endl;
   buffer_length = Particles.n_send_y1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_y1_particles, &buffer_length_particles_y1_send, buffer_length);
   send_buffer_y1_particles = h_send_buffer_y1_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_y1_particles, &buffer_length_particles_y1_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(1, 1, send_buffer_y1_particles, buffer_length_particles_y1_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_y1_particles, d_send_buffer_y1_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_y1_particles, &buffer_length_particles_y1_send, buffer_length);
+  cudaMemcpy(h_send_buffer_y1_particles, send_buffer_y1_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_y1_particles = h_send_buffer_y1_particles;
     #endif
@@ -482,8 +539,9 @@ void Grid3D::Load_and_Send_Particles_Z0(int ireq_n_particles, int ireq_particles
   Real *send_buffer_z0_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_z0_particles = d_send_buffer_z0_particles;
-  Particles.Load_Particles_to_Buffer_GPU(2, 0, send_buffer_z0_particles, buffer_length_particles_z0_send);
+  Particles.Load_Particles_to_Buffer_GPU(2, 0, Particles.G.send_buffer_z0_d, buffer_length_particles_z0_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_z0_particles = Particles.G.send_buffer_z0_d;
     #endif  // PARTICLES_GPU
 
   MPI_Isend(&Particles.n_send_z0, 1, MPI_PART_INT, dest[4], 5, world, &send_request_n_particles[0]);
@@ -493,13 +551,14 @@ void Grid3D::Load_and_Send_Particles_Z0(int ireq_n_particles, int ireq_particles
   // Particles.n_send_z0 << std::endl;
   buffer_length = Particles.n_send_z0 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_z0_particles, &buffer_length_particles_z0_send, buffer_length);
   send_buffer_z0_particles = h_send_buffer_z0_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_z0_particles, &buffer_length_particles_z0_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(2, 0, send_buffer_z0_particles, buffer_length_particles_z0_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_z0_particles, d_send_buffer_z0_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_z0_particles, &buffer_length_particles_z0_send, buffer_length);
+  cudaMemcpy(h_send_buffer_z0_particles, send_buffer_z0_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_z0_particles = h_send_buffer_z0_particles;
     #endif
@@ -515,8 +574,9 @@ void Grid3D::Load_and_Send_Particles_Z1(int ireq_n_particles, int ireq_particles
   Real *send_buffer_z1_particles;
 
     #ifdef PARTICLES_GPU
-  send_buffer_z1_particles = d_send_buffer_z1_particles;
-  Particles.Load_Particles_to_Buffer_GPU(2, 1, send_buffer_z1_particles, buffer_length_particles_z1_send);
+  Particles.Load_Particles_to_Buffer_GPU(2, 1, Particles.G.send_buffer_z1_d, buffer_length_particles_z1_send);
+  // The device buffer may have grown while loading the particles
+  send_buffer_z1_particles = Particles.G.send_buffer_z1_d;
     #endif  // PARTICLES_GPU
 
   MPI_Isend(&Particles.n_send_z1, 1, MPI_PART_INT, dest[5], 4, world, &send_request_n_particles[1]);
@@ -526,13 +586,14 @@ void Grid3D::Load_and_Send_Particles_Z1(int ireq_n_particles, int ireq_particles
   // Particles.n_send_z1 << std::endl;
   buffer_length = Particles.n_send_z1 * N_DATA_PER_PARTICLE_TRANSFER;
     #ifdef PARTICLES_CPU
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_z1_particles, &buffer_length_particles_z1_send, buffer_length);
   send_buffer_z1_particles = h_send_buffer_z1_particles;
-  Check_and_Grow_Particles_Buffer(&send_buffer_z1_particles, &buffer_length_particles_z1_send, buffer_length);
   Particles.Load_Particles_to_Buffer_CPU(2, 1, send_buffer_z1_particles, buffer_length_particles_z1_send);
     #endif  // PARTICLES_CPU
 
     #if defined(PARTICLES_GPU) && !defined(MPI_GPU)
-  cudaMemcpy(h_send_buffer_z1_particles, d_send_buffer_z1_particles, buffer_length * sizeof(Real),
+  Check_and_Grow_Particles_Buffer(&h_send_buffer_z1_particles, &buffer_length_particles_z1_send, buffer_length);
+  cudaMemcpy(h_send_buffer_z1_particles, send_buffer_z1_particles, buffer_length * sizeof(Real),
              cudaMemcpyDeviceToHost);
   send_buffer_z1_particles = h_send_buffer_z1_particles;
     #endif
@@ -554,10 +615,10 @@ void Grid3D::Unload_Particles_from_Buffer_X0(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_x0_particles, h_recv_buffer_x0_particles, buffer_length_particles_x0_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_x0_d, h_recv_buffer_x0_particles,
+             Particles.n_recv_x0 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(0, 0, d_recv_buffer_x0_particles, Particles.n_recv_x0);
+  Particles.Unload_Particles_from_Buffer_GPU(0, 0, Particles.G.recv_buffer_x0_d, Particles.n_recv_x0);
     #endif  // PARTICLES_GPU
 }
 
@@ -571,10 +632,10 @@ void Grid3D::Unload_Particles_from_Buffer_X1(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_x1_particles, h_recv_buffer_x1_particles, buffer_length_particles_x1_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_x1_d, h_recv_buffer_x1_particles,
+             Particles.n_recv_x1 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(0, 1, d_recv_buffer_x1_particles, Particles.n_recv_x1);
+  Particles.Unload_Particles_from_Buffer_GPU(0, 1, Particles.G.recv_buffer_x1_d, Particles.n_recv_x1);
     #endif  // PARTICLES_GPU
 }
 
@@ -588,10 +649,10 @@ void Grid3D::Unload_Particles_from_Buffer_Y0(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_y0_particles, h_recv_buffer_y0_particles, buffer_length_particles_y0_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_y0_d, h_recv_buffer_y0_particles,
+             Particles.n_recv_y0 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(1, 0, d_recv_buffer_y0_particles, Particles.n_recv_y0);
+  Particles.Unload_Particles_from_Buffer_GPU(1, 0, Particles.G.recv_buffer_y0_d, Particles.n_recv_y0);
     #endif  // PARTICLES_GPU
 }
 
@@ -605,10 +666,10 @@ void Grid3D::Unload_Particles_from_Buffer_Y1(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_y1_particles, h_recv_buffer_y1_particles, buffer_length_particles_y1_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_y1_d, h_recv_buffer_y1_particles,
+             Particles.n_recv_y1 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(1, 1, d_recv_buffer_y1_particles, Particles.n_recv_y1);
+  Particles.Unload_Particles_from_Buffer_GPU(1, 1, Particles.G.recv_buffer_y1_d, Particles.n_recv_y1);
     #endif  // PARTICLES_GPU
 }
 
@@ -622,10 +683,10 @@ void Grid3D::Unload_Particles_from_Buffer_Z0(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_z0_particles, h_recv_buffer_z0_particles, buffer_length_particles_z0_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_z0_d, h_recv_buffer_z0_particles,
+             Particles.n_recv_z0 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(2, 0, d_recv_buffer_z0_particles, Particles.n_recv_z0);
+  Particles.Unload_Particles_from_Buffer_GPU(2, 0, Particles.G.recv_buffer_z0_d, Particles.n_recv_z0);
     #endif  // PARTICLES_GPU
 }
 
@@ -639,10 +700,10 @@ void Grid3D::Unload_Particles_from_Buffer_Z1(int *flags)
     #endif  // PARTICLES_CPU
     #ifdef PARTICLES_GPU
       #ifndef MPI_GPU
-  cudaMemcpy(d_recv_buffer_z1_particles, h_recv_buffer_z1_particles, buffer_length_particles_z1_recv * sizeof(Real),
-             cudaMemcpyHostToDevice);
+  cudaMemcpy(Particles.G.recv_buffer_z1_d, h_recv_buffer_z1_particles,
+             Particles.n_recv_z1 * N_DATA_PER_PARTICLE_TRANSFER * sizeof(Real), cudaMemcpyHostToDevice);
       #endif
-  Particles.Unload_Particles_from_Buffer_GPU(2, 1, d_recv_buffer_z1_particles, Particles.n_recv_z1);
+  Particles.Unload_Particles_from_Buffer_GPU(2, 1, Particles.G.recv_buffer_z1_d, Particles.n_recv_z1);
     #endif  // PARTICLES_GPU
 }
 
@@ -704,23 +765,23 @@ void Particles3D::Clear_Particles_For_Transfer(void)
 int Particles3D::Select_Particles_to_Transfer_GPU(int direction, int side)
 {
   int n_transfer;
-  Real *pos;
+  Real_Part *pos;
   Real domainMin, domainMax;
 
   if (direction == 0) {
     pos       = pos_x_dev;
-    domainMax = G.xMax;
-    domainMin = G.xMin;
+    domainMax = G.xMax - G.pos_origin_x;
+    domainMin = G.xMin - G.pos_origin_x;
   }
   if (direction == 1) {
     pos       = pos_y_dev;
-    domainMax = G.yMax;
-    domainMin = G.yMin;
+    domainMax = G.yMax - G.pos_origin_y;
+    domainMin = G.yMin - G.pos_origin_y;
   }
   if (direction == 2) {
     pos       = pos_z_dev;
-    domainMax = G.zMax;
-    domainMin = G.zMin;
+    domainMax = G.zMax - G.pos_origin_z;
+    domainMin = G.zMin - G.pos_origin_z;
   }
   // chprintf("n_local=%d SELECT PARTICLES: %d dir, %d side. Max/Min %.4e/%.4e
   // \n", n_local, direction, side, domainMax, domainMin); Set the number of
@@ -728,28 +789,54 @@ int Particles3D::Select_Particles_to_Transfer_GPU(int direction, int side)
   // buffers
   n_transfer = Select_Particles_to_Transfer_GPU_function(
       n_local, side, domainMin, domainMax, pos, G.n_transfer_d, G.n_transfer_h, G.transfer_particles_flags_d,
-      G.transfer_particles_indices_d, G.replace_particles_indices_d, G.transfer_particles_prefix_sum_d,
-      G.transfer_particles_prefix_sum_blocks_d);
+      G.transfer_particles_indices_d, G.replace_particles_indices_d, &G.transfer_temp_d, &G.transfer_temp_bytes);
   GPU_Error_Check(cudaDeviceSynchronize());
 
   return n_transfer;
 }
 
+// The particle arrays packed into the transfer records
+static ParticleTransferFields Transfer_Fields_GPU(Particles3D &particles)
+{
+  ParticleTransferFields fields;
+  fields.pos_x    = particles.pos_x_dev;
+  fields.pos_y    = particles.pos_y_dev;
+  fields.pos_z    = particles.pos_z_dev;
+  fields.vel_x    = particles.vel_x_dev;
+  fields.vel_y    = particles.vel_y_dev;
+  fields.vel_z    = particles.vel_z_dev;
+  fields.mass     = nullptr;
+  fields.ids      = nullptr;
+  fields.age      = nullptr;
+  fields.time_bin = nullptr;
+  fields.origin_x = particles.G.pos_origin_x;
+  fields.origin_y = particles.G.pos_origin_y;
+  fields.origin_z = particles.G.pos_origin_z;
+      #ifndef SINGLE_PARTICLE_MASS
+  fields.mass = particles.mass_dev;
+      #endif
+      #ifdef PARTICLE_IDS
+  fields.ids = particles.partIDs_dev;
+      #endif
+      #ifdef PARTICLE_AGE
+  fields.age = particles.age_dev;
+      #endif
+      #ifdef PARTICLES_BLOCK_TIMESTEPS
+  fields.time_bin = particles.time_bin_dev;
+      #endif
+  return fields;
+}
+
 void Particles3D::Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int direction, int side, Real *send_buffer_h,
                                                         int buffer_length)
 {
   part_int_t *n_send;
   int *buffer_size;
-  int n_fields_to_transfer;
-  Real *pos, *send_buffer_d;
+  Real_Part *pos;
+  Real **send_buffer;
   Real domainMin, domainMax;
-  int bt_pos_x, bt_pos_y, bt_pos_z, bt_non_pos;
-  int field_id = -1;
-
-  bt_pos_x   = -1;
-  bt_pos_y   = -1;
-  bt_pos_z   = -1;
-  bt_non_pos = -1;
+  // the boundary type of the position along the transfer direction
+  int boundary_type = -1;
 
   if (direction == 0) {
     pos       = pos_x_dev;
@@ -758,14 +845,14 @@ void Particles3D::Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int dire
     if (side == 0) {
       n_send        = &n_send_x0;
       buffer_size   = &G.send_buffer_size_x0;
-      send_buffer_d = G.send_buffer_x0_d;
-      bt_pos_x      = G.boundary_type_x0;
+      send_buffer   = &G.send_buffer_x0_d;
+      boundary_type = G.boundary_type_x0;
     }
     if (side == 1) {
       n_send        = &n_send_x1;
       buffer_size   = &G.send_buffer_size_x1;
-      send_buffer_d = G.send_buffer_x1_d;
-      bt_pos_x      = G.boundary_type_x1;
+      send_buffer   = &G.send_buffer_x1_d;
+      boundary_type = G.boundary_type_x1;
     }
   }
   if (direction == 1) {
@@ -775,14 +862,14 @@ void Particles3D::Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int dire
     if (side == 0) {
       n_send        = &n_send_y0;
       buffer_size   = &G.send_buffer_size_y0;
-      send_buffer_d = G.send_buffer_y0_d;
-      bt_pos_y      = G.boundary_type_y0;
+      send_buffer   = &G.send_buffer_y0_d;
+      boundary_type = G.boundary_type_y0;
     }
     if (side == 1) {
       n_send        = &n_send_y1;
       buffer_size   = &G.send_buffer_size_y1;
-      send_buffer_d = G.send_buffer_y1_d;
-      bt_pos_y      = G.boundary_type_y1;
+      send_buffer   = &G.send_buffer_y1_d;
+      boundary_type = G.boundary_type_y1;
     }
   }
   if (direction == 2) {
@@ -792,61 +879,26 @@ void Particles3D::Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int dire
     if (side == 0) {
       n_send        = &n_send_z0;
       buffer_size   = &G.send_buffer_size_z0;
-      send_buffer_d = G.send_buffer_z0_d;
-      bt_pos_z      = G.boundary_type_z0;
+      send_buffer   = &G.send_buffer_z0_d;
+      boundary_type = G.boundary_type_z0;
     }
     if (side == 1) {
       n_send        = &n_send_z1;
       buffer_size   = &G.send_buffer_size_z1;
-      send_buffer_d = G.send_buffer_z1_d;
-      bt_pos_z      = G.boundary_type_z1;
+      send_buffer   = &G.send_buffer_z1_d;
+      boundary_type = G.boundary_type_z1;
     }
   }
 
   // If the number of particles in the array exceeds the size of the array,
   // extend the array
-  if ((*n_send + n_transfer) * N_DATA_PER_PARTICLE_TRANSFER > *buffer_size) {
-    printf("Extending Particles Transfer Buffer  ");
-    Extend_GPU_Array(&send_buffer_d, *buffer_size,
-                     G.gpu_allocation_factor * (*n_send + n_transfer) * N_DATA_PER_PARTICLE_TRANSFER, true);
-    *buffer_size = (part_int_t)G.gpu_allocation_factor * (*n_send + n_transfer) * N_DATA_PER_PARTICLE_TRANSFER;
-  }
+  Grow_Transfer_Buffer_GPU(send_buffer, buffer_size, (*n_send + n_transfer) * N_DATA_PER_PARTICLE_TRANSFER);
+  Real *send_buffer_d = *send_buffer;
 
   // Load the particles that will be transferred into the buffers
-  n_fields_to_transfer = N_DATA_PER_PARTICLE_TRANSFER;
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, pos_x_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_pos_x);
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, pos_y_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_pos_y);
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, pos_z_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_pos_z);
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, vel_x_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_non_pos);
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, vel_y_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_non_pos);
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, vel_z_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_non_pos);
-      #ifndef SINGLE_PARTICLE_MASS
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, mass_dev,
+  Load_Particles_to_Transfer_GPU_function(n_transfer, direction, Transfer_Fields_GPU(*this),
                                           G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_non_pos);
-      #endif
-      #ifdef PARTICLE_IDS
-  Load_Particles_to_Transfer_Int_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, partIDs_dev,
-                                              G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                              bt_non_pos);
-      #endif
-      #ifdef PARTICLE_AGE
-  Load_Particles_to_Transfer_GPU_function(n_transfer, ++field_id, n_fields_to_transfer, age_dev,
-                                          G.transfer_particles_indices_d, send_buffer_d, domainMin, domainMax,
-                                          bt_non_pos);
-      #endif
+                                          boundary_type);
   GPU_Error_Check(cudaDeviceSynchronize());
 
   *n_send += n_transfer;
@@ -856,18 +908,18 @@ void Particles3D::Copy_Transfer_Particles_to_Buffer_GPU(int n_transfer, int dire
 void Particles3D::Replace_Tranfered_Particles_GPU(int n_transfer)
 {
   // Replace the particles that were transferred
-  Replace_Transfered_Particles_GPU_function(n_transfer, pos_x_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
-  Replace_Transfered_Particles_GPU_function(n_transfer, pos_y_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
-  Replace_Transfered_Particles_GPU_function(n_transfer, pos_z_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
-  Replace_Transfered_Particles_GPU_function(n_transfer, vel_x_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
-  Replace_Transfered_Particles_GPU_function(n_transfer, vel_y_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
-  Replace_Transfered_Particles_GPU_function(n_transfer, vel_z_dev, G.transfer_particles_indices_d,
-                                            G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, pos_x_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, pos_y_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, pos_z_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, vel_x_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, vel_y_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
+  Replace_Transfered_Particles_Part_GPU_function(n_transfer, vel_z_dev, G.transfer_particles_indices_d,
+                                                 G.replace_particles_indices_d, false);
       #ifndef SINGLE_PARTICLE_MASS
   Replace_Transfered_Particles_GPU_function(n_transfer, mass_dev, G.transfer_particles_indices_d,
                                             G.replace_particles_indices_d, false);
@@ -880,10 +932,17 @@ void Particles3D::Replace_Tranfered_Particles_GPU(int n_transfer)
   Replace_Transfered_Particles_GPU_function(n_transfer, age_dev, G.transfer_particles_indices_d,
                                             G.replace_particles_indices_d, false);
       #endif
+      #ifdef PARTICLES_BLOCK_TIMESTEPS
+  if (time_bin_dev != nullptr) {
+    Replace_Transfered_Particles_Bin_GPU_function(n_transfer, time_bin_dev, G.transfer_particles_indices_d,
+                                                  G.replace_particles_indices_d);
+  }
+      #endif
 
   GPU_Error_Check(cudaDeviceSynchronize());
   // Update the local number of particles
   n_local -= n_transfer;
+  order_version++;
 }
 
 void Particles3D::Load_Particles_to_Buffer_GPU(int direction, int side, Real *send_buffer_h, int buffer_length)
@@ -925,70 +984,89 @@ void Particles3D::Set_Particles_Open_Boundary_GPU(int dir, int side)
   // n_transfer = Select_Particles_to_Transfer_GPU_function(  n_local, side,
   // domainMin, domainMax, pos, G.n_transfer_d, G.n_transfer_h,
   // G.transfer_particles_flags_d, G.transfer_particles_indices_d,
-  // G.replace_particles_indices_d, G.transfer_particles_prefix_sum_d,
-  // G.transfer_particles_prefix_sum_blocks_d  );
+  // G.replace_particles_indices_d, &G.transfer_temp_d,
+  // &G.transfer_temp_bytes  );
   // GPU_Error_Check(cudaDeviceSynchronize());
   // chprintf("OPEN condition: removing %d\n", n_transfer);
   Replace_Tranfered_Particles_GPU(n_transfer);
 }
 
-void Particles3D::Copy_Transfer_Particles_from_Buffer_GPU(int n_recv, Real *recv_buffer_d)
+// Reallocate all the particles arrays with new_size elements, keeping the
+// local particles
+void Particles3D::Resize_Particles_Arrays_GPU(part_int_t new_size)
 {
-  int n_fields_to_transfer;
-
-  part_int_t n_local_after = n_local + n_recv;
-  if (n_local_after > particles_array_size) {
-    printf(" Reallocating GPU particles arrays. N local particles: %ld \n", n_local_after);
-    int new_size = G.gpu_allocation_factor * n_local_after;
-    Extend_GPU_Array(&pos_x_dev, (int)particles_array_size, new_size, true);
-    Extend_GPU_Array(&pos_y_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&pos_z_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&vel_x_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&vel_y_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&vel_z_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&grav_x_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&grav_y_dev, (int)particles_array_size, new_size, false);
-    Extend_GPU_Array(&grav_z_dev, (int)particles_array_size, new_size, false);
+  int const size = (int)particles_array_size;
+  Resize_GPU_Array(&pos_x_dev, size, (int)new_size);
+  Resize_GPU_Array(&pos_y_dev, size, (int)new_size);
+  Resize_GPU_Array(&pos_z_dev, size, (int)new_size);
+  Resize_GPU_Array(&vel_x_dev, size, (int)new_size);
+  Resize_GPU_Array(&vel_y_dev, size, (int)new_size);
+  Resize_GPU_Array(&vel_z_dev, size, (int)new_size);
+      #ifndef PARTICLES_KDK_FUSED
+  Resize_GPU_Array(&grav_x_dev, size, (int)new_size);
+  Resize_GPU_Array(&grav_y_dev, size, (int)new_size);
+  Resize_GPU_Array(&grav_z_dev, size, (int)new_size);
+      #endif
       #ifndef SINGLE_PARTICLE_MASS
-    Extend_GPU_Array(&mass_dev, (int)particles_array_size, new_size, false);
+  Resize_GPU_Array(&mass_dev, size, (int)new_size);
       #endif
       #ifdef PARTICLE_IDS
-    Extend_GPU_Array(&partIDs_dev, (int)particles_array_size, new_size, false);
+  Resize_GPU_Array(&partIDs_dev, size, (int)new_size);
       #endif
       #ifdef PARTICLE_AGE
-    Extend_GPU_Array(&age_dev, (int)particles_array_size, new_size, false);
+  Resize_GPU_Array(&age_dev, size, (int)new_size);
       #endif
-    particles_array_size = (part_int_t)new_size;
-    ReAllocate_Memory_GPU_MPI();
+      #ifdef PARTICLES_BLOCK_TIMESTEPS
+  if (time_bin_dev != nullptr) {
+    Resize_GPU_Array(&time_bin_dev, size, (int)new_size);
+    time_bin_size = new_size;
+  }
+      #endif
+  particles_array_size = new_size;
+  ReAllocate_Memory_GPU_MPI();
+}
+
+// Release the memory of the particles arrays when they are mostly empty, for
+// example after the particles of a rank moved to its neighbors. The hysteresis
+// between growing and shrinking keeps this from happening every step
+void Particles3D::Shrink_Particles_Arrays_GPU()
+{
+  part_int_t const fit_size = std::max((part_int_t)(G.gpu_allocation_factor * n_local), (part_int_t)TPB_PARTICLES);
+  if (G.gpu_growth_factor * G.gpu_growth_factor * fit_size >= particles_array_size) {
+    return;
+  }
+  printf(" Shrinking GPU particles arrays. N local particles: %ld  size: %ld  new_size: %ld \n", n_local,
+         particles_array_size, fit_size);
+  Resize_Particles_Arrays_GPU(fit_size);
+}
+
+// Grow a device transfer buffer to hold at least new_size values
+void Particles3D::Grow_Transfer_Buffer_GPU(Real **buffer_d, int *buffer_size, int new_size)
+{
+  if (new_size <= *buffer_size) {
+    return;
+  }
+  int const grown_size = std::max(new_size, (int)(G.gpu_growth_factor * *buffer_size));
+  printf("Extending Particles Transfer Buffer  ");
+  Extend_GPU_Array(buffer_d, *buffer_size, grown_size, true);
+  *buffer_size = grown_size;
+}
+
+void Particles3D::Copy_Transfer_Particles_from_Buffer_GPU(int n_recv, Real *recv_buffer_d)
+{
+  part_int_t n_local_after = n_local + n_recv;
+  if (n_local_after > particles_array_size) {
+    printf(" Reallocating GPU particles arrays. N local particles: %ld \n", n_local_after);
+    part_int_t new_size = std::max((part_int_t)(G.gpu_allocation_factor * n_local_after),
+                                   (part_int_t)(G.gpu_growth_factor * particles_array_size));
+    Resize_Particles_Arrays_GPU(new_size);
   }
 
   // Unload the particles that were transferred from the buffers
-  int field_id         = -1;
-  n_fields_to_transfer = N_DATA_PER_PARTICLE_TRANSFER;
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, pos_x_dev,
-                                            recv_buffer_d);
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, pos_y_dev,
-                                            recv_buffer_d);
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, pos_z_dev,
-                                            recv_buffer_d);
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, vel_x_dev,
-                                            recv_buffer_d);
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, vel_y_dev,
-                                            recv_buffer_d);
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, vel_z_dev,
-                                            recv_buffer_d);
-      #ifndef SINGLE_PARTICLE_MASS
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, mass_dev, recv_buffer_d);
-      #endif
-      #ifdef PARTICLE_IDS
-  Unload_Particles_Int_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, partIDs_dev,
-                                                recv_buffer_d);
-      #endif
-      #ifdef PARTICLE_AGE
-  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, ++field_id, n_fields_to_transfer, age_dev, recv_buffer_d);
-      #endif
+  Unload_Particles_to_Transfer_GPU_function(n_local, n_recv, Transfer_Fields_GPU(*this), recv_buffer_d);
 
   n_local += n_recv;
+  order_version++;
   // if ( n_recv > 0 ) printf( "###Unloaded %d  particles\n", n_recv );
 }
 
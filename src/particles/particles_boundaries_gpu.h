@@ -4,31 +4,70 @@
     #define PARTICLES_BOUNDARIES_H
 
 part_int_t Select_Particles_to_Transfer_GPU_function(part_int_t n_local, int side, Real domainMin, Real domainMax,
-                                                     Real *pos_d, int *n_transfer_d, int *n_transfer_h,
+                                                     Real_Part *pos_d, int *n_transfer_d, int *n_transfer_h,
                                                      bool *transfer_flags_d, int *transfer_indices_d,
-                                                     int *replace_indices_d, int *transfer_prefix_sum_d,
-                                                     int *transfer_prefix_sum_blocks_d);
+                                                     int *replace_indices_d, void **transfer_temp_d,
+                                                     size_t *transfer_temp_bytes);
 
-void Load_Particles_to_Transfer_GPU_function(int n_transfer, int field_id, int n_fields_to_transfer, Real *field_d,
+// The record of one particle in the GPU transfer buffers, with each field in
+// its own type. The positions are global, so they are sent as Real, and the
+// velocities keep the type of the particle arrays. The 8 byte fields come
+// first so the record has no padding between them
+struct ParticleTransferRecord {
+  Real pos_x, pos_y, pos_z;
+    #ifndef SINGLE_PARTICLE_MASS
+  Real mass;
+    #endif
+    #ifdef PARTICLE_IDS
+  part_int_t id;
+    #endif
+    #ifdef PARTICLE_AGE
+  Real age;
+    #endif
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  // The time bin is needed by the closing kick after the transfer
+  Real time_bin;
+    #endif
+  Real_Part vel_x, vel_y, vel_z;
+};
+static_assert(sizeof(ParticleTransferRecord) % sizeof(Real) == 0,
+              "The particle transfer record has to fill a whole number of Real values");
+
+// The particle arrays read and written by the transfers, and the origin of the
+// stored positions
+struct ParticleTransferFields {
+  Real_Part *pos_x, *pos_y, *pos_z;
+  Real_Part *vel_x, *vel_y, *vel_z;
+  Real *mass;
+  part_int_t *ids;
+  Real *age;
+  int *time_bin;
+  Real origin_x, origin_y, origin_z;
+};
+
+// Pack the particles in transfer_indices_d into the records of send_buffer_d,
+// applying the global periodic boundary to the position along direction
+void Load_Particles_to_Transfer_GPU_function(int n_transfer, int direction, ParticleTransferFields fields,
                                              int *transfer_indices_d, Real *send_buffer_d, Real domainMin,
                                              Real domainMax, int boundary_type);
-void Load_Particles_to_Transfer_Int_GPU_function(int n_transfer, int field_id, int n_fields_to_transfer,
-                                                 part_int_t *field_d, int *transfer_indices_d, Real *send_buffer_d,
-                                                 Real domainMin, Real domainMax, int boundary_type);
 
 void Replace_Transfered_Particles_GPU_function(int n_transfer, Real *field_d, int *transfer_indices_d,
                                                int *replace_indices_d, bool print_replace);
+void Replace_Transfered_Particles_Part_GPU_function(int n_transfer, Real_Part *field_d, int *transfer_indices_d,
+                                                    int *replace_indices_d, bool print_replace);
 void Replace_Transfered_Particles_Int_GPU_function(int n_transfer, part_int_t *field_d, int *transfer_indices_d,
                                                    int *replace_indices_d, bool print_replace);
+void Replace_Transfered_Particles_Bin_GPU_function(int n_transfer, int *field_d, int *transfer_indices_d,
+                                                   int *replace_indices_d);
 
 void Copy_Particles_GPU_Buffer_to_Host_Buffer(int n_transfer, Real *buffer_h, Real *buffer_d);
 
 void Copy_Particles_Host_Buffer_to_GPU_Buffer(int n_transfer, Real *buffer_h, Real *buffer_d);
 
-void Unload_Particles_to_Transfer_GPU_function(int n_local, int n_transfer, int field_id, int n_fields_to_transfer,
-                                               Real *field_d, Real *recv_buffer_d);
-void Unload_Particles_Int_to_Transfer_GPU_function(int n_local, int n_transfer, int field_id, int n_fields_to_transfer,
-                                                   part_int_t *field_d, Real *recv_buffer_d);
+// Unpack the records of recv_buffer_d into the particle arrays after the
+// n_local local particles
+void Unload_Particles_to_Transfer_GPU_function(part_int_t n_local, int n_transfer, ParticleTransferFields fields,
+                                               Real *recv_buffer_d);
 
   #endif  // PARTICLES_H
 #endif    // PARTICLES
\ No newline at end of file
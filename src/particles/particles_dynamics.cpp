@@ -8,6 +8,8 @@
   #include "../global/global.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #include "../utils/profiling_ranges.h"
+  #include "../utils/timestep_constraints.h"
   #include "math.h"
   #include "particles_3D.h"
 
@@ -48,7 +50,7 @@ Real Grid3D::Calc_Particles_dt()
   #endif  // PARTICLES_GPU
 
   Real dt_particles_global;
-  #ifdef MPI_CHOLLA
+  #if defined(MPI_CHOLLA) && defined(PARTICLES_CPU)
   dt_particles_global = ReduceRealMin(dt_particles);
   #else
   dt_particles_global = dt_particles;
@@ -59,21 +61,21 @@ Real Grid3D::Calc_Particles_dt()
 
   #ifdef PARTICLES_GPU
 
-// Go over all the particles and find dt_min in the GPU
-Real Grid3D::Calc_Particles_dt_GPU()
+// Go over all the local particles and find their maximum inverse timestep in
+// the GPU
+void Grid3D::Calc_Particles_dti_GPU()
 {
-  // set values for GPU kernels
-  int ngrid = (Particles.n_local - 1) / TPB_PARTICLES + 1;
-
-  if (ngrid > Particles.G.size_blocks_array) {
-    chprintf(" Error: particles dt_array too small\n");
-  }
-
-  Real max_dti;
-  max_dti = Particles.Calc_Particles_dt_GPU_function(
-      ngrid, Particles.n_local, Particles.G.dx, Particles.G.dy, Particles.G.dz, Particles.vel_x_dev,
-      Particles.vel_y_dev, Particles.vel_z_dev, Particles.G.dti_array_host, Particles.G.dti_array_dev);
+  Particles.Calc_Particles_dti_GPU_function(Particles.n_local, Particles.G.dx, Particles.G.dy, Particles.G.dz,
+                                            Particles.vel_x_dev, Particles.vel_y_dev, Particles.vel_z_dev,
+                                            timestep_constraints::Device_Slot(timestep_constraints::particles));
+}
 
+// Convert the maximum inverse timestep of the particles into dt_min. It was
+// already reduced over all the ranks in set_dt, and dt_min decreases with it,
+// so the result doesn't need another reduction
+Real Grid3D::Calc_Particles_dt_GPU()
+{
+  Real max_dti = Particles.max_dti;
   Real dt_min;
 
     #ifdef COSMOLOGY
@@ -86,40 +88,181 @@ Real Grid3D::Calc_Particles_dt_GPU()
   dt_min = 1 / max_dti;
     #endif
 
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  // Only the particles of the last bin are limited by their own timestep
+  dt_min *= 1 << (Particles.n_time_bins - 1);
+    #endif
+
   return Particles.C_cfl * dt_min;
 }
 
 // Update positions and velocities (step 1 of KDK scheme ) in the GPU
 void Grid3D::Advance_Particles_KDK_Step1_GPU()
 {
-    #ifdef COSMOLOGY
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  Advance_Particles_Block_Steps_GPU();
+    #elif defined(PARTICLES_KDK_FUSED)
+      #ifdef COSMOLOGY
+  Particles.Advance_Particles_KDK_Step1_Cosmo_Fused_GPU(Cosmo.current_a, Cosmo.current_a + Cosmo.delta_a / 2,
+                                                        Cosmo.kick_factor_1, Cosmo.drift_factor, streams.particles);
+      #else
+  Particles.Advance_Particles_KDK_Step1_Fused_GPU(Particles.dt, streams.particles);
+      #endif
+    #elif defined(COSMOLOGY)
   Particles.Advance_Particles_KDK_Step1_Cosmo_GPU_function(
-      Particles.n_local, Cosmo.delta_a, Particles.pos_x_dev, Particles.pos_y_dev, Particles.pos_z_dev,
-      Particles.vel_x_dev, Particles.vel_y_dev, Particles.vel_z_dev, Particles.grav_x_dev, Particles.grav_y_dev,
-      Particles.grav_z_dev, Cosmo.current_a, Cosmo.H0, Cosmo.cosmo_h, Cosmo.Omega_M, Cosmo.Omega_L, Cosmo.Omega_K);
+      Particles.n_local, Particles.pos_x_dev, Particles.pos_y_dev, Particles.pos_z_dev, Particles.vel_x_dev,
+      Particles.vel_y_dev, Particles.vel_z_dev, Particles.grav_x_dev, Particles.grav_y_dev, Particles.grav_z_dev,
+      Cosmo.current_a, Cosmo.current_a + Cosmo.delta_a / 2, Cosmo.kick_factor_1, Cosmo.drift_factor, streams.particles);
     #else
   Particles.Advance_Particles_KDK_Step1_GPU_function(Particles.n_local, Particles.dt, Particles.pos_x_dev,
                                                      Particles.pos_y_dev, Particles.pos_z_dev, Particles.vel_x_dev,
                                                      Particles.vel_y_dev, Particles.vel_z_dev, Particles.grav_x_dev,
-                                                     Particles.grav_y_dev, Particles.grav_z_dev);
+                                                     Particles.grav_y_dev, Particles.grav_z_dev, streams.particles);
     #endif
 }
 
 // Update velocities (step 2 of KDK scheme ) in the GPU
 void Grid3D::Advance_Particles_KDK_Step2_GPU()
 {
-    #ifdef COSMOLOGY
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  Close_Particles_Block_Steps_GPU();
+    #elif defined(PARTICLES_KDK_FUSED)
+      #ifdef COSMOLOGY
+  Particles.Advance_Particles_KDK_Step2_Cosmo_Fused_GPU(Cosmo.current_a - Cosmo.delta_a / 2, Cosmo.current_a,
+                                                        Cosmo.kick_factor_2, streams.particles);
+      #else
+  Particles.Advance_Particles_KDK_Step2_Fused_GPU(Particles.dt, streams.particles);
+      #endif
+    #elif defined(COSMOLOGY)
   Particles.Advance_Particles_KDK_Step2_Cosmo_GPU_function(
-      Particles.n_local, Cosmo.delta_a, Particles.vel_x_dev, Particles.vel_y_dev, Particles.vel_z_dev,
-      Particles.grav_x_dev, Particles.grav_y_dev, Particles.grav_z_dev, Cosmo.current_a, Cosmo.H0, Cosmo.cosmo_h,
-      Cosmo.Omega_M, Cosmo.Omega_L, Cosmo.Omega_K);
+      Particles.n_local, Particles.vel_x_dev, Particles.vel_y_dev, Particles.vel_z_dev, Particles.grav_x_dev,
+      Particles.grav_y_dev, Particles.grav_z_dev, Cosmo.current_a - Cosmo.delta_a / 2, Cosmo.current_a,
+      Cosmo.kick_factor_2, streams.particles);
     #else
   Particles.Advance_Particles_KDK_Step2_GPU_function(Particles.n_local, Particles.dt, Particles.vel_x_dev,
                                                      Particles.vel_y_dev, Particles.vel_z_dev, Particles.grav_x_dev,
-                                                     Particles.grav_y_dev, Particles.grav_z_dev);
+                                                     Particles.grav_y_dev, Particles.grav_z_dev, streams.particles);
     #endif
 }
 
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+// The kicks and drifts of the bins that start a substep at the given tick of
+// the last bin. The step goes from step_start over step_length, in scale
+// factor with COSMOLOGY and in time otherwise. Each bin kicks from the middle
+// of its previous substep to the middle of the next one, and the tick after
+// the last one closes the last substep of every bin with a half kick
+BlockStepFactors Grid3D::Get_Block_Step_Factors(int tick, Real step_start, Real step_length)
+{
+  int const n_ticks = 1 << (Particles.n_time_bins - 1);
+
+  // The scale factors, the two half kicks and the drift of a KDK substep
+  auto substep_factors = [&](Real start, Real end, Real &a_start, Real &a_half, Real &a_end, Real &kick_1,
+                             Real &kick_2, Real &drift) {
+      #ifdef COSMOLOGY
+    Cosmo.Get_Particles_Step_Factors(start, end, kick_1, kick_2, drift);
+    a_start = start;
+    a_half  = (start + end) / 2;
+    a_end   = end;
+      #else
+    kick_1  = (end - start) / 2;
+    kick_2  = (end - start) / 2;
+    drift   = end - start;
+    a_start = 1;
+    a_half  = 1;
+    a_end   = 1;
+      #endif  // COSMOLOGY
+  };
+
+  BlockStepFactors factors;
+  for (int bin = 0; bin < PARTICLES_MAX_TIME_BINS; bin++) {
+    factors.a_from[bin] = 1;
+    factors.a_to[bin]   = 1;
+    factors.kick[bin]   = 0;
+    factors.drift[bin]  = 0;
+
+    int const ticks_per_substep = n_ticks >> bin;
+    if (bin >= Particles.n_time_bins || tick % ticks_per_substep != 0) {
+      continue;
+    }
+    int const substep    = tick / ticks_per_substep;
+    int const n_substeps = 1 << bin;
+    Real const length    = step_length / n_substeps;
+
+    Real a_start, a_half, a_end, kick_1, kick_2, drift;
+    if (substep > 0) {
+      // The second half kick of the previous substep
+      Real const start = step_start + (substep - 1) * length;
+      substep_factors(start, start + length, a_start, a_half, a_end, kick_1, kick_2, drift);
+      factors.a_from[bin] = a_half;
+      factors.a_to[bin]   = a_end;
+      factors.kick[bin]   = kick_2;
+    }
+    if (substep < n_substeps) {
+      // The first half kick and the drift of the next substep
+      Real const start = step_start + substep * length;
+      substep_factors(start, start + length, a_start, a_half, a_end, kick_1, kick_2, drift);
+      if (substep == 0) {
+        factors.a_from[bin] = a_start;
+      }
+      factors.a_to[bin] = a_half;
+      factors.kick[bin] += kick_1;
+      factors.drift[bin] = drift;
+    }
+  }
+  return factors;
+}
+
+// Assign the time bins and advance every bin by its substeps, with the
+// gravitational field of the start of the step interpolated to the particles
+// in between. Only the particles that start a substep are launched at each
+// tick. The closing half kick is left to Close_Particles_Block_Steps_GPU
+void Grid3D::Advance_Particles_Block_Steps_GPU()
+{
+      #ifdef COSMOLOGY
+  Real const scale_factor = 1 / (Cosmo.current_a * Cosmo.Get_Hubble_Parameter(Cosmo.current_a)) * Cosmo.cosmo_h;
+  Real const vel_factor   = Cosmo.current_a / scale_factor;
+  Real const step_start   = Cosmo.current_a;
+  Real const step_length  = Cosmo.delta_a;
+  Real const step_dti     = Cosmo.delta_a / (Particles.C_cfl * vel_factor);
+      #else
+  Real const step_start  = 0;
+  Real const step_length = Particles.dt;
+  Real const step_dti    = Particles.dt / Particles.C_cfl;
+      #endif  // COSMOLOGY
+  Particles.Assign_Time_Bins_GPU(step_dti);
+
+  int const n_ticks = 1 << (Particles.n_time_bins - 1);
+  for (int tick = 0; tick < n_ticks; tick++) {
+    part_int_t const n_active = Particles.Count_Active_Particles(tick);
+    if (n_active == 0) {
+      continue;
+    }
+    // Every particle starts a substep at the first tick
+    int *const active_dev = (tick == 0) ? nullptr : Particles.sort_indices_dev[1];
+    Particles.Advance_Particles_Block_Step_GPU(n_active, active_dev,
+                                               Get_Block_Step_Factors(tick, step_start, step_length),
+                                               streams.particles);
+  }
+}
+
+// Close the last substep of every bin with the gravitational field at the new
+// positions. The time was already advanced by the step
+void Grid3D::Close_Particles_Block_Steps_GPU()
+{
+      #ifdef COSMOLOGY
+  Real const step_start  = Cosmo.current_a - Cosmo.delta_a;
+  Real const step_length = Cosmo.delta_a;
+      #else
+  Real const step_start  = 0;
+  Real const step_length = Particles.dt;
+      #endif  // COSMOLOGY
+  int const n_ticks = 1 << (Particles.n_time_bins - 1);
+  Particles.Advance_Particles_Block_Step_GPU(Particles.n_local, nullptr,
+                                             Get_Block_Step_Factors(n_ticks, step_start, step_length),
+                                             streams.particles);
+}
+    #endif  // PARTICLES_BLOCK_TIMESTEPS
+
   #endif  // PARTICLES_GPU
 
   #ifdef PARTICLES_CPU
@@ -155,6 +298,8 @@ Real Grid3D::Calc_Particles_dt_function(part_int_t p_start, part_int_t p_end)
 // Update the particles positions and velocities
 void Grid3D::Advance_Particles(int N_step)
 {
+  profiling::ScopedRange const range((N_step == 1) ? "Advance_Particles_1" : "Advance_Particles_2");
+
   GPU_Error_Check();
   #ifdef CPU_TIME
   if (N_step == 1) {
@@ -199,9 +344,11 @@ void Grid3D::Get_Particles_Acceleration()
   // First compute the gravitational field at the center of the grid cells
   Get_Gravity_Field_Particles();
 
+  #if !defined(PARTICLES_GPU) || !(defined(PARTICLES_KDK_FUSED) || defined(PARTICLES_BLOCK_TIMESTEPS))
   // Then Interpolate the gravitational field from the centers of the cells to
-  // the positions of the particles
+  // the positions of the particles. The fused and block kicks do it themselves
   Get_Gravity_CIC();
+  #endif
 }
 
 // Update positions and velocities (step 1 of KDK scheme )
@@ -340,7 +487,7 @@ Real Grid3D::Calc_Particles_dt_Cosmo()
     #endif  // PARTICLES_GPU
 
   Real dt_particles_global;
-    #ifdef MPI_CHOLLA
+    #if defined(MPI_CHOLLA) && defined(PARTICLES_CPU)
   dt_particles_global = ReduceRealMin(dt_particles);
     #else
   dt_particles_global = dt_particles;
@@ -384,19 +531,13 @@ Real Grid3D::Calc_Particles_dt_Cosmo_function(part_int_t p_start, part_int_t p_e
 // SIMULATION
 void Grid3D::Advance_Particles_KDK_Cosmo_Step1_function(part_int_t p_start, part_int_t p_end)
 {
-  Real dt, dt_half;
   part_int_t pIndx;
-  Real a       = Cosmo.current_a;
-  Real da      = Cosmo.delta_a;
-  Real da_half = da / 2;
-  Real a_half  = a + da_half;
-
-  Real H, H_half;
-  H      = Cosmo.Get_Hubble_Parameter(a);
-  H_half = Cosmo.Get_Hubble_Parameter(a_half);
+  Real a      = Cosmo.current_a;
+  Real a_half = a + Cosmo.delta_a / 2;
 
-  dt      = da / (a * H) * Cosmo.cosmo_h;
-  dt_half = da / (a_half * H_half) * Cosmo.cosmo_h / (a_half);
+  // The kick of the first half step and the drift of the whole step
+  Real kick  = Cosmo.kick_factor_1;
+  Real drift = Cosmo.drift_factor;
 
   Real pos_x, vel_x, grav_x;
   Real pos_y, vel_y, grav_y;
@@ -413,14 +554,14 @@ void Grid3D::Advance_Particles_KDK_Cosmo_Step1_function(part_int_t p_start, part
     grav_z = Particles.grav_z[pIndx];
 
     // Advance velocities by half a step
-    vel_x = (a * vel_x + 0.5 * dt * grav_x) / a_half;
-    vel_y = (a * vel_y + 0.5 * dt * grav_y) / a_half;
-    vel_z = (a * vel_z + 0.5 * dt * grav_z) / a_half;
+    vel_x = (a * vel_x + kick * grav_x) / a_half;
+    vel_y = (a * vel_y + kick * grav_y) / a_half;
+    vel_z = (a * vel_z + kick * grav_z) / a_half;
 
     // Advance the positions by delta_t using the updated velocities
-    pos_x += dt_half * vel_x;
-    pos_y += dt_half * vel_y;
-    pos_z += dt_half * vel_z;
+    pos_x += drift * vel_x;
+    pos_y += drift * vel_y;
+    pos_z += drift * vel_z;
 
     // Save the updated positions and velocities
     Particles.pos_x[pIndx] = pos_x;
@@ -436,14 +577,12 @@ void Grid3D::Advance_Particles_KDK_Cosmo_Step1_function(part_int_t p_start, part
 // Update velocities (step 2 of KDK scheme ) COSMOLOGICAL SIMULATION
 void Grid3D::Advance_Particles_KDK_Cosmo_Step2_function(part_int_t p_start, part_int_t p_end)
 {
-  Real dt;
   part_int_t pIndx;
-  Real a       = Cosmo.current_a;
-  Real da      = Cosmo.delta_a;
-  Real da_half = da / 2;
-  Real a_half  = a - da + da_half;
+  Real a      = Cosmo.current_a;
+  Real a_half = a - Cosmo.delta_a / 2;
 
-  dt = da / (a * Cosmo.Get_Hubble_Parameter(a)) * Cosmo.cosmo_h;
+  // The kick of the second half step
+  Real kick = Cosmo.kick_factor_2;
 
   Real grav_x, grav_y, grav_z;
   Real vel_x, vel_y, vel_z;
@@ -457,9 +596,9 @@ void Grid3D::Advance_Particles_KDK_Cosmo_Step2_function(part_int_t p_start, part
     vel_z = Particles.vel_z[pIndx];
 
     // Advance velocities by half a step
-    Particles.vel_x[pIndx] = (a_half * vel_x + 0.5 * dt * grav_x) / a;
-    Particles.vel_y[pIndx] = (a_half * vel_y + 0.5 * dt * grav_y) / a;
-    Particles.vel_z[pIndx] = (a_half * vel_z + 0.5 * dt * grav_z) / a;
+    Particles.vel_x[pIndx] = (a_half * vel_x + kick * grav_x) / a;
+    Particles.vel_y[pIndx] = (a_half * vel_y + kick * grav_y) / a;
+    Particles.vel_z[pIndx] = (a_half * vel_z + kick * grav_z) / a;
   }
 }
 
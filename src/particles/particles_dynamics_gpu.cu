@@ -9,109 +9,53 @@
   #include "../global/global_cuda.h"
   #include "../grid/grid3D.h"
   #include "../io/io.h"
+  #include "../utils/cuda_utilities.h"
   #include "../utils/gpu.hpp"
+  #include "../utils/reduction_utilities.h"
+  #include "gravity_CIC_gpu.h"
   #include "particles_3D.h"
 
   #ifdef COSMOLOGY
     #include "../cosmology/cosmology.h"
-// #include "../cosmology/cosmology_functions_gpu.h"
-
-// FUTURE FIX: The Hubble function was defined here because I couldn't get it
-// form other file, tried -dc flag when compiling buu paris broke.
-__device__ Real Get_Hubble_Parameter_dev(Real a, Real H0, Real Omega_M, Real Omega_L, Real Omega_K)
-{
-  Real a2     = a * a;
-  Real a3     = a2 * a;
-  Real factor = (Omega_M / a3 + Omega_K / a2 + Omega_L);
-  return H0 * sqrt(factor);
-}
   #endif
 
-__global__ void Calc_Particles_dti_Kernel(part_int_t n_local, Real dx, Real dy, Real dz, Real *vel_x_dev,
-                                          Real *vel_y_dev, Real *vel_z_dev, Real *dti_array)
+/*! \brief Find the maximum inverse timestep of the particles with a grid-stride
+ * loop. max_dti must be zeroed before the launch */
+__global__ void Calc_Particles_dti_Kernel(part_int_t n_local, Real dx, Real dy, Real dz, Real_Part *vel_x_dev,
+                                          Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *max_dti)
 {
-  __shared__ Real max_dti[TPB_PARTICLES];
-
-  part_int_t id;
-  int tid;
-
-  // get a global thread ID
-  id = blockIdx.x * blockDim.x + threadIdx.x;
-  // and a thread id within the block
-  tid = threadIdx.x;
-
-  // set shared memory to 0
-  max_dti[tid] = 0;
-  __syncthreads();
-
-  Real vx, vy, vz;
-
-  // if( tid == 0 ) printf("%f  %f  %f \n", dx, dy, dz );
-
-  // threads corresponding to real cells do the calculation
-  if (id < n_local) {
-    // every thread collects the variables it needs from global memory
-    vx           = vel_x_dev[id];
-    vy           = vel_y_dev[id];
-    vz           = vel_z_dev[id];
-    max_dti[tid] = fmax(fabs(vx) / dx, fabs(vy) / dy);
-    max_dti[tid] = fmax(max_dti[tid], fabs(vz) / dz);
-    max_dti[tid] = fmax(max_dti[tid], 0.0);
-  }
-  __syncthreads();
-
-  // do the reduction in shared memory (find the max inverse timestep in the
-  // block)
-  for (unsigned int s = 1; s < blockDim.x; s *= 2) {
-    if (tid % (2 * s) == 0) {
-      max_dti[tid] = fmax(max_dti[tid], max_dti[tid + s]);
-    }
-    __syncthreads();
+  Real dti = 0;
+  for (part_int_t id = blockIdx.x * blockDim.x + threadIdx.x; id < n_local; id += blockDim.x * gridDim.x) {
+    dti = fmax(dti, fabs(vel_x_dev[id]) / dx);
+    dti = fmax(dti, fabs(vel_y_dev[id]) / dy);
+    dti = fmax(dti, fabs(vel_z_dev[id]) / dz);
   }
 
-  // write the result for this block to global memory
-  if (tid == 0) {
-    dti_array[blockIdx.x] = max_dti[0];
-  }
+  reduction_utilities::gridReduceMax(dti, max_dti);
 }
 
-Real Particles3D::Calc_Particles_dt_GPU_function(int ngrid, part_int_t n_particles_local, Real dx, Real dy, Real dz,
-                                                 Real *vel_x, Real *vel_y, Real *vel_z, Real *dti_array_host,
-                                                 Real *dti_array_dev)
+// The maximum is reduced into max_dti_dev, a slot of timestep_constraints
+// that is zeroed after every step, and stays on the device
+void Particles3D::Calc_Particles_dti_GPU_function(part_int_t n_particles_local, Real dx, Real dy, Real dz,
+                                                  Real_Part *vel_x, Real_Part *vel_y, Real_Part *vel_z,
+                                                  Real *max_dti_dev)
 {
-  // // set values for GPU kernels
-  // int ngrid =  (Particles.n_local - 1) / TPB_PARTICLES + 1;
-  // number of blocks per 1D grid
-  dim3 dim1dGrid(ngrid, 1, 1);
-  //  number of threads per 1D block
-  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
-
-  // printf("%f %f %f \n", dx, dy, dz);
-
   // Only runs if there are local particles
-  if (ngrid == 0) {
-    return 0;
+  if (n_particles_local == 0) {
+    return;
   }
 
-  hipLaunchKernelGGL(Calc_Particles_dti_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_particles_local, dx, dy, dz, vel_x,
-                     vel_y, vel_z, dti_array_dev);
-  GPU_Error_Check();
+  cuda_utilities::AutomaticLaunchParams static const launchParams(Calc_Particles_dti_Kernel);
 
-  // Initialize dt values
-  Real max_dti = 0;
-  // copy the dti array onto the CPU
-  GPU_Error_Check(cudaMemcpy(dti_array_host, dti_array_dev, ngrid * sizeof(Real), cudaMemcpyDeviceToHost));
-  // find maximum inverse timestep from CFL condition
-  for (int i = 0; i < ngrid; i++) {
-    max_dti = fmax(max_dti, dti_array_host[i]);
-  }
-
-  return max_dti;
+  hipLaunchKernelGGL(Calc_Particles_dti_Kernel, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     n_particles_local, dx, dy, dz, vel_x, vel_y, vel_z, max_dti_dev);
+  GPU_Error_Check();
 }
 
-__global__ void Advance_Particles_KDK_Step1_Kernel(part_int_t n_local, Real dt, Real *pos_x_dev, Real *pos_y_dev,
-                                                   Real *pos_z_dev, Real *vel_x_dev, Real *vel_y_dev, Real *vel_z_dev,
-                                                   Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev)
+__global__ void Advance_Particles_KDK_Step1_Kernel(part_int_t n_local, Real dt, Real_Part *pos_x_dev,
+                                                   Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+                                                   Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                   Real *grav_y_dev, Real *grav_z_dev)
 {
   part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
   if (tid >= n_local) {
@@ -129,9 +73,9 @@ __global__ void Advance_Particles_KDK_Step1_Kernel(part_int_t n_local, Real dt,
   pos_z_dev[tid] += dt * vel_z_dev[tid];
 }
 
-__global__ void Advance_Particles_KDK_Step2_Kernel(part_int_t n_local, Real dt, Real *vel_x_dev, Real *vel_y_dev,
-                                                   Real *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev,
-                                                   Real *grav_z_dev)
+__global__ void Advance_Particles_KDK_Step2_Kernel(part_int_t n_local, Real dt, Real_Part *vel_x_dev,
+                                                   Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                   Real *grav_y_dev, Real *grav_z_dev)
 {
   part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
   if (tid >= n_local) {
@@ -144,10 +88,77 @@ __global__ void Advance_Particles_KDK_Step2_Kernel(part_int_t n_local, Real dt,
   vel_z_dev[tid] += 0.5 * dt * grav_z_dev[tid];
 }
 
-void Particles3D::Advance_Particles_KDK_Step1_GPU_function(part_int_t n_local, Real dt, Real *pos_x_dev,
-                                                           Real *pos_y_dev, Real *pos_z_dev, Real *vel_x_dev,
-                                                           Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
-                                                           Real *grav_y_dev, Real *grav_z_dev)
+    #ifdef PARTICLES_KDK_FUSED
+// Interpolate the gravitational field to the particles positions, advance the
+// velocities by half a step and then the positions by a full step
+__global__ void Advance_Particles_KDK_Step1_Fused_Kernel(part_int_t n_local, Real dt, Real_Part *pos_x_dev,
+                                                         Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+                                                         Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                                         Real_Part *vel_z_dev, Real *gravity_x_dev, Real *gravity_y_dev,
+                                                         Real *gravity_z_dev, Real xMin, Real yMin, Real zMin,
+                                                         Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz,
+                                                         int nx, int ny, int nz, int n_ghost)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  Real pos_x = pos_x_dev[tid];
+  Real pos_y = pos_y_dev[tid];
+  Real pos_z = pos_z_dev[tid];
+
+  // Particles outside the local domain are not accelerated
+  Real g_x = 0, g_y = 0, g_z = 0;
+  Interpolate_Gravity_CIC(pos_x, pos_y, pos_z, gravity_x_dev, gravity_y_dev, gravity_z_dev, xMin, yMin, zMin, xMax,
+                          yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x, g_y, g_z);
+
+  // Advance velocities by half a step
+  Real vel_x     = vel_x_dev[tid] + 0.5 * dt * g_x;
+  Real vel_y     = vel_y_dev[tid] + 0.5 * dt * g_y;
+  Real vel_z     = vel_z_dev[tid] + 0.5 * dt * g_z;
+  vel_x_dev[tid] = vel_x;
+  vel_y_dev[tid] = vel_y;
+  vel_z_dev[tid] = vel_z;
+
+  // Advance Positions using advanced velocities
+  pos_x_dev[tid] = pos_x + dt * vel_x;
+  pos_y_dev[tid] = pos_y + dt * vel_y;
+  pos_z_dev[tid] = pos_z + dt * vel_z;
+}
+
+// Interpolate the gravitational field to the particles positions and advance
+// the velocities by the second half step in the same pass
+__global__ void Advance_Particles_KDK_Step2_Fused_Kernel(part_int_t n_local, Real dt, Real_Part *pos_x_dev,
+                                                         Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+                                                         Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                                         Real_Part *vel_z_dev, Real *gravity_x_dev, Real *gravity_y_dev,
+                                                         Real *gravity_z_dev, Real xMin, Real yMin, Real zMin,
+                                                         Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz,
+                                                         int nx, int ny, int nz, int n_ghost)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  // Particles outside the local domain are not accelerated
+  Real g_x = 0, g_y = 0, g_z = 0;
+  Interpolate_Gravity_CIC(pos_x_dev[tid], pos_y_dev[tid], pos_z_dev[tid], gravity_x_dev, gravity_y_dev, gravity_z_dev,
+                          xMin, yMin, zMin, xMax, yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x, g_y, g_z);
+
+  // Advance velocities by the second half a step
+  vel_x_dev[tid] += 0.5 * dt * g_x;
+  vel_y_dev[tid] += 0.5 * dt * g_y;
+  vel_z_dev[tid] += 0.5 * dt * g_z;
+}
+    #endif  // PARTICLES_KDK_FUSED
+
+void Particles3D::Advance_Particles_KDK_Step1_GPU_function(part_int_t n_local, Real dt, Real_Part *pos_x_dev,
+                                                           Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+                                                           Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                                           Real_Part *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev,
+                                                           Real *grav_z_dev, cudaStream_t stream)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -158,15 +169,15 @@ void Particles3D::Advance_Particles_KDK_Step1_GPU_function(part_int_t n_local, R
 
   // Only runs if there are local particles
   if (n_local > 0) {
-    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, dt, pos_x_dev,
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, dt, pos_x_dev,
                        pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev, grav_z_dev);
     GPU_Error_Check();
   }
 }
 
-void Particles3D::Advance_Particles_KDK_Step2_GPU_function(part_int_t n_local, Real dt, Real *vel_x_dev,
-                                                           Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
-                                                           Real *grav_y_dev, Real *grav_z_dev)
+void Particles3D::Advance_Particles_KDK_Step2_GPU_function(part_int_t n_local, Real dt, Real_Part *vel_x_dev,
+                                                           Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                           Real *grav_y_dev, Real *grav_z_dev, cudaStream_t stream)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -177,19 +188,65 @@ void Particles3D::Advance_Particles_KDK_Step2_GPU_function(part_int_t n_local, R
 
   // Only runs if there are local particles
   if (n_local > 0) {
-    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, dt, vel_x_dev,
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, dt, vel_x_dev,
                        vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev, grav_z_dev);
     GPU_Error_Check();
   }
 }
 
+    #ifdef PARTICLES_KDK_FUSED
+void Particles3D::Advance_Particles_KDK_Step1_Fused_GPU(Real dt, cudaStream_t stream)
+{
+  // set values for GPU kernels
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  // number of blocks per 1D grid
+  dim3 dim1dGrid(ngrid, 1, 1);
+  //  number of threads per 1D block
+  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
+
+  // Only runs if there are local particles
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Fused_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, dt,
+                       pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, G.gravity_x_dev,
+                       G.gravity_y_dev, G.gravity_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                       G.zMin - G.pos_origin_z, G.xMax - G.pos_origin_x, G.yMax - G.pos_origin_y,
+                       G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                       G.n_ghost_particles_grid);
+    GPU_Error_Check();
+  }
+}
+
+void Particles3D::Advance_Particles_KDK_Step2_Fused_GPU(Real dt, cudaStream_t stream)
+{
+  // set values for GPU kernels
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  // number of blocks per 1D grid
+  dim3 dim1dGrid(ngrid, 1, 1);
+  //  number of threads per 1D block
+  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
+
+  // Only runs if there are local particles
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Fused_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, dt,
+                       pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, G.gravity_x_dev,
+                       G.gravity_y_dev, G.gravity_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                       G.zMin - G.pos_origin_z, G.xMax - G.pos_origin_x, G.yMax - G.pos_origin_y,
+                       G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                       G.n_ghost_particles_grid);
+    GPU_Error_Check();
+  }
+}
+    #endif  // PARTICLES_KDK_FUSED
+
   #ifdef COSMOLOGY
 
-__global__ void Advance_Particles_KDK_Step1_Cosmo_Kernel(part_int_t n_local, Real da, Real *pos_x_dev, Real *pos_y_dev,
-                                                         Real *pos_z_dev, Real *vel_x_dev, Real *vel_y_dev,
-                                                         Real *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev,
-                                                         Real *grav_z_dev, Real current_a, Real H0, Real cosmo_h,
-                                                         Real Omega_M, Real Omega_L, Real Omega_K)
+// The kick of the first half step and the drift of the whole step of
+// Cosmology::Set_Particles_Step_Factors are the same for all the particles
+__global__ void Advance_Particles_KDK_Step1_Cosmo_Kernel(part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                                         Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+                                                         Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                         Real *grav_y_dev, Real *grav_z_dev, Real current_a,
+                                                         Real a_half, Real kick, Real drift)
 {
   part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
   if (tid >= n_local) {
@@ -201,68 +258,105 @@ __global__ void Advance_Particles_KDK_Step1_Cosmo_Kernel(part_int_t n_local, Rea
   vel_y = vel_y_dev[tid];
   vel_z = vel_z_dev[tid];
 
-  Real da_half, a_half, H, H_half, dt, dt_half;
-  da_half = da / 2;
-  a_half  = current_a + da_half;
+  // Advance velocities by half a step
+  vel_x          = (current_a * vel_x + kick * grav_x_dev[tid]) / a_half;
+  vel_y          = (current_a * vel_y + kick * grav_y_dev[tid]) / a_half;
+  vel_z          = (current_a * vel_z + kick * grav_z_dev[tid]) / a_half;
+  vel_x_dev[tid] = vel_x;
+  vel_y_dev[tid] = vel_y;
+  vel_z_dev[tid] = vel_z;
 
-  H      = Get_Hubble_Parameter_dev(current_a, H0, Omega_M, Omega_L, Omega_K);
-  H_half = Get_Hubble_Parameter_dev(a_half, H0, Omega_M, Omega_L, Omega_K);
+  // Advance Positions using advanced velocities
+  pos_x_dev[tid] += drift * vel_x;
+  pos_y_dev[tid] += drift * vel_y;
+  pos_z_dev[tid] += drift * vel_z;
+}
 
-  dt      = da / (current_a * H) * cosmo_h;
-  dt_half = da / (a_half * H_half) * cosmo_h / (a_half);
+__global__ void Advance_Particles_KDK_Step2_Cosmo_Kernel(part_int_t n_local, Real_Part *vel_x_dev,
+                                                         Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *grav_x_dev,
+                                                         Real *grav_y_dev, Real *grav_z_dev, Real a_half,
+                                                         Real current_a, Real kick)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  // Advance velocities by the second half a step
+  vel_x_dev[tid] = (a_half * vel_x_dev[tid] + kick * grav_x_dev[tid]) / current_a;
+  vel_y_dev[tid] = (a_half * vel_y_dev[tid] + kick * grav_y_dev[tid]) / current_a;
+  vel_z_dev[tid] = (a_half * vel_z_dev[tid] + kick * grav_z_dev[tid]) / current_a;
+}
+
+    #ifdef PARTICLES_KDK_FUSED
+// Interpolate the gravitational field to the particles positions, advance the
+// velocities by half a step and then the positions by a full step
+__global__ void Advance_Particles_KDK_Step1_Cosmo_Fused_Kernel(
+    part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+    Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *gravity_x_dev, Real *gravity_y_dev, Real *gravity_z_dev,
+    Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz, int nx, int ny, int nz,
+    int n_ghost, Real current_a, Real a_half, Real kick, Real drift)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
 
-  // if ( tid == 0 ) printf( "dt: %f\n", dt);
-  // if ( tid == 0 ) printf( "pos_x: %f\n", pos_x_dev[tid]);
-  // if ( tid == 0 ) printf( "vel_x: %f\n", vel_x_dev[tid]);
-  // if ( tid == 0 ) printf( "grav_x: %f\n", grav_x_dev[tid]);
+  Real pos_x = pos_x_dev[tid];
+  Real pos_y = pos_y_dev[tid];
+  Real pos_z = pos_z_dev[tid];
+
+  // Particles outside the local domain are not accelerated
+  Real g_x = 0, g_y = 0, g_z = 0;
+  Interpolate_Gravity_CIC(pos_x, pos_y, pos_z, gravity_x_dev, gravity_y_dev, gravity_z_dev, xMin, yMin, zMin, xMax,
+                          yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x, g_y, g_z);
 
   // Advance velocities by half a step
-  vel_x          = (current_a * vel_x + 0.5 * dt * grav_x_dev[tid]) / a_half;
-  vel_y          = (current_a * vel_y + 0.5 * dt * grav_y_dev[tid]) / a_half;
-  vel_z          = (current_a * vel_z + 0.5 * dt * grav_z_dev[tid]) / a_half;
+  Real vel_x     = (current_a * vel_x_dev[tid] + kick * g_x) / a_half;
+  Real vel_y     = (current_a * vel_y_dev[tid] + kick * g_y) / a_half;
+  Real vel_z     = (current_a * vel_z_dev[tid] + kick * g_z) / a_half;
   vel_x_dev[tid] = vel_x;
   vel_y_dev[tid] = vel_y;
   vel_z_dev[tid] = vel_z;
 
   // Advance Positions using advanced velocities
-  pos_x_dev[tid] += dt_half * vel_x;
-  pos_y_dev[tid] += dt_half * vel_y;
-  pos_z_dev[tid] += dt_half * vel_z;
+  pos_x_dev[tid] = pos_x + drift * vel_x;
+  pos_y_dev[tid] = pos_y + drift * vel_y;
+  pos_z_dev[tid] = pos_z + drift * vel_z;
 }
 
-__global__ void Advance_Particles_KDK_Step2_Cosmo_Kernel(part_int_t n_local, Real da, Real *vel_x_dev, Real *vel_y_dev,
-                                                         Real *vel_z_dev, Real *grav_x_dev, Real *grav_y_dev,
-                                                         Real *grav_z_dev, Real current_a, Real H0, Real cosmo_h,
-                                                         Real Omega_M, Real Omega_L, Real Omega_K)
+// Interpolate the gravitational field to the particles positions and advance
+// the velocities by the second half step in the same pass
+__global__ void Advance_Particles_KDK_Step2_Cosmo_Fused_Kernel(
+    part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev, Real_Part *pos_z_dev, Real_Part *vel_x_dev,
+    Real_Part *vel_y_dev, Real_Part *vel_z_dev, Real *gravity_x_dev, Real *gravity_y_dev, Real *gravity_z_dev,
+    Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax, Real dx, Real dy, Real dz, int nx, int ny, int nz,
+    int n_ghost, Real a_half, Real current_a, Real kick)
 {
   part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
   if (tid >= n_local) {
     return;
   }
 
-  Real vel_x, vel_y, vel_z;
-  vel_x = vel_x_dev[tid];
-  vel_y = vel_y_dev[tid];
-  vel_z = vel_z_dev[tid];
-
-  Real da_half, a_half, dt;
-  da_half = da / 2;
-  a_half  = current_a - da_half;
-
-  dt = da / (current_a * Get_Hubble_Parameter_dev(current_a, H0, Omega_M, Omega_L, Omega_K)) * cosmo_h;
+  // Particles outside the local domain are not accelerated
+  Real g_x = 0, g_y = 0, g_z = 0;
+  Interpolate_Gravity_CIC(pos_x_dev[tid], pos_y_dev[tid], pos_z_dev[tid], gravity_x_dev, gravity_y_dev, gravity_z_dev,
+                          xMin, yMin, zMin, xMax, yMax, zMax, dx, dy, dz, nx, ny, nz, n_ghost, g_x, g_y, g_z);
 
   // Advance velocities by the second half a step
-  vel_x_dev[tid] = (a_half * vel_x + 0.5 * dt * grav_x_dev[tid]) / current_a;
-  vel_y_dev[tid] = (a_half * vel_y + 0.5 * dt * grav_y_dev[tid]) / current_a;
-  vel_z_dev[tid] = (a_half * vel_z + 0.5 * dt * grav_z_dev[tid]) / current_a;
+  vel_x_dev[tid] = (a_half * vel_x_dev[tid] + kick * g_x) / current_a;
+  vel_y_dev[tid] = (a_half * vel_y_dev[tid] + kick * g_y) / current_a;
+  vel_z_dev[tid] = (a_half * vel_z_dev[tid] + kick * g_z) / current_a;
 }
+    #endif  // PARTICLES_KDK_FUSED
 
-void Particles3D::Advance_Particles_KDK_Step1_Cosmo_GPU_function(part_int_t n_local, Real delta_a, Real *pos_x_dev,
-                                                                 Real *pos_y_dev, Real *pos_z_dev, Real *vel_x_dev,
-                                                                 Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
+void Particles3D::Advance_Particles_KDK_Step1_Cosmo_GPU_function(part_int_t n_local, Real_Part *pos_x_dev,
+                                                                 Real_Part *pos_y_dev, Real_Part *pos_z_dev,
+                                                                 Real_Part *vel_x_dev, Real_Part *vel_y_dev,
+                                                                 Real_Part *vel_z_dev, Real *grav_x_dev,
                                                                  Real *grav_y_dev, Real *grav_z_dev, Real current_a,
-                                                                 Real H0, Real cosmo_h, Real Omega_M, Real Omega_L,
-                                                                 Real Omega_K)
+                                                                 Real a_half, Real kick, Real drift,
+                                                                 cudaStream_t stream)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -273,19 +367,19 @@ void Particles3D::Advance_Particles_KDK_Step1_Cosmo_GPU_function(part_int_t n_lo
 
   // Only runs if there are local particles
   if (n_local > 0) {
-    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Cosmo_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, delta_a,
-                       pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev,
-                       grav_z_dev, current_a, H0, cosmo_h, Omega_M, Omega_L, Omega_K);
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Cosmo_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, pos_x_dev,
+                       pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev, grav_z_dev,
+                       current_a, a_half, kick, drift);
     GPU_Error_Check(cudaDeviceSynchronize());
     // GPU_Error_Check();
   }
 }
 
-void Particles3D::Advance_Particles_KDK_Step2_Cosmo_GPU_function(part_int_t n_local, Real delta_a, Real *vel_x_dev,
-                                                                 Real *vel_y_dev, Real *vel_z_dev, Real *grav_x_dev,
-                                                                 Real *grav_y_dev, Real *grav_z_dev, Real current_a,
-                                                                 Real H0, Real cosmo_h, Real Omega_M, Real Omega_L,
-                                                                 Real Omega_K)
+void Particles3D::Advance_Particles_KDK_Step2_Cosmo_GPU_function(part_int_t n_local, Real_Part *vel_x_dev,
+                                                                 Real_Part *vel_y_dev, Real_Part *vel_z_dev,
+                                                                 Real *grav_x_dev, Real *grav_y_dev, Real *grav_z_dev,
+                                                                 Real a_half, Real current_a, Real kick,
+                                                                 cudaStream_t stream)
 {
   // set values for GPU kernels
   int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
@@ -296,14 +390,60 @@ void Particles3D::Advance_Particles_KDK_Step2_Cosmo_GPU_function(part_int_t n_lo
 
   // Only runs if there are local particles
   if (n_local > 0) {
-    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Cosmo_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, delta_a,
-                       vel_x_dev, vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev, grav_z_dev, current_a, H0, cosmo_h,
-                       Omega_M, Omega_L, Omega_K);
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Cosmo_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local, vel_x_dev,
+                       vel_y_dev, vel_z_dev, grav_x_dev, grav_y_dev, grav_z_dev, a_half, current_a, kick);
     GPU_Error_Check(cudaDeviceSynchronize());
     // GPU_Error_Check();
   }
 }
 
+
+    #ifdef PARTICLES_KDK_FUSED
+void Particles3D::Advance_Particles_KDK_Step1_Cosmo_Fused_GPU(Real current_a, Real a_half, Real kick, Real drift,
+                                                              cudaStream_t stream)
+{
+  // set values for GPU kernels
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  // number of blocks per 1D grid
+  dim3 dim1dGrid(ngrid, 1, 1);
+  //  number of threads per 1D block
+  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
+
+  // Only runs if there are local particles
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step1_Cosmo_Fused_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local,
+                       pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, G.gravity_x_dev,
+                       G.gravity_y_dev, G.gravity_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                       G.zMin - G.pos_origin_z, G.xMax - G.pos_origin_x, G.yMax - G.pos_origin_y,
+                       G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                       G.n_ghost_particles_grid, current_a, a_half, kick, drift);
+    GPU_Error_Check(cudaDeviceSynchronize());
+  }
+}
+
+void Particles3D::Advance_Particles_KDK_Step2_Cosmo_Fused_GPU(Real a_half, Real current_a, Real kick,
+                                                              cudaStream_t stream)
+{
+  // set values for GPU kernels
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  // number of blocks per 1D grid
+  dim3 dim1dGrid(ngrid, 1, 1);
+  //  number of threads per 1D block
+  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
+
+  // Only runs if there are local particles
+  if (n_local > 0) {
+    hipLaunchKernelGGL(Advance_Particles_KDK_Step2_Cosmo_Fused_Kernel, dim1dGrid, dim1dBlock, 0, stream, n_local,
+                       pos_x_dev, pos_y_dev, pos_z_dev, vel_x_dev, vel_y_dev, vel_z_dev, G.gravity_x_dev,
+                       G.gravity_y_dev, G.gravity_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y,
+                       G.zMin - G.pos_origin_z, G.xMax - G.pos_origin_x, G.yMax - G.pos_origin_y,
+                       G.zMax - G.pos_origin_z, G.dx, G.dy, G.dz, G.nx_local, G.ny_local, G.nz_local,
+                       G.n_ghost_particles_grid, a_half, current_a, kick);
+    GPU_Error_Check(cudaDeviceSynchronize());
+  }
+}
+    #endif  // PARTICLES_KDK_FUSED
+
   #endif  // COSMOLOGY
 
 #endif
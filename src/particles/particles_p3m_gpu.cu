@@ -0,0 +1,490 @@
+#if defined(PARTICLES) && defined(PARTICLES_P3M)
+
+  #include <algorithm>
+  #include <climits>
+
+  #ifdef O_HIP
+    #include <hipcub/hipcub.hpp>
+namespace cub = hipcub;
+  #else
+    #include <cub/cub.cuh>
+  #endif  // O_HIP
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "../utils/gpu_arrays_functions.h"
+  #include "particles_3D.h"
+
+  #ifdef MPI_CHOLLA
+    #include "../mpi/mpi_routines.h"
+  #endif
+
+  // Number of values of each source: the position and the mass
+  #define P3M_N_DATA 4
+  // Threads per block of the force kernel, which needs more registers than the
+  // other particle kernels
+  #define TPB_P3M 256
+
+/*! \brief Acceleration between two particles at a squared distance r2 below
+ * the cutoff a, per unit mass, G and separation vector. It's the softened
+ * direct force minus the force between two S2 spheres of diameter a, which is
+ * what the mesh resolves (Hockney & Eastwood 1988, eq. 8-22). The difference
+ * goes to zero at r = a */
+__device__ Real P3M_Short_Range_Force(Real r2, Real a, Real eps2)
+{
+  Real const r      = sqrt(r2);
+  Real const soft2  = r2 + eps2;
+  Real const direct = 1 / (soft2 * sqrt(soft2));
+
+  Real const xi = 2 * r / a;
+  Real s2;
+  if (xi <= 1) {
+    s2 = xi * (224 + xi * xi * (-224 + xi * (70 + xi * (48 - 21 * xi))));
+  } else {
+    s2 = 12 / (xi * xi) - 224 + xi * (896 + xi * (-840 + xi * (224 + xi * (70 + xi * (-48 + 7 * xi)))));
+  }
+  return direct - s2 / (35 * a * a * r);
+}
+
+/*! \brief Pack the local particles as sources at the start of sources_dev */
+__global__ void Load_P3M_Local_Sources_Kernel(part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                              Real_Part *pos_z_dev, Real origin_x, Real origin_y, Real origin_z,
+                                              Real *mass_dev, Real particle_mass, Real *sources_dev)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+  sources_dev[P3M_N_DATA * tid + 0] = pos_x_dev[tid] + origin_x;
+  sources_dev[P3M_N_DATA * tid + 1] = pos_y_dev[tid] + origin_y;
+  sources_dev[P3M_N_DATA * tid + 2] = pos_z_dev[tid] + origin_z;
+  sources_dev[P3M_N_DATA * tid + 3] = (mass_dev == NULL) ? particle_mass : mass_dev[tid];
+}
+
+/*! \brief Flag the sources inside the local domain along the direction and
+ * within width of the lower (side 0) or upper (side 1) face */
+__global__ void Get_P3M_Halo_Flags_Kernel(int n_sources, int direction, int side, Real d_min, Real d_max, Real width,
+                                          Real *sources_dev, bool *flags_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  Real const pos = sources_dev[P3M_N_DATA * tid + direction];
+  if (side == 0) {
+    flags_dev[tid] = pos >= d_min && pos < d_min + width;
+  } else {
+    flags_dev[tid] = pos < d_max && pos >= d_max - width;
+  }
+}
+
+/*! \brief Copy the sources at indices_dev into the buffer */
+__global__ void Gather_P3M_Sources_Kernel(int n_gather, int *indices_dev, Real *sources_dev, Real *buffer_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_gather) {
+    return;
+  }
+  int const id = indices_dev[tid];
+  for (int i = 0; i < P3M_N_DATA; i++) {
+    buffer_dev[P3M_N_DATA * tid + i] = sources_dev[P3M_N_DATA * id + i];
+  }
+}
+
+/*! \brief Move the received halo sources across the periodic boundary when
+ * they come from the other end of the global domain. The sources sent from
+ * the lower (side 0) faces of the neighbors lie above d_max, and the ones
+ * from the upper faces below d_min */
+__global__ void Wrap_P3M_Halo_Sources_Kernel(int n_recv, int direction, int side, Real d_min, Real d_max,
+                                             Real length, Real *recv_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_recv) {
+    return;
+  }
+  Real &pos = recv_dev[P3M_N_DATA * tid + direction];
+  if (side == 0 && pos < d_max) {
+    pos += length;
+  }
+  if (side == 1 && pos >= d_min) {
+    pos -= length;
+  }
+}
+
+/*! \brief Compute the linear index of the cell of each source in the local
+ * grid extended by ng_x, ng_y and ng_z cells on each side */
+__global__ void Get_P3M_Cell_Keys_Kernel(int n_sources, Real *sources_dev, Real xMin, Real yMin, Real zMin, Real dx,
+                                         Real dy, Real dz, int ng_x, int ng_y, int ng_z, int nx_ext, int ny_ext,
+                                         int nz_ext, int *keys_dev, int *indices_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const i = min(max(int(floor((sources_dev[P3M_N_DATA * tid + 0] - xMin) / dx)) + ng_x, 0), nx_ext - 1);
+  int const j = min(max(int(floor((sources_dev[P3M_N_DATA * tid + 1] - yMin) / dy)) + ng_y, 0), ny_ext - 1);
+  int const k = min(max(int(floor((sources_dev[P3M_N_DATA * tid + 2] - zMin) / dz)) + ng_z, 0), nz_ext - 1);
+
+  keys_dev[tid]    = i + nx_ext * (j + ny_ext * k);
+  indices_dev[tid] = tid;
+}
+
+/*! \brief Set the range of the sorted sources of each occupied cell */
+__global__ void Get_P3M_Cell_Ranges_Kernel(int n_sources, int *keys_dev, int *cell_start_dev, int *cell_end_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  int const key = keys_dev[tid];
+  if (tid == 0 || keys_dev[tid - 1] != key) {
+    cell_start_dev[key] = tid;
+  }
+  if (tid == n_sources - 1 || keys_dev[tid + 1] != key) {
+    cell_end_dev[key] = tid + 1;
+  }
+}
+
+/*! \brief Add the short-range acceleration from the sources within the cutoff
+ * to every local particle. The threads follow the sorted sources, so the
+ * threads of a block search the same cells */
+__global__ void Add_P3M_Short_Range_Force_Kernel(int n_sources, part_int_t n_local, Real *sorted_dev, int *keys_dev,
+                                                 int *indices_dev, int *cell_start_dev, int *cell_end_dev, int nx_ext,
+                                                 int ny_ext, int nz_ext, int ng_x, int ng_y, int ng_z, Real cutoff,
+                                                 Real eps2, Real Gconst, Real *grav_x_dev, Real *grav_y_dev,
+                                                 Real *grav_z_dev)
+{
+  int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_sources) {
+    return;
+  }
+  // The halo sources only act on the local particles
+  int const id = indices_dev[tid];
+  if (id >= n_local) {
+    return;
+  }
+
+  Real const x = sorted_dev[P3M_N_DATA * tid + 0];
+  Real const y = sorted_dev[P3M_N_DATA * tid + 1];
+  Real const z = sorted_dev[P3M_N_DATA * tid + 2];
+
+  int const key = keys_dev[tid];
+  int const ci  = key % nx_ext;
+  int const cj  = (key / nx_ext) % ny_ext;
+  int const ck  = key / (nx_ext * ny_ext);
+
+  Real const cutoff2 = cutoff * cutoff;
+  Real acc_x = 0, acc_y = 0, acc_z = 0;
+  for (int k = max(ck - ng_z, 0); k <= min(ck + ng_z, nz_ext - 1); k++) {
+    for (int j = max(cj - ng_y, 0); j <= min(cj + ng_y, ny_ext - 1); j++) {
+      for (int i = max(ci - ng_x, 0); i <= min(ci + ng_x, nx_ext - 1); i++) {
+        int const cell = i + nx_ext * (j + ny_ext * k);
+        for (int s = cell_start_dev[cell]; s < cell_end_dev[cell]; s++) {
+          Real const rx = sorted_dev[P3M_N_DATA * s + 0] - x;
+          Real const ry = sorted_dev[P3M_N_DATA * s + 1] - y;
+          Real const rz = sorted_dev[P3M_N_DATA * s + 2] - z;
+          Real const r2 = rx * rx + ry * ry + rz * rz;
+          // Skips the particle itself
+          if (r2 == 0 || r2 >= cutoff2) {
+            continue;
+          }
+          Real const f = sorted_dev[P3M_N_DATA * s + 3] * P3M_Short_Range_Force(r2, cutoff, eps2);
+          acc_x += f * rx;
+          acc_y += f * ry;
+          acc_z += f * rz;
+        }
+      }
+    }
+  }
+
+  grav_x_dev[id] += Gconst * acc_x;
+  grav_y_dev[id] += Gconst * acc_y;
+  grav_z_dev[id] += Gconst * acc_z;
+}
+
+/*! \brief Grow the temporary storage of the cub calls to at least bytes */
+static void Reserve_P3M_Temp(void **temp_dev, size_t *temp_bytes, size_t bytes)
+{
+  if (bytes > *temp_bytes) {
+    cuda_utilities::Pool_Free(*temp_dev);
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+    cuda_utilities::Pool_Malloc(temp_dev, bytes);
+    *temp_bytes = bytes;
+  }
+}
+
+void Particles3D::Initialize_P3M_GPU(struct Parameters *P)
+{
+  p3m_cutoff    = P->p3m_cutoff;
+  p3m_softening = P->p3m_softening;
+
+  // The halo comes from the neighbors across the MPI boundaries, and from this
+  // rank across the periodic boundaries when it's alone in that direction
+  int const flags[6] = {P->xl_bcnd, P->xu_bcnd, P->yl_bcnd, P->yu_bcnd, P->zl_bcnd, P->zu_bcnd};
+  for (int face = 0; face < 6; face++) {
+    p3m_neighbors[face] = -1;
+    #ifdef MPI_CHOLLA
+    if (flags[face] == 5 || flags[face] == 1) {
+      p3m_neighbors[face] = dest[face];
+    }
+    #else
+    if (flags[face] == 1) {
+      p3m_neighbors[face] = 0;
+    }
+    #endif  // MPI_CHOLLA
+  }
+
+  Real const cutoff = p3m_cutoff * fmax(G.dx, fmax(G.dy, G.dz));
+  if (cutoff > G.xMax - G.xMin || cutoff > G.yMax - G.yMin || cutoff > G.zMax - G.zMin) {
+    CHOLLA_ERROR("The P3M cutoff %e is larger than the local domain", cutoff);
+  }
+  int const ng_x = ceil(cutoff / G.dx);
+  int const ng_y = ceil(cutoff / G.dy);
+  int const ng_z = ceil(cutoff / G.dz);
+  p3m_n_cells    = (G.nx_local + 2 * ng_x) * (G.ny_local + 2 * ng_y) * (G.nz_local + 2 * ng_z);
+  Allocate_Particles_GPU_Array_int(&p3m_cell_start_dev, p3m_n_cells);
+  Allocate_Particles_GPU_Array_int(&p3m_cell_end_dev, p3m_n_cells);
+
+  // The source arrays are allocated the first time the forces are computed
+  p3m_n_sources      = 0;
+  p3m_sources_size   = 0;
+  p3m_sources_dev    = NULL;
+  p3m_sorted_dev     = NULL;
+  p3m_keys_dev[0]    = NULL;
+  p3m_keys_dev[1]    = NULL;
+  p3m_indices_dev[0] = NULL;
+  p3m_indices_dev[1] = NULL;
+  p3m_flags_dev      = NULL;
+  p3m_send_size      = 0;
+  p3m_send_dev       = NULL;
+  p3m_temp_dev       = NULL;
+  p3m_temp_bytes     = 0;
+  Allocate_Particles_GPU_Array_int(&p3m_n_selected_dev, 1);
+
+  chprintf(" P3M cutoff: %f  softening: %f \n", cutoff, p3m_softening * fmax(G.dx, fmax(G.dy, G.dz)));
+}
+
+void Particles3D::Free_P3M_GPU()
+{
+  cuda_utilities::Pool_Free(p3m_sources_dev);
+  cuda_utilities::Pool_Free(p3m_sorted_dev);
+  cuda_utilities::Pool_Free(p3m_keys_dev[0]);
+  cuda_utilities::Pool_Free(p3m_keys_dev[1]);
+  cuda_utilities::Pool_Free(p3m_indices_dev[0]);
+  cuda_utilities::Pool_Free(p3m_indices_dev[1]);
+  cuda_utilities::Pool_Free(p3m_flags_dev);
+  cuda_utilities::Pool_Free(p3m_n_selected_dev);
+  cuda_utilities::Pool_Free(p3m_send_dev);
+  cuda_utilities::Pool_Free(p3m_cell_start_dev);
+  cuda_utilities::Pool_Free(p3m_cell_end_dev);
+  cuda_utilities::Pool_Free(p3m_temp_dev);
+}
+
+/*! \brief Grow the source arrays to hold at least n_sources, keeping the
+ * sources already loaded */
+void Particles3D::Reserve_P3M_Sources_GPU(int n_sources)
+{
+  if (n_sources <= p3m_sources_size) {
+    return;
+  }
+  int const new_size = std::max(n_sources, (int)(G.gpu_growth_factor * p3m_sources_size));
+  Resize_GPU_Array(&p3m_sources_dev, P3M_N_DATA * p3m_sources_size, P3M_N_DATA * new_size);
+
+  // The other arrays are filled again every time they are used
+  cuda_utilities::Pool_Free(p3m_sorted_dev);
+  cuda_utilities::Pool_Free(p3m_keys_dev[0]);
+  cuda_utilities::Pool_Free(p3m_keys_dev[1]);
+  cuda_utilities::Pool_Free(p3m_indices_dev[0]);
+  cuda_utilities::Pool_Free(p3m_indices_dev[1]);
+  cuda_utilities::Pool_Free(p3m_flags_dev);
+  Allocate_Particles_GPU_Array_Real(&p3m_sorted_dev, P3M_N_DATA * new_size);
+  Allocate_Particles_GPU_Array_int(&p3m_keys_dev[0], new_size);
+  Allocate_Particles_GPU_Array_int(&p3m_keys_dev[1], new_size);
+  Allocate_Particles_GPU_Array_int(&p3m_indices_dev[0], new_size);
+  Allocate_Particles_GPU_Array_int(&p3m_indices_dev[1], new_size);
+  Allocate_Particles_GPU_Array_bool(&p3m_flags_dev, new_size);
+  p3m_sources_size = new_size;
+}
+
+/*! \brief Send the sources within cutoff of one face to the neighbor across
+ * it, and append the sources received from the neighbor across the opposite
+ * face. Going through the x, y and z faces in order also fills the edges and
+ * corners of the halo, since the later directions send the earlier halos */
+void Particles3D::Exchange_P3M_Halo_GPU(int direction, int side, Real cutoff)
+{
+  int const face     = 2 * direction + side;
+  int const opposite = 2 * direction + 1 - side;
+
+  Real d_min, d_max, length;
+  if (direction == 0) {
+    d_min  = G.xMin;
+    d_max  = G.xMax;
+    length = G.domainMax_x - G.domainMin_x;
+  }
+  if (direction == 1) {
+    d_min  = G.yMin;
+    d_max  = G.yMax;
+    length = G.domainMax_y - G.domainMin_y;
+  }
+  if (direction == 2) {
+    d_min  = G.zMin;
+    d_max  = G.zMax;
+    length = G.domainMax_z - G.domainMin_z;
+  }
+
+  // Select and pack the sources next to the face
+  int n_send = 0;
+  if (p3m_neighbors[face] >= 0 && p3m_n_sources > 0) {
+    int ngrid = (p3m_n_sources - 1) / TPB_PARTICLES + 1;
+    hipLaunchKernelGGL(Get_P3M_Halo_Flags_Kernel, ngrid, TPB_PARTICLES, 0, 0, p3m_n_sources, direction, side, d_min,
+                       d_max, cutoff, p3m_sources_dev, p3m_flags_dev);
+    GPU_Error_Check();
+
+    cub::CountingInputIterator<int> source_ids(0);
+    size_t temp_bytes = 0;
+    GPU_Error_Check(cub::DevicePartition::Flagged(nullptr, temp_bytes, source_ids, p3m_flags_dev, p3m_indices_dev[0],
+                                                  p3m_n_selected_dev, p3m_n_sources));
+    Reserve_P3M_Temp(&p3m_temp_dev, &p3m_temp_bytes, temp_bytes);
+    GPU_Error_Check(cub::DevicePartition::Flagged(p3m_temp_dev, temp_bytes, source_ids, p3m_flags_dev,
+                                                  p3m_indices_dev[0], p3m_n_selected_dev, p3m_n_sources));
+    GPU_Error_Check(cudaMemcpy(&n_send, p3m_n_selected_dev, sizeof(int), cudaMemcpyDeviceToHost));
+
+    if (P3M_N_DATA * n_send > p3m_send_size) {
+      int const new_size = std::max(P3M_N_DATA * n_send, (int)(G.gpu_growth_factor * p3m_send_size));
+      cuda_utilities::Pool_Free(p3m_send_dev);
+      Allocate_Particles_GPU_Array_Real(&p3m_send_dev, new_size);
+      p3m_send_size = new_size;
+    }
+    if (n_send > 0) {
+      ngrid = (n_send - 1) / TPB_PARTICLES + 1;
+      hipLaunchKernelGGL(Gather_P3M_Sources_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_send, p3m_indices_dev[0],
+                         p3m_sources_dev, p3m_send_dev);
+      GPU_Error_Check();
+    }
+  }
+
+  int n_recv = 0;
+    #ifdef MPI_CHOLLA
+  int const dest_rank   = (p3m_neighbors[face] >= 0) ? p3m_neighbors[face] : MPI_PROC_NULL;
+  int const source_rank = (p3m_neighbors[opposite] >= 0) ? p3m_neighbors[opposite] : MPI_PROC_NULL;
+  MPI_Sendrecv(&n_send, 1, MPI_INT, dest_rank, face, &n_recv, 1, MPI_INT, source_rank, face, world, MPI_STATUS_IGNORE);
+  Reserve_P3M_Sources_GPU(p3m_n_sources + n_recv);
+  Real *recv_dev = p3m_sources_dev + P3M_N_DATA * p3m_n_sources;
+      #ifdef MPI_GPU
+  MPI_Sendrecv(p3m_send_dev, P3M_N_DATA * n_send, MPI_CHREAL, dest_rank, face, recv_dev, P3M_N_DATA * n_recv,
+               MPI_CHREAL, source_rank, face, world, MPI_STATUS_IGNORE);
+      #else
+  p3m_send_host.resize(P3M_N_DATA * n_send);
+  p3m_recv_host.resize(P3M_N_DATA * n_recv);
+  if (n_send > 0) {
+    GPU_Error_Check(cudaMemcpy(p3m_send_host.data(), p3m_send_dev, P3M_N_DATA * n_send * sizeof(Real),
+                               cudaMemcpyDeviceToHost));
+  }
+  MPI_Sendrecv(p3m_send_host.data(), P3M_N_DATA * n_send, MPI_CHREAL, dest_rank, face, p3m_recv_host.data(),
+               P3M_N_DATA * n_recv, MPI_CHREAL, source_rank, face, world, MPI_STATUS_IGNORE);
+  if (n_recv > 0) {
+    GPU_Error_Check(cudaMemcpy(recv_dev, p3m_recv_host.data(), P3M_N_DATA * n_recv * sizeof(Real),
+                               cudaMemcpyHostToDevice));
+  }
+      #endif  // MPI_GPU
+    #else
+  // Without MPI the only neighbor is this process across a periodic boundary
+  if (p3m_neighbors[opposite] >= 0) {
+    n_recv = n_send;
+  }
+  Reserve_P3M_Sources_GPU(p3m_n_sources + n_recv);
+  Real *recv_dev = p3m_sources_dev + P3M_N_DATA * p3m_n_sources;
+  if (n_recv > 0) {
+    GPU_Error_Check(
+        cudaMemcpy(recv_dev, p3m_send_dev, P3M_N_DATA * n_recv * sizeof(Real), cudaMemcpyDeviceToDevice));
+  }
+    #endif  // MPI_CHOLLA
+
+  if (n_recv > 0) {
+    int ngrid = (n_recv - 1) / TPB_PARTICLES + 1;
+    hipLaunchKernelGGL(Wrap_P3M_Halo_Sources_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_recv, direction, side, d_min,
+                       d_max, length, recv_dev);
+    GPU_Error_Check();
+  }
+  p3m_n_sources += n_recv;
+}
+
+void Particles3D::Add_Short_Range_Forces_GPU(Real Gconst)
+{
+  if (n_local > INT_MAX) {
+    CHOLLA_ERROR("Can't compute the P3M forces of more than %d particles per process, n_local is %ld", INT_MAX,
+                 n_local);
+  }
+
+  Real const cell   = fmax(G.dx, fmax(G.dy, G.dz));
+  Real const cutoff = p3m_cutoff * cell;
+  Real const eps    = p3m_softening * cell;
+  int const ng_x    = ceil(cutoff / G.dx);
+  int const ng_y    = ceil(cutoff / G.dy);
+  int const ng_z    = ceil(cutoff / G.dz);
+  int const nx_ext  = G.nx_local + 2 * ng_x;
+  int const ny_ext  = G.ny_local + 2 * ng_y;
+  int const nz_ext  = G.nz_local + 2 * ng_z;
+
+  // The local particles go first, so the source index tells them apart from
+  // the halo
+  Reserve_P3M_Sources_GPU(std::max((int)n_local, 1));
+  p3m_n_sources = n_local;
+  if (n_local > 0) {
+    int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+    hipLaunchKernelGGL(Load_P3M_Local_Sources_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_local, pos_x_dev, pos_y_dev,
+                       pos_z_dev, G.pos_origin_x, G.pos_origin_y, G.pos_origin_z, mass_dev, particle_mass,
+                       p3m_sources_dev);
+    GPU_Error_Check();
+  }
+
+  // Every rank takes part in the exchanges, even without local particles
+  for (int direction = 0; direction < 3; direction++) {
+    Exchange_P3M_Halo_GPU(direction, 0, cutoff);
+    Exchange_P3M_Halo_GPU(direction, 1, cutoff);
+  }
+  if (n_local == 0) {
+    return;
+  }
+
+  // Sort the sources by cell and build the linked list of the cells
+  int ngrid = (p3m_n_sources - 1) / TPB_PARTICLES + 1;
+  hipLaunchKernelGGL(Get_P3M_Cell_Keys_Kernel, ngrid, TPB_PARTICLES, 0, 0, p3m_n_sources, p3m_sources_dev, G.xMin,
+                     G.yMin, G.zMin, G.dx, G.dy, G.dz, ng_x, ng_y, ng_z, nx_ext, ny_ext, nz_ext, p3m_keys_dev[0],
+                     p3m_indices_dev[0]);
+  GPU_Error_Check();
+
+  int end_bit = 1;
+  while (end_bit < 31 && (1 << end_bit) < p3m_n_cells) {
+    end_bit++;
+  }
+  size_t temp_bytes = 0;
+  GPU_Error_Check(cub::DeviceRadixSort::SortPairs(nullptr, temp_bytes, p3m_keys_dev[0], p3m_keys_dev[1],
+                                                  p3m_indices_dev[0], p3m_indices_dev[1], p3m_n_sources, 0,
+                                                  end_bit));
+  Reserve_P3M_Temp(&p3m_temp_dev, &p3m_temp_bytes, temp_bytes);
+  GPU_Error_Check(cub::DeviceRadixSort::SortPairs(p3m_temp_dev, temp_bytes, p3m_keys_dev[0], p3m_keys_dev[1],
+                                                  p3m_indices_dev[0], p3m_indices_dev[1], p3m_n_sources, 0,
+                                                  end_bit));
+  hipLaunchKernelGGL(Gather_P3M_Sources_Kernel, ngrid, TPB_PARTICLES, 0, 0, p3m_n_sources, p3m_indices_dev[1],
+                     p3m_sources_dev, p3m_sorted_dev);
+
+  GPU_Error_Check(cudaMemset(p3m_cell_start_dev, 0, p3m_n_cells * sizeof(int)));
+  GPU_Error_Check(cudaMemset(p3m_cell_end_dev, 0, p3m_n_cells * sizeof(int)));
+  hipLaunchKernelGGL(Get_P3M_Cell_Ranges_Kernel, ngrid, TPB_PARTICLES, 0, 0, p3m_n_sources, p3m_keys_dev[1],
+                     p3m_cell_start_dev, p3m_cell_end_dev);
+  GPU_Error_Check();
+
+  ngrid = (p3m_n_sources - 1) / TPB_P3M + 1;
+  hipLaunchKernelGGL(Add_P3M_Short_Range_Force_Kernel, ngrid, TPB_P3M, 0, 0, p3m_n_sources, n_local,
+                     p3m_sorted_dev, p3m_keys_dev[1], p3m_indices_dev[1], p3m_cell_start_dev, p3m_cell_end_dev,
+                     nx_ext, ny_ext, nz_ext, ng_x, ng_y, ng_z, cutoff, eps * eps, Gconst, grav_x_dev, grav_y_dev,
+                     grav_z_dev);
+  GPU_Error_Check();
+}
+
+#endif  // PARTICLES && PARTICLES_P3M
@@ -0,0 +1,200 @@
+#if defined(PARTICLES) && defined(PARTICLES_GPU)
+
+  #include <climits>
+  #include <utility>
+
+  #ifdef O_HIP
+    #include <hipcub/hipcub.hpp>
+namespace cub = hipcub;
+  #else
+    #include <cub/cub.cuh>
+  #endif  // O_HIP
+
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "particles_3D.h"
+
+/*! \brief Compute the linear index of the local cell of each particle, with x
+ * the fastest index like the grid fields, and set the particle indices to the
+ * identity */
+__global__ void Get_Particles_Cell_Keys_Kernel(part_int_t n_local, Real_Part *pos_x_dev, Real_Part *pos_y_dev,
+                                               Real_Part *pos_z_dev, Real xMin, Real yMin, Real zMin, Real dx, Real dy,
+                                               Real dz, int nx_local, int ny_local, int nz_local, int *keys_dev,
+                                               int *indices_dev)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+
+  // Particles on the boundary of the local domain go to the closest cell
+  int const i = min(max(int(floor((pos_x_dev[tid] - xMin) / dx)), 0), nx_local - 1);
+  int const j = min(max(int(floor((pos_y_dev[tid] - yMin) / dy)), 0), ny_local - 1);
+  int const k = min(max(int(floor((pos_z_dev[tid] - zMin) / dz)), 0), nz_local - 1);
+
+  keys_dev[tid]    = i + nx_local * (j + ny_local * k);
+  indices_dev[tid] = tid;
+}
+
+/*! \brief Copy the particle at indices_dev[tid] of src_dev to tid of dst_dev */
+template <typename T>
+__global__ void Gather_Particles_Field_Kernel(part_int_t n_local, int *indices_dev, T *src_dev, T *dst_dev)
+{
+  part_int_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= n_local) {
+    return;
+  }
+  dst_dev[tid] = src_dev[indices_dev[tid]];
+}
+
+/*! \brief Reorder one particle field into the work array and swap the two, so
+ * the previous array of the field becomes the work array of the next field */
+template <typename T>
+static void Gather_Particles_Field(part_int_t n_local, int *indices_dev, T **field_dev, T **work_dev)
+{
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  hipLaunchKernelGGL(Gather_Particles_Field_Kernel<T>, ngrid, TPB_PARTICLES, 0, 0, n_local, indices_dev, *field_dev,
+                     *work_dev);
+  std::swap(*field_dev, *work_dev);
+}
+
+void Particles3D::Free_Sort_Arrays_GPU()
+{
+  cuda_utilities::Pool_Free(sort_keys_dev[0]);
+  cuda_utilities::Pool_Free(sort_keys_dev[1]);
+  cuda_utilities::Pool_Free(sort_indices_dev[0]);
+  cuda_utilities::Pool_Free(sort_indices_dev[1]);
+  cuda_utilities::Pool_Free(sort_real_dev);
+    #ifdef PARTICLES_COMPACT
+  cuda_utilities::Pool_Free(sort_part_dev);
+    #endif
+    #ifdef PARTICLE_IDS
+  cuda_utilities::Pool_Free(sort_ids_dev);
+    #endif
+  cuda_utilities::Pool_Free(sort_temp_dev);
+
+  sort_keys_dev[0] = sort_keys_dev[1] = nullptr;
+  sort_indices_dev[0] = sort_indices_dev[1] = nullptr;
+  sort_real_dev                             = nullptr;
+    #ifdef PARTICLES_COMPACT
+  sort_part_dev = nullptr;
+    #endif
+    #ifdef PARTICLE_IDS
+  sort_ids_dev = nullptr;
+    #endif
+  sort_temp_dev   = nullptr;
+  sort_temp_bytes = 0;
+  sort_array_size = 0;
+}
+
+/*! \brief Allocate the work arrays of the sorting if the size of the particle
+ * arrays changed */
+void Particles3D::Reserve_Sort_Arrays_GPU()
+{
+  if (particles_array_size > INT_MAX) {
+    CHOLLA_ERROR("Can't sort more than %d particles per process, the particle array size is %ld", INT_MAX,
+                 particles_array_size);
+  }
+
+  // The work arrays are swapped with the particle arrays, so they must always
+  // have the size of the particle arrays
+  if (sort_array_size != particles_array_size) {
+    Free_Sort_Arrays_GPU();
+    Allocate_Particles_GPU_Array_int(&sort_keys_dev[0], particles_array_size);
+    Allocate_Particles_GPU_Array_int(&sort_keys_dev[1], particles_array_size);
+    Allocate_Particles_GPU_Array_int(&sort_indices_dev[0], particles_array_size);
+    Allocate_Particles_GPU_Array_int(&sort_indices_dev[1], particles_array_size);
+    Allocate_Particles_GPU_Array_Real(&sort_real_dev, particles_array_size);
+    #ifdef PARTICLES_COMPACT
+    Allocate_Particles_GPU_Array_Part(&sort_part_dev, particles_array_size);
+    #endif
+    #ifdef PARTICLE_IDS
+    Allocate_Particles_GPU_Array_Part_Int(&sort_ids_dev, particles_array_size);
+    #endif
+    sort_array_size = particles_array_size;
+  }
+}
+
+/*! \brief Sort the first n_local pairs of sort_keys_dev[0] and
+ * sort_indices_dev[0] into sort_keys_dev[1] and sort_indices_dev[1], with all
+ * the keys lower than n_keys */
+void Particles3D::Sort_Keys_GPU(int n_keys)
+{
+  // Only sort the bits that a key can have
+  int end_bit = 1;
+  while (end_bit < 31 && (1 << end_bit) < n_keys) {
+    end_bit++;
+  }
+
+  size_t temp_bytes = 0;
+  GPU_Error_Check(cub::DeviceRadixSort::SortPairs(nullptr, temp_bytes, sort_keys_dev[0], sort_keys_dev[1],
+                                                  sort_indices_dev[0], sort_indices_dev[1], int(n_local), 0,
+                                                  end_bit));
+  if (temp_bytes > sort_temp_bytes) {
+    cuda_utilities::Pool_Free(sort_temp_dev);
+    cuda_utilities::MemoryTagScope const tag_scope(cuda_utilities::MemoryTag::particles);
+    cuda_utilities::Pool_Malloc(&sort_temp_dev, temp_bytes);
+    sort_temp_bytes = temp_bytes;
+  }
+  GPU_Error_Check(cub::DeviceRadixSort::SortPairs(sort_temp_dev, temp_bytes, sort_keys_dev[0], sort_keys_dev[1],
+                                                  sort_indices_dev[0], sort_indices_dev[1], int(n_local), 0,
+                                                  end_bit));
+}
+
+void Particles3D::Sort_Particles_GPU()
+{
+  if (n_local < 2) {
+    return;
+  }
+  Reserve_Sort_Arrays_GPU();
+
+  int ngrid = (n_local - 1) / TPB_PARTICLES + 1;
+  hipLaunchKernelGGL(Get_Particles_Cell_Keys_Kernel, ngrid, TPB_PARTICLES, 0, 0, n_local, pos_x_dev, pos_y_dev,
+                     pos_z_dev, G.xMin - G.pos_origin_x, G.yMin - G.pos_origin_y, G.zMin - G.pos_origin_z, G.dx, G.dy,
+                     G.dz, G.nx_local, G.ny_local, G.nz_local, sort_keys_dev[0], sort_indices_dev[0]);
+  GPU_Error_Check();
+  Sort_Keys_GPU(G.nx_local * G.ny_local * G.nz_local);
+
+  // Reorder every field of the particles by the sorted indices
+  int *const indices = sort_indices_dev[1];
+    #ifdef PARTICLES_COMPACT
+  Real_Part **const work_part = &sort_part_dev;
+    #else
+  Real_Part **const work_part = &sort_real_dev;
+    #endif  // PARTICLES_COMPACT
+  Gather_Particles_Field(n_local, indices, &pos_x_dev, work_part);
+  Gather_Particles_Field(n_local, indices, &pos_y_dev, work_part);
+  Gather_Particles_Field(n_local, indices, &pos_z_dev, work_part);
+  Gather_Particles_Field(n_local, indices, &vel_x_dev, work_part);
+  Gather_Particles_Field(n_local, indices, &vel_y_dev, work_part);
+  Gather_Particles_Field(n_local, indices, &vel_z_dev, work_part);
+    #ifndef PARTICLES_KDK_FUSED
+  Gather_Particles_Field(n_local, indices, &grav_x_dev, &sort_real_dev);
+  Gather_Particles_Field(n_local, indices, &grav_y_dev, &sort_real_dev);
+  Gather_Particles_Field(n_local, indices, &grav_z_dev, &sort_real_dev);
+    #endif
+    #ifndef SINGLE_PARTICLE_MASS
+  Gather_Particles_Field(n_local, indices, &mass_dev, &sort_real_dev);
+    #endif
+    #ifdef PARTICLE_AGE
+  Gather_Particles_Field(n_local, indices, &age_dev, &sort_real_dev);
+    #endif
+    #ifdef PARTICLE_IDS
+  Gather_Particles_Field(n_local, indices, &partIDs_dev, &sort_ids_dev);
+    #endif
+    #ifdef PARTICLES_BLOCK_TIMESTEPS
+  // The cell keys were sorted into sort_keys_dev[1], so the first key array
+  // is free. Both have the size of the particle arrays
+  if (time_bin_dev != nullptr) {
+    Gather_Particles_Field(n_local, indices, &time_bin_dev, &sort_keys_dev[0]);
+  }
+    #endif
+  GPU_Error_Check();
+  order_version++;
+}
+
+#endif  // PARTICLES && PARTICLES_GPU
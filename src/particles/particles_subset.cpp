@@ -0,0 +1,107 @@
+/*!
+ * \file particles_subset.cpp
+ * \brief Contains the parsing of the selection of the particle subset outputs
+ * and the selection of the particles on the host
+ *
+ */
+
+#ifdef PARTICLES
+
+  #include "../particles/particles_subset.h"
+
+  #include <cstdlib>
+  #include <string>
+
+  #include "../particles/particles_3D.h"
+  #include "../utils/error_handling.h"
+
+ParticleSubset Parse_Particle_Subset(Parameters const &P)
+{
+  ParticleSubset subset;
+  subset.fraction = P.particles_subset_fraction;
+  subset.n_boxes  = 0;
+  #ifndef PARTICLE_IDS
+  CHOLLA_ASSERT(subset.fraction == 0,
+                "particles_subset_fraction picks the particles by their ID, build with PARTICLE_IDS");
+  #endif  // PARTICLE_IDS
+
+  // Semicolon separated boxes of six comma separated bounds
+  std::string const boxes = P.particles_subset_boxes;
+  size_t begin            = 0;
+  while (begin < boxes.size()) {
+    size_t end = boxes.find(';', begin);
+    if (end == std::string::npos) {
+      end = boxes.size();
+    }
+    std::string const box = boxes.substr(begin, end - begin);
+    begin                 = end + 1;
+    if (box.find_first_not_of(' ') == std::string::npos) {
+      continue;
+    }
+    CHOLLA_ASSERT(subset.n_boxes < PARTICLE_SUBSET_MAX_BOXES, "particles_subset_boxes has more than %d boxes",
+                  PARTICLE_SUBSET_MAX_BOXES);
+
+    Real *bounds      = subset.boxes[subset.n_boxes];
+    char const *start = box.c_str();
+    for (int bound = 0; bound < 6; bound++) {
+      char *stop    = nullptr;
+      bounds[bound] = std::strtod(start, &stop);
+      CHOLLA_ASSERT(stop != start, "The box \"%s\" of particles_subset_boxes needs xmin,ymin,zmin,xmax,ymax,zmax",
+                    box.c_str());
+      start = stop;
+      while (*start == ' ') {
+        start++;
+      }
+      if (bound < 5) {
+        CHOLLA_ASSERT(*start == ',', "The box \"%s\" of particles_subset_boxes needs xmin,ymin,zmin,xmax,ymax,zmax",
+                      box.c_str());
+        start++;
+      }
+    }
+    CHOLLA_ASSERT(*start == '\0', "The box \"%s\" of particles_subset_boxes has more than six bounds", box.c_str());
+    subset.n_boxes++;
+  }
+  return subset;
+}
+
+  #ifdef PARTICLES_CPU
+part_int_t Select_Particle_Subset_CPU(Particles3D &particles, ParticleSubset const &subset, std::vector<Real> &fields,
+                                      std::vector<part_int_t> &ids)
+{
+  std::vector<part_int_t> selected;
+  for (part_int_t i = 0; i < particles.n_local; i++) {
+    part_int_t id = -1;
+    #ifdef PARTICLE_IDS
+    id = particles.partIDs[i];
+    #endif  // PARTICLE_IDS
+    if (Particle_In_Subset(subset, id, particles.pos_x[i], particles.pos_y[i], particles.pos_z[i])) {
+      selected.push_back(i);
+    }
+  }
+
+  part_int_t const n_selected = selected.size();
+  fields.resize(N_PARTICLE_SUBSET_FIELDS * n_selected);
+  ids.clear();
+  for (part_int_t j = 0; j < n_selected; j++) {
+    part_int_t const i         = selected[j];
+    fields[0 * n_selected + j] = particles.pos_x[i];
+    fields[1 * n_selected + j] = particles.pos_y[i];
+    fields[2 * n_selected + j] = particles.pos_z[i];
+    fields[3 * n_selected + j] = particles.vel_x[i];
+    fields[4 * n_selected + j] = particles.vel_y[i];
+    fields[5 * n_selected + j] = particles.vel_z[i];
+    #ifndef SINGLE_PARTICLE_MASS
+    fields[6 * n_selected + j] = particles.mass[i];
+    #endif  // SINGLE_PARTICLE_MASS
+    #ifdef PARTICLE_AGE
+    fields[(6 + PARTICLE_SUBSET_MASS) * n_selected + j] = particles.age[i];
+    #endif  // PARTICLE_AGE
+    #ifdef PARTICLE_IDS
+    ids.push_back(particles.partIDs[i]);
+    #endif  // PARTICLE_IDS
+  }
+  return n_selected;
+}
+  #endif  // PARTICLES_CPU
+
+#endif  // PARTICLES
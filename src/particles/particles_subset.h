@@ -0,0 +1,107 @@
+/*!
+ * \file particles_subset.h
+ * \brief Contains the selection of the particles of the subset outputs: a
+ * fraction of the particles picked by a hash of their ID, and the particles
+ * inside a few boxes
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "../global/global.h"
+#include "../utils/gpu.hpp"
+
+// The most boxes of particles_subset_boxes
+#define PARTICLE_SUBSET_MAX_BOXES 16
+
+// The fields of the selected particles, in the order of their blocks in the
+// buffers of the selection functions
+#ifndef SINGLE_PARTICLE_MASS
+  #define PARTICLE_SUBSET_MASS 1
+#else
+  #define PARTICLE_SUBSET_MASS 0
+#endif
+#ifdef PARTICLE_AGE
+  #define PARTICLE_SUBSET_AGE 1
+#else
+  #define PARTICLE_SUBSET_AGE 0
+#endif
+#define N_PARTICLE_SUBSET_FIELDS (6 + PARTICLE_SUBSET_MASS + PARTICLE_SUBSET_AGE)
+
+class Particles3D;
+
+// The selection of the subset outputs, passed by value to the selection kernel
+struct ParticleSubset {
+  // The fraction of the particles picked by the hash of their ID
+  Real fraction;
+  int n_boxes;
+  // xmin, ymin, zmin, xmax, ymax, zmax of each box
+  Real boxes[PARTICLE_SUBSET_MAX_BOXES][6];
+};
+
+/*!
+ * \brief Read the selection from particles_subset_fraction and
+ * particles_subset_boxes, exits with an error on a malformed list of boxes or
+ * on a fraction without PARTICLE_IDS
+ *
+ * \param[in] P The parameters
+ * \return The selection
+ */
+ParticleSubset Parse_Particle_Subset(Parameters const &P);
+
+/*!
+ * \brief A number in [0, 1) that only depends on the particle ID, from the
+ * splitmix64 finalizer, so a particle stays in the fraction from one output to
+ * the next and from one run to another
+ */
+inline __host__ __device__ Real Particle_ID_Hash(part_int_t const id)
+{
+  unsigned long long hash = (unsigned long long)id + 0x9E3779B97F4A7C15ull;
+  hash                    = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+  hash                    = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+  hash                    = hash ^ (hash >> 31);
+  return Real(double(hash >> 11) * (1.0 / 9007199254740992.0));
+}
+
+/*!
+ * \brief Whether the particle is in the subset, with an id of -1 when the
+ * particles have no IDs
+ */
+inline __host__ __device__ bool Particle_In_Subset(ParticleSubset const &subset, part_int_t const id, Real const x,
+                                                   Real const y, Real const z)
+{
+  if (id >= 0 && Particle_ID_Hash(id) < subset.fraction) {
+    return true;
+  }
+  for (int box_id = 0; box_id < subset.n_boxes; box_id++) {
+    Real const *box = subset.boxes[box_id];
+    if (x >= box[0] && y >= box[1] && z >= box[2] && x < box[3] && y < box[4] && z < box[5]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ * \brief Select the local particles of the subset and gather their fields
+ *
+ * \param[in] particles The particles
+ * \param[in] subset The selection
+ * \param[out] fields N_PARTICLE_SUBSET_FIELDS blocks of the selected particles:
+ * the global positions, the velocities, then the mass and the age if the
+ * particles have them
+ * \param[out] ids The IDs of the selected particles, empty without PARTICLE_IDS
+ * \return The number of selected particles
+ */
+part_int_t Select_Particle_Subset_CPU(Particles3D &particles, ParticleSubset const &subset, std::vector<Real> &fields,
+                                      std::vector<part_int_t> &ids);
+
+/*!
+ * \brief Select_Particle_Subset_CPU on the device: a kernel flags the
+ * particles, a scan compacts their indices and a second kernel gathers their
+ * fields, so only the subset is copied to the host
+ */
+part_int_t Select_Particle_Subset_GPU(Particles3D &particles, ParticleSubset const &subset, std::vector<Real> &fields,
+                                      std::vector<part_int_t> &ids);
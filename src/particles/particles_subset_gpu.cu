@@ -0,0 +1,134 @@
+#if defined(PARTICLES) && defined(PARTICLES_GPU)
+
+  #ifdef O_HIP
+    #include <hipcub/hipcub.hpp>
+namespace cub = hipcub;
+  #else
+    #include <cub/cub.cuh>
+  #endif  // O_HIP
+
+  #include <algorithm>
+  #include <vector>
+
+  #include "../global/global.h"
+  #include "../utils/DeviceVector.h"
+  #include "../utils/gpu.hpp"
+  #include "particles_3D.h"
+  #include "particles_boundaries_gpu.h"
+  #include "particles_subset.h"
+
+// Flag the particles in the subset
+__global__ void Flag_Particle_Subset_Kernel(part_int_t n_local, ParticleTransferFields fields, ParticleSubset subset,
+                                            bool *subset_flags_d)
+{
+  part_int_t const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_local) {
+    return;
+  }
+  part_int_t id = -1;
+  #ifdef PARTICLE_IDS
+  id = fields.ids[tid];
+  #endif  // PARTICLE_IDS
+  subset_flags_d[tid] = Particle_In_Subset(subset, id, fields.pos_x[tid] + fields.origin_x,
+                                           fields.pos_y[tid] + fields.origin_y, fields.pos_z[tid] + fields.origin_z);
+}
+
+// Gather the fields of the selected particles into N_PARTICLE_SUBSET_FIELDS
+// blocks of n_selected values
+__global__ void Gather_Particle_Subset_Kernel(int n_selected, ParticleTransferFields fields,
+                                              int const *subset_indices_d, Real *subset_fields_d,
+                                              part_int_t *subset_ids_d)
+{
+  int const tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_selected) {
+    return;
+  }
+  int const src_id                      = subset_indices_d[tid];
+  subset_fields_d[tid]                  = Real(fields.pos_x[src_id]) + fields.origin_x;
+  subset_fields_d[n_selected + tid]     = Real(fields.pos_y[src_id]) + fields.origin_y;
+  subset_fields_d[2 * n_selected + tid] = Real(fields.pos_z[src_id]) + fields.origin_z;
+  subset_fields_d[3 * n_selected + tid] = fields.vel_x[src_id];
+  subset_fields_d[4 * n_selected + tid] = fields.vel_y[src_id];
+  subset_fields_d[5 * n_selected + tid] = fields.vel_z[src_id];
+  #ifndef SINGLE_PARTICLE_MASS
+  subset_fields_d[6 * n_selected + tid] = fields.mass[src_id];
+  #endif  // SINGLE_PARTICLE_MASS
+  #ifdef PARTICLE_AGE
+  subset_fields_d[(6 + PARTICLE_SUBSET_MASS) * n_selected + tid] = fields.age[src_id];
+  #endif  // PARTICLE_AGE
+  #ifdef PARTICLE_IDS
+  subset_ids_d[tid] = fields.ids[src_id];
+  #endif  // PARTICLE_IDS
+}
+
+part_int_t Select_Particle_Subset_GPU(Particles3D &particles, ParticleSubset const &subset, std::vector<Real> &fields,
+                                      std::vector<part_int_t> &ids)
+{
+  fields.clear();
+  ids.clear();
+  int const n_local = particles.n_local;
+  if (n_local == 0) {
+    return 0;
+  }
+
+  ParticleTransferFields particle_fields;
+  particle_fields.pos_x    = particles.pos_x_dev;
+  particle_fields.pos_y    = particles.pos_y_dev;
+  particle_fields.pos_z    = particles.pos_z_dev;
+  particle_fields.vel_x    = particles.vel_x_dev;
+  particle_fields.vel_y    = particles.vel_y_dev;
+  particle_fields.vel_z    = particles.vel_z_dev;
+  particle_fields.mass     = particles.mass_dev;
+  particle_fields.ids      = nullptr;
+  particle_fields.age      = nullptr;
+  particle_fields.time_bin = nullptr;
+  particle_fields.origin_x = particles.G.pos_origin_x;
+  particle_fields.origin_y = particles.G.pos_origin_y;
+  particle_fields.origin_z = particles.G.pos_origin_z;
+  #ifdef PARTICLE_IDS
+  particle_fields.ids = particles.partIDs_dev;
+  #endif  // PARTICLE_IDS
+  #ifdef PARTICLE_AGE
+  particle_fields.age = particles.age_dev;
+  #endif  // PARTICLE_AGE
+
+  cuda_utilities::DeviceVector<bool> subset_flags_d(n_local);
+  cuda_utilities::DeviceVector<int> subset_indices_d(n_local);
+  cuda_utilities::DeviceVector<int> n_selected_d(1);
+  dim3 dim1dGrid((n_local - 1) / TPB_PARTICLES + 1, 1, 1);
+  dim3 dim1dBlock(TPB_PARTICLES, 1, 1);
+  hipLaunchKernelGGL(Flag_Particle_Subset_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_local, particle_fields, subset,
+                     subset_flags_d.data());
+  GPU_Error_Check();
+
+  // Compact the indices of the flagged particles, in order, with a scan
+  cub::CountingInputIterator<int> particle_ids(0);
+  size_t temp_bytes = 0;
+  GPU_Error_Check(cub::DeviceSelect::Flagged(nullptr, temp_bytes, particle_ids, subset_flags_d.data(),
+                                             subset_indices_d.data(), n_selected_d.data(), n_local));
+  cuda_utilities::DeviceVector<char> temp_d(std::max(temp_bytes, size_t(1)));
+  GPU_Error_Check(cub::DeviceSelect::Flagged(temp_d.data(), temp_bytes, particle_ids, subset_flags_d.data(),
+                                             subset_indices_d.data(), n_selected_d.data(), n_local));
+  int const n_selected = n_selected_d.at(0);
+  if (n_selected == 0) {
+    return 0;
+  }
+
+  // Only the selected particles are copied to the host
+  cuda_utilities::DeviceVector<Real> subset_fields_d(size_t(N_PARTICLE_SUBSET_FIELDS) * n_selected);
+  cuda_utilities::DeviceVector<part_int_t> subset_ids_d(n_selected);
+  dim1dGrid.x = (n_selected - 1) / TPB_PARTICLES + 1;
+  hipLaunchKernelGGL(Gather_Particle_Subset_Kernel, dim1dGrid, dim1dBlock, 0, 0, n_selected, particle_fields,
+                     subset_indices_d.data(), subset_fields_d.data(), subset_ids_d.data());
+  GPU_Error_Check();
+
+  fields.resize(size_t(N_PARTICLE_SUBSET_FIELDS) * n_selected);
+  subset_fields_d.cpyDeviceToHost(fields);
+  #ifdef PARTICLE_IDS
+  ids.resize(n_selected);
+  subset_ids_d.cpyDeviceToHost(ids);
+  #endif  // PARTICLE_IDS
+  return n_selected;
+}
+
+#endif  // PARTICLES && PARTICLES_GPU
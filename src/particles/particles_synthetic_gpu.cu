@@ -0,0 +1,145 @@
+#if defined(PARTICLES_GPU) && defined(COSMOLOGY)
+
+  #include <algorithm>
+
+  #include "../cosmology/synthetic_cosmology.h"
+  #include "../global/global.h"
+  #include "../global/global_cuda.h"
+  #include "../io/io.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/gpu.hpp"
+  #include "particles_3D.h"
+
+/*! \brief The device arrays that the synthetic particles are written to, all
+ * null to only count them */
+struct SyntheticParticleArrays {
+  Real_Part *pos_x = nullptr, *pos_y = nullptr, *pos_z = nullptr;
+  Real_Part *vel_x = nullptr, *vel_y = nullptr, *vel_z = nullptr;
+  Real *mass       = nullptr;
+  part_int_t *ids  = nullptr;
+  Real *age        = nullptr;
+};
+
+/*! \brief Displace the particles of a box of the global lattice, one particle
+ * at the center of every cell, and keep the ones that land in the local
+ * domain. The box starts at the lattice cell (i_start, j_start, k_start) and
+ * wraps around the periodic domain. The particles are counted in n_dev, and
+ * written to the arrays if they are set */
+__global__ void Synthetic_Cosmology_Particles_Kernel(
+    synthetic_cosmology::Field field, int i_start, int j_start, int k_start, int ni, int nj, int nk, int nx_total,
+    int ny_total, int nz_total, Real domainMin_x, Real domainMin_y, Real domainMin_z, Real dx, Real dy, Real dz,
+    Real xMin, Real yMin, Real zMin, Real xMax, Real yMax, Real zMax, Real origin_x, Real origin_y, Real origin_z,
+    Real mass, SyntheticParticleArrays arrays, int *n_dev)
+{
+  part_int_t const tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= part_int_t(ni) * nj * nk) {
+    return;
+  }
+  int const i = ((i_start + int(tid % ni)) % nx_total + nx_total) % nx_total;
+  int const j = ((j_start + int(tid / ni % nj)) % ny_total + ny_total) % ny_total;
+  int const k = ((k_start + int(tid / ni / nj)) % nz_total + nz_total) % nz_total;
+
+  Real const q_x = domainMin_x + (i + 0.5) * dx;
+  Real const q_y = domainMin_y + (j + 0.5) * dy;
+  Real const q_z = domainMin_z + (k + 0.5) * dz;
+  Real psi_x, psi_y, psi_z;
+  field.Displacement(q_x, q_y, q_z, psi_x, psi_y, psi_z);
+
+  // The displaced positions wrap around the periodic domain
+  Real pos_x = q_x + psi_x, pos_y = q_y + psi_y, pos_z = q_z + psi_z;
+  pos_x -= floor((pos_x - domainMin_x) / field.xlen) * field.xlen;
+  pos_y -= floor((pos_y - domainMin_y) / field.ylen) * field.ylen;
+  pos_z -= floor((pos_z - domainMin_z) / field.zlen) * field.zlen;
+  if (pos_x < xMin || pos_x >= xMax || pos_y < yMin || pos_y >= yMax || pos_z < zMin || pos_z >= zMax) {
+    return;
+  }
+
+  int const id = atomicAdd(n_dev, 1);
+  if (arrays.pos_x == nullptr) {
+    return;
+  }
+  arrays.pos_x[id] = pos_x - origin_x;
+  arrays.pos_y[id] = pos_y - origin_y;
+  arrays.pos_z[id] = pos_z - origin_z;
+  arrays.vel_x[id] = field.vel_factor * psi_x;
+  arrays.vel_y[id] = field.vel_factor * psi_y;
+  arrays.vel_z[id] = field.vel_factor * psi_z;
+  if (arrays.mass != nullptr) {
+    arrays.mass[id] = mass;
+  }
+  // The index of the lattice cell is unique over all the ranks
+  if (arrays.ids != nullptr) {
+    arrays.ids[id] = (part_int_t(k) * ny_total + j) * nx_total + i;
+  }
+  if (arrays.age != nullptr) {
+    arrays.age[id] = 0;
+  }
+}
+
+void Particles3D::Initialize_Synthetic_Cosmology(struct Parameters *P)
+{
+  chprintf(" Initializing Synthetic Cosmology Particles\n");
+  CHOLLA_ASSERT(P->Omega_b >= 0 and P->Omega_b < P->Omega_M, "Synthetic_Cosmology needs 0 <= Omega_b < Omega_M");
+
+  // One particle of the mean dark matter density per cell
+  Real const mass = synthetic_cosmology::Mean_Density(*P, P->Omega_M - P->Omega_b) * G.dx * G.dy * G.dz;
+  #ifdef SINGLE_PARTICLE_MASS
+  particle_mass = mass;
+  #endif
+
+  // The particles that land in the local domain start at most the largest
+  // displacement, plus a cell, away from it
+  synthetic_cosmology::Field const field = synthetic_cosmology::Make_Field(*P);
+  int const margin_x = int(synthetic_cosmology::Max_Displacement(field.xlen) / G.dx) + 1;
+  int const margin_y = int(synthetic_cosmology::Max_Displacement(field.ylen) / G.dy) + 1;
+  int const margin_z = int(synthetic_cosmology::Max_Displacement(field.zlen) / G.dz) + 1;
+  int const ni       = std::min(G.nx_local + 2 * margin_x, G.nx_total);
+  int const nj       = std::min(G.ny_local + 2 * margin_y, G.ny_total);
+  int const nk       = std::min(G.nz_local + 2 * margin_z, G.nz_total);
+  int const i_start  = int(round((G.xMin - G.domainMin_x) / G.dx)) - (ni - G.nx_local) / 2;
+  int const j_start  = int(round((G.yMin - G.domainMin_y) / G.dy)) - (nj - G.ny_local) / 2;
+  int const k_start  = int(round((G.zMin - G.domainMin_z) / G.dz)) - (nk - G.nz_local) / 2;
+
+  int *n_dev;
+  Allocate_Particles_GPU_Array_int(&n_dev, 1);
+  int const ngrid = (part_int_t(ni) * nj * nk - 1) / TPB_PARTICLES + 1;
+
+  // Count the local particles, then allocate the arrays and fill them
+  SyntheticParticleArrays arrays;
+  for (int pass = 0; pass < 2; pass++) {
+    GPU_Error_Check(cudaMemset(n_dev, 0, sizeof(int)));
+    hipLaunchKernelGGL(Synthetic_Cosmology_Particles_Kernel, ngrid, TPB_PARTICLES, 0, 0, field, i_start, j_start,
+                       k_start, ni, nj, nk, G.nx_total, G.ny_total, G.nz_total, G.domainMin_x, G.domainMin_y,
+                       G.domainMin_z, G.dx, G.dy, G.dz, G.xMin, G.yMin, G.zMin, G.xMax, G.yMax, G.zMax, G.pos_origin_x,
+                       G.pos_origin_y, G.pos_origin_z, mass, arrays, n_dev);
+    GPU_Error_Check();
+    if (pass > 0) {
+      break;
+    }
+
+    int n_particles;
+    GPU_Error_Check(cudaMemcpy(&n_particles, n_dev, sizeof(int), cudaMemcpyDeviceToHost));
+    n_local = n_particles;
+    Allocate_Particles_Arrays_GPU(n_local);
+    arrays.pos_x = pos_x_dev;
+    arrays.pos_y = pos_y_dev;
+    arrays.pos_z = pos_z_dev;
+    arrays.vel_x = vel_x_dev;
+    arrays.vel_y = vel_y_dev;
+    arrays.vel_z = vel_z_dev;
+  #ifndef SINGLE_PARTICLE_MASS
+    arrays.mass = mass_dev;
+  #endif
+  #ifdef PARTICLE_IDS
+    arrays.ids = partIDs_dev;
+  #endif
+  #ifdef PARTICLE_AGE
+    arrays.age = age_dev;
+  #endif
+  }
+  Free_GPU_Array_int(n_dev);
+
+  chprintf(" Synthetic Cosmology Particles Initialized, n_local: %lu\n", n_local);
+}
+
+#endif  // PARTICLES_GPU && COSMOLOGY
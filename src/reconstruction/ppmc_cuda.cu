@@ -573,115 +573,9 @@ __global__ __launch_bounds__(TPB) void PPMC_VL(Real *dev_conserved, Real *dev_bo
       break;
   }
 
-  // load the 5-cell stencil into registers
-  // cell i
-  reconstruction::Primitive const cell_i =
-      reconstruction::Load_Data(dev_conserved, xid, yid, zid, nx, ny, n_cells, o1, o2, o3, gamma);
-
-  // cell i-1. The equality checks the direction and will subtract one from the correct direction
-  // im1 stands for "i minus 1"
-  reconstruction::Primitive const cell_im1 = reconstruction::Load_Data(
-      dev_conserved, xid - int(dir == 0), yid - int(dir == 1), zid - int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
-
-  // cell i+1.  The equality checks the direction and add one to the correct direction
-  // ip1 stands for "i plus 1"
-  reconstruction::Primitive const cell_ip1 = reconstruction::Load_Data(
-      dev_conserved, xid + int(dir == 0), yid + int(dir == 1), zid + int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
-
-  // cell i-2. The equality checks the direction and will subtract two from the correct direction
-  // im2 stands for "i minus 2"
-  reconstruction::Primitive const cell_im2 =
-      reconstruction::Load_Data(dev_conserved, xid - 2 * int(dir == 0), yid - 2 * int(dir == 1),
-                                zid - 2 * int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
-
-  // cell i+2.  The equality checks the direction and add two to the correct direction
-  // ip2 stands for "i plus 2"
-  reconstruction::Primitive const cell_ip2 =
-      reconstruction::Load_Data(dev_conserved, xid + 2 * int(dir == 0), yid + 2 * int(dir == 1),
-                                zid + 2 * int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
-
-  // Convert to the characteristic variables
-  Real const sound_speed         = hydro_utilities::Calc_Sound_Speed(cell_i.pressure, cell_i.density, gamma);
-  Real const sound_speed_squared = sound_speed * sound_speed;
-
-#ifdef MHD
-  reconstruction::EigenVecs eigenvectors =
-      reconstruction::Compute_Eigenvectors(cell_i, sound_speed, sound_speed_squared, gamma);
-#else
-  reconstruction::EigenVecs eigenvectors;
-#endif  // MHD
-
-  // Cell i
-  reconstruction::Characteristic const cell_i_characteristic = reconstruction::Primitive_To_Characteristic(
-      cell_i, cell_i, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Cell i-1
-  reconstruction::Characteristic const cell_im1_characteristic = reconstruction::Primitive_To_Characteristic(
-      cell_i, cell_im1, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Cell i-2
-  reconstruction::Characteristic const cell_im2_characteristic = reconstruction::Primitive_To_Characteristic(
-      cell_i, cell_im2, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Cell i+1
-  reconstruction::Characteristic const cell_ip1_characteristic = reconstruction::Primitive_To_Characteristic(
-      cell_i, cell_ip1, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Cell i+2
-  reconstruction::Characteristic const cell_ip2_characteristic = reconstruction::Primitive_To_Characteristic(
-      cell_i, cell_ip2, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Compute the interface states for each field
-  reconstruction::Characteristic interface_R_imh_characteristic, interface_L_iph_characteristic;
-
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a0, cell_im1_characteristic.a0, cell_i_characteristic.a0,
-                                      cell_ip1_characteristic.a0, cell_ip2_characteristic.a0,
-                                      interface_L_iph_characteristic.a0, interface_R_imh_characteristic.a0);
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a1, cell_im1_characteristic.a1, cell_i_characteristic.a1,
-                                      cell_ip1_characteristic.a1, cell_ip2_characteristic.a1,
-                                      interface_L_iph_characteristic.a1, interface_R_imh_characteristic.a1);
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a2, cell_im1_characteristic.a2, cell_i_characteristic.a2,
-                                      cell_ip1_characteristic.a2, cell_ip2_characteristic.a2,
-                                      interface_L_iph_characteristic.a2, interface_R_imh_characteristic.a2);
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a3, cell_im1_characteristic.a3, cell_i_characteristic.a3,
-                                      cell_ip1_characteristic.a3, cell_ip2_characteristic.a3,
-                                      interface_L_iph_characteristic.a3, interface_R_imh_characteristic.a3);
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a4, cell_im1_characteristic.a4, cell_i_characteristic.a4,
-                                      cell_ip1_characteristic.a4, cell_ip2_characteristic.a4,
-                                      interface_L_iph_characteristic.a4, interface_R_imh_characteristic.a4);
-
-#ifdef MHD
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a5, cell_im1_characteristic.a5, cell_i_characteristic.a5,
-                                      cell_ip1_characteristic.a5, cell_ip2_characteristic.a5,
-                                      interface_L_iph_characteristic.a5, interface_R_imh_characteristic.a5);
-  reconstruction::PPM_Single_Variable(cell_im2_characteristic.a6, cell_im1_characteristic.a6, cell_i_characteristic.a6,
-                                      cell_ip1_characteristic.a6, cell_ip2_characteristic.a6,
-                                      interface_L_iph_characteristic.a6, interface_R_imh_characteristic.a6);
-#endif  // MHD
-
-  // Convert back to primitive variables
-  reconstruction::Primitive interface_L_iph = reconstruction::Characteristic_To_Primitive(
-      cell_i, interface_L_iph_characteristic, eigenvectors, sound_speed, sound_speed_squared, gamma);
-  reconstruction::Primitive interface_R_imh = reconstruction::Characteristic_To_Primitive(
-      cell_i, interface_R_imh_characteristic, eigenvectors, sound_speed, sound_speed_squared, gamma);
-
-  // Compute the interfaces for the variables that don't have characteristics
-#ifdef DE
-  reconstruction::PPM_Single_Variable(cell_im2.gas_energy, cell_im1.gas_energy, cell_i.gas_energy, cell_ip1.gas_energy,
-                                      cell_ip2.gas_energy, interface_L_iph.gas_energy, interface_R_imh.gas_energy);
-#endif  // DE
-#ifdef SCALAR
-  for (int i = 0; i < NSCALARS; i++) {
-    reconstruction::PPM_Single_Variable(cell_im2.scalar[i], cell_im1.scalar[i], cell_i.scalar[i], cell_ip1.scalar[i],
-                                        cell_ip2.scalar[i], interface_L_iph.scalar[i], interface_R_imh.scalar[i]);
-  }
-#endif  // SCALAR
-
-  // enforce minimum values
-  interface_R_imh.density  = fmax(interface_R_imh.density, (Real)TINY_NUMBER);
-  interface_L_iph.density  = fmax(interface_L_iph.density, (Real)TINY_NUMBER);
-  interface_R_imh.pressure = fmax(interface_R_imh.pressure, (Real)TINY_NUMBER);
-  interface_L_iph.pressure = fmax(interface_L_iph.pressure, (Real)TINY_NUMBER);
+  reconstruction::Primitive interface_L_iph, interface_R_imh;
+  reconstruction::PpmcPolicy::Interfaces(dev_conserved, xid, yid, zid, nx, ny, n_cells, 0, 0, gamma, dir, o1, o2,
+                                         o3, interface_L_iph, interface_R_imh);
 
   // Step 11 - Send final values back from kernel
 
@@ -6,6 +6,8 @@
 #define PPMC_CUDA_H
 
 #include "../global/global.h"
+#include "../reconstruction/reconstruction.h"
+#include "../utils/hydro_utilities.h"
 
 /*!
  * \brief Computes the left and right interface states using PPM with limiting in the characteristic variables and
@@ -50,4 +52,176 @@ __global__ void PPMC_CTU(Real *dev_conserved, Real *dev_bounds_L, Real *dev_boun
 __global__ __launch_bounds__(TPB) void PPMC_VL(Real *dev_conserved, Real *dev_bounds_L, Real *dev_bounds_R, int nx,
                                                int ny, int nz, Real gamma, int dir);
 
+namespace reconstruction
+{
+/*!
+ * \brief PPM reconstruction with limiting in the characteristic variables, as
+ * used by PPMC_VL. Also the reconstruction policy of the fused reconstruction
+ * and Riemann solver kernel. dx and dt are unused.
+ */
+struct PpmcPolicy {
+  /// The order of the reconstruction, as used by Thread_Guard
+  static int constexpr order = 3;
+
+  /*!
+   * \brief Compute the interface states on both sides of one cell
+   *
+   * \param[in] dev_conserved The conserved variable array
+   * \param[in] xid The X index of the cell
+   * \param[in] yid The Y index of the cell
+   * \param[in] zid The Z index of the cell
+   * \param[in] nx The number of cells in the X-direction
+   * \param[in] ny The number of cells in the Y-direction
+   * \param[in] n_cells The total number of cells
+   * \param[in] dx The length of the cells in the `dir` direction
+   * \param[in] dt The time step
+   * \param[in] gamma The adiabatic index
+   * \param[in] dir The direction to reconstruct. 0=X, 1=Y, 2=Z
+   * \param[in] o1 Directional parameter
+   * \param[in] o2 Directional parameter
+   * \param[in] o3 Directional parameter
+   * \param[out] interface_L_iph The left state of the i+1/2 interface
+   * \param[out] interface_R_imh The right state of the i-1/2 interface
+   * \tparam cached Whether dev_conserved is the primitive cache, see
+   * Load_Data
+   */
+  template <bool cached = false>
+  static inline __device__ void Interfaces(Real const *dev_conserved, int const xid, int const yid, int const zid,
+                                           int const nx, int const ny, int const n_cells, Real const dx, Real const dt,
+                                           Real const gamma, int const dir, int const o1, int const o2, int const o3,
+                                           Primitive &interface_L_iph, Primitive &interface_R_imh)
+  {
+    // load the 5-cell stencil into registers
+    // cell i
+    reconstruction::Primitive const cell_i =
+        reconstruction::Load_Data<cached>(dev_conserved, xid, yid, zid, nx, ny, n_cells, o1, o2, o3, gamma);
+
+    // cell i-1. The equality checks the direction and will subtract one from the correct direction
+    // im1 stands for "i minus 1"
+    reconstruction::Primitive const cell_im1 = reconstruction::Load_Data<cached>(
+        dev_conserved, xid - int(dir == 0), yid - int(dir == 1), zid - int(dir == 2), nx, ny, n_cells, o1, o2, o3,
+        gamma);
+
+    // cell i+1.  The equality checks the direction and add one to the correct direction
+    // ip1 stands for "i plus 1"
+    reconstruction::Primitive const cell_ip1 = reconstruction::Load_Data<cached>(
+        dev_conserved, xid + int(dir == 0), yid + int(dir == 1), zid + int(dir == 2), nx, ny, n_cells, o1, o2, o3,
+        gamma);
+
+    // cell i-2. The equality checks the direction and will subtract two from the correct direction
+    // im2 stands for "i minus 2"
+    reconstruction::Primitive const cell_im2 =
+        reconstruction::Load_Data<cached>(dev_conserved, xid - 2 * int(dir == 0), yid - 2 * int(dir == 1),
+                                          zid - 2 * int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
+
+    // cell i+2.  The equality checks the direction and add two to the correct direction
+    // ip2 stands for "i plus 2"
+    reconstruction::Primitive const cell_ip2 =
+        reconstruction::Load_Data<cached>(dev_conserved, xid + 2 * int(dir == 0), yid + 2 * int(dir == 1),
+                                          zid + 2 * int(dir == 2), nx, ny, n_cells, o1, o2, o3, gamma);
+
+    // Convert to the characteristic variables
+    Real const sound_speed         = hydro_utilities::Calc_Sound_Speed(cell_i.pressure, cell_i.density, gamma);
+    Real const sound_speed_squared = sound_speed * sound_speed;
+
+#ifdef MHD
+    reconstruction::EigenVecs const eigenvectors =
+        reconstruction::Compute_Eigenvectors(cell_i, sound_speed, sound_speed_squared, gamma);
+    auto const to_characteristic = [&](reconstruction::Primitive const &cell) {
+      return reconstruction::Primitive_To_Characteristic(cell_i, cell, eigenvectors, sound_speed, sound_speed_squared,
+                                                         gamma);
+    };
+    auto const to_primitive = [&](reconstruction::Characteristic const &characteristic) {
+      return reconstruction::Characteristic_To_Primitive(cell_i, characteristic, eigenvectors, sound_speed,
+                                                         sound_speed_squared, gamma);
+    };
+#else   // not MHD
+    // The hydro eigenvectors are sparse, so only their few factors are
+    // computed and shared by all the projections of the stencil
+    reconstruction::HydroProjection const projection =
+        reconstruction::Compute_Hydro_Projection(cell_i, sound_speed, sound_speed_squared);
+    auto const to_characteristic = [&](reconstruction::Primitive const &cell) {
+      return reconstruction::Primitive_To_Characteristic_Hydro(cell, projection);
+    };
+    auto const to_primitive = [&](reconstruction::Characteristic const &characteristic) {
+      return reconstruction::Characteristic_To_Primitive_Hydro(characteristic, projection);
+    };
+#endif  // MHD
+
+    // Cell i
+    reconstruction::Characteristic const cell_i_characteristic = to_characteristic(cell_i);
+
+    // Cell i-1
+    reconstruction::Characteristic const cell_im1_characteristic = to_characteristic(cell_im1);
+
+    // Cell i-2
+    reconstruction::Characteristic const cell_im2_characteristic = to_characteristic(cell_im2);
+
+    // Cell i+1
+    reconstruction::Characteristic const cell_ip1_characteristic = to_characteristic(cell_ip1);
+
+    // Cell i+2
+    reconstruction::Characteristic const cell_ip2_characteristic = to_characteristic(cell_ip2);
+
+    // Compute the interface states for each field
+    reconstruction::Characteristic interface_R_imh_characteristic, interface_L_iph_characteristic;
+
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a0, cell_im1_characteristic.a0,
+                                        cell_i_characteristic.a0, cell_ip1_characteristic.a0,
+                                        cell_ip2_characteristic.a0, interface_L_iph_characteristic.a0,
+                                        interface_R_imh_characteristic.a0);
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a1, cell_im1_characteristic.a1,
+                                        cell_i_characteristic.a1, cell_ip1_characteristic.a1,
+                                        cell_ip2_characteristic.a1, interface_L_iph_characteristic.a1,
+                                        interface_R_imh_characteristic.a1);
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a2, cell_im1_characteristic.a2,
+                                        cell_i_characteristic.a2, cell_ip1_characteristic.a2,
+                                        cell_ip2_characteristic.a2, interface_L_iph_characteristic.a2,
+                                        interface_R_imh_characteristic.a2);
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a3, cell_im1_characteristic.a3,
+                                        cell_i_characteristic.a3, cell_ip1_characteristic.a3,
+                                        cell_ip2_characteristic.a3, interface_L_iph_characteristic.a3,
+                                        interface_R_imh_characteristic.a3);
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a4, cell_im1_characteristic.a4,
+                                        cell_i_characteristic.a4, cell_ip1_characteristic.a4,
+                                        cell_ip2_characteristic.a4, interface_L_iph_characteristic.a4,
+                                        interface_R_imh_characteristic.a4);
+
+#ifdef MHD
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a5, cell_im1_characteristic.a5,
+                                        cell_i_characteristic.a5, cell_ip1_characteristic.a5,
+                                        cell_ip2_characteristic.a5, interface_L_iph_characteristic.a5,
+                                        interface_R_imh_characteristic.a5);
+    reconstruction::PPM_Single_Variable(cell_im2_characteristic.a6, cell_im1_characteristic.a6,
+                                        cell_i_characteristic.a6, cell_ip1_characteristic.a6,
+                                        cell_ip2_characteristic.a6, interface_L_iph_characteristic.a6,
+                                        interface_R_imh_characteristic.a6);
+#endif  // MHD
+
+    // Convert back to primitive variables
+    interface_L_iph = to_primitive(interface_L_iph_characteristic);
+    interface_R_imh = to_primitive(interface_R_imh_characteristic);
+
+    // Compute the interfaces for the variables that don't have characteristics
+#ifdef DE
+    reconstruction::PPM_Single_Variable(cell_im2.gas_energy, cell_im1.gas_energy, cell_i.gas_energy,
+                                        cell_ip1.gas_energy, cell_ip2.gas_energy, interface_L_iph.gas_energy,
+                                        interface_R_imh.gas_energy);
+#endif  // DE
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      reconstruction::PPM_Single_Variable(cell_im2.scalar[i], cell_im1.scalar[i], cell_i.scalar[i], cell_ip1.scalar[i],
+                                          cell_ip2.scalar[i], interface_L_iph.scalar[i], interface_R_imh.scalar[i]);
+    }
+#endif  // SCALAR
+
+    // enforce minimum values
+    interface_R_imh.density  = fmax(interface_R_imh.density, (Real)TINY_NUMBER);
+    interface_L_iph.density  = fmax(interface_L_iph.density, (Real)TINY_NUMBER);
+    interface_R_imh.pressure = fmax(interface_R_imh.pressure, (Real)TINY_NUMBER);
+    interface_L_iph.pressure = fmax(interface_L_iph.pressure, (Real)TINY_NUMBER);
+  }
+};
+}  // namespace reconstruction
+
 #endif  // PPMC_CUDA_H
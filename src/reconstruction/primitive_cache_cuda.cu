@@ -0,0 +1,61 @@
+/*! \file primitive_cache_cuda.cu
+ *  \brief Definitions of the primitive cache pass read by the cached
+ *  reconstruction kernels. */
+
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
+#include "../reconstruction/primitive_cache_cuda.h"
+#include "../reconstruction/reconstruction.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/gpu.hpp"
+
+namespace
+{
+__global__ __launch_bounds__(TPB) void Compute_Primitive_Cache_3D(Real const *dev_conserved, Real *dev_primitive,
+                                                                  int nx, int ny, int nz, Real gamma)
+{
+  int const n_cells = nx * ny * nz;
+  int const id      = threadIdx.x + blockIdx.x * blockDim.x;
+  if (id >= n_cells) {
+    return;
+  }
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(id, nx, ny, xid, yid, zid);
+
+  // Loading in the X ordering leaves the primitives unrotated
+  reconstruction::Primitive const cell = reconstruction::Load_Data(
+      dev_conserved, xid, yid, zid, nx, ny, n_cells, grid_enum::momentum_x, grid_enum::momentum_y,
+      grid_enum::momentum_z, gamma);
+
+  dev_primitive[grid_enum::density * n_cells + id]    = cell.density;
+  dev_primitive[grid_enum::momentum_x * n_cells + id] = cell.velocity_x;
+  dev_primitive[grid_enum::momentum_y * n_cells + id] = cell.velocity_y;
+  dev_primitive[grid_enum::momentum_z * n_cells + id] = cell.velocity_z;
+  dev_primitive[grid_enum::Energy * n_cells + id]     = cell.pressure;
+#ifdef MHD
+  dev_primitive[grid_enum::magnetic_x * n_cells + id] = cell.magnetic_x;
+  dev_primitive[grid_enum::magnetic_y * n_cells + id] = cell.magnetic_y;
+  dev_primitive[grid_enum::magnetic_z * n_cells + id] = cell.magnetic_z;
+#endif  // MHD
+#ifdef DE
+  dev_primitive[grid_enum::GasEnergy * n_cells + id] = cell.gas_energy;
+#endif  // DE
+#ifdef SCALAR
+  for (int i = 0; i < grid_enum::nscalars; i++) {
+    dev_primitive[(grid_enum::scalar + i) * n_cells + id] = cell.scalar[i];
+  }
+#endif  // SCALAR
+}
+}  // namespace
+
+namespace reconstruction
+{
+void Compute_Primitive_Cache(Real const *dev_conserved, Real *dev_primitive, int nx, int ny, int nz, Real gamma,
+                             cudaStream_t stream)
+{
+  int const n_blocks = (nx * ny * nz + TPB - 1) / TPB;
+  hipLaunchKernelGGL(Compute_Primitive_Cache_3D, n_blocks, TPB, 0, stream, dev_conserved, dev_primitive, nx, ny, nz,
+                     gamma);
+}
+}  // namespace reconstruction
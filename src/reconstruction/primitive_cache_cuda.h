@@ -0,0 +1,146 @@
+/*!
+ * \file primitive_cache_cuda.h
+ * \brief Contains the declaration of the primitive cache pass and the
+ * declaration and implementation of the reconstruction kernel that reads it.
+ * The untiled reconstructions convert the conserved variables of every cell of
+ * their stencil to primitives, so with PPMC each cell is converted 5 times per
+ * sweep and 15 times per half step. The cache converts every cell once and the
+ * three sweeps only load and rotate the primitives, at the cost of one more
+ * array of n_fields * n_cells. Since the kernel is templated on the
+ * reconstruction policy the implementation is in the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
+#include "../reconstruction/reconstruction.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/gpu.hpp"
+
+namespace reconstruction
+{
+/*!
+ * \brief Convert every cell of the grid, ghost cells included, to the
+ * primitive variables read by Load_Data<true>. The primitives are stored in
+ * the slots of the conserved variables they come from: the velocities in the
+ * momentum slots, the pressure in the energy slot, the specific gas energy and
+ * scalars in their slots and with MHD the cell centered magnetic fields in the
+ * slots of the face centered ones.
+ *
+ * \param[in] dev_conserved The conserved variable array
+ * \param[out] dev_primitive The primitive cache, n_fields * n_cells
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] gamma The adiabatic index
+ * \param[in] stream The stream to launch on
+ */
+void Compute_Primitive_Cache(Real const *dev_conserved, Real *dev_primitive, int nx, int ny, int nz, Real gamma,
+                             cudaStream_t stream = 0);
+
+/*!
+ * \brief Reconstruct the interface states of one sweep from the primitive
+ * cache. Otherwise identical to PLMC_cuda and PPMC_VL, the interface states
+ * are written to the same elements.
+ *
+ * \tparam Reconstruction The reconstruction policy, e.g.
+ * reconstruction::PlmcPolicy or reconstruction::PpmcPolicy
+ * \param[in] dev_primitive The primitive cache of Compute_Primitive_Cache
+ * \param[in] dev_conserved The conserved variable array the cache was computed
+ * from. Only read for the face centered magnetic fields with MHD
+ * \param[out] dev_bounds_L The L interface states
+ * \param[out] dev_bounds_R The R interface states
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] dx The length of the cells in the `dir` direction
+ * \param[in] dt The time step
+ * \param[in] gamma The adiabatic index
+ * \param[in] dir The direction to reconstruct. 0=X, 1=Y, 2=Z
+ */
+template <typename Reconstruction>
+__global__ __launch_bounds__(TPB) void Reconstruct_Cached_3D(Real const *dev_primitive, Real const *dev_conserved,
+                                                             Real *dev_bounds_L, Real *dev_bounds_R, int nx, int ny,
+                                                             int nz, Real dx, Real dt, Real gamma, int dir)
+{
+  // get a thread ID
+  int const thread_id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(thread_id, nx, ny, xid, yid, zid);
+
+  // Ensure that we are only operating on cells that will be used
+  if (reconstruction::Thread_Guard<Reconstruction::order>(nx, ny, nz, xid, yid, zid)) {
+    return;
+  }
+
+  // Compute the total number of cells
+  int const n_cells = nx * ny * nz;
+
+  // Set the field indices for the various directions
+  int o1, o2, o3;
+  switch (dir) {
+    case 0:
+      o1 = grid_enum::momentum_x;
+      o2 = grid_enum::momentum_y;
+      o3 = grid_enum::momentum_z;
+      break;
+    case 1:
+      o1 = grid_enum::momentum_y;
+      o2 = grid_enum::momentum_z;
+      o3 = grid_enum::momentum_x;
+      break;
+    case 2:
+      o1 = grid_enum::momentum_z;
+      o2 = grid_enum::momentum_x;
+      o3 = grid_enum::momentum_y;
+      break;
+  }
+
+  reconstruction::Primitive interface_L_iph, interface_R_imh;
+  Reconstruction::template Interfaces<true>(dev_primitive, xid, yid, zid, nx, ny, n_cells, dx, dt, gamma, dir, o1, o2,
+                                            o3, interface_L_iph, interface_R_imh);
+
+  // bounds_R refers to the right side of the i-1/2 interface
+  size_t id = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+  reconstruction::Write_Data(interface_L_iph, dev_bounds_L, dev_conserved, id, n_cells, o1, o2, o3, gamma);
+
+  id = cuda_utilities::compute1DIndex(xid - int(dir == 0), yid - int(dir == 1), zid - int(dir == 2), nx, ny);
+  reconstruction::Write_Data(interface_R_imh, dev_bounds_R, dev_conserved, id, n_cells, o1, o2, o3, gamma);
+}
+
+/*!
+ * \brief Launch Reconstruct_Cached_3D
+ *
+ * \tparam Reconstruction The reconstruction policy
+ * \param[in] dev_primitive The primitive cache of Compute_Primitive_Cache
+ * \param[in] dev_conserved The conserved variable array the cache was computed
+ * from
+ * \param[out] dev_bounds_L The L interface states
+ * \param[out] dev_bounds_R The R interface states
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] dx The length of the cells in the `dir` direction
+ * \param[in] dt The time step
+ * \param[in] gamma The adiabatic index
+ * \param[in] dir The direction to reconstruct. 0=X, 1=Y, 2=Z
+ * \param[in] stream The stream to launch on
+ */
+template <typename Reconstruction>
+void Reconstruct_Cached(Real const *dev_primitive, Real const *dev_conserved, Real *dev_bounds_L, Real *dev_bounds_R,
+                        int nx, int ny, int nz, Real dx, Real dt, Real gamma, int dir, cudaStream_t stream = 0)
+{
+  int const n_blocks = (nx * ny * nz + TPB - 1) / TPB;
+  auto *const kernel = Reconstruct_Cached_3D<Reconstruction>;
+  hipLaunchKernelGGL(kernel, n_blocks, TPB, 0, stream, dev_primitive, dev_conserved, dev_bounds_L, dev_bounds_R, nx, ny,
+                     nz, dx, dt, gamma, dir);
+}
+}  // namespace reconstruction
@@ -0,0 +1,105 @@
+/*!
+ * \file primitive_cache_cuda_tests.cu
+ * \brief Tests for the contents of primitive_cache_cuda.h
+ *
+ */
+
+// STL Includes
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../reconstruction/plmc_cuda.h"
+#include "../reconstruction/ppmc_cuda.h"
+#include "../reconstruction/primitive_cache_cuda.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/testing_utilities.h"
+
+namespace
+{
+/*!
+ * \brief Compare the reconstruction from the primitive cache against the
+ * uncached kernel on a random grid in all three directions
+ *
+ * \tparam Reconstruction The reconstruction policy to read the cache with
+ * \tparam Launcher A callable that launches the uncached reconstruction
+ * \param[in] uncached_reconstruction Launches the uncached reconstruction with
+ * arguments (conserved, bounds_L, bounds_R, nx, ny, nz, dx, dt, gamma, dir)
+ */
+template <typename Reconstruction, typename Launcher>
+void Check_Cached_Matches_Uncached(Launcher uncached_reconstruction)
+{
+  // Set up PRNG to use
+  std::mt19937_64 prng(42);
+  std::uniform_real_distribution<double> doubleRand(0.1, 5);
+
+  // Mock up needed information
+  int const nx = 11, ny = 9, nz = 7;
+  int const n_fields = grid_enum::num_fields;
+  int const n_cells  = nx * ny * nz;
+  double const dx    = doubleRand(prng);
+  double const dt    = doubleRand(prng);
+  double const gamma = 5.0 / 3.0;
+
+  // Setup host grid. Use a large energy so that the pressure stays positive
+  std::vector<double> host_grid(n_cells * n_fields);
+  for (double &val : host_grid) {
+    val = doubleRand(prng);
+  }
+  for (int i = 0; i < n_cells; i++) {
+    host_grid[grid_enum::Energy * n_cells + i] += 50.0;
+  }
+
+  cuda_utilities::DeviceVector<double> dev_grid(host_grid.size());
+  cuda_utilities::DeviceVector<double> dev_primitive(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+  reconstruction::Compute_Primitive_Cache(dev_grid.data(), dev_primitive.data(), nx, ny, nz, gamma);
+
+  for (int direction = 0; direction < 3; direction++) {
+    cuda_utilities::DeviceVector<double> dev_uncached_L(host_grid.size(), true), dev_uncached_R(host_grid.size(), true);
+    cuda_utilities::DeviceVector<double> dev_cached_L(host_grid.size(), true), dev_cached_R(host_grid.size(), true);
+
+    uncached_reconstruction(dev_grid.data(), dev_uncached_L.data(), dev_uncached_R.data(), nx, ny, nz, dx, dt, gamma,
+                            direction);
+    reconstruction::Reconstruct_Cached<Reconstruction>(dev_primitive.data(), dev_grid.data(), dev_cached_L.data(),
+                                                       dev_cached_R.data(), nx, ny, nz, dx, dt, gamma, direction);
+    GPU_Error_Check();
+    GPU_Error_Check(cudaDeviceSynchronize());
+
+    // Both write exactly the same elements and leave the rest zero. The cache
+    // computes the pressure from the unrotated velocities, so it can differ in
+    // the last bits
+    for (size_t i = 0; i < host_grid.size(); i++) {
+      std::string const location = "element " + std::to_string(i) + " in direction " + std::to_string(direction);
+      testing_utilities::Check_Results(dev_uncached_L.at(i), dev_cached_L.at(i), "left interface " + location, 1.0E-10);
+      testing_utilities::Check_Results(dev_uncached_R.at(i), dev_cached_R.at(i), "right interface " + location,
+                                       1.0E-10);
+    }
+  }
+}
+}  // namespace
+
+TEST(tALLPrimitiveCache, PlmcCorrectInputExpectMatchesUncached)
+{
+  Check_Cached_Matches_Uncached<reconstruction::PlmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                                int ny, int nz, double dx, double dt, double gamma,
+                                                                int dir) {
+    hipLaunchKernelGGL(PLMC_cuda, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, dx,
+                       dt, gamma, dir, grid_enum::num_fields);
+  });
+}
+
+TEST(tALLPrimitiveCache, PpmcCorrectInputExpectMatchesUncached)
+{
+  Check_Cached_Matches_Uncached<reconstruction::PpmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                                int ny, int nz, double dx, double dt, double gamma,
+                                                                int dir) {
+    hipLaunchKernelGGL(PPMC_VL, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, gamma,
+                       dir);
+  });
+}
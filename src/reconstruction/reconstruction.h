@@ -134,8 +134,12 @@ bool __device__ __host__ __inline__ Thread_Guard(int const &nx, int const &ny, i
  * \param[in] o2 Directional parameter
  * \param[in] o3 Directional parameter
  * \param[in] gamma The adiabatic index
+ * \tparam cached Whether dev_conserved is the primitive cache of
+ * Compute_Primitive_Cache instead of the conserved array, then the primitives
+ * are only rotated into the sweep direction
  * \return Primitive The loaded cell data
  */
+template <bool cached = false>
 Primitive __device__ __host__ __inline__ Load_Data(Real const *dev_conserved, size_t const &xid, size_t const &yid,
                                                    size_t const &zid, size_t const &nx, size_t const &ny,
                                                    size_t const &n_cells, size_t const &o1, size_t const &o2,
@@ -146,6 +150,33 @@ Primitive __device__ __host__ __inline__ Load_Data(Real const *dev_conserved, si
   // Declare the variable we will return
   Primitive loaded_data;
 
+  if constexpr (cached) {
+    // The cache holds the primitives in the slots of the conserved variables
+    // they come from and the cell centered magnetic fields in the slots of the
+    // face centered ones
+    loaded_data.density    = dev_conserved[grid_enum::density * n_cells + id];
+    loaded_data.velocity_x = dev_conserved[o1 * n_cells + id];
+    loaded_data.velocity_y = dev_conserved[o2 * n_cells + id];
+    loaded_data.velocity_z = dev_conserved[o3 * n_cells + id];
+    loaded_data.pressure   = dev_conserved[grid_enum::Energy * n_cells + id];
+#ifdef MHD
+    // The magnetic field slots are in the same order as the momentum ones
+    int const magnetic_offset = grid_enum::magnetic_x - grid_enum::momentum_x;
+    loaded_data.magnetic_x    = dev_conserved[(o1 + magnetic_offset) * n_cells + id];
+    loaded_data.magnetic_y    = dev_conserved[(o2 + magnetic_offset) * n_cells + id];
+    loaded_data.magnetic_z    = dev_conserved[(o3 + magnetic_offset) * n_cells + id];
+#endif  // MHD
+#ifdef DE
+    loaded_data.gas_energy = dev_conserved[grid_enum::GasEnergy * n_cells + id];
+#endif  // DE
+#ifdef SCALAR
+    for (size_t i = 0; i < grid_enum::nscalars; i++) {
+      loaded_data.scalar[i] = dev_conserved[(grid_enum::scalar + i) * n_cells + id];
+    }
+#endif  // SCALAR
+    return loaded_data;
+  }
+
   // Load hydro variables except pressure
   loaded_data.density    = dev_conserved[grid_enum::density * n_cells + id];
   loaded_data.velocity_x = dev_conserved[o1 * n_cells + id] / loaded_data.density;
@@ -491,6 +522,97 @@ Primitive __device__ __host__ __inline__ Characteristic_To_Primitive(Primitive c
 }
 // =====================================================================================================================
 
+#ifndef MHD
+// =====================================================================================================================
+/*!
+ * \brief The factors of the hydro eigenvectors of a cell. The hydro
+ * eigenvectors are sparse and only depend on the density and sound speed, so
+ * computing the factors once per cell takes the divisions out of every
+ * projection of the stencil
+ *
+ */
+struct HydroProjection {
+  /// The density divided by twice the sound speed
+  Real density_over_two_c;
+  /// One over twice the sound speed squared
+  Real inverse_two_c_squared;
+  /// The sound speed divided by the density
+  Real c_over_density;
+  /// The sound speed squared
+  Real sound_speed_squared;
+};
+// =====================================================================================================================
+
+// =====================================================================================================================
+/*!
+ * \brief Compute the hydro eigenvector factors of a cell
+ *
+ * \param[in] primitive The primitive variables of the cell
+ * \param[in] sound_speed The sound speed
+ * \param[in] sound_speed_squared The sound speed squared
+ * \return HydroProjection The eigenvector factors
+ */
+HydroProjection __device__ __host__ __inline__ Compute_Hydro_Projection(Primitive const &primitive,
+                                                                        Real const &sound_speed,
+                                                                        Real const &sound_speed_squared)
+{
+  HydroProjection projection;
+  projection.density_over_two_c    = primitive.density / (2.0 * sound_speed);
+  projection.inverse_two_c_squared = 1.0 / (2.0 * sound_speed_squared);
+  projection.c_over_density        = sound_speed / primitive.density;
+  projection.sound_speed_squared   = sound_speed_squared;
+  return projection;
+}
+// =====================================================================================================================
+
+// =====================================================================================================================
+/*!
+ * \brief Project the primitive variables slopes into the characteristic variables slopes, the same as
+ * Primitive_To_Characteristic without MHD but with the factors of the eigenvectors computed ahead of time
+ *
+ * \param[in] primitive_slope The primitive variables slopes
+ * \param[in] projection The eigenvector factors of the cell
+ * \return Characteristic The characteristic slopes
+ */
+Characteristic __device__ __host__ __inline__ Primitive_To_Characteristic_Hydro(Primitive const &primitive_slope,
+                                                                                HydroProjection const &projection)
+{
+  Real const pressure_term = primitive_slope.pressure * projection.inverse_two_c_squared;
+  Real const velocity_term = primitive_slope.velocity_x * projection.density_over_two_c;
+
+  Characteristic output;
+  output.a0 = pressure_term - velocity_term;
+  output.a1 = primitive_slope.density - 2.0 * pressure_term;
+  output.a2 = primitive_slope.velocity_y;
+  output.a3 = primitive_slope.velocity_z;
+  output.a4 = pressure_term + velocity_term;
+  return output;
+}
+// =====================================================================================================================
+
+// =====================================================================================================================
+/*!
+ * \brief Project the characteristic variables slopes into the primitive variables slopes, the same as
+ * Characteristic_To_Primitive without MHD but with the factors of the eigenvectors computed ahead of time
+ *
+ * \param[in] characteristic_slope The characteristic slopes
+ * \param[in] projection The eigenvector factors of the cell
+ * \return Primitive The primitive variables slopes
+ */
+Primitive __device__ __host__ __inline__ Characteristic_To_Primitive_Hydro(Characteristic const &characteristic_slope,
+                                                                           HydroProjection const &projection)
+{
+  Primitive output;
+  output.density    = characteristic_slope.a0 + characteristic_slope.a1 + characteristic_slope.a4;
+  output.velocity_x = projection.c_over_density * (characteristic_slope.a4 - characteristic_slope.a0);
+  output.velocity_y = characteristic_slope.a2;
+  output.velocity_z = characteristic_slope.a3;
+  output.pressure   = projection.sound_speed_squared * (characteristic_slope.a0 + characteristic_slope.a4);
+  return output;
+}
+// =====================================================================================================================
+#endif  // not MHD
+
 // =====================================================================================================================
 /*!
  * \brief Monotonize the characteristic slopes and project back into the primitive slopes
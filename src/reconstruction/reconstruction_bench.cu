@@ -0,0 +1,149 @@
+/*!
+ * \file reconstruction_bench.cu
+ * \brief Benchmarks of the 3D reconstruction kernels. Built with `make bench`,
+ * run the executable with `--benchmark_out=<file> --benchmark_out_format=json`
+ * to export the results
+ *
+ */
+
+// STL Includes
+#include <vector>
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../reconstruction/pcm_cuda.h"
+#include "../reconstruction/plmc_cuda.h"
+#include "../reconstruction/plmp_cuda.h"
+#include "../reconstruction/ppmc_cuda.h"
+#include "../reconstruction/ppmp_cuda.h"
+#include "../reconstruction/primitive_cache_cuda.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/benchmark_utilities.h"
+
+namespace
+{
+/*!
+ * \brief The grid and buffers of a reconstruction benchmark on an n^3 grid
+ */
+struct Reconstruction_Setup {
+  int const n;
+  int const n_cells;
+  int const n_fields = grid_enum::num_fields;
+  int const n_blocks;
+  int const n_ghost = 4;
+  Real const dx     = 1.0 / 256;
+  Real const dt     = 1.0e-4;
+  Real const gamma  = 5.0 / 3.0;
+  cuda_utilities::DeviceVector<Real> conserved;
+  cuda_utilities::DeviceVector<Real> bounds_L, bounds_R;
+
+  explicit Reconstruction_Setup(int const size)
+      : n(size),
+        n_cells(size * size * size),
+        n_blocks((n_cells + TPB - 1) / TPB),
+        conserved(n_cells * n_fields),
+        bounds_L(n_cells * n_fields, true),
+        bounds_R(n_cells * n_fields, true)
+  {
+    conserved.cpyHostToDevice(benchmark_utilities::Random_Conserved(n_cells, n_fields));
+  }
+};
+
+// Each iteration reconstructs all three directions
+
+void BM_PCM(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  // PCM writes all three directions at once so it needs all six buffers
+  cuda_utilities::DeviceVector<Real> bounds_Ly(s.n_cells * s.n_fields, true), bounds_Ry(s.n_cells * s.n_fields, true);
+  cuda_utilities::DeviceVector<Real> bounds_Lz(s.n_cells * s.n_fields, true), bounds_Rz(s.n_cells * s.n_fields, true);
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    hipLaunchKernelGGL(PCM_Reconstruction_3D, s.n_blocks, TPB, 0, 0, s.conserved.data(), s.bounds_L.data(),
+                       s.bounds_R.data(), bounds_Ly.data(), bounds_Ry.data(), bounds_Lz.data(), bounds_Rz.data(), s.n,
+                       s.n, s.n, s.n_ghost, s.gamma, s.n_fields);
+  });
+}
+
+void BM_PLMP(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(PLMP_cuda, s.n_blocks, TPB, 0, 0, s.conserved.data(), s.bounds_L.data(), s.bounds_R.data(),
+                         s.n, s.n, s.n, s.n_ghost, s.dx, s.dt, s.gamma, dir, s.n_fields);
+    }
+  });
+}
+
+void BM_PLMC(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(PLMC_cuda, s.n_blocks, TPB, 0, 0, s.conserved.data(), s.bounds_L.data(), s.bounds_R.data(),
+                         s.n, s.n, s.n, s.dx, s.dt, s.gamma, dir, s.n_fields);
+    }
+  });
+}
+
+#ifdef PPMP
+void BM_PPMP(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(PPMP_cuda, s.n_blocks, TPB, 0, 0, s.conserved.data(), s.bounds_L.data(), s.bounds_R.data(),
+                         s.n, s.n, s.n, s.n_ghost, s.dx, s.dt, s.gamma, dir, s.n_fields);
+    }
+  });
+}
+#endif  // PPMP
+
+void BM_PPMC(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(PPMC_VL, s.n_blocks, TPB, 0, 0, s.conserved.data(), s.bounds_L.data(), s.bounds_R.data(), s.n,
+                         s.n, s.n, s.gamma, dir);
+    }
+  });
+}
+
+// The cached versions convert the grid to primitives once and read the cache in
+// all three directions. The extra device memory of the cache is reported as a
+// counter so it can be weighed against the time saved
+
+template <typename Reconstruction>
+void BM_Cached(benchmark::State &state)
+{
+  Reconstruction_Setup s(state.range(0));
+  cuda_utilities::DeviceVector<Real> primitive(s.n_cells * s.n_fields);
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    reconstruction::Compute_Primitive_Cache(s.conserved.data(), primitive.data(), s.n, s.n, s.n, s.gamma);
+    for (int dir = 0; dir < 3; dir++) {
+      reconstruction::Reconstruct_Cached<Reconstruction>(primitive.data(), s.conserved.data(), s.bounds_L.data(),
+                                                         s.bounds_R.data(), s.n, s.n, s.n, s.dx, s.dt, s.gamma, dir);
+    }
+  });
+  state.counters["cache_MiB"] = static_cast<double>(s.n_cells) * s.n_fields * sizeof(Real) / (1024 * 1024);
+}
+
+void BM_PLMC_Cached(benchmark::State &state) { BM_Cached<reconstruction::PlmcPolicy>(state); }
+
+void BM_PPMC_Cached(benchmark::State &state) { BM_Cached<reconstruction::PpmcPolicy>(state); }
+}  // namespace
+
+BENCHMARK(BM_PCM)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PLMP)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PLMC)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+#ifdef PPMP
+BENCHMARK(BM_PPMP)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+#endif  // PPMP
+BENCHMARK(BM_PPMC)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PLMC_Cached)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PPMC_Cached)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
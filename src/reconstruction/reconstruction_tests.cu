@@ -172,6 +172,41 @@ TEST(tMHDReconstructionComputeEigenvectors, CorrectInputExpectCorrectOutput)
   testing_utilities::Check_Results(fiducial_results.a_prime_fast, host_results.a_prime_fast, "a_prime_fast");
   testing_utilities::Check_Results(fiducial_results.a_prime_slow, host_results.a_prime_slow, "a_prime_slow");
 }
+#else   // not MHD
+TEST(tHYDROReconstructionHydroProjection, CorrectInputExpectCorrectOutput)
+{
+  // Test parameters
+  Real const gamma = 5. / 3.;
+  reconstruction::Primitive const primitive{1, 2, 3, 4, 5};
+  reconstruction::Primitive const primitive_slope{9, 10, 11, 12, 13};
+  reconstruction::Characteristic const characteristic_slope{17, 18, 19, 20, 21};
+  Real const sound_speed         = hydro_utilities::Calc_Sound_Speed(primitive.pressure, primitive.density, gamma);
+  Real const sound_speed_squared = sound_speed * sound_speed;
+
+  // Run test
+  reconstruction::HydroProjection const projection =
+      reconstruction::Compute_Hydro_Projection(primitive, sound_speed, sound_speed_squared);
+  reconstruction::Characteristic const test_characteristic =
+      reconstruction::Primitive_To_Characteristic_Hydro(primitive_slope, projection);
+  reconstruction::Primitive const test_primitive =
+      reconstruction::Characteristic_To_Primitive_Hydro(characteristic_slope, projection);
+
+  // Check results
+  reconstruction::Characteristic const fiducial_characteristic{-0.95205080756887717, 7.4400000000000004, 11, 12,
+                                                              2.512050807568877};
+  testing_utilities::Check_Results(fiducial_characteristic.a0, test_characteristic.a0, "a0");
+  testing_utilities::Check_Results(fiducial_characteristic.a1, test_characteristic.a1, "a1");
+  testing_utilities::Check_Results(fiducial_characteristic.a2, test_characteristic.a2, "a2");
+  testing_utilities::Check_Results(fiducial_characteristic.a3, test_characteristic.a3, "a3");
+  testing_utilities::Check_Results(fiducial_characteristic.a4, test_characteristic.a4, "a4");
+
+  reconstruction::Primitive const fiducial_primitive{56, 11.547005383792516, 19, 20, 316.66666666666674};
+  testing_utilities::Check_Results(fiducial_primitive.density, test_primitive.density, "density");
+  testing_utilities::Check_Results(fiducial_primitive.velocity_x, test_primitive.velocity_x, "velocity_x");
+  testing_utilities::Check_Results(fiducial_primitive.velocity_y, test_primitive.velocity_y, "velocity_y");
+  testing_utilities::Check_Results(fiducial_primitive.velocity_z, test_primitive.velocity_z, "velocity_z");
+  testing_utilities::Check_Results(fiducial_primitive.pressure, test_primitive.pressure, "pressure");
+}
 #endif  // MHD
 
 TEST(tALLReconstructionThreadGuard, CorrectInputExpectCorrectOutput)
@@ -0,0 +1,166 @@
+/*!
+ * \file tiled_reconstruction_cuda.h
+ * \brief Contains the declaration and implementation of the shared memory
+ * tiled reconstruction kernel for the Y and Z sweeps and its launcher. Since
+ * the kernel is templated on the reconstruction policy the implementation is in
+ * the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
+#include "../reconstruction/reconstruction.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/error_handling.h"
+#include "../utils/gpu.hpp"
+
+namespace reconstruction
+{
+/// The number of cells along X in a tile, one warp wide so every row of the
+/// tile is loaded with unit stride
+int constexpr tile_x = 32;
+/// The number of cells along the sweep direction in a tile, not counting the
+/// stencil halo
+int constexpr tile_d = TPB / tile_x;
+
+/*!
+ * \brief Reconstruct the interface states of the Y or Z sweep from a tile in
+ * shared memory. Each block covers tile_x cells along X by tile_d cells along
+ * the sweep direction at a single index of the remaining direction. The block
+ * first copies all the fields of its tile plus the stencil halo into shared
+ * memory one X row at a time, so every global load has unit stride regardless
+ * of the sweep direction, and then runs the reconstruction policy on the tile
+ * as if it were a small grid. The interface states are written exactly where
+ * the untiled kernels write them.
+ *
+ * \tparam Reconstruction The reconstruction policy, e.g.
+ * reconstruction::PlmcPolicy or reconstruction::PpmcPolicy
+ * \param[in] dev_conserved The conserved variable array
+ * \param[out] dev_bounds_L The L interface states
+ * \param[out] dev_bounds_R The R interface states
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] dx The length of the cells in the `dir` direction
+ * \param[in] dt The time step
+ * \param[in] gamma The adiabatic index
+ * \param[in] dir The direction to reconstruct, must be 1=Y or 2=Z
+ */
+template <typename Reconstruction>
+__global__ __launch_bounds__(TPB) void Reconstruct_Tiled_3D(Real const *dev_conserved, Real *dev_bounds_L,
+                                                            Real *dev_bounds_R, int nx, int ny, int nz, Real dx,
+                                                            Real dt, Real gamma, int dir)
+{
+  // The stencil halo needed on each side along the sweep direction
+  int constexpr halo       = Reconstruction::order - 1;
+  int constexpr tile_len   = tile_d + 2 * halo;
+  int constexpr tile_cells = tile_x * tile_len;
+  static_assert(grid_enum::num_fields * tile_cells * sizeof(Real) <= 48 * 1024,
+                "The reconstruction tile does not fit in the default shared memory of a block");
+  __shared__ Real tile[grid_enum::num_fields * tile_cells];
+
+  int const n_cells = nx * ny * nz;
+  int const tile_i  = threadIdx.x % tile_x;
+  int const tile_j  = threadIdx.x / tile_x;
+
+  // Global indices of this thread's cell. blockIdx.y tiles the sweep direction
+  // and blockIdx.z is the index of the remaining direction
+  int const xid = blockIdx.x * tile_x + tile_i;
+  int const did = blockIdx.y * tile_d + tile_j;
+  int const yid = (dir == 1) ? did : blockIdx.z;
+  int const zid = (dir == 1) ? blockIdx.z : did;
+
+  // Load the tile and its halo one X row at a time
+  int const n_d = (dir == 1) ? ny : nz;
+  if (xid < nx) {
+    for (int row = tile_j; row < tile_len; row += tile_d) {
+      int const row_did = blockIdx.y * tile_d - halo + row;
+      if (row_did >= 0 and row_did < n_d) {
+        int const source = (dir == 1) ? cuda_utilities::compute1DIndex(xid, row_did, zid, nx, ny)
+                                      : cuda_utilities::compute1DIndex(xid, yid, row_did, nx, ny);
+        for (int field = 0; field < grid_enum::num_fields; field++) {
+          tile[field * tile_cells + row * tile_x + tile_i] = dev_conserved[field * n_cells + source];
+        }
+      }
+    }
+  }
+  __syncthreads();
+
+  // Ensure that we are only operating on cells that will be used
+  if (reconstruction::Thread_Guard<Reconstruction::order>(nx, ny, nz, xid, yid, zid)) {
+    return;
+  }
+
+  // Set the field indices for the various directions
+  int o1, o2, o3;
+  if (dir == 1) {
+    o1 = grid_enum::momentum_y;
+    o2 = grid_enum::momentum_z;
+    o3 = grid_enum::momentum_x;
+  } else {
+    o1 = grid_enum::momentum_z;
+    o2 = grid_enum::momentum_x;
+    o3 = grid_enum::momentum_y;
+  }
+
+  // The tile is a tile_x by tile_len grid in the X-Y plane for the Y sweep and
+  // in the X-Z plane for the Z sweep, both with the same memory layout
+  int const local_ny = (dir == 1) ? tile_len : 1;
+  int const local_y  = (dir == 1) ? tile_j + halo : 0;
+  int const local_z  = (dir == 1) ? 0 : tile_j + halo;
+  reconstruction::Primitive interface_L_iph, interface_R_imh;
+  Reconstruction::Interfaces(tile, tile_i, local_y, local_z, tile_x, local_ny, tile_cells, dx, dt, gamma, dir, o1, o2,
+                             o3, interface_L_iph, interface_R_imh);
+
+  // bounds_R refers to the right side of the i-1/2 interface
+  size_t id = cuda_utilities::compute1DIndex(xid, yid, zid, nx, ny);
+  reconstruction::Write_Data(interface_L_iph, dev_bounds_L, dev_conserved, id, n_cells, o1, o2, o3, gamma);
+
+  id = cuda_utilities::compute1DIndex(xid, yid - int(dir == 1), zid - int(dir == 2), nx, ny);
+  reconstruction::Write_Data(interface_R_imh, dev_bounds_R, dev_conserved, id, n_cells, o1, o2, o3, gamma);
+}
+
+/*!
+ * \brief Launch Reconstruct_Tiled_3D for the Y or Z sweep
+ *
+ * \tparam Reconstruction The reconstruction policy
+ * \param[in] dev_conserved The conserved variable array
+ * \param[out] dev_bounds_L The L interface states
+ * \param[out] dev_bounds_R The R interface states
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] dx The length of the cells in the `dir` direction
+ * \param[in] dt The time step
+ * \param[in] gamma The adiabatic index
+ * \param[in] dir The direction to reconstruct, must be 1=Y or 2=Z. The X sweep
+ * already loads its stencil with unit stride and uses the untiled kernels
+ * \param[in] n_fields The total number of fields, must be grid_enum::num_fields
+ * \param[in] stream The stream to launch on
+ */
+template <typename Reconstruction>
+void Reconstruct_Tiled(Real const *dev_conserved, Real *dev_bounds_L, Real *dev_bounds_R, int nx, int ny, int nz,
+                       Real dx, Real dt, Real gamma, int dir, int n_fields, cudaStream_t stream = 0)
+{
+  if (dir != 1 and dir != 2) {
+    CHOLLA_ERROR("The tiled reconstruction only supports the Y and Z directions, got dir = %d", dir);
+  }
+  if (n_fields != grid_enum::num_fields) {
+    CHOLLA_ERROR("The tiled reconstruction requires n_fields = %d, got %d", grid_enum::num_fields, n_fields);
+  }
+
+  int const n_d = (dir == 1) ? ny : nz;
+  dim3 const blocks((nx + tile_x - 1) / tile_x, (n_d + tile_d - 1) / tile_d, (dir == 1) ? nz : ny);
+  auto *const kernel = Reconstruct_Tiled_3D<Reconstruction>;
+  hipLaunchKernelGGL(kernel, blocks, TPB, 0, stream, dev_conserved, dev_bounds_L, dev_bounds_R, nx, ny, nz, dx, dt,
+                     gamma, dir);
+}
+}  // namespace reconstruction
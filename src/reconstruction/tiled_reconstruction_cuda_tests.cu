@@ -0,0 +1,103 @@
+/*!
+ * \file tiled_reconstruction_cuda_tests.cu
+ * \brief Tests for the contents of tiled_reconstruction_cuda.h
+ *
+ */
+
+// STL Includes
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../reconstruction/plmc_cuda.h"
+#include "../reconstruction/ppmc_cuda.h"
+#include "../reconstruction/tiled_reconstruction_cuda.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/testing_utilities.h"
+
+#ifndef MHD
+namespace
+{
+/*!
+ * \brief Compare the tiled reconstruction against the untiled kernel on a
+ * random grid in the Y and Z directions. The grid is deliberately not a
+ * multiple of the tile size so the partial tiles are exercised
+ *
+ * \tparam Reconstruction The reconstruction policy to tile
+ * \tparam Launcher A callable that launches the untiled reconstruction
+ * \param[in] untiled_reconstruction Launches the untiled reconstruction with
+ * arguments (conserved, bounds_L, bounds_R, nx, ny, nz, dx, dt, gamma, dir)
+ */
+template <typename Reconstruction, typename Launcher>
+void Check_Tiled_Matches_Untiled(Launcher untiled_reconstruction)
+{
+  // Set up PRNG to use
+  std::mt19937_64 prng(42);
+  std::uniform_real_distribution<double> doubleRand(0.1, 5);
+
+  // Mock up needed information
+  int const nx = 37, ny = 13, nz = 11;
+  int const n_fields = grid_enum::num_fields;
+  int const n_cells  = nx * ny * nz;
+  double const dx    = doubleRand(prng);
+  double const dt    = doubleRand(prng);
+  double const gamma = 5.0 / 3.0;
+
+  // Setup host grid. Use a large energy so that the pressure stays positive
+  std::vector<double> host_grid(n_cells * n_fields);
+  for (double &val : host_grid) {
+    val = doubleRand(prng);
+  }
+  for (int i = 0; i < n_cells; i++) {
+    host_grid[grid_enum::Energy * n_cells + i] += 50.0;
+  }
+
+  cuda_utilities::DeviceVector<double> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+
+  for (int direction = 1; direction < 3; direction++) {
+    cuda_utilities::DeviceVector<double> dev_untiled_L(host_grid.size(), true), dev_untiled_R(host_grid.size(), true);
+    cuda_utilities::DeviceVector<double> dev_tiled_L(host_grid.size(), true), dev_tiled_R(host_grid.size(), true);
+
+    untiled_reconstruction(dev_grid.data(), dev_untiled_L.data(), dev_untiled_R.data(), nx, ny, nz, dx, dt, gamma,
+                           direction);
+    reconstruction::Reconstruct_Tiled<Reconstruction>(dev_grid.data(), dev_tiled_L.data(), dev_tiled_R.data(), nx, ny,
+                                                      nz, dx, dt, gamma, direction, n_fields);
+    GPU_Error_Check();
+    GPU_Error_Check(cudaDeviceSynchronize());
+
+    // Both write exactly the same elements and leave the rest zero
+    for (size_t i = 0; i < host_grid.size(); i++) {
+      std::string const location = "element " + std::to_string(i) + " in direction " + std::to_string(direction);
+      testing_utilities::Check_Results(dev_untiled_L.at(i), dev_tiled_L.at(i), "left interface " + location);
+      testing_utilities::Check_Results(dev_untiled_R.at(i), dev_tiled_R.at(i), "right interface " + location);
+    }
+  }
+}
+}  // namespace
+
+TEST(tHYDROTiledReconstruction, PlmcCorrectInputExpectMatchesUntiled)
+{
+  Check_Tiled_Matches_Untiled<reconstruction::PlmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                              int ny, int nz, double dx, double dt, double gamma,
+                                                              int dir) {
+    hipLaunchKernelGGL(PLMC_cuda, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, dx,
+                       dt, gamma, dir, grid_enum::num_fields);
+  });
+}
+
+TEST(tHYDROTiledReconstruction, PpmcCorrectInputExpectMatchesUntiled)
+{
+  Check_Tiled_Matches_Untiled<reconstruction::PpmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                              int ny, int nz, double dx, double dt, double gamma,
+                                                              int dir) {
+    hipLaunchKernelGGL(PPMC_VL, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, gamma,
+                       dir);
+  });
+}
+#endif  // not MHD
@@ -162,11 +162,12 @@ __device__ Real guessp_CUDA(Real dl, Real vxl, Real pl, Real cl, Real dr, Real v
   // purpose:  to provide a guessed value for pressure
   //    pm in the Star Region. The choice is made
   //    according to adaptive Riemann solver using
-  //    the PVRS and TSRS approximate Riemann
+  //    the PVRS, TRRS and TSRS approximate Riemann
   //    solvers. See Sect. 9.5 of Toro (1999)
 
   Real gl, gr, ppv, pm;
-  const Real TOL = 1.0e-6;
+  const Real TOL   = 1.0e-6;
+  const Real QUSER = 2.0;
 
   // compute guess pressure from PVRS Riemann solver
   ppv = 0.5 * (pl + pr) + 0.125 * (vxl - vxr) * (dl + dr) * (cl + cr);
@@ -174,10 +175,26 @@ __device__ Real guessp_CUDA(Real dl, Real vxl, Real pl, Real cl, Real dr, Real v
   if (ppv < 0.0) {
     ppv = 0.0;
   }
-  // Two-Shock Riemann solver with PVRS as estimate
-  gl = sqrt((2.0 / ((gamma + 1.0) * dl)) / (((gamma - 1.0) / (gamma + 1.0)) * pl + ppv));
-  gr = sqrt((2.0 / ((gamma + 1.0) * dr)) / (((gamma - 1.0) / (gamma + 1.0)) * pr + ppv));
-  pm = (gl * pl + gr * pr - (vxr - vxl)) / (gl + gr);
+
+  Real const pmin = fmin(pl, pr);
+  Real const pmax = fmax(pl, pr);
+  if (pmax / pmin <= QUSER && pmin <= ppv && ppv <= pmax) {
+    // Smooth interface, the PVRS pressure is already close
+    pm = ppv;
+  } else if (ppv < pmin) {
+    // Two-Rarefaction Riemann solver, exact if both waves are rarefactions
+    Real const z   = (gamma - 1.0) / (2.0 * gamma);
+    Real const pq  = pow(pl / pr, z);
+    Real const um  = (pq * vxl / cl + vxr / cr + (2.0 / (gamma - 1.0)) * (pq - 1.0)) / (pq / cl + 1.0 / cr);
+    Real const ptl = 1.0 + 0.5 * (gamma - 1.0) * (vxl - um) / cl;
+    Real const ptr = 1.0 + 0.5 * (gamma - 1.0) * (um - vxr) / cr;
+    pm             = 0.5 * (pl * pow(ptl, 1.0 / z) + pr * pow(ptr, 1.0 / z));
+  } else {
+    // Two-Shock Riemann solver with PVRS as estimate
+    gl = sqrt((2.0 / ((gamma + 1.0) * dl)) / (((gamma - 1.0) / (gamma + 1.0)) * pl + ppv));
+    gr = sqrt((2.0 / ((gamma + 1.0) * dr)) / (((gamma - 1.0) / (gamma + 1.0)) * pr + ppv));
+    pm = (gl * pl + gr * pr - (vxr - vxl)) / (gl + gr);
+  }
 
   if (pm < 0.0) {
     pm = TOL;
@@ -217,6 +234,19 @@ __device__ void starpv_CUDA(Real *p, Real *v, Real dl, Real vxl, Real pl, Real c
   const Real TOL   = 1.0e-6;
   Real change, fl, fld, fr, frd, pold, pstart;
 
+  // Nearly uniform interfaces, as in smooth flow. The linearized (PVRS)
+  // solution is off by the square of the jumps, below the Newton tolerance
+  const Real UNIFORM_TOL = 1.0e-3;
+  Real const d_mean      = 0.5 * (dl + dr);
+  Real const c_mean      = 0.5 * (cl + cr);
+  Real const p_mean      = 0.5 * (pl + pr);
+  if (fabs(pr - pl) <= UNIFORM_TOL * p_mean && fabs(dr - dl) <= UNIFORM_TOL * d_mean &&
+      fabs(vxr - vxl) <= UNIFORM_TOL * c_mean) {
+    *p = p_mean + 0.5 * (vxl - vxr) * d_mean * c_mean;
+    *v = 0.5 * (vxl + vxr) + 0.5 * (pl - pr) / (d_mean * c_mean);
+    return;
+  }
+
   // guessed value pstart is computed
   pstart = guessp_CUDA(dl, vxl, pl, cl, dr, vxr, pr, cr, gamma);
   pold   = pstart;
@@ -0,0 +1,84 @@
+/*!
+ * \file exact_cuda_tests.cu
+ * \brief Test the star state of the exact Riemann solver in exact_cuda.cu
+ *
+ */
+
+// STL Includes
+#include <cmath>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../riemann_solvers/exact_cuda.h"  // Include code to test
+#include "../utils/DeviceVector.h"
+#include "../utils/gpu.hpp"
+
+namespace
+{
+/*!
+ * \brief Solve for the star pressure and velocity of one interface
+ *
+ * \param[in] states The primitive left and right states: dl, vxl, pl, dr, vxr, pr
+ * \param[out] star The star pressure and velocity
+ * \param[in] gamma The adiabatic index
+ */
+__global__ void Star_State_Kernel(Real const *states, Real *star, Real gamma)
+{
+  Real const cl = sqrt(gamma * states[2] / states[0]);
+  Real const cr = sqrt(gamma * states[5] / states[3]);
+  starpv_CUDA(&star[0], &star[1], states[0], states[1], states[2], cl, states[3], states[4], states[5], cr, gamma);
+}
+
+std::vector<Real> Star_State(std::vector<Real> const &states, Real const gamma)
+{
+  cuda_utilities::DeviceVector<Real> dev_states(states.size());
+  cuda_utilities::DeviceVector<Real> dev_star(2);
+  dev_states.cpyHostToDevice(states);
+  hipLaunchKernelGGL(Star_State_Kernel, 1, 1, 0, 0, dev_states.data(), dev_star.data(), gamma);
+  GPU_Error_Check();
+  std::vector<Real> star(2);
+  dev_star.cpyDeviceToHost(star);
+  return star;
+}
+}  // namespace
+
+// =============================================================================
+TEST(tHYDROExactStarState, ToroTestsExpectTabulatedStarStates)
+{
+  // Table 4.2 of Toro (1999): the left and right states, then p* and u*
+  std::vector<std::vector<Real>> const tests = {
+      {1.0, 0.0, 1.0, 0.125, 0.0, 0.1, 0.30313, 0.92745},
+      {1.0, -2.0, 0.4, 1.0, 2.0, 0.4, 0.00189, 0.0},
+      {1.0, 0.0, 1000.0, 1.0, 0.0, 0.01, 460.894, 19.5975},
+      {1.0, 0.0, 0.01, 1.0, 0.0, 100.0, 46.0950, -6.19633},
+      {5.99924, 19.5975, 460.894, 5.99242, -6.19633, 46.0950, 1691.64, 8.68975}};
+  Real const gamma = 1.4;
+
+  for (std::vector<Real> const &test : tests) {
+    std::vector<Real> const star = Star_State({test.begin(), test.begin() + 6}, gamma);
+    // The tabulated values have six significant figures
+    EXPECT_NEAR(test[6], star[0], 1.0e-5 + 1.0e-5 * std::abs(test[6]));
+    EXPECT_NEAR(test[7], star[1], 1.0e-5 + 1.0e-5 * std::abs(test[7]));
+  }
+}
+
+TEST(tHYDROExactStarState, NearlyUniformInterfaceExpectIteratedStarState)
+{
+  // Jumps just inside the early exit, compared to a state just outside it that
+  // goes through the Newton iteration
+  Real const gamma                  = 5.0 / 3.0;
+  std::vector<Real> const uniform   = {1.0, 0.3, 2.0, 1.0009, 0.3001, 2.0018};
+  std::vector<Real> const iterated  = {1.0, 0.3, 2.0, 1.0011, 0.3001, 2.0018};
+  std::vector<Real> const star      = Star_State(uniform, gamma);
+  std::vector<Real> const reference = Star_State(iterated, gamma);
+
+  // Both are within the Newton tolerance of the exact star state, and the
+  // density jump barely moves it
+  EXPECT_NEAR(reference[0], star[0], 1.0e-5 * reference[0]);
+  EXPECT_NEAR(reference[1], star[1], 1.0e-5);
+}
+// =============================================================================
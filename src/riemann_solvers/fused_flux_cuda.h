@@ -0,0 +1,176 @@
+/*!
+ * \file fused_flux_cuda.h
+ * \brief Contains the declaration and implementation of the fused
+ * reconstruction and Riemann solver kernel and the Riemann solver policies it
+ * can be instantiated with. Since the kernel is templated the implementation is
+ * in the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
+#include "../reconstruction/reconstruction.h"
+#include "../riemann_solvers/hllc_cuda.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/gpu.hpp"
+#include "../utils/hydro_utilities.h"
+
+namespace riemann_solvers
+{
+/*!
+ * \brief The HLLC Riemann solver as a policy for Calculate_Fluxes_Fused_3D.
+ * Converts the primitive interface states to the rotated conserved states
+ * expected by hllc::Calculate_Flux the same way that
+ * reconstruction::Write_Data does, so the fluxes match those of the unfused
+ * path.
+ */
+struct HllcPolicy {
+  /// The number of entries in the rotated state and flux arrays
+  static int constexpr n_state_vars = hllc::n_state_vars;
+
+  /*!
+   * \brief Compute the flux through one interface
+   *
+   * \param[in] interface_L The primitive state on the left side of the interface
+   * \param[in] interface_R The primitive state on the right side of the interface
+   * \param[out] flux The flux through the interface, rotated so that index 1 is
+   * the momentum normal to the interface
+   * \param[in] gamma The adiabatic index
+   */
+  static inline __device__ void Flux(reconstruction::Primitive const &interface_L,
+                                     reconstruction::Primitive const &interface_R, Real flux[n_state_vars],
+                                     Real const gamma)
+  {
+    Real_Solver stateL[n_state_vars], stateR[n_state_vars], solver_flux[n_state_vars];
+    To_State(interface_L, stateL, gamma);
+    To_State(interface_R, stateR, gamma);
+
+    hllc::Calculate_Flux<Real_Solver>(stateL, stateR, solver_flux, gamma);
+    for (int i = 0; i < n_state_vars; i++) {
+      flux[i] = solver_flux[i];
+    }
+  }
+
+ private:
+  static inline __device__ void To_State(reconstruction::Primitive const &primitive, Real_Solver state[n_state_vars],
+                                         Real const gamma)
+  {
+    state[0] = primitive.density;
+    state[1] = primitive.density * primitive.velocity_x;
+    state[2] = primitive.density * primitive.velocity_y;
+    state[3] = primitive.density * primitive.velocity_z;
+    state[4] = hydro_utilities::Calc_Energy_Primitive(primitive.pressure, primitive.density, primitive.velocity_x,
+                                                      primitive.velocity_y, primitive.velocity_z, gamma);
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      state[5 + i] = primitive.density * primitive.scalar[i];
+    }
+#endif  // SCALAR
+#ifdef DE
+    state[hllc::gas_energy_id] = primitive.density * primitive.gas_energy;
+#endif  // DE
+  }
+};
+}  // namespace riemann_solvers
+
+/*!
+ * \brief Reconstruct the interface states and solve the Riemann problem in a
+ * single kernel. Each thread computes the flux through the i+1/2 face of its
+ * cell from the left state of cell i and the right state of cell i+1, so the
+ * interface states never go through global memory. The fluxes are written in
+ * the same layout as the unfused Riemann solvers and only for faces where both
+ * cells pass the reconstruction's thread guard; other faces are left
+ * untouched.
+ *
+ * \tparam Reconstruction The reconstruction policy, e.g.
+ * reconstruction::PlmcPolicy or reconstruction::PpmcPolicy
+ * \tparam RiemannSolver The Riemann solver policy, e.g.
+ * riemann_solvers::HllcPolicy
+ * \param[in] dev_conserved The conserved variable array
+ * \param[out] dev_flux The flux array
+ * \param[in] nx The number of cells in the X-direction
+ * \param[in] ny The number of cells in the Y-direction
+ * \param[in] nz The number of cells in the Z-direction
+ * \param[in] dx The length of the cells in the `dir` direction
+ * \param[in] dt The time step
+ * \param[in] gamma The adiabatic index
+ * \param[in] dir The direction. 0=X, 1=Y, 2=Z
+ * \param[in] n_fields The total number of fields
+ */
+template <typename Reconstruction, typename RiemannSolver>
+__global__ __launch_bounds__(TPB) void Calculate_Fluxes_Fused_3D(Real const *dev_conserved, Real *dev_flux, int nx,
+                                                                 int ny, int nz, Real dx, Real dt, Real gamma, int dir,
+                                                                 int n_fields)
+{
+  // get a thread ID
+  int const thread_id = threadIdx.x + blockIdx.x * blockDim.x;
+  int xid, yid, zid;
+  cuda_utilities::compute3DIndices(thread_id, nx, ny, xid, yid, zid);
+
+  // The indices of the cell on the right side of the face
+  int const xid_R = xid + int(dir == 0);
+  int const yid_R = yid + int(dir == 1);
+  int const zid_R = zid + int(dir == 2);
+
+  // Ensure that both cells are ones the unfused reconstruction would operate on
+  if (reconstruction::Thread_Guard<Reconstruction::order>(nx, ny, nz, xid, yid, zid) or
+      reconstruction::Thread_Guard<Reconstruction::order>(nx, ny, nz, xid_R, yid_R, zid_R)) {
+    return;
+  }
+
+  int const n_cells = nx * ny * nz;
+
+  // Set the field indices for the various directions
+  int o1, o2, o3;
+  switch (dir) {
+    case 0:
+      o1 = grid_enum::momentum_x;
+      o2 = grid_enum::momentum_y;
+      o3 = grid_enum::momentum_z;
+      break;
+    case 1:
+      o1 = grid_enum::momentum_y;
+      o2 = grid_enum::momentum_z;
+      o3 = grid_enum::momentum_x;
+      break;
+    case 2:
+      o1 = grid_enum::momentum_z;
+      o2 = grid_enum::momentum_x;
+      o3 = grid_enum::momentum_y;
+      break;
+  }
+
+  // The left state of the face is the i+1/2 interface of cell i and the right
+  // state is the i-1/2 interface of cell i+1
+  reconstruction::Primitive interface_L, interface_R, unused;
+  Reconstruction::Interfaces(dev_conserved, xid, yid, zid, nx, ny, n_cells, dx, dt, gamma, dir, o1, o2, o3, interface_L,
+                             unused);
+  Reconstruction::Interfaces(dev_conserved, xid_R, yid_R, zid_R, nx, ny, n_cells, dx, dt, gamma, dir, o1, o2, o3,
+                             unused, interface_R);
+
+  Real flux[RiemannSolver::n_state_vars];
+  RiemannSolver::Flux(interface_L, interface_R, flux, gamma);
+
+  // Write the fluxes in the same layout as the unfused Riemann solvers
+  dev_flux[grid_enum::density * n_cells + thread_id] = flux[0];
+  dev_flux[o1 * n_cells + thread_id]                 = flux[1];
+  dev_flux[o2 * n_cells + thread_id]                 = flux[2];
+  dev_flux[o3 * n_cells + thread_id]                 = flux[3];
+  dev_flux[grid_enum::Energy * n_cells + thread_id]  = flux[4];
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    dev_flux[(grid_enum::scalar + i) * n_cells + thread_id] = flux[5 + i];
+  }
+#endif  // SCALAR
+#ifdef DE
+  dev_flux[(n_fields - 1) * n_cells + thread_id] = flux[hllc::gas_energy_id];
+#endif  // DE
+}
@@ -0,0 +1,136 @@
+/*!
+ * \file fused_flux_cuda_tests.cu
+ * \brief Tests for the contents of fused_flux_cuda.h
+ *
+ */
+
+// STL Includes
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../reconstruction/plmc_cuda.h"
+#include "../reconstruction/ppmc_cuda.h"
+#include "../riemann_solvers/fused_flux_cuda.h"
+#include "../riemann_solvers/hllc_cuda.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/testing_utilities.h"
+
+#ifndef MHD
+namespace
+{
+/*!
+ * \brief Compare the fused reconstruction and HLLC kernel against the
+ * reconstruction kernel followed by Calculate_HLLC_Fluxes_CUDA on a random
+ * grid, in all three directions
+ *
+ * \tparam Reconstruction The reconstruction policy to fuse
+ * \tparam Launcher A callable that launches the unfused reconstruction
+ * \param[in] unfused_reconstruction Launches the unfused reconstruction with
+ * arguments (conserved, bounds_L, bounds_R, nx, ny, nz, dx, dt, gamma, dir)
+ */
+template <typename Reconstruction, typename Launcher>
+void Check_Fused_Matches_Unfused(Launcher unfused_reconstruction)
+{
+  // Set up PRNG to use
+  std::mt19937_64 prng(42);
+  std::uniform_real_distribution<double> doubleRand(0.1, 5);
+
+  // Mock up needed information
+  int const nx = 8, ny = nx, nz = nx;
+  int const n_fields  = grid_enum::num_fields;
+  int const n_cells   = nx * ny * nz;
+  double const dx     = doubleRand(prng);
+  double const dt     = doubleRand(prng);
+  double const gamma  = 5.0 / 3.0;
+  int const numBlocks = (n_cells + TPB - 1) / TPB;
+
+  auto *const hllc_kernel  = Select_Calculate_HLLC_Fluxes_CUDA(n_fields);
+  auto *const fused_kernel = Calculate_Fluxes_Fused_3D<Reconstruction, riemann_solvers::HllcPolicy>;
+
+  // Setup host grid. Use a large energy so that the pressure stays positive
+  std::vector<double> host_grid(n_cells * n_fields);
+  for (double &val : host_grid) {
+    val = doubleRand(prng);
+  }
+  for (int i = 0; i < n_cells; i++) {
+    host_grid[grid_enum::Energy * n_cells + i] += 50.0;
+  }
+
+  cuda_utilities::DeviceVector<double> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+
+  for (int direction = 0; direction < 3; direction++) {
+    cuda_utilities::DeviceVector<double> dev_interface_left(host_grid.size(), true);
+    cuda_utilities::DeviceVector<double> dev_interface_right(host_grid.size(), true);
+    cuda_utilities::DeviceVector<double> dev_flux_unfused(host_grid.size(), true);
+    cuda_utilities::DeviceVector<double> dev_flux_fused(host_grid.size(), true);
+
+    // Unfused path
+    unfused_reconstruction(dev_grid.data(), dev_interface_left.data(), dev_interface_right.data(), nx, ny, nz, dx, dt,
+                           gamma, direction);
+    hipLaunchKernelGGL(hllc_kernel, numBlocks, TPB, 0, 0, dev_interface_left.data(), dev_interface_right.data(),
+                       dev_flux_unfused.data(), nx, ny, nz, 0, gamma, direction, n_fields);
+    GPU_Error_Check();
+
+    // Fused path
+    hipLaunchKernelGGL(fused_kernel, numBlocks, TPB, 0, 0, dev_grid.data(), dev_flux_fused.data(), nx, ny, nz, dx, dt,
+                       gamma, direction, n_fields);
+    GPU_Error_Check();
+    GPU_Error_Check(cudaDeviceSynchronize());
+
+    // Compare the faces that the fused kernel computes
+    for (int zid = 0; zid < nz; zid++) {
+      for (int yid = 0; yid < ny; yid++) {
+        for (int xid = 0; xid < nx; xid++) {
+          if (reconstruction::Thread_Guard<Reconstruction::order>(nx, ny, nz, xid, yid, zid) or
+              reconstruction::Thread_Guard<Reconstruction::order>(
+                  nx, ny, nz, xid + int(direction == 0), yid + int(direction == 1), zid + int(direction == 2))) {
+            continue;
+          }
+
+          int const id = xid + yid * nx + zid * nx * ny;
+          for (int field = 0; field < n_fields; field++) {
+            testing_utilities::Check_Results(dev_flux_unfused.at(field * n_cells + id),
+                                             dev_flux_fused.at(field * n_cells + id),
+                                             "flux of field " + std::to_string(field) + " at i=" + std::to_string(id) +
+                                                 ", in direction " + std::to_string(direction));
+          }
+        }
+      }
+    }
+  }
+}
+}  // namespace
+
+TEST(tHYDROFusedFluxes, PlmcHllcCorrectInputExpectMatchesUnfused)
+{
+  #ifndef VL
+  std::cerr << "Warning: The tHYDROFusedFluxes.PlmcHllcCorrectInputExpectMatchesUnfused only supports the Van Leer "
+               "(VL) integrator"
+            << std::endl;
+  return;
+  #endif  // VL
+  Check_Fused_Matches_Unfused<reconstruction::PlmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                              int ny, int nz, double dx, double dt, double gamma,
+                                                              int dir) {
+    hipLaunchKernelGGL(PLMC_cuda, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, dx,
+                       dt, gamma, dir, grid_enum::num_fields);
+  });
+}
+
+TEST(tHYDROFusedFluxes, PpmcHllcCorrectInputExpectMatchesUnfused)
+{
+  Check_Fused_Matches_Unfused<reconstruction::PpmcPolicy>([](double *grid, double *bounds_L, double *bounds_R, int nx,
+                                                              int ny, int nz, double dx, double dt, double gamma,
+                                                              int dir) {
+    hipLaunchKernelGGL(PPMC_VL, (nx * ny * nz + TPB - 1) / TPB, TPB, 0, 0, grid, bounds_L, bounds_R, nx, ny, nz, gamma,
+                       dir);
+  });
+}
+#endif  // not MHD
@@ -4,13 +4,356 @@
 #ifndef HLLC_CUDA_H
 #define HLLC_CUDA_H
 
+#include <math.h>
+
 #include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../grid/grid_enum.h"
+#include "../utils/gpu.hpp"
+
+#ifdef DE  // PRESSURE_DE
+  #include "../utils/hydro_utilities.h"
+#endif
 
 /*! \fn Calculate_HLLC_Fluxes_CUDA(Real *dev_bounds_L, Real *dev_bounds_R, Real
  * *dev_flux, int nx, int ny, int nz, int n_ghost, Real gamma, int dir, int
  * n_fields) \brief Roe Riemann solver based on the version described in Stone
- * et al, 2008. */
+ * et al, 2008. If n_fields_static is nonzero it replaces the n_fields argument
+ * so the field count is a compile time constant. */
+template <int n_fields_static>
 __global__ void Calculate_HLLC_Fluxes_CUDA(Real *dev_bounds_L, Real *dev_bounds_R, Real *dev_flux, int nx, int ny,
                                            int nz, int n_ghost, Real gamma, int dir, int n_fields);
 
+/*! \fn Select_Calculate_HLLC_Fluxes_CUDA(int n_fields)
+ *  \brief Select the instantiation of Calculate_HLLC_Fluxes_CUDA to launch. This
+ *  is the one specialized for the field count of this build when n_fields
+ *  matches it and the generic one otherwise. */
+decltype(&Calculate_HLLC_Fluxes_CUDA<0>) Select_Calculate_HLLC_Fluxes_CUDA(int n_fields);
+
+namespace hllc
+{
+/*!
+ * \brief Index of the advected internal energy in the state arrays passed to
+ * hllc::Calculate_Flux. The first five entries are density, normal momentum,
+ * the two transverse momenta and energy, followed by the NSCALARS passive
+ * scalars.
+ */
+int constexpr gas_energy_id = 5 + NSCALARS;
+
+/*!
+ * \brief Size of the state and flux arrays passed to hllc::Calculate_Flux
+ */
+int constexpr n_state_vars = grid_enum::num_flux_fields;
+
+/*!
+ * \brief The largest relative jump in the pressure and the density, and jump
+ * in the transverse velocity in units of the sound speed, of an interface
+ * that HLLC_HYBRID solves with the HLL flux
+ */
+Real constexpr hybrid_jump_threshold = 0.05;
+
+/*!
+ * \brief Whether an interface is smooth enough for the HLL flux of
+ * HLLC_HYBRID. The pressure jump flags the shocks, the density jump the
+ * contacts and the transverse velocity jump the shear, which HLL would smear
+ *
+ * \tparam T The floating point type the solver computes in
+ * \param[in] dl, dr The densities on the left and right sides
+ * \param[in] pl, pr The pressures on the left and right sides
+ * \param[in] vyl, vyr, vzl, vzr The transverse velocities on both sides
+ * \param[in] cs The smaller of the sound speeds on both sides
+ * \return true if all jumps are below hybrid_jump_threshold
+ */
+template <typename T = Real>
+inline __host__ __device__ bool Is_Smooth_Interface(T const dl, T const dr, T const pl, T const pr, T const vyl,
+                                                    T const vyr, T const vzl, T const vzr, T const cs)
+{
+  T const threshold = T(hybrid_jump_threshold);
+  return fabs(pr - pl) < threshold * fmin(pl, pr) && fabs(dr - dl) < threshold * fmin(dl, dr) &&
+         fabs(vyr - vyl) + fabs(vzr - vzl) < threshold * cs;
+}
+
+/*!
+ * \brief Compute the HLLC flux through a single interface. This is the body of
+ * Calculate_HLLC_Fluxes_CUDA and is shared with the fused VL predictor so that
+ * both paths produce identical fluxes.
+ *
+ * \tparam T The floating point type the solver computes in. Real by default,
+ * Real_Solver for the float arithmetic of MIXED_PRECISION
+ * \param[in] stateL The conserved state on the left side of the interface,
+ * rotated so that index 1 is the momentum normal to the interface
+ * \param[in] stateR The conserved state on the right side of the interface,
+ * rotated so that index 1 is the momentum normal to the interface
+ * \param[out] flux The flux through the interface, in the same rotated order
+ * \param[in] gamma The adiabatic index
+ */
+template <typename T = Real>
+inline __device__ void Calculate_Flux(T const stateL[n_state_vars], T const stateR[n_state_vars], T flux[n_state_vars],
+                                      T const gamma)
+{
+  T dl, vxl, mxl, vyl, myl, vzl, mzl, pl, El;
+  T dr, vxr, mxr, vyr, myr, vzr, mzr, pr, Er;
+
+  T g1 = gamma - T(1.0);
+  T Hl, Hr;
+  T sqrtdl, sqrtdr, vx, vy, vz, H;
+  T vsq, asq, a;
+  T lambda_m, lambda_p;
+  T f_d_l, f_mx_l, f_my_l, f_mz_l, f_E_l;
+  T f_d_r, f_mx_r, f_my_r, f_mz_r, f_E_r;
+  T dls, drs, mxls, mxrs, myls, myrs, mzls, mzrs, Els, Ers;
+  T Sl, Sr, Sm, cfl, cfr, ps;
+#ifdef DE
+  T dgel, dger, gel, ger, gels, gers, f_ge_l, f_ge_r, E_kin;
+#endif
+#ifdef SCALAR
+  T dscl[NSCALARS], dscr[NSCALARS], scl[NSCALARS], scr[NSCALARS], scls[NSCALARS], scrs[NSCALARS], f_sc_l[NSCALARS],
+    f_sc_r[NSCALARS];
+#endif
+
+  T etah = 0;
+
+  // retrieve conserved variables
+  dl  = stateL[0];
+  mxl = stateL[1];
+  myl = stateL[2];
+  mzl = stateL[3];
+  El  = stateL[4];
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    dscl[i] = stateL[5 + i];
+  }
+#endif
+#ifdef DE
+  dgel = stateL[gas_energy_id];
+#endif
+
+  dr  = stateR[0];
+  mxr = stateR[1];
+  myr = stateR[2];
+  mzr = stateR[3];
+  Er  = stateR[4];
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    dscr[i] = stateR[5 + i];
+  }
+#endif
+#ifdef DE
+  dger = stateR[gas_energy_id];
+#endif
+
+  // calculate primitive variables
+  vxl = mxl / dl;
+  vyl = myl / dl;
+  vzl = mzl / dl;
+#ifdef DE  // PRESSURE_DE
+  E_kin = T(0.5) * dl * (vxl * vxl + vyl * vyl + vzl * vzl);
+  pl    = (T)hydro_utilities::Get_Pressure_From_DE(El, El - E_kin, dgel, gamma);
+#else
+  pl = (El - T(0.5) * dl * (vxl * vxl + vyl * vyl + vzl * vzl)) * (gamma - T(1.0));
+#endif  // PRESSURE_DE
+  pl = fmax(pl, (T)TINY_NUMBER);
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    scl[i] = dscl[i] / dl;
+  }
+#endif
+#ifdef DE
+  gel = dgel / dl;
+#endif
+  vxr = mxr / dr;
+  vyr = myr / dr;
+  vzr = mzr / dr;
+#ifdef DE  // PRESSURE_DE
+  E_kin = T(0.5) * dr * (vxr * vxr + vyr * vyr + vzr * vzr);
+  pr    = (T)hydro_utilities::Get_Pressure_From_DE(Er, Er - E_kin, dger, gamma);
+#else
+  pr = (Er - T(0.5) * dr * (vxr * vxr + vyr * vyr + vzr * vzr)) * (gamma - T(1.0));
+#endif  // PRESSURE_DE
+  pr = fmax(pr, (T)TINY_NUMBER);
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    scr[i] = dscr[i] / dr;
+  }
+#endif
+#ifdef DE
+  ger = dger / dr;
+#endif
+
+  // calculate the enthalpy in each cell
+  Hl = (El + pl) / dl;
+  Hr = (Er + pr) / dr;
+
+  // calculate averages of the variables needed for the Roe Jacobian
+  // (see Stone et al., 2008, Eqn 65, or Toro 2009, 11.118)
+  sqrtdl = sqrt(dl);
+  sqrtdr = sqrt(dr);
+  vx     = (sqrtdl * vxl + sqrtdr * vxr) / (sqrtdl + sqrtdr);
+  vy     = (sqrtdl * vyl + sqrtdr * vyr) / (sqrtdl + sqrtdr);
+  vz     = (sqrtdl * vzl + sqrtdr * vzr) / (sqrtdl + sqrtdr);
+  H      = (sqrtdl * Hl + sqrtdr * Hr) / (sqrtdl + sqrtdr);
+
+  // calculate the sound speed squared (Stone B2)
+  vsq = (vx * vx + vy * vy + vz * vz);
+  asq = g1 * (H - T(0.5) * vsq);
+  a   = sqrt(asq);
+
+  // calculate the averaged eigenvectors of the Roe matrix (Stone Eqn B2,
+  // Toro 11.107)
+  lambda_m = vx - a;
+  lambda_p = vx + a;
+
+  // compute max and min wave speeds
+  cfl = sqrt(gamma * pl / dl);  // sound speed in left state
+  cfr = sqrt(gamma * pr / dr);  // sound speed in right state
+
+  // for signal speeds, take max/min of Roe eigenvalues and left and right
+  // sound speeds Batten eqn. 48
+  Sl = fmin(lambda_m, vxl - cfl);
+  Sr = fmax(lambda_p, vxr + cfr);
+
+  // if the H-correction is turned on, add cross-flux dissipation
+  Sl = sgn_CUDA(Sl) * fmax(fabs(Sl), etah);
+  Sr = sgn_CUDA(Sr) * fmax(fabs(Sr), etah);
+
+  // left and right fluxes
+  f_d_l  = mxl;
+  f_mx_l = mxl * vxl + pl;
+  f_my_l = myl * vxl;
+  f_mz_l = mzl * vxl;
+  f_E_l  = (El + pl) * vxl;
+#ifdef DE
+  f_ge_l = dgel * vxl;
+#endif
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    f_sc_l[i] = dscl[i] * vxl;
+  }
+#endif
+
+  f_d_r  = mxr;
+  f_mx_r = mxr * vxr + pr;
+  f_my_r = myr * vxr;
+  f_mz_r = mzr * vxr;
+  f_E_r  = (Er + pr) * vxr;
+#ifdef DE
+  f_ge_r = dger * vxr;
+#endif
+#ifdef SCALAR
+  for (int i = 0; i < NSCALARS; i++) {
+    f_sc_r[i] = dscr[i] * vxr;
+  }
+#endif
+
+  // return upwind flux if flow is supersonic
+  if (Sl > T(0.0)) {
+    flux[0] = f_d_l;
+    flux[1] = f_mx_l;
+    flux[2] = f_my_l;
+    flux[3] = f_mz_l;
+    flux[4] = f_E_l;
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      flux[5 + i] = f_sc_l[i];
+    }
+#endif
+#ifdef DE
+    flux[gas_energy_id] = f_ge_l;
+#endif
+    return;
+  } else if (Sr < T(0.0)) {
+    flux[0] = f_d_r;
+    flux[1] = f_mx_r;
+    flux[2] = f_my_r;
+    flux[3] = f_mz_r;
+    flux[4] = f_E_r;
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      flux[5 + i] = f_sc_r[i];
+    }
+#endif
+#ifdef DE
+    flux[gas_energy_id] = f_ge_r;
+#endif
+    return;
+  }
+  // otherwise compute subsonic flux
+  else {
+#ifdef HLLC_HYBRID
+    // the smooth interfaces take the cheaper HLL flux, which skips the
+    // contact wave and the star states (Toro 2009, 10.21)
+    if (Is_Smooth_Interface<T>(dl, dr, pl, pr, vyl, vyr, vzl, vzr, fmin(cfl, cfr))) {
+      T const inv_dS = T(1.0) / (Sr - Sl);
+      flux[0]        = (Sr * f_d_l - Sl * f_d_r + Sl * Sr * (dr - dl)) * inv_dS;
+      flux[1]        = (Sr * f_mx_l - Sl * f_mx_r + Sl * Sr * (mxr - mxl)) * inv_dS;
+      flux[2]        = (Sr * f_my_l - Sl * f_my_r + Sl * Sr * (myr - myl)) * inv_dS;
+      flux[3]        = (Sr * f_mz_l - Sl * f_mz_r + Sl * Sr * (mzr - mzl)) * inv_dS;
+      flux[4]        = (Sr * f_E_l - Sl * f_E_r + Sl * Sr * (Er - El)) * inv_dS;
+  #ifdef SCALAR
+      for (int i = 0; i < NSCALARS; i++) {
+        flux[5 + i] = (Sr * f_sc_l[i] - Sl * f_sc_r[i] + Sl * Sr * (dscr[i] - dscl[i])) * inv_dS;
+      }
+  #endif  // SCALAR
+  #ifdef DE
+      flux[gas_energy_id] = (Sr * f_ge_l - Sl * f_ge_r + Sl * Sr * (dger - dgel)) * inv_dS;
+  #endif  // DE
+      return;
+    }
+#endif  // HLLC_HYBRID
+
+    // compute contact wave speed and pressure in star region (Batten eqns 34
+    // & 36)
+    Sm = (dr * vxr * (Sr - vxr) - dl * vxl * (Sl - vxl) + pl - pr) / (dr * (Sr - vxr) - dl * (Sl - vxl));
+    ps = dl * (vxl - Sl) * (vxl - Sm) + pl;
+
+    // conserved variables in the left star state (Batten eqns 35 - 40)
+    dls  = dl * (Sl - vxl) / (Sl - Sm);
+    mxls = (mxl * (Sl - vxl) + ps - pl) / (Sl - Sm);
+    myls = dls * vyl;
+    mzls = dls * vzl;
+    Els  = (El * (Sl - vxl) - pl * vxl + ps * Sm) / (Sl - Sm);
+#ifdef DE
+    gels = dls * gel;
+#endif
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      scls[i] = dls * scl[i];
+    }
+#endif
+
+    // conserved variables in the right star state
+    drs  = dr * (Sr - vxr) / (Sr - Sm);
+    mxrs = (mxr * (Sr - vxr) + ps - pr) / (Sr - Sm);
+    myrs = drs * vyr;
+    mzrs = drs * vzr;
+    Ers  = (Er * (Sr - vxr) - pr * vxr + ps * Sm) / (Sr - Sm);
+#ifdef DE
+    gers = drs * ger;
+#endif
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      scrs[i] = drs * scr[i];
+    }
+#endif
+
+    // compute the hllc flux (Batten eqn 27)
+    flux[0] = T(0.5) * (f_d_l + f_d_r + (Sr - fabs(Sm)) * drs + (Sl + fabs(Sm)) * dls - Sl * dl - Sr * dr);
+    flux[1] = T(0.5) * (f_mx_l + f_mx_r + (Sr - fabs(Sm)) * mxrs + (Sl + fabs(Sm)) * mxls - Sl * mxl - Sr * mxr);
+    flux[2] = T(0.5) * (f_my_l + f_my_r + (Sr - fabs(Sm)) * myrs + (Sl + fabs(Sm)) * myls - Sl * myl - Sr * myr);
+    flux[3] = T(0.5) * (f_mz_l + f_mz_r + (Sr - fabs(Sm)) * mzrs + (Sl + fabs(Sm)) * mzls - Sl * mzl - Sr * mzr);
+    flux[4] = T(0.5) * (f_E_l + f_E_r + (Sr - fabs(Sm)) * Ers + (Sl + fabs(Sm)) * Els - Sl * El - Sr * Er);
+#ifdef DE
+    flux[gas_energy_id] =
+        T(0.5) * (f_ge_l + f_ge_r + (Sr - fabs(Sm)) * gers + (Sl + fabs(Sm)) * gels - Sl * dgel - Sr * dger);
+#endif
+#ifdef SCALAR
+    for (int i = 0; i < NSCALARS; i++) {
+      flux[5 + i] = T(0.5) * (f_sc_l[i] + f_sc_r[i] + (Sr - fabs(Sm)) * scrs[i] + (Sl + fabs(Sm)) * scls[i] -
+                              Sl * dscl[i] - Sr * dscr[i]);
+    }
+#endif
+  }
+}
+}  // namespace hllc
+
 #endif  // HLLC_CUDA_H
@@ -16,6 +16,7 @@
 // Local Includes
 #include "../global/global_cuda.h"
 #include "../riemann_solvers/hllc_cuda.h"  // Include code to test
+#include "../utils/DeviceVector.h"
 #include "../utils/gpu.hpp"
 #include "../utils/testing_utilities.h"
 
@@ -76,7 +77,8 @@ class tHYDROCalculateHLLCFluxesCUDA : public ::testing::Test
     GPU_Error_Check(cudaMemcpy(devConservedRight, stateRight.data(), nFields * sizeof(Real), cudaMemcpyHostToDevice));
 
     // Run kernel
-    hipLaunchKernelGGL(Calculate_HLLC_Fluxes_CUDA, dimGrid, dimBlock, 0, 0,
+    auto *const hllc_kernel = Select_Calculate_HLLC_Fluxes_CUDA(nFields);
+    hipLaunchKernelGGL(hllc_kernel, dimGrid, dimBlock, 0, 0,
                        devConservedLeft,   // the "left" interface
                        devConservedRight,  // the "right" interface
                        devTestFlux, nx, ny, nz, nGhost, gamma, direction, nFields);
@@ -178,4 +180,119 @@ TEST_F(tHYDROCalculateHLLCFluxesCUDA,        // Test suite name
 }
 // =========================================================================
 
+// =========================================================================
+/*!
+ * \brief Test that a stationary contact has no mass or energy flux, also
+ * when HLLC_HYBRID is on
+ *
+ */
+TEST_F(tHYDROCalculateHLLCFluxesCUDA, StationaryContactExpectNoMassFlux)
+{
+  Real const gamma    = 1.4;
+  Real const pressure = 1.0;
+  Real const energy   = pressure / (gamma - 1);
+
+  std::vector<Real> const stateLeft{1.0, 0, 0, 0, energy};
+  std::vector<Real> const stateRight{0.1, 0, 0, 0, energy};
+  std::vector<Real> const fiducialFluxes{0, pressure, 0, 0, 0};
+
+  std::vector<Real> const testFluxes = Compute_Fluxes(stateLeft, stateRight, gamma);
+  Check_Results(fiducialFluxes, testFluxes);
+}
+// =========================================================================
+
+// =========================================================================
+/*!
+ * \brief Test that only the interfaces with small pressure, density and
+ * shear jumps are smooth
+ *
+ */
+TEST(tHYDROHLLCIsSmoothInterface, CorrectInputExpectCorrectOutput)
+{
+  double const d = 1.0, p = 1.0, cs = 1.0;
+  EXPECT_TRUE(hllc::Is_Smooth_Interface<double>(d, 1.01 * d, p, 1.01 * p, 0.0, 0.01, 0.0, 0.01, cs));
+  // a shock
+  EXPECT_FALSE(hllc::Is_Smooth_Interface<double>(d, 1.01 * d, p, 2.0 * p, 0.0, 0.0, 0.0, 0.0, cs));
+  // a contact
+  EXPECT_FALSE(hllc::Is_Smooth_Interface<double>(d, 0.5 * d, p, p, 0.0, 0.0, 0.0, 0.0, cs));
+  // a shear layer
+  EXPECT_FALSE(hllc::Is_Smooth_Interface<double>(d, d, p, p, -0.5, 0.5, 0.0, 0.0, cs));
+}
+// =========================================================================
+
+// =========================================================================
+/*!
+ * \brief Test that the dispatcher only picks the specialized kernel when the
+ * number of fields matches the build
+ *
+ */
+TEST(tHYDROSelectCalculateHLLCFluxesCUDA, CorrectInputExpectCorrectOutput)
+{
+  EXPECT_EQ(Select_Calculate_HLLC_Fluxes_CUDA(grid_enum::num_fields),
+            &Calculate_HLLC_Fluxes_CUDA<grid_enum::num_fields>);
+  EXPECT_EQ(Select_Calculate_HLLC_Fluxes_CUDA(grid_enum::num_fields + 1), &Calculate_HLLC_Fluxes_CUDA<0>);
+}
+// =========================================================================
+
+// =========================================================================
+namespace
+{
+/*!
+ * \brief Compute the HLLC flux of one interface in double and in float
+ */
+__global__ void Calculate_Flux_Both_Precisions(double const *stateL, double const *stateR, double gamma,
+                                               double *flux_double, double *flux_float)
+{
+  double stateL_double[hllc::n_state_vars], stateR_double[hllc::n_state_vars], result_double[hllc::n_state_vars];
+  float stateL_float[hllc::n_state_vars], stateR_float[hllc::n_state_vars], result_float[hllc::n_state_vars];
+  for (int i = 0; i < hllc::n_state_vars; i++) {
+    stateL_double[i] = stateL[i];
+    stateR_double[i] = stateR[i];
+    stateL_float[i]  = stateL[i];
+    stateR_float[i]  = stateR[i];
+  }
+
+  hllc::Calculate_Flux<double>(stateL_double, stateR_double, result_double, gamma);
+  hllc::Calculate_Flux<float>(stateL_float, stateR_float, result_float, gamma);
+
+  for (int i = 0; i < hllc::n_state_vars; i++) {
+    flux_double[i] = result_double[i];
+    flux_float[i]  = result_float[i];
+  }
+}
+}  // namespace
+
+/*!
+ * \brief Test that the float instantiation of hllc::Calculate_Flux used by
+ * MIXED_PRECISION agrees with the double one to single precision on a
+ * subsonic interface
+ *
+ */
+TEST(tHYDROCalculateFluxMixedPrecision, SubsonicInterfaceExpectFloatCloseToDouble)
+{
+  double const gamma = 5.0 / 3.0;
+  std::vector<double> stateL(hllc::n_state_vars, 0.1), stateR(hllc::n_state_vars, 0.1);
+  // density, momentum x, y, z, energy
+  std::vector<double> const hydroL{1.0, 0.3, -0.2, 0.1, 2.5}, hydroR{0.125, -0.05, 0.1, 0.02, 0.3};
+  for (size_t i = 0; i < hydroL.size(); i++) {
+    stateL[i] = hydroL[i];
+    stateR[i] = hydroR[i];
+  }
+
+  cuda_utilities::DeviceVector<double> dev_stateL(hllc::n_state_vars), dev_stateR(hllc::n_state_vars);
+  cuda_utilities::DeviceVector<double> dev_flux_double(hllc::n_state_vars), dev_flux_float(hllc::n_state_vars);
+  dev_stateL.cpyHostToDevice(stateL);
+  dev_stateR.cpyHostToDevice(stateR);
+
+  hipLaunchKernelGGL(Calculate_Flux_Both_Precisions, 1, 1, 0, 0, dev_stateL.data(), dev_stateR.data(), gamma,
+                     dev_flux_double.data(), dev_flux_float.data());
+  GPU_Error_Check();
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  for (int i = 0; i < hllc::n_state_vars; i++) {
+    testing_utilities::Check_Results(dev_flux_double.at(i), dev_flux_float.at(i), "flux " + std::to_string(i), 1.0E-5);
+  }
+}
+// =========================================================================
+
 #endif
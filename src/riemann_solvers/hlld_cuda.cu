@@ -164,6 +164,101 @@ __global__ void Calculate_HLLD_Fluxes_CUDA(Real const *dev_bounds_L, Real const
 }
 // =========================================================================
 
+// =========================================================================
+__global__ __launch_bounds__(TPB) void Calculate_HLLD_Fluxes_Predicated_CUDA(
+    Real const *dev_bounds_L, Real const *dev_bounds_R, Real const *dev_magnetic_face, Real *dev_flux,
+    int const n_cells, Real const gamma, int const direction, int const n_fields)
+{
+  // get a thread index
+  int const threadId = threadIdx.x + blockIdx.x * blockDim.x;
+
+  // Thread guard to avoid overrun
+  if (threadId >= n_cells) {
+    return;
+  }
+
+  // Offsets & indices, cyclic in the direction of the solve
+  int const o1 = grid_enum::momentum_x + direction;
+  int const o2 = grid_enum::momentum_x + (direction + 1) % 3;
+  int const o3 = grid_enum::momentum_x + (direction + 2) % 3;
+
+  // ============================
+  // Retrieve state variables
+  // ============================
+  // The magnetic field in the X-direction
+  Real const magneticX = dev_magnetic_face[threadId];
+
+  mhd::internal::State const stateL =
+      mhd::internal::loadState(dev_bounds_L, magneticX, gamma, threadId, n_cells, o1, o2, o3);
+  mhd::internal::State const stateR =
+      mhd::internal::loadState(dev_bounds_R, magneticX, gamma, threadId, n_cells, o1, o2, o3);
+
+  // =================================================================
+  // Compute all the wave speeds and the star and double star states
+  // =================================================================
+  mhd::internal::Speeds speed  = mhd::internal::approximateLRWaveSpeeds(stateL, stateR, magneticX, gamma);
+  speed.M                      = approximateMiddleWaveSpeed(stateL, stateR, speed);
+  Real const totalPressureStar = mhd::internal::starTotalPressure(stateL, stateR, speed);
+
+  mhd::internal::StarState const starStateL =
+      mhd::internal::computeStarState(stateL, speed, speed.L, magneticX, totalPressureStar);
+  mhd::internal::StarState const starStateR =
+      mhd::internal::computeStarState(stateR, speed, speed.R, magneticX, totalPressureStar);
+  speed.LStar = mhd::internal::approximateStarWaveSpeed(starStateL, speed, magneticX, -1);
+  speed.RStar = mhd::internal::approximateStarWaveSpeed(starStateR, speed, magneticX, 1);
+
+  mhd::internal::DoubleStarState const doubleStarState =
+      mhd::internal::computeDoubleStarState(starStateL, starStateR, magneticX, totalPressureStar, speed);
+
+  // =================================================================
+  // Find the state of the interface
+  // =================================================================
+  // The same checks in the same order as Calculate_HLLD_Fluxes_CUDA so that
+  // the degenerate wave fans end up in the same state
+  // M&K 2005 equation 66
+  bool const inL       = speed.L > 0.0;
+  bool const inR       = not inL and speed.R < 0.0;
+  bool const nonStar   = inL or inR;
+  bool const inLStar   = not nonStar and speed.LStar > 0.0 and speed.L <= 0.0;
+  bool const inRStar   = not nonStar and not inLStar and speed.RStar <= 0.0 and speed.R >= 0.0;
+  bool const star      = inLStar or inRStar;
+  bool const inLDouble = not nonStar and not star and speed.M > 0.0 and speed.LStar <= 0.0;
+  bool const inRDouble = not nonStar and not star and not inLDouble and speed.RStar > 0.0 and speed.M <= 0.0;
+  bool const left      = inL or inLStar or inLDouble;
+
+  // Select the side of the fan
+  mhd::internal::State const &state         = left ? stateL : stateR;
+  mhd::internal::StarState const &starState = left ? starStateL : starStateR;
+  Real const speedSide                      = left ? speed.L : speed.R;
+  Real const speedSideStar                  = left ? speed.LStar : speed.RStar;
+  Real const doubleStarStateEnergy          = left ? doubleStarState.energyL : doubleStarState.energyR;
+
+  // =================================================================
+  // Compute and return the fluxes of the state
+  // =================================================================
+  mhd::internal::Flux const flux     = mhd::internal::nonStarFluxes(state, magneticX);
+  mhd::internal::Flux const starFlux = mhd::internal::starFluxes(starState, state, flux, speed, speedSide);
+  mhd::internal::Flux const doubleStarFlux = mhd::internal::computeDoubleStarFluxes(
+      doubleStarState, doubleStarStateEnergy, starState, state, flux, speed, speedSide, speedSideStar);
+
+  if (nonStar or star or inLDouble or inRDouble) {
+    mhd::internal::returnFluxes(threadId, o1, o2, o3, n_cells, dev_flux,
+                                nonStar ? flux : (star ? starFlux : doubleStarFlux), state);
+  }
+}
+// =========================================================================
+
+// =========================================================================
+decltype(&Calculate_HLLD_Fluxes_CUDA) Select_Calculate_HLLD_Fluxes_CUDA()
+{
+  #ifdef HLLD_PREDICATED
+  return Calculate_HLLD_Fluxes_Predicated_CUDA;
+  #else   // not HLLD_PREDICATED
+  return Calculate_HLLD_Fluxes_CUDA;
+  #endif  // HLLD_PREDICATED
+}
+// =========================================================================
+
 namespace internal
 {
 // =====================================================================
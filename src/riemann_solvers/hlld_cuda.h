@@ -13,6 +13,7 @@
 
 // Local Includes
 #include "../global/global.h"
+#include "../global/global_cuda.h"
 #include "../utils/hydro_utilities.h"
 
 /*!
@@ -42,6 +43,25 @@ __global__ void Calculate_HLLD_Fluxes_CUDA(Real const *dev_bounds_L, Real const
                                            Real const *dev_magnetic_face, Real *dev_flux, int const n_cells,
                                            Real const gamma, int const direction, int const n_fields);
 
+/*!
+ * \brief The branch minimized version of Calculate_HLLD_Fluxes_CUDA, with the
+ * same arguments and results. Every thread computes all the wave speeds and
+ * the star and double star states of both sides, then selects the side of the
+ * fan and its state with predicated selects, so it evaluates a single
+ * non-star, star and double star flux and has a single store of the fluxes
+ * instead of one per state. The kernel is capped at TPB threads per block to
+ * limit its register use
+ */
+__global__ __launch_bounds__(TPB) void Calculate_HLLD_Fluxes_Predicated_CUDA(
+    Real const *dev_bounds_L, Real const *dev_bounds_R, Real const *dev_magnetic_face, Real *dev_flux,
+    int const n_cells, Real const gamma, int const direction, int const n_fields);
+
+/*!
+ * \brief Select the HLLD kernel of this build, Calculate_HLLD_Fluxes_CUDA or
+ * Calculate_HLLD_Fluxes_Predicated_CUDA with HLLD_PREDICATED
+ */
+decltype(&Calculate_HLLD_Fluxes_CUDA) Select_Calculate_HLLD_Fluxes_CUDA();
+
 /*!
  * \brief Namespace to hold private functions used within the HLLD
  * solver
@@ -32,11 +32,13 @@
 /*!
 * \brief Test fixture for simple testing of the HLLD Riemann Solver.
 Effectively takes the left state, right state, fiducial fluxes, and
-custom user output then performs all the required running and testing
+custom user output then performs all the required running and testing. The
+parameter selects the kernel, Calculate_HLLD_Fluxes_Predicated_CUDA if it is
+true and Calculate_HLLD_Fluxes_CUDA otherwise
 *
 */
 // NOLINTNEXTLINE(readability-identifier-naming)
-class tMHDCalculateHLLDFluxesCUDA : public ::testing::Test
+class tMHDCalculateHLLDFluxesCUDA : public ::testing::TestWithParam<bool>
 {
  protected:
   // =====================================================================
@@ -110,7 +112,8 @@ class tMHDCalculateHLLDFluxesCUDA : public ::testing::Test
         cudaMemcpy(devConservedMagXFace, magneticX.data(), magneticX.size() * sizeof(Real), cudaMemcpyHostToDevice));
 
     // Run kernel
-    hipLaunchKernelGGL(mhd::Calculate_HLLD_Fluxes_CUDA, dimGrid, dimBlock, 0, 0,
+    auto *const kernel = GetParam() ? mhd::Calculate_HLLD_Fluxes_Predicated_CUDA : mhd::Calculate_HLLD_Fluxes_CUDA;
+    hipLaunchKernelGGL(kernel, dimGrid, dimBlock, 0, 0,
                        devConservedLeft,      // the "left" interface
                        devConservedRight,     // the "right" interface
                        devConservedMagXFace,  // the magnetic field at the interface
@@ -285,7 +288,7 @@ class tMHDCalculateHLLDFluxesCUDA : public ::testing::Test
  * the Brio & Wu Shock tube
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, BrioAndWuShockTubeCorrectInputExpectCorrectOutput)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, BrioAndWuShockTubeCorrectInputExpectCorrectOutput)
 {
   // Constant Values
   Real const gamma = 2.;
@@ -645,7 +648,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, BrioAndWuShockTubeCorrectInputExpectCorrectO
  * the Dai & Woodward Shock tube
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, DaiAndWoodwardShockTubeCorrectInputExpectCorrectOutput)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, DaiAndWoodwardShockTubeCorrectInputExpectCorrectOutput)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -983,7 +986,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, DaiAndWoodwardShockTubeCorrectInputExpectCor
  * the Ryu & Jones 4d Shock tube
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, RyuAndJones4dShockTubeCorrectInputExpectCorrectOutput)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, RyuAndJones4dShockTubeCorrectInputExpectCorrectOutput)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1287,7 +1290,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, RyuAndJones4dShockTubeCorrectInputExpectCorr
  * the Einfeldt Strong Rarefaction (EFR)
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, EinfeldtStrongRarefactionCorrectInputExpectCorrectOutput)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, EinfeldtStrongRarefactionCorrectInputExpectCorrectOutput)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1548,7 +1551,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, EinfeldtStrongRarefactionCorrectInputExpectC
  * examples in cholla/examples/3D
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, ConstantStatesExpectCorrectFlux)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, ConstantStatesExpectCorrectFlux)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1602,7 +1605,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, ConstantStatesExpectCorrectFlux)
  * \brief Test the HLLD Riemann Solver with the degenerate state
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, DegenerateStateCorrectInputExpectCorrectOutput)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, DegenerateStateCorrectInputExpectCorrectOutput)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1641,7 +1644,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, DegenerateStateCorrectInputExpectCorrectOutp
  * \brief Test the HLLD Riemann Solver with all zeroes
  *
  */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, AllZeroesExpectAllZeroes)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, AllZeroesExpectAllZeroes)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1677,7 +1680,7 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, AllZeroesExpectAllZeroes)
   density.
 *
 */
-TEST_F(tMHDCalculateHLLDFluxesCUDA, UnphysicalValuesExpectAutomaticFix)
+TEST_P(tMHDCalculateHLLDFluxesCUDA, UnphysicalValuesExpectAutomaticFix)
 {
   // Constant Values
   Real const gamma = 5. / 3.;
@@ -1801,6 +1804,14 @@ TEST_F(tMHDCalculateHLLDFluxesCUDA, UnphysicalValuesExpectAutomaticFix)
 }
 // =========================================================================
 
+// =========================================================================
+// Run every integration test with both HLLD kernels
+INSTANTIATE_TEST_SUITE_P(, tMHDCalculateHLLDFluxesCUDA, ::testing::Values(false, true),
+                         [](::testing::TestParamInfo<bool> const &info) {
+                           return info.param ? "Predicated" : "Branching";
+                         });
+// =========================================================================
+
 // =========================================================================
 // End of integration tests for the entire HLLD solver. Unit tests are below
 // =========================================================================
@@ -0,0 +1,124 @@
+/*!
+ * \file riemann_bench.cu
+ * \brief Benchmarks of the Riemann solver kernels. Built with `make bench`,
+ * run the executable with `--benchmark_out=<file> --benchmark_out_format=json`
+ * to export the results. The hydro solvers are benchmarked in hydro builds and
+ * HLLD, next to its predicated version, in MHD builds. HLLC runs its arithmetic in Real_Solver, so building
+ * with MIXED_PRECISION benchmarks the single precision version
+ *
+ */
+
+// STL Includes
+#include <vector>
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../riemann_solvers/exact_cuda.h"
+#include "../riemann_solvers/hll_cuda.h"
+#include "../riemann_solvers/hllc_cuda.h"
+#include "../riemann_solvers/hlld_cuda.h"
+#include "../riemann_solvers/roe_cuda.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/benchmark_utilities.h"
+
+namespace
+{
+/*!
+ * \brief The interface states and flux buffer of a Riemann solver benchmark
+ * on an n^3 grid
+ */
+struct Riemann_Setup {
+  int const n;
+  int const n_cells;
+  int const n_fields = grid_enum::num_fields;
+  int const n_blocks;
+  int const n_ghost = 4;
+  Real const gamma  = 5.0 / 3.0;
+  cuda_utilities::DeviceVector<Real> bounds_L, bounds_R, flux;
+
+  explicit Riemann_Setup(int const size)
+      : n(size),
+        n_cells(size * size * size),
+        n_blocks((n_cells + TPB - 1) / TPB),
+        bounds_L(n_cells * n_fields),
+        bounds_R(n_cells * n_fields),
+        flux(n_cells * n_fields, true)
+  {
+    // Different seeds so the left and right states differ
+    bounds_L.cpyHostToDevice(benchmark_utilities::Random_Conserved(n_cells, n_fields, 1));
+    bounds_R.cpyHostToDevice(benchmark_utilities::Random_Conserved(n_cells, n_fields, 2));
+  }
+};
+
+// Each iteration solves the interfaces of all three directions
+
+#ifndef MHD
+/*!
+ * \brief Benchmark a hydro Riemann solver kernel with the signature of
+ * Calculate_HLLC_Fluxes_CUDA
+ */
+template <typename Kernel>
+void Benchmark_Hydro_Solver(benchmark::State &state, Kernel kernel)
+{
+  Riemann_Setup s(state.range(0));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(kernel, s.n_blocks, TPB, 0, 0, s.bounds_L.data(), s.bounds_R.data(), s.flux.data(), s.n, s.n,
+                         s.n, s.n_ghost, s.gamma, dir, s.n_fields);
+    }
+  });
+}
+
+void BM_HLL(benchmark::State &state) { Benchmark_Hydro_Solver(state, Calculate_HLL_Fluxes_CUDA); }
+
+void BM_HLLC(benchmark::State &state)
+{
+  Benchmark_Hydro_Solver(state, Select_Calculate_HLLC_Fluxes_CUDA(grid_enum::num_fields));
+}
+
+void BM_Roe(benchmark::State &state) { Benchmark_Hydro_Solver(state, Calculate_Roe_Fluxes_CUDA); }
+
+void BM_Exact(benchmark::State &state) { Benchmark_Hydro_Solver(state, Calculate_Exact_Fluxes_CUDA); }
+#endif  // not MHD
+
+#ifdef MHD
+/*!
+ * \brief Benchmark an HLLD kernel with the signature of
+ * Calculate_HLLD_Fluxes_CUDA
+ */
+void Benchmark_HLLD_Solver(benchmark::State &state, decltype(&mhd::Calculate_HLLD_Fluxes_CUDA) kernel)
+{
+  Riemann_Setup s(state.range(0));
+  cuda_utilities::DeviceVector<Real> magnetic_face(s.n_cells);
+  magnetic_face.cpyHostToDevice(std::vector<Real>(s.n_cells, 0.5));
+  benchmark_utilities::Time_Kernels(state, s.n_cells, [&] {
+    for (int dir = 0; dir < 3; dir++) {
+      hipLaunchKernelGGL(kernel, s.n_blocks, TPB, 0, 0, s.bounds_L.data(), s.bounds_R.data(), magnetic_face.data(),
+                         s.flux.data(), s.n_cells, s.gamma, dir, s.n_fields);
+    }
+  });
+}
+
+void BM_HLLD(benchmark::State &state) { Benchmark_HLLD_Solver(state, mhd::Calculate_HLLD_Fluxes_CUDA); }
+
+void BM_HLLD_Predicated(benchmark::State &state)
+{
+  Benchmark_HLLD_Solver(state, mhd::Calculate_HLLD_Fluxes_Predicated_CUDA);
+}
+#endif  // MHD
+}  // namespace
+
+#ifndef MHD
+BENCHMARK(BM_HLL)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HLLC)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Roe)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Exact)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+#endif  // not MHD
+#ifdef MHD
+BENCHMARK(BM_HLLD)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HLLD_Predicated)->RangeMultiplier(2)->Range(32, 256)->UseManualTime()->Unit(benchmark::kMillisecond);
+#endif  // MHD
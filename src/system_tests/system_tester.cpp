@@ -335,9 +335,16 @@ void system_test::SystemTestRunner::launchCholla()
 {
   // Launch Cholla. Note that this dumps all console output to the console
   // log file as requested by the user.
+  // The perf_log is appended to, so a new one is started for every launch
+  std::string perfLogParam;
+  if (not ::globalPerformanceMode.getString().empty()) {
+    std::filesystem::remove(_perfLogPath);
+    perfLogParam = " perf_log=" + _perfLogPath;
+  }
   std::string const chollaRunCommand = globalMpiLauncher.getString() + " " + std::to_string(numMpiRanks) + " " +
-                                       _chollaPath + " " + _chollaSettingsPath + " " + chollaLaunchParams + " " +
-                                       "outdir=" + _outputDirectory + "/" + " >> " + _consoleOutputPath + " 2>&1 ";
+                                       _chollaPath + " " + _chollaSettingsPath + " " + chollaLaunchParams +
+                                       perfLogParam + " " + "outdir=" + _outputDirectory + "/" + " >> " +
+                                       _consoleOutputPath + " 2>&1 ";
   auto returnEcho   = system(("echo Launch Command: " + chollaRunCommand + " >> " + _consoleOutputPath).c_str());
   auto returnLaunch = system((chollaRunCommand).c_str());
   EXPECT_EQ(returnEcho, 0) << "Warning: Echoing the launch command to the console output file "
@@ -353,6 +360,10 @@ void system_test::SystemTestRunner::launchCholla()
   } catch (const std::filesystem::filesystem_error &error) {
     // This file might not exist and isn't required so don't worry if it doesn't exist
   }
+
+  if (not ::globalPerformanceMode.getString().empty()) {
+    _checkPerformance();
+  }
 }
 // =============================================================================
 
@@ -435,6 +446,7 @@ system_test::SystemTestRunner::SystemTestRunner(bool const &particleData, bool c
   nameStream << suiteName << "_" << test_info->name();
   std::string fullTestName = nameStream.str();
   _fullTestFileName        = fullTestName.substr(0, fullTestName.find('/'));
+  _fullTestName            = fullTestName;
 
   // Generate the input paths. Strip out everything after a "/" since that
   // probably indicates a parameterized test.
@@ -473,6 +485,12 @@ system_test::SystemTestRunner::SystemTestRunner(bool const &particleData, bool c
   // Generate output paths, these files don't exist yet
   _outputDirectory   = ::globalChollaRoot.getString() + "/bin/" + fullTestName;
   _consoleOutputPath = _outputDirectory + "/" + _fullTestFileName + "_console.log";
+  _perfLogPath       = _outputDirectory + "/" + _fullTestFileName + "_perf_log.csv";
+
+  std::string const performanceMode = ::globalPerformanceMode.getString();
+  if (not performanceMode.empty() and performanceMode != "record" and performanceMode != "compare") {
+    throw std::invalid_argument("Error: --perf-mode must be `record` or `compare`, not `" + performanceMode + "`");
+  }
 
   // Create the new directory and check that it exists
   // TODO: C++17: When we update to C++17 or newer this section should
@@ -533,6 +551,102 @@ void system_test::SystemTestRunner::_checkNumTimeSteps()
 };
 // =============================================================================
 
+// =============================================================================
+void system_test::SystemTestRunner::_checkPerformance()
+{
+  std::ifstream perfLog(_perfLogPath);
+  if (not perfLog) {
+    ADD_FAILURE() << "The performance mode needs the perf_log of a CPU_TIME build, but `" << _perfLogPath
+                  << "` was not written";
+    return;
+  }
+
+  // The columns of the phases are the ones in milliseconds
+  auto const splitCsv = [](std::string const &line) {
+    std::vector<std::string> values;
+    std::stringstream lineStream(line);
+    std::string value;
+    while (std::getline(lineStream, value, ',')) {
+      values.push_back(value);
+    }
+    return values;
+  };
+  std::string line;
+  std::getline(perfLog, line);
+  std::vector<std::string> const header = splitCsv(line);
+  std::vector<std::pair<std::string, double>> phases;
+  std::vector<size_t> phaseColumns;
+  for (size_t column = 0; column < header.size(); column++) {
+    std::string const &name = header[column];
+    if (name.size() > 3 and name.compare(name.size() - 3, 3, "_ms") == 0) {
+      phases.emplace_back(name.substr(0, name.size() - 3), 0.0);
+      phaseColumns.push_back(column);
+    }
+  }
+  bool firstStep = true;
+  while (std::getline(perfLog, line)) {
+    std::vector<std::string> const values = splitCsv(line);
+    if (firstStep or values.size() != header.size()) {
+      firstStep = false;
+      continue;
+    }
+    for (size_t i = 0; i < phases.size(); i++) {
+      phases[i].second += std::stod(values[phaseColumns[i]]);
+    }
+  }
+
+  // The baseline has a line `build test phase milliseconds` per phase, and
+  // comment lines starting with #
+  std::string const baselinePath =
+      ::globalChollaRoot.getString() + "/builds/perf_baseline." + ::globalChollaMachine.getString();
+  std::string const key = ::globalChollaBuild.getString() + " " + _fullTestName;
+  std::vector<std::string> otherLines;
+  std::unordered_map<std::string, double> baseline;
+  std::ifstream baselineFile(baselinePath);
+  while (std::getline(baselineFile, line)) {
+    std::stringstream lineStream(line);
+    std::string build, test, phase;
+    double milliseconds;
+    if (line.empty() or line[0] == '#' or not(lineStream >> build >> test >> phase >> milliseconds) or
+        build + " " + test != key) {
+      otherLines.push_back(line);
+    } else {
+      baseline[phase] = milliseconds;
+    }
+  }
+  baselineFile.close();
+
+  if (::globalPerformanceMode.getString() == "record") {
+    std::ofstream outFile(baselinePath);
+    for (std::string const &otherLine : otherLines) {
+      outFile << otherLine << std::endl;
+    }
+    for (auto const &[phase, milliseconds] : phases) {
+      outFile << key << " " << phase << " " << milliseconds << std::endl;
+    }
+    EXPECT_TRUE(outFile.good()) << "Could not write the performance baseline `" << baselinePath << "`";
+    return;
+  }
+
+  if (baseline.empty()) {
+    ADD_FAILURE() << "The performance baseline `" << baselinePath << "` has no entries for `" << key
+                  << "`, run with `--perf-mode record` first";
+    return;
+  }
+  double const minimumMilliseconds = 1.0;
+  for (auto const &[phase, milliseconds] : phases) {
+    auto const entry = baseline.find(phase);
+    if (entry == baseline.end() or entry->second < minimumMilliseconds) {
+      continue;
+    }
+    double const allowed = entry->second * (1 + ::globalPerformanceThreshold);
+    EXPECT_LE(milliseconds, allowed) << "The " << phase << " phase took " << milliseconds << " ms, "
+                                     << 100 * (milliseconds / entry->second - 1) << "% slower than the baseline of "
+                                     << entry->second << " ms";
+  }
+}
+// =============================================================================
+
 // =============================================================================
 std::vector<double> system_test::SystemTestRunner::loadTestFieldData(std::string dataSetName,
                                                                      std::vector<size_t> &testDims,
@@ -42,6 +42,11 @@ namespace system_test
  * throw an error with the path it searched. All the output files from the
  * test are deposited in `cholla/bin/testSuiteName_testCaseName`
  *
+ * With `--perf-mode record` or `--perf-mode compare` every launch also writes
+ * the perf_log of a CPU_TIME build, and the wall time of each of its phases
+ * summed over the steps is recorded to, or compared with, the baseline of the
+ * machine in `cholla/builds/perf_baseline.MACHINE`
+ *
  * More advanced functionality is provided with a series of member functions
  * that allow you to programmatically generate the fiducial HDF5 file,
  * choose which datasets to compare, whether or not to compare the number of
@@ -84,7 +89,8 @@ class system_test::SystemTestRunner
   void runL1ErrorTest(double const &maxAllowedL1Error, double const &maxAllowedError = 1E-7);
 
   /*!
-   * \brief Launch Cholla as it is set up
+   * \brief Launch Cholla as it is set up. In performance mode the wall times
+   * of the phases are then recorded or compared with the baseline
    *
    */
   void launchCholla();
@@ -279,6 +285,9 @@ class system_test::SystemTestRunner
   /// The full name of the test with an underscore instead of a period. This
   /// is the name of many of the input files, the output directory, etc
   std::string _fullTestFileName;
+  /// The full name of the test including the parameters of a parameterized
+  /// test, the name of its entries in the performance baseline
+  std::string _fullTestName;
   /// The path to the Cholla settings file
   std::string _chollaSettingsPath;
   /// The path to the fiducial data file
@@ -287,6 +296,8 @@ class system_test::SystemTestRunner
   std::string _outputDirectory;
   /// The path and name of the console output file
   std::string _consoleOutputPath;
+  /// The path of the perf_log file in performance mode
+  std::string _perfLogPath;
 
   /// A list of all the data set names in the fiducial data file
   std::vector<std::string> _fiducialDataSetNames;
@@ -339,6 +350,16 @@ class system_test::SystemTestRunner
    */
   void _checkNumTimeSteps();
 
+  /*!
+   * \brief Sum the wall time of each phase of the perf_log over the steps,
+   * skipping the first step like the timers do, then either record the sums
+   * as the baseline of the test or check that no phase is slower than its
+   * baseline by more than globalPerformanceThreshold. Phases with a baseline
+   * under a millisecond are too noisy to compare
+   *
+   */
+  void _checkPerformance();
+
   /*!
    * \brief Load the test data for particles from the HDF5 file(s). If
    * there is more than one HDF5 file then it concatenates the contents into a
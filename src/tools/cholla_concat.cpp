@@ -0,0 +1,550 @@
+/*! \file cholla_concat.cpp
+ *  \brief Concatenate the per rank HDF5 snapshots of Cholla into single files
+ *  with MPI, in the layout of the output_cat single file output. Each rank
+ *  reads its share of the source files and all the ranks write every field
+ *  collectively, so a snapshot of thousands of files is merged in one pass.
+ *  The 3D fields go to the block of the offset attribute of their file, with
+ *  the face centered magnetic fields one cell longer, and the particle fields
+ *  are appended in the order of the ranks. The fields can be converted to
+ *  float32 and compressed on the way.
+ *
+ *  Built with `make concat` into bin/cholla-concat.<machine>, it only needs
+ *  MPI and an HDF5 library with parallel support:
+ *
+ *    mpirun -np 64 bin/cholla-concat.<machine> -s data/ -o cat/ -n 4096 -c 0-10
+ */
+
+#include <getopt.h>
+#include <hdf5.h>
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef H5_HAVE_PARALLEL
+  #error "cholla-concat needs an HDF5 library built with parallel support"
+#endif  // H5_HAVE_PARALLEL
+
+namespace
+{
+int procID, nproc;
+
+// The attributes that only describe the file of one rank
+char const *const local_attributes[] = {"dims_local", "offset", "n_particles_local"};
+
+void Concat_Error(char const *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "cholla-concat rank %d: ", procID);
+  vfprintf(stderr, format, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+struct Options {
+  std::string source_dir;
+  std::string output_dir = ".";
+  std::string suffix;
+  int n_files = 0;
+  std::vector<int> outputs;
+  std::set<std::string> skip_fields;
+  bool float32 = false;
+  int deflate  = 0;
+  int chunk    = 0;
+  // Whether the snapshots are in a directory per output, see FnameTemplate
+  bool separate_cycle_dirs = false;
+};
+
+// The datasets of a snapshot as found in the file of rank 0
+struct DatasetInfo {
+  char name[64];
+  int rank;
+  // The extent of the dataset in the first file and in the single file
+  hsize_t local_dims[3];
+  hsize_t global_dims[3];
+  // The file type, as an HDF5 class and a size in bytes
+  int type_class;
+  int type_size;
+};
+
+void Print_Usage(char const *exe)
+{
+  if (procID == 0) {
+    printf(
+        "Usage: %s -s source_dir -n n_files -c outputs [options]\n"
+        "  -s, --source-dir dir   The directory of the per rank files\n"
+        "  -o, --output-dir dir   The directory of the single files (default .)\n"
+        "  -n, --num-files n      The number of ranks that wrote the snapshots\n"
+        "  -c, --outputs list     The outputs, e.g. 8, 2-9 or 1,4,6-8\n"
+        "  -p, --particles        Concatenate the particle files, <n>_particles.h5.<rank>\n"
+        "      --suffix str       Concatenate the files <n><str>.h5.<rank>\n"
+        "      --skip f1,f2       The fields to leave out\n"
+        "      --float32          Convert the floating point fields to float32\n"
+        "      --deflate level    Compress the fields with shuffle and deflate\n"
+        "      --chunk n          The chunk edge of the 3D fields, by default the\n"
+        "                         blocks of the ranks when compressing\n"
+        "  -h, --help             This message\n",
+        exe);
+  }
+}
+
+std::vector<int> Parse_Outputs(std::string const &list)
+{
+  std::vector<int> outputs;
+  std::stringstream entries(list);
+  std::string entry;
+  while (std::getline(entries, entry, ',')) {
+    size_t const dash = entry.find('-');
+    int const first   = std::atoi(entry.substr(0, dash).c_str());
+    int const last    = (dash == std::string::npos) ? first : std::atoi(entry.substr(dash + 1).c_str());
+    if (first < 0 or last < first) {
+      Concat_Error("invalid outputs \"%s\"", list.c_str());
+    }
+    for (int output = first; output <= last; output++) {
+      outputs.push_back(output);
+    }
+  }
+  return outputs;
+}
+
+Options Parse_Options(int argc, char **argv)
+{
+  enum { suffix_option = 256, skip_option, float32_option, deflate_option, chunk_option };
+  option const long_options[] = {{"source-dir", required_argument, nullptr, 's'},
+                                 {"output-dir", required_argument, nullptr, 'o'},
+                                 {"num-files", required_argument, nullptr, 'n'},
+                                 {"outputs", required_argument, nullptr, 'c'},
+                                 {"particles", no_argument, nullptr, 'p'},
+                                 {"suffix", required_argument, nullptr, suffix_option},
+                                 {"skip", required_argument, nullptr, skip_option},
+                                 {"float32", no_argument, nullptr, float32_option},
+                                 {"deflate", required_argument, nullptr, deflate_option},
+                                 {"chunk", required_argument, nullptr, chunk_option},
+                                 {"help", no_argument, nullptr, 'h'},
+                                 {nullptr, 0, nullptr, 0}};
+
+  Options options;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "s:o:n:c:ph", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case 's':
+        options.source_dir = optarg;
+        break;
+      case 'o':
+        options.output_dir = optarg;
+        break;
+      case 'n':
+        options.n_files = std::atoi(optarg);
+        break;
+      case 'c':
+        options.outputs = Parse_Outputs(optarg);
+        break;
+      case 'p':
+        options.suffix = "_particles";
+        break;
+      case suffix_option:
+        options.suffix = optarg;
+        break;
+      case skip_option: {
+        std::stringstream fields(optarg);
+        std::string field;
+        while (std::getline(fields, field, ',')) {
+          options.skip_fields.insert(field);
+        }
+        break;
+      }
+      case float32_option:
+        options.float32 = true;
+        break;
+      case deflate_option:
+        options.deflate = std::atoi(optarg);
+        break;
+      case chunk_option:
+        options.chunk = std::atoi(optarg);
+        break;
+      case 'h':
+        Print_Usage(argv[0]);
+        MPI_Finalize();
+        exit(0);
+      default:
+        Print_Usage(argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+
+  if (options.source_dir.empty() or options.n_files < 1 or options.outputs.empty()) {
+    Print_Usage(argv[0]);
+    Concat_Error("-s, -n and -c are required");
+  }
+  if (options.deflate < 0 or options.deflate > 9) {
+    Concat_Error("the deflate level has to be between 0 and 9, it is %d", options.deflate);
+  }
+  return options;
+}
+
+// The path of the file of a rank, like FnameTemplate::format_fname
+std::string Source_Path(Options const &options, int nfile, int file)
+{
+  std::string const dir = options.source_dir + "/" + (options.separate_cycle_dirs ? std::to_string(nfile) + "/" : "");
+  return dir + std::to_string(nfile) + options.suffix + ".h5." + std::to_string(file);
+}
+
+hid_t Open_Source(std::string const &path)
+{
+  hid_t const file_id = H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file_id < 0) {
+    Concat_Error("unable to open %s", path.c_str());
+  }
+  return file_id;
+}
+
+void Read_Int_Attribute(hid_t file_id, char const *name, hid_t mem_type, void *value)
+{
+  hid_t const attribute_id = H5Aopen(file_id, name, H5P_DEFAULT);
+  if (attribute_id < 0 or H5Aread(attribute_id, mem_type, value) < 0) {
+    Concat_Error("unable to read the attribute %s", name);
+  }
+  H5Aclose(attribute_id);
+}
+
+// The type of a dataset in the single file, and the native type it is
+// transferred through
+hid_t File_Type(DatasetInfo const &info)
+{
+  if (info.type_class == H5T_FLOAT) {
+    return (info.type_size == 4) ? H5T_IEEE_F32LE : H5T_IEEE_F64LE;
+  }
+  return (info.type_size == 4) ? H5T_STD_I32LE : H5T_STD_I64LE;
+}
+
+hid_t Memory_Type(DatasetInfo const &info)
+{
+  if (info.type_class == H5T_FLOAT) {
+    return (info.type_size == 4) ? H5T_NATIVE_FLOAT : H5T_NATIVE_DOUBLE;
+  }
+  return (info.type_size == 4) ? H5T_NATIVE_INT : H5T_NATIVE_LLONG;
+}
+
+// Copy the attributes of the first file to the single file, without the ones
+// of the rank
+herr_t Copy_Attribute(hid_t source_id, char const *name, H5A_info_t const *, void *data)
+{
+  for (char const *local : local_attributes) {
+    if (strcmp(name, local) == 0) {
+      return 0;
+    }
+  }
+  hid_t const destination_id = *static_cast<hid_t *>(data);
+  hid_t const attribute_id   = H5Aopen(source_id, name, H5P_DEFAULT);
+  hid_t const type_id        = H5Aget_type(attribute_id);
+  hid_t const space_id       = H5Aget_space(attribute_id);
+  std::vector<char> value(H5Aget_storage_size(attribute_id) + H5Tget_size(type_id));
+  H5Aread(attribute_id, type_id, value.data());
+
+  hid_t const copy_id = H5Acreate(destination_id, name, type_id, space_id, H5P_DEFAULT, H5P_DEFAULT);
+  H5Awrite(copy_id, type_id, value.data());
+  H5Aclose(copy_id);
+  H5Sclose(space_id);
+  H5Tclose(type_id);
+  H5Aclose(attribute_id);
+  return 0;
+}
+
+// Find the datasets of the snapshot in the file of rank 0
+std::vector<DatasetInfo> Read_Datasets(Options const &options, hid_t file_id)
+{
+  int global[3] = {1, 1, 1}, local[3] = {1, 1, 1};
+  bool const has_blocks = H5Aexists(file_id, "dims_local") > 0;
+  if (has_blocks) {
+    Read_Int_Attribute(file_id, "dims", H5T_NATIVE_INT, global);
+    Read_Int_Attribute(file_id, "dims_local", H5T_NATIVE_INT, local);
+  }
+
+  H5G_info_t group_info;
+  H5Gget_info(file_id, &group_info);
+  std::vector<DatasetInfo> datasets;
+  for (hsize_t index = 0; index < group_info.nlinks; index++) {
+    DatasetInfo info{};
+    H5Lget_name_by_idx(file_id, ".", H5_INDEX_NAME, H5_ITER_INC, index, info.name, sizeof(info.name), H5P_DEFAULT);
+    if (options.skip_fields.count(info.name) > 0) {
+      continue;
+    }
+    // The groups of the file aren't concatenated
+    hid_t const dataset_id = H5Dopen(file_id, info.name, H5P_DEFAULT);
+    if (dataset_id < 0) {
+      continue;
+    }
+    hid_t const space_id = H5Dget_space(dataset_id);
+    hid_t const type_id  = H5Dget_type(dataset_id);
+    info.rank            = H5Sget_simple_extent_ndims(space_id);
+    H5Sget_simple_extent_dims(space_id, info.local_dims, nullptr);
+    info.type_class = H5Tget_class(type_id);
+    info.type_size  = int(H5Tget_size(type_id));
+    H5Tclose(type_id);
+    H5Sclose(space_id);
+    H5Dclose(dataset_id);
+
+    if (info.type_class != H5T_FLOAT and info.type_class != H5T_INTEGER) {
+      Concat_Error("%s is neither a floating point nor an integer dataset", info.name);
+    }
+    if (options.float32 and info.type_class == H5T_FLOAT) {
+      info.type_size = 4;
+    }
+    if (info.rank == 3) {
+      if (not has_blocks) {
+        Concat_Error("%s is a 3D dataset but the files have no dims_local attribute", info.name);
+      }
+      // The face centered fields have one more cell than the local block
+      for (int d = 0; d < 3; d++) {
+        info.global_dims[d] = global[d] + info.local_dims[d] - local[d];
+      }
+    } else if (info.rank != 1) {
+      Concat_Error("%s has rank %d, only the 3D fields and the particle fields are supported", info.name, info.rank);
+    }
+    datasets.push_back(info);
+  }
+  return datasets;
+}
+
+// Create the single file and its empty datasets on rank 0
+void Create_Output(Options const &options, std::string const &path, hid_t source_id,
+                   std::vector<DatasetInfo> const &datasets, long long n_particles)
+{
+  hid_t const file_id = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  if (file_id < 0) {
+    Concat_Error("unable to create %s", path.c_str());
+  }
+  hid_t destination_id = file_id;
+  H5Aiterate(source_id, H5_INDEX_NAME, H5_ITER_INC, nullptr, Copy_Attribute, &destination_id);
+  if (n_particles >= 0) {
+    // Like the particle files of output_cat
+    hsize_t const one    = 1;
+    hid_t const space_id = H5Screate_simple(1, &one, nullptr);
+    hid_t const attribute_id =
+        H5Acreate(file_id, "n_particles_total", H5T_STD_I64BE, space_id, H5P_DEFAULT, H5P_DEFAULT);
+    H5Awrite(attribute_id, H5T_NATIVE_LLONG, &n_particles);
+    H5Aclose(attribute_id);
+    H5Sclose(space_id);
+  }
+
+  for (DatasetInfo const &info : datasets) {
+    hsize_t dims[3], chunk[3];
+    if (info.rank == 3) {
+      for (int d = 0; d < 3; d++) {
+        dims[d]  = info.global_dims[d];
+        chunk[d] = std::min(hsize_t(options.chunk > 0 ? options.chunk : info.local_dims[d]), dims[d]);
+      }
+    } else {
+      dims[0]  = std::max(n_particles, 1LL);
+      chunk[0] = std::min(hsize_t(1) << 20, dims[0]);
+    }
+    hid_t const space_id = H5Screate_simple(info.rank, dims, nullptr);
+    hid_t const dcpl_id  = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_fill_time(dcpl_id, H5D_FILL_TIME_NEVER);
+    if (options.deflate > 0 or options.chunk > 0) {
+      H5Pset_chunk(dcpl_id, info.rank, chunk);
+    }
+    if (options.deflate > 0) {
+      H5Pset_shuffle(dcpl_id);
+      H5Pset_deflate(dcpl_id, options.deflate);
+    }
+    hid_t const dataset_id =
+        H5Dcreate(file_id, info.name, File_Type(info), space_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+    if (dataset_id < 0) {
+      Concat_Error("unable to create the dataset %s", info.name);
+    }
+    H5Dclose(dataset_id);
+    H5Pclose(dcpl_id);
+    H5Sclose(space_id);
+  }
+  H5Fclose(file_id);
+}
+
+// Concatenate one output, returns the number of bytes read
+double Concat_Output(Options const &options, int nfile)
+{
+  std::string const output_path = options.output_dir + "/" + std::to_string(nfile) + options.suffix + ".h5";
+
+  // Rank 0 finds the datasets, the others receive them
+  std::vector<DatasetInfo> datasets;
+  int n_datasets = 0;
+  hid_t first_id = -1;
+  if (procID == 0) {
+    first_id   = Open_Source(Source_Path(options, nfile, 0));
+    datasets   = Read_Datasets(options, first_id);
+    n_datasets = int(datasets.size());
+  }
+  MPI_Bcast(&n_datasets, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  datasets.resize(n_datasets);
+  MPI_Bcast(datasets.data(), int(n_datasets * sizeof(DatasetInfo)), MPI_BYTE, 0, MPI_COMM_WORLD);
+  bool const has_particles = std::any_of(datasets.begin(), datasets.end(), [](DatasetInfo const &info) {
+    return info.rank == 1;
+  });
+
+  // The files are dealt out to the ranks in turn. The particles of a file
+  // start after the ones of all the files before it
+  std::vector<long long> n_particles(options.n_files, 0), particle_offset(options.n_files + 1, 0);
+  if (has_particles) {
+    for (int file = procID; file < options.n_files; file += nproc) {
+      hid_t const file_id = Open_Source(Source_Path(options, nfile, file));
+      Read_Int_Attribute(file_id, "n_particles_local", H5T_NATIVE_LLONG, &n_particles[file]);
+      H5Fclose(file_id);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, n_particles.data(), options.n_files, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    for (int file = 0; file < options.n_files; file++) {
+      particle_offset[file + 1] = particle_offset[file] + n_particles[file];
+    }
+  }
+
+  if (procID == 0) {
+    Create_Output(options, output_path, first_id, datasets, has_particles ? particle_offset.back() : -1);
+    H5Fclose(first_id);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  hid_t const fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_fapl_mpio(fapl_id, MPI_COMM_WORLD, MPI_INFO_NULL);
+  hid_t const output_id = H5Fopen(output_path.c_str(), H5F_ACC_RDWR, fapl_id);
+  H5Pclose(fapl_id);
+  if (output_id < 0) {
+    Concat_Error("unable to open %s for the collective writes", output_path.c_str());
+  }
+  hid_t const dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+  H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+
+  // Every round each rank copies one file, the writes are collective so the
+  // ranks without a file in the last round write nothing
+  double bytes = 0;
+  std::vector<char> buffer;
+  int const n_rounds = (options.n_files + nproc - 1) / nproc;
+  for (int round = 0; round < n_rounds; round++) {
+    int const file    = round * nproc + procID;
+    bool const active = file < options.n_files;
+    hid_t source_id   = -1;
+    int offset[3] = {0, 0, 0}, local[3] = {0, 0, 0}, global[3] = {0, 0, 0};
+    if (active) {
+      source_id = Open_Source(Source_Path(options, nfile, file));
+      if (H5Aexists(source_id, "offset") > 0) {
+        Read_Int_Attribute(source_id, "offset", H5T_NATIVE_INT, offset);
+        Read_Int_Attribute(source_id, "dims_local", H5T_NATIVE_INT, local);
+        Read_Int_Attribute(source_id, "dims", H5T_NATIVE_INT, global);
+      }
+    }
+
+    for (DatasetInfo const &info : datasets) {
+      hid_t const dataset_id  = H5Dopen(output_id, info.name, H5P_DEFAULT);
+      hid_t const file_space  = H5Dget_space(dataset_id);
+      hid_t const memory_type = Memory_Type(info);
+      hid_t memory_space      = H5S_ALL;
+      hsize_t const zero[3]   = {0, 0, 0};
+      hsize_t start[3], count[3], dims[3];
+
+      if (active) {
+        hid_t const source_dataset = H5Dopen(source_id, info.name, H5P_DEFAULT);
+        if (source_dataset < 0) {
+          Concat_Error("%s has no dataset %s", Source_Path(options, nfile, file).c_str(), info.name);
+        }
+        memory_space = H5Dget_space(source_dataset);
+        H5Sget_simple_extent_dims(memory_space, dims, nullptr);
+        hsize_t n_values = 1;
+        for (int d = 0; d < info.rank; d++) {
+          n_values *= dims[d];
+        }
+        buffer.resize(std::max(n_values * H5Tget_size(memory_type), hsize_t(1)));
+        if (H5Dread(source_dataset, memory_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data()) < 0) {
+          Concat_Error("reading %s of %s failed", info.name, Source_Path(options, nfile, file).c_str());
+        }
+        H5Dclose(source_dataset);
+        bytes += n_values * info.type_size;
+
+        if (info.rank == 3) {
+          // Neighboring ranks share the faces of the face centered fields,
+          // only the last rank writes the upper one
+          for (int d = 0; d < 3; d++) {
+            bool const last = offset[d] + local[d] == global[d];
+            start[d]        = offset[d];
+            count[d]        = last ? dims[d] : std::min(dims[d], hsize_t(local[d]));
+          }
+        } else {
+          start[0] = particle_offset[file];
+          count[0] = n_particles[file];
+        }
+        if (count[0] > 0) {
+          H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, nullptr, count, nullptr);
+          H5Sselect_hyperslab(memory_space, H5S_SELECT_SET, zero, nullptr, count, nullptr);
+        } else {
+          H5Sselect_none(file_space);
+          H5Sselect_none(memory_space);
+        }
+      } else {
+        H5Sselect_none(file_space);
+        memory_space = H5Scopy(file_space);
+        buffer.resize(std::max(buffer.size(), size_t(1)));
+      }
+
+      if (H5Dwrite(dataset_id, memory_type, memory_space, file_space, dxpl_id, buffer.data()) < 0) {
+        Concat_Error("writing %s of %s failed", info.name, output_path.c_str());
+      }
+      H5Sclose(memory_space);
+      H5Sclose(file_space);
+      H5Dclose(dataset_id);
+    }
+
+    if (active) {
+      H5Fclose(source_id);
+    }
+  }
+
+  H5Pclose(dxpl_id);
+  if (H5Fclose(output_id) < 0) {
+    Concat_Error("closing %s failed", output_path.c_str());
+  }
+  return bytes;
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &procID);
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+
+  Options options = Parse_Options(argc, argv);
+
+  // The snapshots are either in a directory per output or all in the source
+  // directory, like the two layouts of FnameTemplate
+  if (procID == 0) {
+    FILE *file = fopen(Source_Path(options, options.outputs[0], 0).c_str(), "r");
+    if (file == nullptr) {
+      options.separate_cycle_dirs = true;
+    } else {
+      fclose(file);
+    }
+  }
+  int separate_cycle_dirs = options.separate_cycle_dirs;
+  MPI_Bcast(&separate_cycle_dirs, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  options.separate_cycle_dirs = separate_cycle_dirs;
+
+  for (int nfile : options.outputs) {
+    double const start = MPI_Wtime();
+    double bytes       = Concat_Output(options, nfile);
+    MPI_Allreduce(MPI_IN_PLACE, &bytes, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    double const time = MPI_Wtime() - start;
+    if (procID == 0) {
+      printf("Output %d: %d files, %.3f GB in %.2f s, %.3f GB/s\n", nfile, options.n_files, bytes * 1e-9, time,
+             bytes * 1e-9 / time);
+    }
+  }
+
+  MPI_Finalize();
+  return 0;
+}
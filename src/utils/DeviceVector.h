@@ -2,8 +2,9 @@
  * \file DeviceVector.h
  * \author Robert 'Bob' Caddy (rvc@pitt.edu)
  * \brief Contains the declartion and implementation of the DeviceVector
- * class. Note that since this is a templated class the implementation must be
- * in the header file
+ * class, and of the PinnedVector class that its asynchronous copies to the
+ * host land in. Note that since these are templated classes the
+ * implementation must be in the header file
  *
  */
 
@@ -21,7 +22,115 @@
 // Local Includes
 #include "../global/global.h"
 #include "../global/global_cuda.h"
+#include "../utils/device_memory_pool.h"
 #include "../utils/gpu.hpp"
+#include "../utils/gpu_streams.h"
+
+// =============================================================================
+// Declaration and definition of PinnedVector class
+// =============================================================================
+namespace cuda_utilities
+{
+/*!
+ * \brief A page-locked host array for the asynchronous copies of a
+ * DeviceVector, with the event that marks the end of the last copy into it.
+ * It works like a future: the copy is queued on a stream and the host only
+ * waits for it when an element is read with the `[]` operator, so the copy
+ * can overlap whatever the host does in between.
+ *
+ * \tparam T The type of the elements, the same as the DeviceVector
+ */
+template <typename T>
+class PinnedVector
+{
+ public:
+  /*!
+   * \brief Construct a new Pinned Vector object, allocating the page-locked
+   * host memory
+   *
+   * \param[in] size The number of elements of the array
+   */
+  explicit PinnedVector(size_t const size = 1) : _size(size)
+  {
+    GPU_Error_Check(cudaHostAlloc((void **)&_ptr, _size * sizeof(T), cudaHostAllocDefault));
+  }
+
+  ~PinnedVector() { cudaFreeHost(_ptr); }
+
+  PinnedVector(const PinnedVector<T> &)                    = delete;
+  PinnedVector<T> &operator=(const PinnedVector<T> &other) = delete;
+
+  /*!
+   * \brief Get the raw host pointer. This does not wait for the pending copy
+   *
+   * \return T* The pointer to the page-locked array
+   */
+  T *data() { return _ptr; }
+
+  /*!
+   * \brief Get the number of elements in the array.
+   *
+   * \return size_t The number of elements in the array
+   */
+  size_t size() { return _size; }
+
+  /*!
+   * \brief Mark the end of a copy into the array that was queued on stream
+   *
+   * \param[in] stream The stream the copy was queued on
+   */
+  void Record(cudaStream_t stream)
+  {
+    _copied.Record(stream);
+    _pending = true;
+  }
+
+  /*!
+   * \brief Check if the last copy into the array is done without blocking
+   *
+   * \return bool True if the values can be read
+   */
+  bool Ready() { return not _pending or _copied.Ready(); }
+
+  /// Block the host until the last copy into the array is done
+  void Synchronize()
+  {
+    if (_pending) {
+      _copied.Synchronize();
+      _pending = false;
+    }
+  }
+
+  /*!
+   * \brief Return a value of the array once the last copy into it is done.
+   * Does not perform bounds checking
+   *
+   * \param[in] index The index of the desired value
+   * \return T The value at host_ptr[index]
+   */
+  T operator[](size_t const &index)
+  {
+    Synchronize();
+    return _ptr[index];
+  }
+
+ private:
+  /// The size of the host array
+  size_t _size;
+
+  /// The pointer to the page-locked host array
+  T *_ptr = nullptr;
+
+  /// The event recorded after the last copy into the array
+  Event _copied;
+
+  /// Whether a copy was recorded that hasn't been waited for
+  bool _pending = false;
+};
+}  // namespace cuda_utilities
+// =============================================================================
+// End declaration and definition of PinnedVector class
+// =============================================================================
 
 // =============================================================================
 // Declaration of DeviceVector class
@@ -119,6 +228,29 @@ class DeviceVector
    */
   void assign(T const &hostValue, size_t const &index = 0);
 
+  /*!
+   * \brief Queue the copy of a value from device memory into the first
+   * element of `hostValue` on `stream` and return without waiting for it.
+   * The value is read with `hostValue[0]`, which waits for the copy. Like the
+   * `at()` method this method performs bounds checking
+   *
+   * \param[in] index The index of the desired value
+   * \param[out] hostValue The pinned array to copy the value into
+   * \param[in] stream The stream to queue the copy on
+   */
+  void atAsync(size_t const index, PinnedVector<T> &hostValue, cudaStream_t stream = 0);
+
+  /*!
+   * \brief Queue the assignment of a single value in the array on `stream`.
+   * The value is staged by the runtime before this returns, so `hostValue`
+   * doesn't have to outlive the call
+   *
+   * \param[in] hostValue The value to write to the device array
+   * \param[in] index The location to write the value to, defaults to zero.
+   * \param[in] stream The stream to queue the copy on
+   */
+  void assignAsync(T const &hostValue, size_t const &index = 0, cudaStream_t stream = 0);
+
   /*!
    * \brief Resize the device container to contain `newSize` elements. If
    * `newSize` is greater than the current size then all the values are
@@ -160,6 +292,19 @@ class DeviceVector
    */
   void cpyHostToDevice(std::vector<T> const &vecIn) { cpyHostToDevice(vecIn.data(), vecIn.size()); }
 
+  /*!
+   * \brief Queue the copy of the first `arrSize` elements of `arrIn` to the
+   * device on `stream`. The copy only overlaps the host when `arrIn` is
+   * page-locked, like the data of a PinnedVector, and `arrIn` must not change
+   * until the copy is done
+   *
+   * \param[in] arrIn The pointer to the array to be copied to the device
+   * \param[in] arrSize The number of elements/size of the array to copy
+   * to the device
+   * \param[in] stream The stream to queue the copy on
+   */
+  void cpyHostToDeviceAsync(const T *arrIn, size_t const &arrSize, cudaStream_t stream);
+
   /*!
    * \brief Copy the array from the device to a host array. Checks if the
    * host array is large enough based on the `arrSize` parameter.
@@ -177,6 +322,16 @@ class DeviceVector
    */
   void cpyDeviceToHost(std::vector<T> &vecOut) { cpyDeviceToHost(vecOut.data(), vecOut.size()); }
 
+  /*!
+   * \brief Queue the copy of the array from the device to a pinned host array
+   * on `stream` and return without waiting for it. Checks if the host array
+   * is large enough
+   *
+   * \param[out] vecOut The pinned array to copy the device array into
+   * \param[in] stream The stream to queue the copy on
+   */
+  void cpyDeviceToHostAsync(PinnedVector<T> &vecOut, cudaStream_t stream);
+
  private:
   /// The size of the device array
   size_t _size;
@@ -192,14 +347,14 @@ class DeviceVector
   void _allocate(size_t const size)
   {
     _size = size;
-    GPU_Error_Check(cudaMalloc(&_ptr, _size * sizeof(T)));
+    Pool_Malloc(&_ptr, _size * sizeof(T));
   }
 
   /*!
    * \brief Free the device side array
    *
    */
-  void _deAllocate() { GPU_Error_Check(cudaFree(_ptr)); }
+  void _deAllocate() { Pool_Free(_ptr); }
 };
 }  // namespace cuda_utilities
 // =============================================================================
@@ -244,7 +399,7 @@ void DeviceVector<T>::resize(size_t const newSize)
   GPU_Error_Check(cudaMemcpyPeer(_ptr, 0, oldDevPtr, 0, count));
 
   // Free the old array
-  GPU_Error_Check(cudaFree(oldDevPtr));
+  Pool_Free(oldDevPtr);
 }
 // =========================================================================
 
@@ -295,6 +450,33 @@ void DeviceVector<T>::assign(T const &hostValue, size_t const &index)
 }
 // =========================================================================
 
+// =========================================================================
+template <typename T>
+void DeviceVector<T>::atAsync(size_t const index, PinnedVector<T> &hostValue, cudaStream_t stream)
+{
+  if (index < _size) {
+    GPU_Error_Check(cudaMemcpyAsync(hostValue.data(), &(_ptr[index]), sizeof(T), cudaMemcpyDeviceToHost, stream));
+    hostValue.Record(stream);
+  } else {
+    throw std::out_of_range(
+        "Warning: DeviceVector.atAsync() detected an"
+        " out of bounds memory access. Tried to"
+        " access element " +
+        std::to_string(index) + " of " + std::to_string(_size));
+  }
+}
+// =========================================================================
+
+// =========================================================================
+template <typename T>
+void DeviceVector<T>::assignAsync(T const &hostValue, size_t const &index, cudaStream_t stream)
+{
+  GPU_Error_Check(cudaMemcpyAsync(&(_ptr[index]),  // destination
+                                  &hostValue,      // source
+                                  sizeof(T), cudaMemcpyHostToDevice, stream));
+}
+// =========================================================================
+
 // =========================================================================
 template <typename T>
 void DeviceVector<T>::cpyHostToDevice(const T *arrIn, size_t const &arrSize)
@@ -326,6 +508,39 @@ void DeviceVector<T>::cpyDeviceToHost(T *arrOut, size_t const &arrSize)
   }
 }
 // =========================================================================
+
+// =========================================================================
+template <typename T>
+void DeviceVector<T>::cpyHostToDeviceAsync(const T *arrIn, size_t const &arrSize, cudaStream_t stream)
+{
+  if (arrSize <= _size) {
+    GPU_Error_Check(cudaMemcpyAsync(_ptr, arrIn, arrSize * sizeof(T), cudaMemcpyHostToDevice, stream));
+  } else {
+    throw std::out_of_range(
+        "Warning: Couldn't copy array to device,"
+        " device array is too small. Host array"
+        " size=" +
+        std::to_string(arrSize) + ", device array size=" + std::to_string(_size));
+  }
+}
+// =========================================================================
+
+// =========================================================================
+template <typename T>
+void DeviceVector<T>::cpyDeviceToHostAsync(PinnedVector<T> &vecOut, cudaStream_t stream)
+{
+  if (_size <= vecOut.size()) {
+    GPU_Error_Check(cudaMemcpyAsync(vecOut.data(), _ptr, _size * sizeof(T), cudaMemcpyDeviceToHost, stream));
+    vecOut.Record(stream);
+  } else {
+    throw std::out_of_range(
+        "Warning: Couldn't copy array to host, "
+        "host array is too small. Host array "
+        "size=" +
+        std::to_string(vecOut.size()) + ", device array size=" + std::to_string(_size));
+  }
+}
+// =========================================================================
 }  // end namespace cuda_utilities
    // =============================================================================
    // End definition of DeviceVector class
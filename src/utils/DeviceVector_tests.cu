@@ -209,6 +209,29 @@ TEST(tALLDeviceVectorArrayDeviceToHostCopy, CheckHostMemoryValuesExpectCorrectMe
   }
 }
 
+TEST(tALLDeviceVectorAsyncCopies, CheckHostMemoryValuesExpectCorrectMemoryValues)
+{
+  // Initialize the vectors
+  size_t const vectorSize = 10;
+  cuda_utilities::DeviceVector<double> devVector{vectorSize};
+  cuda_utilities::PinnedVector<double> pinnedIn(vectorSize), pinnedOut(vectorSize), pinnedValue;
+  std::iota(pinnedIn.data(), pinnedIn.data() + vectorSize, 0);
+  cuda_utilities::Stream stream;
+
+  // Queue the copies to the device and back on the same stream
+  devVector.cpyHostToDeviceAsync(pinnedIn.data(), vectorSize, stream);
+  devVector.assignAsync(17, 4, stream);
+  devVector.cpyDeviceToHostAsync(pinnedOut, stream);
+  devVector.atAsync(4, pinnedValue, stream);
+
+  // Check the values, the [] operator waits for the copies
+  for (size_t i = 0; i < vectorSize; i++) {
+    EXPECT_EQ((i == 4) ? 17 : pinnedIn.data()[i], pinnedOut[i]);
+  }
+  EXPECT_EQ(17, pinnedValue[0]);
+  EXPECT_TRUE(pinnedValue.Ready());
+}
+
 TEST(tALLDeviceVectorReset, SetNewSizeExpectCorrectSize)
 {
   // Initialize the vectors
@@ -339,3 +362,15 @@ TEST(tALLDeviceVectorStdVectorDeviceToHostCopy, OutOfBoundsCopyExpectThrowOutOfR
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto,hicpp-avoid-goto)
   EXPECT_THROW(devVector.cpyDeviceToHost(stdVec), std::out_of_range);
 }
+
+TEST(tALLDeviceVectorAtAsync, OutOfBoundsAccessExpectThrowOutOfRange)
+{
+  // Initialize the vectors
+  size_t const vectorSize = 10;
+  cuda_utilities::DeviceVector<double> devVector{vectorSize};
+  cuda_utilities::PinnedVector<double> pinnedValue;
+
+  // Check that the .atAsync() method throws the correct exception
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto,hicpp-avoid-goto)
+  EXPECT_THROW(devVector.atAsync(100, pinnedValue), std::out_of_range);
+}
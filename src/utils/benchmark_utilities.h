@@ -0,0 +1,97 @@
+/*!
+ * \file benchmark_utilities.h
+ * \brief Contains the helpers shared by the Google Benchmark kernel
+ * benchmarks (the *_bench.cu files), which are built with `make bench`. Since
+ * the helpers are templated the implementation is in the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+// Local Includes
+#include "../global/global.h"
+#include "../grid/grid_enum.h"
+#include "../utils/gpu.hpp"
+#include "../utils/gpu_streams.h"
+
+namespace benchmark_utilities
+{
+/*!
+ * \brief Record the precision and the macro flags of the build in the context
+ * of the JSON output, so results from different builds (e.g. with and without
+ * MIXED_PRECISION) can be told apart
+ */
+inline bool const context_added = [] {
+  benchmark::AddCustomContext("sizeof(Real)", std::to_string(sizeof(Real)));
+  benchmark::AddCustomContext("sizeof(Real_Solver)", std::to_string(sizeof(Real_Solver)));
+  benchmark::AddCustomContext("git_hash", GIT_HASH);
+  benchmark::AddCustomContext("macro_flags", MACRO_FLAGS);
+  return true;
+}();
+
+/*!
+ * \brief Generate a random grid of conserved variables with a positive
+ * density and a large enough energy that the pressure is positive
+ *
+ * \param[in] n_cells The number of cells
+ * \param[in] n_fields The number of fields
+ * \param[in] seed (optional) The seed of the random number generator
+ * \return std::vector<Real> The grid, field-major
+ */
+inline std::vector<Real> Random_Conserved(size_t const n_cells, int const n_fields, uint64_t const seed = 42)
+{
+  std::mt19937_64 prng(seed);
+  std::uniform_real_distribution<double> doubleRand(0.5, 1.5);
+
+  std::vector<Real> grid(n_cells * n_fields);
+  for (Real &val : grid) {
+    val = doubleRand(prng);
+  }
+  for (size_t i = 0; i < n_cells; i++) {
+    grid[grid_enum::Energy * n_cells + i] += 10.0;
+  }
+  return grid;
+}
+
+/*!
+ * \brief Time a sequence of kernel launches with GPU events. The launches are
+ * run once to warm up and then once per benchmark iteration, and the event
+ * time is reported as the manual time of the iteration. The benchmark must be
+ * registered with UseManualTime(). Sets the items processed to the number of
+ * cells so the output contains the cells per second.
+ *
+ * \tparam Launch A callable that launches the kernels on stream 0
+ * \param[in] state The benchmark state
+ * \param[in] n_cells The number of cells processed by one call of launch
+ * \param[in] launch Launches the kernels to time
+ */
+template <typename Launch>
+void Time_Kernels(benchmark::State &state, size_t const n_cells, Launch launch)
+{
+  cuda_utilities::Event start(true), stop(true);
+
+  launch();
+  GPU_Error_Check();
+  GPU_Error_Check(cudaDeviceSynchronize());
+
+  for (auto _ : state) {
+    start.Record(0);
+    launch();
+    stop.Record(0);
+    stop.Synchronize();
+    state.SetIterationTime(stop.ElapsedTime(start) / 1000.0);
+  }
+  GPU_Error_Check();
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n_cells);
+}
+}  // namespace benchmark_utilities
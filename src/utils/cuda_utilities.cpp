@@ -34,4 +34,23 @@ void Print_GPU_Memory_Usage(std::string const &additional_text)
 
   chprintf(output_message.c_str());
 }
+
+void Print_Kernel_Resource_Usage(std::string const &name, void const *kernel, int threads_per_block)
+{
+  cudaFuncAttributes attributes;
+  GPU_Error_Check(cudaFuncGetAttributes(&attributes, kernel));
+
+  int device, blocks_per_sm;
+  cudaDeviceProp properties;
+  GPU_Error_Check(cudaGetDevice(&device));
+  GPU_Error_Check(cudaGetDeviceProperties(&properties, device));
+  GPU_Error_Check(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocks_per_sm, kernel, threads_per_block, 0));
+
+  Real const occupancy =
+      100.0 * static_cast<Real>(blocks_per_sm * threads_per_block) / properties.maxThreadsPerMultiProcessor;
+
+  chprintf(" %s: %d registers, %zu B local, %zu B shared, %d blocks of %d threads per SM (%.0f%% occupancy)\n",
+           name.c_str(), attributes.numRegs, attributes.localSizeBytes, attributes.sharedSizeBytes, blocks_per_sm,
+           threads_per_block, occupancy);
+}
 }  // end namespace cuda_utilities
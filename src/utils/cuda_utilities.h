@@ -134,4 +134,23 @@ struct AutomaticLaunchParams {
  */
 void Print_GPU_Memory_Usage(std::string const &additional_text = "");
 // =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Print the register, local memory and static shared memory use of a
+ * kernel and its theoretical occupancy at a given block size to standard out
+ *
+ * \param[in] name The name to print for the kernel
+ * \param[in] kernel The kernel
+ * \param[in] threads_per_block The block size to compute the occupancy for
+ */
+void Print_Kernel_Resource_Usage(std::string const &name, void const *kernel, int threads_per_block = TPB);
+
+/// \overload
+template <typename T>
+void Print_Kernel_Resource_Usage(std::string const &name, T *kernel, int threads_per_block = TPB)
+{
+  Print_Kernel_Resource_Usage(name, reinterpret_cast<void const *>(kernel), threads_per_block);
+}
+// =====================================================================
 }  // end namespace cuda_utilities
\ No newline at end of file
@@ -0,0 +1,285 @@
+/*!
+ * \file device_memory_pool.cpp
+ * \brief Implementation file for device_memory_pool.h
+ *
+ */
+#include "../utils/device_memory_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "../global/global.h"
+#include "../io/io.h"
+#include "../mpi/mpi_routines.h"
+
+// hipMallocAsync is supported from ROCm 5.3, cudaMallocAsync from CUDA 11.2.
+// GPU-aware MPI can't count on the memory of the default pool being mappable
+// by the other ranks of the node, and the particle and P3M arrays go straight
+// to MPI with MPI_GPU, so then the pool only counts cudaMalloc allocations
+#if !defined(MPI_GPU) && ((defined(O_HIP) && defined(HIP_VERSION) && HIP_VERSION >= 50300000) || \
+                          (!defined(O_HIP) && defined(CUDART_VERSION) && CUDART_VERSION >= 11020))
+  #define STREAM_ORDERED_POOL
+#endif
+
+namespace
+{
+int constexpr n_tags = static_cast<int>(cuda_utilities::MemoryTag::n_tags);
+
+// The size of a live allocation of the pool, the tag it is accounted to and
+// whether it is managed memory
+struct PoolAllocation {
+  size_t bytes;
+  int tag;
+  bool managed;
+};
+
+struct PoolUsage {
+  std::mutex mutex;
+  std::unordered_map<void *, PoolAllocation> sizes;
+  size_t current_bytes = 0;
+  size_t high_water    = 0;
+  size_t n_allocations = 0;
+  size_t managed_bytes = 0;
+  // The current and high-water usage of every tag
+  size_t tag_bytes[n_tags]      = {};
+  size_t tag_high_water[n_tags] = {};
+  // -1 until the device is checked for stream ordered allocation
+  int stream_ordered = -1;
+};
+
+// The tag of the innermost MemoryTagScope of the thread
+thread_local cuda_utilities::MemoryTag current_tag = cuda_utilities::MemoryTag::other;
+
+const char *const tag_names[n_tags] = {"hydro",      "integrator", "gravity",  "particles",
+                                       "boundaries", "io",         "analysis", "other"};
+
+// Never destroyed, so that the static DeviceVectors freed at exit still find it
+PoolUsage &Usage()
+{
+  static PoolUsage *const usage = new PoolUsage;
+  return *usage;
+}
+
+// Whether the allocations go through cudaMallocAsync, checked on the first
+// allocation. Called with the mutex held
+bool Stream_Ordered(PoolUsage &usage)
+{
+#ifdef STREAM_ORDERED_POOL
+  if (usage.stream_ordered < 0) {
+    int device, supported = 0;
+    GPU_Error_Check(cudaGetDevice(&device));
+    GPU_Error_Check(cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, device));
+    if (supported != 0) {
+      // By default the pool releases the freed memory to the driver at every
+      // synchronization, keep it instead so it is reused
+      cudaMemPool_t pool;
+      uint64_t threshold = UINT64_MAX;
+      GPU_Error_Check(cudaDeviceGetDefaultMemPool(&pool, device));
+      GPU_Error_Check(cudaMemPoolSetAttribute(pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    }
+    usage.stream_ordered = (supported != 0) ? 1 : 0;
+  }
+  return usage.stream_ordered == 1;
+#else   // not STREAM_ORDERED_POOL
+  return false;
+#endif  // STREAM_ORDERED_POOL
+}
+
+#ifdef MANAGED_MEMORY
+// Managed memory that prefers to live on the current device, so it is only
+// moved to the host when the device runs out
+void *Managed_Malloc(size_t bytes)
+{
+  void *ptr = nullptr;
+  int device;
+  GPU_Error_Check(cudaGetDevice(&device));
+  GPU_Error_Check(cudaMallocManaged(&ptr, bytes, cudaMemAttachGlobal));
+  GPU_Error_Check(cudaMemAdvise(ptr, bytes, cudaMemAdviseSetPreferredLocation, device));
+  return ptr;
+}
+#endif  // MANAGED_MEMORY
+
+// Account a new allocation. Called with the mutex held
+void Count_Allocation(PoolUsage &usage, void *ptr, size_t bytes, bool managed)
+{
+  int const tag    = static_cast<int>(current_tag);
+  usage.sizes[ptr] = PoolAllocation{bytes, tag, managed};
+  usage.n_allocations++;
+  usage.current_bytes += bytes;
+  usage.high_water = std::max(usage.high_water, usage.current_bytes);
+  usage.tag_bytes[tag] += bytes;
+  usage.tag_high_water[tag] = std::max(usage.tag_high_water[tag], usage.tag_bytes[tag]);
+  if (managed) {
+    usage.managed_bytes += bytes;
+  }
+}
+}  // namespace
+
+namespace cuda_utilities
+{
+MemoryTagScope::MemoryTagScope(MemoryTag tag) : previous_(current_tag) { current_tag = tag; }
+
+MemoryTagScope::~MemoryTagScope() { current_tag = previous_; }
+
+void *Pool_Malloc_Bytes(size_t bytes, cudaStream_t stream)
+{
+  if (bytes == 0) {
+    return nullptr;
+  }
+
+  PoolUsage &usage = Usage();
+  std::lock_guard<std::mutex> lock(usage.mutex);
+#ifdef MANAGED_MEMORY
+  // The I/O buffers are only touched at the outputs, let them move out of
+  // the way of the integrator when the device is oversubscribed
+  if (current_tag == MemoryTag::io) {
+    void *const ptr = Managed_Malloc(bytes);
+    Count_Allocation(usage, ptr, bytes, true);
+    return ptr;
+  }
+#endif  // MANAGED_MEMORY
+  void *ptr = nullptr;
+#ifdef STREAM_ORDERED_POOL
+  if (Stream_Ordered(usage)) {
+    GPU_Error_Check(cudaMallocAsync(&ptr, bytes, stream));
+    // The callers of the default stream expect the memory to be ready on
+    // every stream, most of the allocations are served from the pool anyway
+    if (stream == 0) {
+      GPU_Error_Check(cudaStreamSynchronize(stream));
+    }
+  } else {
+    GPU_Error_Check(cudaMalloc(&ptr, bytes));
+  }
+#else   // not STREAM_ORDERED_POOL
+  GPU_Error_Check(cudaMalloc(&ptr, bytes));
+#endif  // STREAM_ORDERED_POOL
+
+  Count_Allocation(usage, ptr, bytes, false);
+  return ptr;
+}
+
+void *Pool_Malloc_Managed_Bytes(size_t bytes, cudaStream_t stream)
+{
+#ifdef MANAGED_MEMORY
+  if (bytes == 0) {
+    return nullptr;
+  }
+
+  PoolUsage &usage = Usage();
+  std::lock_guard<std::mutex> lock(usage.mutex);
+  void *const ptr = Managed_Malloc(bytes);
+  Count_Allocation(usage, ptr, bytes, true);
+  return ptr;
+#else   // not MANAGED_MEMORY
+  return Pool_Malloc_Bytes(bytes, stream);
+#endif  // MANAGED_MEMORY
+}
+
+void Pool_Prefetch(void const *ptr, cudaStream_t stream)
+{
+#ifdef MANAGED_MEMORY
+  if (ptr == nullptr) {
+    return;
+  }
+
+  size_t bytes;
+  {
+    PoolUsage &usage = Usage();
+    std::lock_guard<std::mutex> lock(usage.mutex);
+    auto const allocation = usage.sizes.find(const_cast<void *>(ptr));
+    if (allocation == usage.sizes.end() || !allocation->second.managed) {
+      return;
+    }
+    bytes = allocation->second.bytes;
+  }
+  int device;
+  GPU_Error_Check(cudaGetDevice(&device));
+  GPU_Error_Check(cudaMemPrefetchAsync(ptr, bytes, device, stream));
+#endif  // MANAGED_MEMORY
+}
+
+void Pool_Free(void *ptr, cudaStream_t stream)
+{
+  if (ptr == nullptr) {
+    return;
+  }
+
+  PoolUsage &usage = Usage();
+  std::lock_guard<std::mutex> lock(usage.mutex);
+  auto const allocation = usage.sizes.find(ptr);
+  if (allocation == usage.sizes.end()) {
+    GPU_Error_Check(cudaFree(ptr));
+    return;
+  }
+  bool const managed = allocation->second.managed;
+  usage.current_bytes -= allocation->second.bytes;
+  usage.tag_bytes[allocation->second.tag] -= allocation->second.bytes;
+  if (managed) {
+    usage.managed_bytes -= allocation->second.bytes;
+  }
+  usage.sizes.erase(allocation);
+
+  // Managed memory never comes from the stream ordered pool
+  if (managed) {
+    GPU_Error_Check(cudaFree(ptr));
+    return;
+  }
+
+#ifdef STREAM_ORDERED_POOL
+  if (Stream_Ordered(usage)) {
+    GPU_Error_Check(cudaFreeAsync(ptr, stream));
+    return;
+  }
+#endif  // STREAM_ORDERED_POOL
+  GPU_Error_Check(cudaFree(ptr));
+}
+
+size_t Pool_High_Water()
+{
+  PoolUsage &usage = Usage();
+  std::lock_guard<std::mutex> lock(usage.mutex);
+  return usage.high_water;
+}
+
+void Print_Pool_Usage()
+{
+  PoolUsage &usage = Usage();
+  size_t current_bytes, high_water, n_allocations, managed_bytes;
+  size_t tag_bytes[n_tags], tag_high_water[n_tags];
+  bool stream_ordered;
+  {
+    std::lock_guard<std::mutex> lock(usage.mutex);
+    current_bytes  = usage.current_bytes;
+    high_water     = usage.high_water;
+    n_allocations  = usage.n_allocations;
+    managed_bytes  = usage.managed_bytes;
+    stream_ordered = usage.stream_ordered == 1;
+    std::copy(usage.tag_bytes, usage.tag_bytes + n_tags, tag_bytes);
+    std::copy(usage.tag_high_water, usage.tag_high_water + n_tags, tag_high_water);
+  }
+#ifdef MPI_CHOLLA
+  current_bytes = Reduce_size_t_Max(current_bytes);
+  high_water    = Reduce_size_t_Max(high_water);
+  n_allocations = Reduce_size_t_Max(n_allocations);
+  managed_bytes = Reduce_size_t_Max(managed_bytes);
+  for (int tag = 0; tag < n_tags; tag++) {
+    tag_bytes[tag]      = Reduce_size_t_Max(tag_bytes[tag]);
+    tag_high_water[tag] = Reduce_size_t_Max(tag_high_water[tag]);
+  }
+#endif  // MPI_CHOLLA
+
+  chprintf("Device memory pool (%s): %.2f MB in use, high-water mark %.2f MB, %zu allocations (max over ranks)\n",
+           stream_ordered ? "stream ordered" : "cudaMalloc", current_bytes / 1.0e6, high_water / 1.0e6, n_allocations);
+  if (managed_bytes > 0) {
+    chprintf("  %.2f MB of it is managed memory that can move to the host\n", managed_bytes / 1.0e6);
+  }
+  for (int tag = 0; tag < n_tags; tag++) {
+    if (tag_high_water[tag] > 0) {
+      chprintf("  %-10s %10.2f MB in use, high-water mark %10.2f MB\n", tag_names[tag], tag_bytes[tag] / 1.0e6,
+               tag_high_water[tag] / 1.0e6);
+    }
+  }
+}
+}  // namespace cuda_utilities
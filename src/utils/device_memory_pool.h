@@ -0,0 +1,139 @@
+/*!
+ * \file device_memory_pool.h
+ * \brief Declarations of the pool that the device allocations go through. The
+ * allocations are stream ordered with cudaMallocAsync/hipMallocAsync where the
+ * runtime and the device support it, and the pool keeps the memory it is given
+ * back so that arrays that are freed and allocated again, like growing particle
+ * buffers, are served without going back to the driver. Every allocation is
+ * counted for the usage report, under the subsystem of the MemoryTagScope it
+ * is made in. With MANAGED_MEMORY the I/O allocations and the integrator
+ * scratch arrays are managed memory, so problems somewhat larger than the
+ * device still run.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "../utils/gpu.hpp"
+
+namespace cuda_utilities
+{
+/*!
+ * \brief The subsystems the device memory of the pool is accounted to
+ */
+enum class MemoryTag { hydro, integrator, gravity, particles, boundaries, io, analysis, other, n_tags };
+
+/*!
+ * \brief Account the pool allocations made on this thread during the lifetime
+ * of the scope to tag. The scopes nest and the innermost one wins, the
+ * allocations outside of every scope go to MemoryTag::other. The memory stays
+ * accounted to its tag until it is freed.
+ */
+class MemoryTagScope
+{
+ public:
+  explicit MemoryTagScope(MemoryTag tag);
+  ~MemoryTagScope();
+  MemoryTagScope(MemoryTagScope const &)            = delete;
+  MemoryTagScope &operator=(MemoryTagScope const &) = delete;
+
+ private:
+  MemoryTag previous_;
+};
+
+/*!
+ * \brief Allocate bytes of device memory from the pool. Memory allocated on the
+ * default stream can be used anywhere once this returns, like the memory of
+ * cudaMalloc. Memory allocated on another stream can be used in the order of
+ * that stream right away, and on the other streams once they are synchronized
+ * with it. An allocation of zero bytes returns nullptr.
+ *
+ * \param[in] bytes The number of bytes to allocate
+ * \param[in] stream The stream the allocation is ordered on
+ * \return void* The device memory
+ */
+void *Pool_Malloc_Bytes(size_t bytes, cudaStream_t stream = 0);
+
+/*!
+ * \brief Allocate bytes of device memory from the pool into *ptr, the pool
+ * version of cudaMalloc
+ *
+ * \tparam T The type of the array
+ * \param[out] ptr The pointer to set to the device memory
+ * \param[in] bytes The number of bytes to allocate
+ * \param[in] stream The stream the allocation is ordered on
+ */
+template <typename T>
+void Pool_Malloc(T **ptr, size_t bytes, cudaStream_t stream = 0)
+{
+  *ptr = static_cast<T *>(Pool_Malloc_Bytes(bytes, stream));
+}
+
+/*!
+ * \brief Allocate bytes of managed memory that prefers to live on the device.
+ * When the device is oversubscribed the driver moves its pages to the host and
+ * back, so it suits large arrays that are only used in a part of the step.
+ * Counted and freed like the other pool memory. Without MANAGED_MEMORY this is
+ * Pool_Malloc_Bytes
+ *
+ * \param[in] bytes The number of bytes to allocate
+ * \param[in] stream The stream the allocation is ordered on without
+ * MANAGED_MEMORY
+ * \return void* The managed memory
+ */
+void *Pool_Malloc_Managed_Bytes(size_t bytes, cudaStream_t stream = 0);
+
+/*!
+ * \brief Allocate bytes of managed memory into *ptr, see
+ * Pool_Malloc_Managed_Bytes
+ *
+ * \tparam T The type of the array
+ * \param[out] ptr The pointer to set to the memory
+ * \param[in] bytes The number of bytes to allocate
+ * \param[in] stream The stream the allocation is ordered on without
+ * MANAGED_MEMORY
+ */
+template <typename T>
+void Pool_Malloc_Managed(T **ptr, size_t bytes, cudaStream_t stream = 0)
+{
+  *ptr = static_cast<T *>(Pool_Malloc_Managed_Bytes(bytes, stream));
+}
+
+/*!
+ * \brief Queue the migration of a managed allocation of the pool to the device
+ * on stream, ahead of the kernels that use it, so its pages move in bulk
+ * instead of on faults. Does nothing for the other memory
+ *
+ * \param[in] ptr The start of the allocation
+ * \param[in] stream The stream of the kernels that use it
+ */
+void Pool_Prefetch(void const *ptr, cudaStream_t stream = 0);
+
+/*!
+ * \brief Give device memory back to the pool once the work queued on stream
+ * before it is done. Memory that didn't come from the pool is freed with
+ * cudaFree, and nullptr is ignored.
+ *
+ * \param[in] ptr The device memory to free
+ * \param[in] stream The stream the free is ordered on
+ */
+void Pool_Free(void *ptr, cudaStream_t stream = 0);
+
+/*!
+ * \brief Print the largest current and high-water usage of the pool over the
+ * ranks, in total and for each MemoryTag, and the number of allocations made
+ * through it. The usage is tracked locally at allocation time, so this is the
+ * only collective and is meant for the outputs and the end of the run
+ *
+ */
+void Print_Pool_Usage();
+
+/*!
+ * \brief The high-water usage of the pool on this rank in bytes. Doesn't
+ * communicate, so it can be read every step
+ *
+ */
+size_t Pool_High_Water();
+}  // namespace cuda_utilities
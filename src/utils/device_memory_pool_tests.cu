@@ -0,0 +1,50 @@
+/*!
+ * \file device_memory_pool_tests.cu
+ * \brief Tests for the contents of device_memory_pool.h
+ *
+ */
+
+// STL Includes
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/device_memory_pool.h"
+#include "../utils/gpu.hpp"
+
+TEST(tALLDeviceMemoryPool, EmptyAllocationExpectNullptr)
+{
+  int *array = reinterpret_cast<int *>(1);
+  cuda_utilities::Pool_Malloc(&array, 0);
+  EXPECT_EQ(nullptr, array);
+  cuda_utilities::Pool_Free(array);
+}
+
+TEST(tALLDeviceMemoryPool, StreamOrderedArraysExpectCorrectValues)
+{
+  size_t const n_values = 1000;
+  cudaStream_t stream;
+  GPU_Error_Check(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+
+  // Free the first array before the second one is allocated so the pool can
+  // hand the same memory out again
+  std::vector<int> const fiducial = {0, 0x01010101};
+  for (int const value : fiducial) {
+    int *array = nullptr;
+    cuda_utilities::Pool_Malloc(&array, n_values * sizeof(int), stream);
+    ASSERT_NE(nullptr, array);
+    GPU_Error_Check(cudaMemsetAsync(array, value & 0xff, n_values * sizeof(int), stream));
+
+    std::vector<int> host(n_values, -1);
+    GPU_Error_Check(cudaMemcpyAsync(host.data(), array, n_values * sizeof(int), cudaMemcpyDeviceToHost, stream));
+    cuda_utilities::Pool_Free(array, stream);
+    GPU_Error_Check(cudaStreamSynchronize(stream));
+    for (size_t i = 0; i < n_values; i++) {
+      EXPECT_EQ(value, host[i]) << "value " << i;
+    }
+  }
+  GPU_Error_Check(cudaStreamDestroy(stream));
+}
@@ -6,10 +6,13 @@
 #include <iostream>
 #include <string>
 
+#include "../utils/flight_recorder.h"
+
 #ifdef MPI_CHOLLA
   #include "../mpi/mpi_routines.h"
 [[noreturn]] void chexit(int code)
 {
+  flight_recorder::Dump("chexit");
   if (code == 0) {
     /*exit normally*/
     MPI_Finalize();
@@ -24,6 +27,7 @@
 #else  /*MPI_CHOLLA*/
 [[noreturn]] void chexit(int code)
 {
+  flight_recorder::Dump("chexit");
   /*exit using code*/
   exit(code);
 }
@@ -68,6 +72,10 @@ void Check_Configuration(Parameters const& P)
   Check_Boundary(P.zl_bcnd, "zl_bcnd");
   Check_Boundary(P.zu_bcnd, "zu_bcnd");
 
+  // The single file outputs are shared by all the ranks, so they can't be on
+  // a node-local checkpoint tier
+  CHOLLA_ASSERT(P.checkpoint_dir[0] == '\0' or not P.output_cat, "checkpoint_dir can't be combined with output_cat");
+
   // warn if error checking is disabled
 #ifndef DISABLE_GPU_ERROR_CHECKING
   // NOLINTNEXTLINE(clang-diagnostic-#warnings)
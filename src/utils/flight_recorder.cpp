@@ -0,0 +1,118 @@
+/*!
+ * \file flight_recorder.cpp
+ * \brief Contains the definitions of the flight recorder of the last steps
+ *
+ */
+
+#include "../utils/flight_recorder.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../io/io.h"
+
+namespace
+{
+// Everything the signal handlers read is set up once by Initialize and never
+// reallocated, so they only read plain memory
+std::vector<char> ring;
+std::vector<char> header_line;
+std::string file_name;
+long long n_slots = 0;
+// The number of records ever made, the next one goes to slot n_records % n_slots
+std::atomic<long long> n_records{0};
+
+struct sigaction previous_sigterm;
+
+void Write_String(int const file, char const *text)
+{
+  size_t left = strlen(text);
+  while (left > 0) {
+    ssize_t const written = write(file, text, left);
+    if (written <= 0) {
+      return;
+    }
+    text += written;
+    left -= written;
+  }
+}
+
+extern "C" void Handle_Signal(int const signal_number)
+{
+  if (signal_number == SIGUSR1) {
+    flight_recorder::Dump("SIGUSR1");
+    return;
+  }
+  // Hand SIGTERM back to the handler that was there before, by default the
+  // one that ends the process
+  flight_recorder::Dump("SIGTERM");
+  sigaction(SIGTERM, &previous_sigterm, nullptr);
+  raise(SIGTERM);
+}
+}  // namespace
+
+namespace flight_recorder
+{
+void Initialize(Parameters const &P, int const n_steps, char const *header)
+{
+  if (n_steps <= 0) {
+    return;
+  }
+  n_slots = n_steps;
+  ring.assign(n_slots * line_size, '\0');
+  header_line.assign(header, header + strlen(header));
+  header_line.insert(header_line.end(), {'\n', '\0'});
+  file_name = std::string(P.outdir) + "flight_recorder." + std::to_string(procID) + ".csv";
+  n_records = 0;
+
+  struct sigaction action = {};
+  action.sa_handler       = Handle_Signal;
+  action.sa_flags         = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, nullptr);
+  sigaction(SIGTERM, &action, &previous_sigterm);
+  chprintf("Flight recorder keeps the last %d steps, kill -USR1 writes them to %s\n", n_steps, file_name.c_str());
+}
+
+bool Enabled() { return n_slots > 0; }
+
+void Record(char const *line)
+{
+  if (n_slots == 0) {
+    return;
+  }
+  long long const record = n_records.load(std::memory_order_relaxed);
+  char *const slot       = ring.data() + (record % n_slots) * line_size;
+  strncpy(slot, line, line_size - 1);
+  slot[line_size - 1] = '\0';
+  n_records.store(record + 1, std::memory_order_release);
+}
+
+void Dump(char const *reason)
+{
+  if (n_slots == 0) {
+    return;
+  }
+  int const file = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file < 0) {
+    return;
+  }
+  Write_String(file, "# written on ");
+  Write_String(file, reason);
+  Write_String(file, "\n");
+  Write_String(file, header_line.data());
+  long long const end   = n_records.load(std::memory_order_acquire);
+  long long const first = (end > n_slots) ? end - n_slots : 0;
+  for (long long record = first; record < end; record++) {
+    Write_String(file, ring.data() + (record % n_slots) * line_size);
+    Write_String(file, "\n");
+  }
+  close(file);
+}
+}  // namespace flight_recorder
@@ -0,0 +1,54 @@
+/*!
+ * \file flight_recorder.h
+ * \brief Contains a per rank ring buffer of the records of the last steps, the
+ * local timers, dt, MPI wait and memory use, that is written to disk when the
+ * run is killed with SIGTERM, on SIGUSR1, or when it exits through chexit, so
+ * a run that slows down or dies late leaves a record of its last steps.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// Local Includes
+#include "../global/global.h"
+
+namespace flight_recorder
+{
+/// The longest record line kept, longer lines are cut
+inline constexpr size_t line_size = 1024;
+
+/*!
+ * \brief Allocate the ring of n_steps records and install the handlers of
+ * SIGTERM and SIGUSR1. The records go to flight_recorder.<rank>.csv in the
+ * output directory, after the header line. Does nothing if n_steps is 0
+ *
+ * \param[in] P The parameters, for the output directory
+ * \param[in] n_steps The number of steps kept
+ * \param[in] header The names of the comma separated values of the records
+ */
+void Initialize(Parameters const &P, int n_steps, char const *header);
+
+/*!
+ * \brief Whether Initialize set up a ring
+ */
+bool Enabled();
+
+/*!
+ * \brief Copy a record into the ring, over the oldest one once it is full.
+ * Only copies the line, so it can run every step
+ *
+ * \param[in] line The record, without a newline
+ */
+void Record(char const *line);
+
+/*!
+ * \brief Write the header and the records, oldest first, over the file of the
+ * rank. Only uses async-signal-safe calls, so the signal handlers can call it.
+ * Does nothing if the ring isn't set up
+ *
+ * \param[in] reason A note for the first line of the file
+ */
+void Dump(char const *reason);
+}  // namespace flight_recorder
@@ -0,0 +1,47 @@
+/*!
+ * \file flight_recorder_tests.cpp
+ * \brief Tests for the contents of flight_recorder.h
+ *
+ */
+
+// STL Includes
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/flight_recorder.h"
+
+// =============================================================================
+TEST(tALLFlightRecorder, FullRingExpectLastRecordsOldestFirst)
+{
+  Parameters P;
+  std::string const outdir = (std::filesystem::temp_directory_path() / "cholla_flight_recorder_").string();
+  strncpy(P.outdir, outdir.c_str(), MAXLEN - 1);
+  P.outdir[MAXLEN - 1] = '\0';
+
+  flight_recorder::Initialize(P, 2, "step,dt");
+  ASSERT_TRUE(flight_recorder::Enabled());
+  flight_recorder::Record("1,0.5");
+  flight_recorder::Record("2,0.25");
+  flight_recorder::Record("3,0.125");
+  flight_recorder::Dump("test");
+
+  std::string const file_name = outdir + "flight_recorder." + std::to_string(procID) + ".csv";
+  std::ifstream file(file_name);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(file, line);) {
+    lines.push_back(line);
+  }
+  std::filesystem::remove(file_name);
+
+  std::vector<std::string> const fiducial = {"# written on test", "step,dt", "2,0.25", "3,0.125"};
+  EXPECT_EQ(fiducial, lines);
+}
+// =============================================================================
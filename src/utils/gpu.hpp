@@ -12,18 +12,21 @@
 
   #include <hip/hip_runtime.h>
 
-  #if defined(PARIS) || defined(PARIS_GALACTIC)
+  #if defined(PARIS) || defined(PARIS_GALACTIC) || defined(LYA_STATISTICS_GPU)
 
     #include <hipfft.h>
 
-  #endif  // CUFFT PARIS PARIS_GALACTIC
+  #endif  // CUFFT PARIS PARIS_GALACTIC LYA_STATISTICS_GPU
 
   #define WARPSIZE 64
 static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
 
+  #define CUFFT_C2C     HIPFFT_C2C
+  #define CUFFT_C2R     HIPFFT_C2R
   #define CUFFT_D2Z     HIPFFT_D2Z
   #define CUFFT_FORWARD HIPFFT_FORWARD
   #define CUFFT_INVERSE HIPFFT_BACKWARD
+  #define CUFFT_R2C     HIPFFT_R2C
   #define CUFFT_Z2D     HIPFFT_Z2D
   #define CUFFT_Z2Z     HIPFFT_Z2Z
   #define CUFFT_SUCCESS HIPFFT_SUCCESS
@@ -33,9 +36,15 @@ static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
   #define cudaError                          hipError_t
   #define cudaError_t                        hipError_t
   #define cudaErrorInsufficientDriver        hipErrorInsufficientDriver
+  #define cudaErrorNotReady                  hipErrorNotReady
   #define cudaErrorNoDevice                  hipErrorNoDevice
   #define cudaEvent_t                        hipEvent_t
   #define cudaEventCreate                    hipEventCreate
+  #define cudaEventCreateWithFlags           hipEventCreateWithFlags
+  #define cudaEventDestroy                   hipEventDestroy
+  #define cudaEventDefault                   hipEventDefault
+  #define cudaEventDisableTiming             hipEventDisableTiming
+  #define cudaEventQuery                     hipEventQuery
   #define cudaEventElapsedTime               hipEventElapsedTime
   #define cudaEventRecord                    hipEventRecord
   #define cudaEventSynchronize               hipEventSynchronize
@@ -47,15 +56,20 @@ static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
   #define cudaGetLastError                   hipGetLastError
   #define cudaHostAlloc                      hipHostMalloc
   #define cudaHostAllocDefault               hipHostMallocDefault
+  #define cudaHostAllocMapped                hipHostMallocMapped
+  #define cudaHostGetDevicePointer           hipHostGetDevicePointer
   #define cudaMalloc                         hipMalloc
   #define cudaMemcpy                         hipMemcpy
   #define cudaMemcpyAsync                    hipMemcpyAsync
+  #define cudaMemcpy2D                       hipMemcpy2D
+  #define cudaMemcpy2DAsync                  hipMemcpy2DAsync
   #define cudaMemcpyPeer                     hipMemcpyPeer
   #define cudaMemcpyDeviceToHost             hipMemcpyDeviceToHost
   #define cudaMemcpyDeviceToDevice           hipMemcpyDeviceToDevice
   #define cudaMemcpyHostToDevice             hipMemcpyHostToDevice
   #define cudaMemGetInfo                     hipMemGetInfo
   #define cudaMemset                         hipMemset
+  #define cudaMemsetAsync                    hipMemsetAsync
   #define cudaReadModeElementType            hipReadModeElementType
   #define cudaSetDevice                      hipSetDevice
   #define cudaSuccess                        hipSuccess
@@ -67,6 +81,48 @@ static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
   #define cudaMemGetInfo                     hipMemGetInfo
   #define cudaDeviceGetPCIBusId              hipDeviceGetPCIBusId
   #define cudaPeekAtLastError                hipPeekAtLastError
+  #define cudaStream_t                       hipStream_t
+  #define cudaStreamCreate                   hipStreamCreate
+  #define cudaStreamCreateWithFlags          hipStreamCreateWithFlags
+  #define cudaStreamDefault                  hipStreamDefault
+  #define cudaStreamNonBlocking              hipStreamNonBlocking
+  #define cudaStreamWaitEvent                hipStreamWaitEvent
+  #define cudaStreamDestroy                  hipStreamDestroy
+  #define cudaStreamSynchronize              hipStreamSynchronize
+
+  // Kernel attribute definitions
+  #define cudaFuncAttributes                            hipFuncAttributes
+  #define cudaFuncGetAttributes                         hipFuncGetAttributes
+  #define cudaOccupancyMaxActiveBlocksPerMultiprocessor hipOccupancyMaxActiveBlocksPerMultiprocessor
+
+  // Graph definitions
+  #define cudaGraph_t                      hipGraph_t
+  #define cudaGraphExec_t                  hipGraphExec_t
+  #define cudaGraphDestroy                 hipGraphDestroy
+  #define cudaGraphExecDestroy             hipGraphExecDestroy
+  #define cudaGraphInstantiateWithFlags    hipGraphInstantiateWithFlags
+  #define cudaGraphLaunch                  hipGraphLaunch
+  #define cudaStreamBeginCapture           hipStreamBeginCapture
+  #define cudaStreamEndCapture             hipStreamEndCapture
+  #define cudaStreamCaptureModeThreadLocal hipStreamCaptureModeThreadLocal
+
+  // Stream ordered allocation definitions
+  #define cudaDevAttrMemoryPoolsSupported hipDeviceAttributeMemoryPoolsSupported
+  #define cudaDeviceGetAttribute          hipDeviceGetAttribute
+  #define cudaDeviceGetDefaultMemPool     hipDeviceGetDefaultMemPool
+  #define cudaFreeAsync                   hipFreeAsync
+  #define cudaMallocAsync                 hipMallocAsync
+  #define cudaMemPool_t                   hipMemPool_t
+  #define cudaMemPoolAttrReleaseThreshold hipMemPoolAttrReleaseThreshold
+  #define cudaMemPoolSetAttribute         hipMemPoolSetAttribute
+
+  // Managed memory definitions
+  #define cudaCpuDeviceId                   hipCpuDeviceId
+  #define cudaMallocManaged                 hipMallocManaged
+  #define cudaMemAdvise                     hipMemAdvise
+  #define cudaMemAdviseSetPreferredLocation hipMemAdviseSetPreferredLocation
+  #define cudaMemAttachGlobal               hipMemAttachGlobal
+  #define cudaMemPrefetchAsync              hipMemPrefetchAsync
 
   // Texture definitions
   #define cudaArray           hipArray
@@ -94,30 +150,37 @@ static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
   #define cudaPointerGetAttributes hipPointerGetAttributes
 
   // FFT definitions
+  #define cufftComplex       hipfftComplex
   #define cufftDestroy       hipfftDestroy
   #define cufftDoubleComplex hipfftDoubleComplex
   #define cufftDoubleReal    hipfftDoubleReal
+  #define cufftExecC2C       hipfftExecC2C
+  #define cufftExecC2R       hipfftExecC2R
   #define cufftExecD2Z       hipfftExecD2Z
+  #define cufftExecR2C       hipfftExecR2C
   #define cufftExecZ2D       hipfftExecZ2D
   #define cufftExecZ2Z       hipfftExecZ2Z
   #define cufftHandle        hipfftHandle
   #define cufftPlan3d        hipfftPlan3d
   #define cufftPlanMany      hipfftPlanMany
+  #define cufftReal          hipfftReal
+  #define cufftType          hipfftType
 
-  #define curandStateMRG32k3a_t hiprandStateMRG32k3a_t
-  #define curand_init           hiprand_init
-  #define curand                hiprand
-  #define curand_poisson        hiprand_poisson
+  #define curandStateMRG32k3a_t       hiprandStateMRG32k3a_t
+  #define curandStatePhilox4_32_10_t hiprandStatePhilox4_32_10_t
+  #define curand_init                hiprand_init
+  #define curand                     hiprand
+  #define curand_poisson             hiprand_poisson
 
 #else  // not O_HIP
 
   #include <cuda_runtime.h>
 
-  #if defined(PARIS) || defined(PARIS_GALACTIC)
+  #if defined(PARIS) || defined(PARIS_GALACTIC) || defined(LYA_STATISTICS_GPU)
 
     #include <cufft.h>
 
-  #endif  // defined(PARIS) || defined(PARIS_GALACTIC)
+  #endif  // defined(PARIS) || defined(PARIS_GALACTIC) || defined(LYA_STATISTICS_GPU)
 
   #define WARPSIZE                               32
 static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
@@ -128,6 +191,13 @@ static constexpr int maxWarpsPerBlock = 1024 / WARPSIZE;
 
 #define GPU_MAX_THREADS 256
 
+/*!
+ * \brief True while kernels are being captured into a graph. GPU_Error_Check
+ * does not synchronize the device during a capture since that would
+ * invalidate it.
+ */
+inline bool gpuGraphCapturing = false;
+
 /*!
  * \brief Check for CUDA/HIP error codes. Can be called wrapping a GPU function that returns a value or with no
  * arguments and it will get the latest error code.
@@ -140,7 +210,9 @@ inline void GPU_Error_Check(cudaError_t code = cudaPeekAtLastError(), bool abort
                             std::experimental::source_location location = std::experimental::source_location::current())
 {
 #ifndef DISABLE_GPU_ERROR_CHECKING
-  code = cudaDeviceSynchronize();
+  if (!gpuGraphCapturing) {
+    code = cudaDeviceSynchronize();
+  }
 
   // Check the code
   if (code != cudaSuccess) {
@@ -154,7 +226,7 @@ inline void GPU_Error_Check(cudaError_t code = cudaPeekAtLastError(), bool abort
 #endif  // DISABLE_GPU_ERROR_CHECKING
 }
 
-#if defined(PARIS) || defined(PARIS_GALACTIC)
+#if defined(PARIS) || defined(PARIS_GALACTIC) || defined(LYA_STATISTICS_GPU)
 /*!
  * \brief Check for CUFFT/HIPFFT error codes. Can be called wrapping a FFT function that returns a value
  *
@@ -177,7 +249,7 @@ inline void GPU_Error_Check(cufftResult_t code, bool abort = true,
   }
   #endif  // DISABLE_GPU_ERROR_CHECKING
 }
-#endif  // defined(PARIS) || defined(PARIS_GALACTIC)
+#endif  // defined(PARIS) || defined(PARIS_GALACTIC) || defined(LYA_STATISTICS_GPU)
 
 #if defined(__CUDACC__) || defined(__HIPCC__)
 
@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "../global/global_cuda.h"
+#include "../utils/device_memory_pool.h"
 #include "../utils/error_handling.h"
 #include "../utils/gpu.hpp"
 #include "../utils/gpu_arrays_functions.h"
@@ -29,7 +30,7 @@ void Extend_GPU_Array_Real(Real **current_array_d, int current_size, int new_siz
   }
 
   Real *new_array_d;
-  GPU_Error_Check(cudaMalloc((void **)&new_array_d, new_size * sizeof(Real)));
+  cuda_utilities::Pool_Malloc(&new_array_d, new_size * sizeof(Real));
   cudaDeviceSynchronize();
   GPU_Error_Check();
   if (new_array_d == NULL) {
@@ -47,7 +48,7 @@ void Extend_GPU_Array_Real(Real **current_array_d, int current_size, int new_siz
   // cudaDeviceSynchronize();
 
   // Free the original array
-  cudaFree(*current_array_d);
+  cuda_utilities::Pool_Free(*current_array_d);
   cudaDeviceSynchronize();
   GPU_Error_Check();
 
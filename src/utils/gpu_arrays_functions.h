@@ -4,20 +4,16 @@
 #include <iostream>
 
 #include "../global/global_cuda.h"
+#include "../utils/device_memory_pool.h"
 #include "../utils/error_handling.h"
 #include "../utils/gpu.hpp"
 #include "../utils/gpu_arrays_functions.h"
 
+/*! \brief Reallocate a device array with new_size elements, keeping the first
+ * min(current_size, new_size) elements */
 template <typename T>
-void Extend_GPU_Array(T **current_array_d, int current_size, int new_size, bool print_out)
+void Resize_GPU_Array(T **current_array_d, int current_size, int new_size)
 {
-  if (new_size <= current_size) {
-    return;
-  }
-  if (print_out) {
-    std::cout << " Extending GPU Array, size: " << current_size << "  new_size: " << new_size << std::endl;
-  }
-
   size_t global_free, global_total;
   GPU_Error_Check(cudaMemGetInfo(&global_free, &global_total));
   cudaDeviceSynchronize();
@@ -33,7 +29,7 @@ void Extend_GPU_Array(T **current_array_d, int current_size, int new_size, bool
   }
 
   T *new_array_d;
-  GPU_Error_Check(cudaMalloc((void **)&new_array_d, new_size * sizeof(T)));
+  cuda_utilities::Pool_Malloc(&new_array_d, new_size * sizeof(T));
   cudaDeviceSynchronize();
   GPU_Error_Check();
   if (new_array_d == NULL) {
@@ -42,12 +38,13 @@ void Extend_GPU_Array(T **current_array_d, int current_size, int new_size, bool
   }
 
   // Copy the content of the original array to the new array
-  GPU_Error_Check(cudaMemcpy(new_array_d, *current_array_d, current_size * sizeof(T), cudaMemcpyDeviceToDevice));
+  int const n_copy = current_size < new_size ? current_size : new_size;
+  GPU_Error_Check(cudaMemcpy(new_array_d, *current_array_d, n_copy * sizeof(T), cudaMemcpyDeviceToDevice));
   cudaDeviceSynchronize();
   GPU_Error_Check();
 
   // Free the original array
-  cudaFree(*current_array_d);
+  cuda_utilities::Pool_Free(*current_array_d);
   cudaDeviceSynchronize();
   GPU_Error_Check();
 
@@ -55,4 +52,16 @@ void Extend_GPU_Array(T **current_array_d, int current_size, int new_size, bool
   *current_array_d = new_array_d;
 }
 
+template <typename T>
+void Extend_GPU_Array(T **current_array_d, int current_size, int new_size, bool print_out)
+{
+  if (new_size <= current_size) {
+    return;
+  }
+  if (print_out) {
+    std::cout << " Extending GPU Array, size: " << current_size << "  new_size: " << new_size << std::endl;
+  }
+  Resize_GPU_Array(current_array_d, current_size, new_size);
+}
+
 #endif
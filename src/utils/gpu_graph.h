@@ -0,0 +1,125 @@
+/*!
+ * \file gpu_graph.h
+ * \brief Contains the declaration and implementation of the GpuGraph class,
+ * which captures a fixed sequence of kernel launches into a CUDA/HIP graph
+ * and replays it. Since the launch method is templated the implementation is
+ * in the header file
+ *
+ */
+
+#pragma once
+
+// STL Includes
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/gpu.hpp"
+
+namespace cuda_utilities
+{
+/*!
+ * \brief Capture a sequence of kernel launches into a graph and replay it on
+ * later calls. The sequence is recaptured whenever any of the key arguments
+ * passed to `Launch` change, so anything passed by value to the kernels (dt,
+ * grid sizes, pointers) must be part of the key.
+ *
+ * The first call runs the sequence without capturing so that one-time setup
+ * inside it (allocations, launch parameter queries, output) happens outside
+ * of the graph. The sequence must launch all of its work on the stream it is
+ * given and must not perform synchronous memory copies.
+ */
+class GpuGraph
+{
+ public:
+  GpuGraph() { GPU_Error_Check(cudaStreamCreate(&_stream)); }
+
+  ~GpuGraph()
+  {
+    _destroyGraph();
+    cudaStreamDestroy(_stream);
+  }
+
+  GpuGraph(const GpuGraph &)            = delete;
+  GpuGraph &operator=(const GpuGraph &) = delete;
+
+  /*!
+   * \brief Run the sequence, replaying the captured graph if the key is
+   * unchanged since the last capture
+   *
+   * \tparam Sequence A callable taking a cudaStream_t
+   * \tparam Keys Trivially copyable types
+   * \param[in] sequence The kernel launch sequence
+   * \param[in] keys The values the sequence depends on
+   */
+  template <typename Sequence, typename... Keys>
+  void Launch(Sequence &&sequence, Keys const &...keys)
+  {
+    std::vector<unsigned char> key;
+    (_appendKey(key, keys), ...);
+
+    if (not _warmedUp) {
+      sequence(_stream);
+      GPU_Error_Check(cudaStreamSynchronize(_stream));
+      _warmedUp = true;
+      return;
+    }
+
+    if (_exec == nullptr or key != _key) {
+      _destroyGraph();
+      gpuGraphCapturing = true;
+      GPU_Error_Check(cudaStreamBeginCapture(_stream, cudaStreamCaptureModeThreadLocal));
+      sequence(_stream);
+      GPU_Error_Check(cudaStreamEndCapture(_stream, &_graph));
+      gpuGraphCapturing = false;
+      GPU_Error_Check(cudaGraphInstantiateWithFlags(&_exec, _graph, 0));
+      _key = key;
+      _nCaptures++;
+    }
+
+    GPU_Error_Check(cudaGraphLaunch(_exec, _stream));
+    GPU_Error_Check(cudaStreamSynchronize(_stream));
+    _nLaunches++;
+  }
+
+  /// The number of times the sequence has been captured
+  size_t nCaptures() const { return _nCaptures; }
+
+  /// The number of times the graph has been launched
+  size_t nLaunches() const { return _nLaunches; }
+
+ private:
+  cudaStream_t _stream;
+  cudaGraph_t _graph    = nullptr;
+  cudaGraphExec_t _exec = nullptr;
+  std::vector<unsigned char> _key;
+  bool _warmedUp    = false;
+  size_t _nCaptures = 0;
+  size_t _nLaunches = 0;
+
+  template <typename T>
+  static void _appendKey(std::vector<unsigned char> &key, T const &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "GpuGraph keys must be trivially copyable");
+    size_t const offset = key.size();
+    key.resize(offset + sizeof(T));
+    std::memcpy(key.data() + offset, &value, sizeof(T));
+  }
+
+  void _destroyGraph()
+  {
+    if (_exec != nullptr) {
+      cudaGraphExecDestroy(_exec);
+      _exec = nullptr;
+    }
+    if (_graph != nullptr) {
+      cudaGraphDestroy(_graph);
+      _graph = nullptr;
+    }
+  }
+};
+}  // namespace cuda_utilities
@@ -0,0 +1,176 @@
+/*!
+ * \file gpu_streams.h
+ * \brief Contains the declaration and implementation of the Stream and Event
+ * classes, thin RAII wrappers around CUDA/HIP streams and events, and the
+ * GridStreams struct that holds the streams used by Grid3D
+ *
+ */
+
+#pragma once
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/gpu.hpp"
+
+namespace cuda_utilities
+{
+/*!
+ * \brief A CUDA/HIP stream. The stream is created on first use so that
+ * objects can be constructed before the device has been selected.
+ *
+ * By default the stream is a blocking stream, i.e. it implicitly synchronizes
+ * with the legacy default stream (stream 0). Work issued on it is therefore
+ * still ordered with any kernel or copy that uses stream 0, while it can
+ * overlap with work on other Stream objects.
+ */
+class Stream
+{
+ public:
+  /*!
+   * \brief Construct a new Stream object
+   *
+   * \param[in] blocking (optional) If false the stream does not synchronize
+   * with the legacy default stream and any ordering has to be done with
+   * Events
+   */
+  explicit Stream(bool const blocking = true) : _blocking(blocking) {}
+
+  ~Stream()
+  {
+    if (_created) {
+      cudaStreamDestroy(_stream);
+    }
+  }
+
+  Stream(const Stream &)            = delete;
+  Stream &operator=(const Stream &) = delete;
+
+  /*!
+   * \brief Get the underlying stream, creating it if needed
+   *
+   * \return cudaStream_t The stream
+   */
+  cudaStream_t get()
+  {
+    if (not _created) {
+      GPU_Error_Check(cudaStreamCreateWithFlags(&_stream, _blocking ? cudaStreamDefault : cudaStreamNonBlocking));
+      _created = true;
+    }
+    return _stream;
+  }
+
+  /// Implicit conversion so a Stream can be passed wherever a cudaStream_t is expected
+  operator cudaStream_t() { return get(); }
+
+  /// Block the host until all work on this stream has finished
+  void Synchronize() { GPU_Error_Check(cudaStreamSynchronize(get())); }
+
+ private:
+  cudaStream_t _stream = 0;
+  bool _blocking;
+  bool _created = false;
+};
+
+/*!
+ * \brief A CUDA/HIP event used to order work between streams. By default
+ * timing is disabled since it is only used for synchronization. Like Stream
+ * the event is created on first use.
+ */
+class Event
+{
+ public:
+  /*!
+   * \brief Construct a new Event object
+   *
+   * \param[in] timing (optional) If true the event records a timestamp so it
+   * can be used with ElapsedTime
+   */
+  explicit Event(bool const timing = false) : _timing(timing) {}
+
+  ~Event()
+  {
+    if (_created) {
+      cudaEventDestroy(_event);
+    }
+  }
+
+  Event(const Event &)            = delete;
+  Event &operator=(const Event &) = delete;
+
+  /*!
+   * \brief Record the event at the current point of a stream
+   *
+   * \param[in] stream The stream to record on
+   */
+  void Record(cudaStream_t stream) { GPU_Error_Check(cudaEventRecord(get(), stream)); }
+
+  /*!
+   * \brief Make all later work on a stream wait until this event has
+   * completed. Does not block the host.
+   *
+   * \param[in] stream The stream that should wait
+   */
+  void Wait(cudaStream_t stream) { GPU_Error_Check(cudaStreamWaitEvent(stream, get(), 0)); }
+
+  /// Block the host until the event has completed
+  void Synchronize() { GPU_Error_Check(cudaEventSynchronize(get())); }
+
+  /*!
+   * \brief Check if the event has completed without blocking
+   *
+   * \return bool True if all work before the event has finished
+   */
+  bool Ready() { return cudaEventQuery(get()) != cudaErrorNotReady; }
+
+  /*!
+   * \brief The time between an earlier event and this one. Both events must
+   * have been constructed with timing enabled and this event must have
+   * completed
+   *
+   * \param[in] start The earlier event
+   * \return float The elapsed time in milliseconds
+   */
+  float ElapsedTime(Event &start)
+  {
+    float time;
+    GPU_Error_Check(cudaEventElapsedTime(&time, start.get(), get()));
+    return time;
+  }
+
+  /// Get the underlying event, creating it if needed
+  cudaEvent_t get()
+  {
+    if (not _created) {
+      GPU_Error_Check(cudaEventCreateWithFlags(&_event, _timing ? cudaEventDefault : cudaEventDisableTiming));
+      _created = true;
+    }
+    return _event;
+  }
+
+ private:
+  cudaEvent_t _event;
+  bool _timing;
+  bool _created = false;
+};
+
+/*!
+ * \brief The streams that the different parts of a Grid3D step are issued on.
+ * All of them are blocking streams so they stay ordered with anything that
+ * still runs on stream 0, while work on different members can overlap.
+ */
+struct GridStreams {
+  /// The hydro integrator and the source terms applied with it
+  Stream hydro;
+  /// Packing and unpacking of the MPI boundary buffers
+  Stream boundaries;
+  /// Particle kernels
+  Stream particles;
+  /// Host to device uploads that overlap the kernels, like the CPU gravity
+  /// potential
+  Stream uploads;
+};
+}  // namespace cuda_utilities
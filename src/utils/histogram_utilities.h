@@ -0,0 +1,206 @@
+/*!
+ * \file histogram_utilities.h
+ * \brief Contains the GPU resident histograms of the analysis routines. A
+ * histogram bins the values that a sampler computes for each element, so the
+ * binned quantities never have to be copied to the host
+ *
+ */
+
+#pragma once
+
+// STL Includes
+#include <algorithm>
+#include <cmath>
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../global/global_cuda.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/error_handling.h"
+#include "../utils/gpu.hpp"
+
+/*!
+ * \brief Namespace to contain the device resident histograms, in one or two
+ * dimensions with linear or logarithmic bins and optional weights
+ *
+ */
+namespace histogram_utilities
+{
+/// The largest shared memory of the bins of a block, in bytes
+static constexpr size_t maxSharedHistogramBytes = 48 * 1024;
+
+// =====================================================================
+/*!
+ * \brief The bins of one dimension of a histogram, n_bins bins of equal
+ * width between min and max, or of equal width in log10 when log_scale is
+ * set
+ */
+struct BinAxis {
+  int n_bins;
+  Real min;
+  Real max;
+  bool log_scale;
+
+  /*!
+   * \brief The bin of value, or -1 if the value is outside of [min, max].
+   * The value max is in the last bin
+   *
+   * \param[in] value The value to bin
+   * \return int The index of the bin
+   */
+  __host__ __device__ int Bin(Real value) const
+  {
+    if (!(value >= min && value <= max)) {
+      return -1;
+    }
+    Real const position = log_scale ? (log10(value) - log10(min)) / (log10(max) - log10(min))
+                                    : (value - min) / (max - min);
+    int const bin       = int(position * n_bins);
+    return bin < n_bins ? bin : n_bins - 1;
+  }
+};
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Add the samples of n_samples elements to the 2D histogram hist of
+ * x_axis.n_bins * y_axis.n_bins bins, with the y bins the fastest index.
+ * sampler(id, x, y, weight) sets the values and the weight of element id and
+ * returns false for the elements that are skipped.
+ *
+ * The bins are privatized in n_copies copies in shared memory, one per group
+ * of blockDim.x / n_copies threads, and added to hist at the end of the block.
+ * With n_copies = 0 the samples are added to hist directly
+ *
+ * \tparam Sampler A functor with a `__device__ bool operator()(size_t id,
+ * Real &x, Real &y, Real &weight) const`
+ */
+template <typename Sampler>
+__global__ void kernelHistogram2D(Sampler sampler, size_t n_samples, BinAxis x_axis, BinAxis y_axis, int n_copies,
+                                  float *hist)
+{
+  extern __shared__ float shared_hist[];
+  int const n_bins = x_axis.n_bins * y_axis.n_bins;
+
+  float *local_hist = hist;
+  if (n_copies > 0) {
+    for (int i = threadIdx.x; i < n_copies * n_bins; i += blockDim.x) {
+      shared_hist[i] = 0;
+    }
+    __syncthreads();
+    local_hist = shared_hist + (threadIdx.x * n_copies / blockDim.x) * n_bins;
+  }
+
+  // Grid stride loop over the samples
+  for (size_t id = blockIdx.x * blockDim.x + threadIdx.x; id < n_samples; id += blockDim.x * gridDim.x) {
+    Real x, y, weight = 1;
+    if (!sampler(id, x, y, weight)) {
+      continue;
+    }
+    int const x_bin = x_axis.Bin(x);
+    int const y_bin = y_axis.Bin(y);
+    if (x_bin < 0 || y_bin < 0) {
+      continue;
+    }
+    atomicAdd(&local_hist[x_bin * y_axis.n_bins + y_bin], float(weight));
+  }
+
+  if (n_copies > 0) {
+    __syncthreads();
+    for (int i = threadIdx.x; i < n_bins; i += blockDim.x) {
+      float sum = 0;
+      for (int copy = 0; copy < n_copies; copy++) {
+        sum += shared_hist[copy * n_bins + i];
+      }
+      if (sum != 0) {
+        atomicAdd(&hist[i], sum);
+      }
+    }
+  }
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Adapt the sampler of a 1D histogram to kernelHistogram2D, with a
+ * single y bin
+ */
+template <typename Sampler>
+struct Sampler1D {
+  Sampler sampler;
+
+  __device__ bool operator()(size_t id, Real &x, Real &y, Real &weight) const
+  {
+    y = 0;
+    return sampler(id, x, weight);
+  }
+};
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Add the samples of sampler to the device histogram dev_hist of
+ * x_axis.n_bins * y_axis.n_bins bins, with the y bins the fastest index. Each
+ * warp has its own copy of the bins in shared memory if they fit, otherwise
+ * each block, otherwise the samples go straight to dev_hist
+ *
+ * \param[in] sampler A functor with a `__device__ bool operator()(size_t id,
+ * Real &x, Real &y, Real &weight) const`
+ * \param[in] n_samples The number of elements to sample
+ * \param[in] x_axis The bins of x
+ * \param[in] y_axis The bins of y
+ * \param[in,out] dev_hist The device histogram the samples are added to
+ */
+template <typename Sampler>
+void Histogram2D(Sampler const &sampler, size_t n_samples, BinAxis const &x_axis, BinAxis const &y_axis,
+                 float *dev_hist)
+{
+  if (n_samples == 0) {
+    return;
+  }
+  if (x_axis.n_bins <= 0 || y_axis.n_bins <= 0 || !(x_axis.max > x_axis.min) || !(y_axis.max > y_axis.min) ||
+      (x_axis.log_scale && x_axis.min <= 0) || (y_axis.log_scale && y_axis.min <= 0)) {
+    CHOLLA_ERROR("Invalid histogram bins: %d bins in [%e, %e] and %d bins in [%e, %e]", x_axis.n_bins, x_axis.min,
+                 x_axis.max, y_axis.n_bins, y_axis.min, y_axis.max);
+  }
+
+  size_t const bins_bytes = size_t(x_axis.n_bins) * y_axis.n_bins * sizeof(float);
+  int const n_warps       = TPB / WARPSIZE;
+  int n_copies            = 0;
+  if (n_warps * bins_bytes <= maxSharedHistogramBytes) {
+    n_copies = n_warps;
+  } else if (bins_bytes <= maxSharedHistogramBytes) {
+    n_copies = 1;
+  }
+
+  // Enough blocks to fill the device, each one reduces its shared bins once
+  cuda_utilities::AutomaticLaunchParams static const launchParams(kernelHistogram2D<Sampler>);
+  size_t const n_blocks = std::min((n_samples + TPB - 1) / TPB, size_t(std::max(launchParams.numBlocks, 1)));
+
+  hipLaunchKernelGGL(kernelHistogram2D<Sampler>, dim3(n_blocks, 1, 1), dim3(TPB, 1, 1), n_copies * bins_bytes, 0,
+                     sampler, n_samples, x_axis, y_axis, n_copies, dev_hist);
+  GPU_Error_Check();
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Add the samples of sampler to the 1D device histogram dev_hist of
+ * x_axis.n_bins bins
+ *
+ * \param[in] sampler A functor with a `__device__ bool operator()(size_t id,
+ * Real &x, Real &weight) const`
+ * \param[in] n_samples The number of elements to sample
+ * \param[in] x_axis The bins of x
+ * \param[in,out] dev_hist The device histogram the samples are added to
+ */
+template <typename Sampler>
+void Histogram1D(Sampler const &sampler, size_t n_samples, BinAxis const &x_axis, float *dev_hist)
+{
+  BinAxis const y_axis = {1, 0, 1, false};
+  Histogram2D(Sampler1D<Sampler>{sampler}, n_samples, x_axis, y_axis, dev_hist);
+}
+// =====================================================================
+}  // namespace histogram_utilities
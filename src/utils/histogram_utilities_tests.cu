@@ -0,0 +1,152 @@
+/*!
+ * \file histogram_utilities_tests.cu
+ * \brief Tests for the contents of histogram_utilities.h
+ *
+ */
+
+// STL Includes
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/histogram_utilities.h"
+#include "../utils/testing_utilities.h"
+
+namespace
+{
+// The values of an array, weighted by a second array when it is set
+struct ArraySampler1D {
+  Real const *values;
+  Real const *weights;
+
+  __device__ bool operator()(size_t id, Real &x, Real &weight) const
+  {
+    x = values[id];
+    if (weights != nullptr) {
+      weight = weights[id];
+    }
+    return true;
+  }
+};
+
+// The pairs of values of two arrays, skipping the negative weights
+struct ArraySampler2D {
+  Real const *x_values;
+  Real const *y_values;
+  Real const *weights;
+
+  __device__ bool operator()(size_t id, Real &x, Real &y, Real &weight) const
+  {
+    x      = x_values[id];
+    y      = y_values[id];
+    weight = weights[id];
+    return weight >= 0;
+  }
+};
+
+// Bin the pairs on the host with the same bins
+std::vector<float> Host_Histogram_2D(std::vector<Real> const &x, std::vector<Real> const &y,
+                                     std::vector<Real> const &weights, histogram_utilities::BinAxis const &x_axis,
+                                     histogram_utilities::BinAxis const &y_axis)
+{
+  std::vector<float> hist(x_axis.n_bins * y_axis.n_bins, 0);
+  for (size_t i = 0; i < x.size(); i++) {
+    int const x_bin = x_axis.Bin(x[i]);
+    int const y_bin = y_axis.Bin(y[i]);
+    if (x_bin >= 0 && y_bin >= 0 && weights[i] >= 0) {
+      hist[x_bin * y_axis.n_bins + y_bin] += weights[i];
+    }
+  }
+  return hist;
+}
+
+void Check_Histogram_2D(int n_x_bins, int n_y_bins)
+{
+  size_t const n_samples = 100000;
+  std::vector<Real> x(n_samples), y(n_samples), weights(n_samples);
+  std::mt19937 prng(1);
+  std::uniform_real_distribution<double> log_rand(-4, 3);
+  std::uniform_real_distribution<double> linear_rand(-1, 11);
+  std::uniform_real_distribution<double> weight_rand(-0.2, 1);
+  for (size_t i = 0; i < n_samples; i++) {
+    x[i]       = std::pow(10, log_rand(prng));
+    y[i]       = linear_rand(prng);
+    weights[i] = weight_rand(prng);
+  }
+
+  histogram_utilities::BinAxis const x_axis = {n_x_bins, 1e-3, 1e2, true};
+  histogram_utilities::BinAxis const y_axis = {n_y_bins, 0, 10, false};
+  std::vector<float> const fiducial_hist    = Host_Histogram_2D(x, y, weights, x_axis, y_axis);
+
+  cuda_utilities::DeviceVector<Real> dev_x(n_samples), dev_y(n_samples), dev_weights(n_samples);
+  dev_x.cpyHostToDevice(x);
+  dev_y.cpyHostToDevice(y);
+  dev_weights.cpyHostToDevice(weights);
+  cuda_utilities::DeviceVector<float> dev_hist(fiducial_hist.size(), true);
+
+  histogram_utilities::Histogram2D(ArraySampler2D{dev_x.data(), dev_y.data(), dev_weights.data()}, n_samples, x_axis,
+                                   y_axis, dev_hist.data());
+  std::vector<float> test_hist(fiducial_hist.size());
+  dev_hist.cpyDeviceToHost(test_hist);
+
+  // The float sums are added in a different order on the device
+  for (size_t i = 0; i < fiducial_hist.size(); i++) {
+    testing_utilities::Check_Results(fiducial_hist[i], test_hist[i], "bin " + std::to_string(i), 1e-2);
+  }
+}
+}  // namespace
+
+TEST(tALLHistogramBinAxis, LinearAndLogBinsExpectCorrectIndices)
+{
+  histogram_utilities::BinAxis const linear = {10, 0, 10, false};
+  histogram_utilities::BinAxis const log    = {3, 1, 1000, true};
+
+  EXPECT_EQ(linear.Bin(0), 0);
+  EXPECT_EQ(linear.Bin(4.5), 4);
+  EXPECT_EQ(linear.Bin(10), 9);
+  EXPECT_EQ(linear.Bin(-0.1), -1);
+  EXPECT_EQ(linear.Bin(10.1), -1);
+  EXPECT_EQ(log.Bin(5), 0);
+  EXPECT_EQ(log.Bin(50), 1);
+  EXPECT_EQ(log.Bin(500), 2);
+  EXPECT_EQ(log.Bin(0.5), -1);
+}
+
+TEST(tALLHistogram1D, UnweightedValuesExpectCorrectCounts)
+{
+  // Every bin of [0, 8) gets bin + 1 values, and a few values are outside
+  std::vector<Real> values;
+  for (int bin = 0; bin < 8; bin++) {
+    for (int i = 0; i <= bin; i++) {
+      values.push_back(bin + 0.5);
+    }
+  }
+  values.push_back(-1);
+  values.push_back(9);
+
+  cuda_utilities::DeviceVector<Real> dev_values(values.size());
+  dev_values.cpyHostToDevice(values);
+  cuda_utilities::DeviceVector<float> dev_hist(8, true);
+
+  histogram_utilities::BinAxis const x_axis = {8, 0, 8, false};
+  histogram_utilities::Histogram1D(ArraySampler1D{dev_values.data(), nullptr}, values.size(), x_axis, dev_hist.data());
+  std::vector<float> test_hist(8);
+  dev_hist.cpyDeviceToHost(test_hist);
+
+  for (int bin = 0; bin < 8; bin++) {
+    EXPECT_EQ(test_hist[bin], float(bin + 1));
+  }
+}
+
+TEST(tALLHistogram2D, WarpSharedBinsExpectCorrectOutput) { Check_Histogram_2D(16, 8); }
+
+TEST(tALLHistogram2D, BlockSharedBinsExpectCorrectOutput) { Check_Histogram_2D(100, 100); }
+
+TEST(tALLHistogram2D, GlobalBinsExpectCorrectOutput) { Check_Histogram_2D(400, 300); }
@@ -0,0 +1,119 @@
+/*!
+ * \file launch_autotuner.cpp
+ * \brief Implementation file for launch_autotuner.h
+ *
+ */
+#include "../utils/launch_autotuner.h"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
+namespace
+{
+// The GPU model, the kernel and the number of elements of a tuned block size
+using CacheKey = std::tuple<std::string, std::string, size_t>;
+
+struct LaunchCache {
+  std::mutex mutex;
+  std::map<CacheKey, int> block_sizes;
+  // The file of Load_Launch_Cache, empty if there is none
+  std::string path;
+  // Whether anything was tuned since the file was read
+  bool modified = false;
+};
+
+LaunchCache &Cache()
+{
+  static LaunchCache cache;
+  return cache;
+}
+}  // namespace
+
+namespace cuda_utilities
+{
+void Load_Launch_Cache(std::string const &path)
+{
+  LaunchCache &cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.path     = path;
+  cache.modified = false;
+
+  // One tab separated entry per line since the model names have spaces
+  std::ifstream file(path);
+  std::string line;
+  int n_entries = 0;
+  while (std::getline(file, line)) {
+    if (line.empty() or line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string model, kernel, elements, threads;
+    if (std::getline(fields, model, '\t') and std::getline(fields, kernel, '\t') and
+        std::getline(fields, elements, '\t') and std::getline(fields, threads, '\t')) {
+      cache.block_sizes[CacheKey(model, kernel, std::stoull(elements))] = std::stoi(threads);
+      n_entries++;
+    }
+  }
+  chprintf("Read %d tuned launch parameters from %s\n", n_entries, path.c_str());
+}
+
+void Save_Launch_Cache()
+{
+  LaunchCache &cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (cache.path.empty() or not cache.modified or procID != 0) {
+    return;
+  }
+
+  std::ofstream file(cache.path);
+  if (not file) {
+    chprintf("Unable to write the tuned launch parameters to %s\n", cache.path.c_str());
+    return;
+  }
+  file << "# GPU model\tkernel\telements\tthreads per block\n";
+  for (auto const &[key, threads] : cache.block_sizes) {
+    file << std::get<0>(key) << '\t' << std::get<1>(key) << '\t' << std::get<2>(key) << '\t' << threads << '\n';
+  }
+  cache.modified = false;
+  chprintf("Wrote %zu tuned launch parameters to %s\n", cache.block_sizes.size(), cache.path.c_str());
+}
+
+std::string Device_Model()
+{
+  int device;
+  cudaDeviceProp properties;
+  GPU_Error_Check(cudaGetDevice(&device));
+  GPU_Error_Check(cudaGetDeviceProperties(&properties, device));
+  std::string model(properties.name);
+#ifdef O_HIP
+  // The name of some AMD GPUs is empty, the architecture tells them apart
+  model += std::string(" ") + properties.gcnArchName;
+#endif  // O_HIP
+  return model;
+}
+
+bool Find_Tuned_Block_Size(std::string const &kernel, size_t numElements, int &threadsPerBlock)
+{
+  CacheKey const key(Device_Model(), kernel, numElements);
+  LaunchCache &cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto const entry = cache.block_sizes.find(key);
+  if (entry == cache.block_sizes.end()) {
+    return false;
+  }
+  threadsPerBlock = entry->second;
+  return true;
+}
+
+void Store_Tuned_Block_Size(std::string const &kernel, size_t numElements, int threadsPerBlock)
+{
+  CacheKey const key(Device_Model(), kernel, numElements);
+  LaunchCache &cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.block_sizes[key] = threadsPerBlock;
+  cache.modified         = true;
+}
+}  // namespace cuda_utilities
@@ -0,0 +1,174 @@
+/*!
+ * \file launch_autotuner.h
+ * \brief Declarations of the launch parameter autotuner. With LAUNCH_AUTOTUNE
+ * the first launch of a tuned kernel times it at several block sizes and keeps
+ * the fastest, and the winners are stored in a cache file keyed by the GPU
+ * model, the kernel and the number of elements, so later runs on the same
+ * model start with them. Without LAUNCH_AUTOTUNE the launch parameters are the
+ * ones of AutomaticLaunchParams
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+
+#include "../global/global.h"
+#include "../io/io.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/gpu.hpp"
+
+namespace cuda_utilities
+{
+/// The block sizes the autotuner times, the ones above the largest block size
+/// of the kernel are skipped
+inline constexpr int tunedBlockSizes[] = {64, 128, 256, 512, 1024};
+
+/// The number of timed launches at each block size, after one warm up launch
+inline constexpr int tuningRepeats = 5;
+
+// =====================================================================
+/*!
+ * \brief Read the tuned block sizes of a cache file and remember the file so
+ * that Save_Launch_Cache writes the new ones back to it. A missing file is an
+ * empty cache
+ *
+ * \param[in] path The cache file
+ */
+void Load_Launch_Cache(std::string const &path);
+
+/*!
+ * \brief Write every tuned block size, the loaded ones included, to the file
+ * of Load_Launch_Cache if anything new was tuned. Only rank 0 writes
+ *
+ */
+void Save_Launch_Cache();
+
+/*!
+ * \brief The GPU model the tuned block sizes are stored under, the device
+ * name and on AMD GPUs also the architecture
+ *
+ * \return std::string The model of the current device
+ */
+std::string Device_Model();
+
+/*!
+ * \brief Look up the tuned block size of a kernel on the current GPU model
+ *
+ * \param[in] kernel The name of the kernel
+ * \param[in] numElements The number of elements the kernel is launched for
+ * \param[out] threadsPerBlock The tuned block size, if there is one
+ * \return bool Whether the cache has a block size for the kernel
+ */
+bool Find_Tuned_Block_Size(std::string const &kernel, size_t numElements, int &threadsPerBlock);
+
+/*!
+ * \brief Store the tuned block size of a kernel on the current GPU model
+ *
+ * \param[in] kernel The name of the kernel
+ * \param[in] numElements The number of elements the kernel is launched for
+ * \param[in] threadsPerBlock The fastest block size
+ */
+void Store_Tuned_Block_Size(std::string const &kernel, size_t numElements, int threadsPerBlock);
+// =====================================================================
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+// =====================================================================
+/*!
+ * \brief Launch parameters of a kernel with one thread per element, tuned on
+ * the first construction with LAUNCH_AUTOTUNE. The kernel is launched with the
+ * given arguments while it is timed, so it must only write arrays it doesn't
+ * read, and it must not be constructed while a graph is captured. Like
+ * AutomaticLaunchParams it is meant to be a static const at the launch site
+ *
+ * \tparam T The type of the kernel
+ */
+template <typename T>
+struct TunedLaunchParams {
+ public:
+  /*!
+   * \brief Construct the launch parameters, from the cache or by timing the
+   * kernel if it isn't cached. Falls back to AutomaticLaunchParams without
+   * LAUNCH_AUTOTUNE
+   *
+   * \param[in] name The name the kernel is cached under
+   * \param[in] kernel The kernel
+   * \param[in] numElements The number of elements, one per thread
+   * \param[in] stream The stream to time the kernel on
+   * \param[in] args The arguments to time the kernel with
+   */
+  template <typename... Args>
+  TunedLaunchParams(std::string const &name, T &kernel, size_t numElements, cudaStream_t stream, Args... args)
+  {
+    AutomaticLaunchParams<T> const automatic(kernel, numElements);
+    threadsPerBlock = automatic.threadsPerBlock;
+    numBlocks       = automatic.numBlocks;
+  #ifdef LAUNCH_AUTOTUNE
+    if (numElements == 0) {
+      return;
+    }
+    std::decay_t<T> const kernel_pointer = kernel;
+    cudaFuncAttributes attributes;
+    GPU_Error_Check(cudaFuncGetAttributes(&attributes, reinterpret_cast<void const *>(kernel_pointer)));
+
+    // A cached block size the kernel can't be launched with was tuned for
+    // other launch bounds, so it is tuned again
+    int tuned = 0;
+    if (Find_Tuned_Block_Size(name, numElements, tuned) and tuned <= attributes.maxThreadsPerBlock) {
+      threadsPerBlock = tuned;
+      numBlocks       = (numElements + tuned - 1) / tuned;
+      return;
+    }
+    if (gpuGraphCapturing) {
+      return;
+    }
+
+    cudaEvent_t start, stop;
+    GPU_Error_Check(cudaEventCreate(&start));
+    GPU_Error_Check(cudaEventCreate(&stop));
+    float best_time = -1;
+    for (int const threads : tunedBlockSizes) {
+      if (threads > attributes.maxThreadsPerBlock) {
+        continue;
+      }
+      int const blocks = (numElements + threads - 1) / threads;
+      hipLaunchKernelGGL(kernel, blocks, threads, 0, stream, args...);
+      GPU_Error_Check(cudaEventRecord(start, stream));
+      for (int repeat = 0; repeat < tuningRepeats; repeat++) {
+        hipLaunchKernelGGL(kernel, blocks, threads, 0, stream, args...);
+      }
+      GPU_Error_Check(cudaEventRecord(stop, stream));
+      GPU_Error_Check(cudaEventSynchronize(stop));
+      GPU_Error_Check();
+
+      float time;
+      GPU_Error_Check(cudaEventElapsedTime(&time, start, stop));
+      if (best_time < 0 or time < best_time) {
+        best_time       = time;
+        threadsPerBlock = threads;
+        numBlocks       = blocks;
+      }
+    }
+    GPU_Error_Check(cudaEventDestroy(start));
+    GPU_Error_Check(cudaEventDestroy(stop));
+
+    if (best_time >= 0) {
+      Store_Tuned_Block_Size(name, numElements, threadsPerBlock);
+      chprintf(" Tuned %s for %zu elements: %d threads per block, %.3f ms per launch\n", name.c_str(), numElements,
+               threadsPerBlock, best_time / tuningRepeats);
+    }
+  #endif  // LAUNCH_AUTOTUNE
+  }
+
+  /// Defaulted Destructor
+  ~TunedLaunchParams() = default;
+
+  /// The number of threads per block
+  int threadsPerBlock;
+  /// The number of blocks, enough for one thread per element
+  int numBlocks;
+};
+// =====================================================================
+#endif  // defined(__CUDACC__) || defined(__HIPCC__)
+}  // namespace cuda_utilities
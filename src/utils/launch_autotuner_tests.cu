@@ -0,0 +1,95 @@
+/*!
+ * \file launch_autotuner_tests.cu
+ * \brief Tests for the contents of launch_autotuner.h
+ *
+ */
+
+// STL Includes
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/launch_autotuner.h"
+
+namespace
+{
+__global__ void Double_Kernel(Real const *input, Real *output, size_t n)
+{
+  size_t const id = blockIdx.x * blockDim.x + threadIdx.x;
+  if (id < n) {
+    output[id] = 2 * input[id];
+  }
+}
+}  // namespace
+
+TEST(tALLLaunchAutotuner, CacheRoundTripExpectSameBlockSizes)
+{
+  std::string const path = "launch_autotuner_test_cache.txt";
+  std::remove(path.c_str());
+
+  cuda_utilities::Load_Launch_Cache(path);
+  int threads = 0;
+  EXPECT_FALSE(cuda_utilities::Find_Tuned_Block_Size("Test_Kernel", 1000, threads));
+  cuda_utilities::Store_Tuned_Block_Size("Test_Kernel", 1000, 128);
+  cuda_utilities::Store_Tuned_Block_Size("Test_Kernel", 2000, 512);
+  cuda_utilities::Save_Launch_Cache();
+
+  // A fresh load only knows what was written to the file
+  cuda_utilities::Load_Launch_Cache(path);
+  ASSERT_TRUE(cuda_utilities::Find_Tuned_Block_Size("Test_Kernel", 1000, threads));
+  EXPECT_EQ(128, threads);
+  ASSERT_TRUE(cuda_utilities::Find_Tuned_Block_Size("Test_Kernel", 2000, threads));
+  EXPECT_EQ(512, threads);
+  EXPECT_FALSE(cuda_utilities::Find_Tuned_Block_Size("Test_Kernel", 3000, threads));
+  EXPECT_FALSE(cuda_utilities::Find_Tuned_Block_Size("Other_Kernel", 1000, threads));
+
+  // The entries are stored under the model of the device that tuned them
+  std::ifstream file(path);
+  std::string line, model;
+  while (std::getline(file, line)) {
+    if (line[0] != '#') {
+      model = line.substr(0, line.find('\t'));
+    }
+  }
+  EXPECT_EQ(cuda_utilities::Device_Model(), model);
+  std::remove(path.c_str());
+}
+
+TEST(tALLLaunchAutotuner, TunedKernelExpectCorrectResultsAndValidLaunch)
+{
+  size_t const n = 100000;
+  std::vector<Real> host(n);
+  for (size_t i = 0; i < n; i++) {
+    host[i] = static_cast<Real>(i);
+  }
+  cuda_utilities::DeviceVector<Real> input(n), output(n);
+  input.cpyHostToDevice(host);
+
+  cuda_utilities::TunedLaunchParams const params("Double_Kernel", Double_Kernel, n, 0, input.data(), output.data(), n);
+  EXPECT_GT(params.threadsPerBlock, 0);
+  EXPECT_GE(static_cast<size_t>(params.numBlocks) * params.threadsPerBlock, n);
+
+  hipLaunchKernelGGL(Double_Kernel, params.numBlocks, params.threadsPerBlock, 0, 0, input.data(), output.data(), n);
+  GPU_Error_Check();
+  std::vector<Real> result(n);
+  output.cpyDeviceToHost(result);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(2 * host[i], result[i]) << "element " << i;
+  }
+
+#ifdef LAUNCH_AUTOTUNE
+  // The second construction finds the winner of the first in the cache
+  int threads = 0;
+  ASSERT_TRUE(cuda_utilities::Find_Tuned_Block_Size("Double_Kernel", n, threads));
+  EXPECT_EQ(params.threadsPerBlock, threads);
+  cuda_utilities::TunedLaunchParams const cached("Double_Kernel", Double_Kernel, n, 0, input.data(), output.data(), n);
+  EXPECT_EQ(params.threadsPerBlock, cached.threadsPerBlock);
+#endif  // LAUNCH_AUTOTUNE
+}
@@ -236,6 +236,82 @@ inline __host__ __device__ auto cellCenteredMagneticFields(Real const *dev_conse
 }
 // =========================================================================
 
+// =========================================================================
+/*!
+ * \brief The cell centered magnetic fields of cellCenteredMagneticFields,
+ * read from the cache of the fields that Calc_dt_3D writes with
+ * MHD_CENTERED_B_CACHE when dev_magnetic_centered isn't null
+ *
+ * \param[in] dev_magnetic_centered The cache of the x, y, and z cell centered
+ * fields, one block of n_cells after the other, or null to average the faces
+ * \param[in] dev_conserved A pointer to the device array of conserved variables
+ * \param[in] id The 1D index into each grid subarray.
+ * \param[in] xid The x index
+ * \param[in] yid The y index
+ * \param[in] zid The z index
+ * \param[in] n_cells The total number of cells
+ * \param[in] nx The number of cells in the x-direction
+ * \param[in] ny The number of cells in the y-direction
+ *
+ * \return Real local struct with the X, Y, and Z cell centered magnetic
+ * fields, like cellCenteredMagneticFields
+ */
+inline __host__ __device__ auto cellCenteredMagneticFields(Real const *dev_magnetic_centered, Real const *dev_conserved,
+                                                           size_t const &id, size_t const &xid, size_t const &yid,
+                                                           size_t const &zid, size_t const &n_cells, size_t const &nx,
+                                                           size_t const &ny)
+{
+  if (dev_magnetic_centered == nullptr) {
+    return cellCenteredMagneticFields(dev_conserved, id, xid, yid, zid, n_cells, nx, ny);
+  }
+  decltype(cellCenteredMagneticFields(dev_conserved, id, xid, yid, zid, n_cells, nx, ny)) magnetic;
+  magnetic.x = dev_magnetic_centered[id];
+  magnetic.y = dev_magnetic_centered[n_cells + id];
+  magnetic.z = dev_magnetic_centered[2 * n_cells + id];
+  return magnetic;
+}
+// =========================================================================
+
+// =========================================================================
+/*!
+ * \brief Compute the divergence of the face centered magnetic field in a
+ * given cell. Stone et al. 2008 equation 25. The cell must have a neighbor on
+ * the lower side of each direction
+ *
+ * \param[in] dev_conserved A pointer to the device array of conserved variables
+ * \param[in] id The 1D index into each grid subarray.
+ * \param[in] xid The x index
+ * \param[in] yid The y index
+ * \param[in] zid The z index
+ * \param[in] n_cells The total number of cells
+ * \param[in] nx The number of cells in the x-direction
+ * \param[in] ny The number of cells in the y-direction
+ * \param[in] dx The size of each cell in the x-direction
+ * \param[in] dy The size of each cell in the y-direction
+ * \param[in] dz The size of each cell in the z-direction
+ * \return Real The divergence of the magnetic field in the cell
+ */
+inline __host__ __device__ Real computeMagneticDivergence(Real const *dev_conserved, size_t const &id,
+                                                          size_t const &xid, size_t const &yid, size_t const &zid,
+                                                          size_t const &n_cells, size_t const &nx, size_t const &ny,
+                                                          Real const &dx, Real const &dy, Real const &dz)
+{
+  size_t const id_xMin1 = cuda_utilities::compute1DIndex(xid - 1, yid, zid, nx, ny);
+  size_t const id_yMin1 = cuda_utilities::compute1DIndex(xid, yid - 1, zid, nx, ny);
+  size_t const id_zMin1 = cuda_utilities::compute1DIndex(xid, yid, zid - 1, nx, ny);
+
+  return ((dev_conserved[id + (grid_enum::magnetic_x)*n_cells] -
+           dev_conserved[id_xMin1 + (grid_enum::magnetic_x)*n_cells]) /
+          dx) +
+         ((dev_conserved[id + (grid_enum::magnetic_y)*n_cells] -
+           dev_conserved[id_yMin1 + (grid_enum::magnetic_y)*n_cells]) /
+          dy) +
+         ((dev_conserved[id + (grid_enum::magnetic_z)*n_cells] -
+           dev_conserved[id_zMin1 + (grid_enum::magnetic_z)*n_cells]) /
+          dz);
+}
+// =========================================================================
+
 // =========================================================================
 /*!
  * \brief Initialize the magnitice field from the vector potential
@@ -320,6 +320,36 @@ TEST(tMHDCellCenteredMagneticFields, CorrectInputExpectCorrectOutput)
   testing_utilities::Check_Results(fiducialAvgBy, testAvgBy, "cell centered By value");
   testing_utilities::Check_Results(fiducialAvgBz, testAvgBz, "cell centered Bz value");
 }
+
+TEST(tMHDCellCenteredMagneticFields, CachedFieldsExpectCacheOrAverage)
+{
+  // Initialize the test grid and other state variables
+  size_t const nx = 3, ny = nx;
+  size_t const xid = std::floor(nx / 2), yid = xid, zid = xid;
+  size_t const id      = xid + yid * nx + zid * nx * ny;
+  size_t const n_cells = std::pow(5, 3);
+
+  std::vector<double> testGrid(n_cells * (grid_enum::num_fields));
+  std::iota(std::begin(testGrid), std::end(testGrid), 0.);
+  std::vector<double> cache(3 * n_cells, -1.0);
+  cache.at(id)               = 1.5;
+  cache.at(n_cells + id)     = 2.5;
+  cache.at(2 * n_cells + id) = 3.5;
+
+  // Without a cache the faces are averaged
+  auto const [averageBx, averageBy, averageBz] =
+      mhd::utils::cellCenteredMagneticFields(nullptr, testGrid.data(), id, xid, yid, zid, n_cells, nx, ny);
+  testing_utilities::Check_Results(637.5, averageBx, "averaged Bx value");
+  testing_utilities::Check_Results(761.5, averageBy, "averaged By value");
+  testing_utilities::Check_Results(883.5, averageBz, "averaged Bz value");
+
+  // With a cache the fields are read from it
+  auto const [cachedBx, cachedBy, cachedBz] =
+      mhd::utils::cellCenteredMagneticFields(cache.data(), testGrid.data(), id, xid, yid, zid, n_cells, nx, ny);
+  testing_utilities::Check_Results(1.5, cachedBx, "cached Bx value");
+  testing_utilities::Check_Results(2.5, cachedBy, "cached By value");
+  testing_utilities::Check_Results(3.5, cachedBz, "cached Bz value");
+}
 #endif  // MHD
 // =============================================================================
 // End of tests for the mhd::utils::cellCenteredMagneticFields function
@@ -0,0 +1,66 @@
+/*!
+ * \file profiling_ranges.h
+ * \brief Contains the wrappers that push and pop NVTX (CUDA) or roctx (HIP)
+ * ranges so that the phases of a step show up by name in Nsight Systems,
+ * rocprof or omnitrace. The ranges are only recorded when compiled with
+ * PROFILING_RANGES, otherwise the wrappers are empty inline functions.
+ *
+ */
+
+#pragma once
+
+#ifdef PROFILING_RANGES
+  #ifdef O_HIP
+    #include <roctx.h>
+  #else
+    #include <nvtx3/nvToolsExt.h>
+  #endif  // O_HIP
+#endif    // PROFILING_RANGES
+
+namespace profiling
+{
+/*!
+ * \brief Open a range named name on the calling thread. Must be matched by a
+ * call to Pop_Range in the same thread
+ *
+ * \param[in] name The name of the range
+ */
+inline void Push_Range(const char* name)
+{
+#ifdef PROFILING_RANGES
+  #ifdef O_HIP
+  roctxRangePushA(name);
+  #else
+  nvtxRangePushA(name);
+  #endif  // O_HIP
+#endif    // PROFILING_RANGES
+}
+
+/*!
+ * \brief Close the innermost range opened by Push_Range on the calling thread
+ */
+inline void Pop_Range()
+{
+#ifdef PROFILING_RANGES
+  #ifdef O_HIP
+  roctxRangePop();
+  #else
+  nvtxRangePop();
+  #endif  // O_HIP
+#endif    // PROFILING_RANGES
+}
+
+/*!
+ * \brief ScopedRange opens a range on construction and closes it when it goes
+ * out of scope. Declare it as the first variable of the scope to time
+ */
+class ScopedRange
+{
+ public:
+  explicit ScopedRange(const char* name) { Push_Range(name); }
+  ~ScopedRange() { Pop_Range(); }
+
+  ScopedRange(const ScopedRange&)            = delete;
+  ScopedRange& operator=(const ScopedRange&) = delete;
+};
+}  // namespace profiling
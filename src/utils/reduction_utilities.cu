@@ -38,4 +38,35 @@ __global__ void kernelReduceMax(Real* in, Real* out, size_t N)
   gridReduceMax(maxVal, out);
 }
 // =====================================================================
+
+// =====================================================================
+__global__ void kernelReduceSum(Real* in, Real* out, size_t N)
+{
+  Real sum = 0.0;
+
+  // Grid stride loop to perform as much of the reduction as possible
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+    sum += in[i];
+  }
+
+  // Sum across the grid and add it to `out`
+  gridReduceSum(sum, out);
+}
+// =====================================================================
+
+// =====================================================================
+__global__ void kernelReduceMin(Real* in, Real* out, size_t N)
+{
+  // Initialize minVal to the largest possible number
+  Real minVal = DBL_MAX;
+
+  // Grid stride loop to perform as much of the reduction as possible
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+    minVal = min(minVal, in[i]);
+  }
+
+  // Find the minimum val in the grid and write it to `out`
+  gridReduceMin(minVal, out);
+}
+// =====================================================================
 }  // namespace reduction_utilities
@@ -8,13 +8,16 @@
 #pragma once
 
 // STL Includes
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 // External Includes
 
 // Local Includes
 #include "../global/global.h"
 #include "../global/global_cuda.h"
+#include "../utils/DeviceVector.h"
 #include "../utils/gpu.hpp"
 
 /*!
@@ -80,6 +83,117 @@ __inline__ __device__ Real blockReduceMax(Real val)
 }
 // =====================================================================
 
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the warp/wavefront to find the sum of
+ * `val`
+ *
+ * \param[in] val The thread local variable to sum across the warp
+ * \return Real The sum of `val` within the warp
+ */
+__inline__ __device__ Real warpReduceSum(Real val)
+{
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    val += __shfl_down(val, offset);
+  }
+  return val;
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the block to find the sum of `val`.
+ * The shared memory is reused between calls so consecutive calls must be
+ * separated by a __syncthreads
+ *
+ * \param[in] val The thread local variable to sum across the block
+ * \return Real The sum of `val` within the block, only valid in thread 0
+ */
+__inline__ __device__ Real blockReduceSum(Real val)
+{
+  // Shared memory for storing the results of each warp-wise partial
+  // reduction
+  __shared__ Real shared[::maxWarpsPerBlock];
+
+  int lane   = threadIdx.x % warpSize;  // thread ID within the warp,
+  int warpId = threadIdx.x / warpSize;  // ID of the warp itself
+
+  val = warpReduceSum(val);  // Each warp performs partial reduction
+
+  if (lane == 0) {
+    shared[warpId] = val;
+  }  // Write reduced value to shared memory
+
+  __syncthreads();  // Wait for all partial reductions
+
+  // read from shared memory only if that warp existed
+  val = (threadIdx.x < blockDim.x / warpSize) ? shared[lane] : 0;
+
+  if (warpId == 0) {
+    val = warpReduceSum(val);
+  }  // Final reduce within first warp
+
+  return val;
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the warp/wavefront to find the
+ * minimum value of `val`
+ *
+ * \param[in] val The thread local variable to find the minimum of across
+ * the warp
+ * \return Real The minimum value of `val` within the warp
+ */
+__inline__ __device__ Real warpReduceMin(Real val)
+{
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    val = min(val, __shfl_down(val, offset));
+  }
+  return val;
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the block to find the minimum value
+ * of `val`. The lanes without a warp to read from are filled with the
+ * largest Real so that they can't change the minimum
+ *
+ * \param[in] val The thread local variable to find the minimum of across
+ * the block
+ * \return Real The minimum value of `val` within the block, only valid in
+ * thread 0
+ */
+__inline__ __device__ Real blockReduceMin(Real val)
+{
+  // Shared memory for storing the results of each warp-wise partial
+  // reduction
+  __shared__ Real shared[::maxWarpsPerBlock];
+
+  int lane   = threadIdx.x % warpSize;  // thread ID within the warp,
+  int warpId = threadIdx.x / warpSize;  // ID of the warp itself
+
+  val = warpReduceMin(val);  // Each warp performs partial reduction
+
+  if (lane == 0) {
+    shared[warpId] = val;
+  }  // Write reduced value to shared memory
+
+  __syncthreads();  // Wait for all partial reductions
+
+  // read from shared memory only if that warp existed
+  val = (threadIdx.x < blockDim.x / warpSize) ? shared[lane] : std::numeric_limits<Real>::max();
+
+  if (warpId == 0) {
+    val = warpReduceMin(val);
+  }  // Final reduce within first warp
+
+  return val;
+}
+// =====================================================================
+
 #ifndef O_HIP
 // =====================================================================
 // This section handles the atomics. It is complicated because CUDA
@@ -283,6 +397,261 @@ __inline__ __device__ void gridReduceMax(Real val, Real* out)
 }
 // =====================================================================
 
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the grid to find the sum of `val`.
+ * `out` must be zeroed before the kernel launch that uses this function.
+ * Like gridReduceMax the blocks are combined with one atomic per block,
+ * so the same launch parameter advice applies and the result is only
+ * available after the kernel has finished. Note that the order of the
+ * atomic additions is not fixed so the result can differ in the last
+ * bits between runs.
+ *
+ * \param[in] val The thread local variable to sum across the grid
+ * \param[out] out The pointer to where to store the reduced scalar value
+ * in device memory
+ */
+__inline__ __device__ void gridReduceSum(Real val, Real* out)
+{
+  // Reduce the entire block in parallel
+  val = blockReduceSum(val);
+
+  // Add the block level reduced value to the output scalar atomically
+  if (threadIdx.x == 0) {
+    atomicAdd(out, val);
+  }
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Perform a reduction within the grid to find the minimum value
+ * of `val`. This is the counterpart of gridReduceMax, `out` has to be
+ * set to a large enough value before the kernel launch and the same
+ * launch parameter advice applies.
+ *
+ * \param[in] val The thread local variable to find the minimum of across
+ * the grid
+ * \param[out] out The pointer to where to store the reduced scalar value
+ * in device memory
+ */
+__inline__ __device__ void gridReduceMin(Real val, Real* out)
+{
+  // Reduce the entire block in parallel
+  val = blockReduceMin(val);
+
+  // Write block level reduced value to the output scalar atomically
+  if (threadIdx.x == 0) {
+    atomicMinBits(out, val);
+  }
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief The operations of the multi-value reductions. Each has the binary
+ * operation, its identity, and the atomic that combines a block result with
+ * the value in global memory
+ */
+struct OpSum {
+  __device__ static Real apply(Real a, Real b) { return a + b; }
+  __host__ __device__ static constexpr Real identity() { return 0; }
+  __device__ static void atomic(Real* address, Real val) { atomicAdd(address, val); }
+};
+
+/// See OpSum
+struct OpMax {
+  __device__ static Real apply(Real a, Real b) { return max(a, b); }
+  __host__ __device__ static constexpr Real identity() { return std::numeric_limits<Real>::lowest(); }
+  __device__ static void atomic(Real* address, Real val) { atomicMaxBits(address, val); }
+};
+
+/// See OpSum
+struct OpMin {
+  __device__ static Real apply(Real a, Real b) { return min(a, b); }
+  __host__ __device__ static constexpr Real identity() { return std::numeric_limits<Real>::max(); }
+  __device__ static void atomic(Real* address, Real val) { atomicMinBits(address, val); }
+};
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Reduce several values within the warp/wavefront in one pass,
+ * value n with the n-th operation of `Ops`
+ *
+ * \tparam Ops The operations, OpSum, OpMax or OpMin
+ * \param[in,out] vals The thread local values, reduced into lane 0
+ */
+template <typename... Ops>
+__inline__ __device__ void warpReduceMulti(Real (&vals)[sizeof...(Ops)])
+{
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    int n = 0;
+    ((vals[n] = Ops::apply(vals[n], __shfl_down(vals[n], offset)), n++), ...);
+  }
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Reduce several values within the block in one pass, so that
+ * reductions like the maximum, sum and sum of squares of a field share
+ * the shuffles and a single __syncthreads. The lanes without a warp to
+ * read from are filled with the identity of each operation
+ *
+ * \tparam Ops The operations, OpSum, OpMax or OpMin
+ * \param[in,out] vals The thread local values, reduced into thread 0
+ */
+template <typename... Ops>
+__inline__ __device__ void blockReduceMulti(Real (&vals)[sizeof...(Ops)])
+{
+  // Shared memory for storing the results of each warp-wise partial
+  // reduction
+  __shared__ Real shared[::maxWarpsPerBlock][sizeof...(Ops)];
+
+  int lane   = threadIdx.x % warpSize;  // thread ID within the warp,
+  int warpId = threadIdx.x / warpSize;  // ID of the warp itself
+
+  warpReduceMulti<Ops...>(vals);  // Each warp performs partial reduction
+
+  if (lane == 0) {
+    for (size_t n = 0; n < sizeof...(Ops); n++) {
+      shared[warpId][n] = vals[n];
+    }
+  }  // Write reduced values to shared memory
+
+  __syncthreads();  // Wait for all partial reductions
+
+  // read from shared memory only if that warp existed
+  bool const warp_existed = threadIdx.x < blockDim.x / warpSize;
+  int n                   = 0;
+  ((vals[n] = warp_existed ? shared[lane][n] : Ops::identity(), n++), ...);
+
+  if (warpId == 0) {
+    warpReduceMulti<Ops...>(vals);
+  }  // Final reduce within first warp
+}
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Reduce several values within the grid in one pass, value n with
+ * the n-th operation of `Ops` into out[n]. Like gridReduceMax the blocks
+ * are combined with atomics, so out[n] has to be set to the identity of
+ * its operation, or to a value to combine with, before the launch and the
+ * order of the atomic additions is not fixed. Use reduceMulti for results
+ * that don't depend on the order of the blocks.
+ *
+ * \tparam Ops The operations, OpSum, OpMax or OpMin
+ * \param[in] vals The thread local values
+ * \param[out] out The pointer to the sizeof...(Ops) reduced values in
+ * device memory
+ */
+template <typename... Ops>
+__inline__ __device__ void gridReduceMulti(Real (&vals)[sizeof...(Ops)], Real* out)
+{
+  // Reduce the entire block in parallel
+  blockReduceMulti<Ops...>(vals);
+
+  // Write block level reduced values to the outputs atomically
+  if (threadIdx.x == 0) {
+    int n = 0;
+    ((Ops::atomic(&out[n], vals[n]), n++), ...);
+  }
+}
+// =====================================================================
+
+// =====================================================================
+/// The number of blocks of the first pass of reduceMulti. It is fixed so
+/// that the result only depends on the data
+inline constexpr int reduceMultiBlocks = 128;
+
+/*!
+ * \brief The first pass of reduceMulti, block b writes the reduction of
+ * its part of the samples to partials[n * gridDim.x + b]
+ */
+template <typename Sampler, typename... Ops>
+__global__ void kernelReduceMultiPartials(Sampler sampler, size_t N, Real* partials)
+{
+  Real vals[sizeof...(Ops)] = {Ops::identity()...};
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+    Real sample[sizeof...(Ops)];
+    sampler(i, sample);
+    int n = 0;
+    ((vals[n] = Ops::apply(vals[n], sample[n]), n++), ...);
+  }
+
+  blockReduceMulti<Ops...>(vals);
+  if (threadIdx.x == 0) {
+    for (size_t n = 0; n < sizeof...(Ops); n++) {
+      partials[n * gridDim.x + blockIdx.x] = vals[n];
+    }
+  }
+}
+
+/*!
+ * \brief The second pass of reduceMulti, a single block reduces the
+ * n_partials partial results of each operation into out
+ */
+template <typename... Ops>
+__global__ void kernelReduceMultiFinal(Real const* partials, int n_partials, Real* out)
+{
+  Real vals[sizeof...(Ops)] = {Ops::identity()...};
+  for (int i = threadIdx.x; i < n_partials; i += blockDim.x) {
+    int n = 0;
+    ((vals[n] = Ops::apply(vals[n], partials[n * n_partials + i]), n++), ...);
+  }
+
+  blockReduceMulti<Ops...>(vals);
+  if (threadIdx.x == 0) {
+    for (size_t n = 0; n < sizeof...(Ops); n++) {
+      out[n] = vals[n];
+    }
+  }
+}
+
+/*!
+ * \brief Reduce N samples of several values in one pass over the data,
+ * value n of every sample with the n-th operation of `Ops`. For example
+ * `reduceMulti<OpMax, OpSum, OpSum>` with a sampler that returns
+ * {d, d, d * d} gives the maximum, sum and sum of squares of d.
+ *
+ * \details The blocks write their partial results to global memory and a
+ * second single block kernel combines them in a fixed order, so unlike the
+ * atomic grid reductions the result is the same in every run. The launch
+ * configuration only depends on N. The results are copied to the host, so
+ * this waits for the reduction to finish.
+ *
+ * \tparam Ops The operations, OpSum, OpMax or OpMin
+ * \tparam Sampler A device functor with `void operator()(size_t i, Real
+ * (&sample)[sizeof...(Ops)]) const` that sets the values of sample i
+ * \param[in] sampler The functor that computes the samples
+ * \param[in] N The number of samples
+ * \param[out] out The host array of the sizeof...(Ops) reduced values
+ * \param[in] stream The stream to run the reduction on
+ */
+template <typename... Ops, typename Sampler>
+void reduceMulti(Sampler const& sampler, size_t N, Real* out, cudaStream_t stream = 0)
+{
+  size_t constexpr n_ops = sizeof...(Ops);
+  int const n_blocks     = std::max<size_t>(1, std::min<size_t>(reduceMultiBlocks, (N + TPB - 1) / TPB));
+
+  // The partials and the results of both passes share one buffer
+  cuda_utilities::DeviceVector<Real> static buffer(n_ops * (reduceMultiBlocks + 1));
+  Real* const partials = buffer.data();
+  Real* const results  = buffer.data() + n_ops * reduceMultiBlocks;
+
+  auto const partials_kernel = kernelReduceMultiPartials<Sampler, Ops...>;
+  auto const final_kernel    = kernelReduceMultiFinal<Ops...>;
+  hipLaunchKernelGGL(partials_kernel, n_blocks, TPB, 0, stream, sampler, N, partials);
+  GPU_Error_Check();
+  hipLaunchKernelGGL(final_kernel, 1, TPB, 0, stream, partials, n_blocks, results);
+  GPU_Error_Check();
+  GPU_Error_Check(cudaMemcpyAsync(out, results, n_ops * sizeof(Real), cudaMemcpyDeviceToHost, stream));
+  GPU_Error_Check(cudaStreamSynchronize(stream));
+}
+// =====================================================================
+
 // =====================================================================
 /*!
  * \brief Find the maximum value in the array. Make sure to initialize
@@ -303,4 +672,32 @@ __inline__ __device__ void gridReduceMax(Real val, Real* out)
  */
 __global__ void kernelReduceMax(Real* in, Real* out, size_t N);
 // =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Find the sum of the array. Make sure to zero `out` before using
+ * this kernel; the `cuda_utilities::setScalarDeviceMemory` function
+ * exists for this purpose.
+ *
+ * \param[in] in The pointer to the array to reduce in device memory
+ * \param[out] out The pointer to where to store the reduced scalar
+ * value in device memory
+ * \param[in] N The size of the `in` array
+ */
+__global__ void kernelReduceSum(Real* in, Real* out, size_t N);
+// =====================================================================
+
+// =====================================================================
+/*!
+ * \brief Find the minimum value in the array. Make sure to initialize
+ * `out` to a value at least as large as the minimum before using this
+ * kernel.
+ *
+ * \param[in] in The pointer to the array to reduce in device memory
+ * \param[out] out The pointer to where to store the reduced scalar
+ * value in device memory
+ * \param[in] N The size of the `in` array
+ */
+__global__ void kernelReduceMin(Real* in, Real* out, size_t N);
+// =====================================================================
 }  // namespace reduction_utilities
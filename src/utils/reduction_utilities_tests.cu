@@ -7,6 +7,8 @@
  */
 
 // STL Includes
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <string>
@@ -19,6 +21,7 @@
 #include "../global/global.h"
 #include "../utils/DeviceVector.h"
 #include "../utils/cuda_utilities.h"
+#include "../utils/gpu_streams.h"
 #include "../utils/reduction_utilities.h"
 #include "../utils/testing_utilities.h"
 
@@ -68,3 +71,232 @@ TEST(tALLKernelReduceMax, CorrectInputExpectCorrectOutput)
 // =============================================================================
 // Tests for divergence max reduction
 // =============================================================================
+
+// =============================================================================
+// Tests for sum reduction
+// =============================================================================
+TEST(tALLKernelReduceSum, CorrectInputExpectCorrectOutput)
+{
+  // Launch parameters
+  // =================
+  cuda_utilities::AutomaticLaunchParams static const launchParams(reduction_utilities::kernelReduceSum);
+
+  // Grid Parameters & testing parameters
+  // ====================================
+  size_t const gridSize = 64;
+  size_t const size     = std::pow(gridSize, 3);
+  std::vector<Real> host_grid(size);
+
+  // Fill grid with random multiples of 1/8 so that the sum is exact in any
+  // order of the atomic additions
+  std::mt19937 prng(1);
+  std::uniform_int_distribution<int> intRand(-40, 40);
+  Real fiducialSum = 0;
+  for (Real& host_data : host_grid) {
+    host_data = intRand(prng) / 8.0;
+    fiducialSum += host_data;
+  }
+
+  // Allocating and copying to device
+  // ================================
+  cuda_utilities::DeviceVector<Real> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+
+  cuda_utilities::DeviceVector<Real> static dev_sum(1);
+  dev_sum.assign(0.0);
+
+  // Do the reduction
+  // ================
+  hipLaunchKernelGGL(reduction_utilities::kernelReduceSum, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_grid.data(), dev_sum.data(), host_grid.size());
+  GPU_Error_Check();
+
+  // Perform comparison
+  testing_utilities::Check_Results(fiducialSum, dev_sum.at(0), "sum found");
+}
+
+// =============================================================================
+// Tests for min reduction
+// =============================================================================
+TEST(tALLKernelReduceMin, CorrectInputExpectCorrectOutput)
+{
+  // Launch parameters
+  // =================
+  cuda_utilities::AutomaticLaunchParams static const launchParams(reduction_utilities::kernelReduceMin);
+
+  // Grid Parameters & testing parameters
+  // ====================================
+  size_t const gridSize = 64;
+  size_t const size     = std::pow(gridSize, 3);
+  Real const minValue   = 0.5;
+  std::vector<Real> host_grid(size);
+
+  // Fill grid with random positive values and assign the minimum value. The
+  // values are all positive so that a reduction that ignores the padding
+  // lanes would find 0 instead
+  std::mt19937 prng(1);
+  std::uniform_real_distribution<double> doubleRand(minValue + 1, minValue + 10);
+  std::uniform_int_distribution<int> intRand(0, host_grid.size() - 1);
+  for (Real& host_data : host_grid) {
+    host_data = doubleRand(prng);
+  }
+  host_grid.at(intRand(prng)) = minValue;
+
+  // Allocating and copying to device
+  // ================================
+  cuda_utilities::DeviceVector<Real> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+
+  cuda_utilities::DeviceVector<Real> static dev_min(1);
+  dev_min.assign(std::numeric_limits<double>::max());
+
+  // Do the reduction
+  // ================
+  hipLaunchKernelGGL(reduction_utilities::kernelReduceMin, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_grid.data(), dev_min.data(), host_grid.size());
+  GPU_Error_Check();
+
+  // Perform comparison
+  testing_utilities::Check_Results(minValue, dev_min.at(0), "minimum value found");
+}
+
+// =============================================================================
+// Tests for multi-value reductions
+// =============================================================================
+namespace
+{
+// The maximum, sum and sum of squares of an array, like the error norms of
+// the Poisson solver tests
+struct MaxSumSquaresSampler {
+  Real const* values;
+
+  __device__ void operator()(size_t i, Real (&sample)[3]) const
+  {
+    sample[0] = values[i];
+    sample[1] = values[i];
+    sample[2] = values[i] * values[i];
+  }
+};
+
+__global__ void kernelReduceMaxSumMin(Real* in, Real* out, size_t N)
+{
+  Real vals[3] = {reduction_utilities::OpMax::identity(), 0, reduction_utilities::OpMin::identity()};
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+    vals[0] = max(vals[0], in[i]);
+    vals[1] += in[i];
+    vals[2] = min(vals[2], in[i]);
+  }
+  reduction_utilities::gridReduceMulti<reduction_utilities::OpMax, reduction_utilities::OpSum,
+                                       reduction_utilities::OpMin>(vals, out);
+}
+
+std::vector<Real> Random_Grid(size_t size, bool exact)
+{
+  // Random multiples of 1/8 are summed exactly in any order
+  std::vector<Real> host_grid(size);
+  std::mt19937 prng(1);
+  std::uniform_int_distribution<int> intRand(-40, 40);
+  std::uniform_real_distribution<double> doubleRand(-5, 5);
+  for (Real& host_data : host_grid) {
+    host_data = exact ? intRand(prng) / 8.0 : doubleRand(prng);
+  }
+  return host_grid;
+}
+}  // namespace
+
+TEST(tALLGridReduceMulti, CorrectInputExpectCorrectOutput)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(kernelReduceMaxSumMin);
+  std::vector<Real> const host_grid = Random_Grid(std::pow(64, 3), true);
+  Real fiducial[3]                  = {host_grid[0], 0, host_grid[0]};
+  for (Real const host_data : host_grid) {
+    fiducial[0] = std::max(fiducial[0], host_data);
+    fiducial[1] += host_data;
+    fiducial[2] = std::min(fiducial[2], host_data);
+  }
+
+  cuda_utilities::DeviceVector<Real> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+  std::vector<Real> out = {reduction_utilities::OpMax::identity(), 0, reduction_utilities::OpMin::identity()};
+  cuda_utilities::DeviceVector<Real> dev_out(out.size());
+  dev_out.cpyHostToDevice(out);
+
+  hipLaunchKernelGGL(kernelReduceMaxSumMin, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_grid.data(), dev_out.data(), host_grid.size());
+  GPU_Error_Check();
+  dev_out.cpyDeviceToHost(out);
+
+  testing_utilities::Check_Results(fiducial[0], out[0], "maximum value found");
+  testing_utilities::Check_Results(fiducial[1], out[1], "sum found");
+  testing_utilities::Check_Results(fiducial[2], out[2], "minimum value found");
+}
+
+TEST(tALLReduceMulti, CorrectInputExpectCorrectAndReproducibleOutput)
+{
+  // Inexact values, so the sums depend on the order of the additions
+  for (size_t const size : {size_t(1), size_t(1000), size_t(std::pow(64, 3))}) {
+    std::vector<Real> const host_grid = Random_Grid(size, false);
+    Real fiducial[3]                  = {host_grid[0], 0, 0};
+    for (Real const host_data : host_grid) {
+      fiducial[0] = std::max(fiducial[0], host_data);
+      fiducial[1] += host_data;
+      fiducial[2] += host_data * host_data;
+    }
+
+    cuda_utilities::DeviceVector<Real> dev_grid(host_grid.size());
+    dev_grid.cpyHostToDevice(host_grid);
+    Real first[3], second[3];
+    using reduction_utilities::OpMax, reduction_utilities::OpSum;
+    reduction_utilities::reduceMulti<OpMax, OpSum, OpSum>(MaxSumSquaresSampler{dev_grid.data()}, size, first);
+    reduction_utilities::reduceMulti<OpMax, OpSum, OpSum>(MaxSumSquaresSampler{dev_grid.data()}, size, second);
+
+    std::string const name = " of " + std::to_string(size) + " values";
+    testing_utilities::Check_Results(fiducial[0], first[0], "maximum" + name);
+    testing_utilities::Check_Results(fiducial[1], first[1], "sum" + name, 1e-10);
+    testing_utilities::Check_Results(fiducial[2], first[2], "sum of squares" + name, 1e-10);
+    for (int n = 0; n < 3; n++) {
+      EXPECT_EQ(first[n], second[n]) << "Result " << n << name << " changed between runs";
+    }
+  }
+}
+
+// The fused reduction of three values against a maximum and a sum reduction
+// of the same array. Only the results are checked, the times are printed
+TEST(tALLReduceMultiBenchmark, FusedAndSeparateReductionsExpectSameOutput)
+{
+  cuda_utilities::AutomaticLaunchParams static const maxLaunchParams(reduction_utilities::kernelReduceMax);
+  cuda_utilities::AutomaticLaunchParams static const sumLaunchParams(reduction_utilities::kernelReduceSum);
+  size_t const size                 = std::pow(256, 3);
+  int const n_repeats               = 20;
+  std::vector<Real> const host_grid = Random_Grid(size, true);
+  cuda_utilities::DeviceVector<Real> dev_grid(host_grid.size());
+  dev_grid.cpyHostToDevice(host_grid);
+  cuda_utilities::DeviceVector<Real> dev_out(2);
+
+  cuda_utilities::Event start(true), separate_done(true), fused_done(true);
+  start.Record(0);
+  for (int repeat = 0; repeat < n_repeats; repeat++) {
+    dev_out.assign(reduction_utilities::OpMax::identity(), 0);
+    dev_out.assign(0, 1);
+    hipLaunchKernelGGL(reduction_utilities::kernelReduceMax, maxLaunchParams.numBlocks,
+                       maxLaunchParams.threadsPerBlock, 0, 0, dev_grid.data(), dev_out.data(), host_grid.size());
+    hipLaunchKernelGGL(reduction_utilities::kernelReduceSum, sumLaunchParams.numBlocks,
+                       sumLaunchParams.threadsPerBlock, 0, 0, dev_grid.data(), dev_out.data() + 1, host_grid.size());
+  }
+  GPU_Error_Check();
+  separate_done.Record(0);
+
+  Real fused[3];
+  using reduction_utilities::OpMax, reduction_utilities::OpSum;
+  for (int repeat = 0; repeat < n_repeats; repeat++) {
+    reduction_utilities::reduceMulti<OpMax, OpSum, OpSum>(MaxSumSquaresSampler{dev_grid.data()}, size, fused);
+  }
+  fused_done.Record(0);
+  fused_done.Synchronize();
+
+  std::cout << "Reduction of " << size << " values: max and sum kernels "
+            << separate_done.ElapsedTime(start) / n_repeats << " ms, fused max, sum and sum of squares "
+            << fused_done.ElapsedTime(separate_done) / n_repeats << " ms" << std::endl;
+  testing_utilities::Check_Results(dev_out.at(0), fused[0], "maximum value found");
+  testing_utilities::Check_Results(dev_out.at(1), fused[1], "sum found");
+}
@@ -0,0 +1,121 @@
+/*!
+ * \file roofline.cpp
+ * \brief Contains the implementation of the integrator cost model
+ *
+ */
+
+// STL Includes
+
+// External Includes
+
+// Local Includes
+#include "../global/global.h"
+#include "../io/io.h"
+#include "../utils/roofline.h"
+
+namespace roofline
+{
+namespace
+{
+// The flops of the reconstruction of one field at one interface
+#if defined(PCM)
+double constexpr reconstruction_flops = 0;
+#elif defined(PLMP)
+double constexpr reconstruction_flops = 10;
+#elif defined(PLMC)
+double constexpr reconstruction_flops = 25;
+#elif defined(PPMP)
+double constexpr reconstruction_flops = 40;
+#elif defined(PPMC)
+double constexpr reconstruction_flops = 50;
+#else
+double constexpr reconstruction_flops = 0;
+#endif  // Reconstruction
+
+// The flops of the Riemann solver at one interface, plus the flops of each
+// passively advected field
+#if defined(EXACT)
+double constexpr riemann_flops = 500;
+#elif defined(ROE)
+double constexpr riemann_flops = 250;
+#elif defined(HLLC)
+double constexpr riemann_flops = 150;
+#elif defined(HLL)
+double constexpr riemann_flops = 100;
+#elif defined(HLLD)
+double constexpr riemann_flops = 400;
+#else
+double constexpr riemann_flops = 0;
+#endif  // Riemann solver
+double constexpr riemann_flops_per_scalar = 4;
+
+// The flops of the conservative update of one field with the fluxes of all
+// three directions
+double constexpr update_flops = 8;
+}  // namespace
+
+Cost Integrator_Cost(int const n_fields)
+{
+  // The arrays of n_fields values per cell that the integrator kernels read
+  // and write. A reconstruction kernel reads the conserved variables and
+  // writes the left and right interface states, a Riemann solver reads both
+  // interface states and writes the fluxes, and an update reads the conserved
+  // variables and one flux per direction and writes the conserved variables
+  double const reconstruction = 1 + 2;
+  double const riemann        = 2 + 1;
+  double const update         = 1 + 3 + 1;
+  double arrays               = 0;
+  int n_sweeps                = 0;
+
+#if defined(VL)
+  // Predictor. PCM reconstructs all three directions in a single kernel
+  #ifdef VL_FUSED
+  arrays += 2;
+  #else
+  arrays += 1 + 6 + 3 * riemann + update;
+  #endif  // VL_FUSED
+  // Corrector
+  #ifdef VL_FUSED_CORRECTOR
+  arrays += 3 * (1 + 1) + update;
+  #else
+  arrays += 3 * (reconstruction + riemann) + update;
+  #endif  // VL_FUSED_CORRECTOR
+  n_sweeps = 2;
+#elif defined(SIMPLE)
+  arrays += 3 * (reconstruction + riemann) + update;
+  n_sweeps = 1;
+#endif  // VL or SIMPLE
+
+  int const n_scalars         = (n_fields > 5) ? n_fields - 5 : 0;
+  double const riemann_total = riemann_flops + riemann_flops_per_scalar * n_scalars;
+
+  // Only the last sweep uses the selected reconstruction, the predictor of VL
+  // is always first order
+  Cost cost;
+  cost.bytes = arrays * n_fields * sizeof(Real);
+  cost.flops = n_sweeps * (3 * riemann_total + update_flops * n_fields) + 3 * reconstruction_flops * n_fields;
+  return cost;
+}
+
+void Print_Integrator_Cost(int const n_fields)
+{
+  Cost const cost = Integrator_Cost(n_fields);
+  if (cost.flops == 0) {
+    chprintf("The cost of the integrator per cell update is not modeled\n");
+    return;
+  }
+  chprintf("Estimated cost per cell update: %.0f bytes, %.0f flops, %.3f bytes/flop\n", cost.bytes, cost.flops,
+           cost.bytes / cost.flops);
+}
+
+void Print_Step_Throughput(double const n_cells_total, int const n_fields, double const step_time)
+{
+  if (step_time <= 0) {
+    return;
+  }
+  Cost const cost              = Integrator_Cost(n_fields);
+  double const updates_per_gpu = n_cells_total / nproc / step_time;
+  chprintf("cell updates/s/GPU: %9.3e   est. bandwidth: %8.2f GB/s/GPU   est. flop rate: %8.2f GFlop/s/GPU\n",
+           updates_per_gpu, updates_per_gpu * cost.bytes * 1e-9, updates_per_gpu * cost.flops * 1e-9);
+}
+}  // namespace roofline
@@ -0,0 +1,57 @@
+/*!
+ * \file roofline.h
+ * \brief Contains a simple model of the memory traffic and floating point work
+ * of one cell update of the hydro integrator selected at compile time, used to
+ * turn the measured step time into an estimated bandwidth and flop rate.
+ *
+ */
+
+#pragma once
+
+// Local Includes
+#include "../global/global.h"
+
+namespace roofline
+{
+/*!
+ * \brief The estimated cost of updating a single cell for a full time step
+ */
+struct Cost {
+  /// The bytes moved to and from global memory
+  double bytes = 0;
+  /// The floating point operations
+  double flops = 0;
+};
+
+/*!
+ * \brief Estimate the cost of one cell update for the integrator,
+ * reconstruction and Riemann solver selected at compile time. The memory
+ * traffic counts every array each integrator kernel reads or writes once per
+ * cell, i.e. it assumes the stencil neighbors hit in cache. The flop counts
+ * are rough per interface counts of each method. Neither includes the
+ * boundaries, the time step calculation or the source terms, and for MHD the
+ * constrained transport kernels are not counted. The estimate is meant to
+ * compare configurations and runs, not to be exact.
+ *
+ * \param[in] n_fields The number of fields in the conserved variable array
+ * \return Cost The estimated cost. Zero if the integrator isn't modeled
+ */
+Cost Integrator_Cost(int n_fields);
+
+/*!
+ * \brief Print the estimated cost of one cell update and the bytes per flop
+ *
+ * \param[in] n_fields The number of fields in the conserved variable array
+ */
+void Print_Integrator_Cost(int n_fields);
+
+/*!
+ * \brief Print the throughput of a step. The cells are the real cells of the
+ * whole domain and the rates are per GPU, assuming one GPU per rank
+ *
+ * \param[in] n_cells_total The total number of real cells in the domain
+ * \param[in] n_fields The number of fields in the conserved variable array
+ * \param[in] step_time The wall time of the step in seconds
+ */
+void Print_Step_Throughput(double n_cells_total, int n_fields, double step_time);
+}  // namespace roofline
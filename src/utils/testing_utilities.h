@@ -197,5 +197,7 @@ extern testing_utilities::GlobalString globalChollaRoot;
 extern testing_utilities::GlobalString globalChollaBuild;
 extern testing_utilities::GlobalString globalChollaMachine;
 extern testing_utilities::GlobalString globalMpiLauncher;
+extern testing_utilities::GlobalString globalPerformanceMode;
+extern double globalPerformanceThreshold;
 extern bool globalRunCholla;
 extern bool globalCompareSystemTestResults;
@@ -0,0 +1,129 @@
+/*!
+ * \file timestep_constraints.cu
+ * \brief Implementation of the registry of the timestep constraints
+ *
+ */
+
+// Local Includes
+#include "../mpi/mpi_routines.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/timestep_constraints.h"
+
+namespace timestep_constraints
+{
+// =====================================================================
+namespace
+{
+/// The slots are allocated on first use so that the device is already set
+cuda_utilities::DeviceVector<Real> &Slots()
+{
+  cuda_utilities::DeviceVector<Real> static slots(n_constraints, true);
+  return slots;
+}
+
+/// The host copy of the slots for Start_Readback
+cuda_utilities::PinnedVector<Real> &Host_Slots()
+{
+  cuda_utilities::PinnedVector<Real> static host_slots(n_constraints);
+  return host_slots;
+}
+
+/// Whether Start_Readback was called since the last Reduce
+bool readback_started = false;
+
+/// The values of Start_Reduce, reduced in place until Finish_Reduce
+Real pending_max_dti[n_constraints];
+#ifdef MPI_CHOLLA
+MPI_Request pending_request = MPI_REQUEST_NULL;
+#endif  // MPI_CHOLLA
+
+/// Copy the host slots, with the values that are set on the host
+void Read_Host_Slots(Real *max_dti)
+{
+  for (int constraint = 0; constraint < n_constraints; constraint++) {
+    max_dti[constraint] = Host_Slots()[constraint];
+  }
+#ifdef LOCAL_TIMESTEPS
+  // The maximum over the ranks is the longest timestep of a rank over C_cfl,
+  // infinite for a rank without any motion
+  max_dti[hydro_rank_dt] = 1 / max_dti[hydro];
+#endif  // LOCAL_TIMESTEPS
+}
+}  // namespace
+// =====================================================================
+
+// =====================================================================
+Real *Device_Slot(Constraint constraint) { return Slots().data() + constraint; }
+// =====================================================================
+
+// =====================================================================
+void Start_Readback()
+{
+  Slots().cpyDeviceToHostAsync(Host_Slots(), 0);
+  // The inverse timesteps are positive, so the next step can start from 0.
+  // The zeroing is queued after the copy on the same stream
+  GPU_Error_Check(cudaMemsetAsync(Slots().data(), 0, n_constraints * sizeof(Real), 0));
+  readback_started = true;
+}
+// =====================================================================
+
+// =====================================================================
+void Reduce(Real *max_dti, Real *local_max_dti)
+{
+  if (not readback_started) {
+    Start_Readback();
+  }
+  readback_started = false;
+  Read_Host_Slots(max_dti);
+  if (local_max_dti != nullptr) {
+    for (int constraint = 0; constraint < n_constraints; constraint++) {
+      local_max_dti[constraint] = max_dti[constraint];
+    }
+  }
+
+#ifdef MPI_CHOLLA
+  ReduceRealMax(max_dti, n_constraints);
+#endif  // MPI_CHOLLA
+}
+// =====================================================================
+
+// =====================================================================
+void Start_Reduce()
+{
+  if (not readback_started) {
+    Start_Readback();
+  }
+  readback_started = false;
+  Read_Host_Slots(pending_max_dti);
+
+#ifdef MPI_CHOLLA
+  MPI_Iallreduce(MPI_IN_PLACE, pending_max_dti, n_constraints, MPI_CHREAL, MPI_MAX, world, &pending_request);
+#endif  // MPI_CHOLLA
+}
+// =====================================================================
+
+// =====================================================================
+void Finish_Reduce(Real *max_dti)
+{
+#ifdef MPI_CHOLLA
+  MPI_Wait(&pending_request, MPI_STATUS_IGNORE);
+#endif  // MPI_CHOLLA
+  for (int constraint = 0; constraint < n_constraints; constraint++) {
+    max_dti[constraint] = pending_max_dti[constraint];
+  }
+}
+// =====================================================================
+
+// =====================================================================
+Real Reduce(Constraint constraint)
+{
+  Real max_dti = Slots()[constraint];
+  GPU_Error_Check(cudaMemset(Device_Slot(constraint), 0, sizeof(Real)));
+
+#ifdef MPI_CHOLLA
+  max_dti = ReduceRealMax(max_dti);
+#endif  // MPI_CHOLLA
+  return max_dti;
+}
+// =====================================================================
+}  // namespace timestep_constraints
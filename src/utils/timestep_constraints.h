@@ -0,0 +1,96 @@
+/*!
+ * \file timestep_constraints.h
+ * \brief Declaration of the device resident registry of the inverse timesteps
+ * that constrain the global timestep
+ *
+ */
+
+#pragma once
+
+// Local Includes
+#include "../global/global.h"
+
+/*!
+ * \brief Namespace for the registry of the timestep constraints. Each
+ * subsystem that limits the timestep reduces its maximum inverse timestep into
+ * its own slot of a small device array, so that all of them come back to the
+ * host with a single copy and are reduced over the ranks with a single
+ * MPI_Allreduce.
+ *
+ */
+namespace timestep_constraints
+{
+/// The subsystems that constrain the timestep
+enum Constraint : int {
+  hydro = 0,  ///< The hydro CFL condition, from Calc_dt_GPU
+  particles,  ///< The particle velocities
+  feedback,   ///< The cells updated by the supernova feedback
+#ifdef STATIC_REFINEMENT
+  refinement,  ///< The hydro CFL condition of the refined patch, for its own steps
+#endif  // STATIC_REFINEMENT
+  magnetic_divergence,  ///< Not a timestep, the maximum magnetic divergence of Calc_dt_3D
+#ifdef LOCAL_TIMESTEPS
+  hydro_rank_dt,  ///< Not an inverse timestep, the inverse of the hydro slot of the rank, set by Reduce
+#endif  // LOCAL_TIMESTEPS
+  n_constraints
+};
+
+/*!
+ * \brief Get the device pointer of the slot of a constraint. The slots are
+ * zero at the start of every step, and the kernels have to combine their
+ * value with what is already there with an atomic maximum like
+ * reduction_utilities::gridReduceMax
+ *
+ * \param[in] constraint The constraint
+ * \return Real* The pointer to the slot in device memory
+ */
+Real *Device_Slot(Constraint constraint);
+
+/*!
+ * \brief Queue the copy of every slot to the host on the default stream and
+ * zero the slots for the next step, without waiting for the copy. The next
+ * Reduce of all the slots waits for it instead of copying them again, so
+ * nothing may reduce into the slots in between
+ *
+ */
+void Start_Readback();
+
+/*!
+ * \brief Copy every slot to the host with one copy and, with MPI_CHOLLA, find
+ * the maximum of each over all the ranks with one MPI_Allreduce. The slots
+ * are zeroed for the next step. The copy is the one of Start_Readback when it
+ * was called since the last Reduce
+ *
+ * \param[out] max_dti The host array of the n_constraints reduced inverse
+ * timesteps, indexed by Constraint
+ * \param[out] local_max_dti If not null, the host array of the n_constraints
+ * inverse timesteps of this rank before the MPI_Allreduce
+ */
+void Reduce(Real *max_dti, Real *local_max_dti = nullptr);
+
+/*!
+ * \brief Start the reduction of Reduce without waiting for the MPI_Allreduce,
+ * so that it overlaps the work until Finish_Reduce. Only the copy to the host
+ * is waited for, and the slots are zeroed for the next step
+ *
+ */
+void Start_Reduce();
+
+/*!
+ * \brief Wait for the reduction of Start_Reduce
+ *
+ * \param[out] max_dti The host array of the n_constraints reduced inverse
+ * timesteps, indexed by Constraint
+ */
+void Finish_Reduce(Real *max_dti);
+
+/*!
+ * \brief Reduce a single slot like Reduce, for the constraints that have to
+ * be checked within a step like the supernova feedback
+ *
+ * \param[in] constraint The constraint
+ * \return Real The maximum inverse timestep of the constraint over all the
+ * ranks
+ */
+Real Reduce(Constraint constraint);
+}  // namespace timestep_constraints
@@ -0,0 +1,112 @@
+/*!
+ * \file timestep_constraints_tests.cu
+ * \brief Tests for the contents of timestep_constraints.h and
+ * timestep_constraints.cu
+ *
+ */
+
+// STL Includes
+#include <vector>
+
+// External Includes
+#include <gtest/gtest.h>  // Include GoogleTest and related libraries/headers
+
+// Local Includes
+#include "../global/global.h"
+#include "../utils/DeviceVector.h"
+#include "../utils/cuda_utilities.h"
+#include "../utils/reduction_utilities.h"
+#include "../utils/testing_utilities.h"
+#include "../utils/timestep_constraints.h"
+
+// =============================================================================
+// Tests for the timestep constraint registry
+// =============================================================================
+TEST(tALLTimestepConstraintsReduce, CorrectInputExpectCorrectOutput)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(reduction_utilities::kernelReduceMax);
+
+  // Start from the state after a step
+  Real max_dtis[timestep_constraints::n_constraints];
+  timestep_constraints::Reduce(max_dtis);
+
+  // Reduce two arrays into the hydro slot and one into the particles slot,
+  // the later reductions have to keep the maximum of the earlier ones
+  std::vector<Real> const hydro_a     = {1.0, 4.0, 2.0};
+  std::vector<Real> const hydro_b     = {3.0, 0.5};
+  std::vector<Real> const particles_a = {0.25, 0.75};
+  for (auto const &[values, constraint] : {std::pair{hydro_a, timestep_constraints::hydro},
+                                           std::pair{hydro_b, timestep_constraints::hydro},
+                                           std::pair{particles_a, timestep_constraints::particles}}) {
+    cuda_utilities::DeviceVector<Real> dev_values(values.size());
+    dev_values.cpyHostToDevice(values);
+    hipLaunchKernelGGL(reduction_utilities::kernelReduceMax, launchParams.numBlocks, launchParams.threadsPerBlock, 0,
+                       0, dev_values.data(), timestep_constraints::Device_Slot(constraint), values.size());
+    GPU_Error_Check();
+  }
+
+  timestep_constraints::Reduce(max_dtis);
+  testing_utilities::Check_Results(4.0, max_dtis[timestep_constraints::hydro], "hydro inverse timestep");
+  testing_utilities::Check_Results(0.75, max_dtis[timestep_constraints::particles], "particles inverse timestep");
+  testing_utilities::Check_Results(0.0, max_dtis[timestep_constraints::feedback], "feedback inverse timestep");
+
+  // The slots are zeroed by the reduction
+  testing_utilities::Check_Results(0.0, timestep_constraints::Reduce(timestep_constraints::hydro),
+                                   "hydro inverse timestep of the next step");
+}
+
+TEST(tALLTimestepConstraintsStartReadback, CorrectInputExpectCorrectOutput)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(reduction_utilities::kernelReduceMax);
+
+  // Start from the state after a step
+  Real max_dtis[timestep_constraints::n_constraints];
+  timestep_constraints::Reduce(max_dtis);
+
+  std::vector<Real> const hydro = {1.0, 4.0, 2.0};
+  cuda_utilities::DeviceVector<Real> dev_values(hydro.size());
+  dev_values.cpyHostToDevice(hydro);
+  hipLaunchKernelGGL(reduction_utilities::kernelReduceMax, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_values.data(), timestep_constraints::Device_Slot(timestep_constraints::hydro), hydro.size());
+  GPU_Error_Check();
+
+  // The reduction after the readback gets the values of the readback, and the
+  // slots are already zeroed for the next step
+  timestep_constraints::Start_Readback();
+  timestep_constraints::Reduce(max_dtis);
+  testing_utilities::Check_Results(4.0, max_dtis[timestep_constraints::hydro], "hydro inverse timestep");
+  testing_utilities::Check_Results(0.0, timestep_constraints::Reduce(timestep_constraints::hydro),
+                                   "hydro inverse timestep of the next step");
+}
+
+TEST(tALLTimestepConstraintsStartReduce, CorrectInputExpectCorrectOutput)
+{
+  cuda_utilities::AutomaticLaunchParams static const launchParams(reduction_utilities::kernelReduceMax);
+
+  // Start from the state after a step
+  Real max_dtis[timestep_constraints::n_constraints];
+  timestep_constraints::Reduce(max_dtis);
+
+  std::vector<Real> const hydro = {1.0, 4.0, 2.0};
+  cuda_utilities::DeviceVector<Real> dev_values(hydro.size());
+  dev_values.cpyHostToDevice(hydro);
+  hipLaunchKernelGGL(reduction_utilities::kernelReduceMax, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_values.data(), timestep_constraints::Device_Slot(timestep_constraints::hydro), hydro.size());
+  GPU_Error_Check();
+
+  // The slots are zeroed as soon as the reduction starts, and reducing into
+  // them before it finishes doesn't change its result
+  timestep_constraints::Start_Reduce();
+  hipLaunchKernelGGL(reduction_utilities::kernelReduceMax, launchParams.numBlocks, launchParams.threadsPerBlock, 0, 0,
+                     dev_values.data(), timestep_constraints::Device_Slot(timestep_constraints::particles),
+                     hydro.size());
+  GPU_Error_Check();
+  timestep_constraints::Finish_Reduce(max_dtis);
+  testing_utilities::Check_Results(4.0, max_dtis[timestep_constraints::hydro], "hydro inverse timestep");
+  testing_utilities::Check_Results(0.0, max_dtis[timestep_constraints::particles], "particles inverse timestep");
+  testing_utilities::Check_Results(4.0, timestep_constraints::Reduce(timestep_constraints::particles),
+                                   "particles inverse timestep of the next step");
+}
+// =============================================================================
+// End of tests for the timestep constraint registry
+// =============================================================================
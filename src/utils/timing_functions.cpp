@@ -1,10 +1,19 @@
 #include "../utils/timing_functions.h"
+
+#include "../utils/profiling_ranges.h"
+
 #ifdef CPU_TIME
 
   #include <algorithm>
+  #include <condition_variable>
+  #include <deque>
   #include <fstream>
+  #include <iomanip>
   #include <iostream>
+  #include <mutex>
+  #include <sstream>
   #include <string>
+  #include <thread>
 
   #include "../global/global.h"
   #include "../global/global_cuda.h"
@@ -13,6 +22,9 @@
   #ifdef MPI_CHOLLA
     #include "../mpi/mpi_routines.h"
   #endif
+  #include "../utils/device_memory_pool.h"
+  #include "../utils/error_handling.h"
+  #include "../utils/flight_recorder.h"
 
 void OneTime::Start()
 {
@@ -20,6 +32,7 @@ void OneTime::Start()
   if (inactive) {
     return;
   }
+  profiling::Push_Range(name);
   time_start = Get_Time();
 }
 
@@ -37,17 +50,23 @@ void OneTime::End(bool const print_high_values)
     return;
   }
   Real time_end = Get_Time();
-  Real time     = (time_end - time_start) * 1000;
+  profiling::Pop_Range();
+  t_step += (time_end - time_start) * 1000;
+  ended = true;
+  check_high_values |= print_high_values;
+}
 
-  #ifdef MPI_CHOLLA
-  t_min = ReduceRealMin(time);
-  t_max = ReduceRealMax(time);
-  t_avg = ReduceRealAvg(time);
-  #else
-  t_min = time;
-  t_max = time;
-  t_avg = time;
-  #endif
+void OneTime::RecordTime(Real time)
+{
+  t_step += time * 1000;  // Convert from secs to ms
+  ended = true;
+}
+
+void OneTime::Finish_Step(Real step_min, Real step_max, Real step_avg)
+{
+  t_min = step_min;
+  t_max = step_max;
+  t_avg = step_avg;
   if (n_steps > 0) {
     t_all += t_max;
   }
@@ -55,7 +74,7 @@ void OneTime::End(bool const print_high_values)
 
   #ifdef MPI_CHOLLA
   // Print out information if the process is unusually slow
-  if ((time >= 1.1 * t_avg) and (n_steps > 0) and print_high_values) {
+  if ((t_step >= 1.1 * t_avg) and (n_steps > 0) and check_high_values) {
     // Get node ID
     std::string node_id(MPI_MAX_PROCESSOR_NAME, ' ');
     int length;
@@ -72,30 +91,16 @@ void OneTime::End(bool const print_high_values)
         gpu_id.end());
 
     std::cerr << "WARNING: Rank took longer than expected to execute." << std::endl
-              << "         Node Time: " << time << std::endl
+              << "         Node Time: " << t_step << std::endl
               << "         Avg Time: " << t_avg << std::endl
               << "         Node ID: " << node_id << std::endl
               << "         GPU PCI Bus ID: " << gpu_id << std::endl;
   }
   #endif  // MPI_CHOLLA
-}
 
-void OneTime::RecordTime(Real time)
-{
-  time *= 1000;  // Convert from secs to ms
-  #ifdef MPI_CHOLLA
-  t_min = ReduceRealMin(time);
-  t_max = ReduceRealMax(time);
-  t_avg = ReduceRealAvg(time);
-  #else
-  t_min = time;
-  t_max = time;
-  t_avg = time;
-  #endif
-  if (n_steps > 0) {
-    t_all += t_max;
-  }
-  n_steps++;
+  t_step            = 0;
+  ended             = false;
+  check_high_values = false;
 }
 
 void OneTime::PrintStep()
@@ -112,11 +117,79 @@ void OneTime::PrintAverage()
 
 void OneTime::PrintAll() { chprintf(" Time %-19s all: %9.4f   ms\n", name, t_all); }
 
+/*!
+ * \brief Writes the lines of the perf_log file on a background thread so that
+ * the file system never stalls the time step
+ */
+class Time::StepLog
+{
+ public:
+  explicit StepLog(std::string const& file_name)
+  {
+    out_file.open(file_name, std::ios::app);
+    if (not out_file) {
+      CHOLLA_ERROR("Could not open the perf_log file %s", file_name.c_str());
+    }
+    writer = std::thread([this] { Write_Lines(); });
+  }
+
+  ~StepLog()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    ready.notify_one();
+    writer.join();
+  }
+
+  void Push(std::string line)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      lines.push_back(std::move(line));
+    }
+    ready.notify_one();
+  }
+
+ private:
+  // Write whatever has been queued until the log is destroyed and the queue is
+  // empty
+  void Write_Lines()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [this] { return done or not lines.empty(); });
+      if (lines.empty()) {
+        return;
+      }
+      std::deque<std::string> batch;
+      batch.swap(lines);
+      lock.unlock();
+      for (std::string const& line : batch) {
+        out_file << line << "\n";
+      }
+      out_file.flush();
+      lock.lock();
+    }
+  }
+
+  std::ofstream out_file;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::string> lines;
+  bool done = false;
+  std::thread writer;
+};
+
 Time::Time(void) {}
 
-void Time::Initialize()
+Time::~Time(void) = default;
+
+void Time::Initialize(struct Parameters const& P)
 {
-  n_steps = 0;
+  n_steps       = 0;
+  n_cells_total = Real(P.nx) * Real(P.ny) * Real(P.nz);
 
   // Add or remove timers by editing this list, keep TOTAL at the end
   // add NAME to timing_functions.h
@@ -159,6 +232,126 @@ void Time::Initialize()
   };
 
   chprintf("\nTiming Functions is ON \n");
+
+  std::string recorder_header = "step,t,dt,wall_s";
+  for (OneTime* x : onetimes) {
+    recorder_header += std::string(",") + x->name + "_ms";
+  }
+  recorder_header += ",mpi_wait_ms,mpi_bytes_sent,gpu_memory_used,pool_high_water";
+  flight_recorder::Initialize(P, P.flight_recorder_steps, recorder_header.c_str());
+
+  std::string const file_name(P.perf_log);
+  if (file_name.empty() or procID != 0) {
+    return;
+  }
+  std::string const extension = file_name.substr(file_name.find_last_of('.') + 1);
+  step_log_json               = (extension == "json") or (extension == "jsonl");
+
+  bool file_exists = false;
+  if (FILE* file = fopen(file_name.c_str(), "r")) {
+    file_exists = true;
+    fclose(file);
+  }
+  step_log = std::make_unique<StepLog>(file_name);
+
+  // The CSV header, JSON lines name every value on every line
+  if (not step_log_json and not file_exists) {
+    std::string header = "step,t,dt";
+    for (OneTime* x : onetimes) {
+      header += std::string(",") + x->name + "_ms";
+    }
+    header += ",cell_updates_per_s,mpi_wait_ms,mpi_bytes_sent,gpu_memory_used";
+    step_log->Push(header);
+  }
+  chprintf("Writing the per step timing record to: %s\n", file_name.c_str());
+}
+
+  #ifdef MPI_CHOLLA
+namespace
+{
+// The values of Time::Reduce_Step are triples of (min, max, sum), reduced
+// element-wise by this operator
+void Min_Max_Sum(void* in, void* inout, int* len, MPI_Datatype*)
+{
+  double const* a = static_cast<double const*>(in);
+  double* b       = static_cast<double*>(inout);
+  for (int i = 0; i < 3 * (*len); i += 3) {
+    b[i]     = std::min(a[i], b[i]);
+    b[i + 1] = std::max(a[i + 1], b[i + 1]);
+    b[i + 2] += a[i + 2];
+  }
+}
+}  // namespace
+  #endif  // MPI_CHOLLA
+
+void Time::Reduce_Step()
+{
+  // Every value needs its min, max and sum so it is stored three times. Each
+  // OneTime contributes its time and whether it ran this step
+  std::vector<double> values;
+  values.reserve(3 * (2 * onetimes.size() + 3));
+  auto const add = [&values](double const x) { values.insert(values.end(), {x, x, x}); };
+  for (OneTime* x : onetimes) {
+    add(x->t_step);
+    add(x->ended ? 1 : 0);
+  }
+
+  #ifdef MPI_CHOLLA
+  // Like the averages this skips the first step
+  if (Total.ended && Total.n_steps > 0) {
+    local_work += Total.t_step - mpi_wait_time * 1000;
+  }
+  add(mpi_wait_time * 1000);
+  add(static_cast<double>(mpi_bytes_sent));
+  mpi_wait_time  = 0;
+  mpi_bytes_sent = 0;
+  #else
+  add(0);
+  add(0);
+  #endif  // MPI_CHOLLA
+
+  size_t gpu_free_memory, gpu_total_memory;
+  GPU_Error_Check(cudaMemGetInfo(&gpu_free_memory, &gpu_total_memory));
+  add(static_cast<double>(gpu_total_memory - gpu_free_memory));
+
+  step_local.clear();
+  for (size_t i = 0; i < onetimes.size(); i++) {
+    step_local.push_back(values[6 * i]);
+  }
+  for (size_t i = 6 * onetimes.size(); i < values.size(); i += 3) {
+    step_local.push_back(values[i]);
+  }
+
+  #ifdef MPI_CHOLLA
+  // The triples are a derived type so the operator never sees a partial triple
+  // if the implementation splits the reduction
+  static MPI_Datatype triple = MPI_DATATYPE_NULL;
+  static MPI_Op min_max_sum  = MPI_OP_NULL;
+  if (triple == MPI_DATATYPE_NULL) {
+    MPI_Type_contiguous(3, MPI_DOUBLE, &triple);
+    MPI_Type_commit(&triple);
+    MPI_Op_create(Min_Max_Sum, 1, &min_max_sum);
+  }
+  MPI_Allreduce(MPI_IN_PLACE, values.data(), static_cast<int>(values.size() / 3), triple, min_max_sum, world);
+  double const n_ranks = nproc;
+  #else
+  double const n_ranks = 1;
+  #endif  // MPI_CHOLLA
+
+  step_max.assign(onetimes.size(), 0);
+  for (size_t i = 0; i < onetimes.size(); i++) {
+    double const* time = &values[6 * i];
+    double const* ran  = &values[6 * i + 3];
+    if (ran[1] > 0) {
+      onetimes[i]->Finish_Step(time[0], time[1], time[2] / n_ranks);
+      step_max[i] = time[1];
+    }
+  }
+
+  double const* extra = &values[6 * onetimes.size()];
+  mpi_wait_max        = extra[1];
+  mpi_bytes_sum       = extra[5];
+  gpu_memory_max      = extra[7];
 }
 
 void Time::Print_Times()
@@ -168,6 +361,51 @@ void Time::Print_Times()
   }
 }
 
+void Time::Write_Step_Record(int step, Real t, Real dt)
+{
+  if (flight_recorder::Enabled()) {
+    // Format into a fixed buffer so the record costs no allocation
+    char line[flight_recorder::line_size];
+    size_t length = snprintf(line, sizeof(line), "%d,%.10g,%.10g,%.3f", step, t, dt, Get_Time());
+    for (Real const value : step_local) {
+      if (length < sizeof(line)) {
+        length += snprintf(line + length, sizeof(line) - length, ",%.6g", value);
+      }
+    }
+    size_t const high_water = cuda_utilities::Pool_High_Water();
+    if (length < sizeof(line)) {
+      snprintf(line + length, sizeof(line) - length, ",%zu", high_water);
+    }
+    flight_recorder::Record(line);
+  }
+
+  if (not step_log) {
+    return;
+  }
+
+  // Total is always the last timer
+  Real const total_ms           = step_max.back();
+  Real const cell_updates_per_s = (total_ms > 0) ? n_cells_total / (total_ms / 1000) : 0;
+
+  std::ostringstream line;
+  line << std::setprecision(10);
+  if (step_log_json) {
+    line << "{\"step\": " << step << ", \"t\": " << t << ", \"dt\": " << dt << ", \"wall_ms\": {";
+    for (size_t i = 0; i < onetimes.size(); i++) {
+      line << ((i > 0) ? ", " : "") << "\"" << onetimes[i]->name << "\": " << step_max[i];
+    }
+    line << "}, \"cell_updates_per_s\": " << cell_updates_per_s << ", \"mpi_wait_ms\": " << mpi_wait_max
+         << ", \"mpi_bytes_sent\": " << mpi_bytes_sum << ", \"gpu_memory_used\": " << gpu_memory_max << "}";
+  } else {
+    line << step << "," << t << "," << dt;
+    for (Real const time : step_max) {
+      line << "," << time;
+    }
+    line << "," << cell_updates_per_s << "," << mpi_wait_max << "," << mpi_bytes_sum << "," << gpu_memory_max;
+  }
+  step_log->Push(line.str());
+}
+
 // once at end of run in main.cpp
 void Time::Print_Average_Times(struct Parameters P)
 {
@@ -177,6 +415,13 @@ void Time::Print_Average_Times(struct Parameters P)
     x->PrintAverage();
   }
 
+  if (not GpuTimer::All().empty()) {
+    chprintf("\nGPU Times\n");
+    for (GpuTimer* x : GpuTimer::All()) {
+      x->PrintAverage();
+    }
+  }
+
   std::string file_name("run_timing.log");
 
   chprintf("Writing timing values to file: %s  \n", file_name.c_str());
@@ -242,8 +487,95 @@ void Time::Print_Average_Times(struct Parameters P)
 
 #endif  // CPU_TIME
 
+#if defined(CPU_TIME) && !defined(GPU_GRAPHS)
+  #define GPU_TIMER_ACTIVE
+#endif  // CPU_TIME and not GPU_GRAPHS
+
+GpuTimer::GpuTimer(const char* input_name) : name(input_name)
+{
+#ifdef GPU_TIMER_ACTIVE
+  All().push_back(this);
+#endif  // GPU_TIMER_ACTIVE
+}
+
+GpuTimer::~GpuTimer()
+{
+  if (created) {
+    for (int i = 0; i < n_pairs; i++) {
+      cudaEventDestroy(start_events[i]);
+      cudaEventDestroy(stop_events[i]);
+    }
+  }
+}
+
+void GpuTimer::Start(cudaStream_t stream)
+{
+#ifdef GPU_TIMER_ACTIVE
+  if (not created) {
+    for (int i = 0; i < n_pairs; i++) {
+      GPU_Error_Check(cudaEventCreate(&start_events[i]));
+      GPU_Error_Check(cudaEventCreate(&stop_events[i]));
+    }
+    created = true;
+  }
+
+  Collect(n_pending == n_pairs);
+  GPU_Error_Check(cudaEventRecord(start_events[next], stream));
+#endif  // GPU_TIMER_ACTIVE
+}
+
+void GpuTimer::Stop(cudaStream_t stream)
+{
+#ifdef GPU_TIMER_ACTIVE
+  GPU_Error_Check(cudaEventRecord(stop_events[next], stream));
+  next = (next + 1) % n_pairs;
+  n_pending++;
+#endif  // GPU_TIMER_ACTIVE
+}
+
+void GpuTimer::Collect(bool wait)
+{
+#ifdef GPU_TIMER_ACTIVE
+  while (n_pending > 0) {
+    int const oldest = (next - n_pending + n_pairs) % n_pairs;
+    if (wait) {
+      GPU_Error_Check(cudaEventSynchronize(stop_events[oldest]));
+    } else if (cudaEventQuery(stop_events[oldest]) == cudaErrorNotReady) {
+      return;
+    }
+    float time;
+    GPU_Error_Check(cudaEventElapsedTime(&time, start_events[oldest], stop_events[oldest]));
+    t_all += time;
+    n_calls++;
+    n_pending--;
+  }
+#endif  // GPU_TIMER_ACTIVE
+}
+
+void GpuTimer::PrintAverage()
+{
+#ifdef GPU_TIMER_ACTIVE
+  Collect(true);
+  #ifdef MPI_CHOLLA
+  Real const time = ReduceRealMax(t_all);
+  #else
+  Real const time = t_all;
+  #endif  // MPI_CHOLLA
+  if (n_calls > 0) {
+    chprintf(" Time %-27s all: %9.4f  per call: %9.4f   ms\n", name, time, time / n_calls);
+  }
+#endif  // GPU_TIMER_ACTIVE
+}
+
+std::vector<GpuTimer*>& GpuTimer::All()
+{
+  static std::vector<GpuTimer*> timers;
+  return timers;
+}
+
 ScopedTimer::ScopedTimer(const char* input_name)
 {
+  profiling::Push_Range(input_name);
 #ifdef CPU_TIME
   name       = input_name;
   time_start = Get_Time();
@@ -265,5 +597,37 @@ ScopedTimer::~ScopedTimer(void)
   double t_avg = time_elapsed_ms;
   #endif  // MPI_CHOLLA
   chprintf("ScopedTimer Min: %9.4f ms Max: %9.4f ms Avg: %9.4f ms %s \n", t_min, t_max, t_avg, name);
+#endif  // CPU_TIME
+  profiling::Pop_Range();
+}
+
+StartupTimer::StartupTimer(double time_start) : time_last(time_start) {}
+
+void StartupTimer::End_Phase(const char* name)
+{
+#ifdef CPU_TIME
+  double const time_now = Get_Time();
+  names.push_back(name);
+  times.push_back(time_now - time_last);
+  time_last = time_now;
+#endif  // CPU_TIME
+}
+
+void StartupTimer::Print()
+{
+#ifdef CPU_TIME
+  chprintf("\nStartup Times\n");
+  for (size_t i = 0; i < names.size(); i++) {
+  #ifdef MPI_CHOLLA
+    double t_min = ReduceRealMin(times[i]);
+    double t_max = ReduceRealMax(times[i]);
+    double t_avg = ReduceRealAvg(times[i]);
+  #else
+    double t_min = times[i];
+    double t_max = times[i];
+    double t_avg = times[i];
+  #endif  // MPI_CHOLLA
+    chprintf(" Startup %-20s min: %9.4f  max: %9.4f  avg: %9.4f   s\n", names[i], t_min, t_max, t_avg);
+  }
 #endif  // CPU_TIME
 }
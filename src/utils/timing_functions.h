@@ -1,9 +1,11 @@
 #ifndef TIMING_FUNCTIONS_H
 #define TIMING_FUNCTIONS_H
 
+#include <memory>
 #include <vector>
 
 #include "../global/global.h"  // Provides Real, Get_Time
+#include "../utils/gpu.hpp"
 
 // #ifdef CPU_TIME
 //  Each instance of this class represents a single timer, timing a single
@@ -20,6 +22,11 @@ class OneTime
   Real t_avg      = 0;
   Real t_all      = 0;
   bool inactive   = true;
+  // The local time of the current step, reduced over the ranks by
+  // Time::Reduce_Step
+  Real t_step            = 0;
+  bool ended             = false;
+  bool check_high_values = false;
   OneTime(void) {}
   OneTime(const char* input_name)
   {
@@ -33,6 +40,7 @@ class OneTime
   void PrintAverage();
   void PrintAll();
   void RecordTime(Real time);
+  void Finish_Step(Real step_min, Real step_max, Real step_avg);
 };
 
 // Time loops through instances of OneTime. onetimes is initialized with
@@ -63,14 +71,50 @@ class Time
 
   std::vector<OneTime*> onetimes;
 
+  // The reduced values of the last step that aren't kept by the OneTimes: the
+  // max over the ranks of each OneTime (0 if it didn't run) and of the MPI wait
+  // in ms, the bytes sent by all ranks and the max GPU memory used in bytes
+  std::vector<Real> step_max;
+  Real mpi_wait_max   = 0;
+  Real mpi_bytes_sum  = 0;
+  Real gpu_memory_max = 0;
+  Real n_cells_total  = 0;
+
+  // The time this rank spent on its own work since the first step, the Total
+  // of each step less its MPI wait, in ms
+  Real local_work = 0;
+
+  // The local values of the last step before the reduction, the time of each
+  // OneTime (0 if it didn't run), the MPI wait in ms, the bytes sent and the
+  // GPU memory used in bytes, for the flight recorder
+  std::vector<Real> step_local;
+
   Time();
-  void Initialize();
+  ~Time();
+  void Initialize(struct Parameters const& P);
+
+  /* \brief Reduce the times of all the OneTimes that ran this step, the MPI
+   * wait time, the bytes sent and the GPU memory use over all ranks with a
+   * single MPI_Allreduce. Must be called by every rank once per step after
+   * Total.End() and before Print_Times */
+  void Reduce_Step();
   void Print_Times();
+
+  /* \brief Queue the record of the last reduced step for the perf_log file
+   * and keep the local values of the step in the flight recorder. Only rank 0
+   * writes the perf_log and the file is written by a background thread */
+  void Write_Step_Record(int step, Real t, Real dt);
   void Print_Average_Times(struct Parameters P);
+
+ private:
+  class StepLog;
+  std::unique_ptr<StepLog> step_log;
+  bool step_log_json = false;
 };
 // #endif  // CPU_TIME
 
-// ScopedTimer does nothing if CPU_TIME is disabled
+// ScopedTimer does nothing if CPU_TIME is disabled, except for the profiling
+// range it opens with PROFILING_RANGES. OneTime opens one between Start and End
 /* \brief ScopedTimer helps time a scope. Initialize as first variable and C++ guarantees it is destroyed last */
 class ScopedTimer
 {
@@ -85,4 +129,72 @@ class ScopedTimer
   ~ScopedTimer(void);
 };
 
+/* \brief StartupTimer times the phases of the initialization in main, each one
+ * from the end of the previous phase, so the slow ones stand out at large rank
+ * counts. Does nothing if CPU_TIME is disabled */
+class StartupTimer
+{
+ public:
+  /* \brief StartupTimer Constructor starts the first phase at time_start */
+  explicit StartupTimer(double time_start);
+
+  /* \brief End the current phase and record it as name */
+  void End_Phase(const char* name);
+
+  /* \brief Print the min, max and avg time of each phase over all ranks. Every rank has to call it */
+  void Print();
+
+ private:
+  std::vector<const char*> names;
+  std::vector<double> times;  // s
+  double time_last;
+};
+
+/*!
+ * \brief GpuTimer accumulates the device time of a section of GPU work, e.g. a
+ * single kernel launch, using pairs of events recorded on the stream the work
+ * is issued on. Recording never blocks the host; completed pairs are collected
+ * with a non-blocking query the next time the timer is started, and the host
+ * only waits if all the pairs are still in flight. Every GpuTimer registers
+ * itself on construction and Time::Print_Average_Times prints all of them.
+ * Does nothing if CPU_TIME is disabled, or with GPU_GRAPHS since events inside
+ * a captured graph can't be timed.
+ */
+class GpuTimer
+{
+ public:
+  const char* name;
+  int n_calls = 0;
+  Real t_all  = 0;  // ms
+
+  /* \brief GpuTimer Constructor registers the timer. The events are created on first use */
+  explicit GpuTimer(const char* input_name);
+  ~GpuTimer();
+
+  GpuTimer(const GpuTimer&)            = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  /* \brief Record the start of the timed work on stream */
+  void Start(cudaStream_t stream = 0);
+
+  /* \brief Record the end of the timed work on stream */
+  void Stop(cudaStream_t stream = 0);
+
+  /* \brief Add the times of the completed pairs to t_all. If wait is true wait for all of them */
+  void Collect(bool wait);
+
+  /* \brief Collect everything and print the total and per call time, the max over all ranks */
+  void PrintAverage();
+
+  /* \brief All the GpuTimer objects in the order they were constructed */
+  static std::vector<GpuTimer*>& All();
+
+ private:
+  static int constexpr n_pairs = 8;
+  cudaEvent_t start_events[n_pairs], stop_events[n_pairs];
+  bool created  = false;
+  int next      = 0;  // The next pair to record
+  int n_pending = 0;  // The number of recorded pairs that haven't been collected
+};
+
 #endif  // TIMING_FUNCTIONS_H
@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+
+# Description:
+# Run weak and strong scaling sweeps of the `--benchmark` problem of a
+# cosmological build and print one summary table of the cell updates/s, the
+# particle updates/s and the parallel efficiency of every timed phase. The
+# COSMOLOGY builds benchmark the Synthetic_Cosmology initial conditions, which
+# are generated on the device for any grid size, so nothing is downloaded.
+#
+# The weak sweep keeps the cells per rank fixed and grows the global grid with
+# the decomposition that Cholla picks for each rank count. The strong sweep
+# keeps the global grid fixed. The efficiency of a phase is its time on the
+# fewest ranks over its time on n ranks, times the ratio of the rank counts for
+# the strong sweep.
+#
+# Needs an executable built with `make TYPE=FOM` and an MPI launcher that takes
+# the number of ranks as its last argument. N_STEPS_LIMIT ends the FOM runs
+# after 26 steps, so the benchmarks can't be longer.
+#
+# Syntax: fom_scaling.sh [options]
+
+launcher="mpirun -np"
+ranks="1 8 64"
+weak_cells="128"
+strong_cells="256"
+sweeps="weak strong"
+steps=10
+logdir="fom_scaling_logs"
+
+#set -x #echo all commands
+while getopts "e:l:r:w:n:m:s:o:h" opt; do
+    case $opt in
+        e)  # Set the executable
+            cholla_exe="${OPTARG}"
+            ;;
+        l)  # Set the MPI launcher
+            launcher="${OPTARG}"
+            ;;
+        r)  # Set the rank counts
+            ranks="${OPTARG}"
+            ;;
+        w)  # Set the cells per rank of the weak sweep
+            weak_cells="${OPTARG}"
+            ;;
+        n)  # Set the global grid of the strong sweep
+            strong_cells="${OPTARG}"
+            ;;
+        m)  # Set the sweeps
+            sweeps="${OPTARG}"
+            ;;
+        s)  # Set the number of benchmark steps
+            steps="${OPTARG}"
+            ;;
+        o)  # Set the directory of the logs
+            logdir="${OPTARG}"
+            ;;
+        h)  # Print help
+            echo -e "
+Options:
+-e exe: The Cholla executable, defaults to the FOM one in bin/
+-l launcher: The MPI launcher, followed by the number of ranks (default \"${launcher}\")
+-r \"n1 n2 ...\": The numbers of ranks to run, the first one is the reference (default \"${ranks}\")
+-w cells: The cells per rank along each dimension of the weak sweep (default ${weak_cells})
+-n cells: The global cells along each dimension of the strong sweep (default ${strong_cells})
+-m \"weak strong\": The sweeps to run (default \"${sweeps}\")
+-s steps: The number of benchmark steps of each run, at most 26 (default ${steps})
+-o dir: The directory the output of every run is kept in (default ${logdir})
+-h: This dialogue"
+            exit 0
+            ;;
+        \?)
+            echo "Invalid option: -${OPTARG}" >&2
+            exit 1
+            ;;
+        :)
+            echo "Option -${OPTARG} requires an argument." >&2
+            exit 1
+            ;;
+    esac
+done
+
+# Get Paths
+cholla_root="$(dirname "$(dirname "$(readlink -fm "$0")")")"
+if [ -z "$cholla_exe" ]; then
+    cholla_exe=$(find "${cholla_root}/bin" -name "cholla.FOM*" | head -n 1)
+fi
+if [ ! -x "$cholla_exe" ]; then
+    echo "No Cholla executable found, set it with -e" >&2
+    exit 1
+fi
+mkdir -p "${logdir}"
+echo -e "cholla_exe = ${cholla_exe}"
+echo -e "logs       = ${logdir}"
+echo -e ""
+
+# The number of ranks along each axis for n ranks, like
+# TileBlockDecomposition3D: the prime factors from the largest one dealt out
+# to x, y and z in turn, then sorted so that x has the most ranks
+decompose () {
+    local n=$1 f=2 dims=(1 1 1) index=0 factors=()
+    while [ "$n" -gt 1 ]; do
+        if [ $((n % f)) -eq 0 ]; then
+            factors=("$f" "${factors[@]}")
+            n=$((n / f))
+        else
+            f=$((f + 1))
+        fi
+    done
+    for f in "${factors[@]}"; do
+        dims[$((index % 3))]=$((dims[index % 3] * f))
+        index=$((index + 1))
+    done
+    printf "%s\n" "${dims[@]}" | sort -nr | tr '\n' ' '
+}
+
+# Run one benchmark of n ranks on a nx ny nz grid and keep its output
+run () {
+    local log="${logdir}/$1_$2ranks.log"
+    ${launcher} "$2" "${cholla_exe}" --benchmark "${steps}" nx="$3" ny="$4" nz="$5" > "${log}" 2>&1
+    echo "${log}"
+}
+
+# The phases of a log and their average times in ms, one "name time" per line
+phase_times () {
+    awk '/^ Time .* avg:/ {print $2, $4}' "$1"
+}
+
+# The last value of a throughput line of a log, per GPU
+rate () {
+    awk -v pattern="$2" 'index($0, pattern) == 1 {value = $3} END {print value}' "$1"
+}
+
+printf "%-7s %6s %16s %14s %14s  %s\n" "sweep" "ranks" "grid" "cell upd/s" "part upd/s" "efficiency per phase"
+for sweep in ${sweeps}; do
+    reference=""
+    for n in ${ranks}; do
+        read -r px py pz <<< "$(decompose "$n")"
+        if [ "$sweep" = "weak" ]; then
+            nx=$((weak_cells * px)) ny=$((weak_cells * py)) nz=$((weak_cells * pz))
+        else
+            nx=${strong_cells} ny=${strong_cells} nz=${strong_cells}
+        fi
+        log=$(run "$sweep" "$n" "$nx" "$ny" "$nz")
+
+        # The rates of the whole run are the rates per GPU times the ranks
+        cells=$(rate "$log" "cell updates/s/GPU:")
+        particles=$(rate "$log" "particle updates/s/GPU:")
+        cells=$(awk -v r="$cells" -v n="$n" 'BEGIN {if (r == "") print "failed"; else printf "%.3e", r * n}')
+        particles=$(awk -v r="$particles" -v n="$n" 'BEGIN {if (r == "") print "-"; else printf "%.3e", r * n}')
+
+        if [ -z "$reference" ]; then
+            reference="$log"
+            reference_ranks="$n"
+        fi
+        efficiency=$(awk -v sweep="$sweep" -v n="$n" -v n0="$reference_ranks" '
+            NR == FNR {t0[$1] = $2; next}
+            ($1 in t0) && $2 > 0 {
+                e = t0[$1] / $2
+                if (sweep == "strong") e *= n0 / n
+                printf "%s=%.2f ", $1, e
+            }' <(phase_times "$reference") <(phase_times "$log"))
+
+        printf "%-7s %6s %16s %14s %14s  %s\n" "$sweep" "$n" "${nx}x${ny}x${nz}" "$cells" "$particles" \
+            "${efficiency:-failed}"
+    done
+done
@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+
+# Description:
+# Sweep the number of MPI ranks of the `--benchmark` problem with and without
+# gathering the periodic Paris FFTs onto fewer ranks (the paris_gather_cells
+# parameter) and print the average Grav_Potential time of each run. The first
+# rank count where gathering is faster is reported as the crossover point.
+#
+# Needs an executable built with `make TYPE=gravity` (CPU_TIME has to be on,
+# which make.type.hydro does) and an MPI launcher that takes the number of
+# ranks as its last argument.
+#
+# Syntax: paris_gather_sweep.sh [options]
+
+launcher="mpirun -np"
+ranks="1 8 64"
+cells="128"
+gather="64"
+steps=10
+
+#set -x #echo all commands
+while getopts "e:l:r:n:g:s:h" opt; do
+    case $opt in
+        e)  # Set the executable
+            cholla_exe="${OPTARG}"
+            ;;
+        l)  # Set the MPI launcher
+            launcher="${OPTARG}"
+            ;;
+        r)  # Set the rank counts
+            ranks="${OPTARG}"
+            ;;
+        n)  # Set the global grid size
+            cells="${OPTARG}"
+            ;;
+        g)  # Set the gather sizes
+            gather="${OPTARG}"
+            ;;
+        s)  # Set the number of benchmark steps
+            steps="${OPTARG}"
+            ;;
+        h)  # Print help
+            echo -e "
+Options:
+-e exe: The Cholla executable, defaults to the one in bin/
+-l launcher: The MPI launcher, followed by the number of ranks (default \"${launcher}\")
+-r \"n1 n2 ...\": The numbers of ranks to run (default \"${ranks}\")
+-n cells: The number of cells in each dimension of the global grid (default ${cells})
+-g \"c1 c2 ...\": The values of paris_gather_cells to compare with 0 (default \"${gather}\")
+-s steps: The number of benchmark steps of each run (default ${steps})
+-h: This dialogue"
+            exit 0
+            ;;
+        \?)
+            echo "Invalid option: -${OPTARG}" >&2
+            exit 1
+            ;;
+        :)
+            echo "Option -${OPTARG} requires an argument." >&2
+            exit 1
+            ;;
+    esac
+done
+
+# Get Paths
+cholla_root="$(dirname "$(dirname "$(readlink -fm "$0")")")"
+if [ -z "$cholla_exe" ]; then
+    cholla_exe=$(find "${cholla_root}/bin" -name "cholla.*gravity*" | head -n 1)
+fi
+if [ ! -x "$cholla_exe" ]; then
+    echo "No Cholla executable found, set it with -e" >&2
+    exit 1
+fi
+echo -e "cholla_exe = ${cholla_exe}"
+echo -e "grid       = ${cells}^3"
+echo -e ""
+
+# Run one benchmark and print its average Grav_Potential time in ms
+grav_time () {
+    ${launcher} "$1" "${cholla_exe}" --benchmark "${steps}" nx="${cells}" ny="${cells}" nz="${cells}" \
+        paris_gather_cells="$2" 2>&1 | awk '/Time Grav_Potential +avg:/ {print $4}'
+}
+
+printf "%8s %14s" "ranks" "gather=0"
+for g in ${gather}; do
+    printf " %14s" "gather=${g}"
+done
+printf "\n"
+
+crossover=""
+for n in ${ranks}; do
+    base=$(grav_time "$n" 0)
+    printf "%8s %14s" "$n" "${base:-failed}"
+    for g in ${gather}; do
+        t=$(grav_time "$n" "$g")
+        printf " %14s" "${t:-failed}"
+        if [ -z "$crossover" ] && [ -n "$base" ] && [ -n "$t" ] && awk "BEGIN {exit !($t < $base)}"; then
+            crossover="${n} ranks with paris_gather_cells=${g}"
+        fi
+    done
+    printf "\n"
+done
+
+echo -e ""
+echo -e "Crossover: ${crossover:-gathering was never faster}"